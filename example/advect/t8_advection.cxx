@@ -36,6 +36,8 @@
 #include <t8_vec.h>
 
 #define MAX_FACES 8             /* The maximum number of faces of an element */
+#define T8_ADVECT_NUM_TESTS 8   /* How often an overlapped ghost exchange is
+                                   tested during the flux computation */
 /* TODO: This is not memory efficient. If we run out of memory, we can optimize here. */
 
 /* Enum for statistics. */
@@ -51,6 +53,8 @@ typedef enum
   ADVECT_GHOST_SENT,            /* number of ghosts sent to other processes */
   ADVECT_GHOST_EXCHANGE,        /* ghost exchange runtime */
   ADVECT_GHOST_WAIT,            /* ghost exchange waittime */
+  ADVECT_GHOST_HIDDEN,          /* ghost exchange time hidden behind the flux computation */
+  ADVECT_GHOST_EXPOSED,         /* ghost exchange time not hidden behind computation */
   ADVECT_REPLACE,               /* forest_iterate_replace runtime */
   ADVECT_IO,                    /* vtk runtime */
   ADVECT_ELEM_AVG,              /* average global number of elements (per time step) */
@@ -60,6 +64,7 @@ typedef enum
   ADVECT_FLUX,                  /* flux computation runtime */
   ADVECT_DUMMY,                 /* dummy operations to increase load (see -s option) */
   ADVECT_SOLVE,                 /* solver runtime */
+  ADVECT_CELLS_PER_SECOND,      /* element updates per second of solver runtime */
   ADVECT_TOTAL,                 /* overall runtime */
   ADVECT_ERROR_INF,             /* l_infty error */
   ADVECT_ERROR_2,               /* L_2 error */
@@ -79,6 +84,8 @@ const char         *advect_stat_names[ADVECT_NUM_STATS] = {
   "ghost_sent",
   "ghost_exchange",
   "ghost_exchange_wait",
+  "ghost_exchange_hidden",
+  "ghost_exchange_exposed",
   "replace",
   "vtk_print",
   "number_elements",
@@ -88,12 +95,54 @@ const char         *advect_stat_names[ADVECT_NUM_STATS] = {
   "flux_computation",
   "dummy_ops",
   "solve",
+  "cells_per_second",
   "total",
   "l_infty_error",
   "L_2",
   "volume_loss_[%]"
 };
 
+/** The faces of the local elements of a forest, stored as one array per
+ *  quantity, such that the flux computation is a loop over contiguous arrays.
+ *  Each face is stored once per process. Its flux is added to the element
+ *  \a left and subtracted from the element \a right, if \a right is local.
+ *  Faces at the domain boundary have \a right equal to \a left.
+ *  The faces are sorted into bins. Without multirate, bin 0 holds the faces
+ *  between local elements and bin 1 the faces to ghosts, such that the fluxes
+ *  of bin 0 can be computed while the ghost values are exchanged.
+ *  With multirate, bin b holds the faces of level maxlevel - b, the level of
+ *  the finer of both elements, such that the faces that take a step in a
+ *  substep are the first bins.
+ *  A hanging face is stored once for each of its smaller neighbors.
+ */
+typedef struct
+{
+  t8_locidx_t         num_faces; /**< The number of faces */
+  int                 num_bins; /**< The number of bins */
+  t8_locidx_t        *bin_offsets; /**< The faces of bin b are bin_offsets[b], ...,
+                                        bin_offsets[b + 1] - 1 */
+  t8_locidx_t         num_elements; /**< The number of local elements */
+  t8_locidx_t        *left; /**< The local element at each face */
+  t8_locidx_t        *right; /**< The local or ghost neighbor at each face */
+  double             *area; /**< The area of each face */
+  double             *center[3]; /**< The coordinates of the face centers */
+  double             *normal[3]; /**< The outer normals of \a left */
+  double             *area_u; /**< The area times the normal component of
+                                   the flow at the current time */
+  double             *flux; /**< The flux out of \a left at each face */
+  double             *inv_vol; /**< For each local element 1 / volume */
+  double             *flux_sum; /**< For each local element its total flux.
+                                     With multirate the sum of the fluxes
+                                     times their time steps since its last
+                                     update. */
+  sc_array_t          level_offsets; /**< With multirate, the elements of level l
+                                           are level_offsets[l], ...,
+                                           level_offsets[l + 1] - 1 in
+                                           \a level_elements */
+  sc_array_t          level_elements; /**< With multirate, the local elements
+                                            sorted by level */
+} t8_advect_face_list_t;
+
 /** The description of the problem configuration.
  *  We store all necessary parameters, such as the initial level-set function, the flow function,
  *  data needed for adaptation etc.
@@ -133,6 +182,13 @@ typedef struct
   int                 dim; /**< The dimension of the mesh */
   int                 dummy_op; /**< If true, we carry out more (but useless) operations
                                      per element, in order to simulate more computation load */
+  int                 face_solver; /**< If true, the fluxes are computed from the face list */
+  int                 multirate; /**< If true, the face solver uses local time
+                                     steps, each level takes a step with its own
+                                     CFL time step and delta_t is the step of
+                                     the coarsest level */
+  t8_advect_face_list_t faces; /**< The faces of the local elements, only used
+                                    with face_solver */
 } t8_advect_problem_t;
 
 /** The per element data */
@@ -741,6 +797,433 @@ t8_advect_advance_element (t8_advect_problem_t * problem,
 #endif
 }
 
+/* Free the arrays of the face list of a problem */
+static void
+t8_advect_faces_destroy (t8_advect_problem_t * problem)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  int                 idim;
+
+  T8_FREE (faces->left);
+  T8_FREE (faces->right);
+  T8_FREE (faces->area);
+  for (idim = 0; idim < 3; idim++) {
+    T8_FREE (faces->center[idim]);
+    T8_FREE (faces->normal[idim]);
+    faces->center[idim] = faces->normal[idim] = NULL;
+  }
+  T8_FREE (faces->area_u);
+  T8_FREE (faces->flux);
+  T8_FREE (faces->inv_vol);
+  T8_FREE (faces->flux_sum);
+  T8_FREE (faces->bin_offsets);
+  sc_array_reset (&faces->level_offsets);
+  sc_array_reset (&faces->level_elements);
+  faces->left = faces->right = faces->bin_offsets = NULL;
+  faces->area = faces->area_u = faces->flux = NULL;
+  faces->inv_vol = faces->flux_sum = NULL;
+  faces->num_faces = faces->num_elements = 0;
+  faces->num_bins = 0;
+}
+
+/* Store the geometry of a face of element in the face list.
+ * face_level is the level of the finer element at the face. next_face holds
+ * the next free index of each bin. If the arrays of the list are not
+ * allocated, only count the faces and element may be NULL. */
+static void
+t8_advect_faces_set (t8_advect_problem_t * problem, t8_locidx_t * next_face,
+                     t8_locidx_t left, t8_locidx_t right, int face_level,
+                     t8_locidx_t ltreeid, const t8_element_t * element,
+                     int face, const double *tree_vertices)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  t8_locidx_t         iface;
+  double              center[3], normal[3];
+  int                 idim, bin;
+
+  if (problem->multirate) {
+    bin = problem->maxlevel - face_level;
+  }
+  else {
+    bin = right >= faces->num_elements;
+  }
+  T8_ASSERT (0 <= bin && bin < faces->num_bins);
+  iface = next_face[bin]++;
+  if (faces->left == NULL) {
+    return;
+  }
+  faces->left[iface] = left;
+  faces->right[iface] = right;
+  t8_forest_element_face_centroid (problem->forest, ltreeid, element, face,
+                                   tree_vertices, center);
+  t8_forest_element_face_normal (problem->forest, ltreeid, element, face,
+                                 tree_vertices, normal);
+  faces->area[iface] =
+    t8_forest_element_face_area (problem->forest, ltreeid, element, face,
+                                 tree_vertices);
+  for (idim = 0; idim < 3; idim++) {
+    faces->center[idim][iface] = center[idim];
+    faces->normal[idim][iface] = normal[idim];
+  }
+}
+
+/* Add the faces of a local element to the face list.
+ * A face between two local elements is added by the element with the
+ * smaller index, or by the coarser element if it is hanging.
+ * A face to a ghost is added by the local element. */
+static void
+t8_advect_faces_add_element (t8_advect_problem_t * problem,
+                             t8_locidx_t * next_face,
+                             t8_locidx_t ltreeid, t8_locidx_t lelement,
+                             t8_element_t * element,
+                             t8_eclass_scheme_c * ts,
+                             const double *tree_vertices)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  t8_locidx_t         num_local;
+  const t8_locidx_t  *neighs;
+  t8_element_t      **face_children = NULL;
+  int                 iface, ineigh, num_faces, num_neighs, level_diff;
+  int                 level;
+
+  num_local = faces->num_elements;
+  level = ts->t8_element_level (element);
+  num_faces = ts->t8_element_num_faces (element);
+  for (iface = 0; iface < num_faces; iface++) {
+    num_neighs =
+      t8_forest_get_face_neighbors (problem->forest, lelement, iface,
+                                    &neighs, NULL, &level_diff);
+    if (level_diff > 0) {
+      /* The neighbors are smaller. We add one face for each child of the
+       * element at this face. */
+      T8_ASSERT (num_neighs ==
+                 ts->t8_element_num_face_children (element, iface));
+      if (faces->left != NULL) {
+        face_children = T8_ALLOC (t8_element_t *, num_neighs);
+        ts->t8_element_new (num_neighs, face_children);
+        ts->t8_element_children_at_face (element, iface, face_children,
+                                         num_neighs, NULL);
+      }
+      for (ineigh = 0; ineigh < num_neighs; ineigh++) {
+        t8_advect_faces_set (problem, next_face, lelement, neighs[ineigh],
+                             level + level_diff, ltreeid,
+                             face_children ==
+                             NULL ? NULL : face_children[ineigh],
+                             ts->t8_element_face_child_face (element, iface,
+                                                             ineigh),
+                             tree_vertices);
+      }
+      if (face_children != NULL) {
+        ts->t8_element_destroy (num_neighs, face_children);
+        T8_FREE (face_children);
+        face_children = NULL;
+      }
+    }
+    else if (num_neighs == 0
+             || neighs[0] >= num_local
+             || (level_diff == 0 && neighs[0] > lelement)) {
+      /* A boundary face, a face to a ghost, or a conforming face whose
+       * neighbor has a larger index */
+      T8_ASSERT (num_neighs <= 1);
+      t8_advect_faces_set (problem, next_face, lelement,
+                           num_neighs == 0 ? lelement : neighs[0], level,
+                           ltreeid, element, iface, tree_vertices);
+    }
+  }
+}
+
+/* (Re)build the face list of a problem for the current forest.
+ * The forest must have a face neighbor table. */
+static void
+t8_advect_faces_build (t8_advect_problem_t * problem)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  t8_locidx_t         itree, ielement, lelement, num_elems_in_tree;
+  t8_locidx_t        *next_face;
+  t8_eclass_scheme_c *ts;
+  t8_advect_element_data_t *elem_data;
+  double             *tree_vertices;
+  int                 ipass, idim, ibin;
+
+  t8_advect_faces_destroy (problem);
+  faces->num_elements = t8_forest_get_num_element (problem->forest);
+  faces->num_bins =
+    problem->multirate ? problem->maxlevel - problem->level + 1 : 2;
+  faces->bin_offsets = T8_ALLOC_ZERO (t8_locidx_t, faces->num_bins + 1);
+  next_face = T8_ALLOC_ZERO (t8_locidx_t, faces->num_bins);
+  /* In the first pass we count the faces, in the second one we fill them */
+  for (ipass = 0; ipass < 2; ipass++) {
+    if (ipass == 1) {
+      for (ibin = 0; ibin < faces->num_bins; ibin++) {
+        faces->bin_offsets[ibin + 1] =
+          faces->bin_offsets[ibin] + next_face[ibin];
+        next_face[ibin] = faces->bin_offsets[ibin];
+      }
+      faces->num_faces = faces->bin_offsets[faces->num_bins];
+      faces->left = T8_ALLOC (t8_locidx_t, faces->num_faces);
+      faces->right = T8_ALLOC (t8_locidx_t, faces->num_faces);
+      faces->area = T8_ALLOC (double, faces->num_faces);
+      for (idim = 0; idim < 3; idim++) {
+        faces->center[idim] = T8_ALLOC (double, faces->num_faces);
+        faces->normal[idim] = T8_ALLOC (double, faces->num_faces);
+      }
+      faces->area_u = T8_ALLOC (double, faces->num_faces);
+      faces->flux = T8_ALLOC (double, faces->num_faces);
+    }
+    for (itree = 0, lelement = 0;
+         itree < t8_forest_get_num_local_trees (problem->forest); itree++) {
+      ts =
+        t8_forest_get_eclass_scheme (problem->forest,
+                                     t8_forest_get_tree_class
+                                     (problem->forest, itree));
+      tree_vertices = t8_forest_get_tree_vertices (problem->forest, itree);
+      num_elems_in_tree =
+        t8_forest_get_tree_num_elements (problem->forest, itree);
+      for (ielement = 0; ielement < num_elems_in_tree;
+           ielement++, lelement++) {
+        t8_advect_faces_add_element (problem, next_face, itree, lelement,
+                                     t8_forest_get_element_in_tree
+                                     (problem->forest, itree, ielement),
+                                     ts, tree_vertices);
+      }
+    }
+  }
+#ifdef T8_ENABLE_DEBUG
+  for (ibin = 0; ibin < faces->num_bins; ibin++) {
+    T8_ASSERT (next_face[ibin] == faces->bin_offsets[ibin + 1]);
+  }
+#endif
+  T8_FREE (next_face);
+  faces->inv_vol = T8_ALLOC (double, faces->num_elements);
+  faces->flux_sum = T8_ALLOC_ZERO (double, faces->num_elements);
+  for (lelement = 0; lelement < faces->num_elements; lelement++) {
+    elem_data = (t8_advect_element_data_t *)
+      t8_sc_array_index_locidx (problem->element_data, lelement);
+    faces->inv_vol[lelement] = 1. / elem_data->vol;
+  }
+  if (problem->multirate) {
+    t8_forest_split_levels (problem->forest, &faces->level_offsets,
+                            &faces->level_elements);
+  }
+}
+
+/* Compute the upwind fluxes of the faces first_face, ..., last_face - 1
+ * with the flow at time t.
+ * The loops run over contiguous arrays and have no dependencies between
+ * their iterations. */
+static void
+t8_advect_faces_compute_fluxes (t8_advect_problem_t * problem,
+                                t8_locidx_t first_face, t8_locidx_t last_face,
+                                double t)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  const t8_locidx_t  *left = faces->left, *right = faces->right;
+  const double       *area_u = faces->area_u;
+  double             *flux = faces->flux;
+  const double       *phi;
+  double              x[3], u[3], phi_up;
+  size_t              stride;
+  t8_locidx_t         iface;
+
+  /* The phi values may be stored with a second (dummy) entry per element */
+  phi = (const double *) problem->phi_values->array;
+  stride = problem->phi_values->elem_size / sizeof (double);
+  /* Compute the flow through the faces at the current time */
+  for (iface = first_face; iface < last_face; iface++) {
+    x[0] = faces->center[0][iface];
+    x[1] = faces->center[1][iface];
+    x[2] = faces->center[2][iface];
+    problem->u (x, t, u);
+    faces->area_u[iface] = faces->area[iface] *
+      (faces->normal[0][iface] * u[0] + faces->normal[1][iface] * u[1]
+       + faces->normal[2][iface] * u[2]);
+  }
+  /* Compute the upwind fluxes */
+  for (iface = first_face; iface < last_face; iface++) {
+    phi_up = area_u[iface] >= 0 ? phi[stride * left[iface]]
+      : phi[stride * right[iface]];
+    flux[iface] = -phi_up * area_u[iface];
+  }
+}
+
+/* Advance all local elements by one time step with the face list.
+ * If data_exchange is not NULL, it is the running exchange of the phi
+ * values of the ghosts. The fluxes of the faces between local elements are
+ * computed while it progresses, and the fluxes of the faces to ghosts
+ * after it has ended. */
+static void
+t8_advect_faces_advance (t8_advect_problem_t * problem,
+                         t8_ghost_data_exchange_t * data_exchange)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  const t8_locidx_t  *left = faces->left, *right = faces->right;
+  const double       *flux = faces->flux;
+  double             *flux_sum = faces->flux_sum;
+  double             *phi;
+  double              flux_time, exchange_time, start_time, hidden_time;
+  size_t              stride;
+  t8_locidx_t         iface, lelement, chunk, first_face, num_interior;
+  int                 done;
+
+  T8_ASSERT (!problem->multirate);
+  /* Bin 0 holds the faces between local elements, bin 1 those to ghosts */
+  num_interior = faces->bin_offsets[1];
+
+  flux_time = -sc_MPI_Wtime ();
+  exchange_time = 0;
+  if (data_exchange != NULL) {
+    /* Compute the interior fluxes in chunks and test the exchange after
+     * each of them, such that it progresses. The communication is hidden
+     * until the first successful test. */
+    start_time = sc_MPI_Wtime ();
+    hidden_time = -1;
+    chunk = SC_MAX (1, num_interior / T8_ADVECT_NUM_TESTS);
+    for (first_face = 0; first_face < num_interior; first_face += chunk) {
+      t8_advect_faces_compute_fluxes (problem, first_face,
+                                      SC_MIN (first_face + chunk,
+                                              num_interior), problem->t);
+      if (hidden_time < 0) {
+        exchange_time -= sc_MPI_Wtime ();
+        done = t8_forest_ghost_exchange_test (data_exchange);
+        exchange_time += sc_MPI_Wtime ();
+        if (done) {
+          hidden_time = sc_MPI_Wtime () - start_time - exchange_time;
+        }
+      }
+    }
+    if (hidden_time < 0) {
+      hidden_time = sc_MPI_Wtime () - start_time - exchange_time;
+    }
+    exchange_time -= sc_MPI_Wtime ();
+    t8_forest_ghost_exchange_end (data_exchange);
+    exchange_time += sc_MPI_Wtime ();
+    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_HIDDEN], hidden_time);
+    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXPOSED],
+                         exchange_time);
+    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXCHANGE],
+                         exchange_time);
+    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_WAIT],
+                         t8_forest_profile_get_ghostexchange_waittime
+                         (problem->forest));
+    problem->stats[ADVECT_GHOST_HIDDEN].count = 1;
+    problem->stats[ADVECT_GHOST_EXPOSED].count = 1;
+    problem->stats[ADVECT_GHOST_EXCHANGE].count = 1;
+    problem->stats[ADVECT_GHOST_WAIT].count = 1;
+    /* The phi values of the ghosts are valid now */
+    t8_advect_faces_compute_fluxes (problem, num_interior, faces->num_faces,
+                                    problem->t);
+  }
+  else {
+    t8_advect_faces_compute_fluxes (problem, 0, faces->num_faces, problem->t);
+  }
+  /* Sum the fluxes of each element */
+  memset (flux_sum, 0, faces->num_elements * sizeof (double));
+  for (iface = 0; iface < faces->num_faces; iface++) {
+    flux_sum[left[iface]] += flux[iface];
+  }
+  for (iface = 0; iface < num_interior; iface++) {
+    if (right[iface] != left[iface]) {
+      flux_sum[right[iface]] -= flux[iface];
+    }
+  }
+  flux_time += sc_MPI_Wtime ();
+  sc_stats_accumulate (&problem->stats[ADVECT_FLUX],
+                       flux_time - exchange_time);
+  problem->stats[ADVECT_FLUX].count = 1;
+  /* Phi^t = dt/vol * sum (f) + Phi^(t-1) */
+  phi = (double *) problem->phi_values->array;
+  stride = problem->phi_values->elem_size / sizeof (double);
+  for (lelement = 0; lelement < faces->num_elements; lelement++) {
+    phi[stride * lelement] +=
+      problem->delta_t * faces->inv_vol[lelement] * flux_sum[lelement];
+  }
+}
+
+/* Advance all local elements by one step of the coarsest level with local
+ * time steps. The step consists of 2^(maxlevel - level) substeps with the
+ * time step of maxlevel. In each substep the faces of the active levels
+ * compute their fluxes, which are added to the flux sums of both their
+ * elements weighted by their time step. An element is updated with its flux
+ * sum at the end of its own time step, such that the scheme stays
+ * conservative at faces between different levels. After each substep but
+ * the last one the ghost values of the updated levels are exchanged.
+ * Return the number of element updates. */
+static double
+t8_advect_faces_advance_multirate (t8_advect_problem_t * problem)
+{
+  t8_advect_face_list_t *faces = &problem->faces;
+  const t8_locidx_t  *left = faces->left, *right = faces->right;
+  const t8_locidx_t  *level_offsets, *level_elements;
+  const double       *flux = faces->flux;
+  double             *flux_sum = faces->flux_sum;
+  double             *phi;
+  double              dt, face_dt, flux_time, ghost_exchange_time;
+  double              num_updates = 0;
+  size_t              stride;
+  t8_locidx_t         iface, ientry, lelement;
+  int                 isubstep, num_substeps, min_level, ibin;
+
+  T8_ASSERT (problem->multirate);
+  num_substeps = 1 << (problem->maxlevel - problem->level);
+  dt = problem->delta_t / num_substeps;
+  level_offsets = (const t8_locidx_t *) faces->level_offsets.array;
+  level_elements = (const t8_locidx_t *) faces->level_elements.array;
+  phi = (double *) problem->phi_values->array;
+  stride = problem->phi_values->elem_size / sizeof (double);
+  for (isubstep = 0; isubstep < num_substeps; isubstep++) {
+    flux_time = -sc_MPI_Wtime ();
+    /* The faces of the levels >= min_level start a step. They are the bins
+     * 0, ..., maxlevel - min_level. */
+    min_level = t8_forest_multirate_min_level (problem->level,
+                                               problem->maxlevel, isubstep);
+    t8_advect_faces_compute_fluxes (problem, 0,
+                                    faces->bin_offsets[problem->maxlevel -
+                                                       min_level + 1],
+                                    problem->t + isubstep * dt);
+    for (ibin = 0; ibin <= problem->maxlevel - min_level; ibin++) {
+      face_dt = dt * (1 << ibin);
+      for (iface = faces->bin_offsets[ibin];
+           iface < faces->bin_offsets[ibin + 1]; iface++) {
+        flux_sum[left[iface]] += face_dt * flux[iface];
+        if (right[iface] < faces->num_elements
+            && right[iface] != left[iface]) {
+          flux_sum[right[iface]] -= face_dt * flux[iface];
+        }
+      }
+    }
+    /* The elements of the levels >= min_level end their step */
+    min_level = t8_forest_multirate_min_level (problem->level,
+                                               problem->maxlevel,
+                                               (isubstep + 1) % num_substeps);
+    for (ientry = level_offsets[min_level]; ientry < faces->num_elements;
+         ientry++) {
+      lelement = level_elements[ientry];
+      phi[stride * lelement] += faces->inv_vol[lelement] * flux_sum[lelement];
+      flux_sum[lelement] = 0;
+    }
+    num_updates += faces->num_elements - level_offsets[min_level];
+    flux_time += sc_MPI_Wtime ();
+    sc_stats_accumulate (&problem->stats[ADVECT_FLUX], flux_time);
+    problem->stats[ADVECT_FLUX].count = 1;
+    if (isubstep + 1 < num_substeps) {
+      /* Only the ghosts of the updated levels changed. The exchange after
+       * the last substep is done by the caller. */
+      ghost_exchange_time = -sc_MPI_Wtime ();
+      t8_forest_ghost_exchange_levels (problem->forest, problem->phi_values,
+                                       min_level);
+      ghost_exchange_time += sc_MPI_Wtime ();
+      sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXCHANGE],
+                           ghost_exchange_time);
+      sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXPOSED],
+                           ghost_exchange_time);
+      sc_stats_accumulate (&problem->stats[ADVECT_GHOST_WAIT],
+                           t8_forest_profile_get_ghostexchange_waittime
+                           (problem->forest));
+    }
+  }
+  return num_updates;
+}
+
 /* Compute element midpoint and vol and store at element_data field.
  * tree_vertices can be NULL, if not it should point to the vertex coordinates of the tree */
 static void
@@ -953,6 +1436,10 @@ t8_advect_problem_adapt (t8_advect_problem_t * problem, int measure_time)
   }
   /* We also want ghost elements in the new forest */
   t8_forest_set_ghost (problem->forest_adapt, 1, T8_GHOST_FACES);
+  if (problem->face_solver) {
+    t8_forest_set_face_neighbors (problem->forest_adapt, 1);
+    t8_forest_set_geometry_cache (problem->forest_adapt, 1);
+  }
   /* Commit the forest, adaptation and balance happens here */
   t8_forest_commit (problem->forest_adapt);
 
@@ -1045,6 +1532,10 @@ t8_advect_problem_partition (t8_advect_problem_t * problem, int measure_time)
   /* Partition the forest and create ghosts */
   t8_forest_set_partition (forest_partition, problem->forest, 0);
   t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
+  if (problem->face_solver) {
+    t8_forest_set_face_neighbors (forest_partition, 1);
+    t8_forest_set_geometry_cache (forest_partition, 1);
+  }
   t8_forest_commit (forest_partition);
   /* Add runtimes to internal stats */
   if (measure_time) {
@@ -1169,7 +1660,7 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
                         int level, int maxlevel,
                         double T, double cfl, sc_MPI_Comm comm,
                         double band_width, int dim, int dummy_op,
-                        int volume_refine)
+                        int volume_refine, int face_solver, int multirate)
 {
   t8_advect_problem_t *problem;
   t8_scheme_cxx_t    *default_scheme;
@@ -1200,6 +1691,11 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
   problem->band_width = band_width;     /* width of the refinemen band around 0 level-set */
   problem->dim = dim;           /* dimension of the mesh */
   problem->dummy_op = dummy_op; /* If true, emulate more computational load per element */
+  problem->face_solver = face_solver;   /* If true, use the face list */
+  problem->multirate = multirate;       /* If true, use local time steps */
+  memset (&problem->faces, 0, sizeof (t8_advect_face_list_t));
+  sc_array_init (&problem->faces.level_offsets, sizeof (t8_locidx_t));
+  sc_array_init (&problem->faces.level_elements, sizeof (t8_locidx_t));
 
   for (i = 0; i < ADVECT_NUM_STATS; i++) {
     sc_stats_init (&problem->stats[i], advect_stat_names[i]);
@@ -1210,6 +1706,18 @@ t8_advect_problem_init (t8_cmesh_t cmesh,
 
   problem->forest =
     t8_forest_new_uniform (cmesh, default_scheme, level, 1, comm);
+  if (face_solver) {
+    t8_forest_t         forest_copy;
+
+    /* The face solver needs the face neighbor table and the geometry cache */
+    t8_forest_init (&forest_copy);
+    t8_forest_set_copy (forest_copy, problem->forest);
+    t8_forest_set_ghost (forest_copy, 1, T8_GHOST_FACES);
+    t8_forest_set_face_neighbors (forest_copy, 1);
+    t8_forest_set_geometry_cache (forest_copy, 1);
+    t8_forest_commit (forest_copy);
+    problem->forest = forest_copy;
+  }
 
   /* Initialize the element array with num_local_elements + num_ghosts entries. */
 
@@ -1319,6 +1827,15 @@ t8_advect_problem_init_elements (t8_advect_problem_t * problem)
       /* Set the faces */
       elem_data->num_faces = ts->t8_element_num_faces (element);
       for (iface = 0; iface < elem_data->num_faces; iface++) {
+        if (problem->face_solver) {
+          /* The face solver reads the neighbors from the forest */
+          elem_data->num_neighbors[iface] = 0;
+          elem_data->flux_valid[iface] = -1;
+          elem_data->dual_faces[iface] = NULL;
+          elem_data->fluxes[iface] = NULL;
+          elem_data->neighs[iface] = NULL;
+          continue;
+        }
         /* Compute the indices of the face neighbors */
 
         t8_forest_leaf_face_neighbors (problem->forest, itree, element,
@@ -1474,6 +1991,7 @@ t8_advect_problem_destroy (t8_advect_problem_t ** pproblem)
   }
   /* destroy elements */
   t8_advect_problem_elements_destroy (problem);
+  t8_advect_faces_destroy (problem);
   /* Free the element array */
   sc_array_destroy (problem->element_data);
   if (problem->element_data_adapt != NULL) {
@@ -1490,36 +2008,251 @@ t8_advect_problem_destroy (t8_advect_problem_t ** pproblem)
   *pproblem = NULL;
 }
 
+/* Simulate more load per element by useless operations on the
+ * second phi entry of an element */
+static void
+t8_advect_dummy_op (t8_advect_problem_t * problem, t8_locidx_t ielement)
+{
+  int                 i, j;
+  double             *phi_values;
+  double              dummy_time = -sc_MPI_Wtime ();
+
+  phi_values =
+    (double *) t8_sc_array_index_locidx (problem->phi_values, ielement);
+  phi_values[1] = 0;
+  for (i = 1; i < 5; i++) {
+    phi_values[1] *= i;
+    for (j = 0; j < 5; j++) {
+      phi_values[1] += pow (i, j);
+    }
+  }
+  dummy_time += sc_MPI_Wtime ();
+  sc_stats_accumulate (&problem->stats[ADVECT_DUMMY], dummy_time);
+  problem->stats[ADVECT_DUMMY].count = 1;
+}
+
+/* Advance all local elements by one time step with the element loop.
+ * The face neighbors and fluxes are stored in the element data and are
+ * recomputed if the forest was adapted or partitioned. */
+static void
+t8_advect_advance_elements (t8_advect_problem_t * problem,
+                            int adapted_or_partitioned)
+{
+  int                 iface, ineigh;
+  t8_locidx_t         itree, ielement, lelement;
+  t8_advect_element_data_t *elem_data, *neigh_data = NULL;
+  double              flux;
+  double             *tree_vertices;
+  int                 num_faces;
+  int                 dual_face;
+  t8_element_t       *elem, **neighs;
+  t8_eclass_scheme_c *neigh_scheme;
+  double              neighbor_time, flux_time;
+  int                 hanging, neigh_is_ghost;
+  t8_locidx_t         neigh_index = -1;
+  double              phi_plus, phi_minus;
+
+  for (itree = 0, lelement = 0;
+       itree < t8_forest_get_num_local_trees (problem->forest); itree++) {
+    /* tree loop */
+    /* Get the vertices of this tree */
+    tree_vertices = t8_forest_get_tree_vertices (problem->forest, itree);
+    /* Get the scheme of this tree */
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (problem->forest,
+                                                     itree);
+         ielement++, lelement++) {
+      /* element loop */
+      /* Get a pointer to the element data */
+      elem_data = (t8_advect_element_data_t *)
+        t8_sc_array_index_locidx (problem->element_data, lelement);
+      elem =
+        t8_forest_get_element_in_tree (problem->forest, itree, ielement);
+      num_faces = elem_data->num_faces;
+      /* Compute left and right flux */
+      for (iface = 0; iface < num_faces; iface++) {
+        if (elem_data->flux_valid[iface] <= 0 || adapted_or_partitioned) {
+
+          /* Compute flux at this face */
+          if (adapted_or_partitioned) {
+            /* We changed the mesh, so that we have to calculate the neighbor
+             * indices again. */
+            if (elem_data->num_neighbors[iface] > 0) {
+              T8_FREE (elem_data->neighs[iface]);
+              T8_FREE (elem_data->dual_faces[iface]);
+              elem_data->flux_valid[iface] = -1;
+            }
+            T8_FREE (elem_data->fluxes[iface]);
+            neighbor_time = -sc_MPI_Wtime ();
+            t8_forest_leaf_face_neighbors (problem->forest, itree, elem,
+                                           &neighs, iface,
+                                           &elem_data->dual_faces[iface],
+                                           &elem_data->num_neighbors[iface],
+                                           &elem_data->neighs[iface],
+                                           &neigh_scheme, 1);
+            for (ineigh = 0; ineigh < elem_data->num_neighbors[iface];
+                 ineigh++) {
+              elem_data->neigh_level[iface] =
+                neigh_scheme->t8_element_level (neighs[ineigh]);
+            }
+
+
+
+            /* *INDENT-OFF* */
+            neigh_scheme->t8_element_destroy (elem_data->num_neighbors[iface],
+                                              neighs);
+            /* *INDENT-ON* */
+
+            T8_FREE (neighs);
+
+            /* Allocate flux storage */
+            elem_data->fluxes[iface] =
+              T8_ALLOC (double,
+                        SC_MAX (1, elem_data->num_neighbors[iface]));
+            elem_data->flux_valid[iface] = 0;
+
+            neighbor_time += sc_MPI_Wtime ();
+            sc_stats_accumulate (&problem->stats[ADVECT_NEIGHS],
+                                 neighbor_time);
+            /* We want to count all runs over the solver time as one */
+            problem->stats[ADVECT_NEIGHS].count = 1;
+          }
+
+          /* sensible default */
+          neigh_data = NULL;
+          neigh_is_ghost = 0;
+          /* Compute whether this is a hanging face
+           * and whether the first neighbor is a ghost */
+          if (elem_data->num_neighbors[iface] >= 1) {
+
+            neigh_index = elem_data->neighs[iface][0];
+            neigh_is_ghost = neigh_index >=
+              t8_forest_get_num_element (problem->forest);
+            hanging = elem_data->level != elem_data->neigh_level[iface];
+          }
+          else {
+            hanging = 0;
+            neigh_is_ghost = 0;
+          }
+          flux_time = -sc_MPI_Wtime ();
+          if (problem->dim == 1) {
+            if (elem_data->num_neighbors[iface] == 0) {
+              T8_ASSERT (elem_data->num_neighbors[iface] <= 0);
+              /* This is a boundary */
+              neigh_index = -1;
+            }
+#if 0
+            flux =
+              t8_advect_flux_lax_friedrich_1d (problem, plus_data,
+                                               minus_data);
+#else
+            flux =
+              t8_advect_flux_upwind_1d (problem, lelement, neigh_index,
+                                        iface);
+#endif
+            elem_data->fluxes[iface][0] = flux;
+            elem_data->flux_valid[iface] = 1;
+          }
+          else {
+            T8_ASSERT (problem->dim == 2 || problem->dim == 3);
+            /* Check whether the flux for the neighbor element was computed */
+            /* Get a pointer to the neighbor element */
+            if (elem_data->num_neighbors[iface] >= 1 && !neigh_is_ghost) {
+              neigh_data = (t8_advect_element_data_t *)
+                t8_sc_array_index_locidx (problem->element_data,
+                                          neigh_index);
+            }
+
+            /* Get the phi value at the current element */
+            phi_plus = t8_advect_element_get_phi (problem, lelement);
+            if (elem_data->num_neighbors[iface] == 1) {
+              dual_face = elem_data->dual_faces[iface][0];
+              /* There is exactly one face-neighbor */
+              /* get the phi value at the neighbor element */
+              phi_minus = t8_advect_element_get_phi (problem, neigh_index);
+              flux =
+                t8_advect_flux_upwind (problem, phi_plus, phi_minus,
+                                       itree, elem, tree_vertices, iface);
+
+              elem_data->flux_valid[iface] = 1;
+              elem_data->fluxes[iface][0] = flux;
+
+              /* If this face is not hanging, we can set the
+               * flux of the neighbor element as well */
+              if (!adapted_or_partitioned && !neigh_is_ghost && !hanging) {
+                if (neigh_data->flux_valid[dual_face] < 0) {
+                  neigh_data->fluxes[dual_face] = T8_ALLOC (double, 1);
+                  neigh_data->dual_faces[dual_face] = T8_ALLOC (int, 1);
+                  neigh_data->neighs[dual_face] = T8_ALLOC (t8_locidx_t, 1);
+                }
+                SC_CHECK_ABORT (dual_face < neigh_data->num_faces, "num\n");
+                //         SC_CHECK_ABORT (neigh_data->num_neighbors[dual_face] == 1, "dual face\n");
+                neigh_data->fluxes[dual_face][0] = -flux;
+                neigh_data->dual_faces[dual_face][0] = iface;
+                neigh_data->neighs[dual_face][0] = lelement;
+                neigh_data->flux_valid[dual_face] = 1;
+              }
+            }
+            else if (elem_data->num_neighbors[iface] > 1) {
+              flux =
+                t8_advect_flux_upwind_hanging (problem, lelement, itree,
+                                               elem, tree_vertices, iface,
+                                               adapted_or_partitioned);
+            }
+            else {
+              /* This element is at the domain boundary */
+              /* We enforce outflow boundary conditions */
+              T8_ASSERT (elem_data->num_neighbors[iface] <= 0);
+              t8_advect_boundary_set_phi (problem, lelement, &phi_minus);
+
+              flux =
+                t8_advect_flux_upwind (problem, phi_plus, phi_minus,
+                                       itree, elem, tree_vertices, iface);
+
+              elem_data->flux_valid[iface] = 1;
+              elem_data->fluxes[iface][0] = flux;
+            }
+          }
+          flux_time += sc_MPI_Wtime ();
+
+          sc_stats_accumulate (&problem->stats[ADVECT_FLUX], flux_time);
+          /* We want to count all runs over the solver time as one */
+          problem->stats[ADVECT_FLUX].count = 1;
+        }
+      }
+      if (problem->dummy_op) {
+        t8_advect_dummy_op (problem, ielement);
+      }
+      /* Compute time step */
+      //      printf ("advance %i\n", ielement);
+      t8_advect_advance_element (problem, lelement);
+    }
+  }
+  /* Store the advanced phi value in each element */
+  t8_advect_project_element_data (problem);
+}
+
 static void
 t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
                  t8_example_level_set_fn phi_0, void *ls_data,
                  const int level, const int maxlevel, double T, double cfl,
                  sc_MPI_Comm comm, int adapt_freq, int no_vtk,
                  int vtk_freq, double band_width, int dim, int dummy_op,
-                 int volume_refine)
+                 int volume_refine, int face_solver, int overlap,
+                 int multirate)
 {
   t8_advect_problem_t *problem;
-  int                 iface, ineigh;
-  t8_locidx_t         itree, ielement, lelement;
-  t8_advect_element_data_t *elem_data, *neigh_data = NULL;
-  double              flux;
+  t8_ghost_data_exchange_t *data_exchange = NULL;
+  t8_locidx_t         lelement, num_local_elements;
   double              l_infty, L_2;
-  double             *tree_vertices;
   int                 modulus, time_steps;
-  int                 num_faces;
   int                 done = 0;
   int                 adapted_or_partitioned = 0;
-  int                 dual_face;
-  t8_element_t       *elem, **neighs;
-  t8_eclass_scheme_c *neigh_scheme;
   double              total_time, solve_time = 0;
-  double              ghost_exchange_time, ghost_waittime, neighbor_time,
-    flux_time;
+  double              ghost_exchange_time, ghost_waittime, neighbor_time;
   double              vtk_time = 0;
   double              start_volume, end_volume;
-  int                 hanging, neigh_is_ghost;
-  t8_locidx_t         neigh_index = -1;
-  double              phi_plus, phi_minus;
+  double              cell_updates = 0, global_cell_updates, max_solve_time;
 
   /* Initialize problem */
   /* start timing */
@@ -1527,7 +2260,7 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
   problem =
     t8_advect_problem_init (cmesh, u, phi_0, ls_data, level, maxlevel, T,
                             cfl, comm, band_width, dim, dummy_op,
-                            volume_refine);
+                            volume_refine, face_solver, multirate);
   t8_advect_problem_init_elements (problem);
 
   if (maxlevel > level) {
@@ -1550,6 +2283,12 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
   t8_advect_print_phi (problem);
 #endif
 
+  if (multirate) {
+    /* delta_t is the CFL time step of the finest level. Each coarser level
+     * takes a step twice as large as the next finer one. */
+    problem->delta_t *= 1 << (maxlevel - level);
+  }
+
   /* Set initialization runtime */
   sc_stats_set1 (&problem->stats[ADVECT_INIT], total_time + sc_MPI_Wtime (),
                  advect_stat_names[ADVECT_INIT]);
@@ -1584,202 +2323,36 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
     sc_stats_accumulate (&problem->stats[ADVECT_ELEM_AVG],
                          t8_forest_get_global_num_elements (problem->forest));
 
+    num_local_elements = t8_forest_get_num_element (problem->forest);
     solve_time -= sc_MPI_Wtime ();
-    for (itree = 0, lelement = 0;
-         itree < t8_forest_get_num_local_trees (problem->forest); itree++) {
-      /* tree loop */
-      /* Get the vertices of this tree */
-      tree_vertices = t8_forest_get_tree_vertices (problem->forest, itree);
-      /* Get the scheme of this tree */
-      for (ielement = 0;
-           ielement < t8_forest_get_tree_num_elements (problem->forest,
-                                                       itree);
-           ielement++, lelement++) {
-        /* element loop */
-        /* Get a pointer to the element data */
-        elem_data = (t8_advect_element_data_t *)
-          t8_sc_array_index_locidx (problem->element_data, lelement);
-        elem =
-          t8_forest_get_element_in_tree (problem->forest, itree, ielement);
-        num_faces = elem_data->num_faces;
-        /* Compute left and right flux */
-        for (iface = 0; iface < num_faces; iface++) {
-          if (elem_data->flux_valid[iface] <= 0 || adapted_or_partitioned) {
-
-            /* Compute flux at this face */
-            if (adapted_or_partitioned) {
-              /* We changed the mesh, so that we have to calculate the neighbor
-               * indices again. */
-              if (elem_data->num_neighbors[iface] > 0) {
-                T8_FREE (elem_data->neighs[iface]);
-                T8_FREE (elem_data->dual_faces[iface]);
-                elem_data->flux_valid[iface] = -1;
-              }
-              T8_FREE (elem_data->fluxes[iface]);
-              neighbor_time = -sc_MPI_Wtime ();
-              t8_forest_leaf_face_neighbors (problem->forest, itree, elem,
-                                             &neighs, iface,
-                                             &elem_data->dual_faces[iface],
-                                             &elem_data->num_neighbors[iface],
-                                             &elem_data->neighs[iface],
-                                             &neigh_scheme, 1);
-              for (ineigh = 0; ineigh < elem_data->num_neighbors[iface];
-                   ineigh++) {
-                elem_data->neigh_level[iface] =
-                  neigh_scheme->t8_element_level (neighs[ineigh]);
-              }
-
-
-
-              /* *INDENT-OFF* */
-              neigh_scheme->t8_element_destroy (elem_data->num_neighbors[iface],
-                                                neighs);
-              /* *INDENT-ON* */
-
-              T8_FREE (neighs);
-
-              /* Allocate flux storage */
-              elem_data->fluxes[iface] =
-                T8_ALLOC (double,
-                          SC_MAX (1, elem_data->num_neighbors[iface]));
-              elem_data->flux_valid[iface] = 0;
-
-              neighbor_time += sc_MPI_Wtime ();
-              sc_stats_accumulate (&problem->stats[ADVECT_NEIGHS],
-                                   neighbor_time);
-              /* We want to count all runs over the solver time as one */
-              problem->stats[ADVECT_NEIGHS].count = 1;
-            }
-
-            /* sensible default */
-            neigh_data = NULL;
-            neigh_is_ghost = 0;
-            /* Compute whether this is a hanging face
-             * and whether the first neighbor is a ghost */
-            if (elem_data->num_neighbors[iface] >= 1) {
-
-              neigh_index = elem_data->neighs[iface][0];
-              neigh_is_ghost = neigh_index >=
-                t8_forest_get_num_element (problem->forest);
-              hanging = elem_data->level != elem_data->neigh_level[iface];
-            }
-            else {
-              hanging = 0;
-              neigh_is_ghost = 0;
-            }
-            flux_time = -sc_MPI_Wtime ();
-            if (problem->dim == 1) {
-              if (elem_data->num_neighbors[iface] == 0) {
-                T8_ASSERT (elem_data->num_neighbors[iface] <= 0);
-                /* This is a boundary */
-                neigh_index = -1;
-              }
-#if 0
-              flux =
-                t8_advect_flux_lax_friedrich_1d (problem, plus_data,
-                                                 minus_data);
-#else
-              flux =
-                t8_advect_flux_upwind_1d (problem, lelement, neigh_index,
-                                          iface);
-#endif
-              elem_data->fluxes[iface][0] = flux;
-              elem_data->flux_valid[iface] = 1;
-            }
-            else {
-              T8_ASSERT (problem->dim == 2 || problem->dim == 3);
-              /* Check whether the flux for the neighbor element was computed */
-              /* Get a pointer to the neighbor element */
-              if (elem_data->num_neighbors[iface] >= 1 && !neigh_is_ghost) {
-                neigh_data = (t8_advect_element_data_t *)
-                  t8_sc_array_index_locidx (problem->element_data,
-                                            neigh_index);
-              }
-
-              /* Get the phi value at the current element */
-              phi_plus = t8_advect_element_get_phi (problem, lelement);
-              if (elem_data->num_neighbors[iface] == 1) {
-                dual_face = elem_data->dual_faces[iface][0];
-                /* There is exactly one face-neighbor */
-                /* get the phi value at the neighbor element */
-                phi_minus = t8_advect_element_get_phi (problem, neigh_index);
-                flux =
-                  t8_advect_flux_upwind (problem, phi_plus, phi_minus,
-                                         itree, elem, tree_vertices, iface);
-
-                elem_data->flux_valid[iface] = 1;
-                elem_data->fluxes[iface][0] = flux;
-
-                /* If this face is not hanging, we can set the
-                 * flux of the neighbor element as well */
-                if (!adapted_or_partitioned && !neigh_is_ghost && !hanging) {
-                  if (neigh_data->flux_valid[dual_face] < 0) {
-                    neigh_data->fluxes[dual_face] = T8_ALLOC (double, 1);
-                    neigh_data->dual_faces[dual_face] = T8_ALLOC (int, 1);
-                    neigh_data->neighs[dual_face] = T8_ALLOC (t8_locidx_t, 1);
-                  }
-                  SC_CHECK_ABORT (dual_face < neigh_data->num_faces, "num\n");
-                  //         SC_CHECK_ABORT (neigh_data->num_neighbors[dual_face] == 1, "dual face\n");
-                  neigh_data->fluxes[dual_face][0] = -flux;
-                  neigh_data->dual_faces[dual_face][0] = iface;
-                  neigh_data->neighs[dual_face][0] = lelement;
-                  neigh_data->flux_valid[dual_face] = 1;
-                }
-              }
-              else if (elem_data->num_neighbors[iface] > 1) {
-                flux =
-                  t8_advect_flux_upwind_hanging (problem, lelement, itree,
-                                                 elem, tree_vertices, iface,
-                                                 adapted_or_partitioned);
-              }
-              else {
-                /* This element is at the domain boundary */
-                /* We enforce outflow boundary conditions */
-                T8_ASSERT (elem_data->num_neighbors[iface] <= 0);
-                t8_advect_boundary_set_phi (problem, lelement, &phi_minus);
-
-                flux =
-                  t8_advect_flux_upwind (problem, phi_plus, phi_minus,
-                                         itree, elem, tree_vertices, iface);
-
-                elem_data->flux_valid[iface] = 1;
-                elem_data->fluxes[iface][0] = flux;
-              }
-            }
-            flux_time += sc_MPI_Wtime ();
-
-            sc_stats_accumulate (&problem->stats[ADVECT_FLUX], flux_time);
-            /* We want to count all runs over the solver time as one */
-            problem->stats[ADVECT_FLUX].count = 1;
-          }
-        }
-        if (problem->dummy_op) {
-          /* simulate more load per element */
-          int                 i, j;
-          double             *phi_values;
-          double              dummy_time = -sc_MPI_Wtime ();
-          phi_values =
-            (double *) t8_sc_array_index_locidx (problem->phi_values,
-                                                 ielement);
-          phi_values[1] = 0;
-          for (i = 1; i < 5; i++) {
-            phi_values[1] *= i;
-            for (j = 0; j < 5; j++) {
-              phi_values[1] += pow (i, j);
-            }
-          }
-          dummy_time += sc_MPI_Wtime ();
-          sc_stats_accumulate (&problem->stats[ADVECT_DUMMY], dummy_time);
-          problem->stats[ADVECT_DUMMY].count = 1;
+    if (problem->face_solver) {
+      if (adapted_or_partitioned || problem->num_time_steps == 0) {
+        /* (Re)build the face list for the current forest */
+        neighbor_time = -sc_MPI_Wtime ();
+        t8_advect_faces_build (problem);
+        neighbor_time += sc_MPI_Wtime ();
+        sc_stats_accumulate (&problem->stats[ADVECT_NEIGHS], neighbor_time);
+        problem->stats[ADVECT_NEIGHS].count = 1;
+      }
+      if (problem->dummy_op) {
+        for (lelement = 0; lelement < num_local_elements; lelement++) {
+          t8_advect_dummy_op (problem, lelement);
         }
-        /* Compute time step */
-        //      printf ("advance %i\n", ielement);
-        t8_advect_advance_element (problem, lelement);
       }
+      if (multirate) {
+        cell_updates += t8_advect_faces_advance_multirate (problem);
+      }
+      else {
+        t8_advect_faces_advance (problem, data_exchange);
+        data_exchange = NULL;
+        cell_updates += num_local_elements;
+      }
+    }
+    else {
+      t8_advect_advance_elements (problem, adapted_or_partitioned);
+      cell_updates += num_local_elements;
     }
     adapted_or_partitioned = 0;
-    /* Store the advanced phi value in each element */
-    t8_advect_project_element_data (problem);
     solve_time += sc_MPI_Wtime ();
 #if 0
     /* test adapt, adapt and balance 3 times during the whole computation */
@@ -1799,15 +2372,28 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
 
     /* Exchange ghost values */
     ghost_exchange_time = -sc_MPI_Wtime ();
-    t8_forest_ghost_exchange_data (problem->forest, problem->phi_values);
+    if (overlap) {
+      /* Start the exchange, it is ended during the next flux computation */
+      data_exchange =
+        t8_forest_ghost_exchange_begin (problem->forest, problem->phi_values);
+    }
+    else {
+      t8_forest_ghost_exchange_data (problem->forest, problem->phi_values);
+    }
     ghost_exchange_time += sc_MPI_Wtime ();
     sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXCHANGE],
                          ghost_exchange_time);
-    ghost_waittime =
-      t8_forest_profile_get_ghostexchange_waittime (problem->forest);
-    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_WAIT], ghost_waittime);
+    sc_stats_accumulate (&problem->stats[ADVECT_GHOST_EXPOSED],
+                         ghost_exchange_time);
+    if (!overlap) {
+      ghost_waittime =
+        t8_forest_profile_get_ghostexchange_waittime (problem->forest);
+      sc_stats_accumulate (&problem->stats[ADVECT_GHOST_WAIT],
+                           ghost_waittime);
+    }
     /* We want to count all runs over the solver time as one */
     problem->stats[ADVECT_GHOST_EXCHANGE].count = 1;
+    problem->stats[ADVECT_GHOST_EXPOSED].count = 1;
     problem->stats[ADVECT_GHOST_WAIT].count = 1;
 
     if (problem->t + problem->delta_t > problem->T) {
@@ -1819,6 +2405,10 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
       done = 1;
     }
   }                             /* End element loop */
+  if (data_exchange != NULL) {
+    /* Finish the exchange of the last time step */
+    t8_forest_ghost_exchange_end (data_exchange);
+  }
   if (!no_vtk) {
     vtk_time -= sc_MPI_Wtime ();
     /* Print last time step vtk */
@@ -1831,6 +2421,20 @@ t8_advect_solve (t8_cmesh_t cmesh, t8_flow_function_3d_fn u,
                  advect_stat_names[ADVECT_TOTAL]);
   sc_stats_set1 (&problem->stats[ADVECT_SOLVE], solve_time,
                  advect_stat_names[ADVECT_SOLVE]);
+  sc_stats_set1 (&problem->stats[ADVECT_CELLS_PER_SECOND],
+                 solve_time > 0 ? cell_updates / solve_time : 0,
+                 advect_stat_names[ADVECT_CELLS_PER_SECOND]);
+  /* The global rate is limited by the slowest process */
+  sc_MPI_Allreduce (&cell_updates, &global_cell_updates, 1, sc_MPI_DOUBLE,
+                    sc_MPI_SUM, problem->comm);
+  sc_MPI_Allreduce (&solve_time, &max_solve_time, 1, sc_MPI_DOUBLE,
+                    sc_MPI_MAX, problem->comm);
+  t8_global_essentialf ("[advect] %s solver: %e cell updates in %f s,"
+                        " %e cells/s\n",
+                        face_solver ? "Face" : "Element",
+                        global_cell_updates, max_solve_time,
+                        max_solve_time > 0 ?
+                        global_cell_updates / max_solve_time : 0);
   sc_stats_set1 (&problem->stats[ADVECT_IO], vtk_time,
                  advect_stat_names[ADVECT_IO]);
   /* Compute volume loss */
@@ -1869,8 +2473,8 @@ main (int argc, char *argv[])
   const char         *mshfile = NULL;
   int                 level, reflevel, dim, eclass_int, dummy_op;
   int                 parsed, helpme, no_vtk, vtk_freq, adapt_freq;
-  int                 volume_refine;
-  int                 flow_arg;
+  int                 volume_refine, face_solver, overlap, multirate;
+  int                 flow_arg, num_threads;
   double              T, cfl, band_width;
   t8_levelset_sphere_data_t ls_data;
   /* brief help message */
@@ -1946,6 +2550,20 @@ main (int argc, char *argv[])
                          "Suppress vtk output. "
                          "Overwrites any -v setting.");
 
+  sc_options_add_switch (opt, 'F', "face-solver", &face_solver,
+                         "Compute the fluxes with a list of faces built from "
+                         "the face neighbor\n\t\t\t\t     table and the "
+                         "geometry cache of the forest, instead of the "
+                         "element loop.\n\t\t\t\t     Needs dimension 2 "
+                         "or 3.");
+  sc_options_add_switch (opt, 'O', "overlap", &overlap,
+                         "Overlap the ghost exchange with the computation "
+                         "of the fluxes between local\n\t\t\t\t     "
+                         "elements. Needs -F.");
+  sc_options_add_switch (opt, 'M', "multirate", &multirate,
+                         "Use local time steps, each level takes a step "
+                         "with its own CFL time step.\n\t\t\t\t     "
+                         "Needs -F, cannot be combined with -O.");
   sc_options_add_switch (opt, 's', "simulate", &dummy_op,
                          "Simulate more load per element. "
                          "In each iteration, useless dummy operations\n "
@@ -1964,6 +2582,10 @@ main (int argc, char *argv[])
                       "Refine elements close to the 0 level-set only "
                       "if their volume is smaller than the l+V-times refined\n"
                       " smallest element int the mesh.");
+  sc_options_add_int (opt, 'j', "threads", &num_threads, 0,
+                      "The number of threads of the thread-parallel "
+                      "algorithms of t8code.\n\t\t\t\t     "
+                      "Default is the OpenMP default.");
 
   parsed =
     sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
@@ -1975,10 +2597,14 @@ main (int argc, char *argv[])
   else if (parsed >= 0 && 1 <= flow_arg && flow_arg <= 6 && 0 <= level
            && 0 <= reflevel && 0 <= vtk_freq
            && ((mshfile != NULL && 0 < dim && dim <= 3)
-               || (1 <= eclass_int && eclass_int <= 8)) && band_width >= 0) {
+               || (1 <= eclass_int && eclass_int <= 8)) && band_width >= 0
+           && (!face_solver || eclass_int != 1)
+           && (!overlap || face_solver)
+           && (!multirate || (face_solver && !overlap))) {
     t8_cmesh_t          cmesh;
     t8_flow_function_3d_fn u;
 
+    t8_set_num_threads (num_threads);
     if (mshfile == NULL) {
       switch (eclass_int) {
       case 7:
@@ -1992,6 +2618,8 @@ main (int argc, char *argv[])
         T8_ASSERT (eclass_int < 7);
       }
     }
+    SC_CHECK_ABORT (!face_solver || dim > 1,
+                    "The face solver needs a mesh of dimension 2 or 3.\n");
     /* Set level-set midpoint coordinates to zero for unused dimensions. */
     if (eclass_int == 2 || eclass_int == 3 || eclass_int == 7) {
       ls_data.M[2] = 0;
@@ -2013,7 +2641,7 @@ main (int argc, char *argv[])
                      level,
                      level + reflevel, T, cfl, sc_MPI_COMM_WORLD, adapt_freq,
                      no_vtk, vtk_freq, band_width, dim, dummy_op,
-                     volume_refine);
+                     volume_refine, face_solver, overlap, multirate);
   }
   else {
     /* wrong usage */
@@ -74,20 +74,28 @@ t8_read_msh_partition (t8_cmesh_t cmesh, const char *prefix)
  *  dim         The dimension of the mesh to be read from the files.
  *  master      If do_partition is true a valid MPI rank that will read the
  *              file alone. The other processes will not hold any trees then.
+ *  scatter     If true and master is a valid MPI rank, master reads the file
+ *              and scatters the trees uniformly to all processes.
  */
 static t8_cmesh_t
 t8_read_msh_file_build_cmesh (const char *prefix, int do_partition, int dim,
-                              int master)
+                              int master, int scatter)
 {
   t8_cmesh_t          cmesh;
   int                 partitioned_read;
 
-  /* If the master argument is positive, then we read the cmesh
-   * only on the master rank and is directly partitioned. */
-  partitioned_read = master >= 0;
-  cmesh =
-    t8_cmesh_from_msh_file ((char *) prefix, partitioned_read,
-                            sc_MPI_COMM_WORLD, dim, master);
+  if (scatter && master >= 0) {
+    cmesh = t8_cmesh_from_msh_file_scatter (prefix, sc_MPI_COMM_WORLD, dim,
+                                            master);
+  }
+  else {
+    /* If the master argument is positive, then we read the cmesh
+     * only on the master rank and is directly partitioned. */
+    partitioned_read = master >= 0;
+    cmesh =
+      t8_cmesh_from_msh_file ((char *) prefix, partitioned_read,
+                              sc_MPI_COMM_WORLD, dim, master);
+  }
   if (cmesh != NULL) {
     t8_debugf ("Succesfully constructed cmesh from %s.msh file.\n", prefix);
     t8_debugf ("cmesh is of dimension %i and has %lli elements.\n",
@@ -108,6 +116,7 @@ int
 main (int argc, char *argv[])
 {
   int                 mpiret, parsed, partition, dim, master, mpisize;
+  int                 scatter;
   sc_options_t       *opt;
   const char         *prefix;
   char                usage[BUFSIZ];
@@ -144,6 +153,10 @@ main (int argc, char *argv[])
   sc_options_add_int (opt, 'm', "master", &master, -1, "If specified, the "
                       "mesh is partitioned and all elements reside on process with "
                       "rank master.");
+  sc_options_add_bool (opt, 's', "scatter", &scatter, 0, "If true and "
+                       "master is specified, master reads the file and sends "
+                       "the trees directly to their processes in a uniform "
+                       "partition.");
   parsed =
     sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
   if (parsed < 0 || strcmp (prefix, "") == 0 || 0 > dim || dim > 3
@@ -152,7 +165,8 @@ main (int argc, char *argv[])
     return 1;
   }
   else {
-    cmesh = t8_read_msh_file_build_cmesh (prefix, partition, dim, master);
+    cmesh = t8_read_msh_file_build_cmesh (prefix, partition, dim, master,
+                                          scatter);
     t8_cmesh_destroy (&cmesh);
     sc_options_print_summary (t8_get_package_id (), SC_LP_PRODUCTION, opt);
   }
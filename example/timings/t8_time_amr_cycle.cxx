@@ -0,0 +1,382 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program times complete adaptation cycles of a forest.
+ * Each cycle constructs a uniform forest, adapts it around a sphere that
+ * moves from cycle to cycle, balances, partitions and creates the ghost
+ * layer, exchanges one double per element and optionally writes vtk files.
+ * For each cycle and stage, the minimum, mean and maximum runtime over all
+ * processes are written as one line of CSV or as one JSON object per line,
+ * together with the number of processes and elements. Running the program
+ * with different numbers of processes and appending to the same file
+ * produces a strong scaling table for a fixed mesh or a weak scaling table
+ * if the mesh is scaled with the processes.
+ * With -p, the profile of each process in the last cycle is written to a
+ * CSV file, to match slow processes with the mpirank field of the vtk files.
+ */
+
+#include <sc_options.h>
+#include <sc_statistics.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_readmshfile.h>
+#include <example/common/t8_example_common.h>
+
+/* The timed stages of a cycle */
+typedef enum
+{
+  T8_TIME_AMR_NEW = 0,
+  T8_TIME_AMR_ADAPT,
+  T8_TIME_AMR_BALANCE,
+  T8_TIME_AMR_PARTITION,
+  T8_TIME_AMR_GHOST,
+  T8_TIME_AMR_GHOST_EXCHANGE,
+  T8_TIME_AMR_VTK,
+  T8_TIME_AMR_TOTAL,
+  T8_TIME_AMR_NUM_STAGES
+} t8_time_amr_stage_t;
+
+static const char  *t8_time_amr_stage_names[T8_TIME_AMR_NUM_STAGES] = {
+  "new_uniform",
+  "adapt",
+  "balance",
+  "partition",
+  "ghost",
+  "ghost_exchange",
+  "vtk",
+  "total"
+};
+
+/* The options of a benchmark run */
+typedef struct
+{
+  int                 mesh;     /* 0: hybrid hypercube, 1: bigmesh, 2: msh file */
+  int                 eclass;   /* The element class of the bigmesh */
+  int                 num_trees; /* The number of trees of the bigmesh */
+  const char         *mshfile;  /* The prefix of the msh file */
+  int                 dim;      /* The dimension of the msh file */
+  int                 level;    /* The level of the uniform forest */
+  int                 refine;   /* The number of levels refined around the sphere */
+  int                 num_cycles; /* The number of cycles */
+  int                 do_vtk;   /* If true, write vtk files */
+  int                 json;     /* If true, write JSON instead of CSV */
+  int                 append;   /* If true, append to the output file */
+  const char         *scaling;  /* A label for the scaling column */
+  const char         *output;   /* The output file, stdout if NULL */
+  const char         *profile_csv; /* The per process profile file, none if NULL */
+} t8_time_amr_options_t;
+
+static              t8_cmesh_t
+t8_time_amr_cmesh (const t8_time_amr_options_t * opts, sc_MPI_Comm comm)
+{
+  switch (opts->mesh) {
+  case 0:
+    return t8_cmesh_new_hypercube_hybrid (3, comm, 0, 0);
+  case 1:
+    return t8_cmesh_new_bigmesh ((t8_eclass_t) opts->eclass,
+                                 opts->num_trees, comm);
+  default:
+    return t8_cmesh_from_msh_file (opts->mshfile, 0, comm, opts->dim, 0);
+  }
+}
+
+/* Write the results of one cycle on the first process. */
+static void
+t8_time_amr_write (FILE * file, const t8_time_amr_options_t * opts,
+                   int mpisize, int cycle, sc_statinfo_t * stats,
+                   const t8_gloidx_t * num_elements)
+{
+  int                 istage;
+
+  for (istage = 0; istage < T8_TIME_AMR_NUM_STAGES; istage++) {
+    if (istage == T8_TIME_AMR_VTK && !opts->do_vtk) {
+      continue;
+    }
+    if (opts->json) {
+      fprintf (file, "{\"scaling\": \"%s\", \"mpisize\": %i, "
+               "\"level\": %i, \"cycle\": %i, \"stage\": \"%s\", "
+               "\"global_elements\": %lli, \"time_min\": %.6e, "
+               "\"time_mean\": %.6e, \"time_max\": %.6e}\n", opts->scaling,
+               mpisize, opts->level, cycle, t8_time_amr_stage_names[istage],
+               (long long) num_elements[istage], stats[istage].min,
+               stats[istage].average, stats[istage].max);
+    }
+    else {
+      fprintf (file, "%s,%i,%i,%i,%s,%lli,%.6e,%.6e,%.6e\n", opts->scaling,
+               mpisize, opts->level, cycle, t8_time_amr_stage_names[istage],
+               (long long) num_elements[istage], stats[istage].min,
+               stats[istage].average, stats[istage].max);
+    }
+  }
+  fflush (file);
+}
+
+static void
+t8_time_amr_cycles (const t8_time_amr_options_t * opts, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_t         forest, forest_adapt, forest_balance;
+  t8_example_level_set_struct_t ls_data;
+  t8_levelset_sphere_data_t sphere;
+  sc_statinfo_t       stats[T8_TIME_AMR_NUM_STAGES];
+  t8_gloidx_t         num_elements[T8_TIME_AMR_NUM_STAGES];
+  double              times[T8_TIME_AMR_NUM_STAGES], start;
+  sc_array_t          element_data;
+  char                filename[BUFSIZ];
+  FILE               *file = NULL;
+  int                 mpirank, mpisize, mpiret, cycle, istage;
+  int                 procs_sent, balance_rounds;
+  t8_locidx_t         ghosts_sent;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    file = stdout;
+    if (opts->output != NULL) {
+      file = fopen (opts->output, opts->append ? "a" : "w");
+      SC_CHECK_ABORTF (file != NULL, "Could not open file %s", opts->output);
+    }
+    /* Write the CSV header unless we append to an existing table */
+    if (file != stdout) {
+      fseek (file, 0, SEEK_END);
+    }
+    if (!opts->json && (file == stdout || ftell (file) == 0)) {
+      fprintf (file, "scaling,mpisize,level,cycle,stage,global_elements,"
+               "time_min,time_mean,time_max\n");
+    }
+  }
+
+  cmesh = t8_time_amr_cmesh (opts, comm);
+  scheme = t8_scheme_new_default_cxx ();
+  /* Refine around a sphere that moves on a circle */
+  sphere.radius = 0.25;
+  sphere.M[2] = 0.5;
+  ls_data.L = t8_levelset_sphere;
+  ls_data.udata = &sphere;
+  ls_data.band_width = 1;
+  ls_data.t = 0;
+  ls_data.min_level = opts->level;
+  ls_data.max_level = opts->level + opts->refine;
+
+  for (cycle = 0; cycle < opts->num_cycles; cycle++) {
+    sphere.M[0] = 0.5 + 0.25 * cos (2 * M_PI * cycle / opts->num_cycles);
+    sphere.M[1] = 0.5 + 0.25 * sin (2 * M_PI * cycle / opts->num_cycles);
+    memset (times, 0, sizeof (times));
+
+    /* Construct the uniform forest */
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    start = sc_MPI_Wtime ();
+    forest = t8_forest_new_uniform (cmesh, scheme, opts->level, 0, comm);
+    times[T8_TIME_AMR_NEW] = sc_MPI_Wtime () - start;
+    num_elements[T8_TIME_AMR_NEW] = t8_forest_get_global_num_elements (forest);
+
+    /* Adapt, balance, partition and create ghosts in separate commits,
+     * each stage is timed by the forest profile */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_profiling (forest_adapt, 1);
+    t8_forest_set_user_data (forest_adapt, &ls_data);
+    t8_forest_set_adapt (forest_adapt, forest, t8_common_adapt_level_set, 1);
+    t8_forest_commit (forest_adapt);
+    times[T8_TIME_AMR_ADAPT] = t8_forest_profile_get_adapt_time (forest_adapt);
+    num_elements[T8_TIME_AMR_ADAPT] =
+      t8_forest_get_global_num_elements (forest_adapt);
+
+    t8_forest_init (&forest_balance);
+    t8_forest_set_profiling (forest_balance, 1);
+    t8_forest_set_balance (forest_balance, forest_adapt, 0);
+    t8_forest_commit (forest_balance);
+    times[T8_TIME_AMR_BALANCE] =
+      t8_forest_profile_get_balance_time (forest_balance, &balance_rounds);
+    num_elements[T8_TIME_AMR_BALANCE] =
+      t8_forest_get_global_num_elements (forest_balance);
+
+    t8_forest_init (&forest);
+    t8_forest_set_profiling (forest, 1);
+    t8_forest_set_partition (forest, forest_balance, 0);
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest);
+    times[T8_TIME_AMR_PARTITION] =
+      t8_forest_profile_get_partition_time (forest, &procs_sent);
+    times[T8_TIME_AMR_GHOST] =
+      t8_forest_profile_get_ghost_time (forest, &ghosts_sent);
+    num_elements[T8_TIME_AMR_PARTITION] =
+      num_elements[T8_TIME_AMR_GHOST] =
+      t8_forest_get_global_num_elements (forest);
+
+    /* Exchange one double per element */
+    sc_array_init_size (&element_data, sizeof (double),
+                        t8_forest_get_num_element (forest) +
+                        t8_forest_get_num_ghosts (forest));
+    memset (element_data.array, 0,
+            element_data.elem_count * element_data.elem_size);
+    start = sc_MPI_Wtime ();
+    t8_forest_ghost_exchange_data (forest, &element_data);
+    times[T8_TIME_AMR_GHOST_EXCHANGE] = sc_MPI_Wtime () - start;
+    num_elements[T8_TIME_AMR_GHOST_EXCHANGE] =
+      num_elements[T8_TIME_AMR_PARTITION];
+    sc_array_reset (&element_data);
+
+    if (opts->do_vtk) {
+      snprintf (filename, BUFSIZ, "t8_time_amr_cycle_%04i", cycle);
+      start = sc_MPI_Wtime ();
+      t8_forest_write_vtk (forest, filename);
+      times[T8_TIME_AMR_VTK] = sc_MPI_Wtime () - start;
+    }
+    num_elements[T8_TIME_AMR_VTK] = num_elements[T8_TIME_AMR_PARTITION];
+    num_elements[T8_TIME_AMR_TOTAL] = num_elements[T8_TIME_AMR_PARTITION];
+    if (opts->profile_csv != NULL && cycle == opts->num_cycles - 1) {
+      /* The processes of the last cycle, to find the stragglers */
+      t8_forest_write_profile_csv (forest, opts->profile_csv);
+    }
+    t8_forest_unref (&forest);
+
+    /* Compute the statistics over all processes */
+    for (istage = 0; istage < T8_TIME_AMR_TOTAL; istage++) {
+      times[T8_TIME_AMR_TOTAL] += times[istage];
+    }
+    for (istage = 0; istage < T8_TIME_AMR_NUM_STAGES; istage++) {
+      sc_stats_set1 (&stats[istage], times[istage],
+                     t8_time_amr_stage_names[istage]);
+    }
+    sc_stats_compute (comm, T8_TIME_AMR_NUM_STAGES, stats);
+    if (mpirank == 0) {
+      t8_time_amr_write (file, opts, mpisize, cycle, stats, num_elements);
+    }
+    t8_global_productionf ("Cycle %i: %lli elements, %i balance rounds, "
+                           "sent to %i processes, %li ghosts sent, "
+                           "%.3e s\n", cycle,
+                           (long long) num_elements[T8_TIME_AMR_TOTAL],
+                           balance_rounds, procs_sent, (long) ghosts_sent,
+                           stats[T8_TIME_AMR_TOTAL].max);
+  }
+
+  t8_scheme_cxx_unref (&scheme);
+  t8_cmesh_unref (&cmesh);
+  if (file != NULL && file != stdout) {
+    fclose (file);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_options_t       *opt;
+  char                usage[BUFSIZ];
+  char                help[BUFSIZ];
+  t8_time_amr_options_t opts;
+  int                 parsed, helpme;
+
+  /* brief help message */
+  snprintf (usage, BUFSIZ, "Usage:\t%s <OPTIONS>\n\t%s -h\t"
+            "for a brief overview of all options.",
+            basename (argv[0]), basename (argv[0]));
+
+  /* long help message */
+  snprintf (help, BUFSIZ,
+            "This program times complete adaptation cycles: new uniform,\n"
+            "adapt, balance, partition, ghost, ghost exchange and vtk output.\n"
+            "For each cycle and stage it writes the minimum, mean and maximum\n"
+            "runtime over all processes as CSV or as JSON lines.\n"
+            "Append the output of runs with different numbers of processes\n"
+            "to one file to obtain a strong or weak scaling table.\n\n%s\n",
+            usage);
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* initialize command line argument parser */
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'm', "mesh", &opts.mesh, 0,
+                      "The coarse mesh:\n\t\t0 - hybrid hypercube\n"
+                      "\t\t1 - bigmesh, see -e and -t\n"
+                      "\t\t2 - msh file, see -f and -d");
+  sc_options_add_int (opt, 'e', "elements", &opts.eclass, T8_ECLASS_HEX,
+                      "The element class of the bigmesh.");
+  sc_options_add_int (opt, 't', "trees", &opts.num_trees, 64,
+                      "The number of trees of the bigmesh.");
+  sc_options_add_string (opt, 'f', "mshfile", &opts.mshfile, NULL,
+                         "The prefix of the msh file.");
+  sc_options_add_int (opt, 'd', "dim", &opts.dim, 3,
+                      "The dimension of the msh file.");
+  sc_options_add_int (opt, 'l', "level", &opts.level, 3,
+                      "The level of the uniform forest.");
+  sc_options_add_int (opt, 'r', "refine", &opts.refine, 2,
+                      "The number of levels refined around the sphere.");
+  sc_options_add_int (opt, 'C', "cycles", &opts.num_cycles, 5,
+                      "The number of cycles.");
+  sc_options_add_switch (opt, 'v', "vtk", &opts.do_vtk,
+                         "Write vtk files in each cycle.");
+  sc_options_add_switch (opt, 'j', "json", &opts.json,
+                         "Write JSON lines instead of CSV.");
+  sc_options_add_switch (opt, 'a', "append", &opts.append,
+                         "Append to the output file.");
+  sc_options_add_string (opt, 's', "scaling", &opts.scaling, "strong",
+                         "A label written to the scaling column.");
+  sc_options_add_string (opt, 'o', "output", &opts.output, NULL,
+                         "The file to write the results to. "
+                         "If not given, the results are written to stdout.");
+  sc_options_add_string (opt, 'p', "profile", &opts.profile_csv, NULL,
+                         "Write the profile of each process in the last "
+                         "cycle to this CSV file.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    /* display help message and usage */
+    t8_global_productionf ("%s\n", help);
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && 0 <= opts.mesh && opts.mesh <= 2
+           && (opts.mesh != 1 || (T8_ECLASS_ZERO <= opts.eclass
+                                  && opts.eclass < T8_ECLASS_COUNT
+                                  && opts.num_trees > 0))
+           && (opts.mesh != 2 || (opts.mshfile != NULL
+                                  && 2 <= opts.dim && opts.dim <= 3))
+           && opts.level >= 0 && opts.refine >= 0 && opts.num_cycles > 0) {
+    t8_time_amr_cycles (&opts, sc_MPI_COMM_WORLD);
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\t ERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
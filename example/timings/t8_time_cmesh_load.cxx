@@ -0,0 +1,300 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program times the startup of a computation from saved cmesh files
+ * for 1, sqrt(P) and P files on P processes.
+ * For each number of files F the first F processes construct a bigmesh,
+ * partitioned among them, and save it with t8_cmesh_save. Then all
+ * processes load it with t8_cmesh_load_and_distribute, repartition it
+ * uniformly and commit a uniform forest on it.
+ * The time to the first element is the sum of the load, distribute and
+ * forest times. The peak heap memory of these stages is recorded by the
+ * profile regions, where the C library reports it.
+ * The results are written as CSV, one line per number of files, to choose
+ * the fastest restart configuration of a file system.
+ */
+
+#include <sc_options.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest.h>
+#include <t8_cmesh.h>
+#include <t8_profile_regions.h>
+
+/* The timed stages */
+typedef enum
+{
+  T8_TIME_CMESH_SAVE = 0,
+  T8_TIME_CMESH_LOAD,
+  T8_TIME_CMESH_DISTRIBUTE,
+  T8_TIME_CMESH_FOREST,
+  T8_TIME_CMESH_FIRST_ELEMENT,
+  T8_TIME_CMESH_MEMORY,
+  T8_TIME_CMESH_NUM_VALUES
+} t8_time_cmesh_value_t;
+
+static const char  *t8_time_cmesh_mode_names[T8_LOAD_COUNT] = {
+  "simple", "bgq", "stride"
+};
+
+/* The options of a benchmark run */
+typedef struct
+{
+  int                 eclass;   /* The element class of the bigmesh */
+  int                 num_trees; /* The number of trees of the bigmesh */
+  int                 level;    /* The level of the uniform forest */
+  int                 mode;     /* The load mode */
+  int                 procs_per_node; /* The processes per node for the stride mode */
+  const char         *prefix;   /* The prefix of the cmesh files */
+  int                 keep;     /* If true, keep the cmesh files */
+  const char         *output;   /* The output file, stdout if NULL */
+} t8_time_cmesh_options_t;
+
+/* Save a bigmesh to num_files files, written by the first num_files
+ * processes of comm. */
+static void
+t8_time_cmesh_save (const t8_time_cmesh_options_t * opts, int num_files,
+                    sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh, cmesh_partition;
+  sc_MPI_Comm         comm_save;
+  int                 mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_split (comm, mpirank < num_files, mpirank,
+                              &comm_save);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank < num_files) {
+    cmesh = t8_cmesh_new_bigmesh ((t8_eclass_t) opts->eclass,
+                                  opts->num_trees, comm_save);
+    if (num_files > 1) {
+      /* Each of the writing processes writes its part of the trees */
+      t8_cmesh_init (&cmesh_partition);
+      t8_cmesh_set_derive (cmesh_partition, cmesh);
+      t8_cmesh_set_partition_uniform (cmesh_partition, 0);
+      t8_cmesh_commit (cmesh_partition, comm_save);
+      cmesh = cmesh_partition;
+    }
+    SC_CHECK_ABORTF (t8_cmesh_save (cmesh, opts->prefix),
+                     "Could not save cmesh to %s", opts->prefix);
+    t8_cmesh_destroy (&cmesh);
+  }
+  mpiret = sc_MPI_Comm_free (&comm_save);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Measure the startup from num_files files. The values are the maxima
+ * over all processes. */
+static void
+t8_time_cmesh_startup (const t8_time_cmesh_options_t * opts, int num_files,
+                       sc_MPI_Comm comm, double *values)
+{
+  t8_cmesh_t          cmesh, cmesh_partition;
+  t8_forest_t         forest;
+  char                filename[BUFSIZ];
+  double              start;
+  int                 mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  memset (values, 0, T8_TIME_CMESH_NUM_VALUES * sizeof (double));
+
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+  start = sc_MPI_Wtime ();
+  t8_time_cmesh_save (opts, num_files, comm);
+  values[T8_TIME_CMESH_SAVE] = sc_MPI_Wtime () - start;
+
+  /* From here on, this is what a restart does */
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+  t8_profile_region_begin ("startup");
+  start = sc_MPI_Wtime ();
+  cmesh = t8_cmesh_load_and_distribute (opts->prefix, num_files, comm,
+                                        (t8_load_mode_t) opts->mode,
+                                        opts->procs_per_node);
+  SC_CHECK_ABORTF (cmesh != NULL, "Could not load cmesh from %s",
+                   opts->prefix);
+  values[T8_TIME_CMESH_LOAD] = sc_MPI_Wtime () - start;
+
+  start = sc_MPI_Wtime ();
+  t8_cmesh_init (&cmesh_partition);
+  t8_cmesh_set_derive (cmesh_partition, cmesh);
+  t8_cmesh_set_partition_uniform (cmesh_partition, opts->level);
+  t8_cmesh_commit (cmesh_partition, comm);
+  values[T8_TIME_CMESH_DISTRIBUTE] = sc_MPI_Wtime () - start;
+
+  start = sc_MPI_Wtime ();
+  forest = t8_forest_new_uniform (cmesh_partition,
+                                  t8_scheme_new_default_cxx (), opts->level,
+                                  0, comm);
+  values[T8_TIME_CMESH_FOREST] = sc_MPI_Wtime () - start;
+  t8_profile_region_end ("startup");
+  values[T8_TIME_CMESH_FIRST_ELEMENT] = values[T8_TIME_CMESH_LOAD]
+    + values[T8_TIME_CMESH_DISTRIBUTE] + values[T8_TIME_CMESH_FOREST];
+  values[T8_TIME_CMESH_MEMORY] = t8_profile_regions_last_memory_peak ();
+  t8_forest_unref (&forest);
+
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, values,
+                             T8_TIME_CMESH_NUM_VALUES, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+
+  if (!opts->keep && mpirank < num_files) {
+    snprintf (filename, BUFSIZ, "%s_%04d.cmesh", opts->prefix, mpirank);
+    remove (filename);
+  }
+}
+
+static void
+t8_time_cmesh_load (const t8_time_cmesh_options_t * opts, sc_MPI_Comm comm)
+{
+  double              values[T8_TIME_CMESH_NUM_VALUES];
+  int                 num_files[3], inum, mpirank, mpisize, mpiret;
+  FILE               *file = NULL;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (opts->num_trees >= mpisize,
+                  "Need at least one tree per process");
+  if (mpirank == 0) {
+    file = stdout;
+    if (opts->output != NULL) {
+      file = fopen (opts->output, "w");
+      SC_CHECK_ABORTF (file != NULL, "Could not open file %s", opts->output);
+    }
+    fprintf (file, "mpisize,num_files,mode,num_trees,level,time_save,"
+             "time_load,time_distribute,time_forest,time_first_element,"
+             "memory_peak\n");
+  }
+  t8_profile_regions_set_memory (1);
+
+  num_files[0] = 1;
+  num_files[1] = SC_MAX (1, (int) (sqrt ((double) mpisize) + .5));
+  num_files[2] = mpisize;
+  for (inum = 0; inum < 3; inum++) {
+    if (inum > 0 && num_files[inum] == num_files[inum - 1]) {
+      /* Do not time the same number of files twice */
+      continue;
+    }
+    t8_time_cmesh_startup (opts, num_files[inum], comm, values);
+    if (mpirank == 0) {
+      fprintf (file, "%i,%i,%s,%i,%i,%.6e,%.6e,%.6e,%.6e,%.6e,%.0f\n",
+               mpisize, num_files[inum],
+               t8_time_cmesh_mode_names[opts->mode], opts->num_trees,
+               opts->level, values[T8_TIME_CMESH_SAVE],
+               values[T8_TIME_CMESH_LOAD], values[T8_TIME_CMESH_DISTRIBUTE],
+               values[T8_TIME_CMESH_FOREST],
+               values[T8_TIME_CMESH_FIRST_ELEMENT],
+               values[T8_TIME_CMESH_MEMORY]);
+      fflush (file);
+    }
+    t8_global_productionf ("%i files: %.3e s to the first element\n",
+                           num_files[inum],
+                           values[T8_TIME_CMESH_FIRST_ELEMENT]);
+  }
+  if (file != NULL && file != stdout) {
+    fclose (file);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_options_t       *opt;
+  char                usage[BUFSIZ];
+  char                help[BUFSIZ];
+  t8_time_cmesh_options_t opts;
+  int                 parsed, helpme;
+
+  /* brief help message */
+  snprintf (usage, BUFSIZ, "Usage:\t%s <OPTIONS>\n\t%s -h\t"
+            "for a brief overview of all options.",
+            basename (argv[0]), basename (argv[0]));
+
+  /* long help message */
+  snprintf (help, BUFSIZ,
+            "This program times saving a cmesh to 1, sqrt(P) and P files,\n"
+            "loading and distributing it on P processes and committing the\n"
+            "first forest. It writes the times and the peak heap memory\n"
+            "as CSV.\n\n%s\n", usage);
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* initialize command line argument parser */
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'e', "elements", &opts.eclass, T8_ECLASS_HEX,
+                      "The element class of the bigmesh.");
+  sc_options_add_int (opt, 't', "trees", &opts.num_trees, 4096,
+                      "The number of trees of the bigmesh. "
+                      "At least the number of processes.");
+  sc_options_add_int (opt, 'l', "level", &opts.level, 1,
+                      "The level of the uniform forest.");
+  sc_options_add_int (opt, 'M', "mode", &opts.mode, T8_LOAD_SIMPLE,
+                      "The load mode:\n\t\t0 - simple\n\t\t1 - bgq\n"
+                      "\t\t2 - stride, see -N");
+  sc_options_add_int (opt, 'N', "procs-per-node", &opts.procs_per_node, 1,
+                      "The number of processes per node in stride mode.");
+  sc_options_add_string (opt, 'p', "prefix", &opts.prefix,
+                         "t8_time_cmesh_load", "The prefix of the files.");
+  sc_options_add_switch (opt, 'k', "keep", &opts.keep,
+                         "Keep the cmesh files.");
+  sc_options_add_string (opt, 'o', "output", &opts.output, NULL,
+                         "The file to write the results to. "
+                         "If not given, the results are written to stdout.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    /* display help message and usage */
+    t8_global_productionf ("%s\n", help);
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && T8_ECLASS_ZERO <= opts.eclass
+           && opts.eclass < T8_ECLASS_COUNT && opts.num_trees > 0
+           && opts.level >= 0 && T8_LOAD_FIRST <= opts.mode
+           && opts.mode < T8_LOAD_COUNT && opts.procs_per_node > 0) {
+    t8_time_cmesh_load (&opts, sc_MPI_COMM_WORLD);
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\t ERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
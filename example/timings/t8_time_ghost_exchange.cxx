@@ -0,0 +1,399 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program times the ghost data exchange of an adapted, balanced and
+ * partitioned forest for a range of data sizes per element.
+ * For each data size it measures
+ *  - the blocking exchange t8_forest_ghost_exchange_data,
+ *  - a fake compute load on the local elements alone, and
+ *  - the split-phase exchange t8_forest_ghost_exchange_begin, the compute
+ *    load interrupted by calls to t8_forest_ghost_exchange_test, and
+ *    t8_forest_ghost_exchange_end.
+ * The achieved overlap is the fraction of the shorter of exchange and
+ * compute that is hidden by the split-phase exchange: 1 if the overlapped
+ * run takes as long as the longer of both and 0 if it takes as long as their
+ * sum. The bandwidth is the number of bytes sent and received by the process
+ * with the most communication divided by the blocking exchange time.
+ * The exchange uses point-to-point messages with a reused exchange plan, or
+ * neighborhood collectives with -n.
+ * The results are written as CSV, one line per data size.
+ */
+
+#include <sc_options.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_cmesh.h>
+
+/* The options of a benchmark run */
+typedef struct
+{
+  int                 mesh;     /* 0: hypercube, 1: hybrid hypercube, 2: bigmesh */
+  int                 eclass;   /* The element class of the hypercube and bigmesh */
+  int                 num_trees; /* The number of trees of the bigmesh */
+  int                 level;    /* The level of the uniform forest */
+  int                 refine;   /* The number of levels refined adaptively */
+  int                 min_size; /* The smallest number of bytes per element */
+  int                 max_size; /* The largest number of bytes per element */
+  int                 num_repetitions; /* The number of timed exchanges per size */
+  double              compute_factor; /* The compute time relative to the exchange time */
+  int                 num_tests; /* The number of exchange tests during the compute */
+  int                 neighborhood; /* If true, use neighborhood collectives */
+  const char         *output;   /* The output file, stdout if NULL */
+} t8_time_ghost_options_t;
+
+/* The timings of one data size, maximum over all processes */
+typedef enum
+{
+  T8_TIME_GHOST_BLOCKING = 0,
+  T8_TIME_GHOST_COMPUTE,
+  T8_TIME_GHOST_OVERLAP,
+  T8_TIME_GHOST_NUM_TIMES
+} t8_time_ghost_time_t;
+
+static const char  *t8_time_ghost_mesh_names[3] = {
+  "hypercube", "hybrid", "bigmesh"
+};
+
+static              t8_cmesh_t
+t8_time_ghost_cmesh (const t8_time_ghost_options_t * opts, sc_MPI_Comm comm)
+{
+  switch (opts->mesh) {
+  case 0:
+    return t8_cmesh_new_hypercube ((t8_eclass_t) opts->eclass, comm, 0, 0,
+                                   0);
+  case 1:
+    return t8_cmesh_new_hypercube_hybrid (3, comm, 0, 0);
+  default:
+    return t8_cmesh_new_bigmesh ((t8_eclass_t) opts->eclass,
+                                 opts->num_trees, comm);
+  }
+}
+
+/* Refine every second element up to the maximum level */
+static int
+t8_time_ghost_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                     t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                     t8_eclass_scheme_c * ts, int num_elements,
+                     t8_element_t * elements[])
+{
+  int                 level, maxlevel;
+
+  level = ts->t8_element_level (elements[0]);
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  if (level < maxlevel
+      && ts->t8_element_get_linear_id (elements[0], level) % 2) {
+    return 1;
+  }
+  return 0;
+}
+
+/* The fake compute load: update the first double of the entry of each
+ * local element num_passes times. If data_exchange is not NULL, test it
+ * num_tests times during the computation to progress the messages. */
+static void
+t8_time_ghost_compute (sc_array_t * element_data, t8_locidx_t num_elements,
+                       int num_passes, int num_tests,
+                       t8_ghost_data_exchange_t * data_exchange)
+{
+  t8_locidx_t         ielem;
+  double             *value;
+  int                 ipass, tests_done = 0;
+  long long           num_updates, iupdate = 0;
+
+  num_updates = (long long) num_passes * num_elements;
+  for (ipass = 0; ipass < num_passes; ipass++) {
+    for (ielem = 0; ielem < num_elements; ielem++, iupdate++) {
+      value = (double *) t8_sc_array_index_locidx (element_data, ielem);
+      *value = 0.5 * *value + 1.;
+      if (data_exchange != NULL && tests_done < num_tests
+          && iupdate * num_tests >= tests_done * num_updates) {
+        t8_forest_ghost_exchange_test (data_exchange);
+        tests_done++;
+      }
+    }
+  }
+}
+
+/* Compute the runtime of a fake compute load of one pass, maximum over
+ * all processes */
+static double
+t8_time_ghost_compute_pass (sc_array_t * element_data,
+                            t8_locidx_t num_elements, sc_MPI_Comm comm)
+{
+  double              time;
+  int                 mpiret, num_passes = 1;
+
+  /* Repeat the pass until the time can be measured */
+  do {
+    time = -sc_MPI_Wtime ();
+    t8_time_ghost_compute (element_data, num_elements, num_passes, 0, NULL);
+    time += sc_MPI_Wtime ();
+    num_passes *= 2;
+  } while (time < 1e-3 && num_passes < (1 << 20));
+  time /= num_passes / 2;
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &time, 1, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  return time;
+}
+
+static void
+t8_time_ghost_exchange (const t8_time_ghost_options_t * opts,
+                        sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_ghost_data_exchange_t *data_exchange;
+  sc_array_t          element_data;
+  const int          *remote_ranks;
+  const t8_locidx_t  *send_offsets, *send_indices, *recv_offsets;
+  t8_locidx_t         num_elements, num_ghosts;
+  double              times[T8_TIME_GHOST_NUM_TIMES], time, pass_time;
+  double              bytes, max_bytes, overlap, bandwidth;
+  FILE               *file = NULL;
+  int                 mpirank, mpisize, mpiret, num_remotes, maxlevel;
+  int                 data_size, irep, num_passes;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    file = stdout;
+    if (opts->output != NULL) {
+      file = fopen (opts->output, "w");
+      SC_CHECK_ABORTF (file != NULL, "Could not open file %s", opts->output);
+    }
+    fprintf (file, "mesh,backend,mpisize,global_elements,data_size,"
+             "max_bytes,time_blocking,time_compute,time_overlap,overlap,"
+             "bandwidth\n");
+  }
+
+  /* Construct an adapted, balanced and partitioned forest with ghosts */
+  cmesh = t8_time_ghost_cmesh (opts, comm);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                  opts->level, 0, comm);
+  maxlevel = opts->level + opts->refine;
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_user_data (forest_adapt, &maxlevel);
+  t8_forest_set_adapt (forest_adapt, forest, t8_time_ghost_adapt, 1);
+  t8_forest_set_balance (forest_adapt, NULL, 0);
+  t8_forest_set_partition (forest_adapt, NULL, 0);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_set_ghost_neighborhood (forest_adapt, opts->neighborhood);
+  t8_forest_commit (forest_adapt);
+  forest = forest_adapt;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  t8_forest_ghost_exchange_get_pattern (forest, &num_remotes, &remote_ranks,
+                                        &send_offsets, &send_indices,
+                                        &recv_offsets);
+  /* The number of entries sent and received by this process */
+  bytes = num_ghosts + (num_remotes > 0 ? send_offsets[num_remotes] : 0);
+
+  for (data_size = opts->min_size; data_size <= opts->max_size;
+       data_size *= 2) {
+    sc_array_init_size (&element_data, data_size, num_elements + num_ghosts);
+    memset (element_data.array, 0,
+            element_data.elem_count * element_data.elem_size);
+    /* The first exchange computes the exchange plan and is not timed */
+    t8_forest_ghost_exchange_data (forest, &element_data);
+
+    /* The blocking exchange */
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    time = -sc_MPI_Wtime ();
+    for (irep = 0; irep < opts->num_repetitions; irep++) {
+      t8_forest_ghost_exchange_data (forest, &element_data);
+    }
+    time += sc_MPI_Wtime ();
+    times[T8_TIME_GHOST_BLOCKING] = time / opts->num_repetitions;
+
+    /* Choose the compute load relative to the exchange time */
+    mpiret = sc_MPI_Allreduce (&times[T8_TIME_GHOST_BLOCKING],
+                               &time, 1, sc_MPI_DOUBLE, sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+    pass_time = t8_time_ghost_compute_pass (&element_data, num_elements,
+                                            comm);
+    num_passes = (int) SC_MAX (1., opts->compute_factor * time
+                               / SC_MAX (pass_time, 1e-9) + .5);
+
+    /* The compute load alone */
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    time = -sc_MPI_Wtime ();
+    for (irep = 0; irep < opts->num_repetitions; irep++) {
+      t8_time_ghost_compute (&element_data, num_elements, num_passes, 0,
+                             NULL);
+    }
+    time += sc_MPI_Wtime ();
+    times[T8_TIME_GHOST_COMPUTE] = time / opts->num_repetitions;
+
+    /* The split-phase exchange overlapped with the compute load */
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    time = -sc_MPI_Wtime ();
+    for (irep = 0; irep < opts->num_repetitions; irep++) {
+      data_exchange = t8_forest_ghost_exchange_begin (forest, &element_data);
+      t8_time_ghost_compute (&element_data, num_elements, num_passes,
+                             opts->num_tests, data_exchange);
+      if (data_exchange != NULL) {
+        t8_forest_ghost_exchange_end (data_exchange);
+      }
+    }
+    time += sc_MPI_Wtime ();
+    times[T8_TIME_GHOST_OVERLAP] = time / opts->num_repetitions;
+
+    mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, times,
+                               T8_TIME_GHOST_NUM_TIMES, sc_MPI_DOUBLE,
+                               sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+    max_bytes = bytes * data_size;
+    mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &max_bytes, 1,
+                               sc_MPI_DOUBLE, sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+
+    /* The part of the shorter phase that was hidden */
+    overlap = (times[T8_TIME_GHOST_BLOCKING] + times[T8_TIME_GHOST_COMPUTE]
+               - times[T8_TIME_GHOST_OVERLAP])
+      / SC_MAX (SC_MIN (times[T8_TIME_GHOST_BLOCKING],
+                        times[T8_TIME_GHOST_COMPUTE]), 1e-12);
+    overlap = SC_MAX (0., SC_MIN (1., overlap));
+    bandwidth = times[T8_TIME_GHOST_BLOCKING] > 0 ?
+      max_bytes / times[T8_TIME_GHOST_BLOCKING] : 0;
+    if (mpirank == 0) {
+      fprintf (file, "%s,%s,%i,%lli,%i,%.0f,%.6e,%.6e,%.6e,%.3f,%.6e\n",
+               t8_time_ghost_mesh_names[opts->mesh],
+               opts->neighborhood ? "neighborhood" : "p2p", mpisize,
+               (long long) t8_forest_get_global_num_elements (forest),
+               data_size, max_bytes, times[T8_TIME_GHOST_BLOCKING],
+               times[T8_TIME_GHOST_COMPUTE], times[T8_TIME_GHOST_OVERLAP],
+               overlap, bandwidth);
+      fflush (file);
+    }
+    t8_global_productionf ("%i bytes per element: %.3e s blocking, "
+                           "%.3f overlap, %.3e bytes/s\n", data_size,
+                           times[T8_TIME_GHOST_BLOCKING], overlap,
+                           bandwidth);
+    sc_array_reset (&element_data);
+  }
+
+  t8_forest_unref (&forest);
+  if (file != NULL && file != stdout) {
+    fclose (file);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_options_t       *opt;
+  char                usage[BUFSIZ];
+  char                help[BUFSIZ];
+  t8_time_ghost_options_t opts;
+  int                 parsed, helpme;
+
+  /* brief help message */
+  snprintf (usage, BUFSIZ, "Usage:\t%s <OPTIONS>\n\t%s -h\t"
+            "for a brief overview of all options.",
+            basename (argv[0]), basename (argv[0]));
+
+  /* long help message */
+  snprintf (help, BUFSIZ,
+            "This program times the ghost data exchange of an adapted\n"
+            "forest for data sizes from -s to -S bytes per element.\n"
+            "It compares the blocking exchange with the split-phase exchange\n"
+            "overlapped by a fake compute load and reports the achieved\n"
+            "overlap and bandwidth as CSV.\n\n%s\n", usage);
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* initialize command line argument parser */
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'm', "mesh", &opts.mesh, 0,
+                      "The coarse mesh:\n\t\t0 - hypercube, see -e\n"
+                      "\t\t1 - hybrid hypercube\n"
+                      "\t\t2 - bigmesh, see -e and -t");
+  sc_options_add_int (opt, 'e', "elements", &opts.eclass, T8_ECLASS_HEX,
+                      "The element class of the hypercube and bigmesh.");
+  sc_options_add_int (opt, 't', "trees", &opts.num_trees, 64,
+                      "The number of trees of the bigmesh.");
+  sc_options_add_int (opt, 'l', "level", &opts.level, 3,
+                      "The level of the uniform forest.");
+  sc_options_add_int (opt, 'r', "refine", &opts.refine, 1,
+                      "The number of levels refined adaptively.");
+  sc_options_add_int (opt, 's', "min-size", &opts.min_size, 8,
+                      "The smallest number of bytes per element.");
+  sc_options_add_int (opt, 'S', "max-size", &opts.max_size, 1024,
+                      "The largest number of bytes per element. "
+                      "The sizes are doubled from -s to -S.");
+  sc_options_add_int (opt, 'R', "repetitions", &opts.num_repetitions, 20,
+                      "The number of timed exchanges per data size.");
+  sc_options_add_double (opt, 'c', "compute", &opts.compute_factor, 1.,
+                         "The compute time relative to the blocking "
+                         "exchange time.");
+  sc_options_add_int (opt, 'T', "tests", &opts.num_tests, 4,
+                      "The number of exchange tests during the compute.");
+  sc_options_add_switch (opt, 'n', "neighborhood", &opts.neighborhood,
+                         "Use neighborhood collectives.");
+  sc_options_add_string (opt, 'o', "output", &opts.output, NULL,
+                         "The file to write the results to. "
+                         "If not given, the results are written to stdout.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    /* display help message and usage */
+    t8_global_productionf ("%s\n", help);
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && 0 <= opts.mesh && opts.mesh <= 2
+           && T8_ECLASS_ZERO <= opts.eclass && opts.eclass < T8_ECLASS_COUNT
+           && opts.num_trees > 0 && opts.level >= 0 && opts.refine >= 0
+           && (int) sizeof (double) <= opts.min_size
+           && opts.min_size <= opts.max_size && opts.num_repetitions > 0
+           && opts.compute_factor >= 0 && opts.num_tests >= 0) {
+    t8_time_ghost_exchange (&opts, sc_MPI_COMM_WORLD);
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\t ERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
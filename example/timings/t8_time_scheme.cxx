@@ -0,0 +1,425 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program measures the time per call of the element scheme functions
+ * of the default scheme for each element class and a range of levels.
+ * For each level, a sample of elements that is spread evenly over a uniform
+ * refinement of one tree is constructed, and each function is called for all
+ * elements of the sample, repeated a number of times.
+ * The results are written as comma separated lines
+ *   eclass,operation,level,num_ops,ns_per_op
+ * to a file or to stdout, so that they can be compared between versions.
+ */
+
+#include <sc_options.h>
+#include <t8_eclass.h>
+#include <t8_default_cxx.hxx>
+#include <t8_element_cxx.hxx>
+#include <t8_data/t8_containers.h>
+
+/* The measured scheme functions */
+typedef enum
+{
+  T8_TIME_SCHEME_CHILD = 0,
+  T8_TIME_SCHEME_PARENT,
+  T8_TIME_SCHEME_SUCCESSOR,
+  T8_TIME_SCHEME_SET_LINEAR_ID,
+  T8_TIME_SCHEME_GET_LINEAR_ID,
+  T8_TIME_SCHEME_FACE_NEIGHBOR,
+  T8_TIME_SCHEME_BOUNDARY_FACE,
+  T8_TIME_SCHEME_COMPARE,
+  T8_TIME_SCHEME_VERTEX_COORDS,
+  T8_TIME_SCHEME_NUM_OPS
+} t8_time_scheme_op_t;
+
+static const char  *t8_time_scheme_op_names[T8_TIME_SCHEME_NUM_OPS] = {
+  "child",
+  "parent",
+  "successor",
+  "set_linear_id",
+  "get_linear_id",
+  "face_neighbor",
+  "boundary_face",
+  "compare",
+  "vertex_coords"
+};
+
+/* A sample of elements of one level and the arguments for each call */
+typedef struct
+{
+  t8_eclass_scheme_c *ts;
+  int                 level;
+  t8_locidx_t         count;
+  size_t              elem_size;
+  t8_element_array_t  elements;     /* The sampled elements */
+  t8_element_array_t  result;       /* Output elements */
+  t8_linearidx_t     *ids;          /* The linear id of each element */
+  int                *child;        /* A child id of each element */
+  int                *face;         /* A face of each element */
+  int                *vertex;       /* A vertex of each element */
+  t8_locidx_t         num_boundary; /* The number of root boundary faces */
+  t8_locidx_t        *boundary_elem; /* For each root boundary face its element */
+  int                *boundary_face; /* and its face */
+  t8_element_t       *boundary[T8_ECLASS_COUNT]; /* One face element per face class */
+  t8_eclass_scheme_c *boundary_scheme[T8_ECLASS_COUNT]; /* The scheme of each face class */
+} t8_time_scheme_sample_t;
+
+#define T8_TIME_SCHEME_ELEM(s,array,i) \
+  ((t8_element_t *) ((char *) t8_element_array_index_locidx (&(s)->array, 0) \
+                     + (size_t) (i) * (s)->elem_size))
+
+static void
+t8_time_scheme_sample_init (t8_time_scheme_sample_t * sample,
+                            t8_scheme_cxx_t * scheme, t8_eclass_t eclass,
+                            int level, t8_locidx_t max_count)
+{
+  t8_eclass_scheme_c *ts = scheme->eclass_schemes[eclass];
+  t8_gloidx_t         num_leafs, stride;
+  t8_locidx_t         ielem;
+  t8_element_t       *elem;
+  t8_eclass_t         face_class;
+  int                 iface, num_faces;
+
+  memset (sample, 0, sizeof (*sample));
+  sample->ts = ts;
+  sample->level = level;
+  num_leafs = t8_eclass_count_leaf (eclass, level);
+  sample->count = (t8_locidx_t) SC_MIN (num_leafs, (t8_gloidx_t) max_count);
+  stride = num_leafs / sample->count;
+  sample->elem_size = ts->t8_element_size ();
+  t8_element_array_init_size (&sample->elements, ts, sample->count);
+  t8_element_array_init_size (&sample->result, ts, sample->count);
+  sample->ids = T8_ALLOC (t8_linearidx_t, sample->count);
+  sample->child = T8_ALLOC (int, sample->count);
+  sample->face = T8_ALLOC (int, sample->count);
+  sample->vertex = T8_ALLOC (int, sample->count);
+  sample->boundary_elem = T8_ALLOC (t8_locidx_t, sample->count);
+  sample->boundary_face = T8_ALLOC (int, sample->count);
+
+  for (ielem = 0; ielem < sample->count; ielem++) {
+    elem = T8_TIME_SCHEME_ELEM (sample, elements, ielem);
+    sample->ids[ielem] = (t8_linearidx_t) (ielem * stride);
+    ts->t8_element_set_linear_id (elem, level, sample->ids[ielem]);
+    sample->child[ielem] = ielem % ts->t8_element_num_children (elem);
+    sample->vertex[ielem] = ielem % ts->t8_element_num_corners (elem);
+    num_faces = ts->t8_element_num_faces (elem);
+    sample->face[ielem] = num_faces > 0 ? ielem % num_faces : -1;
+    /* Collect the faces at the boundary of the root tree */
+    for (iface = 0; iface < num_faces; iface++) {
+      if (ts->t8_element_is_root_boundary (elem, iface)) {
+        face_class = ts->t8_element_face_class (elem, iface);
+        if (sample->boundary[face_class] == NULL) {
+          sample->boundary_scheme[face_class] =
+            scheme->eclass_schemes[face_class];
+          sample->boundary_scheme[face_class]->t8_element_new (1,
+                                                               &sample->boundary
+                                                               [face_class]);
+        }
+        sample->boundary_elem[sample->num_boundary] = ielem;
+        sample->boundary_face[sample->num_boundary] = iface;
+        sample->num_boundary++;
+        break;
+      }
+    }
+  }
+}
+
+static void
+t8_time_scheme_sample_reset (t8_time_scheme_sample_t * sample)
+{
+  int                 eclass;
+
+  for (eclass = 0; eclass < T8_ECLASS_COUNT; eclass++) {
+    if (sample->boundary[eclass] != NULL) {
+      sample->boundary_scheme[eclass]->t8_element_destroy (1,
+                                                           &sample->boundary
+                                                           [eclass]);
+    }
+  }
+  t8_element_array_reset (&sample->elements);
+  t8_element_array_reset (&sample->result);
+  T8_FREE (sample->ids);
+  T8_FREE (sample->child);
+  T8_FREE (sample->face);
+  T8_FREE (sample->vertex);
+  T8_FREE (sample->boundary_elem);
+  T8_FREE (sample->boundary_face);
+}
+
+/* Call one scheme function for all elements of the sample, repeated
+ * num_repeat times. Return the number of calls, or 0 if the function
+ * cannot be called for this sample. The results are added to checksum so
+ * that the calls are not optimized away. */
+static t8_gloidx_t
+t8_time_scheme_run (t8_time_scheme_sample_t * s, t8_time_scheme_op_t op,
+                    int num_repeat, t8_linearidx_t * checksum)
+{
+  t8_eclass_scheme_c *ts = s->ts;
+  t8_locidx_t         ielem, num_elems = s->count;
+  t8_element_t       *elem, *out;
+  t8_eclass_t         face_class;
+  int                 irepeat, neigh_face, coords[3];
+
+  switch (op) {
+  case T8_TIME_SCHEME_CHILD:
+    if (s->level >= ts->t8_element_maxlevel ()) {
+      return 0;
+    }
+    break;
+  case T8_TIME_SCHEME_PARENT:
+    if (s->level == 0) {
+      return 0;
+    }
+    break;
+  case T8_TIME_SCHEME_SUCCESSOR:
+    /* The last element of the uniform refinement has no successor */
+    if (s->ids[num_elems - 1] + 1 ==
+        (t8_linearidx_t) t8_eclass_count_leaf (ts->eclass, s->level)) {
+      num_elems--;
+    }
+    break;
+  case T8_TIME_SCHEME_FACE_NEIGHBOR:
+    if (s->face[0] < 0) {
+      return 0;
+    }
+    break;
+  case T8_TIME_SCHEME_BOUNDARY_FACE:
+    num_elems = s->num_boundary;
+    break;
+  default:
+    break;
+  }
+  if (num_elems == 0) {
+    return 0;
+  }
+
+  for (irepeat = 0; irepeat < num_repeat; irepeat++) {
+    switch (op) {
+    case T8_TIME_SCHEME_CHILD:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        ts->t8_element_child (T8_TIME_SCHEME_ELEM (s, elements, ielem),
+                              s->child[ielem],
+                              T8_TIME_SCHEME_ELEM (s, result, ielem));
+      }
+      break;
+    case T8_TIME_SCHEME_PARENT:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        ts->t8_element_parent (T8_TIME_SCHEME_ELEM (s, elements, ielem),
+                               T8_TIME_SCHEME_ELEM (s, result, ielem));
+      }
+      break;
+    case T8_TIME_SCHEME_SUCCESSOR:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        ts->t8_element_successor (T8_TIME_SCHEME_ELEM (s, elements, ielem),
+                                  T8_TIME_SCHEME_ELEM (s, result, ielem),
+                                  s->level);
+      }
+      break;
+    case T8_TIME_SCHEME_SET_LINEAR_ID:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        ts->t8_element_set_linear_id (T8_TIME_SCHEME_ELEM (s, result, ielem),
+                                      s->level, s->ids[ielem]);
+      }
+      break;
+    case T8_TIME_SCHEME_GET_LINEAR_ID:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        *checksum +=
+          ts->t8_element_get_linear_id (T8_TIME_SCHEME_ELEM
+                                        (s, elements, ielem), s->level);
+      }
+      break;
+    case T8_TIME_SCHEME_FACE_NEIGHBOR:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        *checksum +=
+          ts->t8_element_face_neighbor_inside (T8_TIME_SCHEME_ELEM
+                                               (s, elements, ielem),
+                                               T8_TIME_SCHEME_ELEM (s, result,
+                                                                    ielem),
+                                               s->face[ielem], &neigh_face);
+      }
+      break;
+    case T8_TIME_SCHEME_BOUNDARY_FACE:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        elem = T8_TIME_SCHEME_ELEM (s, elements, s->boundary_elem[ielem]);
+        face_class = ts->t8_element_face_class (elem, s->boundary_face[ielem]);
+        ts->t8_element_boundary_face (elem, s->boundary_face[ielem],
+                                      s->boundary[face_class],
+                                      s->boundary_scheme[face_class]);
+      }
+      break;
+    case T8_TIME_SCHEME_COMPARE:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        *checksum +=
+          ts->t8_element_compare (T8_TIME_SCHEME_ELEM (s, elements, ielem),
+                                  T8_TIME_SCHEME_ELEM (s, elements,
+                                                       (ielem + 1) %
+                                                       num_elems));
+      }
+      break;
+    case T8_TIME_SCHEME_VERTEX_COORDS:
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        ts->t8_element_vertex_coords (T8_TIME_SCHEME_ELEM
+                                      (s, elements, ielem), s->vertex[ielem],
+                                      coords);
+        *checksum += coords[0];
+      }
+      break;
+    default:
+      SC_ABORT_NOT_REACHED ();
+    }
+  }
+  out = T8_TIME_SCHEME_ELEM (s, result, 0);
+  *checksum += ts->t8_element_level (out);
+  return (t8_gloidx_t) num_elems *num_repeat;
+}
+
+static void
+t8_time_scheme (int eclass_int, int min_level, int max_level,
+                int num_samples, int num_repeat, const char *filename)
+{
+  t8_scheme_cxx_t    *scheme;
+  t8_time_scheme_sample_t sample;
+  t8_eclass_t         eclass;
+  int                 level, op;
+  t8_gloidx_t         num_ops;
+  t8_linearidx_t      checksum = 0;
+  double              start, ns_per_op;
+  FILE               *file = stdout;
+
+  if (filename != NULL) {
+    file = fopen (filename, "w");
+    SC_CHECK_ABORTF (file != NULL, "Could not open file %s", filename);
+  }
+  fprintf (file, "eclass,operation,level,num_ops,ns_per_op\n");
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT;
+       eclass = (t8_eclass_t) (eclass + 1)) {
+    if (eclass_int >= 0 && eclass != eclass_int) {
+      continue;
+    }
+    for (level = min_level;
+         level <= SC_MIN (max_level,
+                          scheme->eclass_schemes[eclass]->
+                          t8_element_maxlevel ()); level++) {
+      t8_time_scheme_sample_init (&sample, scheme, eclass, level,
+                                  num_samples);
+      for (op = 0; op < T8_TIME_SCHEME_NUM_OPS; op++) {
+        start = sc_MPI_Wtime ();
+        num_ops = t8_time_scheme_run (&sample, (t8_time_scheme_op_t) op,
+                                      num_repeat, &checksum);
+        if (num_ops > 0) {
+          ns_per_op = 1e9 * (sc_MPI_Wtime () - start) / num_ops;
+          fprintf (file, "%s,%s,%i,%lli,%.3f\n", t8_eclass_to_string[eclass],
+                   t8_time_scheme_op_names[op], level, (long long) num_ops,
+                   ns_per_op);
+        }
+      }
+      t8_time_scheme_sample_reset (&sample);
+    }
+  }
+  t8_scheme_cxx_unref (&scheme);
+  if (filename != NULL) {
+    fclose (file);
+  }
+  t8_debugf ("Checksum %llu\n", (unsigned long long) checksum);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret, mpirank;
+  sc_options_t       *opt;
+  char                usage[BUFSIZ];
+  char                help[BUFSIZ];
+  int                 eclass_int, min_level, max_level;
+  int                 num_samples, num_repeat;
+  const char         *filename = NULL;
+  int                 parsed, helpme;
+
+  /* brief help message */
+  snprintf (usage, BUFSIZ, "Usage:\t%s <OPTIONS>\n\t%s -h\t"
+            "for a brief overview of all options.",
+            basename (argv[0]), basename (argv[0]));
+
+  /* long help message */
+  snprintf (help, BUFSIZ,
+            "This program measures the time per call of the functions of the\n"
+            "default element scheme for each element class and the levels\n"
+            "from the minimum to the maximum level. It writes one line\n"
+            "eclass,operation,level,num_ops,ns_per_op for each measurement.\n"
+            "The program runs on the first process only.\n\n%s\n", usage);
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* initialize command line argument parser */
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'e', "elements", &eclass_int, -1,
+                      "The element class to measure. -1 for all classes.");
+  sc_options_add_int (opt, 'l', "minlevel", &min_level, 1,
+                      "The minimum level.");
+  sc_options_add_int (opt, 'L', "maxlevel", &max_level, 8,
+                      "The maximum level.");
+  sc_options_add_int (opt, 'n', "samples", &num_samples, 1 << 16,
+                      "The maximum number of elements in a sample.");
+  sc_options_add_int (opt, 'r', "repeat", &num_repeat, 10,
+                      "The number of calls for each element.");
+  sc_options_add_string (opt, 'o', "output", &filename, NULL,
+                         "The file to write the results to. "
+                         "If not given, the results are written to stdout.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    /* display help message and usage */
+    t8_global_productionf ("%s\n", help);
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && -1 <= eclass_int && eclass_int < T8_ECLASS_COUNT
+           && 0 <= min_level && min_level <= max_level && num_samples > 0
+           && num_repeat > 0) {
+    mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+    SC_CHECK_MPI (mpiret);
+    if (mpirank == 0) {
+      t8_time_scheme (eclass_int, min_level, max_level, num_samples,
+                      num_repeat, filename);
+    }
+  }
+  else {
+    /* wrong usage */
+    t8_global_productionf ("\n\t ERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
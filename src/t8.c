@@ -21,6 +21,9 @@
 */
 
 #include <t8.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 static int          t8_package_id = -1;
 
@@ -146,6 +149,36 @@ t8_init (int log_threshold)
   t8_global_productionf ("%-*s %s\n", w, "CFLAGS", T8_CFLAGS);
   t8_global_productionf ("%-*s %s\n", w, "LDFLAGS", T8_LDFLAGS);
   t8_global_productionf ("%-*s %s\n", w, "LIBS", T8_LIBS);
+  t8_global_productionf ("%-*s %i\n", w, "Threads", t8_get_num_threads ());
+}
+
+void
+t8_init_threads (int log_threshold, int num_threads)
+{
+  t8_set_num_threads (num_threads);
+  t8_init (log_threshold);
+}
+
+void
+t8_set_num_threads (int num_threads)
+{
+#ifdef T8_ENABLE_OPENMP
+  T8_ASSERT (!omp_in_parallel ());
+  if (num_threads > 0) {
+    /* All parallel regions of t8code use the default team size */
+    omp_set_num_threads (num_threads);
+  }
+#endif
+}
+
+int
+t8_get_num_threads (void)
+{
+#ifdef T8_ENABLE_OPENMP
+  return omp_get_max_threads ();
+#else
+  return 1;
+#endif
 }
 
 void               *
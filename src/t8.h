@@ -110,8 +110,22 @@ typedef enum
   T8_MPI_TAG_FIRST = P4EST_COMM_TAG_FIRST,
   T8_MPI_PARTITION_CMESH = P4EST_COMM_TAG_LAST, /**< Used for coarse mesh partitioning */
   T8_MPI_PARTITION_FOREST,  /**< Used for forest partitioning */
+  T8_MPI_PARTITION_ELEMENTS,  /**< Used for the elements in forest partitioning */
   T8_MPI_GHOST_FOREST,  /**< Used for for ghost layer creation */
+  T8_MPI_GHOST_SIZE_FOREST,  /**< Used for the message sizes of ghost layer creation */
   T8_MPI_GHOST_EXC_FOREST,  /**< Used for ghost data exchange */
+  T8_MPI_GHOST_UPDATE_FOREST,  /**< Used for incremental ghost layer updates */
+  T8_MPI_GHOST_SHARED,  /**< Used for notifications of shared memory ghost exchanges */
+  T8_MPI_GHOST_SHARED_DONE,  /**< Used to confirm that shared ghost data was read */
+  T8_MPI_GHOST_RMA,  /**< Used to set up one-sided ghost exchanges */
+  T8_MPI_LOCATE_POINTS,  /**< Used for distributed point location */
+  T8_MPI_READ_MSH_FILE,  /**< Used for parallel reading of .msh files */
+  T8_MPI_CMESH_FACES,  /**< Used for parallel computation of face connections */
+  T8_MPI_LNODES,  /**< Used for the global numbering of the nodes of a forest */
+  T8_MPI_TRANSFER_DATA,  /**< Used for data transfer between two forests */
+  T8_MPI_PARTICLES,  /**< Used for the migration of particles in partition */
+  T8_MPI_EXTRUDE,  /**< Used for the leaves of shared trees in forest extrusion */
+  T8_MPI_SCATTER_MSH_FILE,  /**< Used for scattering a .msh file from one process */
   T8_MPI_TAG_LAST
 }
 t8_MPI_tag_t;
@@ -224,6 +238,34 @@ void                t8_errorf (const char *fmt, ...)
  */
 void                t8_init (int log_threshold);
 
+/** Register t8code with libsc, set the number of threads of its
+ * thread-parallel algorithms and print version and variable information.
+ * \param [in] log_threshold As in \ref t8_init.
+ * \param [in] num_threads  As in \ref t8_set_num_threads.
+ */
+void                t8_init_threads (int log_threshold, int num_threads);
+
+/** Set the number of threads of the thread-parallel algorithms of t8code.
+ * Adapt, populate, the geometry cache, face iteration and search all run in
+ * the OpenMP thread team of the calling process and use this number of
+ * threads, unless a function is given its own number of threads.
+ * With fewer MPI processes per node and more threads per process, the
+ * ghost layers and the replicated coarse mesh and shared memory arrays
+ * become smaller.
+ * This is only effective if t8code was configured with --enable-openmp.
+ * \param [in] num_threads The number of threads. 0 or a negative number
+ *                         to keep the OpenMP default, for example as given
+ *                         by the environment variable OMP_NUM_THREADS.
+ * \note This function must not be called inside a parallel region.
+ */
+void                t8_set_num_threads (int num_threads);
+
+/** Return the number of threads of the thread-parallel algorithms.
+ * \return          The number of threads, see \ref t8_set_num_threads.
+ *                  1 if t8code was not configured with --enable-openmp.
+ */
+int                 t8_get_num_threads (void);
+
 /** Return a pointer to an array element indexed by a t8_topidx_t.
  * \param [in] index needs to be in [0]..[elem_count-1].
  * \return           A void * pointing to entry \a it in \a array.
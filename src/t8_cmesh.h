@@ -31,6 +31,7 @@
 #include <t8_data/t8_shmem.h>
 #include <t8_cmesh/t8_cmesh_save.h>
 #include <t8_element.h>
+#include <t8_geometry.h>
 
 /* TODO: If including eclass were just for the cmesh_new routines, we should
  *       move them into a different file.
@@ -54,6 +55,26 @@ typedef struct t8_cmesh *t8_cmesh_t;
 typedef struct t8_ctree *t8_ctree_t;
 typedef struct t8_cghost *t8_cghost_t;
 
+/** The number of computed tree vertices that each thread keeps,
+ * see \ref t8_cmesh_get_tree_vertices. */
+#define T8_CMESH_VERTEX_CACHE_SIZE 8
+
+/** The categories in which \ref t8_cmesh_memory_usage reports
+ * the allocated bytes of a cmesh. */
+typedef enum t8_cmesh_memory
+{
+  T8_CMESH_MEMORY_STRUCT = 0,   /**< The cmesh struct, its profile and vertex caches. */
+  T8_CMESH_MEMORY_STASH,        /**< The stash of an uncommitted cmesh. */
+  T8_CMESH_MEMORY_TREES,        /**< The local tree structs. */
+  T8_CMESH_MEMORY_GHOSTS,       /**< The ghost structs and the ghost to process map. */
+  T8_CMESH_MEMORY_FACES,        /**< The face neighbor and tree to face arrays. */
+  T8_CMESH_MEMORY_ATTRIBUTES,   /**< The attributes and their info entries. */
+  T8_CMESH_MEMORY_OFFSETS,      /**< The shared tree offset array. */
+  T8_CMESH_MEMORY_HASH,         /**< The global to local ghost id hash table. */
+  T8_CMESH_MEMORY_OTHER,        /**< Part headers, tree to process map and bounding boxes. */
+  T8_CMESH_MEMORY_NUM_CATEGORIES /**< The number of categories. */
+} t8_cmesh_memory_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /** Create a new cmesh with reference count one.
@@ -288,6 +309,68 @@ void                t8_cmesh_set_attribute (t8_cmesh_t cmesh,
                                             void *data, size_t data_size,
                                             int data_persists);
 
+/** Compute the face connections of a partitioned cmesh from the global
+ * vertex ids of its trees.
+ * Two faces are connected if they have the same vertex ids. The faces are
+ * matched on processes determined by their vertex ids and the face
+ * connections are sent to the owners of the trees, so no process needs
+ * to know all faces.
+ * For each face connection of a local tree \ref t8_cmesh_set_join is called,
+ * and the classes and face connections of the ghost trees are set as well.
+ * Faces without a neighbor face are boundary faces.
+ * The classes and vertices of the local trees and the partition must be set
+ * separately. This function is collective.
+ * \param [in,out] cmesh       The cmesh to be updated, must not be committed.
+ * \param [in]     first_tree  The global id of the first local tree. The
+ *                             local trees of a process must directly follow
+ *                             the trees of the lower ranks.
+ * \param [in]     num_local_trees The number of local trees.
+ * \param [in]     eclasses    For each local tree its element class.
+ * \param [in]     vertex_ids  For each local tree the non-negative global ids
+ *                             of its vertices in t8code vertex order, one tree
+ *                             after the other.
+ * \param [in]     comm        The mpi communicator.
+ */
+void                t8_cmesh_compute_face_connectivity (t8_cmesh_t cmesh,
+                                                        t8_gloidx_t
+                                                        first_tree,
+                                                        t8_locidx_t
+                                                        num_local_trees,
+                                                        const t8_eclass_t *
+                                                        eclasses,
+                                                        const t8_gloidx_t *
+                                                        vertex_ids,
+                                                        sc_MPI_Comm comm);
+
+/** Store an attribute of the same size at each tree in a range of trees.
+ *  This is equivalent to calling \ref t8_cmesh_set_attribute for each tree
+ *  in the range, but the data of all trees is given in one contiguous array
+ *  and is stored without a separate allocation per tree.
+ *  In particular, it is the preferred way to set the vertices of many trees.
+ * \param [in, out] cmesh       The cmesh to be updated.
+ * \param [in]      first_tree_id The global id of the first tree in the range.
+ * \param [in]      num_trees   The number of trees in the range.
+ * \param [in]      package_id  Unique identifier of a valid software package. \see sc_package_register
+ * \param [in]      key         An integer key used to identify this attribute under all
+ *                              attributes with the same package_id.
+ * \param [in]      data        A pointer to \a num_trees * \a data_size bytes.
+ *                              The attribute of tree \a first_tree_id + i starts
+ *                              at byte i * \a data_size.
+ * \param [in]      data_size   The number of bytes of the attribute of one tree.
+ * \param [in]      data_persists If true then t8code assumes that \a data is present
+ *                              until \ref t8_cmesh_commit is called and does not copy it
+ *                              before. If false the whole array is copied immediately
+ *                              with one memcpy.
+ *                              In both cases a copy of the data is used by t8_code after t8_cmesh_commit.
+ */
+void                t8_cmesh_set_attribute_array (t8_cmesh_t cmesh,
+                                                  t8_gloidx_t first_tree_id,
+                                                  t8_gloidx_t num_trees,
+                                                  int package_id, int key,
+                                                  void *data,
+                                                  size_t data_size,
+                                                  int data_persists);
+
 /** Insert a face-connection between two trees in a cmesh.
  * \param [in,out] cmesh        The cmesh to be updated.
  * \param [in]     tree1        The tree id of the first of the two trees.
@@ -309,7 +392,8 @@ void                t8_cmesh_set_join (t8_cmesh_t cmesh, t8_gloidx_t gtree1,
  * \param [in]     set_profiling If true, profiling will be enabled, if false
  *                              disabled.
  *
- * Profiling is disabled by default.
+ * Profiling is disabled by default. Enabling it also enables the memory
+ * peaks of the profile regions, \see t8_profile_regions_set_memory.
  * The cmesh must not be committed before calling this function.
  * \see t8_cmesh_print_profile
  */
@@ -350,12 +434,59 @@ int                 t8_cmesh_is_equal (t8_cmesh_t cmesh_a,
 t8_cmesh_t          t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root,
                                     sc_MPI_Comm comm);
 
+/** Store the trees of a replicated cmesh only once per node.
+ * After commit, the trees, ghosts and attributes of the cmesh lie in one
+ * block of shared memory per node, and each process only holds pointers
+ * to it. Thus the memory needed per node does not grow with the number of
+ * processes per node.
+ * This setting has no effect if the cmesh is partitioned or if no shared
+ * memory is available. Then each process stores its own copy.
+ * The cmesh must be destroyed on all processes of the communicator passed
+ * to \ref t8_cmesh_commit at the same time and the communicator must be
+ * valid until then.
+ * \param [in,out] cmesh       The cmesh to be updated.
+ * \param [in]     node_shared If nonzero, the trees are stored in node shared memory.
+ */
+void                t8_cmesh_set_node_shared (t8_cmesh_t cmesh,
+                                              int node_shared);
+
+/** Compute the vertices of the trees from a geometry instead of storing them.
+ * For each tree that has no vertices set via \ref t8_cmesh_set_tree_vertices,
+ * \ref t8_cmesh_get_tree_vertices evaluates the geometry at the corners of
+ * the tree's reference element. The geometry is called with the global id
+ * of the tree.
+ * A cmesh that is partitioned or copied from this cmesh keeps the geometry,
+ * a refined cmesh does not.
+ * \param [in,out] cmesh       The cmesh to be updated.
+ * \param [in]     geometry    The geometry of the trees. Its transformation
+ *                             must be set. We take ownership of one reference.
+ */
+void                t8_cmesh_set_tree_geometry (t8_cmesh_t cmesh,
+                                                t8_geometry_t geometry);
+
 #ifdef T8_WITH_METIS
 /* TODO: document this. */
 /* TODO: think about making this a pre-commit set_reorder function. */
 void                t8_cmesh_reorder (t8_cmesh_t cmesh, sc_MPI_Comm comm);
 
-/* TODO: think about a sensible interface for a parmetis reordering. */
+/** Reorder the trees of a cmesh during commit, such that cutting the
+ * tree order into contiguous parts gives a partition with few faces
+ * between different processes.
+ * The face graph of the trees is partitioned into mpisize parts with METIS
+ * and the trees of each part are numbered consecutively, keeping their
+ * original order within a part. The resulting edge cut, which is the
+ * number of faces between trees of different parts, is printed.
+ * A cmesh derived from the reordered cmesh with
+ * \ref t8_cmesh_set_partition_uniform then has tree-contiguous partitions
+ * with a small number of ghost trees, regardless of the numbering of the
+ * input mesh.
+ * The tree ids given in \ref t8_cmesh_set_tree_class, \ref t8_cmesh_set_join
+ * and the attribute functions refer to the original numbering.
+ * \param [in,out] cmesh       The cmesh to be updated. It must be built
+ *                             from scratch and must not be partitioned.
+ * \param [in]     reorder     If nonzero, the trees are reordered.
+ */
+void                t8_cmesh_set_reorder (t8_cmesh_t cmesh, int reorder);
 #endif
 
 /** After allocating and adding properties to a cmesh, finish its construction.
@@ -369,9 +500,41 @@ void                t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm);
 /* TODO: Document */
 int                 t8_cmesh_save (t8_cmesh_t cmesh, const char *fileprefix);
 
+/** Save a committed cmesh in a binary format.
+ * As \ref t8_cmesh_save, each process writes the file fileprefix_RANK.cmesh
+ * and for a replicated cmesh only rank 0 writes.
+ * The trees, ghosts and attributes of each process are written exactly as
+ * they are stored in memory, such that loading them again does not require
+ * any parsing. All attributes of the trees are stored.
+ * The files can only be read on machines with the same byte order and
+ * the same data type sizes as the writing machine.
+ * \param [in]      cmesh       A committed cmesh.
+ * \param [in]      fileprefix  The prefix of the file names.
+ * \return                      True on success.
+ */
+int                 t8_cmesh_save_binary (t8_cmesh_t cmesh,
+                                          const char *fileprefix);
+
 /* TODO: Document */
+/* The file may be written by \ref t8_cmesh_save or \ref t8_cmesh_save_binary,
+ * the format is detected automatically. */
 t8_cmesh_t          t8_cmesh_load (const char *filename, sc_MPI_Comm comm);
 
+/** Load a cmesh from a file written by \ref t8_cmesh_save_binary and
+ * use the trees directly from a private memory mapping of the file.
+ * Thus the trees do not need to be copied and the operating system only
+ * reads those parts of the file that are accessed.
+ * Changes to the cmesh are not written back to the file.
+ * The file must not be modified or truncated as long as the cmesh exists.
+ * If memory mapping is not available or the file is in text format, the
+ * file is read as in \ref t8_cmesh_load.
+ * \param [in]      filename    The name of the file to load.
+ * \param [in]      comm        The MPI communicator of the loaded cmesh.
+ * \return                      The loaded cmesh, NULL on failure.
+ */
+t8_cmesh_t          t8_cmesh_load_mapped (const char *filename,
+                                          sc_MPI_Comm comm);
+
 /* TODO: Document */
 /* procs_per_node is only relevant in mode==JUQUEEN.
  *  num_files = 1 => replicated cmesh is constructed */
@@ -527,6 +690,12 @@ t8_locidx_t         t8_cmesh_get_local_id (t8_cmesh_t cmesh,
                                            t8_gloidx_t global_id);
 
 /** Print the collected statistics from a cmesh profile.
+ * If hardware counters are recorded, their values for commit are printed
+ * as well, \see t8_profile_regions_num_hw_counters, followed by the peak
+ * heap memory of commit if the C library reports it.
+ * Last, the bytes, messages and peer processes sent and received in
+ * partition and bcast are printed together with a histogram of the
+ * communication volume over all processes.
  * \param [in]    cmesh         The cmesh.
  *
  * \a cmesh must be committed before calling this function.
@@ -534,15 +703,83 @@ t8_locidx_t         t8_cmesh_get_local_id (t8_cmesh_t cmesh,
  */
 void                t8_cmesh_print_profile (t8_cmesh_t cmesh);
 
+/** Count the bytes that a cmesh allocates, broken down by category.
+ * Data that lies in node shared memory is counted on each process
+ * with the fraction 1 / (number of processes on the node).
+ * This function is collective over \a comm.
+ * \param [in]    cmesh         The cmesh, committed or not.
+ * \param [in]    comm          The communicator over which the usage is reduced.
+ * \param [out]   local         If not NULL, the bytes of this process for each
+ *                              category, T8_CMESH_MEMORY_NUM_CATEGORIES entries.
+ * \param [out]   sum           If not NULL, the bytes of each category summed
+ *                              over all processes in \a comm.
+ * \param [out]   max           If not NULL, the maximum over all processes in
+ *                              \a comm of the bytes of each category.
+ * \return                      The sum over all categories of \a local.
+ */
+size_t              t8_cmesh_memory_usage (t8_cmesh_t cmesh,
+                                           sc_MPI_Comm comm, size_t * local,
+                                           size_t * sum, size_t * max);
+
+/** Print the memory usage of a cmesh, summed and maximized over processes.
+ * This function is collective over \a comm.
+ * \param [in]    cmesh         The cmesh.
+ * \param [in]    comm          The communicator over which the usage is reduced.
+ * \see t8_cmesh_memory_usage
+ */
+void                t8_cmesh_print_memory_usage (t8_cmesh_t cmesh,
+                                                 sc_MPI_Comm comm);
+
 /** Return a pointer to the vertex coordinates of a tree.
+ * If the vertices of the tree are not stored but a geometry was set with
+ * \ref t8_cmesh_set_tree_geometry, they are computed and stored in a small
+ * cache of the calling thread. Such a pointer stays valid until the calling
+ * thread has computed the vertices of T8_CMESH_VERTEX_CACHE_SIZE other trees.
  * \param [in]    cmesh         The cmesh.
  * \param [in]    ltreeid       The id of a loca tree.
- * \return    If stored, a pointer to the vertex coordinates of \a tree.
+ * \return    If stored or computed, a pointer to the vertex coordinates of \a tree.
  *            If no coordinates for this tree are found, NULL.
  */
 double             *t8_cmesh_get_tree_vertices (t8_cmesh_t cmesh,
                                                 t8_locidx_t ltreeid);
 
+/** Return the geometry of the trees of a cmesh.
+ * \param [in]    cmesh         The cmesh, must be committed.
+ * \return    The geometry set with \ref t8_cmesh_set_tree_geometry, or NULL
+ *            if no geometry was set. We do not pass ownership.
+ */
+t8_geometry_t       t8_cmesh_get_tree_geometry (t8_cmesh_t cmesh);
+
+/** Compute the axis aligned bounding box of the vertices of a local tree.
+ * The boxes of all local trees are computed on the first call and
+ * stored at the cmesh. This first call is not thread safe.
+ * \param [in]    cmesh         The cmesh, must be committed.
+ * \param [in]    ltreeid       The id of a local tree.
+ * \param [out]   box           The minimum x, y and z coordinates followed
+ *                              by the maximum x, y and z coordinates.
+ * \return    True if the tree has vertices. Otherwise the box is empty,
+ *            with its minimum larger than its maximum.
+ */
+int                 t8_cmesh_get_tree_bounding_box (t8_cmesh_t cmesh,
+                                                    t8_locidx_t ltreeid,
+                                                    double box[6]);
+
+/** Find the local trees whose bounding boxes contain a point.
+ * The trees are found with a bounding volume hierarchy over the local
+ * trees, which is built together with the bounding boxes.
+ * \param [in]    cmesh         The cmesh, must be committed.
+ * \param [in]    point         The x, y and z coordinates of the point.
+ * \param [in]    tolerance     The boxes are enlarged by this value in each
+ *                              direction.
+ * \param [in,out] ltreeids     An array of t8_locidx_t. On output the local
+ *                              ids of the trees are appended.
+ * \see t8_cmesh_get_tree_bounding_box
+ */
+void                t8_cmesh_find_trees_at_point (t8_cmesh_t cmesh,
+                                                  const double point[3],
+                                                  double tolerance,
+                                                  sc_array_t * ltreeids);
+
 /** Return the attribute pointer of a tree.
  * \param [in]     cmesh        The cmesh.
  * \param [in]     package_id   The identifier of a valid software package. \see sc_package_register
@@ -592,6 +829,35 @@ void                t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
                                              t8_gloidx_t * child_in_tree_end,
                                              int8_t * first_tree_shared);
 
+/** Calculate the sections of a uniform forest for all processes at once.
+ * The result for process p is the same as that of \ref t8_cmesh_uniform_bounds
+ * on process p. This function does not communicate.
+ * \param [in]    cmesh         The cmesh to be considered.
+ * \param [in]    level         The uniform refinement level to be created.
+ * \param [out]   first_local_trees  The first local tree of each process.
+ * \param [out]   child_in_tree_begins The first local element in the first
+ *                              local tree of each process. Not computed if NULL.
+ * \param [out]   last_local_trees  The last local tree of each process.
+ * \param [out]   child_in_tree_ends The first element in the last local tree
+ *                              of each process that does not belong to it
+ *                              anymore. Not computed if NULL.
+ * \param [out]   first_trees_shared The first_tree_shared flag of each process.
+ *                              Not computed if NULL.
+ * Each array must have mpisize entries.
+ * \a cmesh must be committed before calling this function.
+ */
+void                t8_cmesh_uniform_bounds_all (t8_cmesh_t cmesh,
+                                                 int level,
+                                                 t8_gloidx_t *
+                                                 first_local_trees,
+                                                 t8_gloidx_t *
+                                                 child_in_tree_begins,
+                                                 t8_gloidx_t *
+                                                 last_local_trees,
+                                                 t8_gloidx_t *
+                                                 child_in_tree_ends,
+                                                 int8_t * first_trees_shared);
+
 /** Increase the reference counter of a cmesh.
  * \param [in,out] cmesh        On input, this cmesh must exist with positive
  *                              reference count.  It may be in any state.
@@ -658,6 +924,41 @@ t8_cmesh_t          t8_cmesh_new_from_p8est (p8est_connectivity_t * conn,
  */
 t8_cmesh_t          t8_cmesh_new_empty (sc_MPI_Comm comm, int do_partition);
 
+/** Construct a replicated cmesh directly from arrays describing its trees.
+ * In contrast to setting each tree, vertex and face connection with the
+ * t8_cmesh_set_ functions, the trees are built without the intermediate
+ * stash, which saves memory and time for large meshes.
+ * The same arrays must be given on all processes of \a comm.
+ * \param [in]      dimension  The dimension of the cmesh.
+ * \param [in]      num_trees  The number of trees.
+ * \param [in]      eclasses   For each tree its element class. All classes
+ *                             must have dimension \a dimension.
+ * \param [in]      vertices   The vertex coordinates of all trees, one tree
+ *                             after the other. Tree i has 3 * t8_eclass_num_vertices[eclasses[i]]
+ *                             entries.
+ * \param [in]      face_neighbors If not NULL, for each tree and each face the
+ *                             local id of the neighbor tree, with
+ *                             t8_eclass_max_num_faces[\a dimension] entries per
+ *                             tree. A negative value marks a boundary face.
+ *                             If NULL, all faces are boundary faces.
+ * \param [in]      ttf        Must be NULL if and only if \a face_neighbors is.
+ *                             For each tree and each face the value
+ *                             F * orientation + neighbor face, where F is
+ *                             t8_eclass_max_num_faces[\a dimension], arranged as
+ *                             \a face_neighbors. Both sides of each face
+ *                             connection must be given.
+ * \param [in]      comm       mpi communicator to be used with the new cmesh.
+ * \return                     A committed replicated cmesh.
+ */
+t8_cmesh_t          t8_cmesh_new_from_arrays (int dimension,
+                                              t8_locidx_t num_trees,
+                                              const t8_eclass_t * eclasses,
+                                              const double *vertices,
+                                              const t8_locidx_t *
+                                              face_neighbors,
+                                              const int8_t * ttf,
+                                              sc_MPI_Comm comm);
+
 /** Constructs a cmesh that consists only of one tree of a given element class.
  * \param [in]      eclass     The element class.
  * \param [in]      comm       mpi communicator to be used with the new cmesh.
@@ -732,6 +1033,21 @@ t8_cmesh_t          t8_cmesh_new_periodic_line_more_trees (sc_MPI_Comm comm);
 t8_cmesh_t          t8_cmesh_new_bigmesh (t8_eclass_t eclass, int num_trees,
                                           sc_MPI_Comm comm);
 
+/** Construct the same mesh as \ref t8_cmesh_new_bigmesh directly as a
+ * partitioned cmesh.
+ * Each process only sets its local trees of a uniform level 0 partition
+ * and their ghosts, such that memory and runtime only depend on the
+ * local number of trees.
+ * \param [in] eclass       This element class determines the dimension and
+ *                          the type trees used.
+ * \param [in] num_trees    The global number of trees to use. Must be > 0.
+ * \param [in] comm         The MPI_Communicator used to commit the cmesh.
+ * \return                  A committed and partitioned cmesh.
+ */
+t8_cmesh_t          t8_cmesh_new_bigmesh_partitioned (t8_eclass_t eclass,
+                                                      t8_gloidx_t num_trees,
+                                                      sc_MPI_Comm comm);
+
 /** Construct a forest of three connected askew lines
   * \param [in] comm         The mpi communicator to use.
   * \return                  A valid cmesh, as if _init and _commit had been called.
@@ -30,6 +30,10 @@
 #include <metis.h>
 #endif
 #include "t8_cmesh_trees.h"
+#include "t8_cmesh_boxes.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /** \file t8_cmesh.c
  *
@@ -167,6 +171,30 @@ t8_cmesh_comm_is_valid (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   return 1;
 }
 
+/* The computed vertices of the last trees that a thread asked for.
+ * The entries are replaced in round robin order. */
+typedef struct t8_cmesh_vertex_cache
+{
+  t8_locidx_t         ltreeid[T8_CMESH_VERTEX_CACHE_SIZE];      /* -1 for an empty entry */
+  double              vertices[T8_CMESH_VERTEX_CACHE_SIZE]
+    [3 * T8_ECLASS_MAX_CORNERS];
+  int                 next;     /* The entry that is replaced next */
+} t8_cmesh_vertex_cache_t;
+
+/* The corners of the reference element of each eclass */
+static const double
+  t8_cmesh_reference_vertices[T8_ECLASS_COUNT][3 * T8_ECLASS_MAX_CORNERS] = {
+  {0, 0, 0},                    /* VERTEX */
+  {0, 0, 0, 1, 0, 0},           /* LINE */
+  {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0},         /* QUAD */
+  {0, 0, 0, 1, 0, 0, 1, 1, 0},  /* TRIANGLE */
+  {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0,
+   0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1},         /* HEX */
+  {0, 0, 0, 1, 0, 0, 1, 0, 1, 1, 1, 1},         /* TET */
+  {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 1, 1, 1},       /* PRISM */
+  {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0, 1, 1, 1} /* PYRAMID */
+};
+
 void
 t8_cmesh_init (t8_cmesh_t * pcmesh)
 {
@@ -471,14 +499,68 @@ t8_cmesh_set_attribute (t8_cmesh_t cmesh, t8_gloidx_t gtree_id,
                           data, data_persists);
 }
 
+void
+t8_cmesh_set_attribute_array (t8_cmesh_t cmesh, t8_gloidx_t first_tree_id,
+                              t8_gloidx_t num_trees, int package_id, int key,
+                              void *data, size_t data_size, int data_persists)
+{
+  T8_ASSERT (cmesh != NULL);
+  T8_ASSERT (!cmesh->committed);
+
+  t8_stash_add_attribute_array (cmesh->stash, first_tree_id, num_trees,
+                                package_id, key, data_size, data,
+                                !data_persists);
+}
+
 double             *
 t8_cmesh_get_tree_vertices (t8_cmesh_t cmesh, t8_locidx_t ltreeid)
 {
+  t8_cmesh_vertex_cache_t *cache;
+  t8_gloidx_t         gtreeid;
+  t8_eclass_t         eclass;
+  double             *vertices;
+  int                 ithread, ientry, ivertex;
+
   T8_ASSERT (t8_cmesh_is_committed (cmesh));
   T8_ASSERT (0 <= ltreeid && ltreeid < cmesh->num_local_trees);
 
-  return (double *) t8_cmesh_get_attribute (cmesh, t8_get_package_id (), 0,
-                                            ltreeid);
+  vertices = (double *) t8_cmesh_get_attribute (cmesh, t8_get_package_id (),
+                                                0, ltreeid);
+  if (vertices != NULL || cmesh->tree_geometry == NULL) {
+    return vertices;
+  }
+  /* Compute the vertices from the geometry */
+#ifdef _OPENMP
+  ithread = omp_get_thread_num ();
+#else
+  ithread = 0;
+#endif
+  T8_ASSERT (0 <= ithread && ithread < cmesh->num_vertex_caches);
+  cache = cmesh->vertex_caches + ithread;
+  for (ientry = 0; ientry < T8_CMESH_VERTEX_CACHE_SIZE; ientry++) {
+    if (cache->ltreeid[ientry] == ltreeid) {
+      return cache->vertices[ientry];
+    }
+  }
+  ientry = cache->next;
+  cache->next = (cache->next + 1) % T8_CMESH_VERTEX_CACHE_SIZE;
+  cache->ltreeid[ientry] = ltreeid;
+  eclass = t8_cmesh_get_tree_class (cmesh, ltreeid);
+  gtreeid = t8_cmesh_get_global_id (cmesh, ltreeid);
+  for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass]; ivertex++) {
+    t8_geometry_evaluate (cmesh->tree_geometry, (t8_topidx_t) gtreeid,
+                          t8_cmesh_reference_vertices[eclass] + 3 * ivertex,
+                          cache->vertices[ientry] + 3 * ivertex);
+  }
+  return cache->vertices[ientry];
+}
+
+t8_geometry_t
+t8_cmesh_get_tree_geometry (t8_cmesh_t cmesh)
+{
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+
+  return cmesh->tree_geometry;
 }
 
 void               *
@@ -743,6 +825,8 @@ t8_cmesh_set_profiling (t8_cmesh_t cmesh, int set_profiling)
     if (cmesh->profile == NULL) {
       /* Only do something if profiling is not enabled already */
       cmesh->profile = T8_ALLOC_ZERO (t8_cprofile_struct_t, 1);
+      /* Record the memory peaks of the commit stages */
+      t8_profile_regions_set_memory (1);
     }
   }
   else {
@@ -869,13 +953,14 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
 {
   int                 mpirank, mpisize, mpiret;
   int                 iclass;
+  size_t              num_bytes;
   t8_cmesh_t          cmesh_out;
 
   struct
   {
     t8_cmesh_struct_t   cmesh;
     t8_gloidx_t         num_trees_per_eclass[T8_ECLASS_COUNT];
-    size_t              stash_elem_counts[3];
+    size_t              stash_elem_counts[4];
     int                 pre_commit;     /* True, if cmesh on root is not committed yet. */
 #ifdef T8_ENABLE_DEBUG
     sc_MPI_Comm         comm;
@@ -925,6 +1010,8 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
       meta_info.stash_elem_counts[0] = cmesh_in->stash->attributes.elem_count;
       meta_info.stash_elem_counts[1] = cmesh_in->stash->classes.elem_count;
       meta_info.stash_elem_counts[2] = cmesh_in->stash->joinfaces.elem_count;
+      meta_info.stash_elem_counts[3] =
+        t8_stash_get_attribute_bytes (cmesh_in->stash);
     }
 #ifdef T8_ENABLE_DEBUG
     meta_info.comm = comm;
@@ -952,7 +1039,7 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
     cmesh_out->num_ghosts = 0;
     T8_ASSERT (cmesh_out->set_partition == 0);
     if (meta_info.cmesh.profile != NULL) {
-      t8_cmesh_set_profiling (cmesh_in, 1);
+      t8_cmesh_set_profiling (cmesh_out, 1);
     }
     for (iclass = 0; iclass < T8_ECLASS_COUNT; iclass++) {
       cmesh_out->num_trees_per_eclass[iclass] =
@@ -964,14 +1051,20 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
     T8_ASSERT (meta_info.comm == comm);
 #endif
   }
+  num_bytes = sizeof (meta_info);
   if (meta_info.pre_commit) {
     /* broadcast all the stashed information about trees/neighbors/attributes */
     t8_stash_bcast (cmesh_out->stash, root, comm,
                     meta_info.stash_elem_counts);
+    num_bytes += meta_info.stash_elem_counts[0]
+      * sizeof (t8_stash_attribute_struct_t)
+      + meta_info.stash_elem_counts[1] * sizeof (t8_stash_class_struct_t)
+      + meta_info.stash_elem_counts[2] * sizeof (t8_stash_joinface_struct_t)
+      + meta_info.stash_elem_counts[3];
   }
   else {
     /* broadcast the stored information about the trees */
-    t8_cmesh_trees_bcast (cmesh_out, root, comm);
+    num_bytes += t8_cmesh_trees_bcast (cmesh_out, root, comm);
     if (mpirank != root) {
       /* destroy stash and set to committed */
       t8_stash_destroy (&cmesh_out->stash);
@@ -981,6 +1074,22 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
 
   cmesh_out->mpirank = mpirank;
   cmesh_out->mpisize = mpisize;
+  /* The root sends the payload to all other processes */
+  if (cmesh_out->profile != NULL) {
+    memset (&cmesh_out->profile->bcast_comm, 0, sizeof (t8_profile_comm_t));
+  }
+  if (mpirank == root) {
+    int                 iproc;
+
+    for (iproc = 0; iproc < mpisize - 1; iproc++) {
+      t8_profile_comm_sent (cmesh_out->profile == NULL ? NULL :
+                            &cmesh_out->profile->bcast_comm, 1, num_bytes);
+    }
+  }
+  else {
+    t8_profile_comm_received (cmesh_out->profile == NULL ? NULL :
+                              &cmesh_out->profile->bcast_comm, 1, num_bytes);
+  }
   /* Final checks */
 #ifdef T8_ENABLE_DEBUG
   if (!meta_info.pre_commit) {
@@ -991,7 +1100,52 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
   return cmesh_out;
 }
 
+void
+t8_cmesh_set_node_shared (t8_cmesh_t cmesh, int node_shared)
+{
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+
+  cmesh->set_node_shared = node_shared != 0;
+}
+
+void
+t8_cmesh_set_tree_geometry (t8_cmesh_t cmesh, t8_geometry_t geometry)
+{
+  int                 icache;
+
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+  T8_ASSERT (geometry != NULL);
+
+  if (cmesh->tree_geometry != NULL) {
+    t8_geometry_unref (&cmesh->tree_geometry);
+  }
+  cmesh->tree_geometry = geometry;
+  if (cmesh->vertex_caches == NULL) {
+    /* Allocate one cache for each thread */
+#ifdef _OPENMP
+    cmesh->num_vertex_caches = omp_get_max_threads ();
+#else
+    cmesh->num_vertex_caches = 1;
+#endif
+    cmesh->vertex_caches =
+      T8_ALLOC (t8_cmesh_vertex_cache_t, cmesh->num_vertex_caches);
+    for (icache = 0; icache < cmesh->num_vertex_caches; icache++) {
+      memset (cmesh->vertex_caches[icache].ltreeid, -1,
+              sizeof (cmesh->vertex_caches[icache].ltreeid));
+      cmesh->vertex_caches[icache].next = 0;
+    }
+  }
+}
+
 #ifdef T8_WITH_METIS
+void
+t8_cmesh_set_reorder (t8_cmesh_t cmesh, int reorder)
+{
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+
+  cmesh->set_reorder = reorder != 0;
+}
+
 void
 t8_cmesh_reorder (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 {
@@ -1140,15 +1294,15 @@ int
 t8_cmesh_tree_face_is_boundary (t8_cmesh_t cmesh,
                                 t8_locidx_t ltree_id, int face)
 {
-  t8_locidx_t        *face_neighbor;
-  int8_t             *ttf;
+  t8_locidx_t         face_neighbor;
+  int8_t              ttf;
 
   T8_ASSERT (t8_cmesh_is_committed (cmesh));
 
-  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, ltree_id, &face_neighbor,
-                                      &ttf);
+  face_neighbor = t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees,
+                                                        ltree_id, face, &ttf);
 
-  if (face_neighbor[face] == ltree_id && ttf[face] == face) {
+  if (face_neighbor == ltree_id && ttf == face) {
     /* The tree is connected to itself at the same face.
      * Thus this is a domain boundary */
     return 1;
@@ -1252,22 +1406,128 @@ t8_cmesh_print_profile (t8_cmesh_t cmesh)
     t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "Printing stats for cmesh.\n");
     sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS,
                     T8_CPROFILE_NUM_STATS, stats, 1, 1);
+    /* The hardware counters of commit, if they are recorded */
+    {
+      const char         *phase_names[1] = { "Commit" };
+
+      t8_profile_regions_print_hw_counters (sc_MPI_COMM_WORLD, "cmesh", 1,
+                                            phase_names,
+                                            profile->commit_hw_counters);
+      t8_profile_regions_print_memory (sc_MPI_COMM_WORLD, "cmesh", 1,
+                                       phase_names,
+                                       &profile->commit_memory_peak);
+    }
+    /* The messages of partition and bcast */
+    {
+      const char         *phase_names[2] = { "Partition", "Bcast" };
+      t8_profile_comm_t   phases[2];
+
+      phases[0] = profile->partition_comm;
+      phases[1] = profile->bcast_comm;
+      t8_profile_comm_print (sc_MPI_COMM_WORLD, "cmesh", 2, phase_names,
+                             phases);
+    }
   }
 }
 
+size_t
+t8_cmesh_memory_usage (t8_cmesh_t cmesh, sc_MPI_Comm comm, size_t * local,
+                       size_t * sum, size_t * max)
+{
+  size_t              usage[T8_CMESH_MEMORY_NUM_CATEGORIES], total;
+  long long           send[T8_CMESH_MEMORY_NUM_CATEGORIES];
+  long long           recv[T8_CMESH_MEMORY_NUM_CATEGORIES];
+  t8_cmesh_tree_boxes_struct_t *boxes;
+  int                 icat, mpiret;
+
+  T8_ASSERT (cmesh != NULL);
+
+  memset (usage, 0, sizeof (usage));
+  usage[T8_CMESH_MEMORY_STRUCT] = sizeof (t8_cmesh_struct_t)
+    + cmesh->num_vertex_caches * sizeof (t8_cmesh_vertex_cache_t);
+  if (cmesh->profile != NULL) {
+    usage[T8_CMESH_MEMORY_STRUCT] += sizeof (t8_cprofile_struct_t);
+  }
+  if (cmesh->stash != NULL) {
+    usage[T8_CMESH_MEMORY_STASH] = t8_stash_memory_used (cmesh->stash);
+  }
+  if (cmesh->trees != NULL) {
+    t8_cmesh_trees_memory_usage (cmesh->trees, usage);
+  }
+  if (cmesh->tree_offsets != NULL) {
+    usage[T8_CMESH_MEMORY_OFFSETS] =
+      t8_shmem_array_get_bytes_per_process (cmesh->tree_offsets);
+  }
+  if (cmesh->tree_boxes != NULL) {
+    boxes = cmesh->tree_boxes;
+    usage[T8_CMESH_MEMORY_OTHER] += sizeof (t8_cmesh_tree_boxes_struct_t)
+      + boxes->num_trees * (6 * sizeof (double) + sizeof (t8_locidx_t))
+      + SC_MAX (1, 2 * boxes->num_trees) * sizeof (t8_cmesh_bvh_node_t);
+  }
+
+  for (icat = 0, total = 0; icat < T8_CMESH_MEMORY_NUM_CATEGORIES; icat++) {
+    total += usage[icat];
+    send[icat] = (long long) usage[icat];
+    if (local != NULL) {
+      local[icat] = usage[icat];
+    }
+  }
+  if (sum != NULL) {
+    mpiret = sc_MPI_Allreduce (send, recv, T8_CMESH_MEMORY_NUM_CATEGORIES,
+                               sc_MPI_LONG_LONG_INT, sc_MPI_SUM, comm);
+    SC_CHECK_MPI (mpiret);
+    for (icat = 0; icat < T8_CMESH_MEMORY_NUM_CATEGORIES; icat++) {
+      sum[icat] = (size_t) recv[icat];
+    }
+  }
+  if (max != NULL) {
+    mpiret = sc_MPI_Allreduce (send, recv, T8_CMESH_MEMORY_NUM_CATEGORIES,
+                               sc_MPI_LONG_LONG_INT, sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+    for (icat = 0; icat < T8_CMESH_MEMORY_NUM_CATEGORIES; icat++) {
+      max[icat] = (size_t) recv[icat];
+    }
+  }
+  return total;
+}
+
 void
-t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
-                         t8_gloidx_t * first_local_tree,
-                         t8_gloidx_t * child_in_tree_begin,
-                         t8_gloidx_t * last_local_tree,
-                         t8_gloidx_t * child_in_tree_end,
-                         int8_t * first_tree_shared)
+t8_cmesh_print_memory_usage (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  size_t              sum[T8_CMESH_MEMORY_NUM_CATEGORIES];
+  size_t              max[T8_CMESH_MEMORY_NUM_CATEGORIES];
+  int                 icat;
+  const char         *names[T8_CMESH_MEMORY_NUM_CATEGORIES] = {
+    "struct", "stash", "trees", "ghosts", "faces", "attributes", "offsets",
+    "hash", "other"
+  };
+
+  t8_cmesh_memory_usage (cmesh, comm, NULL, sum, max);
+  t8_global_productionf ("cmesh memory usage in bytes (sum, max):\n");
+  for (icat = 0; icat < T8_CMESH_MEMORY_NUM_CATEGORIES; icat++) {
+    t8_global_productionf ("  %-12s %14llu %14llu\n", names[icat],
+                           (unsigned long long) sum[icat],
+                           (unsigned long long) max[icat]);
+  }
+}
+
+/* Compute the section of a uniform forest of the given level for the
+ * process rank. This only depends on the global number of trees and
+ * never communicates. */
+static void
+t8_cmesh_uniform_bounds_rank (t8_cmesh_t cmesh, int level, int rank,
+                              t8_gloidx_t * first_local_tree,
+                              t8_gloidx_t * child_in_tree_begin,
+                              t8_gloidx_t * last_local_tree,
+                              t8_gloidx_t * child_in_tree_end,
+                              int8_t * first_tree_shared)
 {
   int                 is_empty;
 
   T8_ASSERT (cmesh != NULL);
   T8_ASSERT (cmesh->committed);
   T8_ASSERT (level >= 0);
+  T8_ASSERT (0 <= rank && rank < cmesh->mpisize);
 
   *first_local_tree = 0;
   if (child_in_tree_begin != NULL) {
@@ -1291,7 +1551,7 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
     children_per_tree = one << cmesh->dimension * level;
     global_num_children = cmesh->num_trees * children_per_tree;
 
-    if (cmesh->mpirank == 0) {
+    if (rank == 0) {
       first_global_child = 0;
       if (child_in_tree_begin != NULL) {
         *child_in_tree_begin = 0;
@@ -1305,12 +1565,12 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
        */
       first_global_child =
         ((long double) global_num_children *
-         cmesh->mpirank) / (double) cmesh->mpisize;
+         rank) / (double) cmesh->mpisize;
     }
-    if (cmesh->mpirank != cmesh->mpisize - 1) {
+    if (rank != cmesh->mpisize - 1) {
       last_global_child =
         ((long double) global_num_children *
-         (cmesh->mpirank + 1)) / (double) cmesh->mpisize;
+         (rank + 1)) / (double) cmesh->mpisize;
     }
     else {
       last_global_child = global_num_children;
@@ -1333,9 +1593,9 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
     if (first_tree_shared != NULL) {
 #ifdef T8_ENABLE_DEBUG
       prev_last_tree = (first_global_child - 1) / children_per_tree;
-      T8_ASSERT (cmesh->mpirank > 0 || prev_last_tree <= 0);
+      T8_ASSERT (rank > 0 || prev_last_tree <= 0);
 #endif
-      if (!is_empty && cmesh->mpirank > 0 && first_global_child > 0) {
+      if (!is_empty && rank > 0 && first_global_child > 0) {
         /* We exclude empty partitions here, by def their first_tree_shared flag is zero */
         /* We also exclude that the previous partition was empty at the beginning of the
          * partitions array */
@@ -1370,7 +1630,7 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
     }
 
 #if 0
-    if (first_global_child >= last_global_child && cmesh->mpirank != 0) {
+    if (first_global_child >= last_global_child && rank != 0) {
       /* This process is empty */
       *first_local_tree = prev_last_tree + 1;
     }
@@ -1382,6 +1642,45 @@ t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
   }
 }
 
+void
+t8_cmesh_uniform_bounds (t8_cmesh_t cmesh, int level,
+                         t8_gloidx_t * first_local_tree,
+                         t8_gloidx_t * child_in_tree_begin,
+                         t8_gloidx_t * last_local_tree,
+                         t8_gloidx_t * child_in_tree_end,
+                         int8_t * first_tree_shared)
+{
+  t8_cmesh_uniform_bounds_rank (cmesh, level, cmesh->mpirank,
+                                first_local_tree, child_in_tree_begin,
+                                last_local_tree, child_in_tree_end,
+                                first_tree_shared);
+}
+
+void
+t8_cmesh_uniform_bounds_all (t8_cmesh_t cmesh, int level,
+                             t8_gloidx_t * first_local_trees,
+                             t8_gloidx_t * child_in_tree_begins,
+                             t8_gloidx_t * last_local_trees,
+                             t8_gloidx_t * child_in_tree_ends,
+                             int8_t * first_trees_shared)
+{
+  int                 iproc;
+
+  T8_ASSERT (first_local_trees != NULL && last_local_trees != NULL);
+
+  for (iproc = 0; iproc < cmesh->mpisize; iproc++) {
+    t8_cmesh_uniform_bounds_rank (cmesh, level, iproc,
+                                  first_local_trees + iproc,
+                                  child_in_tree_begins == NULL ? NULL :
+                                  child_in_tree_begins + iproc,
+                                  last_local_trees + iproc,
+                                  child_in_tree_ends == NULL ? NULL :
+                                  child_in_tree_ends + iproc,
+                                  first_trees_shared == NULL ? NULL :
+                                  first_trees_shared + iproc);
+  }
+}
+
 static void
 t8_cmesh_reset (t8_cmesh_t * pcmesh)
 {
@@ -1421,6 +1720,13 @@ t8_cmesh_reset (t8_cmesh_t * pcmesh)
   if (cmesh->profile != NULL) {
     T8_FREE (cmesh->profile);
   }
+  if (cmesh->tree_boxes != NULL) {
+    t8_cmesh_tree_boxes_destroy (&cmesh->tree_boxes);
+  }
+  if (cmesh->tree_geometry != NULL) {
+    t8_geometry_unref (&cmesh->tree_geometry);
+    T8_FREE (cmesh->vertex_caches);
+  }
   if (cmesh->set_refine_scheme != NULL) {
     t8_scheme_cxx_unref (&cmesh->set_refine_scheme);
   }
@@ -1761,6 +2067,88 @@ t8_cmesh_new_empty (sc_MPI_Comm comm, int do_partition)
   return cmesh;
 }
 
+t8_cmesh_t
+t8_cmesh_new_from_arrays (int dimension, t8_locidx_t num_trees,
+                          const t8_eclass_t * eclasses,
+                          const double *vertices,
+                          const t8_locidx_t * face_neighbors,
+                          const int8_t * ttf, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_ctree_t          tree;
+  t8_stash_attribute_struct_t attribute;
+  t8_locidx_t         ltree, *tree_face_neighbors, neighbor;
+  int8_t             *tree_ttf;
+  size_t              vertex_offset;
+  int                 F, iface, num_faces;
+
+  T8_ASSERT (0 <= dimension && dimension <= T8_ECLASS_MAX_DIM);
+  T8_ASSERT (num_trees >= 0);
+  T8_ASSERT (num_trees == 0 || (eclasses != NULL && vertices != NULL));
+  T8_ASSERT ((face_neighbors == NULL) == (ttf == NULL));
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_dimension (cmesh, dimension);
+  if (num_trees == 0) {
+    t8_cmesh_commit (cmesh, comm);
+    return cmesh;
+  }
+
+  /* We build the trees structure directly, without going through the stash.
+   * Each tree carries the vertices as its only attribute. */
+  t8_cmesh_trees_init (&cmesh->trees, 1, num_trees, 0);
+  t8_cmesh_trees_start_part (cmesh->trees, 0, 0, num_trees, 0, 0, 1);
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    T8_ASSERT (t8_eclass_to_dimension[eclasses[ltree]] == dimension);
+    t8_cmesh_trees_add_tree (cmesh->trees, ltree, 0, eclasses[ltree]);
+    tree = t8_cmesh_trees_get_tree (cmesh->trees, ltree);
+    tree->num_attributes = 1;
+    tree->att_offset =
+      3 * t8_eclass_num_vertices[eclasses[ltree]] * sizeof (double);
+    cmesh->num_trees_per_eclass[eclasses[ltree]]++;
+    cmesh->num_local_trees_per_eclass[eclasses[ltree]]++;
+  }
+  t8_cmesh_trees_finish_part (cmesh->trees, 0);
+  cmesh->num_trees = cmesh->num_local_trees = num_trees;
+  cmesh->first_tree = 0;
+
+  /* Copy the vertices of each tree */
+  attribute.package_id = t8_get_package_id ();
+  attribute.key = 0;
+  attribute.is_owned = 0;
+  for (ltree = 0, vertex_offset = 0; ltree < num_trees; ltree++) {
+    attribute.id = ltree;
+    attribute.attr_size =
+      3 * t8_eclass_num_vertices[eclasses[ltree]] * sizeof (double);
+    attribute.attr_data = (void *) (vertices + vertex_offset);
+    t8_cmesh_trees_add_attribute (cmesh->trees, 0, &attribute, ltree, 0);
+    vertex_offset += 3 * t8_eclass_num_vertices[eclasses[ltree]];
+  }
+
+  /* Set the face connections */
+  t8_cmesh_trees_set_all_boundary (cmesh, cmesh->trees);
+  if (face_neighbors != NULL) {
+    F = t8_eclass_max_num_faces[dimension];
+    for (ltree = 0; ltree < num_trees; ltree++) {
+      (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, ltree,
+                                          &tree_face_neighbors, &tree_ttf);
+      num_faces = t8_eclass_num_faces[eclasses[ltree]];
+      for (iface = 0; iface < num_faces; iface++) {
+        neighbor = face_neighbors[(size_t) ltree * F + iface];
+        if (neighbor >= 0) {
+          T8_ASSERT (neighbor < num_trees);
+          tree_face_neighbors[iface] = neighbor;
+          tree_ttf[iface] = ttf[(size_t) ltree * F + iface];
+        }
+      }
+    }
+  }
+
+  /* The stash is empty, thus commit only finishes the cmesh */
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
 /* TODO: This is just a helper function that was needed when we changed the vertex interface
  *       to use attributes. Before we stored a list of vertex coordinates in the cmesh and each tree indexed into this list.
  *       Now each tree carries the coordinates of its vertices.
@@ -2483,6 +2871,57 @@ t8_cmesh_new_bigmesh (t8_eclass_t eclass, int num_trees, sc_MPI_Comm comm)
   return cmesh;
 }
 
+t8_cmesh_t
+t8_cmesh_new_bigmesh_partitioned (t8_eclass_t eclass, t8_gloidx_t num_trees,
+                                  sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_gloidx_t         first_tree, last_tree, itree, prev_tree, next_tree;
+  int                 mpirank, mpisize, mpiret;
+
+  T8_ASSERT (num_trees > 0);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  /* The local tree range of a uniform level 0 partition */
+  first_tree = (mpirank * num_trees) / mpisize;
+  last_tree = ((mpirank + 1) * num_trees) / mpisize - 1;
+
+  t8_cmesh_init (&cmesh);
+  if (first_tree <= last_tree) {
+    /* Each tree is joined with its successor along faces 0 and 1 as in
+     * t8_cmesh_new_bigmesh. Thus the only ghosts are the predecessor of
+     * the first and the successor of the last local tree. */
+    prev_tree = (first_tree + num_trees - 1) % num_trees;
+    next_tree = (last_tree + 1) % num_trees;
+    for (itree = first_tree; itree <= last_tree; itree++) {
+      t8_cmesh_set_tree_class (cmesh, itree, eclass);
+    }
+    if (t8_eclass_to_dimension[eclass] > 0) {
+      for (itree = first_tree; itree <= last_tree; itree++) {
+        t8_cmesh_set_join (cmesh, itree, (itree + 1) % num_trees, 0, 1, 0);
+      }
+      if (last_tree - first_tree + 1 < num_trees) {
+        /* Not all trees are local, so the neighbors of the range are
+         * ghosts and the join of the predecessor is not set yet. */
+        t8_cmesh_set_tree_class (cmesh, prev_tree, eclass);
+        if (next_tree != prev_tree) {
+          t8_cmesh_set_tree_class (cmesh, next_tree, eclass);
+        }
+        t8_cmesh_set_join (cmesh, prev_tree, first_tree, 0, 1, 0);
+      }
+    }
+  }
+  t8_debugf ("Generating partitioned bigmesh with %lli global trees and"
+             " local trees %lli to %lli.\n", (long long) num_trees,
+             (long long) first_tree, (long long) last_tree);
+  t8_cmesh_set_partition_range (cmesh, 3, first_tree, last_tree);
+  t8_cmesh_commit (cmesh, comm);
+
+  return cmesh;
+}
+
 t8_cmesh_t
 t8_cmesh_new_line_zigzag (sc_MPI_Comm comm)
 {
@@ -0,0 +1,281 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_cmesh_boxes.c
+ *
+ * We compute the bounding boxes of the local trees from their vertices
+ * and sort them into a bounding volume hierarchy.
+ */
+
+#include <t8_cmesh.h>
+#include "t8_cmesh_types.h"
+#include "t8_cmesh_boxes.h"
+
+/* The maximum number of trees in a leaf of the hierarchy */
+#define T8_CMESH_BVH_LEAF_SIZE 4
+
+/* Set a box to be empty, its minimum is larger than its maximum */
+static void
+t8_cmesh_box_set_empty (double box[6])
+{
+  int                 idim;
+
+  for (idim = 0; idim < 3; idim++) {
+    box[idim] = 1;
+    box[3 + idim] = 0;
+  }
+}
+
+static int
+t8_cmesh_box_is_empty (const double box[6])
+{
+  return box[0] > box[3];
+}
+
+/* Enlarge box such that it contains other */
+static void
+t8_cmesh_box_union (double box[6], const double other[6])
+{
+  int                 idim;
+
+  if (t8_cmesh_box_is_empty (other)) {
+    return;
+  }
+  if (t8_cmesh_box_is_empty (box)) {
+    memcpy (box, other, 6 * sizeof (double));
+    return;
+  }
+  for (idim = 0; idim < 3; idim++) {
+    box[idim] = SC_MIN (box[idim], other[idim]);
+    box[3 + idim] = SC_MAX (box[3 + idim], other[3 + idim]);
+  }
+}
+
+/* Compute the box of the vertices of a local tree */
+static void
+t8_cmesh_tree_compute_box (t8_cmesh_t cmesh, t8_locidx_t ltreeid,
+                           double box[6])
+{
+  double             *vertices;
+  int                 ivertex, num_vertices, idim;
+
+  t8_cmesh_box_set_empty (box);
+  vertices = t8_cmesh_get_tree_vertices (cmesh, ltreeid);
+  if (vertices == NULL) {
+    return;
+  }
+  num_vertices =
+    t8_eclass_num_vertices[t8_cmesh_get_tree_class (cmesh, ltreeid)];
+  for (idim = 0; idim < 3; idim++) {
+    box[idim] = box[3 + idim] = vertices[idim];
+  }
+  for (ivertex = 1; ivertex < num_vertices; ivertex++) {
+    for (idim = 0; idim < 3; idim++) {
+      box[idim] = SC_MIN (box[idim], vertices[3 * ivertex + idim]);
+      box[3 + idim] = SC_MAX (box[3 + idim], vertices[3 * ivertex + idim]);
+    }
+  }
+}
+
+/* Build the part of the hierarchy for the trees
+ * tree_order[first], ..., tree_order[first + count - 1] with root node
+ * inode. We split the trees at the mean of their box centers along the
+ * longest axis of the node. */
+static void
+t8_cmesh_bvh_build (t8_cmesh_tree_boxes_struct_t * boxes, int inode,
+                    t8_locidx_t first, t8_locidx_t count)
+{
+  t8_cmesh_bvh_node_t *node = boxes->nodes + inode;
+  t8_locidx_t         itree, left, right, swap;
+  const double       *box;
+  double              split, extent, max_extent;
+  int                 idim, axis;
+
+  node->first = first;
+  node->count = count;
+  node->child = -1;
+  t8_cmesh_box_set_empty (node->box);
+  for (itree = first; itree < first + count; itree++) {
+    t8_cmesh_box_union (node->box,
+                        boxes->boxes + 6 * boxes->tree_order[itree]);
+  }
+  if (count <= T8_CMESH_BVH_LEAF_SIZE || t8_cmesh_box_is_empty (node->box)) {
+    return;
+  }
+  /* Find the longest axis */
+  axis = 0;
+  max_extent = -1;
+  for (idim = 0; idim < 3; idim++) {
+    extent = node->box[3 + idim] - node->box[idim];
+    if (extent > max_extent) {
+      max_extent = extent;
+      axis = idim;
+    }
+  }
+  /* Compute the mean of the centers, empty boxes count as the node center */
+  split = 0;
+  for (itree = first; itree < first + count; itree++) {
+    box = boxes->boxes + 6 * boxes->tree_order[itree];
+    split += t8_cmesh_box_is_empty (box) ?
+      node->box[axis] + node->box[3 + axis] : box[axis] + box[3 + axis];
+  }
+  split /= count;
+  /* Partition the trees at the split coordinate */
+  left = first;
+  right = first + count - 1;
+  while (left <= right) {
+    box = boxes->boxes + 6 * boxes->tree_order[left];
+    if (!t8_cmesh_box_is_empty (box) && box[axis] + box[3 + axis] < split) {
+      left++;
+    }
+    else {
+      swap = boxes->tree_order[left];
+      boxes->tree_order[left] = boxes->tree_order[right];
+      boxes->tree_order[right] = swap;
+      right--;
+    }
+  }
+  if (left == first || left == first + count) {
+    /* All centers coincide, we split in half */
+    left = first + count / 2;
+  }
+  node->child = boxes->num_nodes;
+  boxes->num_nodes += 2;
+  t8_cmesh_bvh_build (boxes, node->child, first, left - first);
+  t8_cmesh_bvh_build (boxes, node->child + 1, left, first + count - left);
+}
+
+t8_cmesh_tree_boxes_struct_t *
+t8_cmesh_tree_boxes_get (t8_cmesh_t cmesh)
+{
+  t8_cmesh_tree_boxes_struct_t *boxes;
+  t8_locidx_t         itree;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  if (cmesh->tree_boxes != NULL) {
+    return cmesh->tree_boxes;
+  }
+  boxes = cmesh->tree_boxes = T8_ALLOC (t8_cmesh_tree_boxes_struct_t, 1);
+  boxes->num_trees = cmesh->num_local_trees;
+  boxes->boxes = T8_ALLOC (double, 6 * boxes->num_trees);
+  boxes->tree_order = T8_ALLOC (t8_locidx_t, boxes->num_trees);
+  for (itree = 0; itree < boxes->num_trees; itree++) {
+    t8_cmesh_tree_compute_box (cmesh, itree, boxes->boxes + 6 * itree);
+    boxes->tree_order[itree] = itree;
+  }
+  /* A binary tree with n leafs of at least one tree has at most
+   * 2n - 1 nodes */
+  boxes->nodes = T8_ALLOC (t8_cmesh_bvh_node_t,
+                           SC_MAX (1, 2 * boxes->num_trees));
+  boxes->num_nodes = 1;
+  t8_cmesh_bvh_build (boxes, 0, 0, boxes->num_trees);
+  return boxes;
+}
+
+void
+t8_cmesh_tree_boxes_destroy (t8_cmesh_tree_boxes_struct_t ** pboxes)
+{
+  t8_cmesh_tree_boxes_struct_t *boxes;
+
+  T8_ASSERT (pboxes != NULL);
+  boxes = *pboxes;
+  T8_ASSERT (boxes != NULL);
+  T8_FREE (boxes->boxes);
+  T8_FREE (boxes->tree_order);
+  T8_FREE (boxes->nodes);
+  T8_FREE (boxes);
+  *pboxes = NULL;
+}
+
+int
+t8_cmesh_get_tree_bounding_box (t8_cmesh_t cmesh, t8_locidx_t ltreeid,
+                                double box[6])
+{
+  t8_cmesh_tree_boxes_struct_t *boxes;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (0 <= ltreeid && ltreeid < cmesh->num_local_trees);
+  boxes = t8_cmesh_tree_boxes_get (cmesh);
+  memcpy (box, boxes->boxes + 6 * ltreeid, 6 * sizeof (double));
+  return !t8_cmesh_box_is_empty (box);
+}
+
+/* Return true if a point lies in a box enlarged by tolerance */
+static int
+t8_cmesh_box_contains (const double box[6], const double point[3],
+                       double tolerance)
+{
+  int                 idim;
+
+  for (idim = 0; idim < 3; idim++) {
+    if (point[idim] < box[idim] - tolerance
+        || point[idim] > box[3 + idim] + tolerance) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void
+t8_cmesh_find_trees_at_point (t8_cmesh_t cmesh, const double point[3],
+                              double tolerance, sc_array_t * ltreeids)
+{
+  t8_cmesh_tree_boxes_struct_t *boxes;
+  t8_cmesh_bvh_node_t *node;
+  sc_array_t          stack;
+  t8_locidx_t         itree, ltreeid;
+  int                 inode;
+
+  T8_ASSERT (ltreeids != NULL);
+  T8_ASSERT (ltreeids->elem_size == sizeof (t8_locidx_t));
+  boxes = t8_cmesh_tree_boxes_get (cmesh);
+  if (boxes->num_trees == 0) {
+    return;
+  }
+  /* Traverse the hierarchy depth first */
+  sc_array_init (&stack, sizeof (int));
+  *(int *) sc_array_push (&stack) = 0;
+  while (stack.elem_count > 0) {
+    inode = *(int *) sc_array_pop (&stack);
+    node = boxes->nodes + inode;
+    if (t8_cmesh_box_is_empty (node->box)
+        || !t8_cmesh_box_contains (node->box, point, tolerance)) {
+      continue;
+    }
+    if (node->child >= 0) {
+      /* Push the second child first, such that the trees are found in
+       * the order of the hierarchy */
+      *(int *) sc_array_push (&stack) = node->child + 1;
+      *(int *) sc_array_push (&stack) = node->child;
+      continue;
+    }
+    for (itree = node->first; itree < node->first + node->count; itree++) {
+      ltreeid = boxes->tree_order[itree];
+      if (!t8_cmesh_box_is_empty (boxes->boxes + 6 * ltreeid)
+          && t8_cmesh_box_contains (boxes->boxes + 6 * ltreeid, point,
+                                    tolerance)) {
+        *(t8_locidx_t *) sc_array_push (ltreeids) = ltreeid;
+      }
+    }
+  }
+  sc_array_reset (&stack);
+}
@@ -0,0 +1,78 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_cmesh_boxes.h
+ *
+ * Bounding boxes of the local trees of a cmesh and a bounding volume
+ * hierarchy over them. They are built on first use.
+ */
+
+#ifndef T8_CMESH_BOXES_H
+#define T8_CMESH_BOXES_H
+
+#include <t8.h>
+#include <t8_cmesh.h>
+
+/** A node of the bounding volume hierarchy of the trees of a cmesh. */
+typedef struct
+{
+  double              box[6];   /**< The bounding box of all trees below this node,
+                                     the minimum coordinates followed by the maximum coordinates. */
+  t8_locidx_t         first;    /**< The first index in \a tree_order of the trees below this node. */
+  t8_locidx_t         count;    /**< The number of trees below this node. */
+  int                 child;    /**< The index of the first child node, the second child
+                                     follows it. -1 if this node is a leaf. */
+}
+t8_cmesh_bvh_node_t;
+
+/** The bounding boxes of the local trees of a cmesh. */
+typedef struct t8_cmesh_tree_boxes
+{
+  t8_locidx_t         num_trees;        /**< The number of local trees. */
+  double             *boxes;    /**< For each local tree 6 doubles, its bounding box.
+                                     The box of a tree without vertices is empty,
+                                     such that its minimum is larger than its maximum. */
+  t8_locidx_t        *tree_order;       /**< The local trees ordered such that the trees
+                                             of each node of the hierarchy are consecutive. */
+  t8_cmesh_bvh_node_t *nodes;   /**< The nodes of the hierarchy, the root is the first one. */
+  int                 num_nodes;        /**< The number of nodes. */
+}
+t8_cmesh_tree_boxes_struct_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Return the tree boxes of a cmesh and build them if they do not exist.
+ * \param [in,out] cmesh  A committed cmesh.
+ * \return                The tree boxes of \a cmesh.
+ * \note Building the boxes is not thread safe.
+ */
+t8_cmesh_tree_boxes_struct_t *t8_cmesh_tree_boxes_get (t8_cmesh_t cmesh);
+
+/** Free the memory of tree boxes.
+ * \param [in,out] pboxes A pointer to the tree boxes. Set to NULL on output.
+ */
+void                t8_cmesh_tree_boxes_destroy (t8_cmesh_tree_boxes_struct_t
+                                                 ** pboxes);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_CMESH_BOXES_H */
@@ -35,42 +35,87 @@
 #include <t8_cmesh/t8_cmesh_partition.h>
 #include <t8_cmesh/t8_cmesh_refine.h>
 #include <t8_cmesh/t8_cmesh_copy.h>
+#include <t8_profile_regions.h>
+#ifdef T8_WITH_METIS
+#include <metis.h>
+#endif
 
-typedef struct ghost_facejoins_struct
-{
-  t8_gloidx_t         ghost_id; /* The id of the ghost */
-  t8_locidx_t         local_id; /* The local id of the ghost */
-} t8_ghost_facejoin_t;
-
+/* Compare two global ids */
 static int
-t8_ghost_facejoins_compare (const void *fj1, const void *fj2)
+t8_cmesh_commit_gloidx_compare (const void *id1, const void *id2)
 {
-  struct ghost_facejoins_struct *FJ1 = (struct ghost_facejoins_struct *) fj1;
-  struct ghost_facejoins_struct *FJ2 = (struct ghost_facejoins_struct *) fj2;
+  t8_gloidx_t         a = *(const t8_gloidx_t *) id1;
+  t8_gloidx_t         b = *(const t8_gloidx_t *) id2;
 
-  return FJ1->ghost_id < FJ2->ghost_id ? -1 : FJ1->ghost_id != FJ2->ghost_id;
+  return a < b ? -1 : a != b;
 }
 
-static int
-t8_ghost_facejoin_equal (const void *v1, const void *v2, const void *u)
+/* Sort an array of non-negative global ids and remove duplicates.
+ * We use a least significant digit radix sort with 8 bit digits and only
+ * sort by as many digits as the largest id needs, so this is linear in
+ * the number of ids. Small arrays are sorted with qsort.
+ * Returns the number of unique ids. */
+static size_t
+t8_cmesh_commit_sort_unique_ids (t8_gloidx_t * ids, size_t num_ids)
 {
-  return t8_ghost_facejoins_compare (v1, v2) == 0;
+  t8_gloidx_t        *buffer, *in, *out, *swap, max_id = 0;
+  size_t              counts[256], iz, num_unique, sum, count;
+  int                 shift, digit;
+
+  if (num_ids < 256) {
+    qsort (ids, num_ids, sizeof (t8_gloidx_t),
+           t8_cmesh_commit_gloidx_compare);
+  }
+  else {
+    for (iz = 0; iz < num_ids; iz++) {
+      T8_ASSERT (ids[iz] >= 0);
+      max_id = SC_MAX (max_id, ids[iz]);
+    }
+    buffer = T8_ALLOC (t8_gloidx_t, num_ids);
+    in = ids;
+    out = buffer;
+    for (shift = 0; shift == 0 || (max_id >> shift) > 0; shift += 8) {
+      memset (counts, 0, sizeof (counts));
+      for (iz = 0; iz < num_ids; iz++) {
+        counts[(in[iz] >> shift) & 0xff]++;
+      }
+      for (digit = 0, sum = 0; digit < 256; digit++) {
+        count = counts[digit];
+        counts[digit] = sum;
+        sum += count;
+      }
+      for (iz = 0; iz < num_ids; iz++) {
+        out[counts[(in[iz] >> shift) & 0xff]++] = in[iz];
+      }
+      swap = in;
+      in = out;
+      out = swap;
+    }
+    if (in != ids) {
+      memcpy (ids, in, num_ids * sizeof (t8_gloidx_t));
+    }
+    T8_FREE (buffer);
+  }
+  for (iz = 0, num_unique = 0; iz < num_ids; iz++) {
+    if (num_unique == 0 || ids[num_unique - 1] != ids[iz]) {
+      ids[num_unique++] = ids[iz];
+    }
+  }
+  return num_unique;
 }
 
-/* The hash value for a ghost is
- * global_id % num_local_trees
- *
- * This hash function gets as input a facejoins_struct
- * and as user data the number of hashs, which is the number of local trees if
- * nonzero and 10 otherwise.
- */
-static unsigned
-t8_ghost_hash (const void *v, const void *u)
+/* Return the local id of a ghost, given the sorted global ids of all
+ * ghosts, or -1 if the tree is not a ghost. */
+static              t8_locidx_t
+t8_cmesh_commit_find_ghost (const t8_gloidx_t * ghost_ids,
+                            t8_locidx_t num_ghosts, t8_gloidx_t global_id)
 {
-  t8_gloidx_t         ghost_id = ((t8_ghost_facejoin_t *) v)->ghost_id;
-  t8_locidx_t         num_hashs = *((t8_locidx_t *) u);
+  const t8_gloidx_t  *found;
 
-  return ghost_id % num_hashs;
+  found = (const t8_gloidx_t *) bsearch (&global_id, ghost_ids, num_ghosts,
+                                         sizeof (t8_gloidx_t),
+                                         t8_cmesh_commit_gloidx_compare);
+  return found == NULL ? -1 : (t8_locidx_t) (found - ghost_ids);
 }
 
 static void
@@ -195,15 +240,11 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   sc_statinfo_t       stats[3];
 #endif
 
-  sc_hash_t          *ghost_ids;
-  sc_mempool_t       *ghost_facejoin_mempool;
-  struct ghost_facejoins_struct *ghost_facejoin = NULL, *temp_facejoin,
-    **facejoin_pp;
-  size_t              joinfaces_it, iz;
+  t8_gloidx_t        *ghost_ids;
+  size_t              joinfaces_it, iz, num_ghost_ids;
   t8_gloidx_t         last_tree = cmesh->num_local_trees +
     cmesh->first_tree - 1, id1, id2;
-  t8_locidx_t         temp_local_id = 0;
-  t8_locidx_t         num_hashs;
+  t8_locidx_t         temp_local_id = 0, temp_local_id2 = 0;
   t8_gloidx_t        *face_neigh_g, *face_neigh_g2;
   t8_stash_class_struct_t *classentry;
   int                 id1_istree, id2_istree;
@@ -248,19 +289,11 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   T8_ASSERT (cmesh->first_tree >= 0);
   T8_ASSERT (cmesh->first_tree_shared >= 0);
 
-  num_hashs = cmesh->num_local_trees > 0 ? cmesh->num_local_trees : 10;
-  ghost_facejoin_mempool = sc_mempool_new (sizeof (t8_ghost_facejoin_t));
-  /* TODO: There could be a mayor bug here, since the mempool given to
-   * sc_hash_new should actually allocate sc_link_t objects and not the
-   * data objects. */
-  ghost_ids = sc_hash_new (t8_ghost_hash, t8_ghost_facejoin_equal,
-                           &num_hashs, NULL);
-
-  temp_facejoin =
-    (t8_ghost_facejoin_t *) sc_mempool_alloc (ghost_facejoin_mempool);
-
-  cmesh->num_ghosts = 0;
-  /* Parse joinfaces array and save all global id of local ghosts, and assign them a local id */
+  /* Parse joinfaces array and collect the global ids of all local ghosts.
+   * We sort them afterwards and a ghost's local id is its position in
+   * the sorted array, thus we do not need a hash table to look them up. */
+  ghost_ids = T8_ALLOC (t8_gloidx_t, cmesh->stash->joinfaces.elem_count + 1);
+  num_ghost_ids = 0;
   for (joinfaces_it = 0; joinfaces_it < cmesh->stash->joinfaces.elem_count;
        joinfaces_it++) {
     joinface =
@@ -270,32 +303,19 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
     id2 = joinface->id2;
     id2_istree = id2 <= last_tree && id2 >= cmesh->first_tree;
     id1_istree = id1 <= last_tree && id1 >= cmesh->first_tree;
-    if (id1_istree || id2_istree) {
-      /* Only consider facejoins with local trees involved to get the global
-       * ids of all local ghosts. */
-      if (!id2_istree) {
-        /* id2 is a ghost */
-        temp_facejoin->ghost_id = id2;
-        if (sc_hash_insert_unique (ghost_ids, temp_facejoin, NULL)) {
-          /* If we did not already stored id2 in the hash we do so and assign the next local ghost id */
-          temp_facejoin->local_id = cmesh->num_ghosts++;
-          temp_facejoin = (t8_ghost_facejoin_t *)
-            sc_mempool_alloc (ghost_facejoin_mempool);
-        }
-      }
-      if (!id1_istree) {
-        /* id1 is a ghost */
-        T8_ASSERT (id2_istree);
-        temp_facejoin->ghost_id = id1;
-        if (sc_hash_insert_unique (ghost_ids, temp_facejoin, NULL)) {
-          /* If we did not already stored id1 in the hash we do so and assign the next local ghost id */
-          temp_facejoin->local_id = cmesh->num_ghosts++;
-          temp_facejoin = (t8_ghost_facejoin_t *)
-            sc_mempool_alloc (ghost_facejoin_mempool);
-        }
-      }
+    /* Only consider facejoins with local trees involved to get the global
+     * ids of all local ghosts. */
+    if (id1_istree && !id2_istree) {
+      /* id2 is a ghost */
+      ghost_ids[num_ghost_ids++] = id2;
+    }
+    else if (!id1_istree && id2_istree) {
+      /* id1 is a ghost */
+      ghost_ids[num_ghost_ids++] = id1;
     }
   }
+  num_ghost_ids = t8_cmesh_commit_sort_unique_ids (ghost_ids, num_ghost_ids);
+  cmesh->num_ghosts = (t8_locidx_t) num_ghost_ids;
 
 #if T8_ENABLE_DEBUG
   sc_flops_shot (&fi, &snapshot);
@@ -325,13 +345,10 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
     /* Only do something if the partition is not empty */
     /* TODO: optimize if non-hybrid mesh */
     /* Iterate through classes and add ghosts and trees */
-    /* We need a temporary ghost_facejoin to check the hash for existing global ids */
-    temp_facejoin->local_id = -10;
     for (iz = 0; iz < cmesh->stash->classes.elem_count; iz++) {
       /* get class and tree id */
       classentry = (t8_stash_class_struct_t *)
         sc_array_index (&cmesh->stash->classes, iz);
-      temp_facejoin->ghost_id = classentry->id;
       if (cmesh->first_tree <= classentry->id && classentry->id <= last_tree) {
         /* initialize tree */
         t8_cmesh_trees_add_tree (cmesh->trees,
@@ -340,13 +357,13 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
         cmesh->num_local_trees_per_eclass[classentry->eclass]++;
       }
       else {
-        if (sc_hash_lookup (ghost_ids, temp_facejoin,
-                            (void ***) &facejoin_pp)) {
+        temp_local_id = t8_cmesh_commit_find_ghost (ghost_ids,
+                                                    cmesh->num_ghosts,
+                                                    classentry->id);
+        if (temp_local_id >= 0) {
           /* The classentry belongs to a local ghost */
-          ghost_facejoin = *facejoin_pp;
-          t8_cmesh_trees_add_ghost (cmesh->trees, ghost_facejoin->local_id,
-                                    ghost_facejoin->ghost_id, 0,
-                                    classentry->eclass,
+          t8_cmesh_trees_add_ghost (cmesh->trees, temp_local_id,
+                                    classentry->id, 0, classentry->eclass,
                                     cmesh->num_local_trees);
         }
       }
@@ -384,7 +401,6 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
       id2 = joinface->id2;
       id1_istree = cmesh->first_tree <= id1 && last_tree >= id1;
       id2_istree = cmesh->first_tree <= id2 && last_tree >= id2;
-      temp_facejoin->ghost_id = id1;
       tree1 = NULL;
 #if T8_ENABLE_DEBUG
       ghost1 = NULL;
@@ -407,26 +423,22 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
                                              cmesh->first_tree, &face_neigh,
                                              &ttf);
       }
-      else if (sc_hash_lookup (ghost_ids, temp_facejoin,
-                               (void ***) &facejoin_pp)) {
+      else if ((temp_local_id =
+                t8_cmesh_commit_find_ghost (ghost_ids, cmesh->num_ghosts,
+                                            id1)) >= 0) {
         /* id1 is a local ghost */
-        ghost_facejoin = *facejoin_pp;
 #if T8_ENABLE_DEBUG
-        ghost1 = t8_cmesh_trees_get_ghost_ext (cmesh->trees,
-                                               ghost_facejoin->local_id,
+        ghost1 = t8_cmesh_trees_get_ghost_ext (cmesh->trees, temp_local_id,
                                                &face_neigh_g, &ttf);
 #else
-        (void) t8_cmesh_trees_get_ghost_ext (cmesh->trees,
-                                             ghost_facejoin->local_id,
+        (void) t8_cmesh_trees_get_ghost_ext (cmesh->trees, temp_local_id,
                                              &face_neigh_g, &ttf);
 #endif
-        temp_local_id = ghost_facejoin->local_id;
       }
 #if T8_ENABLE_DEBUG
       ghost2 = NULL;
 #endif
       tree2 = NULL;
-      temp_facejoin->ghost_id = joinface->id2;
       if (id2_istree) {
         /* Second tree in the connection is a local tree */
         tree2 = t8_cmesh_trees_get_tree_ext (cmesh->trees,
@@ -434,17 +446,15 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
                                              cmesh->first_tree, &face_neigh2,
                                              &ttf2);
       }
-      else if (sc_hash_lookup (ghost_ids, temp_facejoin,
-                               (void ***) &facejoin_pp)) {
-        /* id1 is a local ghost */
-        ghost_facejoin = *facejoin_pp;
+      else if ((temp_local_id2 =
+                t8_cmesh_commit_find_ghost (ghost_ids, cmesh->num_ghosts,
+                                            id2)) >= 0) {
+        /* id2 is a local ghost */
 #if T8_ENABLE_DEBUG
-        ghost2 = t8_cmesh_trees_get_ghost_ext (cmesh->trees,
-                                               ghost_facejoin->local_id,
+        ghost2 = t8_cmesh_trees_get_ghost_ext (cmesh->trees, temp_local_id2,
                                                &face_neigh_g2, &ttf2);
 #else
-        (void) t8_cmesh_trees_get_ghost_ext (cmesh->trees,
-                                             ghost_facejoin->local_id,
+        (void) t8_cmesh_trees_get_ghost_ext (cmesh->trees, temp_local_id2,
                                              &face_neigh_g2, &ttf2);
 #endif
       }
@@ -457,7 +467,7 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
           T8_ASSERT (ghost2 != NULL || tree2 != NULL);
           face_neigh[joinface->face1] =
             tree2 ? id2 - cmesh->first_tree :
-            ghost_facejoin->local_id + cmesh->num_local_trees;
+            temp_local_id2 + cmesh->num_local_trees;
         }
         else {
           /* First entry is a ghost */
@@ -483,12 +493,7 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
       /* Done with setting face join */
     }
 
-    /* Add attributes */
-    /* TODO: attribute is required to be sorted right now. Think this over
-     *       if we cant work around it, at least use the sorted array above when
-     *       counting the attributes per tree. */
-
-    t8_stash_attribute_sort (cmesh->stash);
+    /* Add attributes, they were already sorted at the beginning */
     t8_cmesh_add_attributes (cmesh);
 
     /* compute global number of trees. id1 serves as buffer since
@@ -496,9 +501,7 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 
   }                             /* End if nonempty partition */
 
-  sc_mempool_free (ghost_facejoin_mempool, temp_facejoin);
-  sc_hash_destroy (ghost_ids);
-  sc_mempool_destroy (ghost_facejoin_mempool);
+  T8_FREE (ghost_ids);
 
   id1 = cmesh->num_local_trees;
   sc_MPI_Allreduce (&id1, &cmesh->num_trees, 1, T8_MPI_GLOIDX,
@@ -512,6 +515,187 @@ t8_cmesh_commit_partitioned_new (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 #endif
 }
 
+#ifdef T8_WITH_METIS
+static int
+t8_cmesh_commit_idx_compare (const void *idx1, const void *idx2)
+{
+  idx_t               a = *(const idx_t *) idx1;
+  idx_t               b = *(const idx_t *) idx2;
+
+  return a < b ? -1 : a != b;
+}
+
+/* Partition the face graph of the trees in the stash of a replicated cmesh
+ * into mpisize parts and compute the new global id of each tree, such that
+ * the trees of each part are numbered consecutively.
+ * The partition is computed on rank 0, which stores the resulting edge cut
+ * in edgecut, and broadcast to the other processes. */
+static void
+t8_cmesh_commit_reorder_ids (t8_stash_t stash, t8_gloidx_t * new_id,
+                             idx_t num_trees, int mpisize, int mpirank,
+                             idx_t * edgecut, sc_MPI_Comm comm)
+{
+  t8_stash_joinface_struct_t *joinface;
+  idx_t              *xadj, *adjncy, *adjwgt, *degree, *part;
+  idx_t               options[METIS_NOPTIONS];
+  idx_t               ncon = 1, nparts = mpisize;
+  idx_t               itree, ineigh, istart, iend, num_entries;
+  t8_gloidx_t        *part_offset;
+  size_t              iz;
+  int                 mpiret, success;
+
+  *edgecut = 0;
+  if (mpirank == 0) {
+    /* xadj and adjncy store the face connections in CSR format.
+     * Self connections of periodic trees are no edges of the graph. */
+    xadj = T8_ALLOC_ZERO (idx_t, num_trees + 1);
+    for (iz = 0; iz < stash->joinfaces.elem_count; iz++) {
+      joinface = (t8_stash_joinface_struct_t *)
+        sc_array_index (&stash->joinfaces, iz);
+      if (joinface->id1 != joinface->id2) {
+        xadj[joinface->id1 + 1]++;
+        xadj[joinface->id2 + 1]++;
+      }
+    }
+    for (itree = 0; itree < num_trees; itree++) {
+      xadj[itree + 1] += xadj[itree];
+    }
+    adjncy = T8_ALLOC (idx_t, SC_MAX (xadj[num_trees], 1));
+    adjwgt = T8_ALLOC (idx_t, SC_MAX (xadj[num_trees], 1));
+    degree = T8_ALLOC_ZERO (idx_t, num_trees);
+    for (iz = 0; iz < stash->joinfaces.elem_count; iz++) {
+      joinface = (t8_stash_joinface_struct_t *)
+        sc_array_index (&stash->joinfaces, iz);
+      if (joinface->id1 != joinface->id2) {
+        adjncy[xadj[joinface->id1] + degree[joinface->id1]++] =
+          joinface->id2;
+        adjncy[xadj[joinface->id2] + degree[joinface->id2]++] =
+          joinface->id1;
+      }
+    }
+    T8_FREE (degree);
+    /* Two trees can be connected via multiple faces. Since METIS does not
+     * allow multiple edges, we merge them to one edge whose weight is the
+     * number of faces. Thus, the edge cut is the number of cut faces. */
+    for (itree = 0, istart = 0, num_entries = 0; itree < num_trees; itree++) {
+      iend = xadj[itree + 1];
+      qsort (adjncy + istart, iend - istart, sizeof (idx_t),
+             t8_cmesh_commit_idx_compare);
+      for (ineigh = istart; ineigh < iend; ineigh++) {
+        if (num_entries > xadj[itree]
+            && adjncy[num_entries - 1] == adjncy[ineigh]) {
+          adjwgt[num_entries - 1]++;
+        }
+        else {
+          adjncy[num_entries] = adjncy[ineigh];
+          adjwgt[num_entries] = 1;
+          num_entries++;
+        }
+      }
+      istart = iend;
+      xadj[itree + 1] = num_entries;
+    }
+
+    METIS_SetDefaultOptions (options);
+    options[METIS_OPTION_NUMBERING] = 0;
+    part = T8_ALLOC (idx_t, num_trees);
+    success = METIS_PartGraphKway (&num_trees, &ncon, xadj, adjncy, NULL,
+                                   NULL, adjwgt, &nparts, NULL, NULL,
+                                   options, edgecut, part);
+    SC_CHECK_ABORT (success == METIS_OK,
+                    "METIS failed to partition the coarse mesh.\n");
+
+    /* Number the trees of each part consecutively */
+    part_offset = T8_ALLOC_ZERO (t8_gloidx_t, mpisize + 1);
+    for (itree = 0; itree < num_trees; itree++) {
+      part_offset[part[itree] + 1]++;
+    }
+    for (itree = 0; itree < mpisize; itree++) {
+      part_offset[itree + 1] += part_offset[itree];
+    }
+    for (itree = 0; itree < num_trees; itree++) {
+      new_id[itree] = part_offset[part[itree]]++;
+    }
+    T8_FREE (part_offset);
+    T8_FREE (part);
+    T8_FREE (xadj);
+    T8_FREE (adjncy);
+    T8_FREE (adjwgt);
+  }
+  mpiret = sc_MPI_Bcast (new_id, num_trees, T8_MPI_GLOIDX, 0, comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Reorder the trees in the stash of a replicated cmesh, such that
+ * the trees in each part of a graph partition of the face connections
+ * have consecutive global ids. */
+static void
+t8_cmesh_commit_reorder_stash (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  t8_stash_t          stash = cmesh->stash;
+  t8_stash_class_struct_t *classentry;
+  t8_stash_joinface_struct_t *joinface;
+  t8_stash_attribute_struct_t *attribute;
+  t8_gloidx_t        *new_id, temp_id;
+  idx_t               num_trees, edgecut;
+  size_t              iz;
+  int                 temp_face;
+
+  T8_ASSERT (stash != NULL);
+  T8_ASSERT (!cmesh->set_partition);
+
+  num_trees = (idx_t) stash->classes.elem_count;
+  T8_ASSERT ((size_t) num_trees == stash->classes.elem_count);
+  if (cmesh->mpisize == 1 || num_trees <= 1) {
+    /* There is only one part, we keep the order */
+    return;
+  }
+#ifdef T8_ENABLE_DEBUG
+  for (iz = 0; iz < stash->classes.elem_count; iz++) {
+    classentry = (t8_stash_class_struct_t *)
+      sc_array_index (&stash->classes, iz);
+    T8_ASSERT (0 <= classentry->id && classentry->id < num_trees);
+  }
+#endif
+
+  new_id = T8_ALLOC (t8_gloidx_t, num_trees);
+  t8_cmesh_commit_reorder_ids (stash, new_id, num_trees, cmesh->mpisize,
+                               cmesh->mpirank, &edgecut, comm);
+  t8_global_productionf ("Reordered %lli trees for %i processes with an "
+                         "edge cut of %lli faces.\n", (long long) num_trees,
+                         cmesh->mpisize, (long long) edgecut);
+
+  /* Change the ids of all stash entries to the new ids */
+  for (iz = 0; iz < stash->classes.elem_count; iz++) {
+    classentry = (t8_stash_class_struct_t *)
+      sc_array_index (&stash->classes, iz);
+    classentry->id = new_id[classentry->id];
+  }
+  for (iz = 0; iz < stash->joinfaces.elem_count; iz++) {
+    joinface = (t8_stash_joinface_struct_t *)
+      sc_array_index (&stash->joinfaces, iz);
+    joinface->id1 = new_id[joinface->id1];
+    joinface->id2 = new_id[joinface->id2];
+    if (joinface->id1 > joinface->id2) {
+      /* We ensure id1 <= id2, see t8_stash_add_facejoin */
+      temp_id = joinface->id1;
+      joinface->id1 = joinface->id2;
+      joinface->id2 = temp_id;
+      temp_face = joinface->face1;
+      joinface->face1 = joinface->face2;
+      joinface->face2 = temp_face;
+    }
+  }
+  for (iz = 0; iz < stash->attributes.elem_count; iz++) {
+    attribute = (t8_stash_attribute_struct_t *)
+      sc_array_index (&stash->attributes, iz);
+    attribute->id = new_id[attribute->id];
+  }
+  t8_stash_class_sort (stash);
+  T8_FREE (new_id);
+}
+#endif
+
 void
 t8_cmesh_commit_from_stash (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 {
@@ -528,64 +712,21 @@ t8_cmesh_commit_from_stash (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 }
 
 /* Refine a cmesh to an arbitrary level >= 0.
- * The function t8_cmesh_refine can only refine a cmesh one level,
- * so we use intermediate cmeshes for the higher levels.
+ * t8_cmesh_refine computes all levels at once.
  * If the level is 0 then we only copy the cmesh. */
 static void
 t8_cmesh_commit_refine (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 {
-  int                 level, il;
-  t8_cmesh_t          cmesh_temp[2], cmesh_from;
   T8_ASSERT (t8_cmesh_is_initialized (cmesh));
   T8_ASSERT (!cmesh->committed);
   T8_ASSERT (t8_cmesh_is_committed (cmesh->set_from));
   T8_ASSERT (cmesh->set_refine_level >= 0);
 
-  cmesh_from = cmesh->set_from;
-  level = cmesh->set_refine_level;
-
-  if (level == 0) {
-    t8_cmesh_copy (cmesh, cmesh_from, comm);
+  if (cmesh->set_refine_level == 0) {
+    t8_cmesh_copy (cmesh, cmesh->set_from, comm);
     return;
   }
-
-  if (level > 1) {
-    /* We need cmesh_from later, therefore we ref it before
-     * a temporary cmesh is derived from it */
-    t8_cmesh_ref (cmesh_from);
-    cmesh_temp[1] = cmesh_from;
-  }
-
-  /* This loop is only executed if level > 1 */
-  for (il = 0; il < level - 1; il++) {
-    /* cmesh_temp[0] and cmesh_temp[1] are successively refined from each other,
-     * starting with cmesh_temp[1] = cmesh_from */
-    t8_cmesh_init (&cmesh_temp[il % 2]);
-    t8_cmesh_set_derive (cmesh_temp[il % 2], cmesh_temp[1 - il % 2]);
-    /* Since we need the scheme to refine cmesh, we ref it */
-    t8_scheme_cxx_ref (cmesh->set_refine_scheme);
-    t8_cmesh_set_refine (cmesh_temp[il % 2], 1, cmesh->set_refine_scheme);
-    t8_cmesh_commit (cmesh_temp[il % 2], comm);
-    t8_debugf ("[%i] Commited %i\n", level, il % 2);
-  }
-  if (level > 1) {
-    /* Refine from the last temporary cmesh */
-    cmesh->set_from = cmesh_temp[1 - il % 2];
-    /* t8_cmesh_refine only accepts refinement level 1, so we
-     * set it temporarily. */
-    cmesh->set_refine_level = 1;
-  }
   t8_cmesh_refine (cmesh);
-  if (level > 1) {
-    /* reset the refinement level and
-     * cmesh_from. */
-    cmesh->set_refine_level = level;
-    /* Clean-up memory and restore old cmesh_from */
-    if (cmesh->set_from != cmesh_from) {
-      t8_cmesh_destroy (&cmesh->set_from);
-      cmesh->set_from = cmesh_from;
-    }
-  }
 }
 
 /* TODO: set boundary face connections here.
@@ -607,7 +748,10 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   SC_CHECK_ABORT (0 <= cmesh->dimension
                   && cmesh->dimension <= T8_ECLASS_MAX_DIM,
                   "Dimension of the cmesh is not set properly.\n");
+  SC_CHECK_ABORT (!cmesh->set_reorder || cmesh->set_from == NULL,
+                  "Only a cmesh built from scratch can be reordered.\n");
 
+  t8_profile_region_begin ("cmesh_commit");
   /* If profiling is enabled, we measure the runtime of  commit. */
   if (cmesh->profile != NULL) {
     cmesh->profile->commit_runtime = sc_MPI_Wtime ();
@@ -670,6 +814,13 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   }                             /* End set_from != NULL */
   else {
     /* cmesh is constructed from a stash */
+#ifdef T8_WITH_METIS
+    if (cmesh->set_reorder) {
+      SC_CHECK_ABORT (!cmesh->set_partition,
+                      "A partitioned cmesh cannot be reordered.\n");
+      t8_cmesh_commit_reorder_stash (cmesh, comm);
+    }
+#endif
     if (cmesh->set_refine_level > 0) {
       /* cmesh should be refined */
       t8_cmesh_init (&cmesh_temp);
@@ -702,8 +853,28 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
     }
   }
 
+  if (cmesh->set_from != NULL && cmesh->set_refine_level == 0
+      && cmesh->tree_geometry == NULL
+      && cmesh->set_from->tree_geometry != NULL) {
+    /* A partitioned or copied cmesh has the same trees as set_from,
+     * thus it keeps their geometry */
+    t8_geometry_ref (cmesh->set_from->tree_geometry);
+    t8_cmesh_set_tree_geometry (cmesh, cmesh->set_from->tree_geometry);
+  }
+
+  if (cmesh->trees != NULL) {
+    /* Sort the ghost map once, such that lookups do not modify the cmesh */
+    t8_cmesh_trees_sort_ghost_map (cmesh->trees);
+  }
   cmesh->committed = 1;
 
+  if (cmesh->set_node_shared && !cmesh->set_partition) {
+    /* Store the replicated trees once per node */
+    t8_cmesh_trees_share (cmesh->trees, comm);
+  }
+  t8_cmesh_trees_build_face_arrays (cmesh->trees, cmesh->num_local_trees,
+                                    cmesh->dimension);
+
   /* Compute trees_per_eclass */
   t8_cmesh_gather_trees_per_eclass (cmesh, comm);
 
@@ -743,4 +914,10 @@ t8_cmesh_commit (t8_cmesh_t cmesh, sc_MPI_Comm comm)
     cmesh->profile->first_tree_shared = cmesh->first_tree_shared
       * cmesh->mpisize;
   }
+  t8_profile_region_end ("cmesh_commit");
+  if (cmesh->profile != NULL) {
+    t8_profile_regions_last_hw_counters (cmesh->profile->commit_hw_counters);
+    cmesh->profile->commit_memory_peak =
+      t8_profile_regions_last_memory_peak ();
+  }
 }
@@ -0,0 +1,548 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_cmesh_faces.c
+ * We find the face connections of a partitioned cmesh from the vertex ids
+ * of its trees. Each face is sent to a process determined by its vertices,
+ * where it is matched with its neighbor face. The face connections are then
+ * sent to the owners of the trees.
+ */
+
+#include <t8_eclass.h>
+#include "t8_cmesh_types.h"
+#include "t8_cmesh_faces.h"
+
+/* A face that is sent to the process that matches it with
+ * its neighbor face */
+typedef struct
+{
+  t8_gloidx_t         tree_id;
+  t8_gloidx_t         vertices[4];      /* The vertices in the order of the face */
+  t8_gloidx_t         key[4];   /* The vertices in ascending order. */
+  int8_t              face_number;
+  int8_t              eclass;   /* The eclass of the tree */
+  int8_t              num_vertices;
+} t8_cmesh_faces_face_t;
+
+/* A face connection between two trees as passed to t8_cmesh_set_join */
+typedef struct
+{
+  t8_gloidx_t         tree_ids[2];
+  int8_t              faces[2];
+  int8_t              eclasses[2];
+  int8_t              orientation;
+} t8_cmesh_faces_join_t;
+
+/* A ghost tree together with its eclass */
+typedef struct
+{
+  t8_gloidx_t         tree_id;
+  t8_eclass_t         eclass;
+} t8_cmesh_faces_ghost_t;
+
+/* Compare two vertex ids */
+static int
+t8_cmesh_faces_gloidx_compare (const void *a, const void *b)
+{
+  const t8_gloidx_t   ga = *(const t8_gloidx_t *) a;
+  const t8_gloidx_t   gb = *(const t8_gloidx_t *) b;
+
+  return ga < gb ? -1 : ga > gb;
+}
+
+/* Compare two ghosts by their tree id */
+static int
+t8_cmesh_faces_ghost_compare (const void *a, const void *b)
+{
+  const t8_gloidx_t   ga = ((const t8_cmesh_faces_ghost_t *) a)->tree_id;
+  const t8_gloidx_t   gb = ((const t8_cmesh_faces_ghost_t *) b)->tree_id;
+
+  return ga < gb ? -1 : ga > gb;
+}
+
+/* Compare two faces by their sorted vertices, such that faces
+ * with the same vertices are next to each other after sorting. */
+static int
+t8_cmesh_faces_face_compare (const void *a, const void *b)
+{
+  const t8_cmesh_faces_face_t *face_a = (const t8_cmesh_faces_face_t *) a;
+  const t8_cmesh_faces_face_t *face_b = (const t8_cmesh_faces_face_t *) b;
+  int                 iv;
+
+  if (face_a->num_vertices != face_b->num_vertices) {
+    return face_a->num_vertices < face_b->num_vertices ? -1 : 1;
+  }
+  for (iv = 0; iv < face_a->num_vertices; iv++) {
+    if (face_a->key[iv] != face_b->key[iv]) {
+      return face_a->key[iv] < face_b->key[iv] ? -1 : 1;
+    }
+  }
+  if (face_a->tree_id != face_b->tree_id) {
+    return face_a->tree_id < face_b->tree_id ? -1 : 1;
+  }
+  return face_a->face_number - face_b->face_number;
+}
+
+/* Compare two face connections by their first tree and face.
+ * Each face belongs to at most one face connection, so this identifies
+ * a face connection. */
+static int
+t8_cmesh_faces_join_compare (const void *a, const void *b)
+{
+  const t8_cmesh_faces_join_t *join_a = (const t8_cmesh_faces_join_t *) a;
+  const t8_cmesh_faces_join_t *join_b = (const t8_cmesh_faces_join_t *) b;
+
+  if (join_a->tree_ids[0] != join_b->tree_ids[0]) {
+    return join_a->tree_ids[0] < join_b->tree_ids[0] ? -1 : 1;
+  }
+  return join_a->faces[0] - join_b->faces[0];
+}
+
+/* Return the process that owns a tree, given the first tree of each process
+ * and the global number of trees in tree_offsets[mpisize]. */
+static int
+t8_cmesh_faces_tree_owner (const t8_gloidx_t * tree_offsets, int mpisize,
+                           t8_gloidx_t tree_id)
+{
+  int                 low = 0, high = mpisize - 1, mid;
+
+  T8_ASSERT (0 <= tree_id && tree_id < tree_offsets[mpisize]);
+  /* Find the process p with tree_offsets[p] <= tree_id < tree_offsets[p + 1] */
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (tree_offsets[mid + 1] <= tree_id) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+char               *
+t8_cmesh_faces_exchange (sc_MPI_Comm comm, int tag, size_t item_size,
+                         const char *items, size_t num_items,
+                         const int *dest, size_t *num_recv, int *recv_counts)
+{
+  int                *send_counts, *recv_counts_alloc = NULL;
+  size_t             *send_offsets, *recv_offsets, *positions;
+  size_t              iitem;
+  char               *send_buffer, *recv_buffer;
+  sc_MPI_Request     *requests;
+  int                 mpirank, mpisize, iproc, num_requests, mpiret;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (recv_counts == NULL) {
+    recv_counts = recv_counts_alloc = T8_ALLOC (int, mpisize);
+  }
+  send_counts = T8_ALLOC_ZERO (int, mpisize);
+  send_offsets = T8_ALLOC (size_t, mpisize + 1);
+  recv_offsets = T8_ALLOC (size_t, mpisize + 1);
+  positions = T8_ALLOC (size_t, mpisize);
+  for (iitem = 0; iitem < num_items; iitem++) {
+    T8_ASSERT (0 <= dest[iitem] && dest[iitem] < mpisize);
+    send_counts[dest[iitem]]++;
+  }
+  mpiret = sc_MPI_Alltoall (send_counts, 1, sc_MPI_INT, recv_counts, 1,
+                            sc_MPI_INT, comm);
+  SC_CHECK_MPI (mpiret);
+  send_offsets[0] = recv_offsets[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    send_offsets[iproc + 1] = send_offsets[iproc] + send_counts[iproc];
+    recv_offsets[iproc + 1] = recv_offsets[iproc] + recv_counts[iproc];
+    positions[iproc] = send_offsets[iproc];
+  }
+  /* Sort the items by their destination */
+  send_buffer = T8_ALLOC (char, SC_MAX (num_items, 1) * item_size);
+  for (iitem = 0; iitem < num_items; iitem++) {
+    memcpy (send_buffer + positions[dest[iitem]]++ * item_size,
+            items + iitem * item_size, item_size);
+  }
+  *num_recv = recv_offsets[mpisize];
+  recv_buffer = T8_ALLOC (char, SC_MAX (*num_recv, 1) * item_size);
+
+  requests = T8_ALLOC (sc_MPI_Request, 2 * mpisize);
+  num_requests = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc != mpirank && recv_counts[iproc] > 0) {
+      mpiret = sc_MPI_Irecv (recv_buffer + recv_offsets[iproc] * item_size,
+                             recv_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, tag, comm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc != mpirank && send_counts[iproc] > 0) {
+      mpiret = sc_MPI_Isend (send_buffer + send_offsets[iproc] * item_size,
+                             send_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, tag, comm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  /* The items to ourselves are copied */
+  memcpy (recv_buffer + recv_offsets[mpirank] * item_size,
+          send_buffer + send_offsets[mpirank] * item_size,
+          send_counts[mpirank] * item_size);
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+
+  T8_FREE (requests);
+  T8_FREE (send_buffer);
+  T8_FREE (positions);
+  T8_FREE (recv_offsets);
+  T8_FREE (send_offsets);
+  T8_FREE (send_counts);
+  T8_FREE (recv_counts_alloc);
+  return recv_buffer;
+}
+
+/* Given two connected faces compute their orientation.
+ * The orientation is the position of the first vertex of the smaller
+ * face in the bigger face, see t8_cmesh_set_join. */
+static int
+t8_cmesh_faces_orientation (const t8_cmesh_faces_face_t * face_a,
+                            const t8_cmesh_faces_face_t * face_b)
+{
+  const t8_cmesh_faces_face_t *smaller_face, *bigger_face;
+  int                 compare, iv;
+
+  compare = t8_eclass_compare ((t8_eclass_t) face_a->eclass,
+                               (t8_eclass_t) face_b->eclass);
+  if (compare > 0 || (compare == 0 && face_a->tree_id >= face_b->tree_id)) {
+    /* If both classes are the same, the face with the smaller tree id is
+     * the smaller one. For a tree connected to itself we use face_b. */
+    smaller_face = face_b;
+    bigger_face = face_a;
+  }
+  else {
+    smaller_face = face_a;
+    bigger_face = face_b;
+  }
+  for (iv = 0; iv < bigger_face->num_vertices; iv++) {
+    if (bigger_face->vertices[iv] == smaller_face->vertices[0]) {
+      return iv;
+    }
+  }
+  SC_ABORT_NOT_REACHED ();
+  return -1;
+}
+
+/* Match the faces sent to this process. For each pair of faces with the
+ * same vertices a face connection is created and added to joins.
+ * For each connection the owners of its trees are added to dest. */
+static void
+t8_cmesh_faces_match (t8_cmesh_faces_face_t * faces, size_t num_faces,
+                      const t8_gloidx_t * tree_offsets, int mpisize,
+                      sc_array_t * joins, sc_array_t * dest)
+{
+  t8_cmesh_faces_face_t *face, *neighbor;
+  t8_cmesh_faces_join_t *join;
+  size_t              iface;
+  int                 owner, neighbor_owner;
+
+  qsort (faces, num_faces, sizeof (t8_cmesh_faces_face_t),
+         t8_cmesh_faces_face_compare);
+  for (iface = 0; iface + 1 < num_faces; iface++) {
+    face = faces + iface + 1;
+    neighbor = faces + iface;
+    if (face->num_vertices != neighbor->num_vertices
+        || memcmp (face->key, neighbor->key,
+                   face->num_vertices * sizeof (t8_gloidx_t))) {
+      /* These faces are not connected */
+      continue;
+    }
+    /* The tree with the bigger id is the first tree of the connection */
+    T8_ASSERT (neighbor->tree_id < face->tree_id
+               || (neighbor->tree_id == face->tree_id
+                   && neighbor->face_number < face->face_number));
+    join = (t8_cmesh_faces_join_t *) sc_array_push (joins);
+    join->tree_ids[0] = face->tree_id;
+    join->tree_ids[1] = neighbor->tree_id;
+    join->faces[0] = face->face_number;
+    join->faces[1] = neighbor->face_number;
+    join->eclasses[0] = face->eclass;
+    join->eclasses[1] = neighbor->eclass;
+    join->orientation = t8_cmesh_faces_orientation (face, neighbor);
+    /* Send the connection to the owners of both trees */
+    owner = t8_cmesh_faces_tree_owner (tree_offsets, mpisize, face->tree_id);
+    neighbor_owner =
+      t8_cmesh_faces_tree_owner (tree_offsets, mpisize, neighbor->tree_id);
+    *(int *) sc_array_push (dest) = owner;
+    if (neighbor_owner != owner) {
+      *(t8_cmesh_faces_join_t *) sc_array_push (joins) = *join;
+      *(int *) sc_array_push (dest) = neighbor_owner;
+    }
+    /* Each face has at most one neighbor */
+    iface++;
+  }
+}
+
+/* Add the face connections of the local trees to the cmesh and
+ * request the face connections of the ghosts from their owners.
+ * This function is collective. */
+static void
+t8_cmesh_faces_set_joins (t8_cmesh_t cmesh, sc_MPI_Comm comm, int mpirank,
+                          int mpisize, const t8_gloidx_t * tree_offsets,
+                          t8_cmesh_faces_join_t * joins, size_t num_joins)
+{
+  t8_cmesh_faces_join_t *ghost_joins, *replies, *join;
+  t8_cmesh_faces_ghost_t *ghosts;
+  t8_gloidx_t        *ghost_ids, *requests, first_tree, num_local_trees;
+  t8_gloidx_t         ltree;
+  size_t             *tree_joins_offset, *tree_joins, *positions;
+  size_t              ijoin, num_ghosts, ighost, num_recv, num_replies;
+  size_t              num_ghost_joins, irequest;
+  int                *dest, *recv_counts, iproc, iside;
+
+  first_tree = tree_offsets[mpirank];
+  num_local_trees = tree_offsets[mpirank + 1] - first_tree;
+
+  /* Set the face connections of the local trees and collect the ghosts.
+   * For each local tree we also count the connections it is part of. */
+  tree_joins_offset = T8_ALLOC_ZERO (size_t, num_local_trees + 1);
+  ghosts = T8_ALLOC (t8_cmesh_faces_ghost_t, SC_MAX (num_joins, 1));
+  num_ghosts = 0;
+  for (ijoin = 0; ijoin < num_joins; ijoin++) {
+    join = joins + ijoin;
+    t8_cmesh_set_join (cmesh, join->tree_ids[0], join->tree_ids[1],
+                       join->faces[0], join->faces[1], join->orientation);
+    for (iside = 0; iside < 2; iside++) {
+      if (iside == 1 && join->tree_ids[0] == join->tree_ids[1]) {
+        /* A connection of a tree with itself is counted once */
+        continue;
+      }
+      ltree = join->tree_ids[iside] - first_tree;
+      if (0 <= ltree && ltree < num_local_trees) {
+        tree_joins_offset[ltree + 1]++;
+      }
+      else {
+        /* Each connection contains at most one ghost */
+        ghosts[num_ghosts].tree_id = join->tree_ids[iside];
+        ghosts[num_ghosts++].eclass = (t8_eclass_t) join->eclasses[iside];
+      }
+    }
+  }
+  for (ltree = 0; ltree < num_local_trees; ltree++) {
+    tree_joins_offset[ltree + 1] += tree_joins_offset[ltree];
+  }
+  /* Store the connections of each local tree */
+  tree_joins = T8_ALLOC (size_t, SC_MAX (tree_joins_offset[num_local_trees],
+                                         1));
+  positions = T8_ALLOC (size_t, num_local_trees + 1);
+  memcpy (positions, tree_joins_offset,
+          (num_local_trees + 1) * sizeof (size_t));
+  for (ijoin = 0; ijoin < num_joins; ijoin++) {
+    join = joins + ijoin;
+    for (iside = 0; iside < 2; iside++) {
+      if (iside == 1 && join->tree_ids[0] == join->tree_ids[1]) {
+        continue;
+      }
+      ltree = join->tree_ids[iside] - first_tree;
+      if (0 <= ltree && ltree < num_local_trees) {
+        tree_joins[positions[ltree]++] = ijoin;
+      }
+    }
+  }
+  T8_FREE (positions);
+
+  /* Set the classes of the ghosts. A ghost may be part of several
+   * connections, so we remove the duplicates. */
+  qsort (ghosts, num_ghosts, sizeof (t8_cmesh_faces_ghost_t),
+         t8_cmesh_faces_ghost_compare);
+  for (ijoin = 0, ighost = 0; ijoin < num_ghosts; ijoin++) {
+    if (ighost == 0 || ghosts[ighost - 1].tree_id != ghosts[ijoin].tree_id) {
+      ghosts[ighost++] = ghosts[ijoin];
+      t8_cmesh_set_tree_class (cmesh, ghosts[ijoin].tree_id,
+                               ghosts[ijoin].eclass);
+    }
+  }
+  num_ghosts = ighost;
+
+  /* Request the face connections of the ghosts from their owners */
+  ghost_ids = T8_ALLOC (t8_gloidx_t, SC_MAX (num_ghosts, 1));
+  dest = T8_ALLOC (int, SC_MAX (num_ghosts, 1));
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    ghost_ids[ighost] = ghosts[ighost].tree_id;
+    dest[ighost] = t8_cmesh_faces_tree_owner (tree_offsets, mpisize,
+                                              ghost_ids[ighost]);
+  }
+  T8_FREE (ghosts);
+  recv_counts = T8_ALLOC (int, mpisize);
+  requests = (t8_gloidx_t *)
+    t8_cmesh_faces_exchange (comm, T8_MPI_CMESH_FACES, sizeof (t8_gloidx_t),
+                             (char *) ghost_ids, num_ghosts, dest, &num_recv,
+                             recv_counts);
+  T8_FREE (dest);
+  T8_FREE (ghost_ids);
+
+  /* Answer the requests with all connections of the requested trees */
+  num_replies = 0;
+  for (irequest = 0; irequest < num_recv; irequest++) {
+    ltree = requests[irequest] - first_tree;
+    num_replies += tree_joins_offset[ltree + 1] - tree_joins_offset[ltree];
+  }
+  replies = T8_ALLOC (t8_cmesh_faces_join_t, SC_MAX (num_replies, 1));
+  dest = T8_ALLOC (int, SC_MAX (num_replies, 1));
+  num_replies = 0;
+  for (iproc = 0, irequest = 0; iproc < mpisize; iproc++) {
+    for (ighost = 0; ighost < (size_t) recv_counts[iproc];
+         ighost++, irequest++) {
+      ltree = requests[irequest] - first_tree;
+      for (ijoin = tree_joins_offset[ltree];
+           ijoin < tree_joins_offset[ltree + 1]; ijoin++) {
+        replies[num_replies] = joins[tree_joins[ijoin]];
+        dest[num_replies++] = iproc;
+      }
+    }
+  }
+  T8_FREE (requests);
+  T8_FREE (recv_counts);
+  T8_FREE (tree_joins);
+  T8_FREE (tree_joins_offset);
+  ghost_joins = (t8_cmesh_faces_join_t *)
+    t8_cmesh_faces_exchange (comm, T8_MPI_CMESH_FACES,
+                             sizeof (t8_cmesh_faces_join_t),
+                             (char *) replies, num_replies, dest,
+                             &num_ghost_joins, NULL);
+  T8_FREE (dest);
+  T8_FREE (replies);
+
+  /* Add the connections of the ghosts that do not contain a local tree,
+   * since we already added those. A connection between two ghosts
+   * is received twice. */
+  qsort (ghost_joins, num_ghost_joins, sizeof (t8_cmesh_faces_join_t),
+         t8_cmesh_faces_join_compare);
+  for (ijoin = 0; ijoin < num_ghost_joins; ijoin++) {
+    join = ghost_joins + ijoin;
+    if ((ijoin > 0 && !t8_cmesh_faces_join_compare (join, join - 1))
+        || (first_tree <= join->tree_ids[0]
+            && join->tree_ids[0] < first_tree + num_local_trees)
+        || (first_tree <= join->tree_ids[1]
+            && join->tree_ids[1] < first_tree + num_local_trees)) {
+      continue;
+    }
+    t8_cmesh_set_join (cmesh, join->tree_ids[0], join->tree_ids[1],
+                       join->faces[0], join->faces[1], join->orientation);
+  }
+  T8_FREE (ghost_joins);
+}
+
+void
+t8_cmesh_compute_face_connectivity (t8_cmesh_t cmesh, t8_gloidx_t first_tree,
+                                    t8_locidx_t num_local_trees,
+                                    const t8_eclass_t * eclasses,
+                                    const t8_gloidx_t * vertex_ids,
+                                    sc_MPI_Comm comm)
+{
+  t8_gloidx_t        *tree_offsets, num_trees, min_vertex;
+  t8_cmesh_faces_face_t *face, *recv_faces;
+  t8_cmesh_faces_join_t *recv_joins;
+  sc_array_t          faces, dest, joins;
+  size_t              num_recv, vertex_offset;
+  t8_locidx_t         ltree;
+  t8_eclass_t         eclass;
+  int                 mpirank, mpisize, mpiret, iproc, iface, iv;
+
+  T8_ASSERT (cmesh != NULL && !cmesh->committed);
+  T8_ASSERT (num_local_trees >= 0);
+  T8_ASSERT (num_local_trees == 0 || (eclasses != NULL
+                                      && vertex_ids != NULL));
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* Compute the first tree of each process */
+  tree_offsets = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  num_trees = num_local_trees;
+  mpiret = sc_MPI_Allgather (&num_trees, 1, T8_MPI_GLOIDX,
+                             tree_offsets + 1, 1, T8_MPI_GLOIDX, comm);
+  SC_CHECK_MPI (mpiret);
+  tree_offsets[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    tree_offsets[iproc + 1] += tree_offsets[iproc];
+  }
+  SC_CHECK_ABORT (tree_offsets[mpirank] == first_tree,
+                  "The local trees must follow the trees of the lower ranks.\n");
+
+  /* Build all faces of the local trees. Each face is sent to the process
+   * given by its smallest vertex, thus both faces of a connection are
+   * matched on the same process. */
+  sc_array_init (&faces, sizeof (t8_cmesh_faces_face_t));
+  sc_array_init (&dest, sizeof (int));
+  for (ltree = 0, vertex_offset = 0; ltree < num_local_trees; ltree++) {
+    eclass = eclasses[ltree];
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      face = (t8_cmesh_faces_face_t *) sc_array_push (&faces);
+      face->tree_id = first_tree + ltree;
+      face->face_number = iface;
+      face->eclass = eclass;
+      face->num_vertices =
+        t8_eclass_num_vertices[t8_eclass_face_types[eclass][iface]];
+      for (iv = 0; iv < face->num_vertices; iv++) {
+        face->vertices[iv] = vertex_ids[vertex_offset +
+                                        t8_face_vertex_to_tree_vertex[eclass]
+                                        [iface][iv]];
+        face->key[iv] = face->vertices[iv];
+      }
+      qsort (face->key, face->num_vertices, sizeof (t8_gloidx_t),
+             t8_cmesh_faces_gloidx_compare);
+      min_vertex = face->key[0];
+      T8_ASSERT (min_vertex >= 0);
+      *(int *) sc_array_push (&dest) = (int) (min_vertex % mpisize);
+    }
+    vertex_offset += t8_eclass_num_vertices[eclass];
+  }
+
+  /* Send the faces to the processes that match them */
+  recv_faces = (t8_cmesh_faces_face_t *)
+    t8_cmesh_faces_exchange (comm, T8_MPI_CMESH_FACES,
+                             sizeof (t8_cmesh_faces_face_t), faces.array,
+                             faces.elem_count, (int *) dest.array, &num_recv,
+                             NULL);
+  sc_array_reset (&faces);
+  sc_array_truncate (&dest);
+  sc_array_init (&joins, sizeof (t8_cmesh_faces_join_t));
+  t8_cmesh_faces_match (recv_faces, num_recv, tree_offsets, mpisize, &joins,
+                        &dest);
+  T8_FREE (recv_faces);
+
+  /* Send the face connections to the owners of their trees */
+  recv_joins = (t8_cmesh_faces_join_t *)
+    t8_cmesh_faces_exchange (comm, T8_MPI_CMESH_FACES,
+                             sizeof (t8_cmesh_faces_join_t), joins.array,
+                             joins.elem_count, (int *) dest.array, &num_recv,
+                             NULL);
+  sc_array_reset (&joins);
+  sc_array_reset (&dest);
+  t8_cmesh_faces_set_joins (cmesh, comm, mpirank, mpisize, tree_offsets,
+                            recv_joins, num_recv);
+  T8_FREE (recv_joins);
+  T8_FREE (tree_offsets);
+}
@@ -0,0 +1,62 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_cmesh_faces.h
+ *
+ * In this file we collect functions that find the face connections
+ * of partitioned cmeshes in parallel.
+ */
+
+#ifndef T8_CMESH_FACES_H
+#define T8_CMESH_FACES_H
+
+#include <t8.h>
+#include <t8_cmesh.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Send items of equal size to other processes.
+ * Item i is sent to process \a dest[i]. This function is collective.
+ * \param [in]      comm        The communicator.
+ * \param [in]      tag         The MPI tag used for the messages.
+ * \param [in]      item_size   The size of one item in bytes.
+ * \param [in]      items       The \a num_items items to send.
+ * \param [in]      num_items   The number of items to send.
+ * \param [in]      dest        For each item its destination process.
+ * \param [out]     num_recv    The number of received items.
+ * \param [out]     recv_counts If not NULL, an array of mpisize entries,
+ *                              on output the number of items received from
+ *                              each process.
+ * \return          The received items, ordered by their source process.
+ *                  Must be freed with T8_FREE.
+ */
+char               *t8_cmesh_faces_exchange (sc_MPI_Comm comm, int tag,
+                                             size_t item_size,
+                                             const char *items,
+                                             size_t num_items,
+                                             const int *dest,
+                                             size_t *num_recv,
+                                             int *recv_counts);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_CMESH_FACES_H */
@@ -194,6 +194,29 @@ t8_offset_any_owner_of_tree (int mpisize, t8_gloidx_t gtree,
   return proc;
 }
 
+/* Find the smallest rank in [low, high] whose last tree is at least gtree.
+ * Since the absolute values of the offset entries are non-decreasing,
+ * so are the last trees of the processes and we can use a binary search.
+ * Returns high + 1 if no such rank exists. */
+static int
+t8_offset_lower_bound_last (t8_gloidx_t gtree, int low, int high,
+                            t8_gloidx_t * offset)
+{
+  int                 proc;
+
+  high++;
+  while (low < high) {
+    proc = low + (high - low) / 2;
+    if (t8_offset_last (proc, offset) < gtree) {
+      low = proc + 1;
+    }
+    else {
+      high = proc;
+    }
+  }
+  return low;
+}
+
 /* Find the smallest process that owns a given tree.
  * To increase the runtime, some_owner can be a process that
  * already owns the tree. Otherwise (some_owner < 0), the function will compute one. */
@@ -201,40 +224,21 @@ int
 t8_offset_first_owner_of_tree (int mpisize, t8_gloidx_t gtree,
                                t8_gloidx_t * offset, int *some_owner)
 {
-  int                 proc, proc_temp;
+  int                 proc;
 
   T8_ASSERT (t8_offset_valid_tree (gtree, mpisize, offset));
-  if (*some_owner < 0) {
-    *some_owner = t8_offset_any_owner_of_tree (mpisize, gtree, offset);
-  }
   T8_ASSERT (*some_owner < mpisize);
-  proc = *some_owner;
-  /* Here, proc stores an arbitrary owner of gtree */
-  /* Now we find the smallest process that owns the tree */
-  proc_temp = proc;
-  while (proc_temp >= 0 && t8_offset_in_range (gtree, proc_temp, offset)) {
-    /* decrement temp as long as it holds the tree */
-    proc_temp--;
-    while (0 <= proc_temp && t8_offset_empty (proc_temp, offset)) {
-      /* Skip empty processes */
-      proc_temp--;
-    }
-  }
-  /* We are now one nonempty proccess below the smallest process having the tree */
-  if (proc_temp >= -1) {
-    proc_temp++;
-    while (t8_offset_empty (proc_temp, offset)) {
-      /* Skip empty processes */
-      proc_temp++;
-    }
-    T8_ASSERT (t8_offset_in_range (gtree, proc_temp, offset));
-  }
-  else {
-    /* TODO: This should never happen */
-    T8_ASSERT (1 == 0);
-    proc_temp = proc;
+  /* The smallest process whose last tree is not smaller than gtree.
+   * This process cannot be empty, since an empty process has the same
+   * last tree as its predecessor. If we know an owner, the first owner
+   * cannot be bigger. */
+  proc = t8_offset_lower_bound_last (gtree, 0, *some_owner >= 0 ?
+                                     *some_owner : mpisize - 1, offset);
+  T8_ASSERT (proc < mpisize);
+  T8_ASSERT (t8_offset_in_range (gtree, proc, offset));
+  if (*some_owner < 0) {
+    *some_owner = proc;
   }
-  proc = proc_temp;
   return proc;
 }
 
@@ -293,40 +297,26 @@ int
 t8_offset_last_owner_of_tree (int mpisize, t8_gloidx_t gtree,
                               t8_gloidx_t * offset, int *some_owner)
 {
-  int                 proc, proc_temp;
+  int                 proc;
 
   T8_ASSERT (t8_offset_valid_tree (gtree, mpisize, offset));
-  if (*some_owner < 0) {
-    *some_owner = t8_offset_any_owner_of_tree (mpisize, gtree, offset);
-  }
   T8_ASSERT (*some_owner < mpisize);
-  proc = *some_owner;
-  /* Here, proc stores an arbitrary owner of gtree */
-  /* Now we find the smallest process that owns the tree */
-  proc_temp = proc;
-  while (proc_temp < mpisize && t8_offset_in_range (gtree, proc_temp, offset)) {
-    /* increment temp as long as it holds the tree */
-    proc_temp++;
-    while (proc_temp < mpisize && t8_offset_empty (proc_temp, offset)) {
-      /* Skip empty processes */
-      proc_temp++;
-    }
-  }
-  /* We are now one nonempty proccess above the biggest process having the tree */
-  if (proc_temp <= mpisize) {
-    proc_temp--;
-    while (t8_offset_empty (proc_temp, offset)) {
-      /* Skip empty processes */
-      proc_temp--;
-    }
-    T8_ASSERT (t8_offset_in_range (gtree, proc_temp, offset));
+  /* All processes below the smallest process whose last tree is bigger
+   * than gtree and above the first owner have gtree as their last tree.
+   * Thus, the biggest nonempty process among them is the last owner. */
+  proc = t8_offset_lower_bound_last (gtree + 1, *some_owner >= 0 ?
+                                     *some_owner : 0, mpisize - 1, offset);
+  if (proc >= mpisize || t8_offset_first (proc, offset) > gtree) {
+    /* proc does not own gtree, the last owner is smaller */
+    do {
+      proc--;
+    } while (proc >= 0 && t8_offset_empty (proc, offset));
   }
-  else {
-    /* TODO: This should never happen */
-    T8_ASSERT (1 == 0);
-    proc_temp = proc;
+  T8_ASSERT (proc >= 0);
+  T8_ASSERT (t8_offset_in_range (gtree, proc, offset));
+  if (*some_owner < 0) {
+    *some_owner = proc;
   }
-  proc = proc_temp;
   return proc;
 }
 
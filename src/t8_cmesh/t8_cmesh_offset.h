@@ -145,8 +145,10 @@ int                 t8_offset_any_owner_of_tree (int mpisize,
  * \param [in] offset     The partition to be considered.
  * \param [in] some_owner If >= 0 considered as input: a process that has \a gtree as local tree.
  *                        If < 0 on output a process that has \a gtree as local tree.
- *                        Specifying \a some_owner increases the runtime from
- *                        O(log mpisize) to O(n), where n is the number of owners of the tree.
+ *                        Specifying \a some_owner restricts the binary
+ *                        search to the ranks up to \a some_owner.
+ *                        The runtime is O(log mpisize), independent of the
+ *                        number of owners of the tree.
  * \return                The smallest rank that has \a gtree as a local tree.
  */
 int                 t8_offset_first_owner_of_tree (int mpisize,
@@ -163,8 +165,10 @@ int                 t8_offset_first_owner_of_tree (int mpisize,
  * \param [in] offset     The partition to be considered.
  * \param [in,out] some_owner If >= 0 considered as input: a process that has \a gtree as local tree.
  *                        If < 0 on output a process that has \a gtree as local tree.
- *                        Specifying \a some_owner increases the runtime from
- *                        O(log mpisize) to O(n), where n is the number of owners of the tree.
+ *                        Specifying \a some_owner restricts the binary
+ *                        search to the ranks from \a some_owner on.
+ *                        The runtime is O(log mpisize) plus the number of
+ *                        empty processes directly following the last owner.
  * \return                The biggest rank that has \a gtree as a local tree.
  */
 int                 t8_offset_last_owner_of_tree (int mpisize,
@@ -99,10 +99,6 @@ t8_partition_new_ghost_ids (t8_cmesh_t cmesh,
   t8_locidx_t        *tree_neighbors;
   int8_t             *ttf;
   int                 iface, face_tree;
-  t8_trees_glo_lo_hash_t *new_hash;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
 
   for (ghost_it = 0; ghost_it < recv_part->num_ghosts; ghost_it++) {
     /* loop over all ghosts of recv_part */
@@ -126,20 +122,12 @@ t8_partition_new_ghost_ids (t8_cmesh_t cmesh,
           ghost_it + first_ghost + cmesh->num_local_trees;
       }
     }
-    /* Insert this ghost's global and local id into the hash table */
-    new_hash = (t8_trees_glo_lo_hash_t *)
-      sc_mempool_alloc (cmesh->trees->global_local_mempool);
-    new_hash->global_id = ghost->treeid;
-    /* The new local ghost id is the concurrent id of this ghost plus the
+    /* Insert this ghost's global and local id into the map.
+     * The new local ghost id is the concurrent id of this ghost plus the
      * number of local trees */
-    new_hash->local_id = ghost_it + first_ghost + cmesh->num_local_trees;
-#ifdef T8_ENABLE_DEBUG
-    ret =
-#endif
-      sc_hash_insert_unique (cmesh->trees->ghost_globalid_to_local_id,
-                             new_hash, NULL);
-    /* The entry must not have existed before */
-    T8_ASSERT (ret);
+    t8_cmesh_trees_insert_ghost_map (cmesh->trees, ghost->treeid,
+                                     ghost_it + first_ghost +
+                                     cmesh->num_local_trees);
   }
 }
 
@@ -261,6 +249,41 @@ t8_cmesh_gather_treecount_ext (t8_cmesh_t cmesh, sc_MPI_Comm comm,
   }
 }
 
+/* Create the tree offsets of cmesh for a uniform partition of level level
+ * of the trees of cmesh_from. Since the bounds of all processes are known
+ * in closed form, we do not communicate.
+ * An empty process stores the first nonshared tree of the next nonempty
+ * process, which is what t8_cmesh_uniform_bounds returns for it. */
+static void
+t8_cmesh_partition_uniform_offsets (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
+                                    int level, sc_MPI_Comm comm)
+{
+  t8_gloidx_t        *first_trees, *last_trees, *offsets;
+  int8_t             *shared;
+  int                 iproc;
+
+  T8_ASSERT (cmesh->mpisize == cmesh_from->mpisize);
+  first_trees = T8_ALLOC (t8_gloidx_t, cmesh->mpisize);
+  last_trees = T8_ALLOC (t8_gloidx_t, cmesh->mpisize);
+  shared = T8_ALLOC (int8_t, cmesh->mpisize);
+  offsets = T8_ALLOC (t8_gloidx_t, cmesh->mpisize + 1);
+  t8_cmesh_uniform_bounds_all (cmesh_from, level, first_trees, NULL,
+                               last_trees, NULL, shared);
+  for (iproc = 0; iproc < cmesh->mpisize; iproc++) {
+    offsets[iproc] = shared[iproc] ? -first_trees[iproc] - 1 :
+      first_trees[iproc];
+  }
+  offsets[cmesh->mpisize] = cmesh->num_trees;
+
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  cmesh->tree_offsets = t8_cmesh_alloc_offsets (cmesh->mpisize, comm);
+  t8_shmem_array_copy_from (cmesh->tree_offsets, offsets);
+  T8_FREE (first_trees);
+  T8_FREE (last_trees);
+  T8_FREE (shared);
+  T8_FREE (offsets);
+}
+
 /* Given a cmesh create its tree_offsets from the local number of
  * trees on each process */
 void
@@ -1399,6 +1422,43 @@ t8_cmesh_send_ghost (t8_cmesh_t cmesh, const struct t8_cmesh *cmesh_from,
 }
 
 /* copy all tree/ghost/attribute data to the send buffer */
+/* A pending memcpy of t8_cmesh_partition_copy_data. Copies of consecutive
+ * source ranges to consecutive destination ranges are joined into one. */
+typedef struct
+{
+  char               *dest;
+  const char         *src;
+  size_t              bytes;
+} t8_partition_copy_run_t;
+
+/* Copy the pending range of a run, if any. */
+static void
+t8_partition_copy_run_flush (t8_partition_copy_run_t * run)
+{
+  if (run->bytes > 0) {
+    (void) memcpy (run->dest, run->src, run->bytes);
+  }
+  run->bytes = 0;
+}
+
+/* Add a copy of bytes bytes from src to dest to a run. If it continues the
+ * pending range of the run in source and destination, it is appended to it.
+ * Otherwise the pending range is copied first. */
+static void
+t8_partition_copy_run_add (t8_partition_copy_run_t * run, char *dest,
+                           const void *src, size_t bytes)
+{
+  if (run->bytes > 0 && run->dest + run->bytes == dest
+      && run->src + run->bytes == (const char *) src) {
+    run->bytes += bytes;
+    return;
+  }
+  t8_partition_copy_run_flush (run);
+  run->dest = dest;
+  run->src = (const char *) src;
+  run->bytes = bytes;
+}
+
 static void
 t8_cmesh_partition_copy_data (char *send_buffer, t8_cmesh_t cmesh,
                               const struct t8_cmesh *cmesh_from,
@@ -1428,11 +1488,13 @@ t8_cmesh_partition_copy_data (char *send_buffer, t8_cmesh_t cmesh,
   t8_cghost_t         ghost, ghost_cpy;
   int                 iface, iatt;
   int8_t             *ttf_ghost, *ttf;
+  size_t              face_bytes;
+  t8_partition_copy_run_t tree_run, face_run, att_info_run, att_run;
 
-  /* Copy all trees to the send buffer */
-  /* TODO: This is currently inefficient since we copy each tree for itself.
-   *       Best practive is to copy chunks of trees out of the different part
-   *       arrays of cmesh_from */
+  /* Copy all trees to the send buffer.
+   * Consecutive trees of the same part of cmesh_from are contiguous in its
+   * memory, as are their face neighbors and attributes. Thus we copy chunks
+   * of trees from the part arrays instead of each tree for itself. */
   if (total_alloc == 0 || send_buffer == NULL) {
     t8_debugf ("No data to store in buffer.\n");
     return;
@@ -1445,44 +1507,55 @@ t8_cmesh_partition_copy_data (char *send_buffer, t8_cmesh_t cmesh,
   temp_offset_data = 0;
   /* offset from the beginning to the current tree */
   temp_offset_tree = 0;
+  tree_run.bytes = face_run.bytes = att_info_run.bytes = att_run.bytes = 0;
   for (itree = send_first; itree <= send_last; itree++) {
     tree = t8_cmesh_trees_get_tree_ext (cmesh_from->trees, itree,
                                         &face_neighbor, NULL);
 
-    (void) memcpy (send_buffer + temp_offset_tree, tree,
-                   sizeof (t8_ctree_struct_t));
+    t8_partition_copy_run_add (&tree_run, send_buffer + temp_offset_tree,
+                               tree, sizeof (t8_ctree_struct_t));
     temp_offset_tree += sizeof (t8_ctree_struct_t);
-    /* Copy all face neighbor information to send_buffer */
-    (void) memcpy (send_buffer + num_trees * sizeof (t8_ctree_struct_t) +
-                   num_ghost_send * sizeof (t8_cghost_struct_t) +
-                   ghost_neighbor_bytes + temp_offset, face_neighbor,
-                   t8_eclass_num_faces[tree->eclass] *
-                   (sizeof (t8_locidx_t) + sizeof (int8_t)));
-    temp_offset += t8_eclass_num_faces[tree->eclass] *
-      (sizeof (t8_locidx_t) + sizeof (int8_t))
-      + T8_ADD_PADDING (t8_eclass_num_faces[tree->eclass] *
-                        (sizeof (t8_locidx_t) + sizeof (int8_t)));
-    /* TODO: ??? temp_offset += T8_ADD_PADDING (temp_offset) instead of the last 2 lines? */
+    /* Copy all face neighbor information to send_buffer, including the
+     * padding, such that the face neighbors of consecutive trees can be
+     * copied at once */
+    face_bytes = t8_eclass_num_faces[tree->eclass] *
+      (sizeof (t8_locidx_t) + sizeof (int8_t));
+    face_bytes += T8_ADD_PADDING (face_bytes);
+    t8_partition_copy_run_add (&face_run, send_buffer +
+                               num_trees * sizeof (t8_ctree_struct_t) +
+                               num_ghost_send * sizeof (t8_cghost_struct_t) +
+                               ghost_neighbor_bytes + temp_offset,
+                               face_neighbor, face_bytes);
+    temp_offset += face_bytes;
     if (tree->num_attributes > 0) {
       /* Copy all attribute infos to send_buffer */
-      (void) memcpy (send_buffer + num_trees * sizeof (t8_ctree_struct_t) +
-                     num_ghost_send * sizeof (t8_cghost_struct_t) +
-                     ghost_neighbor_bytes + tree_neighbor_bytes +
-                     temp_offset_att, T8_TREE_ATTR_INFO (tree, 0),
-                     tree->num_attributes *
-                     sizeof (t8_attribute_info_struct_t));
+      t8_partition_copy_run_add (&att_info_run, send_buffer +
+                                 num_trees * sizeof (t8_ctree_struct_t) +
+                                 num_ghost_send * sizeof (t8_cghost_struct_t)
+                                 + ghost_neighbor_bytes + tree_neighbor_bytes
+                                 + temp_offset_att,
+                                 T8_TREE_ATTR_INFO (tree, 0),
+                                 tree->num_attributes *
+                                 sizeof (t8_attribute_info_struct_t));
       temp_offset_att +=
         tree->num_attributes * sizeof (t8_attribute_info_struct_t);
       /* Copy all attribute data to send_buffer */
-      (void) memcpy (send_buffer + num_trees * sizeof (t8_ctree_struct_t) +
-                     num_ghost_send * sizeof (t8_cghost_struct_t) +
-                     ghost_neighbor_bytes + tree_neighbor_bytes +
-                     attr_info_bytes + temp_offset_data,
-                     T8_TREE_ATTR (tree, T8_TREE_ATTR_INFO (tree, 0)),
-                     t8_cmesh_trees_attribute_size (tree));
+      t8_partition_copy_run_add (&att_run, send_buffer +
+                                 num_trees * sizeof (t8_ctree_struct_t) +
+                                 num_ghost_send * sizeof (t8_cghost_struct_t)
+                                 + ghost_neighbor_bytes + tree_neighbor_bytes
+                                 + attr_info_bytes + temp_offset_data,
+                                 T8_TREE_ATTR (tree,
+                                               T8_TREE_ATTR_INFO (tree, 0)),
+                                 t8_cmesh_trees_attribute_size (tree));
       temp_offset_data += t8_cmesh_trees_attribute_size (tree);
     }
   }
+  /* Copy the remaining chunks, before the offsets are changed below */
+  t8_partition_copy_run_flush (&tree_run);
+  t8_partition_copy_run_flush (&face_run);
+  t8_partition_copy_run_flush (&att_info_run);
+  t8_partition_copy_run_flush (&att_run);
   T8_ASSERT (tree_attribute_bytes == temp_offset_data);
   /* Set new face_neighbor offsets */
   /* TODO: indent bug? */
@@ -1984,6 +2057,9 @@ t8_cmesh_partition_sendloop (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
                         comm, *requests + iproc - flag - *send_first);
         SC_CHECK_MPI (mpiret);
         num_send_mpi++;
+        t8_profile_comm_sent (cmesh->profile == NULL ? NULL :
+                              &cmesh->profile->partition_comm, 1,
+                              total_alloc);
       }
       else {
         /* If num_trees + num_ghost_send = 0 we do not post an MPI_Send
@@ -2086,6 +2162,8 @@ t8_cmesh_partition_receive_message (t8_cmesh_t cmesh, sc_MPI_Comm comm,
                         proc_recv, T8_MPI_PARTITION_CMESH, comm,
                         sc_MPI_STATUS_IGNORE);
   SC_CHECK_MPI (mpiret);
+  t8_profile_comm_received (cmesh->profile == NULL ? NULL :
+                            &cmesh->profile->partition_comm, 1, recv_bytes);
   /* Read num trees and num ghosts */
   recv_part->num_trees =
     *((t8_locidx_t *) (recv_part->first_tree + recv_bytes -
@@ -2412,6 +2490,10 @@ t8_cmesh_partition_recvloop (t8_cmesh_t cmesh,
   T8_FREE (local_procid);
 }
 
+#if T8_ENABLE_DEBUG
+/* Compute the send and receive ranges by checking all processes.
+ * Since this has O(mpisize) runtime, we only use it in debugging mode to
+ * verify the ranges computed by binary search on the offset arrays. */
 static void
 t8_cmesh_partition_debug_listprocs (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
                                     sc_MPI_Comm comm, int *fs, int *ls,
@@ -2460,6 +2542,7 @@ t8_cmesh_partition_debug_listprocs (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
   }
   t8_debugf ("I receive from: %s\n", out);
 }
+#endif
 
 /* Given an initial cmesh (cmesh_from) and a new partition table (tree_offset)
  * create the new partition on the destination cmesh (cmesh) */
@@ -2474,7 +2557,8 @@ t8_cmesh_partition_given (t8_cmesh_t cmesh, const struct t8_cmesh *cmesh_from,
   size_t              my_buffer_bytes = -1;
   char              **send_buffer = NULL, *my_buffer = NULL;
 
-  int                 fs, ls, fr, lr;
+  /* The send and receive ranges computed by the debugging routine */
+  int                 fs = -1, ls = -2, fr = -1, lr = -2;
 
   sc_MPI_Request     *requests = NULL;
   t8_locidx_t         num_ghosts, itree, num_trees;
@@ -2499,10 +2583,12 @@ t8_cmesh_partition_given (t8_cmesh_t cmesh, const struct t8_cmesh *cmesh_from,
   cmesh->first_tree = t8_offset_first (cmesh->mpirank, tree_offset);
   cmesh->num_local_trees = t8_offset_num_trees (cmesh->mpirank, tree_offset);
 
+#if T8_ENABLE_DEBUG
   if (cmesh_from->set_partition) {
     t8_cmesh_partition_debug_listprocs (cmesh, (t8_cmesh_t) cmesh_from, comm,
                                         &fs, &ls, &fr, &lr);
   }
+#endif
 
   /*********************************************/
   /*        Done with setup                    */
@@ -2582,7 +2668,7 @@ void
 t8_cmesh_partition (t8_cmesh_t cmesh, sc_MPI_Comm comm)
 {
   t8_cmesh_t          cmesh_from;
-  t8_gloidx_t         last_tree, *tree_offsets;
+  t8_gloidx_t        *tree_offsets;
 
   T8_ASSERT (t8_cmesh_is_committed (cmesh->set_from));
   T8_ASSERT (t8_cmesh_is_initialized (cmesh));
@@ -2602,16 +2688,15 @@ t8_cmesh_partition (t8_cmesh_t cmesh, sc_MPI_Comm comm)
   /*         and trees per proc array           */
   /**********************************************/
   if (cmesh->set_partition_level >= 0) {
-    /* Compute first and last tree index */
+    /* Compute the tree offsets of all processes without communication */
     T8_ASSERT (cmesh->tree_offsets == NULL);
-    t8_cmesh_uniform_bounds (cmesh_from, cmesh->set_partition_level,
-                             &cmesh->first_tree, NULL, &last_tree, NULL,
-                             &cmesh->first_tree_shared);
-    cmesh->num_local_trees = last_tree - cmesh->first_tree + 1;
-    /* Compute the tree offset */
-    t8_cmesh_gather_treecount_nocommit (cmesh, comm);
-    /* Set the tree offsets to the cmesh's offset array */
+    t8_cmesh_partition_uniform_offsets (cmesh, cmesh_from,
+                                        cmesh->set_partition_level, comm);
     tree_offsets = t8_shmem_array_get_gloidx_array (cmesh->tree_offsets);
+    cmesh->first_tree_shared = tree_offsets[cmesh->mpirank] < 0;
+    cmesh->first_tree = t8_offset_first (cmesh->mpirank, tree_offsets);
+    cmesh->num_local_trees =
+      t8_offset_num_trees (cmesh->mpirank, tree_offsets);
   }
   else {
     /* We compute the partition after a given partition table in cmesh->tree_offsets */
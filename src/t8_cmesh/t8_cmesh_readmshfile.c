@@ -25,6 +25,7 @@
 #include <t8_cmesh_vtk.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_stash.h"
+#include "t8_cmesh_faces.h"
 
 /* The supported number of gmesh tree classes.
  * Currently, we only support first order trees.
@@ -114,6 +115,194 @@ t8_cmesh_msh_read_next_line (char **line, size_t * n, FILE * fp)
   return retval;
 }
 
+/* The format of a .msh file as given in its $MeshFormat section */
+typedef struct
+{
+  int                 version;  /* The major version number, 2 or 4 */
+  int                 binary;   /* True if the file is stored in binary */
+  int                 swap;     /* True if the byte order of the file differs from ours */
+  int                 data_size;        /* The size of a size_t in a version 4 file,
+                                           the size of a double in a version 2 file */
+} t8_msh_file_format_t;
+
+/* Search the line that starts with a section name such as "$Nodes".
+ * Since we compare whole lines, this also works for binary files.
+ * On success fp points to the line after the section name.
+ * Return 0 on success and -1 if the section was not found. */
+static int
+t8_msh_file_find_section (FILE * fp, const char *section)
+{
+  char               *line = NULL;
+  size_t              linen = 0, length = strlen (section);
+  ssize_t             retval;
+
+  while ((retval = getline (&line, &linen, fp)) >= 0) {
+    if (!strncmp (line, section, length)
+        && strspn (line + length, " \t\r\n") == strlen (line + length)) {
+      free (line);
+      return 0;
+    }
+  }
+  free (line);
+  return -1;
+}
+
+/* Read the $MeshFormat section of an open .msh file.
+ * Return 0 on success and -1 if the format is not supported.
+ * On success fp points behind the $MeshFormat section. */
+static int
+t8_msh_file_read_format (FILE * fp, t8_msh_file_format_t * format)
+{
+  char               *line = (char *) malloc (1024);
+  size_t              linen = 1024;
+  double              version;
+  int                 file_type, one;
+
+  fseek (fp, 0, SEEK_SET);
+  if (t8_msh_file_find_section (fp, "$MeshFormat")
+      || t8_cmesh_msh_read_next_line (&line, &linen, fp) < 0
+      || sscanf (line, "%lf %i %i", &version, &file_type,
+                 &format->data_size) != 3) {
+    t8_global_errorf ("Could not read the $MeshFormat section.\n");
+    free (line);
+    return -1;
+  }
+  free (line);
+  format->version = (int) version;
+  format->binary = file_type == 1;
+  format->swap = 0;
+  if ((format->version != 2 && version != 4.1)
+      || (format->version == 2 && format->data_size != sizeof (double))
+      || (format->version == 4 && format->data_size != 4
+          && format->data_size != 8)) {
+    t8_global_errorf ("The .msh file format %g with data size %i is not "
+                      "supported.\n", version, format->data_size);
+    return -1;
+  }
+  if (format->binary) {
+    /* Binary files store the integer 1 to detect the byte order */
+    if (fread (&one, sizeof (int), 1, fp) != 1) {
+      t8_global_errorf ("Could not read the $MeshFormat section.\n");
+      return -1;
+    }
+    if (one != 1) {
+      format->swap = 1;
+    }
+  }
+  return 0;
+}
+
+/* Reverse the byte order of count values of size bytes each */
+static void
+t8_msh_file_swap_bytes (void *data, size_t size, size_t count)
+{
+  char               *bytes = (char *) data, temp;
+  size_t              ivalue, ibyte;
+
+  for (ivalue = 0; ivalue < count; ivalue++, bytes += size) {
+    for (ibyte = 0; ibyte < size / 2; ibyte++) {
+      temp = bytes[ibyte];
+      bytes[ibyte] = bytes[size - 1 - ibyte];
+      bytes[size - 1 - ibyte] = temp;
+    }
+  }
+}
+
+/* Read count ints from a .msh file. In a binary file all values are read
+ * with one call to fread.
+ * Return 0 on success and -1 on failure. */
+static int
+t8_msh_file_read_ints (FILE * fp, const t8_msh_file_format_t * format,
+                       int *values, size_t count)
+{
+  size_t              ivalue;
+
+  if (format->binary) {
+    if (fread (values, sizeof (int), count, fp) != count) {
+      return -1;
+    }
+    if (format->swap) {
+      t8_msh_file_swap_bytes (values, sizeof (int), count);
+    }
+    return 0;
+  }
+  for (ivalue = 0; ivalue < count; ivalue++) {
+    if (fscanf (fp, "%i", values + ivalue) != 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Read count values of type size_t from a version 4 .msh file and
+ * store them as long. In a binary file all values are read with one
+ * call to fread.
+ * Return 0 on success and -1 on failure. */
+static int
+t8_msh_file_read_sizes (FILE * fp, const t8_msh_file_format_t * format,
+                        long *values, size_t count)
+{
+  size_t              ivalue;
+  char               *buffer;
+  uint64_t            value64;
+  uint32_t            value32;
+
+  if (format->binary) {
+    buffer = T8_ALLOC (char, SC_MAX (count, 1) * format->data_size);
+    if (fread (buffer, format->data_size, count, fp) != count) {
+      T8_FREE (buffer);
+      return -1;
+    }
+    if (format->swap) {
+      t8_msh_file_swap_bytes (buffer, format->data_size, count);
+    }
+    for (ivalue = 0; ivalue < count; ivalue++) {
+      if (format->data_size == 8) {
+        memcpy (&value64, buffer + 8 * ivalue, 8);
+        values[ivalue] = (long) value64;
+      }
+      else {
+        memcpy (&value32, buffer + 4 * ivalue, 4);
+        values[ivalue] = (long) value32;
+      }
+    }
+    T8_FREE (buffer);
+    return 0;
+  }
+  for (ivalue = 0; ivalue < count; ivalue++) {
+    if (fscanf (fp, "%li", values + ivalue) != 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Read count doubles from a .msh file. In a binary file all values are
+ * read with one call to fread.
+ * Return 0 on success and -1 on failure. */
+static int
+t8_msh_file_read_doubles (FILE * fp, const t8_msh_file_format_t * format,
+                          double *values, size_t count)
+{
+  size_t              ivalue;
+
+  if (format->binary) {
+    if (fread (values, sizeof (double), count, fp) != count) {
+      return -1;
+    }
+    if (format->swap) {
+      t8_msh_file_swap_bytes (values, sizeof (double), count);
+    }
+    return 0;
+  }
+  for (ivalue = 0; ivalue < count; ivalue++) {
+    if (fscanf (fp, "%lf", values + ivalue) != 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 /* The nodes are stored in the .msh file in the format
  *
  * $Nodes
@@ -129,7 +318,7 @@ t8_cmesh_msh_read_next_line (char **line, size_t * n, FILE * fp)
  */
 typedef struct
 {
-  t8_locidx_t         index;
+  long                index;
   double              coordinates[3];
 } t8_msh_file_node_t;
 
@@ -171,45 +360,143 @@ t8_msh_file_node_compare (const void *node_a, const void *node_b,
   return Node_a->index == Node_b->index;
 }
 
+/* Read the nodes of a version 2 binary .msh file into a hash table.
+ * Each node is stored as an int index followed by three doubles and we
+ * read all nodes with one call to fread. */
+static int
+t8_msh_file_read_nodes_binary (FILE * fp,
+                               const t8_msh_file_format_t * format,
+                               t8_locidx_t num_nodes, sc_hash_t * node_table,
+                               sc_mempool_t * node_mempool)
+{
+  t8_msh_file_node_t *Node;
+  const size_t        record_size = sizeof (int) + 3 * sizeof (double);
+  char               *buffer;
+  t8_locidx_t         ln;
+  int                 index, retval;
+
+  buffer = T8_ALLOC (char, SC_MAX (num_nodes, 1) * record_size);
+  if (fread (buffer, record_size, num_nodes, fp) != (size_t) num_nodes) {
+    t8_global_errorf ("Error reading the binary nodes.\n");
+    T8_FREE (buffer);
+    return -1;
+  }
+  for (ln = 0; ln < num_nodes; ln++) {
+    Node = (t8_msh_file_node_t *) sc_mempool_alloc (node_mempool);
+    memcpy (&index, buffer + ln * record_size, sizeof (int));
+    memcpy (Node->coordinates, buffer + ln * record_size + sizeof (int),
+            3 * sizeof (double));
+    if (format->swap) {
+      t8_msh_file_swap_bytes (&index, sizeof (int), 1);
+      t8_msh_file_swap_bytes (Node->coordinates, sizeof (double), 3);
+    }
+    Node->index = index;
+    retval = sc_hash_insert_unique (node_table, Node, NULL);
+    T8_ASSERT (retval);
+  }
+  T8_FREE (buffer);
+  return 0;
+}
+
+/* Read the node blocks of a version 4 .msh file into a hash table.
+ * The file pointer must point behind the header of the $Nodes section.
+ * Each block has the format
+ *
+ * entity_dim entity_tag parametric num_nodes_in_block
+ * tag_1
+ * ...
+ * tag_n
+ * x_1 y_1 z_1
+ * ...
+ * x_n y_n z_n
+ *
+ * where the coordinates are followed by entity_dim parametric coordinates
+ * if parametric is true.
+ * In a binary file, we read the tags and the coordinates of a block with
+ * one call to fread each. */
+static int
+t8_msh_file_read_nodes_v4 (FILE * fp, const t8_msh_file_format_t * format,
+                           long num_blocks, sc_hash_t * node_table,
+                           sc_mempool_t * node_mempool)
+{
+  t8_msh_file_node_t *Node;
+  long                iblock, num_block_nodes, inode, *tags;
+  double             *coordinates;
+  int                 block_header[3], num_coordinates, retval;
+
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    /* Read the entity dimension and tag, whether the nodes
+     * are parametric and the number of nodes */
+    if (t8_msh_file_read_ints (fp, format, block_header, 3)
+        || t8_msh_file_read_sizes (fp, format, &num_block_nodes, 1)) {
+      t8_global_errorf ("Error reading node block %li\n", iblock);
+      return -1;
+    }
+    num_coordinates = 3 + (block_header[2] ? block_header[0] : 0);
+    tags = T8_ALLOC (long, SC_MAX (num_block_nodes, 1));
+    coordinates =
+      T8_ALLOC (double, SC_MAX (num_block_nodes, 1) * num_coordinates);
+    if (t8_msh_file_read_sizes (fp, format, tags, num_block_nodes)
+        || t8_msh_file_read_doubles (fp, format, coordinates,
+                                     num_block_nodes * num_coordinates)) {
+      t8_global_errorf ("Error reading node block %li\n", iblock);
+      T8_FREE (tags);
+      T8_FREE (coordinates);
+      return -1;
+    }
+    for (inode = 0; inode < num_block_nodes; inode++) {
+      Node = (t8_msh_file_node_t *) sc_mempool_alloc (node_mempool);
+      Node->index = tags[inode];
+      memcpy (Node->coordinates, coordinates + inode * num_coordinates,
+              3 * sizeof (double));
+      retval = sc_hash_insert_unique (node_table, Node, NULL);
+      T8_ASSERT (retval);
+    }
+    T8_FREE (tags);
+    T8_FREE (coordinates);
+  }
+  return 0;
+}
+
 /* Read an open .msh file and parse the nodes into a hash table.
  */
 static sc_hash_t   *
-t8_msh_file_read_nodes (FILE * fp, t8_locidx_t * num_nodes,
-                        sc_mempool_t ** node_mempool)
+t8_msh_file_read_nodes (FILE * fp, const t8_msh_file_format_t * format,
+                        t8_locidx_t * num_nodes, sc_mempool_t ** node_mempool)
 {
   t8_msh_file_node_t *Node;
   sc_hash_t          *node_table = NULL;
-  t8_locidx_t         ln, last_index;
+  t8_locidx_t         ln;
+  long                last_index;
   char               *line = (char *) malloc (1024);
-  char                first_word[2048] = "\0";
   size_t              linen = 1024;
   int                 retval;
-  long                index, lnum_nodes;
+  long                index, lnum_nodes, header[4];
 
   T8_ASSERT (fp != NULL);
   /* Go to the beginning of the file */
   fseek (fp, 0, SEEK_SET);
   /* Search for the line beginning with "$Nodes" */
-  while (!feof (fp) && strcmp (first_word, "$Nodes")) {
-    (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-    /* Get the first word of this line */
-    retval = sscanf (line, "%2048s", first_word);
-
-    /* Checking for read/write error */
-    if (retval != 1) {
-      t8_global_errorf ("Premature end of line while reading num nodes.\n");
-      t8_debugf ("The line is %s", line);
-      goto die_node;
-    }
+  if (t8_msh_file_find_section (fp, "$Nodes")) {
+    t8_global_errorf ("Could not find the $Nodes section.\n");
+    goto die_node;
   }
 
-  /* Read the line containing the number of nodes */
-  (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-  /* Read the number of nodes in a long int before converting it
-   * to t8_locidx_t. */
-  retval = sscanf (line, "%li", &lnum_nodes);
+  if (format->version == 4) {
+    /* The header of the section consists of the number of blocks,
+     * the number of nodes and the minimum and maximum node tag */
+    retval = t8_msh_file_read_sizes (fp, format, header, 4);
+    lnum_nodes = header[1];
+  }
+  else {
+    /* Read the line containing the number of nodes. */
+    (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
+    /* Read the number of nodes in a long int before converting it
+     * to t8_locidx_t. */
+    retval = sscanf (line, "%li", &lnum_nodes) != 1;
+  }
   /* Checking for read/write error */
-  if (retval != 1) {
+  if (retval) {
     t8_global_errorf ("Premature end of line while reading num nodes.\n");
     t8_debugf ("The line is %s", line);
     goto die_node;
@@ -224,6 +511,25 @@ t8_msh_file_read_nodes (FILE * fp, t8_locidx_t * num_nodes,
   node_table = sc_hash_new (t8_msh_file_node_hash, t8_msh_file_node_compare,
                             num_nodes, NULL);
 
+  if (format->version == 4) {
+    if (t8_msh_file_read_nodes_v4 (fp, format, header[0], node_table,
+                                   *node_mempool)) {
+      goto die_node;
+    }
+    free (line);
+    t8_debugf ("Successfully read all Nodes.\n");
+    return node_table;
+  }
+  if (format->binary) {
+    if (t8_msh_file_read_nodes_binary (fp, format, *num_nodes, node_table,
+                                       *node_mempool)) {
+      goto die_node;
+    }
+    free (line);
+    t8_debugf ("Successfully read all Nodes.\n");
+    return node_table;
+  }
+
   /* read each node and add it to the hash table */
   last_index = 0;
   for (ln = 0; ln < *num_nodes; ln++) {
@@ -246,8 +552,6 @@ t8_msh_file_read_nodes (FILE * fp, t8_locidx_t * num_nodes,
       goto die_node;
     }
     Node->index = index;
-    /* Check for type conversion error */
-    T8_ASSERT (Node->index == index);
     /* Insert the node in the hash table */
     retval = sc_hash_insert_unique (node_table, Node, NULL);
     /* If retval is zero then the node was already in the hash table.
@@ -267,7 +571,7 @@ die_node:
   if (node_table != NULL) {
     sc_hash_destroy (node_table);
     sc_mempool_destroy (*node_mempool);
-    node_mempool = NULL;
+    *node_mempool = NULL;
   }
   /* Free memory */
   free (line);
@@ -275,42 +579,250 @@ die_node:
   return NULL;
 }
 
+/* Add a tree read from a .msh file to the cmesh.
+ * node_indices are the indices of its nodes in .msh order.
+ * If vertex_indices is not NULL, the node indices in t8code order are
+ * appended to it.
+ * Return 0 on success and -1 if a node was not found. */
+static int
+t8_cmesh_msh_file_add_tree (t8_cmesh_t cmesh, sc_hash_t * vertices,
+                            t8_gloidx_t tree_id, t8_eclass_t eclass,
+                            const long *node_indices,
+                            sc_array_t * vertex_indices)
+{
+  t8_msh_file_node_t  Node, **found_node;
+  long               *stored_indices;
+  double              tree_vertices[24];
+  int                 i, num_nodes, t8_vertex_num;
+
+  t8_cmesh_set_tree_class (cmesh, tree_id, eclass);
+  num_nodes = t8_eclass_num_vertices[eclass];
+  /* Get the coordinates of the nodes from the stored nodes */
+  for (i = 0; i < num_nodes; i++) {
+    Node.index = node_indices[i];
+    if (!sc_hash_lookup (vertices, (void *) &Node, (void ***) &found_node)) {
+      t8_global_errorf ("Node %li of tree %li was not found.\n",
+                        node_indices[i], (long) tree_id);
+      return -1;
+    }
+    /* Add node coordinates to the tree vertices */
+    t8_vertex_num = t8_msh_tree_vertex_to_t8_vertex_num[eclass][i];
+    tree_vertices[3 * t8_vertex_num] = (*found_node)->coordinates[0];
+    tree_vertices[3 * t8_vertex_num + 1] = (*found_node)->coordinates[1];
+    tree_vertices[3 * t8_vertex_num + 2] = (*found_node)->coordinates[2];
+  }
+  if (t8_cmesh_tree_vertices_negative_volume (eclass, tree_vertices,
+                                              num_nodes)) {
+    /* The volume described is negative. We need to switch two
+     * vertices. */
+    double              temp;
+    T8_ASSERT (t8_eclass_to_dimension[eclass] == 3);
+    t8_debugf ("Correcting negative volume of tree %li\n", (long) tree_id);
+    /* We switch vertex 0 and vertex 1 */
+    for (i = 0; i < 3; i++) {
+      temp = tree_vertices[i];
+      tree_vertices[i] = tree_vertices[3 + i];
+      tree_vertices[3 + i] = temp;
+    }
+    T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
+               (eclass, tree_vertices, num_nodes));
+  }
+  /* Set the vertices of this tree */
+  t8_cmesh_set_tree_vertices (cmesh, tree_id, t8_get_package_id (),
+                              0, tree_vertices, num_nodes);
+  /* If wished, we store the vertex indices of that tree. */
+  if (vertex_indices != NULL) {
+    /* Allocate memory for the inices */
+    stored_indices = T8_ALLOC (long, num_nodes);
+    for (i = 0; i < num_nodes; i++) {
+      /* Get the i-th node index in t8code order and store it. */
+      stored_indices[i] =
+        node_indices[t8_vertex_to_msh_vertex_num[eclass][i]];
+    }
+    /* Set the index array as a new entry in the array */
+    *(long **) sc_array_push (vertex_indices) = stored_indices;
+  }
+  return 0;
+}
+
+/* Translate a gmsh element type to a t8code eclass.
+ * Return T8_ECLASS_COUNT if the type is not supported. */
+static              t8_eclass_t
+t8_msh_file_element_type_to_eclass (long ele_type)
+{
+  if (ele_type > T8_NUM_GMSH_ELEM_CLASSES || ele_type < 0
+      || t8_msh_tree_type_to_eclass[ele_type] == T8_ECLASS_COUNT) {
+    t8_global_errorf ("tree type %li is not supported by t8code.\n",
+                      ele_type);
+    return T8_ECLASS_COUNT;
+  }
+  return t8_msh_tree_type_to_eclass[ele_type];
+}
+
+/* Read the elements of a version 2 binary .msh file.
+ * The elements are stored in blocks of elements of the same type with
+ * the header
+ *
+ * element_type num_elements_in_block num_tags
+ *
+ * followed by num_elements_in_block records of ints
+ *
+ * element_number tag_1 ... tag_n node_1 ... node_m
+ *
+ * We read each block with one call to fread. */
+static int
+t8_cmesh_msh_file_read_eles_binary (t8_cmesh_t cmesh, FILE * fp,
+                                    const t8_msh_file_format_t * format,
+                                    long num_trees, sc_hash_t * vertices,
+                                    sc_array_t * vertex_indices, int dim)
+{
+  t8_eclass_t         eclass;
+  t8_gloidx_t         tree_count = 0;
+  long                tree_loop = 0, node_indices[8];
+  int                 block_header[3], *records, record_size;
+  int                 num_nodes, iele, i, *record;
+
+  while (tree_loop < num_trees) {
+    if (t8_msh_file_read_ints (fp, format, block_header, 3)) {
+      t8_global_errorf ("Premature end of file while reading trees.\n");
+      return -1;
+    }
+    eclass = t8_msh_file_element_type_to_eclass (block_header[0]);
+    if (eclass == T8_ECLASS_COUNT) {
+      return -1;
+    }
+    num_nodes = t8_eclass_num_vertices[eclass];
+    record_size = 1 + block_header[2] + num_nodes;
+    records = T8_ALLOC (int, SC_MAX (block_header[1], 1) * record_size);
+    if (t8_msh_file_read_ints (fp, format, records,
+                               block_header[1] * record_size)) {
+      t8_global_errorf ("Premature end of file while reading trees.\n");
+      T8_FREE (records);
+      return -1;
+    }
+    if (t8_eclass_to_dimension[eclass] == dim) {
+      for (iele = 0; iele < block_header[1]; iele++) {
+        /* Skip the element number and the tags */
+        record = records + iele * record_size + 1 + block_header[2];
+        for (i = 0; i < num_nodes; i++) {
+          node_indices[i] = record[i];
+        }
+        if (t8_cmesh_msh_file_add_tree (cmesh, vertices, tree_count++,
+                                        eclass, node_indices,
+                                        vertex_indices)) {
+          T8_FREE (records);
+          return -1;
+        }
+      }
+    }
+    T8_FREE (records);
+    tree_loop += block_header[1];
+  }
+  return 0;
+}
+
+/* Read the element blocks of a version 4 .msh file. The file pointer
+ * must point behind the header of the $Elements section.
+ * Each block has the format
+ *
+ * entity_dim entity_tag element_type num_elements_in_block
+ * element_tag node_1 ... node_m
+ * ...
+ *
+ * In a binary file, we read the elements of a block with one call
+ * to fread. */
+static int
+t8_cmesh_msh_file_read_eles_v4 (t8_cmesh_t cmesh, FILE * fp,
+                                const t8_msh_file_format_t * format,
+                                long num_blocks, sc_hash_t * vertices,
+                                sc_array_t * vertex_indices, int dim)
+{
+  t8_eclass_t         eclass;
+  t8_gloidx_t         tree_count = 0;
+  long                iblock, num_block_elements, iele, *records;
+  int                 block_header[3], num_nodes;
+
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    /* Read the entity dimension and tag, the element type
+     * and the number of elements */
+    if (t8_msh_file_read_ints (fp, format, block_header, 3)
+        || t8_msh_file_read_sizes (fp, format, &num_block_elements, 1)) {
+      t8_global_errorf ("Error reading element block %li\n", iblock);
+      return -1;
+    }
+    eclass = t8_msh_file_element_type_to_eclass (block_header[2]);
+    if (eclass == T8_ECLASS_COUNT) {
+      return -1;
+    }
+    num_nodes = t8_eclass_num_vertices[eclass];
+    records = T8_ALLOC (long, SC_MAX (num_block_elements, 1)
+                        * (1 + num_nodes));
+    if (t8_msh_file_read_sizes (fp, format, records,
+                                num_block_elements * (1 + num_nodes))) {
+      t8_global_errorf ("Error reading element block %li\n", iblock);
+      T8_FREE (records);
+      return -1;
+    }
+    if (t8_eclass_to_dimension[eclass] == dim) {
+      for (iele = 0; iele < num_block_elements; iele++) {
+        /* Skip the element tag */
+        if (t8_cmesh_msh_file_add_tree (cmesh, vertices, tree_count++,
+                                        eclass,
+                                        records + iele * (1 + num_nodes) + 1,
+                                        vertex_indices)) {
+          T8_FREE (records);
+          return -1;
+        }
+      }
+    }
+    T8_FREE (records);
+  }
+  return 0;
+}
+
 /* fp should be set after the Nodes section, right before the tree section.
  * If vertex_indices is not NULL, it is allocated and will store
  * for each tree the indices of its vertices.
  * They are stored as arrays of long ints. */
-int
+static int
 t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
+                             const t8_msh_file_format_t * format,
                              sc_hash_t * vertices,
                              sc_array_t ** vertex_indices, int dim)
 {
   char               *line = (char *) malloc (1024), *line_modify;
-  char                first_word[2048] = "\0";
   size_t              linen = 1024;
   t8_locidx_t         num_trees, tree_loop;
   t8_gloidx_t         tree_count;
   t8_eclass_t         eclass;
-  t8_msh_file_node_t  Node, **found_node;
-  long                lnum_trees;
+  long                lnum_trees, header[4];
   int                 retval, i;
   int                 ele_type, num_tags;
-  int                 num_nodes, t8_vertex_num;
-  long                node_indices[8], *stored_indices;
-  double              tree_vertices[24];
+  int                 num_nodes;
+  long                node_indices[8];
+  sc_array_t         *indices = NULL;
 
   T8_ASSERT (fp != NULL);
+  if (vertex_indices != NULL) {
+    /* We store a list of the vertex indices for each element */
+    *vertex_indices = indices = sc_array_new (sizeof (long *));
+  }
   /* Search for the line beginning with "$Elements" */
-  while (!feof (fp) && strcmp (first_word, "$Elements")) {
-    (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-    /* Get the first word of this line */
-    retval = sscanf (line, "%2048s", first_word);
+  if (t8_msh_file_find_section (fp, "$Elements")) {
+    t8_global_errorf ("Could not find the $Elements section.\n");
+    goto die_ele;
+  }
 
-    /* Checking for read/write error */
-    if (retval != 1) {
-      t8_global_errorf ("Premature end of line while reading num trees.\n");
-      t8_debugf ("The line is %s", line);
+  if (format->version == 4) {
+    /* The header of the section consists of the number of blocks,
+     * the number of elements and the minimum and maximum element tag */
+    if (t8_msh_file_read_sizes (fp, format, header, 4)
+        || t8_cmesh_msh_file_read_eles_v4 (cmesh, fp, format, header[0],
+                                           vertices, indices, dim)) {
       goto die_ele;
     }
+    free (line);
+    return 0;
   }
 
   /* Read the line containing the number of trees */
@@ -328,10 +840,15 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
   /* Check for type conversion error */
   T8_ASSERT (num_trees == lnum_trees);
 
-  if (vertex_indices != NULL) {
-    /* We store a list of the vertex indices for each element */
-    *vertex_indices = sc_array_new (sizeof (long *));
+  if (format->binary) {
+    if (t8_cmesh_msh_file_read_eles_binary (cmesh, fp, format, num_trees,
+                                            vertices, indices, dim)) {
+      goto die_ele;
+    }
+    free (line);
+    return 0;
   }
+
   tree_count = 0;               /* The index of the next tree to insert */
   for (tree_loop = 0; tree_loop < num_trees; tree_loop++) {
     /* Read the next line containing tree information */
@@ -349,20 +866,14 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
      */
     sscanf (line, "%*i %i %i", &ele_type, &num_tags);
     /* Check if the tree type is supported */
-    if (ele_type > T8_NUM_GMSH_ELEM_CLASSES || ele_type < 0
-        || t8_msh_tree_type_to_eclass[ele_type] == T8_ECLASS_COUNT) {
-      t8_global_errorf ("tree type %i is not supported by t8code.\n",
-                        ele_type);
+    eclass = t8_msh_file_element_type_to_eclass (ele_type);
+    if (eclass == T8_ECLASS_COUNT) {
       goto die_ele;
     }
-    /* Continue if tree type is supported */
-    eclass = t8_msh_tree_type_to_eclass[ele_type];
-    T8_ASSERT (eclass != T8_ECLASS_COUNT);
     /* Check if the tree is of the correct dimension */
     if (t8_eclass_to_dimension[eclass] == dim) {
       /* The tree is of the correct dimension,
        * add it to the cmesh and read its nodes */
-      t8_cmesh_set_tree_class (cmesh, tree_count, eclass);
       line_modify = line;
       /* Since the tags are stored before the node indices, we need to
        * skip them first. But since the number of them is unknown and the
@@ -385,47 +896,10 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
         /* move line_modify to the next word in the line */
         (void) strsep (&line_modify, " ");
       }
-      /* Now the nodes are read and we get their coordinates from
-       * the stored nodes */
-      for (i = 0; i < num_nodes; i++) {
-        Node.index = node_indices[i];
-        sc_hash_lookup (vertices, (void *) &Node, (void ***) &found_node);
-        /* Add node coordinates to the tree vertices */
-        t8_vertex_num = t8_msh_tree_vertex_to_t8_vertex_num[eclass][i];
-        tree_vertices[3 * t8_vertex_num] = (*found_node)->coordinates[0];
-        tree_vertices[3 * t8_vertex_num + 1] = (*found_node)->coordinates[1];
-        tree_vertices[3 * t8_vertex_num + 2] = (*found_node)->coordinates[2];
-      }
-      if (t8_cmesh_tree_vertices_negative_volume (eclass, tree_vertices,
-                                                  num_nodes)) {
-        /* The volume described is negative. We need to switch two
-         * vertices. */
-        double              temp;
-        T8_ASSERT (t8_eclass_to_dimension[eclass] == 3);
-        t8_debugf ("Correcting negative volume of tree %li\n", tree_count);
-        /* We switch vertex 0 and vertex 1 */
-        for (i = 0; i < 3; i++) {
-          temp = tree_vertices[i];
-          tree_vertices[i] = tree_vertices[3 + i];
-          tree_vertices[3 + i] = temp;
-        }
-        T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
-                   (eclass, tree_vertices, num_nodes));
-      }
-      /* Set the vertices of this tree */
-      t8_cmesh_set_tree_vertices (cmesh, tree_count, t8_get_package_id (),
-                                  0, tree_vertices, num_nodes);
-      /* If wished, we store the vertex indices of that tree. */
-      if (vertex_indices != NULL) {
-        /* Allocate memory for the inices */
-        stored_indices = T8_ALLOC (long, t8_eclass_num_vertices[eclass]);
-        for (i = 0; i < t8_eclass_num_vertices[eclass]; i++) {
-          /* Get the i-th node index in t8code order and store it. */
-          stored_indices[i] =
-            node_indices[t8_vertex_to_msh_vertex_num[eclass][i]];
-        }
-        /* Set the index array as a new entry in the array */
-        *(long **) sc_array_push (*vertex_indices) = stored_indices;
+      /* Now the nodes are read and we add the tree to the cmesh */
+      if (t8_cmesh_msh_file_add_tree (cmesh, vertices, tree_count,
+                                      eclass, node_indices, indices)) {
+        goto die_ele;
       }
       /* advance the tree counter */
       tree_count++;
@@ -436,7 +910,6 @@ t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
 die_ele:
   /* Error handling */
   free (line);
-  t8_cmesh_destroy (&cmesh);
   return -1;
 }
 
@@ -445,7 +918,7 @@ die_ele:
  */
 typedef struct
 {
-  t8_locidx_t         ltree_id; /* The local id of the tree this face belongs to */
+  t8_gloidx_t         tree_id;  /* The global id of the tree this face belongs to */
   int8_t              face_number;      /* The number of that face whitin the tree */
   int                 num_vertices;     /* The number of vertices of this face. */
   long               *vertices; /* The indices of these vertices. */
@@ -526,7 +999,7 @@ t8_msh_file_face_set_boundary (void **face, const void *data)
   Face = *(t8_msh_file_face_t **) face;
 
   /* Get the global tree id */
-  gtree_id = Face->ltree_id;
+  gtree_id = Face->tree_id;
   /* Set the Face as a domain boundary */
   t8_cmesh_set_join (cmesh, gtree_id, gtree_id, Face->face_number,
                      Face->face_number, 0);
@@ -565,7 +1038,7 @@ t8_msh_file_face_orientation (t8_msh_file_face_t * Face_a,
   else {
     /* both classes are the same, thus
      * the face with the smaller tree id is the smaller one */
-    if (Face_a->ltree_id < Face_b->ltree_id) {
+    if (Face_a->tree_id < Face_b->tree_id) {
       smaller_Face = Face_a;
       bigger_Face = Face_b;
       bigger_class =
@@ -648,7 +1121,7 @@ t8_cmesh_msh_file_find_neighbors (t8_cmesh_t cmesh,
       num_face_vertices = t8_eclass_num_vertices[face_class];
       Face->vertices = T8_ALLOC (long, num_face_vertices);
       Face->num_vertices = num_face_vertices;
-      Face->ltree_id = gtree_it;
+      Face->tree_id = gtree_it;
       Face->face_number = face_it;
       /* Copy the vertices of the face to the face struct */
       for (vertex_it = 0; vertex_it < num_face_vertices; vertex_it++) {
@@ -661,17 +1134,17 @@ t8_cmesh_msh_file_find_neighbors (t8_cmesh_t cmesh,
       if (!retval) {
         /* The face was already in the hash */
         Neighbor = *pNeighbor;
-        T8_ASSERT (Neighbor->ltree_id != gtree_it);
-        /* The current tree is a neighbor to the tree Neighbor->ltree_id */
+        T8_ASSERT (Neighbor->tree_id != gtree_it);
+        /* The current tree is a neighbor to the tree Neighbor->tree_id */
         /* We need to identify the face number and the orientation */
         gtree_id = gtree_it;
-        gtree_neighbor = Neighbor->ltree_id;
+        gtree_neighbor = Neighbor->tree_id;
         /* Compute the orientation of the face connection */
         /* Get the element class of the neighbor tree */
         class_entry = (t8_stash_class_struct_t *)
           t8_sc_array_index_locidx (&cmesh->stash->classes,
-                                    Neighbor->ltree_id);
-        T8_ASSERT (class_entry->id == Neighbor->ltree_id);
+                                    Neighbor->tree_id);
+        T8_ASSERT (class_entry->id == Neighbor->tree_id);
         neighbor_tclass = class_entry->eclass;
         /* Calculate the orientation */
         orientation = t8_msh_file_face_orientation (Face, Neighbor, eclass,
@@ -697,12 +1170,1039 @@ t8_cmesh_msh_file_find_neighbors (t8_cmesh_t cmesh,
   t8_debugf ("Done finding tree neighbors.\n");
 }
 
+/* In the parallel reader each process reads a part of the $Nodes and
+ * the $Elements section of an ASCII .msh file.
+ * Each section is divided into byte ranges of equal size and a process
+ * parses all lines that begin in its range.
+ * The nodes are then distributed such that node i is stored on process
+ * i % mpisize. Each process requests the coordinates of the nodes of its
+ * elements from these processes.
+ * The trees of a process are the elements that it parsed, thus
+ * the trees are numbered in the order of the file as in the serial reader.
+ * To find the face neighbors, each face is sent to a process determined by
+ * its vertices. This process matches the faces of neighboring trees and
+ * sends the face connection back to the owners of these trees.
+ * Finally, each process requests the face connections of its ghosts
+ * from their owners.
+ */
+
+/* The sections of a .msh file that we need to find */
+enum
+{
+  T8_MSH_FILE_NODES = 0,
+  T8_MSH_FILE_END_NODES,
+  T8_MSH_FILE_ELEMENTS,
+  T8_MSH_FILE_END_ELEMENTS,
+  T8_MSH_FILE_NUM_SECTIONS
+};
+
+static const char  *t8_msh_file_section_names[T8_MSH_FILE_NUM_SECTIONS] = {
+  "$Nodes", "$EndNodes", "$Elements", "$EndElements"
+};
+
+/* The longest section name plus the whitespace behind it */
+#define T8_MSH_FILE_SECTION_OVERLAP 16
+
+/* An element that was read by the parallel reader */
+typedef struct
+{
+  t8_eclass_t         eclass;
+  long                nodes[8]; /* The node indices in .msh order */
+} t8_msh_file_element_t;
+
+/* Compare two nodes by their index */
+static int
+t8_msh_file_node_compare_index (const void *node_a, const void *node_b)
+{
+  const long          index_a = ((const t8_msh_file_node_t *) node_a)->index;
+  const long          index_b = ((const t8_msh_file_node_t *) node_b)->index;
+
+  return index_a < index_b ? -1 : index_a > index_b;
+}
+
+/* Compare two longs */
+static int
+t8_msh_file_long_compare (const void *a, const void *b)
+{
+  const long          la = *(const long *) a;
+  const long          lb = *(const long *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+/* Find the positions of the section names of a .msh file.
+ * Each process searches its share of the file and the results are
+ * combined. On output sections[i] is the position of the i-th section
+ * name, file_size if it was not found and -1 if a read error occured
+ * on any process.
+ * This function is collective. */
+static void
+t8_msh_file_find_sections (FILE * fp, long long file_size, int mpirank,
+                           int mpisize, sc_MPI_Comm comm,
+                           long long *sections)
+{
+  long long           local_sections[T8_MSH_FILE_NUM_SECTIONS];
+  long long           begin, end, read_begin;
+  size_t              length, ipos, name_length;
+  char               *buffer, next;
+  int                 isec, mpiret;
+
+  for (isec = 0; isec < T8_MSH_FILE_NUM_SECTIONS; isec++) {
+    local_sections[isec] = file_size;
+  }
+  begin = file_size * mpirank / mpisize;
+  end = file_size * (mpirank + 1) / mpisize;
+  if (fp == NULL) {
+    local_sections[0] = -1;
+  }
+  else if (begin < end) {
+    /* We also read the character before our range, to know whether a line
+     * starts at begin, and enough characters after our range to complete
+     * a section name that starts in it. */
+    read_begin = SC_MAX (begin - 1, 0);
+    length = (size_t) (SC_MIN (end + T8_MSH_FILE_SECTION_OVERLAP, file_size)
+                       - read_begin);
+    buffer = T8_ALLOC (char, length + 1);
+    if (fseek (fp, read_begin, SEEK_SET)
+        || fread (buffer, 1, length, fp) != length) {
+      local_sections[0] = -1;
+    }
+    else {
+      buffer[length] = '\0';
+      for (ipos = begin - read_begin; read_begin + (long long) ipos < end;
+           ipos++) {
+        if (buffer[ipos] != '$' || (ipos > 0 && buffer[ipos - 1] != '\n')) {
+          /* No section name starts here */
+          continue;
+        }
+        for (isec = 0; isec < T8_MSH_FILE_NUM_SECTIONS; isec++) {
+          name_length = strlen (t8_msh_file_section_names[isec]);
+          next = buffer[SC_MIN (ipos + name_length, length)];
+          if (local_sections[isec] == file_size
+              && !strncmp (buffer + ipos, t8_msh_file_section_names[isec],
+                           name_length)
+              && (next == '\0' || strchr (" \t\r\n", next) != NULL)) {
+            local_sections[isec] = read_begin + ipos;
+          }
+        }
+      }
+    }
+    T8_FREE (buffer);
+  }
+  /* The first appearance of each section and -1 if any process failed */
+  mpiret = sc_MPI_Allreduce (local_sections, sections,
+                             T8_MSH_FILE_NUM_SECTIONS, sc_MPI_LONG_LONG_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Given the position of a section name, skip the section name line and
+ * the line with the number of entries. Return the position of the first
+ * entry and the number of entries, or -1 on failure. */
+static long long
+t8_msh_file_section_begin (FILE * fp, long long section, long *num_entries)
+{
+  char               *line = (char *) malloc (1024);
+  size_t              linen = 1024;
+  long long           begin = -1;
+
+  if (!fseek (fp, section, SEEK_SET)
+      && t8_cmesh_msh_read_next_line (&line, &linen, fp) >= 0
+      && t8_cmesh_msh_read_next_line (&line, &linen, fp) >= 0
+      && sscanf (line, "%li", num_entries) == 1) {
+    begin = ftell (fp);
+  }
+  free (line);
+  return begin;
+}
+
+/* Read the lines of the block [block_begin, block_end) of a file whose
+ * first character lies in this process's share of the block.
+ * The lines are returned as one string that must be freed with T8_FREE,
+ * NULL on failure. */
+static char        *
+t8_msh_file_read_block (FILE * fp, long long block_begin,
+                        long long block_end, int mpirank, int mpisize)
+{
+  long long           begin, end;
+  size_t              length, first_line, tail_length;
+  char               *buffer, *tail = NULL, *line_end;
+  size_t              tailn = 0;
+  ssize_t             retval;
+
+  begin = block_begin + (block_end - block_begin) * mpirank / mpisize;
+  end = block_begin + (block_end - block_begin) * (mpirank + 1) / mpisize;
+  T8_ASSERT (block_begin > 0);
+  /* We read the character before our range to know whether
+   * a line starts at begin */
+  length = (size_t) (end - begin + 1);
+  buffer = T8_ALLOC (char, length + 1);
+  if (begin < end && (fseek (fp, begin - 1, SEEK_SET)
+                      || fread (buffer, 1, length, fp) != length)) {
+    T8_FREE (buffer);
+    return NULL;
+  }
+  if (begin == end) {
+    buffer[0] = '\0';
+    return buffer;
+  }
+  buffer[length] = '\0';
+  /* The first line that begins in our range */
+  line_end = (char *) memchr (buffer, '\n', length);
+  first_line = line_end == NULL ? length : (size_t) (line_end - buffer) + 1;
+  memmove (buffer, buffer + first_line, length - first_line + 1);
+  length -= first_line;
+  if (length > 0 && buffer[length - 1] != '\n') {
+    /* Our last line continues behind our range */
+    retval = getline (&tail, &tailn, fp);
+    if (retval > 0) {
+      tail_length = (size_t) retval;
+      buffer = T8_REALLOC (buffer, char, length + tail_length + 1);
+      memcpy (buffer + length, tail, tail_length + 1);
+    }
+    free (tail);
+  }
+  return buffer;
+}
+
+/* Split the next line off a string of lines. The line is NUL terminated
+ * and the pointer to the remaining lines is returned. */
+static char        *
+t8_msh_file_next_line (char *lines)
+{
+  char               *line_end;
+
+  line_end = strchr (lines, '\n');
+  if (line_end == NULL) {
+    return lines + strlen (lines);
+  }
+  *line_end = '\0';
+  return line_end + 1;
+}
+
+/* Parse the node lines read by this process. Returns the number of
+ * parsed nodes, or -1 on failure. */
+static long
+t8_msh_file_parse_nodes (char *lines, sc_array_t * nodes)
+{
+  t8_msh_file_node_t *node;
+  char               *line, *next_line, *pos, *end;
+  long                num_nodes = 0;
+  int                 i;
+
+  for (line = lines; *line != '\0'; line = next_line) {
+    next_line = t8_msh_file_next_line (line);
+    if (strspn (line, " \t\r\v") == strlen (line)) {
+      /* Skip empty lines */
+      continue;
+    }
+    node = (t8_msh_file_node_t *) sc_array_push (nodes);
+    node->index = strtol (line, &end, 10);
+    for (i = 0; i < 3 && end != line; i++) {
+      pos = end;
+      node->coordinates[i] = strtod (pos, &end);
+      if (end == pos) {
+        end = line;
+      }
+    }
+    if (end == line || node->index < 0) {
+      t8_errorf ("Error reading node line %s\n", line);
+      return -1;
+    }
+    num_nodes++;
+  }
+  return num_nodes;
+}
+
+/* Parse the element lines read by this process and keep the elements of
+ * dimension dim. Returns the number of parsed elements of any
+ * dimension, or -1 on failure. */
+static long
+t8_msh_file_parse_elements (char *lines, int dim, sc_array_t * elements)
+{
+  t8_msh_file_element_t *element;
+  t8_eclass_t         eclass;
+  char               *line, *next_line, *pos, *end;
+  long                num_elements = 0, ele_type = 0, num_tags = 0;
+  int                 i, num_nodes;
+
+  for (line = lines; *line != '\0'; line = next_line) {
+    next_line = t8_msh_file_next_line (line);
+    if (strspn (line, " \t\r\v") == strlen (line)) {
+      /* Skip empty lines */
+      continue;
+    }
+    num_elements++;
+    /* The line describing the tree looks like
+     * tree_number tree_type Number_tags tag_1 ... tag_n Node_1 ... Node_m
+     * We ignore the tree number and the tags. */
+    end = line;
+    for (i = 0; i < 3; i++) {
+      pos = end;
+      ele_type = num_tags;
+      num_tags = strtol (pos, &end, 10);
+      if (end == pos) {
+        t8_errorf ("Premature end of line while reading tree %s.\n", line);
+        return -1;
+      }
+    }
+    /* Check if the tree type is supported */
+    if (ele_type > T8_NUM_GMSH_ELEM_CLASSES || ele_type < 0
+        || t8_msh_tree_type_to_eclass[ele_type] == T8_ECLASS_COUNT) {
+      t8_errorf ("tree type %li is not supported by t8code.\n", ele_type);
+      return -1;
+    }
+    eclass = t8_msh_tree_type_to_eclass[ele_type];
+    if (t8_eclass_to_dimension[eclass] != dim) {
+      continue;
+    }
+    /* Skip the tags */
+    for (i = 0; i < num_tags && end != pos; i++) {
+      pos = end;
+      (void) strtol (pos, &end, 10);
+    }
+    element = (t8_msh_file_element_t *) sc_array_push (elements);
+    element->eclass = eclass;
+    num_nodes = t8_eclass_num_vertices[eclass];
+    for (i = 0; i < num_nodes && end != pos; i++) {
+      pos = end;
+      element->nodes[i] = strtol (pos, &end, 10);
+    }
+    if (end == pos) {
+      t8_errorf ("Premature end of line while reading tree %s.\n", line);
+      return -1;
+    }
+  }
+  return num_elements;
+}
+
+/* Distribute the nodes such that node i is on process i % mpisize and
+ * answer the requests for the nodes of the local elements.
+ * On output nodes contains the coordinates of all nodes of the elements
+ * sorted by their index.
+ * Returns false if a node could not be found.
+ * This function is collective. */
+static int
+t8_msh_file_fetch_nodes (sc_MPI_Comm comm, int mpirank, int mpisize,
+                         sc_array_t * nodes, sc_array_t * elements)
+{
+  t8_msh_file_node_t *owned_nodes, *replies, *found, search;
+  t8_msh_file_element_t *element;
+  long               *requests, *recv_requests;
+  int                *dest, *recv_counts;
+  size_t              inode, num_owned, num_requests, num_recv, num_replies;
+  size_t              ielem, irequest;
+  int                 iproc, iv, found_all = 1, mpiret;
+  char               *recv;
+
+  /* Send each node to its owner */
+  dest = T8_ALLOC (int, SC_MAX (nodes->elem_count, 1));
+  for (inode = 0; inode < nodes->elem_count; inode++) {
+    dest[inode] = ((t8_msh_file_node_t *)
+                   sc_array_index (nodes, inode))->index % mpisize;
+  }
+  owned_nodes = (t8_msh_file_node_t *)
+    t8_cmesh_faces_exchange (comm, T8_MPI_READ_MSH_FILE,
+                             sizeof (t8_msh_file_node_t), nodes->array,
+                             nodes->elem_count, dest, &num_owned, NULL);
+  T8_FREE (dest);
+  qsort (owned_nodes, num_owned, sizeof (t8_msh_file_node_t),
+         t8_msh_file_node_compare_index);
+
+  /* Collect the nodes of our elements without duplicates */
+  requests = T8_ALLOC (long, SC_MAX (elements->elem_count, 1) * 8);
+  num_requests = 0;
+  for (ielem = 0; ielem < elements->elem_count; ielem++) {
+    element = (t8_msh_file_element_t *) sc_array_index (elements, ielem);
+    for (iv = 0; iv < t8_eclass_num_vertices[element->eclass]; iv++) {
+      requests[num_requests++] = element->nodes[iv];
+    }
+  }
+  qsort (requests, num_requests, sizeof (long), t8_msh_file_long_compare);
+  for (irequest = 0, inode = 0; irequest < num_requests; irequest++) {
+    if (inode == 0 || requests[inode - 1] != requests[irequest]) {
+      requests[inode++] = requests[irequest];
+    }
+  }
+  num_requests = inode;
+
+  /* Request the nodes from their owners */
+  dest = T8_ALLOC (int, SC_MAX (num_requests, 1));
+  for (irequest = 0; irequest < num_requests; irequest++) {
+    dest[irequest] = requests[irequest] % mpisize;
+  }
+  recv_counts = T8_ALLOC (int, mpisize);
+  recv_requests = (long *)
+    t8_cmesh_faces_exchange (comm, T8_MPI_READ_MSH_FILE, sizeof (long),
+                             (char *) requests, num_requests, dest,
+                             &num_recv, recv_counts);
+  T8_FREE (dest);
+  T8_FREE (requests);
+
+  /* Answer the requests */
+  replies = T8_ALLOC (t8_msh_file_node_t, SC_MAX (num_recv, 1));
+  dest = T8_ALLOC (int, SC_MAX (num_recv, 1));
+  for (iproc = 0, irequest = 0; iproc < mpisize; iproc++) {
+    for (inode = 0; inode < (size_t) recv_counts[iproc]; inode++, irequest++) {
+      search.index = recv_requests[irequest];
+      found = (t8_msh_file_node_t *)
+        bsearch (&search, owned_nodes, num_owned, sizeof (t8_msh_file_node_t),
+                 t8_msh_file_node_compare_index);
+      if (found != NULL) {
+        replies[irequest] = *found;
+      }
+      else {
+        t8_errorf ("Node %li was not found in the node section.\n",
+                   search.index);
+        replies[irequest].index = -1;
+        found_all = 0;
+      }
+      dest[irequest] = iproc;
+    }
+  }
+  T8_FREE (recv_requests);
+  T8_FREE (recv_counts);
+  T8_FREE (owned_nodes);
+  recv = t8_cmesh_faces_exchange (comm, T8_MPI_READ_MSH_FILE,
+                                  sizeof (t8_msh_file_node_t),
+                                  (char *) replies, num_recv, dest,
+                                  &num_replies, NULL);
+  T8_FREE (dest);
+  T8_FREE (replies);
+
+  /* Store the received nodes sorted by their index */
+  sc_array_resize (nodes, num_replies);
+  memcpy (nodes->array, recv, num_replies * sizeof (t8_msh_file_node_t));
+  T8_FREE (recv);
+  qsort (nodes->array, num_replies, sizeof (t8_msh_file_node_t),
+         t8_msh_file_node_compare_index);
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &found_all, 1, sc_MPI_INT,
+                             sc_MPI_LAND, comm);
+  SC_CHECK_MPI (mpiret);
+  return found_all;
+}
+
+/* Add the local trees with their classes and vertices to the cmesh and
+ * store the class and the node indices in t8code order of each tree in
+ * eclasses and vertex_ids. */
+static void
+t8_msh_file_set_trees (t8_cmesh_t cmesh, sc_array_t * elements,
+                       sc_array_t * nodes, t8_gloidx_t first_tree,
+                       t8_eclass_t * eclasses, sc_array_t * vertex_ids)
+{
+  t8_msh_file_element_t *element;
+  t8_msh_file_node_t  search, *found;
+  t8_eclass_t         eclass;
+  t8_gloidx_t         tree_id, *t8_indices;
+  size_t              ielem;
+  double              tree_vertices[24], temp;
+  int                 i, num_nodes, t8_vertex_num;
+
+  for (ielem = 0; ielem < elements->elem_count; ielem++) {
+    element = (t8_msh_file_element_t *) sc_array_index (elements, ielem);
+    eclass = element->eclass;
+    tree_id = first_tree + ielem;
+    num_nodes = t8_eclass_num_vertices[eclass];
+    t8_cmesh_set_tree_class (cmesh, tree_id, eclass);
+    eclasses[ielem] = eclass;
+    t8_indices = (t8_gloidx_t *) sc_array_push_count (vertex_ids, num_nodes);
+    for (i = 0; i < num_nodes; i++) {
+      search.index = element->nodes[i];
+      found = (t8_msh_file_node_t *)
+        bsearch (&search, nodes->array, nodes->elem_count,
+                 sizeof (t8_msh_file_node_t), t8_msh_file_node_compare_index);
+      T8_ASSERT (found != NULL);
+      /* Add node coordinates to the tree vertices */
+      t8_vertex_num = t8_msh_tree_vertex_to_t8_vertex_num[eclass][i];
+      tree_vertices[3 * t8_vertex_num] = found->coordinates[0];
+      tree_vertices[3 * t8_vertex_num + 1] = found->coordinates[1];
+      tree_vertices[3 * t8_vertex_num + 2] = found->coordinates[2];
+      /* Get the i-th node index in t8code order */
+      t8_indices[i] = element->nodes[t8_vertex_to_msh_vertex_num[eclass][i]];
+    }
+    if (t8_cmesh_tree_vertices_negative_volume (eclass, tree_vertices,
+                                                num_nodes)) {
+      /* The volume described is negative. We need to switch two
+       * vertices. */
+      T8_ASSERT (t8_eclass_to_dimension[eclass] == 3);
+      t8_debugf ("Correcting negative volume of tree %li\n", (long) tree_id);
+      /* We switch vertex 0 and vertex 1 */
+      for (i = 0; i < 3; i++) {
+        temp = tree_vertices[i];
+        tree_vertices[i] = tree_vertices[3 + i];
+        tree_vertices[3 + i] = temp;
+      }
+      T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
+                 (eclass, tree_vertices, num_nodes));
+    }
+    t8_cmesh_set_tree_vertices (cmesh, tree_id, t8_get_package_id (),
+                                0, tree_vertices, num_nodes);
+  }
+}
+
+/* Create a partitioned cmesh from the elements of this process, which are
+ * the trees first_tree, first_tree + 1, ... and the coordinates of their
+ * nodes as returned by t8_msh_file_fetch_nodes.
+ * The arrays nodes and elements are reset.
+ * This function is collective. */
+static              t8_cmesh_t
+t8_msh_file_build_cmesh (sc_MPI_Comm comm, int dim, sc_array_t * nodes,
+                         sc_array_t * elements, t8_gloidx_t first_tree)
+{
+  t8_cmesh_t          cmesh;
+  t8_eclass_t        *eclasses;
+  sc_array_t          vertex_ids;
+  t8_locidx_t         num_local_trees;
+
+  num_local_trees = (t8_locidx_t) elements->elem_count;
+  t8_cmesh_init (&cmesh);
+  eclasses = T8_ALLOC (t8_eclass_t, SC_MAX (num_local_trees, 1));
+  sc_array_init (&vertex_ids, sizeof (t8_gloidx_t));
+  t8_msh_file_set_trees (cmesh, elements, nodes, first_tree, eclasses,
+                         &vertex_ids);
+  sc_array_reset (nodes);
+  sc_array_reset (elements);
+
+  /* Match the faces of all trees in parallel */
+  t8_cmesh_compute_face_connectivity (cmesh, first_tree, num_local_trees,
+                                      eclasses,
+                                      (t8_gloidx_t *) vertex_ids.array, comm);
+  sc_array_reset (&vertex_ids);
+  T8_FREE (eclasses);
+
+  t8_cmesh_set_dimension (cmesh, dim);
+  t8_cmesh_set_partition_range (cmesh, 3, first_tree,
+                                first_tree + num_local_trees - 1);
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
+/* Read a .msh file in parallel and create a partitioned cmesh
+ * from it. This function is collective. */
+static              t8_cmesh_t
+t8_cmesh_msh_file_read_parallel (const char *filename, sc_MPI_Comm comm,
+                                 int dim)
+{
+  t8_msh_file_format_t format;
+  FILE               *fp;
+  long long           file_size = 0, sections[T8_MSH_FILE_NUM_SECTIONS];
+  long long           nodes_begin, elements_begin;
+  long                counts[3], global_counts[3];
+  long                num_nodes = 0, num_elements = 0;
+  char               *lines;
+  sc_array_t          nodes, elements;
+  t8_gloidx_t        *tree_offsets, num_local_trees, first_tree;
+  int                 mpirank, mpisize, mpiret, iproc;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  /* Every process opens the file and computes its size */
+  fp = fopen (filename, "rb");
+  if (fp == NULL) {
+    t8_errorf ("Could not open file %s\n", filename);
+  }
+  else if (t8_msh_file_read_format (fp, &format) || format.version != 2
+           || format.binary) {
+    /* We split the file at line breaks, so we need an ASCII file
+     * with one node or element per line */
+    t8_errorf ("Parallel reading only supports ASCII .msh files "
+               "of version 2.\n");
+    fclose (fp);
+    fp = NULL;
+  }
+  else if (fseek (fp, 0, SEEK_END) || (file_size = ftell (fp)) < 0) {
+    t8_errorf ("Could not read file %s\n", filename);
+    fclose (fp);
+    fp = NULL;
+  }
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &file_size, 1,
+                             sc_MPI_LONG_LONG_INT, sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  t8_msh_file_find_sections (fp, file_size, mpirank, mpisize, comm,
+                             sections);
+  if (sections[0] < 0 || sections[T8_MSH_FILE_NUM_SECTIONS - 1] == file_size
+      || sections[T8_MSH_FILE_END_NODES] == file_size
+      || sections[T8_MSH_FILE_ELEMENTS] == file_size
+      || sections[T8_MSH_FILE_NODES] == file_size) {
+    t8_global_errorf ("Could not find the nodes and elements in %s\n",
+                      filename);
+    if (fp != NULL) {
+      fclose (fp);
+    }
+    return NULL;
+  }
+
+  /* Read and parse our parts of the node and element sections */
+  sc_array_init (&nodes, sizeof (t8_msh_file_node_t));
+  sc_array_init (&elements, sizeof (t8_msh_file_element_t));
+  counts[0] = counts[1] = counts[2] = 0;
+  nodes_begin = t8_msh_file_section_begin (fp, sections[T8_MSH_FILE_NODES],
+                                           &num_nodes);
+  elements_begin =
+    t8_msh_file_section_begin (fp, sections[T8_MSH_FILE_ELEMENTS],
+                               &num_elements);
+  if (nodes_begin < 0 || elements_begin < 0
+      || nodes_begin > sections[T8_MSH_FILE_END_NODES]
+      || elements_begin > sections[T8_MSH_FILE_END_ELEMENTS]) {
+    counts[0] = 1;
+  }
+  else {
+    lines = t8_msh_file_read_block (fp, nodes_begin,
+                                    sections[T8_MSH_FILE_END_NODES],
+                                    mpirank, mpisize);
+    counts[1] = lines == NULL ? -1 : t8_msh_file_parse_nodes (lines, &nodes);
+    T8_FREE (lines);
+    lines = t8_msh_file_read_block (fp, elements_begin,
+                                    sections[T8_MSH_FILE_END_ELEMENTS],
+                                    mpirank, mpisize);
+    counts[2] = lines == NULL ? -1 :
+      t8_msh_file_parse_elements (lines, dim, &elements);
+    T8_FREE (lines);
+    counts[0] = counts[1] < 0 || counts[2] < 0;
+  }
+  fclose (fp);
+  /* Check that no process failed and that all nodes and elements
+   * were read */
+  mpiret = sc_MPI_Allreduce (counts, global_counts, 3, sc_MPI_LONG,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  if (global_counts[0] == 0 && (global_counts[1] != num_nodes
+                                || global_counts[2] != num_elements)) {
+    t8_global_errorf ("Read %li nodes and %li elements but expected %li "
+                      "nodes and %li elements.\n", global_counts[1],
+                      global_counts[2], num_nodes, num_elements);
+    global_counts[0] = 1;
+  }
+  if (global_counts[0] != 0
+      || !t8_msh_file_fetch_nodes (comm, mpirank, mpisize, &nodes,
+                                   &elements)) {
+    t8_global_errorf ("Error reading file %s\n", filename);
+    sc_array_reset (&nodes);
+    sc_array_reset (&elements);
+    return NULL;
+  }
+
+  /* Compute the first tree of each process */
+  tree_offsets = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  num_local_trees = elements.elem_count;
+  mpiret = sc_MPI_Allgather (&num_local_trees, 1, T8_MPI_GLOIDX,
+                             tree_offsets + 1, 1, T8_MPI_GLOIDX, comm);
+  SC_CHECK_MPI (mpiret);
+  tree_offsets[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    tree_offsets[iproc + 1] += tree_offsets[iproc];
+  }
+  if (tree_offsets[mpisize] == 0) {
+    t8_global_errorf ("The file %s contains no elements of dimension %i\n",
+                      filename, dim);
+    T8_FREE (tree_offsets);
+    sc_array_reset (&nodes);
+    sc_array_reset (&elements);
+    return NULL;
+  }
+
+  first_tree = tree_offsets[mpirank];
+  T8_FREE (tree_offsets);
+  return t8_msh_file_build_cmesh (comm, dim, &nodes, &elements, first_tree);
+}
+
+/* In the scatter reader only the master process opens the file.
+ * It reads the $Nodes and the $Elements section in chunks of
+ * T8_MSH_FILE_SCATTER_CHUNK lines and sends each chunk straight to the
+ * processes that keep it: node i to process i % mpisize as in the
+ * parallel reader and each tree to its owner in the uniform partition
+ * of level 0. Since the number of trees of dimension dim is not stored
+ * in the file, the master counts them in a first pass over the element
+ * section. Each stream of chunks ends with an empty message.
+ * Afterwards the processes proceed as in the parallel reader, thus no
+ * process holds more than its part of the mesh and one chunk.
+ */
+
+/* The number of lines that the master reads and sends at once */
+#define T8_MSH_FILE_SCATTER_CHUNK 65536
+
+/* Read at most max_lines lines of a section up to the line end_section.
+ * done is set to true if end_section was reached.
+ * The lines are returned as one string that must be freed with T8_FREE,
+ * NULL if the file ended before end_section. */
+static char        *
+t8_msh_file_read_chunk (FILE * fp, const char *end_section, long max_lines,
+                        int *done)
+{
+  char               *buffer, *line = NULL;
+  size_t              length = 0, alloc = BUFSIZ, linen = 0;
+  size_t              name_length = strlen (end_section);
+  ssize_t             retval;
+  long                num_lines = 0;
+
+  buffer = T8_ALLOC (char, alloc);
+  buffer[0] = '\0';
+  *done = 0;
+  while (num_lines < max_lines) {
+    retval = getline (&line, &linen, fp);
+    if (retval < 0) {
+      free (line);
+      T8_FREE (buffer);
+      return NULL;
+    }
+    if (!strncmp (line, end_section, name_length)
+        && strspn (line + name_length, " \t\r\n")
+        == strlen (line + name_length)) {
+      *done = 1;
+      break;
+    }
+    if (length + (size_t) retval + 1 > alloc) {
+      alloc = SC_MAX (2 * alloc, length + (size_t) retval + 1);
+      buffer = T8_REALLOC (buffer, char, alloc);
+    }
+    memcpy (buffer + length, line, (size_t) retval + 1);
+    length += (size_t) retval;
+    num_lines++;
+  }
+  free (line);
+  return buffer;
+}
+
+/* The first tree of a process in the uniform partition of level 0 of
+ * num_trees trees as computed by t8_cmesh_uniform_bounds.
+ * For rank = mpisize this is num_trees. */
+static              t8_gloidx_t
+t8_msh_file_scatter_first_tree (t8_gloidx_t num_trees, int rank,
+                                int mpisize)
+{
+  if (rank == 0) {
+    return 0;
+  }
+  if (rank == mpisize) {
+    return num_trees;
+  }
+  return ((long double) num_trees * rank) / (double) mpisize;
+}
+
+/* Send count entries of size bytes to process dest.
+ * The entries for the sending process itself are appended to local. */
+static void
+t8_msh_file_scatter_send (sc_MPI_Comm comm, int mpirank, int dest,
+                          void *data, size_t count, size_t size,
+                          sc_array_t * local)
+{
+  int                 mpiret;
+
+  if (count == 0) {
+    /* An empty message would end the stream */
+    return;
+  }
+  if (dest == mpirank) {
+    T8_ASSERT (local->elem_size == size);
+    memcpy (sc_array_push_count (local, count), data, count * size);
+    return;
+  }
+  mpiret = sc_MPI_Send (data, (int) (count * size), sc_MPI_BYTE, dest,
+                        T8_MPI_SCATTER_MSH_FILE, comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Send the empty message that ends a stream to all other processes */
+static void
+t8_msh_file_scatter_finish (sc_MPI_Comm comm, int mpirank, int mpisize)
+{
+  int                 iproc, mpiret;
+
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc != mpirank) {
+      mpiret = sc_MPI_Send (NULL, 0, sc_MPI_BYTE, iproc,
+                            T8_MPI_SCATTER_MSH_FILE, comm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+}
+
+/* Receive the entries that the master sends and append them to array
+ * until the empty message arrives. */
+static void
+t8_msh_file_scatter_recv (sc_MPI_Comm comm, int master, sc_array_t * array)
+{
+  sc_MPI_Status       status;
+  size_t              num_entries;
+  void               *recv;
+  int                 recv_bytes, mpiret;
+
+  do {
+    mpiret = sc_MPI_Probe (master, T8_MPI_SCATTER_MSH_FILE, comm, &status);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Get_count (&status, sc_MPI_BYTE, &recv_bytes);
+    SC_CHECK_MPI (mpiret);
+    T8_ASSERT (recv_bytes % array->elem_size == 0);
+    num_entries = (size_t) recv_bytes / array->elem_size;
+    recv = num_entries > 0 ? sc_array_push_count (array, num_entries) : NULL;
+    mpiret = sc_MPI_Recv (recv, recv_bytes, sc_MPI_BYTE, master,
+                          T8_MPI_SCATTER_MSH_FILE, comm,
+                          sc_MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  } while (recv_bytes > 0);
+}
+
+/* Read the node section in chunks and send node i to process i % mpisize.
+ * The nodes of the master are appended to nodes.
+ * Returns the number of read nodes, or -1 on failure. */
+static long
+t8_msh_file_scatter_nodes (FILE * fp, sc_MPI_Comm comm, int mpirank,
+                           int mpisize, sc_array_t * nodes)
+{
+  sc_array_t          chunk;
+  t8_msh_file_node_t *node, *sorted;
+  size_t             *offsets, inode, begin;
+  long                num_nodes = 0, num_parsed;
+  char               *lines;
+  int                 iproc, owner, done = 0;
+
+  sc_array_init (&chunk, sizeof (t8_msh_file_node_t));
+  offsets = T8_ALLOC (size_t, mpisize + 1);
+  while (!done) {
+    lines = t8_msh_file_read_chunk (fp, "$EndNodes",
+                                    T8_MSH_FILE_SCATTER_CHUNK, &done);
+    num_parsed = lines == NULL ? -1 : t8_msh_file_parse_nodes (lines, &chunk);
+    if (lines != NULL) {
+      T8_FREE (lines);
+    }
+    if (num_parsed < 0) {
+      num_nodes = -1;
+      break;
+    }
+    num_nodes += num_parsed;
+    /* Sort the nodes of the chunk by their owner */
+    memset (offsets, 0, (mpisize + 1) * sizeof (size_t));
+    for (inode = 0; inode < chunk.elem_count; inode++) {
+      node = (t8_msh_file_node_t *) sc_array_index (&chunk, inode);
+      offsets[node->index % mpisize + 1]++;
+    }
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      offsets[iproc + 1] += offsets[iproc];
+    }
+    sorted = T8_ALLOC (t8_msh_file_node_t, SC_MAX (chunk.elem_count, 1));
+    for (inode = 0; inode < chunk.elem_count; inode++) {
+      node = (t8_msh_file_node_t *) sc_array_index (&chunk, inode);
+      owner = node->index % mpisize;
+      sorted[offsets[owner]++] = *node;
+    }
+    /* Now offsets[iproc] is the end of the nodes of iproc */
+    for (iproc = 0, begin = 0; iproc < mpisize; iproc++) {
+      t8_msh_file_scatter_send (comm, mpirank, iproc, sorted + begin,
+                                offsets[iproc] - begin,
+                                sizeof (t8_msh_file_node_t), nodes);
+      begin = offsets[iproc];
+    }
+    T8_FREE (sorted);
+    sc_array_truncate (&chunk);
+  }
+  T8_FREE (offsets);
+  sc_array_reset (&chunk);
+  return num_nodes;
+}
+
+/* Read the element section in chunks and count the elements of dimension
+ * dim in num_dim_trees. If num_trees is not negative, send each element of
+ * dimension dim to its owner in the uniform partition of num_trees trees.
+ * The elements of the master are appended to elements.
+ * Returns the number of read elements of any dimension, or -1 on failure. */
+static long
+t8_msh_file_scatter_elements (FILE * fp, sc_MPI_Comm comm, int mpirank,
+                              int mpisize, int dim, t8_gloidx_t num_trees,
+                              t8_gloidx_t * num_dim_trees,
+                              sc_array_t * elements)
+{
+  sc_array_t          chunk;
+  t8_gloidx_t         tree_id, next_first_tree = 0;
+  size_t              ielem, iend;
+  long                num_elements = 0, num_parsed;
+  char               *lines;
+  int                 iproc = -1, done = 0;
+
+  sc_array_init (&chunk, sizeof (t8_msh_file_element_t));
+  *num_dim_trees = 0;
+  while (!done && num_elements >= 0) {
+    lines = t8_msh_file_read_chunk (fp, "$EndElements",
+                                    T8_MSH_FILE_SCATTER_CHUNK, &done);
+    num_parsed = lines == NULL ? -1 :
+      t8_msh_file_parse_elements (lines, dim, &chunk);
+    if (lines != NULL) {
+      T8_FREE (lines);
+    }
+    if (num_parsed < 0) {
+      num_elements = -1;
+      break;
+    }
+    num_elements += num_parsed;
+    /* Send each contiguous range of trees to its owner */
+    for (ielem = 0; num_trees >= 0 && ielem < chunk.elem_count;
+         ielem = iend) {
+      tree_id = *num_dim_trees + ielem;
+      if (tree_id >= num_trees) {
+        /* The file has changed since we counted the trees */
+        num_elements = -1;
+        break;
+      }
+      while (next_first_tree <= tree_id) {
+        iproc++;
+        next_first_tree =
+          t8_msh_file_scatter_first_tree (num_trees, iproc + 1, mpisize);
+      }
+      iend = SC_MIN (chunk.elem_count,
+                     (size_t) (next_first_tree - *num_dim_trees));
+      t8_msh_file_scatter_send (comm, mpirank, iproc,
+                                sc_array_index (&chunk, ielem), iend - ielem,
+                                sizeof (t8_msh_file_element_t), elements);
+    }
+    *num_dim_trees += chunk.elem_count;
+    sc_array_truncate (&chunk);
+  }
+  sc_array_reset (&chunk);
+  return num_elements;
+}
+
+/* Read a .msh file on the master process and scatter it to a cmesh that
+ * is partitioned uniformly. This function is collective. */
+static              t8_cmesh_t
+t8_cmesh_msh_file_read_scatter (const char *filename, sc_MPI_Comm comm,
+                                int dim, int master)
+{
+  t8_msh_file_format_t format;
+  FILE               *fp = NULL;
+  char               *line = NULL;
+  size_t              linen = 0;
+  long                num_nodes = 0, num_elements = 0, num_read;
+  long                elements_begin = -1;
+  t8_gloidx_t         num_trees = -1, num_dim_trees, first_tree;
+  sc_array_t          nodes, elements;
+  int                 mpirank, mpisize, mpiret, failed = 0;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  T8_ASSERT (0 <= master && master < mpisize);
+
+  sc_array_init (&nodes, sizeof (t8_msh_file_node_t));
+  sc_array_init (&elements, sizeof (t8_msh_file_element_t));
+  if (mpirank == master) {
+    fp = fopen (filename, "rb");
+    if (fp == NULL) {
+      t8_errorf ("Could not open file %s\n", filename);
+      failed = 1;
+    }
+    else if (t8_msh_file_read_format (fp, &format) || format.version != 2
+             || format.binary) {
+      /* We send whole lines, so we need an ASCII file
+       * with one node or element per line */
+      t8_errorf ("Scattering only supports ASCII .msh files "
+                 "of version 2.\n");
+      failed = 1;
+    }
+    else if (t8_msh_file_find_section (fp, "$Nodes")
+             || t8_cmesh_msh_read_next_line (&line, &linen, fp) < 0
+             || sscanf (line, "%li", &num_nodes) != 1) {
+      t8_errorf ("Could not find the nodes in %s\n", filename);
+      failed = 1;
+    }
+    if (!failed) {
+      num_read = t8_msh_file_scatter_nodes (fp, comm, mpirank, mpisize,
+                                            &nodes);
+      if (num_read != num_nodes) {
+        t8_errorf ("Read %li nodes but expected %li nodes.\n", num_read,
+                   num_nodes);
+        failed = 1;
+      }
+    }
+    /* We end the stream of nodes even on failure */
+    t8_msh_file_scatter_finish (comm, mpirank, mpisize);
+    if (!failed && (t8_msh_file_find_section (fp, "$Elements")
+                    || t8_cmesh_msh_read_next_line (&line, &linen, fp) < 0
+                    || sscanf (line, "%li", &num_elements) != 1
+                    || (elements_begin = ftell (fp)) < 0)) {
+      t8_errorf ("Could not find the elements in %s\n", filename);
+      failed = 1;
+    }
+    if (!failed) {
+      /* Count the trees */
+      num_read = t8_msh_file_scatter_elements (fp, comm, mpirank, mpisize,
+                                               dim, -1, &num_trees, NULL);
+      if (num_read != num_elements) {
+        t8_errorf ("Read %li elements but expected %li elements.\n",
+                   num_read, num_elements);
+        failed = 1;
+      }
+      else if (num_trees == 0) {
+        t8_errorf ("The file %s contains no elements of dimension %i\n",
+                   filename, dim);
+        failed = 1;
+      }
+    }
+    if (failed) {
+      num_trees = -1;
+    }
+  }
+  else {
+    t8_msh_file_scatter_recv (comm, master, &nodes);
+  }
+  mpiret = sc_MPI_Bcast (&num_trees, 1, T8_MPI_GLOIDX, master, comm);
+  SC_CHECK_MPI (mpiret);
+  if (num_trees < 0) {
+    if (fp != NULL) {
+      fclose (fp);
+    }
+    free (line);
+    sc_array_reset (&nodes);
+    sc_array_reset (&elements);
+    t8_global_errorf ("Error reading file %s\n", filename);
+    return NULL;
+  }
+
+  /* Send the trees to their owners */
+  if (mpirank == master) {
+    if (fseek (fp, elements_begin, SEEK_SET)
+        || t8_msh_file_scatter_elements (fp, comm, mpirank, mpisize, dim,
+                                         num_trees, &num_dim_trees,
+                                         &elements) != num_elements
+        || num_dim_trees != num_trees) {
+      t8_errorf ("Could not read the elements of %s\n", filename);
+      failed = 1;
+    }
+    t8_msh_file_scatter_finish (comm, mpirank, mpisize);
+    fclose (fp);
+  }
+  else {
+    t8_msh_file_scatter_recv (comm, master, &elements);
+  }
+  free (line);
+  first_tree = t8_msh_file_scatter_first_tree (num_trees, mpirank, mpisize);
+  if ((t8_gloidx_t) elements.elem_count
+      != t8_msh_file_scatter_first_tree (num_trees, mpirank + 1, mpisize)
+      - first_tree) {
+    failed = 1;
+  }
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &failed, 1, sc_MPI_INT,
+                             sc_MPI_LOR, comm);
+  SC_CHECK_MPI (mpiret);
+  if (failed || !t8_msh_file_fetch_nodes (comm, mpirank, mpisize, &nodes,
+                                          &elements)) {
+    t8_global_errorf ("Error reading file %s\n", filename);
+    sc_array_reset (&nodes);
+    sc_array_reset (&elements);
+    return NULL;
+  }
+  return t8_msh_file_build_cmesh (comm, dim, &nodes, &elements, first_tree);
+}
+
 t8_cmesh_t
 t8_cmesh_from_msh_file (const char *fileprefix, int partition,
                         sc_MPI_Comm comm, int dim, int master)
 {
-  int                 mpirank, mpisize, mpiret;
+  int                 mpirank, mpisize, mpiret, retval;
   t8_cmesh_t          cmesh;
+  t8_msh_file_format_t format;
   sc_hash_t          *vertices;
   t8_locidx_t         num_vertices;
   sc_mempool_t       *node_mempool = NULL;
@@ -717,9 +2217,11 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
-  /* TODO: implement partitioned input using gmesh's
-   * partitioned files.
-   * Or using a single file and computing the partition on the run. */
+  if (partition && master < 0) {
+    /* All processes read the file in parallel */
+    snprintf (current_file, BUFSIZ, "%s.msh", fileprefix);
+    return t8_cmesh_msh_file_read_parallel (current_file, comm, dim);
+  }
   T8_ASSERT (partition == 0 || (master >= 0 && master < mpisize));
 
   /* initialize cmesh structure */
@@ -732,24 +2234,43 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
     snprintf (current_file, BUFSIZ, "%s.msh", fileprefix);
     /* Open the file */
     t8_debugf ("Opening file %s\n", current_file);
-    file = fopen (current_file, "r");
+    file = fopen (current_file, "rb");
     if (file == NULL) {
       t8_global_errorf ("Could not open file %s\n", current_file);
+      t8_cmesh_destroy (&cmesh);
       return NULL;
     }
-    /* read nodes from the file */
-    vertices = t8_msh_file_read_nodes (file, &num_vertices, &node_mempool);
-    t8_cmesh_msh_file_read_eles (cmesh, file, vertices, &vertex_indices, dim);
+    /* read the file format and the nodes from the file */
+    vertices = NULL;
+    vertex_indices = NULL;
+    retval = t8_msh_file_read_format (file, &format);
+    if (!retval) {
+      vertices = t8_msh_file_read_nodes (file, &format, &num_vertices,
+                                         &node_mempool);
+      retval = vertices == NULL
+        || t8_cmesh_msh_file_read_eles (cmesh, file, &format, vertices,
+                                        &vertex_indices, dim);
+    }
     /* close the file and free the memory for the nodes */
     fclose (file);
-    t8_cmesh_msh_file_find_neighbors (cmesh, vertex_indices);
+    if (!retval) {
+      t8_cmesh_msh_file_find_neighbors (cmesh, vertex_indices);
+    }
     if (vertices != NULL) {
       sc_hash_destroy (vertices);
+      sc_mempool_destroy (node_mempool);
+    }
+    if (vertex_indices != NULL) {
+      while (vertex_indices->elem_count > 0) {
+        indices_entry = *(long **) sc_array_pop (vertex_indices);
+        T8_FREE (indices_entry);
+      }
+      sc_array_destroy (vertex_indices);
     }
-    sc_mempool_destroy (node_mempool);
-    while (vertex_indices->elem_count > 0) {
-      indices_entry = *(long **) sc_array_pop (vertex_indices);
-      T8_FREE (indices_entry);
+    if (retval) {
+      t8_global_errorf ("Error reading file %s\n", current_file);
+      t8_cmesh_destroy (&cmesh);
+      return NULL;
     }
     sc_array_destroy (vertex_indices);
   }
@@ -785,3 +2306,13 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
   }
   return cmesh;
 }
+
+t8_cmesh_t
+t8_cmesh_from_msh_file_scatter (const char *fileprefix, sc_MPI_Comm comm,
+                                int dim, int master)
+{
+  char                current_file[BUFSIZ];
+
+  snprintf (current_file, BUFSIZ, "%s.msh", fileprefix);
+  return t8_cmesh_msh_file_read_scatter (current_file, comm, dim, master);
+}
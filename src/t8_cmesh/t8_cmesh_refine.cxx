@@ -20,9 +20,13 @@
   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 */
 
-/** \file t8_cmesh_refine.c
+/** \file t8_cmesh_refine.cxx
  *
- * TODO: document this file
+ * Uniform refinement of a committed cmesh by an arbitrary level.
+ * Each tree is replaced by all of its descendants of the given level.
+ * The local and global ids of these children, their face neighbors and
+ * their coordinates are computed directly from the coarse cmesh, not by
+ * refining one level after another.
  */
 
 /* TODO: could this file be part of cmesh_commit.c? */
@@ -34,503 +38,449 @@
 #include "t8_cmesh_trees.h"
 #include "t8_cmesh_partition.h"
 
-/* Since we do not now which children of a ghost will also be ghosts in the
- * refined cmesh we have to create a list of all those children for each coarse
- * ghost. In this list we store the child_id and the new local_id of the children
- * that are ghosts in the refined cmesh.
- * Thus, for each coarse ghost we get an array of maximal number of children entries.
- */
+/* The maximal refinement level. The number of children of a tree must fit
+ * into a t8_locidx_t, thus for lines we can refine at most 30 levels. */
+#define T8_CMESH_REFINE_MAX_LEVEL 30
+
+/* For each eclass we give a lookup table of the child id's on a given face,
+ * listed in the order of the face's vertices.
+ * For example for type T8_ECLASS_QUAD we have
+ *                    f_3
+ *                     _ _
+ *              f_0  |2 3|  f_1
+ *                   |0 1|
+ *                     - -
+ *                    f_2
+ * where the numbers inside refer to the chlid_ids of the quad.
+ * The lookup table then gives:  0 -> 0,2
+ *                               1 -> 1,3
+ *                               2 -> 0,1
+ *                               3 -> 2,3
+ * as can be see in the 3rd line of the array.
+ * A child on face f of its parent lies with its face f on this face.
+ * Thus, the children of level l on face f are exactly those whose child ids
+ * of all levels are listed for face f. */
+static const int8_t t8_cmesh_refine_face_children[T8_ECLASS_COUNT][6][4] = {
+  {{0}},                        /* VERTEX */
+  {{0}, {1}},                   /* LINE */
+  {{0, 2}, {1, 3}, {0, 1}, {2, 3}},     /* QUAD */
+  {{1, 2}, {0, 2}, {0, 1}},     /* TRIANGLE */
+  {{0, 2, 4, 6}, {1, 3, 5, 7}, {0, 1, 4, 5}, {2, 3, 6, 7}, {0, 1, 2, 3}, {4, 5, 6, 7}},  /* HEX */
+  {{1, 2, 3, 7}, {0, 2, 3, 6}, {0, 1, 3, 4}, {0, 1, 2, 5}}      /* TET */
+};
+
+/* The information about a refinement that is shared by all trees.
+ *
+ * A child of a tree is identified by its child id after level refinement
+ * steps. This is the number whose digits in base num_children are the
+ * child ids of each refinement step, the first step being the most
+ * significant digit. The local (global) id of a child is then the local
+ * (global) id of its parent times factor plus its child id. This is
+ * the same numbering that we would get by refining one level at a time.
+ *
+ * Since we do not now which children of a ghost will also be ghosts in the
+ * refined cmesh we store for each coarse ghost the child ids of those children
+ * that are ghosts in the refined cmesh. These are the children on the ghost's
+ * faces that are connected to local trees.
+ * If the first local tree of cmesh_from is shared with a smaller rank,
+ * its children are only kept on that smaller rank. On this rank, the
+ * shared tree is then treated like a ghost.
+ * We refer to the ghosts and the shared tree as ghost parents. The shared
+ * tree comes first, followed by the ghosts of cmesh_from in their order. */
 typedef struct
 {
-  int8_t              child_id;
-  t8_locidx_t         local_id;
-} t8_child_id_to_local_id;
+  t8_cmesh_t          cmesh_from;       /* The cmesh that is refined */
+  int                 level;    /* The refinement level */
+  int                 num_children;     /* The number of children of a tree in one refinement step */
+  t8_locidx_t         factor;   /* The number of children of a tree after level steps */
+  t8_locidx_t         num_dropped;      /* 1 if the children of the first local tree are left to a smaller rank, 0 otherwise */
+  t8_locidx_t         num_trees;        /* The number of local trees in the refined cmesh */
+  t8_locidx_t         num_ghost_parents;        /* The number of ghost parents */
+  t8_locidx_t        *ghost_offsets;    /* For each ghost parent the index of its first child in ghost_children */
+  sc_array_t          ghost_children;   /* The child ids of the children of each ghost parent
+                                           that are ghosts in the refined cmesh, sorted for each parent */
+} t8_cmesh_refine_context_t;
+
+/* Compare two local ids */
+static int
+t8_cmesh_refine_locidx_compare (const void *id1, const void *id2)
+{
+  t8_locidx_t         A = *(const t8_locidx_t *) id1;
+  t8_locidx_t         B = *(const t8_locidx_t *) id2;
 
-/* When setting the new ghost neighbors of a refined tree we have to look up the new local_ids
- * in this array. Thus we have to search in it for the respective child_id.
- * We store an additional entry with child_id = -1 at the end, so that
- * this search terminates when the entry is not found. */
-static              t8_locidx_t
-t8_cmesh_refine_childid_to_localid (t8_child_id_to_local_id ** idarray,
-                                    t8_locidx_t lparent_id, int8_t child_id)
+  return A < B ? -1 : A != B;
+}
+
+/* Split a child id into the child ids of the single refinement steps.
+ * digits[0] is the child id of the first refinement step. */
+static void
+t8_cmesh_refine_child_digits (const t8_cmesh_refine_context_t * r,
+                              t8_locidx_t child_id, int *digits)
 {
-  int                 ichild;
-  int8_t              child_id_found = -2;
+  int                 il;
 
-  for (ichild = 0; child_id_found != child_id; ichild++) {
-    child_id_found = idarray[lparent_id][ichild].child_id;
-    T8_ASSERT (child_id_found != -1);   /* -1 marks the end of the array */
+  for (il = r->level - 1; il >= 0; il--) {
+    digits[il] = child_id % r->num_children;
+    child_id /= r->num_children;
   }
-  T8_ASSERT (child_id_found == child_id);
-  return idarray[lparent_id][ichild - 1].local_id;
+  T8_ASSERT (child_id == 0);
 }
 
-/* Allocate memory for an array holding a child_id_to_local_id array for
- * each parent ghost. */
-static t8_child_id_to_local_id **
-t8_cmesh_refine_init_idarray (t8_cmesh_t cmesh_from)
+/* The inverse of t8_cmesh_refine_child_digits */
+static              t8_locidx_t
+t8_cmesh_refine_child_id (const t8_cmesh_refine_context_t * r,
+                          const int *digits)
 {
-  return T8_ALLOC (t8_child_id_to_local_id *, cmesh_from->num_ghosts);
+  int                 il;
+  t8_locidx_t         child_id = 0;
+
+  for (il = 0; il < r->level; il++) {
+    child_id = child_id * r->num_children + digits[il];
+  }
+  return child_id;
 }
 
-/* Allocate and fill for a given parent ghost its entry in the idarray.
- * child_counted[i] is 1 if the child_id i of the parent will be a ghost in the
- * refined cmesh.
- * num_children is the number of nonzero entries in child_counted.
- * next_local_id is the next local ghost_id int the refined cmesh that was not
- * already set.
- * The return value is the local_id of the last child of gparent_id plus one.
- *
- * This function is meant to be called for each ghost parent in ascending order of
- * their local ids.
- */
-static              t8_locidx_t
-t8_cmesh_refine_fill_idarray (t8_child_id_to_local_id ** idarray,
-                              t8_locidx_t gparent_id,
-                              int8_t child_counted[10], int num_children,
-                              t8_locidx_t next_local_id)
+/* Decide whether a face of a child (for one refinement step) lies inside
+ * its parent. If so, we return true and store the child id of the sibling
+ * that is connected to the child along this face and the tree to face value
+ * of the connection.
+ * Otherwise the face of the child lies on the same face of the parent and
+ * we return false. */
+/* TODO: This will not work anymore when pyramids are used together with other types */
+static int
+t8_cmesh_refine_inner_neighbor (t8_eclass_t eclass, int child_id, int face,
+                                int F, int *sibling, int8_t * ttf)
 {
-  int                 ichild, child_index;
-  int                 num_alloc;
-
-  num_alloc = num_children + 1;
-  idarray[gparent_id] = T8_ALLOC (t8_child_id_to_local_id, num_alloc);
-  for (ichild = 0, child_index = 0; ichild < num_children; ichild++) {
-    /* Look for the next nonzero entry in child_counted */
-    while (child_counted[child_index] == 0) {
-      child_index++;
+  switch (eclass) {
+  case T8_ECLASS_LINE:
+    /* child i is connected along face 1 - i with child 1 - i. */
+    if (face == 1 - child_id) {
+      *sibling = 1 - child_id;
+      *ttf = child_id;
+      return 1;
     }
-    /* set child id an local_id */
-    idarray[gparent_id][ichild].child_id = child_index;
-    idarray[gparent_id][ichild].local_id = next_local_id + ichild;
-    child_index++;
+    return 0;
+  case T8_ECLASS_QUAD:
+    /* For the inner face connections we have
+     *                 faces
+     * child_id     f_0 f_1 f_2 f_3
+     *    0          -   1   -   2
+     *    1          0   -   -   3
+     *    2          -   3   0   -
+     *    3          2   -   1   -
+     *
+     *   This means that child i along its face f_j is connected to the child
+     *   given in the table.
+     *   These values can be computed as follows:
+     *   child i is connected along face 1-(i%2) with child (1 xor i)
+     *                    and along face 3-(i/2) with child (2 xor i)
+     *   The face number on the neighbor of this connection is (j xor 1)
+     * The orientation for each of these connections is 0.
+     */
+    if (face == 1 - child_id % 2) {
+      *sibling = child_id ^ 1;
+    }
+    else if (face == 3 - child_id / 2) {
+      *sibling = child_id ^ 2;
+    }
+    else {
+      return 0;
+    }
+    *ttf = face ^ 1;
+    return 1;
+  case T8_ECLASS_TRIANGLE:
+    /* The triangle in the middle (child_id 3) is connect to child i along
+     * its face 2 - i. Child i is connected along its face i.
+     * The orientation of each of these connections is 1. */
+    if (child_id == 3) {
+      *sibling = 2 - face;
+      *ttf = 1 * F + 2 - face;
+      return 1;
+    }
+    if (face == child_id) {
+      *sibling = 3;
+      *ttf = 1 * F + 2 - child_id;
+      return 1;
+    }
+    return 0;
+  default:
+    SC_ABORTF ("Refining %s trees is not implemented yet.\n",
+               t8_eclass_to_string[eclass]);
   }
-  /* allocate one more entry and set it to -1,
-   * such that when searching we can check whether we are at the end of the array */
-  idarray[gparent_id][ichild].child_id = -1;
-  idarray[gparent_id][ichild].local_id = -1;
-  return next_local_id + num_children;
+  return 0;
 }
 
-static void
-t8_cmesh_refine_destroy_idarray (t8_child_id_to_local_id ** idarray,
-                                 t8_locidx_t num_parent_ghosts)
+/* Given a child (for one refinement step) and one of its faces that lies on
+ * the same face of the parent, return the child id of the child of the parent's
+ * face neighbor that is connected to it.
+ * neigh_face and orientation describe the connection of the parent to its neighbor.
+ * For two dimensional trees an orientation of 1 reverses the order of the
+ * children on the face. */
+static int
+t8_cmesh_refine_outer_neighbor (t8_eclass_t eclass, int child_id, int face,
+                                t8_eclass_t neigh_eclass, int neigh_face,
+                                int orientation)
 {
-  t8_locidx_t         lghost;
+  int                 num_face_children, ichild;
 
-  for (lghost = 0; lghost < num_parent_ghosts; lghost++) {
-    T8_FREE (idarray[lghost]);
+  T8_ASSERT (t8_eclass_to_dimension[eclass] <= 2);
+  num_face_children = 1 << (t8_eclass_to_dimension[eclass] - 1);
+  for (ichild = 0; ichild < num_face_children; ichild++) {
+    if (t8_cmesh_refine_face_children[eclass][face][ichild] == child_id) {
+      break;
+    }
   }
-  T8_FREE (idarray);
+  T8_ASSERT (ichild < num_face_children);
+  if (orientation) {
+    ichild = num_face_children - 1 - ichild;
+  }
+  return t8_cmesh_refine_face_children[neigh_eclass][neigh_face][ichild];
 }
 
-/* Given a parent's local tree/ghost id and a child_id,
- * compute the new local id of the child to be used as a face neihgbor.
- * This works for local trees and ghosts. */
-/* TODO: This will not work anymore when pyramids are used together with other types */
-static              t8_locidx_t
-t8_cmesh_refine_new_neighborid (t8_cmesh_t cmesh_from, t8_locidx_t parent_id,
-                                int child_id,
-                                t8_child_id_to_local_id ** id_array,
-                                int factor)
+/* Compute the face neighbor of a child of a tree along a face of the child.
+ * eclass is the eclass of the tree, parent_ttf the tree to face value of the tree
+ * at this face and neigh_eclass the eclass of the tree's neighbor at this face.
+ * If is_boundary is true, the tree's face is a domain boundary.
+ * We store the child id of the neighbor child and the tree to face value
+ * of the connection.
+ * The return value is true if the neighbor is a child of the same tree and
+ * false if it is a child of the tree's face neighbor.
+ * At the domain boundary the neighbor is the child itself.
+ *
+ * The neighbor of a child lies in the same tree if the face lies inside one
+ * of its ancestors. For the levels below this ancestor the child's face lies
+ * on the same face of its parent and we follow the face of the neighbor
+ * through these levels. */
+static int
+t8_cmesh_refine_child_neighbor (const t8_cmesh_refine_context_t * r,
+                                t8_eclass_t eclass, t8_locidx_t child_id,
+                                int face, int8_t parent_ttf,
+                                t8_eclass_t neigh_eclass, int is_boundary,
+                                t8_locidx_t * neigh_child, int8_t * ttf)
 {
-  if (parent_id >= cmesh_from->num_local_trees) {
-    /* The parent is a ghost */
-    return t8_cmesh_refine_childid_to_localid (id_array, parent_id
-                                               - cmesh_from->num_local_trees,
-                                               child_id)
-      + cmesh_from->num_local_trees * factor;   /* This is the new number of local trees */
+  int                 digits[T8_CMESH_REFINE_MAX_LEVEL];
+  int                 il, F, sibling, is_inner;
+
+  F = t8_eclass_max_num_faces[t8_eclass_to_dimension[eclass]];
+  t8_cmesh_refine_child_digits (r, child_id, digits);
+  /* Find the finest level at which the face lies inside the parent */
+  for (il = r->level - 1; il >= 0; il--) {
+    if (t8_cmesh_refine_inner_neighbor (eclass, digits[il], face, F,
+                                        &sibling, ttf)) {
+      break;
+    }
+  }
+  is_inner = il >= 0;
+  if (!is_inner) {
+    /* The face lies on the face of the tree */
+    *ttf = parent_ttf;
+    if (is_boundary) {
+      /* We are at the boundary and the child is its own neighbor */
+      *neigh_child = child_id;
+      return 0;
+    }
   }
   else {
-    /* The parent is a tree */
-    return parent_id * factor + child_id;
+    /* The neighbor is in the same tree */
+    digits[il] = sibling;
+    neigh_eclass = eclass;
+  }
+  /* Follow the face of the neighbor through the remaining levels.
+   * The face number and orientation stay the same */
+  for (il++; il < r->level; il++) {
+    digits[il] = t8_cmesh_refine_outer_neighbor (eclass, digits[il], face,
+                                                 neigh_eclass, *ttf % F,
+                                                 *ttf / F);
   }
+  *neigh_child = t8_cmesh_refine_child_id (r, digits);
+  return is_inner;
 }
 
-/*TODO: Will this function be used?*/
-#if 0
-static void
-t8_cmesh_refine_fill_childids (t8_eclass_t eclass, int **childidsA,
-                               int **childidsB)
+/* Return the local id in the refined cmesh of a child of a ghost parent.
+ * The child must be a ghost in the refined cmesh. */
+static              t8_locidx_t
+t8_cmesh_refine_ghost_child_local_id (const t8_cmesh_refine_context_t * r,
+                                      t8_locidx_t gparent,
+                                      t8_locidx_t child_id)
 {
-  /* These arrays decode at index num_faces*or + neighbor_face the child id of the neighbor
-   * that we are connected to. For example if we consider child_id 0 and now it
-   * has a face neighbor along face 2 with orientation 0, then the child_id of
-   * the coarse neighbor's child we are connected to is neigh_childidsA[3*0+2] = 0.
-   * The encoding is such that neigh_childidsA is for child_id 0 (all iface) and child_id 1 if
-   * iface = 0, neigh_childidsB is for child_id 2 (all iface) and child_id 1 if iface = 1.
-   */
-  /* TODO: t8_eclass_num_children is deprecated */
-  *childidsA = T8_ALLOC (int, t8_eclass_num_children[eclass] * 2);
-  *childidsB = T8_ALLOC (int, t8_eclass_num_children[eclass] * 2);
-  switch (eclass) {
-  case T8_ECLASS_QUAD:
-    (*childidsA)[0] = (*childidsB)[4] = 0;
-    (*childidsA)[1] = (*childidsB)[5] = 1;
-    (*childidsA)[2] = (*childidsB)[6] = 0;
-    (*childidsA)[3] = (*childidsB)[7] = 2;
-    (*childidsA)[4] = (*childidsB)[0] = 2;
-    (*childidsA)[5] = (*childidsB)[1] = 3;
-    (*childidsA)[6] = (*childidsB)[2] = 1;
-    (*childidsA)[7] = (*childidsB)[3] = 3;
-    break;
-  case T8_ECLASS_TRIANGLE:
-    (*childidsA)[0] = (*childidsB)[3] = 1;
-    (*childidsA)[1] = (*childidsB)[4] = 0;
-    (*childidsA)[2] = (*childidsB)[5] = 0;
-    (*childidsA)[3] = (*childidsB)[0] = 2;
-    (*childidsA)[4] = (*childidsB)[1] = 2;
-    (*childidsA)[5] = (*childidsB)[2] = 1;
-    break;
-  default:
-    SC_ABORT_NOT_REACHED ();
+  t8_locidx_t        *first, *found;
+
+  first = (t8_locidx_t *) r->ghost_children.array +
+    r->ghost_offsets[gparent];
+  found = (t8_locidx_t *) bsearch (&child_id, first,
+                                   r->ghost_offsets[gparent + 1] -
+                                   r->ghost_offsets[gparent],
+                                   sizeof (t8_locidx_t),
+                                   t8_cmesh_refine_locidx_compare);
+  T8_ASSERT (found != NULL);
+  return r->num_trees + (t8_locidx_t) (found -
+                                       (t8_locidx_t *) r->ghost_children.
+                                       array);
+}
+
+/* Given the local id of a tree or ghost in cmesh_from and a child id,
+ * compute the new local id of the child to be used as a face neighbor. */
+static              t8_locidx_t
+t8_cmesh_refine_new_neighborid (const t8_cmesh_refine_context_t * r,
+                                t8_locidx_t parent_id, t8_locidx_t child_id)
+{
+  const t8_cmesh_t    cmesh_from = r->cmesh_from;
+
+  if (r->num_dropped <= parent_id
+      && parent_id < cmesh_from->num_local_trees) {
+    /* The parent is a tree and its children are local trees */
+    return (parent_id - r->num_dropped) * r->factor + child_id;
   }
+  if (parent_id < r->num_dropped) {
+    /* The parent is the shared first tree */
+    return t8_cmesh_refine_ghost_child_local_id (r, parent_id, child_id);
+  }
+  /* The parent is a ghost */
+  return t8_cmesh_refine_ghost_child_local_id (r, parent_id
+                                               - cmesh_from->num_local_trees
+                                               + r->num_dropped, child_id);
 }
-#endif
 
-/* Given a parent's global tree/ghost id and a child_id,
- * compute the new global id of the child. */
-/* TODO: This will not work anymore when pyramids are used together with other types */
-static              t8_gloidx_t
-t8_cmesh_refine_new_globalid (t8_gloidx_t parent_id, int child_id, int factor)
+/* Return the eclass of a tree or ghost in cmesh_from given by its local id */
+static              t8_eclass_t
+t8_cmesh_refine_local_class (t8_cmesh_t cmesh_from, t8_locidx_t local_id)
 {
-  return parent_id * factor + child_id;
+  if (local_id < cmesh_from->num_local_trees) {
+    return t8_cmesh_get_tree_class (cmesh_from, local_id);
+  }
+  return t8_cmesh_get_ghost_class (cmesh_from,
+                                   local_id - cmesh_from->num_local_trees);
 }
 
-/* TODO: Will this function be needed? */
-#if 0
-static void
-t8_cmesh_refine_outer_faces (t8_cmesh_t cmesh_from, t8_locidx_t parent_id,
-                             t8_gloidx_t global_parent_id,
-                             t8_eclass_t eclass,
-                             t8_child_id_to_local_id ** id_array,
-                             int child_id,
-                             t8_locidx_t * neighbor_out,
-                             t8_gloidx_t * neighbor_out_ghost,
-                             t8_locidx_t * neighbor_old,
-                             t8_gloidx_t * gneighbor_old,
-                             int8_t * ttf_out, int8_t * ttf_old, int factor,
-                             int compute_ghost)
+/* Return the eclass of a tree in cmesh_from given by its global id.
+ * If the tree is neither a local tree nor a ghost, we do not know its eclass
+ * and return the fallback eclass instead. */
+/* TODO: For hybrid meshes the neighbors of ghosts may have a different eclass
+ *       than the ghost. We would need to communicate their eclasses. */
+static              t8_eclass_t
+t8_cmesh_refine_global_class (t8_cmesh_t cmesh_from, t8_gloidx_t global_id,
+                              t8_eclass_t fallback)
 {
-  int                *neigh_childidsA, *neigh_childidsB;
-  int                 num_faces, iface, F;
-  int                 old_face, orient;
-  int                 new_neigh_childid;
-  t8_locidx_t         old_neigh;
-  t8_gloidx_t         old_neigh_ghost;
-
-  num_faces = t8_eclass_num_faces[eclass];
-  t8_cmesh_refine_fill_childids (eclass, &neigh_childidsA, &neigh_childidsB);
-  F = t8_eclass_max_num_faces[cmesh_from->dimension];
-  for (iface = 0; iface < num_faces; iface++) {
-    if (iface == child_id) {
-      /* We already set this side */
-      continue;
-    }
-    /* Get the old face neighbor, face number and orientation */
-    if (!compute_ghost) {
-      old_neigh = neighbor_old[iface];
-    }
-    else {
-      old_neigh_ghost = gneighbor_old[iface];
-    }
-    old_face = ttf_old[iface] % F;
-    orient = ttf_old[iface] / F;
-    if (!compute_ghost && old_neigh == parent_id) {
-      /* We are local tree and this side is a boundary,
-       * so we set our own local id as face neighbor */
-      neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                            parent_id,
-                                                            child_id,
-                                                            id_array, factor);
-    }
-    else if (compute_ghost && old_neigh_ghost == global_parent_id) {
-      /* We are local ghost and this side is a boundary,
-       * so we set our own glocal id as face neighbor */
-      neighbor_out_ghost[iface] =
-        t8_cmesh_refine_new_globalid (global_parent_id, child_id, factor);
-    }
-    else {
-      /* depending on the child_id and old_face we set the new neighbors
-       * child_id */
-      if (2 * child_id + iface <= 2) {
-        new_neigh_childid = neigh_childidsA[orient * 3 + old_face];
-      }
-      else {
-        new_neigh_childid = neigh_childidsB[orient * 3 + old_face];
-      }
-      if (!compute_ghost) {
-        /* Compute the new neighbors local id from the old one and the new
-         * child id */
-        neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                              old_neigh,
-                                                              new_neigh_childid,
-                                                              id_array,
-                                                              factor);
-      }
-      else {
-        neighbor_out_ghost[iface] =
-          t8_cmesh_refine_new_globalid (old_neigh_ghost,
-                                        new_neigh_childid, factor);
-      }
+  t8_locidx_t         local_id;
+
+  if (cmesh_from->first_tree <= global_id
+      && global_id < cmesh_from->first_tree + cmesh_from->num_local_trees) {
+    return t8_cmesh_get_tree_class (cmesh_from, (t8_locidx_t)
+                                    (global_id - cmesh_from->first_tree));
+  }
+  local_id = t8_cmesh_trees_get_ghost_local_id (cmesh_from->trees,
+                                                global_id);
+  if (local_id >= 0) {
+    return t8_cmesh_refine_local_class (cmesh_from, local_id);
+  }
+  return fallback;
+}
+
+/* Get the eclass, the global id and the face neighbors of a ghost parent.
+ * The global ids of the face neighbors are stored in neighbors, which must
+ * have space for all faces. The tree to face values are returned in ttf. */
+static              t8_eclass_t
+t8_cmesh_refine_ghost_parent (const t8_cmesh_refine_context_t * r,
+                              t8_locidx_t gparent, t8_gloidx_t * global_id,
+                              t8_gloidx_t * neighbors, int8_t ** ttf)
+{
+  const t8_cmesh_t    cmesh_from = r->cmesh_from;
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  t8_locidx_t        *tree_neighbors;
+  t8_gloidx_t        *ghost_neighbors;
+  int                 iface;
+
+  if (gparent < r->num_dropped) {
+    /* The parent is the shared first tree */
+    tree = t8_cmesh_trees_get_tree_ext (cmesh_from->trees, gparent,
+                                        &tree_neighbors, ttf);
+    *global_id = cmesh_from->first_tree + gparent;
+    for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+      neighbors[iface] =
+        t8_cmesh_get_global_id (cmesh_from, tree_neighbors[iface]);
     }
-    /* The new orientation and face number are the same as the old
-     * ones so we do not need to change ttf_out */
-    ttf_out[iface] = ttf_old[iface];
+    return tree->eclass;
   }
+  ghost = t8_cmesh_trees_get_ghost_ext (cmesh_from->trees,
+                                        gparent - r->num_dropped,
+                                        &ghost_neighbors, ttf);
+  *global_id = ghost->treeid;
+  memcpy (neighbors, ghost_neighbors,
+          t8_eclass_num_faces[ghost->eclass] * sizeof (t8_gloidx_t));
+  return ghost->eclass;
 }
-#endif
 
-/* TODO: comment */
-/* The eclass is the eclass of the parent tree */
-/* parent_id is the local id of the parent and global_parent_id the
- * global one. The global id is only needed when parent is a ghost */
-/* id_array is the array storing the new local ids of the ghosts */
-/* neighbor_out are the face neighbors if parent is a local tree and
- * neighbor_out_ghost if parent is a ghost */
-/* Factor should be the same whether parent is a tree or a ghost */
+/* For each ghost parent find its children that are ghosts in the refined cmesh.
+ * These are the children on the faces of the parent that are connected to
+ * a local tree whose children are kept. */
 static void
-t8_cmesh_refine_new_neighbors (t8_cmesh_t cmesh_from, t8_locidx_t parent_id,
-                               t8_gloidx_t global_parent_id,
-                               t8_eclass_t eclass,
-                               t8_child_id_to_local_id ** id_array,
-                               int child_id,
-                               t8_locidx_t * neighbor_out,
-                               t8_gloidx_t * neighbor_out_ghost,
-                               int8_t * ttf_out, int factor)
+t8_cmesh_refine_count_ghosts (t8_cmesh_refine_context_t * r)
 {
-  t8_locidx_t         iface, old_neigh = -1, *neighbor_old;     /* old_neigh and old_neigh_ghost get initial */
-  t8_gloidx_t         old_neigh_ghost = -1, *gneighbor_old;     /* values to prevent unused variable warnings */
-  int8_t             *ttf_old;
-  int                 num_faces, F, dim, old_face, orient, new_neigh_childid;
-  int                 compute_ghost, k;
-
-  /* One of the inputs must be NULL and the other one must be set */
-  T8_ASSERT (neighbor_out == NULL || neighbor_out_ghost == NULL);
-  T8_ASSERT (neighbor_out != NULL || neighbor_out_ghost != NULL);
-
-  /* Flag to decide whether we compute the neighbors of a ghost or not */
-  compute_ghost = neighbor_out_ghost != NULL;
-
-  dim = t8_eclass_to_dimension[eclass];
-  F = t8_eclass_max_num_faces[dim];
-  num_faces = t8_eclass_num_faces[eclass];
-  if (compute_ghost) {
-    (void) t8_cmesh_trees_get_ghost_ext (cmesh_from->trees, parent_id,
-                                         &gneighbor_old, &ttf_old);
-  }
-  else {
-    (void) t8_cmesh_trees_get_tree_ext (cmesh_from->trees, parent_id,
-                                        &neighbor_old, &ttf_old);
+  const t8_cmesh_t    cmesh_from = r->cmesh_from;
+  t8_gloidx_t         global_id, neighbors[T8_ECLASS_MAX_FACES];
+  t8_gloidx_t         first_local, end_local;
+  t8_locidx_t         gparent, idesc, num_face_desc, num_new, num_unique;
+  t8_locidx_t        *children;
+  t8_eclass_t         eclass;
+  int8_t             *ttf;
+  int                 iface, il, desc, num_face_children;
+  int                 digits[T8_CMESH_REFINE_MAX_LEVEL];
+  size_t              first, ichild;
+
+  r->num_ghost_parents = cmesh_from->num_ghosts + r->num_dropped;
+  r->ghost_offsets = T8_ALLOC (t8_locidx_t, r->num_ghost_parents + 1);
+  sc_array_init (&r->ghost_children, sizeof (t8_locidx_t));
+
+  /* The number of children of level level on a face */
+  num_face_children = r->num_children / 2;
+  for (il = 0, num_face_desc = 1; il < r->level; il++) {
+    num_face_desc *= num_face_children;
   }
-  switch (eclass) {
-  case T8_ECLASS_QUAD:
-    /* Inner face connections */
-    /* For the inner face connections we have
-     *                 faces
-     * child_id     f_0 f_1 f_2 f_3
-     *    0          -   1   -   2
-     *    1          0   -   -   3
-     *    2          -   3   0   -
-     *    3          2   -   1   -
-     *
-     *   This means that child i along its face f_j is connected to the child
-     *   given in the table.
-     *   These values can be computed as follows:
-     *   child i is connected along face 1-(i%2) with child (1 xor i)
-     *                    and along face 3-(i/2) with child (2 xor i)
-     *   The face number on the neighbor of this connection is (j xor 1)
-     * The orientation for each of these connections is 0.
-     */
-    for (k = 1, iface = 1 - (child_id % 2); k <= 2;
-         k++, iface = 3 - child_id / 2) {
-      if (!compute_ghost) {
-        neighbor_out[iface] =
-          t8_cmesh_refine_new_neighborid (cmesh_from, parent_id, child_id ^ k,
-                                          id_array, factor);
-      }
-      else {
-        neighbor_out_ghost[iface] =
-          t8_cmesh_refine_new_globalid (global_parent_id, child_id ^ k,
-                                        factor);
+  /* The global ids of the trees whose children are local */
+  first_local = cmesh_from->first_tree + r->num_dropped;
+  end_local = cmesh_from->first_tree + cmesh_from->num_local_trees;
+
+  for (gparent = 0; gparent < r->num_ghost_parents; gparent++) {
+    first = r->ghost_children.elem_count;
+    r->ghost_offsets[gparent] = (t8_locidx_t) first;
+    eclass = t8_cmesh_refine_ghost_parent (r, gparent, &global_id,
+                                           neighbors, &ttf);
+    T8_ASSERT (eclass != T8_ECLASS_PRISM && eclass != T8_ECLASS_PYRAMID
+               && eclass != T8_ECLASS_VERTEX);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      if (neighbors[iface] < first_local || neighbors[iface] >= end_local) {
+        /* This face is not connected to a local tree */
+        continue;
       }
-      ttf_out[iface] = iface ^ 1;
-    }
-    /* Outer face connections */
-    for (k = 0, iface = child_id % 2; k < 2; k++, iface = 2 + child_id / 2) {
-      /* Get the old face neighbor, face number and orientation */
-      if (!compute_ghost) {
-        old_neigh = neighbor_old[iface];
-      }
-      else {
-        old_neigh_ghost = gneighbor_old[iface];
-      }
-      old_face = ttf_old[iface] % F;
-      orient = ttf_old[iface] / F;
-      if (!compute_ghost && old_neigh == parent_id) {
-        /* We are local tree and this side is a boundary,
-         * so we set our own local id as face neighbor */
-        neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                              parent_id,
-                                                              child_id,
-                                                              id_array,
-                                                              factor);
-      }
-      else if (compute_ghost && old_neigh_ghost == global_parent_id) {
-        /* We are local ghost and this side is a boundary,
-         * so we set our own glocal id as face neighbor */
-        neighbor_out_ghost[iface] =
-          t8_cmesh_refine_new_globalid (global_parent_id, child_id, factor);
-      }
-      else {
-        /* We are connected to another tree */
-        /* These arrays decode at index 4*or + neighbor_face the child id of the neighbor
-         * that we are connected to. For example if we consider child_id 0 and now it
-         * has a face neighbor along face 2 with orientation 0, then the child_id of
-         * the coarse neighbor's child we are connected to is neigh_childidsA[4*0+2] = 0.
-         * The encoding is such that neigh_childidsA is for child_id 0 (all iface), child_id 1 if
-         * iface = 2, child_id 3 if iface = 3, neigh_childidsB is for child_id 1 if iface = 1,
-         * child_id 2 if iface = 0 and child_id 3 (all ifaces).
-         */
-        int                 neigh_childidsA[8] = { 0, 1, 0, 2, 2, 3, 1, 3 };
-        int                 neigh_childidsB[8] = { 2, 3, 1, 3, 0, 1, 0, 2 };
-        /* depending on the child_id and old_face we set the new neighbors
-         * child_id */
-        if (child_id == 0 || (child_id != 3 && iface % 2)) {
-          new_neigh_childid = neigh_childidsA[orient * 4 + old_face];
-        }
-        else {
-          T8_ASSERT (child_id == 3 || iface % 2 == 0);
-          new_neigh_childid = neigh_childidsB[orient * 4 + old_face];
-        }
-        if (!compute_ghost) {
-          /* Compute the new neighbors local id from the old one and the new
-           * child id */
-          neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                                old_neigh,
-                                                                new_neigh_childid,
-                                                                id_array,
-                                                                factor);
+      /* Add all children on this face */
+      for (idesc = 0; idesc < num_face_desc; idesc++) {
+        for (il = r->level - 1, desc = idesc; il >= 0; il--) {
+          digits[il] = t8_cmesh_refine_face_children[eclass][iface]
+            [desc % num_face_children];
+          desc /= num_face_children;
         }
-        else {
-          neighbor_out_ghost[iface] =
-            t8_cmesh_refine_new_globalid (old_neigh_ghost,
-                                          new_neigh_childid, factor);
-        }
-      }
-      /* The new orientation and face number are the same as the old
-       * ones so we do not need to change ttf_out */
-      ttf_out[iface] = ttf_old[iface];
-    }
-    break;
-  case T8_ECLASS_TRIANGLE:
-    if (child_id == 3) {
-      T8_ASSERT (!compute_ghost);
-      /* The triangle in the middle is connect to child i on face i.
-       * The orientation of each edge is 1 */
-      for (iface = 0; iface < num_faces; iface++) {
-        /* Set the new local id of the face neighbors */
-        /* face    neighbor child_id      2 - face
-         *   0          2                   2
-         *   1          1                   1
-         *   2          0                   0
-         */
-        neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                              parent_id,
-                                                              2 - iface,
-                                                              id_array,
-                                                              factor);
-        /* Set the new orientation and face number */
-        ttf_out[iface] = 1 * F + 2 - iface;
+        *(t8_locidx_t *) sc_array_push (&r->ghost_children) =
+          t8_cmesh_refine_child_id (r, digits);
       }
     }
-    else {
-      /* child_id is 0,1,2 */
-      T8_ASSERT (0 <= child_id && child_id <= 2);
-      if (!compute_ghost) {
-        /* Along face number child_id we are connected with the middle triangle
-         * which has child_id = 3, we are connected with its face 2 - child_id */
-        neighbor_out[child_id] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                                 parent_id, 3,
-                                                                 id_array,
-                                                                 factor);
-      }
-      else {
-        neighbor_out_ghost[child_id] =
-          t8_cmesh_refine_new_globalid (global_parent_id, 3, factor);
-      }
-      ttf_out[child_id] = 1 * F + 2 - child_id;
-      for (iface = 0; iface < num_faces; iface++) {
-        if (iface == child_id) {
-          /* We already set this side */
-          continue;
-        }
-        /* Get the old face neighbor, face number and orientation */
-        if (!compute_ghost) {
-          old_neigh = neighbor_old[iface];
-        }
-        else {
-          old_neigh_ghost = gneighbor_old[iface];
-        }
-        old_face = ttf_old[iface] % F;
-        orient = ttf_old[iface] / F;
-        if (!compute_ghost && old_neigh == parent_id) {
-          /* We are local tree and this side is a boundary,
-           * so we set our own local id as face neighbor */
-          neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                                parent_id,
-                                                                child_id,
-                                                                id_array,
-                                                                factor);
-        }
-        else if (compute_ghost && old_neigh_ghost == global_parent_id) {
-          /* We are local ghost and this side is a boundary,
-           * so we set our own glocal id as face neighbor */
-          neighbor_out_ghost[iface] =
-            t8_cmesh_refine_new_globalid (global_parent_id, child_id, factor);
-        }
-        else {
-          /* These arrays decode at index 3*or + neighbor_face the child id of the neighbor
-           * that we are connected to. For example if we consider child_id 0 and now it
-           * has a face neighbor along face 2 with orientation 0, then the child_id of
-           * the coarse neighbor's child we are connected to is neigh_childidsA[3*0+2] = 0.
-           * The encoding is such that neigh_childidsA is for child_id 0 (all iface) and child_id 1 if
-           * iface = 0, neigh_childidsB is for child_id 2 (all iface) and child_id 1 if iface = 1.
-           */
-          int                 neigh_childidsA[6] = { 1, 0, 0, 2, 2, 1 };
-          int                 neigh_childidsB[6] = { 2, 2, 1, 1, 0, 0 };
-          /* depending on the child_id and old_face we set the new neighbors
-           * child_id */
-          if (2 * child_id + iface <= 2) {
-            new_neigh_childid = neigh_childidsA[orient * 3 + old_face];
-          }
-          else {
-            new_neigh_childid = neigh_childidsB[orient * 3 + old_face];
-          }
-          if (!compute_ghost) {
-            /* Compute the new neighbors local id from the old one and the new
-             * child id */
-            neighbor_out[iface] = t8_cmesh_refine_new_neighborid (cmesh_from,
-                                                                  old_neigh,
-                                                                  new_neigh_childid,
-                                                                  id_array,
-                                                                  factor);
-          }
-          else {
-            neighbor_out_ghost[iface] =
-              t8_cmesh_refine_new_globalid (old_neigh_ghost,
-                                            new_neigh_childid, factor);
-          }
+    /* Sort the children of this parent and remove duplicates, which
+     * occur for children on more than one of these faces */
+    children = (t8_locidx_t *) r->ghost_children.array + first;
+    num_new = (t8_locidx_t) (r->ghost_children.elem_count - first);
+    if (num_new > 0) {
+      qsort (children, num_new, sizeof (t8_locidx_t),
+             t8_cmesh_refine_locidx_compare);
+      for (ichild = 1, num_unique = 1; ichild < (size_t) num_new; ichild++) {
+        if (children[ichild] != children[num_unique - 1]) {
+          children[num_unique++] = children[ichild];
         }
-        /* The new orientation and face number are the same as the old
-         * ones so we do not need to change ttf_out */
-        ttf_out[iface] = ttf_old[iface];
       }
+      sc_array_resize (&r->ghost_children, first + num_unique);
     }
-    break;
-  default:
-    SC_ABORTF ("Not implemented %s.\n", "yet");
   }
+  r->ghost_offsets[r->num_ghost_parents] =
+    (t8_locidx_t) r->ghost_children.elem_count;
 }
 
 /* Compute the coordinates of the i-th child of a tree of a given class
@@ -548,30 +498,31 @@ t8_cmesh_refine_new_neighbors (t8_cmesh_t cmesh_from, t8_locidx_t parent_id,
  *    x_0          x_1
  *
  */
-/* TODO: Implement for prisms, Pyramids, points and lines */
+/* TODO: Implement for prisms, Pyramids and points */
 static void
 t8_cmesh_refine_new_coord (const double *coords_in,
                            t8_eclass_t eclass, int child_id,
                            double *coords_out)
 {
-  int                 num_vertices, ivertex, dim, idim;
+  int                 num_vertices, ivertex, idim;
   int                 coord_lookup[8];
 
   T8_ASSERT (coords_in != NULL);
   T8_ASSERT (eclass == T8_ECLASS_HEX || eclass == T8_ECLASS_QUAD
-             || eclass == T8_ECLASS_TRIANGLE || eclass == T8_ECLASS_TET);
+             || eclass == T8_ECLASS_LINE || eclass == T8_ECLASS_TRIANGLE
+             || eclass == T8_ECLASS_TET);
 
   num_vertices = t8_eclass_num_vertices[eclass];
-  dim = t8_eclass_to_dimension[eclass];
   switch (eclass) {
+  case T8_ECLASS_LINE:
   case T8_ECLASS_QUAD:
   case T8_ECLASS_HEX:
     for (ivertex = 0; ivertex < num_vertices; ivertex++) {
-      for (idim = 0; idim < dim; idim++) {
+      for (idim = 0; idim < 3; idim++) {
         /* Xout_i = Xin_i,childid   ,where i=ivertex and x_ij = (x_i+x_j)/2 */
-        coords_out[dim * ivertex + idim] =
-          (coords_in[dim * ivertex + idim] +
-           coords_in[dim * child_id + idim]) / 2;
+        coords_out[3 * ivertex + idim] =
+          (coords_in[3 * ivertex + idim] +
+           coords_in[3 * child_id + idim]) / 2;
       }
     }
     break;
@@ -654,286 +605,232 @@ t8_cmesh_refine_new_coord (const double *coords_in,
   }
 }
 
-/* Set the number of attributes and the class for each child of a given tree in cmesh_from */
+/* Compute the coordinates of a child of a tree from the coordinates of that
+ * tree. The child is given by its child id after level refinement steps. */
+static void
+t8_cmesh_refine_child_coords (const t8_cmesh_refine_context_t * r,
+                              const double *coords_in, t8_eclass_t eclass,
+                              t8_locidx_t child_id, double *coords_out)
+{
+  double              temp[2][3 * T8_ECLASS_MAX_CORNERS];
+  const double       *coords_from;
+  int                 digits[T8_CMESH_REFINE_MAX_LEVEL];
+  int                 il;
+
+  t8_cmesh_refine_child_digits (r, child_id, digits);
+  coords_from = coords_in;
+  for (il = 0; il < r->level; il++) {
+    if (il == r->level - 1) {
+      t8_cmesh_refine_new_coord (coords_from, eclass, digits[il], coords_out);
+    }
+    else {
+      t8_cmesh_refine_new_coord (coords_from, eclass, digits[il],
+                                 temp[il % 2]);
+      coords_from = temp[il % 2];
+    }
+  }
+}
+
+/* Set the class, the tree id and the number of attributes of a child tree.
+ * itree is the local id of the child in the refined cmesh. */
 static void
-t8_cmesh_refine_inittree (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
-                          t8_locidx_t treeid, t8_locidx_t firstnewtree,
-                          int factor)
+t8_cmesh_refine_inittree (t8_cmesh_t cmesh,
+                          const t8_cmesh_refine_context_t * r,
+                          t8_locidx_t itree)
 {
   t8_ctree_t          tree, newtree;
-  t8_locidx_t         itree;
-  t8_locidx_t        *tree_neighbors;
-  int8_t             *ttf;
-  size_t              newattr_size;
 
-  tree = t8_cmesh_trees_get_tree_ext (cmesh_from->trees, treeid,
-                                      &tree_neighbors, &ttf);
-  newattr_size = t8_cmesh_trees_attribute_size (tree);
-  for (itree = 0; itree < factor; itree++) {
-    newtree = t8_cmesh_trees_get_tree (cmesh->trees, firstnewtree + itree);
-    newtree->eclass = tree->eclass;     /* TODO: For pyramid support we will
+  tree = t8_cmesh_trees_get_tree (r->cmesh_from->trees,
+                                  itree / r->factor + r->num_dropped);
+  newtree = t8_cmesh_trees_get_tree (cmesh->trees, itree);
+  newtree->eclass = tree->eclass;       /* TODO: For pyramid support we will
                                            need to change the eclass here to tets for some trees */
-    newtree->num_attributes = tree->num_attributes;
-    newtree->treeid = firstnewtree + itree;
-    t8_cmesh_trees_init_attributes (cmesh->trees, firstnewtree + itree,
-                                    newtree->num_attributes, newattr_size);
-  }
+  newtree->treeid = itree;
+  t8_cmesh_trees_init_attributes (cmesh->trees, itree, tree->num_attributes,
+                                  t8_cmesh_trees_attribute_size (tree));
 }
 
-/* Set the attributes and face_neighbors for each child of a given tree (treeid) in cmesh_from */
-/* The attributes are just copies of the parent's attributes,
+/* Set the attributes and face_neighbors of a child tree.
+ * The attributes are just copies of the parent's attributes,
  * except for the coordinate attribute if it is set (t8_package_id and key=0).
  * The new coordinates are then calculated.
+ * attr_offsets and info_offsets store for each parent the number of
+ * attribute bytes and attributes of all children of previous parents.
+ * We set the attribute offsets directly instead of using
+ * t8_cmesh_trees_add_attribute, such that the children can be
+ * filled independent of each other.
  */
 static void
-t8_cmesh_refine_tree (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
-                      t8_child_id_to_local_id ** id_array,
-                      t8_locidx_t treeid, t8_locidx_t firstnewtree,
-                      int factor)
+t8_cmesh_refine_tree (t8_cmesh_t cmesh, const t8_cmesh_refine_context_t * r,
+                      t8_locidx_t itree, const size_t * attr_offsets,
+                      const size_t * info_offsets)
 {
+  const t8_cmesh_t    cmesh_from = r->cmesh_from;
   t8_ctree_t          tree, newtree;
-  t8_locidx_t         itree;
+  t8_locidx_t         parent_id, child_id, neigh_child;
   t8_locidx_t        *tree_neighbors, *ntree_neighbors;
+  t8_eclass_t         neigh_eclass;
   int8_t             *ttf, *nttf;
-  int                 iatt;
-  double             *coords;
-  t8_attribute_info_struct_t *attr_info;
-  t8_stash_attribute_struct_t attr_struct;
-
-  tree = t8_cmesh_trees_get_tree_ext (cmesh_from->trees, treeid,
+  int                 iatt, iface, is_boundary;
+  size_t              ipart, attr_size, offset;
+  t8_attribute_info_struct_t *attr_info, *nattr_info;
+
+  parent_id = itree / r->factor + r->num_dropped;
+  child_id = itree % r->factor;
+  ipart = parent_id - r->num_dropped;
+  tree = t8_cmesh_trees_get_tree_ext (cmesh_from->trees, parent_id,
                                       &tree_neighbors, &ttf);
-  for (itree = 0; itree < factor; itree++) {
-    newtree = t8_cmesh_trees_get_tree_ext (cmesh->trees, firstnewtree + itree,
-                                           &ntree_neighbors, &nttf);
-    /* Set all attributes of the child tree */
-    for (iatt = 0; iatt < tree->num_attributes; iatt++) {
-      attr_info = T8_TREE_ATTR_INFO (tree, iatt);
-      attr_struct.attr_data = T8_TREE_ATTR (tree, attr_info);
-      attr_struct.attr_size = attr_info->attribute_size;
-      attr_struct.id = cmesh->first_tree + firstnewtree + itree;
-      attr_struct.key = attr_info->key;
-      attr_struct.package_id = attr_info->package_id;
-      attr_struct.is_owned = 0; /* Make sure that the attribute data is copied
-                                   from the old tree */
-      t8_cmesh_trees_add_attribute (cmesh->trees, 0, &attr_struct,
-                                    firstnewtree + itree, iatt);
-      if (attr_struct.package_id == t8_get_package_id ()
-          && attr_struct.key == 0) {
-        /* The attribute was the tree's coordinates.
-         * In this case we compute the new coordinates */
-        /* TODO: We assume here that this particular combination of package id and
-         *       key is only used for attributes. This must be ensured */
-        coords = (double *) T8_TREE_ATTR (newtree, T8_TREE_ATTR_INFO (newtree,
-                                                                      iatt));
-        /* coords is the attribute of newtree */
-        t8_cmesh_refine_new_coord ((double *) attr_struct.attr_data,
-                                   tree->eclass, itree, coords);
-        attr_struct.is_owned = 1;
-      }
+  newtree = t8_cmesh_trees_get_tree_ext (cmesh->trees, itree,
+                                         &ntree_neighbors, &nttf);
+  /* Set all attributes of the child tree.
+   * The data of all attributes is stored behind the attribute infos
+   * of all trees. The attribute offsets are relative to the tree's first
+   * attribute info. */
+  attr_size = (attr_offsets[ipart + 1] - attr_offsets[ipart]) / r->factor;
+  offset = (info_offsets[r->num_trees / r->factor] - info_offsets[ipart]
+            - child_id * tree->num_attributes)
+    * sizeof (t8_attribute_info_struct_t)
+    + attr_offsets[ipart] + child_id * attr_size;
+  for (iatt = 0; iatt < tree->num_attributes; iatt++) {
+    attr_info = T8_TREE_ATTR_INFO (tree, iatt);
+    nattr_info = T8_TREE_ATTR_INFO (newtree, iatt);
+    nattr_info->key = attr_info->key;
+    nattr_info->package_id = attr_info->package_id;
+    nattr_info->attribute_size = attr_info->attribute_size;
+    nattr_info->attribute_offset = offset;
+    offset += attr_info->attribute_size;
+    if (attr_info->package_id == t8_get_package_id ()
+        && attr_info->key == 0) {
+      /* The attribute was the tree's coordinates.
+       * In this case we compute the new coordinates */
+      /* TODO: We assume here that this particular combination of package id and
+       *       key is only used for attributes. This must be ensured */
+      t8_cmesh_refine_child_coords (r, (double *)
+                                    T8_TREE_ATTR (tree, attr_info),
+                                    tree->eclass, child_id, (double *)
+                                    T8_TREE_ATTR (newtree, nattr_info));
+    }
+    else {
+      memcpy (T8_TREE_ATTR (newtree, nattr_info),
+              T8_TREE_ATTR (tree, attr_info), attr_info->attribute_size);
     }
-    /* Set all face_neighbors of the child tree */
-    t8_cmesh_refine_new_neighbors (cmesh_from, treeid, -1, tree->eclass,
-                                   id_array, itree,
-                                   ntree_neighbors, NULL, nttf, factor);
   }
-}
-
-/* Set the class for each child of a given ghost in cmesh_from.
- * The number of childs that stay a ghost on this process depends on the
- * faces of the ghost connected to local trees. */
-static void
-t8_cmesh_refine_initghost (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
-                           t8_child_id_to_local_id ** idarray,
-                           t8_locidx_t ghostid, int factor)
-{
-  t8_cghost_t         ghost, newghost;
-  t8_locidx_t         ighost, lghost_id;
-  t8_gloidx_t        *ghost_neighbors;
-  int8_t             *ttf, child_id = -2;
-
-  ghost = t8_cmesh_trees_get_ghost_ext (cmesh_from->trees, ghostid,
-                                        &ghost_neighbors, &ttf);
-  child_id = idarray[ghostid][0].child_id;
-  for (ighost = 0; child_id != -1; ighost++) {
-    lghost_id = idarray[ghostid][ighost].local_id;
-    newghost = t8_cmesh_trees_get_ghost (cmesh->trees, lghost_id);
-    newghost->eclass = ghost->eclass;   /* TODO: For pyramid support we will
-                                           need to change the eclass here to tets for some ghosts */
-    /*     ighost     child_id
-     * tri
-     * face 0
-     *        0           1
-     *        1           2
-     * face 1
-     *        0           0
-     *        1           2
-     * face 2
-     *        0           0
-     *        1           1
-     */
-    newghost->treeid = ghost->treeid * factor + child_id;
-    child_id = idarray[ghostid][ighost + 1].child_id;
+  /* Set all face_neighbors of the child tree */
+  for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
+    is_boundary = tree_neighbors[iface] == parent_id
+      && ttf[iface] == iface;
+    neigh_eclass =
+      t8_cmesh_refine_local_class (cmesh_from, tree_neighbors[iface]);
+    if (t8_cmesh_refine_child_neighbor
+        (r, tree->eclass, child_id, iface, ttf[iface], neigh_eclass,
+         is_boundary, &neigh_child, nttf + iface)) {
+      /* The neighbor is a child of the same tree */
+      ntree_neighbors[iface] =
+        t8_cmesh_refine_new_neighborid (r, parent_id, neigh_child);
+    }
+    else {
+      ntree_neighbors[iface] =
+        t8_cmesh_refine_new_neighborid (r, tree_neighbors[iface],
+                                        neigh_child);
+    }
   }
 }
 
+/* Set the face neighbors of all children of a ghost parent that
+ * are ghosts in the refined cmesh. */
 static void
-t8_cmesh_refine_ghost (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
-                       t8_child_id_to_local_id ** idarray,
-                       t8_locidx_t ghostid, int factor)
-{
-  t8_cghost_t         newghost;
-  t8_gloidx_t        *ghost_neighbors, *nghost_neighbors;
-  int8_t             *ttf, *nttf, child_id = -2;
-  t8_locidx_t         lghost_id;
-  int                 ichild;
-
-  (void) t8_cmesh_trees_get_ghost_ext (cmesh_from->trees, ghostid,
-                                       &ghost_neighbors, &ttf);
-  child_id = idarray[ghostid][0].child_id;
-  for (ichild = 0; child_id != -1; ichild++) {
-    lghost_id = idarray[ghostid][ichild].local_id;
-    newghost = t8_cmesh_trees_get_ghost_ext (cmesh->trees, lghost_id,
-                                             &nghost_neighbors, &nttf);
-    /* Set all face_neighbors of the child ghost */
-    /* *INDENT-OFF* */
-    t8_cmesh_refine_new_neighbors (cmesh_from, ghostid,
-     t8_cmesh_get_global_id (cmesh_from, cmesh_from->num_local_trees + ghostid),
-                                   newghost->eclass, idarray, (int) child_id,
-                                   NULL, nghost_neighbors, nttf, factor);
-    /* *INDENT-ON* */
-    child_id = idarray[ghostid][ichild + 1].child_id;
-  }
-}
-
-static              t8_locidx_t
-t8_cmesh_refine_count_ghost (t8_cmesh_t cmesh, t8_cmesh_t cmesh_from,
-                             t8_child_id_to_local_id ** idarray)
+t8_cmesh_refine_ghost (t8_cmesh_t cmesh, const t8_cmesh_refine_context_t * r,
+                       t8_locidx_t gparent)
 {
-  t8_cghost_t         ghost;
-  t8_gloidx_t        *face_neighbor, neighbor;
-  t8_locidx_t         num_ghosts, ighost;
-  int                 iface, ichild, num_face_child, num_local_children;
-  /* For each eclass we give a lookup table of the child id's on a given face.
-   * For example for type T8_ECLASS_QUAD we have
-   *                    f_3
-   *                     _ _
-   *              f_0  |2 3|  f_1
-   *                   |0 1|
-   *                     - -
-   *                    f_2
-   * where the numbers inside refer to the chlid_ids of the quad.
-   * The lookup table then gives:  0 -> 0,2
-   *                               1 -> 1,3
-   *                               2 -> 0,1
-   *                               3 -> 2,3
-   * as can be see in the 2nd line of the array */
-  int8_t              child_id_by_class_and_face[T8_ECLASS_COUNT][6][10] = {
-    {{}},                       /* VERTEX */
-    {{0}, {1}},                 /* LINE */
-    {{0, 2}, {1, 3}, {0, 1}, {2, 3}},   /* QUAD */
-    {{1, 2}, {0, 2}, {0, 1}},   /* TRIANGLE */
-    {{0, 2, 4, 6}, {1, 3, 5, 7}, {0, 1, 4, 5}, {2, 3, 6, 7}, {0, 1, 2, 3}, {4, 5, 6, 7}},       /* HEX */
-    {{1, 2, 3, 7}, {0, 2, 3, 6}, {0, 1, 3, 4}, {0, 1, 2, 5}}    /* TET */
-  };
-  int8_t              child_counted[10] = { 0 }, *temp_child_counted;
-  t8_locidx_t         next_local_id = 0;
-  t8_eclass_scheme_c *ts;
-  t8_element_t       *root_elem;
-
-  num_ghosts = 0;
-  for (ighost = 0; ighost < cmesh_from->num_ghosts; ighost++) {
-    ghost = t8_cmesh_trees_get_ghost_ext (cmesh_from->trees, ighost,
-                                          &face_neighbor, NULL);
-    T8_ASSERT (ghost->eclass != T8_ECLASS_PRISM &&
-               ghost->eclass != T8_ECLASS_PYRAMID &&
-               ghost->eclass != T8_ECLASS_VERTEX);
-
-    /* In order to compute the number of face children of the ghost, we need to call
-     * the element_num_children function with the root element as argument.
-     * Thus, we need to create this root element first. */
-    ts = cmesh->set_refine_scheme->eclass_schemes[ghost->eclass];
-    ts->t8_element_new (1, &root_elem);
-
-    num_local_children = 0;
-    memset (child_counted, 0, 10 * sizeof (int8_t));
-    for (iface = 0; iface < t8_eclass_num_faces[ghost->eclass]; iface++) {
-      /* Compute the number of face children */
-      num_face_child = ts->t8_element_num_face_children (root_elem, iface);
-      neighbor = face_neighbor[iface];
-      if (neighbor >= cmesh_from->first_tree &&
-          neighbor < cmesh_from->first_tree + cmesh_from->num_local_trees) {
-        /* This neighbor of the ghost is a local tree */
-        for (ichild = 0; ichild < num_face_child; ichild++) {
-          /* For each child of this face check whether we counted the corresponding ghost */
-          temp_child_counted =
-            &child_counted[child_id_by_class_and_face[ghost->eclass][iface]
-                           [ichild]];
-          if (*temp_child_counted != 1) {
-            /* If we did not count this ghost child then we do it now */
-            num_ghosts++;
-            num_local_children++;
-            *temp_child_counted = 1;
-          }
-        }
+  t8_gloidx_t         global_id, neighbors[T8_ECLASS_MAX_FACES];
+  t8_gloidx_t        *nghost_neighbors;
+  t8_locidx_t         lghost, child_id, neigh_child;
+  t8_eclass_t         eclass, neigh_eclass;
+  int8_t             *ttf, *nttf;
+  int                 iface, is_boundary;
+
+  eclass = t8_cmesh_refine_ghost_parent (r, gparent, &global_id, neighbors,
+                                         &ttf);
+  for (lghost = r->ghost_offsets[gparent];
+       lghost < r->ghost_offsets[gparent + 1]; lghost++) {
+    child_id = ((t8_locidx_t *) r->ghost_children.array)[lghost];
+    (void) t8_cmesh_trees_get_ghost_ext (cmesh->trees, lghost,
+                                         &nghost_neighbors, &nttf);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      is_boundary = neighbors[iface] == global_id && ttf[iface] == iface;
+      neigh_eclass = t8_cmesh_refine_global_class (r->cmesh_from,
+                                                   neighbors[iface], eclass);
+      if (t8_cmesh_refine_child_neighbor
+          (r, eclass, child_id, iface, ttf[iface], neigh_eclass, is_boundary,
+           &neigh_child, nttf + iface)) {
+        /* The neighbor is a child of the same tree */
+        nghost_neighbors[iface] = global_id * r->factor + neigh_child;
+      }
+      else {
+        nghost_neighbors[iface] = neighbors[iface] * r->factor + neigh_child;
       }
     }
-    next_local_id = t8_cmesh_refine_fill_idarray (idarray, ighost,
-                                                  child_counted,
-                                                  num_local_children,
-                                                  next_local_id);
-    ts->t8_element_destroy (1, &root_elem);
   }
-  return num_ghosts;
 }
 
 void
 t8_cmesh_refine (t8_cmesh_t cmesh)
 {
   t8_cmesh_t          cmesh_from;
-  t8_locidx_t         itree, firstnewtree;
-  t8_locidx_t         ighost;
-  t8_child_id_to_local_id **idarray;
-  int                 dim, factor, level, iclass;
+  t8_cmesh_refine_context_t r;
+  t8_ctree_t          tree;
+  t8_locidx_t         itree, ighost, gparent, num_parents;
+  t8_gloidx_t         global_id, neighbors[T8_ECLASS_MAX_FACES];
+  t8_eclass_t         eclass;
+  int8_t             *ttf;
+  size_t             *attr_offsets, *info_offsets;
+  int                 dim, iclass;
 
   T8_ASSERT (cmesh != NULL);
   T8_ASSERT (cmesh->set_from != NULL);
   T8_ASSERT (cmesh->set_from->committed);
   T8_ASSERT (cmesh->set_from->num_trees_per_eclass[T8_ECLASS_PYRAMID] == 0);
-  T8_ASSERT (cmesh->set_refine_level == 1);     /* levels bigger than 1 are not yet implemented */
-
-  if (cmesh->set_from->set_partition && cmesh->set_from->first_tree_shared) {
-    SC_ABORT ("Refining a partioned cmesh with shared first trees "
-              "is not implemented yet.\n");
-  }
+  T8_ASSERT (cmesh->set_refine_level > 0);
 
   cmesh_from = (t8_cmesh_t) cmesh->set_from;
   dim = cmesh_from->dimension;
-  level = cmesh->set_refine_level;
-  /* The number of new trees per old tree
-   * dim     factor (level = 1)
+  SC_CHECK_ABORTF (dim * cmesh->set_refine_level <= T8_CMESH_REFINE_MAX_LEVEL,
+                   "Cannot refine a cmesh of dimension %i to level %i.\n",
+                   dim, cmesh->set_refine_level);
+  r.cmesh_from = cmesh_from;
+  r.level = cmesh->set_refine_level;
+  /* The number of new trees per old tree and refinement step
+   * dim     num_children
    *  0         1   (points)
    *  1         2   (lines)
    *  2         4   (quads and triangles)
    *  3         8   (Hexes, prisms, Tets)
    */
-  factor = ((t8_linearidx_t) 1) << (dim * level);
-  cmesh->num_local_trees = cmesh_from->num_local_trees * factor;
-  cmesh->num_trees = cmesh_from->num_trees * factor;
+  r.num_children = 1 << dim;
+  r.factor = ((t8_locidx_t) 1) << (dim * r.level);
+  /* If the first tree is shared, the smaller rank keeps all of its children.
+   * Thus, the refined cmesh has no shared trees. */
+  r.num_dropped = cmesh_from->set_partition && cmesh_from->first_tree_shared;
+  num_parents = cmesh_from->num_local_trees - r.num_dropped;
+  SC_CHECK_ABORT ((t8_gloidx_t) num_parents * r.factor <= T8_LOCIDX_MAX,
+                  "Too many local trees in the refined cmesh.\n");
+  r.num_trees = num_parents * r.factor;
+
+  cmesh->set_partition = cmesh_from->set_partition;
+  cmesh->num_local_trees = r.num_trees;
+  cmesh->num_trees = cmesh_from->num_trees * r.factor;
   for (iclass = T8_ECLASS_ZERO; iclass < T8_ECLASS_COUNT; iclass++) {
     /* TODO: This does not work with pyramids */
     cmesh->num_trees_per_eclass[iclass] =
-      cmesh_from->num_trees_per_eclass[iclass] * factor;
+      cmesh_from->num_trees_per_eclass[iclass] * r.factor;
   }
+  cmesh->first_tree = (cmesh_from->first_tree + r.num_dropped) * r.factor;
+  cmesh->first_tree_shared = 0;
 
-  cmesh->first_tree = cmesh_from->first_tree * factor;
+  /* Find the children of the ghost parents that are ghosts */
+  t8_cmesh_refine_count_ghosts (&r);
+  cmesh->num_ghosts = (t8_locidx_t) r.ghost_children.elem_count;
 
-  /* Count the number of new ghosts and temporarily store their local ids */
-  idarray = t8_cmesh_refine_init_idarray (cmesh_from);
-  cmesh->num_ghosts =
-    t8_cmesh_refine_count_ghost (cmesh, cmesh_from, idarray);
-  /* Check for locidx overflow */
-  T8_ASSERT ((t8_gloidx_t) cmesh_from->num_local_trees * factor ==
-             cmesh->num_local_trees);
   /************************/
   /* Create the new trees */
   /************************/
@@ -943,24 +840,56 @@ t8_cmesh_refine (t8_cmesh_t cmesh)
                        cmesh->num_ghosts);
   t8_cmesh_trees_start_part (cmesh->trees, 0, 0, cmesh->num_local_trees, 0,
                              cmesh->num_ghosts, 1);
-  /* Loop over all trees in cmesh_from and set the classes for their children */
-  for (itree = 0, firstnewtree = 0; itree < cmesh_from->num_local_trees;
-       itree++, firstnewtree += factor) {
-    t8_cmesh_refine_inittree (cmesh, cmesh_from, itree, firstnewtree, factor);
+  /* Set the classes of all children. The children of different trees
+   * are independent of each other and can be handled by different threads. */
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (itree = 0; itree < r.num_trees; itree++) {
+    t8_cmesh_refine_inittree (cmesh, &r, itree);
   }
-  for (ighost = 0; ighost < cmesh_from->num_ghosts; ighost++) {
-    t8_cmesh_refine_initghost (cmesh, cmesh_from, idarray, ighost, factor);
+  for (gparent = 0; gparent < r.num_ghost_parents; gparent++) {
+    eclass = t8_cmesh_refine_ghost_parent (&r, gparent, &global_id,
+                                           neighbors, &ttf);
+    for (ighost = r.ghost_offsets[gparent];
+         ighost < r.ghost_offsets[gparent + 1]; ighost++) {
+      /* TODO: For pyramid support we will need to change the eclass here
+       *       to tets for some ghosts */
+      t8_cmesh_trees_add_ghost (cmesh->trees, ighost, global_id * r.factor +
+                                ((t8_locidx_t *) r.ghost_children.array)
+                                [ighost], 0, eclass, r.num_trees);
+    }
   }
   /* Allocate face neihbors and attributes for new trees */
   t8_cmesh_trees_finish_part (cmesh->trees, 0);
-  /* Loop over all trees in cmesh_from and set the new face-neighbors and attributes */
-  for (itree = 0, firstnewtree = 0; itree < cmesh_from->num_local_trees;
-       itree++, firstnewtree += factor) {
-    t8_cmesh_refine_tree (cmesh, cmesh_from, idarray, itree, firstnewtree,
-                          factor);
+
+  /* For each parent count the attribute bytes and attributes of
+   * the children of all previous parents */
+  attr_offsets = T8_ALLOC (size_t, num_parents + 1);
+  info_offsets = T8_ALLOC (size_t, num_parents + 1);
+  attr_offsets[0] = info_offsets[0] = 0;
+  for (itree = 0; itree < num_parents; itree++) {
+    tree = t8_cmesh_trees_get_tree (cmesh_from->trees, itree + r.num_dropped);
+    attr_offsets[itree + 1] = attr_offsets[itree]
+      + r.factor * t8_cmesh_trees_attribute_size (tree);
+    info_offsets[itree + 1] = info_offsets[itree]
+      + r.factor * tree->num_attributes;
   }
-  for (ighost = 0; ighost < cmesh_from->num_ghosts; ighost++) {
-    t8_cmesh_refine_ghost (cmesh, cmesh_from, idarray, ighost, factor);
+  /* Set the new face-neighbors and attributes */
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (itree = 0; itree < r.num_trees; itree++) {
+    t8_cmesh_refine_tree (cmesh, &r, itree, attr_offsets, info_offsets);
+  }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (gparent = 0; gparent < r.num_ghost_parents; gparent++) {
+    t8_cmesh_refine_ghost (cmesh, &r, gparent);
   }
-  t8_cmesh_refine_destroy_idarray (idarray, cmesh_from->num_ghosts);
+  T8_FREE (attr_offsets);
+  T8_FREE (info_offsets);
+  T8_FREE (r.ghost_offsets);
+  sc_array_reset (&r.ghost_children);
 }
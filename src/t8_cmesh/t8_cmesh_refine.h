@@ -61,6 +61,11 @@ T8_EXTERN_C_BEGIN ();
  */
 
 /** Populate a cmesh that is derived via refinement from another cmesh.
+ * All refinement levels are computed at once. The trees are filled
+ * in parallel if OpenMP is enabled.
+ * If cmesh_from is partitioned, so is the refined cmesh. If the first local tree
+ * of cmesh_from is shared, all of its children are left to the smaller
+ * rank, such that the refined cmesh has no shared trees.
  * \param [in,out]  cmesh       The cmesh to be populated. Its set_from entry has
  *                              to be set to a committed cmesh and its set_refine_level
  *                              entry has to be positive.
@@ -33,6 +33,11 @@
 #include <t8_cmesh/t8_cmesh_save.h>
 #include <t8_cmesh/t8_cmesh_partition.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
+#include <t8_profile_regions.h>
+#ifdef T8_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /* This macro is called to check a condition and if not fulfilled
  * close the file and exit the function */
@@ -604,56 +609,468 @@ t8_cmesh_save (t8_cmesh_t cmesh, const char *fileprefix)
   return 1;
 }
 
-#undef T8_SAVE_CHECK_CLOSE
+/* A binary cmesh file consists of
+ *  - the header,
+ *  - one t8_cmesh_binary_part_t entry for each part of the trees structure,
+ *  - the first_tree array of each part, starting at the offset stored
+ *    in its entry,
+ *  - the tree_to_proc and the ghost_to_proc arrays, starting at the offset
+ *    stored in the header.
+ * The first_tree arrays are written byte by byte as they are stored in
+ * memory. Since all offsets inside a part are relative, they can be read
+ * back into a trees structure without any conversion.
+ * Thus we can only read files that were written on a machine with
+ * the same byte order and the same sizes of the tree structs.
+ * All offsets are multiples of T8_CMESH_BINARY_ALIGN, such that the parts
+ * can also be used directly from a memory mapping of the file. */
 
-t8_cmesh_t
-t8_cmesh_load (const char *filename, sc_MPI_Comm comm)
+#define T8_CMESH_BINARY_MAGIC "t8cmeshb"
+#define T8_CMESH_BINARY_ALIGN 16
+
+/* The header of a binary cmesh file */
+typedef struct
+{
+  char                magic[8];
+  int32_t             format;
+  int32_t             byte_order;       /* 1 in the byte order of the writer. */
+  int32_t             type_sizes[5];    /* The sizes of t8_locidx_t, t8_gloidx_t and the
+                                           tree, ghost and attribute info structs. */
+  int32_t             set_partition;
+  int32_t             mpirank;
+  int32_t             mpisize;
+  int32_t             dimension;
+  int32_t             first_tree_shared;
+  int32_t             num_parts;
+  int32_t             padding;
+  int64_t             num_trees;
+  int64_t             num_local_trees;
+  int64_t             num_ghosts;
+  int64_t             first_tree;
+  int64_t             num_local_trees_per_eclass[T8_ECLASS_COUNT];
+  int64_t             num_trees_per_eclass[T8_ECLASS_COUNT];
+  int64_t             proc_offset;      /* The position of the tree_to_proc array in the file. */
+} t8_cmesh_binary_header_t;
+
+/* The description of one part in a binary cmesh file */
+typedef struct
+{
+  int64_t             first_tree_id;
+  int64_t             first_ghost_id;
+  int64_t             num_trees;
+  int64_t             num_ghosts;
+  int64_t             num_bytes;
+  int64_t             offset;   /* The position of the part's data in the file. */
+} t8_cmesh_binary_part_t;
+
+/* Round an offset up to the next multiple of T8_CMESH_BINARY_ALIGN */
+static              int64_t
+t8_cmesh_binary_align (int64_t offset)
+{
+  return (offset + T8_CMESH_BINARY_ALIGN - 1) / T8_CMESH_BINARY_ALIGN
+    * T8_CMESH_BINARY_ALIGN;
+}
+
+/* Fill the type sizes entry of a binary header */
+static void
+t8_cmesh_binary_type_sizes (int32_t type_sizes[5])
+{
+  type_sizes[0] = sizeof (t8_locidx_t);
+  type_sizes[1] = sizeof (t8_gloidx_t);
+  type_sizes[2] = sizeof (t8_ctree_struct_t);
+  type_sizes[3] = sizeof (t8_cghost_struct_t);
+  type_sizes[4] = sizeof (t8_attribute_info_struct_t);
+}
+
+/* Fill the header and the part table of a binary cmesh file.
+ * The part table must have room for one entry for each part. */
+static void
+t8_cmesh_binary_fill_header (t8_cmesh_t cmesh,
+                             t8_cmesh_binary_header_t * header,
+                             t8_cmesh_binary_part_t * parts)
+{
+  t8_part_tree_t      part;
+  int                 ipart, eclass;
+  int64_t             offset;
+
+  /* We zero the header, such that the padding bytes are defined */
+  memset (header, 0, sizeof (*header));
+  memcpy (header->magic, T8_CMESH_BINARY_MAGIC, sizeof (header->magic));
+  header->format = T8_CMESH_BINARY_FORMAT;
+  header->byte_order = 1;
+  t8_cmesh_binary_type_sizes (header->type_sizes);
+  header->set_partition = cmesh->set_partition != 0;
+  header->mpirank = cmesh->mpirank;
+  header->mpisize = cmesh->mpisize;
+  header->dimension = cmesh->dimension;
+  header->first_tree_shared = cmesh->first_tree_shared;
+  header->num_parts = cmesh->trees->from_proc->elem_count;
+  header->num_trees = cmesh->num_trees;
+  header->num_local_trees = cmesh->num_local_trees;
+  header->num_ghosts = cmesh->num_ghosts;
+  header->first_tree = cmesh->first_tree;
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    header->num_local_trees_per_eclass[eclass] =
+      cmesh->num_local_trees_per_eclass[eclass];
+    header->num_trees_per_eclass[eclass] =
+      cmesh->num_trees_per_eclass[eclass];
+  }
+
+  /* The parts follow behind the part table */
+  offset = sizeof (t8_cmesh_binary_header_t)
+    + header->num_parts * sizeof (t8_cmesh_binary_part_t);
+  for (ipart = 0; ipart < header->num_parts; ipart++) {
+    part = t8_cmesh_trees_get_part (cmesh->trees, ipart);
+    parts[ipart].first_tree_id = part->first_tree_id;
+    parts[ipart].first_ghost_id = part->first_ghost_id;
+    parts[ipart].num_trees = part->num_trees;
+    parts[ipart].num_ghosts = part->num_ghosts;
+    parts[ipart].num_bytes =
+      t8_cmesh_trees_get_part_size (cmesh->trees, ipart);
+    parts[ipart].offset = offset = t8_cmesh_binary_align (offset);
+    offset += parts[ipart].num_bytes;
+  }
+  header->proc_offset = t8_cmesh_binary_align (offset);
+}
+
+/* Write zeros to a file until its position is \a offset.
+ * Returns true on success. */
+static int
+t8_cmesh_binary_pad (FILE * fp, int64_t offset)
+{
+  static const char   zeros[T8_CMESH_BINARY_ALIGN] = { 0 };
+  long                position;
+
+  position = ftell (fp);
+  return position >= 0 && position <= offset
+    && (position == offset
+        || fwrite (zeros, offset - position, 1, fp) == 1);
+}
+
+/* Write the header, the parts and the tree_to_proc and ghost_to_proc arrays
+ * of a cmesh to a binary file. If anything goes wrong, the file is closed
+ * and 0 is returned. */
+static int
+t8_cmesh_save_binary_data (t8_cmesh_t cmesh, FILE * fp)
+{
+  t8_cmesh_binary_header_t header;
+  t8_cmesh_binary_part_t *parts;
+  t8_part_tree_t      part;
+  size_t              num_parts, written;
+  int                 ipart, parts_valid;
+
+  num_parts = cmesh->trees->from_proc->elem_count;
+  parts = T8_ALLOC (t8_cmesh_binary_part_t, SC_MAX (num_parts, 1));
+  t8_cmesh_binary_fill_header (cmesh, &header, parts);
+  written = fwrite (&header, sizeof (header), 1, fp);
+  if (num_parts > 0) {
+    written += fwrite (parts, sizeof (t8_cmesh_binary_part_t), num_parts, fp);
+  }
+  parts_valid = written == 1 + num_parts;
+
+  /* Write the data of each part as it is */
+  for (ipart = 0; parts_valid && ipart < (int) num_parts; ipart++) {
+    part = t8_cmesh_trees_get_part (cmesh->trees, ipart);
+    parts_valid = t8_cmesh_binary_pad (fp, parts[ipart].offset)
+      && (parts[ipart].num_bytes == 0
+          || fwrite (part->first_tree, parts[ipart].num_bytes, 1, fp) == 1);
+  }
+  T8_FREE (parts);
+  T8_SAVE_CHECK_CLOSE (parts_valid, fp);
+
+  /* Write for each tree and ghost its part */
+  T8_SAVE_CHECK_CLOSE (t8_cmesh_binary_pad (fp, header.proc_offset), fp);
+  T8_SAVE_CHECK_CLOSE (cmesh->num_local_trees == 0 ||
+                       fwrite (cmesh->trees->tree_to_proc, sizeof (int),
+                               cmesh->num_local_trees, fp)
+                       == (size_t) cmesh->num_local_trees, fp);
+  T8_SAVE_CHECK_CLOSE (cmesh->num_ghosts == 0 ||
+                       fwrite (cmesh->trees->ghost_to_proc, sizeof (int),
+                               cmesh->num_ghosts, fp)
+                       == (size_t) cmesh->num_ghosts, fp);
+  return 1;
+}
+
+int
+t8_cmesh_save_binary (t8_cmesh_t cmesh, const char *fileprefix)
 {
   FILE               *fp;
-  t8_cmesh_t          cmesh;
-  int                 mpiret;
+  char                filename[BUFSIZ];
 
-  /* Open the file in read mode */
-  fp = fopen (filename, "r");
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  if (!cmesh->set_partition && cmesh->mpirank != 0) {
+    /* If the cmesh is replicated, only rank 0 writes it */
+    return 1;
+  }
+
+  /* We use the same file names as t8_cmesh_save, such that the
+   * files can be read with t8_cmesh_load_and_distribute. */
+  snprintf (filename, BUFSIZ, "%s_%04i.cmesh", fileprefix, cmesh->mpirank);
+
+  fp = fopen (filename, "wb");
   if (fp == NULL) {
     /* Could not open file */
     t8_errorf ("Error when opening file %s.\n", filename);
+    return 0;
+  }
+  if (!t8_cmesh_save_binary_data (cmesh, fp)) {
+    t8_errorf ("Error when writing file %s.\n", filename);
+    return 0;
+  }
+  if (fclose (fp)) {
+    t8_errorf ("Error when closing file %s.\n", filename);
+    return 0;
+  }
+  return 1;
+}
+
+/* Check whether a file was written by t8_cmesh_save_binary and
+ * rewind it to its beginning */
+static int
+t8_cmesh_load_is_binary (FILE * fp)
+{
+  char                magic[8];
+  int                 is_binary;
+
+  is_binary = fread (magic, sizeof (magic), 1, fp) == 1
+    && !memcmp (magic, T8_CMESH_BINARY_MAGIC, sizeof (magic));
+  rewind (fp);
+  return is_binary;
+}
+
+/* Map a whole file into memory. The mapping is private, thus changes
+ * to the memory are not written back to the file.
+ * On success the mapping and its size are returned.
+ * If mapping is not possible or not all parts lie inside the file,
+ * NULL is returned. */
+static char        *
+t8_cmesh_load_map_file (FILE * fp, const t8_cmesh_binary_part_t * parts,
+                        int num_parts, size_t *map_size)
+{
+#ifdef T8_HAVE_SYS_MMAN_H
+  struct stat         file_stat;
+  void               *map;
+  int                 ipart;
+
+  if (fstat (fileno (fp), &file_stat) || file_stat.st_size <= 0) {
     return NULL;
   }
-  t8_cmesh_init (&cmesh);
-  /* Read all metadata of the cmesh */
-  if (!t8_cmesh_load_header (cmesh, fp)) {
-    t8_errorf ("Error when opening file %s.\n", filename);
-    t8_cmesh_destroy (&cmesh);
+  for (ipart = 0; ipart < num_parts; ipart++) {
+    if (parts[ipart].offset + parts[ipart].num_bytes >
+        (int64_t) file_stat.st_size) {
+      return NULL;
+    }
+  }
+  map = mmap (NULL, (size_t) file_stat.st_size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE, fileno (fp), 0);
+  if (map == MAP_FAILED) {
     return NULL;
   }
-  /* Read all metadata of the trees */
-  if (!t8_cmesh_load_trees (cmesh, fp)) {
+  *map_size = (size_t) file_stat.st_size;
+  return (char *) map;
+#else
+  return NULL;
+#endif
+}
+
+/* Read a binary cmesh file. The parts' data is read directly into the
+ * trees structure of the cmesh. If use_mmap is true and memory mapping is
+ * available, the parts point directly into a mapping of the file instead.
+ * If anything goes wrong, the file is closed and 0 is returned */
+static int
+t8_cmesh_load_binary (t8_cmesh_t cmesh, FILE * fp, int use_mmap)
+{
+  t8_cmesh_binary_header_t header;
+  t8_cmesh_binary_part_t *parts;
+  t8_part_tree_t      part;
+  int32_t             type_sizes[5];
+  int64_t             sum_trees, sum_ghosts;
+  int                 ipart, ieclass;
+  int                 parts_valid;
+  char               *map = NULL;
+  size_t              map_size = 0;
+
+  T8_SAVE_CHECK_CLOSE (fread (&header, sizeof (header), 1, fp) == 1, fp);
+  T8_SAVE_CHECK_CLOSE (!memcmp (header.magic, T8_CMESH_BINARY_MAGIC,
+                                sizeof (header.magic)), fp);
+  if (header.format != T8_CMESH_BINARY_FORMAT) {
+    /* The file was saved with an old format and we cannot read it any more */
+    t8_errorf
+      ("Input file is in an old format that we cannot read anymore.\n");
+    fclose (fp);
+    return 0;
+  }
+  if (header.byte_order != 1) {
+    t8_errorf ("Input file was written with a different byte order.\n");
+    fclose (fp);
+    return 0;
+  }
+  t8_cmesh_binary_type_sizes (type_sizes);
+  if (memcmp (type_sizes, header.type_sizes, sizeof (type_sizes))) {
+    t8_errorf ("Input file was written with different sizes of the "
+               "tree data types.\n");
+    fclose (fp);
+    return 0;
+  }
+  /* Check if the rank and mpisize stored were valid */
+  T8_SAVE_CHECK_CLOSE (0 <= header.mpirank
+                       && header.mpirank < header.mpisize, fp);
+  T8_SAVE_CHECK_CLOSE (header.dimension >= 0 && header.dimension <= 3, fp);
+  T8_SAVE_CHECK_CLOSE (0 <= header.num_local_trees
+                       && header.num_local_trees <= header.num_trees, fp);
+  T8_SAVE_CHECK_CLOSE (0 <= header.num_ghosts
+                       && header.num_ghosts <= header.num_trees, fp);
+  T8_SAVE_CHECK_CLOSE (header.num_local_trees == 0
+                       || (0 <= header.first_tree
+                           && header.first_tree < header.num_trees), fp);
+  T8_SAVE_CHECK_CLOSE (header.num_parts >= 0 && header.proc_offset >= 0, fp);
+
+  cmesh->set_partition = header.set_partition;
+  cmesh->dimension = header.dimension;
+  cmesh->first_tree_shared = header.first_tree_shared;
+  cmesh->num_trees = header.num_trees;
+  cmesh->num_local_trees = header.num_local_trees;
+  cmesh->num_ghosts = header.num_ghosts;
+  cmesh->first_tree = header.first_tree;
+  for (ieclass = T8_ECLASS_ZERO; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    cmesh->num_local_trees_per_eclass[ieclass] =
+      header.num_local_trees_per_eclass[ieclass];
+    cmesh->num_trees_per_eclass[ieclass] =
+      header.num_trees_per_eclass[ieclass];
+  }
+
+  /* Read and check the part table */
+  parts = T8_ALLOC (t8_cmesh_binary_part_t, SC_MAX (header.num_parts, 1));
+  parts_valid = header.num_parts == 0 ||
+    fread (parts, sizeof (t8_cmesh_binary_part_t), header.num_parts, fp)
+    == (size_t) header.num_parts;
+  sum_trees = sum_ghosts = 0;
+  for (ipart = 0; parts_valid && ipart < header.num_parts; ipart++) {
+    parts_valid = parts[ipart].num_trees >= 0
+      && parts[ipart].num_ghosts >= 0 && parts[ipart].num_bytes >= 0
+      && parts[ipart].offset >= 0
+      && parts[ipart].offset % T8_CMESH_BINARY_ALIGN == 0;
+    sum_trees += parts[ipart].num_trees;
+    sum_ghosts += parts[ipart].num_ghosts;
+  }
+  parts_valid = parts_valid && sum_trees == cmesh->num_local_trees
+    && sum_ghosts == cmesh->num_ghosts;
+  if (parts_valid && use_mmap) {
+    /* If the file cannot be mapped, we read it */
+    map = t8_cmesh_load_map_file (fp, parts, header.num_parts, &map_size);
+  }
+  if (!parts_valid) {
+    T8_FREE (parts);
+  }
+  T8_SAVE_CHECK_CLOSE (parts_valid, fp);
+
+  /* Read the data of each part directly into the trees structure */
+  t8_cmesh_trees_init (&cmesh->trees, header.num_parts,
+                       cmesh->num_local_trees, cmesh->num_ghosts);
+  for (ipart = 0; ipart < header.num_parts; ipart++) {
+    t8_cmesh_trees_start_part (cmesh->trees, ipart,
+                               parts[ipart].first_tree_id,
+                               parts[ipart].num_trees,
+                               parts[ipart].first_ghost_id,
+                               parts[ipart].num_ghosts, 0);
+  }
+  if (map != NULL) {
+    /* The trees structure takes ownership of the mapping and the parts
+     * point inside of it */
+    t8_cmesh_trees_set_mapping (cmesh->trees, map, map_size);
+  }
+  for (ipart = 0; parts_valid && ipart < header.num_parts; ipart++) {
+    part = t8_cmesh_trees_get_part (cmesh->trees, ipart);
+    if (parts[ipart].num_bytes > 0) {
+      if (map != NULL) {
+        part->first_tree = map + parts[ipart].offset;
+      }
+      else {
+        part->first_tree = T8_ALLOC (char, parts[ipart].num_bytes);
+        parts_valid = !fseek (fp, (long) parts[ipart].offset, SEEK_SET)
+          && fread (part->first_tree, parts[ipart].num_bytes, 1, fp) == 1;
+      }
+    }
+  }
+  T8_FREE (parts);
+  T8_SAVE_CHECK_CLOSE (parts_valid, fp);
+
+  /* Read for each tree and ghost its part */
+  T8_SAVE_CHECK_CLOSE (!fseek (fp, (long) header.proc_offset, SEEK_SET), fp);
+  T8_SAVE_CHECK_CLOSE (cmesh->num_local_trees == 0 ||
+                       fread (cmesh->trees->tree_to_proc, sizeof (int),
+                              cmesh->num_local_trees, fp)
+                       == (size_t) cmesh->num_local_trees, fp);
+  T8_SAVE_CHECK_CLOSE (cmesh->num_ghosts == 0 ||
+                       fread (cmesh->trees->ghost_to_proc, sizeof (int),
+                              cmesh->num_ghosts, fp)
+                       == (size_t) cmesh->num_ghosts, fp);
+  t8_cmesh_trees_build_ghost_hash (cmesh->trees, cmesh->num_local_trees,
+                                   cmesh->num_ghosts);
+  return 1;
+}
+
+#undef T8_SAVE_CHECK_CLOSE
+
+/* Load a cmesh from a file written by t8_cmesh_save or t8_cmesh_save_binary.
+ * If use_mmap is true, the trees of a binary file are memory mapped */
+static              t8_cmesh_t
+t8_cmesh_load_ext (const char *filename, sc_MPI_Comm comm, int use_mmap)
+{
+  FILE               *fp;
+  t8_cmesh_t          cmesh;
+  int                 mpiret;
+
+  /* Open the file in read mode */
+  fp = fopen (filename, "rb");
+  if (fp == NULL) {
+    /* Could not open file */
     t8_errorf ("Error when opening file %s.\n", filename);
-    t8_cmesh_destroy (&cmesh);
     return NULL;
   }
-  if (cmesh->set_partition) {
-    /* Write all ghost metadata */
-    if (!t8_cmesh_load_ghosts (cmesh, fp)) {
+  t8_cmesh_init (&cmesh);
+  if (t8_cmesh_load_is_binary (fp)) {
+    /* The file was written with t8_cmesh_save_binary */
+    if (!t8_cmesh_load_binary (cmesh, fp, use_mmap)) {
       t8_errorf ("Error when opening file %s.\n", filename);
       t8_cmesh_destroy (&cmesh);
       return NULL;
     }
   }
-  t8_cmesh_trees_finish_part (cmesh->trees, 0);
-  if (!t8_cmesh_load_tree_attributes (cmesh, fp)) {
-    t8_errorf ("Error when opening file %s.\n", filename);
-    t8_cmesh_destroy (&cmesh);
-    return NULL;
-  }
-  if (cmesh->set_partition) {
-    /* Write all ghost metadata */
-    if (!t8_cmesh_load_ghost_attributes (cmesh, fp)) {
+  else {
+    /* Read all metadata of the cmesh */
+    if (!t8_cmesh_load_header (cmesh, fp)) {
+      t8_errorf ("Error when opening file %s.\n", filename);
+      t8_cmesh_destroy (&cmesh);
+      return NULL;
+    }
+    /* Read all metadata of the trees */
+    if (!t8_cmesh_load_trees (cmesh, fp)) {
       t8_errorf ("Error when opening file %s.\n", filename);
       t8_cmesh_destroy (&cmesh);
       return NULL;
     }
+    if (cmesh->set_partition) {
+      /* Write all ghost metadata */
+      if (!t8_cmesh_load_ghosts (cmesh, fp)) {
+        t8_errorf ("Error when opening file %s.\n", filename);
+        t8_cmesh_destroy (&cmesh);
+        return NULL;
+      }
+    }
+    t8_cmesh_trees_finish_part (cmesh->trees, 0);
+    if (!t8_cmesh_load_tree_attributes (cmesh, fp)) {
+      t8_errorf ("Error when opening file %s.\n", filename);
+      t8_cmesh_destroy (&cmesh);
+      return NULL;
+    }
+    if (cmesh->set_partition) {
+      /* Write all ghost metadata */
+      if (!t8_cmesh_load_ghost_attributes (cmesh, fp)) {
+        t8_errorf ("Error when opening file %s.\n", filename);
+        t8_cmesh_destroy (&cmesh);
+        return NULL;
+      }
+    }
   }
   /* Close the file */
   fclose (fp);
@@ -667,6 +1084,28 @@ t8_cmesh_load (const char *filename, sc_MPI_Comm comm)
   return cmesh;
 }
 
+t8_cmesh_t
+t8_cmesh_load (const char *filename, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+
+  t8_profile_region_begin ("cmesh_load");
+  cmesh = t8_cmesh_load_ext (filename, comm, 0);
+  t8_profile_region_end ("cmesh_load");
+  return cmesh;
+}
+
+t8_cmesh_t
+t8_cmesh_load_mapped (const char *filename, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+
+  t8_profile_region_begin ("cmesh_load");
+  cmesh = t8_cmesh_load_ext (filename, comm, 1);
+  t8_profile_region_end ("cmesh_load");
+  return cmesh;
+}
+
 /* Query whether a given process will open a cmesh saved file.
  * This depends on the number of processes, the number of files and
  * the load mode.
@@ -36,6 +36,10 @@
  *  We can only read files that were written in the same format. */
 #define T8_CMESH_FORMAT 0x0002
 
+/** Increment this constant each time the binary file format changes.
+ *  \see t8_cmesh_save_binary */
+#define T8_CMESH_BINARY_FORMAT 0x0002
+
 /** This enumeration contains all modes in which we can open a saved cmesh.
  * The cmesh can be loaded with more processes than it was saved and the
  * mode controls, which of the processes open files and distribute the data.
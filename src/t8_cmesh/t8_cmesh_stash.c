@@ -38,6 +38,8 @@ t8_stash_init (t8_stash_t * pstash)
   sc_array_init (&stash->attributes, sizeof (t8_stash_attribute_struct_t));
   sc_array_init (&stash->classes, sizeof (t8_stash_class_struct_t));
   sc_array_init (&stash->joinfaces, sizeof (t8_stash_joinface_struct_t));
+  sc_array_init (&stash->attribute_blocks, sizeof (void *));
+  stash->attribute_block_bytes = 0;
 }
 
 void
@@ -61,8 +63,14 @@ t8_stash_destroy (t8_stash_t * pstash)
     }
   }
   sc_array_reset (&stash->attributes);
+  for (attr_count = 0; attr_count < stash->attribute_blocks.elem_count;
+       attr_count++) {
+    T8_FREE (*(void **) sc_array_index (&stash->attribute_blocks,
+                                        attr_count));
+  }
+  sc_array_reset (&stash->attribute_blocks);
   T8_FREE (stash);
-  pstash = NULL;
+  *pstash = NULL;
 }
 
 void
@@ -175,6 +183,43 @@ t8_stash_add_attribute (t8_stash_t stash, t8_gloidx_t id, int package_id,
   }
 }
 
+void
+t8_stash_add_attribute_array (t8_stash_t stash, t8_gloidx_t first_id,
+                              t8_gloidx_t num_trees, int package_id, int key,
+                              size_t size, void *attr, int copy)
+{
+  t8_stash_attribute_struct_t *sattr;
+  char               *data;
+  t8_gloidx_t         itree;
+
+  T8_ASSERT (stash != NULL);
+  T8_ASSERT (first_id >= 0 && num_trees >= 0);
+  T8_ASSERT (attr != NULL || size == 0 || num_trees == 0);
+
+  if (num_trees == 0) {
+    return;
+  }
+  data = (char *) attr;
+  if (copy) {
+    /* One block for all trees, the stash frees it on destroy */
+    data = T8_ALLOC (char, num_trees * size);
+    memcpy (data, attr, num_trees * size);
+    *(void **) sc_array_push (&stash->attribute_blocks) = data;
+    stash->attribute_block_bytes += num_trees * size;
+  }
+  sattr = (t8_stash_attribute_struct_t *)
+    sc_array_push_count (&stash->attributes, (size_t) num_trees);
+  for (itree = 0; itree < num_trees; itree++, sattr++) {
+    sattr->attr_size = size;
+    sattr->id = first_id + itree;
+    /* The entries point into the block and are not freed by themselves */
+    sattr->is_owned = 0;
+    sattr->key = key;
+    sattr->package_id = package_id;
+    sattr->attr_data = data + itree * size;
+  }
+}
+
 size_t
 t8_stash_get_attribute_size (t8_stash_t stash, size_t index)
 {
@@ -238,100 +283,191 @@ t8_stash_attribute_compare (const void *v1, const void *v2)
 
 /* Sort the attribute entries in the order
  * (treeid, packageid, key)
+ * Attributes are usually set tree by tree, so we first check whether the
+ * array is already sorted. Otherwise, if the tree ids lie in a small range,
+ * we use a stable counting sort by tree id followed by an insertion sort
+ * that only needs to reorder the attributes of each single tree.
+ * For widely spread tree ids we fall back to qsort.
  */
 void
 t8_stash_attribute_sort (t8_stash_t stash)
 {
-  sc_array_sort (&stash->attributes, t8_stash_attribute_compare);
-}
-
-static void
-t8_stash_bcast_attributes (sc_array_t * attributes, int root,
-                           sc_MPI_Comm comm)
-{
-  size_t              num_atts, iatt, att_size, copied_bytes;
-  t8_stash_attribute_struct_t *att;
-  char               *buffer;
-  int                 mpirank, mpisize, mpiret;
-  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
-  SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_size (comm, &mpisize);
-  SC_CHECK_MPI (mpiret);
-
-  T8_ASSERT (attributes != NULL);
+  sc_array_t         *attributes = &stash->attributes;
+  t8_stash_attribute_struct_t *atts, *sorted, temp;
+  size_t              num_atts, iatt, jatt, num_ids, *offsets;
+  t8_gloidx_t         min_id, max_id;
+  int                 is_sorted = 1;
 
   num_atts = attributes->elem_count;
+  if (num_atts <= 1) {
+    return;
+  }
+  atts = (t8_stash_attribute_struct_t *) attributes->array;
+  min_id = max_id = atts[0].id;
+  for (iatt = 1; iatt < num_atts; iatt++) {
+    min_id = SC_MIN (min_id, atts[iatt].id);
+    max_id = SC_MAX (max_id, atts[iatt].id);
+    if (is_sorted
+        && t8_stash_attribute_compare (atts + iatt - 1, atts + iatt) > 0) {
+      is_sorted = 0;
+    }
+  }
+  if (is_sorted) {
+    return;
+  }
+  if ((t8_gloidx_t) (max_id - min_id) > (t8_gloidx_t) (2 * num_atts + 1024)) {
+    sc_array_sort (attributes, t8_stash_attribute_compare);
+    return;
+  }
 
-  /* Count the number of byte of all attributes */
-  att_size = 0;
+  /* Counting sort by tree id */
+  num_ids = (size_t) (max_id - min_id) + 1;
+  offsets = T8_ALLOC_ZERO (size_t, num_ids + 1);
   for (iatt = 0; iatt < num_atts; iatt++) {
-    att = (t8_stash_attribute_struct_t *) sc_array_index (attributes, iatt);
-    att_size += att->attr_size;
+    offsets[atts[iatt].id - min_id + 1]++;
   }
-  /* Allocat buffer */
-  buffer = T8_ALLOC_ZERO (char, att_size);
-  /* Copy all attributes to send buffer */
-  if (mpirank == root) {
-    copied_bytes = 0;
-    for (iatt = 0; iatt < num_atts; iatt++) {
-      att = (t8_stash_attribute_struct_t *) sc_array_index (attributes, iatt);
-      memcpy (buffer + copied_bytes, att->attr_data, att->attr_size);
-      copied_bytes += att->attr_size;
+  for (iatt = 1; iatt <= num_ids; iatt++) {
+    offsets[iatt] += offsets[iatt - 1];
+  }
+  sorted = T8_ALLOC (t8_stash_attribute_struct_t, num_atts);
+  for (iatt = 0; iatt < num_atts; iatt++) {
+    sorted[offsets[atts[iatt].id - min_id]++] = atts[iatt];
+  }
+  T8_FREE (offsets);
+
+  /* Insertion sort by (packageid, key), entries only move within a tree */
+  for (iatt = 1; iatt < num_atts; iatt++) {
+    temp = sorted[iatt];
+    for (jatt = iatt; jatt > 0
+         && t8_stash_attribute_compare (sorted + jatt - 1, &temp) > 0;
+         jatt--) {
+      sorted[jatt] = sorted[jatt - 1];
     }
+    sorted[jatt] = temp;
   }
-  /* broadcast buffer */
-  sc_MPI_Bcast (buffer, att_size, sc_MPI_BYTE, root, comm);
-  /* Copy attributes from buffer back to stash */
-  if (mpirank != root) {
-    copied_bytes = 0;
-    for (iatt = 0; iatt < num_atts; iatt++) {
-      att = (t8_stash_attribute_struct_t *) sc_array_index (attributes, iatt);
-      att->attr_data = T8_ALLOC (char, att->attr_size);
-      memcpy (att->attr_data, buffer + copied_bytes, att->attr_size);
-      copied_bytes += att->attr_size;
+  memcpy (atts, sorted, num_atts * sizeof (t8_stash_attribute_struct_t));
+  T8_FREE (sorted);
+}
+
+/* The attribute data is packed with each attribute padded to a multiple
+ * of 8 bytes, such that the attributes stay aligned on the receivers. */
+static              size_t
+t8_stash_padded_size (size_t size)
+{
+  return (size + 7) & ~(size_t) 7;
+}
+
+/* The maximum number of bytes sent in one broadcast call */
+#define T8_STASH_BCAST_CHUNK ((size_t) 1 << 28)
+
+size_t
+t8_stash_get_attribute_bytes (t8_stash_t stash)
+{
+  size_t              iatt, num_bytes = 0;
+
+  T8_ASSERT (stash != NULL);
+  for (iatt = 0; iatt < stash->attributes.elem_count; iatt++) {
+    num_bytes += t8_stash_padded_size (t8_stash_get_attribute_size (stash,
+                                                                    iatt));
+  }
+  return num_bytes;
+}
+
+size_t
+t8_stash_memory_used (t8_stash_t stash)
+{
+  t8_stash_attribute_struct_t *attr;
+  size_t              iatt, num_bytes;
+
+  T8_ASSERT (stash != NULL);
+  num_bytes = sizeof (t8_stash_struct_t)
+    + sc_array_memory_used (&stash->classes, 0)
+    + sc_array_memory_used (&stash->joinfaces, 0)
+    + sc_array_memory_used (&stash->attributes, 0)
+    + sc_array_memory_used (&stash->attribute_blocks, 0)
+    + stash->attribute_block_bytes;
+  /* Attributes that were copied one by one own their data */
+  for (iatt = 0; iatt < stash->attributes.elem_count; iatt++) {
+    attr = (t8_stash_attribute_struct_t *)
+      sc_array_index (&stash->attributes, iatt);
+    if (attr->is_owned) {
+      num_bytes += attr->attr_size;
     }
   }
-  T8_FREE (buffer);
+  return num_bytes;
 }
 
 /* bcast the data of stash on root to all procs.
+ * All entries are packed into one buffer that is broadcasted in chunks.
  * On the other procs stash_init has to be called before */
 t8_stash_t
 t8_stash_bcast (t8_stash_t stash, int root, sc_MPI_Comm comm,
-                size_t elem_counts[3])
+                size_t elem_counts[4])
 {
-  int                 mpirank, mpisize, mpiret;
+  int                 mpirank, mpiret;
+  size_t              bytes[3], num_bytes, offset, chunk, iatt, iarray;
+  sc_array_t         *arrays[3];
+  t8_stash_attribute_struct_t *att;
+  char               *buffer;
+
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
-  mpiret = sc_MPI_Comm_size (comm, &mpisize);
-  SC_CHECK_MPI (mpiret);
 
-  if (mpirank != root) {
-    sc_array_resize (&stash->attributes, elem_counts[0]);
-    sc_array_resize (&stash->classes, elem_counts[1]);
-    sc_array_resize (&stash->joinfaces, elem_counts[2]);
+  arrays[0] = &stash->attributes;
+  arrays[1] = &stash->classes;
+  arrays[2] = &stash->joinfaces;
+  bytes[0] = elem_counts[0] * sizeof (t8_stash_attribute_struct_t);
+  bytes[1] = elem_counts[1] * sizeof (t8_stash_class_struct_t);
+  bytes[2] = elem_counts[2] * sizeof (t8_stash_joinface_struct_t);
+  num_bytes = bytes[0] + bytes[1] + bytes[2] + elem_counts[3];
+  if (num_bytes == 0) {
+    return stash;
   }
-  if (elem_counts[0] > 0) {
-    mpiret = sc_MPI_Bcast (stash->attributes.array,
-                           elem_counts[0] *
-                           sizeof (t8_stash_attribute_struct_t), sc_MPI_BYTE,
-                           0, comm);
-    SC_CHECK_MPI (mpiret);
-    t8_stash_bcast_attributes (&stash->attributes, root, comm);
+
+  /* The buffer is laid out as: attribute entries, classes, joinfaces,
+   * attribute data. */
+  buffer = T8_ALLOC (char, num_bytes);
+  if (mpirank == root) {
+    T8_ASSERT (elem_counts[3] == t8_stash_get_attribute_bytes (stash));
+    for (iarray = 0, offset = 0; iarray < 3; iarray++) {
+      T8_ASSERT (arrays[iarray]->elem_count == elem_counts[iarray]);
+      memcpy (buffer + offset, arrays[iarray]->array, bytes[iarray]);
+      offset += bytes[iarray];
+    }
+    for (iatt = 0; iatt < elem_counts[0]; iatt++) {
+      att = (t8_stash_attribute_struct_t *)
+        sc_array_index (&stash->attributes, iatt);
+      memcpy (buffer + offset, att->attr_data, att->attr_size);
+      offset += t8_stash_padded_size (att->attr_size);
+    }
   }
-  if (elem_counts[1] > 0) {
-    mpiret = sc_MPI_Bcast (stash->classes.array,
-                           elem_counts[1] * sizeof (t8_stash_class_struct_t),
-                           sc_MPI_BYTE, 0, comm);
+  for (offset = 0; offset < num_bytes; offset += chunk) {
+    chunk = SC_MIN (num_bytes - offset, T8_STASH_BCAST_CHUNK);
+    mpiret = sc_MPI_Bcast (buffer + offset, (int) chunk, sc_MPI_BYTE, root,
+                           comm);
     SC_CHECK_MPI (mpiret);
   }
-  if (elem_counts[2] > 0) {
-    mpiret = sc_MPI_Bcast (stash->joinfaces.array,
-                           elem_counts[2] *
-                           sizeof (t8_stash_joinface_struct_t), sc_MPI_BYTE,
-                           0, comm);
-    SC_CHECK_MPI (mpiret);
+  if (mpirank == root) {
+    T8_FREE (buffer);
+    return stash;
+  }
+
+  /* Unpack the arrays. The attribute entries point into the buffer,
+   * and the stash keeps it until it is destroyed. */
+  for (iarray = 0, offset = 0; iarray < 3; iarray++) {
+    sc_array_resize (arrays[iarray], elem_counts[iarray]);
+    memcpy (arrays[iarray]->array, buffer + offset, bytes[iarray]);
+    offset += bytes[iarray];
+  }
+  for (iatt = 0; iatt < elem_counts[0]; iatt++) {
+    att = (t8_stash_attribute_struct_t *)
+      sc_array_index (&stash->attributes, iatt);
+    att->attr_data = buffer + offset;
+    att->is_owned = 0;
+    offset += t8_stash_padded_size (att->attr_size);
   }
+  *(void **) sc_array_push (&stash->attribute_blocks) = buffer;
+  stash->attribute_block_bytes += num_bytes;
   return stash;
 }
 
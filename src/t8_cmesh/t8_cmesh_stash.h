@@ -82,6 +82,9 @@ typedef struct t8_stash
   sc_array_t          classes; /**< Stores the eclasses of the trees. \see t8_stash_class */
   sc_array_t          joinfaces; /**< Stores the face-connections. \see t8_stash_joinface */
   sc_array_t          attributes; /**< Stores the attributes. \see t8_stash_attribute */
+  sc_array_t          attribute_blocks; /**< Stores pointers to the memory blocks
+                                             allocated by \ref t8_stash_add_attribute_array. */
+  size_t              attribute_block_bytes; /**< The total size of the blocks in \a attribute_blocks. */
 } t8_stash_struct_t;
 
 T8_EXTERN_C_BEGIN ();
@@ -155,6 +158,29 @@ void                t8_stash_add_attribute (t8_stash_t stash, t8_gloidx_t id,
                                             size_t size, void *attr,
                                             int copy);
 
+/** Add an attribute of the same size to each tree in a range of trees.
+ * The attributes are given in one contiguous array, such that the attribute
+ * of tree \a first_id + i starts at byte i * \a size of \a attr.
+ * If the data is copied, this is done with one allocation and one memcpy
+ * for all trees.
+ * \param [in] stash    The stash structure to be modified.
+ * \param [in] first_id The global index of the first tree in the range.
+ * \param [in] num_trees The number of trees in the range.
+ * \param [in] package_id The unique id of the current package.
+ * \param [in] key      An integer value used to identify this attribute.
+ * \param [in] size     The size (in bytes) of the attribute of one tree.
+ * \param [in] attr     Points to \a num_trees * \a size bytes of memory.
+ * \param [in] copy     If true the attribute data is copied from \a attr to an internal storage.
+ *                      If false only the pointer \a attr is stored and the data is only copied
+ *                      if the cmesh is committed.
+ */
+void                t8_stash_add_attribute_array (t8_stash_t stash,
+                                                  t8_gloidx_t first_id,
+                                                  t8_gloidx_t num_trees,
+                                                  int package_id, int key,
+                                                  size_t size, void *attr,
+                                                  int copy);
+
 /** Return the size (in bytes) of an attribute in the stash.
  * \param [in]   stash   The stash to be considered.
  * \param [in]   index   The index of the attribute in the attribute array of \a stash.
@@ -205,21 +231,43 @@ int                 t8_stash_attribute_is_owned (t8_stash_t stash,
                                                  size_t index);
 
 /** Sort the attributes array of a stash in the order
- * (treeid, packageid, key) *
+ * (treeid, packageid, key).
+ * This is linear in the number of attributes if the array is already
+ * sorted or the tree ids lie in a range not much larger than the number
+ * of attributes.
  * \param [in,out]   stash   The stash to be considered.
  */
 void                t8_stash_attribute_sort (t8_stash_t stash);
 
+/** Return the number of bytes that the attribute data of a stash occupies
+ * when it is broadcasted with \ref t8_stash_bcast.
+ * \param [in]   stash   The stash to be considered.
+ * \return               The number of bytes of all attributes, each padded to
+ *                       a multiple of 8.
+ */
+size_t              t8_stash_get_attribute_bytes (t8_stash_t stash);
+
+/** Return the number of bytes that a stash allocates, including the
+ * attribute data that it owns.
+ * \param [in]   stash   The stash to be considered.
+ * \return               The allocated bytes of \a stash.
+ */
+size_t              t8_stash_memory_used (t8_stash_t stash);
+
 /** Broadcast a stash on the root process to all processes in a communicator.
  *  The number of entries in the classes, joinfaces and attributes arrays must
  *  be known on the receiving processes before calling this function.
+ *  All entries and the attribute data are packed into one buffer, which is
+ *  broadcasted in chunks of at most 256 MiB.
  *  \param [in,out] stash   On root the stash that is to be broadcasted.
  *                          On the other process an initialized stash. Its entries will
  *                          get overwritten by the entries in the root stash.
  *  \param [in]     root    The mpirank of the root process.
  *  \param [in]     comm    The mpi communicator which is used fpr broadcast.
- *  \param [in]     elem_counts An array with three entries giving the number of
- *                  elements in the classes, joinfaces and attributes arrays.
+ *  \param [in]     elem_counts An array with four entries giving the number of
+ *                  elements in the attributes, classes and joinfaces arrays
+ *                  and the number of bytes of the attribute data as returned by
+ *                  \ref t8_stash_get_attribute_bytes on root.
  */
 t8_stash_t          t8_stash_bcast (t8_stash_t stash, int root,
                                     sc_MPI_Comm comm, size_t elem_counts[]);
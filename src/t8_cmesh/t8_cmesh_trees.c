@@ -27,6 +27,9 @@
 
 #include "t8_cmesh_stash.h"
 #include "t8_cmesh_trees.h"
+#ifdef T8_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 /* This struct is needed as a key to search
  * for an argument in the arguments array of a tree */
@@ -36,25 +39,16 @@ struct t8_key_id_pair
   int                 package_id;
 };
 
-/* The hash function for the global to local hash table.
- * We hash the globa_id */
-static unsigned
-t8_cmesh_trees_glo_lo_hash_func (const void *v, const void *u)
-{
-  const t8_trees_glo_lo_hash_t *entry = (const t8_trees_glo_lo_hash_t *) v;
-  return (unsigned) entry->global_id;
-}
-
-/* The equality function for the global to local hash table.
- * We consider two entries equal, if their global id's match. */
+/* The compare function for the global to local map.
+ * We compare the global ids. */
 static int
-t8_cmesh_trees_glo_lo_hash_equal (const void *v1, const void *v2,
-                                  const void *u)
+t8_cmesh_trees_glo_lo_compare (const void *v1, const void *v2)
 {
   const t8_trees_glo_lo_hash_t *entry1 = (const t8_trees_glo_lo_hash_t *) v1;
   const t8_trees_glo_lo_hash_t *entry2 = (const t8_trees_glo_lo_hash_t *) v2;
 
-  return entry1->global_id == entry2->global_id;
+  return entry1->global_id < entry2->global_id ? -1 :
+    entry1->global_id != entry2->global_id;
 }
 
 t8_part_tree_t
@@ -81,13 +75,17 @@ t8_cmesh_trees_init (t8_cmesh_trees_t * ptrees, int num_procs,
   trees->tree_to_proc = T8_ALLOC_ZERO (int, num_trees);
   trees->ghost_to_proc = num_ghosts > 0 ? T8_ALLOC_ZERO (int, num_ghosts)
   :                   NULL;
-  /* Initialize the global_id mempool */
-  trees->global_local_mempool =
-    sc_mempool_new (sizeof (t8_trees_glo_lo_hash_t));
-  /* Initialize the global_id hash table */
-  trees->ghost_globalid_to_local_id =
-    sc_hash_new (t8_cmesh_trees_glo_lo_hash_func,
-                 t8_cmesh_trees_glo_lo_hash_equal, NULL, NULL);
+  /* Initialize the global_id to local_id map */
+  sc_array_init (&trees->ghost_globalid_to_local_id,
+                 sizeof (t8_trees_glo_lo_hash_t));
+  trees->ghost_map_sorted = 1;
+  trees->mapping = NULL;
+  trees->mapping_size = 0;
+  trees->shared = NULL;
+  trees->shared_comm = sc_MPI_COMM_NULL;
+  trees->face_neighbors = NULL;
+  trees->face_ttf = NULL;
+  trees->face_stride = 0;
 
 }
 
@@ -120,10 +118,6 @@ t8_cmesh_trees_add_ghost (t8_cmesh_trees_t trees, t8_locidx_t lghost_index,
 {
   t8_part_tree_t      part;
   t8_cghost_t         ghost;
-  t8_trees_glo_lo_hash_t *hash_entry;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
 
   T8_ASSERT (trees != NULL);
   T8_ASSERT (proc >= 0);
@@ -143,21 +137,53 @@ t8_cmesh_trees_add_ghost (t8_cmesh_trees_t trees, t8_locidx_t lghost_index,
   ghost->treeid = gtree_id;
   ghost->neigh_offset = 0;
   trees->ghost_to_proc[lghost_index] = proc;
-  /* Insert this ghosts global id into the hash table */
-  /* build the entry */
-  hash_entry = (t8_trees_glo_lo_hash_t *)
-    sc_mempool_alloc (trees->global_local_mempool);
-  hash_entry->global_id = gtree_id;
-  hash_entry->local_id =
-    lghost_index + part->first_ghost_id + num_local_trees;
-  /* insert it */
+  /* Insert this ghosts global id into the map */
+  t8_cmesh_trees_insert_ghost_map (trees, gtree_id, lghost_index
+                                   + part->first_ghost_id + num_local_trees);
+}
+
+void
+t8_cmesh_trees_insert_ghost_map (t8_cmesh_trees_t trees,
+                                 t8_gloidx_t global_id, t8_locidx_t local_id)
+{
+  t8_trees_glo_lo_hash_t *entry;
+  size_t              count;
+
+  T8_ASSERT (trees != NULL);
+  count = trees->ghost_globalid_to_local_id.elem_count;
+  entry = (t8_trees_glo_lo_hash_t *)
+    sc_array_push (&trees->ghost_globalid_to_local_id);
+  entry->global_id = global_id;
+  entry->local_id = local_id;
+  /* Ghosts are mostly inserted in the order of their global ids,
+   * then the map stays sorted */
+  if (count > 0 && entry[-1].global_id >= global_id) {
+    trees->ghost_map_sorted = 0;
+  }
+}
+
+void
+t8_cmesh_trees_sort_ghost_map (t8_cmesh_trees_t trees)
+{
+  T8_ASSERT (trees != NULL);
+  if (!trees->ghost_map_sorted) {
+    sc_array_sort (&trees->ghost_globalid_to_local_id,
+                   t8_cmesh_trees_glo_lo_compare);
+    trees->ghost_map_sorted = 1;
+  }
 #ifdef T8_ENABLE_DEBUG
-  ret =
+  {
+    const t8_trees_glo_lo_hash_t *entries = (const t8_trees_glo_lo_hash_t *)
+      trees->ghost_globalid_to_local_id.array;
+    size_t              ientry;
+
+    /* Each ghost must be inserted only once */
+    for (ientry = 1; ientry < trees->ghost_globalid_to_local_id.elem_count;
+         ientry++) {
+      T8_ASSERT (entries[ientry - 1].global_id < entries[ientry].global_id);
+    }
+  }
 #endif
-    sc_hash_insert_unique (trees->ghost_globalid_to_local_id, hash_entry,
-                           NULL);
-  /* It mus not have existed before, thus true was returned */
-  T8_ASSERT (ret);
 }
 
 #ifdef T8_ENABLE_DEBUG
@@ -470,6 +496,87 @@ t8_cmesh_trees_copy_part (t8_cmesh_trees_t trees_dest, int part_dest,
   memcpy (partD->first_tree, partS->first_tree, byte_count);
 }
 
+size_t
+t8_cmesh_trees_get_part_size (t8_cmesh_trees_t trees, int proc)
+{
+  return t8_cmesh_trees_get_part_alloc (trees,
+                                        t8_cmesh_trees_get_part (trees,
+                                                                 proc));
+}
+
+void
+t8_cmesh_trees_build_ghost_hash (t8_cmesh_trees_t trees,
+                                 t8_locidx_t num_local_trees,
+                                 t8_locidx_t num_ghosts)
+{
+  t8_locidx_t         lghost;
+  t8_cghost_t         ghost;
+
+  T8_ASSERT (trees != NULL);
+  for (lghost = 0; lghost < num_ghosts; lghost++) {
+    ghost = t8_cmesh_trees_get_ghost (trees, lghost);
+    t8_cmesh_trees_insert_ghost_map (trees, ghost->treeid,
+                                     lghost + num_local_trees);
+  }
+  t8_cmesh_trees_sort_ghost_map (trees);
+}
+
+void
+t8_cmesh_trees_set_mapping (t8_cmesh_trees_t trees, char *mapping,
+                            size_t mapping_size)
+{
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (trees->mapping == NULL);
+  trees->mapping = mapping;
+  trees->mapping_size = mapping_size;
+}
+
+void
+t8_cmesh_trees_share (t8_cmesh_trees_t trees, sc_MPI_Comm comm)
+{
+  size_t              num_parts, ipart, offset, total_size, *part_sizes;
+  t8_part_tree_t      part;
+  char               *shared;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (trees->mapping == NULL && trees->shared == NULL);
+
+  num_parts = trees->from_proc->elem_count;
+  part_sizes = T8_ALLOC (size_t, num_parts);
+  for (ipart = 0, total_size = 0; ipart < num_parts; ipart++) {
+    /* Pad the parts to keep each of them aligned */
+    part_sizes[ipart] =
+      (t8_cmesh_trees_get_part_size (trees, ipart) + 7) & ~(size_t) 7;
+    total_size += part_sizes[ipart];
+  }
+  if (total_size == 0) {
+    T8_FREE (part_sizes);
+    return;
+  }
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  shared = (char *) sc_shmem_malloc (t8_get_package_id (), 1, total_size,
+                                     comm);
+  if (sc_shmem_write_start (shared, comm)) {
+    /* Only one process per node copies the parts */
+    for (ipart = 0, offset = 0; ipart < num_parts; ipart++) {
+      part = t8_cmesh_trees_get_part (trees, ipart);
+      memcpy (shared + offset, part->first_tree,
+              t8_cmesh_trees_get_part_size (trees, ipart));
+      offset += part_sizes[ipart];
+    }
+  }
+  sc_shmem_write_end (shared, comm);
+  for (ipart = 0, offset = 0; ipart < num_parts; ipart++) {
+    part = t8_cmesh_trees_get_part (trees, ipart);
+    T8_FREE (part->first_tree);
+    part->first_tree = shared + offset;
+    offset += part_sizes[ipart];
+  }
+  T8_FREE (part_sizes);
+  trees->shared = shared;
+  trees->shared_comm = comm;
+}
+
 t8_ctree_t
 t8_cmesh_trees_get_tree (t8_cmesh_trees_t trees, t8_locidx_t ltree)
 {
@@ -509,6 +616,68 @@ t8_cmesh_trees_get_face_neighbor (t8_ctree_t tree, int face)
   return face_neighbors[face];
 }
 
+void
+t8_cmesh_trees_build_face_arrays (t8_cmesh_trees_t trees,
+                                  t8_locidx_t num_local_trees, int dimension)
+{
+  t8_ctree_t          tree;
+  t8_locidx_t         ltree, *face_neigh;
+  int8_t             *ttf;
+  int                 F, iface, num_faces;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (trees->face_neighbors == NULL && trees->face_ttf == NULL);
+
+  if (num_local_trees <= 0 || dimension <= 0) {
+    return;
+  }
+  F = t8_eclass_max_num_faces[dimension];
+  trees->face_stride = F;
+  trees->face_neighbors = T8_ALLOC (t8_locidx_t, (size_t) num_local_trees * F);
+  trees->face_ttf = T8_ALLOC (int8_t, (size_t) num_local_trees * F);
+  for (ltree = 0; ltree < num_local_trees; ltree++) {
+    tree = t8_cmesh_trees_get_tree_ext (trees, ltree, &face_neigh, &ttf);
+    num_faces = t8_eclass_num_faces[tree->eclass];
+    memcpy (trees->face_neighbors + (size_t) ltree * F, face_neigh,
+            num_faces * sizeof (t8_locidx_t));
+    memcpy (trees->face_ttf + (size_t) ltree * F, ttf,
+            num_faces * sizeof (int8_t));
+    /* Trees with fewer faces than F are padded with invalid entries */
+    for (iface = num_faces; iface < F; iface++) {
+      trees->face_neighbors[(size_t) ltree * F + iface] = -1;
+      trees->face_ttf[(size_t) ltree * F + iface] = -1;
+    }
+  }
+}
+
+t8_locidx_t
+t8_cmesh_trees_get_face_neighbor_ext (t8_cmesh_trees_t trees,
+                                      t8_locidx_t ltree_id, int face,
+                                      int8_t * ttf)
+{
+  t8_locidx_t        *face_neigh;
+  int8_t             *tree_ttf;
+  size_t              index;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (ltree_id >= 0);
+
+  if (trees->face_neighbors != NULL) {
+    T8_ASSERT (0 <= face && face < trees->face_stride);
+    index = (size_t) ltree_id * trees->face_stride + face;
+    if (ttf != NULL) {
+      *ttf = trees->face_ttf[index];
+    }
+    return trees->face_neighbors[index];
+  }
+  (void) t8_cmesh_trees_get_tree_ext (trees, ltree_id, &face_neigh,
+                                      &tree_ttf);
+  if (ttf != NULL) {
+    *ttf = tree_ttf[face];
+  }
+  return face_neigh[face];
+}
+
 t8_cghost_t
 t8_cmesh_trees_get_ghost (t8_cmesh_trees_t trees, t8_locidx_t lghost)
 {
@@ -542,23 +711,30 @@ t8_locidx_t
 t8_cmesh_trees_get_ghost_local_id (t8_cmesh_trees_t trees,
                                    t8_gloidx_t global_id)
 {
-  t8_trees_glo_lo_hash_t hash_search, **phash_found, *hash_found;
-  int                 ret;
-
-  hash_search.global_id = global_id;
-  ret = sc_hash_lookup (trees->ghost_globalid_to_local_id, &hash_search,
-                        (void ***) &phash_found);
-  t8_debugf ("[H] trees looked for local id to gid %li found %i\n",
-             global_id, ret);
-  if (ret) {
-    /* The entry was found */
-    hash_found = *phash_found;
-    return hash_found->local_id;
+  const t8_trees_glo_lo_hash_t *base;
+  size_t              num_entries, half;
+
+  if (!trees->ghost_map_sorted) {
+    /* Ghosts were added since the last sort, this only happens while the
+     * cmesh is built */
+    t8_cmesh_trees_sort_ghost_map (trees);
   }
-  else {
-    /* A ghost with this global id does not exist */
+  num_entries = trees->ghost_globalid_to_local_id.elem_count;
+  if (num_entries == 0) {
     return -1;
   }
+  /* Search the last entry whose global id is at most global_id. The loop
+   * does not branch on the comparison, its length only depends on the
+   * number of entries. */
+  base = (const t8_trees_glo_lo_hash_t *)
+    trees->ghost_globalid_to_local_id.array;
+  while (num_entries > 1) {
+    half = num_entries / 2;
+    base = base[half].global_id <= global_id ? base + half : base;
+    num_entries -= half;
+  }
+  /* A negative number if a ghost with this global id does not exist */
+  return base->global_id == global_id ? base->local_id : -1;
 }
 
 size_t
@@ -581,6 +757,66 @@ t8_cmesh_trees_size (t8_cmesh_trees_t trees)
   return total_bytes;
 }
 
+void
+t8_cmesh_trees_memory_usage (t8_cmesh_trees_t trees, size_t * usage)
+{
+  t8_part_tree_t      part;
+  t8_ctree_t          tree;
+  t8_cghost_t         ghost;
+  t8_locidx_t         ltree, lghost, num_trees = 0, num_ghosts = 0;
+  size_t              part_bytes[T8_CMESH_MEMORY_NUM_CATEGORIES];
+  int                 ipart, icat, num_sharing = 1, mpiret;
+
+  T8_ASSERT (trees != NULL);
+  T8_ASSERT (usage != NULL);
+
+  memset (part_bytes, 0, sizeof (part_bytes));
+  usage[T8_CMESH_MEMORY_OTHER] += sizeof (t8_cmesh_trees_struct_t);
+  if (trees->from_proc != NULL) {
+    usage[T8_CMESH_MEMORY_OTHER] += sc_array_memory_used (trees->from_proc, 1);
+    /* Split the parts' memory into tree, ghost, face and attribute data */
+    for (ipart = 0; ipart < (int) trees->from_proc->elem_count; ipart++) {
+      part = t8_cmesh_trees_get_part (trees, ipart);
+      part_bytes[T8_CMESH_MEMORY_TREES] +=
+        part->num_trees * sizeof (t8_ctree_struct_t);
+      part_bytes[T8_CMESH_MEMORY_GHOSTS] +=
+        part->num_ghosts * sizeof (t8_cghost_struct_t);
+      for (ltree = 0; ltree < part->num_trees; ltree++) {
+        tree = t8_cmesh_trees_get_tree (trees, ltree + part->first_tree_id);
+        part_bytes[T8_CMESH_MEMORY_ATTRIBUTES] +=
+          t8_cmesh_trees_attribute_size (tree)
+          + tree->num_attributes * sizeof (t8_attribute_info_struct_t);
+        part_bytes[T8_CMESH_MEMORY_FACES] +=
+          t8_cmesh_trees_neighbor_bytes (tree);
+      }
+      for (lghost = 0; lghost < part->num_ghosts; lghost++) {
+        ghost =
+          t8_cmesh_trees_get_ghost (trees, lghost + part->first_ghost_id);
+        part_bytes[T8_CMESH_MEMORY_FACES] +=
+          t8_cmesh_trees_gneighbor_bytes (ghost);
+      }
+      num_trees += part->num_trees;
+      num_ghosts += part->num_ghosts;
+    }
+  }
+  if (trees->shared != NULL) {
+    /* Each process on the node holds an equal share of the parts */
+    mpiret = sc_MPI_Comm_size (trees->shared_comm, &num_sharing);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (icat = 0; icat < T8_CMESH_MEMORY_NUM_CATEGORIES; icat++) {
+    usage[icat] += part_bytes[icat] / num_sharing;
+  }
+  usage[T8_CMESH_MEMORY_OTHER] += num_trees * sizeof (int);
+  usage[T8_CMESH_MEMORY_GHOSTS] += num_ghosts * sizeof (int);
+  if (trees->face_neighbors != NULL) {
+    usage[T8_CMESH_MEMORY_FACES] += (size_t) num_trees * trees->face_stride
+      * (sizeof (t8_locidx_t) + sizeof (int8_t));
+  }
+  usage[T8_CMESH_MEMORY_HASH] +=
+    sc_array_memory_used (&trees->ghost_globalid_to_local_id, 0);
+}
+
 void
 t8_cmesh_trees_copy_toproc (t8_cmesh_trees_t trees_dest,
                             t8_cmesh_trees_t trees_src,
@@ -931,11 +1167,12 @@ t8_cmesh_trees_ghost_id (t8_cmesh_t cmesh, t8_cmesh_trees_t trees,
   return -1;
 }
 
-void
+size_t
 t8_cmesh_trees_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
 {
   int                 num_parts, ipart;
   int                 mpirank, mpiret, mpisize;
+  size_t              num_bytes;
   t8_cmesh_trees_t    trees = NULL;
   t8_part_tree_t      part;
 
@@ -971,6 +1208,7 @@ t8_cmesh_trees_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
   /* Broadcast the number of parts */
   mpiret = sc_MPI_Bcast (&num_parts, 1, sc_MPI_INT, root, comm);
   SC_CHECK_MPI (mpiret);
+  num_bytes = sizeof (int);
 
   if (mpirank != root) {
     /* Init trees structure */
@@ -1005,10 +1243,12 @@ t8_cmesh_trees_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
       sc_MPI_Bcast (part->first_tree, part_info.num_bytes, sc_MPI_BYTE, root,
                     comm);
     SC_CHECK_MPI (mpiret);
+    num_bytes += sizeof (part_info) + part_info.num_bytes;
   }                             /* end for */
   /* Bcast the tree_to_proc array */
   sc_MPI_Bcast (trees->tree_to_proc, cmesh_in->num_trees, sc_MPI_INT, root,
                 comm);
+  return num_bytes + cmesh_in->num_trees * sizeof (int);
 }
 
 /* Check whether for each tree its neighbors are set consistently, that means that
@@ -1231,17 +1471,31 @@ t8_cmesh_trees_destroy (t8_cmesh_trees_t * ptrees)
   t8_cmesh_trees_t    trees = *ptrees;
   t8_part_tree_t      part;
 
-  for (proc = 0; proc < trees->from_proc->elem_count; proc++) {
-    part = t8_cmesh_trees_get_part (trees, proc);
-    T8_FREE (part->first_tree);
+  if (trees->mapping != NULL) {
+    /* The parts lie in a memory mapped file */
+#ifdef T8_HAVE_SYS_MMAN_H
+    munmap (trees->mapping, trees->mapping_size);
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+  }
+  else if (trees->shared != NULL) {
+    /* The parts lie in node shared memory */
+    sc_shmem_free (t8_get_package_id (), trees->shared, trees->shared_comm);
+  }
+  else {
+    for (proc = 0; proc < trees->from_proc->elem_count; proc++) {
+      part = t8_cmesh_trees_get_part (trees, proc);
+      T8_FREE (part->first_tree);
+    }
   }
+  T8_FREE (trees->face_neighbors);
+  T8_FREE (trees->face_ttf);
   T8_FREE (trees->ghost_to_proc);
   T8_FREE (trees->tree_to_proc);
   sc_array_destroy (trees->from_proc);
-  /* Free the hash table */
-
-  sc_hash_destroy (trees->ghost_globalid_to_local_id);
-  sc_mempool_destroy (trees->global_local_mempool);
+  /* Free the global_id to local_id map */
+  sc_array_reset (&trees->ghost_globalid_to_local_id);
 
   T8_FREE (trees);
   ptrees = NULL;
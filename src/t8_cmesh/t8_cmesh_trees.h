@@ -145,7 +145,7 @@ T8_EXTERN_C_BEGIN ();
   t8_eclass_num_faces[(g)->eclass] * sizeof(t8_gloidx_t))
 
 /** This struct is an entry of the trees global_id to local_id
- * hash table for ghost trees. */
+ * map for ghost trees. */
 typedef struct
 {
   t8_gloidx_t         global_id;/**< The global id */
@@ -255,6 +255,72 @@ void                t8_cmesh_trees_copy_part (t8_cmesh_trees_t trees_dest,
                                               t8_cmesh_trees_t trees_src,
                                               int part_src);
 
+/** Return the number of bytes of a part's first_tree array, that is
+ * the size of its trees, ghosts, face neighbors and attributes.
+ * \param [in]          trees         The trees structure.
+ * \param [in]          proc          The index of the part.
+ *                                    \ref t8_cmesh_trees_finish_part
+ *                                    must have been called for this part.
+ * \return                            The number of bytes used by part \a proc.
+ */
+size_t              t8_cmesh_trees_get_part_size (t8_cmesh_trees_t trees,
+                                                  int proc);
+
+/** Insert all ghosts of a trees structure into its global id to local id
+ * hash table. This is needed if the parts and the ghost_to_proc array were
+ * filled directly from raw bytes instead of via \ref t8_cmesh_trees_add_ghost.
+ * \param [in,out]      trees           The trees structure.
+ * \param [in]          num_local_trees The number of local trees.
+ * \param [in]          num_ghosts      The number of ghosts.
+ */
+void                t8_cmesh_trees_build_ghost_hash (t8_cmesh_trees_t trees,
+                                                     t8_locidx_t
+                                                     num_local_trees,
+                                                     t8_locidx_t num_ghosts);
+
+/** Add a ghost to the global_id to local_id map of a trees structure.
+ * \param [in,out]      trees           The trees structure.
+ * \param [in]          global_id       The global id of the ghost.
+ * \param [in]          local_id        Its local id, starting at the number
+ *                                      of local trees.
+ * The map must be sorted with \ref t8_cmesh_trees_sort_ghost_map before
+ * it is used concurrently.
+ */
+void                t8_cmesh_trees_insert_ghost_map (t8_cmesh_trees_t trees,
+                                                     t8_gloidx_t global_id,
+                                                     t8_locidx_t local_id);
+
+/** Sort the global_id to local_id map of the ghosts of a trees structure,
+ * such that it can be searched in logarithmic time.
+ * \param [in,out]      trees           The trees structure.
+ */
+void                t8_cmesh_trees_sort_ghost_map (t8_cmesh_trees_t trees);
+
+/** Pass a memory mapped file to a trees structure, into which the
+ * first_tree arrays of its parts point.
+ * The parts are then not freed individually, instead the whole mapping
+ * is unmapped when the trees structure is destroyed.
+ * \param [in,out]      trees         The trees structure.
+ * \param [in]          mapping       The start of a memory mapping.
+ * \param [in]          mapping_size  The size of \a mapping in bytes.
+ */
+void                t8_cmesh_trees_set_mapping (t8_cmesh_trees_t trees,
+                                                char *mapping,
+                                                size_t mapping_size);
+
+/** Move the parts of a trees structure into one block of node shared memory.
+ * All processes on a node then use the same copy of the parts, which must
+ * therefore be equal on all processes, as for a replicated cmesh.
+ * The parts must not be modified afterwards.
+ * This function is collective, as is destroying the trees structure.
+ * \param [in,out]      trees         The trees structure.
+ * \param [in]          comm          The communicator on which the parts are
+ *                                    shared. It must be valid until \a trees
+ *                                    is destroyed.
+ */
+void                t8_cmesh_trees_share (t8_cmesh_trees_t trees,
+                                          sc_MPI_Comm comm);
+
 /** Add a tree to a trees structure.
  * \param [in,out]  trees The trees structure to be updated.
  * \param [in]      tree_id The local id of the tree to be inserted.
@@ -329,6 +395,36 @@ t8_ctree_t          t8_cmesh_trees_get_tree_ext (t8_cmesh_trees_t trees,
 t8_locidx_t         t8_cmesh_trees_get_face_neighbor (t8_ctree_t tree,
                                                       int face);
 
+/** Copy the face neighbors and tree to face entries of all local trees
+ * into two arrays with a fixed number of entries per tree. Lookups with
+ * \ref t8_cmesh_trees_get_face_neighbor_ext then read from these arrays
+ * instead of the tree parts.
+ * The trees must not be modified afterwards.
+ * \param [in,out]  trees       The trees structure.
+ * \param [in]      num_local_trees The number of local trees in \a trees.
+ * \param [in]      dimension   The dimension of the trees.
+ */
+void                t8_cmesh_trees_build_face_arrays (t8_cmesh_trees_t
+                                                      trees,
+                                                      t8_locidx_t
+                                                      num_local_trees,
+                                                      int dimension);
+
+/** Return the local id of the face neighbor of a local tree and its
+ * tree to face entry.
+ * \param [in]      trees       The trees structure.
+ * \param [in]      ltree_id    The local id of the tree.
+ * \param [in]      face        The face number.
+ * \param [out]     ttf         If not NULL, on output the tree to face entry
+ *                              of \a face, that is F * orientation + neighbor face.
+ * \return                      The local id of the neighbor tree or ghost.
+ */
+t8_locidx_t         t8_cmesh_trees_get_face_neighbor_ext (t8_cmesh_trees_t
+                                                          trees,
+                                                          t8_locidx_t
+                                                          ltree_id, int face,
+                                                          int8_t * ttf);
+
 /* TODO: This function return NULL if the ghost is not present.
  *       So far no error checking is done here. */
 /** Return a pointer to a specific ghost in a trees struct.
@@ -370,6 +466,16 @@ t8_locidx_t         t8_cmesh_trees_get_ghost_local_id (t8_cmesh_trees_t trees,
  * returns the complete size in bytes needed to store all information */
 size_t              t8_cmesh_trees_size (t8_cmesh_trees_t trees);
 
+/** Add the bytes allocated by a trees structure to a memory usage count.
+ * If the parts lie in node shared memory, each process adds its share.
+ * \param [in]      trees   The trees structure.
+ * \param [in,out]  usage   T8_CMESH_MEMORY_NUM_CATEGORIES counters, indexed by
+ *                          \ref t8_cmesh_memory_t. On output the bytes of
+ *                          \a trees are added to them.
+ */
+void                t8_cmesh_trees_memory_usage (t8_cmesh_trees_t trees,
+                                                 size_t * usage);
+
 /** For one tree in a trees structure set the number of attributes
  *  and temporarily store the total size of all of this tree's attributes.
  *  This temporary value is used in \ref t8_cmesh_trees_finish_part.
@@ -462,8 +568,9 @@ void                t8_cmesh_trees_print (t8_cmesh_t cmesh,
  * \param [in]      root        The rank that broadcasts \a cmesh_in to all
  *                              other ranks.
  * \param [in]      comm        MPI communicator to use.
+ * \return                      The number of bytes that were broadcasted.
  */
-void                t8_cmesh_trees_bcast (t8_cmesh_t cmesh_in, int root,
+size_t              t8_cmesh_trees_bcast (t8_cmesh_t cmesh_in, int root,
                                           sc_MPI_Comm comm);
 
 /** Check whether the face connection of a trees structure are consistent.
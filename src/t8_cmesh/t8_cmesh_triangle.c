@@ -25,439 +25,746 @@
 #include <t8_cmesh_vtk.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_stash.h"
-
-/* TODO: if partitioned then only add the needed face-connections to join faces
- *       maybe also only trees and ghosts to classes.
- *       Specifying all face-connections makes commit algorithm slow! */
+#ifdef T8_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 /* TODO: eventually compute neighbours only from .node and .ele files, since
  *       creating .neigh files with tetgen/triangle is not common and even seems
  *       to not work sometimes */
 
-/* Read a the next line from a file stream that does not start with '#' or
- * contains only whitespaces (tabs etc.)
- *
- * \param [in,out] line     An allocated string to store the line.
- * \param [in,out] n        The number of allocated bytes.
- *                          If more bytes are needed line is reallocated and
- *                          the new number of bytes is stored in n.
- * \param [in]     fp       The file stream to read from.
- * \return                  The number of read arguments of the last line read.
- *                          negative on failure */
+/* The files are mapped to memory if possible and otherwise read with a
+ * single call to fread. We then parse the numbers directly from memory.
+ * Since the records of the files are numbered consecutively, we store the
+ * position of each record. Thus, we can read the records of single nodes
+ * and elements without parsing the rest of the file. */
+typedef struct
+{
+  char               *data;     /* The content of the file */
+  size_t              size;     /* The number of bytes in data */
+  int                 mapped;   /* True if data is a memory mapping */
+  sc_array_t          records;  /* The offset of each line in data that is
+                                   not empty and not a comment.
+                                   The first record is the header. */
+} t8_cmesh_triangle_file_t;
+
+/* The trees that a process reads from the .ele and .neigh files */
+typedef struct
+{
+  long                tree_id;
+  long                corners[4];       /* The corners in 2d only need 3 entries */
+  long                neighbors[4];     /* The neighbor at each face or -1 */
+  int                 has_corners;      /* True if the corners were read */
+  int                 is_ghost;
+} t8_cmesh_triangle_tree_t;
+
+/* The powers of ten that are exactly representable as double */
+static const double t8_cmesh_triangle_powers_of_ten[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+  1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Open a file and store the position of its records.
+ * On success 0 is returned.
+ * On failure -1 is returned and the file does not need to be closed. */
 static int
-t8_cmesh_triangle_read_next_line (char **line, size_t * n, FILE * fp)
+t8_cmesh_triangle_file_open (t8_cmesh_triangle_file_t * file,
+                             const char *filename)
 {
-  int                 retval;
-
-  do {
-    /* read first non-comment line from file */
-    /* TODO: getline depends on IEEE Std 1003.1-2008 (``POSIX.1'')
-     *       p4est therefore has its own getline function in p4est_connectivity.h. */
-    retval = getline (line, n, fp);
-    if (retval < 0) {
-      return retval;
+  FILE               *fp;
+  long                size;
+  size_t              pos, begin;
+  char               *line_end;
+
+  file->data = NULL;
+  file->mapped = 0;
+  sc_array_init (&file->records, sizeof (size_t));
+  fp = fopen (filename, "rb");
+  if (fp == NULL) {
+    t8_global_errorf ("Failed to open %s.\n", filename);
+    return -1;
+  }
+  if (fseek (fp, 0, SEEK_END) || (size = ftell (fp)) < 0
+      || fseek (fp, 0, SEEK_SET)) {
+    t8_global_errorf ("Failed to read %s.\n", filename);
+    fclose (fp);
+    return -1;
+  }
+  file->size = (size_t) size;
+#ifdef T8_HAVE_SYS_MMAN_H
+  if (size > 0) {
+    void               *map;
+
+    map = mmap (NULL, file->size, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+    if (map != MAP_FAILED) {
+      file->data = (char *) map;
+      file->mapped = 1;
     }
   }
-  /* check if line is a comment (trainling '#') or consists solely of
-   * blank spaces/tabs */
-  while (*line[0] == '#' || strspn (*line, " \t\r\v\n") == strlen (*line));
-  return retval;
+#endif
+  if (file->data == NULL) {
+    /* The file could not be mapped, so we read it */
+    file->data = T8_ALLOC (char, file->size + 1);
+    if (fread (file->data, 1, file->size, fp) != file->size) {
+      t8_global_errorf ("Failed to read %s.\n", filename);
+      T8_FREE (file->data);
+      fclose (fp);
+      return -1;
+    }
+  }
+  fclose (fp);
+
+  /* Store the beginning of each line that is not empty or a comment */
+  for (pos = 0; pos < file->size; pos = begin) {
+    line_end = (char *) memchr (file->data + pos, '\n', file->size - pos);
+    begin = line_end == NULL ? file->size : (size_t) (line_end - file->data)
+      + 1;
+    while (pos < begin && strchr (" \t\r\v", file->data[pos]) != NULL
+           && file->data[pos] != '\0') {
+      pos++;
+    }
+    if (pos < begin && file->data[pos] != '#' && file->data[pos] != '\n') {
+      *(size_t *) sc_array_push (&file->records) = pos;
+    }
+  }
+  return 0;
 }
 
-/* Open .node file  and read node input
- * vertices is needed to temporarily store the vertex coordinates and pass
- * to t8_cmesh_triangle_read_eles.
- * memory for vertices is allocated here.
- * On succes the index of the first node is returned (0 or 1).
- * On failure -1 is returned. */
-static int
-t8_cmesh_triangle_read_nodes (t8_cmesh_t cmesh, char *filename,
-                              double **vertices, long *num_corners, int dim)
+/* Close a file opened with t8_cmesh_triangle_file_open */
+static void
+t8_cmesh_triangle_file_close (t8_cmesh_triangle_file_t * file)
 {
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
-  t8_topidx_t         cit;
-  long                corner;
-  t8_topidx_t         corner_offset = 0;
-  double              x, y, z;
-#if 0                           /* used for currently disabeld code */
-  int                 i, bdy_marker;
+#ifdef T8_HAVE_SYS_MMAN_H
+  if (file->mapped) {
+    munmap (file->data, file->size);
+  }
 #endif
-  int                 num_attributes;
-  int                 nbdy_marker;
-  int                 retval;
-  int                 temp;
-  int                 num_read;
-
-  T8_ASSERT (filename != NULL);
-  T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
-    t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_node;
+  if (!file->mapped) {
+    T8_FREE (file->data);
   }
+  sc_array_reset (&file->records);
+}
 
-  /* read first non-comment line from .node file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
-    t8_global_errorf ("Failed to read first line from %s.\n", filename);
-    goto die_node;
+/* Skip the blanks in front of the next number of a line.
+ * Return the position of the number or NULL if the line ends first. */
+static const char  *
+t8_cmesh_triangle_skip_blanks (const char *pos, const char *end)
+{
+  while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+    pos++;
   }
+  if (pos == end || *pos == '\n' || *pos == '#') {
+    return NULL;
+  }
+  return pos;
+}
+
+/* Parse an integer at *pos and advance *pos behind it.
+ * Return 0 on success and -1 if the line does not continue with a number. */
+static int
+t8_cmesh_triangle_parse_long (const char **pos, const char *end,
+                              long *value)
+{
+  const char         *p = t8_cmesh_triangle_skip_blanks (*pos, end);
+  const char         *digits;
+  long                result = 0;
+  int                 negative = 0;
 
-  /* read number of corners, dimension (must be 2), number of attributes
-   * and number of boundary markers (0 or 1) */
-  retval = sscanf (line, "%li %i %i %i", num_corners, &temp,
-                   &num_attributes, &nbdy_marker);
-  if (retval != 4) {
-    t8_global_errorf ("Premature end of line.\n");
-    goto die_node;
+  if (p == NULL) {
+    return -1;
   }
-  if (temp != dim) {
-    t8_global_errorf ("Dimension must equal %i.\n", dim);
-    goto die_node;
-  }
-  T8_ASSERT (num_attributes >= 0);
-  T8_ASSERT (nbdy_marker == 0 || nbdy_marker == 1);
-
-  *vertices = T8_ALLOC (double, dim * *num_corners);
-  /* read all vertex coordinates */
-  for (cit = 0; cit < *num_corners; cit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
-      t8_global_errorf ("Failed to read line from %s.\n", filename);
-      goto die_node;
+  if (*p == '-' || *p == '+') {
+    negative = *p++ == '-';
+  }
+  for (digits = p; p < end && *p >= '0' && *p <= '9'; p++) {
+    result = 10 * result + (*p - '0');
+  }
+  if (p == digits) {
+    return -1;
+  }
+  *value = negative ? -result : result;
+  *pos = p;
+  return 0;
+}
+
+/* Parse a floating point number at *pos and advance *pos behind it.
+ * Numbers with at most 19 significant digits and a small exponent are
+ * computed exactly from their digits. All other numbers are passed to
+ * strtod.
+ * Return 0 on success and -1 if the line does not continue with a number. */
+static int
+t8_cmesh_triangle_parse_double (const char **pos, const char *end,
+                                double *value)
+{
+  const char         *p = t8_cmesh_triangle_skip_blanks (*pos, end);
+  const char         *start;
+  uint64_t            mantissa = 0;
+  int                 num_digits = 0, num_significant = 0;
+  int                 exponent = 0, exp_value = 0, exp_negative = 0;
+  int                 negative = 0, exact = 1;
+  char                buffer[64], *strtod_end;
+
+  if (p == NULL) {
+    return -1;
+  }
+  start = p;
+  if (*p == '-' || *p == '+') {
+    negative = *p++ == '-';
+  }
+  /* The digits before the decimal point */
+  for (; p < end && *p >= '0' && *p <= '9'; p++, num_digits++) {
+    if (num_significant < 19) {
+      mantissa = 10 * mantissa + (*p - '0');
+      num_significant += mantissa != 0;
     }
-    /* read corner number and coordinates */
-    retval = sscanf (line, "%li %lf %lf%n", &corner, &x, &y, &num_read);
-    if (dim == 3) {
-      retval += sscanf (line + num_read, "%lf", &z);
+    else {
+      exponent++;
+      exact = exact && *p == '0';
     }
-    if (retval != dim + 1) {
-      t8_global_errorf ("Premature end of line in %s.\n", filename);
+  }
+  /* The digits after the decimal point */
+  if (p < end && *p == '.') {
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++, num_digits++) {
+      if (num_significant < 19) {
+        mantissa = 10 * mantissa + (*p - '0');
+        num_significant += mantissa != 0;
+        exponent--;
+      }
+      else {
+        exact = exact && *p == '0';
+      }
     }
-    /* The corners in a triangle file are indexed starting with zero or one.
-     * The corners in the cmesh always start with zero */
-    if (cit == 0) {
-      T8_ASSERT (corner == 0 || corner == 1);
-      corner_offset = corner;
+  }
+  if (num_digits == 0) {
+    return -1;
+  }
+  /* The exponent */
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (p < end && (*p == '-' || *p == '+')) {
+      exp_negative = *p++ == '-';
     }
-    (*vertices)[dim * cit] = x;
-    (*vertices)[dim * cit + 1] = y;
-    if (dim == 3) {
-      (*vertices)[dim * cit + 2] = z;
+    if (p == end || *p < '0' || *p > '9') {
+      return -1;
     }
-
-#if 0                           /* read attributes and boundary marker. This part is currently not needed */
-    /* read attributes but do not save them */
-    for (i = 0; i < num_attributes; i++) {
-      retval = sscanf (line, "%*f ");
-      if (retval != 0) {
-        t8_global_errorf ("Premature end of line in %s.\n", filename);
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+      if (exp_value < 100000) {
+        exp_value = 10 * exp_value + (*p - '0');
       }
     }
-    retval = sscanf (&line, "%i", &bdy_marker);
-    if (retval != 1) {
-      t8_global_errorf ("Premature end of line in %s.\n", filename);
+    exponent += exp_negative ? -exp_value : exp_value;
+  }
+  *pos = p;
+  if (exact && mantissa <= ((uint64_t) 1 << 53)
+      && exponent >= -22 && exponent <= 22) {
+    /* The mantissa and the power of ten are exact doubles, thus
+     * a single multiplication or division is correctly rounded. */
+    *value = (double) mantissa;
+    if (exponent < 0) {
+      *value /= t8_cmesh_triangle_powers_of_ten[-exponent];
+    }
+    else {
+      *value *= t8_cmesh_triangle_powers_of_ten[exponent];
+    }
+    if (negative) {
+      *value = -*value;
     }
-#endif /* if 0 */
+    return 0;
   }
-  fclose (fp);
-  /* Done reading .node file */
-  free (line);
-  return corner_offset;
-die_node:
-  /* Clean up on error. */
-  /* Close open file */
-  if (fp != NULL) {
-    fclose (fp);
+  /* Let strtod handle all other numbers */
+  if ((size_t) (p - start) >= sizeof (buffer)) {
+    return -1;
   }
-  free (line);
-  return -1;
+  memcpy (buffer, start, p - start);
+  buffer[p - start] = '\0';
+  *value = strtod (buffer, &strtod_end);
+  return *strtod_end == '\0' ? 0 : -1;
 }
 
-/* Open .ele file and read element input
- * On succes the index of the first element is returned (0 or 1).
- * On failure -1 is returned. */
-/* TODO: We can use this file to scan for the neighbors as well
- *       for each node create a list of all nodes (with smaller index)
- *       that it shares a face with. And for each triangle face, look-up
- *       in this list.
- */
+/* Parse num_values integers from the beginning of a record.
+ * Return 0 on success and -1 on failure. */
 static int
-t8_cmesh_triangle_read_eles (t8_cmesh_t cmesh, int corner_offset,
-                             char *filename, double *vertices, int dim
-#ifdef T8_ENABLE_DEBUG
-                             , long num_vertices
-#endif
-  )
+t8_cmesh_triangle_parse_record (t8_cmesh_triangle_file_t * file,
+                                size_t irecord, long *values, int num_values)
 {
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
-  t8_locidx_t         num_elems, tit;
-  t8_locidx_t         triangle, triangle_offset = 0;
-  long                temp_triangle;
-  long                tcorners[4];      /* in 2d only the first 3 values are needed */
-  int                 retval;
-  int                 temp;
+  const char         *pos, *end = file->data + file->size;
+  int                 ivalue;
+
+  if (irecord >= file->records.elem_count) {
+    return -1;
+  }
+  pos = file->data + *(size_t *) sc_array_index (&file->records, irecord);
+  for (ivalue = 0; ivalue < num_values; ivalue++) {
+    if (t8_cmesh_triangle_parse_long (&pos, end, values + ivalue)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Read the coordinates of a node from the .node file. The coordinates
+ * of 2d nodes get a zero z-coordinate.
+ * Return 0 on success and -1 on failure. */
+static int
+t8_cmesh_triangle_parse_node (t8_cmesh_triangle_file_t * file, long inode,
+                              long corner_offset, int dim,
+                              double *coordinates)
+{
+  const char         *pos, *end = file->data + file->size;
+  long                corner;
   int                 i;
-  int                 num_read;
-  double              tree_vertices[12];
 
-  /* Open .ele file and read element input */
-  T8_ASSERT (filename != NULL);
-  T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
-    t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_ele;
+  if ((size_t) inode + 1 >= file->records.elem_count) {
+    return -1;
+  }
+  pos = file->data + *(size_t *) sc_array_index (&file->records, inode + 1);
+  if (t8_cmesh_triangle_parse_long (&pos, end, &corner)
+      || corner - corner_offset != inode) {
+    return -1;
   }
-  /* read first non-comment line from .ele file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
-    t8_global_errorf ("Failed to read first line from %s.\n", filename);
-    goto die_ele;
+  coordinates[2] = 0;
+  for (i = 0; i < dim; i++) {
+    if (t8_cmesh_triangle_parse_double (&pos, end, coordinates + i)) {
+      return -1;
+    }
   }
+  return 0;
+}
+
+/* Read the corners of a tree from the .ele file or its neighbors
+ * from the .neigh file. The first dim + 1 numbers after the tree number
+ * are stored in values and offset is subtracted from them. Negative numbers
+ * in the .neigh file mark the domain boundary and are stored as -1.
+ * Return 0 on success and -1 on failure. */
+static int
+t8_cmesh_triangle_parse_tree (t8_cmesh_triangle_file_t * file, long itree,
+                              long element_offset, long offset, int dim,
+                              long *values)
+{
+  long                record[5];
+  int                 i;
 
-  /* get number of triangles and points per triangle */
-  retval = sscanf (line, "%i %i", &num_elems, &temp);
-  if (retval != 2) {
-    t8_global_errorf ("Premature end of line in %s.\n", filename);
+  if (t8_cmesh_triangle_parse_record (file, itree + 1, record, dim + 2)
+      || record[0] - element_offset != itree) {
+    return -1;
   }
-  T8_ASSERT (temp >= 3);
+  for (i = 0; i < dim + 1; i++) {
+    values[i] = record[i + 1] < 0 ? -1 : record[i + 1] - offset;
+  }
+  return 0;
+}
+
+/* Compare two trees by their id */
+static int
+t8_cmesh_triangle_tree_compare (const void *tree_a, const void *tree_b)
+{
+  const long          id_a = ((const t8_cmesh_triangle_tree_t *) tree_a)->tree_id;
+  const long          id_b = ((const t8_cmesh_triangle_tree_t *) tree_b)->tree_id;
+
+  return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/* Compare two longs */
+static int
+t8_cmesh_triangle_long_compare (const void *a, const void *b)
+{
+  const long          la = *(const long *) a;
+  const long          lb = *(const long *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+/* Sort an array of longs and remove duplicates */
+static void
+t8_cmesh_triangle_sort_unique (sc_array_t * array)
+{
+  size_t              iz, num_unique = 0;
+  long               *values = (long *) array->array;
+
+  qsort (values, array->elem_count, sizeof (long),
+         t8_cmesh_triangle_long_compare);
+  for (iz = 0; iz < array->elem_count; iz++) {
+    if (num_unique == 0 || values[num_unique - 1] != values[iz]) {
+      values[num_unique++] = values[iz];
+    }
+  }
+  sc_array_resize (array, num_unique);
+}
+
+/* Find a tree in the trees that we read. The first num_local_trees trees
+ * are the local trees starting at first_tree, the remaining trees are
+ * sorted by their id. Return NULL if the tree was not read. */
+static t8_cmesh_triangle_tree_t *
+t8_cmesh_triangle_find_tree (sc_array_t * trees, size_t num_local_trees,
+                             long first_tree, long tree_id)
+{
+  t8_cmesh_triangle_tree_t search;
+
+  if (first_tree <= tree_id && tree_id < first_tree + (long) num_local_trees) {
+    return (t8_cmesh_triangle_tree_t *) sc_array_index (trees,
+                                                        tree_id - first_tree);
+  }
+  search.tree_id = tree_id;
+  return (t8_cmesh_triangle_tree_t *)
+    bsearch (&search, trees->array + num_local_trees * trees->elem_size,
+             trees->elem_count - num_local_trees, trees->elem_size,
+             t8_cmesh_triangle_tree_compare);
+}
+
+/* Read the neighbors of the given trees from the .neigh file and, if
+ * read_corners is true, their corners from the .ele file. The trees are
+ * added to the trees array. */
+static int
+t8_cmesh_triangle_read_trees (t8_cmesh_triangle_file_t * ele_file,
+                              t8_cmesh_triangle_file_t * neigh_file,
+                              long element_offset, long corner_offset,
+                              int dim, sc_array_t * tree_ids,
+                              int read_corners, int is_ghost,
+                              sc_array_t * trees)
+{
+  t8_cmesh_triangle_tree_t *tree;
+  size_t              iz;
+
+  for (iz = 0; iz < tree_ids->elem_count; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_push (trees);
+    tree->tree_id = *(long *) sc_array_index (tree_ids, iz);
+    tree->has_corners = read_corners;
+    tree->is_ghost = is_ghost;
+    if (t8_cmesh_triangle_parse_tree (neigh_file, tree->tree_id,
+                                      element_offset, element_offset, dim,
+                                      tree->neighbors)
+        || (read_corners
+            && t8_cmesh_triangle_parse_tree (ele_file, tree->tree_id,
+                                             element_offset, corner_offset,
+                                             dim, tree->corners))) {
+      t8_global_errorf ("Failed to read tree %li.\n", tree->tree_id);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Read the .node, .ele and .neigh files and add the trees with ids in
+ * [first_tree, last_tree] to the cmesh. If partition is true, the trees
+ * are the local trees of this process. We then also add the classes of
+ * the ghost trees and the face connections of the local and ghost trees.
+ * We only read the nodes that are corners of these trees.
+ * On success 0 is returned.
+ * On failure -1 is returned. */
+static int
+t8_cmesh_triangle_read_files (t8_cmesh_t cmesh, const char *fileprefix,
+                              int dim, int partition, int mpirank,
+                              int mpisize)
+{
+  static const char  *suffixes[3] = { "node", "ele", "neigh" };
+  t8_cmesh_triangle_file_t files[3], *node_file, *ele_file, *neigh_file;
+  t8_cmesh_triangle_tree_t *tree, *neighbor, *tree_a, *tree_b;
+  const t8_eclass_t   eclass = dim == 2 ? T8_ECLASS_TRIANGLE : T8_ECLASS_TET;
+  const int           num_faces = dim + 1;
+  char                current_file[BUFSIZ];
+  long                header[4], num_corners, num_elems;
+  long                corner_offset, element_offset, first_tree, last_tree;
+  long                itree, *corner;
+  size_t              num_local_trees, num_ghosts, iz, inode;
+  sc_array_t          trees, tree_ids, node_ids;
+  double             *coordinates = NULL, tree_vertices[12], temp;
+  int                 ifile, num_open = 0, retval = -1;
+  int                 i, face1, face2, face_a, face_b, orientation;
+  int                 firstvertex, ivertex;
+
+  sc_array_init (&trees, sizeof (t8_cmesh_triangle_tree_t));
+  sc_array_init (&tree_ids, sizeof (long));
+  sc_array_init (&node_ids, sizeof (long));
+  for (ifile = 0; ifile < 3; ifile++) {
+    snprintf (current_file, BUFSIZ, "%s.%s", fileprefix, suffixes[ifile]);
+    if (t8_cmesh_triangle_file_open (files + ifile, current_file)) {
+      goto die_read;
+    }
+    num_open++;
+  }
+  node_file = files;
+  ele_file = files + 1;
+  neigh_file = files + 2;
+
+  /* The .node file starts with the number of corners, the dimension,
+   * the number of attributes and the number of boundary markers (0 or 1) */
+  if (t8_cmesh_triangle_parse_record (node_file, 0, header, 4)) {
+    t8_global_errorf ("Premature end of line in %s.node.\n", fileprefix);
+    goto die_read;
+  }
+  num_corners = header[0];
+  if (header[1] != dim) {
+    t8_global_errorf ("Dimension must equal %i.\n", dim);
+    goto die_read;
+  }
+  T8_ASSERT (header[2] >= 0);
+  T8_ASSERT (header[3] == 0 || header[3] == 1);
+  /* The .ele file starts with the number of trees and the number of
+   * corners per tree, the .neigh file with the number of trees and
+   * the number of neighbors per tree */
+  if (t8_cmesh_triangle_parse_record (ele_file, 0, header, 2)
+      || t8_cmesh_triangle_parse_record (neigh_file, 0, header + 2, 2)) {
+    t8_global_errorf ("Premature end of line in %s.ele or %s.neigh.\n",
+                      fileprefix, fileprefix);
+    goto die_read;
+  }
+  num_elems = header[0];
+  T8_ASSERT (header[1] >= dim + 1);
+  if (header[2] != num_elems || header[3] != num_faces) {
+    t8_global_errorf ("%s.neigh does not match %s.ele.\n", fileprefix,
+                      fileprefix);
+    goto die_read;
+  }
+  /* The corners and trees are indexed starting with zero or one.
+   * The corners and trees in the cmesh always start with zero */
+  if (num_corners <= 0 || num_elems <= 0
+      || t8_cmesh_triangle_parse_record (node_file, 1, &corner_offset, 1)
+      || t8_cmesh_triangle_parse_record (ele_file, 1, &element_offset, 1)) {
+    t8_global_errorf ("Premature end of file in %s.node or %s.ele.\n",
+                      fileprefix, fileprefix);
+    goto die_read;
+  }
+  T8_ASSERT (corner_offset == 0 || corner_offset == 1);
+  T8_ASSERT (element_offset == 0 || element_offset == 1);
   /* This step is actually only necessary if the cmesh will be bcasted and
    * partitioned. Then we use the num_elems variable to compute the partition table
    * on the remote processes */
   cmesh->num_trees = num_elems;
-  /* For each triangle read the corner indices */
-  for (tit = 0; tit < num_elems; tit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
-      t8_global_errorf ("Failed to read line from %s.\n", filename);
-      goto die_ele;
+  if (partition) {
+    first_tree = (mpirank * num_elems) / mpisize;
+    last_tree = ((mpirank + 1) * num_elems) / mpisize - 1;
+    t8_debugf ("Partition range [%li,%li]\n", first_tree, last_tree);
+  }
+  else {
+    first_tree = 0;
+    last_tree = num_elems - 1;
+  }
+
+  /* Read the local trees */
+  for (itree = first_tree; itree <= last_tree; itree++) {
+    *(long *) sc_array_push (&tree_ids) = itree;
+  }
+  if (t8_cmesh_triangle_read_trees (ele_file, neigh_file, element_offset,
+                                    corner_offset, dim, &tree_ids, 1, 0,
+                                    &trees)) {
+    goto die_read;
+  }
+  num_local_trees = trees.elem_count;
+  /* The ghosts are the neighbors of local trees that are not local.
+   * In 3d we need their corners to compute the orientation of their
+   * face connections. */
+  sc_array_truncate (&tree_ids);
+  for (iz = 0; iz < num_local_trees; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_index (&trees, iz);
+    for (face1 = 0; face1 < num_faces; face1++) {
+      itree = tree->neighbors[face1];
+      if (itree >= 0 && (itree < first_tree || itree > last_tree)) {
+        *(long *) sc_array_push (&tree_ids) = itree;
+      }
     }
-    retval = sscanf (line, "%li %li %li %li%n", &temp_triangle, tcorners,
-                     tcorners + 1, tcorners + 2, &num_read);
-    triangle = temp_triangle;
-    if (dim == 3) {
-      /* TODO: this is kind of unelegant, can we do it better? */
-      retval += sscanf (line + num_read, "%li", tcorners + 3);
+  }
+  t8_cmesh_triangle_sort_unique (&tree_ids);
+  if (t8_cmesh_triangle_read_trees (ele_file, neigh_file, element_offset,
+                                    corner_offset, dim, &tree_ids, dim == 3,
+                                    1, &trees)) {
+    goto die_read;
+  }
+  num_ghosts = trees.elem_count - num_local_trees;
+  /* For the face connections of the ghosts we also need to read the
+   * neighbors of the ghosts that are neither local trees nor ghosts. */
+  sc_array_truncate (&tree_ids);
+  for (iz = num_local_trees; iz < trees.elem_count; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_index (&trees, iz);
+    for (face1 = 0; face1 < num_faces; face1++) {
+      itree = tree->neighbors[face1];
+      if (itree >= 0 && t8_cmesh_triangle_find_tree (&trees, num_local_trees,
+                                                     first_tree,
+                                                     itree) == NULL) {
+        *(long *) sc_array_push (&tree_ids) = itree;
+      }
     }
-    if (retval != dim + 2) {
-      t8_global_errorf ("Premature end of line in %s.\n", filename);
-      goto die_ele;
+  }
+  t8_cmesh_triangle_sort_unique (&tree_ids);
+  if (t8_cmesh_triangle_read_trees (ele_file, neigh_file, element_offset,
+                                    corner_offset, dim, &tree_ids, dim == 3,
+                                    0, &trees)) {
+    goto die_read;
+  }
+  /* Sort the trees that are not local, so that we can find them */
+  qsort (trees.array + num_local_trees * trees.elem_size,
+         trees.elem_count - num_local_trees, trees.elem_size,
+         t8_cmesh_triangle_tree_compare);
+  t8_debugf ("Read %li local trees and %li ghosts.\n",
+             (long) num_local_trees, (long) num_ghosts);
+
+  /* Read the coordinates of all corners of trees that we read */
+  for (iz = 0; iz < trees.elem_count; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_index (&trees, iz);
+    for (i = 0; tree->has_corners && i < num_faces; i++) {
+      if (tree->corners[i] < 0 || tree->corners[i] >= num_corners) {
+        t8_global_errorf ("Invalid corner in tree %li.\n", tree->tree_id);
+        goto die_read;
+      }
+      *(long *) sc_array_push (&node_ids) = tree->corners[i];
     }
-    /* The triangles in a triangle file are indexed starting with zero or one.
-     * The triangles in the cmesh always start with zero */
-    if (tit == 0) {
-      triangle_offset = triangle;
-      T8_ASSERT (triangle == 0 || triangle == 1);
+  }
+  t8_cmesh_triangle_sort_unique (&node_ids);
+  coordinates = T8_ALLOC (double, 3 * SC_MAX (node_ids.elem_count, 1));
+  for (inode = 0; inode < node_ids.elem_count; inode++) {
+    if (t8_cmesh_triangle_parse_node (node_file,
+                                      *(long *) sc_array_index (&node_ids,
+                                                                inode),
+                                      corner_offset, dim,
+                                      coordinates + 3 * inode)) {
+      t8_global_errorf ("Premature end of line in %s.node.\n", fileprefix);
+      goto die_read;
     }
-    T8_ASSERT (triangle - triangle_offset == tit);
-    t8_cmesh_set_tree_class (cmesh, triangle - triangle_offset,
-                             dim == 2 ? T8_ECLASS_TRIANGLE : T8_ECLASS_TET);
-    if (corner_offset != 0) {
-      tcorners[0] -= corner_offset;
-      tcorners[1] -= corner_offset;
-      tcorners[2] -= corner_offset;
-      tcorners[3] -= corner_offset;
+  }
+
+  /* Set the vertices of the local trees and the classes of the
+   * local trees and ghosts */
+  for (iz = 0; iz < trees.elem_count; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_index (&trees, iz);
+    if (!tree->has_corners) {
+      continue;
     }
-    T8_ASSERT (tcorners[0] < num_vertices);
-    T8_ASSERT (tcorners[1] < num_vertices);
-    T8_ASSERT (tcorners[2] < num_vertices);
-    T8_ASSERT (dim == 2 || tcorners[3] < num_vertices);
-    for (i = 0; i < dim + 1; i++) {
-      tree_vertices[3 * i] = vertices[dim * tcorners[i]];
-      tree_vertices[3 * i + 1] = vertices[dim * tcorners[i] + 1];
-      tree_vertices[3 * i + 2] =
-        dim == 2 ? 0 : vertices[dim * tcorners[i] + 2];
+    for (i = 0; i < num_faces; i++) {
+      corner = (long *) bsearch (tree->corners + i, node_ids.array,
+                                 node_ids.elem_count, sizeof (long),
+                                 t8_cmesh_triangle_long_compare);
+      T8_ASSERT (corner != NULL);
+      inode = corner - (long *) node_ids.array;
+      tree_vertices[3 * i] = coordinates[3 * inode];
+      tree_vertices[3 * i + 1] = coordinates[3 * inode + 1];
+      tree_vertices[3 * i + 2] = coordinates[3 * inode + 2];
     }
     if (dim == 3
         && t8_cmesh_tree_vertices_negative_volume (T8_ECLASS_TET,
                                                    tree_vertices, dim + 1)) {
       /* The volume described is negative. We need to switch two
        * vertices. */
-      double              temp;
-
-      T8_ASSERT (dim == 3);
-      t8_debugf ("Correcting negative volume of tree %li\n",
-                 (long) triangle - triangle_offset);
+      t8_debugf ("Correcting negative volume of tree %li\n", tree->tree_id);
       /* We switch vertex 0 and vertex 1 */
       for (i = 0; i < 3; i++) {
         temp = tree_vertices[i];
         tree_vertices[i] = tree_vertices[3 + i];
         tree_vertices[3 + i] = temp;
       }
+      itree = tree->corners[0];
+      tree->corners[0] = tree->corners[1];
+      tree->corners[1] = itree;
       T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
                  (T8_ECLASS_TET, tree_vertices, dim + 1));
     }
-    t8_cmesh_set_tree_vertices (cmesh, triangle - triangle_offset,
-                                t8_get_package_id (), 0,
-                                tree_vertices, dim + 1);
-  }
-  fclose (fp);
-  T8_FREE (vertices);
-  free (line);
-  /* Done reading .ele file */
-  return triangle_offset;
-die_ele:
-  /* Clean up on error. */
-  /* Close open file */
-  if (fp != NULL) {
-    fclose (fp);
-  }
-  T8_FREE (vertices);
-  free (line);
-  return -1;
-}
-
-/* Open .neigh file and read element neighbor information
- * On success 0 is returned.
- * On failure -1 is returned. */
-static int
-t8_cmesh_triangle_read_neigh (t8_cmesh_t cmesh, int element_offset,
-                              char *filename, int dim)
-{
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
-  t8_locidx_t         element, num_elems, tit;
-  t8_locidx_t        *tneighbors;
-  int                 retval;
-  int                 temp;
-  int                 orientation = 0, face1, face2;
-  int                 num_read;
-  const int           num_faces = dim + 1;
-  double             *el_vertices1, *el_vertices2;
-  int                 ivertex, firstvertex;
-
-  /* Open .neigh file and read face neighbor information */
-  T8_ASSERT (filename != NULL);
-  T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
-    t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_neigh;
-  }
-  /* read first non-comment line from .ele file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
-    t8_global_errorf ("Failed to read first line from %s.\n", filename);
-    goto die_neigh;
+    if (iz < num_local_trees) {
+      t8_cmesh_set_tree_class (cmesh, tree->tree_id, eclass);
+      t8_cmesh_set_tree_vertices (cmesh, tree->tree_id, t8_get_package_id (),
+                                  0, tree_vertices, dim + 1);
+    }
   }
-  retval = sscanf (line, "%i %i", &num_elems, &temp);
-  if (retval != 2) {
-    t8_global_errorf ("Premature end of line in   %s.\n", filename);
-    goto die_neigh;
+  for (iz = num_local_trees; iz < trees.elem_count; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_index (&trees, iz);
+    if (tree->is_ghost) {
+      t8_cmesh_set_tree_class (cmesh, tree->tree_id, eclass);
+    }
   }
-  T8_ASSERT (temp == dim + 1);
-
-  tneighbors = T8_ALLOC (t8_locidx_t, num_elems * num_faces);
 
-  /* We read all the neighbors and write them into an array.
+  /* Find the neighboring faces of the local trees and ghosts.
    * Since TRIANGLE provides us for each triangle and each face with
    * which triangle ist is connected, we still need to find
    * out with which face of this triangle it is connected. */
-  for (tit = 0; tit < num_elems; tit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
-      t8_global_errorf ("Failed to read line from %s.\n", filename);
-      goto die_neigh;
-    }
-    retval =
-      sscanf (line, "%i %i %i %i%n", &element, tneighbors + num_faces * tit,
-              tneighbors + num_faces * tit + 1,
-              tneighbors + num_faces * tit + 2, &num_read);
-    if (dim == 3) {
-      retval +=
-        sscanf (line + num_read, "%i", tneighbors + num_faces * tit + 3);
+  for (iz = 0; iz < trees.elem_count; iz++) {
+    tree = (t8_cmesh_triangle_tree_t *) sc_array_index (&trees, iz);
+    if (iz >= num_local_trees && !tree->is_ghost) {
+      continue;
     }
-    if (retval != dim + 2) {
-      t8_global_errorf ("Premature end of line in %s.\n", filename);
-      goto die_neigh;
-    }
-    T8_ASSERT (element - element_offset == tit);
-
-  }
-  /* We are done reading the file. */
-  fclose (fp);
-
-  /* To compute the face neighbor orientations it is necessary to look up the
-   * vertices of a given tree_id. This is only possible if the attribute array
-   * is sorted. */
-  t8_stash_attribute_sort (cmesh->stash);
-  /* Finde the neighboring faces */
-  for (tit = 0; tit < num_elems; tit++) {
     for (face1 = 0; face1 < num_faces; face1++) {
-      element = tneighbors[num_faces * tit + face1] - element_offset;
-      /* triangle store the neighbor triangle on face1 of tit
+      /* triangle store the neighbor triangle on face1 of tree
        * or -1 if there is no neighbor */
-      if (element != -1 - element_offset && tit < element) {
-        for (face2 = 0; face2 < 3; face2++) {
-          /* Finde the face number of triangle which is connected to tit */
-          if (tneighbors[num_faces * element + face2] == tit + element_offset) {
-            break;
-          }
-        }
-        /* jump here after break */
-        T8_ASSERT (face2 < num_faces);
-        if (dim == 2) {
-          /* compute orientation after the pattern
-           *         f1
-           *        0 1 2
-           *       ======
-           *    0 | 1 0 1
-           * f2 1 | 0 1 0
-           *    2 | 1 0 1
-           */
-          orientation = (face1 + face2 + 1) % 2;
+      itree = tree->neighbors[face1];
+      if (itree < 0 || itree == tree->tree_id) {
+        continue;
+      }
+      neighbor = t8_cmesh_triangle_find_tree (&trees, num_local_trees,
+                                              first_tree, itree);
+      T8_ASSERT (neighbor != NULL);
+      if (itree < tree->tree_id
+          && (neighbor - (t8_cmesh_triangle_tree_t *) trees.array <
+              (ptrdiff_t) num_local_trees || neighbor->is_ghost)) {
+        /* We insert this connection when we visit the neighbor */
+        continue;
+      }
+      for (face2 = 0; face2 < num_faces; face2++) {
+        /* Find the face number of the neighbor which is connected to tree */
+        if (neighbor->neighbors[face2] == tree->tree_id) {
+          break;
         }
-        else {
-          /* TODO: compute correct orientation in 3d
-             or do we do this here? */
-          firstvertex = face1 == 0 ? 1 : 0;
-          el_vertices1 =
-            (double *) t8_stash_get_attribute (cmesh->stash, tit);
-          el_vertices2 =
-            (double *) t8_stash_get_attribute (cmesh->stash, element);
-          el_vertices1 += 3 * firstvertex;
-          for (ivertex = 1; ivertex <= 3; ivertex++) {
-            /* The face with number k consists of the vertices with numbers
-             * k+1, k+2, k+3 (mod 4)
-             * in el_vertices are the coordinates of these vertices in order
-             * v_0x v_0y v_0z v_1x v_1y ... */
-            if (el_vertices1[0] == el_vertices2[3 * ((face2 + ivertex) % 4)]
-                && el_vertices1[1] ==
-                el_vertices2[3 * ((face2 + ivertex) % 4) + 1]
-                && el_vertices1[2] ==
-                el_vertices2[3 * ((face2 + ivertex) % 4) + 2]) {
-              orientation = ivertex;
-              ivertex = 4;      /* Abort loop */
-            }
+      }
+      if (face2 == num_faces) {
+        t8_global_errorf ("Tree %li is not a neighbor of tree %li.\n",
+                          tree->tree_id, itree);
+        goto die_read;
+      }
+      /* We compute the orientation with respect to the tree
+       * with the smaller id */
+      if (tree->tree_id < itree) {
+        tree_a = tree;
+        tree_b = neighbor;
+        face_a = face1;
+        face_b = face2;
+      }
+      else {
+        tree_a = neighbor;
+        tree_b = tree;
+        face_a = face2;
+        face_b = face1;
+      }
+      if (dim == 2) {
+        /* compute orientation after the pattern
+         *         f1
+         *        0 1 2
+         *       ======
+         *    0 | 1 0 1
+         * f2 1 | 0 1 0
+         *    2 | 1 0 1
+         */
+        orientation = (face_a + face_b + 1) % 2;
+      }
+      else {
+        /* The face with number k consists of the vertices with numbers
+         * k+1, k+2, k+3 (mod 4). We find the first vertex of face_a
+         * in face_b. */
+        T8_ASSERT (tree_a->has_corners && tree_b->has_corners);
+        firstvertex = face_a == 0 ? 1 : 0;
+        orientation = -1;
+        for (ivertex = 1; ivertex <= 3; ivertex++) {
+          if (tree_a->corners[firstvertex] ==
+              tree_b->corners[(face_b + ivertex) % 4]) {
+            orientation = ivertex;
+            break;
           }
-          T8_ASSERT (ivertex == 5);     /* asserts if an orientation was successfully found */
-        }
-        /* Insert this face connection if we did not insert it before */
-        if (tit < element || face1 <= face2) {
-          /* if tit !< element then tit == element,
-           * face1 > face2 would mean that we already inserted this connection */
-          t8_cmesh_set_join (cmesh, tit, element, face1, face2, orientation);
         }
+        /* asserts if an orientation was successfully found */
+        T8_ASSERT (orientation > 0);
       }
+      t8_cmesh_set_join (cmesh, tree_a->tree_id, tree_b->tree_id, face_a,
+                         face_b, orientation);
     }
   }
-  T8_FREE (tneighbors);
-  free (line);
-  return 0;
-die_neigh:
-  /* Clean up on error. */
-  /* Close open file */
-  if (fp != NULL) {
-    fclose (fp);
+  if (partition) {
+    t8_cmesh_set_partition_range (cmesh, 3, first_tree, last_tree);
   }
-  free (line);
-  return -1;
+  retval = 0;
+die_read:
+  /* Clean up. */
+  T8_FREE (coordinates);
+  sc_array_reset (&node_ids);
+  sc_array_reset (&tree_ids);
+  sc_array_reset (&trees);
+  for (ifile = 0; ifile < num_open; ifile++) {
+    t8_cmesh_triangle_file_close (files + ifile);
+  }
+  return retval;
 }
 
 /* TODO: remove do_dup argument */
@@ -467,81 +774,23 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
 {
   int                 mpirank, mpisize, mpiret;
   t8_cmesh_t          cmesh;
-  double             *vertices;
-  long                num_vertices;
-  t8_gloidx_t         first_tree, last_tree;
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
-  cmesh = NULL;
-#if 0
   /* TODO: Use cmesh_bcast when scanning replicated mesh.
    *       in that case only rank 0 will read the mesh */
-  if (mpirank == 0 || partition)
-#endif
-  {
-    int                 retval, corner_offset = 0;
-    char                current_file[BUFSIZ];
-
-    t8_cmesh_init (&cmesh);
-    /* read .node file */
-    snprintf (current_file, BUFSIZ, "%s.node", fileprefix);
-    retval =
-      t8_cmesh_triangle_read_nodes (cmesh, current_file, &vertices,
-                                    &num_vertices, dim);
-    if (retval != 0 && retval != 1) {
-      t8_global_errorf ("Error while parsing file %s.\n", current_file);
-      t8_cmesh_unref (&cmesh);
-    }
-    else {
-      /* read .ele file */
-      corner_offset = retval;
-      snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
-      retval =
-        t8_cmesh_triangle_read_eles (cmesh, corner_offset, current_file,
-                                     vertices, dim
-#ifdef T8_ENABLE_DEBUG
-                                     , num_vertices
-#endif
-        );
-      if (retval != 0 && retval != 1) {
-        t8_global_errorf ("Error while parsing file %s.\n", current_file);
-        t8_cmesh_unref (&cmesh);
-      }
-      else {
-        /* read .neigh file */
-        snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
-        retval = t8_cmesh_triangle_read_neigh (cmesh, corner_offset,
-                                               current_file, dim);
-        if (retval != 0) {
-          t8_global_errorf ("Error while parsing file %s.\n", current_file);
-          t8_cmesh_unref (&cmesh);
-        }
-      }
-    }
-    T8_ASSERT (cmesh != NULL);
+  t8_cmesh_init (&cmesh);
+  if (t8_cmesh_triangle_read_files (cmesh, fileprefix, dim, partition,
+                                    mpirank, mpisize)) {
+    t8_global_errorf ("Error while parsing the files %s.\n", fileprefix);
+    t8_cmesh_unref (&cmesh);
   }
-  /* TODO: broadcasting NULL does not work. We need a way to tell the
-   *       other processes if something went wrong. */
-  /* This broadcasts the NULL pointer if anything went wrong */
-#if 0
-  /* TODO: If not partitioned use bcast */
-  if (!partition) {
-    cmesh = t8_cmesh_bcast (cmesh, 0, comm);
-  }
-#endif
+  T8_ASSERT (cmesh != NULL);
 
   if (cmesh != NULL) {
-    if (partition) {
-      first_tree = (mpirank * cmesh->num_trees) / mpisize;
-      last_tree = ((mpirank + 1) * cmesh->num_trees) / mpisize - 1;
-      t8_debugf ("Partition range [%lli,%lli]\n", (long long) first_tree,
-                 (long long) last_tree);
-      t8_cmesh_set_partition_range (cmesh, 3, first_tree, last_tree);
-    }
     t8_cmesh_commit (cmesh, comm);
   }
 #ifdef T8_WITH_METIS
@@ -564,9 +813,6 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
 {
   int                 mpirank, mpisize, mpiret;
   t8_cmesh_t          cmesh;
-  double             *vertices;
-  long                num_vertices;
-  t8_gloidx_t         first_tree, last_tree;
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
   SC_CHECK_MPI (mpiret);
@@ -575,45 +821,12 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
 
   cmesh = NULL;
   if (mpirank == 0 || partition) {
-    int                 retval, corner_offset;
-    char                current_file[BUFSIZ];
-
     t8_cmesh_init (&cmesh);
-    /* read .node file */
-    snprintf (current_file, BUFSIZ, "%s.node", fileprefix);
-    retval =
-      t8_cmesh_triangle_read_nodes (cmesh, current_file, &vertices,
-                                    &num_vertices, dim);
-    if (retval != 0 && retval != 1) {
-      t8_global_errorf ("Error while parsing file %s.\n", current_file);
+    if (t8_cmesh_triangle_read_files (cmesh, fileprefix, dim, partition,
+                                      mpirank, mpisize)) {
+      t8_global_errorf ("Error while parsing the files %s.\n", fileprefix);
       t8_cmesh_unref (&cmesh);
     }
-    else {
-      /* read .ele file */
-      corner_offset = retval;
-      snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
-      retval =
-        t8_cmesh_triangle_read_eles (cmesh, corner_offset, current_file,
-                                     vertices, dim
-#ifdef T8_ENABLE_DEBUG
-                                     , num_vertices
-#endif
-        );
-      if (retval != 0 && retval != 1) {
-        t8_global_errorf ("Error while parsing file %s.\n", current_file);
-        t8_cmesh_unref (&cmesh);
-      }
-      else {
-        /* read .neigh file */
-        snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
-        retval = t8_cmesh_triangle_read_neigh (cmesh, corner_offset,
-                                               current_file, dim);
-        if (retval != 0) {
-          t8_global_errorf ("Error while parsing file %s.\n", current_file);
-          t8_cmesh_unref (&cmesh);
-        }
-      }
-    }
     T8_ASSERT (cmesh != NULL);
   }
   /* TODO: broadcasting NULL does not work. We need a way to tell the
@@ -625,13 +838,6 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
   }
 
   if (cmesh != NULL) {
-    if (partition) {
-      first_tree = (mpirank * cmesh->num_trees) / mpisize;
-      last_tree = ((mpirank + 1) * cmesh->num_trees) / mpisize - 1;
-      t8_debugf ("Partition range [%lli,%lli]\n", (long long) first_tree,
-                 (long long) last_tree);
-      t8_cmesh_set_partition_range (cmesh, 3, first_tree, last_tree);
-    }
     sc_flops_snap (fi, snapshot);
     t8_cmesh_commit (cmesh, comm);
     sc_stats_set1 (&stats[statindex], snapshot->iwtime, "Partitioned Commit");
@@ -28,6 +28,8 @@
 #include <t8_data/t8_shmem.h>
 #include "t8_cmesh_stash.h"
 #include "t8_element.h"
+#include "t8_geometry.h"
+#include <t8_profile_regions.h>
 
 /** \file t8_cmesh_types.h
  * We define here the datatypes needed for internal cmesh routines.
@@ -97,6 +99,10 @@ typedef struct t8_cmesh
                                            refinement patter. See \ref t8_cmesh_set_refine. */
   int8_t              set_partition_level; /**< Non-negative if the cmesh should be partition from an already existing cmesh
                                          with an assumes \a level uniform mesh underneath.  TODO: fix sentence */
+  int8_t              set_reorder; /**< If nonzero the trees are reordered with a graph partitioner during commit.
+                                        \ref t8_cmesh_set_reorder. */
+  int8_t              set_node_shared; /**< If nonzero and the cmesh is replicated, the committed trees are
+                                            stored once per node in shared memory. \ref t8_cmesh_set_node_shared. */
 #if 0
   t8_cmesh_from_t     from_method;      /* TODO: Document */
 #endif
@@ -140,6 +146,13 @@ typedef struct t8_cmesh
 #endif
   t8_stash_t          stash; /**< Used as temporary storage for the trees before commit. */
   t8_cprofile_t      *profile; /**< Used to measure runtimes and statistics of the cmesh algorithms. */
+  struct t8_cmesh_tree_boxes *tree_boxes; /**< If computed, the bounding boxes of the local trees.
+                                               \ref t8_cmesh_get_tree_bounding_box */
+  t8_geometry_t       tree_geometry; /**< If set, the vertices of trees without stored vertices
+                                          are computed from this geometry.
+                                          \ref t8_cmesh_set_tree_geometry */
+  struct t8_cmesh_vertex_cache *vertex_caches; /**< One cache of computed tree vertices per thread. */
+  int                 num_vertex_caches; /**< The number of entries in \a vertex_caches. */
 }
 t8_cmesh_struct_t;
 
@@ -229,10 +242,22 @@ typedef struct t8_cmesh_trees
   sc_array_t         *from_proc;        /* array of t8_part_tree, one for each process */
   int                *tree_to_proc;     /* for each tree its process */
   int                *ghost_to_proc;    /* for each ghost its process */
-  sc_hash_t          *ghost_globalid_to_local_id;       /* A hash table storing the map
+  sc_array_t          ghost_globalid_to_local_id;       /* An array of t8_trees_glo_lo_hash_t storing the map
                                                            global_id -> local_id for the ghost trees.
-                                                           The local_id is the local ghost id starting at num_local_trees  */
-  sc_mempool_t       *global_local_mempool;     /* Memory pool for the entries in the hash table */
+                                                           The local_id is the local ghost id starting at num_local_trees.
+                                                           Sorted by global id if ghost_map_sorted is true. */
+  int                 ghost_map_sorted; /* True if ghost_globalid_to_local_id is sorted */
+  char               *mapping;  /* If not NULL, the parts' data lies in this memory mapped file
+                                   and is not freed individually. */
+  size_t              mapping_size;     /* The size of the memory mapping in bytes */
+  char               *shared;   /* If not NULL, the parts' data lies in this node shared
+                                   memory block and is not freed individually. */
+  sc_MPI_Comm         shared_comm;      /* The communicator that \a shared was allocated on */
+  t8_locidx_t        *face_neighbors;   /* If not NULL, the face neighbors of all local trees,
+                                           face_stride entries per tree */
+  int8_t             *face_ttf; /* If not NULL, the tree to face entries of all local trees,
+                                   face_stride entries per tree */
+  int                 face_stride;      /* The maximum number of faces of a tree */
 }
 t8_cmesh_trees_struct_t;
 
@@ -274,6 +299,13 @@ typedef struct t8_cprofile
   int                 first_tree_shared; /**< 1 if this processes' first tree is shared. 0 if not. */
   double              partition_runtime;/**< The runtime of  the last call to \a t8_cmesh_partition. */
   double              commit_runtime;/**< The runtim of the last call to \a t8_cmesh_commit. */
+  double              commit_hw_counters[T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+                                    /**< The hardware counters of the last call to \a t8_cmesh_commit,
+                                         \see t8_profile_regions_num_hw_counters. */
+  double              commit_memory_peak; /**< The peak heap memory in bytes during the last call to
+                                               \a t8_cmesh_commit, \see t8_profile_regions_set_memory. */
+  t8_profile_comm_t   partition_comm;   /**< The messages of the last call to \a t8_cmesh_partition. */
+  t8_profile_comm_t   bcast_comm;       /**< The payload of the last call to \a t8_cmesh_bcast. */
 }
 t8_cprofile_struct_t;
 
@@ -56,84 +56,93 @@ t8_cmesh_get_num_vertices (t8_cmesh_t cmesh, int count_ghosts)
   return num_vertices;
 }
 
-/* TODO: implement for scale < 1 */
-static int
-t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
-                             double scale, int write_ghosts)
+/* Write the xml header of a .vtu file up to the first piece. */
+static void
+t8_cmesh_vtk_write_header (FILE * vtufile)
 {
-  T8_ASSERT (cmesh != NULL);
-  T8_ASSERT (t8_cmesh_is_committed (cmesh));
-  T8_ASSERT (fileprefix != NULL);
-  T8_ASSERT (scale == 1.);      /* scale = 1 not implemented yet */
-
-  if (cmesh->mpirank == 0) {
-    /* Write the pvtu header file. */
-    int num_ranks_that_write = cmesh->set_partition ? cmesh->mpisize : 1;
-    if (t8_write_pvtu (fileprefix, num_ranks_that_write, 1, 1, 0, 0, 0, NULL)) {
-      SC_ABORTF ("Error when writing file %s.pvtu\n", fileprefix);
-    }
-  }
-  /* If the cmesh is replicated only rank 0 prints it,
-   * otherwise each process prints its part of the cmesh.*/
-  if (cmesh->mpirank == 0 || cmesh->set_partition) {
-    char                vtufilename[BUFSIZ];
-    FILE               *vtufile;
-    t8_topidx_t         num_vertices, ivertex;
-    t8_locidx_t         num_trees;
-    t8_ctree_t          tree;
-    double              x, y, z;
-    double             *vertices, *vertex;
-    int                 k, sk;
-    long long           offset, count_vertices;
-    t8_locidx_t         ighost, num_ghosts, num_loc_trees;
-#ifdef T8_ENABLE_DEBUG
-    t8_cghost_t         ghost;
-#endif
-    t8_eclass_t         eclass;
-
-    num_vertices = t8_cmesh_get_num_vertices (cmesh, write_ghosts);
-    num_trees = t8_cmesh_get_num_local_trees (cmesh);
-    if (write_ghosts) {
-      num_trees += t8_cmesh_get_num_ghosts (cmesh);
-    }
-
-    snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix, cmesh->mpirank);
-    vtufile = fopen (vtufilename, "wb");
-    if (vtufile == NULL) {
-      t8_global_errorf ("Could not open file %s for output.\n", vtufilename);
-      return -1;
-    }
-    fprintf (vtufile, "<?xml version=\"1.0\"?>\n");
-    fprintf (vtufile, "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
+  fprintf (vtufile, "<?xml version=\"1.0\"?>\n");
+  fprintf (vtufile, "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
 #if defined T8_VTK_BINARY && defined T8_VTK_COMPRESSION
-    fprintf (vtufile, " compressor=\"vtkZLibDataCompressor\"");
+  fprintf (vtufile, " compressor=\"vtkZLibDataCompressor\"");
 #endif
 #ifdef SC_IS_BIGENDIAN
-    fprintf (vtufile, " byte_order=\"BigEndian\">\n");
+  fprintf (vtufile, " byte_order=\"BigEndian\">\n");
 #else
-    fprintf (vtufile, " byte_order=\"LittleEndian\">\n");
+  fprintf (vtufile, " byte_order=\"LittleEndian\">\n");
 #endif
-    fprintf (vtufile, "  <UnstructuredGrid>\n");
-    fprintf (vtufile,
-             "    <Piece NumberOfPoints=\"%lld\" NumberOfCells=\"%lld\">\n",
-             (long long) num_vertices, (long long) num_trees);
-    fprintf (vtufile, "      <Points>\n");
+  fprintf (vtufile, "  <UnstructuredGrid>\n");
+}
 
-    /* write point position data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"Position\""
-             " NumberOfComponents=\"3\" format=\"%s\">\n",
-             T8_VTK_FLOAT_NAME, T8_VTK_FORMAT_STRING);
+/* Write the local trees of a cmesh, and its ghosts if write_ghosts is
+ * true, as one piece of a .vtu file. */
+static void
+t8_cmesh_vtk_write_piece (t8_cmesh_t cmesh, FILE * vtufile, int write_ghosts)
+{
+  t8_topidx_t         num_vertices, ivertex;
+  t8_locidx_t         num_trees;
+  t8_ctree_t          tree;
+  double              x, y, z;
+  double             *vertices, *vertex;
+  int                 k, sk;
+  long long           offset, count_vertices;
+  t8_locidx_t         ighost, num_ghosts, num_loc_trees;
+#ifdef T8_ENABLE_DEBUG
+  t8_cghost_t         ghost;
+#endif
+  t8_eclass_t         eclass;
+
+  num_vertices = t8_cmesh_get_num_vertices (cmesh, write_ghosts);
+  num_trees = t8_cmesh_get_num_local_trees (cmesh);
+  if (write_ghosts) {
+    num_trees += t8_cmesh_get_num_ghosts (cmesh);
+  }
+  fprintf (vtufile,
+           "    <Piece NumberOfPoints=\"%lld\" NumberOfCells=\"%lld\">\n",
+           (long long) num_vertices, (long long) num_trees);
+  fprintf (vtufile, "      <Points>\n");
+
+  /* write point position data */
+  fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"Position\""
+           " NumberOfComponents=\"3\" format=\"%s\">\n",
+           T8_VTK_FLOAT_NAME, T8_VTK_FORMAT_STRING);
 
 #ifdef T8_VTK_ASCII
-    for (tree = t8_cmesh_get_first_tree (cmesh); tree != NULL;
-         tree = t8_cmesh_get_next_tree (cmesh, tree)) {
-      vertices = ((double *) t8_cmesh_get_attribute (cmesh,
-                                                     t8_get_package_id (), 0,
-                                                     tree->treeid));
-      for (ivertex = 0; ivertex < t8_eclass_num_vertices[tree->eclass];
-           ivertex++) {
+  for (tree = t8_cmesh_get_first_tree (cmesh); tree != NULL;
+       tree = t8_cmesh_get_next_tree (cmesh, tree)) {
+    vertices = ((double *) t8_cmesh_get_attribute (cmesh,
+                                                   t8_get_package_id (), 0,
+                                                   tree->treeid));
+    for (ivertex = 0; ivertex < t8_eclass_num_vertices[tree->eclass];
+         ivertex++) {
+      vertex = vertices +
+        3 * t8_eclass_vtk_corner_number[tree->eclass][ivertex];
+      x = vertex[0];
+      y = vertex[1];
+      z = vertex[2];
+#ifdef T8_VTK_DOUBLES
+      fprintf (vtufile, "     %24.16e %24.16e %24.16e\n", x, y, z);
+#else
+      fprintf (vtufile, "          %16.8e %16.8e %16.8e\n", x, y, z);
+#endif
+    }
+  }                           /* end tree loop */
+  if (write_ghosts) {
+
+    /* Write the vertices of the ghost trees */
+    num_ghosts = t8_cmesh_get_num_ghosts (cmesh);
+    num_loc_trees = t8_cmesh_get_num_local_trees (cmesh);
+    for (ighost = 0; ighost < num_ghosts; ighost++) {
+      /* Get the eclass of this ghost */
+      eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
+      /* Get a pointer to this ghosts vertices */
+      vertices = (double *) t8_cmesh_get_attribute (cmesh,
+                                                    t8_get_package_id (), 0,
+                                                    ighost + num_loc_trees);
+      T8_ASSERT (vertices != NULL);
+      /* TODO: This code is duplicated above */
+      for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass]; ivertex++) {
         vertex = vertices +
-          3 * t8_eclass_vtk_corner_number[tree->eclass][ivertex];
+          3 * t8_eclass_vtk_corner_number[eclass][ivertex];
         x = vertex[0];
         y = vertex[1];
         z = vertex[2];
@@ -143,194 +152,207 @@ t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
         fprintf (vtufile, "          %16.8e %16.8e %16.8e\n", x, y, z);
 #endif
       }
-    }                           /* end tree loop */
-    if (write_ghosts) {
-
-      /* Write the vertices of the ghost trees */
-      num_ghosts = t8_cmesh_get_num_ghosts (cmesh);
-      num_loc_trees = t8_cmesh_get_num_local_trees (cmesh);
-      for (ighost = 0; ighost < num_ghosts; ighost++) {
-        /* Get the eclass of this ghost */
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        /* Get a pointer to this ghosts vertices */
-        vertices = (double *) t8_cmesh_get_attribute (cmesh,
-                                                      t8_get_package_id (), 0,
-                                                      ighost + num_loc_trees);
-        T8_ASSERT (vertices != NULL);
-        /* TODO: This code is duplicated above */
-        for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass]; ivertex++) {
-          vertex = vertices +
-            3 * t8_eclass_vtk_corner_number[eclass][ivertex];
-          x = vertex[0];
-          y = vertex[1];
-          z = vertex[2];
-#ifdef T8_VTK_DOUBLES
-          fprintf (vtufile, "     %24.16e %24.16e %24.16e\n", x, y, z);
-#else
-          fprintf (vtufile, "          %16.8e %16.8e %16.8e\n", x, y, z);
-#endif
-        }
-      }                         /* end ghost loop */
-    }
+    }                         /* end ghost loop */
+  }
 #else
-    SC_ABORT ("Binary vtk file not implemented\n");
+  SC_ABORT ("Binary vtk file not implemented\n");
 #endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
-    fprintf (vtufile, "      </Points>\n");
-    fprintf (vtufile, "      <Cells>\n");
+  fprintf (vtufile, "        </DataArray>\n");
+  fprintf (vtufile, "      </Points>\n");
+  fprintf (vtufile, "      <Cells>\n");
 
-    /* write connectivity data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"connectivity\""
-             " format=\"%s\">\n", T8_VTK_TOPIDX, T8_VTK_FORMAT_STRING);
+  /* write connectivity data */
+  fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"connectivity\""
+           " format=\"%s\">\n", T8_VTK_TOPIDX, T8_VTK_FORMAT_STRING);
 #ifdef T8_VTK_ASCII
-    for (tree = t8_cmesh_get_first_tree (cmesh), count_vertices = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree)) {
+  for (tree = t8_cmesh_get_first_tree (cmesh), count_vertices = 0;
+       tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree)) {
+    fprintf (vtufile, "         ");
+    for (k = 0; k < t8_eclass_num_vertices[tree->eclass]; ++k,
+         count_vertices++) {
+      fprintf (vtufile, " %lld", count_vertices);
+    }
+    fprintf (vtufile, "\n");
+  }
+  if (write_ghosts) {
+    /* Write the ghost connectivity */
+    for (ighost = 0; ighost < num_ghosts; ighost++) {
+      eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
       fprintf (vtufile, "         ");
-      for (k = 0; k < t8_eclass_num_vertices[tree->eclass]; ++k,
-           count_vertices++) {
+      for (k = 0; k < t8_eclass_num_vertices[eclass]; ++k, count_vertices++) {
         fprintf (vtufile, " %lld", count_vertices);
       }
       fprintf (vtufile, "\n");
     }
-    if (write_ghosts) {
-      /* Write the ghost connectivity */
-      for (ighost = 0; ighost < num_ghosts; ighost++) {
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        fprintf (vtufile, "         ");
-        for (k = 0; k < t8_eclass_num_vertices[eclass]; ++k, count_vertices++) {
-          fprintf (vtufile, " %lld", count_vertices);
-        }
-        fprintf (vtufile, "\n");
-      }
-    }
+  }
 #else
-    SC_ABORT ("Binary vtk file not implemented\n");
+  SC_ABORT ("Binary vtk file not implemented\n");
 #endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
+  fprintf (vtufile, "        </DataArray>\n");
 
-    /* write offset data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"offsets\""
-             " format=\"%s\">\n", T8_VTK_TOPIDX, T8_VTK_FORMAT_STRING);
+  /* write offset data */
+  fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"offsets\""
+           " format=\"%s\">\n", T8_VTK_TOPIDX, T8_VTK_FORMAT_STRING);
 #ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      offset += t8_eclass_num_vertices[tree->eclass];
+  fprintf (vtufile, "         ");
+  for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
+       tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
+    offset += t8_eclass_num_vertices[tree->eclass];
+    fprintf (vtufile, " %lld", offset);
+    if (!(sk % 8))
+      fprintf (vtufile, "\n         ");
+  }
+  if (write_ghosts) {
+    /* ghost offset data */
+    for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
+      eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
+      offset += t8_eclass_num_vertices[eclass];
       fprintf (vtufile, " %lld", offset);
       if (!(sk % 8))
         fprintf (vtufile, "\n         ");
     }
-    if (write_ghosts) {
-      /* ghost offset data */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        offset += t8_eclass_num_vertices[eclass];
-        fprintf (vtufile, " %lld", offset);
-        if (!(sk % 8))
-          fprintf (vtufile, "\n         ");
-      }
-    }
-    fprintf (vtufile, "\n");
+  }
+  fprintf (vtufile, "\n");
 #else
-    SC_ABORT ("Binary vtk file not implemented\n");
+  SC_ABORT ("Binary vtk file not implemented\n");
 #endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
-    /* write type data */
-    fprintf (vtufile, "        <DataArray type=\"UInt8\" Name=\"types\""
-             " format=\"%s\">\n", T8_VTK_FORMAT_STRING);
+  fprintf (vtufile, "        </DataArray>\n");
+  /* write type data */
+  fprintf (vtufile, "        <DataArray type=\"UInt8\" Name=\"types\""
+           " format=\"%s\">\n", T8_VTK_FORMAT_STRING);
 #ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1; tree != NULL;
-         tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      fprintf (vtufile, " %d", t8_eclass_vtk_type[tree->eclass]);
-      if (!(sk % 20) && tree->treeid != (cmesh->num_local_trees - 1))
+  fprintf (vtufile, "         ");
+  for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1; tree != NULL;
+       tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
+    fprintf (vtufile, " %d", t8_eclass_vtk_type[tree->eclass]);
+    if (!(sk % 20) && tree->treeid != (cmesh->num_local_trees - 1))
+      fprintf (vtufile, "\n         ");
+  }
+  if (write_ghosts) {
+    /* ghost offset types */
+    for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
+      eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
+      fprintf (vtufile, " %d", t8_eclass_vtk_type[eclass]);
+      if (!(sk % 20) && ighost != (num_ghosts - 1))
         fprintf (vtufile, "\n         ");
     }
-    if (write_ghosts) {
-      /* ghost offset types */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-        eclass = t8_cmesh_get_ghost_class (cmesh, ighost);
-        fprintf (vtufile, " %d", t8_eclass_vtk_type[eclass]);
-        if (!(sk % 20) && ighost != (num_ghosts - 1))
-          fprintf (vtufile, "\n         ");
-      }
-    }
-    fprintf (vtufile, "\n");
+  }
+  fprintf (vtufile, "\n");
 #else
-    SC_ABORT ("Binary vtk file not implemented\n");
+  SC_ABORT ("Binary vtk file not implemented\n");
 #endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
-    fprintf (vtufile, "      </Cells>\n");
-    /* write treeif data */
-    fprintf (vtufile, "      <CellData Scalars=\"treeid,mpirank\">\n");
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"treeid\""
-             " format=\"%s\">\n", T8_VTK_GLOIDX, T8_VTK_FORMAT_STRING);
+  fprintf (vtufile, "        </DataArray>\n");
+  fprintf (vtufile, "      </Cells>\n");
+  /* write treeif data */
+  fprintf (vtufile, "      <CellData Scalars=\"treeid,mpirank\">\n");
+  fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"treeid\""
+           " format=\"%s\">\n", T8_VTK_GLOIDX, T8_VTK_FORMAT_STRING);
 #ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
-      /* Since tree_id is actually 64 Bit but we store it as 32, we have to check
-       * that we do not get into conversion errors */
-      /* TODO: We switched to 32 Bit because Paraview could not handle 64 well enough.
-       */
-      T8_ASSERT (tree->treeid + cmesh->first_tree ==
-                 (t8_gloidx_t) ((long) tree->treeid + cmesh->first_tree));
-      fprintf (vtufile, " %ld", (long) tree->treeid + cmesh->first_tree);
-      if (!(sk % 8))
-        fprintf (vtufile, "\n         ");
-    }
-    if (write_ghosts) {
-      /* ghost offset types */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
+  fprintf (vtufile, "         ");
+  for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
+       tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
+    /* Since tree_id is actually 64 Bit but we store it as 32, we have to check
+     * that we do not get into conversion errors */
+    /* TODO: We switched to 32 Bit because Paraview could not handle 64 well enough.
+     */
+    T8_ASSERT (tree->treeid + cmesh->first_tree ==
+               (t8_gloidx_t) ((long) tree->treeid + cmesh->first_tree));
+    fprintf (vtufile, " %ld", (long) tree->treeid + cmesh->first_tree);
+    if (!(sk % 8))
+      fprintf (vtufile, "\n         ");
+  }
+  if (write_ghosts) {
+    /* ghost offset types */
+    for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
 #ifdef T8_ENABLE_DEBUG
-        ghost = t8_cmesh_trees_get_ghost (cmesh->trees, ighost);
-        /* Check for conversion errors */
-        T8_ASSERT (ghost->treeid == (t8_gloidx_t) ((long) ghost->treeid));
+      ghost = t8_cmesh_trees_get_ghost (cmesh->trees, ighost);
+      /* Check for conversion errors */
+      T8_ASSERT (ghost->treeid == (t8_gloidx_t) ((long) ghost->treeid));
 #endif
 #if 0
-        fprintf (vtufile, " %ld", (long) ghost->treeid);
+      fprintf (vtufile, " %ld", (long) ghost->treeid);
 #endif
-        /* Write -1 as tree_id so that we can distinguish ghosts from normal trees
-         * in the vtk file */
-        fprintf (vtufile, " %ld", (long) -1);
-        if (!(sk % 8))
-          fprintf (vtufile, "\n         ");
-      }
+      /* Write -1 as tree_id so that we can distinguish ghosts from normal trees
+       * in the vtk file */
+      fprintf (vtufile, " %ld", (long) -1);
+      if (!(sk % 8))
+        fprintf (vtufile, "\n         ");
     }
-    fprintf (vtufile, "\n");
+  }
+  fprintf (vtufile, "\n");
 #else
-    SC_ABORT ("Binary vtk file not implemented\n");
+  SC_ABORT ("Binary vtk file not implemented\n");
 #endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
-    /* write mpirank data */
-    fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"mpirank\""
-             " format=\"%s\">\n", "Int32", T8_VTK_FORMAT_STRING);
+  fprintf (vtufile, "        </DataArray>\n");
+  /* write mpirank data */
+  fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"mpirank\""
+           " format=\"%s\">\n", "Int32", T8_VTK_FORMAT_STRING);
 #ifdef T8_VTK_ASCII
-    fprintf (vtufile, "         ");
-    for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
-         tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
+  fprintf (vtufile, "         ");
+  for (tree = t8_cmesh_get_first_tree (cmesh), sk = 1, offset = 0;
+       tree != NULL; tree = t8_cmesh_get_next_tree (cmesh, tree), ++sk) {
+    fprintf (vtufile, " %i", cmesh->mpirank);
+    if (!(sk % 8))
+      fprintf (vtufile, "\n         ");
+  }
+  if (write_ghosts) {
+    /* write our rank for each ghost */
+    for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
       fprintf (vtufile, " %i", cmesh->mpirank);
       if (!(sk % 8))
         fprintf (vtufile, "\n         ");
     }
-    if (write_ghosts) {
-      /* write our rank for each ghost */
-      for (ighost = 0; ighost < num_ghosts; ighost++, ++sk) {
-        fprintf (vtufile, " %i", cmesh->mpirank);
-        if (!(sk % 8))
-          fprintf (vtufile, "\n         ");
-      }
-    }
-    fprintf (vtufile, "\n");
+  }
+  fprintf (vtufile, "\n");
 #else
-    SC_ABORT ("Binary vtk file not implemented\n");
+  SC_ABORT ("Binary vtk file not implemented\n");
 #endif /* T8_VTK_ASCII */
-    fprintf (vtufile, "        </DataArray>\n");
-    fprintf (vtufile, "      </CellData>\n");
-    /* write type data */
-    fprintf (vtufile, "    </Piece>\n");
-    fprintf (vtufile, "  </UnstructuredGrid>\n");
-    fprintf (vtufile, "</VTKFile>\n");
+  fprintf (vtufile, "        </DataArray>\n");
+  fprintf (vtufile, "      </CellData>\n");
+  /* write type data */
+  fprintf (vtufile, "    </Piece>\n");
+}
+
+/* Write the end of a .vtu file behind the last piece. */
+static void
+t8_cmesh_vtk_write_footer (FILE * vtufile)
+{
+  fprintf (vtufile, "  </UnstructuredGrid>\n");
+  fprintf (vtufile, "</VTKFile>\n");
+}
+
+/* TODO: implement for scale < 1 */
+static int
+t8_cmesh_vtk_write_file_ext (t8_cmesh_t cmesh, const char *fileprefix,
+                             double scale, int write_ghosts)
+{
+  T8_ASSERT (cmesh != NULL);
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (scale == 1.);      /* scale = 1 not implemented yet */
+
+  if (cmesh->mpirank == 0) {
+    /* Write the pvtu header file. */
+    int num_ranks_that_write = cmesh->set_partition ? cmesh->mpisize : 1;
+    if (t8_write_pvtu (fileprefix, num_ranks_that_write, 1, 1, 0, 0, 0, NULL)) {
+      SC_ABORTF ("Error when writing file %s.pvtu\n", fileprefix);
+    }
+  }
+  /* If the cmesh is replicated only rank 0 prints it,
+   * otherwise each process prints its part of the cmesh.*/
+  if (cmesh->mpirank == 0 || cmesh->set_partition) {
+    char                vtufilename[BUFSIZ];
+    FILE               *vtufile;
+
+    snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix, cmesh->mpirank);
+    vtufile = fopen (vtufilename, "wb");
+    if (vtufile == NULL) {
+      t8_global_errorf ("Could not open file %s for output.\n", vtufilename);
+      return -1;
+    }
+    t8_cmesh_vtk_write_header (vtufile);
+    t8_cmesh_vtk_write_piece (cmesh, vtufile, write_ghosts);
+    t8_cmesh_vtk_write_footer (vtufile);
     fclose (vtufile);
   }
   return 0;
@@ -343,3 +365,90 @@ t8_cmesh_vtk_write_file (t8_cmesh_t cmesh, const char *fileprefix,
   T8_ASSERT (scale == 1.0);
   return t8_cmesh_vtk_write_file_ext (cmesh, fileprefix, 1.0, 1);
 }
+
+int
+t8_cmesh_vtk_write_file_nodes (t8_cmesh_t cmesh, const char *fileprefix,
+                               double scale, sc_MPI_Comm comm)
+{
+  sc_MPI_Comm         node_comm;
+  char                vtufilename[BUFSIZ];
+  char               *piece = NULL, *pieces = NULL;
+  size_t              piece_size = 0;
+  FILE               *piecefile, *vtufile;
+  int                *lengths = NULL, *displs = NULL;
+  int                 node, num_nodes, noderank, nodesize, iproc;
+  int                 piece_length, total_length = 0, mpiret;
+  int                 retval = 0;
+
+  T8_ASSERT (cmesh != NULL);
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (scale == 1.0);
+
+  if (!cmesh->set_partition) {
+    /* A replicated cmesh is written by process 0 alone */
+    return t8_cmesh_vtk_write_file (cmesh, fileprefix, scale);
+  }
+  node_comm = t8_vtk_node_comm (comm, &node, &num_nodes);
+  if (cmesh->mpirank == 0) {
+    /* Write the pvtu header file with one piece per node. */
+    if (t8_write_pvtu (fileprefix, num_nodes, 1, 1, 0, 0, 0, NULL)) {
+      SC_ABORTF ("Error when writing file %s.pvtu\n", fileprefix);
+    }
+  }
+
+  /* Write our piece to memory */
+  piecefile = open_memstream (&piece, &piece_size);
+  SC_CHECK_ABORT (piecefile != NULL, "Could not open a memory stream.\n");
+  t8_cmesh_vtk_write_piece (cmesh, piecefile, 1);
+  fclose (piecefile);
+
+  /* Gather the pieces of the node on its first process */
+  mpiret = sc_MPI_Comm_rank (node_comm, &noderank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (node_comm, &nodesize);
+  SC_CHECK_MPI (mpiret);
+  piece_length = (int) piece_size;
+  if (noderank == 0) {
+    lengths = T8_ALLOC (int, nodesize);
+    displs = T8_ALLOC (int, nodesize);
+  }
+  mpiret = sc_MPI_Gather (&piece_length, 1, sc_MPI_INT, lengths, 1,
+                          sc_MPI_INT, 0, node_comm);
+  SC_CHECK_MPI (mpiret);
+  if (noderank == 0) {
+    for (iproc = 0; iproc < nodesize; iproc++) {
+      displs[iproc] = total_length;
+      total_length += lengths[iproc];
+    }
+    pieces = T8_ALLOC (char, SC_MAX (total_length, 1));
+  }
+  mpiret = sc_MPI_Gatherv (piece, piece_length, sc_MPI_BYTE, pieces,
+                           lengths, displs, sc_MPI_BYTE, 0, node_comm);
+  SC_CHECK_MPI (mpiret);
+  free (piece);
+
+  /* The first process of the node writes the pieces into one file */
+  if (noderank == 0) {
+    snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix, node);
+    vtufile = fopen (vtufilename, "wb");
+    if (vtufile == NULL) {
+      t8_errorf ("Could not open file %s for output.\n", vtufilename);
+      retval = -1;
+    }
+    else {
+      t8_cmesh_vtk_write_header (vtufile);
+      fwrite (pieces, 1, total_length, vtufile);
+      t8_cmesh_vtk_write_footer (vtufile);
+      if (ferror (vtufile)) {
+        t8_errorf ("Error when writing file %s\n", vtufilename);
+        retval = -1;
+      }
+      fclose (vtufile);
+    }
+    T8_FREE (pieces);
+    T8_FREE (lengths);
+    T8_FREE (displs);
+  }
+  return retval;
+}
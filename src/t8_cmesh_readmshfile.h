@@ -39,6 +39,8 @@ T8_EXTERN_C_BEGIN ();
 /* put declarations here */
 
 /** Read a .msh file and create a cmesh from it.
+ * Supported are the ASCII and binary formats of version 2.2 and 4.1.
+ * The nodes and elements of binary files are read in blocks.
  * \param [in]    fileprefix    The prefix of the mesh file.
  *                              The file fileprefix.msh is read.
  * \param [in]    partition     If true the file is only opened on one process
@@ -51,6 +53,11 @@ T8_EXTERN_C_BEGIN ();
  *                              dimension to read has to be set manually.
  * \param [in]    master        If partition is true, a valid MPI rank that will
  *                              read the file and store all the trees alone.
+ *                              If partition is true and \a master is negative,
+ *                              all processes read a part of the file in parallel.
+ *                              The trees are then distributed in the order of
+ *                              the file, such that each process gets about the
+ *                              same number of bytes of the element section.
  * \return        A committed cmesh holding the mesh of dimension \a dim in the
  *                specified .msh file.
  */
@@ -58,6 +65,26 @@ t8_cmesh_t
 t8_cmesh_from_msh_file (const char *fileprefix, int partition,
                         sc_MPI_Comm comm, int dim, int master);
 
+/** Read a .msh file on one process and scatter it to a partitioned cmesh.
+ * The \a master process reads the nodes and elements in chunks and sends
+ * each chunk directly to the processes that need it. The trees are
+ * distributed as by \ref t8_cmesh_set_partition_uniform with level 0.
+ * Thus no process holds the whole mesh and the file only needs to be
+ * accessible on \a master.
+ * Supported are ASCII files of version 2.2.
+ * \param [in]    fileprefix    The prefix of the mesh file.
+ *                              The file fileprefix.msh is read.
+ * \param [in]    comm          The MPI communicator with which the cmesh is to be committed.
+ * \param [in]    dim           The dimension to read from the .msh file.
+ * \param [in]    master        The MPI rank that reads the file.
+ * \return        A committed cmesh holding the mesh of dimension \a dim in the
+ *                specified .msh file, or NULL on failure.
+ * This function is collective.
+ */
+t8_cmesh_t
+t8_cmesh_from_msh_file_scatter (const char *fileprefix, sc_MPI_Comm comm,
+                                int dim, int master);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_CMESH_READMSHFILE_H */
@@ -39,17 +39,19 @@ T8_EXTERN_C_BEGIN ();
 /* put declarations here */
 
 /** Open a .node, .ele and .neigh file created by TRIANGLE to read
- * and create a cmesh from them. The cmesh will be replicated.
- * The files are opened and read by one process and the cmesh is then
- * broadcasted to the other processes.
+ * and create a cmesh from them.
+ * The files are memory mapped if possible and the numbers are parsed
+ * directly from memory.
  * \param [in] fileprefix A string holding the prefix of the TRIANGLE files.
  *                        The files \a fileprefix.node, \a fileprefix.ele and
  *                        \a fileprefix.neigh are read.
- * \param [in] partition  In the future this flag can decide whether the returned
- *                        cmesh is partitioned or not. Currently it is always replicated.
+ * \param [in] partition  If true, the returned cmesh is partitioned and each
+ *                        process only reads its own range of trees, the
+ *                        ghosts and the nodes of these trees from the files.
+ *                        Otherwise, the cmesh is replicated.
  * \param [in] comm       The mpi communicator to be used.
  * \param [in] do_dup     Whether \a comm should be duplicated by cmesh.
- * \return                A ommited, replicated cmesh constructed from the info
+ * \return                A commited cmesh constructed from the info
  *                        in the TRIANGLE files.
  */
 t8_cmesh_t
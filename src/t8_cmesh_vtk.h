@@ -39,6 +39,25 @@ int                 t8_cmesh_vtk_write_file (t8_cmesh_t cmesh,
                                              const char *fileprefix,
                                              double scale);
 
+/** Write a partitioned cmesh in .pvtu file format with one .vtu file per
+ * shared memory node instead of one per process.
+ * The first process of each node gathers the local trees of the processes
+ * on its node and writes them as one piece per process into the file
+ * fileprefix_NODE.vtu. Process 0 writes the file fileprefix.pvtu that
+ * lists the files of all nodes.
+ * If the cmesh is replicated, this is \ref t8_cmesh_vtk_write_file.
+ * \param [in] cmesh       A committed cmesh.
+ * \param [in] fileprefix  The prefix of the output files.
+ * \param [in] scale       Must be 1.
+ * \param [in] comm        The communicator with which \a cmesh was committed.
+ * \return                 0 on success, nonzero otherwise (process local).
+ * This function is collective.
+ */
+int                 t8_cmesh_vtk_write_file_nodes (t8_cmesh_t cmesh,
+                                                   const char *fileprefix,
+                                                   double scale,
+                                                   sc_MPI_Comm comm);
+
 /* TODO: Should this function be part of the interface?
  * Not for now: Move to _vtk.h but mark as DEPRECATED */
 /** Set the vertices of a tree in the cmesh.
@@ -54,6 +54,25 @@ t8_element_array_is_valid (t8_element_array_t * element_array)
 }
 #endif
 
+/* Set the number of elements of the sc_array of an element array.
+ * If the memory reserved with t8_element_array_reserve suffices, we only
+ * change the count. Otherwise sc_array_resize grows the memory, which it
+ * also shrinks to the next power of two and would thus undo a reservation. */
+static void
+t8_element_array_set_count (t8_element_array_t * element_array,
+                            size_t new_count)
+{
+  sc_array_t         *array = &element_array->array;
+
+  if (new_count > 0 && array->byte_alloc >= 0
+      && new_count * array->elem_size <= (size_t) array->byte_alloc) {
+    array->elem_count = new_count;
+  }
+  else {
+    sc_array_resize (array, new_count);
+  }
+}
+
 t8_element_array_t *
 t8_element_array_new (t8_eclass_scheme_c * scheme)
 {
@@ -186,7 +205,7 @@ t8_element_array_resize (t8_element_array_t * element_array, size_t new_count)
   /* Store the old number of elements */
   old_count = t8_element_array_get_count (element_array);
   /* resize the data array */
-  sc_array_resize (&element_array->array, new_count);
+  t8_element_array_set_count (element_array, new_count);
   /* if the new_count is larger than the previous count, we need to
    * call t8_element_init on the newly allocated elements. */
   if (old_count < new_count) {
@@ -199,13 +218,52 @@ t8_element_array_resize (t8_element_array_t * element_array, size_t new_count)
   }
 }
 
+void
+t8_element_array_reserve (t8_element_array_t * element_array,
+                          size_t capacity)
+{
+  sc_array_t         *array;
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+
+  array = &element_array->array;
+  T8_ASSERT (array->byte_alloc >= 0);
+  if (capacity * array->elem_size > (size_t) array->byte_alloc) {
+    array->array = SC_REALLOC (array->array, char,
+                               capacity * array->elem_size);
+    array->byte_alloc = (ssize_t) (capacity * array->elem_size);
+  }
+}
+
+void
+t8_element_array_shrink_to_fit (t8_element_array_t * element_array)
+{
+  sc_array_t         *array;
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+
+  array = &element_array->array;
+  T8_ASSERT (array->byte_alloc >= 0);
+  if (array->elem_count == 0) {
+    sc_array_reset (array);
+  }
+  else if (array->elem_count * array->elem_size < (size_t) array->byte_alloc) {
+    array->array = SC_REALLOC (array->array, char,
+                               array->elem_count * array->elem_size);
+    array->byte_alloc = (ssize_t) (array->elem_count * array->elem_size);
+  }
+}
+
 void
 t8_element_array_copy (t8_element_array_t * dest, t8_element_array_t * src)
 {
   T8_ASSERT (t8_element_array_is_valid (dest));
   T8_ASSERT (t8_element_array_is_valid (src));
   T8_ASSERT (dest->scheme == src->scheme);
-  sc_array_copy (&dest->array, &src->array);
+  /* Keep the allocation of dest if it is large enough */
+  t8_element_array_set_count (dest, src->array.elem_count);
+  if (src->array.elem_count > 0) {
+    memcpy (dest->array.array, src->array.array,
+            src->array.elem_count * src->array.elem_size);
+  }
 }
 
 t8_element_t       *
@@ -213,8 +271,11 @@ t8_element_array_push (t8_element_array_t * element_array)
 {
   t8_element_t       *new_element;
   T8_ASSERT (t8_element_array_is_valid (element_array));
-  new_element = (t8_element_t *)
-    sc_array_push (&element_array->array);
+  t8_element_array_set_count (element_array,
+                              element_array->array.elem_count + 1);
+  new_element = t8_element_array_index_locidx (element_array,
+                                               element_array->array.
+                                               elem_count - 1);
   element_array->scheme->t8_element_init (1, new_element, 0);
   return new_element;
 }
@@ -225,8 +286,11 @@ t8_element_t
   t8_element_t       *new_elements;
   T8_ASSERT (t8_element_array_is_valid (element_array));
   /* grow the array */
+  t8_element_array_set_count (element_array,
+                              element_array->array.elem_count + count);
   new_elements = (t8_element_t *)
-    sc_array_push_count (&element_array->array, count);
+    sc_array_index (&element_array->array,
+                    element_array->array.elem_count - count);
   /* initialize the elements */
   element_array->scheme->t8_element_init (count, new_elements, 0);
   return new_elements;
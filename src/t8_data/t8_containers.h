@@ -44,6 +44,101 @@ typedef struct
   sc_array_t          array;  /**< The array in which the elements are stored */
 } t8_element_array_t;
 
+/** A position in a range of a \ref t8_element_array_t.
+ * It stores the index of the current element instead of a pointer to it,
+ * such that it stays valid when the array is resized or reallocated, as
+ * long as the element at this index still exists.
+ * The functions for iterators are inline and do not check the scheme, so
+ * they are cheaper than \ref t8_element_array_index_locidx in loops.
+ * A loop over all elements of an array reads
+ * \code
+ * for (t8_element_array_iterator_init (&it, array, 0,
+ *                                      t8_element_array_get_count (array));
+ *      t8_element_array_iterator_is_valid (&it);
+ *      t8_element_array_iterator_next (&it)) {
+ *   element = t8_element_array_iterator_get (&it);
+ * }
+ * \endcode
+ */
+typedef struct
+{
+  t8_element_array_t *element_array; /**< The array that is iterated. */
+  size_t              index;    /**< The index of the current element. */
+  size_t              end;      /**< The index after the last element of the range. */
+} t8_element_array_iterator_t;
+
+/** Initialize an iterator for a range of an element array.
+ * \param [out] it            The iterator.
+ * \param [in]  element_array The array.
+ * \param [in]  begin         The index of the first element of the range.
+ * \param [in]  end           The index after the last element of the range.
+ */
+static inline void
+t8_element_array_iterator_init (t8_element_array_iterator_t * it,
+                                t8_element_array_t * element_array,
+                                size_t begin, size_t end)
+{
+  T8_ASSERT (begin <= end);
+  it->element_array = element_array;
+  it->index = begin;
+  it->end = end;
+}
+
+/** Query whether an iterator points to an element of its range.
+ * \param [in]  it   An initialized iterator.
+ * \return           True if the current index is smaller than the end of the range.
+ */
+static inline int
+t8_element_array_iterator_is_valid (const t8_element_array_iterator_t * it)
+{
+  return it->index < it->end;
+}
+
+/** Return the current element of an iterator.
+ * The pointer is computed from the current memory of the array, so it has
+ * to be queried again after the array was resized.
+ * \param [in]  it   A valid iterator.
+ * \return           A pointer to the element at the current index.
+ */
+static inline t8_element_t *
+t8_element_array_iterator_get (const t8_element_array_iterator_t * it)
+{
+  T8_ASSERT (it->index < it->element_array->array.elem_count);
+  return (t8_element_t *) (it->element_array->array.array
+                           + it->index * it->element_array->array.elem_size);
+}
+
+/** Return the current index of an iterator.
+ * \param [in]  it   An initialized iterator.
+ * \return           The index of the current element in the array.
+ */
+static inline size_t
+t8_element_array_iterator_get_index (const t8_element_array_iterator_t * it)
+{
+  return it->index;
+}
+
+/** Advance an iterator to the next element.
+ * \param [in,out] it An initialized iterator.
+ */
+static inline void
+t8_element_array_iterator_next (t8_element_array_iterator_t * it)
+{
+  it->index++;
+}
+
+/** Move an iterator to an index.
+ * \param [in,out] it    An initialized iterator.
+ * \param [in]     index The new current index, at most the end of the range.
+ */
+static inline void
+t8_element_array_iterator_seek (t8_element_array_iterator_t * it,
+                                size_t index)
+{
+  T8_ASSERT (index <= it->end);
+  it->index = index;
+}
+
 T8_EXTERN_C_BEGIN ();
 
 /** Creates a new array structure with 0 elements.
@@ -133,10 +228,36 @@ void                t8_element_array_init_copy (t8_element_array_t *
  *                          If it is zero the effect equals \ref t8_element_array_reset.
  * \note If \a new_count is larger than the number of current elements on \a element_array,
  * then \ref t8_element_init is called for the new elements.
+ * \note If \a new_count is nonzero and smaller than the current count, the
+ * memory is kept, \see t8_element_array_shrink_to_fit.
  */
 void                t8_element_array_resize (t8_element_array_t *
                                              element_array, size_t new_count);
 
+/** Reserve memory for a number of elements in an element array.
+ * The element count is not changed. As long as the array holds at most
+ * \a capacity elements, \ref t8_element_array_push,
+ * \ref t8_element_array_push_count and \ref t8_element_array_resize do not
+ * reallocate the memory. Use this to avoid the repeated reallocation and
+ * copying of large arrays that are filled element by element.
+ * \param [in,out] element_array  The element array to be modified.
+ * \param [in] capacity     The number of elements to reserve memory for.
+ *                          If it is less than the currently reserved number,
+ *                          nothing happens.
+ * \note Reducing the count with \ref t8_element_array_resize keeps the
+ * memory. Call \ref t8_element_array_shrink_to_fit to release it.
+ */
+void                t8_element_array_reserve (t8_element_array_t *
+                                              element_array, size_t capacity);
+
+/** Release the memory of an element array that is not used by its elements.
+ * \param [in,out] element_array  The element array to be modified.
+ *                          If it has no elements, the effect equals
+ *                          \ref t8_element_array_reset.
+ */
+void                t8_element_array_shrink_to_fit (t8_element_array_t *
+                                                    element_array);
+
 /** Copy the contents of an array into another.
  * Both arrays must have the same eclass_scheme.
  * \param [in] dest Array will be resized and get new data.
@@ -0,0 +1,163 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_element_scratch.cxx
+ * Implementation of the scratch arena for elements, see
+ * \ref t8_element_scratch.h
+ */
+
+#include <t8_element_cxx.hxx>
+#include <sc_containers.h>
+#include <t8_data/t8_element_scratch.h>
+
+/** The default size of a memory block of a scratch arena in bytes. */
+#define T8_ELEMENT_SCRATCH_BLOCK_SIZE 16384
+
+/** The alignment of each allocation in a scratch arena in bytes. */
+#define T8_ELEMENT_SCRATCH_ALIGN 16
+
+T8_EXTERN_C_BEGIN ();
+
+void
+t8_element_scratch_init (t8_element_scratch_t * scratch, size_t block_size)
+{
+  T8_ASSERT (scratch != NULL);
+
+  sc_array_init (&scratch->blocks, sizeof (t8_element_scratch_block_t));
+  scratch->block_size =
+    block_size > 0 ? block_size : T8_ELEMENT_SCRATCH_BLOCK_SIZE;
+  scratch->current = 0;
+  scratch->offset = 0;
+}
+
+void
+t8_element_scratch_reset (t8_element_scratch_t * scratch)
+{
+  size_t              iblock;
+  t8_element_scratch_block_t *block;
+
+  T8_ASSERT (scratch != NULL);
+
+  for (iblock = 0; iblock < scratch->blocks.elem_count; iblock++) {
+    block = (t8_element_scratch_block_t *)
+      sc_array_index (&scratch->blocks, iblock);
+    T8_FREE (block->data);
+  }
+  sc_array_reset (&scratch->blocks);
+  scratch->current = 0;
+  scratch->offset = 0;
+}
+
+void               *
+t8_element_scratch_alloc (t8_element_scratch_t * scratch, size_t num_bytes)
+{
+  t8_element_scratch_block_t *block;
+  void               *mem;
+
+  T8_ASSERT (scratch != NULL);
+
+  /* Round up, such that the next allocation is aligned as well */
+  num_bytes = (num_bytes + T8_ELEMENT_SCRATCH_ALIGN - 1) &
+    ~((size_t) T8_ELEMENT_SCRATCH_ALIGN - 1);
+  /* If the current block has not enough space left, we continue with the
+   * next block that is big enough or allocate a new one. */
+  while (scratch->current < scratch->blocks.elem_count) {
+    block = (t8_element_scratch_block_t *)
+      sc_array_index (&scratch->blocks, scratch->current);
+    if (scratch->offset + num_bytes <= block->size) {
+      mem = block->data + scratch->offset;
+      scratch->offset += num_bytes;
+      return mem;
+    }
+    scratch->current++;
+    scratch->offset = 0;
+  }
+  /* We need a new block */
+  block = (t8_element_scratch_block_t *) sc_array_push (&scratch->blocks);
+  block->size = SC_MAX (scratch->block_size, num_bytes);
+  block->data = T8_ALLOC (char, block->size);
+  scratch->current = scratch->blocks.elem_count - 1;
+  scratch->offset = num_bytes;
+  return block->data;
+}
+
+void
+t8_element_scratch_new (t8_element_scratch_t * scratch,
+                        t8_eclass_scheme_c * ts, int length,
+                        t8_element_t ** elems)
+{
+  char               *mem;
+  size_t              element_size;
+  int                 ielem;
+
+  T8_ASSERT (scratch != NULL);
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (0 <= length);
+  T8_ASSERT (elems != NULL);
+
+  if (length == 0) {
+    return;
+  }
+  element_size = ts->t8_element_size ();
+  mem = (char *) t8_element_scratch_alloc (scratch, length * element_size);
+  ts->t8_element_init (length, (t8_element_t *) mem, 0);
+  for (ielem = 0; ielem < length; ielem++) {
+    elems[ielem] = (t8_element_t *) (mem + ielem * element_size);
+  }
+}
+
+void
+t8_element_scratch_mark (const t8_element_scratch_t * scratch,
+                         t8_element_scratch_mark_t * mark)
+{
+  T8_ASSERT (scratch != NULL);
+  T8_ASSERT (mark != NULL);
+
+  mark->block = scratch->current;
+  mark->offset = scratch->offset;
+}
+
+void
+t8_element_scratch_release (t8_element_scratch_t * scratch,
+                            const t8_element_scratch_mark_t * mark)
+{
+  T8_ASSERT (scratch != NULL);
+  T8_ASSERT (mark != NULL);
+  /* We can only go back in the arena */
+  T8_ASSERT (mark->block < scratch->current
+             || (mark->block == scratch->current
+                 && mark->offset <= scratch->offset));
+
+  scratch->current = mark->block;
+  scratch->offset = mark->offset;
+}
+
+void
+t8_element_scratch_clear (t8_element_scratch_t * scratch)
+{
+  T8_ASSERT (scratch != NULL);
+
+  scratch->current = 0;
+  scratch->offset = 0;
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,140 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_element_scratch.h
+ * We define a scratch arena for short-lived elements.
+ * Algorithms that need a few temporary elements per iteration, such as
+ * balance, ghost or face neighbor computations, can allocate them from
+ * an arena instead of the mempool of the eclass scheme.
+ * An allocation only increases an offset into a memory block, and all
+ * elements allocated since a given mark are freed at once by resetting
+ * the arena to this mark.
+ * An arena is owned by its caller and not shared between threads,
+ * thus each thread can allocate from its own arena without locking.
+ */
+
+#ifndef T8_ELEMENT_SCRATCH_H
+#define T8_ELEMENT_SCRATCH_H
+
+#include <t8.h>
+#include <t8_element.h>
+
+/** A scratch arena for elements.
+ * It consists of a list of memory blocks that are reused after a reset.
+ */
+typedef struct
+{
+  sc_array_t          blocks;         /**< The memory blocks of the arena,
+                                           each of type \ref t8_element_scratch_block_t. */
+  size_t              block_size;     /**< The minimum size of a new block in bytes. */
+  size_t              current;        /**< The index of the block we allocate from. */
+  size_t              offset;         /**< The number of used bytes in the current block. */
+} t8_element_scratch_t;
+
+/** A memory block of a \ref t8_element_scratch_t. */
+typedef struct
+{
+  char               *data;           /**< The memory of this block. */
+  size_t              size;           /**< The size of this block in bytes. */
+} t8_element_scratch_block_t;
+
+/** A position in a \ref t8_element_scratch_t. Resetting the arena to
+ * a mark frees all elements that were allocated after the mark was taken. */
+typedef struct
+{
+  size_t              block;          /**< The block index at the time of the mark. */
+  size_t              offset;         /**< The offset at the time of the mark. */
+} t8_element_scratch_mark_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Initialize an empty scratch arena. No memory is allocated until the
+ * first element is requested.
+ * \param [in,out] scratch      The arena to initialize.
+ * \param [in]     block_size   The minimum size of a memory block in bytes.
+ *                              If 0, a default size is used.
+ */
+void                t8_element_scratch_init (t8_element_scratch_t * scratch,
+                                             size_t block_size);
+
+/** Free all memory of a scratch arena.
+ * All elements allocated from the arena become invalid.
+ * \param [in,out] scratch      An initialized arena. It must be initialized
+ *                              again before it can be reused.
+ */
+void                t8_element_scratch_reset (t8_element_scratch_t *
+                                              scratch);
+
+/** Allocate memory in a scratch arena.
+ * The memory is aligned for any element type and freed together with the
+ * elements allocated after it.
+ * \param [in,out] scratch      An initialized arena.
+ * \param [in]     num_bytes    The number of bytes to allocate.
+ * \return                      A pointer to \a num_bytes bytes of memory.
+ */
+void               *t8_element_scratch_alloc (t8_element_scratch_t * scratch,
+                                              size_t num_bytes);
+
+/** Allocate elements of a given eclass scheme in a scratch arena.
+ * The elements are stored contiguously and initialized with
+ * \ref t8_element_init. They must not be passed to \ref t8_element_destroy.
+ * \param [in,out] scratch      An initialized arena.
+ * \param [in]     ts           The eclass scheme of the elements.
+ * \param [in]     length       Non-negative number of elements to allocate.
+ * \param [out]    elems        Array of length \a length whose entries are
+ *                              set to the new elements.
+ */
+void                t8_element_scratch_new (t8_element_scratch_t * scratch,
+                                            t8_eclass_scheme_c * ts,
+                                            int length, t8_element_t ** elems);
+
+/** Remember the current position of a scratch arena.
+ * \param [in]     scratch      An initialized arena.
+ * \param [out]    mark         The current position of \a scratch.
+ */
+void                t8_element_scratch_mark (const t8_element_scratch_t *
+                                             scratch,
+                                             t8_element_scratch_mark_t *
+                                             mark);
+
+/** Free all elements that were allocated after a mark was taken.
+ * The memory stays with the arena and is reused by later allocations.
+ * \param [in,out] scratch      An initialized arena.
+ * \param [in]     mark         A mark of \a scratch that was taken with
+ *                              \ref t8_element_scratch_mark and was not
+ *                              invalidated by releasing an earlier mark.
+ */
+void                t8_element_scratch_release (t8_element_scratch_t *
+                                                scratch,
+                                                const
+                                                t8_element_scratch_mark_t *
+                                                mark);
+
+/** Free all elements of a scratch arena, but keep its memory.
+ * \param [in,out] scratch      An initialized arena.
+ */
+void                t8_element_scratch_clear (t8_element_scratch_t *
+                                              scratch);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_ELEMENT_SCRATCH_H */
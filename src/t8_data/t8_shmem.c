@@ -40,9 +40,25 @@ typedef struct t8_shmem_array
 #endif
 } t8_shmem_array_struct_t;
 
+void
+t8_shmem_init (sc_MPI_Comm comm)
+{
+#ifdef SC_ENABLE_MPICOMMSHARED
+  sc_MPI_Comm         intranode, internode;
+
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    /* Without node communicators, sc falls back to one copy of each
+     * shared array per process */
+    sc_mpi_comm_attach_node_comms (comm, 0);
+  }
+#endif
+}
+
 int
 t8_shmem_set_type (sc_MPI_Comm comm, sc_shmem_type_t type)
 {
+  t8_shmem_init (comm);
   if (sc_shmem_get_type (comm) == SC_SHMEM_NOT_SET) {
     /* This communicator does not have a shmem type, so we set it */
     sc_shmem_set_type (comm, type);
@@ -69,7 +85,7 @@ t8_shmem_array_init (t8_shmem_array_t * parray, size_t elem_size,
   array->elem_count = elem_count;
   array->elem_size = elem_size;
 #ifdef T8_ENABLE_DEBUG
-  array->shmem_type = T8_SHMEM_BEST_TYPE;
+  array->shmem_type = sc_shmem_get_type (comm);
 #endif
 }
 
@@ -93,15 +109,166 @@ t8_shmem_array_copy (t8_shmem_array_t dest, t8_shmem_array_t source)
   sc_shmem_memcpy (dest->array, source->array, bytes, source->comm);
 }
 
+void
+t8_shmem_array_copy_from (t8_shmem_array_t dest, const void *source)
+{
+  T8_ASSERT (dest != NULL);
+  T8_ASSERT (dest->array != NULL);
+  T8_ASSERT (source != NULL);
+
+  sc_shmem_memcpy (dest->array, (void *) source,
+                   dest->elem_count * dest->elem_size, dest->comm);
+}
+
+/* Return true if the arrays of a communicator are stored once per node */
+static int
+t8_shmem_is_shared (sc_MPI_Comm comm)
+{
+  sc_shmem_type_t     type;
+
+  type = sc_shmem_get_type (comm);
+  return !(type == SC_SHMEM_NOT_SET || type == SC_SHMEM_BASIC
+           || type == SC_SHMEM_PRESCAN);
+}
+
+#ifdef SC_ENABLE_MPICOMMSHARED
+/* Allgather bytes bytes of each process into the array recv of comm.
+ * The data is gathered on the first process of each node, the node leaders
+ * exchange the data of their nodes with one allgatherv, and then each leader
+ * writes the data into the shared array of its node, or broadcasts it to the
+ * processes of its node if they store their own copy.
+ * In contrast to the allgather of sc, this works with any number of
+ * processes per node and any mapping of ranks to nodes. */
+static void
+t8_shmem_allgather_hierarchical (void *sendbuf, size_t bytes, void *recv,
+                                 sc_MPI_Comm comm, sc_MPI_Comm intranode,
+                                 sc_MPI_Comm internode)
+{
+  int                 mpiret, mpirank, mpisize;
+  int                 intrarank, intrasize, num_nodes, inode, iproc;
+  int                *node_ranks = NULL, *all_ranks = NULL;
+  int                *node_sizes = NULL, *node_offsets = NULL;
+  int                *byte_counts = NULL, *byte_offsets = NULL;
+  int                 is_identity = 0, do_write;
+  char               *node_data = NULL, *all_data = NULL;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (intranode, &intrarank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+  SC_CHECK_MPI (mpiret);
+
+  /* Gather the ranks and the data of the processes of this node */
+  if (intrarank == 0) {
+    node_ranks = T8_ALLOC (int, intrasize);
+    node_data = T8_ALLOC (char, intrasize * bytes);
+  }
+  mpiret = sc_MPI_Gather (&mpirank, 1, sc_MPI_INT, node_ranks, 1,
+                          sc_MPI_INT, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Gather (sendbuf, (int) bytes, sc_MPI_BYTE, node_data,
+                          (int) bytes, sc_MPI_BYTE, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+
+  if (intrarank == 0) {
+    /* Exchange the ranks and the data of all nodes between the leaders */
+    mpiret = sc_MPI_Comm_size (internode, &num_nodes);
+    SC_CHECK_MPI (mpiret);
+    node_sizes = T8_ALLOC (int, num_nodes);
+    node_offsets = T8_ALLOC (int, num_nodes);
+    byte_counts = T8_ALLOC (int, num_nodes);
+    byte_offsets = T8_ALLOC (int, num_nodes);
+    mpiret = sc_MPI_Allgather (&intrasize, 1, sc_MPI_INT, node_sizes, 1,
+                               sc_MPI_INT, internode);
+    SC_CHECK_MPI (mpiret);
+    for (inode = 0, iproc = 0; inode < num_nodes; inode++) {
+      node_offsets[inode] = iproc;
+      byte_counts[inode] = node_sizes[inode] * (int) bytes;
+      byte_offsets[inode] = iproc * (int) bytes;
+      iproc += node_sizes[inode];
+    }
+    T8_ASSERT (iproc == mpisize);
+    all_ranks = T8_ALLOC (int, mpisize);
+    mpiret = sc_MPI_Allgatherv (node_ranks, intrasize, sc_MPI_INT,
+                                all_ranks, node_sizes, node_offsets,
+                                sc_MPI_INT, internode);
+    SC_CHECK_MPI (mpiret);
+    /* If the nodes hold consecutive ranks in order, we receive the data
+     * directly into the array */
+    is_identity = 1;
+    for (iproc = 0; iproc < mpisize && is_identity; iproc++) {
+      is_identity = all_ranks[iproc] == iproc;
+    }
+  }
+
+  /* Only one process per node writes a shared array */
+  do_write = t8_shmem_is_shared (comm) ? sc_shmem_write_start (recv, comm)
+    : intrarank == 0;
+  T8_ASSERT (do_write == (intrarank == 0));
+  if (do_write) {
+    all_data = is_identity ? (char *) recv : T8_ALLOC (char, mpisize * bytes);
+    mpiret = sc_MPI_Allgatherv (node_data, intrasize * (int) bytes,
+                                sc_MPI_BYTE, all_data, byte_counts,
+                                byte_offsets, sc_MPI_BYTE, internode);
+    SC_CHECK_MPI (mpiret);
+    if (!is_identity) {
+      for (iproc = 0; iproc < mpisize; iproc++) {
+        memcpy ((char *) recv + all_ranks[iproc] * bytes,
+                all_data + iproc * bytes, bytes);
+      }
+      T8_FREE (all_data);
+    }
+  }
+  if (t8_shmem_is_shared (comm)) {
+    sc_shmem_write_end (recv, comm);
+  }
+  else {
+    /* Each process stores its own copy */
+    mpiret = sc_MPI_Bcast (recv, mpisize * (int) bytes, sc_MPI_BYTE, 0,
+                           intranode);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  if (intrarank == 0) {
+    T8_FREE (node_ranks);
+    T8_FREE (node_data);
+    T8_FREE (node_sizes);
+    T8_FREE (node_offsets);
+    T8_FREE (byte_counts);
+    T8_FREE (byte_offsets);
+    T8_FREE (all_ranks);
+  }
+}
+#endif
+
 void
 t8_shmem_array_allgather (void *sendbuf, int sendcount,
                           sc_MPI_Datatype sendtype,
                           t8_shmem_array_t recvarray, int recvcount,
                           sc_MPI_Datatype recvtype)
 {
+#ifdef SC_ENABLE_MPICOMMSHARED
+  sc_MPI_Comm         intranode, internode;
+  size_t              bytes;
+#endif
+
   T8_ASSERT (recvarray != NULL);
   T8_ASSERT (recvarray->array != NULL);
 
+#ifdef SC_ENABLE_MPICOMMSHARED
+  sc_mpi_comm_get_node_comms (recvarray->comm, &intranode, &internode);
+  if (intranode != sc_MPI_COMM_NULL && internode != sc_MPI_COMM_NULL) {
+    bytes = sendcount * sc_mpi_sizeof (sendtype);
+    T8_ASSERT (bytes == recvcount * sc_mpi_sizeof (recvtype));
+    t8_shmem_allgather_hierarchical (sendbuf, bytes, recvarray->array,
+                                     recvarray->comm, intranode, internode);
+    return;
+  }
+#endif
+  /* Without node communicators, sc falls back to a flat allgather */
   sc_shmem_allgather (sendbuf, sendcount, sendtype, recvarray->array,
                       recvcount, recvtype, recvarray->comm);
 }
@@ -158,6 +325,33 @@ t8_shmem_array_set_gloidx (t8_shmem_array_t array, int index,
   ((t8_gloidx_t *) array->array)[index] = value;
 }
 
+size_t
+t8_shmem_array_get_bytes_per_process (t8_shmem_array_t array)
+{
+  size_t              bytes;
+#ifdef SC_ENABLE_MPICOMMSHARED
+  sc_MPI_Comm         intranode, internode;
+  int                 mpiret, intrasize;
+#endif
+
+  T8_ASSERT (array != NULL);
+  bytes = array->elem_count * array->elem_size;
+  if (!t8_shmem_is_shared (array->comm)) {
+    /* Each process stores its own copy */
+    return bytes;
+  }
+#ifdef SC_ENABLE_MPICOMMSHARED
+  sc_mpi_comm_get_node_comms (array->comm, &intranode, &internode);
+  if (intranode != sc_MPI_COMM_NULL) {
+    /* The array is stored once per node */
+    mpiret = sc_MPI_Comm_size (intranode, &intrasize);
+    SC_CHECK_MPI (mpiret);
+    return (bytes + intrasize - 1) / intrasize;
+  }
+#endif
+  return bytes;
+}
+
 void *
 t8_shmem_array_get_array (t8_shmem_array_t array)
 {
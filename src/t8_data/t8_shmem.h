@@ -53,10 +53,21 @@ typedef struct t8_shmem_array *t8_shmem_array_t;
 
 T8_EXTERN_C_BEGIN ();
 
+/** Attach node communicators to a communicator, if it does not have them yet.
+ * sc stores shared memory arrays once per node only if the node
+ * communicators are attached, otherwise each process has its own copy.
+ * The node communicators are detected via MPI_Comm_split_type.
+ * \param [in]          comm    The MPI Communicator.
+ * \note This function is collective if the node communicators are not attached.
+ */
+void                t8_shmem_init (sc_MPI_Comm comm);
+
 /** Try to set a shared memory type of a communicator.
  * If the type was set, returns true, otherwise false.
  * This will not set the type, if ther already was a type set
- * on this communicator. \see sc_shmem_set_type
+ * on this communicator. Node communicators are attached with
+ * \ref t8_shmem_init, such that the array is stored once per node
+ * for the shared types. \see sc_shmem_set_type
  * \param [in,out]      comm    The MPI Communicator
  * \param [in]          type    A shared memory type.
  * \return                      Non-zero if the type was set. Zero if it wasn't.
@@ -93,7 +104,23 @@ void                t8_shmem_array_set_gloidx (t8_shmem_array_t array,
 void                t8_shmem_array_copy (t8_shmem_array_t dest,
                                          t8_shmem_array_t source);
 
+/** Copy the contents of a local buffer into a t8_shmem array.
+ * Each process must pass the same data.
+ * \param [in,out]      dest    The array in which should be copied.
+ * \param [in]          source  A buffer of as many elements as \a dest,
+ *                              each of the element size of \a dest.
+ * \note This function is collective.
+ */
+void                t8_shmem_array_copy_from (t8_shmem_array_t dest,
+                                              const void *source);
+
 /** Fill a t8_shmem array with an allgather.
+ * If the communicator of \a recvarray has node communicators, the data is
+ * gathered on one process per node, exchanged between these processes with
+ * one allgather and then written to the shared array of each node, or
+ * broadcast within the node if each process stores its own copy.
+ * This sends one message per node instead of one per process across the
+ * nodes and works with any mapping of ranks to nodes.
  *
  * \param[in] sendbuf         the source from this process
  * \param[in] sendcount       the number of items to allgather
@@ -141,6 +168,15 @@ t8_gloidx_t        *t8_shmem_array_get_gloidx_array (t8_shmem_array_t array);
 t8_gloidx_t         t8_shmem_array_get_gloidx (t8_shmem_array_t array,
                                                int index);
 
+/** Return the number of bytes that one process uses for a t8_shmem array.
+ * If the array is stored once per node, this is its size divided by the
+ * number of processes of the node, otherwise its full size.
+ * \param [in]          array   The t8_shmem_array
+ * \return                      The number of bytes per process.
+ */
+size_t              t8_shmem_array_get_bytes_per_process (t8_shmem_array_t
+                                                          array);
+
 /** Return a pointer to the data array of a t8_shmem_array.
  * \param [in]          array The t8_shmem_array.
  * \return                    A pointer to the data array of \a array.
@@ -21,6 +21,9 @@
 */
 
 #include "t8_default_common_cxx.hxx"
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -28,6 +31,8 @@ T8_EXTERN_C_BEGIN ();
 /** This class independent function assumes an sc_mempool_t as context.
  * It is suitable as the elem_new callback in \ref t8_eclass_scheme_t.
  * We assume that the mempool has been created with the correct element size.
+ * Inside of an OpenMP parallel region the access to the mempool is serialized,
+ * since a scheme is shared by all threads.
  * \param [in,out] ts_context   An element is allocated in this sc_mempool_t.
  * \param [in]     length       Non-negative number of elements to allocate.
  * \param [in,out] elem         Array of correct size whose members are filled.
@@ -63,6 +68,27 @@ t8_default_scheme_common_c::t8_element_num_corners (const t8_element_t * elem)
   return t8_eclass_num_vertices[eclass];
 }
 
+void
+t8_default_scheme_common_c::t8_element_bounding_box (const t8_element_t *
+                                                     elem, int box[6])
+{
+  int                 first[3], last[3], dim, i;
+
+  if (eclass == T8_ECLASS_PYRAMID) {
+    /* Pyramids may have tets as children, that do not fill the cube */
+    t8_eclass_scheme_c::t8_element_bounding_box (elem, box);
+    return;
+  }
+  /* The first and the last vertex are the opposite corners of the cube */
+  dim = t8_eclass_to_dimension[eclass];
+  t8_element_vertex_coords (elem, 0, first);
+  t8_element_vertex_coords (elem, t8_eclass_num_vertices[eclass] - 1, last);
+  for (i = 0; i < 3; i++) {
+    box[i] = i < dim ? first[i] : 0;
+    box[3 + i] = i < dim ? last[i] : 0;
+  }
+}
+
 void
 t8_default_scheme_common_c::t8_element_new (int length, t8_element_t ** elem)
 {
@@ -86,6 +112,15 @@ t8_default_mempool_alloc (sc_mempool_t * ts_context, int length,
   T8_ASSERT (0 <= length);
   T8_ASSERT (elem != NULL);
 
+#ifdef T8_ENABLE_OPENMP
+  if (omp_in_parallel ()) {
+#pragma omp critical (t8_default_mempool)
+    for (i = 0; i < length; ++i) {
+      elem[i] = (t8_element_t *) sc_mempool_alloc (ts_context);
+    }
+    return;
+  }
+#endif
   for (i = 0; i < length; ++i) {
     elem[i] = (t8_element_t *) sc_mempool_alloc (ts_context);
   }
@@ -101,6 +136,15 @@ t8_default_mempool_free (sc_mempool_t * ts_context, int length,
   T8_ASSERT (0 <= length);
   T8_ASSERT (elem != NULL);
 
+#ifdef T8_ENABLE_OPENMP
+  if (omp_in_parallel ()) {
+#pragma omp critical (t8_default_mempool)
+    for (i = 0; i < length; ++i) {
+      sc_mempool_free (ts_context, elem[i]);
+    }
+    return;
+  }
+#endif
   for (i = 0; i < length; ++i) {
     sc_mempool_free (ts_context, elem[i]);
   }
@@ -43,6 +43,12 @@ public:
   /** Compute the number of corners of a given element. */
   virtual int         t8_element_num_corners (const t8_element_t * elem);
 
+  /** Compute a box in integer coordinates that contains an element.
+   * All default elements except pyramids fill the cube spanned by their
+   * first and their last vertex. */
+  virtual void        t8_element_bounding_box (const t8_element_t * elem,
+                                               int box[6]);
+
   /** Allocate space for a bunch of elements. */
   virtual void        t8_element_new (int length, t8_element_t ** elem);
 
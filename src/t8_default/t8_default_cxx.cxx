@@ -31,6 +31,11 @@
 #include "t8_default_tri_cxx.hxx"
 #include "t8_default_tet_cxx.hxx"
 #include "t8_default_prism_cxx.hxx"
+#include "t8_default_pyramid_cxx.hxx"
+#include "t8_default_tri_compact_cxx.hxx"
+#include "t8_default_tet_compact_cxx.hxx"
+#include "t8_default_quad_hilbert_cxx.hxx"
+#include "t8_default_hex_hilbert_cxx.hxx"
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -50,6 +55,50 @@ t8_scheme_new_default_cxx (void)
   s->eclass_schemes[T8_ECLASS_TRIANGLE] = new t8_default_scheme_tri_c ();
   s->eclass_schemes[T8_ECLASS_TET] = new t8_default_scheme_tet_c ();
   s->eclass_schemes[T8_ECLASS_PRISM] = new t8_default_scheme_prism_c ();
+  s->eclass_schemes[T8_ECLASS_PYRAMID] = new t8_default_scheme_pyramid_c ();
+
+  return s;
+}
+
+t8_scheme_cxx_t    *
+t8_scheme_new_compact_cxx (void)
+{
+  t8_scheme_cxx_t    *s;
+
+  s = T8_ALLOC_ZERO (t8_scheme_cxx_t, 1);
+  t8_refcount_init (&s->rc);
+
+  s->eclass_schemes[T8_ECLASS_VERTEX] = new t8_default_scheme_vertex_c ();
+  s->eclass_schemes[T8_ECLASS_LINE] = new t8_default_scheme_line_c ();
+  s->eclass_schemes[T8_ECLASS_QUAD] = new t8_default_scheme_quad_c ();
+  s->eclass_schemes[T8_ECLASS_HEX] = new t8_default_scheme_hex_c ();
+  s->eclass_schemes[T8_ECLASS_TRIANGLE] =
+    new t8_default_scheme_tri_compact_c ();
+  s->eclass_schemes[T8_ECLASS_TET] = new t8_default_scheme_tet_compact_c ();
+  /* The default prism and pyramid schemes write default triangles
+   * to their faces */
+  s->eclass_schemes[T8_ECLASS_PRISM] = NULL;
+  s->eclass_schemes[T8_ECLASS_PYRAMID] = NULL;
+
+  return s;
+}
+
+t8_scheme_cxx_t    *
+t8_scheme_new_hilbert_cxx (void)
+{
+  t8_scheme_cxx_t    *s;
+
+  s = T8_ALLOC_ZERO (t8_scheme_cxx_t, 1);
+  t8_refcount_init (&s->rc);
+
+  s->eclass_schemes[T8_ECLASS_VERTEX] = new t8_default_scheme_vertex_c ();
+  s->eclass_schemes[T8_ECLASS_LINE] = new t8_default_scheme_line_c ();
+  s->eclass_schemes[T8_ECLASS_QUAD] = new t8_default_scheme_quad_hilbert_c ();
+  s->eclass_schemes[T8_ECLASS_HEX] = new t8_default_scheme_hex_hilbert_c ();
+  s->eclass_schemes[T8_ECLASS_TRIANGLE] = new t8_default_scheme_tri_c ();
+  s->eclass_schemes[T8_ECLASS_TET] = new t8_default_scheme_tet_c ();
+  s->eclass_schemes[T8_ECLASS_PRISM] = new t8_default_scheme_prism_c ();
+  s->eclass_schemes[T8_ECLASS_PYRAMID] = new t8_default_scheme_pyramid_c ();
 
   return s;
 }
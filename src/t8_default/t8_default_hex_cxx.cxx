@@ -639,6 +639,60 @@ t8_default_scheme_hex_c::t8_element_successor (const t8_element_t * elem1,
   p8est_quadrant_set_morton ((p8est_quadrant_t *) elem2, level, id + 1);
 }
 
+void
+t8_default_scheme_hex_c::t8_element_set_linear_id_range (t8_element_t *
+                                                         elements,
+                                                         int level,
+                                                         t8_linearidx_t
+                                                         first_id,
+                                                         t8_locidx_t
+                                                         count)
+{
+  p8est_quadrant_t   *hexs = (p8est_quadrant_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  T8_ASSERT (count <= 0
+             || first_id + count <= ((t8_linearidx_t) 1) << P8EST_DIM * level);
+
+  /* Each hexahedron is computed directly from its morton index */
+  for (ielem = 0; ielem < count; ielem++) {
+    p8est_quadrant_set_morton (hexs + ielem, level, first_id + ielem);
+  }
+}
+
+void
+t8_default_scheme_hex_c::t8_element_level_batch (const t8_element_t *
+                                                 elements,
+                                                 t8_locidx_t count,
+                                                 int *levels)
+{
+  const t8_phex_t    *elems = (const t8_phex_t *) elements;
+  t8_locidx_t         ielem;
+
+  /* Read the levels directly instead of calling a function per element */
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] = elems[ielem].level;
+  }
+}
+
+void
+t8_default_scheme_hex_c::t8_element_get_linear_id_batch (const t8_element_t *
+                                                         elements,
+                                                         t8_locidx_t count,
+                                                         int level,
+                                                         t8_linearidx_t * ids)
+{
+  const t8_phex_t    *elems = (const t8_phex_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    ids[ielem] = p8est_quadrant_linear_id (elems + ielem, level);
+  }
+}
+
 void
 t8_default_scheme_hex_c::t8_element_anchor (const t8_element_t * elem,
                                             int coord[3])
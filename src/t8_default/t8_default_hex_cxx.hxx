@@ -253,6 +253,25 @@ public:
   virtual void        t8_element_successor (const t8_element_t * t,
                                             t8_element_t * s, int level);
 
+/** Initialize count consecutive elements of a uniform refinement */
+  virtual void        t8_element_set_linear_id_range (t8_element_t *
+                                                      elements, int level,
+                                                      t8_linearidx_t
+                                                      first_id,
+                                                      t8_locidx_t count);
+
+/** Compute the levels of count consecutive elements */
+  virtual void        t8_element_level_batch (const t8_element_t *
+                                              elements, t8_locidx_t count,
+                                              int *levels);
+
+/** Compute the linear ids of count consecutive elements */
+  virtual void        t8_element_get_linear_id_batch (const t8_element_t *
+                                                      elements,
+                                                      t8_locidx_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
 /** Get the integer coordinates of the anchor node of an element */
   virtual void        t8_element_anchor (const t8_element_t * elem,
                                          int anchor[3]);
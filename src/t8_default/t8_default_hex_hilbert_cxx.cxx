@@ -0,0 +1,375 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <p8est_bits.h>
+#include "t8_dhilbert_bits.h"
+#include "t8_default_hex_hilbert_cxx.hxx"
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The number of bits of a hexahedron coordinate below the maximum level */
+#define T8_HEX_HILBERT_SHIFT (P8EST_MAXLEVEL - P8EST_QMAXLEVEL)
+
+/* Compute the Hilbert index of a hexahedron at a given level.
+ * If the level is larger than the level of q, this is the index of the
+ * first descendant of q at this level. */
+static t8_linearidx_t
+t8_hex_hilbert_id (const p8est_quadrant_t * q, int level)
+{
+  uint32_t            coords[P8EST_DIM];
+  t8_linearidx_t      id;
+
+  T8_ASSERT (p8est_quadrant_is_inside_root (q));
+  coords[0] = (uint32_t) q->x >> T8_HEX_HILBERT_SHIFT;
+  coords[1] = (uint32_t) q->y >> T8_HEX_HILBERT_SHIFT;
+  coords[2] = (uint32_t) q->z >> T8_HEX_HILBERT_SHIFT;
+  id = t8_dhilbert_index (P8EST_DIM, P8EST_QMAXLEVEL, coords);
+  /* The index of q at its own level are the highest bits */
+  id >>= P8EST_DIM * (P8EST_QMAXLEVEL - q->level);
+  if (level <= q->level) {
+    return id >> P8EST_DIM * (q->level - level);
+  }
+  return id << P8EST_DIM * (level - q->level);
+}
+
+/* Set the coordinates and level of a hexahedron from its Hilbert index */
+static void
+t8_hex_hilbert_set (p8est_quadrant_t * q, int level, t8_linearidx_t id)
+{
+  uint32_t            coords[P8EST_DIM];
+  const p8est_qcoord_t mask = ~(P8EST_QUADRANT_LEN (level) - 1);
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  /* Any point of the hexahedron determines it, we use the first one */
+  t8_dhilbert_coords (P8EST_DIM, P8EST_QMAXLEVEL,
+                      id << P8EST_DIM * (P8EST_QMAXLEVEL - level), coords);
+  q->x = ((p8est_qcoord_t) coords[0] << T8_HEX_HILBERT_SHIFT) & mask;
+  q->y = ((p8est_qcoord_t) coords[1] << T8_HEX_HILBERT_SHIFT) & mask;
+  q->z = ((p8est_qcoord_t) coords[2] << T8_HEX_HILBERT_SHIFT) & mask;
+  q->level = (int8_t) level;
+}
+
+int
+t8_default_scheme_hex_hilbert_c::t8_element_compare (const t8_element_t *
+                                                     elem1,
+                                                     const t8_element_t *
+                                                     elem2)
+{
+  const p8est_quadrant_t *q1 = (const p8est_quadrant_t *) elem1;
+  const p8est_quadrant_t *q2 = (const p8est_quadrant_t *) elem2;
+  t8_linearidx_t      id1, id2;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+
+  /* Compare the first descendants, an ancestor is smaller than its
+   * descendants */
+  id1 = t8_hex_hilbert_id (q1, P8EST_QMAXLEVEL);
+  id2 = t8_hex_hilbert_id (q2, P8EST_QMAXLEVEL);
+  if (id1 != id2) {
+    return id1 < id2 ? -1 : 1;
+  }
+  return (int) q1->level - (int) q2->level;
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_sibling (const t8_element_t *
+                                                     elem, int sibid,
+                                                     t8_element_t * sibling)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p8est_quadrant_t    r;
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (sibling));
+  T8_ASSERT (q->level > 0);
+  T8_ASSERT (0 <= sibid && sibid < P8EST_CHILDREN);
+
+  id = t8_hex_hilbert_id (q, q->level);
+  r = *q;
+  t8_hex_hilbert_set (&r, q->level, (id & ~(t8_linearidx_t) 0x07) | sibid);
+  *(p8est_quadrant_t *) sibling = r;
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_child (const t8_element_t *
+                                                   elem, int childid,
+                                                   t8_element_t * child)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p8est_quadrant_t    r;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (child));
+  T8_ASSERT (q->level < P8EST_QMAXLEVEL);
+  T8_ASSERT (childid >= 0 && childid < P8EST_CHILDREN);
+
+  r = *q;
+  t8_hex_hilbert_set (&r, q->level + 1,
+                      t8_hex_hilbert_id (q, q->level + 1) + childid);
+  T8_ASSERT (p8est_quadrant_is_parent (q, &r));
+  *(p8est_quadrant_t *) child = r;
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_children (const t8_element_t *
+                                                      elem, int length,
+                                                      t8_element_t * c[])
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p8est_quadrant_t    r;
+  t8_linearidx_t      id;
+  int                 i, level;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (length == P8EST_CHILDREN);
+  T8_ASSERT (q->level < P8EST_QMAXLEVEL);
+
+  /* elem may be one of the children, thus we copy it first */
+  r = *q;
+  level = q->level + 1;
+  id = t8_hex_hilbert_id (q, level);
+  for (i = 0; i < P8EST_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid (c[i]));
+    t8_hex_hilbert_set (&r, level, id + i);
+    *(p8est_quadrant_t *) c[i] = r;
+  }
+}
+
+int
+t8_default_scheme_hex_hilbert_c::t8_element_child_id (const t8_element_t *
+                                                      elem)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  if (q->level == 0) {
+    return 0;
+  }
+  return (int) (t8_hex_hilbert_id (q, q->level) & 0x07);
+}
+
+int
+t8_default_scheme_hex_hilbert_c::t8_element_ancestor_id (const t8_element_t
+                                                         * elem, int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= q->level);
+  if (level == 0) {
+    return 0;
+  }
+  return (int) (t8_hex_hilbert_id (q, level) & 0x07);
+}
+
+int
+t8_default_scheme_hex_hilbert_c::t8_element_is_family (t8_element_t ** fam)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) fam[0];
+  t8_linearidx_t      id;
+  int                 i;
+
+#ifdef T8_ENABLE_DEBUG
+  for (i = 0; i < P8EST_CHILDREN; i++) {
+    T8_ASSERT (t8_element_is_valid (fam[i]));
+  }
+#endif
+  if (q->level == 0 || !p8est_quadrant_is_inside_root (q)) {
+    return 0;
+  }
+  /* The children of one parent have consecutive indices,
+   * starting with a multiple of 8 */
+  id = t8_hex_hilbert_id (q, q->level);
+  if ((id & 0x07) != 0) {
+    return 0;
+  }
+  for (i = 1; i < P8EST_CHILDREN; i++) {
+    q = (const p8est_quadrant_t *) fam[i];
+    if (q->level != ((const p8est_quadrant_t *) fam[0])->level
+        || !p8est_quadrant_is_inside_root (q)
+        || t8_hex_hilbert_id (q, q->level) != id + i) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_children_at_face (const
+                                                              t8_element_t *
+                                                              elem, int face,
+                                                              t8_element_t *
+                                                              children[],
+                                                              int
+                                                              num_children,
+                                                              int
+                                                              *child_indices)
+{
+  int                 i;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (num_children == t8_element_num_face_children (elem, face));
+
+  /* The children at a face are ordered as the children of the face, which
+   * are the Morton children at the corners of the face.
+   * We compute the first child last, since elem == children[0] is allowed. */
+  for (i = num_children - 1; i >= 0; i--) {
+    T8_ASSERT (t8_element_is_valid (children[i]));
+    t8_default_scheme_hex_c::t8_element_child (elem,
+                                               p8est_face_corners[face][i],
+                                               children[i]);
+  }
+  if (child_indices != NULL) {
+    for (i = 0; i < num_children; i++) {
+      child_indices[i] = t8_element_child_id (children[i]);
+    }
+  }
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_set_linear_id (t8_element_t *
+                                                           elem, int level,
+                                                           t8_linearidx_t id)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  T8_ASSERT (0 <= id && id < ((t8_linearidx_t) 1) << P8EST_DIM * level);
+
+  t8_hex_hilbert_set ((p8est_quadrant_t *) elem, level, id);
+}
+
+t8_linearidx_t
+  t8_default_scheme_hex_hilbert_c::t8_element_get_linear_id (const
+                                                             t8_element_t *
+                                                             elem, int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  return t8_hex_hilbert_id ((const p8est_quadrant_t *) elem, level);
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_first_descendant (const
+                                                              t8_element_t *
+                                                              elem,
+                                                              t8_element_t *
+                                                              desc,
+                                                              int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (q->level <= level && level <= P8EST_QMAXLEVEL);
+
+  t8_hex_hilbert_set ((p8est_quadrant_t *) desc, level,
+                      t8_hex_hilbert_id (q, level));
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_last_descendant (const
+                                                             t8_element_t *
+                                                             elem,
+                                                             t8_element_t *
+                                                             desc, int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (q->level <= level && level <= P8EST_QMAXLEVEL);
+
+  /* The last descendant is just before the first descendant of the
+   * successor of q */
+  id = t8_hex_hilbert_id (q, q->level) + 1;
+  id <<= P8EST_DIM * (level - q->level);
+  t8_hex_hilbert_set ((p8est_quadrant_t *) desc, level, id - 1);
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_successor (const t8_element_t *
+                                                       elem1,
+                                                       t8_element_t * elem2,
+                                                       int level)
+{
+  p8est_quadrant_t    r;
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  id = t8_hex_hilbert_id ((const p8est_quadrant_t *) elem1, level);
+  T8_ASSERT (id + 1 < ((t8_linearidx_t) 1) << P8EST_DIM * level);
+  r = *(const p8est_quadrant_t *) elem1;
+  t8_hex_hilbert_set (&r, level, id + 1);
+  *(p8est_quadrant_t *) elem2 = r;
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_set_linear_id_range (t8_element_t
+                                                                 * elements,
+                                                                 int level,
+                                                                 t8_linearidx_t
+                                                                 first_id,
+                                                                 t8_locidx_t
+                                                                 count)
+{
+  p8est_quadrant_t   *hexs = (p8est_quadrant_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  T8_ASSERT (count <= 0
+             || first_id + count <= ((t8_linearidx_t) 1) << P8EST_DIM * level);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    t8_hex_hilbert_set (hexs + ielem, level, first_id + ielem);
+  }
+}
+
+void
+t8_default_scheme_hex_hilbert_c::t8_element_get_linear_id_batch (const
+                                                                 t8_element_t
+                                                                 * elements,
+                                                                 t8_locidx_t
+                                                                 count,
+                                                                 int level,
+                                                                 t8_linearidx_t
+                                                                 * ids)
+{
+  const t8_phex_t    *elems = (const t8_phex_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    ids[ielem] = t8_hex_hilbert_id (elems + ielem, level);
+  }
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,113 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_default_hex_hilbert_cxx.hxx
+ * Hexahedra ordered along the Hilbert curve instead of the Morton curve.
+ * The elements are the same p8est_quadrant_t as in the default scheme and
+ * all geometric functions are the default ones. The functions that depend
+ * on the order of the elements, such as the child ids, the linear ids and
+ * the comparison, are reimplemented with \ref t8_dhilbert_index.
+ * The faces of a hexahedron are default quadrilaterals.
+ */
+
+#ifndef T8_DEFAULT_HEX_HILBERT_CXX_HXX
+#define T8_DEFAULT_HEX_HILBERT_CXX_HXX
+
+#include "t8_default_hex_cxx.hxx"
+
+struct t8_default_scheme_hex_hilbert_c:public t8_default_scheme_hex_c
+{
+public:
+  /** Compare two elements in the Hilbert order. */
+  virtual int         t8_element_compare (const t8_element_t * elem1,
+                                          const t8_element_t * elem2);
+
+  /** Compute a specific sibling of a given hexahedron. */
+  virtual void        t8_element_sibling (const t8_element_t * elem,
+                                          int sibid, t8_element_t * sibling);
+
+  /** Construct the child of a given number in the Hilbert order. */
+  virtual void        t8_element_child (const t8_element_t * elem,
+                                        int childid, t8_element_t * child);
+
+  /** Construct all children of a given element in the Hilbert order. */
+  virtual void        t8_element_children (const t8_element_t * elem,
+                                           int length, t8_element_t * c[]);
+
+  /** Return the position of an element among its siblings. */
+  virtual int         t8_element_child_id (const t8_element_t * elem);
+
+  /** Return the child id of the ancestor of an element at a given level. */
+  virtual int         t8_element_ancestor_id (const t8_element_t * elem,
+                                              int level);
+
+  /** Return nonzero if the elements are the children of one parent in
+   * the Hilbert order. */
+  virtual int         t8_element_is_family (t8_element_t ** fam);
+
+  /** Construct the children at a face in the order of the face's children.
+   * The child indices are positions in the Hilbert order. */
+  virtual void        t8_element_children_at_face (const t8_element_t * elem,
+                                                   int face,
+                                                   t8_element_t * children[],
+                                                   int num_children,
+                                                   int *child_indices);
+
+  /** Initialize an element according to its Hilbert index. */
+  virtual void        t8_element_set_linear_id (t8_element_t * elem,
+                                                int level, t8_linearidx_t id);
+
+  /** Compute the Hilbert index of an element. */
+  virtual t8_linearidx_t t8_element_get_linear_id (const
+                                                   t8_element_t *
+                                                   elem, int level);
+
+  /** Compute the first descendant of an element in the Hilbert order. */
+  virtual void        t8_element_first_descendant (const t8_element_t *
+                                                   elem, t8_element_t * desc,
+                                                   int level);
+
+  /** Compute the last descendant of an element in the Hilbert order. */
+  virtual void        t8_element_last_descendant (const t8_element_t *
+                                                  elem, t8_element_t * desc,
+                                                  int level);
+
+  /** Compute the successor of an element in the Hilbert order. */
+  virtual void        t8_element_successor (const t8_element_t * t,
+                                            t8_element_t * s, int level);
+
+  /** Initialize count consecutive elements of a uniform refinement */
+  virtual void        t8_element_set_linear_id_range (t8_element_t *
+                                                      elements, int level,
+                                                      t8_linearidx_t
+                                                      first_id,
+                                                      t8_locidx_t count);
+
+  /** Compute the Hilbert indices of count consecutive elements */
+  virtual void        t8_element_get_linear_id_batch (const t8_element_t *
+                                                      elements,
+                                                      t8_locidx_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+};
+
+#endif /* !T8_DEFAULT_HEX_HILBERT_CXX_HXX */
@@ -0,0 +1,264 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_default_kernels_cxx.hxx
+ * Non-virtual calls to the element functions of the default schemes.
+ * A loop over the elements of one tree, where the element class is fixed,
+ * can be written as a template over the scheme class and run with
+ * \ref t8_default_scheme_dispatch. If the scheme is a default scheme, the
+ * loop is instantiated with its class and the element functions are called
+ * directly instead of through the virtual table. For any other scheme the
+ * loop is instantiated with \ref t8_eclass_scheme_c and uses virtual calls.
+ */
+
+#ifndef T8_DEFAULT_KERNELS_CXX_HXX
+#define T8_DEFAULT_KERNELS_CXX_HXX
+
+#include <typeinfo>
+#include <t8_element_cxx.hxx>
+#include <t8_default/t8_default_vertex_cxx.hxx>
+#include <t8_default/t8_default_line_cxx.hxx>
+#include <t8_default/t8_default_quad_cxx.hxx>
+#include <t8_default/t8_default_tri_cxx.hxx>
+#include <t8_default/t8_default_hex_cxx.hxx>
+#include <t8_default/t8_default_tet_cxx.hxx>
+#include <t8_default/t8_default_prism_cxx.hxx>
+#include <t8_default/t8_default_pyramid_cxx.hxx>
+
+/** Element functions of a scheme class \a TScheme that are called without
+ * virtual dispatch. Each function calls the implementation of \a TScheme
+ * with a qualified name. */
+template < class TScheme > struct t8_default_kernel
+{
+  /** True if the functions are called directly. The default schemes only
+   * read their arguments and write the output element, thus such calls may
+   * be made for different elements concurrently. */
+  static const int    is_direct = 1;
+
+  /** \see t8_eclass_scheme_c::t8_element_level */
+  static int          level (TScheme * ts, const t8_element_t * elem)
+  {
+    return ts->TScheme::t8_element_level (elem);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_child_id */
+  static int          child_id (TScheme * ts, const t8_element_t * elem)
+  {
+    return ts->TScheme::t8_element_child_id (elem);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_num_children */
+  static int          num_children (TScheme * ts, const t8_element_t * elem)
+  {
+    return ts->TScheme::t8_element_num_children (elem);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_is_family */
+  static int          is_family (TScheme * ts, t8_element_t ** fam)
+  {
+    return ts->TScheme::t8_element_is_family (fam);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_compare */
+  static int          compare (TScheme * ts, const t8_element_t * elem1,
+                               const t8_element_t * elem2)
+  {
+    return ts->TScheme::t8_element_compare (elem1, elem2);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_parent */
+  static void         parent (TScheme * ts, const t8_element_t * elem,
+                              t8_element_t * parent)
+  {
+    ts->TScheme::t8_element_parent (elem, parent);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_children */
+  static void         children (TScheme * ts, const t8_element_t * elem,
+                                int length, t8_element_t * c[])
+  {
+    ts->TScheme::t8_element_children (elem, length, c);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_children_batch */
+  static void         children_batch (TScheme * ts,
+                                      const t8_element_t * elements,
+                                      t8_locidx_t count,
+                                      t8_element_t * children)
+  {
+    ts->TScheme::t8_element_children_batch (elements, count, children);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_copy */
+  static void         copy (TScheme * ts, const t8_element_t * source,
+                            t8_element_t * dest)
+  {
+    ts->TScheme::t8_element_copy (source, dest);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_successor */
+  static void         successor (TScheme * ts, const t8_element_t * elem,
+                                 t8_element_t * succ, int level)
+  {
+    ts->TScheme::t8_element_successor (elem, succ, level);
+  }
+
+  /** \see t8_eclass_scheme_c::t8_element_get_linear_id */
+  static t8_linearidx_t linear_id (TScheme * ts, const t8_element_t * elem,
+                                   int level)
+  {
+    return ts->TScheme::t8_element_get_linear_id (elem, level);
+  }
+};
+
+/** The element functions of an arbitrary scheme, called through the
+ * virtual table. */
+template <> struct t8_default_kernel <t8_eclass_scheme_c >
+{
+  static const int    is_direct = 0;
+
+  static int          level (t8_eclass_scheme_c * ts,
+                             const t8_element_t * elem)
+  {
+    return ts->t8_element_level (elem);
+  }
+
+  static int          child_id (t8_eclass_scheme_c * ts,
+                                const t8_element_t * elem)
+  {
+    return ts->t8_element_child_id (elem);
+  }
+
+  static int          num_children (t8_eclass_scheme_c * ts,
+                                    const t8_element_t * elem)
+  {
+    return ts->t8_element_num_children (elem);
+  }
+
+  static int          is_family (t8_eclass_scheme_c * ts,
+                                 t8_element_t ** fam)
+  {
+    return ts->t8_element_is_family (fam);
+  }
+
+  static int          compare (t8_eclass_scheme_c * ts,
+                               const t8_element_t * elem1,
+                               const t8_element_t * elem2)
+  {
+    return ts->t8_element_compare (elem1, elem2);
+  }
+
+  static void         parent (t8_eclass_scheme_c * ts,
+                              const t8_element_t * elem,
+                              t8_element_t * parent)
+  {
+    ts->t8_element_parent (elem, parent);
+  }
+
+  static void         children (t8_eclass_scheme_c * ts,
+                                const t8_element_t * elem, int length,
+                                t8_element_t * c[])
+  {
+    ts->t8_element_children (elem, length, c);
+  }
+
+  static void         children_batch (t8_eclass_scheme_c * ts,
+                                      const t8_element_t * elements,
+                                      t8_locidx_t count,
+                                      t8_element_t * children)
+  {
+    ts->t8_element_children_batch (elements, count, children);
+  }
+
+  static void         copy (t8_eclass_scheme_c * ts,
+                            const t8_element_t * source, t8_element_t * dest)
+  {
+    ts->t8_element_copy (source, dest);
+  }
+
+  static void         successor (t8_eclass_scheme_c * ts,
+                                 const t8_element_t * elem,
+                                 t8_element_t * succ, int level)
+  {
+    ts->t8_element_successor (elem, succ, level);
+  }
+
+  static t8_linearidx_t linear_id (t8_eclass_scheme_c * ts,
+                                   const t8_element_t * elem, int level)
+  {
+    return ts->t8_element_get_linear_id (elem, level);
+  }
+};
+
+/* Run KERNEL with the scheme TS cast to TYPE if TS is exactly of this type.
+ * A scheme derived from TYPE, such as the Hilbert schemes, may override
+ * the functions that the kernel would call directly, thus it is excluded. */
+#define T8_DEFAULT_DISPATCH_CASE(TS, ECLASS, TYPE, KERNEL) \
+  case ECLASS: \
+    if (typeid (*(TS)) == typeid (TYPE)) { \
+      (KERNEL).run (static_cast<TYPE *> (TS)); \
+      return; \
+    } \
+    break
+
+/** Run a templated kernel with the scheme of a tree.
+ * This should be called once per tree, since casting the scheme has
+ * a (small) cost.
+ * \param [in] ts       The scheme of the elements of a tree.
+ * \param [in,out] kernel An object with a member function template
+ *                      template <class TScheme> void run (TScheme * ts).
+ *                      If \a ts is a default scheme, run is called with
+ *                      \a ts cast to its class, otherwise, also for classes
+ *                      derived from a default scheme, with
+ *                      \ref t8_eclass_scheme_c. Inside run, the elements
+ *                      should be accessed with \ref t8_default_kernel.
+ */
+template < class TKernel > void
+t8_default_scheme_dispatch (t8_eclass_scheme_c * ts, TKernel & kernel)
+{
+  switch (ts->eclass) {
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_VERTEX,
+                              t8_default_scheme_vertex_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_LINE,
+                              t8_default_scheme_line_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_QUAD,
+                              t8_default_scheme_quad_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_TRIANGLE,
+                              t8_default_scheme_tri_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_HEX,
+                              t8_default_scheme_hex_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_TET,
+                              t8_default_scheme_tet_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_PRISM,
+                              t8_default_scheme_prism_c, kernel);
+    T8_DEFAULT_DISPATCH_CASE (ts, T8_ECLASS_PYRAMID,
+                              t8_default_scheme_pyramid_c, kernel);
+  default:
+    break;
+  }
+  /* Not a default scheme */
+  kernel.run (ts);
+}
+
+#undef T8_DEFAULT_DISPATCH_CASE
+
+#endif /* !T8_DEFAULT_KERNELS_CXX_HXX */
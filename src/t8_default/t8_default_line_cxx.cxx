@@ -314,6 +314,26 @@ t8_default_scheme_line_c::t8_element_successor (const t8_element_t * elem1,
                       (t8_default_line_t *) elem2, level);
 }
 
+void
+t8_default_scheme_line_c::t8_element_set_linear_id_range (t8_element_t *
+                                                          elements,
+                                                          int level,
+                                                          t8_linearidx_t
+                                                          first_id,
+                                                          t8_locidx_t
+                                                          count)
+{
+  t8_default_line_t  *lines = (t8_default_line_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DLINE_MAXLEVEL);
+  T8_ASSERT (count <= 0 || first_id + count <= ((t8_linearidx_t) 1) << level);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    t8_dline_init_linear_id (lines + ielem, level, first_id + ielem);
+  }
+}
+
 void
 t8_default_scheme_line_c::t8_element_first_descendant (const t8_element_t *
                                                        elem,
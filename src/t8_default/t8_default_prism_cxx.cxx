@@ -24,6 +24,7 @@
 #include "t8_default_prism_cxx.hxx"
 #include "t8_dprism_bits.h"
 #include "t8_dprism.h"
+#include "t8_default_refine_tables_cxx.hxx"
 
 typedef t8_dprism_t t8_default_prism_t;
 
@@ -344,6 +345,65 @@ t8_default_scheme_prism_c::t8_element_successor (const t8_element_t * t,
                        (t8_default_prism_t *) s, level);
 }
 
+void
+t8_default_scheme_prism_c::t8_element_set_linear_id_range (t8_element_t *
+                                                           elements,
+                                                           int level,
+                                                           t8_linearidx_t
+                                                           first_id,
+                                                           t8_locidx_t
+                                                           count)
+{
+  t8_default_prism_t *prisms = (t8_default_prism_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
+
+  if (count <= 0) {
+    return;
+  }
+  /* Computing the successor is cheaper than computing an element
+   * from its linear id */
+  t8_dprism_init_linear_id (prisms, level, first_id);
+  for (ielem = 1; ielem < count; ielem++) {
+    t8_dprism_successor (prisms + ielem - 1, prisms + ielem, level);
+  }
+}
+
+void
+t8_default_scheme_prism_c::t8_element_children_batch (const t8_element_t *
+                                                      elements,
+                                                      t8_locidx_t count,
+                                                      t8_element_t * children)
+{
+  const t8_default_prism_t *elems = (const t8_default_prism_t *) elements;
+  t8_default_prism_t *child = (t8_default_prism_t *) children;
+  t8_locidx_t         ielem;
+  t8_dtri_coord_t     h_tri;
+  t8_dline_coord_t    h_line;
+  int                 ichild, type, tri_child;
+
+  /* The lower two bits of a child id are the triangle child id,
+   * the third bit is the line child id. */
+  for (ielem = 0; ielem < count; ielem++) {
+    T8_ASSERT (elems[ielem].tri.level < T8_DPRISM_MAXLEVEL);
+    T8_ASSERT (elems[ielem].line.level == elems[ielem].tri.level);
+    h_tri = T8_DTRI_LEN (elems[ielem].tri.level + 1);
+    h_line = T8_DLINE_LEN (elems[ielem].line.level + 1);
+    type = elems[ielem].tri.type;
+    for (ichild = 0; ichild < T8_DPRISM_CHILDREN; ichild++, child++) {
+      tri_child = ichild & 3;
+      *child = elems[ielem];
+      child->tri.x += t8_dtri_child_anchor_offset[type][tri_child][0] * h_tri;
+      child->tri.y += t8_dtri_child_anchor_offset[type][tri_child][1] * h_tri;
+      child->tri.type = t8_dtri_child_type[type][tri_child];
+      child->tri.level++;
+      child->line.x += (ichild >> 2) * h_line;
+      child->line.level++;
+    }
+  }
+}
+
 void
 t8_default_scheme_prism_c::t8_element_first_descendant (const t8_element_t *
                                                         elem,
@@ -0,0 +1,528 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "t8_default_common_cxx.hxx"
+#include "t8_default_pyramid_cxx.hxx"
+#include "t8_dpyramid_bits.h"
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+typedef t8_dpyramid_t t8_default_pyramid_t;
+
+int
+t8_default_scheme_pyramid_c::t8_element_maxlevel (void)
+{
+  return T8_DPYRAMID_MAXLEVEL;
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_level (const t8_element_t * elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_get_level ((const t8_dpyramid_t *) elem);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_copy (const t8_element_t * source,
+                                              t8_element_t * dest)
+{
+  T8_ASSERT (t8_element_is_valid (source));
+  T8_ASSERT (t8_element_is_valid (dest));
+  t8_dpyramid_copy ((const t8_dpyramid_t *) source, (t8_dpyramid_t *) dest);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_compare (const t8_element_t * elem1,
+                                                 const t8_element_t * elem2)
+{
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+  return t8_dpyramid_compare ((const t8_dpyramid_t *) elem1,
+                              (const t8_dpyramid_t *) elem2);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_parent (const t8_element_t * elem,
+                                                t8_element_t * parent)
+{
+  const t8_default_pyramid_t *p = (const t8_default_pyramid_t *) elem;
+  t8_default_pyramid_t *par = (t8_default_pyramid_t *) parent;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (parent));
+  t8_dpyramid_parent (p, par);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_sibling (const t8_element_t * elem,
+                                                 int sibid,
+                                                 t8_element_t * sibling)
+{
+  const t8_default_pyramid_t *p = (const t8_default_pyramid_t *) elem;
+  t8_default_pyramid_t *s = (t8_default_pyramid_t *) sibling;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (sibling));
+  t8_dpyramid_sibling (p, sibid, s);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_num_corners (const t8_element_t *
+                                                     elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_num_corners ((const t8_dpyramid_t *) elem);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_num_faces (const t8_element_t * elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_num_faces ((const t8_dpyramid_t *) elem);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_max_num_faces (const t8_element_t *
+                                                       elem)
+{
+  return T8_DPYRAMID_FACES;
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_num_children (const t8_element_t *
+                                                      elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_num_children ((const t8_dpyramid_t *) elem);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_num_face_children (const t8_element_t
+                                                           * elem, int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return T8_DPYRAMID_FACE_CHILDREN;
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_get_face_corner (const t8_element_t *
+                                                         element, int face,
+                                                         int corner)
+{
+  T8_ASSERT (t8_element_is_valid (element));
+  return t8_dpyramid_get_face_corner ((const t8_dpyramid_t *) element, face,
+                                      corner);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_child (const t8_element_t * elem,
+                                               int childid,
+                                               t8_element_t * child)
+{
+  const t8_default_pyramid_t *p = (const t8_default_pyramid_t *) elem;
+  t8_default_pyramid_t *c = (t8_default_pyramid_t *) child;
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (child));
+
+  t8_dpyramid_child (p, childid, c);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_children (const t8_element_t * elem,
+                                                  int length,
+                                                  t8_element_t * c[])
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (length == t8_element_num_children (elem));
+#ifdef T8_ENABLE_DEBUG
+  int                 i;
+  for (i = 0; i < length; i++) {
+    T8_ASSERT (t8_element_is_valid (c[i]));
+  }
+#endif
+  t8_dpyramid_childrenpv ((const t8_dpyramid_t *) elem, length,
+                          (t8_dpyramid_t **) c);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_child_id (const t8_element_t * elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_child_id ((const t8_dpyramid_t *) elem);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_ancestor_id (const t8_element_t *
+                                                     elem, int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_ancestor_id ((const t8_dpyramid_t *) elem, level);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_is_family (t8_element_t ** fam)
+{
+#ifdef T8_ENABLE_DEBUG
+  /* We cannot check all elements, since we do not know
+   * how many elements fam contains. */
+  T8_ASSERT (t8_element_is_valid (fam[0]));
+#endif
+  return t8_dpyramid_is_familypv ((t8_dpyramid_t **) fam);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_nca (const t8_element_t * elem1,
+                                             const t8_element_t * elem2,
+                                             t8_element_t * nca)
+{
+  const t8_default_pyramid_t *p1 = (const t8_default_pyramid_t *) elem1;
+  const t8_default_pyramid_t *p2 = (const t8_default_pyramid_t *) elem2;
+  t8_default_pyramid_t *c = (t8_default_pyramid_t *) nca;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+  t8_dpyramid_nearest_common_ancestor (p1, p2, c);
+}
+
+t8_eclass_t
+  t8_default_scheme_pyramid_c::t8_element_face_class (const t8_element_t *
+                                                      elem, int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_dpyramid_face_class ((const t8_dpyramid_t *) elem, face);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_children_at_face (const t8_element_t
+                                                          * elem, int face,
+                                                          t8_element_t *
+                                                          children[],
+                                                          int num_children,
+                                                          int *child_indices)
+{
+  const t8_dpyramid_t *p = (const t8_dpyramid_t *) elem;
+  t8_dpyramid_t     **c = (t8_dpyramid_t **) children;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  T8_ASSERT (num_children == T8_DPYRAMID_FACE_CHILDREN);
+
+#ifdef T8_ENABLE_DEBUG
+  /* debugging check that all children elements are valid */
+  {
+    int                 i;
+    for (i = 0; i < num_children; i++) {
+      T8_ASSERT (t8_element_is_valid (children[i]));
+    }
+  }
+#endif
+
+  t8_dpyramid_children_at_face (p, face, c, num_children, child_indices);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_face_child_face (const t8_element_t *
+                                                         elem, int face,
+                                                         int face_child)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  T8_ASSERT (0 <= face_child && face_child < T8_DPYRAMID_FACE_CHILDREN);
+  return t8_dpyramid_face_child_face ((const t8_dpyramid_t *) elem, face,
+                                      face_child);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_face_parent_face (const t8_element_t
+                                                          * elem, int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  return t8_dpyramid_face_parent_face ((const t8_dpyramid_t *) elem, face);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_tree_face (const t8_element_t * elem,
+                                                   int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  return t8_dpyramid_tree_face ((const t8_dpyramid_t *) elem, face);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_extrude_face (const t8_element_t *
+                                                      face,
+                                                      const
+                                                      t8_eclass_scheme_c *
+                                                      face_scheme,
+                                                      t8_element_t * elem,
+                                                      int root_face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= root_face && root_face < T8_DPYRAMID_FACES);
+  /* The base of the root pyramid is a quad, all other faces are triangles */
+  T8_ASSERT (face_scheme->eclass == (root_face == T8_DPYRAMID_FACES - 1 ?
+                                     T8_ECLASS_QUAD : T8_ECLASS_TRIANGLE));
+  T8_ASSERT (face_scheme->t8_element_is_valid (face));
+  return t8_dpyramid_extrude_face (face, (t8_dpyramid_t *) elem, root_face);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_first_descendant_face (const
+                                                               t8_element_t *
+                                                               elem, int face,
+                                                               t8_element_t *
+                                                               first_desc,
+                                                               int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_first_descendant_face ((const t8_dpyramid_t *) elem, face,
+                                     (t8_dpyramid_t *) first_desc, level);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_last_descendant_face (const
+                                                              t8_element_t *
+                                                              elem, int face,
+                                                              t8_element_t *
+                                                              last_desc,
+                                                              int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_last_descendant_face ((const t8_dpyramid_t *) elem, face,
+                                    (t8_dpyramid_t *) last_desc, level);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_boundary_face (const t8_element_t *
+                                                       elem, int face,
+                                                       t8_element_t *
+                                                       boundary,
+                                                       const
+                                                       t8_eclass_scheme_c *
+                                                       boundary_scheme)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  T8_ASSERT (t8_element_is_root_boundary (elem, face));
+  /* The boundary of a quadrilateral face is a quad, the other faces
+   * are triangles */
+  T8_ASSERT (boundary_scheme->eclass == t8_element_face_class (elem, face));
+  T8_ASSERT (boundary_scheme->t8_element_is_valid (boundary));
+  t8_dpyramid_boundary_face ((const t8_dpyramid_t *) elem, face, boundary);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_boundary (const t8_element_t * elem,
+                                                  int min_dim, int length,
+                                                  t8_element_t ** boundary)
+{
+  SC_ABORT ("Not implemented\n");
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_is_root_boundary (const t8_element_t
+                                                          * elem, int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  return t8_dpyramid_is_root_boundary ((const t8_dpyramid_t *) elem, face);
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_face_neighbor_inside (const
+                                                              t8_element_t *
+                                                              elem,
+                                                              t8_element_t *
+                                                              neigh, int face,
+                                                              int *neigh_face)
+{
+  const t8_dpyramid_t *p = (const t8_dpyramid_t *) elem;
+  t8_dpyramid_t      *n = (t8_dpyramid_t *) neigh;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (neigh));
+  T8_ASSERT (0 <= face && face < t8_element_num_faces (elem));
+  T8_ASSERT (neigh_face != NULL);
+  *neigh_face = t8_dpyramid_face_neighbour (p, face, n);
+  /* return true if neigh is inside the root */
+  return t8_dpyramid_is_inside_root (n);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_set_linear_id (t8_element_t * elem,
+                                                       int level,
+                                                       t8_linearidx_t id)
+{
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  T8_ASSERT (t8_element_is_valid (elem));
+
+  t8_dpyramid_init_linear_id ((t8_default_pyramid_t *) elem, level, id);
+}
+
+t8_linearidx_t
+  t8_default_scheme_pyramid_c::t8_element_get_linear_id (const t8_element_t *
+                                                         elem, int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+
+  return t8_dpyramid_linear_id ((const t8_default_pyramid_t *) elem, level);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_successor (const t8_element_t * elem1,
+                                                   t8_element_t * elem2,
+                                                   int level)
+{
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+
+  t8_dpyramid_successor ((const t8_default_pyramid_t *) elem1,
+                         (t8_default_pyramid_t *) elem2, level);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_first_descendant (const t8_element_t
+                                                          * elem,
+                                                          t8_element_t * desc,
+                                                          int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_first_descendant ((const t8_dpyramid_t *) elem,
+                                (t8_dpyramid_t *) desc, level);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_last_descendant (const t8_element_t *
+                                                         elem,
+                                                         t8_element_t * desc,
+                                                         int level)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (t8_element_is_valid (desc));
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_last_descendant ((const t8_dpyramid_t *) elem,
+                               (t8_dpyramid_t *) desc, level);
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_anchor (const t8_element_t * elem,
+                                                int anchor[3])
+{
+  const t8_dpyramid_t *p = (const t8_dpyramid_t *) elem;
+  T8_ASSERT (t8_element_is_valid (elem));
+
+  anchor[0] = p->pyramid.x;
+  anchor[1] = p->pyramid.y;
+  anchor[2] = p->pyramid.z;
+}
+
+int
+t8_default_scheme_pyramid_c::t8_element_root_len (const t8_element_t * elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return T8_DPYRAMID_ROOT_LEN;
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_vertex_coords (const t8_element_t *
+                                                       t, int vertex,
+                                                       int coords[])
+{
+  T8_ASSERT (t8_element_is_valid (t));
+  t8_dpyramid_compute_coords ((const t8_default_pyramid_t *) t, vertex,
+                              coords);
+}
+
+#ifdef T8_ENABLE_DEBUG
+/* *INDENT-OFF* */
+/* indent bug, indent adds a second "const" modifier */
+int
+t8_default_scheme_pyramid_c::t8_element_is_valid (const t8_element_t * t) const
+/* *INDENT-ON* */
+
+{
+  return t8_dpyramid_is_valid ((const t8_dpyramid_t *) t);
+}
+#endif
+
+void
+t8_default_scheme_pyramid_c::t8_element_new (int length, t8_element_t ** elem)
+{
+  /* allocate memory for a pyramid */
+  t8_default_scheme_common_c::t8_element_new (length, elem);
+
+  /* in debug mode, set sensible default values. */
+#ifdef T8_ENABLE_DEBUG
+  {
+    int                 i;
+    for (i = 0; i < length; i++) {
+      t8_element_init (1, elem[i], 0);
+    }
+  }
+#endif
+}
+
+void
+t8_default_scheme_pyramid_c::t8_element_init (int length, t8_element_t * elem,
+                                              int new_called)
+{
+#ifdef T8_ENABLE_DEBUG
+  if (!new_called) {
+    int                 i;
+    t8_dpyramid_t      *pyramids = (t8_dpyramid_t *) elem;
+    for (i = 0; i < length; i++) {
+      t8_dpyramid_init (pyramids + i);
+    }
+  }
+#endif
+}
+
+ /* Constructor */
+t8_default_scheme_pyramid_c::t8_default_scheme_pyramid_c (void)
+{
+  eclass = T8_ECLASS_PYRAMID;
+  element_size = sizeof (t8_dpyramid_t);
+  ts_context = sc_mempool_new (element_size);
+}
+
+ /* Destructor */
+t8_default_scheme_pyramid_c::~t8_default_scheme_pyramid_c ()
+{
+  /* This destructor is empty since the destructor of the
+   * default_common scheme is called automatically and it
+   * suffices to destroy the quad_scheme.
+   * However we need to provide an implementation of the destructor
+   * and hence this empty function. */
+}
+
+T8_EXTERN_C_END ();
@@ -336,6 +336,61 @@ t8_default_scheme_quad_c::t8_element_successor (const t8_element_t * elem1,
                             (p4est_quadrant_t *) elem2);
 }
 
+void
+t8_default_scheme_quad_c::t8_element_set_linear_id_range (t8_element_t *
+                                                          elements,
+                                                          int level,
+                                                          t8_linearidx_t
+                                                          first_id,
+                                                          t8_locidx_t
+                                                          count)
+{
+  p4est_quadrant_t   *quads = (p4est_quadrant_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+  T8_ASSERT (count <= 0
+             || first_id + count <= ((t8_linearidx_t) 1) << P4EST_DIM * level);
+
+  /* Each quadrant is computed directly from its morton index */
+  for (ielem = 0; ielem < count; ielem++) {
+    p4est_quadrant_set_morton (quads + ielem, level, first_id + ielem);
+    T8_QUAD_SET_TDIM (quads + ielem, 2);
+  }
+}
+
+void
+t8_default_scheme_quad_c::t8_element_level_batch (const t8_element_t *
+                                                  elements,
+                                                  t8_locidx_t count,
+                                                  int *levels)
+{
+  const t8_pquad_t   *elems = (const t8_pquad_t *) elements;
+  t8_locidx_t         ielem;
+
+  /* Read the levels directly instead of calling a function per element */
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] = elems[ielem].level;
+  }
+}
+
+void
+t8_default_scheme_quad_c::t8_element_get_linear_id_batch (const t8_element_t *
+                                                          elements,
+                                                          t8_locidx_t count,
+                                                          int level,
+                                                          t8_linearidx_t * ids)
+{
+  const t8_pquad_t   *elems = (const t8_pquad_t *) elements;
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    ids[ielem] = p4est_quadrant_linear_id (elems + ielem, level);
+  }
+}
+
 void
 t8_default_scheme_quad_c::t8_element_nca (const t8_element_t * elem1,
                                           const t8_element_t * elem2,
@@ -692,6 +747,74 @@ t8_default_scheme_quad_c::t8_element_boundary_face (const t8_element_t * elem,
           ((int64_t) T8_DLINE_ROOT_LEN) / P4EST_ROOT_LEN);
 }
 
+int
+t8_default_scheme_quad_c::t8_element_face_neighbor_across_tree (const
+                                                                t8_element_t *
+                                                                elem,
+                                                                int face,
+                                                                t8_eclass_scheme_c
+                                                                *
+                                                                boundary_scheme,
+                                                                int
+                                                                orientation,
+                                                                int sign,
+                                                                int
+                                                                is_smaller_face,
+                                                                t8_eclass_scheme_c
+                                                                *
+                                                                neigh_scheme,
+                                                                t8_element_t *
+                                                                neigh,
+                                                                int
+                                                                neigh_root_face)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  p4est_quadrant_t   *n = (p4est_quadrant_t *) neigh;
+  p4est_qcoord_t      t;
+
+  if (neigh_scheme->eclass != T8_ECLASS_QUAD) {
+    /* The neighbor tree is a triangle, we use the boundary line */
+    return t8_eclass_scheme::t8_element_face_neighbor_across_tree
+      (elem, face, boundary_scheme, orientation, sign, is_smaller_face,
+       neigh_scheme, neigh, neigh_root_face);
+  }
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (neigh_scheme->t8_element_is_valid (neigh));
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (0 <= neigh_root_face && neigh_root_face < P4EST_FACES);
+  T8_ASSERT (orientation == 0 || orientation == 1);
+
+  /* The coordinate along the face, as in t8_element_boundary_face */
+  t = face >> 1 ? q->x : q->y;
+  if (orientation) {
+    /* The line is reversed, as in t8_dline_transform_face */
+    t = P4EST_ROOT_LEN - t - P4EST_QUADRANT_LEN (q->level);
+  }
+  /* Place the quadrant at the neighbor face, as in t8_element_extrude_face */
+  n->level = q->level;
+  switch (neigh_root_face) {
+  case 0:
+    n->x = 0;
+    n->y = t;
+    break;
+  case 1:
+    n->x = P4EST_LAST_OFFSET (n->level);
+    n->y = t;
+    break;
+  case 2:
+    n->x = t;
+    n->y = 0;
+    break;
+  case 3:
+    n->x = t;
+    n->y = P4EST_LAST_OFFSET (n->level);
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  return neigh_root_face;
+}
+
 void
 t8_default_scheme_quad_c::t8_element_boundary (const t8_element_t * elem,
                                                int min_dim, int length,
@@ -240,6 +240,24 @@ public:
                                                 const t8_eclass_scheme_c *
                                                 boundary_scheme);
 
+/** Construct the face neighbor of a quadrant in a neighboring quad tree
+ *  without a temporary line element. */
+  virtual int         t8_element_face_neighbor_across_tree (const
+                                                            t8_element_t *
+                                                            elem, int face,
+                                                            t8_eclass_scheme_c
+                                                            * boundary_scheme,
+                                                            int orientation,
+                                                            int sign,
+                                                            int
+                                                            is_smaller_face,
+                                                            t8_eclass_scheme_c
+                                                            * neigh_scheme,
+                                                            t8_element_t *
+                                                            neigh,
+                                                            int
+                                                            neigh_root_face);
+
 /** Construct all codimension-one boundary elements of a given element. */
   virtual void        t8_element_boundary (const t8_element_t * elem,
                                            int min_dim, int length,
@@ -288,6 +306,25 @@ public:
   virtual void        t8_element_successor (const t8_element_t * t,
                                             t8_element_t * s, int level);
 
+/** Initialize count consecutive elements of a uniform refinement */
+  virtual void        t8_element_set_linear_id_range (t8_element_t *
+                                                      elements, int level,
+                                                      t8_linearidx_t
+                                                      first_id,
+                                                      t8_locidx_t count);
+
+/** Compute the levels of count consecutive elements */
+  virtual void        t8_element_level_batch (const t8_element_t *
+                                              elements, t8_locidx_t count,
+                                              int *levels);
+
+/** Compute the linear ids of count consecutive elements */
+  virtual void        t8_element_get_linear_id_batch (const t8_element_t *
+                                                      elements,
+                                                      t8_locidx_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
 /** Get the integer coordinates of the anchor node of an element */
   virtual void        t8_element_anchor (const t8_element_t * elem,
                                          int anchor[3]);
@@ -0,0 +1,169 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_default_refine_tables_cxx.hxx
+ * Lookup tables for the refinement of one element of the default schemes.
+ * The children of an element only differ by offsets that are fixed per
+ * child id and parent type. We store
+ *  - the anchor offset and type of each child of a triangle and a tet, and
+ *  - for each corner of each child the set of parent corners whose average
+ *    is this child corner.
+ * Children are numbered as in \ref t8_eclass_scheme_c::t8_element_child and
+ * corners as in \ref t8_eclass_scheme_c::t8_element_vertex_coords.
+ * Since every child corner is a parent corner or the midpoint of an edge,
+ * a face or the volume of the parent, the corner averages are exact for
+ * the affine and multilinear maps of the trees. Thus the coordinates of
+ * all children of an element follow from its corner coordinates by
+ * additions only.
+ */
+
+#ifndef T8_DEFAULT_REFINE_TABLES_CXX_HXX
+#define T8_DEFAULT_REFINE_TABLES_CXX_HXX
+
+#include <t8_eclass.h>
+
+/** The anchor offset of the children of a triangle in units of the
+ * child length, indexed by parent type, child id and coordinate. */
+constexpr int8_t    t8_dtri_child_anchor_offset[2][4][2] = {
+  {{0, 0}, {1, 0}, {1, 0}, {1, 1}},
+  {{0, 0}, {0, 1}, {0, 1}, {1, 1}}
+};
+
+/** The type of the children of a triangle, indexed by parent type and
+ * child id. This is \ref t8_dtri_type_of_child_morton. */
+constexpr int8_t    t8_dtri_child_type[2][4] = {
+  {0, 0, 1, 0},
+  {1, 0, 1, 1}
+};
+
+/** The anchor offset of the children of a tet in units of the child
+ * length, indexed by parent type, child id and coordinate. */
+constexpr int8_t    t8_dtet_child_anchor_offset[6][8][3] = {
+  {{0, 0, 0}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0},
+   {1, 0, 1}, {1, 0, 1}, {1, 0, 1}, {1, 1, 1}},
+  {{0, 0, 0}, {1, 0, 0}, {1, 0, 0}, {1, 0, 0},
+   {1, 1, 0}, {1, 1, 0}, {1, 1, 0}, {1, 1, 1}},
+  {{0, 0, 0}, {0, 1, 0}, {0, 1, 0}, {0, 1, 0},
+   {1, 1, 0}, {1, 1, 0}, {1, 1, 0}, {1, 1, 1}},
+  {{0, 0, 0}, {0, 1, 0}, {0, 1, 0}, {0, 1, 0},
+   {0, 1, 1}, {0, 1, 1}, {0, 1, 1}, {1, 1, 1}},
+  {{0, 0, 0}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1},
+   {0, 1, 1}, {0, 1, 1}, {0, 1, 1}, {1, 1, 1}},
+  {{0, 0, 0}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1},
+   {1, 0, 1}, {1, 0, 1}, {1, 0, 1}, {1, 1, 1}}
+};
+
+/** The type of the children of a tet, indexed by parent type and
+ * child id. This is \ref t8_dtet_type_of_child_morton. */
+constexpr int8_t    t8_dtet_child_type[6][8] = {
+  {0, 0, 4, 5, 0, 1, 2, 0},
+  {1, 1, 2, 3, 0, 1, 5, 1},
+  {2, 0, 1, 2, 2, 3, 4, 2},
+  {3, 3, 4, 5, 1, 2, 3, 3},
+  {4, 2, 3, 4, 0, 4, 5, 4},
+  {5, 0, 1, 5, 3, 4, 5, 5}
+};
+
+/* The corner tables below store for each child and corner a bit mask of
+ * parent corners. Bit p is set if parent corner p contributes to the
+ * average. */
+
+/** The child corners of a line, indexed by child id and corner. */
+constexpr uint8_t   t8_refine_line_child_corners[2][2] = {
+  {1, 3}, {3, 2}
+};
+
+/** The child corners of a quad, indexed by child id and corner. */
+constexpr uint8_t   t8_refine_quad_child_corners[4][4] = {
+  {1, 3, 5, 15}, {3, 2, 15, 10}, {5, 15, 4, 12}, {15, 10, 12, 8}
+};
+
+/** The child corners of a hex, indexed by child id and corner. */
+constexpr uint8_t   t8_refine_hex_child_corners[8][8] = {
+  {1, 3, 5, 15, 17, 51, 85, 255},
+  {3, 2, 15, 10, 51, 34, 255, 170},
+  {5, 15, 4, 12, 85, 255, 68, 204},
+  {15, 10, 12, 8, 255, 170, 204, 136},
+  {17, 51, 85, 255, 16, 48, 80, 240},
+  {51, 34, 255, 170, 48, 32, 240, 160},
+  {85, 255, 68, 204, 80, 240, 64, 192},
+  {255, 170, 204, 136, 240, 160, 192, 128}
+};
+
+/** The child corners of a triangle, indexed by parent type, child id
+ * and corner. */
+constexpr uint8_t   t8_refine_tri_child_corners[2][4][3] = {
+  {{1, 3, 5}, {3, 2, 6}, {3, 5, 6}, {5, 6, 4}},
+  {{1, 3, 5}, {3, 5, 6}, {3, 2, 6}, {5, 6, 4}}
+};
+
+/** The child corners of a tet, indexed by parent type, child id
+ * and corner. */
+constexpr uint8_t   t8_refine_tet_child_corners[6][8][4] = {
+  {{1, 3, 5, 9}, {3, 2, 6, 10}, {3, 5, 9, 10}, {3, 5, 6, 10},
+   {5, 6, 4, 12}, {5, 6, 10, 12}, {5, 9, 10, 12}, {9, 10, 12, 8}},
+  {{1, 3, 5, 9}, {3, 2, 6, 10}, {3, 5, 6, 10}, {3, 5, 9, 10},
+   {5, 6, 10, 12}, {5, 6, 4, 12}, {5, 9, 10, 12}, {9, 10, 12, 8}},
+  {{1, 3, 5, 9}, {3, 5, 9, 10}, {3, 5, 6, 10}, {3, 2, 6, 10},
+   {5, 6, 4, 12}, {5, 6, 10, 12}, {5, 9, 10, 12}, {9, 10, 12, 8}},
+  {{1, 3, 5, 9}, {3, 2, 6, 10}, {3, 5, 6, 10}, {3, 5, 9, 10},
+   {5, 9, 10, 12}, {5, 6, 10, 12}, {5, 6, 4, 12}, {9, 10, 12, 8}},
+  {{1, 3, 5, 9}, {3, 5, 9, 10}, {3, 5, 6, 10}, {3, 2, 6, 10},
+   {5, 9, 10, 12}, {5, 6, 4, 12}, {5, 6, 10, 12}, {9, 10, 12, 8}},
+  {{1, 3, 5, 9}, {3, 5, 6, 10}, {3, 5, 9, 10}, {3, 2, 6, 10},
+   {5, 9, 10, 12}, {5, 6, 10, 12}, {5, 6, 4, 12}, {9, 10, 12, 8}}
+};
+
+/** The child corners of a prism, indexed by the type of its triangle,
+ * child id and corner. */
+constexpr uint8_t   t8_refine_prism_child_corners[2][8][6] = {
+  {{1, 3, 5, 9, 27, 45}, {3, 2, 6, 27, 18, 54},
+   {3, 5, 6, 27, 45, 54}, {5, 6, 4, 45, 54, 36},
+   {9, 27, 45, 8, 24, 40}, {27, 18, 54, 24, 16, 48},
+   {27, 45, 54, 24, 40, 48}, {45, 54, 36, 40, 48, 32}},
+  {{1, 3, 5, 9, 27, 45}, {3, 5, 6, 27, 45, 54},
+   {3, 2, 6, 27, 18, 54}, {5, 6, 4, 45, 54, 36},
+   {9, 27, 45, 8, 24, 40}, {27, 45, 54, 24, 40, 48},
+   {27, 18, 54, 24, 16, 48}, {45, 54, 36, 40, 48, 32}}
+};
+
+/** Return the corner table of the children of an element.
+ * \param [in] eclass   The class of the element. Must not be a vertex
+ *                      or a pyramid.
+ * \param [in] type     The type of a triangle or tet, the type of the
+ *                      triangle of a prism. Ignored for other classes.
+ * \return              The masks of child c start at position c times
+ *                      the number of corners of \a eclass.
+ */
+constexpr const uint8_t *
+t8_refine_child_corners (t8_eclass_t eclass, int type)
+{
+  return eclass == T8_ECLASS_LINE ? &t8_refine_line_child_corners[0][0]
+    : eclass == T8_ECLASS_QUAD ? &t8_refine_quad_child_corners[0][0]
+    : eclass == T8_ECLASS_HEX ? &t8_refine_hex_child_corners[0][0]
+    : eclass == T8_ECLASS_TRIANGLE ? &t8_refine_tri_child_corners[type][0][0]
+    : eclass == T8_ECLASS_TET ? &t8_refine_tet_child_corners[type][0][0]
+    : eclass == T8_ECLASS_PRISM ? &t8_refine_prism_child_corners[type][0][0]
+    : nullptr;
+}
+
+#endif /* T8_DEFAULT_REFINE_TABLES_CXX_HXX */
@@ -25,6 +25,7 @@
 #include "t8_dtet_bits.h"
 #include "t8_dtri_bits.h"
 #include "t8_dtet_connectivity.h"
+#include "t8_default_refine_tables_cxx.hxx"
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -483,6 +484,82 @@ t8_default_scheme_tet_c::t8_element_successor (const t8_element_t * elem1,
                      (t8_default_tet_t *) elem2, level);
 }
 
+void
+t8_default_scheme_tet_c::t8_element_set_linear_id_range (t8_element_t *
+                                                         elements,
+                                                         int level,
+                                                         t8_linearidx_t
+                                                         first_id,
+                                                         t8_locidx_t
+                                                         count)
+{
+  t8_default_tet_t   *tets = (t8_default_tet_t *) elements;
+
+  T8_ASSERT (0 <= level && level <= T8_DTET_MAXLEVEL);
+
+  /* Only the levels whose local index changes are recomputed for
+   * each element */
+  t8_dtet_init_linear_id_range (tets, first_id, level, count);
+}
+
+void
+t8_default_scheme_tet_c::t8_element_level_batch (const t8_element_t *
+                                                 elements,
+                                                 t8_locidx_t count,
+                                                 int *levels)
+{
+  const t8_default_tet_t *elems = (const t8_default_tet_t *) elements;
+  t8_locidx_t         ielem;
+
+  /* Read the levels directly instead of calling a function per element */
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] = elems[ielem].level;
+  }
+}
+
+void
+t8_default_scheme_tet_c::t8_element_get_linear_id_batch (const t8_element_t *
+                                                         elements,
+                                                         t8_locidx_t count,
+                                                         int level,
+                                                         t8_linearidx_t * ids)
+{
+  const t8_default_tet_t *elems = (const t8_default_tet_t *) elements;
+
+  T8_ASSERT (0 <= level && level <= T8_DTET_MAXLEVEL);
+
+  t8_dtet_linear_id_batch (elems, count, level, ids);
+}
+
+void
+t8_default_scheme_tet_c::t8_element_children_batch (const t8_element_t *
+                                                    elements,
+                                                    t8_locidx_t count,
+                                                    t8_element_t * children)
+{
+  const t8_default_tet_t *elems = (const t8_default_tet_t *) elements;
+  t8_default_tet_t   *child = (t8_default_tet_t *) children;
+  t8_locidx_t         ielem;
+  t8_dtet_coord_t     h;
+  int                 ichild, type;
+
+  /* The children are the parent shifted by a fixed offset per child id
+   * and parent type */
+  for (ielem = 0; ielem < count; ielem++) {
+    T8_ASSERT (elems[ielem].level < T8_DTET_MAXLEVEL);
+    h = T8_DTET_LEN (elems[ielem].level + 1);
+    type = elems[ielem].type;
+    for (ichild = 0; ichild < T8_DTET_CHILDREN; ichild++, child++) {
+      *child = elems[ielem];
+      child->x += t8_dtet_child_anchor_offset[type][ichild][0] * h;
+      child->y += t8_dtet_child_anchor_offset[type][ichild][1] * h;
+      child->z += t8_dtet_child_anchor_offset[type][ichild][2] * h;
+      child->type = t8_dtet_child_type[type][ichild];
+      child->level++;
+    }
+  }
+}
+
 void
 t8_default_scheme_tet_c::t8_element_first_descendant (const t8_element_t *
                                                       elem,
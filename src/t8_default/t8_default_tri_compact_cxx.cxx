@@ -0,0 +1,774 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "t8_default_common_cxx.hxx"
+#include "t8_default_tri_compact_cxx.hxx"
+#include "t8_dtri_bits.h"
+#include "t8_dtri_connectivity.h"
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The level of a compact triangle */
+static inline int
+t8_tri_compact_level (const t8_element_t * elem)
+{
+  return (int) (*(const t8_default_tri_compact_t *) elem &
+                T8_COMPACT_LEVEL_MASK);
+}
+
+/* The linear id of a compact triangle at its level */
+static inline       t8_linearidx_t
+t8_tri_compact_id (const t8_element_t * elem)
+{
+  return *(const t8_default_tri_compact_t *) elem >> T8_COMPACT_LEVEL_BITS;
+}
+
+/* Set a compact triangle to a level and a linear id at this level */
+static inline void
+t8_tri_compact_set (t8_element_t * elem, int level, t8_linearidx_t id)
+{
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  T8_ASSERT (id < ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level));
+  *(t8_default_tri_compact_t *) elem =
+    (id << T8_COMPACT_LEVEL_BITS) | (t8_default_tri_compact_t) level;
+}
+
+void
+t8_default_tri_compact_decode (const t8_element_t * elem, t8_dtri_t * t)
+{
+  t8_dtri_init (t);
+  t8_dtri_init_linear_id (t, t8_tri_compact_id (elem),
+                          t8_tri_compact_level (elem));
+}
+
+void
+t8_default_tri_compact_encode (const t8_dtri_t * t, t8_element_t * elem)
+{
+  t8_tri_compact_set (elem, t->level, t8_dtri_linear_id (t, t->level));
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_maxlevel (void)
+{
+  return T8_DTRI_MAXLEVEL;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_level (const t8_element_t * elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return t8_tri_compact_level (elem);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_copy (const t8_element_t * source,
+                                                  t8_element_t * dest)
+{
+  T8_ASSERT (t8_element_is_valid (source));
+  *(t8_default_tri_compact_t *) dest =
+    *(const t8_default_tri_compact_t *) source;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_compare (const t8_element_t *
+                                                     elem1,
+                                                     const t8_element_t *
+                                                     elem2)
+{
+  int                 level1, level2, maxlevel;
+  t8_linearidx_t      id1, id2;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+
+  /* Compare the linear ids at the bigger level of the two,
+   * as t8_dtri_compare does */
+  level1 = t8_tri_compact_level (elem1);
+  level2 = t8_tri_compact_level (elem2);
+  maxlevel = SC_MAX (level1, level2);
+  id1 = t8_tri_compact_id (elem1) << (T8_DTRI_DIM * (maxlevel - level1));
+  id2 = t8_tri_compact_id (elem2) << (T8_DTRI_DIM * (maxlevel - level2));
+  if (id1 == id2) {
+    /* The triangle with the smaller level is considered smaller */
+    return level1 - level2;
+  }
+  return id1 < id2 ? -1 : 1;
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_parent (const t8_element_t * elem,
+                                                    t8_element_t * parent)
+{
+  int                 level = t8_tri_compact_level (elem);
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (level > 0);
+  t8_tri_compact_set (parent, level - 1,
+                      t8_tri_compact_id (elem) >> T8_DTRI_DIM);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_sibling (const t8_element_t *
+                                                     elem, int sibid,
+                                                     t8_element_t * sibling)
+{
+  int                 level = t8_tri_compact_level (elem);
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= sibid && sibid < T8_DTRI_CHILDREN);
+  T8_ASSERT (level > 0);
+  /* Replace the last digit of the linear id */
+  t8_tri_compact_set (sibling, level,
+                      (t8_tri_compact_id (elem) &
+                       ~((t8_linearidx_t) T8_DTRI_CHILDREN - 1)) | sibid);
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_num_faces (const t8_element_t *
+                                                       elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return T8_DTRI_FACES;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_max_num_faces (const t8_element_t
+                                                           * elem)
+{
+  return T8_DTRI_FACES;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_num_children (const t8_element_t
+                                                          * elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return T8_DTRI_CHILDREN;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_num_face_children (const
+                                                               t8_element_t *
+                                                               elem, int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return T8_DTRI_FACE_CHILDREN;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_get_face_corner (const
+                                                             t8_element_t *
+                                                             element,
+                                                             int face,
+                                                             int corner)
+{
+  T8_ASSERT (t8_element_is_valid (element));
+  T8_ASSERT (0 <= face && face < T8_DTRI_FACES);
+  T8_ASSERT (0 <= corner && corner < 2);
+  return t8_dtri_face_corner[face][corner];
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_get_corner_face (const
+                                                             t8_element_t *
+                                                             element,
+                                                             int corner,
+                                                             int face)
+{
+  T8_ASSERT (t8_element_is_valid (element));
+  T8_ASSERT (0 <= corner && corner < T8_DTRI_CORNERS);
+  T8_ASSERT (0 <= face && face < 2);
+  return t8_dtri_corner_face[corner][face];
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_child (const t8_element_t * elem,
+                                                   int childid,
+                                                   t8_element_t * child)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= childid && childid < T8_DTRI_CHILDREN);
+  /* Append the child id as last digit of the linear id */
+  t8_tri_compact_set (child, t8_tri_compact_level (elem) + 1,
+                      (t8_tri_compact_id (elem) << T8_DTRI_DIM) | childid);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_children (const t8_element_t *
+                                                      elem, int length,
+                                                      t8_element_t * c[])
+{
+  int                 ichild, level;
+  t8_linearidx_t      id;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (length == T8_DTRI_CHILDREN);
+
+  /* elem may be one of the children, so we read it first */
+  level = t8_tri_compact_level (elem) + 1;
+  id = t8_tri_compact_id (elem) << T8_DTRI_DIM;
+  for (ichild = 0; ichild < T8_DTRI_CHILDREN; ichild++) {
+    t8_tri_compact_set (c[ichild], level, id | ichild);
+  }
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_child_id (const t8_element_t *
+                                                      elem)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return (int) (t8_tri_compact_id (elem) & (T8_DTRI_CHILDREN - 1));
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_ancestor_id (const t8_element_t *
+                                                         elem, int level)
+{
+  int                 elem_level = t8_tri_compact_level (elem);
+
+  T8_ASSERT (0 <= level && level <= elem_level);
+  if (level == 0) {
+    /* The root triangle is its own first child */
+    return 0;
+  }
+  return (int) ((t8_tri_compact_id (elem) >>
+                 (T8_DTRI_DIM * (elem_level - level))) &
+                (T8_DTRI_CHILDREN - 1));
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_is_family (t8_element_t ** fam)
+{
+  int                 ichild, level;
+  t8_linearidx_t      first_id;
+
+  level = t8_tri_compact_level (fam[0]);
+  first_id = t8_tri_compact_id (fam[0]);
+  if (level == 0 || (first_id & (T8_DTRI_CHILDREN - 1)) != 0) {
+    return 0;
+  }
+  /* The children of a triangle have consecutive linear ids */
+  for (ichild = 1; ichild < T8_DTRI_CHILDREN; ichild++) {
+    if (t8_tri_compact_level (fam[ichild]) != level
+        || t8_tri_compact_id (fam[ichild]) != first_id + ichild) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_nca (const t8_element_t * elem1,
+                                                 const t8_element_t * elem2,
+                                                 t8_element_t * nca)
+{
+  int                 level1, level2, level;
+  t8_linearidx_t      id1, id2;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (t8_element_is_valid (elem2));
+  level1 = t8_tri_compact_level (elem1);
+  level2 = t8_tri_compact_level (elem2);
+  /* The linear ids of the ancestors are prefixes of the linear ids.
+   * We search the finest level at which both prefixes agree. */
+  level = SC_MIN (level1, level2);
+  id1 = t8_tri_compact_id (elem1) >> (T8_DTRI_DIM * (level1 - level));
+  id2 = t8_tri_compact_id (elem2) >> (T8_DTRI_DIM * (level2 - level));
+  while (id1 != id2) {
+    id1 >>= T8_DTRI_DIM;
+    id2 >>= T8_DTRI_DIM;
+    level--;
+  }
+  T8_ASSERT (level >= 0);
+  t8_tri_compact_set (nca, level, id1);
+}
+
+t8_eclass_t
+  t8_default_scheme_tri_compact_c::t8_element_face_class (const t8_element_t *
+                                                          elem, int face)
+{
+  T8_ASSERT (t8_element_is_valid (elem));
+  return T8_ECLASS_LINE;
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_children_at_face (const
+                                                              t8_element_t *
+                                                              elem, int face,
+                                                              t8_element_t *
+                                                              children[],
+                                                              int
+                                                              num_children,
+                                                              int
+                                                              *child_indices)
+{
+  t8_dtri_t           t;
+  t8_dtri_t           tri_children[T8_DTRI_FACE_CHILDREN];
+  t8_element_t       *tri_children_pointers[T8_DTRI_FACE_CHILDREN];
+  int                 ichild;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (num_children == T8_DTRI_FACE_CHILDREN);
+  t8_default_tri_compact_decode (elem, &t);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    t8_dtri_init (tri_children + ichild);
+    tri_children_pointers[ichild] = (t8_element_t *) (tri_children + ichild);
+  }
+  tri_scheme->t8_element_children_at_face ((const t8_element_t *) &t, face,
+                                           tri_children_pointers,
+                                           num_children, child_indices);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    t8_default_tri_compact_encode (tri_children + ichild, children[ichild]);
+  }
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_face_child_face (const
+                                                             t8_element_t *
+                                                             elem, int face,
+                                                             int face_child)
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  return tri_scheme->t8_element_face_child_face ((const t8_element_t *) &t,
+                                                 face, face_child);
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_face_parent_face (const
+                                                              t8_element_t *
+                                                              elem, int face)
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  return tri_scheme->t8_element_face_parent_face ((const t8_element_t *) &t,
+                                                  face);
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_tree_face (const t8_element_t *
+                                                       elem, int face)
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  return tri_scheme->t8_element_tree_face ((const t8_element_t *) &t, face);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_transform_face (const
+                                                            t8_element_t *
+                                                            elem1,
+                                                            t8_element_t *
+                                                            elem2,
+                                                            int orientation,
+                                                            int sign,
+                                                            int
+                                                            is_smaller_face)
+{
+  t8_dtri_t           t1, t2;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  t8_default_tri_compact_decode (elem1, &t1);
+  t8_dtri_init (&t2);
+  tri_scheme->t8_element_transform_face ((const t8_element_t *) &t1,
+                                         (t8_element_t *) &t2, orientation,
+                                         sign, is_smaller_face);
+  t8_default_tri_compact_encode (&t2, elem2);
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_extrude_face (const t8_element_t
+                                                          * face,
+                                                          const
+                                                          t8_eclass_scheme_c *
+                                                          face_scheme,
+                                                          t8_element_t * elem,
+                                                          int root_face)
+{
+  t8_dtri_t           t;
+  int                 elem_face;
+
+  t8_dtri_init (&t);
+  elem_face = tri_scheme->t8_element_extrude_face (face, face_scheme,
+                                                   (t8_element_t *) &t,
+                                                   root_face);
+  t8_default_tri_compact_encode (&t, elem);
+  return elem_face;
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_first_descendant_face (const
+                                                                   t8_element_t
+                                                                   * elem,
+                                                                   int face,
+                                                                   t8_element_t
+                                                                   *
+                                                                   first_desc,
+                                                                   int level)
+{
+  t8_dtri_t           t, desc;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  t8_dtri_init (&desc);
+  tri_scheme->t8_element_first_descendant_face ((const t8_element_t *) &t,
+                                                face, (t8_element_t *) &desc,
+                                                level);
+  t8_default_tri_compact_encode (&desc, first_desc);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_last_descendant_face (const
+                                                                  t8_element_t
+                                                                  * elem,
+                                                                  int face,
+                                                                  t8_element_t
+                                                                  * last_desc,
+                                                                  int level)
+{
+  t8_dtri_t           t, desc;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  t8_dtri_init (&desc);
+  tri_scheme->t8_element_last_descendant_face ((const t8_element_t *) &t,
+                                               face, (t8_element_t *) &desc,
+                                               level);
+  t8_default_tri_compact_encode (&desc, last_desc);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_boundary_face (const t8_element_t
+                                                           * elem, int face,
+                                                           t8_element_t *
+                                                           boundary,
+                                                           const
+                                                           t8_eclass_scheme_c
+                                                           * boundary_scheme)
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  /* The boundary lines are default lines */
+  tri_scheme->t8_element_boundary_face ((const t8_element_t *) &t, face,
+                                        boundary, boundary_scheme);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_boundary (const t8_element_t *
+                                                      elem, int min_dim,
+                                                      int length,
+                                                      t8_element_t **
+                                                      boundary)
+{
+  SC_ABORT ("Not implemented\n");
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_is_root_boundary (const
+                                                              t8_element_t *
+                                                              elem, int face)
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  return t8_dtri_is_root_boundary (&t, face);
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_face_neighbor_inside (const
+                                                                  t8_element_t
+                                                                  * elem,
+                                                                  t8_element_t
+                                                                  * neigh,
+                                                                  int face,
+                                                                  int
+                                                                  *neigh_face)
+{
+  t8_dtri_t           t, n;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= face && face < T8_DTRI_FACES);
+  T8_ASSERT (neigh_face != NULL);
+
+  t8_default_tri_compact_decode (elem, &t);
+  *neigh_face = t8_dtri_face_neighbour (&t, face, &n);
+  if (!t8_dtri_is_inside_root (&n)) {
+    /* A neighbor outside of the root triangle has no linear id */
+    return 0;
+  }
+  t8_default_tri_compact_encode (&n, neigh);
+  return 1;
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_set_linear_id (t8_element_t *
+                                                           elem, int level,
+                                                           t8_linearidx_t id)
+{
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  T8_ASSERT (0 <= id && id < ((t8_linearidx_t) 1) << (2 * level));
+
+  t8_tri_compact_set (elem, level, id);
+}
+
+t8_linearidx_t
+  t8_default_scheme_tri_compact_c::t8_element_get_linear_id (const
+                                                             t8_element_t *
+                                                             elem, int level)
+{
+  int                 elem_level = t8_tri_compact_level (elem);
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  /* As t8_dtri_linear_id, we fill up with the ids of the first descendants
+   * if level is bigger than the level of elem. */
+  if (level <= elem_level) {
+    return t8_tri_compact_id (elem);
+  }
+  return t8_tri_compact_id (elem) << (T8_DTRI_DIM * (level - elem_level));
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_first_descendant (const
+                                                              t8_element_t *
+                                                              elem,
+                                                              t8_element_t *
+                                                              desc, int level)
+{
+  int                 elem_level = t8_tri_compact_level (elem);
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (elem_level <= level && level <= T8_DTRI_MAXLEVEL);
+  t8_tri_compact_set (desc, level, t8_tri_compact_id (elem) <<
+                      (T8_DTRI_DIM * (level - elem_level)));
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_last_descendant (const
+                                                             t8_element_t *
+                                                             elem,
+                                                             t8_element_t *
+                                                             desc, int level)
+{
+  int                 elem_level = t8_tri_compact_level (elem);
+  int                 exponent;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  T8_ASSERT (elem_level <= level && level <= T8_DTRI_MAXLEVEL);
+  /* The last descendant always takes the last child */
+  exponent = T8_DTRI_DIM * (level - elem_level);
+  t8_tri_compact_set (desc, level, (t8_tri_compact_id (elem) << exponent) |
+                      ((((t8_linearidx_t) 1) << exponent) - 1));
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_successor (const t8_element_t *
+                                                       elem1,
+                                                       t8_element_t * elem2,
+                                                       int level)
+{
+  t8_dtri_t           t, s;
+
+  T8_ASSERT (t8_element_is_valid (elem1));
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  if (t8_tri_compact_level (elem1) == level) {
+    /* The successor has the next linear id */
+    t8_tri_compact_set (elem2, level, t8_tri_compact_id (elem1) + 1);
+    return;
+  }
+  t8_default_tri_compact_decode (elem1, &t);
+  t8_dtri_successor (&t, &s, level);
+  t8_default_tri_compact_encode (&s, elem2);
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_set_linear_id_range (t8_element_t
+                                                                 * elements,
+                                                                 int level,
+                                                                 t8_linearidx_t
+                                                                 first_id,
+                                                                 t8_locidx_t
+                                                                 count)
+{
+  t8_locidx_t         ielem;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    t8_tri_compact_set ((t8_element_t *) ((t8_default_tri_compact_t *)
+                                          elements + ielem), level,
+                        first_id + ielem);
+  }
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_level_batch (const t8_element_t
+                                                         * elements,
+                                                         t8_locidx_t count,
+                                                         int *levels)
+{
+  const t8_default_tri_compact_t *elems =
+    (const t8_default_tri_compact_t *) elements;
+  t8_locidx_t         ielem;
+
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] = (int) (elems[ielem] & T8_COMPACT_LEVEL_MASK);
+  }
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_get_linear_id_batch (const
+                                                                 t8_element_t
+                                                                 * elements,
+                                                                 t8_locidx_t
+                                                                 count,
+                                                                 int level,
+                                                                 t8_linearidx_t
+                                                                 * ids)
+{
+  const t8_default_tri_compact_t *elems =
+    (const t8_default_tri_compact_t *) elements;
+  t8_locidx_t         ielem;
+  int                 elem_level;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  for (ielem = 0; ielem < count; ielem++) {
+    elem_level = (int) (elems[ielem] & T8_COMPACT_LEVEL_MASK);
+    ids[ielem] = elems[ielem] >> T8_COMPACT_LEVEL_BITS;
+    if (level > elem_level) {
+      ids[ielem] <<= T8_DTRI_DIM * (level - elem_level);
+    }
+  }
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_anchor (const t8_element_t *
+                                                    elem, int anchor[3])
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  anchor[0] = t.x;
+  anchor[1] = t.y;
+  anchor[2] = 0;
+}
+
+int
+t8_default_scheme_tri_compact_c::t8_element_root_len (const t8_element_t *
+                                                      elem)
+{
+  return T8_DTRI_ROOT_LEN;
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_vertex_coords (const
+                                                           t8_element_t *
+                                                           elem, int vertex,
+                                                           int coords[])
+{
+  t8_dtri_t           t;
+
+  T8_ASSERT (t8_element_is_valid (elem));
+  t8_default_tri_compact_decode (elem, &t);
+  t8_dtri_compute_coords (&t, vertex, coords);
+}
+
+#ifdef T8_ENABLE_DEBUG
+/* *INDENT-OFF* */
+/* indent bug, indent adds a second "const" modifier */
+int
+t8_default_scheme_tri_compact_c::t8_element_is_valid (const t8_element_t * elem) const
+/* *INDENT-ON* */
+{
+  int                 level = t8_tri_compact_level (elem);
+
+  return level <= T8_DTRI_MAXLEVEL
+    && t8_tri_compact_id (elem) <
+    ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level);
+}
+#endif
+
+void
+t8_default_scheme_tri_compact_c::t8_element_new (int length,
+                                                 t8_element_t ** elem)
+{
+  /* allocate memory for a compact triangle */
+  t8_default_scheme_common_c::t8_element_new (length, elem);
+
+  /* in debug mode, set sensible default values. */
+#ifdef T8_ENABLE_DEBUG
+  {
+    int                 i;
+    for (i = 0; i < length; i++) {
+      t8_element_init (1, elem[i], 0);
+    }
+  }
+#endif
+}
+
+void
+t8_default_scheme_tri_compact_c::t8_element_init (int length,
+                                                  t8_element_t * elem,
+                                                  int new_called)
+{
+#ifdef T8_ENABLE_DEBUG
+  if (!new_called) {
+    int                 i;
+    t8_default_tri_compact_t *tris = (t8_default_tri_compact_t *) elem;
+    /* The root triangle has level 0 and linear id 0 */
+    for (i = 0; i < length; i++) {
+      tris[i] = 0;
+    }
+  }
+#endif
+}
+
+/* Constructor */
+t8_default_scheme_tri_compact_c::t8_default_scheme_tri_compact_c (void)
+{
+  eclass = T8_ECLASS_TRIANGLE;
+  element_size = sizeof (t8_default_tri_compact_t);
+  ts_context = sc_mempool_new (element_size);
+  tri_scheme = new t8_default_scheme_tri_c ();
+}
+
+/* Destructor */
+t8_default_scheme_tri_compact_c::~t8_default_scheme_tri_compact_c ()
+{
+  delete              tri_scheme;
+}
+
+T8_EXTERN_C_END ();
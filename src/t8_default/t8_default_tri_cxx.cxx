@@ -26,6 +26,7 @@
 #include "t8_dline_bits.h"
 #include "t8_dtet.h"
 #include "t8_dtri_connectivity.h"
+#include "t8_default_refine_tables_cxx.hxx"
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -531,6 +532,81 @@ t8_default_scheme_tri_c::t8_element_successor (const t8_element_t *
                      (t8_default_tri_t *) elem2, level);
 }
 
+void
+t8_default_scheme_tri_c::t8_element_set_linear_id_range (t8_element_t *
+                                                         elements,
+                                                         int level,
+                                                         t8_linearidx_t
+                                                         first_id,
+                                                         t8_locidx_t
+                                                         count)
+{
+  t8_default_tri_t   *tris = (t8_default_tri_t *) elements;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  /* Only the levels whose local index changes are recomputed for
+   * each element */
+  t8_dtri_init_linear_id_range (tris, first_id, level, count);
+}
+
+void
+t8_default_scheme_tri_c::t8_element_level_batch (const t8_element_t *
+                                                 elements,
+                                                 t8_locidx_t count,
+                                                 int *levels)
+{
+  const t8_default_tri_t *elems = (const t8_default_tri_t *) elements;
+  t8_locidx_t         ielem;
+
+  /* Read the levels directly instead of calling a function per element */
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] = elems[ielem].level;
+  }
+}
+
+void
+t8_default_scheme_tri_c::t8_element_get_linear_id_batch (const t8_element_t *
+                                                         elements,
+                                                         t8_locidx_t count,
+                                                         int level,
+                                                         t8_linearidx_t * ids)
+{
+  const t8_default_tri_t *elems = (const t8_default_tri_t *) elements;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  t8_dtri_linear_id_batch (elems, count, level, ids);
+}
+
+void
+t8_default_scheme_tri_c::t8_element_children_batch (const t8_element_t *
+                                                    elements,
+                                                    t8_locidx_t count,
+                                                    t8_element_t * children)
+{
+  const t8_default_tri_t *elems = (const t8_default_tri_t *) elements;
+  t8_default_tri_t   *child = (t8_default_tri_t *) children;
+  t8_locidx_t         ielem;
+  t8_dtri_coord_t     h;
+  int                 ichild, type;
+
+  /* The children are the parent shifted by a fixed offset per child id
+   * and parent type */
+  for (ielem = 0; ielem < count; ielem++) {
+    T8_ASSERT (elems[ielem].level < T8_DTRI_MAXLEVEL);
+    h = T8_DTRI_LEN (elems[ielem].level + 1);
+    type = elems[ielem].type;
+    for (ichild = 0; ichild < T8_DTRI_CHILDREN; ichild++, child++) {
+      *child = elems[ielem];
+      child->x += t8_dtri_child_anchor_offset[type][ichild][0] * h;
+      child->y += t8_dtri_child_anchor_offset[type][ichild][1] * h;
+      child->type = t8_dtri_child_type[type][ichild];
+      child->level++;
+    }
+  }
+}
+
 void
 t8_default_scheme_tri_c::t8_element_anchor (const t8_element_t * elem,
                                             int anchor[3])
@@ -0,0 +1,121 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include "t8_dhilbert_bits.h"
+
+/* In the transposed form of a Hilbert index the coordinate X[i] holds
+ * the bits dim * k + dim - 1 - i of the index in its bit k. */
+
+t8_linearidx_t
+t8_dhilbert_index (int dim, int bits, const uint32_t coords[])
+{
+  uint32_t            X[T8_DHILBERT_MAXDIM], P, Q, t;
+  t8_linearidx_t      index;
+  int                 i, k;
+
+  T8_ASSERT (1 <= dim && dim <= T8_DHILBERT_MAXDIM);
+  T8_ASSERT (1 <= bits && bits < 32 && dim * bits <= 64);
+
+  for (i = 0; i < dim; i++) {
+    T8_ASSERT (coords[i] < ((uint32_t) 1) << bits);
+    X[i] = coords[i];
+  }
+  /* Undo the rotations and reflections, starting with the coarsest level */
+  for (Q = ((uint32_t) 1) << (bits - 1); Q > 1; Q >>= 1) {
+    P = Q - 1;
+    for (i = 0; i < dim; i++) {
+      if (X[i] & Q) {
+        /* invert the low bits of X[0] */
+        X[0] ^= P;
+      }
+      else {
+        /* exchange the low bits of X[0] and X[i] */
+        t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+  /* Gray encode */
+  for (i = 1; i < dim; i++) {
+    X[i] ^= X[i - 1];
+  }
+  t = 0;
+  for (Q = ((uint32_t) 1) << (bits - 1); Q > 1; Q >>= 1) {
+    if (X[dim - 1] & Q) {
+      t ^= Q - 1;
+    }
+  }
+  for (i = 0; i < dim; i++) {
+    X[i] ^= t;
+  }
+  /* Interleave the transposed index */
+  index = 0;
+  for (k = bits - 1; k >= 0; k--) {
+    for (i = 0; i < dim; i++) {
+      index = (index << 1) | ((X[i] >> k) & 1);
+    }
+  }
+  return index;
+}
+
+void
+t8_dhilbert_coords (int dim, int bits, t8_linearidx_t index,
+                    uint32_t coords[])
+{
+  uint32_t            P, Q, t;
+  int                 i, k;
+
+  T8_ASSERT (1 <= dim && dim <= T8_DHILBERT_MAXDIM);
+  T8_ASSERT (1 <= bits && bits < 32 && dim * bits <= 64);
+  T8_ASSERT (dim * bits == 64 || index >> (dim * bits) == 0);
+
+  /* Transpose the index */
+  for (i = 0; i < dim; i++) {
+    coords[i] = 0;
+  }
+  for (k = bits - 1; k >= 0; k--) {
+    for (i = 0; i < dim; i++) {
+      coords[i] |= ((uint32_t) (index >> (dim * k + dim - 1 - i)) & 1) << k;
+    }
+  }
+  /* Gray decode */
+  t = coords[dim - 1] >> 1;
+  for (i = dim - 1; i > 0; i--) {
+    coords[i] ^= coords[i - 1];
+  }
+  coords[0] ^= t;
+  /* Redo the rotations and reflections, starting with the finest level */
+  for (Q = 2; Q != ((uint32_t) 1) << bits; Q <<= 1) {
+    P = Q - 1;
+    for (i = dim - 1; i >= 0; i--) {
+      if (coords[i] & Q) {
+        coords[0] ^= P;
+      }
+      else {
+        t = (coords[0] ^ coords[i]) & P;
+        coords[0] ^= t;
+        coords[i] ^= t;
+      }
+    }
+  }
+}
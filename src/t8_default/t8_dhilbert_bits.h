@@ -0,0 +1,71 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_dhilbert_bits.h
+ * The Hilbert curve on the integer points of a square or cube.
+ * We use J. Skilling's algorithm (Programming the Hilbert curve, AIP
+ * Conference Proceedings 707, 2004), which works in any dimension and
+ * needs no state tables.
+ * The curve of \a bits bits per coordinate visits the points of each
+ * dyadic subcube consecutively. Thus the index of an element of level l
+ * are the highest dim * l bits of the index of any point inside it.
+ * The curve starts in the origin.
+ */
+
+#ifndef T8_DHILBERT_BITS_H
+#define T8_DHILBERT_BITS_H
+
+#include <t8.h>
+
+/** The maximum dimension of the Hilbert curve. */
+#define T8_DHILBERT_MAXDIM 3
+
+T8_EXTERN_C_BEGIN ();
+
+/** Compute the position of a point on the Hilbert curve.
+ * \param [in] dim      The dimension, 1 <= \a dim <= \ref T8_DHILBERT_MAXDIM.
+ * \param [in] bits     The number of bits of each coordinate,
+ *                      1 <= \a bits and \a dim * \a bits <= 64.
+ * \param [in] coords   The \a dim coordinates of the point, each smaller
+ *                      than 2^\a bits.
+ * \return              The index of the point, smaller than
+ *                      2^(\a dim * \a bits).
+ */
+t8_linearidx_t      t8_dhilbert_index (int dim, int bits,
+                                       const uint32_t coords[]);
+
+/** Compute the point at a given position on the Hilbert curve.
+ * This is the inverse of \ref t8_dhilbert_index.
+ * \param [in] dim      The dimension, 1 <= \a dim <= \ref T8_DHILBERT_MAXDIM.
+ * \param [in] bits     The number of bits of each coordinate,
+ *                      1 <= \a bits and \a dim * \a bits <= 64.
+ * \param [in] index    The index of the point, smaller than
+ *                      2^(\a dim * \a bits).
+ * \param [out] coords  The \a dim coordinates of the point.
+ */
+void                t8_dhilbert_coords (int dim, int bits,
+                                        t8_linearidx_t index,
+                                        uint32_t coords[]);
+
+T8_EXTERN_C_END ();
+
+#endif /* T8_DHILBERT_BITS_H */
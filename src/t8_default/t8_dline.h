@@ -38,7 +38,9 @@
 /** The number of children at a face of a line. */
 #define T8_DLINE_FACE_CHILDREN 1
 
-/** The maximum refinement level allowed for a line. */
+/** The maximum refinement level allowed for a line.
+ *  The coordinates are passed as int by the element interface, which
+ *  limits the root length to 2^30. */
 #define T8_DLINE_MAXLEVEL 30
 
 /** The length of the root line in integer coordinates. */
@@ -77,26 +77,18 @@ t8_dprism_init_linear_id (t8_dprism_t * p, int level, uint64_t id)
   uint64_t            tri_id = 0;
   uint64_t            line_id = 0;
   int                 i;
-  int                 triangles_of_size_i = 1;
 
   T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
   T8_ASSERT (id < sc_intpow64u (T8_DPRISM_CHILDREN, level));
 
-  for (i = 0; i <= level; i++) {
-    /*Get the number of the i-th prism and get the related triangle number
-     * then multiplicate it by the number of triangles of level size.*/
-    tri_id += (id % T8_DTRI_CHILDREN) * triangles_of_size_i;
-
-    /*If id % 8 is larger than 3, the prism is in the upper part of the
-     * parent prism. => line_id + 2^i*/
-    line_id +=
-      (id % T8_DPRISM_CHILDREN) / T8_DTRI_CHILDREN *
-      sc_intpow64u (T8_DLINE_CHILDREN, i);
-
-    /*Each Prism divides into 8 children */
-    id /= T8_DPRISM_CHILDREN;
-    /*Each triangle divides into 4 children */
-    triangles_of_size_i *= T8_DTRI_CHILDREN;
+  /* Each of the level 3-bit digits of id is a prism child id. Its lower
+   * two bits are the triangle child id and its highest bit is the
+   * line child id, so we deinterleave the digits into a tri id in
+   * base 4 and a line id in base 2. */
+  for (i = 0; i < level; i++) {
+    tri_id |= (id & 3) << (2 * i);
+    line_id |= ((id >> 2) & 1) << i;
+    id >>= 3;
   }
   t8_dtri_init_linear_id (&p->tri, tri_id, level);
   t8_dline_init_linear_id (&p->line, level, line_id);
@@ -252,8 +244,10 @@ t8_dprism_child (const t8_dprism_t * p, int childid, t8_dprism_t * child)
 {
   T8_ASSERT (0 <= childid && childid < T8_DPRISM_CHILDREN);
   T8_ASSERT (p->line.level == p->tri.level);
-  t8_dtri_child (&p->tri, childid % T8_DTRI_CHILDREN, &child->tri);
-  t8_dline_child (&p->line, childid / T8_DTRI_CHILDREN, &child->line);
+  /* The lower two bits of childid are the triangle child id,
+   * the third bit is the line child id. */
+  t8_dtri_child (&p->tri, childid & 3, &child->tri);
+  t8_dline_child (&p->line, childid >> 2, &child->line);
   T8_ASSERT (child->line.level == child->tri.level);
 }
 
@@ -292,13 +286,17 @@ t8_dprism_face_neighbour (const t8_dprism_t * p, int face,
     return 2 - face;
   }
   else if (face == 3) {
+    /* The neighbour below shares the triangle, its line is shifted down */
     t8_dtri_copy (&p->tri, &neigh->tri);
-    t8_dline_face_neighbour (&p->line, &neigh->line, 0, NULL);
+    neigh->line.x = p->line.x - T8_DLINE_LEN (p->line.level);
+    neigh->line.level = p->line.level;
     return 4;
   }
   else {
+    /* The neighbour above shares the triangle, its line is shifted up */
     t8_dtri_copy (&p->tri, &neigh->tri);
-    t8_dline_face_neighbour (&p->line, &neigh->line, 1, NULL);
+    neigh->line.x = p->line.x + T8_DLINE_LEN (p->line.level);
+    neigh->line.level = p->line.level;
     return 3;
   }
 }
@@ -462,44 +460,38 @@ void
 t8_dprism_successor (const t8_dprism_t * p, t8_dprism_t * succ, int level)
 {
   int                 prism_child_id;
+  int                 l;
+
+  T8_ASSERT (1 <= level && level <= T8_DPRISM_MAXLEVEL);
+  T8_ASSERT (p->line.level == p->tri.level);
   t8_dprism_copy (p, succ);
   /*update the level */
   succ->line.level = level;
   succ->tri.level = level;
-  prism_child_id = t8_dprism_child_id (succ);
-  T8_ASSERT (1 <= level && level <= T8_DPRISM_MAXLEVEL);
-  T8_ASSERT (p->line.level == p->tri.level);
-  /*The next prism is the child with local ID 0 of the next parent prism */
-  if (prism_child_id == T8_DPRISM_CHILDREN - 1) {
-    t8_dprism_successor (p, succ, level - 1);
-    /*Zero out the bits of higher level, caused by recursion */
-#if 1
-    succ->tri.x =
-      (succ->tri.x >> (T8_DTRI_MAXLEVEL - level + 1)) << (T8_DTRI_MAXLEVEL -
-                                                          level + 1);
-    succ->tri.y =
-      (succ->tri.y >> (T8_DTRI_MAXLEVEL - level + 1)) << (T8_DTRI_MAXLEVEL -
-                                                          level + 1);
-#endif
-#if 1
-    succ->line.x =
-      (succ->line.x >> (T8_DLINE_MAXLEVEL - level + 1)) <<
-      (T8_DLINE_MAXLEVEL - level + 1);
-#endif
-    /*Set the level to the actual level */
-    succ->line.level = level;
-    succ->tri.level = level;
+  /* Go up to the first ancestor that is not the last child of its parent.
+   * Each parent computation also zeroes out the coordinate bits of the
+   * level that we leave. */
+  for (l = level;; l--) {
+    T8_ASSERT (l >= 1);
+    prism_child_id = t8_dprism_child_id (succ);
+    if (prism_child_id != T8_DPRISM_CHILDREN - 1) {
+      break;
+    }
+    t8_dprism_parent (succ, succ);
   }
   /*The next prism is one plane up, local_tri_id = 0 */
-  else if ((prism_child_id + 1) % T8_DTRI_CHILDREN == 0) {
-    /*parent is computed with succ, cause there are the updated datas */
+  if ((prism_child_id + 1) % T8_DTRI_CHILDREN == 0) {
     t8_dprism_parent (succ, succ);
     t8_dprism_child (succ, prism_child_id + 1, succ);
   }
   /*The next Prism is in the same plane, but has the next base-triangle */
   else {
-    t8_dtri_successor (&p->tri, &succ->tri, level);
+    t8_dtri_successor (&succ->tri, &succ->tri, l);
   }
+  /* The successor is the first descendant of this ancestor. All bits below
+   * level l are zero, so we only need to set the levels. */
+  succ->line.level = level;
+  succ->tri.level = level;
   T8_ASSERT (succ->line.level == succ->tri.level);
 }
 
@@ -571,44 +563,19 @@ t8_dprism_linear_id (const t8_dprism_t * p, int level)
   uint64_t            tri_id;
   uint64_t            line_id;
   int                 i;
-  uint64_t            prisms_of_size_i = 1;
-  /*line_level = Num_of_Line_children ^ (level - 1) */
-  uint64_t            line_level;
-  /*prism_shift = Num_of_Prism_children / Num_of_line-Children * 8 ^ (level - 1) */
-  uint64_t            prism_shift;
+
   T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
   T8_ASSERT (p->line.level == p->tri.level);
-  /*id = 0 for root element */
-  if (level == 0) {
-    return 0;
-  }
 
-  line_level = sc_intpow64u (T8_DLINE_CHILDREN, level - 1);
-  /* *INDENT-OFF* */
-  prism_shift =
-    (T8_DPRISM_CHILDREN / T8_DLINE_CHILDREN) *
-    sc_intpow64u (T8_DPRISM_CHILDREN, level - 1);
-  /* *INDENT-ON* */
   tri_id = t8_dtri_linear_id (&p->tri, level);
   line_id = t8_dline_linear_id (&p->line, level);
+  /* The prism child id at level i + 1 is the triangle child id
+   * (the i-th base 4 digit of tri_id) plus 4 times the line child id
+   * (the i-th bit of line_id). We interleave these into 3-bit digits. */
   for (i = 0; i < level; i++) {
-    /*Compute via getting the local id of each ancestor triangle in which
-     *elem->tri lies, the prism id, that elem would have, if it lies on the
-     * lowest plane of the prism of level 0 */
-    id += (tri_id % T8_DTRI_CHILDREN) * prisms_of_size_i;
-    tri_id /= T8_DTRI_CHILDREN;
-    prisms_of_size_i *= T8_DPRISM_CHILDREN;
+    id |= ((tri_id & 3) | ((line_id & 1) << 2)) << (3 * i);
+    tri_id >>= 2;
+    line_id >>= 1;
   }
-  /*Now add the actual plane in which the prism is, which is computed via
-   * line_id*/
-  for (i = level - 1; i >= 0; i--) {
-    /*The number to add to the id computed via the tri_id is 4*8^(level-i)
-     *for each plane in a prism of size i*/
-    id += line_id / line_level * prism_shift;
-    line_id = (uint64_t) (line_id % line_level);
-    prism_shift /= T8_DPRISM_CHILDREN;
-    line_level /= T8_DLINE_CHILDREN;
-  }
-
   return id;
 }
@@ -0,0 +1,86 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#ifndef T8_DPYRAMID_H
+#define T8_DPYRAMID_H
+
+/** \file t8_dpyramid.h
+ * The data type of the default pyramid implementation.
+ * A pyramid is refined into six pyramids and four tetrahedra, the
+ * tetrahedra are then refined as usual into eight tetrahedra each.
+ * Thus, an element in a pyramidal tree is either a pyramid or a tetrahedron.
+ * We store both in a \ref t8_dtet_t and distinguish them by their type.
+ * Tetrahedra have the types 0, ..., 5 and pyramids have type 6 if their
+ * base is the bottom face of their cube {z <= x, z <= y} and type 7 if their
+ * base is the top face {z >= x, z >= y}.
+ */
+
+#include <t8.h>
+#include "t8_dtet.h"
+
+/** The number of children that a pyramid is refined into. */
+#define T8_DPYRAMID_CHILDREN 10
+
+/** The number of faces of a pyramid. */
+#define T8_DPYRAMID_FACES 5
+
+/** The number of children that a face is refined to. */
+#define T8_DPYRAMID_FACE_CHILDREN 4
+
+/** The number of corners of a pyramid */
+#define T8_DPYRAMID_CORNERS 5
+
+/** The maximum refinement level allowed for a pyramid.
+ *  Must be smaller or equal to T8_DTET_MAXLEVEL.
+ *  A pyramid at level 20 has more than 2^60 descendants, so that the
+ *  linear ids of a uniform refinement still fit into a t8_gloidx_t. */
+#define T8_DPYRAMID_MAXLEVEL 20
+
+/** The length of the root pyramid in integer coordinates.
+ *  Pyramids use the same coordinates as tetrahedra. */
+#define T8_DPYRAMID_ROOT_LEN T8_DTET_ROOT_LEN
+
+/** The length of a pyramid at a given level in integer coordinates. */
+#define T8_DPYRAMID_LEN(l) T8_DTET_LEN(l)
+
+/** The type of a pyramid whose base is the bottom face of its cube. */
+#define T8_DPYRAMID_FIRST_TYPE 6
+
+/** The type of a pyramid whose base is the top face of its cube. */
+#define T8_DPYRAMID_SECOND_TYPE 7
+
+/** This data type stores a pyramid or a tetrahedron in a pyramidal tree. */
+typedef struct t8_dpyramid
+{
+  /** The level, anchor and type of the element.
+   *  In debugging mode its eclass is always T8_ECLASS_TET, such that
+   *  tetrahedra can be passed to the t8_dtet functions directly. */
+  t8_dtet_t           pyramid;
+
+  /** The level at which the ancestors of a tetrahedron change from
+   *  pyramids to tetrahedra, that is the level of its oldest tetrahedral
+   *  ancestor. -1 if the element is a pyramid. */
+  int8_t              switch_shape_at_level;
+}
+t8_dpyramid_t;
+
+#endif /* T8_DPYRAMID_H */
@@ -0,0 +1,1092 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <p4est_bits.h>
+#include "t8_dpyramid_bits.h"
+#include "t8_dtet_bits.h"
+#include "t8_dtet_connectivity.h"
+#include "t8_dtri.h"
+
+/* A pyramid of type 6 has the vertices
+ * (0,0,0), (1,0,0), (0,1,0), (1,1,0), (1,1,1)
+ * and a pyramid of type 7 the vertices
+ * (0,0,1), (1,0,1), (0,1,1), (1,1,1), (0,0,0)
+ * relative to its anchor, scaled by its length.
+ * A type 6 pyramid consists of the tetrahedra of type 1 and 2 of its cube,
+ * a type 7 pyramid of those of type 4 and 5. The remaining two tetrahedra of
+ * the cube have types 0 and 3.
+ * The root pyramid has type 6. */
+
+const int           t8_dpyramid_face_corner[T8_DPYRAMID_FACES][4] = {
+  {0, 2, 4, -1},
+  {1, 3, 4, -1},
+  {0, 1, 4, -1},
+  {2, 3, 4, -1},
+  {0, 1, 2, 3}
+};
+
+/* For a pyramid of type 6 or 7 (first index type - 6), the type and the
+ * cube id of the child with local index Iloc.
+ * A type 6 pyramid is refined into the pyramids in its subcubes 0, 1, 2, 3, 7,
+ * the type 7 pyramid in subcube 3 and the tetrahedra of type 0 and 3 that
+ * lie in the pyramid. A type 7 pyramid is refined accordingly. */
+static const int8_t t8_dpyramid_type_Iloc_to_type[2][T8_DPYRAMID_CHILDREN] = {
+  {6, 6, 3, 6, 0, 6, 3, 0, 7, 6},
+  {7, 6, 3, 0, 7, 3, 7, 0, 7, 7}
+};
+
+static const int8_t t8_dpyramid_type_Iloc_to_cid[2][T8_DPYRAMID_CHILDREN] = {
+  {0, 1, 1, 2, 2, 3, 3, 3, 3, 7},
+  {0, 4, 4, 4, 4, 5, 5, 6, 6, 7}
+};
+
+/* The number of pyramids among the children with a smaller local index. */
+static const int8_t t8_dpyramid_type_Iloc_to_num_pyra[2][T8_DPYRAMID_CHILDREN]
+  = {
+  {0, 1, 2, 2, 3, 3, 4, 4, 4, 5},
+  {0, 1, 2, 2, 2, 3, 3, 4, 4, 5}
+};
+
+/* For a pyramid of type 6 or 7 (first index type - 6) and its cube id,
+ * the type of its parent. -1 if there is no such pyramid. */
+static const int8_t t8_dpyramid_type_cid_to_parenttype[2][8] = {
+  {6, 6, 6, 6, 7, -1, -1, 6},
+  {7, -1, -1, 6, 7, 7, 7, 7}
+};
+
+/* Each triangular face of a pyramid is a face of one of the two tetrahedra
+ * that form the pyramid. We store the type of this tetrahedron and its face. */
+static const int8_t t8_dpyramid_face_to_tet_type[2][4] = {
+  {2, 1, 1, 2},
+  {4, 5, 5, 4}
+};
+
+static const int8_t t8_dpyramid_face_to_tet_face[2][4] = {
+  {2, 0, 2, 0},
+  {3, 1, 3, 1}
+};
+
+/* Return true if p is a pyramid and false if it is a tetrahedron. */
+static int
+t8_dpyramid_is_pyra (const t8_dpyramid_t * p)
+{
+  return p->pyramid.type >= T8_DPYRAMID_FIRST_TYPE;
+}
+
+static int
+t8_dpyramid_is_equal (const t8_dpyramid_t * p1, const t8_dpyramid_t * p2)
+{
+  return p1->pyramid.level == p2->pyramid.level
+    && p1->pyramid.type == p2->pyramid.type
+    && p1->pyramid.x == p2->pyramid.x && p1->pyramid.y == p2->pyramid.y
+    && p1->pyramid.z == p2->pyramid.z;
+}
+
+/* Compute the cube id of p's ancestor cube at level */
+static int
+t8_dpyramid_cube_id (const t8_dpyramid_t * p, int level)
+{
+  int                 cid = 0;
+  t8_dtet_coord_t     h;
+
+  if (level == 0) {
+    return 0;
+  }
+  h = T8_DPYRAMID_LEN (level);
+  cid |= (p->pyramid.x & h) ? 0x01 : 0;
+  cid |= (p->pyramid.y & h) ? 0x02 : 0;
+  cid |= (p->pyramid.z & h) ? 0x04 : 0;
+  return cid;
+}
+
+/* Fill num_pyra[d] with the number of descendants of a pyramid
+ * d levels below it, for d = 0, ..., max_diff.
+ * A tetrahedron has 8^d such descendants. */
+static void
+t8_dpyramid_num_descendants (int max_diff, t8_linearidx_t * num_pyra)
+{
+  int                 d;
+
+  num_pyra[0] = 1;
+  for (d = 1; d <= max_diff; d++) {
+    /* 6 pyramid children and 4 tetrahedral children */
+    num_pyra[d] = 6 * num_pyra[d - 1] + 4 * (((t8_linearidx_t) 1) <<
+                                             3 * (d - 1));
+  }
+}
+
+/* Compute the parent of p and return the child id of p.
+ * p and parent may point to the same element. */
+static int
+t8_dpyramid_parent_child_id (const t8_dpyramid_t * p, t8_dpyramid_t * parent)
+{
+  t8_dtet_coord_t     h;
+  int                 cid, parent_type, type, Iloc;
+
+  T8_ASSERT (p->pyramid.level > 0);
+  if (!t8_dpyramid_is_pyra (p)
+      && p->pyramid.level > p->switch_shape_at_level) {
+    /* The parent is a tetrahedron */
+    Iloc = t8_dtet_child_id (&p->pyramid);
+    parent->switch_shape_at_level = p->switch_shape_at_level;
+    t8_dtet_parent (&p->pyramid, &parent->pyramid);
+    return Iloc;
+  }
+  /* The parent is a pyramid */
+  type = p->pyramid.type;
+  cid = t8_dpyramid_cube_id (p, p->pyramid.level);
+  if (t8_dpyramid_is_pyra (p)) {
+    parent_type =
+      t8_dpyramid_type_cid_to_parenttype[type -
+                                         T8_DPYRAMID_FIRST_TYPE][cid];
+  }
+  else {
+    /* The tetrahedra in the lower half of a cube are children of type 6
+     * pyramids and those in the upper half of type 7 pyramids. */
+    parent_type = cid & 0x04 ? T8_DPYRAMID_SECOND_TYPE :
+      T8_DPYRAMID_FIRST_TYPE;
+  }
+  T8_ASSERT (parent_type >= T8_DPYRAMID_FIRST_TYPE);
+  for (Iloc = 0; Iloc < T8_DPYRAMID_CHILDREN; Iloc++) {
+    if (t8_dpyramid_type_Iloc_to_cid[parent_type -
+                                     T8_DPYRAMID_FIRST_TYPE][Iloc] == cid
+        && t8_dpyramid_type_Iloc_to_type[parent_type -
+                                         T8_DPYRAMID_FIRST_TYPE][Iloc] ==
+        type) {
+      break;
+    }
+  }
+  T8_ASSERT (Iloc < T8_DPYRAMID_CHILDREN);
+  h = T8_DPYRAMID_LEN (p->pyramid.level);
+  parent->pyramid.x = p->pyramid.x & ~h;
+  parent->pyramid.y = p->pyramid.y & ~h;
+  parent->pyramid.z = p->pyramid.z & ~h;
+  parent->pyramid.type = parent_type;
+  parent->pyramid.level = p->pyramid.level - 1;
+  parent->switch_shape_at_level = -1;
+  return Iloc;
+}
+
+/* Given a tetrahedron of the Kuhn decomposition of a cube at a given level,
+ * construct the element of the pyramidal tree at this level that contains it.
+ * Return the face of this element that contains the face tet_face of tet.
+ * If tet does not lie in the root pyramid, elem is a copy of tet. */
+static int
+t8_dpyramid_tet_to_element (const t8_dtet_t * tet, int tet_face,
+                            t8_dpyramid_t * elem)
+{
+  t8_dtet_t           ancestor;
+  int                 level, face, type;
+
+  level = tet->level;
+  t8_dtet_init (&ancestor);
+  t8_dtet_copy (tet, &elem->pyramid);
+  elem->switch_shape_at_level = level;
+  if (!t8_dpyramid_is_inside_root (elem)) {
+    return tet_face;
+  }
+  /* The element is a tetrahedron if and only if one of tet's ancestors
+   * is a tetrahedron of type 0 or 3. The first of these is the oldest
+   * tetrahedral ancestor. */
+  for (level = 1; level <= tet->level; level++) {
+    t8_dtet_ancestor (tet, level, &ancestor);
+    if (ancestor.type == 0 || ancestor.type == 3) {
+      elem->switch_shape_at_level = level;
+      return tet_face;
+    }
+  }
+  /* tet is part of a pyramid */
+  type = tet->type == 1 || tet->type == 2 ? T8_DPYRAMID_FIRST_TYPE :
+    T8_DPYRAMID_SECOND_TYPE;
+  elem->pyramid.type = type;
+  elem->switch_shape_at_level = -1;
+  for (face = 0; face < T8_DPYRAMID_FACES - 1; face++) {
+    if (t8_dpyramid_face_to_tet_type[type - T8_DPYRAMID_FIRST_TYPE][face]
+        == tet->type
+        && t8_dpyramid_face_to_tet_face[type - T8_DPYRAMID_FIRST_TYPE][face]
+        == tet_face) {
+      return face;
+    }
+  }
+  /* tet_face is not a triangular face of the pyramid */
+  SC_ABORT_NOT_REACHED ();
+  return -1;
+}
+
+/* Compute the plane that contains a face of p.
+ * The normal is scaled such that its entries are small integers. */
+static void
+t8_dpyramid_face_plane (const t8_dpyramid_t * p, int face,
+                        int64_t normal[3], int64_t * offset)
+{
+  t8_dtet_coord_t     corners[3][3];
+  int64_t             d1[3], d2[3];
+  t8_dtet_coord_t     h;
+  int                 i;
+
+  h = T8_DPYRAMID_LEN (p->pyramid.level);
+  for (i = 0; i < 3; i++) {
+    t8_dpyramid_compute_coords (p, t8_dpyramid_get_face_corner (p, face, i),
+                                corners[i]);
+  }
+  for (i = 0; i < 3; i++) {
+    d1[i] = (corners[1][i] - corners[0][i]) / h;
+    d2[i] = (corners[2][i] - corners[0][i]) / h;
+  }
+  normal[0] = d1[1] * d2[2] - d1[2] * d2[1];
+  normal[1] = d1[2] * d2[0] - d1[0] * d2[2];
+  normal[2] = d1[0] * d2[1] - d1[1] * d2[0];
+  *offset = normal[0] * corners[0][0] + normal[1] * corners[0][1]
+    + normal[2] * corners[0][2];
+}
+
+/* Return the face of p that lies in a given plane, or -1 if there is none. */
+static int
+t8_dpyramid_face_in_plane (const t8_dpyramid_t * p,
+                           const int64_t normal[3], int64_t offset)
+{
+  t8_dtet_coord_t     coords[3];
+  int                 face, corner, num_corners;
+
+  for (face = 0; face < t8_dpyramid_num_faces (p); face++) {
+    num_corners = t8_dpyramid_face_class (p, face) == T8_ECLASS_QUAD ? 4 : 3;
+    for (corner = 0; corner < num_corners; corner++) {
+      t8_dpyramid_compute_coords (p,
+                                  t8_dpyramid_get_face_corner (p, face,
+                                                               corner),
+                                  coords);
+      if (normal[0] * coords[0] + normal[1] * coords[1]
+          + normal[2] * coords[2] != offset) {
+        break;
+      }
+    }
+    if (corner == num_corners) {
+      return face;
+    }
+  }
+  return -1;
+}
+
+/* Return the face of the root pyramid that contains a face of p,
+ * or -1 if the face is not on the boundary of the root pyramid.
+ * The root faces are the planes x = z, x = 1, y = z, y = 1 and z = 0. */
+static int
+t8_dpyramid_root_face (const t8_dpyramid_t * p, int face)
+{
+  t8_dtet_coord_t     coords[3];
+  int                 is_on_face[T8_DPYRAMID_FACES] = { 1, 1, 1, 1, 1 };
+  int                 corner, num_corners, root_face;
+
+  num_corners = t8_dpyramid_face_class (p, face) == T8_ECLASS_QUAD ? 4 : 3;
+  for (corner = 0; corner < num_corners; corner++) {
+    t8_dpyramid_compute_coords (p,
+                                t8_dpyramid_get_face_corner (p, face, corner),
+                                coords);
+    is_on_face[0] = is_on_face[0] && coords[0] == coords[2];
+    is_on_face[1] = is_on_face[1] && coords[0] == T8_DPYRAMID_ROOT_LEN;
+    is_on_face[2] = is_on_face[2] && coords[1] == coords[2];
+    is_on_face[3] = is_on_face[3] && coords[1] == T8_DPYRAMID_ROOT_LEN;
+    is_on_face[4] = is_on_face[4] && coords[2] == 0;
+  }
+  for (root_face = 0; root_face < T8_DPYRAMID_FACES; root_face++) {
+    if (is_on_face[root_face]) {
+      return root_face;
+    }
+  }
+  return -1;
+}
+
+/* Compute the first (last = 0) or last (last = 1) descendant of p
+ * at face at a given level. */
+static void
+t8_dpyramid_face_descendant (const t8_dpyramid_t * p, int face,
+                             t8_dpyramid_t * desc, int level, int last)
+{
+  t8_dpyramid_t       child;
+  int64_t             normal[3], offset;
+  int                 ichild, num_children, child_face;
+
+  T8_ASSERT (p->pyramid.level <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_init (&child);
+  t8_dpyramid_face_plane (p, face, normal, &offset);
+  t8_dpyramid_copy (p, desc);
+  while (desc->pyramid.level < level) {
+    num_children = t8_dpyramid_num_children (desc);
+    child_face = -1;
+    for (ichild = 0; ichild < num_children && child_face < 0; ichild++) {
+      t8_dpyramid_child (desc, last ? num_children - 1 - ichild : ichild,
+                         &child);
+      child_face = t8_dpyramid_face_in_plane (&child, normal, offset);
+    }
+    T8_ASSERT (child_face >= 0);
+    t8_dpyramid_copy (&child, desc);
+  }
+}
+
+void
+t8_dpyramid_init (t8_dpyramid_t * p)
+{
+  t8_dtet_init (&p->pyramid);
+  p->pyramid.type = T8_DPYRAMID_FIRST_TYPE;
+  p->switch_shape_at_level = -1;
+}
+
+int
+t8_dpyramid_get_level (const t8_dpyramid_t * p)
+{
+  return p->pyramid.level;
+}
+
+t8_eclass_t
+t8_dpyramid_shape (const t8_dpyramid_t * p)
+{
+  return t8_dpyramid_is_pyra (p) ? T8_ECLASS_PYRAMID : T8_ECLASS_TET;
+}
+
+void
+t8_dpyramid_copy (const t8_dpyramid_t * p, t8_dpyramid_t * dest)
+{
+  if (p == dest) {
+    return;
+  }
+  memcpy (dest, p, sizeof (t8_dpyramid_t));
+}
+
+int
+t8_dpyramid_compare (const t8_dpyramid_t * p1, const t8_dpyramid_t * p2)
+{
+  int                 maxlvl;
+  t8_linearidx_t      id1, id2;
+
+  maxlvl = SC_MAX (p1->pyramid.level, p2->pyramid.level);
+  id1 = t8_dpyramid_linear_id (p1, maxlvl);
+  id2 = t8_dpyramid_linear_id (p2, maxlvl);
+  if (id1 == id2) {
+    /* The element with the smaller level is considered smaller */
+    T8_ASSERT (p1->pyramid.level != p2->pyramid.level
+               || t8_dpyramid_is_equal (p1, p2));
+    return p1->pyramid.level - p2->pyramid.level;
+  }
+  return id1 < id2 ? -1 : 1;
+}
+
+void
+t8_dpyramid_parent (const t8_dpyramid_t * p, t8_dpyramid_t * parent)
+{
+  (void) t8_dpyramid_parent_child_id (p, parent);
+}
+
+void
+t8_dpyramid_ancestor (const t8_dpyramid_t * p, int level,
+                      t8_dpyramid_t * ancestor)
+{
+  t8_dtet_t           tet;
+  int                 switch_level;
+
+  T8_ASSERT (0 <= level && level <= p->pyramid.level);
+  if (!t8_dpyramid_is_pyra (p) && level >= p->switch_shape_at_level) {
+    /* The ancestor is a tetrahedron */
+    switch_level = p->switch_shape_at_level;
+    t8_dtet_ancestor (&p->pyramid, level, &ancestor->pyramid);
+    ancestor->switch_shape_at_level = switch_level;
+    return;
+  }
+  /* The ancestor is a pyramid. Its type follows from the type of the
+   * tetrahedron of its cube that contains p. */
+  tet = p->pyramid;
+  if (t8_dpyramid_is_pyra (p)) {
+    tet.type = t8_dpyramid_face_to_tet_type[p->pyramid.type -
+                                            T8_DPYRAMID_FIRST_TYPE][0];
+  }
+  t8_dtet_ancestor (&tet, level, &tet);
+  T8_ASSERT (tet.type != 0 && tet.type != 3);
+  ancestor->pyramid.x = tet.x;
+  ancestor->pyramid.y = tet.y;
+  ancestor->pyramid.z = tet.z;
+  ancestor->pyramid.level = level;
+  ancestor->pyramid.type = tet.type == 1 || tet.type == 2 ?
+    T8_DPYRAMID_FIRST_TYPE : T8_DPYRAMID_SECOND_TYPE;
+  ancestor->switch_shape_at_level = -1;
+}
+
+int
+t8_dpyramid_num_children (const t8_dpyramid_t * p)
+{
+  return t8_dpyramid_is_pyra (p) ? T8_DPYRAMID_CHILDREN : T8_DTET_CHILDREN;
+}
+
+void
+t8_dpyramid_child (const t8_dpyramid_t * p, int childid,
+                   t8_dpyramid_t * child)
+{
+  t8_dtet_coord_t     h;
+  int                 cid, type, level;
+
+  T8_ASSERT (p->pyramid.level < T8_DPYRAMID_MAXLEVEL);
+  T8_ASSERT (0 <= childid && childid < t8_dpyramid_num_children (p));
+  if (!t8_dpyramid_is_pyra (p)) {
+    /* Tetrahedra are refined as in the tetrahedral tree */
+    child->switch_shape_at_level = p->switch_shape_at_level;
+    t8_dtet_child (&p->pyramid, childid, &child->pyramid);
+    return;
+  }
+  level = p->pyramid.level + 1;
+  h = T8_DPYRAMID_LEN (level);
+  type = p->pyramid.type - T8_DPYRAMID_FIRST_TYPE;
+  cid = t8_dpyramid_type_Iloc_to_cid[type][childid];
+  type = t8_dpyramid_type_Iloc_to_type[type][childid];
+  child->pyramid.x = p->pyramid.x + (cid & 0x01 ? h : 0);
+  child->pyramid.y = p->pyramid.y + (cid & 0x02 ? h : 0);
+  child->pyramid.z = p->pyramid.z + (cid & 0x04 ? h : 0);
+  child->pyramid.type = type;
+  child->pyramid.level = level;
+  child->switch_shape_at_level = type < T8_DPYRAMID_FIRST_TYPE ? level : -1;
+}
+
+void
+t8_dpyramid_childrenpv (const t8_dpyramid_t * p, int length,
+                        t8_dpyramid_t * c[])
+{
+  int                 i;
+
+  T8_ASSERT (length == t8_dpyramid_num_children (p));
+  /* Compute the children in reverse order, since p may be c[0] */
+  for (i = length - 1; i >= 0; i--) {
+    t8_dpyramid_child (p, i, c[i]);
+  }
+}
+
+int
+t8_dpyramid_child_id (const t8_dpyramid_t * p)
+{
+  t8_dpyramid_t       parent;
+
+  if (p->pyramid.level == 0) {
+    return 0;
+  }
+  t8_dpyramid_init (&parent);
+  return t8_dpyramid_parent_child_id (p, &parent);
+}
+
+int
+t8_dpyramid_ancestor_id (const t8_dpyramid_t * p, int level)
+{
+  t8_dpyramid_t       ancestor;
+
+  t8_dpyramid_init (&ancestor);
+  t8_dpyramid_ancestor (p, level, &ancestor);
+  return t8_dpyramid_child_id (&ancestor);
+}
+
+int
+t8_dpyramid_is_familypv (t8_dpyramid_t ** fam)
+{
+  t8_dpyramid_t       parent, child;
+  int                 i, num_children;
+
+  if (fam[0]->pyramid.level == 0) {
+    return 0;
+  }
+  t8_dpyramid_init (&parent);
+  t8_dpyramid_init (&child);
+  t8_dpyramid_parent (fam[0], &parent);
+  num_children = t8_dpyramid_num_children (&parent);
+  for (i = 0; i < num_children; i++) {
+    t8_dpyramid_child (&parent, i, &child);
+    if (!t8_dpyramid_is_equal (&child, fam[i])) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void
+t8_dpyramid_sibling (const t8_dpyramid_t * p, int sibid,
+                     t8_dpyramid_t * sibling)
+{
+  T8_ASSERT (p->pyramid.level > 0);
+  t8_dpyramid_parent (p, sibling);
+  t8_dpyramid_child (sibling, sibid, sibling);
+}
+
+void
+t8_dpyramid_nearest_common_ancestor (const t8_dpyramid_t * p1,
+                                     const t8_dpyramid_t * p2,
+                                     t8_dpyramid_t * nca)
+{
+  t8_dpyramid_t       anc1, anc2;
+  int                 level;
+
+  t8_dpyramid_init (&anc1);
+  t8_dpyramid_init (&anc2);
+  level = SC_MIN (p1->pyramid.level, p2->pyramid.level);
+  t8_dpyramid_ancestor (p1, level, &anc1);
+  t8_dpyramid_ancestor (p2, level, &anc2);
+  /* Go up until both ancestors are the same. This terminates at the
+   * latest at the root. */
+  while (!t8_dpyramid_is_equal (&anc1, &anc2)) {
+    t8_dpyramid_parent (&anc1, &anc1);
+    t8_dpyramid_parent (&anc2, &anc2);
+  }
+  t8_dpyramid_copy (&anc1, nca);
+}
+
+int
+t8_dpyramid_num_faces (const t8_dpyramid_t * p)
+{
+  return t8_dpyramid_is_pyra (p) ? T8_DPYRAMID_FACES : T8_DTET_FACES;
+}
+
+int
+t8_dpyramid_num_corners (const t8_dpyramid_t * p)
+{
+  return t8_dpyramid_is_pyra (p) ? T8_DPYRAMID_CORNERS : T8_DTET_CORNERS;
+}
+
+t8_eclass_t
+t8_dpyramid_face_class (const t8_dpyramid_t * p, int face)
+{
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  if (t8_dpyramid_is_pyra (p) && face == T8_DPYRAMID_FACES - 1) {
+    /* The base of a pyramid is a quad */
+    return T8_ECLASS_QUAD;
+  }
+  return T8_ECLASS_TRIANGLE;
+}
+
+int
+t8_dpyramid_get_face_corner (const t8_dpyramid_t * p, int face, int corner)
+{
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  if (t8_dpyramid_is_pyra (p)) {
+    T8_ASSERT (0 <= corner
+               && corner < (face == T8_DPYRAMID_FACES - 1 ? 4 : 3));
+    return t8_dpyramid_face_corner[face][corner];
+  }
+  T8_ASSERT (0 <= corner && corner < 3);
+  return t8_dtet_face_corner[face][corner];
+}
+
+void
+t8_dpyramid_compute_coords (const t8_dpyramid_t * p, int vertex,
+                            t8_dtet_coord_t coordinates[3])
+{
+  t8_dtet_coord_t     h;
+
+  T8_ASSERT (0 <= vertex && vertex < t8_dpyramid_num_corners (p));
+  if (!t8_dpyramid_is_pyra (p)) {
+    t8_dtet_compute_coords (&p->pyramid, vertex, coordinates);
+    return;
+  }
+  h = T8_DPYRAMID_LEN (p->pyramid.level);
+  coordinates[0] = p->pyramid.x;
+  coordinates[1] = p->pyramid.y;
+  coordinates[2] = p->pyramid.z;
+  if (vertex == 4) {
+    /* The apex */
+    if (p->pyramid.type == T8_DPYRAMID_FIRST_TYPE) {
+      coordinates[0] += h;
+      coordinates[1] += h;
+      coordinates[2] += h;
+    }
+    return;
+  }
+  /* The base */
+  coordinates[0] += vertex & 0x01 ? h : 0;
+  coordinates[1] += vertex & 0x02 ? h : 0;
+  coordinates[2] += p->pyramid.type == T8_DPYRAMID_SECOND_TYPE ? h : 0;
+}
+
+int
+t8_dpyramid_face_neighbour (const t8_dpyramid_t * p, int face,
+                            t8_dpyramid_t * neigh)
+{
+  t8_dtet_t           tet;
+  int                 tet_face, dual_face, type;
+
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  if (t8_dpyramid_is_pyra (p) && face == T8_DPYRAMID_FACES - 1) {
+    /* The neighbor at the base of a pyramid is the pyramid of the
+     * other type in the cube below or above. */
+    t8_dpyramid_copy (p, neigh);
+    if (p->pyramid.type == T8_DPYRAMID_FIRST_TYPE) {
+      neigh->pyramid.type = T8_DPYRAMID_SECOND_TYPE;
+      neigh->pyramid.z -= T8_DPYRAMID_LEN (p->pyramid.level);
+    }
+    else {
+      neigh->pyramid.type = T8_DPYRAMID_FIRST_TYPE;
+      neigh->pyramid.z += T8_DPYRAMID_LEN (p->pyramid.level);
+    }
+    return face;
+  }
+  /* A triangular face is a face of a tetrahedron of the Kuhn decomposition
+   * of p's cube. We compute the face neighbor of this tetrahedron and look
+   * up the element that contains it. */
+  tet = p->pyramid;
+  tet_face = face;
+  if (t8_dpyramid_is_pyra (p)) {
+    type = p->pyramid.type - T8_DPYRAMID_FIRST_TYPE;
+    tet.type = t8_dpyramid_face_to_tet_type[type][face];
+    tet_face = t8_dpyramid_face_to_tet_face[type][face];
+  }
+  dual_face = t8_dtet_face_neighbour (&tet, tet_face, &tet);
+  return t8_dpyramid_tet_to_element (&tet, dual_face, neigh);
+}
+
+int
+t8_dpyramid_is_inside_root (const t8_dpyramid_t * p)
+{
+  t8_dtet_t           tet;
+
+  if (p->pyramid.x < 0 || p->pyramid.x >= T8_DPYRAMID_ROOT_LEN
+      || p->pyramid.y < 0 || p->pyramid.y >= T8_DPYRAMID_ROOT_LEN
+      || p->pyramid.z < 0 || p->pyramid.z >= T8_DPYRAMID_ROOT_LEN) {
+    /* p is outside of the root cube */
+    return 0;
+  }
+  /* p is inside the root pyramid if one of its tetrahedra is
+   * inside a level 0 tetrahedron of type 1 or 2. */
+  tet = p->pyramid;
+  if (t8_dpyramid_is_pyra (p)) {
+    tet.type = t8_dpyramid_face_to_tet_type[p->pyramid.type -
+                                            T8_DPYRAMID_FIRST_TYPE][0];
+  }
+  t8_dtet_ancestor (&tet, 0, &tet);
+  return tet.type == 1 || tet.type == 2;
+}
+
+int
+t8_dpyramid_is_root_boundary (const t8_dpyramid_t * p, int face)
+{
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  return t8_dpyramid_root_face (p, face) >= 0;
+}
+
+int
+t8_dpyramid_tree_face (const t8_dpyramid_t * p, int face)
+{
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  return t8_dpyramid_root_face (p, face);
+}
+
+void
+t8_dpyramid_children_at_face (const t8_dpyramid_t * p, int face,
+                              t8_dpyramid_t * children[], int num_children,
+                              int *child_indices)
+{
+  t8_dpyramid_t       elem, child;
+  int64_t             normal[3], offset;
+  int                 ichild, num_found;
+
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  T8_ASSERT (num_children == T8_DPYRAMID_FACE_CHILDREN);
+  /* Copy p, since it may be the same as children[0] */
+  t8_dpyramid_copy (p, &elem);
+  t8_dpyramid_init (&child);
+  t8_dpyramid_face_plane (&elem, face, normal, &offset);
+  num_found = 0;
+  for (ichild = 0; ichild < t8_dpyramid_num_children (&elem); ichild++) {
+    t8_dpyramid_child (&elem, ichild, &child);
+    if (t8_dpyramid_face_in_plane (&child, normal, offset) >= 0) {
+      T8_ASSERT (num_found < num_children);
+      t8_dpyramid_copy (&child, children[num_found]);
+      if (child_indices != NULL) {
+        child_indices[num_found] = ichild;
+      }
+      num_found++;
+    }
+  }
+  T8_ASSERT (num_found == num_children);
+}
+
+int
+t8_dpyramid_face_child_face (const t8_dpyramid_t * p, int face,
+                             int face_child)
+{
+  t8_dpyramid_t       children[T8_DPYRAMID_FACE_CHILDREN];
+  t8_dpyramid_t      *children_ptr[T8_DPYRAMID_FACE_CHILDREN];
+  int64_t             normal[3], offset;
+  int                 i;
+
+  T8_ASSERT (0 <= face_child && face_child < T8_DPYRAMID_FACE_CHILDREN);
+  for (i = 0; i < T8_DPYRAMID_FACE_CHILDREN; i++) {
+    children_ptr[i] = children + i;
+  }
+  t8_dpyramid_children_at_face (p, face, children_ptr,
+                                T8_DPYRAMID_FACE_CHILDREN, NULL);
+  t8_dpyramid_face_plane (p, face, normal, &offset);
+  return t8_dpyramid_face_in_plane (children + face_child, normal, offset);
+}
+
+int
+t8_dpyramid_face_parent_face (const t8_dpyramid_t * p, int face)
+{
+  t8_dpyramid_t       parent;
+  t8_dtet_coord_t     coords[3];
+  int64_t             normal[3], offset;
+  int                 parent_face, corner, num_corners;
+
+  T8_ASSERT (0 <= face && face < t8_dpyramid_num_faces (p));
+  if (p->pyramid.level == 0) {
+    return face;
+  }
+  t8_dpyramid_init (&parent);
+  t8_dpyramid_parent (p, &parent);
+  t8_dpyramid_face_plane (p, face, normal, &offset);
+  /* Since p lies inside its parent, face is part of a face of the parent
+   * if and only if all corners of this face lie in the plane of face. */
+  for (parent_face = 0; parent_face < t8_dpyramid_num_faces (&parent);
+       parent_face++) {
+    num_corners = t8_dpyramid_face_class (&parent, parent_face)
+      == T8_ECLASS_QUAD ? 4 : 3;
+    for (corner = 0; corner < num_corners; corner++) {
+      t8_dpyramid_compute_coords (&parent,
+                                  t8_dpyramid_get_face_corner (&parent,
+                                                               parent_face,
+                                                               corner),
+                                  coords);
+      if (normal[0] * coords[0] + normal[1] * coords[1]
+          + normal[2] * coords[2] != offset) {
+        break;
+      }
+    }
+    if (corner == num_corners) {
+      return parent_face;
+    }
+  }
+  return -1;
+}
+
+void
+t8_dpyramid_boundary_face (const t8_dpyramid_t * p, int face,
+                           t8_element_t * boundary)
+{
+  t8_dtet_coord_t     coords[3], u[3], v[3], u0, v0, h;
+  int                 root_face, corner;
+
+  root_face = t8_dpyramid_root_face (p, face);
+  T8_ASSERT (0 <= root_face && root_face < T8_DPYRAMID_FACES);
+  if (root_face == T8_DPYRAMID_FACES - 1) {
+    /* The base of the root pyramid is the quad z = 0 */
+    p4est_quadrant_t   *q = (p4est_quadrant_t *) boundary;
+
+    q->x = ((int64_t) p->pyramid.x * P4EST_ROOT_LEN) / T8_DPYRAMID_ROOT_LEN;
+    q->y = ((int64_t) p->pyramid.y * P4EST_ROOT_LEN) / T8_DPYRAMID_ROOT_LEN;
+    q->level = p->pyramid.level;
+    return;
+  }
+  else {
+    t8_dtri_t          *b = (t8_dtri_t *) boundary;
+
+    /* Compute the coordinates of the face's corners in the root face.
+     * The corners 0, 1 and 2 of the root face are mapped to the corners
+     * (0,0), (1,0) and (1,1) of the root triangle. */
+    for (corner = 0; corner < 3; corner++) {
+      t8_dpyramid_compute_coords (p,
+                                  t8_dpyramid_get_face_corner (p, face,
+                                                               corner),
+                                  coords);
+      u[corner] = root_face < 2 ? coords[1] : coords[0];
+      v[corner] = root_face % 2 == 0 ? coords[root_face / 2] : coords[2];
+    }
+    /* The anchor of the triangle is the minimum of its corners and its
+     * type is 0 if it has the corner (u0 + h, v0). */
+    h = T8_DPYRAMID_LEN (p->pyramid.level);
+    u0 = SC_MIN (u[0], SC_MIN (u[1], u[2]));
+    v0 = SC_MIN (v[0], SC_MIN (v[1], v[2]));
+    b->type = 1;
+    for (corner = 0; corner < 3; corner++) {
+      if (u[corner] == u0 + h && v[corner] == v0) {
+        b->type = 0;
+      }
+    }
+    b->x = u0 * T8_DTRI_ROOT_BY_DTET_ROOT;
+    b->y = v0 * T8_DTRI_ROOT_BY_DTET_ROOT;
+    b->level = p->pyramid.level;
+  }
+}
+
+int
+t8_dpyramid_extrude_face (const t8_element_t * face, t8_dpyramid_t * p,
+                          int root_face)
+{
+  const t8_dtri_t    *b = (const t8_dtri_t *) face;
+  t8_dtet_t           tet;
+  t8_dtet_coord_t     face_coords[3][3], tet_coords[3];
+  t8_dtet_coord_t     u, v, h;
+  int                 corner, vertex, type, num_matches, tet_face;
+  int                 opposite = -1, is_inside;
+
+  T8_ASSERT (0 <= root_face && root_face < T8_DPYRAMID_FACES);
+  if (root_face == T8_DPYRAMID_FACES - 1) {
+    /* The element is a type 6 pyramid at the bottom of the root pyramid */
+    const p4est_quadrant_t *q = (const p4est_quadrant_t *) face;
+
+    p->pyramid.level = q->level;
+    p->pyramid.type = T8_DPYRAMID_FIRST_TYPE;
+    p->pyramid.x = ((int64_t) q->x * T8_DPYRAMID_ROOT_LEN) / P4EST_ROOT_LEN;
+    p->pyramid.y = ((int64_t) q->y * T8_DPYRAMID_ROOT_LEN) / P4EST_ROOT_LEN;
+    p->pyramid.z = 0;
+    p->switch_shape_at_level = -1;
+    return root_face;
+  }
+  /* Compute the corners of the face in the root pyramid */
+  h = T8_DPYRAMID_LEN (b->level);
+  for (corner = 0; corner < 3; corner++) {
+    u = b->x / T8_DTRI_ROOT_BY_DTET_ROOT;
+    v = b->y / T8_DTRI_ROOT_BY_DTET_ROOT;
+    if (corner == 1) {
+      u += b->type == 0 ? h : 0;
+      v += b->type == 0 ? 0 : h;
+    }
+    else if (corner == 2) {
+      u += h;
+      v += h;
+    }
+    switch (root_face) {
+    case 0:
+      face_coords[corner][0] = v;
+      face_coords[corner][1] = u;
+      face_coords[corner][2] = v;
+      break;
+    case 1:
+      face_coords[corner][0] = T8_DPYRAMID_ROOT_LEN;
+      face_coords[corner][1] = u;
+      face_coords[corner][2] = v;
+      break;
+    case 2:
+      face_coords[corner][0] = u;
+      face_coords[corner][1] = v;
+      face_coords[corner][2] = v;
+      break;
+    case 3:
+      face_coords[corner][0] = u;
+      face_coords[corner][1] = T8_DPYRAMID_ROOT_LEN;
+      face_coords[corner][2] = v;
+      break;
+    default:
+      SC_ABORT_NOT_REACHED ();
+    }
+  }
+  /* The cube of the element is the cube of the face's first corner,
+   * moved inside for the faces x = 1 and y = 1. */
+  t8_dtet_init (&tet);
+  tet.level = b->level;
+  tet.x = face_coords[0][0] - (root_face == 1 ? h : 0);
+  tet.y = face_coords[0][1] - (root_face == 3 ? h : 0);
+  tet.z = face_coords[0][2];
+  /* Find the tetrahedron of this cube that has the face as a face and lies
+   * inside the root pyramid. */
+  tet_face = -1;
+  for (type = 0; type < T8_DTET_NUM_TYPES && tet_face < 0; type++) {
+    tet.type = type;
+    num_matches = 0;
+    is_inside = 1;
+    for (vertex = 0; vertex < T8_DTET_CORNERS; vertex++) {
+      t8_dtet_compute_coords (&tet, vertex, tet_coords);
+      for (corner = 0; corner < 3; corner++) {
+        if (tet_coords[0] == face_coords[corner][0]
+            && tet_coords[1] == face_coords[corner][1]
+            && tet_coords[2] == face_coords[corner][2]) {
+          break;
+        }
+      }
+      if (corner < 3) {
+        num_matches++;
+      }
+      else {
+        /* vertex is opposite to the face, it has to lie on the inner
+         * side of the faces x = z and y = z */
+        opposite = vertex;
+        is_inside = !((root_face == 0 && tet_coords[0] <= tet_coords[2])
+                      || (root_face == 2 && tet_coords[1] <= tet_coords[2]));
+      }
+    }
+    if (num_matches == 3 && is_inside) {
+      tet_face = opposite;
+    }
+  }
+  T8_ASSERT (tet_face >= 0);
+  return t8_dpyramid_tet_to_element (&tet, tet_face, p);
+}
+
+void
+t8_dpyramid_first_descendant_face (const t8_dpyramid_t * p, int face,
+                                   t8_dpyramid_t * desc, int level)
+{
+  t8_dpyramid_face_descendant (p, face, desc, level, 0);
+}
+
+void
+t8_dpyramid_last_descendant_face (const t8_dpyramid_t * p, int face,
+                                  t8_dpyramid_t * desc, int level)
+{
+  t8_dpyramid_face_descendant (p, face, desc, level, 1);
+}
+
+t8_linearidx_t
+t8_dpyramid_linear_id (const t8_dpyramid_t * p, int level)
+{
+  t8_dpyramid_t       elem;
+  t8_linearidx_t      id = 0, num_pyra[T8_DPYRAMID_MAXLEVEL + 1];
+  int                 Iloc, num_pyra_children, depth;
+
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_init (&elem);
+  if (level < p->pyramid.level) {
+    t8_dpyramid_ancestor (p, level, &elem);
+  }
+  else {
+    t8_dpyramid_copy (p, &elem);
+  }
+  t8_dpyramid_num_descendants (level, num_pyra);
+  /* Go up to the root and add the number of descendants at level of all
+   * elder siblings of elem's ancestors. */
+  while (elem.pyramid.level > 0) {
+    depth = level - elem.pyramid.level;
+    Iloc = t8_dpyramid_parent_child_id (&elem, &elem);
+    if (t8_dpyramid_is_pyra (&elem)) {
+      num_pyra_children =
+        t8_dpyramid_type_Iloc_to_num_pyra[elem.pyramid.type -
+                                          T8_DPYRAMID_FIRST_TYPE][Iloc];
+      id += num_pyra_children * num_pyra[depth]
+        + ((t8_linearidx_t) (Iloc - num_pyra_children) << 3 * depth);
+    }
+    else {
+      id += (t8_linearidx_t) Iloc << 3 * depth;
+    }
+  }
+  return id;
+}
+
+void
+t8_dpyramid_init_linear_id (t8_dpyramid_t * p, int level, t8_linearidx_t id)
+{
+  t8_linearidx_t      num_pyra[T8_DPYRAMID_MAXLEVEL + 1], num_desc;
+  int                 i, Iloc, depth, type;
+
+  T8_ASSERT (0 <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  t8_dpyramid_num_descendants (level, num_pyra);
+  T8_ASSERT (id < num_pyra[level]);
+  /* Start at the root pyramid and descend to level */
+  p->pyramid.x = p->pyramid.y = p->pyramid.z = 0;
+  p->pyramid.level = 0;
+  p->pyramid.type = T8_DPYRAMID_FIRST_TYPE;
+  p->switch_shape_at_level = -1;
+  for (i = 1; i <= level; i++) {
+    depth = level - i;
+    if (t8_dpyramid_is_pyra (p)) {
+      /* Find the child whose descendants contain id */
+      type = p->pyramid.type - T8_DPYRAMID_FIRST_TYPE;
+      for (Iloc = 0; Iloc < T8_DPYRAMID_CHILDREN; Iloc++) {
+        num_desc = t8_dpyramid_type_Iloc_to_type[type][Iloc]
+          >= T8_DPYRAMID_FIRST_TYPE ? num_pyra[depth] :
+          ((t8_linearidx_t) 1) << 3 * depth;
+        if (id < num_desc) {
+          break;
+        }
+        id -= num_desc;
+      }
+      T8_ASSERT (Iloc < T8_DPYRAMID_CHILDREN);
+    }
+    else {
+      Iloc = id >> 3 * depth;
+      id &= (((t8_linearidx_t) 1) << 3 * depth) - 1;
+    }
+    t8_dpyramid_child (p, Iloc, p);
+  }
+  T8_ASSERT (id == 0);
+}
+
+void
+t8_dpyramid_successor (const t8_dpyramid_t * p, t8_dpyramid_t * s,
+                       int level)
+{
+  t8_linearidx_t      id;
+
+  T8_ASSERT (1 <= level && level <= p->pyramid.level);
+  id = t8_dpyramid_linear_id (p, level);
+  t8_dpyramid_init_linear_id (s, level, id + 1);
+}
+
+void
+t8_dpyramid_first_descendant (const t8_dpyramid_t * p, t8_dpyramid_t * desc,
+                              int level)
+{
+  T8_ASSERT (p->pyramid.level <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  /* The first child of a pyramid is a pyramid of the same type and the
+   * first child of a tetrahedron a tetrahedron of the same type, both with
+   * the same anchor. */
+  t8_dpyramid_copy (p, desc);
+  desc->pyramid.level = level;
+}
+
+void
+t8_dpyramid_last_descendant (const t8_dpyramid_t * p, t8_dpyramid_t * desc,
+                             int level)
+{
+  t8_dtet_coord_t     offset;
+
+  T8_ASSERT (p->pyramid.level <= level && level <= T8_DPYRAMID_MAXLEVEL);
+  /* The last child of a pyramid or tetrahedron has the same type and
+   * lies in the last subcube. */
+  offset = T8_DPYRAMID_LEN (p->pyramid.level) - T8_DPYRAMID_LEN (level);
+  t8_dpyramid_copy (p, desc);
+  desc->pyramid.x += offset;
+  desc->pyramid.y += offset;
+  desc->pyramid.z += offset;
+  desc->pyramid.level = level;
+}
+
+int
+t8_dpyramid_is_valid (const t8_dpyramid_t * p)
+{
+  int                 is_valid;
+  t8_dtet_coord_t     max_coord;
+
+  /* The level is in the valid range */
+  is_valid = 0 <= p->pyramid.level
+    && p->pyramid.level <= T8_DPYRAMID_MAXLEVEL;
+  /* The coordinates are in valid ranges, we allow the x,y,z coordinates
+   * to lie in the 3x3 neighborhood of the root cube. */
+  max_coord = ((int64_t) 2 * T8_DPYRAMID_ROOT_LEN) - 1;
+  is_valid = is_valid && -T8_DPYRAMID_ROOT_LEN <= p->pyramid.x
+    && p->pyramid.x <= max_coord;
+  is_valid = is_valid && -T8_DPYRAMID_ROOT_LEN <= p->pyramid.y
+    && p->pyramid.y <= max_coord;
+  is_valid = is_valid && -T8_DPYRAMID_ROOT_LEN <= p->pyramid.z
+    && p->pyramid.z <= max_coord;
+#ifdef T8_ENABLE_DEBUG
+  is_valid = is_valid && p->pyramid.eclass_int8 == T8_ECLASS_TET;
+#endif
+  /* The type is in the valid range and the switch level matches it */
+  is_valid = is_valid && 0 <= p->pyramid.type
+    && p->pyramid.type <= T8_DPYRAMID_SECOND_TYPE;
+  if (t8_dpyramid_is_pyra (p)) {
+    is_valid = is_valid && p->switch_shape_at_level == -1;
+  }
+  else {
+    is_valid = is_valid && 0 <= p->switch_shape_at_level
+      && p->switch_shape_at_level <= p->pyramid.level;
+  }
+  return is_valid;
+}
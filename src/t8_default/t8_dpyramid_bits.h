@@ -0,0 +1,378 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_dpyramid_bits.h
+ * Definitions of pyramid-specific functions.
+ * The elements of a pyramidal tree are pyramids and tetrahedra,
+ * see \ref t8_dpyramid.h. All functions in this file accept both.
+ */
+
+#ifndef T8_DPYRAMID_BITS_H
+#define T8_DPYRAMID_BITS_H
+
+#include <t8_element.h>
+#include "t8_dpyramid.h"
+
+T8_EXTERN_C_BEGIN ();
+
+/** Look-up table for the corners of each face of a pyramid.
+ *  The triangular faces have -1 as their fourth entry. */
+extern const int    t8_dpyramid_face_corner[T8_DPYRAMID_FACES][4];
+
+/** Initialize an element as the root pyramid.
+ * \param [in,out] p  Existing element whose data will be filled.
+ */
+void                t8_dpyramid_init (t8_dpyramid_t * p);
+
+/** Compute the level of an element.
+ * \param [in] p    Element whose level is computed.
+ * \return          The level of \a p.
+ */
+int                 t8_dpyramid_get_level (const t8_dpyramid_t * p);
+
+/** Compute the shape of an element.
+ * \param [in] p    Input element.
+ * \return          T8_ECLASS_PYRAMID if \a p is a pyramid,
+ *                  T8_ECLASS_TET if \a p is a tetrahedron.
+ */
+t8_eclass_t         t8_dpyramid_shape (const t8_dpyramid_t * p);
+
+/** Copy all values from one element to another.
+ * \param [in] p    The element to be copied.
+ * \param [in,out] dest Existing element whose data will be filled with the data
+ *                   of \a p.
+ */
+void                t8_dpyramid_copy (const t8_dpyramid_t * p,
+                                      t8_dpyramid_t * dest);
+
+/** Compare two elements. returns negativ if p1 < p2, zero if p1 equals p2
+ *  and positiv if p1 > p2.
+ *  If p2 is a copy of p1 then the elements are equal.
+ */
+int                 t8_dpyramid_compare (const t8_dpyramid_t * p1,
+                                         const t8_dpyramid_t * p2);
+
+/** Compute the parent of an element.
+ * \param [in]  p   Input element with level > 0.
+ * \param [in,out] parent Existing element whose data will
+ *                  be filled with the data of \a p's parent.
+ * \note \a p may point to the same element as \a parent.
+ */
+void                t8_dpyramid_parent (const t8_dpyramid_t * p,
+                                        t8_dpyramid_t * parent);
+
+/** Compute the ancestor of an element at a given level.
+ * \param [in]  p   Input element.
+ * \param [in]  level A level smaller or equal to the level of \a p.
+ * \param [in,out] ancestor Existing element whose data will
+ *                  be filled with the data of \a p's ancestor on
+ *                  level \a level.
+ * \note \a p may point to the same element as \a ancestor.
+ */
+void                t8_dpyramid_ancestor (const t8_dpyramid_t * p, int level,
+                                          t8_dpyramid_t * ancestor);
+
+/** Compute the number of children of an element.
+ * \param [in] p    Input element.
+ * \return          10 if \a p is a pyramid, 8 if \a p is a tetrahedron.
+ */
+int                 t8_dpyramid_num_children (const t8_dpyramid_t * p);
+
+/** Compute the childid-th child of an element.
+ * A pyramid is refined into six pyramids and four tetrahedra, a tetrahedron
+ * is refined into eight tetrahedra as in \ref t8_dtet_child.
+ * \param [in] p    Input element.
+ * \param [in] childid The id of the child, 0 <= \a childid < \ref t8_dpyramid_num_children.
+ * \param [in,out] child Existing element whose data will be filled
+ *                  with the data of \a p's childid-th child.
+ * \note \a p may point to the same element as \a child.
+ */
+void                t8_dpyramid_child (const t8_dpyramid_t * p, int childid,
+                                       t8_dpyramid_t * child);
+
+/** Compute all children of an element.
+ * \param [in] p    Input element.
+ * \param [in] length The number of children of \a p.
+ * \param [in,out] c Pointers to the computed children in linear order.
+ *                  \a p may point to the same element as c[0].
+ */
+void                t8_dpyramid_childrenpv (const t8_dpyramid_t * p,
+                                            int length, t8_dpyramid_t * c[]);
+
+/** Compute the child id of an element.
+ * \param [in] p    Input element.
+ * \return          The child id of \a p, 0 for the root pyramid.
+ */
+int                 t8_dpyramid_child_id (const t8_dpyramid_t * p);
+
+/** Compute the child id of the ancestor of an element at a given level.
+ * \param [in] p    Input element.
+ * \param [in] level A level smaller or equal to the level of \a p.
+ * \return          The child id of the ancestor of \a p at \a level.
+ */
+int                 t8_dpyramid_ancestor_id (const t8_dpyramid_t * p,
+                                             int level);
+
+/** Check whether a collection of elements is a family in linear order.
+ * \param [in] fam  An array of as many elements as the parent of fam[0]
+ *                  has children.
+ * \return          Nonzero if \a fam is a family.
+ */
+int                 t8_dpyramid_is_familypv (t8_dpyramid_t ** fam);
+
+/** Compute a specific sibling of an element.
+ * \param [in] p    Input element with level > 0.
+ * \param [in] sibid The id of the sibling.
+ * \param [in,out] sibling Existing element whose data will be filled
+ *                  with the data of sibling no. \a sibid of \a p.
+ */
+void                t8_dpyramid_sibling (const t8_dpyramid_t * p, int sibid,
+                                         t8_dpyramid_t * sibling);
+
+/** Compute the nearest common ancestor of two elements in the same tree.
+ * \param [in] p1   First input element.
+ * \param [in] p2   Second input element.
+ * \param [in,out] nca Existing element whose data will be filled with the
+ *                  nearest common ancestor of \a p1 and \a p2.
+ */
+void                t8_dpyramid_nearest_common_ancestor (const t8_dpyramid_t
+                                                         * p1,
+                                                         const t8_dpyramid_t
+                                                         * p2,
+                                                         t8_dpyramid_t *
+                                                         nca);
+
+/** Compute the number of faces of an element.
+ * \param [in] p    Input element.
+ * \return          5 if \a p is a pyramid, 4 if \a p is a tetrahedron.
+ */
+int                 t8_dpyramid_num_faces (const t8_dpyramid_t * p);
+
+/** Compute the number of corners of an element.
+ * \param [in] p    Input element.
+ * \return          5 if \a p is a pyramid, 4 if \a p is a tetrahedron.
+ */
+int                 t8_dpyramid_num_corners (const t8_dpyramid_t * p);
+
+/** Compute the element class of a face of an element.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \return          T8_ECLASS_QUAD for the base of a pyramid,
+ *                  T8_ECLASS_TRIANGLE otherwise.
+ */
+t8_eclass_t         t8_dpyramid_face_class (const t8_dpyramid_t * p,
+                                            int face);
+
+/** Return a corner of a face of an element.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \param [in] corner A corner of \a face.
+ * \return          The corner number of \a corner as a corner of \a p.
+ */
+int                 t8_dpyramid_get_face_corner (const t8_dpyramid_t * p,
+                                                 int face, int corner);
+
+/** Compute the integer coordinates of a vertex of an element.
+ * \param [in] p    Input element.
+ * \param [in] vertex The number of the vertex.
+ * \param [out] coordinates An array of 3 t8_dtet_coord_t that will be
+ *                  filled with the coordinates of the vertex.
+ */
+void                t8_dpyramid_compute_coords (const t8_dpyramid_t * p,
+                                                int vertex,
+                                                t8_dtet_coord_t
+                                                coordinates[3]);
+
+/** Compute the same level face neighbor of an element.
+ * The neighbor of a tetrahedron may be a pyramid and vice versa.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \param [in,out] neigh Existing element whose data will be filled with the
+ *                  data of the face neighbor of \a p along \a face.
+ * \return          The face of \a neigh that coincides with \a face.
+ * \note If the neighbor lies outside of the root pyramid, the data of \a neigh
+ *       is undefined and only \ref t8_dpyramid_is_inside_root may be called.
+ */
+int                 t8_dpyramid_face_neighbour (const t8_dpyramid_t * p,
+                                                int face,
+                                                t8_dpyramid_t * neigh);
+
+/** Query whether an element lies inside the root pyramid.
+ * \param [in] p    Input element.
+ * \return          Nonzero if \a p lies inside the root pyramid.
+ */
+int                 t8_dpyramid_is_inside_root (const t8_dpyramid_t * p);
+
+/** Query whether a face of an element lies on the boundary of the root pyramid.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \return          Nonzero if \a face is a subface of a face of the root pyramid.
+ */
+int                 t8_dpyramid_is_root_boundary (const t8_dpyramid_t * p,
+                                                  int face);
+
+/** Compute the face of the root pyramid in which a face of an element lies.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p on the boundary of the root pyramid.
+ * \return          The face of the root pyramid that contains \a face.
+ */
+int                 t8_dpyramid_tree_face (const t8_dpyramid_t * p, int face);
+
+/** Compute the children of an element that share a face with a given face.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \param [in,out] children Existing elements that will be filled with the
+ *                  children of \a p at \a face in linear order.
+ * \param [in] num_children The number of children at \a face, always 4.
+ * \param [in,out] child_indices If not NULL, on output the child ids of
+ *                  the children at \a face.
+ * \note \a p may point to the same element as children[0].
+ */
+void                t8_dpyramid_children_at_face (const t8_dpyramid_t * p,
+                                                  int face,
+                                                  t8_dpyramid_t * children[],
+                                                  int num_children,
+                                                  int *child_indices);
+
+/** Compute the face number of a child at a face that coincides with the face.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \param [in] face_child The number of a child of \a p at \a face,
+ *                  in the order of \ref t8_dpyramid_children_at_face.
+ * \return          The face of the child that lies inside \a face.
+ */
+int                 t8_dpyramid_face_child_face (const t8_dpyramid_t * p,
+                                                 int face, int face_child);
+
+/** Compute the face of the parent of an element that contains a face of the element.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \return          The face of the parent of \a p that contains \a face,
+ *                  -1 if there is no such face.
+ *                  If \a p is the root, \a face is returned.
+ */
+int                 t8_dpyramid_face_parent_face (const t8_dpyramid_t * p,
+                                                  int face);
+
+/** Construct the boundary element of an element at a face of the root pyramid.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p on the boundary of the root pyramid.
+ * \param [in,out] boundary An existing p4est_quadrant_t if \a face is the
+ *                  base of the root pyramid, a t8_dtri_t otherwise.
+ *                  On output the face element in the coordinates of the
+ *                  root face.
+ */
+void                t8_dpyramid_boundary_face (const t8_dpyramid_t * p,
+                                               int face,
+                                               t8_element_t * boundary);
+
+/** Construct the element inside the root pyramid that has a given face element
+ *  at a face of the root pyramid as a face.
+ * \param [in] face A p4est_quadrant_t if \a root_face is the base of
+ *                  the root pyramid, a t8_dtri_t otherwise.
+ * \param [in,out] p Existing element whose data will be filled.
+ * \param [in] root_face A face of the root pyramid.
+ * \return          The face of \a p that coincides with \a face.
+ */
+int                 t8_dpyramid_extrude_face (const t8_element_t * face,
+                                              t8_dpyramid_t * p,
+                                              int root_face);
+
+/** Compute the first descendant of an element that shares a face with a given face.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \param [in,out] desc Existing element whose data will be filled.
+ * \param [in] level The level of \a desc.
+ */
+void                t8_dpyramid_first_descendant_face (const t8_dpyramid_t *
+                                                       p, int face,
+                                                       t8_dpyramid_t * desc,
+                                                       int level);
+
+/** Compute the last descendant of an element that shares a face with a given face.
+ * \param [in] p    Input element.
+ * \param [in] face A face of \a p.
+ * \param [in,out] desc Existing element whose data will be filled.
+ * \param [in] level The level of \a desc.
+ */
+void                t8_dpyramid_last_descendant_face (const t8_dpyramid_t *
+                                                      p, int face,
+                                                      t8_dpyramid_t * desc,
+                                                      int level);
+
+/** Compute the linear id of an element in a uniform refinement of a given level.
+ * In contrast to the other element classes, the number of elements in a
+ * uniform refinement of level l is not a power of two, but
+ * 6^l + 4 * sum_{i=1}^{l} 6^{l-i} 8^{i-1}.
+ * \param [in] p    Input element.
+ * \param [in] level The level of the uniform refinement.
+ * \return          The linear id of \a p (or its first descendant or
+ *                  ancestor at \a level).
+ */
+t8_linearidx_t      t8_dpyramid_linear_id (const t8_dpyramid_t * p,
+                                           int level);
+
+/** Initialize an element as the element with a given linear id in a
+ *  uniform refinement of a given level.
+ * \param [in,out] p Existing element whose data will be filled.
+ * \param [in] level The level of the uniform refinement.
+ * \param [in] id   The linear id of the element.
+ */
+void                t8_dpyramid_init_linear_id (t8_dpyramid_t * p, int level,
+                                                t8_linearidx_t id);
+
+/** Compute the successor of an element in a uniform refinement of a given level.
+ * \param [in] p    Input element.
+ * \param [in,out] s Existing element whose data will be filled with the
+ *                  data of \a p's successor at \a level.
+ * \param [in] level The level of the uniform refinement.
+ */
+void                t8_dpyramid_successor (const t8_dpyramid_t * p,
+                                           t8_dpyramid_t * s, int level);
+
+/** Compute the first descendant of an element at a given level.
+ * \param [in] p    Input element.
+ * \param [in,out] desc Existing element whose data will be filled.
+ * \param [in] level The level of \a desc.
+ */
+void                t8_dpyramid_first_descendant (const t8_dpyramid_t * p,
+                                                  t8_dpyramid_t * desc,
+                                                  int level);
+
+/** Compute the last descendant of an element at a given level.
+ * \param [in] p    Input element.
+ * \param [in,out] desc Existing element whose data will be filled.
+ * \param [in] level The level of \a desc.
+ */
+void                t8_dpyramid_last_descendant (const t8_dpyramid_t * p,
+                                                 t8_dpyramid_t * desc,
+                                                 int level);
+
+/** Query whether all entries of an element are in valid ranges.
+ * \param [in] p    Input element.
+ * \return          True if \a p is a valid element.
+ */
+int                 t8_dpyramid_is_valid (const t8_dpyramid_t * p);
+
+T8_EXTERN_C_END ();
+
+#endif /* T8_DPYRAMID_BITS_H */
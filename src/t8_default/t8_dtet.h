@@ -44,7 +44,9 @@
 #define T8_DTET_CORNERS 4
 
 /** The maximum refinement level allowed for a tetrahedron.
- *  Must be smaller or equal to T8_DTRI_MAXLEVEL. */
+ *  Must be smaller or equal to T8_DTRI_MAXLEVEL.
+ *  A tetrahedron's linear id uses 3 bits per level of a t8_linearidx_t,
+ *  thus 21 is the largest level possible with 64 bit linear ids. */
 #define T8_DTET_MAXLEVEL 21
 
 /** The length of the root tetrahedron in integer coordinates. */
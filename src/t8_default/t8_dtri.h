@@ -43,7 +43,12 @@ T8_EXTERN_C_BEGIN ();
 /** The number of corners of a triangle */
 #define T8_DTRI_CORNERS 3
 
-/** The maximum refinement level allowed for a triangle. */
+/** The maximum refinement level allowed for a triangle.
+ *  A triangle's linear id uses 2 bits per level of a t8_linearidx_t and
+ *  its coordinates as well as those of face neighbours outside of the
+ *  root must fit into a t8_dtri_coord_t. Coordinates are passed as int
+ *  by the element interface, so wider coordinates would gain at most one
+ *  level. */
 #define T8_DTRI_MAXLEVEL 29
 
 /** The length of the root triangle in integer coordinates. */
@@ -1349,6 +1349,64 @@ t8_dtri_linear_id (const t8_dtri_t * t, int level)
   return id;
 }
 
+/* The number of triangles/tets whose linear ids are computed together
+ * in t8_dtri_linear_id_batch. */
+#define T8_DTRI_BATCH_LANES 8
+
+void
+t8_dtri_linear_id_batch (const t8_dtri_t * t, int count, int level,
+                         t8_linearidx_t * ids)
+{
+  const t8_dtri_t    *tl;
+  t8_linearidx_t      id[T8_DTRI_BATCH_LANES];
+  int                 exponent[T8_DTRI_BATCH_LANES];
+  int                 type[T8_DTRI_BATCH_LANES];
+  int                 first, lane, num_lanes, i, shift, max_level;
+  int                 cid;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  for (first = 0; first < count; first += T8_DTRI_BATCH_LANES) {
+    num_lanes = SC_MIN (T8_DTRI_BATCH_LANES, count - first);
+    max_level = 0;
+    for (lane = 0; lane < num_lanes; lane++) {
+      tl = t + first + lane;
+      id[lane] = 0;
+      type[lane] = tl->type;
+      /* As in t8_dtri_linear_id, we fill up with the ids of the
+       * descendants at t's origin with the same type as t */
+      exponent[lane] = level > tl->level ?
+        (level - tl->level) * T8_DTRI_DIM : 0;
+      max_level = SC_MAX (max_level, tl->level);
+    }
+    /* We walk from the finest level to the root for all lanes at once.
+     * The lanes do not depend on each other, such that the table lookups
+     * of different elements are interleaved. */
+    for (i = max_level; i > 0; i--) {
+      shift = T8_DTRI_MAXLEVEL - i;
+      for (lane = 0; lane < num_lanes; lane++) {
+        tl = t + first + lane;
+        if (i > tl->level) {
+          continue;
+        }
+        /* The cube id of the ancestor of level i, see compute_cubeid */
+        cid = ((tl->x >> shift) & 1) | (((tl->y >> shift) & 1) << 1);
+#ifdef T8_DTRI_TO_DTET
+        cid |= ((tl->z >> shift) & 1) << 2;
+#endif
+        id[lane] |= ((t8_linearidx_t)
+                     t8_dtri_type_cid_to_Iloc[type[lane]][cid]) <<
+          exponent[lane];
+        exponent[lane] += T8_DTRI_DIM;
+        type[lane] = t8_dtri_cid_type_to_parenttype[cid][type[lane]];
+      }
+    }
+    for (lane = 0; lane < num_lanes; lane++) {
+      T8_ASSERT (id[lane] == t8_dtri_linear_id (t + first + lane, level));
+      ids[first + lane] = id[lane];
+    }
+  }
+}
+
 void
 t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
 {
@@ -1386,6 +1444,70 @@ t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
   t->type = type;
 }
 
+/* Set the coordinates and type of t at the levels first_level to level
+ * to those of the triangle with linear id id.
+ * types must store the types of t's ancestors up to level first_level - 1.
+ * On output it stores the types of all ancestors of t. */
+static void
+t8_dtri_set_linear_id_levels (t8_dtri_t * t, t8_linearidx_t id, int level,
+                              int first_level, t8_dtri_type_t * types)
+{
+  int                 i;
+  const int           children_m1 = T8_DTRI_CHILDREN - 1;
+  t8_linearidx_t      local_index;
+  t8_dtri_cube_id_t   cid;
+  t8_dtri_coord_t     h;
+
+  for (i = first_level; i <= level; i++) {
+    h = T8_DTRI_LEN (i);
+    /* Get the local index of T's ancestor on level i */
+    local_index = (id >> (T8_DTRI_DIM * (level - i))) & children_m1;
+    /* Get the type and cube-id of T's ancestor on level i */
+    cid = t8_dtri_parenttype_Iloc_to_cid[types[i - 1]][local_index];
+    types[i] = t8_dtri_parenttype_Iloc_to_type[types[i - 1]][local_index];
+    t->x = (cid & 1) ? t->x | h : t->x & ~h;
+    t->y = (cid & 2) ? t->y | h : t->y & ~h;
+#ifdef T8_DTRI_TO_DTET
+    t->z = (cid & 4) ? t->z | h : t->z & ~h;
+#endif
+  }
+  t->type = types[level];
+}
+
+void
+t8_dtri_init_linear_id_range (t8_dtri_t * t, t8_linearidx_t first_id,
+                              int level, int count)
+{
+  t8_dtri_type_t      types[T8_DTRI_MAXLEVEL + 1];
+  const int           children_m1 = T8_DTRI_CHILDREN - 1;
+  t8_linearidx_t      id;
+  int                 ielem, first_level;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  T8_ASSERT (count <= 0 || first_id + count - 1 <
+             ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level));
+
+  if (count <= 0) {
+    return;
+  }
+  /* The first triangle is computed at all levels */
+  t8_dtri_init_root (t);
+  t->level = level;
+  types[0] = 0;                 /* This is the type of the root triangle */
+  t8_dtri_set_linear_id_levels (t, first_id, level, 1, types);
+  for (ielem = 1, id = first_id + 1; ielem < count; ielem++, id++) {
+    /* Only the local indices of the levels after the last nonzero
+     * digit of id change. These are on average less than two levels. */
+    for (first_level = level;
+         first_level > 1
+         && ((id >> (T8_DTRI_DIM * (level - first_level))) & children_m1)
+         == 0; first_level--) {
+    }
+    t8_dtri_copy (t + ielem - 1, t + ielem);
+    t8_dtri_set_linear_id_levels (t + ielem, id, level, first_level, types);
+  }
+}
+
 void
 t8_dtri_init_root (t8_dtri_t * t)
 {
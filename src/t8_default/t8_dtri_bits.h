@@ -275,6 +275,20 @@ int                 t8_dtri_is_ancestor (const t8_dtri_t * t,
  */
 t8_linearidx_t      t8_dtri_linear_id (const t8_dtri_t * t, int level);
 
+/** Computes the linear positions of an array of triangles in a uniform grid.
+ * The result is the same as calling \ref t8_dtri_linear_id for each
+ * triangle, but the triangles are processed in small groups, such that
+ * the computations for different triangles can overlap.
+ * \param [in] t     An array of \a count triangles.
+ * \param [in] count The number of triangles.
+ * \param [in] level level of uniform grid to be considered.
+ * \param [out] ids  An array of \a count entries. On output ids[i] is
+ *                   the linear id of the i-th triangle.
+ */
+void                t8_dtri_linear_id_batch (const t8_dtri_t * t,
+                                             int count, int level,
+                                             t8_linearidx_t * ids);
+
 /** Initialize a triangle as the triangle with a given global id in a uniform
  *  refinement of a given level. *
  * \param [in,out] t  Existing triangle whose data will be filled.
@@ -284,6 +298,23 @@ t8_linearidx_t      t8_dtri_linear_id (const t8_dtri_t * t, int level);
 void                t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id,
                                             int level);
 
+/** Initialize an array of triangles as consecutive triangles in a uniform
+ * refinement of a given level. The i-th triangle gets the linear id
+ * \a first_id + i.
+ * The types of the ancestors of the current triangle are kept between
+ * the steps, such that only the levels whose local index changes are
+ * recomputed. Thus each triangle costs amortized constant time, compared
+ * to O(level) for \ref t8_dtri_init_linear_id.
+ * \param [in,out] t   An array of \a count existing triangles.
+ * \param [in] first_id The linear id of the first triangle.
+ * \param [in] level  level of uniform grid to be considered.
+ * \param [in] count  The number of triangles. first_id + count must not
+ *                    exceed the number of triangles of the uniform grid.
+ */
+void                t8_dtri_init_linear_id_range (t8_dtri_t * t,
+                                                  t8_linearidx_t first_id,
+                                                  int level, int count);
+
 /** Initialize a triangle as the root triangle (type 0 at level 0)
  * \param [in,out] t Existing triangle whose data will be filled.
  */
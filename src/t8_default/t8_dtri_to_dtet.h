@@ -89,8 +89,10 @@ T8_EXTERN_C_BEGIN ();
 #define t8_dtri_is_parent t8_dtet_is_parent
 #define t8_dtri_is_ancestor t8_dtet_is_ancestor
 #define t8_dtri_linear_id t8_dtet_linear_id
+#define t8_dtri_linear_id_batch t8_dtet_linear_id_batch
 #define t8_dtri_linear_id_corner_desc t8_dtet_linear_id_corner_desc
 #define t8_dtri_init_linear_id t8_dtet_init_linear_id
+#define t8_dtri_init_linear_id_range t8_dtet_init_linear_id_range
 #define t8_dtri_init_root t8_dtet_init_root
 #define t8_dtri_successor t8_dtet_successor
 #define t8_dtri_first_descendant t8_dtet_first_descendant
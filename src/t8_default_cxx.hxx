@@ -36,6 +36,22 @@ T8_EXTERN_C_BEGIN ();
 /** Return the default element implementation of t8code. */
 t8_scheme_cxx_t    *t8_scheme_new_default_cxx (void);
 
+/** Return an element implementation that stores triangles and tetrahedra
+ * in 8 bytes each. All other element classes are the default ones.
+ * Tetrahedra of this implementation can be refined up to level 19.
+ * Prisms are not supported, since their faces are default triangles.
+ */
+t8_scheme_cxx_t    *t8_scheme_new_compact_cxx (void);
+
+/** Return an element implementation that orders quadrilaterals and
+ * hexahedra along the Hilbert curve instead of the Morton curve.
+ * Consecutive elements of a uniform tree share a face, which makes the
+ * partitions of a forest more compact and reduces its ghost layer.
+ * The elements have the same storage and geometry as the default ones and
+ * all other element classes are the default ones.
+ */
+t8_scheme_cxx_t    *t8_scheme_new_hilbert_cxx (void);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_DEFAULT_H */
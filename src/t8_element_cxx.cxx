@@ -58,6 +58,177 @@ t8_eclass_scheme::t8_element_size ()
 }
 /* *INDENT-ON* */
 
+/* Default implementation for set_linear_id_range */
+void
+t8_eclass_scheme::t8_element_set_linear_id_range (t8_element_t * elements,
+                                                  int level,
+                                                  t8_linearidx_t first_id,
+                                                  t8_locidx_t count)
+{
+  t8_locidx_t         ielem;
+  char               *elem = (char *) elements;
+  const size_t        size = t8_element_size ();
+
+  if (count <= 0) {
+    return;
+  }
+  t8_element_set_linear_id ((t8_element_t *) elem, level, first_id);
+  for (ielem = 1; ielem < count; ielem++, elem += size) {
+    t8_element_successor ((const t8_element_t *) elem,
+                          (t8_element_t *) (elem + size), level);
+  }
+}
+
+/* Default implementation for level_batch */
+void
+t8_eclass_scheme::t8_element_level_batch (const t8_element_t * elements,
+                                          t8_locidx_t count, int *levels)
+{
+  t8_locidx_t         ielem;
+  const char         *elem = (const char *) elements;
+  const size_t        size = t8_element_size ();
+
+  for (ielem = 0; ielem < count; ielem++, elem += size) {
+    levels[ielem] = t8_element_level ((const t8_element_t *) elem);
+  }
+}
+
+/* Default implementation for get_linear_id_batch */
+void
+t8_eclass_scheme::t8_element_get_linear_id_batch (const t8_element_t *
+                                                  elements,
+                                                  t8_locidx_t count,
+                                                  int level,
+                                                  t8_linearidx_t * ids)
+{
+  t8_locidx_t         ielem;
+  const char         *elem = (const char *) elements;
+  const size_t        size = t8_element_size ();
+
+  for (ielem = 0; ielem < count; ielem++, elem += size) {
+    ids[ielem] = t8_element_get_linear_id ((const t8_element_t *) elem,
+                                           level);
+  }
+}
+
+/* Default implementation for vertex_coords_batch */
+void
+t8_eclass_scheme::t8_element_vertex_coords_batch (const t8_element_t *
+                                                  elements,
+                                                  t8_locidx_t count,
+                                                  int vertex, int *coords)
+{
+  t8_locidx_t         ielem;
+  const char         *elem = (const char *) elements;
+  const size_t        size = t8_element_size ();
+
+  for (ielem = 0; ielem < count; ielem++, elem += size) {
+    t8_element_vertex_coords ((const t8_element_t *) elem, vertex,
+                              coords + 3 * ielem);
+  }
+}
+
+/* Default implementation for bounding_box */
+void
+t8_eclass_scheme::t8_element_bounding_box (const t8_element_t * elem,
+                                           int box[6])
+{
+  int                 coords[3], num_corners, icorner, dim, i;
+
+  dim = t8_eclass_to_dimension[eclass];
+  num_corners = t8_element_num_corners (elem);
+  for (i = 0; i < 3; i++) {
+    box[i] = box[3 + i] = 0;
+  }
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    t8_element_vertex_coords (elem, icorner, coords);
+    for (i = 0; i < dim; i++) {
+      if (icorner == 0 || coords[i] < box[i]) {
+        box[i] = coords[i];
+      }
+      if (icorner == 0 || coords[i] > box[3 + i]) {
+        box[3 + i] = coords[i];
+      }
+    }
+  }
+}
+
+/* Default implementation for children_batch */
+void
+t8_eclass_scheme::t8_element_children_batch (const t8_element_t * elements,
+                                             t8_locidx_t count,
+                                             t8_element_t * children)
+{
+  t8_locidx_t         ielem;
+  int                 num_children, ichild;
+  const char         *elem = (const char *) elements;
+  char               *child = (char *) children;
+  const size_t        size = t8_element_size ();
+  t8_element_t      **child_pointers;
+
+  if (count <= 0) {
+    return;
+  }
+  num_children = t8_element_num_children (elements);
+  child_pointers = T8_ALLOC (t8_element_t *, num_children);
+  for (ielem = 0; ielem < count; ielem++, elem += size) {
+    T8_ASSERT (t8_element_num_children ((const t8_element_t *) elem) ==
+               num_children);
+    for (ichild = 0; ichild < num_children; ichild++, child += size) {
+      child_pointers[ichild] = (t8_element_t *) child;
+    }
+    t8_element_children ((const t8_element_t *) elem, num_children,
+                         child_pointers);
+  }
+  T8_FREE (child_pointers);
+}
+
+/* Default implementation for compare_batch */
+void
+t8_eclass_scheme::t8_element_compare_batch (const t8_element_t * elements1,
+                                            const t8_element_t * elements2,
+                                            t8_locidx_t count, int *results)
+{
+  t8_locidx_t         ielem;
+  const char         *elem1 = (const char *) elements1;
+  const char         *elem2 = (const char *) elements2;
+  const size_t        size = t8_element_size ();
+
+  for (ielem = 0; ielem < count; ielem++, elem1 += size, elem2 += size) {
+    results[ielem] = t8_element_compare ((const t8_element_t *) elem1,
+                                         (const t8_element_t *) elem2);
+  }
+}
+
+/* Default implementation for face_neighbor_across_tree */
+int
+t8_eclass_scheme::t8_element_face_neighbor_across_tree (const t8_element_t *
+                                                        elem, int face,
+                                                        t8_eclass_scheme_c *
+                                                        boundary_scheme,
+                                                        int orientation,
+                                                        int sign,
+                                                        int is_smaller_face,
+                                                        t8_eclass_scheme_c *
+                                                        neigh_scheme,
+                                                        t8_element_t * neigh,
+                                                        int neigh_root_face)
+{
+  t8_element_t       *face_element;
+  int                 neigh_face;
+
+  boundary_scheme->t8_element_new (1, &face_element);
+  t8_element_boundary_face (elem, face, face_element, boundary_scheme);
+  boundary_scheme->t8_element_transform_face (face_element, face_element,
+                                              orientation, sign,
+                                              is_smaller_face);
+  neigh_face = neigh_scheme->t8_element_extrude_face (face_element,
+                                                      boundary_scheme, neigh,
+                                                      neigh_root_face);
+  boundary_scheme->t8_element_destroy (1, &face_element);
+  return neigh_face;
+}
+
 /* Default implementation for array_index */
 t8_element_t       *
 t8_eclass_scheme::t8_element_array_index (sc_array_t * array, size_t it)
@@ -427,6 +427,43 @@ public:
                                                 const t8_eclass_scheme_c *
                                                 boundary_scheme) = 0;
 
+  /** Construct the face neighbor of an element across a face of its root
+   * tree. This is the same as \ref t8_element_boundary_face, followed by
+   * \ref t8_element_transform_face of the boundary scheme and
+   * \ref t8_element_extrude_face of the neighbor scheme.
+   * \param [in] elem     The input element. \a face must lie on the
+   *                      boundary of its root tree.
+   * \param [in] face     The face of \a elem.
+   * \param [in] boundary_scheme The scheme of the face of the root tree.
+   * \param [in] orientation The orientation of the tree-tree connection.
+   * \param [in] sign     The sign as in \ref t8_element_transform_face.
+   * \param [in] is_smaller_face As in \ref t8_element_transform_face.
+   * \param [in] neigh_scheme The scheme of the neighbor tree.
+   * \param [in,out] neigh An allocated element of \a neigh_scheme. On output
+   *                      the face neighbor of \a elem in the neighbor tree.
+   * \param [in] neigh_root_face The face of the neighbor tree.
+   * \return              The face of \a neigh that coincides with the face
+   *                      of \a elem.
+   * We provide a default implementation of this routine that uses a
+   * temporary boundary element. It should be overwritten if the neighbor
+   * can be computed directly.
+   */
+  virtual int         t8_element_face_neighbor_across_tree (const
+                                                            t8_element_t *
+                                                            elem, int face,
+                                                            t8_eclass_scheme_c
+                                                            * boundary_scheme,
+                                                            int orientation,
+                                                            int sign,
+                                                            int
+                                                            is_smaller_face,
+                                                            t8_eclass_scheme_c
+                                                            * neigh_scheme,
+                                                            t8_element_t *
+                                                            neigh,
+                                                            int
+                                                            neigh_root_face);
+
   /** Construct the first descendant of an element that touches a given face.
    * \param [in] elem      The input element.
    * \param [in] face      A face of \a elem.
@@ -546,6 +583,105 @@ public:
   virtual void        t8_element_successor (const t8_element_t * t,
                                             t8_element_t * s, int level) = 0;
 
+  /** Initialize a range of consecutive elements of a uniform refinement.
+   * The i-th element of \a elements is set to the element with linear id
+   * \a first_id + i in the uniform refinement of level \a level.
+   * \param [in,out] elements An array of \a count elements, for example
+   *                      obtained from a \ref t8_element_array_t.
+   *                      On output the elements are set as described above.
+   * \param [in] level    The level of the uniform refinement to consider.
+   * \param [in] first_id The linear id of the first element.
+   * \param [in] count    The number of elements to set.
+   *                      first_id + count must not exceed the
+   *                      number of leafs in the uniform refinement.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_set_linear_id for the first element and
+   * \ref t8_element_successor for all others.
+   */
+  virtual void        t8_element_set_linear_id_range (t8_element_t *
+                                                      elements, int level,
+                                                      t8_linearidx_t
+                                                      first_id,
+                                                      t8_locidx_t count);
+
+  /** Compute the levels of a range of consecutive elements.
+   * \param [in] elements An array of \a count elements, for example
+   *                      obtained from a \ref t8_element_array_t.
+   * \param [in] count    The number of elements.
+   * \param [out] levels  An array of \a count integers. On output
+   *                      levels[i] is the level of the i-th element.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_level for each element.
+   */
+  virtual void        t8_element_level_batch (const t8_element_t *
+                                              elements, t8_locidx_t count,
+                                              int *levels);
+
+  /** Compute the linear ids of a range of consecutive elements.
+   * \param [in] elements An array of \a count elements.
+   * \param [in] count    The number of elements.
+   * \param [in] level    The level of the uniform refinement to consider.
+   * \param [out] ids     An array of \a count linear ids. On output
+   *                      ids[i] is the linear id of the i-th element.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_get_linear_id for each element.
+   */
+  virtual void        t8_element_get_linear_id_batch (const t8_element_t *
+                                                      elements,
+                                                      t8_locidx_t count,
+                                                      int level,
+                                                      t8_linearidx_t * ids);
+
+  /** Compute the integer coordinates of a vertex for a range of
+   * consecutive elements.
+   * \param [in] elements An array of \a count elements.
+   * \param [in] count    The number of elements.
+   * \param [in] vertex   The id of the vertex whose coordinates are computed.
+   * \param [out] coords  An array of 3 * \a count integers. On output the
+   *                      entries 3 * i, ..., 3 * i + dim - 1 are the
+   *                      coordinates of \a vertex of the i-th element.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_vertex_coords for each element.
+   */
+  virtual void        t8_element_vertex_coords_batch (const t8_element_t *
+                                                      elements,
+                                                      t8_locidx_t count,
+                                                      int vertex,
+                                                      int *coords);
+
+  /** Construct the children of a range of consecutive elements.
+   * All elements must have the same number of children.
+   * \param [in] elements An array of \a count elements.
+   * \param [in] count    The number of elements.
+   * \param [in,out] children An array of \a count times the number of
+   *                      children of an element. On output the children of
+   *                      the i-th element are stored consecutively starting
+   *                      at position i times the number of children.
+   *                      This array must not overlap with \a elements.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_children for each element.
+   */
+  virtual void        t8_element_children_batch (const t8_element_t *
+                                                 elements, t8_locidx_t count,
+                                                 t8_element_t * children);
+
+  /** Compare the elements of two ranges of consecutive elements pairwise.
+   * \param [in] elements1 An array of \a count elements.
+   * \param [in] elements2 An array of \a count elements.
+   * \param [in] count    The number of elements.
+   * \param [out] results An array of \a count integers. On output
+   *                      results[i] is the result of \ref t8_element_compare
+   *                      for the i-th elements of both arrays.
+   * We provide a default implementation of this routine that calls
+   * \ref t8_element_compare for each pair of elements.
+   */
+  virtual void        t8_element_compare_batch (const t8_element_t *
+                                                elements1,
+                                                const t8_element_t *
+                                                elements2,
+                                                t8_locidx_t count,
+                                                int *results);
+
 /** Get the integer coordinates of the anchor node of an element */
   /* TODO: better document this */
   virtual void        t8_element_anchor (const t8_element_t * elem,
@@ -568,6 +704,19 @@ public:
   virtual void        t8_element_vertex_coords (const t8_element_t * t,
                                                 int vertex, int coords[]) = 0;
 
+  /** Compute an axis aligned box in integer coordinates that contains an
+   * element, in the coordinates of \ref t8_element_vertex_coords.
+   * \param [in] elem     The element to be considered.
+   * \param [out] box     The minimum coordinates followed by the maximum
+   *                      coordinates. Entries beyond the dimension of the
+   *                      element are 0.
+   * We provide a default implementation of this routine that computes the
+   * box of the element's vertices. It should be overwritten if the box
+   * is known from the anchor and the level of an element.
+   */
+  virtual void        t8_element_bounding_box (const t8_element_t * elem,
+                                               int box[6]);
+
   /* TODO: deactivate */
   /** Return a pointer to a t8_element in an array indexed by a size_t.
    * \param [in] array    The \ref sc_array storing \t t8_element_t pointers.
@@ -614,6 +763,7 @@ public:
    * \note If an element was created by \ref t8_element_new then \ref t8_element_init
    * may not be called for it. Thus, \ref t8_element_new should initialize an element
    * in the same way as a call to \ref t8_element_init would.
+   * \note This function may be called concurrently from several threads.
    * \see t8_element_init
    * \see t8_element_is_valid
    */
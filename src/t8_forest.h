@@ -36,10 +36,13 @@
 /** Opaque pointer to a forest implementation. */
 typedef struct t8_forest *t8_forest_t;
 typedef struct t8_tree *t8_tree_t;
+typedef struct t8_forest_pool *t8_forest_pool_t;
 
 /** This type controls, which neighbors count as ghost elements.
  * Currently, we support face-neighbors. Vertex and edge neighbors
- * will eventually be added. */
+ * will eventually be added. They require vertex and edge neighbor
+ * functions in the element schemes and vertex and edge connectivity
+ * between the trees of the cmesh, which are both not available yet. */
 typedef enum
 {
   T8_GHOST_NONE = 0,  /**< Do not create ghost layer. */
@@ -48,6 +51,36 @@ typedef enum
   T8_GHOST_VERTICES   /**< Consider all vertex (codimension 3) and edge and face neighbors. */
 } t8_ghost_type_t;
 
+/** A cursor to iterate over all local elements of a forest in order of
+ * their local index without searching for their trees.
+ * \see t8_forest_element_cursor_init */
+typedef struct t8_forest_element_cursor
+{
+  t8_forest_t         forest;           /**< The forest. */
+  t8_locidx_t         lelement_id;      /**< The local index of the current element. */
+  t8_locidx_t         ltreeid;          /**< The local tree of the current element. */
+  t8_locidx_t         tree_element_id;  /**< The index of the current element in its tree. */
+  t8_locidx_t         tree_num_elements; /**< The number of elements of the current tree. */
+  t8_tree_t           tree;             /**< The current tree. */
+  t8_eclass_scheme_c *ts;               /**< The eclass scheme of the current tree. */
+  t8_element_t       *element;          /**< The current element. */
+} t8_forest_element_cursor_t;
+
+/** The categories in which \ref t8_forest_memory_usage reports
+ * the allocated bytes of a forest. */
+typedef enum t8_forest_memory
+{
+  T8_FOREST_MEMORY_STRUCT = 0,  /**< The forest struct, its tree array and profile. */
+  T8_FOREST_MEMORY_ELEMENTS,    /**< The element arrays of the local trees, or their compact form. */
+  T8_FOREST_MEMORY_GHOSTS,      /**< The ghost layer. */
+  T8_FOREST_MEMORY_FACES,       /**< The face neighbor table. */
+  T8_FOREST_MEMORY_OFFSETS,     /**< The shared or compact partition tables. */
+  T8_FOREST_MEMORY_INDEX,       /**< The element to tree index, owner table and traversal order. */
+  T8_FOREST_MEMORY_GEOMETRY,    /**< The cached element geometry. */
+  T8_FOREST_MEMORY_CMESH,       /**< The coarse mesh, see \ref t8_cmesh_memory_usage. */
+  T8_FOREST_MEMORY_NUM_CATEGORIES /**< The number of categories. */
+} t8_forest_memory_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /* TODO: if eclass is a vertex then num_outgoing/num_incoming are always
@@ -88,6 +121,22 @@ typedef void        (*t8_forest_replace_t) (t8_forest_t forest_old,
                                             int num_incoming,
                                             t8_locidx_t first_incoming);
 
+/** Callback function prototype to place the memory of a forest.
+ * It is called for the storage of the local trees and for the element
+ * array of each local and ghost tree when the forest is committed.
+ * The memory is allocated and already filled, so the callback may only
+ * change how it is placed, for example with mbind from libnuma to
+ * interleave it or to move it to a NUMA node.
+ * \param [in] forest      The forest that is committed.
+ * \param [in] memory      The start of the memory.
+ * \param [in] num_bytes   The size of the memory in bytes.
+ * \param [in] user_data   The user data passed to \ref t8_forest_set_memory_advice.
+ */
+typedef void        (*t8_forest_memory_advise_t) (t8_forest_t forest,
+                                                  void *memory,
+                                                  size_t num_bytes,
+                                                  void *user_data);
+
 /** Callback function prototype to decide for refining and coarsening.
  * If the \a num_elements equals the number of children then the elements
  * form a family and we decide whether this family should be coarsened
@@ -115,6 +164,78 @@ typedef int         (*t8_forest_adapt_t) (t8_forest_t forest,
                                           int num_elements,
                                           t8_element_t * elements[]);
 
+/** Callback function prototype to decide for refining and coarsening of all
+ * elements of a tree at once.
+ * This is the batched version of \ref t8_forest_adapt_t. Instead of being called
+ * once for each element or family, it is called once per local tree with all
+ * leaf elements of that tree in \a forest_from.
+ * For each element index i, \a family_first[i] is nonzero if and only if the
+ * elements i, i + 1, ..., i + num_children - 1 form a family.
+ * On output, \a markers[i] must be
+ *   greater zero if element i should be refined,
+ *   smaller zero if the family starting at i should be coarsened
+ *                (only allowed if \a family_first[i] is nonzero),
+ *   zero else.
+ * The markers of the elements i + 1, ..., i + num_children - 1 of a family
+ * that is coarsened are ignored.
+ * \param [in] forest      the forest to which the new elements belong
+ * \param [in] forest_from the forest that is adapted.
+ * \param [in] which_tree  the local tree containing \a elements
+ * \param [in] ts          the eclass scheme of the tree
+ * \param [in] elements    The leaf elements of \a which_tree in \a forest_from.
+ * \param [in] family_first For each element a flag whether a family starts
+ *                         at this element.
+ * \param [out] markers    An array of as many entries as \a elements.
+ *                         On output the refine/keep/coarsen markers as described above.
+ * \see t8_forest_set_adapt_batch
+ */
+typedef void        (*t8_forest_adapt_batch_t) (t8_forest_t forest,
+                                                t8_forest_t forest_from,
+                                                t8_locidx_t which_tree,
+                                                t8_eclass_scheme_c * ts,
+                                                t8_element_array_t *
+                                                elements,
+                                                const int8_t * family_first,
+                                                int *markers);
+
+/** Callback function prototype to compute the weight of an element for
+ * a weighted partition.
+ * \param [in] forest_from the forest that is partitioned.
+ * \param [in] which_tree  the local tree containing \a element
+ * \param [in] lelement_id the local element id in \a forest_from in the tree of \a element
+ * \param [in] ts          the eclass scheme of the tree
+ * \param [in] element     the element
+ * \return                 The weight of \a element. Must be non-negative.
+ * \see t8_forest_set_partition_weight
+ */
+typedef double      (*t8_forest_partition_weight_t) (t8_forest_t forest_from,
+                                                     t8_locidx_t which_tree,
+                                                     t8_locidx_t lelement_id,
+                                                     t8_eclass_scheme_c * ts,
+                                                     const t8_element_t *
+                                                     element);
+
+/** Quality measures of the partition of a forest.
+ * The first entries are local to each process, the last entries are
+ * the same on each process. \see t8_forest_partition_stats */
+typedef struct
+{
+  t8_locidx_t         num_elements; /**< The number of local elements. */
+  t8_locidx_t         num_ghosts; /**< The number of ghost elements. */
+  t8_locidx_t         num_remote_faces; /**< The number of faces of local elements
+                                             that touch an element of another process. */
+  int                 num_neighbor_ranks; /**< The number of processes that share a face with this process. */
+  double              surface_to_volume; /**< The ratio of remote faces to local elements. */
+  double              ghost_ratio; /**< The ratio of ghost elements to local elements. */
+  double              element_imbalance; /**< The maximum number of local elements over all
+                                              processes divided by the average number. */
+  t8_gloidx_t         global_num_remote_faces; /**< The sum of \a num_remote_faces over all processes.
+                                                    Each face between two processes is counted twice. */
+  int                 max_neighbor_ranks; /**< The maximum of \a num_neighbor_ranks over all processes. */
+  double              max_surface_to_volume; /**< The maximum of \a surface_to_volume over all processes. */
+  double              max_ghost_ratio; /**< The maximum of \a ghost_ratio over all processes. */
+} t8_forest_partition_stats_t;
+
   /** Create a new forest with reference count one.
  * This forest needs to be specialized with the t8_forest_set_* calls.
  * Currently it is manatory to either call the functions \ref
@@ -161,6 +282,20 @@ int                 t8_forest_is_committed (t8_forest_t forest);
 int                 t8_forest_is_equal (t8_forest_t forest_a,
                                         t8_forest_t forest_b);
 
+/** Compute a checksum of the elements of a committed forest.
+ * Each element contributes a hash of its global tree id, its level and
+ * its first descendant's linear id and the contributions are added up
+ * over all processes. Thus the checksum does not depend on the partition
+ * and two forests with the same elements on the same cmesh have the same
+ * checksum. Compared to \ref t8_forest_is_equal this is a cheap global
+ * equality check, however different forests may have the same checksum
+ * with a small probability.
+ * \param [in] forest   A committed forest that is not compressed.
+ * \return              The checksum of \a forest.
+ * \note This function is collective over the communicator of \a forest.
+ */
+uint64_t            t8_forest_checksum (t8_forest_t forest);
+
 /** Set the cmesh associated to a forest.
  * By default, the forest takes ownership of the cmesh such that it will be
  * destroyed when the forest is destroyed.  To keep ownership of the cmesh,
@@ -205,6 +340,9 @@ void                t8_forest_set_level (t8_forest_t forest, int level);
  * from, call \ref t8_forest_ref before passing it into this function.
  * This means that it is ILLEGAL to continue using \b from or dereferencing it
  * UNLESS it is referenced directly before passing it into this function.
+ * The copy does not duplicate the elements. Both forests share the element
+ * arrays of their trees, which are freed with the last forest that uses them.
+ * Thus copying costs memory and time per tree, not per element.
  * \param [in,out] forest     The forest.
  * \param [in]     from       A second forest from which \a forest will be copied
  *                            in \ref t8_forest_commit.
@@ -237,12 +375,63 @@ void                t8_forest_set_copy (t8_forest_t forest,
  * 1) Adapt 2) Balance 3) Partition
  * \note This setting may not be combined with \ref t8_forest_set_copy and overwrites
  * this setting.
+ * \note If \b forest holds the only reference to \b set_from when it is adapted,
+ * the element arrays of trees without any changes are moved from \b set_from
+ * to \b forest instead of being copied.
  */
 void                t8_forest_set_adapt (t8_forest_t forest,
                                          const t8_forest_t set_from,
                                          t8_forest_adapt_t adapt_fn,
                                          int recursive);
 
+/** Set a source forest with a batched adapt function to be adapted on commiting.
+ * This is an alternative to \ref t8_forest_set_adapt. Instead of calling an
+ * adapt function for each element, \a adapt_batch_fn is called once for each
+ * local tree and fills a marker array for all elements of the tree.
+ * The ownership of \a set_from is handled as in \ref t8_forest_set_adapt.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The source forest from which \b forest will be adapted.
+ *                          We take ownership. This can be prevented by
+ *                          referencing \b set_from.
+ *                          If NULL, a previously (or later) set forest will
+ *                          be taken (\ref t8_forest_set_partition, \ref t8_forest_set_balance).
+ * \param [in] adapt_batch_fn The batched adapt function used on commiting.
+ * \note Batched adaptation is never recursive.
+ * \note This setting can be combined with \ref t8_forest_set_partition and \ref
+ * t8_forest_set_balance, but not with \ref t8_forest_set_adapt.
+ */
+void                t8_forest_set_adapt_batch (t8_forest_t forest,
+                                               const t8_forest_t set_from,
+                                               t8_forest_adapt_batch_t
+                                               adapt_batch_fn);
+
+/** Set the number of threads used to adapt the local trees of a forest
+ * concurrently during commit.
+ * Each local tree is adapted by exactly one thread and the element offsets of
+ * the trees are computed afterwards.
+ * This is only effective if t8code was configured with --enable-openmp.
+ * Otherwise, the trees are adapted serially.
+ * \param [in,out] forest   The forest.
+ * \param [in]     num_threads The number of threads. 0 or 1 for serial adaptation,
+ *                          a negative number to use \ref t8_get_num_threads threads.
+ * \note If \a num_threads > 1, the adapt callback (\ref t8_forest_adapt_t or
+ * \ref t8_forest_adapt_batch_t) must be reentrant: It is called concurrently for
+ * elements of different trees, the calls for one tree are always made from the
+ * same thread and in order. The callback may read the forests, the user data
+ * and the element scheme, but it must not modify data that is shared between
+ * trees without synchronizing. It must not call MPI.
+ * The callback may allocate elements with \ref t8_element_new, since the
+ * default schemes serialize their allocations inside of parallel regions.
+ * \note With \ref t8_forest_set_adapt_batch and a single local tree, the new
+ * elements of this tree are built by several threads if it has enough
+ * elements. The batched adapt callback is still called once from one thread.
+ * \note If \a num_threads > 1, libsc should be configured with --enable-pthread,
+ * such that its memory accounting is thread-safe.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_adapt_threads (t8_forest_t forest,
+                                                 int num_threads);
+
 /** Set the user data of a forest. This can i.e. be used to pass user defined
  * arguments to the adapt routine.
  * \param [in,out] forest   The forest
@@ -268,9 +457,11 @@ void               *t8_forest_get_user_data (t8_forest_t forest);
  *                          referencing \b set_from.
  *                          If NULL, a previously (or later) set forest will
  *                          be taken (\ref t8_forest_set_adapt, \ref t8_forest_set_balance).
- * \param [in]      set_for_coarsening CURRENTLY DISABLED. If true, then the partitions
+ * \param [in]      set_for_coarsening If true, then the partitions
  *                          are choose such that coarsening an element once is a process local
- *                          operation.
+ *                          operation. Process boundaries are moved to the front of families
+ *                          whose elements are all local on one process of \b set_from.
+ *                          Families that already were split are not considered.
  * \note This setting can be combined with \ref t8_forest_set_adapt and \ref
  * t8_forest_set_balance. The order in which these operations are executed is always
  * 1) Adapt 2) Balance 3) Partition
@@ -283,6 +474,104 @@ void                t8_forest_set_partition (t8_forest_t forest,
                                              const t8_forest_t set_from,
                                              int set_for_coarsening);
 
+/** Partition a forest such that each rank is assigned the same (up to
+ * the weight of one element) sum of element weights instead of the same
+ * number of elements.
+ * The weight of each element is either taken from a callback or from an array.
+ * \param [in, out] forest  The forest.
+ * \param [in]      weight_fn If not NULL, the callback that is called for each
+ *                          element of the partitioned forest to compute its weight.
+ * \param [in]      weights If not NULL, an array with the non-negative weight of each
+ *                          local element of \b set_from of \ref t8_forest_set_partition.
+ *                          It must stay valid until \a forest is committed. An array may
+ *                          only be used if \b forest is not adapted or balanced in the
+ *                          same commit, since otherwise the partitioned forest is an
+ *                          intermediate one. If \a weight_fn is not NULL, this is ignored.
+ * \note If the weights of all elements are zero, the forest is partitioned by
+ * number of elements.
+ * \note This setting only has an effect if \ref t8_forest_set_partition is called, too.
+ * It is not used for the partitioning during \ref t8_forest_set_balance.
+ */
+void                t8_forest_set_partition_weight (t8_forest_t forest,
+                                                    t8_forest_partition_weight_t
+                                                    weight_fn,
+                                                    const double *weights);
+
+/** Register an array of element data that is partitioned together with the
+ * elements of a forest. The data is sent in the same messages as the elements,
+ * so that partitioning a forest with k data arrays costs one round of
+ * communication instead of k + 1 rounds with \ref t8_forest_partition_data.
+ * This function may be called several times to register multiple arrays.
+ * \param [in, out] forest  The forest.
+ * \param [in]      data_in An array with one entry for each local element of
+ *                          \b set_from of \ref t8_forest_set_partition.
+ *                          It must stay valid until \a forest is committed.
+ * \param [in,out]  data_out An array with the same element size as \a data_in.
+ *                          It is resized to the number of local elements of
+ *                          \a forest during \ref t8_forest_commit and filled with
+ *                          the data of these elements. It must not be \a data_in.
+ * \note As for the weights in \ref t8_forest_set_partition_weight, data can only
+ * be registered if \a forest is not adapted or balanced in the same commit.
+ * \see t8_forest_partition_data
+ */
+void                t8_forest_set_partition_data (t8_forest_t forest,
+                                                  const sc_array_t * data_in,
+                                                  sc_array_t * data_out);
+
+/** Only partition a forest if the load imbalance of its source exceeds a
+ * threshold. The imbalance is the maximum number of local elements
+ * over all processes divided by the average number, computed with one
+ * reduction. If it is at most \a threshold, the full partition is skipped
+ * and the elements keep their process. The partition offsets and, if the
+ * forest is only partitioned, the ghost layer of \b set_from are reused.
+ * Partition data registered with \ref t8_forest_set_partition_data is
+ * copied.
+ * \param [in, out] forest   The forest.
+ * \param [in]      threshold The imbalance up to which the partition is
+ *                           skipped. The default 0, or any value smaller
+ *                           than 1, always partitions the forest.
+ * \note This setting only has an effect if \ref t8_forest_set_partition is
+ * called, too. The imbalance ignores weights set with
+ * \ref t8_forest_set_partition_weight.
+ */
+void                t8_forest_set_partition_threshold (t8_forest_t forest,
+                                                       double threshold);
+
+/** Partition a forest diffusively, such that elements only move between
+ * processes that are adjacent in the space-filling curve order.
+ * The new first element of each process is the one of the usual partition,
+ * but clamped to lie between the old first elements of its two
+ * neighboring processes. Each process thus sends to and receives from at
+ * most its two neighbors, which limits the migration volume and the number
+ * of messages for nearly balanced forests, at the cost of a possibly
+ * remaining imbalance that is removed over several partitions.
+ * \param [in, out] forest   The forest.
+ * \param [in]      diffusive If true, the forest is partitioned diffusively.
+ * \note This setting only has an effect if \ref t8_forest_set_partition is
+ * called, too. It can be combined with \ref t8_forest_set_partition_weight.
+ */
+void                t8_forest_set_partition_diffusive (t8_forest_t forest,
+                                                       int diffusive);
+
+/** Partition a forest only to the first processes of its communicator.
+ * The elements are distributed among the processes with rank smaller than
+ * \a num_ranks, all other processes own no elements and no trees after
+ * partitioning. If the cmesh is partitioned, it is repartitioned
+ * accordingly and stays consistent with the forest.
+ * Use \ref t8_forest_get_active_comm to obtain a communicator of the
+ * processes that own elements.
+ * \param [in, out] forest   The forest.
+ * \param [in]      num_ranks The number of processes that own elements.
+ *                           If 0 or at least the size of the communicator,
+ *                           all processes are used, which is the default.
+ * \note This setting only has an effect if \ref t8_forest_set_partition is
+ * called, too. It can be combined with \ref t8_forest_set_partition_weight.
+ * It cannot be combined with \ref t8_forest_set_partition_diffusive, and the
+ * partition is never skipped by \ref t8_forest_set_partition_threshold.
+ */
+void                t8_forest_set_partition_ranks (t8_forest_t forest,
+                                                   int num_ranks);
+
 /** Set a source forest to be balanced during commit.
  * A forest is said to be balanced if each element has face neighbors of level
  * at most +1 or -1 of the element's level.
@@ -303,6 +592,9 @@ void                t8_forest_set_partition (t8_forest_t forest,
  * \note This setting can be combined with \ref t8_forest_set_adapt and \ref
  * t8_forest_set_balance. The order in which these operations are executed is always
  * 1) Adapt 2) Balance 3) Partition.
+ * If combined with \ref t8_forest_set_partition, the intermediate forests of
+ * balance are not repartitioned regardless of \a no_repartition. Instead the
+ * balanced forest is partitioned once.
  * \note This setting may not be combined with \ref t8_forest_set_copy and overwrites
  * this setting.
  */
@@ -327,17 +619,352 @@ void                t8_forest_set_ghost (t8_forest_t forest, int do_ghost,
  * \param [in]      ghost_version If 1, the iterative ghost algorithm for balanced forests is used.
  *                                If 2, the iterativ algorithm for unbalanced forests.
  *                                If 3, the top-down search algorithm for unbalanced forests.
+ * \param [in]      ghost_depth   The number of ghost layers. If 1, the ghost layer
+ *                                consists of the face-neighbors of the local elements.
+ *                                If k > 1, the local elements that are reachable
+ *                                from a process's face-neighbor ghosts with at most
+ *                                k - 1 steps between local face-neighbors are
+ *                                ghosts of this process, too. Must be >= 1.
  * \see t8_forest_set_ghost
  */
 void                t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
                                              t8_ghost_type_t ghost_type,
-                                             int ghost_version);
+                                             int ghost_version,
+                                             int ghost_depth);
+
+/** Set whether the ghost layer of a forest is built and exchanged with
+ * MPI neighborhood collectives on a distributed graph communicator instead of
+ * point-to-point messages.
+ * The graph communicator connects each process with its remote processes and
+ * is stored with the ghost layer. All ghost data exchanges of the forest then
+ * use it and must be called on all processes of the forest's communicator,
+ * also on processes without elements.
+ * If MPI does not provide neighborhood collectives (MPI < 3), point-to-point
+ * messages are used regardless.
+ * \param [in,out] forest   The forest.
+ * \param [in]     use_neighborhood If true, use neighborhood collectives.
+ *                          Must be the same on all processes.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_set_ghost
+ */
+void                t8_forest_set_ghost_neighborhood (t8_forest_t forest,
+                                                      int use_neighborhood);
+
+/** Set whether processes on the same shared memory node exchange ghost data
+ * through an MPI shared memory window instead of messages.
+ * Each process packs the data of its remote elements into its segment of
+ * the window, and the remotes on the same node copy their ghost values
+ * directly from it. Only a small notification is sent per pair of processes.
+ * Remotes on other nodes still get messages. Exchanges with more than
+ * \a max_data_size bytes per element and exchanges with user packed buffers
+ * use messages for all remotes.
+ * The window is allocated when the ghost layer is created, which is then done
+ * on all processes of the forest's communicator, also on processes without
+ * elements. Since freeing the window is collective, forests with a shared
+ * ghost window must be destroyed in the same order on all processes.
+ * If MPI does not provide shared memory windows (MPI < 3), messages are used
+ * regardless.
+ * \param [in,out] forest   The forest.
+ * \param [in]     max_data_size The maximum number of bytes per element
+ *                          of exchanges through the window. 0 disables
+ *                          shared memory exchanges. Must be the same on
+ *                          all processes.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_set_ghost
+ */
+void                t8_forest_set_ghost_shared (t8_forest_t forest,
+                                                size_t max_data_size);
+
+/** Set whether ghost data is exchanged with one-sided communication instead
+ * of messages.
+ * When the ghost layer is created, each process exposes a receive buffer for
+ * its ghosts in an MPI window and learns from each remote process where its
+ * elements start among the remote's ghosts. An exchange then puts the data
+ * of the remote elements directly into the remotes' buffers, without the
+ * matching of two-sided messages, and copies the received data into the
+ * ghost entries when the exchange ends.
+ * Exchanges with more than \a max_data_size bytes per element use messages.
+ * Remotes on the same node use the shared memory window instead, if
+ * \ref t8_forest_set_ghost_shared is set as well.
+ * The window is created when the ghost layer is created, which is then done
+ * on all processes of the forest's communicator, also on processes without
+ * elements. Since freeing the window is collective, forests with an RMA
+ * ghost window must be destroyed in the same order on all processes.
+ * Exchanges through the window are finished in the order in which they were
+ * begun; beginning one finishes the previous one.
+ * \param [in,out] forest   The forest.
+ * \param [in]     max_data_size The maximum number of bytes per element
+ *                          of exchanges through the window. 0 disables
+ *                          one-sided exchanges. Must be the same on all
+ *                          processes.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_set_ghost
+ */
+void                t8_forest_set_ghost_rma (t8_forest_t forest,
+                                             size_t max_data_size);
+
+/** Set whether the elements in the messages of partition and ghost are
+ * compressed. Each element of a tree is then sent as part of a run of
+ * elements of the same level with consecutive linear ids, which is stored
+ * as the linear id of its first element, its level and its length.
+ * Neighboring parts of a forest often have the same level, so this is much
+ * smaller than the elements themselves and saves bandwidth on slow links,
+ * at the cost of encoding and decoding the elements.
+ * A message is compressed if it holds at least \a min_bytes bytes of
+ * elements and its runs are smaller than its elements.
+ * \param [in,out] forest   The forest.
+ * \param [in]     min_bytes The minimum number of bytes of elements in a
+ *                          compressed message. 0 disables compression.
+ *                          Must be the same on all processes.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_set_partition \see t8_forest_set_ghost
+ */
+void                t8_forest_set_message_compression (t8_forest_t forest,
+                                                       size_t min_bytes);
+
+/** Set whether a table of the face neighbors of all local leafs is built
+ * when the forest is committed.
+ * The table stores for each face of each local leaf the indices of its
+ * neighbor leafs, including ghosts, their dual faces and whether the face
+ * is hanging. Its entries are the same as those of
+ * \ref t8_forest_leaf_face_neighbors, but they can be read with
+ * \ref t8_forest_get_face_neighbors without allocations or searches.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_face_neighbors If true, build the table.
+ * The forest must not be committed before calling this function.
+ * \note The committed forest must be balanced. On more than one process
+ *       a face ghost layer is required, \see t8_forest_set_ghost.
+ */
+void                t8_forest_set_face_neighbors (t8_forest_t forest,
+                                                  int do_face_neighbors);
+
+/** Set whether the geometry of the leafs is cached when the forest is committed.
+ * The centroid and volume of each local and ghost leaf and the area and
+ * normal of each of its faces are computed once and stored in the forest.
+ * Afterwards \ref t8_forest_element_centroid, \ref t8_forest_element_volume,
+ * \ref t8_forest_element_face_area and \ref t8_forest_element_face_normal
+ * return the stored values for leafs of the forest, if they are called with
+ * the vertices of the leaf's tree.
+ * Ghosts are only cached if the vertices of all ghost trees are known.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_cache If true, build the cache.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_geometry_cache (t8_forest_t forest,
+                                                  int do_cache);
+
+/** Set how the memory of the elements of a forest is placed.
+ * The element arrays are allocated through sc and filled when the forest
+ * is committed. Afterwards, the storage of the local trees and the element
+ * array of each local and ghost tree can be advised to use transparent huge
+ * pages, which reduces TLB misses when traversing large forests, and are
+ * passed to a user callback, which may place them on NUMA nodes.
+ * \param [in,out] forest   The forest.
+ * \param [in]     hugepages If true, advise the element arrays to use
+ *                          transparent huge pages. Only arrays that span at
+ *                          least one whole page are advised, and only if
+ *                          madvise is available.
+ * \param [in]     advise_fn If not NULL, called for the memory of each array
+ *                          after the huge page advice.
+ * \param [in]     user_data Passed to \a advise_fn.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_memory_advice (t8_forest_t forest,
+                                                 int hugepages,
+                                                 t8_forest_memory_advise_t
+                                                 advise_fn, void *user_data);
+
+/** Create a pool that keeps the element memory of destroyed forests for
+ * reuse. When a forest that uses a pool is destroyed, the element arrays of
+ * its trees are handed to the pool instead of being freed, as long as the
+ * pool holds less than \a max_bytes. A forest that is committed with the
+ * same pool takes the smallest buffer that fits each of its trees, so that
+ * repeated adapt and partition cycles allocate little new memory.
+ * The pool is reference counted and freed with its last reference.
+ * \param [out]    ppool     On output, the new pool with one reference.
+ * \param [in]     max_bytes The maximum number of bytes kept in the pool.
+ * \see t8_forest_set_pool
+ */
+void                t8_forest_pool_init (t8_forest_pool_t * ppool,
+                                         size_t max_bytes);
+
+/** Increase the reference counter of a pool.
+ * \param [in,out] pool     A pool with positive reference count.
+ */
+void                t8_forest_pool_ref (t8_forest_pool_t pool);
+
+/** Decrease the reference counter of a pool.
+ * If the counter reaches zero, the pool and all memory kept in it is freed.
+ * \param [in,out] ppool    On input, a pool with positive reference count.
+ *                          If the pool is freed, it is set to NULL.
+ */
+void                t8_forest_pool_unref (t8_forest_pool_t * ppool);
+
+/** Set a pool from which a forest takes its element memory.
+ * The forest takes ownership of one reference of \a pool. To keep using
+ * the pool, call \ref t8_forest_pool_ref before passing it.
+ * A forest that is committed from another forest uses the pool of the
+ * other forest, unless it was given a pool with this function.
+ * \param [in,out] forest   The forest.
+ * \param [in]     pool     A pool created with \ref t8_forest_pool_init.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_pool (t8_forest_t forest,
+                                        t8_forest_pool_t pool);
+
+/** Set whether the geometry of a forest is stored and written in single
+ * precision. If true, the geometry cache stores its values as float, see
+ * \ref t8_forest_set_geometry_cache, and the vtk output of the forest writes
+ * coordinates and data as Float32, see \ref t8_forest_vtk_write_file_format.
+ * All computations are still done in double precision, only the stored
+ * results are rounded. This halves the memory of the cache and the size of
+ * binary vtk files, which is enough for visualization and for refinement
+ * indicators.
+ * \param [in,out] forest   The forest.
+ * \param [in]     use_float If true, use single precision.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_geometry_float (t8_forest_t forest,
+                                                  int use_float);
+
+/** Return whether the geometry of a forest is stored in single precision.
+ * \param [in]     forest   The forest.
+ * \return                  True if \ref t8_forest_set_geometry_float was
+ *                          called with true for \a forest.
+ */
+int                 t8_forest_get_geometry_float (t8_forest_t forest);
 
-/* TODO: use assertions and document that the forest_set (..., from) and
- *       set_load are mutually exclusive. */
+/** Set whether an array that maps each local element to its local tree is
+ * built when the forest is committed. With this array,
+ * \ref t8_forest_get_element runs in constant time instead of searching
+ * the trees. It uses one t8_locidx_t per local element.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_index If true, build the array.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_element_tree_index (t8_forest_t forest,
+                                                      int do_index);
+
+/** Set whether an array of the levels of the local elements is built when
+ * the forest is committed. Loops that only need the levels of the elements,
+ * as the maximum level in balance or the level output to vtk, then read one
+ * byte per element from a contiguous array instead of the element structs.
+ * It uses one int8_t per local element.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_levels If true, build the array.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_get_element_levels
+ */
+void                t8_forest_set_element_levels (t8_forest_t forest,
+                                                  int do_levels);
+
+/** Set whether the local elements and ghosts are grouped by level when the
+ * forest is committed. For each level, the indices of its local elements and
+ * ghosts are stored contiguously, such that loops over the elements of some
+ * levels, as in local time stepping, do not scan all elements. The maximum
+ * existing level of the forest is computed with the lists, which makes the
+ * commit collective over one additional integer.
+ * It uses about one t8_locidx_t per local element and ghost.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_lists If true, build the lists.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_get_level_elements, t8_forest_get_level_ghosts
+ */
+void                t8_forest_set_level_lists (t8_forest_t forest,
+                                               int do_lists);
+
+/** Set whether a copy of the partition tables, laid out for fast owner
+ * searches, is built when the forest is committed.
+ * \ref t8_forest_element_find_owner and the owner searches of the ghost
+ * layer then use this table instead of the shared partition arrays.
+ * It uses about 24 bytes per nonempty process on each process.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_table If true, build the table.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_owner_table (t8_forest_t forest,
+                                               int do_table);
+
+/** Set whether the partition tables of a forest are stored compressed.
+ * The shared partition tables store the first element, the first tree and
+ * the first descendant of each process and thus need 24 bytes per process
+ * on each process or node. If set, a compressed copy is built when the
+ * forest is committed, which uses a few bytes per nonempty process, and
+ * the shared tables are freed.
+ * \ref t8_forest_element_find_owner and
+ * \ref t8_forest_get_first_local_element_id then use the compressed copy.
+ * Collective algorithms that need the shared tables, such as partition
+ * and ghost, recreate them when they are called.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_compact If true, compress the partition tables.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_partition_compact (t8_forest_t forest,
+                                                     int do_compact);
+
+/** Set whether a traversal order of the local elements is computed when the
+ * forest is committed. In this order, the local trees are sorted along a
+ * Hilbert curve through their centroids and the elements of each tree
+ * follow in their SFC order. Trees that are close in space are then close
+ * in the order, even if their local tree ids are far apart, as for a
+ * cmesh that was not reordered. Loops over element data that access the
+ * neighbors of an element benefit from this order.
+ * It uses one t8_locidx_t per local tree and per local element.
+ * \param [in,out] forest   The forest.
+ * \param [in]     do_order If true, compute the traversal order.
+ * The forest must not be committed before calling this function.
+ * \see t8_forest_get_traversal_order
+ */
+void                t8_forest_set_traversal_order (t8_forest_t forest,
+                                                   int do_order);
+
+/** Set a forest to be loaded from a file that was written with
+ * \ref t8_forest_save when it is committed.
+ * The cmesh and the scheme must be set with \ref t8_forest_set_cmesh and
+ * \ref t8_forest_set_scheme. The cmesh must be the same as the cmesh of
+ * the saved forest and the scheme must use the same element layout.
+ * The file can be loaded on any number of processes. The elements are
+ * distributed evenly among the processes of the forest. If the cmesh is
+ * partitioned, it is repartitioned to match the loaded forest.
+ * \param [in,out] forest   The forest.
+ * \param [in]     filename The file to load the forest from.
+ * The forest must not be committed before calling this function.
+ * This setting and \ref t8_forest_set_level or deriving the forest from
+ * another one are mutually exclusive.
+ * \see t8_forest_load
+ */
 void                t8_forest_set_load (t8_forest_t forest,
                                         const char *filename);
 
+/** Set the local leaves of a forest that is built from them when it is
+ * committed. The leaves are given as their global tree, the level and the
+ * linear id in the uniform refinement of this level of the tree. They must
+ * be sorted by tree and by their position in the tree and must not overlap.
+ * Each tree between the first and the last tree of the leaves must have
+ * at least one leaf on this process. The processes must hold consecutive
+ * parts of the forest in the order of their ranks.
+ * The elements are created in one pass over the leaves, thus this is the
+ * fastest way to build a forest for which the leaves are known.
+ * The cmesh and the scheme must be set with \ref t8_forest_set_cmesh and
+ * \ref t8_forest_set_scheme. If the cmesh is partitioned, the trees of the
+ * leaves must be local in it and it is repartitioned to match the forest.
+ * \param [in,out] forest   The forest.
+ * \param [in]     num_leaves The number of local leaves.
+ * \param [in]     trees    The global tree of each leaf.
+ * \param [in]     ids      The linear id of each leaf at its level.
+ * \param [in]     levels   The refinement level of each leaf.
+ * The arrays are not copied and must stay valid until the forest is
+ * committed.
+ * The forest must not be committed before calling this function.
+ * This setting, \ref t8_forest_set_level, \ref t8_forest_set_load and
+ * deriving the forest from another one are mutually exclusive.
+ */
+void                t8_forest_set_leaves (t8_forest_t forest,
+                                          t8_locidx_t num_leaves,
+                                          const t8_gloidx_t * trees,
+                                          const t8_linearidx_t * ids,
+                                          const int *levels);
+
 /** Compute the global number of elements in a forest as the sum
  *  of the local element counts.
  *  \param [in] forest    The forest.
@@ -377,6 +1004,33 @@ t8_gloidx_t         t8_forest_get_global_num_elements (t8_forest_t forest);
  */
 t8_locidx_t         t8_forest_get_num_ghosts (t8_forest_t forest);
 
+/** Return the face neighbors of a local leaf from the face neighbor table
+ * of a forest.
+ * \param [in]      forest      The forest. Must have a face neighbor table,
+ *                              \see t8_forest_set_face_neighbors.
+ * \param [in]      lelement_id The local index of a leaf of \a forest.
+ * \param [in]      face        A face of this leaf.
+ * \param [out]     neighbors   If not NULL, on output the indices of the
+ *                              neighbor leafs. 0, 1, ... num_local_el - 1 for
+ *                              local leafs and num_local_el, ... for ghosts.
+ * \param [out]     dual_faces  If not NULL, on output the face ids of the
+ *                              neighbor leafs at \a face.
+ * \param [out]     level_diff  If not NULL, on output the level of the
+ *                              neighbors minus the level of the leaf.
+ *                              Nonzero if and only if the face is hanging.
+ * \return                      The number of neighbor leafs. 0 at the domain
+ *                              boundary.
+ * The output arrays point into the table and must not be freed.
+ * \a forest must be committed before calling this function.
+ */
+int                 t8_forest_get_face_neighbors (t8_forest_t forest,
+                                                  t8_locidx_t lelement_id,
+                                                  int face,
+                                                  const t8_locidx_t
+                                                  **neighbors,
+                                                  const int8_t **dual_faces,
+                                                  int *level_diff);
+
 /** Return the element class of a forest local tree.
  *  \param [in] forest    The forest.
  *  \param [in] ltreeid   The local id of a tree in \a forest.
@@ -429,13 +1083,30 @@ t8_locidx_t         t8_forest_cmesh_ltreeid_to_ltreeid (t8_forest_t forest,
 t8_ctree_t          t8_forest_get_coarse_tree (t8_forest_t forest,
                                                t8_locidx_t ltreeid);
 
+/** Compute quality measures of the current partition of a forest.
+ * These can be used to decide whether a repartition pays off or to tune
+ * partition weights.
+ * The remote faces are found by computing the owners of the face neighbors
+ * of each local element, hence the forest does not need to be balanced.
+ * The number of neighbor ranks and ghosts are taken from the ghost layer.
+ * This function is MPI collective.
+ * \param [in]  forest    The forest. Must have a face ghost layer if it is
+ *                        distributed over more than one process.
+ * \param [out] stats     On output the partition statistics of \a forest.
+ * \a forest must be committed before calling this function.
+ */
+void                t8_forest_partition_stats (t8_forest_t forest,
+                                               t8_forest_partition_stats_t *
+                                               stats);
+
 /** Enable or disable profiling for a forest. If profiling is enabled, runtimes
  * and statistics are collected during forest_commit.
  * \param [in,out] forest        The forest to be updated.
  * \param [in]     set_profiling If true, profiling will be enabled, if false
  *                              disabled.
  *
- * Profiling is disabled by default.
+ * Profiling is disabled by default. Enabling it also enables the memory
+ * peaks of the profile regions, \see t8_profile_regions_set_memory.
  * The forest must not be committed before calling this function.
  * \see t8_forest_print_profile
  */
@@ -443,6 +1114,19 @@ void                t8_forest_set_profiling (t8_forest_t forest,
                                              int set_profiling);
 
 /** Print the collected statistics from a forest profile.
+ * For the ghost layer creation, this includes the runtimes of the
+ * remote search, the owner computation, packing, receiving and parsing,
+ * the number of sent and received bytes and the distribution of the
+ * received message sizes and latencies over all processes.
+ * It also includes the memory per process of the partition tables,
+ * which are stored once per node if shared memory is available.
+ * If hardware counters are recorded, their values for adapt, balance,
+ * partition, ghost and commit are printed as well,
+ * \see t8_profile_regions_num_hw_counters, followed by the peak heap memory
+ * of these phases if the C library reports it.
+ * Last, the bytes, messages and peer processes sent and received in
+ * partition, ghost creation, ghost exchange and balance are printed together
+ * with a histogram of the communication volume over all processes.
  * \param [in]    forest        The forest.
  *
  * \a forest must be committed before calling this function.
@@ -450,6 +1134,48 @@ void                t8_forest_set_profiling (t8_forest_t forest,
  */
 void                t8_forest_print_profile (t8_forest_t forest);
 
+/** Write the profile of each process as one line of a CSV file, to find
+ * the processes that are slow and relate them to their partition, for
+ * example with the process numbers in the vtk output.
+ * Each line holds the process number, its numbers of local trees, elements,
+ * ghosts and remote processes, the runtimes of adapt, balance, partition,
+ * ghost and commit, the wait time of the last ghost exchange, the number of
+ * balance rounds, the bytes sent in partition and ghost creation and sent and
+ * received in ghost exchanges and the peak heap memory of commit.
+ * The runtimes and bytes are 0 if profiling is not enabled.
+ * \param [in]    forest        The forest, must be committed.
+ * \param [in]    filename      The name of the file. It is written by the
+ *                              first process.
+ * \return                      True if the file was written.
+ * \note This function is collective over the forest's communicator.
+ * \see t8_forest_set_profiling
+ */
+int                 t8_forest_write_profile_csv (t8_forest_t forest,
+                                                 const char *filename);
+
+/** Count the bytes that a committed forest allocates, broken down by category.
+ * The cmesh is counted completely, even if it is shared with other forests.
+ * This function is collective over the forest's communicator.
+ * \param [in]    forest        The forest, must be committed.
+ * \param [out]   local         If not NULL, the bytes of this process for each
+ *                              category, T8_FOREST_MEMORY_NUM_CATEGORIES entries.
+ * \param [out]   sum           If not NULL, the bytes of each category summed
+ *                              over all processes.
+ * \param [out]   max           If not NULL, the maximum over all processes
+ *                              of the bytes of each category.
+ * \return                      The sum over all categories of \a local.
+ */
+size_t              t8_forest_memory_usage (t8_forest_t forest,
+                                            size_t * local, size_t * sum,
+                                            size_t * max);
+
+/** Print the memory usage of a forest, summed and maximized over processes.
+ * This function is collective over the forest's communicator.
+ * \param [in]    forest        The forest, must be committed.
+ * \see t8_forest_memory_usage
+ */
+void                t8_forest_print_memory_usage (t8_forest_t forest);
+
 /** Get the runtime of the last call to \ref t8_forest_adapt.
  * \param [in]   forest         The forest.
  * \return                      The runtime of adapt if profiling was activated.
@@ -518,6 +1244,9 @@ void                t8_forest_ghost_print (t8_forest_t forest);
 
 /** Change the cmesh associated to a forest to a partitioned cmesh that
  * is partitioned according to the tree distribution in the forest.
+ * If the local trees of the cmesh already match the local trees of the
+ * forest on each process, the cmesh is kept. Otherwise only the trees
+ * that change their owner, and their ghosts, are sent to other processes.
  * \param [in,out]   forest The forest.
  * \param [in]       comm   The MPI communicator that is used to partition
  *                          and commit the cmesh.
@@ -536,6 +1265,21 @@ void                t8_forest_partition_cmesh (t8_forest_t forest,
  */
 sc_MPI_Comm         t8_forest_get_mpicomm (t8_forest_t forest);
 
+/** Create a communicator of all processes of a forest that own elements.
+ * This is useful if the forest was partitioned to a subset of its processes
+ * with \ref t8_forest_set_partition_ranks, such that collective operations
+ * of an application do not involve the idle processes.
+ * This function is collective over the communicator of the forest.
+ * \param [in]      forest    A committed forest.
+ * \param [out]     active_comm On processes with local elements a new
+ *                             communicator of these processes, ordered
+ *                             by their rank in the forest's communicator.
+ *                             On all other processes sc_MPI_COMM_NULL.
+ *                             It must be freed with sc_MPI_Comm_free.
+ */
+void                t8_forest_get_active_comm (t8_forest_t forest,
+                                               sc_MPI_Comm * active_comm);
+
 /** Return the global id of the first local tree of a forest.
  * \param [in]      forest      The forest.
  * \return                      The global id of the first local tree in \a forest.
@@ -597,6 +1341,117 @@ double             *t8_forest_get_tree_vertices (t8_forest_t forest,
 t8_element_array_t *t8_forest_tree_get_leafs (t8_forest_t forest,
                                               t8_locidx_t ltree_id);
 
+/** Return the levels of the local elements of a forest.
+ * \param [in]      forest      A committed forest.
+ * \return          An array with the level of each local element, indexed by
+ *                  the local element id. NULL if the forest was not committed
+ *                  with \ref t8_forest_set_element_levels.
+ */
+const int8_t       *t8_forest_get_element_levels (t8_forest_t forest);
+
+/** Return the maximum refinement level of all elements of a forest.
+ * \param [in]      forest      A committed forest.
+ * \return          The maximum level of all elements on all processes.
+ *                  -1 if it was not computed, which it always is if the
+ *                  forest was committed with \ref t8_forest_set_level_lists.
+ */
+int                 t8_forest_get_maxlevel_existing (t8_forest_t forest);
+
+/** Return the local elements of a given level.
+ * \param [in]      forest      A forest committed with
+ *                              \ref t8_forest_set_level_lists.
+ * \param [in]      level       A level, 0 <= \a level.
+ * \param [out]     elements    On output the local indices of the elements
+ *                              of \a level in ascending order. NULL if the
+ *                              level does not exist.
+ * \return          The number of local elements of \a level.
+ */
+t8_locidx_t         t8_forest_get_level_elements (t8_forest_t forest,
+                                                  int level,
+                                                  const t8_locidx_t **
+                                                  elements);
+
+/** Return the ghosts of a given level.
+ * \param [in]      forest      A forest committed with
+ *                              \ref t8_forest_set_level_lists.
+ * \param [in]      level       A level, 0 <= \a level.
+ * \param [out]     ghosts      On output the indices of the ghosts of
+ *                              \a level in ascending order. The ghost with
+ *                              index i has the local index num_elements + i
+ *                              in the element data arrays of
+ *                              \ref t8_forest_ghost_exchange_data.
+ *                              NULL if the level does not exist.
+ * \return          The number of ghosts of \a level.
+ */
+t8_locidx_t         t8_forest_get_level_ghosts (t8_forest_t forest,
+                                                int level,
+                                                const t8_locidx_t ** ghosts);
+
+/** Sort the local elements of a forest by their refinement level.
+ * This gives the lists of elements of each level, as needed for local time
+ * stepping, \see t8_forest_multirate_min_level.
+ * \param [in]      forest   A committed forest.
+ * \param [in,out]  level_offsets An array of t8_locidx_t. On output it has
+ *                          maxlevel + 2 entries, with maxlevel as in
+ *                          \ref t8_forest_get_maxlevel. The elements of level
+ *                          l are the entries level_offsets[l], ...,
+ *                          level_offsets[l + 1] - 1 of \a elements.
+ * \param [in,out]  elements An array of t8_locidx_t. On output it holds the
+ *                          local indices of all local elements, sorted by
+ *                          level and ascending within each level.
+ * The levels are read from the array of \ref t8_forest_set_element_levels if
+ * it exists.
+ */
+void                t8_forest_split_levels (t8_forest_t forest,
+                                            sc_array_t * level_offsets,
+                                            sc_array_t * elements);
+
+/** Return the lowest level that takes a time step in a substep of a
+ * level-based local time stepping (multirate) schedule.
+ * One step of the coarsest level min_level consists of
+ * 2^(max_level - min_level) substeps with the time step dt of max_level.
+ * An element of level l takes a step with time step 2^(max_level - l) dt
+ * in each substep that is a multiple of 2^(max_level - l). Thus the active
+ * levels of a substep are all levels greater or equal the returned level.
+ * \param [in]      min_level The coarsest level of the schedule.
+ * \param [in]      max_level The finest level, greater or equal min_level.
+ * \param [in]      substep  The substep, 0 <= \a substep <
+ *                          2^(max_level - min_level).
+ * \return                  The lowest active level in \a substep.
+ * \note The ghost values that change in \a substep can be exchanged with
+ * \ref t8_forest_ghost_exchange_levels, passing the returned level.
+ */
+int                 t8_forest_multirate_min_level (int min_level,
+                                                   int max_level,
+                                                   int substep);
+
+/** Replace the element arrays of the local trees of a forest by a compact
+ * form. For each tree, the linear id of the first descendant of its first
+ * element is stored, and for each element its level, from which the
+ * elements are rebuilt by \ref t8_forest_decompress. This is meant for
+ * forests that are kept alive but not used for a while, for example old time
+ * levels or checkpoints. The compact form uses one byte per element.
+ * The ghost layer and all other data of the forest are kept.
+ * Until \ref t8_forest_decompress is called, the elements of the forest may
+ * not be accessed, and the forest may only be referenced, unreferenced,
+ * decompressed or passed to \ref t8_forest_memory_usage.
+ * \param [in,out] forest   A committed forest that is not compressed.
+ */
+void                t8_forest_compress (t8_forest_t forest);
+
+/** Rebuild the element arrays of a forest that was compressed with
+ * \ref t8_forest_compress and free the compact form.
+ * \param [in,out] forest   A compressed forest.
+ */
+void                t8_forest_decompress (t8_forest_t forest);
+
+/** Return whether a forest is compressed.
+ * \param [in]      forest      A committed forest.
+ * \return          True if \ref t8_forest_compress was called for \a forest
+ *                  and \ref t8_forest_decompress was not called since.
+ */
+int                 t8_forest_is_compressed (t8_forest_t forest);
+
 /** Return a cmesh associated to a forest.
  * \param [in]      forest      The forest.
  * \return          The cmesh associated to the forest.
@@ -609,13 +1464,80 @@ t8_cmesh_t          t8_forest_get_cmesh (t8_forest_t forest);
  * \param [out]     ltreeid     If not NULL, on output the local tree id of the tree in which the
  *                              element lies in.
  * \return          A pointer to the element. NULL if this element does not exist.
- * \note This function performs a binary search. For constant access, use \ref t8_forest_get_element_in_tree
+ * \note This function performs a binary search, unless the forest was
+ * committed with \ref t8_forest_set_element_tree_index.
+ * For constant access, use \ref t8_forest_get_element_in_tree.
+ * To iterate over all elements use \ref t8_forest_element_cursor_init.
  * \a forest must be committed before calling this function.
  */
 t8_element_t       *t8_forest_get_element (t8_forest_t forest,
                                            t8_locidx_t lelement_id,
                                            t8_locidx_t * ltreeid);
 
+/** Initialize a cursor that iterates over the local elements of a forest.
+ * The cursor points before the first element, call
+ * \ref t8_forest_element_cursor_next to advance it:
+ *
+ *     t8_forest_element_cursor_init (forest, &cursor);
+ *     while (t8_forest_element_cursor_next (&cursor)) {
+ *       ... cursor.element, cursor.ltreeid, cursor.ts ...
+ *     }
+ *
+ * \param [in]      forest      The forest.
+ * \param [out]     cursor      The cursor to initialize.
+ * \a forest must be committed before calling this function.
+ */
+void                t8_forest_element_cursor_init (t8_forest_t forest,
+                                                   t8_forest_element_cursor_t
+                                                   * cursor);
+
+/** Advance a cursor to the next local element of its forest.
+ * Each call runs in constant time, except when empty trees are skipped.
+ * \param [in,out]  cursor      A cursor initialized with
+ *                              \ref t8_forest_element_cursor_init.
+ *                              On output its entries describe the next
+ *                              element.
+ * \return          True if the cursor points to an element, false if all
+ *                  elements were visited.
+ */
+int                 t8_forest_element_cursor_next (t8_forest_element_cursor_t
+                                                   * cursor);
+
+/** Return the traversal order of the local elements of a forest.
+ * Entry i is the local index of the i-th element in traversal order.
+ * \param [in]      forest      The forest.
+ * \return          The traversal order, NULL if the forest was not committed
+ *                  with \ref t8_forest_set_traversal_order.
+ * \a forest must be committed before calling this function.
+ */
+const t8_locidx_t  *t8_forest_get_traversal_order (t8_forest_t forest);
+
+/** Return the traversal order of the local trees of a forest.
+ * Entry i is the local id of the i-th tree in traversal order.
+ * \param [in]      forest      The forest.
+ * \return          The tree order, NULL if the forest was not committed
+ *                  with \ref t8_forest_set_traversal_order.
+ * \a forest must be committed before calling this function.
+ */
+const t8_locidx_t  *t8_forest_get_tree_traversal_order (t8_forest_t forest);
+
+/** Permute an array of element data between the local element order and
+ * the traversal order of a forest.
+ * \param [in]      forest      The forest, committed with
+ *                              \ref t8_forest_set_traversal_order.
+ * \param [in]      data        An array with one entry per local element.
+ * \param [in,out]  permuted    An array with the element size of \a data.
+ *                              On output it is resized and holds the
+ *                              permuted entries of \a data.
+ * \param [in]      inverse     If false, \a data is in local element order
+ *                              and \a permuted in traversal order.
+ *                              If true, the other way around.
+ */
+void                t8_forest_permute_element_data (t8_forest_t forest,
+                                                    const sc_array_t * data,
+                                                    sc_array_t * permuted,
+                                                    int inverse);
+
 /** Return an element of a local tree in a forest.
  * \param [in]      forest      The forest.
  * \param [in]      ltreeid     An id of a local tree in the forest.
@@ -726,8 +1648,50 @@ t8_gloidx_t         t8_forest_element_face_neighbor (t8_forest_t forest,
                                                      neigh_scheme, int face,
                                                      int *neigh_face);
 
-/* TODO: implement */
-void                t8_forest_save (t8_forest_t forest);
+/** Write a forest and optional data per element to a binary checkpoint file.
+ * The file stores the global number of elements in each tree and the raw
+ * bytes of all elements in global order, such that it can be loaded on a
+ * different number of processes with \ref t8_forest_load or
+ * \ref t8_forest_set_load. The processes write their parts of the file
+ * collectively with MPI I/O, or one after the other if t8code is built
+ * without MPI I/O.
+ * Since the elements are stored as raw bytes, the file can only be read on
+ * machines with the same byte order, and with a scheme that uses the same
+ * element layout.
+ * \param [in]     forest   A committed forest.
+ * \param [in]     filename The file to write.
+ * \param [in]     element_data If not NULL, an array with one entry per
+ *                          local element that is written with the forest.
+ *                          Its element size must be the same on all processes.
+ * \return  True if succesful, false if not (process local).
+ * This function is collective.
+ */
+int                 t8_forest_save (t8_forest_t forest, const char *filename,
+                                    const sc_array_t * element_data);
+
+/** Load a forest that was written with \ref t8_forest_save.
+ * This is equivalent to calling \ref t8_forest_init, \ref t8_forest_set_cmesh,
+ * \ref t8_forest_set_scheme, \ref t8_forest_set_load,
+ * \ref t8_forest_set_ghost and \ref t8_forest_commit and reading the
+ * element data.
+ * \param [in]     filename The file to load the forest from.
+ * \param [in]     cmesh    The cmesh of the saved forest.
+ * \param [in]     scheme   The element scheme of the saved forest.
+ * \param [in]     do_face_ghost If true, a layer of ghost elements is created.
+ * \param [in]     comm     The MPI communicator of the new forest. It does
+ *                          not need to have the size of the communicator of
+ *                          the saved forest.
+ * \param [in,out] element_data If not NULL, an initialized array whose
+ *                          element size is the size of the data that was
+ *                          saved per element. On output it holds the data
+ *                          of the local elements of the new forest.
+ * \return                  The loaded forest.
+ * This function is collective.
+ */
+t8_forest_t         t8_forest_load (const char *filename, t8_cmesh_t cmesh,
+                                    t8_scheme_cxx_t * scheme,
+                                    int do_face_ghost, sc_MPI_Comm comm,
+                                    sc_array_t * element_data);
 
 /** Write the forest in a parallel vtu format. There is one master
  * .pvtu file and each process writes in its own .vtu file.
@@ -746,11 +1710,14 @@ void                t8_forest_save (t8_forest_t forest);
 void                t8_forest_write_vtk (t8_forest_t forest,
                                          const char *filename);
 
-/* TODO: implement */
-void                t8_forest_iterate (t8_forest_t forest);
-
 /** Compute the coordinates of a given vertex of an element if the
  * vertex coordinates of the surrounding tree are known.
+ * If the tree has no stored vertices and the cmesh has a geometry, see
+ * \ref t8_cmesh_set_tree_geometry, the corner is the image of the geometry
+ * and \a vertices is not used. The image of each corner of a tree is
+ * computed only once and stored in the forest. All other element geometry
+ * functions are based on the corners and thus follow the geometry as well.
+ * The corners of one tree must not be computed by several threads at once.
  * \param [in]      forest     The forest.
  * \param [in]      ltree_id   The forest local id of the tree in which the element is.
  * \param [in]      element    The element.
@@ -768,6 +1735,115 @@ void                t8_forest_element_coordinate (t8_forest_t forest,
                                                   int corner_number,
                                                   double *coordinates);
 
+/** Compute the coordinates of all corners of a range of elements of a tree.
+ * This gives the same result as calling \ref t8_forest_element_coordinate
+ * for each corner of each element, but decodes the corners of many
+ * elements at once and maps them with one loop per element class.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltreeid    The forest local id of a local tree.
+ * \param [in]      first_element The index of the first element within the tree.
+ * \param [in]      num_elements The number of elements.
+ * \param [in]      vertices   An array storing the vertex coordinates of the tree.
+ * \param [out]     coordinates On input an allocated array of
+ *                             3 * num_corners * \a num_elements doubles, where
+ *                             num_corners is the number of vertices of the tree's class.
+ *                             On output corner \a c of element \a first_element + \a e
+ *                             is stored at 3 * (\a e * num_corners + \a c).
+ */
+void                t8_forest_element_coordinates_batch (t8_forest_t forest,
+                                                         t8_locidx_t ltreeid,
+                                                         t8_locidx_t
+                                                         first_element,
+                                                         t8_locidx_t
+                                                         num_elements,
+                                                         const double
+                                                         *vertices,
+                                                         double *coordinates);
+
+/** Compute the coordinates of all corners of a range of elements of a tree
+ * in single precision.
+ * The coordinates are computed in double precision as in
+ * \ref t8_forest_element_coordinates_batch and rounded to float, which halves
+ * the memory of the output, for example for visualization.
+ * The parameters are the same as for \ref t8_forest_element_coordinates_batch.
+ * \param [out]     coordinates On input an allocated array of
+ *                             3 * num_corners * \a num_elements floats.
+ *                             On output the coordinates of the corners.
+ */
+void                t8_forest_element_coordinates_batch_float (t8_forest_t
+                                                               forest,
+                                                               t8_locidx_t
+                                                               ltreeid,
+                                                               t8_locidx_t
+                                                               first_element,
+                                                               t8_locidx_t
+                                                               num_elements,
+                                                               const double
+                                                               *vertices,
+                                                               float
+                                                               *coordinates);
+
+/** Compute the coordinates of all corners of the children of a range of
+ * elements of a tree.
+ * This gives the same result as constructing the children of each element
+ * and calling \ref t8_forest_element_coordinate for their corners, up to
+ * rounding. Each corner of a child is the average of some corners of its
+ * parent, which are looked up in the refinement tables of the element
+ * class. Thus, after the corners of the parents have been computed with
+ * \ref t8_forest_element_coordinates_batch, the corners of their children
+ * only take additions.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltreeid    The forest local id of a local tree.
+ *                             The tree must not be a pyramid tree.
+ * \param [in]      first_element The index of the first element within the tree.
+ * \param [in]      num_elements The number of elements.
+ *                             Each element must be refinable.
+ * \param [in]      vertices   An array storing the vertex coordinates of the tree.
+ * \param [out]     coordinates On input an allocated array of
+ *                             3 * num_children * num_corners * \a num_elements
+ *                             doubles, where num_children and num_corners are
+ *                             the number of children and vertices of the tree's class.
+ *                             On output corner \a c of child \a k of element
+ *                             \a first_element + \a e is stored at
+ *                             3 * ((\a e * num_children + \a k) * num_corners + \a c).
+ */
+void                t8_forest_element_children_coordinates_batch (t8_forest_t
+                                                                  forest,
+                                                                  t8_locidx_t
+                                                                  ltreeid,
+                                                                  t8_locidx_t
+                                                                  first_element,
+                                                                  t8_locidx_t
+                                                                  num_elements,
+                                                                  const double
+                                                                  *vertices,
+                                                                  double
+                                                                  *coordinates);
+
+/** Compute an axis aligned bounding box of an element in physical space.
+ * The box is computed from the integer bounding box of the element, see
+ * t8_element_bounding_box, and the map of the tree. For trees with an
+ * affine geometry this only costs a few operations per coordinate and for
+ * quad, hex and prism trees the 2^d corners of the integer box are mapped.
+ * Thus the box is suitable for pruning in \ref t8_forest_search callbacks.
+ * It may be larger than the box of the element's corners, for example for
+ * triangles and tets. For pyramids and trees with a curved geometry, see
+ * \ref t8_cmesh_set_tree_geometry, it is the box of the element's corners.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltreeid    The forest local id of the tree in which the element is.
+ * \param [in]      element    The element.
+ * \param [in]      vertices   An array storing the vertex coordinates of the tree.
+ * \param [out]     box        On output the minimum x, y and z coordinates followed
+ *                             by the maximum x, y and z coordinates of a box
+ *                             that contains \a element.
+ */
+void                t8_forest_element_bounding_box (t8_forest_t forest,
+                                                    t8_locidx_t ltreeid,
+                                                    const t8_element_t *
+                                                    element,
+                                                    const double *vertices,
+                                                    double box[6]);
+
 /** Compute the coordinates of the centroid of an element if the
  * vertex coordinates of the surrounding tree are known.
  * The centroid is the sum of all corner vertices divided by the number of corners.
@@ -802,7 +1878,10 @@ double              t8_forest_element_diam (t8_forest_t forest,
                                             const t8_element_t * element,
                                             const double *vertices);
 
-/** Compute the volume of an element. This is only an approximation.
+/** Compute the volume of an element.
+ * Tets, triangles and lines are exact. Hexes and prisms are exact for
+ * d-linear trees; parallelepiped and straight prism trees use a cheaper
+ * formula with four corners. Quads are approximated as parallelograms.
  * \param [in]      forest     The forest.
  * \param [in]      ltree_id   The forest local id of the tree in which the element is.
  * \param [in]      element    The element.
@@ -868,6 +1947,74 @@ void                t8_forest_element_face_normal (t8_forest_t forest,
                                                    *tree_vertices,
                                                    double normal[3]);
 
+/** Compute area, centroid and normal vector of an element's face at once.
+ * The corners of the face are mapped into the tree only once and shared
+ * between the three quantities.
+ * The results match \ref t8_forest_element_face_area,
+ * \ref t8_forest_element_face_centroid and \ref t8_forest_element_face_normal.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree in which the element is.
+ * \param [in]      element    The element.
+ * \param [in]      face       A face of \a element.
+ * \param [in]      vertices   An array storing the vertex coordinates of the tree.
+ * \param [out]     area       If not NULL, on output the area of \a face.
+ * \param [out]     centroid   If not NULL, on output the centroid of \a face.
+ * \param [out]     normal     If not NULL, on output the outward normal vector
+ *                             of \a element at \a face. Only for elements of
+ *                             dimension 2 or 3.
+ * \a forest must be committed when calling this function.
+ */
+void                t8_forest_element_face_geometry (t8_forest_t forest,
+                                                     t8_locidx_t ltreeid,
+                                                     const t8_element_t *
+                                                     element, int face,
+                                                     const double *vertices,
+                                                     double *area,
+                                                     double centroid[3],
+                                                     double normal[3]);
+
+/** Compute area, centroid and normal vector of an element's face and of
+ * the faces of all children of the element at this face.
+ * This is the geometry of a hanging face: the coarse face of \a element
+ * and the faces of its face children, see \ref t8_element_children_at_face,
+ * which the neighbors of a coarser element see.
+ * Corners that the face children share with each other and with the
+ * coarse face are mapped into the tree only once.
+ * Index 0 of the output arrays refers to \a face itself, index 1 + i to the
+ * face of the i-th face child.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree in which the element is.
+ * \param [in]      element    The element.
+ * \param [in]      face       A face of \a element.
+ * \param [in]      vertices   An array storing the vertex coordinates of the tree.
+ * \param [out]     area       If not NULL, an array of 1 + num_face_children doubles.
+ *                             On output the face areas.
+ * \param [out]     centroid   If not NULL, an array of 3 * (1 + num_face_children)
+ *                             doubles. On output the face centroids.
+ * \param [out]     normal     If not NULL, an array of 3 * (1 + num_face_children)
+ *                             doubles. On output the outward normal vectors.
+ *                             All normals are oriented away from the centroid
+ *                             of \a element. Only for elements of dimension 2 or 3.
+ * \return                     The number of face children of \a element at \a face,
+ *                             see \ref t8_element_num_face_children.
+ * \a forest must be committed when calling this function.
+ */
+int                 t8_forest_element_face_geometry_children (t8_forest_t
+                                                              forest,
+                                                              t8_locidx_t
+                                                              ltreeid,
+                                                              const
+                                                              t8_element_t *
+                                                              element,
+                                                              int face,
+                                                              const double
+                                                              *vertices,
+                                                              double *area,
+                                                              double
+                                                              *centroid,
+                                                              double
+                                                              *normal);
+
 /* TODO: if set level and partition/adapt/balance all give NULL, then
  * refine uniformly and partition/adapt/balance the unfiform forest. */
 /** Build a uniformly refined forest on a coarse mesh.
@@ -880,12 +2027,60 @@ void                t8_forest_element_face_normal (t8_forest_t forest,
  *                            \a scheme and refinement level \a level.
  * \note This is equivalent to calling \ref t8_forest_init, \ref t8_forest_set_cmesh,
  * \ref t8_forest_set_scheme, \ref t8_forest_set_level, and \ref t8_forest_commit.
+ * \note If \a cmesh has pyramid trees, \a level must be 0, since the uniform
+ * partition does not support the varying number of descendants of pyramids.
+ * Such a forest can be refined with \ref t8_forest_set_adapt and partitioned
+ * afterwards.
  */
 t8_forest_t         t8_forest_new_uniform (t8_cmesh_t cmesh,
                                            t8_scheme_cxx_t * scheme,
                                            int level, int do_face_ghost,
                                            sc_MPI_Comm comm);
 
+/** Build a forest from its local leaves.
+ * \param [in]      cmesh     A coarse mesh.
+ * \param [in]      scheme    An eclass scheme.
+ * \param [in]      num_leaves The number of local leaves.
+ * \param [in]      trees     The global tree of each leaf.
+ * \param [in]      ids       The linear id of each leaf at its level.
+ * \param [in]      levels    The refinement level of each leaf.
+ * \param [in]      do_partition If true, the forest is partitioned after
+ *                            it is built.
+ * \param [in]      do_face_ghost If true, a layer of ghost elements is created for the forest.
+ * \param [in]      comm      MPI communicator to use.
+ * \return                    A forest with the given leaves.
+ * \note This is equivalent to calling \ref t8_forest_init, \ref t8_forest_set_cmesh,
+ * \ref t8_forest_set_scheme, \ref t8_forest_set_leaves, and \ref t8_forest_commit.
+ */
+t8_forest_t         t8_forest_new_from_leaves (t8_cmesh_t cmesh,
+                                               t8_scheme_cxx_t * scheme,
+                                               t8_locidx_t num_leaves,
+                                               const t8_gloidx_t * trees,
+                                               const t8_linearidx_t * ids,
+                                               const int *levels,
+                                               int do_partition,
+                                               int do_face_ghost,
+                                               sc_MPI_Comm comm);
+
+/** Build a forest from another forest and a target level for each of its
+ * elements. An element with a larger target level is refined to it in one
+ * step. Elements with a smaller target level are replaced by their ancestor
+ * of this level, if all local elements inside the ancestor have at most the
+ * same target level and the ancestor is not split between processes.
+ * Otherwise they are kept. The forest is not partitioned.
+ * \param [in]    forest_from The forest to start from. This function takes
+ *                            ownership of it.
+ * \param [in]    target_levels The target level of each local element of
+ *                            \a forest_from.
+ * \param [in]    do_face_ghost If true, a layer of ghost elements is created for the forest.
+ * \return        A new forest with the target levels of \a forest_from.
+ * \note This avoids the element wise callbacks of \ref t8_forest_new_adapt
+ * if the new levels are already known.
+ */
+t8_forest_t         t8_forest_new_from_levels (t8_forest_t forest_from,
+                                               const int *target_levels,
+                                               int do_face_ghost);
+
 /** Build a adapted forest from another forest.
  * \param [in]    forest_from The forest to refine
  * \param [in]    adapt_fn    Adapt function to use
@@ -902,6 +2097,61 @@ t8_forest_t         t8_forest_new_adapt (t8_forest_t forest_from,
                                          int recursive, int do_face_ghost,
                                          void *user_data);
 
+/** Compute the thresholds for an adaptation of a forest that reaches a
+ * target global number of elements. Elements with an indicator above the
+ * refine threshold are refined once and families whose indicators are all
+ * below the coarsen threshold are coarsened once. The coarsen threshold is
+ * \a coarsen_fraction times the refine threshold.
+ * The smallest refine threshold for which the predicted global number of
+ * elements does not exceed the target is searched in a few rounds, each
+ * of which tests a fixed number of candidates with one reduction.
+ * The prediction assumes that all elements below the coarsen threshold
+ * belong to coarsened families.
+ * This function is collective.
+ * \param [in]    forest      A committed forest.
+ * \param [in]    indicators  A nonnegative error indicator for each local
+ *                            element of \a forest.
+ * \param [in]    target_num_elements The target global number of elements.
+ * \param [in]    coarsen_fraction The ratio of the coarsen threshold to the
+ *                            refine threshold in [0, 1]. If 0, no elements
+ *                            are coarsened.
+ * \param [out]   refine_threshold On output the refine threshold.
+ * \param [out]   coarsen_threshold On output the coarsen threshold.
+ * \return        The predicted global number of elements after the
+ *                adaptation.
+ */
+double              t8_forest_adapt_budget_thresholds (t8_forest_t forest,
+                                                       const double
+                                                       *indicators,
+                                                       t8_gloidx_t
+                                                       target_num_elements,
+                                                       double
+                                                       coarsen_fraction,
+                                                       double
+                                                       *refine_threshold,
+                                                       double
+                                                       *coarsen_threshold);
+
+/** Build an adapted forest with about a target global number of elements.
+ * The thresholds are computed with \ref t8_forest_adapt_budget_thresholds
+ * and the forest is adapted once, non-recursively, with them.
+ * \param [in]    forest_from The forest to adapt. This function takes
+ *                            ownership of it.
+ * \param [in]    indicators  A nonnegative error indicator for each local
+ *                            element of \a forest_from.
+ * \param [in]    target_num_elements The target global number of elements.
+ * \param [in]    coarsen_fraction The ratio of the coarsen threshold to the
+ *                            refine threshold in [0, 1].
+ * \param [in]    do_face_ghost If true, a layer of ghost elements is created for the forest.
+ * \return        A new forest that is adapted from \a forest_from.
+ */
+t8_forest_t         t8_forest_new_adapt_budget (t8_forest_t forest_from,
+                                                const double *indicators,
+                                                t8_gloidx_t
+                                                target_num_elements,
+                                                double coarsen_fraction,
+                                                int do_face_ghost);
+
 /** Increase the reference counter of a forest.
  * \param [in,out] forest       On input, this forest must exist with positive
  *                              reference count.  It may be in any state.
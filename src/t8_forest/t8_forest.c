@@ -29,9 +29,19 @@
 #include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest/t8_forest_adapt.h>
 #include <t8_forest/t8_forest_balance.h>
+#include <t8_forest/t8_forest_io.h>
 #include <t8_forest_vtk.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
 #include <t8_cmesh/t8_cmesh_trees.h>
+#include <t8_profile_regions.h>
+#if defined (SC_ENABLE_MPI) && MPI_VERSION >= 3
+/* MPI provides nonblocking collectives */
+#define T8_FOREST_NONBLOCKING_REDUCE
+#endif
+#ifdef T8_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 void
 t8_forest_init (t8_forest_t * pforest)
@@ -156,6 +166,45 @@ t8_forest_set_level (t8_forest_t forest, int level)
   forest->set_level = level;
 }
 
+void
+t8_forest_set_load (t8_forest_t forest, const char *filename)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+
+  T8_ASSERT (filename != NULL);
+
+  if (forest->set_load_filename != NULL) {
+    T8_FREE (forest->set_load_filename);
+  }
+  forest->set_load_filename = T8_ALLOC (char, strlen (filename) + 1);
+  strcpy (forest->set_load_filename, filename);
+}
+
+void
+t8_forest_set_leaves (t8_forest_t forest, t8_locidx_t num_leaves,
+                      const t8_gloidx_t * trees, const t8_linearidx_t * ids,
+                      const int *levels)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (num_leaves >= 0);
+  T8_ASSERT (num_leaves == 0 || (trees != NULL && ids != NULL
+                                 && levels != NULL));
+
+  if (forest->set_leaves == NULL) {
+    forest->set_leaves = T8_ALLOC (t8_forest_set_leaves_t, 1);
+  }
+  forest->set_leaves->num_leaves = num_leaves;
+  forest->set_leaves->trees = trees;
+  forest->set_leaves->ids = ids;
+  forest->set_leaves->levels = levels;
+}
+
 void
 t8_forest_set_copy (t8_forest_t forest, const t8_forest_t set_from)
 {
@@ -177,6 +226,7 @@ t8_forest_set_copy (t8_forest_t forest, const t8_forest_t set_from)
 
   /* Overwrite any previous setting */
   forest->set_adapt_fn = NULL;
+  forest->set_adapt_batch_fn = NULL;
   forest->set_adapt_recursive = -1;
   forest->set_balance = -1;
   forest->set_for_coarsening = -1;
@@ -209,6 +259,63 @@ t8_forest_set_partition (t8_forest_t forest, const t8_forest_t set_from,
   }
 }
 
+void
+t8_forest_set_partition_weight (t8_forest_t forest,
+                                t8_forest_partition_weight_t weight_fn,
+                                const double *weights)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_partition_weight_fn = weight_fn;
+  forest->set_partition_weights = weight_fn == NULL ? weights : NULL;
+}
+
+void
+t8_forest_set_partition_data (t8_forest_t forest, const sc_array_t * data_in,
+                              sc_array_t * data_out)
+{
+  t8_forest_partition_data_t *field;
+
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  T8_ASSERT (data_in != NULL && data_out != NULL);
+  T8_ASSERT (data_in != data_out);
+  T8_ASSERT (data_in->elem_size == data_out->elem_size);
+
+  if (forest->set_partition_data == NULL) {
+    forest->set_partition_data =
+      sc_array_new (sizeof (t8_forest_partition_data_t));
+  }
+  field = (t8_forest_partition_data_t *)
+    sc_array_push (forest->set_partition_data);
+  field->data_in = data_in;
+  field->data_out = data_out;
+}
+
+void
+t8_forest_set_partition_diffusive (t8_forest_t forest, int diffusive)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_partition_diffusive = diffusive != 0;
+}
+
+void
+t8_forest_set_partition_threshold (t8_forest_t forest, double threshold)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_partition_threshold = threshold;
+}
+
+void
+t8_forest_set_partition_ranks (t8_forest_t forest, int num_ranks)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  T8_ASSERT (num_ranks >= 0);
+
+  forest->set_partition_num_ranks = num_ranks;
+}
+
 void
 t8_forest_set_balance (t8_forest_t forest, const t8_forest_t set_from,
                        int no_repartition)
@@ -241,14 +348,19 @@ t8_forest_set_balance (t8_forest_t forest, const t8_forest_t set_from,
 
 void
 t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
-                         t8_ghost_type_t ghost_type, int ghost_version)
+                         t8_ghost_type_t ghost_type, int ghost_version,
+                         int ghost_depth)
 {
   T8_ASSERT (t8_forest_is_initialized (forest));
   /* We currently only support face ghosts */
+  /* Edge and vertex ghosts would need edge and vertex neighbors of elements
+   * and trees, which neither the element schemes nor the cmesh provide. */
   SC_CHECK_ABORT (do_ghost == 0 || ghost_type == T8_GHOST_FACES,
                   "Ghost neighbors other than face-neighbors are not supported.\n");
   SC_CHECK_ABORT (1 <= ghost_version && ghost_version <= 3,
                   "Invalid choice for ghost version. Choose 1, 2, or 3.\n");
+  SC_CHECK_ABORT (ghost_depth >= 1,
+                  "Invalid choice for ghost depth. Choose at least 1.\n");
 
   if (ghost_type == T8_GHOST_NONE) {
     /* none type disables ghost */
@@ -260,6 +372,7 @@ t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
   if (forest->do_ghost) {
     forest->ghost_type = ghost_type;
     forest->ghost_algorithm = ghost_version;
+    forest->ghost_depth = ghost_depth;
   }
 }
 
@@ -268,7 +381,272 @@ t8_forest_set_ghost (t8_forest_t forest, int do_ghost,
                      t8_ghost_type_t ghost_type)
 {
   /* Use ghost version 3, top-down search and for unbalanced forests. */
-  t8_forest_set_ghost_ext (forest, do_ghost, ghost_type, 3);
+  t8_forest_set_ghost_ext (forest, do_ghost, ghost_type, 3, 1);
+}
+
+void
+t8_forest_set_ghost_neighborhood (t8_forest_t forest, int use_neighborhood)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->ghost_neighborhood = (use_neighborhood != 0);
+}
+
+void
+t8_forest_set_ghost_shared (t8_forest_t forest, size_t max_data_size)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->ghost_shared_size = max_data_size;
+}
+
+void
+t8_forest_set_ghost_rma (t8_forest_t forest, size_t max_data_size)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->ghost_rma_size = max_data_size;
+}
+
+void
+t8_forest_set_message_compression (t8_forest_t forest, size_t min_bytes)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->message_compression = min_bytes;
+}
+
+void
+t8_forest_set_face_neighbors (t8_forest_t forest, int do_face_neighbors)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_face_neighbors = (do_face_neighbors != 0);
+}
+
+void
+t8_forest_set_geometry_cache (t8_forest_t forest, int do_cache)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_geometry_cache = (do_cache != 0);
+}
+
+void
+t8_forest_set_geometry_float (t8_forest_t forest, int use_float)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->geometry_float = (use_float != 0);
+}
+
+int
+t8_forest_get_geometry_float (t8_forest_t forest)
+{
+  T8_ASSERT (forest != NULL);
+
+  return forest->geometry_float;
+}
+
+void
+t8_forest_set_element_tree_index (t8_forest_t forest, int do_index)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_element_tree_index = (do_index != 0);
+}
+
+void
+t8_forest_set_element_levels (t8_forest_t forest, int do_levels)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_element_levels = (do_levels != 0);
+}
+
+void
+t8_forest_set_level_lists (t8_forest_t forest, int do_lists)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_level_lists = (do_lists != 0);
+}
+
+void
+t8_forest_set_owner_table (t8_forest_t forest, int do_table)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_owner_table = (do_table != 0);
+}
+
+void
+t8_forest_set_partition_compact (t8_forest_t forest, int do_compact)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_partition_compact = (do_compact != 0);
+}
+
+void
+t8_forest_set_traversal_order (t8_forest_t forest, int do_order)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_traversal_order = (do_order != 0);
+}
+
+void
+t8_forest_set_memory_advice (t8_forest_t forest, int hugepages,
+                             t8_forest_memory_advise_t advise_fn,
+                             void *user_data)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->memory_hugepages = (hugepages != 0);
+  forest->memory_advise_fn = advise_fn;
+  forest->memory_advise_data = user_data;
+}
+
+void
+t8_forest_pool_init (t8_forest_pool_t * ppool, size_t max_bytes)
+{
+  t8_forest_pool_t    pool;
+
+  T8_ASSERT (ppool != NULL);
+  pool = *ppool = T8_ALLOC (t8_forest_pool_struct_t, 1);
+  t8_refcount_init (&pool->rc);
+  pool->max_bytes = max_bytes;
+  pool->num_bytes = 0;
+  sc_array_init (&pool->buffers, sizeof (t8_forest_pool_buffer_t));
+}
+
+void
+t8_forest_pool_ref (t8_forest_pool_t pool)
+{
+  T8_ASSERT (pool != NULL);
+  t8_refcount_ref (&pool->rc);
+}
+
+void
+t8_forest_pool_unref (t8_forest_pool_t * ppool)
+{
+  t8_forest_pool_t    pool;
+  t8_forest_pool_buffer_t *buffer;
+  size_t              ib;
+
+  T8_ASSERT (ppool != NULL);
+  pool = *ppool;
+  T8_ASSERT (pool != NULL);
+  T8_ASSERT (pool->rc.refcount > 0);
+
+  if (t8_refcount_unref (&pool->rc)) {
+    for (ib = 0; ib < pool->buffers.elem_count; ib++) {
+      buffer = (t8_forest_pool_buffer_t *) sc_array_index (&pool->buffers, ib);
+      /* The buffers were allocated by sc_array */
+      SC_FREE (buffer->data);
+    }
+    sc_array_reset (&pool->buffers);
+    T8_FREE (pool);
+    *ppool = NULL;
+  }
+}
+
+void
+t8_forest_set_pool (t8_forest_t forest, t8_forest_pool_t pool)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  T8_ASSERT (pool != NULL);
+
+  if (forest->pool != NULL) {
+    t8_forest_pool_unref (&forest->pool);
+  }
+  forest->pool = pool;
+}
+
+void
+t8_forest_release_tree_elements (t8_forest_t forest,
+                                 t8_element_array_t * elements)
+{
+  t8_forest_pool_t    pool = forest->pool;
+  t8_forest_pool_buffer_t *buffer;
+  sc_array_t         *array = &elements->array;
+
+  /* Move the memory into the pool if it fits. Views and empty arrays
+   * own no memory. */
+  if (pool != NULL && array->byte_alloc > 0
+      && pool->num_bytes + (size_t) array->byte_alloc <= pool->max_bytes) {
+    buffer = (t8_forest_pool_buffer_t *) sc_array_push (&pool->buffers);
+    buffer->data = array->array;
+    buffer->num_bytes = (size_t) array->byte_alloc;
+    pool->num_bytes += buffer->num_bytes;
+    array->array = NULL;
+    array->byte_alloc = 0;
+    array->elem_count = 0;
+  }
+  t8_element_array_reset (elements);
+}
+
+void
+t8_forest_shared_elements_unref (t8_forest_t forest)
+{
+  t8_forest_shared_elements_t *shared = forest->shared_elements;
+  t8_locidx_t         itree;
+
+  T8_ASSERT (shared != NULL);
+  if (t8_refcount_unref (&shared->rc)) {
+    /* This was the last forest with these elements */
+    for (itree = 0; itree < shared->num_trees; itree++) {
+      t8_forest_release_tree_elements (forest, &shared->elements[itree]);
+    }
+    T8_FREE (shared->elements);
+    T8_FREE (shared);
+  }
+  forest->shared_elements = NULL;
+}
+
+void
+t8_forest_init_tree_elements (t8_forest_t forest,
+                              t8_element_array_t * elements,
+                              t8_eclass_scheme_c * scheme,
+                              size_t num_elements)
+{
+  t8_forest_pool_t    pool = forest->pool;
+  t8_forest_pool_buffer_t *buffer, *last;
+  size_t              num_bytes, ib, ibest;
+
+  if (pool == NULL || num_elements == 0) {
+    t8_element_array_init_size (elements, scheme, num_elements);
+    return;
+  }
+  t8_element_array_init (elements, scheme);
+  num_bytes = num_elements * elements->array.elem_size;
+  /* Find the smallest buffer that is large enough */
+  ibest = pool->buffers.elem_count;
+  for (ib = 0; ib < pool->buffers.elem_count; ib++) {
+    buffer = (t8_forest_pool_buffer_t *) sc_array_index (&pool->buffers, ib);
+    if (buffer->num_bytes >= num_bytes
+        && (ibest == pool->buffers.elem_count
+            || buffer->num_bytes <
+            ((t8_forest_pool_buffer_t *)
+             sc_array_index (&pool->buffers, ibest))->num_bytes)) {
+      ibest = ib;
+    }
+  }
+  if (ibest < pool->buffers.elem_count) {
+    buffer = (t8_forest_pool_buffer_t *) sc_array_index (&pool->buffers,
+                                                         ibest);
+    elements->array.array = buffer->data;
+    elements->array.byte_alloc = (ssize_t) buffer->num_bytes;
+    pool->num_bytes -= buffer->num_bytes;
+    /* Fill the gap with the last buffer */
+    last = (t8_forest_pool_buffer_t *) sc_array_pop (&pool->buffers);
+    if (buffer != last) {
+      *buffer = *last;
+    }
+  }
+  /* Initializes the new elements and allocates if no buffer was found */
+  t8_element_array_resize (elements, num_elements);
 }
 
 void
@@ -282,6 +660,7 @@ t8_forest_set_adapt (t8_forest_t forest, const t8_forest_t set_from,
   T8_ASSERT (forest->cmesh == NULL);
   T8_ASSERT (forest->scheme_cxx == NULL);
   T8_ASSERT (forest->set_adapt_fn == NULL);
+  T8_ASSERT (forest->set_adapt_batch_fn == NULL);
   T8_ASSERT (forest->set_adapt_recursive == -1);
 
   forest->set_adapt_fn = adapt_fn;
@@ -303,37 +682,431 @@ t8_forest_set_adapt (t8_forest_t forest, const t8_forest_t set_from,
   }
 }
 
-void
-t8_forest_set_user_data (t8_forest_t forest, void *data)
+void
+t8_forest_set_adapt_batch (t8_forest_t forest, const t8_forest_t set_from,
+                           t8_forest_adapt_batch_t adapt_batch_fn)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->mpicomm == sc_MPI_COMM_NULL);
+  T8_ASSERT (forest->cmesh == NULL);
+  T8_ASSERT (forest->scheme_cxx == NULL);
+  T8_ASSERT (forest->set_adapt_fn == NULL);
+  T8_ASSERT (forest->set_adapt_batch_fn == NULL);
+  T8_ASSERT (forest->set_adapt_recursive == -1);
+
+  forest->set_adapt_batch_fn = adapt_batch_fn;
+  /* Batched adaptation is never recursive */
+  forest->set_adapt_recursive = 0;
+
+  if (set_from != NULL) {
+    /* If set_from = NULL, we assume a previous forest_from was set */
+    forest->set_from = set_from;
+  }
+
+  /* Add ADAPT to the from_method.
+   * This overwrites T8_FOREST_FROM_COPY */
+  if (forest->from_method == T8_FOREST_FROM_LAST) {
+    forest->from_method = T8_FOREST_FROM_ADAPT;
+  }
+  else {
+    forest->from_method |= T8_FOREST_FROM_ADAPT;
+  }
+}
+
+void
+t8_forest_set_adapt_threads (t8_forest_t forest, int num_threads)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_adapt_threads = num_threads;
+}
+
+void
+t8_forest_set_user_data (t8_forest_t forest, void *data)
+{
+  /* TODO: we need a is_initialized and may be committed check! */
+#if 0
+  T8_ASSERT (t8_forest_is_initialized (forest));
+#endif
+  forest->user_data = data;
+}
+
+void               *
+t8_forest_get_user_data (t8_forest_t forest)
+{
+#if 0
+  T8_ASSERT (t8_forest_is_initialized (forest));
+#endif
+  return forest->user_data;
+}
+
+void
+t8_forest_comm_global_num_elements (t8_forest_t forest)
+{
+  int                 mpiret;
+  t8_gloidx_t         local_num_el;
+  t8_gloidx_t         global_num_el;
+
+  local_num_el = (t8_gloidx_t) forest->local_num_elements;
+  mpiret = sc_MPI_Allreduce (&local_num_el, &global_num_el, 1,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  forest->global_num_elements = global_num_el;
+}
+
+/* Copy a shared memory array of a forest, if it exists */
+static void
+t8_forest_copy_shmem_array (t8_shmem_array_t * pdest,
+                            t8_shmem_array_t source, sc_MPI_Comm comm)
+{
+  if (source != NULL) {
+    t8_shmem_array_init (pdest, t8_shmem_array_get_elem_size (source),
+                         t8_shmem_array_get_elem_count (source), comm);
+    t8_shmem_array_copy (*pdest, source);
+  }
+}
+
+/* Apply the memory advice of forest to the data of an array.
+ * For huge pages, we advise the whole pages inside of the array. */
+static void
+t8_forest_memory_advise_array (t8_forest_t forest, sc_array_t * array)
+{
+  size_t              num_bytes;
+
+  num_bytes = array->elem_count * array->elem_size;
+  if (num_bytes == 0) {
+    return;
+  }
+#if defined T8_HAVE_SYS_MMAN_H && defined MADV_HUGEPAGE
+  if (forest->memory_hugepages) {
+    size_t              page_size, begin, end;
+
+    page_size = (size_t) sysconf (_SC_PAGESIZE);
+    begin = ((size_t) array->array + page_size - 1) / page_size * page_size;
+    end = ((size_t) array->array + num_bytes) / page_size * page_size;
+    if (begin < end) {
+      /* This is only a hint, we ignore its failure */
+      (void) madvise ((void *) begin, end - begin, MADV_HUGEPAGE);
+    }
+  }
+#endif
+  if (forest->memory_advise_fn != NULL) {
+    forest->memory_advise_fn (forest, array->array, num_bytes,
+                              forest->memory_advise_data);
+  }
+}
+
+/* Apply the memory advice of forest to its trees and the element
+ * arrays of its local and ghost trees */
+static void
+t8_forest_memory_advise (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_ghost_trees;
+
+  t8_forest_memory_advise_array (forest, forest->trees);
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    t8_forest_memory_advise_array (forest,
+                                   t8_element_array_get_array
+                                   (&t8_forest_get_tree (forest, itree)->
+                                    elements));
+  }
+  num_ghost_trees = t8_forest_ghost_num_trees (forest);
+  for (itree = 0; itree < num_ghost_trees; itree++) {
+    t8_forest_memory_advise_array (forest,
+                                   t8_element_array_get_array
+                                   (t8_forest_ghost_get_tree_elements
+                                    (forest, itree)));
+  }
+}
+
+/* Build the array that stores for each local element its local tree */
+static void
+t8_forest_build_element_tree_index (t8_forest_t forest)
+{
+  t8_locidx_t         ltree, num_trees, ielem, tree_end;
+  t8_tree_t           tree;
+
+  T8_ASSERT (forest->element_to_tree == NULL);
+
+  forest->element_to_tree =
+    T8_ALLOC (t8_locidx_t, t8_forest_get_num_element (forest));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    tree = t8_forest_get_tree (forest, ltree);
+    tree_end = tree->elements_offset +
+      (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+    for (ielem = tree->elements_offset; ielem < tree_end; ielem++) {
+      forest->element_to_tree[ielem] = ltree;
+    }
+  }
+}
+
+/* The Hilbert key of a point with integer coordinates of \a bits bits
+ * each, computed with Skilling's transpose algorithm
+ * (Programming the Hilbert curve, AIP Conf. Proc. 707, 2004). */
+static              t8_linearidx_t
+t8_forest_hilbert_key (const uint32_t coords[3], int dim, int bits)
+{
+  uint32_t            X[3], M, P, Q, t;
+  t8_linearidx_t      key = 0;
+  int                 i, b;
+
+  T8_ASSERT (1 <= dim && dim <= 3);
+  T8_ASSERT (0 < bits && dim * bits <= 64);
+  if (dim == 1) {
+    return coords[0];
+  }
+  for (i = 0; i < dim; i++) {
+    X[i] = coords[i];
+  }
+  M = (uint32_t) 1 << (bits - 1);
+  /* Undo the excess work */
+  for (Q = M; Q > 1; Q >>= 1) {
+    P = Q - 1;
+    for (i = 0; i < dim; i++) {
+      if (X[i] & Q) {
+        X[0] ^= P;
+      }
+      else {
+        t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+  /* Gray encode */
+  for (i = 1; i < dim; i++) {
+    X[i] ^= X[i - 1];
+  }
+  t = 0;
+  for (Q = M; Q > 1; Q >>= 1) {
+    if (X[dim - 1] & Q) {
+      t ^= Q - 1;
+    }
+  }
+  for (i = 0; i < dim; i++) {
+    X[i] ^= t;
+  }
+  /* Interleave the bits of the transposed coordinates */
+  for (b = bits - 1; b >= 0; b--) {
+    for (i = 0; i < dim; i++) {
+      key = (key << 1) | ((X[i] >> b) & 1);
+    }
+  }
+  return key;
+}
+
+typedef struct
+{
+  t8_linearidx_t      key;
+  t8_locidx_t         ltreeid;
+} t8_forest_tree_key_t;
+
+static int
+t8_forest_tree_key_compare (const void *a, const void *b)
+{
+  const t8_forest_tree_key_t *ka = (const t8_forest_tree_key_t *) a;
+  const t8_forest_tree_key_t *kb = (const t8_forest_tree_key_t *) b;
+
+  if (ka->key != kb->key) {
+    return ka->key < kb->key ? -1 : 1;
+  }
+  return ka->ltreeid < kb->ltreeid ? -1 : ka->ltreeid > kb->ltreeid;
+}
+
+/* Sort the local trees along a Hilbert curve through their centroids and
+ * build the resulting traversal order of the local elements.
+ * The curve is fitted to the bounding box of the centroids of all
+ * processes, such that all processes use the same curve. */
+static void
+t8_forest_build_traversal_order (t8_forest_t forest)
+{
+  t8_locidx_t         ltree, num_trees, ielem, tree_end, pos;
+  t8_forest_tree_key_t *keys;
+  t8_tree_t           tree;
+  double             *centroids, *vertices;
+  double              box_min[3], box_max[3], global_min[3], global_max[3];
+  double              scale;
+  uint32_t            coords[3];
+  int                 num_vertices, ivertex, i, dim, bits, mpiret;
+
+  T8_ASSERT (forest->tree_order == NULL);
+  T8_ASSERT (forest->element_order == NULL);
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  dim = SC_MAX (forest->dimension, 1);
+  /* Use as many bits as fit into a t8_linearidx_t */
+  bits = dim == 3 ? 21 : 31;
+  centroids = T8_ALLOC_ZERO (double, 3 * (num_trees + 1));
+  for (i = 0; i < 3; i++) {
+    box_min[i] = 1e300;
+    box_max[i] = -1e300;
+  }
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    vertices = t8_forest_get_tree_vertices (forest, ltree);
+    if (vertices != NULL) {
+      num_vertices =
+        t8_eclass_num_vertices[t8_forest_get_tree_class (forest, ltree)];
+      for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+        for (i = 0; i < 3; i++) {
+          centroids[3 * ltree + i] += vertices[3 * ivertex + i];
+        }
+      }
+      for (i = 0; i < 3; i++) {
+        centroids[3 * ltree + i] /= num_vertices;
+      }
+    }
+    for (i = 0; i < 3; i++) {
+      box_min[i] = SC_MIN (box_min[i], centroids[3 * ltree + i]);
+      box_max[i] = SC_MAX (box_max[i], centroids[3 * ltree + i]);
+    }
+  }
+  mpiret = sc_MPI_Allreduce (box_min, global_min, 3, sc_MPI_DOUBLE,
+                             sc_MPI_MIN, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce (box_max, global_max, 3, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Compute the Hilbert keys of the quantized centroids */
+  keys = T8_ALLOC (t8_forest_tree_key_t, num_trees + 1);
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    for (i = 0; i < 3; i++) {
+      coords[i] = 0;
+      if (i < dim && global_max[i] > global_min[i]) {
+        scale = ((double) (((uint32_t) 1 << bits) - 1)) /
+          (global_max[i] - global_min[i]);
+        coords[i] = (uint32_t)
+          ((centroids[3 * ltree + i] - global_min[i]) * scale);
+      }
+    }
+    keys[ltree].key = t8_forest_hilbert_key (coords, dim, bits);
+    keys[ltree].ltreeid = ltree;
+  }
+  qsort (keys, num_trees, sizeof (t8_forest_tree_key_t),
+         t8_forest_tree_key_compare);
+
+  /* Concatenate the elements of the trees in the sorted order */
+  forest->tree_order = T8_ALLOC (t8_locidx_t, num_trees + 1);
+  forest->element_order =
+    T8_ALLOC (t8_locidx_t, t8_forest_get_num_element (forest) + 1);
+  pos = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    forest->tree_order[ltree] = keys[ltree].ltreeid;
+    tree = t8_forest_get_tree (forest, keys[ltree].ltreeid);
+    tree_end = tree->elements_offset +
+      (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+    for (ielem = tree->elements_offset; ielem < tree_end; ielem++) {
+      forest->element_order[pos++] = ielem;
+    }
+  }
+  T8_ASSERT (pos == t8_forest_get_num_element (forest));
+  T8_FREE (keys);
+  T8_FREE (centroids);
+}
+
+/* Copy the hardware counters and the memory peak of one phase from the
+ * profile of an intermediate forest */
+static void
+t8_forest_profile_copy_phase (t8_profile_t * dest, const t8_profile_t * src,
+                              t8_profile_hw_phase_t phase)
 {
-  /* TODO: we need a is_initialized and may be committed check! */
-#if 0
-  T8_ASSERT (t8_forest_is_initialized (forest));
-#endif
-  forest->user_data = data;
+  memcpy (dest->hw_counters[phase], src->hw_counters[phase],
+          sizeof (dest->hw_counters[phase]));
+  dest->memory_peak[phase] = src->memory_peak[phase];
 }
 
-void               *
-t8_forest_get_user_data (t8_forest_t forest)
+/* Start the reduction of the values of forest that need all processes:
+ * the global number of elements if it is not known, the done flag of balance
+ * and the number of elements of each level if level lists are built.
+ * They are summed with one nonblocking collective, such that its latency is
+ * hidden behind the remaining local work of commit. */
+static void
+t8_forest_global_reduce_begin (t8_forest_t forest)
 {
-#if 0
-  T8_ASSERT (t8_forest_is_initialized (forest));
+  t8_forest_global_reduce_t *reduce;
+  const t8_locidx_t  *offsets;
+  int                 ilevel, num_levels = 0;
+  int                 mpiret;
+
+  T8_ASSERT (forest->global_reduce == NULL);
+  if (forest->global_num_elements >= 0 && forest->reduce_done == NULL
+      && !forest->do_level_lists) {
+    /* There is nothing to reduce */
+    return;
+  }
+  if (forest->do_level_lists) {
+    /* The element counts of each level come with the level lists */
+    t8_forest_level_lists_build_elements (forest);
+    num_levels = forest->level_lists->num_levels;
+  }
+  reduce = forest->global_reduce = T8_ALLOC (t8_forest_global_reduce_t, 1);
+  reduce->num_values = T8_FOREST_REDUCE_LEVELS + num_levels;
+  reduce->values = T8_ALLOC (t8_gloidx_t, 2 * reduce->num_values);
+  reduce->values[T8_FOREST_REDUCE_NUM_ELEMENTS] = forest->local_num_elements;
+  reduce->values[T8_FOREST_REDUCE_NOT_DONE] = forest->reduce_done != NULL
+    && !*forest->reduce_done;
+  if (num_levels > 0) {
+    offsets = forest->level_lists->element_offsets;
+    for (ilevel = 0; ilevel < num_levels; ilevel++) {
+      reduce->values[T8_FOREST_REDUCE_LEVELS + ilevel] =
+        offsets[ilevel + 1] - offsets[ilevel];
+    }
+  }
+#ifdef T8_FOREST_NONBLOCKING_REDUCE
+  mpiret = MPI_Iallreduce (reduce->values, reduce->values + reduce->num_values,
+                           reduce->num_values, T8_MPI_GLOIDX, MPI_SUM,
+                           forest->mpicomm, &reduce->request);
+#else
+  reduce->request = sc_MPI_REQUEST_NULL;
+  mpiret = sc_MPI_Allreduce (reduce->values,
+                             reduce->values + reduce->num_values,
+                             reduce->num_values, T8_MPI_GLOIDX, sc_MPI_SUM,
+                             forest->mpicomm);
 #endif
-  return forest->user_data;
+  SC_CHECK_MPI (mpiret);
 }
 
-void
-t8_forest_comm_global_num_elements (t8_forest_t forest)
+/* Wait for the reduction of t8_forest_global_reduce_begin and store
+ * its results in forest */
+static void
+t8_forest_global_reduce_end (t8_forest_t forest)
 {
+  t8_forest_global_reduce_t *reduce = forest->global_reduce;
+  const t8_gloidx_t  *global;
+  int                 ilevel;
   int                 mpiret;
-  t8_gloidx_t         local_num_el;
-  t8_gloidx_t         global_num_el;
 
-  local_num_el = (t8_gloidx_t) forest->local_num_elements;
-  mpiret = sc_MPI_Allreduce (&local_num_el, &global_num_el, 1,
-                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  if (reduce == NULL) {
+    return;
+  }
+  mpiret = sc_MPI_Waitall (1, &reduce->request, sc_MPI_STATUSES_IGNORE);
   SC_CHECK_MPI (mpiret);
-  forest->global_num_elements = global_num_el;
+  global = reduce->values + reduce->num_values;
+  T8_ASSERT (forest->global_num_elements < 0 || forest->global_num_elements
+             == global[T8_FOREST_REDUCE_NUM_ELEMENTS]);
+  forest->global_num_elements = global[T8_FOREST_REDUCE_NUM_ELEMENTS];
+  if (forest->reduce_done != NULL) {
+    *forest->reduce_done = global[T8_FOREST_REDUCE_NOT_DONE] == 0;
+    forest->reduce_done = NULL;
+  }
+  if (reduce->num_values > T8_FOREST_REDUCE_LEVELS) {
+    /* The maximum existing level is the finest level with elements */
+    forest->maxlevel_existing = 0;
+    for (ilevel = reduce->num_values - T8_FOREST_REDUCE_LEVELS - 1;
+         ilevel > 0; ilevel--) {
+      if (global[T8_FOREST_REDUCE_LEVELS + ilevel] > 0) {
+        forest->maxlevel_existing = ilevel;
+        break;
+      }
+    }
+    forest->level_lists->num_levels = forest->maxlevel_existing + 1;
+  }
+  T8_FREE (reduce->values);
+  T8_FREE (reduce);
+  forest->global_reduce = NULL;
 }
 
 void
@@ -341,12 +1114,15 @@ t8_forest_commit (t8_forest_t forest)
 {
   int                 mpiret;
   int                 partitioned = 0;
+  int                 adapted = 0;
   sc_MPI_Comm         comm_dup;
+  t8_forest_ghost_t   ghost_from = NULL;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->rc.refcount > 0);
   T8_ASSERT (!forest->committed);
 
+  t8_profile_region_begin ("forest_commit");
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of commit */
     forest->profile->commit_runtime = sc_MPI_Wtime ();
@@ -375,10 +1151,32 @@ t8_forest_commit (t8_forest_t forest)
     SC_CHECK_MPI (mpiret);
     /* Compute the maximum allowed refinement level */
     t8_forest_compute_maxlevel (forest);
-    T8_ASSERT (forest->set_level <= forest->maxlevel);
-    /* populate a new forest with tree and quadrant objects */
-    t8_forest_populate (forest);
     forest->global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
+    if (forest->set_load_filename != NULL) {
+      /* load the trees and elements from a file. The elements are evenly
+       * distributed, thus in general the cmesh must be repartitioned. */
+      T8_ASSERT (forest->set_level == 0);
+      t8_forest_load_trees (forest, forest->set_load_filename);
+      partitioned = 1;
+    }
+    else if (forest->set_leaves != NULL) {
+      /* build the trees from the given leaves, the cmesh is repartitioned
+       * to match them */
+      T8_ASSERT (forest->set_level == 0);
+      t8_forest_leaves_build_trees (forest);
+      partitioned = 1;
+    }
+    else if (forest->set_p4est != NULL) {
+      /* adopt the quadrants of a p4est as the elements of the trees */
+      T8_ASSERT (forest->set_level == 0);
+      t8_forest_p4est_build_trees (forest);
+      partitioned = 1;
+    }
+    else {
+      T8_ASSERT (forest->set_level <= forest->maxlevel);
+      /* populate a new forest with tree and quadrant objects */
+      t8_forest_populate (forest);
+    }
   }
   else {                        /* set_from != NULL */
     t8_forest_t         forest_from = forest->set_from; /* temporarily store set_from, since we may overwrite it */
@@ -388,9 +1186,29 @@ t8_forest_commit (t8_forest_t forest)
     T8_ASSERT (forest->cmesh == NULL);
     T8_ASSERT (forest->scheme_cxx == NULL);
     T8_ASSERT (!forest->do_dup);
+    T8_ASSERT (forest->set_load_filename == NULL);
+    T8_ASSERT (forest->set_leaves == NULL);
+    T8_ASSERT (forest->set_p4est == NULL);
     T8_ASSERT (forest->from_method >= T8_FOREST_FROM_FIRST &&
                forest->from_method < T8_FOREST_FROM_LAST);
 
+    if (forest->from_method == T8_FOREST_FROM_ADAPT && forest->do_ghost
+        && forest_from->ghosts != NULL
+        && forest_from->ghost_type == forest->ghost_type
+        && forest_from->ghost_algorithm == forest->ghost_algorithm
+        && forest_from->ghost_depth == forest->ghost_depth
+        && !forest->ghost_neighborhood && forest->ghost_shared_size == 0
+        && forest->ghost_rma_size == 0
+        && forest_from->ghosts->neighbor_comm == sc_MPI_COMM_NULL
+        && forest_from->ghosts->shared == NULL
+        && forest_from->ghosts->rma == NULL) {
+      /* The forest is only adapted, thus the domain of each process stays
+       * the same and we can update the ghost layer of forest_from instead
+       * of creating it from scratch. We keep it until then. */
+      ghost_from = forest_from->ghosts;
+      t8_forest_ghost_ref (ghost_from);
+    }
+
     /* TODO: optimize all this when forest->set_from has reference count one */
     /* TODO: Get rid of duping the communicator */
     /* we must prevent the case that set_from frees the source communicator */
@@ -409,6 +1227,8 @@ t8_forest_commit (t8_forest_t forest)
     mpiret = sc_MPI_Comm_rank (forest->mpicomm, &forest->mpirank);
     SC_CHECK_MPI (mpiret);
 
+    SC_CHECK_ABORT (forest->set_from->compressed == NULL,
+                    "Cannot derive a forest from a compressed forest.");
     /* increase reference count of cmesh and scheme from the input forest */
     t8_cmesh_ref (forest->set_from->cmesh);
     t8_scheme_cxx_ref (forest->set_from->scheme_cxx);
@@ -420,16 +1240,25 @@ t8_forest_commit (t8_forest_t forest)
 
     /* Compute the maximum allowed refinement level */
     t8_forest_compute_maxlevel (forest);
+    /* The new forest has the element data fields of the old one */
+    t8_forest_fields_inherit (forest, forest_from);
+    /* and takes its element memory from the same pool */
+    if (forest->pool == NULL && forest->set_from->pool != NULL) {
+      t8_forest_pool_ref (forest->set_from->pool);
+      forest->pool = forest->set_from->pool;
+    }
     if (forest->from_method == T8_FOREST_FROM_COPY) {
       SC_CHECK_ABORT (forest->set_from != NULL,
                       "No forest to copy from was specified.");
-      t8_forest_copy_trees (forest, forest->set_from, 1);
+      t8_forest_share_trees (forest, forest->set_from);
+      t8_forest_fields_copy (forest, forest->set_from);
     }
     /* TODO: currently we can only handle copy, adapt, partition, and balance */
 
     /* T8_ASSERT (forest->from_method == T8_FOREST_FROM_COPY); */
     if (forest->from_method & T8_FOREST_FROM_ADAPT) {
-      SC_CHECK_ABORT (forest->set_adapt_fn != NULL,
+      SC_CHECK_ABORT (forest->set_adapt_fn != NULL
+                      || forest->set_adapt_batch_fn != NULL,
                       "No adapt function specified");
       forest->from_method -= T8_FOREST_FROM_ADAPT;
       if (forest->from_method > 0) {
@@ -444,9 +1273,16 @@ t8_forest_commit (t8_forest_t forest)
         t8_forest_set_user_data (forest_adapt,
                                  t8_forest_get_user_data (forest));
         /* Construct an intermediate, adapted forest */
-        t8_forest_set_adapt (forest_adapt, forest->set_from,
-                             forest->set_adapt_fn,
-                             forest->set_adapt_recursive);
+        if (forest->set_adapt_batch_fn != NULL) {
+          t8_forest_set_adapt_batch (forest_adapt, forest->set_from,
+                                     forest->set_adapt_batch_fn);
+        }
+        else {
+          t8_forest_set_adapt (forest_adapt, forest->set_from,
+                               forest->set_adapt_fn,
+                               forest->set_adapt_recursive);
+        }
+        t8_forest_set_adapt_threads (forest_adapt, forest->set_adapt_threads);
         /* Set profiling if enabled */
         t8_forest_set_profiling (forest_adapt, forest->profile != NULL);
         t8_forest_commit (forest_adapt);
@@ -459,53 +1295,111 @@ t8_forest_commit (t8_forest_t forest)
         if (forest->profile != NULL) {
           forest->profile->adapt_runtime =
             forest_adapt->profile->adapt_runtime;
+          t8_forest_profile_copy_phase (forest->profile,
+                                        forest_adapt->profile,
+                                        T8_PROFILE_HW_ADAPT);
         }
       }
       else {
         /* This forest should only be adapted */
         t8_forest_copy_trees (forest, forest->set_from, 0);
         t8_forest_adapt (forest);
+        t8_forest_fields_adapt (forest, forest->set_from);
+        adapted = 1;
       }
     }
     if (forest->from_method & T8_FOREST_FROM_PARTITION) {
-      partitioned = 1;
       /* Partition this forest */
       forest->from_method -= T8_FOREST_FROM_PARTITION;
 
-      if (forest->from_method > 0) {
-        /* The forest should also be balanced after partition */
-        t8_forest_t         forest_partition;
-
-        t8_forest_init (&forest_partition);
+      if (forest->from_method & T8_FOREST_FROM_BALANCE) {
+        /* The forest should also be balanced. We balance first without
+         * repartitioning and then partition the balanced forest once.
+         * Thus, we neither partition before balance nor in each round
+         * of balance and we construct the ghost layer only for the final
+         * forest. */
+        t8_forest_t         forest_balance;
+
+        forest->from_method -= T8_FOREST_FROM_BALANCE;
+        T8_ASSERT (forest->from_method == 0);
+        t8_forest_init (&forest_balance);
         if (forest_from == forest->set_from) {
-          /* forest_partition should not change ownership of forest->set_from */
+          /* forest_balance should not change ownership of forest->set_from */
           t8_forest_ref (forest->set_from);
         }
-        t8_forest_set_partition (forest_partition, forest->set_from,
-                                 forest->set_for_coarsening);
+        /* If set_from is an intermediate forest, forest_balance takes
+         * ownership of it */
+        t8_forest_set_balance (forest_balance, forest->set_from, 1);
         /* activate profiling, if this forest has profiling */
-        t8_forest_set_profiling (forest_partition, forest->profile != NULL);
-        /* Commit the partitioned forest */
-        t8_forest_commit (forest_partition);
-        forest->set_from = forest_partition;
+        t8_forest_set_profiling (forest_balance, forest->profile != NULL);
+        /* Commit the balanced forest */
+        t8_forest_commit (forest_balance);
+        forest->set_from = forest_balance;
         if (forest->profile != NULL) {
-          forest->profile->partition_bytes_sent =
-            forest_partition->profile->partition_bytes_sent;
-          forest->profile->partition_elements_recv =
-            forest_partition->profile->partition_elements_recv;
-          forest->profile->partition_elements_shipped =
-            forest_partition->profile->partition_elements_shipped;
-          forest->profile->partition_procs_sent =
-            forest_partition->profile->partition_procs_sent;
-          forest->profile->partition_runtime =
-            forest_partition->profile->partition_runtime;
+          forest->profile->balance_runtime =
+            forest_balance->profile->balance_runtime;
+          forest->profile->balance_rounds =
+            forest_balance->profile->balance_rounds;
+          t8_forest_profile_copy_phase (forest->profile,
+                                        forest_balance->profile,
+                                        T8_PROFILE_HW_BALANCE);
+        }
+      }
+      /* An array of weights refers to the elements of the forest that
+       * was set */
+      SC_CHECK_ABORT ((forest->set_partition_weights == NULL
+                       && forest->set_partition_data == NULL)
+                      || forest->set_from == forest_from,
+                      "Partition weights arrays and partition data can only"
+                      " be given if the forest is only partitioned.\n");
+      /* Partitioning is the last routine */
+      forest->global_num_elements = forest->set_from->global_num_elements;
+      if (t8_forest_partition_skip (forest)) {
+        /* The imbalance is small enough, we keep the partition */
+        t8_forest_share_trees (forest, forest->set_from);
+        t8_forest_copy_shmem_array (&forest->element_offsets,
+                                    forest->set_from->element_offsets,
+                                    forest->mpicomm);
+        t8_forest_copy_shmem_array (&forest->tree_offsets,
+                                    forest->set_from->tree_offsets,
+                                    forest->mpicomm);
+        t8_forest_copy_shmem_array (&forest->global_first_desc,
+                                    forest->set_from->global_first_desc,
+                                    forest->mpicomm);
+        t8_forest_fields_copy (forest, forest->set_from);
+        if (forest->set_partition_data != NULL) {
+          size_t              ifield;
+          t8_forest_partition_data_t *field;
+
+          for (ifield = 0; ifield < forest->set_partition_data->elem_count;
+               ifield++) {
+            field = (t8_forest_partition_data_t *)
+              sc_array_index (forest->set_partition_data, ifield);
+            sc_array_copy (field->data_out, (sc_array_t *) field->data_in);
+          }
+        }
+        if (forest->set_from == forest_from && forest->do_ghost
+            && forest_from->ghosts != NULL
+            && forest_from->ghost_type == forest->ghost_type
+            && forest_from->ghost_algorithm == forest->ghost_algorithm
+            && forest_from->ghost_depth == forest->ghost_depth
+            && !forest->ghost_neighborhood
+            && forest->ghost_shared_size == 0
+            && forest->ghost_rma_size == 0
+            && forest_from->ghosts->neighbor_comm == sc_MPI_COMM_NULL
+            && forest_from->ghosts->shared == NULL
+            && forest_from->ghosts->rma == NULL) {
+          /* The forest equals forest_from, so we reuse its ghost layer */
+          forest->ghosts = forest_from->ghosts;
+          t8_forest_ghost_ref (forest->ghosts);
         }
       }
       else {
-        /* Partitioning is the last routine, no balance was set */
-        forest->global_num_elements = forest->set_from->global_num_elements;
+        partitioned = 1;
         /* Initialize the trees array of the forest */
         forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
+        /* The fields are sent together with the elements */
+        t8_forest_fields_set_partition (forest, forest->set_from);
         /* partition the forest */
         t8_forest_partition (forest);
       }
@@ -540,14 +1434,35 @@ t8_forest_commit (t8_forest_t forest)
 
   /* Compute the element offset of the trees */
   t8_forest_compute_elements_offset (forest);
+  /* The elements are final, reduce the global values while we compute
+   * the descendants */
+  t8_forest_global_reduce_begin (forest);
 
   /* Compute first and last descendant for each tree */
   t8_forest_compute_desc (forest);
 
   /* we do not need the set parameters anymore */
   forest->set_level = 0;
+  if (forest->set_load_filename != NULL) {
+    T8_FREE (forest->set_load_filename);
+    forest->set_load_filename = NULL;
+  }
+  if (forest->set_leaves != NULL) {
+    T8_FREE (forest->set_leaves);
+    forest->set_leaves = NULL;
+  }
   forest->set_for_coarsening = 0;
+  forest->set_partition_weights = NULL;
+  if (forest->set_partition_data != NULL) {
+    sc_array_destroy (forest->set_partition_data);
+    forest->set_partition_data = NULL;
+  }
   forest->set_from = NULL;
+  t8_forest_global_reduce_end (forest);
+  if (adapted) {
+    t8_global_productionf ("Done t8_forest_adapt with %lld total elements\n",
+                           (long long) forest->global_num_elements);
+  }
   forest->committed = 1;
   t8_debugf ("Committed forest with %li local elements and %lli "
              "global elements.\n\tTree range ist from %lli to %lli.\n",
@@ -563,19 +1478,21 @@ t8_forest_commit (t8_forest_t forest)
   T8_ASSERT (forest->tree_offsets == NULL);
   T8_ASSERT (forest->global_first_desc == NULL);
 #else
-  if (forest->tree_offsets == NULL) {
-    /* Compute the tree offset array */
-    t8_forest_partition_create_tree_offsets (forest);
-  }
-  if (forest->element_offsets == NULL) {
-    /* Compute element offsets */
-    t8_forest_partition_create_offsets (forest);
+  /* Compute the element offsets, tree offsets and global first
+   * descendants that do not exist yet with one collective */
+  t8_forest_partition_create_all_offsets (forest);
+#endif
+  if (forest->do_owner_table) {
+    /* Build the owner search table before the ghost layer, which uses it */
+    t8_forest_owner_table_build (forest);
   }
-  if (forest->global_first_desc == NULL) {
-    /* Compute global first desc array */
-    t8_forest_partition_create_first_desc (forest);
+  if (forest->profile != NULL) {
+    /* Measure the memory of the partition tables */
+    forest->profile->partition_table_bytes =
+      t8_shmem_array_get_bytes_per_process (forest->element_offsets) +
+      t8_shmem_array_get_bytes_per_process (forest->tree_offsets) +
+      t8_shmem_array_get_bytes_per_process (forest->global_first_desc);
   }
-#endif
 
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of commit */
@@ -590,10 +1507,26 @@ t8_forest_commit (t8_forest_t forest)
     t8_forest_partition_cmesh (forest, forest->mpicomm,
                                forest->profile != NULL);
   }
+  /* Detect the trees with an affine geometry */
+  t8_forest_tree_affine_compute (forest);
+  /* Store the face connections of the trees for face neighbor queries */
+  t8_forest_tree_faces_compute (forest);
 
   if (forest->mpisize > 1) {
     /* Construct a ghost layer, if desired */
-    if (forest->do_ghost) {
+    if (forest->ghosts != NULL) {
+      /* The ghost layer of the source forest was reused, since the
+       * partition was skipped */
+      T8_ASSERT (forest->set_partition_threshold > 0);
+    }
+    else if (forest->do_ghost && ghost_from != NULL) {
+      /* Update the previous ghost layer */
+      t8_forest_ghost_create_incremental (forest, ghost_from,
+                                          forest->ghost_algorithm == 1 ? 0 :
+                                          (forest->ghost_algorithm ==
+                                           2 ? 1 : -1));
+    }
+    else if (forest->do_ghost) {
       /* TODO: ghost type */
       switch (forest->ghost_algorithm) {
       case 1:
@@ -611,6 +1544,52 @@ t8_forest_commit (t8_forest_t forest)
     }
   forest->do_ghost = 0;
   }
+  if (ghost_from != NULL) {
+    t8_forest_ghost_unref (&ghost_from);
+  }
+  /* Fill the ghost entries of the element data fields */
+  t8_forest_fields_commit_ghosts (forest);
+  /* Map the element corners of trees with a curved geometry */
+  t8_forest_tree_curved_build (forest);
+  if (forest->do_face_neighbors) {
+    /* Build the face neighbor table, it needs the ghost layer */
+    t8_forest_face_neighbors_build (forest);
+  }
+  if (forest->do_geometry_cache) {
+    /* Cache the element geometry, including the ghosts */
+    t8_forest_geometry_cache_build (forest);
+  }
+  if (forest->do_element_tree_index) {
+    t8_forest_build_element_tree_index (forest);
+  }
+  if (forest->do_element_levels) {
+    t8_forest_element_levels_build (forest);
+  }
+  if (forest->do_level_lists) {
+    /* The element lists were built with the global reduction */
+    t8_forest_level_lists_build_ghosts (forest);
+  }
+  if (forest->do_traversal_order) {
+    t8_forest_build_traversal_order (forest);
+  }
+  if (forest->memory_hugepages || forest->memory_advise_fn != NULL) {
+    t8_forest_memory_advise (forest);
+  }
+  if (forest->do_partition_compact) {
+    /* Compress the partition tables and free the shared ones. This is
+     * done last, since the ghost layer and the owner table need them. */
+    t8_forest_partition_compact_build (forest);
+    t8_shmem_array_destroy (&forest->element_offsets);
+    t8_shmem_array_destroy (&forest->global_first_desc);
+    t8_shmem_array_destroy (&forest->tree_offsets);
+  }
+  t8_profile_region_end ("forest_commit");
+  if (forest->profile != NULL) {
+    t8_profile_regions_last_hw_counters (forest->profile->hw_counters
+                                         [T8_PROFILE_HW_COMMIT]);
+    forest->profile->memory_peak[T8_PROFILE_HW_COMMIT] =
+      t8_profile_regions_last_memory_peak ();
+  }
 }
 
 t8_locidx_t
@@ -642,6 +1621,34 @@ t8_forest_get_num_ghosts (t8_forest_t forest)
   return forest->ghosts->num_ghosts_elements;
 }
 
+int
+t8_forest_get_face_neighbors (t8_forest_t forest, t8_locidx_t lelement_id,
+                              int face, const t8_locidx_t **neighbors,
+                              const int8_t **dual_faces, int *level_diff)
+{
+  const t8_forest_face_neighbors_t *table;
+  t8_locidx_t         iface, offset;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  table = forest->face_neighbors;
+  T8_ASSERT (table != NULL);
+  T8_ASSERT (0 <= lelement_id && lelement_id < table->num_elements);
+
+  iface = table->face_offsets[lelement_id] + face;
+  T8_ASSERT (0 <= face && iface < table->face_offsets[lelement_id + 1]);
+  offset = table->neighbor_offsets[iface];
+  if (neighbors != NULL) {
+    *neighbors = table->neighbors + offset;
+  }
+  if (dual_faces != NULL) {
+    *dual_faces = table->dual_faces + offset;
+  }
+  if (level_diff != NULL) {
+    *level_diff = table->level_diff[iface];
+  }
+  return table->neighbor_offsets[iface + 1] - offset;
+}
+
 /* Currently this function is not used */
 #if 0
 static t8_element_t *
@@ -679,6 +1686,30 @@ t8_forest_compute_cmesh_offset (t8_forest_t forest, sc_MPI_Comm comm)
   return offset;
 }
 
+/* Return true if on each process the local trees of the cmesh of a forest
+ * are exactly the local trees of the forest. Then the cmesh does not need
+ * to be repartitioned. This function is collective. */
+static int
+t8_forest_cmesh_partition_matches (t8_forest_t forest, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_locidx_t         num_trees;
+  int                 matches, global_matches, mpiret;
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  if (num_trees > 0) {
+    matches = cmesh->first_tree == forest->first_local_tree
+      && cmesh->num_local_trees == num_trees;
+  }
+  else {
+    matches = cmesh->num_local_trees == 0;
+  }
+  mpiret = sc_MPI_Allreduce (&matches, &global_matches, 1, sc_MPI_INT,
+                             sc_MPI_LAND, comm);
+  SC_CHECK_MPI (mpiret);
+  return global_matches;
+}
+
 void
 t8_forest_partition_cmesh (t8_forest_t forest, sc_MPI_Comm comm,
                            int set_profiling)
@@ -686,6 +1717,11 @@ t8_forest_partition_cmesh (t8_forest_t forest, sc_MPI_Comm comm,
   t8_cmesh_t          cmesh_partition;
   t8_shmem_array_t    offsets;
 
+  if (t8_forest_cmesh_partition_matches (forest, comm)) {
+    /* No tree changes its owner, we keep the cmesh with its ghosts */
+    t8_debugf ("Cmesh partition matches the forest, nothing to do\n");
+    return;
+  }
   t8_debugf ("Partitioning cmesh according to forest\n");
 
   t8_cmesh_init (&cmesh_partition);
@@ -713,6 +1749,21 @@ t8_forest_get_mpicomm (t8_forest_t forest)
   return forest->mpicomm;
 }
 
+void
+t8_forest_get_active_comm (t8_forest_t forest, sc_MPI_Comm * active_comm)
+{
+  int                 mpiret, color;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (active_comm != NULL);
+
+  /* Processes without elements do not get a communicator */
+  color = forest->local_num_elements > 0 ? 0 : sc_MPI_UNDEFINED;
+  mpiret = sc_MPI_Comm_split (forest->mpicomm, color, forest->mpirank,
+                              active_comm);
+  SC_CHECK_MPI (mpiret);
+}
+
 t8_gloidx_t
 t8_forest_get_first_local_tree_id (t8_forest_t forest)
 {
@@ -855,6 +1906,18 @@ t8_forest_get_element (t8_forest_t forest, t8_locidx_t lelement_id,
   if (lelement_id >= t8_forest_get_num_element (forest)) {
     return NULL;
   }
+  if (forest->element_to_tree != NULL) {
+    /* We look up the tree instead of searching for it */
+    ltree = forest->element_to_tree[lelement_id];
+    if (ltreeid != NULL) {
+      *ltreeid = ltree;
+    }
+    tree = t8_forest_get_tree (forest, ltree);
+    T8_ASSERT (tree->elements_offset <= lelement_id);
+    return t8_element_array_index_locidx (&tree->elements,
+                                          lelement_id -
+                                          tree->elements_offset);
+  }
   /* We optimized the binary search out by using sc_bsearch,
    * but keep it in for debugging. We check whether the hand-written
    * binary search matches the sc_array_bsearch. */
@@ -909,6 +1972,100 @@ t8_forest_get_element (t8_forest_t forest, t8_locidx_t lelement_id,
   return NULL;
 }
 
+void
+t8_forest_element_cursor_init (t8_forest_t forest,
+                               t8_forest_element_cursor_t * cursor)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (cursor != NULL);
+
+  cursor->forest = forest;
+  cursor->lelement_id = -1;
+  /* We start before the first tree, such that the first call to next
+   * enters it */
+  cursor->ltreeid = -1;
+  cursor->tree_element_id = 0;
+  cursor->tree_num_elements = 0;
+  cursor->tree = NULL;
+  cursor->ts = NULL;
+  cursor->element = NULL;
+}
+
+int
+t8_forest_element_cursor_next (t8_forest_element_cursor_t * cursor)
+{
+  t8_forest_t         forest = cursor->forest;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  cursor->tree_element_id++;
+  while (cursor->tree_element_id >= cursor->tree_num_elements) {
+    /* Go to the next nonempty tree */
+    cursor->ltreeid++;
+    if (cursor->ltreeid >= t8_forest_get_num_local_trees (forest)) {
+      cursor->element = NULL;
+      cursor->lelement_id = t8_forest_get_num_element (forest);
+      return 0;
+    }
+    cursor->tree = t8_forest_get_tree (forest, cursor->ltreeid);
+    cursor->ts = t8_forest_get_eclass_scheme (forest, cursor->tree->eclass);
+    cursor->tree_num_elements =
+      (t8_locidx_t) t8_element_array_get_count (&cursor->tree->elements);
+    cursor->tree_element_id = 0;
+  }
+  cursor->lelement_id++;
+  T8_ASSERT (cursor->lelement_id ==
+             cursor->tree->elements_offset + cursor->tree_element_id);
+  cursor->element =
+    t8_element_array_index_locidx (&cursor->tree->elements,
+                                   cursor->tree_element_id);
+  return 1;
+}
+
+const t8_locidx_t  *
+t8_forest_get_traversal_order (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return forest->element_order;
+}
+
+const t8_locidx_t  *
+t8_forest_get_tree_traversal_order (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return forest->tree_order;
+}
+
+void
+t8_forest_permute_element_data (t8_forest_t forest, const sc_array_t * data,
+                                sc_array_t * permuted, int inverse)
+{
+  t8_locidx_t         ielem, num_elements;
+  size_t              size;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->element_order != NULL);
+  T8_ASSERT (data != NULL && permuted != NULL && data != permuted);
+  T8_ASSERT (data->elem_size == permuted->elem_size);
+
+  num_elements = t8_forest_get_num_element (forest);
+  T8_ASSERT (data->elem_count == (size_t) num_elements);
+  size = data->elem_size;
+  sc_array_resize (permuted, num_elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    if (!inverse) {
+      memcpy (sc_array_index (permuted, ielem),
+              data->array + size * forest->element_order[ielem], size);
+    }
+    else {
+      memcpy (sc_array_index (permuted, forest->element_order[ielem]),
+              data->array + size * ielem, size);
+    }
+  }
+}
+
 t8_element_t
   * t8_forest_get_element_in_tree (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_locidx_t leid_in_tree)
@@ -973,6 +2130,22 @@ t8_forest_get_tree_class (t8_forest_t forest, t8_locidx_t ltreeid)
   }
 }
 
+const int8_t       *
+t8_forest_get_element_levels (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return forest->element_levels;
+}
+
+int
+t8_forest_get_maxlevel_existing (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return forest->maxlevel_existing;
+}
+
 /* Return the global index of the first local element */
 t8_gloidx_t
 t8_forest_get_first_local_element_id (t8_forest_t forest)
@@ -983,6 +2156,9 @@ t8_forest_get_first_local_element_id (t8_forest_t forest)
     return t8_shmem_array_get_gloidx (forest->element_offsets,
                                       forest->mpirank);
   }
+  if (forest->partition_compact != NULL) {
+    return forest->partition_compact->first_local_element;
+  }
   return -1;
 }
 
@@ -1130,6 +2306,9 @@ t8_forest_set_profiling (t8_forest_t forest, int set_profiling)
     if (forest->profile == NULL) {
       /* Only do something if profiling is not enabled already */
       forest->profile = T8_ALLOC_ZERO (t8_profile_struct_t, 1);
+      t8_forest_profile_ghost_reset (forest);
+      /* Record the memory peaks of the commit stages */
+      t8_profile_regions_set_memory (1);
     }
   }
   else {
@@ -1140,6 +2319,27 @@ t8_forest_set_profiling (t8_forest_t forest, int set_profiling)
   }
 }
 
+void
+t8_forest_profile_ghost_reset (t8_forest_t forest)
+{
+  t8_profile_t       *profile = forest->profile;
+
+  T8_ASSERT (profile != NULL);
+  profile->ghost_search_runtime = 0;
+  profile->ghost_owner_runtime = 0;
+  profile->ghost_pack_runtime = 0;
+  profile->ghost_receive_runtime = 0;
+  profile->ghost_parse_runtime = 0;
+  profile->ghost_bytes_sent = 0;
+  profile->ghost_bytes_received = 0;
+  memset (&profile->comm[T8_PROFILE_COMM_GHOST], 0,
+          sizeof (t8_profile_comm_t));
+  sc_stats_init (&profile->ghost_message_size,
+                 "forest: Ghost message size in bytes.");
+  sc_stats_init (&profile->ghost_message_latency,
+                 "forest: Ghost message latency.");
+}
+
 void
 t8_forest_print_profile (t8_forest_t forest)
 {
@@ -1176,12 +2376,307 @@ t8_forest_print_profile (t8_forest_t forest)
                    "forest: Balance runtime.");
     sc_stats_set1 (&stats[12], profile->balance_rounds,
                    "forest: Balance rounds.");
+    sc_stats_set1 (&stats[13], profile->ghost_search_runtime,
+                   "forest: Ghost remote search runtime.");
+    sc_stats_set1 (&stats[14], profile->ghost_owner_runtime,
+                   "forest: Ghost owner computation runtime.");
+    sc_stats_set1 (&stats[15], profile->ghost_pack_runtime,
+                   "forest: Ghost packing runtime.");
+    sc_stats_set1 (&stats[16], profile->ghost_receive_runtime,
+                   "forest: Ghost receive runtime.");
+    sc_stats_set1 (&stats[17], profile->ghost_parse_runtime,
+                   "forest: Ghost parse runtime.");
+    sc_stats_set1 (&stats[18], profile->ghost_bytes_sent,
+                   "forest: Number of ghost bytes sent.");
+    sc_stats_set1 (&stats[19], profile->ghost_bytes_received,
+                   "forest: Number of ghost bytes received.");
+    sc_stats_set1 (&stats[22], profile->partition_weight_imbalance,
+                   "forest: Partition weight imbalance.");
+    sc_stats_set1 (&stats[23], profile->partition_table_bytes,
+                   "forest: Partition table bytes per process.");
+    /* The message statistics are accumulated over all messages */
+    stats[20] = profile->ghost_message_size;
+    stats[21] = profile->ghost_message_latency;
     /* compute stats */
     sc_stats_compute (sc_MPI_COMM_WORLD, T8_PROFILE_NUM_STATS, stats);
     /* print stats */
     t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "Printing stats for forest.\n");
     sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS,
                     T8_PROFILE_NUM_STATS, stats, 1, 1);
+    /* The hardware counters and memory peaks of the phases, if they are
+     * recorded */
+    {
+      const char         *phase_names[T8_PROFILE_HW_NUM_PHASES] =
+        { "Adapt", "Balance", "Partition", "Ghost", "Commit" };
+
+      t8_profile_regions_print_hw_counters (sc_MPI_COMM_WORLD, "forest",
+                                            T8_PROFILE_HW_NUM_PHASES,
+                                            phase_names,
+                                            &profile->hw_counters[0][0]);
+      t8_profile_regions_print_memory (sc_MPI_COMM_WORLD, "forest",
+                                       T8_PROFILE_HW_NUM_PHASES,
+                                       phase_names, profile->memory_peak);
+    }
+    /* The messages of the communicating phases */
+    {
+      const char         *phase_names[T8_PROFILE_COMM_NUM_PHASES] =
+        { "Partition", "Ghost", "Ghost exchange", "Balance" };
+
+      t8_profile_comm_print (sc_MPI_COMM_WORLD, "forest",
+                             T8_PROFILE_COMM_NUM_PHASES, phase_names,
+                             profile->comm);
+    }
+  }
+}
+
+/* The columns of the per process profile */
+static const char  *t8_forest_profile_csv_columns[] = {
+  "rank", "local_trees", "elements", "ghosts", "remotes",
+  "adapt_time", "balance_time", "balance_rounds", "partition_time",
+  "ghost_time", "ghost_exchange_waittime", "commit_time",
+  "partition_bytes_sent", "ghost_bytes_sent", "ghost_bytes_received",
+  "ghost_exchange_bytes", "commit_memory_peak"
+};
+
+#define T8_PROFILE_CSV_NUM_COLUMNS \
+  (int) (sizeof (t8_forest_profile_csv_columns) / sizeof (const char *))
+
+int
+t8_forest_write_profile_csv (t8_forest_t forest, const char *filename)
+{
+  t8_profile_t       *profile;
+  double              row[T8_PROFILE_CSV_NUM_COLUMNS], *rows = NULL;
+  FILE               *file;
+  int                 mpirank, mpisize, mpiret, icol, iproc, num_remotes;
+  int                 success = 1;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (filename != NULL);
+  mpiret = sc_MPI_Comm_rank (forest->mpicomm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (forest->mpicomm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* The partition is known without profiling, the times only with it */
+  num_remotes = 0;
+  if (forest->ghosts != NULL) {
+    (void) t8_forest_ghost_get_remotes (forest, &num_remotes);
+  }
+  memset (row, 0, sizeof (row));
+  row[0] = mpirank;
+  row[1] = t8_forest_get_num_local_trees (forest);
+  row[2] = t8_forest_get_num_element (forest);
+  row[3] = t8_forest_get_num_ghosts (forest);
+  row[4] = num_remotes;
+  profile = forest->profile;
+  if (profile != NULL) {
+    row[5] = profile->adapt_runtime;
+    row[6] = profile->balance_runtime;
+    row[7] = profile->balance_rounds;
+    row[8] = profile->partition_runtime;
+    row[9] = profile->ghost_runtime;
+    row[10] = profile->ghost_waittime;
+    row[11] = profile->commit_runtime;
+    row[12] = profile->partition_bytes_sent;
+    row[13] = profile->ghost_bytes_sent;
+    row[14] = profile->ghost_bytes_received;
+    row[15] = profile->comm[T8_PROFILE_COMM_GHOST_EXCHANGE].bytes_sent
+      + profile->comm[T8_PROFILE_COMM_GHOST_EXCHANGE].bytes_received;
+    row[16] = profile->memory_peak[T8_PROFILE_HW_COMMIT];
+  }
+
+  /* The first process writes the rows of all processes */
+  if (mpirank == 0) {
+    rows = T8_ALLOC (double, mpisize * T8_PROFILE_CSV_NUM_COLUMNS);
+  }
+  mpiret = sc_MPI_Gather (row, T8_PROFILE_CSV_NUM_COLUMNS, sc_MPI_DOUBLE,
+                          rows, T8_PROFILE_CSV_NUM_COLUMNS, sc_MPI_DOUBLE, 0,
+                          forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    file = fopen (filename, "w");
+    if (file == NULL) {
+      t8_errorf ("Could not open file %s for writing.\n", filename);
+      success = 0;
+    }
+    else {
+      for (icol = 0; icol < T8_PROFILE_CSV_NUM_COLUMNS; icol++) {
+        fprintf (file, "%s%c", t8_forest_profile_csv_columns[icol],
+                 icol + 1 < T8_PROFILE_CSV_NUM_COLUMNS ? ',' : '\n');
+      }
+      for (iproc = 0; iproc < mpisize; iproc++) {
+        for (icol = 0; icol < T8_PROFILE_CSV_NUM_COLUMNS; icol++) {
+          fprintf (file, "%.9g%c", rows[iproc * T8_PROFILE_CSV_NUM_COLUMNS
+                                        + icol],
+                   icol + 1 < T8_PROFILE_CSV_NUM_COLUMNS ? ',' : '\n');
+        }
+      }
+      fclose (file);
+    }
+    T8_FREE (rows);
+  }
+  mpiret = sc_MPI_Bcast (&success, 1, sc_MPI_INT, 0, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return success;
+}
+
+size_t
+t8_forest_memory_usage (t8_forest_t forest, size_t * local, size_t * sum,
+                        size_t * max)
+{
+  size_t              usage[T8_FOREST_MEMORY_NUM_CATEGORIES], total, it;
+  size_t              value_size;
+  long long           send[T8_FOREST_MEMORY_NUM_CATEGORIES];
+  long long           recv[T8_FOREST_MEMORY_NUM_CATEGORIES];
+  t8_tree_t           tree;
+  t8_forest_face_neighbors_t *faces;
+  t8_forest_geometry_cache_t *geometry;
+  t8_locidx_t         num_faces, num_neighbors;
+  int                 icat, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  memset (usage, 0, sizeof (usage));
+  usage[T8_FOREST_MEMORY_STRUCT] = sizeof (t8_forest_struct_t)
+    + sc_array_memory_used (forest->trees, 1);
+  if (forest->profile != NULL) {
+    usage[T8_FOREST_MEMORY_STRUCT] += sizeof (t8_profile_t);
+  }
+  for (it = 0; it < forest->trees->elem_count; it++) {
+    tree = (t8_tree_t) sc_array_index (forest->trees, it);
+    usage[T8_FOREST_MEMORY_ELEMENTS] +=
+      sc_array_memory_used (t8_element_array_get_array (&tree->elements), 0);
+  }
+  if (forest->shared_elements != NULL) {
+    /* The trees have views, we count the shared arrays in each forest */
+    for (it = 0; it < (size_t) forest->shared_elements->num_trees; it++) {
+      usage[T8_FOREST_MEMORY_ELEMENTS] +=
+        sc_array_memory_used (&forest->shared_elements->elements[it].array,
+                              0);
+    }
+  }
+  if (forest->compressed != NULL) {
+    usage[T8_FOREST_MEMORY_ELEMENTS] +=
+      forest->trees->elem_count * sizeof (t8_linearidx_t)
+      + forest->local_num_elements * sizeof (int8_t);
+  }
+  if (forest->ghosts != NULL) {
+    usage[T8_FOREST_MEMORY_GHOSTS] =
+      t8_forest_ghost_memory_used (forest->ghosts);
+  }
+  if (forest->face_neighbors != NULL) {
+    faces = forest->face_neighbors;
+    num_faces = faces->face_offsets[faces->num_elements];
+    num_neighbors = faces->neighbor_offsets[num_faces];
+    usage[T8_FOREST_MEMORY_FACES] = sizeof (t8_forest_face_neighbors_t)
+      + (faces->num_elements + num_faces + 2) * sizeof (t8_locidx_t)
+      + num_faces * sizeof (int8_t)
+      + num_neighbors * (sizeof (t8_locidx_t) + sizeof (int8_t));
+  }
+  if (forest->element_offsets != NULL) {
+    usage[T8_FOREST_MEMORY_OFFSETS] +=
+      t8_shmem_array_get_bytes_per_process (forest->element_offsets);
+  }
+  if (forest->global_first_desc != NULL) {
+    usage[T8_FOREST_MEMORY_OFFSETS] +=
+      t8_shmem_array_get_bytes_per_process (forest->global_first_desc);
+  }
+  if (forest->tree_offsets != NULL) {
+    usage[T8_FOREST_MEMORY_OFFSETS] +=
+      t8_shmem_array_get_bytes_per_process (forest->tree_offsets);
+  }
+  if (forest->partition_compact != NULL) {
+    usage[T8_FOREST_MEMORY_OFFSETS] +=
+      t8_forest_partition_compact_memory_used (forest);
+  }
+  if (forest->element_to_tree != NULL) {
+    usage[T8_FOREST_MEMORY_INDEX] +=
+      forest->local_num_elements * sizeof (t8_locidx_t);
+  }
+  if (forest->element_levels != NULL) {
+    usage[T8_FOREST_MEMORY_INDEX] +=
+      forest->local_num_elements * sizeof (int8_t);
+  }
+  if (forest->level_lists != NULL) {
+    usage[T8_FOREST_MEMORY_INDEX] += sizeof (t8_forest_level_lists_t)
+      + (2 * (forest->level_lists->num_levels + 1)
+         + forest->local_num_elements
+         + t8_forest_get_num_ghosts (forest)) * sizeof (t8_locidx_t);
+  }
+  if (forest->owner_table != NULL) {
+    usage[T8_FOREST_MEMORY_INDEX] += sizeof (t8_forest_owner_table_t)
+      + (forest->owner_table->num_entries + 1)
+      * (sizeof (t8_gloidx_t) + sizeof (t8_linearidx_t) + sizeof (int))
+      + forest->mpisize * sizeof (int);
+  }
+  if (forest->tree_faces != NULL) {
+    usage[T8_FOREST_MEMORY_INDEX] += T8_ECLASS_MAX_FACES
+      * t8_forest_get_num_local_trees (forest)
+      * sizeof (t8_forest_tree_face_t);
+  }
+  if (forest->tree_order != NULL) {
+    usage[T8_FOREST_MEMORY_INDEX] +=
+      (forest->trees->elem_count + forest->local_num_elements + 2)
+      * sizeof (t8_locidx_t);
+  }
+  if (forest->geometry_cache != NULL) {
+    geometry = forest->geometry_cache;
+    num_faces = geometry->face_offsets[geometry->num_elements];
+    value_size = geometry->is_float ? sizeof (float) : sizeof (double);
+    usage[T8_FOREST_MEMORY_GEOMETRY] = sizeof (t8_forest_geometry_cache_t)
+      + 4 * geometry->num_elements * value_size
+      + (geometry->num_elements + 1) * sizeof (t8_locidx_t)
+      + (geometry->has_normals ? 4 : 1) * num_faces * value_size;
+  }
+  usage[T8_FOREST_MEMORY_GEOMETRY] += t8_forest_tree_curved_memory_used (forest);
+  usage[T8_FOREST_MEMORY_CMESH] =
+    t8_cmesh_memory_usage (forest->cmesh, forest->mpicomm, NULL, NULL, NULL);
+
+  for (icat = 0, total = 0; icat < T8_FOREST_MEMORY_NUM_CATEGORIES; icat++) {
+    total += usage[icat];
+    send[icat] = (long long) usage[icat];
+    if (local != NULL) {
+      local[icat] = usage[icat];
+    }
+  }
+  if (sum != NULL) {
+    mpiret = sc_MPI_Allreduce (send, recv, T8_FOREST_MEMORY_NUM_CATEGORIES,
+                               sc_MPI_LONG_LONG_INT, sc_MPI_SUM,
+                               forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    for (icat = 0; icat < T8_FOREST_MEMORY_NUM_CATEGORIES; icat++) {
+      sum[icat] = (size_t) recv[icat];
+    }
+  }
+  if (max != NULL) {
+    mpiret = sc_MPI_Allreduce (send, recv, T8_FOREST_MEMORY_NUM_CATEGORIES,
+                               sc_MPI_LONG_LONG_INT, sc_MPI_MAX,
+                               forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    for (icat = 0; icat < T8_FOREST_MEMORY_NUM_CATEGORIES; icat++) {
+      max[icat] = (size_t) recv[icat];
+    }
+  }
+  return total;
+}
+
+void
+t8_forest_print_memory_usage (t8_forest_t forest)
+{
+  size_t              sum[T8_FOREST_MEMORY_NUM_CATEGORIES];
+  size_t              max[T8_FOREST_MEMORY_NUM_CATEGORIES];
+  int                 icat;
+  const char         *names[T8_FOREST_MEMORY_NUM_CATEGORIES] = {
+    "struct", "elements", "ghosts", "faces", "offsets", "index", "geometry",
+    "cmesh"
+  };
+
+  t8_forest_memory_usage (forest, NULL, sum, max);
+  t8_global_productionf ("forest memory usage in bytes (sum, max):\n");
+  for (icat = 0; icat < T8_FOREST_MEMORY_NUM_CATEGORIES; icat++) {
+    t8_global_productionf ("  %-12s %14llu %14llu\n", names[icat],
+                           (unsigned long long) sum[icat],
+                           (unsigned long long) max[icat]);
   }
 }
 
@@ -1313,6 +2808,43 @@ t8_forest_new_uniform (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
   return forest;
 }
 
+t8_forest_t
+t8_forest_new_from_leaves (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
+                           t8_locidx_t num_leaves, const t8_gloidx_t * trees,
+                           const t8_linearidx_t * ids, const int *levels,
+                           int do_partition, int do_face_ghost,
+                           sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_partition;
+
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (scheme != NULL);
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, comm);
+  t8_forest_set_scheme (forest, scheme);
+  t8_forest_set_leaves (forest, num_leaves, trees, ids, levels);
+  if (do_face_ghost && !do_partition) {
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  }
+  t8_forest_commit (forest);
+  if (do_partition) {
+    /* Balance the number of elements of the processes */
+    t8_forest_init (&forest_partition);
+    t8_forest_set_partition (forest_partition, forest, 0);
+    if (do_face_ghost) {
+      t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
+    }
+    t8_forest_commit (forest_partition);
+    forest = forest_partition;
+  }
+  t8_global_productionf
+    ("Constructed forest from leaves with %lli global elements.\n",
+     (long long) forest->global_num_elements);
+
+  return forest;
+}
+
 t8_forest_t
 t8_forest_new_adapt (t8_forest_t forest_from,
                      t8_forest_adapt_t adapt_fn,
@@ -1345,7 +2877,10 @@ t8_forest_free_trees (t8_forest_t forest)
   number_of_trees = forest->trees->elem_count;
   for (jt = 0; jt < number_of_trees; jt++) {
     tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, jt);
-    t8_element_array_reset (&tree->elements);
+    t8_forest_release_tree_elements (forest, &tree->elements);
+  }
+  if (forest->shared_elements != NULL) {
+    t8_forest_shared_elements_unref (forest);
   }
   sc_array_destroy (forest->trees);
 }
@@ -1369,6 +2904,15 @@ t8_forest_reset (t8_forest_t * pforest)
       /* in this case we have taken ownership and not released it yet */
       t8_forest_unref (&forest->set_from);
     }
+    if (forest->set_partition_data != NULL) {
+      sc_array_destroy (forest->set_partition_data);
+    }
+    if (forest->set_load_filename != NULL) {
+      T8_FREE (forest->set_load_filename);
+    }
+    if (forest->set_leaves != NULL) {
+      T8_FREE (forest->set_leaves);
+    }
   }
   else {
     T8_ASSERT (forest->set_from == NULL);
@@ -1387,6 +2931,44 @@ t8_forest_reset (t8_forest_t * pforest)
   if (forest->ghosts != NULL) {
     t8_forest_ghost_unref (&forest->ghosts);
   }
+  /* Destroy the face neighbor table if it exists */
+  t8_forest_face_neighbors_destroy (forest);
+  /* Destroy the geometry cache if it exists */
+  t8_forest_geometry_cache_destroy (forest);
+  /* Destroy the element data fields */
+  t8_forest_fields_destroy (forest);
+  if (forest->pool != NULL) {
+    t8_forest_pool_unref (&forest->pool);
+  }
+  if (forest->tree_affine != NULL) {
+    T8_FREE (forest->tree_affine);
+  }
+  if (forest->tree_faces != NULL) {
+    T8_FREE (forest->tree_faces);
+  }
+  t8_forest_tree_curved_destroy (forest);
+  if (forest->element_to_tree != NULL) {
+    T8_FREE (forest->element_to_tree);
+  }
+  if (forest->element_levels != NULL) {
+    T8_FREE (forest->element_levels);
+  }
+  t8_forest_level_lists_destroy (forest);
+  if (forest->compressed != NULL) {
+    t8_forest_compressed_destroy (forest);
+  }
+  if (forest->owner_table != NULL) {
+    t8_forest_owner_table_destroy (forest);
+  }
+  if (forest->partition_compact != NULL) {
+    t8_forest_partition_compact_destroy (forest);
+  }
+  if (forest->tree_order != NULL) {
+    T8_FREE (forest->tree_order);
+  }
+  if (forest->element_order != NULL) {
+    T8_FREE (forest->element_order);
+  }
   /* we have taken ownership on calling t8_forest_set_* */
   if (forest->scheme_cxx != NULL) {
     t8_scheme_cxx_unref (&forest->scheme_cxx);
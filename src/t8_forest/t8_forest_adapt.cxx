@@ -25,6 +25,246 @@
 #include <t8_forest.h>
 #include <t8_data/t8_containers.h>
 #include <t8_element_cxx.hxx>
+#include <t8_default/t8_default_kernels_cxx.hxx>
+#include <t8_profile_regions.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* The minimal number of elements per thread when the new elements of a
+ * single tree are built by several threads. */
+#define T8_FOREST_ADAPT_MIN_THREAD_ELEMENTS 4096
+
+/* Compute the family boundaries of the elements of a tree in one pass.
+ * family_first[i] is set to 1 if the elements i, ..., i + num_children - 1
+ * form a family. We find candidate runs with the child ids
+ * 0, ..., num_children - 1, where num_children is the number of children
+ * of element i, and confirm each with t8_element_is_family. The child ids
+ * alone do not suffice, since the elements of a run may be of different
+ * levels or, in pyramid trees, of different shapes.
+ * This loop runs with the scheme class of the tree,
+ * see t8_default_scheme_dispatch. */
+struct t8_forest_adapt_family_kernel
+{
+  t8_element_array_t *telements_from;
+  t8_locidx_t         num_el_from;
+  int8_t             *family_first;
+
+  template < class TScheme > void run (TScheme * tscheme)
+  {
+    const t8_element_t *element;
+    t8_element_t       *fam[T8_ECLASS_MAX_CHILDREN];
+    t8_element_array_iterator_t it;
+    t8_locidx_t         ielem, first;
+    int                 child_id, family_pos, num_children, ichild;
+
+    /* family_pos is the number of consecutive elements before the current one
+     * with child ids 0, 1, ..., family_pos - 1 */
+    family_pos = 0;
+    num_children = 0;
+    for (t8_element_array_iterator_init (&it, telements_from, 0,
+                                         num_el_from);
+         t8_element_array_iterator_is_valid (&it);
+         t8_element_array_iterator_next (&it)) {
+      element = t8_element_array_iterator_get (&it);
+      ielem = (t8_locidx_t) t8_element_array_iterator_get_index (&it);
+      child_id = t8_default_kernel < TScheme >::child_id (tscheme, element);
+      if (child_id == 0) {
+        /* A new family may start here */
+        num_children =
+          t8_default_kernel < TScheme >::num_children (tscheme, element);
+        family_pos = 1;
+      }
+      else {
+        family_pos = child_id == family_pos ? family_pos + 1 : 0;
+      }
+      if (family_pos == num_children) {
+        /* Confirm that the candidate run is a family */
+        T8_ASSERT (num_children <= T8_ECLASS_MAX_CHILDREN);
+        first = ielem - num_children + 1;
+        for (ichild = 0; ichild < num_children; ichild++) {
+          fam[ichild] =
+            t8_element_array_index_locidx (telements_from, first + ichild);
+        }
+        if (t8_default_kernel < TScheme >::is_family (tscheme, fam)) {
+          family_first[first] = 1;
+        }
+        family_pos = 0;
+      }
+    }
+  }
+};
+
+/* Determine whether the markers of the batched adapt function leave all
+ * elements of a tree unchanged. This loop runs with the scheme class of
+ * the tree, see t8_default_scheme_dispatch. */
+struct t8_forest_adapt_unchanged_kernel
+{
+  t8_element_array_t *telements_from;
+  t8_locidx_t         num_el_from;
+  const int8_t       *family_first;
+  const int          *markers;
+  int                 maxlevel;
+  int                 unchanged;
+
+  template < class TScheme > void run (TScheme * tscheme)
+  {
+    t8_locidx_t         ielem;
+
+    unchanged = 1;
+    for (ielem = 0; ielem < num_el_from; ielem++) {
+      if ((markers[ielem] < 0 && family_first[ielem])
+          || (markers[ielem] > 0
+              && t8_default_kernel < TScheme >::level (tscheme,
+                                                       t8_element_array_index_locidx
+                                                       (telements_from,
+                                                        ielem)) <
+              maxlevel)) {
+        unchanged = 0;
+        return;
+      }
+    }
+  }
+};
+
+/* Determine the number of new elements that each element of a tree is
+ * replaced with by the batched adapt function.
+ * A refined element has num_children new elements, the first element of a
+ * coarsened family has one new element and the other family members have
+ * none. All other elements are kept.
+ * Each element is processed independently, so that with the direct calls
+ * of the default schemes the loops may run with several threads.
+ * This loop runs with the scheme class of the tree,
+ * see t8_default_scheme_dispatch. */
+struct t8_forest_adapt_count_kernel
+{
+  t8_element_array_t *telements_from;
+  t8_locidx_t         num_el_from;
+  const int8_t       *family_first;
+  const int          *markers;
+  int                 maxlevel;
+  int                 num_threads;
+  t8_locidx_t        *out_count;
+
+  template < class TScheme > void run (TScheme * tscheme)
+  {
+    const t8_element_t *element;
+    t8_locidx_t         ielem, ichild, num_children;
+    int                 nthreads;
+
+    nthreads = t8_default_kernel < TScheme >::is_direct ? num_threads : 1;
+    (void) nthreads;
+#ifdef T8_ENABLE_OPENMP
+#pragma omp parallel num_threads (nthreads) if (nthreads > 1) \
+  private (element, ielem, ichild, num_children)
+#endif
+    {
+#ifdef T8_ENABLE_OPENMP
+#pragma omp for schedule (static)
+#endif
+      for (ielem = 0; ielem < num_el_from; ielem++) {
+        element = t8_element_array_index_locidx (telements_from, ielem);
+        out_count[ielem] = markers[ielem] > 0
+          && t8_default_kernel < TScheme >::level (tscheme,
+                                                   element) < maxlevel ?
+          t8_default_kernel < TScheme >::num_children (tscheme, element) : 1;
+      }
+      /* The families do not overlap, so that each thread writes
+       * different entries. The implicit barrier of the loop above ensures
+       * that all counts are set. */
+#ifdef T8_ENABLE_OPENMP
+#pragma omp for schedule (static)
+#endif
+      for (ielem = 0; ielem < num_el_from; ielem++) {
+        if (markers[ielem] < 0 && family_first[ielem]) {
+          element = t8_element_array_index_locidx (telements_from, ielem);
+          num_children =
+            t8_default_kernel < TScheme >::num_children (tscheme, element);
+          out_count[ielem] = 1;
+          for (ichild = 1; ichild < num_children; ichild++) {
+            out_count[ielem + ichild] = 0;
+          }
+        }
+      }
+    }
+  }
+};
+
+/* Fill the new element array of a tree from the markers of the batched
+ * adapt function. The new elements of element i start at out_offsets[i],
+ * and the new element array has been resized to hold all of them.
+ * Each element is processed independently, see
+ * t8_forest_adapt_count_kernel.
+ * This loop runs with the scheme class of the tree,
+ * see t8_default_scheme_dispatch. */
+struct t8_forest_adapt_build_kernel
+{
+  t8_element_array_t *telements;
+  t8_element_array_t *telements_from;
+  t8_locidx_t         num_el_from;
+  const int8_t       *family_first;
+  const int          *markers;
+  const t8_locidx_t  *out_offsets;
+  int                 num_threads;
+
+  template < class TScheme > void run (TScheme * tscheme)
+  {
+    const t8_element_t *element;
+    t8_element_t       *children[T8_ECLASS_MAX_CHILDREN];
+    t8_locidx_t         ielem, num_new;
+    int                 ichild, nthreads;
+
+    nthreads = t8_default_kernel < TScheme >::is_direct ? num_threads : 1;
+    (void) nthreads;
+#ifdef T8_ENABLE_OPENMP
+#pragma omp parallel for num_threads (nthreads) if (nthreads > 1) \
+  private (element, children, num_new, ichild) schedule (static)
+#endif
+    for (ielem = 0; ielem < num_el_from; ielem++) {
+      num_new = out_offsets[ielem + 1] - out_offsets[ielem];
+      if (num_new == 0) {
+        /* A later member of a coarsened family */
+        continue;
+      }
+      element = t8_element_array_index_locidx (telements_from, ielem);
+      T8_ASSERT (family_first[ielem] || markers[ielem] >= 0);
+      if (markers[ielem] < 0 && family_first[ielem]) {
+        /* The family starting at ielem is coarsened */
+#ifdef T8_ENABLE_DEBUG
+        for (ichild = 0;
+             ichild < t8_default_kernel < TScheme >::num_children (tscheme,
+                                                                   element);
+             ichild++) {
+          children[ichild] =
+            t8_element_array_index_locidx (telements_from, ielem + ichild);
+        }
+        T8_ASSERT (tscheme->t8_element_is_family (children));
+#endif
+        t8_default_kernel < TScheme >::parent (tscheme, element,
+                                               t8_element_array_index_locidx
+                                               (telements,
+                                                out_offsets[ielem]));
+      }
+      else if (num_new > 1) {
+        /* The element is refined. We write the children directly
+         * into the new element array, where they are consecutive. */
+        T8_ASSERT (num_new ==
+                   t8_default_kernel < TScheme >::num_children (tscheme,
+                                                                element));
+        t8_default_kernel < TScheme >::children_batch (tscheme, element, 1,
+                                                       t8_element_array_index_locidx
+                                                       (telements,
+                                                        out_offsets[ielem]));
+      }
+      else {
+        /* The element is kept */
+        t8_default_kernel < TScheme >::copy (tscheme, element,
+                                             t8_element_array_index_locidx
+                                             (telements, out_offsets[ielem]));
+      }
+    }
+  }
+};
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -41,6 +281,7 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
 {
   t8_element_t       *element;
   t8_element_t      **fam;
+  t8_element_array_iterator_t it;
   t8_locidx_t         pos;
   size_t              elements_in_array;
   int                 num_children, i, isfamily;
@@ -51,9 +292,14 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   elements_in_array = t8_element_array_get_count (telement);
   T8_ASSERT (*el_inserted == (t8_locidx_t) elements_in_array);
   T8_ASSERT (el_coarsen >= 0);
-  element = t8_element_array_index_locidx (telement, *el_inserted - 1);
-  /* TODO: This assumes that the number of children is the same for each
-   *       element in that class. This may not be the case. */
+  /* The iterator points to the last element that may be coarsened. It stays
+   * valid when we shrink the array, the element pointers do not. */
+  t8_element_array_iterator_init (&it, telement, 0, elements_in_array);
+  t8_element_array_iterator_seek (&it, *el_inserted - 1);
+  element = t8_element_array_iterator_get (&it);
+  /* The last child of an element has the same shape as the element.
+   * Thus, the size of the family of the last element is its number
+   * of children. */
   num_children = ts->t8_element_num_children (element);
   T8_ASSERT (ts->t8_element_child_id (element) == num_children - 1);
 
@@ -83,87 +329,480 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
       ts->t8_element_parent (fam[0], fam[0]);
       elements_in_array -= num_children - 1;
       t8_element_array_resize (telement, elements_in_array);
-      /* Set element to the new constructed parent. Since resizing the array
-       * may change the position in memory, we have to do it after resizing. */
-      element = t8_element_array_index_locidx (telement, pos);
+      /* Set element to the new constructed parent */
+      t8_element_array_iterator_seek (&it, pos);
+      element = t8_element_array_iterator_get (&it);
+      num_children = ts->t8_element_num_children (element);
+      pos -= num_children - 1;
     }
     else {
       /* If the elements are no family or
        * the family is not to be coarsened we abort the coarsening process */
       isfamily = 0;
     }
-    pos -= num_children - 1;
   }
 }
 
+/* Refine element recursively and append all resulting leaf elements to
+ * telements. element must not be an element of telements and must be
+ * refinable, i.e. its level is smaller than forest->maxlevel.
+ * We traverse the refinement tree depth first. The children of the element
+ * that is refined at depth d are stored in the d-th row of
+ * T8_ECLASS_MAX_CHILDREN elements of stack, stack_num[d] is the number of
+ * these children and stack_pos[d] is the index of the next child of
+ * this row that we consider. stack must hold at least
+ * (forest->maxlevel - level of element) rows and stack_pos and stack_num at
+ * least as many entries. Thus we do not need to allocate any elements while
+ * we refine. el_buffer must have space for T8_ECLASS_MAX_CHILDREN pointers. */
 static void
 t8_forest_adapt_refine_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                   t8_locidx_t lelement_id,
                                   t8_eclass_scheme_c * ts,
-                                  sc_list_t * elem_list,
+                                  const t8_element_t * element,
+                                  t8_element_array_t * stack,
+                                  int *stack_pos, int *stack_num,
                                   t8_element_array_t * telements,
                                   t8_locidx_t * num_inserted,
                                   t8_element_t ** el_buffer)
 {
-  t8_element_t       *insert_el;
+  t8_element_t       *insert_el, *child;
   int                 num_children;
-  int                 ci;
+  int                 ci, depth;
 
-  if (elem_list->elem_count <= 0) {
-    return;
+  T8_ASSERT (ts->t8_element_level (element) < forest->maxlevel);
+  T8_ASSERT ((size_t) T8_ECLASS_MAX_CHILDREN * (forest->maxlevel -
+                                                ts->t8_element_level
+                                                (element))
+             <= t8_element_array_get_count (stack));
+
+  /* Store the children of element in the first row of the stack */
+  depth = 0;
+  num_children = ts->t8_element_num_children (element);
+  T8_ASSERT (num_children <= T8_ECLASS_MAX_CHILDREN);
+  for (ci = 0; ci < num_children; ci++) {
+    el_buffer[ci] = t8_element_array_index_int (stack, ci);
   }
-  while (elem_list->elem_count > 0) {
-    el_buffer[0] = (t8_element_t *) sc_list_pop (elem_list);
-    num_children = ts->t8_element_num_children (el_buffer[0]);
+  ts->t8_element_children (element, num_children, el_buffer);
+  stack_pos[0] = 0;
+  stack_num[0] = num_children;
+  while (depth >= 0) {
+    if (stack_pos[depth] >= stack_num[depth]) {
+      /* All children of this row are processed, go up one level */
+      depth--;
+      continue;
+    }
+    child = t8_element_array_index_int (stack,
+                                        depth * T8_ECLASS_MAX_CHILDREN +
+                                        stack_pos[depth]);
+    stack_pos[depth]++;
+    el_buffer[0] = child;
     if (forest->set_adapt_fn (forest, forest->set_from, ltreeid, lelement_id,
-                              ts, 1, el_buffer) > 0) {
-      /* The element should be refined */
-      if (ts->t8_element_level (el_buffer[0]) < forest->maxlevel) {
-        /* only refine, if we do not exceed the maximum allowed level */
-        ts->t8_element_new (num_children - 1, el_buffer + 1);
-        ts->t8_element_children (el_buffer[0], num_children, el_buffer);
-        for (ci = num_children - 1; ci >= 0; ci--) {
-          (void) sc_list_prepend (elem_list, el_buffer[ci]);
-        }
+                              ts, 1, el_buffer) > 0
+        && ts->t8_element_level (child) < forest->maxlevel) {
+      /* The element should be refined and does not exceed the maximum
+       * allowed level. We store its children in the next row. */
+      depth++;
+      num_children = ts->t8_element_num_children (child);
+      T8_ASSERT (num_children <= T8_ECLASS_MAX_CHILDREN);
+      for (ci = 0; ci < num_children; ci++) {
+        el_buffer[ci] =
+          t8_element_array_index_int (stack,
+                                      depth * T8_ECLASS_MAX_CHILDREN + ci);
       }
+      ts->t8_element_children (child, num_children, el_buffer);
+      stack_pos[depth] = 0;
+      stack_num[depth] = num_children;
     }
     else {
+      /* The element is a leaf of the new forest */
       insert_el = t8_element_array_push (telements);
-      ts->t8_element_copy (el_buffer[0], insert_el);
-      ts->t8_element_destroy (1, el_buffer);
+      ts->t8_element_copy (child, insert_el);
       (*num_inserted)++;
     }
   }
 }
 
-/* TODO: optimize this when we own forest_from */
-void
-t8_forest_adapt (t8_forest_t forest)
+/* Return the number of threads that we use to build the new elements of a
+ * tree with num_elements elements during batched adaptation.
+ * We only use several threads if the trees are not already adapted
+ * concurrently and if each thread gets enough elements.
+ * If OpenMP is not enabled, this is 1. */
+static int
+t8_forest_adapt_get_element_threads (t8_forest_t forest,
+                                     t8_locidx_t num_elements)
+{
+#ifdef T8_ENABLE_OPENMP
+  int                 num_threads;
+
+  if (forest->set_adapt_threads == 0 || forest->set_adapt_threads == 1
+      || omp_in_parallel ()) {
+    return 1;
+  }
+  num_threads = forest->set_adapt_threads < 0 ?
+    t8_get_num_threads () : forest->set_adapt_threads;
+  num_threads = SC_MIN (num_threads,
+                        num_elements / T8_FOREST_ADAPT_MIN_THREAD_ELEMENTS);
+  return SC_MAX (num_threads, 1);
+#else
+  return 1;
+#endif
+}
+
+/* Adapt a single tree with the batched adapt function.
+ * The family information and the markers for all elements of the tree
+ * are computed in one pass and afterwards the new element array is filled
+ * in a count, scan and fill pass.
+ * Returns the number of elements in the new tree.
+ * If no element of the tree changes, we do not fill telements but set
+ * \a tree_unchanged to true. */
+static              t8_locidx_t
+t8_forest_adapt_tree_batch (t8_forest_t forest, t8_locidx_t ltree_id,
+                            t8_eclass_scheme_c * tscheme,
+                            t8_element_array_t * telements,
+                            t8_element_array_t * telements_from,
+                            int *tree_unchanged)
+{
+  t8_locidx_t         num_el_from, ielem, el_inserted;
+  t8_locidx_t        *out_offsets;
+  int8_t             *family_first;
+  int                *markers;
+  int                 num_threads;
+  t8_forest_adapt_family_kernel family_kernel;
+  t8_forest_adapt_unchanged_kernel unchanged_kernel;
+  t8_forest_adapt_count_kernel count_kernel;
+  t8_forest_adapt_build_kernel build_kernel;
+
+  *tree_unchanged = 0;
+  num_el_from = (t8_locidx_t) t8_element_array_get_count (telements_from);
+  if (num_el_from == 0) {
+    return 0;
+  }
+  family_first = T8_ALLOC_ZERO (int8_t, num_el_from);
+  markers = T8_ALLOC_ZERO (int, num_el_from);
+
+  /* Compute the family boundaries in one pass */
+  family_kernel.telements_from = telements_from;
+  family_kernel.num_el_from = num_el_from;
+  family_kernel.family_first = family_first;
+  t8_default_scheme_dispatch (tscheme, family_kernel);
+
+  /* Let the user compute all markers of this tree at once */
+  forest->set_adapt_batch_fn (forest, forest->set_from, ltree_id, tscheme,
+                              telements_from, family_first, markers);
+
+  /* Check whether any element changes */
+  unchanged_kernel.telements_from = telements_from;
+  unchanged_kernel.num_el_from = num_el_from;
+  unchanged_kernel.family_first = family_first;
+  unchanged_kernel.markers = markers;
+  unchanged_kernel.maxlevel = forest->maxlevel;
+  t8_default_scheme_dispatch (tscheme, unchanged_kernel);
+  *tree_unchanged = unchanged_kernel.unchanged;
+  if (*tree_unchanged) {
+    T8_FREE (family_first);
+    T8_FREE (markers);
+    return num_el_from;
+  }
+
+  /* Count the new elements of each element and compute their positions in
+   * the new element array with an exclusive prefix sum. Afterwards all new
+   * elements are written independently of each other. */
+  num_threads = t8_forest_adapt_get_element_threads (forest, num_el_from);
+  out_offsets = T8_ALLOC (t8_locidx_t, num_el_from + 1);
+  count_kernel.telements_from = telements_from;
+  count_kernel.num_el_from = num_el_from;
+  count_kernel.family_first = family_first;
+  count_kernel.markers = markers;
+  count_kernel.maxlevel = forest->maxlevel;
+  count_kernel.num_threads = num_threads;
+  count_kernel.out_count = out_offsets + 1;
+  t8_default_scheme_dispatch (tscheme, count_kernel);
+  out_offsets[0] = 0;
+  for (ielem = 0; ielem < num_el_from; ielem++) {
+    out_offsets[ielem + 1] += out_offsets[ielem];
+  }
+  el_inserted = out_offsets[num_el_from];
+  (void) t8_element_array_push_count (telements, el_inserted);
+
+  build_kernel.telements = telements;
+  build_kernel.telements_from = telements_from;
+  build_kernel.num_el_from = num_el_from;
+  build_kernel.family_first = family_first;
+  build_kernel.markers = markers;
+  build_kernel.out_offsets = out_offsets;
+  build_kernel.num_threads = num_threads;
+  t8_default_scheme_dispatch (tscheme, build_kernel);
+
+  T8_FREE (out_offsets);
+  T8_FREE (family_first);
+  T8_FREE (markers);
+  return el_inserted;
+}
+
+/* Called if no element of a tree changes during adaptation.
+ * We set tree_unchanged to true. If copy_elements is true, we copy all
+ * elements, otherwise the caller takes over the elements from
+ * telements_from. */
+static void
+t8_forest_adapt_tree_keep (t8_element_array_t * telements,
+                           t8_element_array_t * telements_from,
+                           int copy_elements, int *tree_unchanged)
+{
+  *tree_unchanged = 1;
+  if (copy_elements) {
+    t8_element_array_copy (telements, telements_from);
+  }
+}
+
+/* Return the number of threads that we use to adapt the trees of forest.
+ * If OpenMP is not enabled, this is 1. */
+static int
+t8_forest_adapt_get_num_threads (t8_forest_t forest)
+{
+#ifdef T8_ENABLE_OPENMP
+  int                 num_threads;
+
+  if (forest->set_adapt_threads == 0 || forest->set_adapt_threads == 1) {
+    return 1;
+  }
+  num_threads = forest->set_adapt_threads < 0 ?
+    t8_get_num_threads () : forest->set_adapt_threads;
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (num_threads, t8_forest_get_num_local_trees (forest));
+  return SC_MAX (num_threads, 1);
+#else
+  return 1;
+#endif
+}
+
+/* Adapt a single local tree of forest from the corresponding tree of
+ * forest->set_from. The elements of the new tree are stored in its element
+ * array and the number of these elements is returned.
+ * If no element of the tree changes, we set *tree_unchanged to true. In this
+ * case, if \a copy_unchanged is false, we do not fill the element array of
+ * the tree, such that the caller can take over the elements of
+ * forest->set_from.
+ * This function only modifies the tree ltree_id of forest and may thus be
+ * called concurrently for different trees. */
+static              t8_locidx_t
+t8_forest_adapt_tree (t8_forest_t forest, t8_locidx_t ltree_id,
+                      int copy_unchanged, int *tree_unchanged)
 {
   t8_forest_t         forest_from;
-  sc_list_t          *refine_list = NULL;       /* This is only needed when we adapt recursively */
   t8_element_array_t *telements, *telements_from;
-  t8_locidx_t         ltree_id, num_trees;
   t8_locidx_t         el_considered;
   t8_locidx_t         el_inserted;
   t8_locidx_t         el_coarsen;
   t8_locidx_t         num_el_from;
-  t8_locidx_t         el_offset;
   size_t              num_children, zz;
   t8_tree_t           tree, tree_from;
   t8_eclass_scheme_c *tscheme;
-  t8_element_t      **elements, **elements_from, *elpop;
+  t8_element_t      **elements, **elements_from;
+  t8_element_array_t  refine_stack;     /* Only needed when we refine recursively */
+  int                *refine_stack_pos = NULL;
+  int                *refine_stack_num = NULL;
   int                 refine;
-  int                 ci;
   int                 num_elements;
+  int                 unchanged;
 #ifdef T8_ENABLE_DEBUG
   int                 is_family;
 #endif
 
+  forest_from = forest->set_from;
+  tree = t8_forest_get_tree (forest, ltree_id);
+  tree_from = t8_forest_get_tree (forest_from, ltree_id);
+  telements = &tree->elements;
+  telements_from = &tree_from->elements;
+  num_el_from = (t8_locidx_t) t8_element_array_get_count (telements_from);
+  tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
+  if (forest->set_adapt_batch_fn != NULL) {
+    /* Adapt the whole tree with one call to the batched adapt function */
+    el_inserted = t8_forest_adapt_tree_batch (forest, ltree_id, tscheme,
+                                              telements, telements_from,
+                                              &unchanged);
+    if (unchanged) {
+      t8_forest_adapt_tree_keep (telements, telements_from, copy_unchanged,
+                                 tree_unchanged);
+    }
+    return el_inserted;
+  }
+  el_considered = 0;
+  el_inserted = 0;
+  el_coarsen = 0;
+  /* As long as no element changed, we do not write the kept elements to
+   * telements but copy them at once when the first element changes.
+   * When we adapt recursively, a kept family may still be coarsened
+   * from telements, so we always write the elements. */
+  unchanged = !forest->set_adapt_recursive;
+  if (!unchanged) {
+    t8_element_array_reserve (telements, num_el_from);
+  }
+  elements = T8_ALLOC (t8_element_t *, T8_ECLASS_MAX_CHILDREN);
+  elements_from = T8_ALLOC (t8_element_t *, T8_ECLASS_MAX_CHILDREN);
+  while (el_considered < num_el_from) {
+#ifdef T8_ENABLE_DEBUG
+    is_family = 1;
+#endif
+    /* The number of children of the considered element is the size of
+     * the family that it may start. This differs between the elements
+     * of a tree if it has elements of different shapes. */
+    num_children =
+      tscheme->t8_element_num_children (t8_element_array_index_locidx
+                                        (telements_from, el_considered));
+    T8_ASSERT (num_children <= T8_ECLASS_MAX_CHILDREN);
+    num_elements = num_children;
+    for (zz = 0; zz < num_children &&
+         el_considered + (t8_locidx_t) zz < num_el_from; zz++) {
+      elements_from[zz] = t8_element_array_index_locidx (telements_from,
+                                                         el_considered + zz);
+      if ((size_t) tscheme->t8_element_child_id (elements_from[zz]) != zz) {
+        break;
+      }
+    }
+    if (zz != num_children) {
+      num_elements = 1;
+#ifdef T8_ENABLE_DEBUG
+      is_family = 0;
+#endif
+    }
+    T8_ASSERT (!is_family || tscheme->t8_element_is_family (elements_from));
+    refine =
+      forest->set_adapt_fn (forest, forest->set_from, ltree_id,
+                            el_considered, tscheme, num_elements,
+                            elements_from);
+    T8_ASSERT (is_family || refine >= 0);
+    if (refine > 0 && tscheme->t8_element_level (elements_from[0]) >=
+        forest->maxlevel) {
+      /* Only refine an element if it does not exceed the maximum level */
+      refine = 0;
+    }
+    if (refine != 0 && unchanged) {
+      /* This is the first element that changes. We copy all previous
+       * elements, which were kept, to the new element array. */
+      T8_ASSERT (el_inserted == el_considered);
+      /* We expect the new tree to have about as many elements as the
+       * old one. This saves most reallocations of the new array. */
+      t8_element_array_reserve (telements, num_el_from);
+      if (el_considered > 0) {
+        (void) t8_element_array_push_count (telements, el_considered);
+        memcpy (t8_element_array_index_locidx (telements, 0),
+                t8_element_array_index_locidx (telements_from, 0),
+                el_considered * t8_element_array_get_size (telements));
+      }
+      unchanged = 0;
+    }
+    if (refine > 0) {
+      /* The first element is to be refined */
+      if (forest->set_adapt_recursive) {
+        /* el_coarsen is the index of the first element in the new element
+         * array which could be coarsened recursively.
+         * We can set this here, since a family that emerges from a refinement will never be coarsened */
+        el_coarsen = el_inserted + num_children;
+        if (refine_stack_pos == NULL) {
+          /* Allocate the stack for the recursive refinement once per tree.
+           * Since each level of elements_from[0] is at least 0, maxlevel
+           * rows are always enough. */
+          t8_element_array_init_size (&refine_stack, tscheme,
+                                      T8_ECLASS_MAX_CHILDREN *
+                                      forest->maxlevel);
+          refine_stack_pos = T8_ALLOC (int, forest->maxlevel);
+          refine_stack_num = T8_ALLOC (int, forest->maxlevel);
+        }
+        t8_forest_adapt_refine_recursive (forest, ltree_id, el_considered,
+                                          tscheme, elements_from[0],
+                                          &refine_stack, refine_stack_pos,
+                                          refine_stack_num, telements,
+                                          &el_inserted, elements);
+      }
+      else {
+        /* add the children to the element array of the current tree */
+        (void) t8_element_array_push_count (telements, num_children);
+        for (zz = 0; zz < num_children; zz++) {
+          elements[zz] =
+            t8_element_array_index_locidx (telements, el_inserted + zz);
+        }
+        tscheme->t8_element_children (elements_from[0], num_children,
+                                      elements);
+        el_inserted += num_children;
+      }
+      el_considered++;
+    }
+    else if (refine < 0) {
+      /* The elements form a family and are to be coarsened */
+      elements[0] = t8_element_array_push (telements);
+      tscheme->t8_element_parent (elements_from[0], elements[0]);
+      el_inserted++;
+      if (forest->set_adapt_recursive) {
+        if (tscheme->t8_element_child_id (elements[0])
+            == tscheme->t8_element_num_children (elements[0]) - 1) {
+          t8_forest_adapt_coarsen_recursive (forest, ltree_id,
+                                             el_considered, tscheme,
+                                             telements, el_coarsen,
+                                             &el_inserted, elements);
+        }
+      }
+      el_considered += num_children;
+    }
+    else {
+      /* The considered elements are neither to be coarsened nor is the first
+       * one to be refined */
+      T8_ASSERT (refine == 0);
+      if (!unchanged) {
+        elements[0] = t8_element_array_push (telements);
+        tscheme->t8_element_copy (elements_from[0], elements[0]);
+      }
+      el_inserted++;
+      if (forest->set_adapt_recursive &&
+          (size_t) tscheme->t8_element_child_id (elements[0])
+          == num_children - 1) {
+        t8_forest_adapt_coarsen_recursive (forest, ltree_id, el_considered,
+                                           tscheme, telements, el_coarsen,
+                                           &el_inserted, elements);
+      }
+      el_considered++;
+    }
+  }
+  if (refine_stack_pos != NULL) {
+    t8_element_array_reset (&refine_stack);
+    T8_FREE (refine_stack_pos);
+    T8_FREE (refine_stack_num);
+  }
+  if (unchanged) {
+    T8_ASSERT (el_inserted == num_el_from);
+    t8_forest_adapt_tree_keep (telements, telements_from, copy_unchanged,
+                               tree_unchanged);
+  }
+  else {
+    t8_element_array_resize (telements, el_inserted);
+    /* Release the memory that we reserved in excess */
+    t8_element_array_shrink_to_fit (telements);
+  }
+
+  T8_FREE (elements);
+  T8_FREE (elements_from);
+  return el_inserted;
+}
+
+void
+t8_forest_adapt (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  t8_locidx_t         ltree_id, num_trees;
+  t8_locidx_t         el_offset;
+  t8_locidx_t        *num_tree_elements;
+  t8_tree_t           tree, tree_from;
+  t8_element_array_t  swap_elements;
+  int                *tree_unchanged;
+  int                 num_threads;
+  int                 consume_from;
+
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->set_from != NULL);
   T8_ASSERT (forest->set_adapt_recursive != -1);
+  T8_ASSERT (forest->set_adapt_batch_fn == NULL
+             || !forest->set_adapt_recursive);
 
+  t8_profile_region_begin ("adapt");
   /* if profiling is enabled, measure runtime */
   if (forest->profile != NULL) {
     forest->profile->adapt_runtime = -sc_MPI_Wtime ();
@@ -183,147 +822,79 @@ t8_forest_adapt (t8_forest_t forest)
    * Will we do this here or in an extra function? */
   T8_ASSERT (forest->trees->elem_count == forest_from->trees->elem_count);
 
-  if (forest->set_adapt_recursive) {
-    refine_list = sc_list_new (NULL);
-  }
-  forest->local_num_elements = 0;
-  el_offset = 0;
   num_trees = t8_forest_get_num_local_trees (forest);
-  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
-    tree = t8_forest_get_tree (forest, ltree_id);
-    tree_from = t8_forest_get_tree (forest_from, ltree_id);
-    telements = &tree->elements;
-    telements_from = &tree_from->elements;
-    num_el_from = (t8_locidx_t) t8_element_array_get_count (telements_from);
-    tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
-    el_considered = 0;
-    el_inserted = 0;
-    el_coarsen = 0;
-    /* TODO: this will generate problems with pyramidal elements */
-    num_children =
-      tscheme->t8_element_num_children (t8_element_array_index_locidx
-                                        (telements_from, 0));
-    elements = T8_ALLOC (t8_element_t *, num_children);
-    elements_from = T8_ALLOC (t8_element_t *, num_children);
-    while (el_considered < num_el_from) {
-#ifdef T8_ENABLE_DEBUG
-      is_family = 1;
-#endif
-      num_elements = num_children;
-      for (zz = 0; zz < num_children &&
-           el_considered + (t8_locidx_t) zz < num_el_from; zz++) {
-        elements_from[zz] = t8_element_array_index_locidx (telements_from,
-                                                           el_considered +
-                                                           zz);
-        if ((size_t) tscheme->t8_element_child_id (elements_from[zz]) != zz) {
-          break;
-        }
-      }
-      if (zz != num_children) {
-        num_elements = 1;
-#ifdef T8_ENABLE_DEBUG
-        is_family = 0;
+  /* The number of new elements for each tree. We store them separately,
+   * such that the trees can be adapted in any order. */
+  num_tree_elements = T8_ALLOC_ZERO (t8_locidx_t, num_trees);
+  /* If we hold the only reference to forest_from, it is destroyed after
+   * this forest is committed. In this case we do not copy the elements of
+   * unchanged trees but take over the element arrays of forest_from.
+   * Element arrays that forest_from shares with other forests are freed
+   * with the last reference, so we cannot take them over. */
+  consume_from = forest_from->rc.refcount == 1
+    && forest_from->shared_elements == NULL;
+  tree_unchanged = T8_ALLOC_ZERO (int, num_trees);
+  num_threads = t8_forest_adapt_get_num_threads (forest);
+  if (num_threads > 1) {
+#ifdef T8_ENABLE_OPENMP
+    /* Adapt the trees concurrently. Each thread only writes to the
+     * trees that it adapts and to their entries in num_tree_elements
+     * and tree_unchanged. */
+#pragma omp parallel for num_threads (num_threads) schedule (dynamic)
+    for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+      num_tree_elements[ltree_id] =
+        t8_forest_adapt_tree (forest, ltree_id, !consume_from,
+                              tree_unchanged + ltree_id);
+    }
+#else
+    SC_ABORT_NOT_REACHED ();
 #endif
-      }
-      T8_ASSERT (!is_family || tscheme->t8_element_is_family (elements_from));
-      refine =
-        forest->set_adapt_fn (forest, forest->set_from, ltree_id,
-                              el_considered, tscheme, num_elements,
-                              elements_from);
-      T8_ASSERT (is_family || refine >= 0);
-      if (refine > 0 && tscheme->t8_element_level (elements_from[0]) >=
-          forest->maxlevel) {
-        /* Only refine an element if it does not exceed the maximum level */
-        refine = 0;
-      }
-      if (refine > 0) {
-        /* The first element is to be refined */
-        if (forest->set_adapt_recursive) {
-          /* el_coarsen is the index of the first element in the new element
-           * array which could be coarsened recursively.
-           * We can set this here, since a family that emerges from a refinement will never be coarsened */
-          el_coarsen = el_inserted + num_children;
-          tscheme->t8_element_new (num_children, elements);
-          tscheme->t8_element_children (elements_from[0], num_children,
-                                        elements);
-          for (ci = num_children - 1; ci >= 0; ci--) {
-            (void) sc_list_prepend (refine_list, elements[ci]);
-          }
-          t8_forest_adapt_refine_recursive (forest, ltree_id, el_considered,
-                                            tscheme, refine_list, telements,
-                                            &el_inserted, elements);
-        }
-        else {
-          /* add the children to the element array of the current tree */
-          (void) t8_element_array_push_count (telements, num_children);
-          for (zz = 0; zz < num_children; zz++) {
-            elements[zz] =
-              t8_element_array_index_locidx (telements, el_inserted + zz);
-          }
-          tscheme->t8_element_children (elements_from[0], num_children,
-                                        elements);
-          el_inserted += num_children;
-        }
-        el_considered++;
-      }
-      else if (refine < 0) {
-        /* The elements form a family and are to be coarsened */
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_parent (elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive) {
-          if ((size_t) tscheme->t8_element_child_id (elements[0])
-              == num_children - 1) {
-            t8_forest_adapt_coarsen_recursive (forest, ltree_id,
-                                               el_considered, tscheme,
-                                               telements, el_coarsen,
-                                               &el_inserted, elements);
-          }
-        }
-        el_considered += num_children;
-      }
-      else {
-        /* The considered elements are neither to be coarsened nor is the first
-         * one to be refined */
-        T8_ASSERT (refine == 0);
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_copy (elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive &&
-            (size_t) tscheme->t8_element_child_id (elements[0])
-            == num_children - 1) {
-          t8_forest_adapt_coarsen_recursive (forest, ltree_id, el_considered,
-                                             tscheme, telements, el_coarsen,
-                                             &el_inserted, elements);
-        }
-        el_considered++;
-      }
+  }
+  else {
+    for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+      num_tree_elements[ltree_id] =
+        t8_forest_adapt_tree (forest, ltree_id, !consume_from,
+                              tree_unchanged + ltree_id);
     }
-    if (forest->set_adapt_recursive) {
-      while (refine_list->elem_count > 0) {
-        SC_ABORT_NOT_REACHED ();
-        elpop = (t8_element_t *) sc_list_pop (refine_list);
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_copy (elpop, elements[0]);
-        tscheme->t8_element_destroy (1, &elpop);
-        el_inserted++;
+  }
+  if (consume_from) {
+    /* Swap the element arrays of the unchanged trees with the empty arrays
+     * of forest_from. We can only do this after all trees are adapted,
+     * since the adapt callback may access any tree of forest_from. */
+    for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+      if (tree_unchanged[ltree_id]) {
+        tree = t8_forest_get_tree (forest, ltree_id);
+        tree_from = t8_forest_get_tree (forest_from, ltree_id);
+        T8_ASSERT (t8_element_array_get_count (&tree->elements) == 0);
+        swap_elements = tree->elements;
+        tree->elements = tree_from->elements;
+        tree_from->elements = swap_elements;
       }
     }
-    tree->elements_offset = el_offset;
-    el_offset += el_inserted;
-    forest->local_num_elements += el_inserted;
-    t8_element_array_resize (telements, el_inserted);
-
-    T8_FREE (elements);
-    T8_FREE (elements_from);
-    /* TODO: compute tree->element_offset */
   }
-  if (forest->set_adapt_recursive) {
-    sc_list_destroy (refine_list);
+  /* Remember whether any local element changed */
+  forest->adapt_unchanged = 1;
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    if (!tree_unchanged[ltree_id]) {
+      forest->adapt_unchanged = 0;
+      break;
+    }
   }
-  t8_forest_comm_global_num_elements (forest);
-  t8_global_productionf ("Done t8_forest_adapt with %lld total elements\n",
-                         (long long) forest->global_num_elements);
+  T8_FREE (tree_unchanged);
+  /* Compute the element offsets of the trees as a prefix sum over
+   * the new element counts */
+  el_offset = 0;
+  for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
+    tree = t8_forest_get_tree (forest, ltree_id);
+    tree->elements_offset = el_offset;
+    el_offset += num_tree_elements[ltree_id];
+  }
+  forest->local_num_elements = el_offset;
+  T8_FREE (num_tree_elements);
+
+  /* The global number of elements is reduced together with the other
+   * global values when the forest is committed */
+  forest->global_num_elements = -1;
 
   /* if profiling is enabled, measure runtime */
   if (forest->profile != NULL) {
@@ -335,6 +906,13 @@ t8_forest_adapt (t8_forest_t forest)
     t8_global_productionf ("End adadpt %f %f\n", sc_MPI_Wtime (),
                            forest->profile->adapt_runtime);
   }
+  t8_profile_region_end ("adapt");
+  if (forest->profile != NULL) {
+    t8_profile_regions_last_hw_counters (forest->profile->hw_counters
+                                         [T8_PROFILE_HW_ADAPT]);
+    forest->profile->memory_peak[T8_PROFILE_HW_ADAPT] =
+      t8_profile_regions_last_memory_peak ();
+  }
 }
 
 T8_EXTERN_C_END ();
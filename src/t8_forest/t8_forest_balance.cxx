@@ -25,31 +25,136 @@
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_partition.h>
 #include <t8_forest.h>
 #include <t8_element_cxx.hxx>
+#include <t8_data/t8_element_scratch.h>
+#include <t8_default/t8_default_kernels_cxx.hxx>
+#include <t8_profile_regions.h>
+
+/* Compute the maximum level of the elements of a tree.
+ * This loop runs with the scheme class of the tree,
+ * see t8_default_scheme_dispatch. */
+struct t8_forest_balance_max_level_kernel
+{
+  t8_element_array_t *telements;
+  int                 max_level;
+
+  template < class TScheme > void run (TScheme * ts)
+  {
+    t8_locidx_t         ielement, num_elements;
+    int                 elem_level;
+
+    num_elements = (t8_locidx_t) t8_element_array_get_count (telements);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      elem_level =
+        t8_default_kernel < TScheme >::level (ts,
+                                              t8_element_array_index_locidx
+                                              (telements, ielement));
+      max_level = SC_MAX (max_level, elem_level);
+    }
+  }
+};
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
+/* The data that t8_forest_balance passes to the adapt function of each
+ * round via forest->t8code_data. */
+typedef struct
+{
+  int                 done;     /* Set to 0 as soon as any element is refined. */
+  const int8_t       *check;    /* If not NULL, only the elements of forest_from
+                                   with nonzero entry are tested. Indexed by the local
+                                   element index in forest_from. */
+  t8_element_array_t *refined;  /* If not NULL, one array for each local tree of
+                                   forest_from in which the refined elements
+                                   are collected. */
+  t8_element_scratch_t scratch; /* The half face neighbors of each element
+                                   are allocated here. */
+} t8_forest_balance_data_t;
+
+/* Return true if an element has a face neighbor in forest_from with a level
+ * larger than the element's level + 1, that is if any of its half face
+ * neighbors has local or ghost leaf descendants in forest_from.
+ * The half face neighbors are allocated in scratch and released again.
+ * This function only reads forest_from and may be called concurrently
+ * with different scratch pads.
+ */
+static int
+t8_forest_balance_element_needs_refine (t8_forest_t forest_from,
+                                        t8_locidx_t ltree_id,
+                                        const t8_element_t * element,
+                                        t8_eclass_scheme_c * ts,
+                                        t8_element_scratch_t * scratch)
+{
+  int                 iface, num_faces, num_half_neighbors, ineigh;
+  t8_gloidx_t         neighbor_tree;
+  t8_eclass_t         neigh_class;
+  t8_eclass_scheme_c *neigh_scheme;
+  t8_element_t      **half_neighbors;
+  t8_element_scratch_mark_t mark;
+
+  num_faces = ts->t8_element_num_faces (element);
+  t8_element_scratch_mark (scratch, &mark);
+  for (iface = 0; iface < num_faces; iface++) {
+    /* Get the element class and scheme of the face neighbor */
+    neigh_class = t8_forest_element_neighbor_eclass (forest_from,
+                                                     ltree_id, element,
+                                                     iface);
+    neigh_scheme = t8_forest_get_eclass_scheme (forest_from, neigh_class);
+    /* Allocate memory for the number of half face neighbors */
+    num_half_neighbors = ts->t8_element_num_face_children (element, iface);
+    half_neighbors = (t8_element_t **)
+      t8_element_scratch_alloc (scratch,
+                                num_half_neighbors * sizeof (t8_element_t *));
+    t8_element_scratch_new (scratch, neigh_scheme, num_half_neighbors,
+                            half_neighbors);
+    /* Compute the half face neighbors of element at this face */
+    neighbor_tree = t8_forest_element_half_face_neighbors (forest_from,
+                                                           ltree_id,
+                                                           element,
+                                                           half_neighbors,
+                                                           neigh_scheme,
+                                                           iface,
+                                                           num_half_neighbors,
+                                                           NULL);
+    if (neighbor_tree >= 0) {
+      /* The face neighbors do exist, check for each one, whether it has
+       * local or ghost leaf descendants in the forest.
+       * If so, the element needs to be refined. */
+      for (ineigh = 0; ineigh < num_half_neighbors; ineigh++) {
+        if (t8_forest_element_has_leaf_desc (forest_from, neighbor_tree,
+                                             half_neighbors[ineigh],
+                                             neigh_scheme)) {
+          t8_element_scratch_release (scratch, &mark);
+          return 1;
+        }
+      }
+    }
+  }
+  /* clean-up */
+  t8_element_scratch_release (scratch, &mark);
+  return 0;
+}
+
 /* This is the adapt function called during one round of balance.
  * We refine an element if it has any face neighbor with a level larger
  * than the element's level + 1.
+ * We adapt recursively, thus element may also be a child of a refined
+ * element of forest_from. The half neighbor computation only depends on
+ * the element and its tree and the leaves of forest_from are never finer
+ * than the leaves of the balanced forest. Thus it is valid to test the
+ * children against forest_from, too.
  */
-/* TODO: We currently do not adapt recursively since some functions such
- * as half neighbor computation require the forest to be committed. Thus,
- * we pass forest_from as a parameter. But doing so is not valid anymore
- * if we refine recursively. */
 static int
 t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
                          t8_locidx_t ltree_id, t8_locidx_t lelement_id,
                          t8_eclass_scheme_c * ts,
                          int num_elements, t8_element_t * elements[])
 {
-  int                *pdone, iface, num_faces, num_half_neighbors, ineigh;
-  t8_gloidx_t         neighbor_tree;
-  t8_eclass_t         neigh_class;
-  t8_eclass_scheme_c *neigh_scheme;
-  t8_element_t       *element = elements[0], **half_neighbors;
+  t8_forest_balance_data_t *balance_data;
+  t8_element_t       *element = elements[0];
 
   /* We only need to check an element, if its level is smaller then the maximum
    * level in the forest minus 2.
@@ -58,53 +163,37 @@ t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
    * If we enter from the check function is_balanced, then it may not be set.
    */
 
-  if (forest_from->maxlevel_existing <= 0 ||
-      ts->t8_element_level (element) <= forest_from->maxlevel_existing - 2) {
-
-    pdone = (int *) forest->t8code_data;
-
-    num_faces = ts->t8_element_num_faces (element);
-    for (iface = 0; iface < num_faces; iface++) {
-      /* Get the element class and scheme of the face neighbor */
-      neigh_class = t8_forest_element_neighbor_eclass (forest_from,
-                                                       ltree_id, element,
-                                                       iface);
-      neigh_scheme = t8_forest_get_eclass_scheme (forest_from, neigh_class);
-      /* Allocate memory for the number of half face neighbors */
-      num_half_neighbors = ts->t8_element_num_face_children (element, iface);
-      half_neighbors = T8_ALLOC (t8_element_t *, num_half_neighbors);
-      neigh_scheme->t8_element_new (num_half_neighbors, half_neighbors);
-      /* Compute the half face neighbors of element at this face */
-      neighbor_tree = t8_forest_element_half_face_neighbors (forest_from,
-                                                             ltree_id,
-                                                             element,
-                                                             half_neighbors,
-                                                             neigh_scheme,
-                                                             iface,
-                                                             num_half_neighbors,
-                                                             NULL);
-      if (neighbor_tree >= 0) {
-        /* The face neighbors do exist, check for each one, whether it has
-         * local or ghost leaf descendants in the forest.
-         * If so, the element will be refined. */
-        for (ineigh = 0; ineigh < num_half_neighbors; ineigh++) {
-          if (t8_forest_element_has_leaf_desc (forest_from, neighbor_tree,
-                                               half_neighbors[ineigh],
-                                               neigh_scheme)) {
-            /* This element should be refined */
-            *pdone = 0;
-            /* clean-up */
-            neigh_scheme->t8_element_destroy (num_half_neighbors,
-                                              half_neighbors);
-            T8_FREE (half_neighbors);
-            return 1;
-          }
-        }
-      }
-      /* clean-up */
-      neigh_scheme->t8_element_destroy (num_half_neighbors, half_neighbors);
-      T8_FREE (half_neighbors);
+  balance_data = (t8_forest_balance_data_t *) forest->t8code_data;
+  if (num_elements > 1 && elements[0] !=
+      t8_forest_get_element_in_tree (forest_from, ltree_id, lelement_id)) {
+    /* This family was built during the recursive adaptation and is
+     * offered for coarsening. Balance never coarsens. */
+    return 0;
+  }
+  /* The children of a refined element are passed with the index of their
+   * ancestor in forest_from. Since it was refined, it is marked. */
+  if (balance_data->check != NULL
+      && !balance_data->check[t8_forest_get_tree_element_offset
+                              (forest_from, ltree_id) + lelement_id]) {
+    /* Neither this element nor its neighbors changed in the last round,
+     * thus the element does not need to be refined now. */
+    return 0;
+  }
+
+  if ((forest_from->maxlevel_existing <= 0 ||
+       ts->t8_element_level (element) <= forest_from->maxlevel_existing - 2)
+      && t8_forest_balance_element_needs_refine (forest_from, ltree_id,
+                                                 element, ts,
+                                                 &balance_data->scratch)) {
+    /* This element should be refined */
+    balance_data->done = 0;
+    if (balance_data->refined != NULL) {
+      /* Remember it to find the elements to check in the next round */
+      ts->t8_element_copy (element,
+                           t8_element_array_push
+                           (&balance_data->refined[ltree_id]));
     }
+    return 1;
   }
 
   return 0;
@@ -114,36 +203,222 @@ t8_forest_balance_adapt (t8_forest_t forest, t8_forest_t forest_from,
 static void
 t8_forest_compute_max_element_level (t8_forest_t forest)
 {
-  t8_locidx_t         ielement, elem_in_tree;
-  t8_locidx_t         itree, num_trees;
-  t8_element_t       *elem;
+  t8_locidx_t         itree, num_trees, ielement;
   t8_eclass_scheme_c *scheme;
-  int                 local_max_level = 0, elem_level;
+  t8_forest_balance_max_level_kernel kernel;
 
-  /* Iterate over all local trees and all local elements and comupte the maximum occurring level */
-  num_trees = t8_forest_get_num_local_trees (forest);
-  for (itree = 0; itree < num_trees; itree++) {
-    elem_in_tree = t8_forest_get_tree_num_elements (forest, itree);
-    scheme =
-      t8_forest_get_eclass_scheme (forest,
-                                   t8_forest_get_tree_class (forest, itree));
-    for (ielement = 0; ielement < elem_in_tree; ielement++) {
-      /* Get the element and compute its level */
-      elem = t8_forest_get_element_in_tree (forest, itree, ielement);
-      elem_level = scheme->t8_element_level (elem);
-      local_max_level = SC_MAX (local_max_level, elem_level);
+  if (forest->level_lists != NULL) {
+    /* The maximum level was computed when the forest was committed */
+    T8_ASSERT (forest->maxlevel_existing >= 0);
+    return;
+  }
+  kernel.max_level = 0;
+  if (forest->element_levels != NULL) {
+    /* Read the levels from the contiguous array */
+    for (ielement = 0; ielement < forest->local_num_elements; ielement++) {
+      kernel.max_level = SC_MAX (kernel.max_level,
+                                 forest->element_levels[ielement]);
+    }
+  }
+  else {
+    /* Iterate over all local trees and all local elements and comupte the maximum occurring level */
+    num_trees = t8_forest_get_num_local_trees (forest);
+    for (itree = 0; itree < num_trees; itree++) {
+      scheme =
+        t8_forest_get_eclass_scheme (forest,
+                                     t8_forest_get_tree_class (forest,
+                                                               itree));
+      kernel.telements = t8_forest_get_tree_element_array (forest, itree);
+      t8_default_scheme_dispatch (scheme, kernel);
     }
   }
   /* Communicate the local maximum levels */
-  sc_MPI_Allreduce (&local_max_level, &forest->maxlevel_existing, 1,
+  sc_MPI_Allreduce (&kernel.max_level, &forest->maxlevel_existing, 1,
                     sc_MPI_INT, sc_MPI_MAX, forest->mpicomm);
 }
 
+/* Find the leaf in a local tree of a forest that is equal to or an ancestor
+ * of a given element. Return its index in the tree or -1 if no such leaf exists.
+ * nca must be an allocated element of the scheme ts. */
+static              t8_locidx_t
+t8_forest_balance_find_leaf (t8_forest_t forest, t8_locidx_t ltree_id,
+                             t8_eclass_scheme_c * ts,
+                             const t8_element_t * element, t8_element_t * nca)
+{
+  t8_element_array_t *elements;
+  t8_element_t       *leaf;
+  t8_locidx_t         index;
+
+  elements = t8_forest_get_tree_element_array (forest, ltree_id);
+  /* The leaf has the largest linear id that is smaller or equal to
+   * the element's id */
+  index =
+    t8_forest_bin_search_lower (elements,
+                                ts->t8_element_get_linear_id (element,
+                                                              forest->maxlevel),
+                                forest->maxlevel);
+  if (index < 0) {
+    return -1;
+  }
+  leaf = t8_element_array_index_locidx (elements, index);
+  /* The leaf contains the element if and only if it is their nearest
+   * common ancestor */
+  ts->t8_element_nca (leaf, element, nca);
+  return ts->t8_element_compare (nca, leaf) == 0 ? index : -1;
+}
+
+/* Compute for each local element of forest_to whether it must be tested in
+ * the next round of balance. forest_to is adapted from forest_from in the
+ * last round and refined contains the elements of forest_from that were refined.
+ * Since balance only refines, the result of t8_forest_balance_adapt can only
+ * change for
+ *  - the descendants of refined elements,
+ *  - local leaves at a face of a refined element that are coarser than it,
+ *  - elements that are ghosts of other processes, since their neighbors on
+ *    these processes may have been refined.
+ * The returned array has one entry for each local element of forest_to and
+ * must be freed with T8_FREE.
+ */
+static int8_t      *
+t8_forest_balance_compute_check (t8_forest_t forest_from,
+                                 t8_forest_t forest_to,
+                                 t8_element_array_t * refined)
+{
+  int8_t             *check, *remotes;
+  t8_locidx_t         itree, num_trees, ielem, num_elements, index;
+  t8_locidx_t         offset, offset_from, lneigh_tree;
+  t8_gloidx_t         gneigh_tree;
+  t8_element_array_t *tree_elements;
+  t8_element_t       *element, *nca, *last_desc, *neighs[2];
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_eclass_t         neigh_class;
+  t8_element_scratch_mark_t mark;
+  t8_locidx_t         last_index;
+  int                 iface, num_faces, level, dual_face;
+  t8_element_scratch_t scratch;
+
+  t8_element_scratch_init (&scratch, 0);
+  check = T8_ALLOC_ZERO (int8_t, t8_forest_get_num_element (forest_to));
+  num_trees = t8_forest_get_num_local_trees (forest_from);
+  T8_ASSERT (num_trees == t8_forest_get_num_local_trees (forest_to));
+  for (itree = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest_to,
+                                      t8_forest_get_tree_class (forest_to,
+                                                                itree));
+    t8_element_scratch_clear (&scratch);
+    t8_element_scratch_new (&scratch, ts, 1, &last_desc);
+    tree_elements = t8_forest_get_tree_element_array (forest_to, itree);
+    offset = t8_forest_get_tree_element_offset (forest_to, itree);
+    num_elements =
+      (t8_locidx_t) t8_element_array_get_count (&refined[itree]);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      element = t8_element_array_index_locidx (&refined[itree], ielem);
+      /* The descendants of the element replace it in forest_to. The first
+       * one has the same first descendant as the element and the last one
+       * the same last descendant. */
+      index =
+        t8_forest_bin_search_lower (tree_elements,
+                                    ts->t8_element_get_linear_id (element,
+                                                                  forest_to->maxlevel),
+                                    forest_to->maxlevel);
+      ts->t8_element_last_descendant (element, last_desc,
+                                      forest_to->maxlevel);
+      last_index =
+        t8_forest_bin_search_lower (tree_elements,
+                                    ts->t8_element_get_linear_id (last_desc,
+                                                                  forest_to->maxlevel),
+                                    forest_to->maxlevel);
+      T8_ASSERT (0 <= index && index < last_index);
+      memset (check + offset + index, 1, last_index - index + 1);
+
+      /* Mark the local leaves at the faces of element that are coarser */
+      level = ts->t8_element_level (element);
+      num_faces = ts->t8_element_num_faces (element);
+      t8_element_scratch_mark (&scratch, &mark);
+      for (iface = 0; iface < num_faces; iface++) {
+        neigh_class = t8_forest_element_neighbor_eclass (forest_to, itree,
+                                                         element, iface);
+        neigh_scheme = t8_forest_get_eclass_scheme (forest_to, neigh_class);
+        t8_element_scratch_new (&scratch, neigh_scheme, 2, neighs);
+        gneigh_tree =
+          t8_forest_element_face_neighbor (forest_to, itree, element,
+                                           neighs[0], neigh_scheme, iface,
+                                           &dual_face);
+        /* Neighbors in ghost trees are handled by their owner, since
+         * there they are remote elements of this process */
+        if (gneigh_tree >= 0 && (lneigh_tree =
+                                 t8_forest_get_local_id (forest_to,
+                                                         gneigh_tree)) >= 0) {
+          index =
+            t8_forest_balance_find_leaf (forest_to, lneigh_tree,
+                                         neigh_scheme, neighs[0], neighs[1]);
+          if (index >= 0
+              && neigh_scheme->
+              t8_element_level (t8_forest_get_element_in_tree
+                                (forest_to, lneigh_tree, index)) < level) {
+            check[t8_forest_get_tree_element_offset (forest_to, lneigh_tree)
+                  + index] = 1;
+          }
+        }
+      }
+      t8_element_scratch_release (&scratch, &mark);
+    }
+  }
+
+  /* Mark the elements that are ghosts of other processes */
+  T8_ASSERT (forest_from->ghosts != NULL);
+  remotes = T8_ALLOC_ZERO (int8_t, t8_forest_get_num_element (forest_from));
+  t8_forest_ghost_mark_remote_elements (forest_from, remotes);
+  for (itree = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest_to,
+                                      t8_forest_get_tree_class (forest_to,
+                                                                itree));
+    t8_element_scratch_clear (&scratch);
+    t8_element_scratch_new (&scratch, ts, 1, &nca);
+    offset = t8_forest_get_tree_element_offset (forest_to, itree);
+    offset_from = t8_forest_get_tree_element_offset (forest_from, itree);
+    num_elements = t8_forest_get_tree_num_elements (forest_from, itree);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      if (remotes[offset_from + ielem]) {
+        /* If this element was refined, its descendants are already marked.
+         * Otherwise it is a leaf of forest_to, too. */
+        element = t8_forest_get_element_in_tree (forest_from, itree, ielem);
+        index = t8_forest_balance_find_leaf (forest_to, itree, ts, element,
+                                             nca);
+        if (index >= 0) {
+          check[offset + index] = 1;
+        }
+      }
+    }
+  }
+  t8_element_scratch_reset (&scratch);
+  T8_FREE (remotes);
+  return check;
+}
+
+/* Add the messages of a temporary forest of a balance round to the
+ * balance phase of the profile of forest. */
+static void
+t8_forest_balance_profile_comm (t8_forest_t forest, t8_forest_t forest_round)
+{
+  int                 iphase;
+
+  T8_ASSERT (forest->profile != NULL && forest_round->profile != NULL);
+  for (iphase = 0; iphase < T8_PROFILE_COMM_NUM_PHASES; iphase++) {
+    t8_profile_comm_add (&forest->profile->comm[T8_PROFILE_COMM_BALANCE],
+                         &forest_round->profile->comm[iphase]);
+  }
+}
+
 void
 t8_forest_balance (t8_forest_t forest, int repartition)
 {
   t8_forest_t         forest_temp, forest_from, forest_partition;
-  int                 done = 0, done_global = 0;
+  t8_forest_balance_data_t balance_data;
+  t8_locidx_t         itree, num_trees;
+  int8_t             *check = NULL, *check_next;
+  sc_array_t          check_in, check_out;
+  int                 done_global = 0;
   int                 count = 0, num_stats, i;
   double              ada_time, ghost_time, part_time;
   sc_statinfo_t      *adap_stats, *ghost_stats, *partition_stats;
@@ -152,6 +427,7 @@ t8_forest_balance (t8_forest_t forest, int repartition)
     ("Into t8_forest_balance with %lli global elements.\n",
      (long long) t8_forest_get_global_num_elements (forest->set_from));
   t8_log_indent_push ();
+  t8_profile_region_begin ("balance");
 
   /* Set default value to prevent compiler warning */
   adap_stats = ghost_stats = partition_stats = NULL;
@@ -181,8 +457,23 @@ t8_forest_balance (t8_forest_t forest, int repartition)
     forest->set_from->ghost_type = T8_GHOST_FACES;
     t8_forest_ghost_create_topdown (forest->set_from);
   }
+  /* In the first round we test all elements. In later rounds only those
+   * elements that are near elements refined in the previous round. */
+  balance_data.check = NULL;
+  t8_element_scratch_init (&balance_data.scratch, 0);
   while (!done_global) {
-    done = 1;
+    t8_profile_region_begin ("balance_round");
+    balance_data.done = 1;
+    /* Allocate the arrays to collect the refined elements of each tree */
+    num_trees = t8_forest_get_num_local_trees (forest_from);
+    balance_data.refined = T8_ALLOC (t8_element_array_t, num_trees);
+    for (itree = 0; itree < num_trees; itree++) {
+      t8_element_array_init (&balance_data.refined[itree],
+                             t8_forest_get_eclass_scheme (forest_from,
+                                                          t8_forest_get_tree_class
+                                                          (forest_from,
+                                                           itree)));
+    }
 
     T8_ASSERT (forest_from->maxlevel_existing >= 0);
     /* Initialize the temp forest to be adapted from forest_from */
@@ -191,18 +482,26 @@ t8_forest_balance (t8_forest_t forest, int repartition)
     forest_temp->maxlevel_existing = forest_from->maxlevel_existing;
     /* Adapt the forest */
     t8_forest_set_adapt (forest_temp, forest_from, t8_forest_balance_adapt,
-                         0);
+                         1);
     if (!repartition) {
       t8_forest_set_ghost (forest_temp, 1, T8_GHOST_FACES);
     }
-    forest_temp->t8code_data = &done;
+    forest_temp->t8code_data = &balance_data;
+    /* The done flags are reduced together with the element counts when
+     * forest_temp is committed */
+    forest_temp->reduce_done = &balance_data.done;
     /* If profiling is enabled, measure ghost/adapt rumtimes */
     if (forest->profile != NULL) {
       t8_forest_set_profiling (forest_temp, 1);
     }
     t8_global_productionf ("Profiling: %i\n", forest->profile != NULL);
+    /* We need forest_from after the commit to compute the elements
+     * to check in the next round */
+    t8_forest_ref (forest_from);
     /* Adapt the forest */
     t8_forest_commit (forest_temp);
+    T8_FREE (check);
+    check = NULL;
     /* Store the runtimes of adapt and ghost */
     if (forest->profile != NULL) {
       while (count >= num_stats - 2) {
@@ -222,18 +521,32 @@ t8_forest_balance (t8_forest_t forest, int repartition)
                        forest_temp->profile->ghost_runtime,
                        "forest balance: Ghost time");
       }
+      t8_forest_balance_profile_comm (forest, forest_temp);
     }
 
-    /* Compute the logical and of all process local done values, if this results
-     * in 1 then all processes are finished */
-    sc_MPI_Allreduce (&done, &done_global, 1, sc_MPI_INT, sc_MPI_LAND,
-                      forest->mpicomm);
+    /* The commit of forest_temp replaced the local done value by the logical
+     * and of all processes, if this is 1 then all processes are finished */
+    done_global = balance_data.done;
+
+    if (!done_global) {
+      check = t8_forest_balance_compute_check (forest_from, forest_temp,
+                                               balance_data.refined);
+    }
+    for (itree = 0; itree < num_trees; itree++) {
+      t8_element_array_reset (&balance_data.refined[itree]);
+    }
+    T8_FREE (balance_data.refined);
+    /* Both forests exist at this point */
+    t8_profile_regions_sample_memory ();
+    t8_forest_unref (&forest_from);
 
     if (repartition && !done_global) {
       /* If repartitioning is used, we partition the forest */
       t8_forest_init (&forest_partition);
       /* Update the maximum occurring level */
       forest_partition->maxlevel_existing = forest_temp->maxlevel_existing;
+      /* We need forest_temp after the commit to partition the check marks */
+      t8_forest_ref (forest_temp);
       t8_forest_set_partition (forest_partition, forest_temp, 0);
       t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
       /* If profiling is enabled, measure partition rumtimes */
@@ -252,17 +565,38 @@ t8_forest_balance (t8_forest_t forest, int repartition)
                        "forest balance: Ghost time");
       }
 
+      /* Send the check marks along with their elements */
+      check_next = T8_ALLOC (int8_t,
+                             t8_forest_get_num_element (forest_partition));
+      sc_array_init_data (&check_in, check, sizeof (int8_t),
+                          t8_forest_get_num_element (forest_temp));
+      sc_array_init_data (&check_out, check_next, sizeof (int8_t),
+                          t8_forest_get_num_element (forest_partition));
+      t8_forest_partition_data (forest_temp, forest_partition, &check_in,
+                                &check_out);
+      if (forest->profile != NULL) {
+        t8_forest_balance_profile_comm (forest, forest_partition);
+      }
+      T8_FREE (check);
+      check = check_next;
+      t8_forest_unref (&forest_temp);
+
       forest_temp = forest_partition;
       forest_partition = NULL;
     }
     /* Adapt forest_temp in the next round */
     forest_from = forest_temp;
+    balance_data.check = check;
     count++;
+    t8_profile_region_end ("balance_round");
   }
+  t8_element_scratch_reset (&balance_data.scratch);
 
   T8_ASSERT (t8_forest_is_balanced (forest_temp));
   /* Forest_temp is now balanced, we copy its trees and elements to forest */
-  t8_forest_copy_trees (forest, forest_temp, 1);
+  t8_forest_share_trees (forest, forest_temp);
+  /* The element data fields were transferred along with forest_temp */
+  t8_forest_fields_copy (forest, forest_temp);
   /* TODO: Also copy ghost elements if ghost creation is set */
 
   t8_log_indent_pop ();
@@ -317,54 +651,97 @@ t8_forest_balance (t8_forest_t forest, int repartition)
       T8_FREE (partition_stats);
     }
   }
+  t8_profile_region_end ("balance");
+  if (forest->profile != NULL) {
+    t8_profile_regions_last_hw_counters (forest->profile->hw_counters
+                                         [T8_PROFILE_HW_BALANCE]);
+    forest->profile->memory_peak[T8_PROFILE_HW_BALANCE] =
+      t8_profile_regions_last_memory_peak ();
+  }
 }
 
-/* Check whether the local elements of a forest are balanced. */
-int
-t8_forest_is_balanced (t8_forest_t forest)
+/* Check whether the elements of one local tree are balanced.
+ * The half face neighbors are allocated in scratch. */
+static int
+t8_forest_is_balanced_tree (t8_forest_t forest, t8_locidx_t itree,
+                            t8_element_scratch_t * scratch)
 {
-  t8_forest_t         forest_from;
-  t8_locidx_t         num_trees, num_elements;
-  t8_locidx_t         itree, ielem;
-  t8_element_t       *element;
+  t8_locidx_t         num_elements, ielem;
+  const t8_element_t *element;
   t8_eclass_scheme_c *ts;
-  void               *data_temp;
-  int                 dummy_int;
-
-  T8_ASSERT (t8_forest_is_committed (forest));
 
-  /* temporarily save forest_from */
-  forest_from = forest->set_from;
+  num_elements = t8_forest_get_tree_num_elements (forest, itree);
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest, itree));
+  /* Iterate over all elements of this tree */
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    element = t8_forest_get_element_in_tree (forest, itree, ielem);
+    /* Only elements at least two levels coarser than the finest
+     * element can have a too fine neighbor. */
+    if ((forest->maxlevel_existing <= 0
+         || ts->t8_element_level (element) <= forest->maxlevel_existing - 2)
+        && t8_forest_balance_element_needs_refine (forest, itree, element,
+                                                   ts, scratch)) {
+      /* This element would need to be refined in the balance step. */
+      return 0;
+    }
+  }
+  return 1;
+}
 
-  forest->set_from = forest;
+/* Check whether the local elements of a forest are balanced.
+ * The face neighbors of all elements are tested in a single pass against
+ * the local and ghost leaves, without building any intermediate forest.
+ * With OpenMP, the trees are tested by t8_get_num_threads threads. */
+int
+t8_forest_is_balanced (t8_forest_t forest)
+{
+  t8_locidx_t         num_trees, itree;
+  t8_element_scratch_t scratch;
+  int                 is_balanced = 1;
+#ifdef T8_ENABLE_OPENMP
+  int                 num_threads;
+#endif
 
-  /* temporarily save forest t8code_data */
-  data_temp = forest->t8code_data;
-  forest->t8code_data = &dummy_int;
+  T8_ASSERT (t8_forest_is_committed (forest));
 
   num_trees = t8_forest_get_num_local_trees (forest);
-  /* Iterate over all trees */
-  for (itree = 0; itree < num_trees; itree++) {
-    num_elements = t8_forest_get_tree_num_elements (forest, itree);
-    ts =
-      t8_forest_get_eclass_scheme (forest,
-                                   t8_forest_get_tree_class (forest, itree));
-    /* Iterate over all elements of this tree */
-    for (ielem = 0; ielem < num_elements; ielem++) {
-      element = t8_forest_get_element_in_tree (forest, itree, ielem);
-      /* Test if this element would need to be refined in the balance step.
-       * If so, the forest is not balanced locally. */
-      if (t8_forest_balance_adapt
-          (forest, forest, itree, ielem, ts, 1, &element)) {
-        forest->set_from = forest_from;
-        forest->t8code_data = data_temp;
-        return 0;
+#ifdef T8_ENABLE_OPENMP
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (t8_get_num_threads (), num_trees);
+  if (num_threads > 1) {
+#pragma omp parallel num_threads (num_threads) private (scratch)
+    {
+      int                 tree_is_balanced, still_balanced;
+
+      /* Each thread allocates the half neighbors in its own arena */
+      t8_element_scratch_init (&scratch, 0);
+#pragma omp for schedule (dynamic)
+      for (itree = 0; itree < num_trees; itree++) {
+#pragma omp atomic read
+        still_balanced = is_balanced;
+        /* Skip the remaining trees as soon as one is not balanced */
+        if (still_balanced) {
+          tree_is_balanced =
+            t8_forest_is_balanced_tree (forest, itree, &scratch);
+          if (!tree_is_balanced) {
+#pragma omp atomic write
+            is_balanced = 0;
+          }
+        }
       }
+      t8_element_scratch_reset (&scratch);
     }
+    return is_balanced;
   }
-  forest->set_from = forest_from;
-  forest->t8code_data = data_temp;
-  return 1;
+#endif
+  t8_element_scratch_init (&scratch, 0);
+  /* Iterate over all trees */
+  for (itree = 0; itree < num_trees && is_balanced; itree++) {
+    is_balanced = t8_forest_is_balanced_tree (forest, itree, &scratch);
+  }
+  t8_element_scratch_reset (&scratch);
+  return is_balanced;
 }
 
 T8_EXTERN_C_END ();
@@ -39,7 +39,9 @@ T8_EXTERN_C_BEGIN ();
  * only temporary and will be replaced in future */
 void                t8_forest_balance (t8_forest_t forest, int repartition);
 
-/* Check whether the local elements of a forest are balanced. */
+/* Check whether the local elements of a forest are balanced.
+ * The forest should have a ghost layer to detect too fine neighbors
+ * on other processes. This function is not collective. */
 int                 t8_forest_is_balanced (t8_forest_t forest);
 
 T8_EXTERN_C_END ();
@@ -33,6 +33,33 @@
 #include <t8_element_cxx.hxx>
 #include <t8_cmesh/t8_cmesh_trees.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
+#include <t8_default/t8_default_kernels_cxx.hxx>
+#include <t8_default/t8_default_refine_tables_cxx.hxx>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* Store the levels of the elements of a tree in levels.
+ * This loop runs with the scheme class of the tree,
+ * see t8_default_scheme_dispatch. */
+struct t8_forest_element_levels_kernel
+{
+  t8_element_array_t *telements;
+  int8_t             *levels;
+
+  template < class TScheme > void run (TScheme * ts)
+  {
+    t8_locidx_t         ielement, num_elements;
+
+    num_elements = (t8_locidx_t) t8_element_array_get_count (telements);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      levels[ielement] = (int8_t)
+        t8_default_kernel < TScheme >::level (ts,
+                                              t8_element_array_index_locidx
+                                              (telements, ielement));
+    }
+  }
+};
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -186,6 +213,96 @@ t8_forest_is_equal (t8_forest_t forest_a, t8_forest_t forest_b)
   return 1;
 }
 
+/* Mix the global tree id, the linear id and the level of an element into
+ * a 64 bit hash value, using the finalizer of the splitmix64 generator. */
+static              uint64_t
+t8_forest_checksum_mix (t8_gloidx_t gtreeid, t8_linearidx_t id, int level)
+{
+  uint64_t            hash;
+
+  hash = id ^ ((uint64_t) gtreeid * 0x9e3779b97f4a7c15ULL)
+    ^ ((uint64_t) level << 56);
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+/* Sum the hash values of the elements of one local tree. */
+static              uint64_t
+t8_forest_checksum_tree (t8_forest_t forest, t8_locidx_t itree)
+{
+  t8_element_array_t *telements;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *first;
+  t8_linearidx_t     *ids;
+  int                *levels, maxlevel;
+  t8_locidx_t         num_elements, ielem;
+  t8_gloidx_t         gtreeid;
+  uint64_t            checksum = 0;
+
+  telements = t8_forest_get_tree_element_array (forest, itree);
+  num_elements = (t8_locidx_t) t8_element_array_get_count (telements);
+  if (num_elements == 0) {
+    return 0;
+  }
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest, itree));
+  gtreeid = t8_forest_global_tree_id (forest, itree);
+  /* The first descendant at the maximum level together with the level
+   * identifies an element uniquely within its tree. */
+  maxlevel = ts->t8_element_maxlevel ();
+  first = t8_element_array_index_locidx (telements, 0);
+  ids = T8_ALLOC (t8_linearidx_t, num_elements);
+  levels = T8_ALLOC (int, num_elements);
+  ts->t8_element_get_linear_id_batch (first, num_elements, maxlevel, ids);
+  ts->t8_element_level_batch (first, num_elements, levels);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    checksum += t8_forest_checksum_mix (gtreeid, ids[ielem], levels[ielem]);
+  }
+  T8_FREE (ids);
+  T8_FREE (levels);
+  return checksum;
+}
+
+uint64_t
+t8_forest_checksum (t8_forest_t forest)
+{
+  t8_locidx_t         num_local_trees, itree;
+  unsigned long long  local_checksum = 0, checksum;
+  int                 mpiret;
+#ifdef T8_ENABLE_OPENMP
+  int                 num_threads;
+#endif
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (!t8_forest_is_compressed (forest));
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+#ifdef T8_ENABLE_OPENMP
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (t8_get_num_threads (), num_local_trees);
+  if (num_threads > 1) {
+#pragma omp parallel for num_threads (num_threads) schedule (dynamic) reduction (+:local_checksum)
+    for (itree = 0; itree < num_local_trees; itree++) {
+      local_checksum += t8_forest_checksum_tree (forest, itree);
+    }
+  }
+  else
+#endif
+  {
+    for (itree = 0; itree < num_local_trees; itree++) {
+      local_checksum += t8_forest_checksum_tree (forest, itree);
+    }
+  }
+  /* Since the hash values are added, the checksum does not depend on the
+   * partition and a single reduction suffices. */
+  mpiret = sc_MPI_Allreduce (&local_checksum, &checksum, 1,
+                             sc_MPI_UNSIGNED_LONG_LONG, sc_MPI_SUM,
+                             forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return (uint64_t) checksum;
+}
+
 /* Given function values at the four edge points of a unit square and
  * a point within that square, interpolate the function value at this point.
  * \param [in]    vertex  An array of size at least dim giving the coordinates of the vertex to interpolate
@@ -219,39 +336,221 @@ t8_forest_bilinear_interpolation (const double *vertex,
   }
 }
 
-/* given an element in a coarse tree, the corner coordinates of the coarse tree
- * and a corner number of the element compute the coordinates of that corner
- * within the coarse tree.
- */
-/* TODO: replace ltree_id argument with ts argument. */
+/* Return the affine map of a local tree if the tree is affine and vertices
+ * are the tree's stored vertices, otherwise NULL. */
+static inline const t8_forest_tree_affine_t *
+t8_forest_get_tree_affine (t8_forest_t forest, t8_locidx_t ltreeid,
+                           const double *vertices)
+{
+  const t8_forest_tree_affine_t *affine;
+
+  if (forest->tree_affine == NULL
+      || ltreeid >= t8_forest_get_num_local_trees (forest)) {
+    return NULL;
+  }
+  affine = forest->tree_affine + ltreeid;
+  return affine->is_affine && affine->vertices == vertices ? affine : NULL;
+}
+
+/* Map reference coordinates with the affine map of a tree */
+static inline void
+t8_forest_tree_affine_map (const t8_forest_tree_affine_t * affine,
+                           const double ref[3], double coordinates[3])
+{
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    coordinates[i] = affine->offset[i] + affine->jacobian[0][i] * ref[0]
+      + affine->jacobian[1][i] * ref[1] + affine->jacobian[2][i] * ref[2];
+  }
+}
+
+/* The hash value of a mapped corner is computed from its reference
+ * coordinates. u_data is not needed. */
+static unsigned
+t8_forest_curved_corner_hash (const void *corner, const void *u_data)
+{
+  const t8_forest_curved_corner_t *c =
+    (const t8_forest_curved_corner_t *) corner;
+
+  return (unsigned) c->coords[0] * 73856093u
+    ^ (unsigned) c->coords[1] * 19349663u
+    ^ (unsigned) c->coords[2] * 83492791u;
+}
+
+/* Returns true if two mapped corners have the same reference coordinates.
+ * u_data is not needed. */
+static int
+t8_forest_curved_corner_equal (const void *corner_a, const void *corner_b,
+                               const void *u_data)
+{
+  const t8_forest_curved_corner_t *a =
+    (const t8_forest_curved_corner_t *) corner_a;
+  const t8_forest_curved_corner_t *b =
+    (const t8_forest_curved_corner_t *) corner_b;
+
+  return a->coords[0] == b->coords[0] && a->coords[1] == b->coords[1]
+    && a->coords[2] == b->coords[2];
+}
+
 void
-t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
-                              const t8_element_t * element,
-                              const double *vertices, int corner_number,
-                              double *coordinates)
+t8_forest_tree_curved_build (t8_forest_t forest)
 {
-  int                 corner_coords[3], i;
-  double              vertex_coords[3];
-  t8_eclass_scheme_c *ts;
-  t8_eclass_t         eclass;
-  double              len;
-  int                 dim;
+  t8_forest_tree_curved_t *curved;
+  t8_locidx_t         num_trees, ltree, lctreeid;
 
-  T8_ASSERT (forest != NULL);
-  T8_ASSERT (forest->scheme_cxx != NULL);
-  eclass = t8_forest_get_tree_class (forest, ltree_id);
-  T8_ASSERT (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_TRIANGLE
-             || eclass == T8_ECLASS_TET || eclass == T8_ECLASS_QUAD
-             || eclass == T8_ECLASS_HEX || eclass == T8_ECLASS_LINE
-             || eclass == T8_ECLASS_PRISM);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->tree_curved == NULL);
+
+  if (t8_cmesh_get_tree_geometry (forest->cmesh) == NULL) {
+    /* All trees are linear */
+    return;
+  }
+  num_trees = t8_forest_get_num_local_trees (forest)
+    + t8_forest_ghost_num_trees (forest);
+  forest->tree_curved = curved =
+    T8_ALLOC_ZERO (t8_forest_tree_curved_t, num_trees + 1);
+  for (ltree = 0; ltree < num_trees; ltree++, curved++) {
+    lctreeid = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltree);
+    if (t8_cmesh_get_attribute (forest->cmesh, t8_get_package_id (), 0,
+                                lctreeid) != NULL) {
+      /* Stored vertices take precedence over the geometry */
+      continue;
+    }
+    curved->gtreeid = t8_cmesh_get_global_id (forest->cmesh, lctreeid);
+    curved->corner_pool = sc_mempool_new (sizeof (t8_forest_curved_corner_t));
+    curved->corners = sc_hash_new (t8_forest_curved_corner_hash,
+                                   t8_forest_curved_corner_equal, NULL,
+                                   NULL);
+  }
+}
+
+void
+t8_forest_tree_curved_destroy (t8_forest_t forest)
+{
+  t8_locidx_t         num_trees, ltree;
+
+  if (forest->tree_curved == NULL) {
+    return;
+  }
+  num_trees = t8_forest_get_num_local_trees (forest)
+    + t8_forest_ghost_num_trees (forest);
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    if (forest->tree_curved[ltree].corners != NULL) {
+      sc_hash_destroy (forest->tree_curved[ltree].corners);
+      sc_mempool_destroy (forest->tree_curved[ltree].corner_pool);
+    }
+  }
+  T8_FREE (forest->tree_curved);
+  forest->tree_curved = NULL;
+}
+
+size_t
+t8_forest_tree_curved_memory_used (t8_forest_t forest)
+{
+  t8_locidx_t         num_trees, ltree;
+  size_t              used;
+
+  if (forest->tree_curved == NULL) {
+    return 0;
+  }
+  num_trees = t8_forest_get_num_local_trees (forest)
+    + t8_forest_ghost_num_trees (forest);
+  used = (num_trees + 1) * sizeof (t8_forest_tree_curved_t);
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    if (forest->tree_curved[ltree].corners != NULL) {
+      used += sc_hash_memory_used (forest->tree_curved[ltree].corners)
+        + sc_mempool_memory_used (forest->tree_curved[ltree].corner_pool);
+    }
+  }
+  return used;
+}
+
+/* Return the curved geometry of a local or ghost tree, or NULL if the
+ * tree's vertices are stored. */
+static inline t8_forest_tree_curved_t *
+t8_forest_get_tree_curved (t8_forest_t forest, t8_locidx_t ltreeid)
+{
+  if (forest->tree_curved == NULL
+      || forest->tree_curved[ltreeid].corners == NULL) {
+    return NULL;
+  }
+  return forest->tree_curved + ltreeid;
+}
+
+/* Map a corner with integer reference coordinates through the geometry
+ * of a curved tree. Each corner is evaluated only once, later calls
+ * return the stored image. len is the inverse root length. */
+static void
+t8_forest_tree_curved_map (t8_forest_t forest,
+                           t8_forest_tree_curved_t * curved,
+                           const int coords[3], double len,
+                           double coordinates[3])
+{
+  t8_forest_curved_corner_t key, *corner;
+  double              ref[3];
+  void              **found;
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    key.coords[i] = coords[i];
+  }
+  if (sc_hash_lookup (curved->corners, &key, &found)) {
+    corner = (t8_forest_curved_corner_t *) * found;
+  }
+  else {
+    corner =
+      (t8_forest_curved_corner_t *) sc_mempool_alloc (curved->corner_pool);
+    for (i = 0; i < 3; i++) {
+      corner->coords[i] = coords[i];
+      ref[i] = len * coords[i];
+    }
+    t8_geometry_evaluate (t8_cmesh_get_tree_geometry (forest->cmesh),
+                          (t8_topidx_t) curved->gtreeid, ref, corner->xyz);
+    sc_hash_insert_unique (curved->corners, corner, NULL);
+  }
+  for (i = 0; i < 3; i++) {
+    coordinates[i] = corner->xyz[i];
+  }
+}
+
+/* Given the integer coordinates of a point in a coarse tree and the
+ * inverse root length len, compute the coordinates of the point within
+ * the coarse tree.
+ */
+static void
+t8_forest_tree_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
+                           t8_eclass_t eclass, const double *vertices,
+                           int corner_coords[3], double len,
+                           double *coordinates)
+{
+  double              vertex_coords[3];
+  const t8_forest_tree_affine_t *affine;
+  t8_forest_tree_curved_t *curved;
+  int                 dim, i;
 
-  ts = forest->scheme_cxx->eclass_schemes[eclass];
   dim = t8_eclass_to_dimension[eclass];
-  len = 1. / ts->t8_element_root_len (element);
-  ts->t8_element_vertex_coords (element, corner_number, corner_coords);
+  curved = t8_forest_get_tree_curved (forest, ltree_id);
+  if (curved != NULL) {
+    /* The corner is the image of the tree's geometry */
+    for (i = dim; i < 3; i++) {
+      corner_coords[i] = 0;
+    }
+    t8_forest_tree_curved_map (forest, curved, corner_coords, len,
+                               coordinates);
+    return;
+  }
+  affine = t8_forest_get_tree_affine (forest, ltree_id, vertices);
+  if (affine != NULL) {
+    /* coordinates = offset + J * (len * corner_coords) */
+    for (i = 0; i < 3; i++) {
+      vertex_coords[i] = i < dim ? len * corner_coords[i] : 0.;
+    }
+    t8_forest_tree_affine_map (affine, vertex_coords, coordinates);
+    return;
+  }
   switch (eclass) {
   case T8_ECLASS_VERTEX:
-    T8_ASSERT (corner_number == 0);
     /* A vertex has exactly one corner, and we already know its coordinates, since they are
      * the same as the trees coordinates. */
     for (i = 0;i < 3;i++) {
@@ -314,85 +613,606 @@ t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
   return;
 }
 
-/* Compute the diameter of an element. */
-double
-t8_forest_element_diam (t8_forest_t forest, t8_locidx_t ltreeid,
-                        const t8_element_t * element, const double *vertices)
+/* given an element in a coarse tree, the corner coordinates of the coarse tree
+ * and a corner number of the element compute the coordinates of that corner
+ * within the coarse tree.
+ */
+/* TODO: replace ltree_id argument with ts argument. */
+void
+t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
+                              const t8_element_t * element,
+                              const double *vertices, int corner_number,
+                              double *coordinates)
 {
-  t8_eclass_t         eclass;
+  int                 corner_coords[3];
   t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
 
-  double              centroid[3], coordinates[3];
-  double              dist;
-  int                 i, num_corners;
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->scheme_cxx != NULL);
+  eclass = t8_forest_get_tree_class (forest, ltree_id);
+  T8_ASSERT (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_TRIANGLE
+             || eclass == T8_ECLASS_TET || eclass == T8_ECLASS_QUAD
+             || eclass == T8_ECLASS_HEX || eclass == T8_ECLASS_LINE
+             || eclass == T8_ECLASS_PRISM);
 
-  /* Get the element's eclass and scheme */
-  eclass = t8_forest_get_tree_class (forest, ltreeid);
-  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  T8_ASSERT (eclass != T8_ECLASS_VERTEX || corner_number == 0);
 
-  /* We approximate the diameter as twice the average of the distances
-   * from the vertices to the centroid. */
+  ts = forest->scheme_cxx->eclass_schemes[eclass];
+  ts->t8_element_vertex_coords (element, corner_number, corner_coords);
+  t8_forest_tree_coordinate (forest, ltree_id, eclass, vertices,
+                             corner_coords, 1. / ts->t8_element_root_len
+                             (element), coordinates);
+}
 
-  num_corners = ts->t8_element_num_corners (element);
+/* The number of elements whose reference coordinates
+ * t8_forest_element_coordinates_batch decodes at once. */
+#define T8_FOREST_COORDINATES_BATCH 128
 
-  /* Compute the centroid */
-  t8_forest_element_centroid (forest, ltreeid, element, vertices, centroid);
-  dist = 0;
-  for (i = 0; i < num_corners; i++) {
-    /* Compute coordinates of this corner */
-    t8_forest_element_coordinate (forest, ltreeid, element, vertices, i,
-                                  coordinates);
-    /* Compute the distance to the midpoint */
-    dist += t8_vec_dist (coordinates, centroid);
+/* Map points in the reference element of a tree to the tree's geometry.
+ * ref and coordinates store 3 doubles per point. */
+static void
+t8_forest_reference_to_tree (t8_eclass_t eclass, const double *vertices,
+                             const double *ref, size_t num_points,
+                             double *coordinates)
+{
+  double              v0[3], m[3][3];
+  size_t              ipoint;
+  int                 i;
+
+  switch (eclass) {
+  case T8_ECLASS_LINE:
+  case T8_ECLASS_TRIANGLE:
+  case T8_ECLASS_TET:
+    /* The map is affine, x = v_0 + M r */
+    for (i = 0; i < 3; i++) {
+      v0[i] = vertices[i];
+      m[0][i] = vertices[3 + i] - vertices[i];
+      m[1][i] = 0;
+      m[2][i] = 0;
+      if (eclass == T8_ECLASS_TRIANGLE) {
+        m[1][i] = vertices[6 + i] - vertices[3 + i];
+      }
+      else if (eclass == T8_ECLASS_TET) {
+        m[1][i] = vertices[9 + i] - vertices[6 + i];
+        m[2][i] = vertices[6 + i] - vertices[3 + i];
+      }
+    }
+    for (ipoint = 0; ipoint < num_points; ipoint++) {
+      const double       *r = ref + 3 * ipoint;
+      for (i = 0; i < 3; i++) {
+        coordinates[3 * ipoint + i] =
+          v0[i] + m[0][i] * r[0] + m[1][i] * r[1] + m[2][i] * r[2];
+      }
+    }
+    break;
+  case T8_ECLASS_QUAD:
+  case T8_ECLASS_HEX:
+    for (ipoint = 0; ipoint < num_points; ipoint++) {
+      t8_forest_bilinear_interpolation (ref + 3 * ipoint, vertices,
+                                        t8_eclass_to_dimension[eclass],
+                                        coordinates + 3 * ipoint);
+    }
+    break;
+  case T8_ECLASS_PRISM:
+    /* Interpolate the triangle at the point's height, then within it */
+    for (ipoint = 0; ipoint < num_points; ipoint++) {
+      const double       *r = ref + 3 * ipoint;
+      double              tri[9];
+      for (i = 0; i < 9; i++) {
+        tri[i] = vertices[i] + r[2] * (vertices[9 + i] - vertices[i]);
+      }
+      for (i = 0; i < 3; i++) {
+        coordinates[3 * ipoint + i] = tri[i]
+          + r[0] * (tri[3 + i] - tri[i]) + r[1] * (tri[6 + i] - tri[3 + i]);
+      }
+    }
+    break;
+  default:
+    SC_ABORT_NOT_REACHED ();
   }
-  /* We approximate the diameter as twice the average of the distances
-   * from the vertices to the centroid. */
-  return 2 * dist / num_corners;
 }
 
-/* Compute the center of mass of an element.
- * The center of mass of a polygon with vertices x_1, ... , x_n
- * is given by   1/n * (x_1 + ... + x_n)
- */
 void
-t8_forest_element_centroid (t8_forest_t forest, t8_locidx_t ltreeid,
-                            const t8_element_t * element,
-                            const double *vertices, double *coordinates)
+t8_forest_element_coordinates_batch (t8_forest_t forest, t8_locidx_t ltreeid,
+                                     t8_locidx_t first_element,
+                                     t8_locidx_t num_elements,
+                                     const double *vertices,
+                                     double *coordinates)
 {
-  double              corner_coords[3];
-  int                 num_corners, icorner;
+  t8_eclass_t         eclass;
   t8_eclass_scheme_c *ts;
+  t8_tree_t           tree;
+  const t8_element_t *element;
+  double              ref[3 * T8_ECLASS_MAX_CORNERS
+                          * T8_FOREST_COORDINATES_BATCH];
+  double              len;
+  t8_locidx_t         ielem, batch_begin, batch_end;
+  int                 num_corners, icorner, corner_coords[3], dim, i;
+  size_t              ipoint;
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  ts =
-    t8_forest_get_eclass_scheme (forest,
-                                 t8_forest_get_tree_class (forest, ltreeid));
-  T8_ASSERT (ts->t8_element_is_valid (element));
-
-  /* initialize the centroid with 0 */
-  memset (coordinates, 0, 3 * sizeof (double));
-  /* get the number of corners of element */
-  num_corners = ts->t8_element_num_corners (element);
-  for (icorner = 0; icorner < num_corners; icorner++) {
-    /* For each corner, add its coordinates to the centroids coordinates. */
-    t8_forest_element_coordinate (forest, ltreeid, element, vertices, icorner,
-                                  corner_coords);
-    /* coordinates = coordinates + corner_coords */
-    t8_vec_axpy (corner_coords, coordinates, 1);
+  T8_ASSERT (0 <= ltreeid && ltreeid < t8_forest_get_num_local_trees (forest));
+  tree = t8_forest_get_tree (forest, ltreeid);
+  T8_ASSERT (0 <= first_element && num_elements >= 0);
+  T8_ASSERT (first_element + num_elements <=
+             (t8_locidx_t) t8_element_array_get_count (&tree->elements));
+  if (num_elements == 0) {
+    return;
+  }
+  eclass = tree->eclass;
+  num_corners = t8_eclass_num_vertices[eclass];
+  if ((eclass != T8_ECLASS_LINE && eclass != T8_ECLASS_TRIANGLE
+       && eclass != T8_ECLASS_TET && eclass != T8_ECLASS_QUAD
+       && eclass != T8_ECLASS_HEX && eclass != T8_ECLASS_PRISM)
+      || t8_forest_get_tree_curved (forest, ltreeid) != NULL) {
+    /* No batched kernel for this class or the tree's geometry */
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      element = t8_element_array_index_locidx (&tree->elements,
+                                               first_element + ielem);
+      for (icorner = 0; icorner < num_corners; icorner++) {
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices,
+                                      icorner, coordinates
+                                      + 3 * (ielem * num_corners + icorner));
+      }
+    }
+    return;
+  }
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  dim = t8_eclass_to_dimension[eclass];
+  /* The root length is the same for all elements of a scheme */
+  len = 1. / ts->t8_element_root_len (t8_element_array_index_locidx
+                                      (&tree->elements, first_element));
+  for (batch_begin = 0; batch_begin < num_elements;
+       batch_begin += T8_FOREST_COORDINATES_BATCH) {
+    batch_end = SC_MIN (num_elements,
+                        batch_begin + T8_FOREST_COORDINATES_BATCH);
+    /* Decode the integer corner coordinates of the batch */
+    for (ielem = batch_begin, ipoint = 0; ielem < batch_end; ielem++) {
+      element = t8_element_array_index_locidx (&tree->elements,
+                                               first_element + ielem);
+      for (icorner = 0; icorner < num_corners; icorner++, ipoint++) {
+        ts->t8_element_vertex_coords (element, icorner, corner_coords);
+        for (i = 0; i < 3; i++) {
+          ref[3 * ipoint + i] = i < dim ? len * corner_coords[i] : 0.;
+        }
+      }
+    }
+    t8_forest_reference_to_tree (eclass, vertices, ref, ipoint, coordinates
+                                 + 3 * (size_t) batch_begin * num_corners);
   }
-  /* Divide each coordinate by num_corners */
-  t8_vec_ax (coordinates, 1. / num_corners);
 }
 
-/* Compute the length of the line from one corner to a second corner in an element */
-static double
-t8_forest_element_line_length (t8_forest_t forest, t8_locidx_t ltreeid,
-                               const t8_element_t * element,
-                               const double *vertices, int corner_a,
-                               int corner_b)
+void
+t8_forest_element_coordinates_batch_float (t8_forest_t forest,
+                                           t8_locidx_t ltreeid,
+                                           t8_locidx_t first_element,
+                                           t8_locidx_t num_elements,
+                                           const double *vertices,
+                                           float *coordinates)
 {
-  double              coordinates_a[3], coordinates_b[3];
-  double              length;
+  double              batch[3 * T8_ECLASS_MAX_CORNERS
+                            * T8_FOREST_COORDINATES_BATCH];
+  t8_locidx_t         batch_begin, batch_count;
+  size_t              num_values, ivalue, offset;
+  int                 num_corners;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  num_corners =
+    t8_eclass_num_vertices[t8_forest_get_tree_class (forest, ltreeid)];
+  /* The corners are computed in double precision one batch at a time
+   * and rounded when they are copied to the output. */
+  for (batch_begin = 0; batch_begin < num_elements;
+       batch_begin += T8_FOREST_COORDINATES_BATCH) {
+    batch_count = SC_MIN (num_elements - batch_begin,
+                          T8_FOREST_COORDINATES_BATCH);
+    t8_forest_element_coordinates_batch (forest, ltreeid,
+                                         first_element + batch_begin,
+                                         batch_count, vertices, batch);
+    num_values = 3 * (size_t) batch_count * num_corners;
+    offset = 3 * (size_t) batch_begin * num_corners;
+    for (ivalue = 0; ivalue < num_values; ivalue++) {
+      coordinates[offset + ivalue] = (float) batch[ivalue];
+    }
+  }
+}
+
+/* Return the type of a triangle, a tet or the triangle of a prism.
+ * We read it from the directions of the edges between the first corners,
+ * see t8_dtri_compute_coords, such that any scheme with the default
+ * corner numbering is supported. */
+static int
+t8_forest_element_simplex_type (t8_eclass_scheme_c * ts,
+                                const t8_element_t * element,
+                                t8_eclass_t eclass)
+{
+  int                 c0[3], c1[3], c2[3], ei, ej;
+
+  ts->t8_element_vertex_coords (element, 0, c0);
+  ts->t8_element_vertex_coords (element, 1, c1);
+  for (ei = 0; c1[ei] == c0[ei]; ei++) {
+  }
+  if (eclass != T8_ECLASS_TET) {
+    return ei;
+  }
+  ts->t8_element_vertex_coords (element, 2, c2);
+  for (ej = 0; c2[ej] == c1[ej]; ej++) {
+  }
+  return 2 * ei + ((ej - ei + 3) % 3 == 2 ? 0 : 1);
+}
+
+/* Return true if the children and corners of the scheme are numbered as
+ * in the refinement tables. Derived schemes, such as the Hilbert schemes,
+ * may number the children differently. */
+static int
+t8_forest_scheme_has_refine_tables (t8_eclass_scheme_c * ts)
+{
+  return typeid (*ts) == typeid (t8_default_scheme_line_c)
+    || typeid (*ts) == typeid (t8_default_scheme_quad_c)
+    || typeid (*ts) == typeid (t8_default_scheme_hex_c)
+    || typeid (*ts) == typeid (t8_default_scheme_tri_c)
+    || typeid (*ts) == typeid (t8_default_scheme_tet_c)
+    || typeid (*ts) == typeid (t8_default_scheme_prism_c);
+}
+
+void
+t8_forest_element_children_coordinates_batch (t8_forest_t forest,
+                                              t8_locidx_t ltreeid,
+                                              t8_locidx_t first_element,
+                                              t8_locidx_t num_elements,
+                                              const double *vertices,
+                                              double *coordinates)
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  t8_tree_t           tree;
+  const t8_element_t *element;
+  t8_element_t       *children[T8_ECLASS_MAX_CHILDREN];
+  double              parents[3 * T8_ECLASS_MAX_CORNERS
+                              * T8_FOREST_COORDINATES_BATCH];
+  const double       *parent;
+  double             *child, sum[3];
+  const uint8_t      *corners;
+  t8_locidx_t         ielem, batch_begin, batch_count;
+  int                 num_corners, num_children, ichild, icorner;
+  int                 iparent, mask, count, type, i;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= ltreeid && ltreeid < t8_forest_get_num_local_trees (forest));
+  tree = t8_forest_get_tree (forest, ltreeid);
+  T8_ASSERT (0 <= first_element && num_elements >= 0);
+  T8_ASSERT (first_element + num_elements <=
+             (t8_locidx_t) t8_element_array_get_count (&tree->elements));
+  if (num_elements == 0) {
+    return;
+  }
+  eclass = tree->eclass;
+  T8_ASSERT (eclass != T8_ECLASS_PYRAMID);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  num_corners = t8_eclass_num_vertices[eclass];
+  if (!t8_forest_scheme_has_refine_tables (ts)
+      || t8_forest_get_tree_curved (forest, ltreeid) != NULL) {
+    /* There are no tables for this scheme or the corners of the children
+     * are no averages of the parent's corners, we construct the children */
+    num_children = ts->t8_element_num_children
+      (t8_element_array_index_locidx (&tree->elements, first_element));
+    ts->t8_element_new (num_children, children);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      element = t8_element_array_index_locidx (&tree->elements,
+                                               first_element + ielem);
+      ts->t8_element_children (element, num_children, children);
+      for (ichild = 0; ichild < num_children; ichild++) {
+        for (icorner = 0; icorner < num_corners; icorner++) {
+          t8_forest_element_coordinate (forest, ltreeid, children[ichild],
+                                        vertices, icorner, coordinates
+                                        + 3 * ((ielem * num_children + ichild)
+                                               * num_corners + icorner));
+        }
+      }
+    }
+    ts->t8_element_destroy (num_children, children);
+    return;
+  }
+  num_children = 1 << t8_eclass_to_dimension[eclass];
+  corners = t8_refine_child_corners (eclass, 0);
+  for (batch_begin = 0; batch_begin < num_elements;
+       batch_begin += T8_FOREST_COORDINATES_BATCH) {
+    batch_count = SC_MIN (num_elements - batch_begin,
+                          T8_FOREST_COORDINATES_BATCH);
+    t8_forest_element_coordinates_batch (forest, ltreeid,
+                                         first_element + batch_begin,
+                                         batch_count, vertices, parents);
+    for (ielem = 0; ielem < batch_count; ielem++) {
+      if (eclass == T8_ECLASS_TRIANGLE || eclass == T8_ECLASS_TET
+          || eclass == T8_ECLASS_PRISM) {
+        type = t8_forest_element_simplex_type (ts,
+                                               t8_element_array_index_locidx
+                                               (&tree->elements,
+                                                first_element + batch_begin
+                                                + ielem), eclass);
+        corners = t8_refine_child_corners (eclass, type);
+      }
+      parent = parents + 3 * ielem * num_corners;
+      child = coordinates
+        + 3 * (size_t) (batch_begin + ielem) * num_children * num_corners;
+      /* Each child corner is the average of the parent corners in its mask */
+      for (i = 0; i < num_children * num_corners; i++, child += 3) {
+        sum[0] = sum[1] = sum[2] = 0;
+        count = 0;
+        for (iparent = 0, mask = corners[i]; mask != 0;
+             iparent++, mask >>= 1) {
+          if (mask & 1) {
+            sum[0] += parent[3 * iparent];
+            sum[1] += parent[3 * iparent + 1];
+            sum[2] += parent[3 * iparent + 2];
+            count++;
+          }
+        }
+        child[0] = sum[0] / count;
+        child[1] = sum[1] / count;
+        child[2] = sum[2] / count;
+      }
+    }
+  }
+}
+
+void
+t8_forest_element_bounding_box (t8_forest_t forest, t8_locidx_t ltreeid,
+                                const t8_element_t * element,
+                                const double *vertices, double box[6])
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  const t8_forest_tree_affine_t *affine;
+  double              ref[3 * 8], coords[3 * 8], center, half;
+  double              len;
+  int                 ibox[6], num_points, ipoint, num_corners, dim, i, j;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  dim = t8_eclass_to_dimension[eclass];
+  if (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_PYRAMID
+      || t8_forest_get_tree_curved (forest, ltreeid) != NULL) {
+    /* The box of the element's corners */
+    num_corners = ts->t8_element_num_corners (element);
+    T8_ASSERT (num_corners <= 8);
+    for (ipoint = 0; ipoint < num_corners; ipoint++) {
+      t8_forest_element_coordinate (forest, ltreeid, element, vertices,
+                                    ipoint, coords + 3 * ipoint);
+    }
+    num_points = num_corners;
+  }
+  else {
+    ts->t8_element_bounding_box (element, ibox);
+    len = 1. / ts->t8_element_root_len (element);
+    affine = t8_forest_get_tree_affine (forest, ltreeid, vertices);
+    if (affine != NULL) {
+      /* The image of the box is a parallelepiped, its extent in each
+       * direction is the sum of the absolute Jacobian entries */
+      for (i = 0; i < 3; i++) {
+        center = affine->offset[i];
+        half = 0;
+        for (j = 0; j < dim; j++) {
+          center +=
+            affine->jacobian[j][i] * 0.5 * len * (ibox[j] + ibox[3 + j]);
+          half +=
+            fabs (affine->jacobian[j][i]) * 0.5 * len * (ibox[3 + j] -
+                                                         ibox[j]);
+        }
+        box[i] = center - half;
+        box[3 + i] = center + half;
+      }
+      return;
+    }
+    /* The maps of quad, hex and prism trees are multilinear on the box,
+     * thus the element lies in the convex hull of the box corners' images */
+    num_points = 1 << dim;
+    for (ipoint = 0; ipoint < num_points; ipoint++) {
+      for (i = 0; i < 3; i++) {
+        ref[3 * ipoint + i] = i < dim ?
+          len * ibox[(ipoint >> i & 1) ? 3 + i : i] : 0.;
+      }
+    }
+    t8_forest_reference_to_tree (eclass, vertices, ref, num_points, coords);
+  }
+  for (i = 0; i < 3; i++) {
+    box[i] = box[3 + i] = coords[i];
+  }
+  for (ipoint = 1; ipoint < num_points; ipoint++) {
+    for (i = 0; i < 3; i++) {
+      box[i] = SC_MIN (box[i], coords[3 * ipoint + i]);
+      box[3 + i] = SC_MAX (box[3 + i], coords[3 * ipoint + i]);
+    }
+  }
+}
+
+/* Return the element array of a local or ghost tree and the index of its
+ * first element in the geometry cache. */
+static t8_element_array_t *
+t8_forest_geometry_cache_tree (t8_forest_t forest, t8_locidx_t ltreeid,
+                               t8_locidx_t * first_index)
+{
+  t8_locidx_t         num_local_trees;
+  t8_tree_t           tree;
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  if (ltreeid < num_local_trees) {
+    tree = t8_forest_get_tree (forest, ltreeid);
+    *first_index = tree->elements_offset;
+    return &tree->elements;
+  }
+  *first_index = t8_forest_get_num_element (forest)
+    + t8_forest_ghost_get_tree_element_offset (forest,
+                                               ltreeid - num_local_trees);
+  return t8_forest_ghost_get_tree_elements (forest,
+                                            ltreeid - num_local_trees);
+}
+
+/* Return the index of an element in the geometry cache of a forest,
+ * or -1 if its geometry is not cached. Only elements that lie in the
+ * element array of their tree are cached. */
+static t8_locidx_t
+t8_forest_geometry_cache_index (t8_forest_t forest, t8_locidx_t ltreeid,
+                                const t8_element_t * element)
+{
+  const t8_forest_geometry_cache_t *cache = forest->geometry_cache;
+  const sc_array_t   *elements;
+  t8_locidx_t         first_index;
+  size_t              pos;
+
+  if (cache == NULL || (ltreeid >= t8_forest_get_num_local_trees (forest)
+                        && cache->num_elements ==
+                        cache->num_local_elements)) {
+    return -1;
+  }
+  elements =
+    t8_element_array_get_array (t8_forest_geometry_cache_tree
+                                (forest, ltreeid, &first_index));
+  if ((const char *) element < elements->array) {
+    return -1;
+  }
+  pos = (size_t) ((const char *) element - elements->array);
+  if (pos >= elements->elem_count * elements->elem_size
+      || pos % elements->elem_size != 0) {
+    return -1;
+  }
+  return first_index + (t8_locidx_t) (pos / elements->elem_size);
+}
+
+/* Read a value of the geometry cache. Exactly one of values and
+ * values_float is not NULL, depending on the precision of the cache. */
+static inline double
+t8_forest_geometry_cache_value (const double *values,
+                                const float *values_float, t8_locidx_t index)
+{
+  return values != NULL ? values[index] : (double) values_float[index];
+}
+
+/* Store a value in the geometry cache in its precision */
+static inline void
+t8_forest_geometry_cache_store (double *values, float *values_float,
+                                t8_locidx_t index, double value)
+{
+  if (values != NULL) {
+    values[index] = value;
+  }
+  else {
+    values_float[index] = (float) value;
+  }
+}
+
+/* Compute the diameter of an element. */
+double
+t8_forest_element_diam (t8_forest_t forest, t8_locidx_t ltreeid,
+                        const t8_element_t * element, const double *vertices)
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+
+  double              centroid[3], coordinates[3];
+  double              dist;
+  int                 i, num_corners;
+
+  /* Get the element's eclass and scheme */
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+
+  /* We approximate the diameter as twice the average of the distances
+   * from the vertices to the centroid. */
+
+  num_corners = ts->t8_element_num_corners (element);
+
+  /* Compute the centroid */
+  t8_forest_element_centroid (forest, ltreeid, element, vertices, centroid);
+  dist = 0;
+  for (i = 0; i < num_corners; i++) {
+    /* Compute coordinates of this corner */
+    t8_forest_element_coordinate (forest, ltreeid, element, vertices, i,
+                                  coordinates);
+    /* Compute the distance to the midpoint */
+    dist += t8_vec_dist (coordinates, centroid);
+  }
+  /* We approximate the diameter as twice the average of the distances
+   * from the vertices to the centroid. */
+  return 2 * dist / num_corners;
+}
+
+/* Compute the center of mass of an element.
+ * The center of mass of a polygon with vertices x_1, ... , x_n
+ * is given by   1/n * (x_1 + ... + x_n)
+ */
+void
+t8_forest_element_centroid (t8_forest_t forest, t8_locidx_t ltreeid,
+                            const t8_element_t * element,
+                            const double *vertices, double *coordinates)
+{
+  double              corner_coords[3];
+  int                 num_corners, icorner;
+  t8_locidx_t         index;
+  const t8_forest_tree_affine_t *affine;
+  t8_eclass_scheme_c *ts;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  ts =
+    t8_forest_get_eclass_scheme (forest,
+                                 t8_forest_get_tree_class (forest, ltreeid));
+  T8_ASSERT (ts->t8_element_is_valid (element));
+
+  index = t8_forest_geometry_cache_index (forest, ltreeid, element);
+  if (index >= 0) {
+    /* The centroid is cached */
+    for (icorner = 0; icorner < 3; icorner++) {
+      coordinates[icorner] =
+        t8_forest_geometry_cache_value (forest->geometry_cache->centroid
+                                        [icorner],
+                                        forest->geometry_cache->centroid_float
+                                        [icorner], index);
+    }
+    return;
+  }
+  affine = t8_forest_get_tree_affine (forest, ltreeid, vertices);
+  if (affine != NULL) {
+    /* Average the corners in reference coordinates and map once */
+    int                 corner[3], dim, i;
+    double              ref[3] = { 0, 0, 0 }, len;
+
+    dim = t8_eclass_to_dimension[ts->eclass];
+    num_corners = ts->t8_element_num_corners (element);
+    len = 1. / (ts->t8_element_root_len (element) * (double) num_corners);
+    for (icorner = 0; icorner < num_corners; icorner++) {
+      ts->t8_element_vertex_coords (element, icorner, corner);
+      for (i = 0; i < dim; i++) {
+        ref[i] += len * corner[i];
+      }
+    }
+    t8_forest_tree_affine_map (affine, ref, coordinates);
+    return;
+  }
+  /* initialize the centroid with 0 */
+  memset (coordinates, 0, 3 * sizeof (double));
+  /* get the number of corners of element */
+  num_corners = ts->t8_element_num_corners (element);
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    /* For each corner, add its coordinates to the centroids coordinates. */
+    t8_forest_element_coordinate (forest, ltreeid, element, vertices, icorner,
+                                  corner_coords);
+    /* coordinates = coordinates + corner_coords */
+    t8_vec_axpy (corner_coords, coordinates, 1);
+  }
+  /* Divide each coordinate by num_corners */
+  t8_vec_ax (coordinates, 1. / num_corners);
+}
+
+/* Compute the length of the line from one corner to a second corner in an element */
+static double
+t8_forest_element_line_length (t8_forest_t forest, t8_locidx_t ltreeid,
+                               const t8_element_t * element,
+                               const double *vertices, int corner_a,
+                               int corner_b)
+{
+  double              coordinates_a[3], coordinates_b[3];
+  double              length;
 
   t8_forest_element_coordinate (forest, ltreeid, element, vertices, corner_a,
                                 coordinates_a);
@@ -450,6 +1270,223 @@ t8_forest_element_tet_volume (double coordinates[4][3])
   return fabs (t8_vec_dot (coordinates[0], cross)) / 6;
 }
 
+/* Return (b - a) * ((c - a) x (d - a)) */
+static double
+t8_forest_triple_product (const double a[3], const double b[3],
+                          const double c[3], const double d[3])
+{
+  double              u[3], v[3], w[3], cross[3];
+
+  t8_vec_axpyz (a, b, u, -1);
+  t8_vec_axpyz (a, c, v, -1);
+  t8_vec_axpyz (a, d, w, -1);
+  t8_vec_cross (v, w, cross);
+  return t8_vec_dot (u, cross);
+}
+
+/* Return true if the map from the reference element to a tree is affine.
+ * Then all elements of a quad, hex or prism tree are parallelograms,
+ * parallelepipeds or straight prisms. */
+static int
+t8_forest_tree_is_affine (t8_eclass_t eclass, const double *vertices)
+{
+  /* For hexes the coefficients of the terms uv, uw, vw and uvw of the
+   * trilinear map, for prisms the difference of the edges from the bottom
+   * to the top triangle. Each as corner weights in Z-order. */
+  static const int    hex_terms[4][8] = {
+    {1, -1, -1, 1, 0, 0, 0, 0}, {1, -1, 0, 0, -1, 1, 0, 0},
+    {1, 0, -1, 0, -1, 0, 1, 0}, {-1, 1, 1, -1, 1, -1, -1, 1}
+  };
+  static const int    prism_terms[2][6] = {
+    {1, -1, 0, -1, 1, 0}, {1, 0, -1, -1, 0, 1}
+  };
+  const int          *terms;
+  double              term, scale;
+  int                 num_terms, num_vertices, iterm, ivertex, i;
+
+  if (eclass != T8_ECLASS_QUAD && eclass != T8_ECLASS_HEX
+      && eclass != T8_ECLASS_PRISM) {
+    /* The maps of all other classes are affine */
+    return 1;
+  }
+  /* For quads only the uv term exists */
+  num_terms = eclass == T8_ECLASS_HEX ? 4 : eclass == T8_ECLASS_QUAD ? 1 : 2;
+  num_vertices = t8_eclass_num_vertices[eclass];
+  /* The terms are compared to the size of the tree */
+  scale = t8_vec_dist (vertices, vertices + 3 * (num_vertices - 1));
+  for (iterm = 0; iterm < num_terms; iterm++) {
+    terms = eclass == T8_ECLASS_HEX ? hex_terms[iterm] : prism_terms[iterm];
+    for (i = 0; i < 3; i++) {
+      term = 0;
+      for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+        term += terms[ivertex] * vertices[3 * ivertex + i];
+      }
+      if (fabs (term) > 1e-12 * scale) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+void
+t8_forest_tree_affine_compute (t8_forest_t forest)
+{
+  t8_forest_tree_affine_t *affine;
+  t8_locidx_t         num_local_trees, ltree;
+  t8_eclass_t         eclass;
+  const double       *v;
+  double              cross[3];
+  /* For each reference coordinate the vertices whose difference is the
+   * derivative of the map, following t8_forest_element_coordinate. */
+  static const int    jacobian_vertices[T8_ECLASS_COUNT][3][2] = {
+    {{0, 0}, {0, 0}, {0, 0}},   /* vertex */
+    {{1, 0}, {0, 0}, {0, 0}},   /* line */
+    {{1, 0}, {2, 0}, {0, 0}},   /* quad */
+    {{1, 0}, {2, 1}, {0, 0}},   /* triangle */
+    {{1, 0}, {2, 0}, {4, 0}},   /* hex */
+    {{1, 0}, {3, 2}, {2, 1}},   /* tet */
+    {{1, 0}, {2, 1}, {3, 0}},   /* prism */
+    {{0, 0}, {0, 0}, {0, 0}}    /* pyramid */
+  };
+  /* The volume of each reference element */
+  static const double reference_volume[T8_ECLASS_COUNT] = {
+    0, 1, 1, 0.5, 1, 1. / 6, 0.5, 0
+  };
+  int                 i, j, dim;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->tree_affine == NULL);
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  forest->tree_affine = affine =
+    T8_ALLOC_ZERO (t8_forest_tree_affine_t, num_local_trees + 1);
+  for (ltree = 0; ltree < num_local_trees; ltree++, affine++) {
+    eclass = t8_forest_get_tree_class (forest, ltree);
+    /* Only stored vertices have a fixed address to compare against */
+    v = affine->vertices = (const double *)
+      t8_cmesh_get_attribute (forest->cmesh, t8_get_package_id (), 0,
+                              t8_forest_ltreeid_to_cmesh_ltreeid (forest,
+                                                                  ltree));
+    if (v == NULL || eclass == T8_ECLASS_VERTEX
+        || eclass == T8_ECLASS_PYRAMID
+        || !t8_forest_tree_is_affine (eclass, v)) {
+      continue;
+    }
+    affine->is_affine = 1;
+    dim = t8_eclass_to_dimension[eclass];
+    for (i = 0; i < 3; i++) {
+      affine->offset[i] = v[i];
+      for (j = 0; j < 3; j++) {
+        affine->jacobian[j][i] = j < dim ?
+          v[3 * jacobian_vertices[eclass][j][0] + i]
+          - v[3 * jacobian_vertices[eclass][j][1] + i] : 0.;
+      }
+    }
+    switch (dim) {
+    case 1:
+      affine->volume = t8_vec_norm (affine->jacobian[0]);
+      break;
+    case 2:
+      t8_vec_cross (affine->jacobian[0], affine->jacobian[1], cross);
+      affine->volume = t8_vec_norm (cross);
+      break;
+    default:
+      t8_vec_cross (affine->jacobian[1], affine->jacobian[2], cross);
+      affine->volume = fabs (t8_vec_dot (affine->jacobian[0], cross));
+    }
+    affine->volume *= reference_volume[eclass];
+  }
+}
+
+/* The points of the two point Gauss rule on [0, 1] */
+static const double t8_forest_gauss_points[2] = {
+  0.5 - 0.28867513459481288225, 0.5 + 0.28867513459481288225
+};
+
+/* Compute the volume of a trilinear hex from its corners in Z-order.
+ * The Jacobian determinant is at most quadratic in each reference
+ * coordinate, so the 2x2x2 Gauss rule integrates it exactly. */
+static double
+t8_forest_element_hex_volume (double coordinates[8][3])
+{
+  /* The derivatives of the trilinear map at the 8 Gauss points,
+   * stored by component */
+  double              du[24], dv[24], dw[24], cross[24], det[8];
+  double              u, v, w, volume = 0;
+  int                 iu, iv, iw, ipoint, i;
+
+  for (iw = 0, ipoint = 0; iw < 2; iw++) {
+    w = t8_forest_gauss_points[iw];
+    for (iv = 0; iv < 2; iv++) {
+      v = t8_forest_gauss_points[iv];
+      for (iu = 0; iu < 2; iu++, ipoint++) {
+        u = t8_forest_gauss_points[iu];
+        for (i = 0; i < 3; i++) {
+          du[8 * i + ipoint] =
+            (1 - v) * (1 - w) * (coordinates[1][i] - coordinates[0][i])
+            + v * (1 - w) * (coordinates[3][i] - coordinates[2][i])
+            + (1 - v) * w * (coordinates[5][i] - coordinates[4][i])
+            + v * w * (coordinates[7][i] - coordinates[6][i]);
+          dv[8 * i + ipoint] =
+            (1 - u) * (1 - w) * (coordinates[2][i] - coordinates[0][i])
+            + u * (1 - w) * (coordinates[3][i] - coordinates[1][i])
+            + (1 - u) * w * (coordinates[6][i] - coordinates[4][i])
+            + u * w * (coordinates[7][i] - coordinates[5][i]);
+          dw[8 * i + ipoint] =
+            (1 - u) * (1 - v) * (coordinates[4][i] - coordinates[0][i])
+            + u * (1 - v) * (coordinates[5][i] - coordinates[1][i])
+            + (1 - u) * v * (coordinates[6][i] - coordinates[2][i])
+            + u * v * (coordinates[7][i] - coordinates[3][i]);
+        }
+      }
+    }
+  }
+  /* The Jacobian determinants at all points at once */
+  t8_vec_cross_n (8, dv, dw, cross);
+  t8_vec_dot_n (8, du, cross, det);
+  for (ipoint = 0; ipoint < 8; ipoint++) {
+    volume += det[ipoint];
+  }
+  return fabs (volume) / 8;
+}
+
+/* Compute the volume of a prism from its corners, the bottom triangle
+ * 0, 1, 2 and the top triangle 3, 4, 5. The map is affine on each triangle
+ * and linear in the height. Its Jacobian determinant is linear on the
+ * triangle and quadratic in the height, so the centroid rule combined
+ * with the 2 point Gauss rule integrates it exactly. */
+static double
+t8_forest_element_prism_volume (double coordinates[6][3])
+{
+  /* The derivatives at the 2 Gauss points, stored by component */
+  double              ds[6], dt[6], dh[6], cross[6], det[2], h;
+  double              edge[3];
+  int                 ih, i, k;
+  /* The centroid of the reference triangle 0 <= t <= s <= 1 */
+  const double        s = 2. / 3, t = 1. / 3;
+
+  for (ih = 0; ih < 2; ih++) {
+    h = t8_forest_gauss_points[ih];
+    for (i = 0; i < 3; i++) {
+      /* The vertical edges of the prism */
+      for (k = 0; k < 3; k++) {
+        edge[k] = coordinates[k + 3][i] - coordinates[k][i];
+      }
+      ds[2 * i + ih] =
+        coordinates[1][i] - coordinates[0][i] + h * (edge[1] - edge[0]);
+      dt[2 * i + ih] =
+        coordinates[2][i] - coordinates[1][i] + h * (edge[2] - edge[1]);
+      dh[2 * i + ih] =
+        edge[0] + s * (edge[1] - edge[0]) + t * (edge[2] - edge[1]);
+    }
+  }
+  t8_vec_cross_n (2, dt, dh, cross);
+  t8_vec_dot_n (2, ds, cross, det);
+  /* The triangle has area 1/2 and each Gauss point weight 1/2 */
+  return fabs (det[0] + det[1]) / 4;
+}
+
 /* Compute an element's volume */
 double
 t8_forest_element_volume (t8_forest_t forest, t8_locidx_t ltreeid,
@@ -457,9 +1494,29 @@ t8_forest_element_volume (t8_forest_t forest, t8_locidx_t ltreeid,
                           const double *vertices)
 {
   t8_eclass_t         eclass;
+  t8_locidx_t         index;
+  const t8_forest_tree_affine_t *affine;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
+  index = t8_forest_geometry_cache_index (forest, ltreeid, element);
+  if (index >= 0) {
+    /* The volume is cached */
+    return t8_forest_geometry_cache_value (forest->geometry_cache->volume,
+                                           forest->geometry_cache->
+                                           volume_float, index);
+  }
+  affine = t8_forest_get_tree_affine (forest, ltreeid, vertices);
+  if (affine != NULL) {
+    /* All elements of a level have the same reference volume */
+    t8_eclass_scheme_c *ts;
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltreeid));
+    return ldexp (affine->volume,
+                  -t8_eclass_to_dimension[ts->eclass]
+                  * ts->t8_element_level (element));
+  }
   /* get the eclass of the forest */
   eclass = t8_forest_get_tree_class (forest, ltreeid);
 
@@ -552,74 +1609,53 @@ t8_forest_element_volume (t8_forest_t forest, t8_locidx_t ltreeid,
     break;
   case T8_ECLASS_HEX:
     {
-      /* We compute the volume as the determinant of the three vectors
-       * from corner 0 to 1, to 2, to 4 (in Z-order).
-       */
-      double              coordinates[4][3], cross[3];
+      double              coordinates[8][3];
       int                 i;
 
-      /* Get the coordinates of the four corners */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 1,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[3]);
-
-      /* Compute the difference of each corner with corner 0 */
-      for (i = 1; i < 4; i++) {
-        t8_vec_axpy (coordinates[0], coordinates[i], -1);
+      if (t8_forest_tree_is_affine (eclass, vertices)) {
+        /* The element is a parallelepiped, its volume is the determinant
+         * of the three vectors from corner 0 to 1, to 2, to 4 (Z-order). */
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
+                                      coordinates[0]);
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices, 1,
+                                      coordinates[1]);
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
+                                      coordinates[2]);
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
+                                      coordinates[4]);
+        return fabs (t8_forest_triple_product (coordinates[0], coordinates[1],
+                                               coordinates[2],
+                                               coordinates[4]));
       }
-
-      /* Compute the cross product of the 2nd and 3rd */
-      t8_vec_cross (coordinates[2], coordinates[3], cross);
-
-      /* return |(a-d) * ((b-d)x(c-d))| */
-      return fabs (t8_vec_dot (coordinates[1], cross));
+      for (i = 0; i < 8; i++) {
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices, i,
+                                      coordinates[i]);
+      }
+      return t8_forest_element_hex_volume (coordinates);
     }
   case T8_ECLASS_PRISM:
-
     {
-      /* We divide the prism into 3 tetrahdra and compute their
-       * volumes. */
-      double              coordinates[4][3], volume;
-
-      /* The first tetrahedron has prism vertices 0, 1, 2, and 4 */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 1,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[3]);
-      volume = t8_forest_element_tet_volume (coordinates);
-
-      /* The second tetrahedron has prism vertices 0, 2, 3, and 4 */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 0,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 3,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[3]);
-      volume += t8_forest_element_tet_volume (coordinates);
-
-      /* The third tetrahedron has prism vertices 2, 3, 4, and 5 */
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 2,
-                                    coordinates[0]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 3,
-                                    coordinates[1]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 4,
-                                    coordinates[2]);
-      t8_forest_element_coordinate (forest, ltreeid, element, vertices, 5,
-                                    coordinates[3]);
-      volume += t8_forest_element_tet_volume (coordinates);
-
-      return volume;
+      double              coordinates[6][3];
+      int                 i;
+
+      if (t8_forest_tree_is_affine (eclass, vertices)) {
+        /* The element is a straight prism over its bottom triangle,
+         * its volume is half the determinant of two triangle edges
+         * and the height vector */
+        for (i = 0; i < 4; i++) {
+          t8_forest_element_coordinate (forest, ltreeid, element, vertices,
+                                        i, coordinates[i]);
+        }
+        return 0.5 * fabs (t8_forest_triple_product (coordinates[0],
+                                                     coordinates[1],
+                                                     coordinates[2],
+                                                     coordinates[3]));
+      }
+      for (i = 0; i < 6; i++) {
+        t8_forest_element_coordinate (forest, ltreeid, element, vertices, i,
+                                      coordinates[i]);
+      }
+      return t8_forest_element_prism_volume (coordinates);
     }
   default:
     SC_ABORT_NOT_REACHED ();
@@ -636,9 +1672,20 @@ t8_forest_element_face_area (t8_forest_t forest, t8_locidx_t ltreeid,
 
   t8_eclass_t         eclass, face_class;
   t8_eclass_scheme_c *ts;
+  t8_locidx_t         index;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
+  index = t8_forest_geometry_cache_index (forest, ltreeid, element);
+  if (index >= 0) {
+    /* The face area is cached */
+    return t8_forest_geometry_cache_value (forest->geometry_cache->face_area,
+                                           forest->geometry_cache->
+                                           face_area_float,
+                                           forest->geometry_cache->
+                                           face_offsets[index] + face);
+  }
+
   /* get the eclass of the forest */
   eclass = t8_forest_get_tree_class (forest, ltreeid);
   /* get the element's scheme and the face scheme */
@@ -807,8 +1854,24 @@ t8_forest_element_face_normal (t8_forest_t forest, t8_locidx_t ltreeid,
 {
   t8_eclass_t         eclass, face_class;
   t8_eclass_scheme_c *ts;
+  t8_locidx_t         index;
+  int                 i;
 
   T8_ASSERT (t8_forest_is_committed (forest));
+
+  index = t8_forest_geometry_cache_index (forest, ltreeid, element);
+  if (index >= 0 && forest->geometry_cache->has_normals) {
+    /* The face normal is cached */
+    index = forest->geometry_cache->face_offsets[index] + face;
+    for (i = 0; i < 3; i++) {
+      normal[i] =
+        t8_forest_geometry_cache_value (forest->geometry_cache->face_normal
+                                        [i],
+                                        forest->geometry_cache->
+                                        face_normal_float[i], index);
+    }
+    return;
+  }
   /* get the eclass of the forest */
   eclass = t8_forest_get_tree_class (forest, ltreeid);
   /* get the element's scheme and the face scheme */
@@ -939,6 +2002,258 @@ t8_forest_element_face_normal (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* The maximal number of distinct corners of a face together with the
+ * corners of its face children. A quad face and its four children
+ * share 9 points. */
+#define T8_FOREST_FACE_MAX_POINTS 9
+
+/* A small table of the corners of a face and its face children,
+ * such that every point is mapped into the tree only once. */
+typedef struct
+{
+  int                 num_points;
+  int                 coords[T8_FOREST_FACE_MAX_POINTS][3];
+  double              xyz[T8_FOREST_FACE_MAX_POINTS][3];
+} t8_forest_face_points_t;
+
+/* Copy the coordinates of a corner of an element to xyz.
+ * If the corner is already in the table we reuse its coordinates,
+ * otherwise we compute them and add them to the table. */
+static void
+t8_forest_face_point (t8_forest_t forest, t8_locidx_t ltreeid,
+                      t8_eclass_scheme_c * ts, const double *vertices,
+                      double len, const t8_element_t * element, int corner,
+                      t8_forest_face_points_t * points, double xyz[3])
+{
+  int                 coords[3];
+  int                 ipoint, i, dim;
+
+  dim = t8_eclass_to_dimension[ts->eclass];
+  coords[0] = coords[1] = coords[2] = 0;
+  ts->t8_element_vertex_coords (element, corner, coords);
+  for (ipoint = 0; ipoint < points->num_points; ipoint++) {
+    for (i = 0; i < dim; i++) {
+      if (points->coords[ipoint][i] != coords[i]) {
+        break;
+      }
+    }
+    if (i == dim) {
+      /* We already computed this point */
+      t8_vec_axb (points->xyz[ipoint], xyz, 1, 0);
+      return;
+    }
+  }
+  T8_ASSERT (points->num_points < T8_FOREST_FACE_MAX_POINTS);
+  ipoint = points->num_points++;
+  for (i = 0; i < 3; i++) {
+    points->coords[ipoint][i] = coords[i];
+  }
+  t8_forest_tree_coordinate (forest, ltreeid, ts->eclass, vertices, coords,
+                             len, points->xyz[ipoint]);
+  t8_vec_axb (points->xyz[ipoint], xyz, 1, 0);
+}
+
+/* Compute area, centroid and normal of a face from the coordinates of
+ * its corners, using the same formulas as t8_forest_element_face_area,
+ * t8_forest_element_face_centroid and t8_forest_element_face_normal.
+ * center is a point inside the element at which the normal is oriented
+ * outwards. Each of area, centroid and normal may be NULL. */
+static void
+t8_forest_face_geometry_from_corners (t8_eclass_t face_class,
+                                      double corners[4][3],
+                                      const double center[3], double *area,
+                                      double *centroid, double *normal)
+{
+  double              triangle[3][3], diff[3];
+  double              norm, c_n;
+  int                 i, num_corners;
+
+  num_corners = t8_eclass_num_vertices[face_class];
+  if (centroid != NULL) {
+    /* The centroid is the average of the corners */
+    t8_vec_axb (corners[0], centroid, 1, 0);
+    for (i = 1; i < num_corners; i++) {
+      t8_vec_axpy (corners[i], centroid, 1);
+    }
+    t8_vec_ax (centroid, 1. / num_corners);
+  }
+
+  switch (face_class) {
+  case T8_ECLASS_VERTEX:
+    /* vertices do not have volume */
+    if (area != NULL) {
+      *area = 0;
+    }
+    /* TODO: normal of a line */
+    T8_ASSERT (normal == NULL);
+    break;
+  case T8_ECLASS_LINE:
+    if (area != NULL) {
+      *area = t8_vec_dist (corners[0], corners[1]);
+    }
+    if (normal != NULL) {
+      double              vb_vb, c_vb;
+
+      /* N = C - <C,V>/<V,V> V with V = V_b - V_a and C = center - V_a,
+       * see t8_forest_element_face_normal */
+      t8_vec_axpyz (corners[0], corners[1], triangle[1], -1);
+      t8_vec_axpyz (corners[0], center, diff, -1);
+      vb_vb = t8_vec_dot (triangle[1], triangle[1]);
+      c_vb = t8_vec_dot (diff, triangle[1]);
+      t8_vec_axpyz (triangle[1], diff, normal, -1 * c_vb / vb_vb);
+      norm = t8_vec_norm (normal);
+      T8_ASSERT (norm != 0);
+      c_n = t8_vec_dot (diff, normal);
+      /* If N*C > 0 then N points inwards, so we have to reverse it */
+      if (c_n > 0) {
+        norm *= -1;
+      }
+      t8_vec_ax (normal, 1. / norm);
+    }
+    break;
+  case T8_ECLASS_TRIANGLE:
+  case T8_ECLASS_QUAD:
+    if (area != NULL) {
+      /* A quad face is divided into the triangles 0, 1, 2 and 1, 2, 3 */
+      *area = 0;
+      for (i = 0; i < num_corners - 2; i++) {
+        t8_vec_axb (corners[i], triangle[0], 1, 0);
+        t8_vec_axb (corners[i + 1], triangle[1], 1, 0);
+        t8_vec_axb (corners[i + 2], triangle[2], 1, 0);
+        *area += t8_forest_element_triangle_area (triangle);
+      }
+    }
+    if (normal != NULL) {
+      /* The normal of the triangle spanned by the corners 0, 1 and 2 */
+      t8_vec_axpyz (corners[0], corners[1], triangle[1], -1);
+      t8_vec_axpyz (corners[0], corners[2], triangle[2], -1);
+      t8_vec_cross (triangle[1], triangle[2], normal);
+      norm = t8_vec_norm (normal);
+      T8_ASSERT (norm != 0);
+      t8_vec_axpyz (corners[0], center, diff, -1);
+      c_n = t8_vec_dot (diff, normal);
+      /* if c_n is positiv, the computed normal points inwards, so we have to reverse it */
+      if (c_n > 0) {
+        norm = -norm;
+      }
+      t8_vec_ax (normal, 1. / norm);
+    }
+    break;
+  default:
+    SC_ABORT ("Not implemented.\n");
+  }
+}
+
+/* Compute area, centroid and normal of a face of an element whose
+ * centroid center is known, adding its corners to points. */
+static void
+t8_forest_face_geometry_points (t8_forest_t forest, t8_locidx_t ltreeid,
+                                t8_eclass_scheme_c * ts,
+                                const t8_element_t * element, int face,
+                                const double *vertices, double len,
+                                const double center[3],
+                                t8_forest_face_points_t * points,
+                                double *area, double *centroid,
+                                double *normal)
+{
+  double              corners[4][3];
+  t8_eclass_t         face_class;
+  int                 i, num_corners;
+
+  face_class = ts->t8_element_face_class (element, face);
+  num_corners = t8_eclass_num_vertices[face_class];
+  for (i = 0; i < num_corners; i++) {
+    t8_forest_face_point (forest, ltreeid, ts, vertices, len, element,
+                          ts->t8_element_get_face_corner (element, face, i),
+                          points, corners[i]);
+  }
+  t8_forest_face_geometry_from_corners (face_class, corners, center, area,
+                                        centroid, normal);
+}
+
+void
+t8_forest_element_face_geometry (t8_forest_t forest, t8_locidx_t ltreeid,
+                                 const t8_element_t * element, int face,
+                                 const double *vertices, double *area,
+                                 double centroid[3], double normal[3])
+{
+  t8_eclass_scheme_c *ts;
+  t8_forest_face_points_t points;
+  double              center[3];
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  if (normal != NULL) {
+    /* The normal is oriented away from the centroid of element */
+    T8_ASSERT (t8_eclass_to_dimension[ts->eclass] >= 2);
+    t8_forest_element_centroid (forest, ltreeid, element, vertices, center);
+  }
+  points.num_points = 0;
+  t8_forest_face_geometry_points (forest, ltreeid, ts, element, face,
+                                  vertices,
+                                  1. / ts->t8_element_root_len (element),
+                                  center, &points, area, centroid, normal);
+}
+
+int
+t8_forest_element_face_geometry_children (t8_forest_t forest,
+                                          t8_locidx_t ltreeid,
+                                          const t8_element_t * element,
+                                          int face, const double *vertices,
+                                          double *area, double *centroid,
+                                          double *normal)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t      **children;
+  t8_forest_face_points_t points;
+  double              center[3], len;
+  int                 num_children, ichild, child_face;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  num_children = ts->t8_element_num_face_children (element, face);
+  len = 1. / ts->t8_element_root_len (element);
+  points.num_points = 0;
+
+  if (normal != NULL) {
+    /* All normals are oriented away from the centroid of element */
+    T8_ASSERT (t8_eclass_to_dimension[ts->eclass] >= 2);
+    t8_forest_element_centroid (forest, ltreeid, element, vertices, center);
+  }
+
+  /* The coarse face */
+  t8_forest_face_geometry_points (forest, ltreeid, ts, element, face,
+                                  vertices, len, center, &points, area,
+                                  centroid, normal);
+
+  /* The face children, they share their corners with each other
+   * and with the coarse face */
+  children = T8_ALLOC (t8_element_t *, num_children);
+  ts->t8_element_new (num_children, children);
+  ts->t8_element_children_at_face (element, face, children, num_children,
+                                   NULL);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    child_face = ts->t8_element_face_child_face (element, face, ichild);
+    T8_ASSERT (ts->t8_element_face_class (children[ichild], child_face)
+               == ts->t8_element_face_class (element, face));
+    t8_forest_face_geometry_points (forest, ltreeid, ts, children[ichild],
+                                    child_face, vertices, len, center,
+                                    &points,
+                                    area != NULL ? area + ichild + 1 : NULL,
+                                    centroid != NULL ?
+                                    centroid + 3 * (ichild + 1) : NULL,
+                                    normal != NULL ?
+                                    normal + 3 * (ichild + 1) : NULL);
+  }
+  ts->t8_element_destroy (num_children, children);
+  T8_FREE (children);
+  return num_children;
+}
+
 /* For each tree in a forest compute its first and last descendant */
 void
 t8_forest_compute_desc (t8_forest_t forest)
@@ -972,7 +2287,52 @@ t8_forest_compute_desc (t8_forest_t forest)
     /* calculate the last descendant of the first element */
     ts->t8_element_last_descendant (element, itree->last_desc,
                                     forest->maxlevel);
+    /* Store their linear ids for the range tests of
+     * t8_forest_element_has_leaf_desc */
+    itree->first_desc_id =
+      ts->t8_element_get_linear_id (itree->first_desc, forest->maxlevel);
+    itree->last_desc_id =
+      ts->t8_element_get_linear_id (itree->last_desc, forest->maxlevel);
+  }
+}
+
+/* The minimum number of elements that one thread fills in
+ * t8_forest_populate_elements. */
+#define T8_FOREST_POPULATE_MIN_PER_THREAD 65536
+
+/* Fill an element array of num_elements elements with the elements of
+ * a uniform refinement of the given level, starting at linear id first_id.
+ * If OpenMP is enabled and the array is large enough, the array is split
+ * into chunks of consecutive elements that are filled concurrently. */
+static void
+t8_forest_populate_elements (t8_eclass_scheme_c * ts,
+                             t8_element_array_t * telements, int level,
+                             t8_linearidx_t first_id, t8_locidx_t num_elements)
+{
+#ifdef T8_ENABLE_OPENMP
+  int                 num_chunks, ichunk;
+  t8_locidx_t         chunk_begin, chunk_end;
+
+  num_chunks = SC_MIN (t8_get_num_threads (),
+                       num_elements / T8_FOREST_POPULATE_MIN_PER_THREAD);
+  if (num_chunks > 1) {
+#pragma omp parallel for num_threads (num_chunks) private (chunk_begin, chunk_end)
+    for (ichunk = 0; ichunk < num_chunks; ichunk++) {
+      chunk_begin = (t8_locidx_t) (((int64_t) num_elements * ichunk)
+                                   / num_chunks);
+      chunk_end = (t8_locidx_t) (((int64_t) num_elements * (ichunk + 1))
+                                 / num_chunks);
+      ts->t8_element_set_linear_id_range (t8_element_array_index_locidx
+                                          (telements, chunk_begin), level,
+                                          first_id + chunk_begin,
+                                          chunk_end - chunk_begin);
+    }
+    return;
   }
+#endif
+  ts->t8_element_set_linear_id_range (t8_element_array_index_locidx
+                                      (telements, 0), level, first_id,
+                                      num_elements);
 }
 
 /* Create the elements on this process given a uniform partition
@@ -986,9 +2346,8 @@ t8_forest_populate (t8_forest_t forest)
   t8_locidx_t         num_tree_elements;
   t8_locidx_t         num_local_trees;
   t8_gloidx_t         jt, first_ctree;
-  t8_gloidx_t         start, end, et;
+  t8_gloidx_t         start, end;
   t8_tree_t           tree;
-  t8_element_t       *element, *element_succ;
   t8_element_array_t *telements;
   t8_eclass_t         tree_class;
   t8_eclass_scheme_c *eclass_scheme;
@@ -1055,25 +2414,448 @@ t8_forest_populate (t8_forest_t forest)
       /* Allocate elements for this processor. */
       t8_element_array_init_size (telements, eclass_scheme,
                                   num_tree_elements);
-      element = t8_element_array_index_locidx (telements, 0);
-      eclass_scheme->t8_element_set_linear_id (element, forest->set_level,
-                                               start);
-      count_elements++;
-      for (et = start + 1; et < end; et++, count_elements++) {
-        element_succ = t8_element_array_index_locidx (telements, et - start);
-        eclass_scheme->t8_element_successor (element, element_succ,
-                                             forest->set_level);
-        /* TODO: process elements here */
-        element = element_succ;
-      }
+      /* Fill the elements of this tree at once */
+      t8_forest_populate_elements (eclass_scheme, telements,
+                                   forest->set_level, start,
+                                   num_tree_elements);
+      count_elements += num_tree_elements;
     }
   }
   forest->local_num_elements = count_elements;
-  /* TODO: if no tree has pyramid type we can optimize this to
-   * global_num_elements = global_num_trees * 2^(dim*level)
-   */
-  t8_forest_comm_global_num_elements (forest);
-  /* TODO: figure out global_first_position, global_first_quadrant without comm */
+  /* Since t8_cmesh_uniform_bounds does not support pyramids for level > 0,
+   * each tree has 2^(dim*level) elements and we do not need to communicate
+   * to get the global number of elements. */
+  forest->global_num_elements = t8_cmesh_get_num_trees (forest->cmesh)
+    * (((t8_gloidx_t) 1) << forest->dimension * forest->set_level);
+#ifdef T8_ENABLE_DEBUG
+  {
+    t8_gloidx_t         global_num_elements;
+
+    global_num_elements = forest->global_num_elements;
+    t8_forest_comm_global_num_elements (forest);
+    T8_ASSERT (global_num_elements == forest->global_num_elements);
+  }
+#endif
+  /* The partition offsets are known analytically as well */
+  t8_forest_partition_create_uniform_offsets (forest, forest->set_level);
+}
+
+void
+t8_forest_leaves_build_trees (t8_forest_t forest)
+{
+  const t8_forest_set_leaves_t *leaves = forest->set_leaves;
+  t8_gloidx_t         cmesh_first_tree, gtree;
+  t8_locidx_t         num_cmesh_trees, num_trees, itree;
+  t8_locidx_t         ileaf, irun, tree_begin, tree_end;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  int                 level;
+
+  T8_ASSERT (forest != NULL && !forest->committed);
+  T8_ASSERT (leaves != NULL);
+  T8_ASSERT (forest->cmesh != NULL && forest->scheme_cxx != NULL);
+
+  forest->local_num_elements = leaves->num_leaves;
+  /* The global number of elements is computed in commit */
+  forest->global_num_elements = -1;
+  if (leaves->num_leaves == 0) {
+    /* This process is empty */
+    forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
+    forest->first_local_tree = 0;
+    forest->last_local_tree = -1;
+    return;
+  }
+  cmesh_first_tree = t8_cmesh_get_first_treeid (forest->cmesh);
+  num_cmesh_trees = t8_cmesh_get_num_local_trees (forest->cmesh);
+  forest->first_local_tree = leaves->trees[0];
+  forest->last_local_tree = leaves->trees[leaves->num_leaves - 1];
+  SC_CHECK_ABORT (cmesh_first_tree <= forest->first_local_tree
+                  && forest->last_local_tree <
+                  cmesh_first_tree + num_cmesh_trees,
+                  "The trees of the leaves are not local in the cmesh");
+  num_trees = forest->last_local_tree - forest->first_local_tree + 1;
+  forest->trees = sc_array_new_count (sizeof (t8_tree_struct_t), num_trees);
+
+  for (itree = 0, tree_begin = 0; itree < num_trees; itree++) {
+    gtree = forest->first_local_tree + itree;
+    /* The leaves of this tree */
+    for (tree_end = tree_begin; tree_end < leaves->num_leaves
+         && leaves->trees[tree_end] == gtree; tree_end++) {
+    }
+    SC_CHECK_ABORT (tree_begin < tree_end,
+                    "The leaves are not sorted or a local tree has no leaf");
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    tree->eclass = t8_cmesh_get_tree_class (forest->cmesh,
+                                            gtree - cmesh_first_tree);
+    tree->elements_offset = tree_begin;
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    T8_ASSERT (ts != NULL);
+    t8_forest_init_tree_elements (forest, &tree->elements, ts,
+                                  tree_end - tree_begin);
+    /* Leaves of the same level with consecutive ids are set in one call */
+    for (ileaf = tree_begin; ileaf < tree_end; ileaf = irun) {
+      level = leaves->levels[ileaf];
+      SC_CHECK_ABORT (0 <= level && level <= forest->maxlevel,
+                      "Invalid level of a leaf");
+      for (irun = ileaf + 1; irun < tree_end && leaves->levels[irun] == level
+           && leaves->ids[irun] == leaves->ids[ileaf] + (irun - ileaf);
+           irun++) {
+      }
+      ts->t8_element_set_linear_id_range (t8_element_array_index_locidx
+                                          (&tree->elements,
+                                           ileaf - tree_begin), level,
+                                          leaves->ids[ileaf], irun - ileaf);
+    }
+#ifdef T8_ENABLE_DEBUG
+    {
+      t8_element_t       *desc, *next_desc;
+      t8_locidx_t         ielem;
+
+      /* The leaves of a tree must be ordered and must not overlap */
+      ts->t8_element_new (1, &desc);
+      ts->t8_element_new (1, &next_desc);
+      for (ielem = 1; ielem < tree_end - tree_begin; ielem++) {
+        ts->t8_element_last_descendant (t8_element_array_index_locidx
+                                        (&tree->elements, ielem - 1), desc,
+                                        forest->maxlevel);
+        ts->t8_element_first_descendant (t8_element_array_index_locidx
+                                         (&tree->elements, ielem), next_desc,
+                                         forest->maxlevel);
+        T8_ASSERT (ts->t8_element_compare (desc, next_desc) < 0);
+      }
+      ts->t8_element_destroy (1, &desc);
+      ts->t8_element_destroy (1, &next_desc);
+    }
+#endif
+    tree_begin = tree_end;
+  }
+  SC_CHECK_ABORT (tree_begin == leaves->num_leaves,
+                  "The leaves are not sorted by their trees");
+}
+
+/* Append a leaf to the leaf arrays of t8_forest_new_from_levels. */
+static void
+t8_forest_leaves_push (sc_array_t * trees, sc_array_t * ids,
+                       sc_array_t * levels, t8_gloidx_t gtree,
+                       t8_linearidx_t id, int level)
+{
+  *(t8_gloidx_t *) sc_array_push (trees) = gtree;
+  *(t8_linearidx_t *) sc_array_push (ids) = id;
+  *(int *) sc_array_push (levels) = level;
+}
+
+t8_forest_t
+t8_forest_new_from_levels (t8_forest_t forest_from, const int *target_levels,
+                           int do_face_ghost)
+{
+  t8_forest_t         forest;
+  t8_locidx_t         itree, num_trees, ielem, irun, num_elements;
+  t8_locidx_t         offset;
+  t8_gloidx_t         gtree;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element, *run_element;
+  t8_element_t       *ancestor, *desc, *run_desc;
+  t8_linearidx_t      id, last_id, ancestor_id;
+  sc_array_t          trees, ids, levels;
+  int                 level, target, maxlevel;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (target_levels != NULL
+             || t8_forest_get_num_element (forest_from) == 0);
+
+  sc_array_init (&trees, sizeof (t8_gloidx_t));
+  sc_array_init (&ids, sizeof (t8_linearidx_t));
+  sc_array_init (&levels, sizeof (int));
+  maxlevel = forest_from->maxlevel;
+  num_trees = t8_forest_get_num_local_trees (forest_from);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest_from, itree);
+    gtree = forest_from->first_local_tree + itree;
+    ts = forest_from->scheme_cxx->eclass_schemes[tree->eclass];
+    num_elements = t8_element_array_get_count (&tree->elements);
+    offset = tree->elements_offset;
+    ts->t8_element_new (1, &ancestor);
+    ts->t8_element_new (1, &desc);
+    ts->t8_element_new (1, &run_desc);
+    for (ielem = 0; ielem < num_elements; ielem = irun) {
+      element = t8_element_array_index_locidx (&tree->elements, ielem);
+      level = ts->t8_element_level (element);
+      target = SC_MIN (SC_MAX (target_levels[offset + ielem], 0), maxlevel);
+      irun = ielem + 1;
+      if (target >= level) {
+        /* Keep or refine the element, its descendants of the target level
+         * are consecutive in the uniform refinement of that level */
+        ts->t8_element_first_descendant (element, desc, target);
+        ts->t8_element_last_descendant (element, run_desc, target);
+        last_id = ts->t8_element_get_linear_id (run_desc, target);
+        for (id = ts->t8_element_get_linear_id (desc, target);
+             id <= last_id; id++) {
+          t8_forest_leaves_push (&trees, &ids, &levels, gtree, id, target);
+        }
+        continue;
+      }
+      /* Coarsen to the ancestor of the target level if all of its local
+       * descendants in this tree want to be at most this fine */
+      ancestor_id = ts->t8_element_get_linear_id (element, target);
+      while (irun < num_elements) {
+        run_element = t8_element_array_index_locidx (&tree->elements, irun);
+        if (ts->t8_element_level (run_element) <= target
+            || target_levels[offset + irun] > target
+            || ts->t8_element_get_linear_id (run_element, target)
+            != ancestor_id) {
+          break;
+        }
+        irun++;
+      }
+      ts->t8_element_set_linear_id (ancestor, target, ancestor_id);
+      ts->t8_element_first_descendant (ancestor, desc, maxlevel);
+      ts->t8_element_first_descendant (element, run_desc, maxlevel);
+      if (ts->t8_element_compare (desc, run_desc) == 0) {
+        ts->t8_element_last_descendant (ancestor, desc, maxlevel);
+        ts->t8_element_last_descendant (t8_element_array_index_locidx
+                                        (&tree->elements, irun - 1),
+                                        run_desc, maxlevel);
+      }
+      if (ts->t8_element_compare (desc, run_desc) == 0) {
+        t8_forest_leaves_push (&trees, &ids, &levels, gtree, ancestor_id,
+                               target);
+      }
+      else {
+        /* The ancestor is not covered by local elements, for example
+         * because it is split across processes, we keep the element */
+        t8_forest_leaves_push (&trees, &ids, &levels, gtree,
+                               ts->t8_element_get_linear_id (element, level),
+                               level);
+        irun = ielem + 1;
+      }
+    }
+    ts->t8_element_destroy (1, &ancestor);
+    ts->t8_element_destroy (1, &desc);
+    ts->t8_element_destroy (1, &run_desc);
+  }
+
+  t8_forest_init (&forest);
+  t8_cmesh_ref (forest_from->cmesh);
+  t8_forest_set_cmesh (forest, forest_from->cmesh, forest_from->mpicomm);
+  t8_scheme_cxx_ref (forest_from->scheme_cxx);
+  t8_forest_set_scheme (forest, forest_from->scheme_cxx);
+  t8_forest_set_leaves (forest, (t8_locidx_t) trees.elem_count,
+                        (const t8_gloidx_t *) trees.array,
+                        (const t8_linearidx_t *) ids.array,
+                        (const int *) levels.array);
+  if (do_face_ghost) {
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  }
+  t8_forest_commit (forest);
+  t8_forest_unref (&forest_from);
+  sc_array_reset (&trees);
+  sc_array_reset (&ids);
+  sc_array_reset (&levels);
+
+  return forest;
+}
+
+/* The number of candidate thresholds that are tested in each round of
+ * t8_forest_adapt_budget_thresholds and the number of rounds. Each round
+ * narrows the search interval by this number of candidates. */
+#define T8_FOREST_BUDGET_NUM_CANDIDATES 64
+#define T8_FOREST_BUDGET_ROUNDS 4
+
+/* Add to delta[k] the predicted local change of the number of elements if
+ * the elements with an indicator above the candidate lo + k * step are
+ * refined and the elements below coarsen_fraction times it are coarsened.
+ * Each refined element adds num_children - 1 elements and each coarsened
+ * element removes (num_children - 1) / num_children elements. */
+static void
+t8_forest_budget_count (t8_forest_t forest, const double *indicators,
+                        double coarsen_fraction, double lo, double step,
+                        double *delta)
+{
+  const int           num_candidates = T8_FOREST_BUDGET_NUM_CANDIDATES;
+  t8_locidx_t         itree, num_trees, ielem, num_elements, offset;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  double              refine_diff[T8_FOREST_BUDGET_NUM_CANDIDATES + 1];
+  double              coarsen_diff[T8_FOREST_BUDGET_NUM_CANDIDATES + 1];
+  double              value, refine_sum, coarsen_sum;
+  int                 k, level, num_children;
+
+  memset (refine_diff, 0, sizeof (refine_diff));
+  memset (coarsen_diff, 0, sizeof (coarsen_diff));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    num_elements = t8_element_array_get_count (&tree->elements);
+    offset = tree->elements_offset;
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      element = t8_element_array_index_locidx (&tree->elements, ielem);
+      level = ts->t8_element_level (element);
+      num_children = ts->t8_element_num_children (element);
+      value = indicators[offset + ielem];
+      if (level < forest->maxlevel) {
+        /* The element is refined for all candidates k < its value */
+        if (step > 0) {
+          k = (int) SC_MAX (0, SC_MIN (ceil ((value - lo) / step),
+                                       num_candidates));
+        }
+        else {
+          k = value > lo ? num_candidates : 0;
+        }
+        refine_diff[0] += num_children - 1;
+        refine_diff[k] -= num_children - 1;
+      }
+      if (level > 0 && coarsen_fraction > 0) {
+        /* The element is coarsened for all candidates k with
+         * coarsen_fraction * candidate > its value */
+        value /= coarsen_fraction;
+        if (step > 0) {
+          k = (int) SC_MAX (0, SC_MIN (floor ((value - lo) / step) + 1,
+                                       num_candidates));
+        }
+        else {
+          k = value < lo ? 0 : num_candidates;
+        }
+        coarsen_diff[k] += (num_children - 1) / (double) num_children;
+      }
+    }
+  }
+  for (k = 0, refine_sum = coarsen_sum = 0; k < num_candidates; k++) {
+    refine_sum += refine_diff[k];
+    coarsen_sum += coarsen_diff[k];
+    delta[k] = refine_sum - coarsen_sum;
+  }
+}
+
+double
+t8_forest_adapt_budget_thresholds (t8_forest_t forest,
+                                   const double *indicators,
+                                   t8_gloidx_t target_num_elements,
+                                   double coarsen_fraction,
+                                   double *refine_threshold,
+                                   double *coarsen_threshold)
+{
+  const int           num_candidates = T8_FOREST_BUDGET_NUM_CANDIDATES;
+  double              local_delta[T8_FOREST_BUDGET_NUM_CANDIDATES];
+  double              delta[T8_FOREST_BUDGET_NUM_CANDIDATES];
+  double              bounds[2], global_bounds[2];
+  double              lo, hi, step, threshold, predicted;
+  t8_locidx_t         ielem, num_elements;
+  int                 mpiret, iround, k;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= coarsen_fraction && coarsen_fraction <= 1);
+  T8_ASSERT (refine_threshold != NULL && coarsen_threshold != NULL);
+
+  /* Compute the global range of the indicators, the minimum is
+   * negated to use a single reduction */
+  num_elements = t8_forest_get_num_element (forest);
+  bounds[0] = -HUGE_VAL;
+  bounds[1] = 0;
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    T8_ASSERT (indicators[ielem] >= 0);
+    bounds[0] = SC_MAX (bounds[0], -indicators[ielem]);
+    bounds[1] = SC_MAX (bounds[1], indicators[ielem]);
+  }
+  mpiret = sc_MPI_Allreduce (bounds, global_bounds, 2, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  lo = -global_bounds[0];
+  hi = global_bounds[1];
+  if (coarsen_fraction > 0 && hi > 0) {
+    /* Above hi / coarsen_fraction each element is coarsened */
+    hi /= coarsen_fraction;
+  }
+  lo = SC_MIN (lo, hi);
+
+  /* Narrow the interval that contains the smallest threshold for which the
+   * predicted number of elements does not exceed the target. The predicted
+   * number of elements decreases with the threshold. */
+  threshold = hi;
+  predicted = (double) forest->global_num_elements;
+  for (iround = 0; iround < T8_FOREST_BUDGET_ROUNDS; iround++) {
+    step = (hi - lo) / (num_candidates - 1);
+    t8_forest_budget_count (forest, indicators, coarsen_fraction, lo, step,
+                            local_delta);
+    mpiret = sc_MPI_Allreduce (local_delta, delta, num_candidates,
+                               sc_MPI_DOUBLE, sc_MPI_SUM, forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    for (k = 0; k < num_candidates - 1 &&
+         forest->global_num_elements + delta[k] > target_num_elements; k++) {
+    }
+    threshold = lo + k * step;
+    predicted = forest->global_num_elements + delta[k];
+    if (k == 0 || step <= 0) {
+      /* The target is reached with the smallest candidate */
+      break;
+    }
+    hi = threshold;
+    lo = threshold - step;
+  }
+  *refine_threshold = threshold;
+  *coarsen_threshold = coarsen_fraction * threshold;
+  t8_global_productionf ("Budget adaptation threshold %g with %.0f predicted"
+                         " elements for a target of %lli.\n", threshold,
+                         predicted, (long long) target_num_elements);
+  return predicted;
+}
+
+/* The thresholds of t8_forest_new_adapt_budget, passed as user data */
+typedef struct
+{
+  const double       *indicators;
+  double              refine_threshold;
+  double              coarsen_threshold;
+} t8_forest_budget_data_t;
+
+/* Refine the elements above the refine threshold and coarsen the families
+ * that are all below the coarsen threshold. */
+static int
+t8_forest_budget_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                        t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                        t8_eclass_scheme_c * ts, int num_elements,
+                        t8_element_t * elements[])
+{
+  const t8_forest_budget_data_t *data =
+    (const t8_forest_budget_data_t *) t8_forest_get_user_data (forest);
+  const double       *values = data->indicators +
+    t8_forest_get_tree_element_offset (forest_from, which_tree) + lelement_id;
+  int                 ielem;
+
+  if (values[0] > data->refine_threshold) {
+    return 1;
+  }
+  if (num_elements > 1) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      if (values[ielem] >= data->coarsen_threshold) {
+        return 0;
+      }
+    }
+    return -1;
+  }
+  return 0;
+}
+
+t8_forest_t
+t8_forest_new_adapt_budget (t8_forest_t forest_from, const double *indicators,
+                            t8_gloidx_t target_num_elements,
+                            double coarsen_fraction, int do_face_ghost)
+{
+  t8_forest_budget_data_t data;
+  t8_forest_t         forest;
+
+  data.indicators = indicators;
+  t8_forest_adapt_budget_thresholds (forest_from, indicators,
+                                     target_num_elements, coarsen_fraction,
+                                     &data.refine_threshold,
+                                     &data.coarsen_threshold);
+  forest = t8_forest_new_adapt (forest_from, t8_forest_budget_adapt, 0,
+                                do_face_ghost, &data);
+  /* The thresholds are only valid during the adaptation */
+  t8_forest_set_user_data (forest, NULL);
+  return forest;
 }
 
 /* return nonzero if the first tree of a forest is shared with a smaller
@@ -1178,8 +2960,8 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
     tree->eclass = fromtree->eclass;
     eclass_scheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
     num_tree_elements = t8_element_array_get_count (&fromtree->elements);
-    t8_element_array_init_size (&tree->elements, eclass_scheme,
-                                num_tree_elements);
+    t8_forest_init_tree_elements (forest, &tree->elements, eclass_scheme,
+                                  num_tree_elements);
     /* TODO: replace with t8_elem_copy (not existing yet), in order to
      * eventually copy additional pointer data stored in the elements?
      * -> i.m.o. we should not allow such pointer data at the elements */
@@ -1208,13 +2990,71 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
   }
 }
 
+void
+t8_forest_share_trees (t8_forest_t forest, t8_forest_t from)
+{
+  t8_forest_shared_elements_t *shared;
+  t8_tree_t           tree, fromtree;
+  t8_locidx_t         jt, number_of_trees;
+  t8_eclass_scheme_c *eclass_scheme;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (from != NULL);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (from->committed);
+  T8_ASSERT (forest->shared_elements == NULL);
+
+  number_of_trees = from->trees->elem_count;
+  if (from->shared_elements == NULL) {
+    /* Move the element arrays of from into a shared struct and let the
+     * trees of from view them */
+    shared = T8_ALLOC (t8_forest_shared_elements_t, 1);
+    t8_refcount_init (&shared->rc);
+    shared->num_trees = number_of_trees;
+    shared->elements = T8_ALLOC (t8_element_array_t, number_of_trees + 1);
+    for (jt = 0; jt < number_of_trees; jt++) {
+      fromtree = (t8_tree_t) t8_sc_array_index_locidx (from->trees, jt);
+      shared->elements[jt] = fromtree->elements;
+      t8_element_array_init_view (&fromtree->elements, &shared->elements[jt],
+                                  0,
+                                  t8_element_array_get_count
+                                  (&shared->elements[jt]));
+    }
+    from->shared_elements = shared;
+  }
+  shared = from->shared_elements;
+  T8_ASSERT (shared->num_trees == number_of_trees);
+  t8_refcount_ref (&shared->rc);
+  forest->shared_elements = shared;
+
+  forest->trees =
+    sc_array_new_size (sizeof (t8_tree_struct_t), number_of_trees);
+  sc_array_copy (forest->trees, from->trees);
+  for (jt = 0; jt < number_of_trees; jt++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, jt);
+    fromtree = (t8_tree_t) t8_sc_array_index_locidx (from->trees, jt);
+    eclass_scheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    t8_element_array_init_view (&tree->elements, &shared->elements[jt], 0,
+                                t8_element_array_get_count
+                                (&shared->elements[jt]));
+    /* Copy the first and last descendant */
+    eclass_scheme->t8_element_new (1, &tree->first_desc);
+    eclass_scheme->t8_element_copy (fromtree->first_desc, tree->first_desc);
+    eclass_scheme->t8_element_new (1, &tree->last_desc);
+    eclass_scheme->t8_element_copy (fromtree->last_desc, tree->last_desc);
+  }
+  forest->first_local_tree = from->first_local_tree;
+  forest->last_local_tree = from->last_local_tree;
+  forest->local_num_elements = from->local_num_elements;
+  forest->global_num_elements = from->global_num_elements;
+}
+
 /* Search for a linear element id (at forest->maxlevel) in a sorted array of
  * elements. If the element does not exist, return the largest index i
  * such that the element at position i has a smaller id than the given one.
  * If no such i exists, return -1.
  */
-/* TODO: should return t8_locidx_t */
-static t8_locidx_t
+t8_locidx_t
 t8_forest_bin_search_lower (t8_element_array_t * elements,
                             t8_linearidx_t element_id, int maxlevel)
 {
@@ -1264,7 +3104,6 @@ t8_forest_element_neighbor_eclass (t8_forest_t forest,
 {
   t8_eclass_scheme_c *ts;
   t8_tree_t           tree;
-  t8_ctree_t          coarse_tree;
   t8_eclass_t         eclass;
   int                 tree_face;
   t8_locidx_t         lcoarse_neighbor;
@@ -1283,13 +3122,20 @@ t8_forest_element_neighbor_eclass (t8_forest_t forest,
     /* If the face neighbor is not inside the tree, we have to find out the tree
      * face and the tree's face neighbor along that face. */
     tree_face = ts->t8_element_tree_face (elem, face);
+    if (forest->tree_faces != NULL) {
+      /* Read the class of the neighbor tree from the stored connection */
+      return (t8_eclass_t) forest->tree_faces[T8_ECLASS_MAX_FACES * ltreeid
+                                              + tree_face].neigh_eclass;
+    }
 
+    /* The forest is not committed yet, we read the class from the cmesh */
     cmesh = t8_forest_get_cmesh (forest);
-    /* Get the coarse tree corresponding to tree */
-    coarse_tree = t8_forest_get_coarse_tree (forest, ltreeid);
     /* Get the (coarse) local id of the tree neighbor */
-    lcoarse_neighbor = t8_cmesh_trees_get_face_neighbor (coarse_tree,
-                                                         tree_face);
+    lcoarse_neighbor =
+      t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees,
+                                            t8_forest_ltreeid_to_cmesh_ltreeid
+                                            (forest, ltreeid), tree_face,
+                                            NULL);
     T8_ASSERT (0 <= lcoarse_neighbor);
     if (lcoarse_neighbor < t8_cmesh_get_num_local_trees (cmesh)) {
       /* The tree neighbor is a local tree */
@@ -1307,6 +3153,110 @@ t8_forest_element_neighbor_eclass (t8_forest_t forest,
   }
 }
 
+/* Compute the connection of a local tree of a forest to its neighbor tree
+ * across the face tree_face from the cmesh. */
+static void
+t8_forest_tree_face_fill (t8_forest_t forest, t8_locidx_t ltreeid,
+                          int tree_face, t8_forest_tree_face_t * connection)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_eclass_t         eclass, neigh_eclass;
+  t8_locidx_t         lctree_id, lcneigh_id;
+  t8_cghost_t         ghost;
+  int8_t              ttf;
+  int                 tree_neigh_face, eclass_compare, F;
+
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  connection->neigh_tree = -1;
+  connection->neigh_eclass = (int8_t) eclass;
+  connection->boundary_eclass =
+    (int8_t) t8_eclass_face_types[eclass][tree_face];
+  /* compute coarse tree id */
+  lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
+    /* This face is a domain boundary */
+    return;
+  }
+  /* Compute the local id of the face neighbor tree and get the
+   * tree to face information of the connection. */
+  lcneigh_id = t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees,
+                                                     lctree_id, tree_face,
+                                                     &ttf);
+  /* F is needed to compute the neighbor face number and the orientation.
+   * tree_neigh_face = ttf % F
+   * or = ttf / F
+   */
+  F = t8_eclass_max_num_faces[cmesh->dimension];
+  /* compute the neighbor face */
+  tree_neigh_face = ttf % F;
+  if (lcneigh_id == lctree_id && tree_face == tree_neigh_face) {
+    /* This face is a domain boundary and there is no neighbor */
+    return;
+  }
+  /* We now compute the eclass of the neighbor tree. */
+  if (lcneigh_id < t8_cmesh_get_num_local_trees (cmesh)) {
+    /* The face neighbor is a local tree */
+    /* Get the eclass of the neighbor tree */
+    neigh_eclass = t8_cmesh_get_tree_class (cmesh, lcneigh_id);
+    connection->neigh_tree = lcneigh_id + t8_cmesh_get_first_treeid (cmesh);
+  }
+  else {
+    /* The face neighbor is a ghost tree */
+    T8_ASSERT (cmesh->num_local_trees <= lcneigh_id
+               && lcneigh_id < cmesh->num_ghosts + cmesh->num_local_trees);
+    /* Get the eclass of the neighbor tree */
+    ghost = t8_cmesh_trees_get_ghost (cmesh->trees,
+                                      lcneigh_id -
+                                      t8_cmesh_get_num_local_trees (cmesh));
+    neigh_eclass = ghost->eclass;
+    connection->neigh_tree = ghost->treeid;
+  }
+  connection->neigh_face = (int8_t) tree_neigh_face;
+  connection->neigh_eclass = (int8_t) neigh_eclass;
+  connection->orientation = (int8_t) (ttf / F);
+  /* We need to find out which face is the smaller one that is the one
+   * according to which the orientation was computed.
+   * face_a is smaller then face_b if either eclass_a < eclass_b
+   * or eclass_a = eclass_b and face_a < face_b. */
+  /* -1 eclass < neigh_eclass, 0 eclass = neigh_eclass, 1 eclass > neigh_eclass */
+  eclass_compare = t8_eclass_compare (eclass, neigh_eclass);
+  if (eclass_compare == 0) {
+    /* Check if the face of the current tree has a smaller index then
+     * the face of the neighbor tree. */
+    connection->is_smaller = tree_face <= tree_neigh_face;
+  }
+  else {
+    /* The face in the current tree is the smaller one if its class is */
+    connection->is_smaller = eclass_compare == -1;
+  }
+  connection->sign =
+    t8_eclass_face_orientation[eclass][tree_face] ==
+    t8_eclass_face_orientation[neigh_eclass][tree_neigh_face];
+}
+
+void
+t8_forest_tree_faces_compute (t8_forest_t forest)
+{
+  t8_locidx_t         num_local_trees, ltree;
+  t8_eclass_t         eclass;
+  int                 iface;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->tree_faces == NULL);
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  forest->tree_faces = T8_ALLOC_ZERO (t8_forest_tree_face_t,
+                                      T8_ECLASS_MAX_FACES * num_local_trees
+                                      + 1);
+  for (ltree = 0; ltree < num_local_trees; ltree++) {
+    eclass = t8_forest_get_tree_class (forest, ltree);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      t8_forest_tree_face_fill (forest, ltree, iface, forest->tree_faces
+                                + T8_ECLASS_MAX_FACES * ltree + iface);
+    }
+  }
+}
+
 t8_gloidx_t
 t8_forest_element_face_neighbor (t8_forest_t forest,
                                  t8_locidx_t ltreeid,
@@ -1331,126 +3281,62 @@ t8_forest_element_face_neighbor (t8_forest_t forest,
   else {
     /* The neighbor does not lie inside the current tree. The content of neigh
      * is undefined right now. */
-    t8_eclass_scheme_c *boundary_scheme, *neighbor_scheme;
-    t8_eclass_t         neigh_eclass, boundary_class;
-    t8_element_t       *face_element;
-    t8_cmesh_t          cmesh;
-    t8_locidx_t         lctree_id, lcneigh_id;
-    t8_locidx_t        *face_neighbor;
-    t8_gloidx_t         global_neigh_id;
-    t8_cghost_t         ghost;
-    int8_t             *ttf;
-    int                 tree_face, tree_neigh_face;
-    int                 is_smaller, eclass_compare;
-    int                 F, sign;
-
-    cmesh = forest->cmesh;
-    /* Get the scheme associated to the element class of the
-     * boundary element. */
+    const t8_forest_tree_face_t *connection;
+    t8_forest_tree_face_t uncached;
+    int                 tree_face;
+
     /* Compute the face of elem_tree at which the face connection is. */
     tree_face = ts->t8_element_tree_face (elem, face);
-    /* compute coarse tree id */
-    lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
-    if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
-      /* This face is a domain boundary. We do not need to continue */
-      return -1;
-    }
-    /* Get the eclass scheme for the boundary */
-    boundary_class = (t8_eclass_t) t8_eclass_face_types[eclass][tree_face];
-    boundary_scheme = t8_forest_get_eclass_scheme (forest, boundary_class);
-    /* Allocate the face element */
-    boundary_scheme->t8_element_new (1, &face_element);
-    /* Compute the face element. */
-    ts->t8_element_boundary_face (elem, face, face_element, boundary_scheme);
-    /* Get the coarse tree that contains elem.
-     * Also get the face neighbor information of the coarse tree. */
-    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees,
-                                        lctree_id, &face_neighbor, &ttf);
-    /* Compute the local id of the face neighbor tree. */
-    lcneigh_id = face_neighbor[tree_face];
-    /* F is needed to compute the neighbor face number and the orientation.
-     * tree_neigh_face = ttf % F
-     * or = ttf / F
-     */
-    F = t8_eclass_max_num_faces[cmesh->dimension];
-    /* compute the neighbor face */
-    tree_neigh_face = ttf[tree_face] % F;
-    if (lcneigh_id == lctree_id && tree_face == tree_neigh_face) {
-      /* This face is a domain boundary and there is no neighbor */
-      return -1;
-    }
-    /* We now compute the eclass of the neighbor tree. */
-    if (lcneigh_id < t8_cmesh_get_num_local_trees (cmesh)) {
-      /* The face neighbor is a local tree */
-      /* Get the eclass of the neighbor tree */
-      neigh_eclass = t8_cmesh_get_tree_class (cmesh, lcneigh_id);
-      global_neigh_id = lcneigh_id + t8_cmesh_get_first_treeid (cmesh);
+    if (forest->tree_faces != NULL) {
+      /* Use the stored connection of the tree face */
+      connection = forest->tree_faces + T8_ECLASS_MAX_FACES * ltreeid
+        + tree_face;
     }
     else {
-      /* The face neighbor is a ghost tree */
-      T8_ASSERT (cmesh->num_local_trees <= lcneigh_id
-                 && lcneigh_id < cmesh->num_ghosts + cmesh->num_local_trees);
-      /* Get the eclass of the neighbor tree */
-      ghost = t8_cmesh_trees_get_ghost (cmesh->trees,
-                                        lcneigh_id -
-                                        t8_cmesh_get_num_local_trees (cmesh));
-      neigh_eclass = ghost->eclass;
-      global_neigh_id = ghost->treeid;
-    }
-    /* We need to find out which face is the smaller one that is the one
-     * according to which the orientation was computed.
-     * face_a is smaller then face_b if either eclass_a < eclass_b
-     * or eclass_a = eclass_b and face_a < face_b. */
-    /* -1 eclass < neigh_eclass, 0 eclass = neigh_eclass, 1 eclass > neigh_eclass */
-    eclass_compare = t8_eclass_compare (eclass, neigh_eclass);
-    is_smaller = 0;
-    if (eclass_compare == -1) {
-      /* The face in the current tree is the smaller one */
-      is_smaller = 1;
-    }
-    else if (eclass_compare == 1) {
-      /* The face in the other tree is the smaller one */
-      is_smaller = 0;
+      /* The forest is not committed yet, compute it from the cmesh */
+      t8_forest_tree_face_fill (forest, ltreeid, tree_face, &uncached);
+      connection = &uncached;
     }
-    else {
-
-      T8_ASSERT (eclass_compare == 0);
-      /* Check if the face of the current tree has a smaller index then
-       * the face of the neighbor tree. */
-      is_smaller = tree_face <= tree_neigh_face;
-    }
-    /* We now transform the face element to the other tree. */
-    sign =
-      t8_eclass_face_orientation[eclass][tree_face] ==
-      t8_eclass_face_orientation[neigh_eclass][tree_neigh_face];
-    boundary_scheme->t8_element_transform_face (face_element,
-                                                face_element,
-                                                ttf[tree_face] / F, sign,
-                                                is_smaller);
-    /* And now we extrude the face to the new neighbor element */
-    neighbor_scheme = forest->scheme_cxx->eclass_schemes[neigh_eclass];
+    if (connection->neigh_tree < 0) {
+      /* This face is a domain boundary. We do not need to continue */
+      return -1;
+    }
+    /* Transform elem to the neighbor tree and extrude it there */
     *neigh_face =
-      neighbor_scheme->t8_element_extrude_face (face_element,
-                                                boundary_scheme, neigh,
-                                                tree_neigh_face);
-
-    return global_neigh_id;
+      ts->t8_element_face_neighbor_across_tree (elem, face,
+                                                forest->scheme_cxx->
+                                                eclass_schemes
+                                                [connection->boundary_eclass],
+                                                connection->orientation,
+                                                connection->sign,
+                                                connection->is_smaller,
+                                                forest->scheme_cxx->
+                                                eclass_schemes
+                                                [connection->neigh_eclass],
+                                                neigh,
+                                                connection->neigh_face);
+    return connection->neigh_tree;
   }
 }
 
-t8_gloidx_t
-t8_forest_element_half_face_neighbors (t8_forest_t forest,
-                                       t8_locidx_t ltreeid,
-                                       const t8_element_t * elem,
-                                       t8_element_t * neighs[],
-                                       t8_eclass_scheme_c *
-                                       neigh_scheme, int face, int num_neighs,
-                                       int dual_faces[])
+/* Compute the half face neighbors of elem. children_at_face must be
+ * num_neighs allocated elements of the scheme of elem, they are used
+ * as temporary storage. */
+static              t8_gloidx_t
+t8_forest_element_half_face_neighbors_core (t8_forest_t forest,
+                                            t8_locidx_t ltreeid,
+                                            const t8_element_t * elem,
+                                            t8_element_t * neighs[],
+                                            t8_eclass_scheme_c *
+                                            neigh_scheme, int face,
+                                            int num_neighs,
+                                            int dual_faces[],
+                                            t8_element_t *
+                                            children_at_face[])
 {
   t8_eclass_scheme_c *ts;
   t8_tree_t           tree;
   t8_eclass_t         eclass;
-  t8_element_t      **children_at_face;
   t8_gloidx_t         neighbor_tree = -1;
 #ifdef T8_ENABLE_DEBUG
   t8_gloidx_t         last_neighbor_tree = -1;
@@ -1470,9 +3356,6 @@ t8_forest_element_half_face_neighbors (t8_forest_t forest,
   /* The number of children of elem at face */
   T8_ASSERT (num_neighs == ts->t8_element_num_face_children (elem, face));
   num_children_at_face = num_neighs;
-  /* Allocate memory for the children of elem that share a face with face. */
-  children_at_face = T8_ALLOC (t8_element_t *, num_children_at_face);
-  ts->t8_element_new (num_children_at_face, children_at_face);
 
   /* Construct the children of elem at face
    *
@@ -1502,381 +3385,1342 @@ t8_forest_element_half_face_neighbors (t8_forest_t forest,
       /* Store the dual face */
       dual_faces[child_it] = neigh_face;
     }
-    /* For each of the neighbors, the neighbor tree must be the same. */
-    T8_ASSERT (child_it == 0 || neighbor_tree == last_neighbor_tree);
-#ifdef T8_ENABLE_DEBUG
-    last_neighbor_tree = neighbor_tree;
-#endif
+    /* For each of the neighbors, the neighbor tree must be the same. */
+    T8_ASSERT (child_it == 0 || neighbor_tree == last_neighbor_tree);
+#ifdef T8_ENABLE_DEBUG
+    last_neighbor_tree = neighbor_tree;
+#endif
+  }
+  return neighbor_tree;
+}
+
+t8_gloidx_t
+t8_forest_element_half_face_neighbors (t8_forest_t forest,
+                                       t8_locidx_t ltreeid,
+                                       const t8_element_t * elem,
+                                       t8_element_t * neighs[],
+                                       t8_eclass_scheme_c *
+                                       neigh_scheme, int face, int num_neighs,
+                                       int dual_faces[])
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t      **children_at_face;
+  t8_gloidx_t         neighbor_tree;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  /* Allocate memory for the children of elem that share a face with face. */
+  children_at_face = T8_ALLOC (t8_element_t *, num_neighs);
+  ts->t8_element_new (num_neighs, children_at_face);
+  neighbor_tree =
+    t8_forest_element_half_face_neighbors_core (forest, ltreeid, elem,
+                                                neighs, neigh_scheme, face,
+                                                num_neighs, dual_faces,
+                                                children_at_face);
+  /* Clean-up the memory */
+  ts->t8_element_destroy (num_neighs, children_at_face);
+  T8_FREE (children_at_face);
+  return neighbor_tree;
+}
+
+t8_gloidx_t
+t8_forest_element_half_face_neighbors_scratch (t8_forest_t forest,
+                                               t8_locidx_t ltreeid,
+                                               const t8_element_t * elem,
+                                               t8_element_t * neighs[],
+                                               t8_eclass_scheme_c *
+                                               neigh_scheme, int face,
+                                               int num_neighs,
+                                               int dual_faces[],
+                                               t8_element_scratch_t * scratch)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t      **children_at_face;
+  t8_element_scratch_mark_t mark;
+  t8_gloidx_t         neighbor_tree;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  /* The children at the face live in the arena until we return */
+  t8_element_scratch_mark (scratch, &mark);
+  children_at_face = (t8_element_t **)
+    t8_element_scratch_alloc (scratch, num_neighs * sizeof (t8_element_t *));
+  t8_element_scratch_new (scratch, ts, num_neighs, children_at_face);
+  neighbor_tree =
+    t8_forest_element_half_face_neighbors_core (forest, ltreeid, elem,
+                                                neighs, neigh_scheme, face,
+                                                num_neighs, dual_faces,
+                                                children_at_face);
+  t8_element_scratch_release (scratch, &mark);
+  return neighbor_tree;
+}
+
+/* Compute the leaf face neighbors of a leaf in a balanced forest.
+ * The neighbor scheme, the number of children at the face and whether the
+ * leaf is at the maximum level are computed by the caller, which also
+ * provides the memory:
+ * neighbor_leafs   num_children_at_face allocated elements of neigh_scheme.
+ * children_at_face num_children_at_face allocated elements of the leaf's
+ *                  scheme, unused if at_maxlevel.
+ * dual_faces, element_indices, owners  num_children_at_face entries each.
+ * Returns the number of neighbor leafs. If this is 1 and
+ * num_children_at_face > 1, the neighbor is stored in neighbor_leafs[0]
+ * and the other elements are unused. */
+static int
+t8_forest_leaf_face_neighbors_core (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    const t8_element_t * leaf, int face,
+                                    t8_eclass_scheme_c * neigh_scheme,
+                                    int at_maxlevel, int num_children_at_face,
+                                    t8_element_t ** neighbor_leafs,
+                                    t8_element_t ** children_at_face,
+                                    int *dual_faces,
+                                    t8_locidx_t * element_indices,
+                                    int *owners)
+{
+  t8_eclass_t         neigh_class, eclass;
+  t8_gloidx_t         gneigh_treeid;
+  t8_locidx_t         lneigh_treeid = -1;
+  t8_locidx_t         lghost_treeid = -1, element_index;
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t *element_array;
+  t8_element_t       *ancestor;
+  t8_linearidx_t      neigh_id;
+  int                 ineigh, different_owners, have_ghosts;
+
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  neigh_class =
+    t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
+  if (at_maxlevel) {
+    T8_ASSERT (num_children_at_face == 1);
+    /* Compute neighbor element and global treeid of the neighbor */
+    gneigh_treeid =
+      t8_forest_element_face_neighbor (forest, ltreeid, leaf,
+                                       neighbor_leafs[0], neigh_scheme,
+                                       face, dual_faces);
+  }
+  else {
+    /* Compute neighbor elements and global treeid of the neighbor */
+    gneigh_treeid =
+      t8_forest_element_half_face_neighbors_core (forest, ltreeid, leaf,
+                                                  neighbor_leafs,
+                                                  neigh_scheme, face,
+                                                  num_children_at_face,
+                                                  dual_faces,
+                                                  children_at_face);
+  }
+  if (gneigh_treeid < 0) {
+    /* There exists no face neighbor across this face */
+    return 0;
+  }
+  T8_ASSERT (gneigh_treeid >= 0
+             && gneigh_treeid < forest->global_num_trees);
+  /* We have computed the half face neighbor elements, we now compute their owners,
+   * if they differ, we know that the half face neighbors are the neighbor leafs.
+   * If the owners do not differ, we have to check if the neighbor leaf is their
+   * parent or grandparent. */
+  different_owners = 0;
+  have_ghosts = 0;
+  for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
+    /* At first, we check whether the current rank owns the neighbor, since
+     * this is a constant time check and it is the most common case */
+    if (t8_forest_element_check_owner (forest, neighbor_leafs[ineigh],
+                                       gneigh_treeid, neigh_class,
+                                       forest->mpirank, at_maxlevel)) {
+      owners[ineigh] = forest->mpirank;
+      /* The neighbor tree is also a local tree. we store its local treeid */
+      lneigh_treeid = t8_forest_get_local_id (forest, gneigh_treeid);
+    }
+    else {
+      owners[ineigh] =
+        t8_forest_element_find_owner (forest, gneigh_treeid,
+                                      neighbor_leafs[ineigh], neigh_class);
+      /* Store that at least one neighbor is a ghost */
+      have_ghosts = 1;
+    }
+    if (ineigh > 0) {
+      /* Check if all owners are the same for all neighbors or not */
+      different_owners = different_owners
+        || (owners[ineigh] != owners[ineigh - 1]);
+    }
+  }
+  if (have_ghosts) {
+    /* At least one neighbor is a ghost, we compute the ghost treeid of the neighbor
+     * tree. */
+    lghost_treeid =
+      t8_forest_ghost_get_ghost_treeid (forest, gneigh_treeid);
+    T8_ASSERT (lghost_treeid >= 0);
+  }
+  /* TODO: Maybe we do not need to compute the owners. It suffices to know
+   *       whether the neighbor is owned by mpirank or not. */
+
+  if (!different_owners) {
+    /* The face neighbors belong to the same process, we thus need to determine
+     * if they are leafs or their parent or grandparent. */
+    neigh_id =
+      neigh_scheme->t8_element_get_linear_id (neighbor_leafs[0],
+                                              forest->maxlevel);
+    if (owners[0] != forest->mpirank) {
+      /* The elements are ghost elements of the same owner */
+      element_array =
+        t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
+      /* Find the index in element_array of the leaf ancestor of the first neighbor.
+       * This is either the neighbor itself or its parent, or its grandparent */
+      element_index =
+        t8_forest_bin_search_lower (element_array, neigh_id,
+                                    forest->maxlevel);
+      /* Get the element */
+      ancestor =
+        t8_forest_ghost_get_element (forest, lghost_treeid, element_index);
+      /* Add the number of ghost elements on previous ghost trees and the number
+       * of local elements. */
+      element_index +=
+        t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
+      element_index += t8_forest_get_num_element (forest);
+      T8_ASSERT (forest->local_num_elements <= element_index
+                 && element_index <
+                 forest->local_num_elements +
+                 t8_forest_get_num_ghosts (forest));
+    }
+    else {
+      /* the elements are local elements */
+      element_array =
+        t8_forest_get_tree_element_array (forest, lneigh_treeid);
+      /* Find the index in element_array of the leaf ancestor of the first neighbor.
+       * This is either the neighbor itself or its parent, or its grandparent */
+      element_index =
+        t8_forest_bin_search_lower (element_array, neigh_id,
+                                    forest->maxlevel);
+      /* Get the element */
+      ancestor =
+        t8_forest_get_tree_element (t8_forest_get_tree
+                                    (forest, lneigh_treeid), element_index);
+      /* Add the element offset of this tree to the index */
+      element_index +=
+        t8_forest_get_tree_element_offset (forest, lneigh_treeid);
+    }
+    if (neigh_scheme->t8_element_compare (ancestor, neighbor_leafs[0]) < 0) {
+      /* ancestor is a real ancestor, and thus the neighbor is either the
+       * parent or grandparent of the half neighbors. we can return it and
+       * the indices. */
+      /* We need to determine the dual face */
+      if (neigh_scheme->t8_element_level (ancestor) ==
+          ts->t8_element_level (leaf)) {
+        /* The ancestor is the same-level neighbor of leaf */
+        if (!at_maxlevel) {
+          /* its dual face is the face of the parent of the first neighbor leaf */
+          dual_faces[0] =
+            neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
+                                                       dual_faces[0]);
+
+        }
+      }
+      else {
+        /* The ancestor is the parent of the parent */
+        T8_ASSERT (neigh_scheme->t8_element_level (ancestor) ==
+                   ts->t8_element_level (leaf) - 1);
+
+        dual_faces[0] =
+          neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
+                                                     dual_faces[0]);
+        if (!at_maxlevel) {
+          /* We need to compute the dual face of the grandparent. */
+          /* Construct the parent of the grand child */
+          neigh_scheme->t8_element_parent (neighbor_leafs[0],
+                                           neighbor_leafs[0]);
+          /* Compute the face id of the parent's face */
+          dual_faces[0] =
+            neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
+                                                       dual_faces[0]);
+        }
+      }
+
+      /* copy the ancestor */
+      neigh_scheme->t8_element_copy (ancestor, neighbor_leafs[0]);
+      /* set return values */
+      element_indices[0] = element_index;
+      return 1;
+    }
+  }
+  /* The leafs are the face neighbors that we are looking for. */
+  /* The face neighbors either belong to different processes and thus must be leafs
+   * in the forest, or the ancestor leaf of the first half neighbor is the half
+   * neighbor itself and thus all half neighbors must be leafs.
+   * Since the forest is balanced, we found all neighbor leafs.
+   * It remains to compute their local ids */
+  for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
+    /* Compute the linear id at maxlevel of the neighbor leaf */
+    neigh_id =
+      neigh_scheme->t8_element_get_linear_id (neighbor_leafs[ineigh],
+                                              forest->maxlevel);
+    /* Get a pointer to the element array in which the neighbor lies and search
+     * for the element's index in this array.
+     * This is either the local leaf array of the local tree or the corresponding leaf array
+     * in the ghost structure */
+    if (owners[ineigh] == forest->mpirank) {
+      /* The neighbor is a local leaf */
+      element_array =
+        t8_forest_get_tree_element_array (forest, lneigh_treeid);
+      /* Find the index of the neighbor in the array */
+      element_indices[ineigh] =
+        t8_forest_bin_search_lower (element_array, neigh_id,
+                                    forest->maxlevel);
+      T8_ASSERT (element_indices[ineigh] >= 0);
+      /* We have to add the tree's element offset to the index found to get
+       * the actual local element id */
+      element_indices[ineigh] +=
+        t8_forest_get_tree_element_offset (forest, lneigh_treeid);
+#if T8_ENABLE_DEBUG
+      /* We check whether the element is really the element at this local id */
+      {
+        t8_locidx_t         check_ltreeid;
+        t8_element_t       *check_element;
+        check_element =
+          t8_forest_get_element (forest, element_indices[ineigh],
+                                 &check_ltreeid);
+        T8_ASSERT (check_ltreeid == lneigh_treeid);
+        T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
+                                                      neighbor_leafs
+                                                      [ineigh]));
+      }
+#endif
+    }
+    else {
+      /* The neighbor is a ghost */
+      element_array =
+        t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
+      /* Find the index of the neighbor in the array */
+      element_indices[ineigh] =
+        t8_forest_bin_search_lower (element_array, neigh_id,
+                                    forest->maxlevel);
+
+#if T8_ENABLE_DEBUG
+      /* We check whether the element is really the element at this local id */
+      {
+        t8_element_t       *check_element;
+        check_element =
+          t8_forest_ghost_get_element (forest, lghost_treeid,
+                                       element_indices[ineigh]);
+        T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
+                                                      neighbor_leafs
+                                                      [ineigh]));
+      }
+#endif
+      /* Add the element offset of previous ghosts to this index */
+      element_indices[ineigh] +=
+        t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
+      /* Add the number of all local elements to this index */
+      element_indices[ineigh] += t8_forest_get_num_element (forest);
+    }
+  }                             /* End for loop over neighbor leafs */
+  return num_children_at_face;
+}
+
+/* Compute the number of half face neighbors of a leaf, or 1 if the leaf
+ * is at the maximum level, and the scheme of the neighbors */
+static int
+t8_forest_leaf_face_neighbors_count (t8_forest_t forest, t8_locidx_t ltreeid,
+                                     const t8_element_t * leaf, int face,
+                                     t8_eclass_scheme_c ** pneigh_scheme,
+                                     int *at_maxlevel)
+{
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         neigh_class;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  neigh_class =
+    t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
+  *pneigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+  *at_maxlevel =
+    ts->t8_element_level (leaf) == t8_forest_get_maxlevel (forest);
+  return *at_maxlevel ? 1 : ts->t8_element_num_face_children (leaf, face);
+}
+
+void
+t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
+                               const t8_element_t * leaf,
+                               t8_element_t ** pneighbor_leafs[],
+                               int face, int *dual_faces[],
+                               int *num_neighbors,
+                               t8_locidx_t ** pelement_indices,
+                               t8_eclass_scheme_c ** pneigh_scheme,
+                               int forest_is_balanced)
+{
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t      **neighbor_leafs, **children_at_face = NULL;
+  int                 num_children_at_face, at_maxlevel, *owners;
+
+  /* TODO: implement is_leaf check to apply to leaf */
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (!forest_is_balanced || t8_forest_is_balanced (forest));
+  SC_CHECK_ABORT (forest_is_balanced, "leaf face neighbors is not implemented " "for unbalanced forests.\n");   /* TODO: write version for unbalanced forests */
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "Ghost structure is needed for t8_forest_leaf_face_neighbors "
+                  "but was not found in forest.\n");
+
+  /* In a balanced forest, the leaf neighbor of a leaf is either the neighbor element itself,
+   * its parent or its children at the face. */
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  num_children_at_face =
+    t8_forest_leaf_face_neighbors_count (forest, ltreeid, leaf, face,
+                                         &neigh_scheme, &at_maxlevel);
+  *pneigh_scheme = neigh_scheme;
+  /* Allocate the neighbor elements and the temporary memory */
+  neighbor_leafs = *pneighbor_leafs =
+    T8_ALLOC (t8_element_t *, num_children_at_face);
+  neigh_scheme->t8_element_new (num_children_at_face, neighbor_leafs);
+  *dual_faces = T8_ALLOC (int, num_children_at_face);
+  *pelement_indices = T8_ALLOC (t8_locidx_t, num_children_at_face);
+  owners = T8_ALLOC (int, num_children_at_face);
+  if (!at_maxlevel) {
+    children_at_face = T8_ALLOC (t8_element_t *, num_children_at_face);
+    ts->t8_element_new (num_children_at_face, children_at_face);
+  }
+
+  *num_neighbors =
+    t8_forest_leaf_face_neighbors_core (forest, ltreeid, leaf, face,
+                                        neigh_scheme, at_maxlevel,
+                                        num_children_at_face, neighbor_leafs,
+                                        children_at_face, *dual_faces,
+                                        *pelement_indices, owners);
+  /* Clean-up the temporary memory */
+  T8_FREE (owners);
+  if (!at_maxlevel) {
+    ts->t8_element_destroy (num_children_at_face, children_at_face);
+    T8_FREE (children_at_face);
+  }
+  if (*num_neighbors == 0) {
+    /* There exists no face neighbor across this face, we return with this info */
+    neigh_scheme->t8_element_destroy (num_children_at_face, neighbor_leafs);
+    T8_FREE (neighbor_leafs);
+    T8_FREE (*dual_faces);
+    T8_FREE (*pelement_indices);
+    *dual_faces = NULL;
+    *pelement_indices = NULL;
+    *pneighbor_leafs = NULL;
+  }
+  else if (*num_neighbors < num_children_at_face) {
+    /* The neighbor is an ancestor of the half face neighbors, we free the
+     * unused elements */
+    neigh_scheme->t8_element_destroy (num_children_at_face - 1,
+                                      neighbor_leafs + 1);
+  }
+}
+
+int
+t8_forest_leaf_face_neighbors_scratch (t8_forest_t forest,
+                                       t8_locidx_t ltreeid,
+                                       const t8_element_t * leaf, int face,
+                                       t8_element_scratch_t * scratch,
+                                       t8_element_t *** pneighbor_leafs,
+                                       int **pdual_faces,
+                                       t8_locidx_t ** pelement_indices,
+                                       t8_eclass_scheme_c ** pneigh_scheme,
+                                       int forest_is_balanced)
+{
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_element_t      **neighbor_leafs, **children_at_face = NULL;
+  t8_element_scratch_mark_t mark;
+  int                 num_children_at_face, at_maxlevel, *owners;
+  int                 num_neighbors;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (scratch != NULL);
+  T8_ASSERT (!forest_is_balanced || t8_forest_is_balanced (forest));
+  SC_CHECK_ABORT (forest_is_balanced, "leaf face neighbors is not implemented "
+                  "for unbalanced forests.\n");
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "Ghost structure is needed for t8_forest_leaf_face_neighbors "
+                  "but was not found in forest.\n");
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  num_children_at_face =
+    t8_forest_leaf_face_neighbors_count (forest, ltreeid, leaf, face,
+                                         &neigh_scheme, &at_maxlevel);
+  *pneigh_scheme = neigh_scheme;
+  /* The output stays in the arena */
+  neighbor_leafs = (t8_element_t **)
+    t8_element_scratch_alloc (scratch,
+                              num_children_at_face * sizeof (t8_element_t *));
+  t8_element_scratch_new (scratch, neigh_scheme, num_children_at_face,
+                          neighbor_leafs);
+  *pdual_faces = (int *)
+    t8_element_scratch_alloc (scratch, num_children_at_face * sizeof (int));
+  *pelement_indices = (t8_locidx_t *)
+    t8_element_scratch_alloc (scratch,
+                              num_children_at_face * sizeof (t8_locidx_t));
+  /* The temporary memory is released before we return */
+  t8_element_scratch_mark (scratch, &mark);
+  owners = (int *)
+    t8_element_scratch_alloc (scratch, num_children_at_face * sizeof (int));
+  if (!at_maxlevel) {
+    children_at_face = (t8_element_t **)
+      t8_element_scratch_alloc (scratch,
+                                num_children_at_face *
+                                sizeof (t8_element_t *));
+    t8_element_scratch_new (scratch, ts, num_children_at_face,
+                            children_at_face);
+  }
+  num_neighbors =
+    t8_forest_leaf_face_neighbors_core (forest, ltreeid, leaf, face,
+                                        neigh_scheme, at_maxlevel,
+                                        num_children_at_face, neighbor_leafs,
+                                        children_at_face, *pdual_faces,
+                                        *pelement_indices, owners);
+  t8_element_scratch_release (scratch, &mark);
+  *pneighbor_leafs = num_neighbors > 0 ? neighbor_leafs : NULL;
+  return num_neighbors;
+}
+
+void
+t8_forest_print_all_leaf_neighbors (t8_forest_t forest)
+{
+  t8_locidx_t         ltree, ielem;
+  t8_element_t       *leaf, **neighbor_leafs;
+  int                 iface, num_neighbors, ineigh;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_locidx_t        *element_indices;
+  int                *dual_faces;
+  char                buffer[BUFSIZ];
+  int                 allocate_first_desc, allocate_tree_offset;
+  int                 allocate_el_offset;
+
+  allocate_tree_offset = forest->tree_offsets == NULL;
+  allocate_first_desc = forest->global_first_desc == NULL;
+  allocate_el_offset = forest->element_offsets == NULL;
+  t8_forest_partition_create_all_offsets (forest);
+  for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
+    /* Get a pointer to the ielem-th element, its eclass, treeid and scheme */
+    leaf = t8_forest_get_element (forest, ielem, &ltree);
+    eclass = t8_forest_get_tree_class (forest, ltree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    /* Iterate over all faces */
+    for (iface = 0; iface < ts->t8_element_num_faces (leaf); iface++) {
+      t8_forest_leaf_face_neighbors (forest, ltree, leaf, &neighbor_leafs,
+                                     iface, &dual_faces, &num_neighbors,
+                                     &element_indices, &neigh_scheme, 1);
+      t8_debugf
+        ("Element %li across face %i has %i leaf neighbors (with dual faces).\n",
+         (long) ielem, iface, num_neighbors);
+      snprintf (buffer, BUFSIZ, "\tIndices:\t");
+      for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+        snprintf (buffer + strlen (buffer), BUFSIZ - strlen (buffer),
+                  "%li  (%i)  ", (long) element_indices[ineigh],
+                  dual_faces[iface]);
+      }
+      t8_debugf ("%s\n", buffer);
+      if (num_neighbors > 0) {
+        neigh_scheme->t8_element_destroy (num_neighbors, neighbor_leafs);
+
+        T8_FREE (element_indices);
+        T8_FREE (neighbor_leafs);
+        T8_FREE (dual_faces);
+      }
+    }
+  }
+  if (allocate_tree_offset) {
+    t8_shmem_array_destroy (&forest->tree_offsets);
+  }
+  if (allocate_first_desc) {
+    t8_shmem_array_destroy (&forest->global_first_desc);
+  }
+  if (allocate_el_offset) {
+    t8_shmem_array_destroy (&forest->element_offsets);
+  }
+}
+
+void
+t8_forest_face_neighbors_build (t8_forest_t forest)
+{
+  t8_forest_face_neighbors_t *table;
+  t8_forest_element_cursor_t cursor;
+  t8_locidx_t         num_elements, num_faces_total;
+  t8_locidx_t         iface_total, *element_indices, *neigh_pos;
+  t8_locidx_t         num_neighbors_total;
+  const t8_element_t *leaf;
+  t8_element_t      **neighbor_leafs;
+  t8_eclass_scheme_c *neigh_scheme;
+  sc_array_t          neighbors, dual_faces;
+  t8_element_scratch_t scratch;
+  int8_t             *dual_pos;
+  int                 iface, num_faces, num_neighbors, ineigh, level;
+  int                *neigh_dual_faces;
+  int                 allocate_first_desc, allocate_tree_offset;
+  int                 allocate_el_offset;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->face_neighbors == NULL);
+
+  /* The owner searches in t8_forest_leaf_face_neighbors need the
+   * partition tables */
+  allocate_tree_offset = forest->tree_offsets == NULL;
+  allocate_first_desc = forest->global_first_desc == NULL;
+  allocate_el_offset = forest->element_offsets == NULL;
+  t8_forest_partition_create_all_offsets (forest);
+
+  num_elements = t8_forest_get_num_element (forest);
+  table = forest->face_neighbors = T8_ALLOC (t8_forest_face_neighbors_t, 1);
+  table->num_elements = num_elements;
+  table->face_offsets = T8_ALLOC (t8_locidx_t, num_elements + 1);
+  /* Count the faces of all local elements */
+  num_faces_total = 0;
+  t8_forest_element_cursor_init (forest, &cursor);
+  while (t8_forest_element_cursor_next (&cursor)) {
+    table->face_offsets[cursor.lelement_id] = num_faces_total;
+    num_faces_total += cursor.ts->t8_element_num_faces (cursor.element);
+  }
+  table->face_offsets[num_elements] = num_faces_total;
+  table->neighbor_offsets = T8_ALLOC (t8_locidx_t, num_faces_total + 1);
+  table->level_diff = T8_ALLOC_ZERO (int8_t, num_faces_total);
+
+  /* Compute the neighbors of all faces. Since we do not know their
+   * number in advance, we collect them in growing arrays. */
+  sc_array_init (&neighbors, sizeof (t8_locidx_t));
+  sc_array_init (&dual_faces, sizeof (int8_t));
+  /* The neighbor elements are taken from a scratch arena that we clear
+   * after each face */
+  t8_element_scratch_init (&scratch, 0);
+  iface_total = 0;
+  t8_forest_element_cursor_init (forest, &cursor);
+  while (t8_forest_element_cursor_next (&cursor)) {
+    leaf = cursor.element;
+    level = cursor.ts->t8_element_level (leaf);
+    num_faces = cursor.ts->t8_element_num_faces (leaf);
+    for (iface = 0; iface < num_faces; iface++, iface_total++) {
+      table->neighbor_offsets[iface_total] = neighbors.elem_count;
+      num_neighbors =
+        t8_forest_leaf_face_neighbors_scratch (forest, cursor.ltreeid, leaf,
+                                               iface, &scratch,
+                                               &neighbor_leafs,
+                                               &neigh_dual_faces,
+                                               &element_indices,
+                                               &neigh_scheme, 1);
+      if (num_neighbors > 0) {
+        /* All neighbors of a face have the same level */
+        table->level_diff[iface_total] =
+          neigh_scheme->t8_element_level (neighbor_leafs[0]) - level;
+        neigh_pos =
+          (t8_locidx_t *) sc_array_push_count (&neighbors, num_neighbors);
+        dual_pos = (int8_t *) sc_array_push_count (&dual_faces,
+                                                   num_neighbors);
+        for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+          neigh_pos[ineigh] = element_indices[ineigh];
+          dual_pos[ineigh] = neigh_dual_faces[ineigh];
+        }
+      }
+      t8_element_scratch_clear (&scratch);
+    }
+  }
+  t8_element_scratch_reset (&scratch);
+  T8_ASSERT (iface_total == num_faces_total);
+  num_neighbors_total = neighbors.elem_count;
+  table->neighbor_offsets[num_faces_total] = num_neighbors_total;
+  /* Copy the neighbors into arrays of their exact size */
+  table->neighbors = T8_ALLOC (t8_locidx_t, num_neighbors_total);
+  table->dual_faces = T8_ALLOC (int8_t, num_neighbors_total);
+  if (num_neighbors_total > 0) {
+    memcpy (table->neighbors, neighbors.array,
+            num_neighbors_total * sizeof (t8_locidx_t));
+    memcpy (table->dual_faces, dual_faces.array,
+            num_neighbors_total * sizeof (int8_t));
+  }
+  sc_array_reset (&neighbors);
+  sc_array_reset (&dual_faces);
+
+  if (allocate_tree_offset) {
+    t8_shmem_array_destroy (&forest->tree_offsets);
+  }
+  if (allocate_first_desc) {
+    t8_shmem_array_destroy (&forest->global_first_desc);
+  }
+  if (allocate_el_offset) {
+    t8_shmem_array_destroy (&forest->element_offsets);
+  }
+}
+
+void
+t8_forest_face_neighbors_destroy (t8_forest_t forest)
+{
+  t8_forest_face_neighbors_t *table = forest->face_neighbors;
+
+  if (table == NULL) {
+    return;
+  }
+  T8_FREE (table->face_offsets);
+  T8_FREE (table->neighbor_offsets);
+  T8_FREE (table->level_diff);
+  T8_FREE (table->neighbors);
+  T8_FREE (table->dual_faces);
+  T8_FREE (table);
+  forest->face_neighbors = NULL;
+}
+
+/* Return the vertices of a local or ghost tree, or NULL if they are
+ * not known. */
+static const double *
+t8_forest_geometry_cache_vertices (t8_forest_t forest, t8_locidx_t ltreeid)
+{
+  t8_locidx_t         lctreeid;
+
+  lctreeid = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  if (lctreeid < t8_cmesh_get_num_local_trees (forest->cmesh)) {
+    return t8_cmesh_get_tree_vertices (forest->cmesh, lctreeid);
+  }
+  /* Ghost trees only have vertices if they are stored as attribute */
+  return (const double *) t8_cmesh_get_attribute (forest->cmesh,
+                                                  t8_get_package_id (), 0,
+                                                  lctreeid);
+}
+
+/* Compute the cached geometry of the elements of one local or ghost tree */
+static void
+t8_forest_geometry_cache_fill_tree (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    t8_forest_geometry_cache_t * cache)
+{
+  t8_element_array_t *elements;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  const double       *vertices;
+  t8_forest_face_points_t points;
+  double              coords[3], centroid[3], len, area;
+  t8_locidx_t         first_index, ielem, num_elements, index, iface_total;
+  int                 iface, num_faces, i;
+
+  elements = t8_forest_geometry_cache_tree (forest, ltreeid, &first_index);
+  vertices = t8_forest_geometry_cache_vertices (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  num_elements = (t8_locidx_t) t8_element_array_get_count (elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    element = t8_element_array_index_locidx (elements, ielem);
+    index = first_index + ielem;
+    t8_forest_element_centroid (forest, ltreeid, element, vertices,
+                                centroid);
+    for (i = 0; i < 3; i++) {
+      t8_forest_geometry_cache_store (cache->centroid[i],
+                                      cache->centroid_float[i], index,
+                                      centroid[i]);
+    }
+    len = 1. / ts->t8_element_root_len (element);
+    t8_forest_geometry_cache_store (cache->volume, cache->volume_float,
+                                    index,
+                                    t8_forest_element_volume (forest, ltreeid,
+                                                              element,
+                                                              vertices));
+    num_faces = ts->t8_element_num_faces (element);
+    iface_total = cache->face_offsets[index];
+    T8_ASSERT (iface_total + num_faces == cache->face_offsets[index + 1]);
+    /* All faces share the corner coordinates and the centroid */
+    points.num_points = 0;
+    for (iface = 0; iface < num_faces; iface++, iface_total++) {
+      t8_forest_face_geometry_points (forest, ltreeid, ts, element, iface,
+                                      vertices, len, centroid, &points,
+                                      &area, NULL,
+                                      cache->has_normals ? coords : NULL);
+      t8_forest_geometry_cache_store (cache->face_area,
+                                      cache->face_area_float, iface_total,
+                                      area);
+      if (cache->has_normals) {
+        for (i = 0; i < 3; i++) {
+          t8_forest_geometry_cache_store (cache->face_normal[i],
+                                          cache->face_normal_float[i],
+                                          iface_total, coords[i]);
+        }
+      }
+    }
+  }
+}
+
+/* Sort the indices 0, ..., num_entries - 1 by their levels with a
+ * counting sort. offsets must have num_levels + 1 entries and sorted
+ * num_entries. The order within a level is ascending. */
+static void
+t8_forest_level_lists_sort (const int8_t * levels, t8_locidx_t num_entries,
+                            int num_levels, t8_locidx_t * offsets,
+                            t8_locidx_t * sorted)
+{
+  t8_locidx_t         ientry;
+  int                 ilevel;
+
+  /* Count the entries of each level, level l is counted in entry l + 1 */
+  memset (offsets, 0, (num_levels + 1) * sizeof (t8_locidx_t));
+  for (ientry = 0; ientry < num_entries; ientry++) {
+    T8_ASSERT (0 <= levels[ientry] && levels[ientry] < num_levels);
+    offsets[levels[ientry] + 1]++;
+  }
+  for (ilevel = 0; ilevel < num_levels; ilevel++) {
+    offsets[ilevel + 1] += offsets[ilevel];
+  }
+  /* We use offsets[l] as the next free position of level l and shift the
+   * offsets back afterwards */
+  for (ientry = 0; ientry < num_entries; ientry++) {
+    sorted[offsets[levels[ientry]]++] = ientry;
+  }
+  for (ilevel = num_levels; ilevel > 0; ilevel--) {
+    offsets[ilevel] = offsets[ilevel - 1];
+  }
+  offsets[0] = 0;
+}
+
+/* The inverse of t8_forest_level_lists_sort, store the level of each
+ * sorted index in levels. */
+static void
+t8_forest_level_lists_scatter (int num_levels, const t8_locidx_t * offsets,
+                               const t8_locidx_t * sorted, int8_t * levels)
+{
+  t8_locidx_t         ientry;
+  int                 ilevel;
+
+  for (ilevel = 0; ilevel < num_levels; ilevel++) {
+    for (ientry = offsets[ilevel]; ientry < offsets[ilevel + 1]; ientry++) {
+      levels[sorted[ientry]] = (int8_t) ilevel;
+    }
+  }
+}
+
+void
+t8_forest_element_levels_compute (t8_forest_t forest, int8_t * levels)
+{
+  t8_locidx_t         itree, num_trees;
+  t8_tree_t           tree;
+  t8_forest_element_levels_kernel kernel;
+
+  if (forest->element_levels != NULL) {
+    memcpy (levels, forest->element_levels,
+            t8_forest_get_num_element (forest) * sizeof (int8_t));
+    return;
+  }
+  if (forest->level_lists != NULL) {
+    t8_forest_level_lists_scatter (forest->level_lists->num_levels,
+                                   forest->level_lists->element_offsets,
+                                   forest->level_lists->elements, levels);
+    return;
+  }
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    kernel.telements = &tree->elements;
+    kernel.levels = levels + tree->elements_offset;
+    t8_default_scheme_dispatch (forest->scheme_cxx->
+                                eclass_schemes[tree->eclass], kernel);
+  }
+}
+
+void
+t8_forest_element_levels_build (t8_forest_t forest)
+{
+  T8_ASSERT (forest->element_levels == NULL);
+
+  forest->element_levels =
+    T8_ALLOC (int8_t, t8_forest_get_num_element (forest));
+  t8_forest_element_levels_compute (forest, forest->element_levels);
+}
+
+void
+t8_forest_ghost_levels_compute (t8_forest_t forest, int8_t * levels)
+{
+  t8_locidx_t         itree, ielement, num_tree_elements, offset;
+  t8_eclass_scheme_c *ts;
+
+  if (forest->level_lists != NULL
+      && forest->level_lists->ghost_offsets != NULL) {
+    t8_forest_level_lists_scatter (forest->level_lists->num_levels,
+                                   forest->level_lists->ghost_offsets,
+                                   forest->level_lists->ghosts, levels);
+    return;
+  }
+  for (itree = 0; itree < t8_forest_ghost_num_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_ghost_get_tree_class (forest,
+                                                                      itree));
+    offset = t8_forest_ghost_get_tree_element_offset (forest, itree);
+    num_tree_elements = t8_forest_ghost_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_tree_elements; ielement++) {
+      levels[offset + ielement] = (int8_t)
+        ts->t8_element_level (t8_forest_ghost_get_element (forest, itree,
+                                                           ielement));
+    }
+  }
+}
+
+void
+t8_forest_level_lists_build_elements (t8_forest_t forest)
+{
+  t8_forest_level_lists_t *lists;
+  t8_locidx_t         num_elements;
+  int8_t             *levels;
+
+  T8_ASSERT (forest->level_lists == NULL);
+
+  num_elements = forest->local_num_elements;
+  levels = T8_ALLOC (int8_t, num_elements);
+  t8_forest_element_levels_compute (forest, levels);
+  lists = T8_ALLOC_ZERO (t8_forest_level_lists_t, 1);
+  /* We do not know the maximum existing level yet, it is reduced from the
+   * element counts of each level */
+  lists->num_levels = forest->maxlevel + 1;
+  lists->element_offsets = T8_ALLOC (t8_locidx_t, lists->num_levels + 1);
+  lists->elements = T8_ALLOC (t8_locidx_t, num_elements);
+  t8_forest_level_lists_sort (levels, num_elements, lists->num_levels,
+                              lists->element_offsets, lists->elements);
+  T8_FREE (levels);
+  forest->level_lists = lists;
+}
+
+void
+t8_forest_level_lists_build_ghosts (t8_forest_t forest)
+{
+  t8_forest_level_lists_t *lists = forest->level_lists;
+  t8_locidx_t         num_ghosts;
+  int8_t             *levels;
+
+  T8_ASSERT (lists != NULL && lists->ghost_offsets == NULL);
+  T8_ASSERT (lists->num_levels == forest->maxlevel_existing + 1);
+
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  levels = T8_ALLOC (int8_t, num_ghosts);
+  t8_forest_ghost_levels_compute (forest, levels);
+  /* The ghosts are elements of other processes, so their levels do not
+   * exceed the maximum existing level */
+  lists->ghost_offsets = T8_ALLOC (t8_locidx_t, lists->num_levels + 1);
+  lists->ghosts = T8_ALLOC (t8_locidx_t, num_ghosts);
+  t8_forest_level_lists_sort (levels, num_ghosts, lists->num_levels,
+                              lists->ghost_offsets, lists->ghosts);
+  T8_FREE (levels);
+}
+
+void
+t8_forest_level_lists_destroy (t8_forest_t forest)
+{
+  if (forest->level_lists == NULL) {
+    return;
+  }
+  T8_FREE (forest->level_lists->element_offsets);
+  T8_FREE (forest->level_lists->elements);
+  T8_FREE (forest->level_lists->ghost_offsets);
+  T8_FREE (forest->level_lists->ghosts);
+  T8_FREE (forest->level_lists);
+  forest->level_lists = NULL;
+}
+
+t8_locidx_t
+t8_forest_get_level_elements (t8_forest_t forest, int level,
+                              const t8_locidx_t ** elements)
+{
+  const t8_forest_level_lists_t *lists;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->level_lists != NULL);
+  T8_ASSERT (level >= 0);
+
+  lists = forest->level_lists;
+  if (level >= lists->num_levels) {
+    *elements = NULL;
+    return 0;
+  }
+  *elements = lists->elements + lists->element_offsets[level];
+  return lists->element_offsets[level + 1] - lists->element_offsets[level];
+}
+
+t8_locidx_t
+t8_forest_get_level_ghosts (t8_forest_t forest, int level,
+                            const t8_locidx_t ** ghosts)
+{
+  const t8_forest_level_lists_t *lists;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->level_lists != NULL);
+  T8_ASSERT (level >= 0);
+
+  lists = forest->level_lists;
+  if (level >= lists->num_levels) {
+    *ghosts = NULL;
+    return 0;
+  }
+  *ghosts = lists->ghosts + lists->ghost_offsets[level];
+  return lists->ghost_offsets[level + 1] - lists->ghost_offsets[level];
+}
+
+void
+t8_forest_split_levels (t8_forest_t forest, sc_array_t * level_offsets,
+                        sc_array_t * elements)
+{
+  t8_locidx_t         num_elements, *offsets;
+  int8_t             *levels;
+  int                 ilevel, num_levels;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (level_offsets->elem_size == sizeof (t8_locidx_t));
+  T8_ASSERT (elements->elem_size == sizeof (t8_locidx_t));
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_levels = t8_forest_get_maxlevel (forest) + 1;
+  sc_array_resize (level_offsets, num_levels + 1);
+  sc_array_resize (elements, num_elements);
+  offsets = (t8_locidx_t *) level_offsets->array;
+  if (forest->level_lists != NULL) {
+    /* Copy the lists and fill the offsets of the nonexisting levels */
+    T8_ASSERT (forest->level_lists->num_levels <= num_levels);
+    memcpy (offsets, forest->level_lists->element_offsets,
+            (forest->level_lists->num_levels + 1) * sizeof (t8_locidx_t));
+    for (ilevel = forest->level_lists->num_levels + 1;
+         ilevel <= num_levels; ilevel++) {
+      offsets[ilevel] = num_elements;
+    }
+    memcpy (elements->array, forest->level_lists->elements,
+            num_elements * sizeof (t8_locidx_t));
+    return;
+  }
+  levels = T8_ALLOC (int8_t, num_elements);
+  t8_forest_element_levels_compute (forest, levels);
+  t8_forest_level_lists_sort (levels, num_elements, num_levels, offsets,
+                              (t8_locidx_t *) elements->array);
+  T8_FREE (levels);
+}
+
+int
+t8_forest_multirate_min_level (int min_level, int max_level, int substep)
+{
+  int                 level = max_level;
+
+  T8_ASSERT (0 <= min_level && min_level <= max_level);
+  T8_ASSERT (0 <= substep && substep < 1 << (max_level - min_level));
+
+  /* Level l takes a step if substep is a multiple of 2^(max_level - l) */
+  while (level > min_level && substep % 2 == 0) {
+    substep /= 2;
+    level--;
+  }
+  return level;
+}
+
+void
+t8_forest_compress (t8_forest_t forest)
+{
+  t8_forest_compressed_t *compressed;
+  t8_locidx_t         itree, num_trees, ielem, num_elements;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *desc;
+  int8_t             *levels;
+  int                 maxlevel;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->compressed == NULL);
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  compressed = T8_ALLOC (t8_forest_compressed_t, 1);
+  compressed->first_ids = T8_ALLOC_ZERO (t8_linearidx_t, num_trees);
+  compressed->levels =
+    T8_ALLOC (int8_t, t8_forest_get_num_element (forest));
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    if (num_elements > 0) {
+      ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+      maxlevel = ts->t8_element_maxlevel ();
+      ts->t8_element_new (1, &desc);
+      ts->t8_element_first_descendant (t8_element_array_index_locidx
+                                       (&tree->elements, 0), desc, maxlevel);
+      compressed->first_ids[itree] =
+        ts->t8_element_get_linear_id (desc, maxlevel);
+      ts->t8_element_destroy (1, &desc);
+      levels = compressed->levels + tree->elements_offset;
+      for (ielem = 0; ielem < num_elements; ielem++) {
+        levels[ielem] =
+          ts->t8_element_level (t8_element_array_index_locidx
+                                (&tree->elements, ielem));
+      }
+    }
+    t8_forest_release_tree_elements (forest, &tree->elements);
+    t8_element_array_init (&tree->elements,
+                           forest->scheme_cxx->eclass_schemes[tree->eclass]);
   }
-  /* Clean-up the memory */
-  ts->t8_element_destroy (num_children_at_face, children_at_face);
-  T8_FREE (children_at_face);
-  return neighbor_tree;
+  if (forest->shared_elements != NULL) {
+    /* The forests that we were copied from or to keep the elements */
+    t8_forest_shared_elements_unref (forest);
+  }
+  forest->compressed = compressed;
 }
 
 void
-t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
-                               const t8_element_t * leaf,
-                               t8_element_t ** pneighbor_leafs[],
-                               int face, int *dual_faces[],
-                               int *num_neighbors,
-                               t8_locidx_t ** pelement_indices,
-                               t8_eclass_scheme_c ** pneigh_scheme,
-                               int forest_is_balanced)
+t8_forest_decompress (t8_forest_t forest)
 {
-  t8_eclass_t         neigh_class, eclass;
-  t8_gloidx_t         gneigh_treeid;
-  t8_locidx_t         lneigh_treeid = -1;
-  t8_locidx_t         lghost_treeid = -1, *element_indices, element_index;
-  t8_eclass_scheme_c *ts, *neigh_scheme;
-  t8_element_array_t *element_array;
-  t8_element_t       *ancestor, **neighbor_leafs;
-  t8_linearidx_t      neigh_id;
-  int                 num_children_at_face, at_maxlevel;
-  int                 ineigh, *owners, different_owners, have_ghosts;
+  t8_forest_compressed_t *compressed = forest->compressed;
+  t8_locidx_t         itree, num_trees, ielem, irun, num_elements;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *desc, *first;
+  t8_linearidx_t      id;
+  const int8_t       *levels;
+  int                 maxlevel, level;
 
-  /* TODO: implement is_leaf check to apply to leaf */
   T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (!forest_is_balanced || t8_forest_is_balanced (forest));
-  SC_CHECK_ABORT (forest_is_balanced, "leaf face neighbors is not implemented " "for unbalanced forests.\n");   /* TODO: write version for unbalanced forests */
-  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
-                  "Ghost structure is needed for t8_forest_leaf_face_neighbors "
-                  "but was not found in forest.\n");
+  T8_ASSERT (compressed != NULL);
 
-  if (forest_is_balanced) {
-    /* In a balanced forest, the leaf neighbor of a leaf is either the neighbor element itself,
-     * its parent or its children at the face. */
-    eclass = t8_forest_get_tree_class (forest, ltreeid);
-    ts = t8_forest_get_eclass_scheme (forest, eclass);
-    /* At first we compute these children of the face neighbor elements of leaf. For this, we need the
-     * neighbor tree's eclass, scheme, and tree id */
-    neigh_class =
-      t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
-    neigh_scheme = *pneigh_scheme =
-      t8_forest_get_eclass_scheme (forest, neigh_class);
-    /* If we are at the maximum refinement level, we compute the neighbor instead */
-    at_maxlevel =
-      ts->t8_element_level (leaf) == t8_forest_get_maxlevel (forest);
-    if (at_maxlevel) {
-      num_children_at_face = 1;
-      neighbor_leafs = *pneighbor_leafs = T8_ALLOC (t8_element_t *, 1);
-      *dual_faces = T8_ALLOC (int, 1);
-      neigh_scheme->t8_element_new (num_children_at_face, neighbor_leafs);
-      /* Compute neighbor element and global treeid of the neighbor */
-      gneigh_treeid =
-        t8_forest_element_face_neighbor (forest, ltreeid, leaf,
-                                         neighbor_leafs[0], neigh_scheme,
-                                         face, *dual_faces);
-    }
-    else {
-      /* Allocate neighbor element */
-      num_children_at_face = ts->t8_element_num_face_children (leaf, face);
-      neighbor_leafs = *pneighbor_leafs =
-        T8_ALLOC (t8_element_t *, num_children_at_face);
-      *dual_faces = T8_ALLOC (int, num_children_at_face);
-      neigh_scheme->t8_element_new (num_children_at_face, neighbor_leafs);
-      /* Compute neighbor elements and global treeid of the neighbor */
-      gneigh_treeid =
-        t8_forest_element_half_face_neighbors (forest, ltreeid, leaf,
-                                               neighbor_leafs,
-                                               neigh_scheme, face,
-                                               num_children_at_face,
-                                               *dual_faces);
-    }
-    if (gneigh_treeid < 0) {
-      /* There exists no face neighbor across this face, we return with this info */
-      neigh_scheme->t8_element_destroy (1, neighbor_leafs);
-      T8_FREE (neighbor_leafs);
-      T8_FREE (*dual_faces);
-      *dual_faces = NULL;
-      *num_neighbors = 0;
-      *pelement_indices = NULL;
-      *pneighbor_leafs = NULL;
-      return;
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    /* The number of elements follows from the offset of the next tree */
+    num_elements = (itree + 1 < num_trees ?
+                    t8_forest_get_tree (forest, itree + 1)->elements_offset :
+                    t8_forest_get_num_element (forest))
+      - tree->elements_offset;
+    t8_forest_init_tree_elements (forest, &tree->elements, ts, num_elements);
+    if (num_elements == 0) {
+      continue;
     }
-    T8_ASSERT (gneigh_treeid >= 0
-               && gneigh_treeid < forest->global_num_trees);
-    /* We have computed the half face neighbor elements, we now compute their owners,
-     * if they differ, we know that the half face neighbors are the neighbor leafs.
-     * If the owners do not differ, we have to check if the neighbor leaf is their
-     * parent or grandparent. */
-    owners = T8_ALLOC (int, num_children_at_face);
-    different_owners = 0;
-    have_ghosts = 0;
-    for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
-      /* At first, we check whether the current rank owns the neighbor, since
-       * this is a constant time check and it is the most common case */
-      if (t8_forest_element_check_owner (forest, neighbor_leafs[ineigh],
-                                         gneigh_treeid, neigh_class,
-                                         forest->mpirank, at_maxlevel)) {
-        owners[ineigh] = forest->mpirank;
-        /* The neighbor tree is also a local tree. we store its local treeid */
-        lneigh_treeid = t8_forest_get_local_id (forest, gneigh_treeid);
-      }
-      else {
-        owners[ineigh] =
-          t8_forest_element_find_owner (forest, gneigh_treeid,
-                                        neighbor_leafs[ineigh], neigh_class);
-        /* Store that at least one neighbor is a ghost */
-        have_ghosts = 1;
-      }
-      if (ineigh > 0) {
-        /* Check if all owners are the same for all neighbors or not */
-        different_owners = different_owners
-          || (owners[ineigh] != owners[ineigh - 1]);
-      }
-    }
-    if (have_ghosts) {
-      /* At least one neighbor is a ghost, we compute the ghost treeid of the neighbor
-       * tree. */
-      lghost_treeid =
-        t8_forest_ghost_get_ghost_treeid (forest, gneigh_treeid);
-      T8_ASSERT (lghost_treeid >= 0);
-    }
-    /* TODO: Maybe we do not need to compute the owners. It suffices to know
-     *       whether the neighbor is owned by mpirank or not. */
-
-    if (!different_owners) {
-      /* The face neighbors belong to the same process, we thus need to determine
-       * if they are leafs or their parent or grandparent. */
-      neigh_id =
-        neigh_scheme->t8_element_get_linear_id (neighbor_leafs[0],
-                                                forest->maxlevel);
-      if (owners[0] != forest->mpirank) {
-        /* The elements are ghost elements of the same owner */
-        element_array =
-          t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
-        /* Find the index in element_array of the leaf ancestor of the first neighbor.
-         * This is either the neighbor itself or its parent, or its grandparent */
-        element_index =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
-        /* Get the element */
-        ancestor =
-          t8_forest_ghost_get_element (forest, lghost_treeid, element_index);
-        /* Add the number of ghost elements on previous ghost trees and the number
-         * of local elements. */
-        element_index +=
-          t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
-        element_index += t8_forest_get_num_element (forest);
-        T8_ASSERT (forest->local_num_elements <= element_index
-                   && element_index <
-                   forest->local_num_elements +
-                   t8_forest_get_num_ghosts (forest));
+    maxlevel = ts->t8_element_maxlevel ();
+    levels = compressed->levels + tree->elements_offset;
+    ts->t8_element_new (1, &desc);
+    id = compressed->first_ids[itree];
+    /* Consecutive elements of the same level are consecutive in the uniform
+     * refinement of this level. We set each run in one call and continue
+     * after the last descendant of its last element. */
+    for (ielem = 0; ielem < num_elements; ielem = irun) {
+      level = levels[ielem];
+      irun = ielem + 1;
+      while (irun < num_elements && levels[irun] == level) {
+        irun++;
       }
-      else {
-        /* the elements are local elements */
-        element_array =
-          t8_forest_get_tree_element_array (forest, lneigh_treeid);
-        /* Find the index in element_array of the leaf ancestor of the first neighbor.
-         * This is either the neighbor itself or its parent, or its grandparent */
-        element_index =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
-        /* Get the element */
-        ancestor =
-          t8_forest_get_tree_element (t8_forest_get_tree
-                                      (forest, lneigh_treeid), element_index);
-        /* Add the element offset of this tree to the index */
-        element_index +=
-          t8_forest_get_tree_element_offset (forest, lneigh_treeid);
-      }
-      if (neigh_scheme->t8_element_compare (ancestor, neighbor_leafs[0]) < 0) {
-        /* ancestor is a real ancestor, and thus the neighbor is either the
-         * parent or grandparent of the half neighbors. we can return it and
-         * the indices. */
-        /* We need to determine the dual face */
-        if (neigh_scheme->t8_element_level (ancestor) ==
-            ts->t8_element_level (leaf)) {
-          /* The ancestor is the same-level neighbor of leaf */
-          if (!at_maxlevel) {
-            /* its dual face is the face of the parent of the first neighbor leaf */
-            *dual_faces[0] =
-              neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
-                                                         *dual_faces[0]);
+      ts->t8_element_set_linear_id (desc, maxlevel, id);
+      first = t8_element_array_index_locidx (&tree->elements, ielem);
+      ts->t8_element_set_linear_id_range (first, level,
+                                          ts->t8_element_get_linear_id (desc,
+                                                                        level),
+                                          irun - ielem);
+      ts->t8_element_last_descendant (t8_element_array_index_locidx
+                                      (&tree->elements, irun - 1), desc,
+                                      maxlevel);
+      id = ts->t8_element_get_linear_id (desc, maxlevel) + 1;
+    }
+    ts->t8_element_destroy (1, &desc);
+  }
+  t8_forest_compressed_destroy (forest);
+}
 
-          }
-        }
-        else {
-          /* The ancestor is the parent of the parent */
-          T8_ASSERT (neigh_scheme->t8_element_level (ancestor) ==
-                     ts->t8_element_level (leaf) - 1);
+int
+t8_forest_is_compressed (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  return forest->compressed != NULL;
+}
 
-          *dual_faces[0] =
-            neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
-                                                       *dual_faces[0]);
-          if (!at_maxlevel) {
-            /* We need to compute the dual face of the grandparent. */
-            /* Construct the parent of the grand child */
-            neigh_scheme->t8_element_parent (neighbor_leafs[0],
-                                             neighbor_leafs[0]);
-            /* Compute the face id of the parent's face */
-            *dual_faces[0] =
-              neigh_scheme->t8_element_face_parent_face (neighbor_leafs[0],
-                                                         *dual_faces[0]);
-          }
-        }
+void
+t8_forest_compressed_destroy (t8_forest_t forest)
+{
+  T8_ASSERT (forest->compressed != NULL);
+  T8_FREE (forest->compressed->first_ids);
+  T8_FREE (forest->compressed->levels);
+  T8_FREE (forest->compressed);
+  forest->compressed = NULL;
+}
 
-        /* free memory */
-        neigh_scheme->t8_element_destroy (num_children_at_face - 1,
-                                          neighbor_leafs + 1);
-        /* copy the ancestor */
-        neigh_scheme->t8_element_copy (ancestor, neighbor_leafs[0]);
-        /* set return values */
-        *num_neighbors = 1;
-        *pelement_indices = T8_ALLOC (t8_locidx_t, 1);
-        (*pelement_indices)[0] = element_index;
-
-        T8_FREE (owners);
-        return;
-      }
-    }
-    /* The leafs are the face neighbors that we are looking for. */
-    /* The face neighbors either belong to different processes and thus must be leafs
-     * in the forest, or the ancestor leaf of the first half neighbor is the half
-     * neighbor itself and thus all half neighbors must be leafs.
-     * Since the forest is balanced, we found all neighbor leafs.
-     * It remains to compute their local ids */
-    *num_neighbors = num_children_at_face;
-    *pelement_indices = T8_ALLOC (t8_locidx_t, num_children_at_face);
-    element_indices = *pelement_indices;
-    for (ineigh = 0; ineigh < num_children_at_face; ineigh++) {
-      /* Compute the linear id at maxlevel of the neighbor leaf */
-      neigh_id =
-        neigh_scheme->t8_element_get_linear_id (neighbor_leafs[ineigh],
-                                                forest->maxlevel);
-      /* Get a pointer to the element array in which the neighbor lies and search
-       * for the element's index in this array.
-       * This is either the local leaf array of the local tree or the corresponding leaf array
-       * in the ghost structure */
-      if (owners[ineigh] == forest->mpirank) {
-        /* The neighbor is a local leaf */
-        element_array =
-          t8_forest_get_tree_element_array (forest, lneigh_treeid);
-        /* Find the index of the neighbor in the array */
-        element_indices[ineigh] =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
-        T8_ASSERT (element_indices[ineigh] >= 0);
-        /* We have to add the tree's element offset to the index found to get
-         * the actual local element id */
-        element_indices[ineigh] +=
-          t8_forest_get_tree_element_offset (forest, lneigh_treeid);
-#if T8_ENABLE_DEBUG
-        /* We check whether the element is really the element at this local id */
-        {
-          t8_locidx_t         check_ltreeid;
-          t8_element_t       *check_element;
-          check_element =
-            t8_forest_get_element (forest, element_indices[ineigh],
-                                   &check_ltreeid);
-          T8_ASSERT (check_ltreeid == lneigh_treeid);
-          T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
-                                                        neighbor_leafs
-                                                        [ineigh]));
-        }
-#endif
-      }
-      else {
-        /* The neighbor is a ghost */
-        element_array =
-          t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
-        /* Find the index of the neighbor in the array */
-        element_indices[ineigh] =
-          t8_forest_bin_search_lower (element_array, neigh_id,
-                                      forest->maxlevel);
+/* A run of elements of one level that are consecutive in the uniform
+ * refinement of this level, as stored in compressed messages */
+typedef struct
+{
+  t8_linearidx_t      id;       /* The linear id of the first element */
+  t8_locidx_t         count;    /* The number of elements */
+  int8_t              level;    /* Their level */
+}
+t8_forest_element_run_t;
 
-#if T8_ENABLE_DEBUG
-        /* We check whether the element is really the element at this local id */
-        {
-          t8_element_t       *check_element;
-          check_element =
-            t8_forest_ghost_get_element (forest, lghost_treeid,
-                                         element_indices[ineigh]);
-          T8_ASSERT (!neigh_scheme->t8_element_compare (check_element,
-                                                        neighbor_leafs
-                                                        [ineigh]));
-        }
-#endif
-        /* Add the element offset of previous ghosts to this index */
-        element_indices[ineigh] +=
-          t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
-        /* Add the number of all local elements to this index */
-        element_indices[ineigh] += t8_forest_get_num_element (forest);
+size_t
+t8_forest_element_runs_encode (t8_eclass_scheme_c * ts,
+                               const t8_element_t * elements,
+                               t8_locidx_t num_elements, char *buffer)
+{
+  t8_forest_element_run_t run;
+  const char         *elem = (const char *) elements;
+  const size_t        size = ts->t8_element_size ();
+  t8_linearidx_t      id;
+  t8_locidx_t         ielem;
+  size_t              bytes = 0;
+  int                 level;
+
+  /* The runs are copied with their padding bytes into the message,
+   * thus we zero them */
+  memset (&run, 0, sizeof (t8_forest_element_run_t));
+  for (ielem = 0; ielem < num_elements; ielem++, elem += size) {
+    level = ts->t8_element_level ((const t8_element_t *) elem);
+    id = ts->t8_element_get_linear_id ((const t8_element_t *) elem, level);
+    if (run.count > 0 && level == run.level
+        && id == run.id + (t8_linearidx_t) run.count) {
+      /* The element continues the run */
+      run.count++;
+      continue;
+    }
+    if (run.count > 0) {
+      if (buffer != NULL) {
+        memcpy (buffer + bytes, &run, sizeof (t8_forest_element_run_t));
       }
-    }                           /* End for loop over neighbor leafs */
-    T8_FREE (owners);
+      bytes += sizeof (t8_forest_element_run_t);
+    }
+    run.id = id;
+    run.level = level;
+    run.count = 1;
   }
-  else {
-    /* TODO: implement unbalanced version */
-    SC_ABORT_NOT_REACHED ();
+  if (run.count > 0) {
+    if (buffer != NULL) {
+      memcpy (buffer + bytes, &run, sizeof (t8_forest_element_run_t));
+    }
+    bytes += sizeof (t8_forest_element_run_t);
+  }
+  return bytes;
+}
+
+size_t
+t8_forest_element_runs_decode (t8_eclass_scheme_c * ts, const char *buffer,
+                               t8_locidx_t num_elements,
+                               t8_element_t * elements)
+{
+  t8_forest_element_run_t run;
+  char               *elem = (char *) elements;
+  const size_t        size = ts->t8_element_size ();
+  t8_locidx_t         num_decoded = 0;
+  size_t              bytes = 0;
+
+  while (num_decoded < num_elements) {
+    memcpy (&run, buffer + bytes, sizeof (t8_forest_element_run_t));
+    bytes += sizeof (t8_forest_element_run_t);
+    T8_ASSERT (0 < run.count && run.count <= num_elements - num_decoded);
+    ts->t8_element_set_linear_id_range ((t8_element_t *) elem, run.level,
+                                        run.id, run.count);
+    elem += run.count * size;
+    num_decoded += run.count;
   }
+  return bytes;
 }
 
 void
-t8_forest_print_all_leaf_neighbors (t8_forest_t forest)
+t8_forest_geometry_cache_build (t8_forest_t forest)
 {
-  t8_locidx_t         ltree, ielem;
-  t8_element_t       *leaf, **neighbor_leafs;
-  int                 iface, num_neighbors, ineigh;
-  t8_eclass_t         eclass;
-  t8_eclass_scheme_c *ts, *neigh_scheme;
-  t8_locidx_t        *element_indices;
-  int                *dual_faces;
-  char                buffer[BUFSIZ];
-  int                 allocate_first_desc = 0, allocate_tree_offset = 0;
-  int                 allocate_el_offset = 0;
+  t8_forest_geometry_cache_t *cache;
+  t8_element_array_t *elements;
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         num_local_trees, num_trees, ltree, ielem;
+  t8_locidx_t         num_elements, first_index, iface_total;
+  int                 cache_ghosts, i;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->geometry_cache == NULL);
 
-  if (forest->tree_offsets == NULL) {
-    allocate_tree_offset = 1;
-    t8_forest_partition_create_tree_offsets (forest);
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  num_trees = num_local_trees + t8_forest_ghost_num_trees (forest);
+  for (ltree = 0; ltree < num_local_trees; ltree++) {
+    SC_CHECK_ABORT (t8_forest_geometry_cache_vertices (forest, ltree) != NULL,
+                    "The geometry cache needs the vertices of all trees.");
   }
-  if (forest->global_first_desc == NULL) {
-    allocate_first_desc = 1;
-    t8_forest_partition_create_first_desc (forest);
+  /* The ghosts are only cached if all ghost trees have vertices */
+  cache_ghosts = 1;
+  for (ltree = num_local_trees; ltree < num_trees && cache_ghosts; ltree++) {
+    cache_ghosts = t8_forest_geometry_cache_vertices (forest, ltree) != NULL;
   }
-  if (forest->element_offsets == NULL) {
-    allocate_el_offset = 1;
-    t8_forest_partition_create_offsets (forest);
+  if (!cache_ghosts) {
+    t8_debugf ("Not caching the ghost geometry, since the vertices of"
+               " a ghost tree are unknown.\n");
+    num_trees = num_local_trees;
   }
-  for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
-    /* Get a pointer to the ielem-th element, its eclass, treeid and scheme */
-    leaf = t8_forest_get_element (forest, ielem, &ltree);
-    eclass = t8_forest_get_tree_class (forest, ltree);
-    ts = t8_forest_get_eclass_scheme (forest, eclass);
-    /* Iterate over all faces */
-    for (iface = 0; iface < ts->t8_element_num_faces (leaf); iface++) {
-      t8_forest_leaf_face_neighbors (forest, ltree, leaf, &neighbor_leafs,
-                                     iface, &dual_faces, &num_neighbors,
-                                     &element_indices, &neigh_scheme, 1);
-      t8_debugf
-        ("Element %li across face %i has %i leaf neighbors (with dual faces).\n",
-         (long) ielem, iface, num_neighbors);
-      snprintf (buffer, BUFSIZ, "\tIndices:\t");
-      for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
-        snprintf (buffer + strlen (buffer), BUFSIZ - strlen (buffer),
-                  "%li  (%i)  ", (long) element_indices[ineigh],
-                  dual_faces[iface]);
-      }
-      t8_debugf ("%s\n", buffer);
-      if (num_neighbors > 0) {
-        neigh_scheme->t8_element_destroy (num_neighbors, neighbor_leafs);
 
-        T8_FREE (element_indices);
-        T8_FREE (neighbor_leafs);
-        T8_FREE (dual_faces);
+  cache = T8_ALLOC (t8_forest_geometry_cache_t, 1);
+  cache->num_local_elements = t8_forest_get_num_element (forest);
+  cache->num_elements = cache->num_local_elements
+    + (cache_ghosts ? t8_forest_get_num_ghosts (forest) : 0);
+  /* Count the faces of all elements */
+  cache->face_offsets = T8_ALLOC (t8_locidx_t, cache->num_elements + 1);
+  iface_total = 0;
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    elements = t8_forest_geometry_cache_tree (forest, ltree, &first_index);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    num_elements = (t8_locidx_t) t8_element_array_get_count (elements);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      cache->face_offsets[first_index + ielem] = iface_total;
+      iface_total +=
+        ts->t8_element_num_faces (t8_element_array_index_locidx
+                                  (elements, ielem));
+    }
+  }
+  cache->face_offsets[cache->num_elements] = iface_total;
+
+  /* Lines have no computable face normals */
+  cache->has_normals = forest->dimension > 1;
+  cache->is_float = forest->geometry_float;
+  for (i = 0; i < 3; i++) {
+    cache->centroid[i] = NULL;
+    cache->centroid_float[i] = NULL;
+    cache->face_normal[i] = NULL;
+    cache->face_normal_float[i] = NULL;
+  }
+  cache->volume = cache->face_area = NULL;
+  cache->volume_float = cache->face_area_float = NULL;
+  if (cache->is_float) {
+    /* Single precision halves the memory of the cache */
+    for (i = 0; i < 3; i++) {
+      cache->centroid_float[i] = T8_ALLOC (float, cache->num_elements);
+      if (cache->has_normals) {
+        cache->face_normal_float[i] = T8_ALLOC (float, iface_total);
       }
     }
+    cache->volume_float = T8_ALLOC (float, cache->num_elements);
+    cache->face_area_float = T8_ALLOC (float, iface_total);
   }
-  if (allocate_tree_offset) {
-    t8_shmem_array_destroy (&forest->tree_offsets);
+  else {
+    for (i = 0; i < 3; i++) {
+      cache->centroid[i] = T8_ALLOC (double, cache->num_elements);
+      if (cache->has_normals) {
+        cache->face_normal[i] = T8_ALLOC (double, iface_total);
+      }
+    }
+    cache->volume = T8_ALLOC (double, cache->num_elements);
+    cache->face_area = T8_ALLOC (double, iface_total);
   }
-  if (allocate_first_desc) {
-    t8_shmem_array_destroy (&forest->global_first_desc);
+
+  /* The trees write to disjoint parts of the cache */
+#ifdef T8_ENABLE_OPENMP
+#pragma omp parallel for schedule (dynamic)
+#endif
+  for (ltree = 0; ltree < num_trees; ltree++) {
+    t8_forest_geometry_cache_fill_tree (forest, ltree, cache);
   }
-  if (allocate_el_offset) {
-    t8_shmem_array_destroy (&forest->element_offsets);
+  forest->geometry_cache = cache;
+}
+
+void
+t8_forest_geometry_cache_destroy (t8_forest_t forest)
+{
+  t8_forest_geometry_cache_t *cache = forest->geometry_cache;
+  int                 i;
+
+  if (cache == NULL) {
+    return;
+  }
+  for (i = 0; i < 3; i++) {
+    T8_FREE (cache->centroid[i]);
+    T8_FREE (cache->face_normal[i]);
+    T8_FREE (cache->centroid_float[i]);
+    T8_FREE (cache->face_normal_float[i]);
   }
+  T8_FREE (cache->volume);
+  T8_FREE (cache->face_offsets);
+  T8_FREE (cache->face_area);
+  T8_FREE (cache->volume_float);
+  T8_FREE (cache->face_area_float);
+  T8_FREE (cache);
+  forest->geometry_cache = NULL;
 }
 
 /* Check if an element is owned by a specific rank */
@@ -2016,6 +4860,326 @@ t8_forest_element_find_owner_compare (const void *find_owner_data,
   }
 }
 
+/* Fill the entries of the subtree with root k of an Eytzinger table with
+ * the sorted entries starting at index i. Returns the first sorted index
+ * that was not used. */
+static int
+t8_forest_owner_table_fill (t8_forest_owner_table_t * table,
+                            const t8_gloidx_t * sorted_trees,
+                            const t8_linearidx_t * sorted_descs, int i,
+                            int k)
+{
+  if (k <= table->num_entries) {
+    i = t8_forest_owner_table_fill (table, sorted_trees, sorted_descs, i,
+                                    2 * k);
+    table->first_trees[k] = sorted_trees[i];
+    table->first_descs[k] = sorted_descs[i];
+    table->sorted_index[k] = i;
+    i = t8_forest_owner_table_fill (table, sorted_trees, sorted_descs,
+                                    i + 1, 2 * k + 1);
+  }
+  return i;
+}
+
+void
+t8_forest_owner_table_build (t8_forest_t forest)
+{
+  t8_forest_owner_table_t *table;
+  t8_gloidx_t        *first_trees, *element_offsets, *sorted_trees;
+  t8_linearidx_t     *first_descs, *sorted_descs;
+  int                 iproc, num_entries;
+
+  T8_ASSERT (forest->owner_table == NULL);
+  T8_ASSERT (forest->tree_offsets != NULL);
+  T8_ASSERT (forest->element_offsets != NULL);
+  T8_ASSERT (forest->global_first_desc != NULL);
+
+  first_trees = t8_shmem_array_get_gloidx_array (forest->tree_offsets);
+  element_offsets = t8_shmem_array_get_gloidx_array (forest->element_offsets);
+  first_descs =
+    (t8_linearidx_t *) t8_shmem_array_get_array (forest->global_first_desc);
+
+  table = forest->owner_table = T8_ALLOC (t8_forest_owner_table_t, 1);
+  table->ranks = T8_ALLOC (int, forest->mpisize);
+  sorted_trees = T8_ALLOC (t8_gloidx_t, forest->mpisize);
+  sorted_descs = T8_ALLOC (t8_linearidx_t, forest->mpisize);
+  /* Collect the nonempty processes, they are sorted by their first
+   * tree and first descendant */
+  num_entries = 0;
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (!t8_offset_empty (iproc, element_offsets)) {
+      table->ranks[num_entries] = iproc;
+      sorted_trees[num_entries] = t8_offset_first (iproc, first_trees);
+      sorted_descs[num_entries] = first_descs[iproc];
+      num_entries++;
+    }
+  }
+  table->num_entries = num_entries;
+  table->first_trees = T8_ALLOC (t8_gloidx_t, num_entries + 1);
+  table->first_descs = T8_ALLOC (t8_linearidx_t, num_entries + 1);
+  table->sorted_index = T8_ALLOC (int, num_entries + 1);
+  t8_forest_owner_table_fill (table, sorted_trees, sorted_descs, 0, 1);
+  T8_FREE (sorted_trees);
+  T8_FREE (sorted_descs);
+}
+
+void
+t8_forest_owner_table_destroy (t8_forest_t forest)
+{
+  t8_forest_owner_table_t *table = forest->owner_table;
+
+  T8_ASSERT (table != NULL);
+  T8_FREE (table->first_trees);
+  T8_FREE (table->first_descs);
+  T8_FREE (table->sorted_index);
+  T8_FREE (table->ranks);
+  T8_FREE (table);
+  forest->owner_table = NULL;
+}
+
+/* Find the owner of a first descendant with the owner table.
+ * The owner is the last nonempty process whose first tree and first
+ * descendant are smaller than or equal to those of the element. */
+static int
+t8_forest_owner_table_search (const t8_forest_owner_table_t * table,
+                              t8_gloidx_t gtreeid, t8_linearidx_t desc_id)
+{
+  int                 k, sorted;
+
+  T8_ASSERT (table->num_entries > 0);
+  /* Descend to the first entry that is greater than the element */
+  k = 1;
+  while (k <= table->num_entries) {
+    k = 2 * k + (table->first_trees[k] < gtreeid
+                 || (table->first_trees[k] == gtreeid
+                     && table->first_descs[k] <= desc_id));
+  }
+  /* Undo the right turns after the last left turn, then k is the
+   * first entry that is greater, or 0 if there is none. */
+  while (k & 1) {
+    k >>= 1;
+  }
+  k >>= 1;
+  sorted = k == 0 ? table->num_entries : table->sorted_index[k];
+  T8_ASSERT (sorted > 0);
+  return table->ranks[sorted - 1];
+}
+
+/* Append the variable length encoding of value to stream at position pos,
+ * 7 bits per byte with the high bit set on all but the last byte.
+ * Returns the position after the encoding. */
+static size_t
+t8_forest_partition_compact_write (unsigned char *stream, size_t pos,
+                                   uint64_t value)
+{
+  while (value >= 0x80) {
+    stream[pos++] = (unsigned char) (value | 0x80);
+    value >>= 7;
+  }
+  stream[pos++] = (unsigned char) value;
+  return pos;
+}
+
+/* Decode a value that was written with t8_forest_partition_compact_write
+ * at position *pos of stream and advance *pos past it. */
+static              uint64_t
+t8_forest_partition_compact_read (const unsigned char *stream, size_t *pos)
+{
+  uint64_t            value = 0;
+  int                 shift = 0;
+
+  while (stream[*pos] & 0x80) {
+    value |= (uint64_t) (stream[(*pos)++] & 0x7f) << shift;
+    shift += 7;
+  }
+  value |= (uint64_t) stream[(*pos)++] << shift;
+  return value;
+}
+
+/* Decode the entry after (rank, tree, desc, element) from stream at
+ * position *pos and store it in place of the previous entry. */
+static void
+t8_forest_partition_compact_next (const unsigned char *stream, size_t *pos,
+                                  int *rank, t8_gloidx_t * tree,
+                                  t8_linearidx_t * desc,
+                                  t8_gloidx_t * element)
+{
+  t8_gloidx_t         tree_diff;
+
+  *rank += (int) t8_forest_partition_compact_read (stream, pos);
+  tree_diff = (t8_gloidx_t) t8_forest_partition_compact_read (stream, pos);
+  if (tree_diff == 0) {
+    *desc += (t8_linearidx_t) t8_forest_partition_compact_read (stream, pos);
+  }
+  else {
+    *tree += tree_diff;
+    *desc = (t8_linearidx_t) t8_forest_partition_compact_read (stream, pos);
+  }
+  *element += (t8_gloidx_t) t8_forest_partition_compact_read (stream, pos);
+}
+
+void
+t8_forest_partition_compact_build (t8_forest_t forest)
+{
+  t8_forest_partition_compact_t *table;
+  t8_gloidx_t        *first_trees, *element_offsets;
+  t8_gloidx_t         tree, prev_tree = 0, element, prev_element = 0;
+  t8_linearidx_t     *first_descs, desc, prev_desc = 0;
+  int                 iproc, prev_rank = 0, ientry, iblock;
+  size_t              pos;
+
+  T8_ASSERT (forest->partition_compact == NULL);
+  T8_ASSERT (forest->tree_offsets != NULL);
+  T8_ASSERT (forest->element_offsets != NULL);
+  T8_ASSERT (forest->global_first_desc != NULL);
+
+  first_trees = t8_shmem_array_get_gloidx_array (forest->tree_offsets);
+  element_offsets = t8_shmem_array_get_gloidx_array (forest->element_offsets);
+  first_descs =
+    (t8_linearidx_t *) t8_shmem_array_get_array (forest->global_first_desc);
+
+  table = forest->partition_compact =
+    T8_ALLOC (t8_forest_partition_compact_t, 1);
+  table->first_local_element = element_offsets[forest->mpirank];
+  table->num_entries = 0;
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    table->num_entries += !t8_offset_empty (iproc, element_offsets);
+  }
+  table->num_blocks = (table->num_entries + T8_FOREST_PARTITION_COMPACT_BLOCK
+                       - 1) / T8_FOREST_PARTITION_COMPACT_BLOCK;
+  table->block_ranks = T8_ALLOC (int, table->num_blocks);
+  table->block_trees = T8_ALLOC (t8_gloidx_t, table->num_blocks);
+  table->block_descs = T8_ALLOC (t8_linearidx_t, table->num_blocks);
+  table->block_elements = T8_ALLOC (t8_gloidx_t, table->num_blocks);
+  table->block_offsets = T8_ALLOC (size_t, table->num_blocks + 1);
+  /* Each entry needs at most four encodings of 10 bytes */
+  table->stream = T8_ALLOC (unsigned char, 40 * table->num_entries + 1);
+
+  pos = 0;
+  for (iproc = 0, ientry = 0; iproc < forest->mpisize; iproc++) {
+    if (t8_offset_empty (iproc, element_offsets)) {
+      continue;
+    }
+    tree = t8_offset_first (iproc, first_trees);
+    desc = first_descs[iproc];
+    element = element_offsets[iproc];
+    if (ientry % T8_FOREST_PARTITION_COMPACT_BLOCK == 0) {
+      /* Store the first entry of a block in full */
+      iblock = ientry / T8_FOREST_PARTITION_COMPACT_BLOCK;
+      table->block_ranks[iblock] = iproc;
+      table->block_trees[iblock] = tree;
+      table->block_descs[iblock] = desc;
+      table->block_elements[iblock] = element;
+      table->block_offsets[iblock] = pos;
+    }
+    else {
+      /* The entries are sorted, so all differences are nonnegative */
+      T8_ASSERT (iproc > prev_rank && tree >= prev_tree
+                 && element > prev_element);
+      T8_ASSERT (tree > prev_tree || desc > prev_desc);
+      pos = t8_forest_partition_compact_write (table->stream, pos,
+                                               iproc - prev_rank);
+      pos = t8_forest_partition_compact_write (table->stream, pos,
+                                               tree - prev_tree);
+      pos = t8_forest_partition_compact_write (table->stream, pos,
+                                               tree == prev_tree ?
+                                               desc - prev_desc : desc);
+      pos = t8_forest_partition_compact_write (table->stream, pos,
+                                               element - prev_element);
+    }
+    prev_rank = iproc;
+    prev_tree = tree;
+    prev_desc = desc;
+    prev_element = element;
+    ientry++;
+  }
+  table->block_offsets[table->num_blocks] = pos;
+  /* Release the memory that the encoding did not need */
+  table->stream = T8_REALLOC (table->stream, unsigned char, pos + 1);
+}
+
+void
+t8_forest_partition_compact_destroy (t8_forest_t forest)
+{
+  t8_forest_partition_compact_t *table = forest->partition_compact;
+
+  T8_ASSERT (table != NULL);
+  T8_FREE (table->block_ranks);
+  T8_FREE (table->block_trees);
+  T8_FREE (table->block_descs);
+  T8_FREE (table->block_elements);
+  T8_FREE (table->block_offsets);
+  T8_FREE (table->stream);
+  T8_FREE (table);
+  forest->partition_compact = NULL;
+}
+
+size_t
+t8_forest_partition_compact_memory_used (t8_forest_t forest)
+{
+  t8_forest_partition_compact_t *table = forest->partition_compact;
+
+  T8_ASSERT (table != NULL);
+  return sizeof (t8_forest_partition_compact_t)
+    + table->num_blocks * (sizeof (int) + 2 * sizeof (t8_gloidx_t)
+                           + sizeof (t8_linearidx_t) + sizeof (size_t))
+    + sizeof (size_t) + table->block_offsets[table->num_blocks] + 1;
+}
+
+/* Find the owner of a first descendant with the compact partition table.
+ * We search the last block whose first entry is smaller than or equal to
+ * the element and then decode the entries of this block. */
+static int
+t8_forest_partition_compact_search (const t8_forest_partition_compact_t *
+                                    table, t8_gloidx_t gtreeid,
+                                    t8_linearidx_t desc_id)
+{
+  int                 low, high, mid, rank, ientry, num_block_entries;
+  t8_gloidx_t         tree, element;
+  t8_linearidx_t      desc;
+  size_t              pos;
+
+  T8_ASSERT (table->num_blocks > 0);
+  /* The first nonempty process owns the first descendant of tree 0 */
+  low = 0;
+  high = table->num_blocks - 1;
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    if (table->block_trees[mid] < gtreeid
+        || (table->block_trees[mid] == gtreeid
+            && table->block_descs[mid] <= desc_id)) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  rank = table->block_ranks[low];
+  tree = table->block_trees[low];
+  desc = table->block_descs[low];
+  element = table->block_elements[low];
+  pos = table->block_offsets[low];
+  num_block_entries =
+    SC_MIN (T8_FOREST_PARTITION_COMPACT_BLOCK,
+            table->num_entries - low * T8_FOREST_PARTITION_COMPACT_BLOCK);
+  for (ientry = 1; ientry < num_block_entries; ientry++) {
+    int                 next_rank = rank;
+    t8_gloidx_t         next_tree = tree;
+    t8_linearidx_t      next_desc = desc;
+
+    t8_forest_partition_compact_next (table->stream, &pos, &next_rank,
+                                      &next_tree, &next_desc, &element);
+    if (next_tree > gtreeid || (next_tree == gtreeid && next_desc > desc_id)) {
+      /* This process starts after the element */
+      break;
+    }
+    rank = next_rank;
+    tree = next_tree;
+    desc = next_desc;
+  }
+  return rank;
+}
+
 int
 t8_forest_element_find_owner_ext (t8_forest_t forest,
                                   t8_gloidx_t gtreeid,
@@ -2059,6 +5223,21 @@ t8_forest_element_find_owner_ext (t8_forest_t forest,
     ts->t8_element_first_descendant (element, first_desc, forest->maxlevel);
   }
 
+  if (forest->partition_compact != NULL && forest->tree_offsets == NULL) {
+    /* The shared partition tables were freed, use the compressed copy */
+    guess = t8_forest_partition_compact_search (forest->partition_compact,
+                                                gtreeid,
+                                                ts->t8_element_get_linear_id
+                                                (first_desc,
+                                                 ts->t8_element_level
+                                                 (first_desc)));
+    T8_ASSERT (lower_bound <= guess && guess <= upper_bound);
+    if (!element_is_desc) {
+      ts->t8_element_destroy (1, &first_desc);
+    }
+    return guess;
+  }
+
   T8_ASSERT (forest->tree_offsets != NULL);
   T8_ASSERT (forest->global_first_desc != NULL);
 
@@ -2070,6 +5249,13 @@ t8_forest_element_find_owner_ext (t8_forest_t forest,
   element_desc_id =
     ts->t8_element_get_linear_id (first_desc,
                                   ts->t8_element_level (first_desc));
+  if (forest->owner_table != NULL) {
+    /* The owner table does not need the bounds */
+    guess = t8_forest_owner_table_search (forest->owner_table, gtreeid,
+                                          element_desc_id);
+    T8_ASSERT (lower_bound <= guess && guess <= upper_bound);
+    found = 1;
+  }
   /* Get a pointer to the element offset array */
   element_offsets = t8_shmem_array_get_gloidx_array (forest->element_offsets);
 
@@ -2210,20 +5396,12 @@ t8_forest_element_find_owner_old (t8_forest_t forest,
   ssize_t             proc_index;
   struct find_owner_data_t find_owner_data;
 
-  if (forest->tree_offsets == NULL) {
-    /* If the offset of global tree ids is not created, create it now.
-     * Once created, we do not delete it in this function, since we expect
-     * multiple calls to find_owner in a row.
-     */
-    t8_forest_partition_create_tree_offsets (forest);
-  }
-  if (forest->global_first_desc == NULL) {
-    /* If the offset of first global ids is not created, create it now.
-     * Once created, we do not delete it in this function, since we expect
-     * multiple calls to find_owner in a row.
-     */
-    t8_forest_partition_create_first_desc (forest);
-  }
+  /* If the offsets of global tree ids and first global ids are not
+   * created, create them now.
+   * Once created, we do not delete them in this function, since we expect
+   * multiple calls to find_owner in a row.
+   */
+  t8_forest_partition_create_all_offsets (forest);
 
   /* In owners_of_tree we will store all processes that have elements of the
    * tree gtreeid. */
@@ -2601,10 +5779,11 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
                                  t8_eclass_scheme_c * ts)
 {
   t8_locidx_t   ltreeid;
+  t8_tree_t     tree;
   t8_element_array_t *elements;
   t8_element_t  *last_desc, *elem_found;
   t8_locidx_t   ghost_treeid;
-  t8_linearidx_t      last_desc_id, elem_id;
+  t8_linearidx_t      last_desc_id, elem_id, found_id;
   int           index, level, level_found;
 
   T8_ASSERT (t8_forest_is_committed (forest));
@@ -2618,6 +5797,8 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
   /* TODO: set level in last_descendant */
   ts->t8_element_last_descendant (element, last_desc, forest->maxlevel);
   last_desc_id = ts->t8_element_get_linear_id (last_desc, forest->maxlevel);
+  ts->t8_element_destroy (1, &last_desc);
+  elem_id = ts->t8_element_get_linear_id (element, forest->maxlevel);
   /* Get the level of the element */
   level = ts->t8_element_level (element);
   /* Get the local id of the tree. If the tree is not a local tree,
@@ -2625,23 +5806,34 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
   ltreeid = t8_forest_get_local_id (forest, gtreeid);
   if (ltreeid >= 0) {
     /* The tree is a local tree */
-    /* Get the elements */
-    elements = t8_forest_get_tree_element_array (forest, ltreeid);
-
-    index = t8_forest_bin_search_lower (elements, last_desc_id, forest->maxlevel);
-    if (index >= 0) {
-      /* There exists an element in the array with id <= last_desc_id,
-       * If also elem_id < id, then we found a true decsendant of element */
-      elem_found = t8_element_array_index_locidx (elements, index);
-      elem_id = ts->t8_element_get_linear_id (elem_found, forest->maxlevel);
-      level_found = ts->t8_element_level (elem_found);
-      if (ts->t8_element_get_linear_id (element, forest->maxlevel)
-          <= elem_id && level < level_found) {
-        /* The element is a true descendant */
-        T8_ASSERT (ts->t8_element_level (elem_found) > ts->t8_element_level (element));
-        /* clean-up */
-        ts->t8_element_destroy (1, &last_desc);
-        return 1;
+    tree = t8_forest_get_tree (forest, ltreeid);
+    /* The leafs of the tree cover the ids from first_desc_id to
+     * last_desc_id. A leaf whose first or last descendant lies in the
+     * range of element, but differs from the element's, is a true
+     * descendant of element. This decides most queries without a search. */
+    if ((elem_id < tree->first_desc_id && tree->first_desc_id <= last_desc_id)
+        || (elem_id <= tree->last_desc_id
+            && tree->last_desc_id < last_desc_id)) {
+      return 1;
+    }
+    if (tree->first_desc_id <= last_desc_id
+        && elem_id <= tree->last_desc_id) {
+      /* The range of element lies within the range of the tree */
+      /* Get the elements */
+      elements = &tree->elements;
+
+      index = t8_forest_bin_search_lower (elements, last_desc_id, forest->maxlevel);
+      if (index >= 0) {
+        /* There exists an element in the array with id <= last_desc_id,
+         * If also elem_id < id, then we found a true decsendant of element */
+        elem_found = t8_element_array_index_locidx (elements, index);
+        found_id = ts->t8_element_get_linear_id (elem_found, forest->maxlevel);
+        level_found = ts->t8_element_level (elem_found);
+        if (elem_id <= found_id && level < level_found) {
+          /* The element is a true descendant */
+          T8_ASSERT (ts->t8_element_level (elem_found) > ts->t8_element_level (element));
+          return 1;
+        }
       }
     }
   }
@@ -2657,14 +5849,11 @@ t8_forest_element_has_leaf_desc (t8_forest_t forest, t8_gloidx_t gtreeid,
         /* There exists an element in the array with id <= last_desc_id,
          * If also elem_id < id, then we found a true decsendant of element */
         elem_found = t8_element_array_index_int (elements, index);
-        elem_id = ts->t8_element_get_linear_id (elem_found, forest->maxlevel);
+        found_id = ts->t8_element_get_linear_id (elem_found, forest->maxlevel);
         level_found = ts->t8_element_level (elem_found);
-        if (ts->t8_element_get_linear_id (element, forest->maxlevel)
-            <= elem_id && level < level_found) {
+        if (elem_id <= found_id && level < level_found) {
           /* The element is a true descendant */
           T8_ASSERT (ts->t8_element_level (elem_found) > ts->t8_element_level (element));
-          /* clean-up */
-          ts->t8_element_destroy (1, &last_desc);
           return 1;
         }
       }
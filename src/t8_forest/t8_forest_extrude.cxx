@@ -0,0 +1,375 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_extrude.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_element_cxx.hxx>
+#include <t8_default/t8_default_quad_hilbert_cxx.hxx>
+#include <t8_default/t8_default_hex_hilbert_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* A leaf of the extruded forest within its tree. Sorting by the key, the
+ * linear id of the first descendant, gives the order of the leaves. */
+typedef struct
+{
+  t8_linearidx_t      key;
+  t8_linearidx_t      id;
+  int                 level;
+} t8_forest_extrude_leaf_t;
+
+static int
+t8_forest_extrude_leaf_compare (const void *leafa, const void *leafb)
+{
+  const t8_linearidx_t keya = ((const t8_forest_extrude_leaf_t *) leafa)->key;
+  const t8_linearidx_t keyb = ((const t8_forest_extrude_leaf_t *) leafb)->key;
+
+  return keya < keyb ? -1 : keya != keyb;
+}
+
+/* The three dimensional class of a column above a tree of class eclass */
+static              t8_eclass_t
+t8_forest_extrude_eclass (t8_eclass_t eclass)
+{
+  T8_ASSERT (eclass == T8_ECLASS_TRIANGLE || eclass == T8_ECLASS_QUAD);
+  return eclass == T8_ECLASS_TRIANGLE ? T8_ECLASS_PRISM : T8_ECLASS_HEX;
+}
+
+/* Compute the linear id of the prism or hex of a given level above the
+ * triangle or quad with linear id id2 and at the line with linear id
+ * line_id. The child id of a prism or hex is the child id of its triangle
+ * or quad plus 4 times the child id of its line, thus we interleave the
+ * base 4 digits of id2 with the bits of line_id. */
+static              t8_linearidx_t
+t8_forest_extrude_linear_id (t8_linearidx_t id2, t8_linearidx_t line_id,
+                             int level)
+{
+  t8_linearidx_t      id = 0;
+  int                 i;
+
+  for (i = 0; i < level; i++) {
+    id |= ((id2 & 3) | ((line_id & 1) << 2)) << (3 * i);
+    id2 >>= 2;
+    line_id >>= 1;
+  }
+  return id;
+}
+
+/* Build the replicated three dimensional cmesh of columns above the trees
+ * of a replicated two dimensional cmesh. */
+static              t8_cmesh_t
+t8_forest_extrude_cmesh (t8_cmesh_t cmesh, int num_layers, double height,
+                         sc_MPI_Comm comm)
+{
+  t8_locidx_t         num_trees2, itree, ineigh, num_trees;
+  t8_locidx_t        *face_neighbors;
+  t8_eclass_t         eclass2, *eclasses;
+  int8_t             *ttf, ttf2;
+  double             *vertices, *tree_vertices;
+  const double       *vertices2;
+  size_t              num_vertices, vertex_offset, offset;
+  int                 ilayer, ivertex, iface, num_vertices2, num_faces2;
+  const int           F2 = t8_eclass_max_num_faces[2];
+  const int           F3 = t8_eclass_max_num_faces[3];
+  const double        layer_height = height / num_layers;
+
+  num_trees2 = t8_cmesh_get_num_local_trees (cmesh);
+  num_trees = num_trees2 * num_layers;
+  /* Count the vertices of all new trees */
+  for (itree = 0, num_vertices = 0; itree < num_trees2; itree++) {
+    num_vertices += 2 * t8_eclass_num_vertices[t8_cmesh_get_tree_class
+                                               (cmesh, itree)];
+  }
+  num_vertices *= num_layers;
+  eclasses = T8_ALLOC (t8_eclass_t, num_trees);
+  vertices = T8_ALLOC (double, 3 * num_vertices);
+  face_neighbors = T8_ALLOC (t8_locidx_t, (size_t) num_trees * F3);
+  ttf = T8_ALLOC (int8_t, (size_t) num_trees * F3);
+
+  for (itree = 0, vertex_offset = 0; itree < num_trees2; itree++) {
+    eclass2 = t8_cmesh_get_tree_class (cmesh, itree);
+    SC_CHECK_ABORT (eclass2 == T8_ECLASS_TRIANGLE
+                    || eclass2 == T8_ECLASS_QUAD,
+                    "Only triangle and quad trees can be extruded");
+    num_vertices2 = t8_eclass_num_vertices[eclass2];
+    num_faces2 = t8_eclass_num_faces[eclass2];
+    vertices2 = t8_cmesh_get_tree_vertices (cmesh, itree);
+    SC_CHECK_ABORT (vertices2 != NULL, "The trees have no vertices");
+    for (ilayer = 0; ilayer < num_layers; ilayer++) {
+      offset = (size_t) (itree * num_layers + ilayer);
+      eclasses[offset] = t8_forest_extrude_eclass (eclass2);
+      /* The vertices of the bottom face are the triangle or quad vertices
+       * and the vertices of the top face follow in the same order. */
+      tree_vertices = vertices + 3 * vertex_offset;
+      for (ivertex = 0; ivertex < num_vertices2; ivertex++) {
+        tree_vertices[3 * ivertex] = vertices2[3 * ivertex];
+        tree_vertices[3 * ivertex + 1] = vertices2[3 * ivertex + 1];
+        tree_vertices[3 * ivertex + 2] =
+          vertices2[3 * ivertex + 2] + ilayer * layer_height;
+        tree_vertices[3 * (ivertex + num_vertices2)] = vertices2[3 * ivertex];
+        tree_vertices[3 * (ivertex + num_vertices2) + 1] =
+          vertices2[3 * ivertex + 1];
+        tree_vertices[3 * (ivertex + num_vertices2) + 2] =
+          vertices2[3 * ivertex + 2] + (ilayer + 1) * layer_height;
+      }
+      vertex_offset += 2 * num_vertices2;
+      /* The side faces have the numbers of the triangle or quad faces and
+       * their corners are the face corners of the triangle or quad at the
+       * bottom followed by those at the top. Thus the connection of a side
+       * face has the same neighbor face and orientation as in 2D.
+       * Boundary faces are connected to themselves, which carries over. */
+      for (iface = 0; iface < num_faces2; iface++) {
+        ineigh =
+          t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees, itree, iface,
+                                                &ttf2);
+        face_neighbors[offset * F3 + iface] = ineigh * num_layers + ilayer;
+        ttf[offset * F3 + iface] = F3 * (ttf2 / F2) + ttf2 % F2;
+      }
+      /* The bottom and top faces connect the layers of the column */
+      face_neighbors[offset * F3 + num_faces2] =
+        ilayer > 0 ? (t8_locidx_t) offset - 1 : -1;
+      ttf[offset * F3 + num_faces2] = num_faces2 + 1;
+      face_neighbors[offset * F3 + num_faces2 + 1] =
+        ilayer < num_layers - 1 ? (t8_locidx_t) offset + 1 : -1;
+      ttf[offset * F3 + num_faces2 + 1] = num_faces2;
+    }
+  }
+  T8_ASSERT (vertex_offset == num_vertices);
+
+  cmesh = t8_cmesh_new_from_arrays (3, num_trees, eclasses, vertices,
+                                    face_neighbors, ttf, comm);
+  T8_FREE (eclasses);
+  T8_FREE (vertices);
+  T8_FREE (face_neighbors);
+  T8_FREE (ttf);
+  return cmesh;
+}
+
+/* Append the linear ids and levels of the leaves of a local tree to an
+ * array of pairs (id, level). */
+static void
+t8_forest_extrude_tree_leaves (t8_forest_t forest, t8_locidx_t itree,
+                               sc_array_t * leaves)
+{
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  t8_linearidx_t     *pair;
+  t8_locidx_t         num_elements, ielem;
+  int                 level;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest, itree));
+  num_elements = t8_forest_get_tree_num_elements (forest, itree);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    element = t8_forest_get_element_in_tree (forest, itree, ielem);
+    level = ts->t8_element_level (element);
+    pair = (t8_linearidx_t *) sc_array_push (leaves);
+    pair[0] = ts->t8_element_get_linear_id (element, level);
+    pair[1] = level;
+  }
+}
+
+/* Append the leaves of the columns above the given leaves of a tree to
+ * the leaf arrays of the extruded forest, in the order of the trees and
+ * the order within each tree. */
+static void
+t8_forest_extrude_column (t8_forest_t forest, t8_eclass_t eclass2,
+                          t8_gloidx_t gtree, int num_layers,
+                          sc_array_t * leaves, sc_array_t * column,
+                          sc_array_t * trees, sc_array_t * ids,
+                          sc_array_t * levels)
+{
+  t8_eclass_scheme_c *ts3;
+  t8_forest_extrude_leaf_t *leaf;
+  const t8_linearidx_t *pair;
+  t8_linearidx_t      line_id, num_lines;
+  size_t              ileaf;
+  int                 ilayer, level, maxlevel;
+
+  ts3 = t8_forest_get_eclass_scheme (forest,
+                                     t8_forest_extrude_eclass (eclass2));
+  maxlevel = ts3->t8_element_maxlevel ();
+  /* The leaves above the tree are the same in each layer, thus we compute
+   * and sort them once. */
+  sc_array_truncate (column);
+  for (ileaf = 0; ileaf < leaves->elem_count; ileaf++) {
+    pair = (const t8_linearidx_t *) sc_array_index (leaves, ileaf);
+    level = (int) pair[1];
+    SC_CHECK_ABORT (level <= maxlevel, "The level of a leaf exceeds the"
+                    " maximum level of the extruded elements");
+    num_lines = (t8_linearidx_t) 1 << level;
+    for (line_id = 0; line_id < num_lines; line_id++) {
+      leaf = (t8_forest_extrude_leaf_t *) sc_array_push (column);
+      leaf->id = t8_forest_extrude_linear_id (pair[0], line_id, level);
+      leaf->key = leaf->id << (3 * (maxlevel - level));
+      leaf->level = level;
+    }
+  }
+  sc_array_sort (column, t8_forest_extrude_leaf_compare);
+  for (ilayer = 0; ilayer < num_layers; ilayer++) {
+    for (ileaf = 0; ileaf < column->elem_count; ileaf++) {
+      leaf = (t8_forest_extrude_leaf_t *) sc_array_index (column, ileaf);
+      *(t8_gloidx_t *) sc_array_push (trees) = gtree * num_layers + ilayer;
+      *(t8_linearidx_t *) sc_array_push (ids) = leaf->id;
+      *(int *) sc_array_push (levels) = leaf->level;
+    }
+  }
+}
+
+t8_forest_t
+t8_forest_extrude (t8_forest_t forest, int num_layers, double height,
+                   int do_face_ghost)
+{
+  t8_cmesh_t          cmesh;
+  t8_eclass_scheme_c *ts;
+  t8_gloidx_t         bounds[2], *all_bounds, first_tree, last_tree;
+  t8_locidx_t         num_trees, itree, first_owned;
+  sc_array_t          leaves, column, trees, ids, levels;
+  sc_MPI_Request      request = sc_MPI_REQUEST_NULL;
+  sc_MPI_Status       status;
+  t8_forest_t         forest_extruded;
+  int                 mpirank, mpisize, mpiret, iproc, ieclass;
+  int                 owner, recv_count;
+  size_t              num_own_leaves;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_layers > 0);
+  SC_CHECK_ABORT (forest->dimension == 2,
+                  "Only two dimensional forests can be extruded");
+  SC_CHECK_ABORT (!t8_cmesh_is_partitioned (forest->cmesh),
+                  "Extruding a forest requires a replicated cmesh");
+  for (ieclass = T8_ECLASS_QUAD; ieclass <= T8_ECLASS_HEX; ieclass++) {
+    /* The Hilbert curves do not interleave the ids of the faces and lines */
+    ts = forest->scheme_cxx->eclass_schemes[ieclass];
+    SC_CHECK_ABORT (dynamic_cast < t8_default_scheme_quad_hilbert_c * >(ts)
+                    == NULL
+                    && dynamic_cast < t8_default_scheme_hex_hilbert_c * >(ts)
+                    == NULL, "Extruding a forest requires a Morton scheme");
+  }
+  mpirank = forest->mpirank;
+  mpisize = forest->mpisize;
+
+  /* Gather the first and last local tree of each process. An empty
+   * process has a last tree smaller than its first tree. */
+  num_trees = t8_forest_get_num_local_trees (forest);
+  bounds[0] = num_trees > 0 ? forest->first_local_tree : 0;
+  bounds[1] = num_trees > 0 ? forest->last_local_tree : -1;
+  all_bounds = T8_ALLOC (t8_gloidx_t, 2 * mpisize);
+  mpiret = sc_MPI_Allgather (bounds, 2, T8_MPI_GLOIDX, all_bounds, 2,
+                             T8_MPI_GLOIDX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* A column belongs to the first process that has elements of its tree.
+   * We find the owner of our first tree, which is the first process whose
+   * last tree is not smaller than it. */
+  first_tree = bounds[0];
+  last_tree = bounds[1];
+  for (owner = 0; owner < mpirank; owner++) {
+    if (all_bounds[2 * owner] <= all_bounds[2 * owner + 1]
+        && all_bounds[2 * owner + 1] >= first_tree) {
+      break;
+    }
+  }
+
+  sc_array_init (&leaves, 2 * sizeof (t8_linearidx_t));
+  first_owned = 0;
+  if (num_trees > 0 && owner < mpirank) {
+    /* Our first tree is shared with lower processes, we send its leaves
+     * to the owner of its column */
+    t8_forest_extrude_tree_leaves (forest, 0, &leaves);
+    mpiret = sc_MPI_Isend (leaves.array,
+                           leaves.elem_count * leaves.elem_size, sc_MPI_BYTE,
+                           owner, T8_MPI_EXTRUDE, forest->mpicomm, &request);
+    SC_CHECK_MPI (mpiret);
+    first_owned = 1;
+  }
+
+  sc_array_init (&column, sizeof (t8_forest_extrude_leaf_t));
+  sc_array_init (&trees, sizeof (t8_gloidx_t));
+  sc_array_init (&ids, sizeof (t8_linearidx_t));
+  sc_array_init (&levels, sizeof (int));
+  for (itree = first_owned; itree < num_trees; itree++) {
+    /* The leaves of the first tree may still be sent, thus we collect
+     * the leaves of each owned tree in a new array */
+    sc_array_t          tree_leaves;
+
+    sc_array_init (&tree_leaves, 2 * sizeof (t8_linearidx_t));
+    t8_forest_extrude_tree_leaves (forest, itree, &tree_leaves);
+    if (itree == num_trees - 1) {
+      /* Receive the leaves of our last tree from the following processes
+       * that share it, in the order of their ranks */
+      for (iproc = mpirank + 1; iproc < mpisize
+           && (all_bounds[2 * iproc] > all_bounds[2 * iproc + 1]
+               || all_bounds[2 * iproc] == last_tree); iproc++) {
+        if (all_bounds[2 * iproc] > all_bounds[2 * iproc + 1]) {
+          /* This process is empty */
+          continue;
+        }
+        mpiret = sc_MPI_Probe (iproc, T8_MPI_EXTRUDE, forest->mpicomm,
+                               &status);
+        SC_CHECK_MPI (mpiret);
+        mpiret = sc_MPI_Get_count (&status, sc_MPI_BYTE, &recv_count);
+        SC_CHECK_MPI (mpiret);
+        num_own_leaves = tree_leaves.elem_count;
+        sc_array_resize (&tree_leaves, num_own_leaves +
+                         recv_count / tree_leaves.elem_size);
+        mpiret = sc_MPI_Recv (sc_array_index (&tree_leaves, num_own_leaves),
+                              recv_count, sc_MPI_BYTE, iproc,
+                              T8_MPI_EXTRUDE, forest->mpicomm,
+                              sc_MPI_STATUS_IGNORE);
+        SC_CHECK_MPI (mpiret);
+      }
+    }
+    t8_forest_extrude_column (forest, t8_forest_get_tree_class (forest,
+                                                                itree),
+                              forest->first_local_tree + itree, num_layers,
+                              &tree_leaves, &column, &trees, &ids, &levels);
+    sc_array_reset (&tree_leaves);
+  }
+  mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  sc_array_reset (&leaves);
+  sc_array_reset (&column);
+  T8_FREE (all_bounds);
+
+  cmesh = t8_forest_extrude_cmesh (forest->cmesh, num_layers, height,
+                                   forest->mpicomm);
+  t8_scheme_cxx_ref (forest->scheme_cxx);
+  /* The leaves are already distributed by columns, which we keep */
+  forest_extruded =
+    t8_forest_new_from_leaves (cmesh, forest->scheme_cxx,
+                               (t8_locidx_t) trees.elem_count,
+                               (const t8_gloidx_t *) trees.array,
+                               (const t8_linearidx_t *) ids.array,
+                               (const int *) levels.array, 0, do_face_ghost,
+                               forest->mpicomm);
+  sc_array_reset (&trees);
+  sc_array_reset (&ids);
+  sc_array_reset (&levels);
+  return forest_extruded;
+}
+
+T8_EXTERN_C_END ();
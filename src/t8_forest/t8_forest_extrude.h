@@ -0,0 +1,68 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_extrude.h
+ * Extrude a two dimensional forest into a forest of columns.
+ *
+ * Each triangle tree of the coarse mesh becomes a column of prism trees and
+ * each quad tree a column of hex trees. Each leaf of the two dimensional
+ * forest becomes the prisms or hexes of the same level that lie above it,
+ * thus the horizontal refinement carries over and the vertical refinement
+ * in each layer matches it. The coarse mesh and the elements of the new
+ * forest are built directly, without refining a three dimensional forest.
+ */
+
+#ifndef T8_FOREST_EXTRUDE_H
+#define T8_FOREST_EXTRUDE_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Extrude a committed two dimensional forest into a prism and hex forest.
+ * Tree t of the coarse mesh of \a forest becomes the trees
+ * t * \a num_layers, ..., (t + 1) * \a num_layers - 1 of the new coarse mesh,
+ * from bottom to top. Layer k spans the heights z + k * \a height / \a num_layers
+ * to z + (k + 1) * \a height / \a num_layers above the vertices of t.
+ * A leaf of level l is extruded to \a num_layers times 2^l elements of
+ * level l.
+ * The new forest is partitioned by columns: all elements above a leaf of
+ * \a forest are on the process that owns the first element of its tree.
+ * \param [in] forest       A committed forest of triangles and quads on a
+ *                          replicated cmesh, with a scheme whose prism and hex
+ *                          linear ids interleave the triangle and quad linear
+ *                          ids with the line linear ids, as the default scheme.
+ *                          We do not take ownership.
+ * \param [in] num_layers   The number of trees in each column. Must be > 0.
+ * \param [in] height       The height of each column.
+ * \param [in] do_face_ghost If true, a layer of ghost elements is created for
+ *                          the new forest.
+ * \return                  The committed extruded forest. Its cmesh is replicated.
+ * \note This function is collective over the communicator of \a forest.
+ */
+t8_forest_t         t8_forest_extrude (t8_forest_t forest, int num_layers,
+                                       double height, int do_face_ghost);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_EXTRUDE_H */
@@ -0,0 +1,489 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_fields.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_element_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* Return the number of fields of a committed or uncommitted forest */
+static int
+t8_forest_fields_count (t8_forest_t forest)
+{
+  return forest->fields == NULL ? 0 : (int) forest->fields->elem_count;
+}
+
+static t8_forest_field_t *
+t8_forest_fields_index (t8_forest_t forest, int ifield)
+{
+  T8_ASSERT (0 <= ifield && ifield < t8_forest_fields_count (forest));
+  return (t8_forest_field_t *) sc_array_index_int (forest->fields, ifield);
+}
+
+/* Add a field without entries to a forest */
+static t8_forest_field_t *
+t8_forest_fields_push (t8_forest_t forest, const char *name,
+                       size_t elem_size, t8_forest_field_policy_t policy,
+                       t8_forest_field_interpolate_t interpolate,
+                       void *user_data)
+{
+  t8_forest_field_t  *field;
+
+  if (forest->fields == NULL) {
+    forest->fields = sc_array_new (sizeof (t8_forest_field_t));
+  }
+  field = (t8_forest_field_t *) sc_array_push (forest->fields);
+  field->name = T8_ALLOC (char, strlen (name) + 1);
+  strcpy (field->name, name);
+  field->policy = policy;
+  field->interpolate = interpolate;
+  field->user_data = user_data;
+  sc_array_init (&field->data, elem_size);
+  return field;
+}
+
+static void
+t8_forest_fields_reset (t8_forest_field_t * field)
+{
+  T8_FREE (field->name);
+  sc_array_reset (&field->data);
+}
+
+int
+t8_forest_field_register (t8_forest_t forest, const char *name,
+                          size_t elem_size, t8_forest_field_policy_t policy,
+                          t8_forest_field_interpolate_t interpolate,
+                          void *user_data)
+{
+  t8_forest_field_t  *field;
+  size_t              num_entries;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (name != NULL && elem_size > 0);
+  T8_ASSERT (policy != T8_FOREST_FIELD_AVERAGE
+             || elem_size % sizeof (double) == 0);
+  T8_ASSERT ((policy == T8_FOREST_FIELD_USER) == (interpolate != NULL));
+  SC_CHECK_ABORTF (t8_forest_field_find (forest, name) < 0,
+                   "A field with name %s already exists.\n", name);
+
+  field = t8_forest_fields_push (forest, name, elem_size, policy,
+                                 interpolate, user_data);
+  num_entries = (size_t) t8_forest_get_num_element (forest)
+    + t8_forest_get_num_ghosts (forest);
+  sc_array_resize (&field->data, num_entries);
+  memset (field->data.array, 0, num_entries * elem_size);
+  return t8_forest_fields_count (forest) - 1;
+}
+
+void
+t8_forest_field_unregister (t8_forest_t forest, int ifield)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  t8_forest_fields_reset (t8_forest_fields_index (forest, ifield));
+  /* Close the gap in the array of fields */
+  memmove (sc_array_index_int (forest->fields, ifield),
+           (char *) sc_array_index_int (forest->fields, ifield) +
+           sizeof (t8_forest_field_t),
+           (forest->fields->elem_count - ifield - 1)
+           * sizeof (t8_forest_field_t));
+  sc_array_resize (forest->fields, forest->fields->elem_count - 1);
+}
+
+int
+t8_forest_field_num (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return t8_forest_fields_count (forest);
+}
+
+int
+t8_forest_field_find (t8_forest_t forest, const char *name)
+{
+  int                 ifield;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  for (ifield = 0; ifield < t8_forest_fields_count (forest); ifield++) {
+    if (!strcmp (t8_forest_fields_index (forest, ifield)->name, name)) {
+      return ifield;
+    }
+  }
+  return -1;
+}
+
+const char         *
+t8_forest_field_get_name (t8_forest_t forest, int ifield)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return t8_forest_fields_index (forest, ifield)->name;
+}
+
+sc_array_t         *
+t8_forest_field_get_data (t8_forest_t forest, int ifield)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  return &t8_forest_fields_index (forest, ifield)->data;
+}
+
+void
+t8_forest_field_ghost_exchange (t8_forest_t forest)
+{
+  t8_forest_field_t  *field;
+  sc_array_t          combined;
+  size_t              elem_size, offset, num_entries, ientry;
+  int                 ifield, num_fields;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  num_fields = t8_forest_fields_count (forest);
+  if (forest->ghosts == NULL || num_fields == 0) {
+    return;
+  }
+  if (num_fields == 1) {
+    t8_forest_ghost_exchange_data (forest,
+                                   &t8_forest_fields_index (forest,
+                                                            0)->data);
+    return;
+  }
+  /* Interleave the entries of all fields, such that they are exchanged
+   * in one message per process */
+  elem_size = 0;
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    elem_size += t8_forest_fields_index (forest, ifield)->data.elem_size;
+  }
+  num_entries = t8_forest_fields_index (forest, 0)->data.elem_count;
+  sc_array_init_size (&combined, elem_size, num_entries);
+  for (ifield = 0, offset = 0; ifield < num_fields; ifield++) {
+    field = t8_forest_fields_index (forest, ifield);
+    T8_ASSERT (field->data.elem_count == num_entries);
+    for (ientry = 0; ientry < (size_t) forest->local_num_elements; ientry++) {
+      memcpy (combined.array + ientry * elem_size + offset,
+              sc_array_index (&field->data, ientry), field->data.elem_size);
+    }
+    offset += field->data.elem_size;
+  }
+  t8_forest_ghost_exchange_data (forest, &combined);
+  for (ifield = 0, offset = 0; ifield < num_fields; ifield++) {
+    field = t8_forest_fields_index (forest, ifield);
+    for (ientry = forest->local_num_elements; ientry < num_entries; ientry++) {
+      memcpy (sc_array_index (&field->data, ientry),
+              combined.array + ientry * elem_size + offset,
+              field->data.elem_size);
+    }
+    offset += field->data.elem_size;
+  }
+  sc_array_reset (&combined);
+}
+
+void
+t8_forest_fields_inherit (t8_forest_t forest, t8_forest_t forest_from)
+{
+  t8_forest_field_t  *field;
+  int                 ifield;
+
+  T8_ASSERT (forest->fields == NULL);
+  for (ifield = 0; ifield < t8_forest_fields_count (forest_from); ifield++) {
+    field = t8_forest_fields_index (forest_from, ifield);
+    t8_forest_fields_push (forest, field->name, field->data.elem_size,
+                           field->policy, field->interpolate,
+                           field->user_data);
+  }
+}
+
+void
+t8_forest_fields_copy (t8_forest_t forest, t8_forest_t forest_from)
+{
+  t8_forest_field_t  *field, *field_from;
+  int                 ifield;
+
+  T8_ASSERT (t8_forest_fields_count (forest) ==
+             t8_forest_fields_count (forest_from));
+  for (ifield = 0; ifield < t8_forest_fields_count (forest); ifield++) {
+    field = t8_forest_fields_index (forest, ifield);
+    field_from = t8_forest_fields_index (forest_from, ifield);
+    sc_array_resize (&field->data, forest_from->local_num_elements);
+    memcpy (field->data.array, field_from->data.array,
+            forest_from->local_num_elements * field->data.elem_size);
+  }
+}
+
+/* Interpolate the entries of one field from num_outgoing old elements to
+ * num_incoming new elements. One of the two numbers is 1. */
+static void
+t8_forest_fields_interpolate (const t8_forest_field_t * field,
+                              t8_forest_t forest_from, t8_forest_t forest,
+                              t8_locidx_t ltreeid, int num_outgoing,
+                              t8_locidx_t first_outgoing,
+                              const char *outgoing, int num_incoming,
+                              t8_locidx_t first_incoming, char *incoming)
+{
+  const size_t        elem_size = field->data.elem_size;
+  double             *mean;
+  size_t              num_values, ivalue;
+  int                 i;
+
+  T8_ASSERT (num_outgoing == 1 || num_incoming == 1);
+  switch (field->policy) {
+  case T8_FOREST_FIELD_AVERAGE:
+    if (num_outgoing > 1) {
+      /* The coarse element gets the mean of its children */
+      num_values = elem_size / sizeof (double);
+      mean = (double *) incoming;
+      memcpy (mean, outgoing, elem_size);
+      for (i = 1; i < num_outgoing; i++) {
+        for (ivalue = 0; ivalue < num_values; ivalue++) {
+          mean[ivalue] +=
+            ((const double *) (outgoing + i * elem_size))[ivalue];
+        }
+      }
+      for (ivalue = 0; ivalue < num_values; ivalue++) {
+        mean[ivalue] /= num_outgoing;
+      }
+      return;
+    }
+    /* Refined elements are copied */
+  case T8_FOREST_FIELD_COPY:
+    /* Either copy the old element to all new elements, or copy the
+     * first old element to the new element */
+    for (i = 0; i < num_incoming; i++) {
+      memcpy (incoming + i * elem_size, outgoing, elem_size);
+    }
+    return;
+  case T8_FOREST_FIELD_USER:
+    field->interpolate (forest_from, forest, ltreeid, num_outgoing,
+                        first_outgoing, outgoing, num_incoming,
+                        first_incoming, incoming, elem_size,
+                        field->user_data);
+    return;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+/* Return true if elem_new is a descendant of elem_old, which has level level_old */
+static int
+t8_forest_fields_is_descendant (t8_eclass_scheme_c * ts,
+                                const t8_element_t * elem_new,
+                                const t8_element_t * elem_old, int level_old)
+{
+  return ts->t8_element_level (elem_new) >= level_old
+    && ts->t8_element_get_linear_id (elem_new, level_old) ==
+    ts->t8_element_get_linear_id (elem_old, level_old);
+}
+
+void
+t8_forest_fields_adapt (t8_forest_t forest, t8_forest_t forest_from)
+{
+  t8_forest_field_t  *field, *field_from;
+  t8_tree_t           tree, tree_from;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *elem, *elem_from;
+  t8_locidx_t         itree, num_trees, num_elements, offset;
+  t8_locidx_t         ielem, ielem_from, num_elems, num_elems_from;
+  t8_locidx_t         num_incoming, num_outgoing;
+  int                 ifield, num_fields, level, level_from;
+
+  num_fields = t8_forest_fields_count (forest);
+  T8_ASSERT (num_fields == t8_forest_fields_count (forest_from));
+  if (num_fields == 0) {
+    return;
+  }
+  num_trees = (t8_locidx_t) forest->trees->elem_count;
+  T8_ASSERT (num_trees == t8_forest_get_num_local_trees (forest_from));
+  num_elements = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    num_elements +=
+      (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+  }
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    sc_array_resize (&t8_forest_fields_index (forest, ifield)->data,
+                     num_elements);
+  }
+
+  /* Walk through the old and new elements of each tree in parallel.
+   * Runs of unchanged elements are copied at once, for refined and
+   * coarsened elements the fields are interpolated. */
+  offset = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    tree_from = t8_forest_get_tree (forest_from, itree);
+    T8_ASSERT (tree->eclass == tree_from->eclass);
+    ts = t8_forest_get_eclass_scheme (forest_from, tree_from->eclass);
+    num_elems = (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+    num_elems_from =
+      (t8_locidx_t) t8_element_array_get_count (&tree_from->elements);
+    if (num_elems_from == 0 && num_elems > 0) {
+      /* An empty tree stays empty when adapted. Thus t8_forest_adapt
+       * consumed forest_from and took over the elements of this unchanged
+       * tree. Its values are still stored at the old offset. */
+      for (ifield = 0; ifield < num_fields; ifield++) {
+        field = t8_forest_fields_index (forest, ifield);
+        field_from = t8_forest_fields_index (forest_from, ifield);
+        memcpy (sc_array_index (&field->data, offset),
+                sc_array_index (&field_from->data, tree_from->elements_offset),
+                num_elems * field->data.elem_size);
+      }
+      offset += num_elems;
+      continue;
+    }
+    for (ielem = 0, ielem_from = 0; ielem_from < num_elems_from;) {
+      T8_ASSERT (ielem < num_elems);
+      elem = t8_element_array_index_locidx (&tree->elements, ielem);
+      elem_from =
+        t8_element_array_index_locidx (&tree_from->elements, ielem_from);
+      level = ts->t8_element_level (elem);
+      level_from = ts->t8_element_level (elem_from);
+      if (level == level_from) {
+        /* Both elements are the same and so are the following elements
+         * with equal levels */
+        num_outgoing = 1;
+        while (ielem + num_outgoing < num_elems
+               && ielem_from + num_outgoing < num_elems_from
+               && ts->t8_element_level (t8_element_array_index_locidx
+                                        (&tree->elements,
+                                         ielem + num_outgoing)) ==
+               ts->t8_element_level (t8_element_array_index_locidx
+                                     (&tree_from->elements,
+                                      ielem_from + num_outgoing))) {
+          T8_ASSERT (!ts->t8_element_compare
+                     (t8_element_array_index_locidx
+                      (&tree->elements, ielem + num_outgoing),
+                      t8_element_array_index_locidx
+                      (&tree_from->elements, ielem_from + num_outgoing)));
+          num_outgoing++;
+        }
+        for (ifield = 0; ifield < num_fields; ifield++) {
+          field = t8_forest_fields_index (forest, ifield);
+          field_from = t8_forest_fields_index (forest_from, ifield);
+          memcpy (sc_array_index (&field->data, offset + ielem),
+                  sc_array_index (&field_from->data,
+                                  tree_from->elements_offset + ielem_from),
+                  num_outgoing * field->data.elem_size);
+        }
+        ielem += num_outgoing;
+        ielem_from += num_outgoing;
+        continue;
+      }
+      num_incoming = num_outgoing = 1;
+      if (level > level_from) {
+        /* elem_from was refined, possibly recursively */
+        while (ielem + num_incoming < num_elems
+               && t8_forest_fields_is_descendant (ts,
+                                                  t8_element_array_index_locidx
+                                                  (&tree->elements,
+                                                   ielem + num_incoming),
+                                                  elem_from, level_from)) {
+          num_incoming++;
+        }
+      }
+      else {
+        /* The family of elem_from was coarsened, possibly recursively */
+        while (ielem_from + num_outgoing < num_elems_from
+               && t8_forest_fields_is_descendant (ts,
+                                                  t8_element_array_index_locidx
+                                                  (&tree_from->elements,
+                                                   ielem_from +
+                                                   num_outgoing), elem,
+                                                  level)) {
+          num_outgoing++;
+        }
+      }
+      for (ifield = 0; ifield < num_fields; ifield++) {
+        field = t8_forest_fields_index (forest, ifield);
+        field_from = t8_forest_fields_index (forest_from, ifield);
+        t8_forest_fields_interpolate (field, forest_from, forest, itree,
+                                      num_outgoing, ielem_from,
+                                      (const char *)
+                                      sc_array_index (&field_from->data,
+                                                      tree_from->
+                                                      elements_offset +
+                                                      ielem_from),
+                                      num_incoming, ielem,
+                                      (char *) sc_array_index (&field->data,
+                                                               offset +
+                                                               ielem));
+      }
+      ielem += num_incoming;
+      ielem_from += num_outgoing;
+    }
+    T8_ASSERT (ielem == num_elems);
+    offset += num_elems;
+  }
+}
+
+void
+t8_forest_fields_set_partition (t8_forest_t forest, t8_forest_t forest_from)
+{
+  t8_forest_field_t  *field;
+  int                 ifield;
+
+  T8_ASSERT (t8_forest_fields_count (forest) ==
+             t8_forest_fields_count (forest_from));
+  for (ifield = 0; ifield < t8_forest_fields_count (forest); ifield++) {
+    field = t8_forest_fields_index (forest, ifield);
+    /* Only the local entries are partitioned, the ghost entries are
+     * exchanged after the ghost layer is built */
+    sc_array_init_view (&field->source,
+                        &t8_forest_fields_index (forest_from,
+                                                 ifield)->data, 0,
+                        forest_from->local_num_elements);
+    t8_forest_set_partition_data (forest, &field->source, &field->data);
+  }
+}
+
+void
+t8_forest_fields_commit_ghosts (t8_forest_t forest)
+{
+  int                 ifield;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  for (ifield = 0; ifield < t8_forest_fields_count (forest); ifield++) {
+    sc_array_resize (&t8_forest_fields_index (forest, ifield)->data,
+                     (size_t) forest->local_num_elements +
+                     t8_forest_get_num_ghosts (forest));
+  }
+  t8_forest_field_ghost_exchange (forest);
+}
+
+void
+t8_forest_fields_destroy (t8_forest_t forest)
+{
+  int                 ifield;
+
+  if (forest->fields == NULL) {
+    return;
+  }
+  for (ifield = 0; ifield < t8_forest_fields_count (forest); ifield++) {
+    t8_forest_fields_reset (t8_forest_fields_index (forest, ifield));
+  }
+  sc_array_destroy (forest->fields);
+  forest->fields = NULL;
+}
+
+T8_EXTERN_C_END ();
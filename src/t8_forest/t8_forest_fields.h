@@ -0,0 +1,170 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_fields.h
+ * Element data fields that are attached to a forest and follow its
+ * elements through adapt, balance, partition and ghost exchange.
+ *
+ * A field stores one entry of a fixed size for each local element of a
+ * forest, followed by one entry for each ghost element. When a new forest
+ * is committed from a forest with fields, it gets the same fields and their
+ * values are transferred from the old elements to the new ones:
+ * Unchanged elements are copied in blocks, refined and coarsened elements
+ * are interpolated according to the policy of the field, partitioning sends
+ * the fields in the same messages as the elements, and the ghost entries
+ * are filled by a ghost exchange. This replaces the replace callbacks of
+ * \ref t8_forest_iterate_replace and separate calls to
+ * \ref t8_forest_partition_data in the common cases.
+ */
+
+#ifndef T8_FOREST_FIELDS_H
+#define T8_FOREST_FIELDS_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** How the values of a field are transferred to refined and coarsened
+ * elements. Unchanged elements always keep their value. */
+typedef enum t8_forest_field_policy
+{
+  T8_FOREST_FIELD_COPY = 0,     /**< The children of a refined element copy its value.
+                                     A coarsened element gets the value of its
+                                     first child (injection). Works for any entry. */
+  T8_FOREST_FIELD_AVERAGE,      /**< As \ref T8_FOREST_FIELD_COPY, but a coarsened
+                                     element gets the arithmetic mean of its children.
+                                     The entries must consist of doubles. */
+  T8_FOREST_FIELD_USER          /**< Refined and coarsened elements are interpolated
+                                     by a callback, \see t8_forest_field_interpolate_t. */
+} t8_forest_field_policy_t;
+
+/** Callback function prototype to interpolate the values of a field from
+ * old to new elements.
+ * It is called for each refined element and each coarsened family, but not
+ * for unchanged elements, whose entries are copied.
+ * \param [in] forest_old      The forest whose elements are replaced.
+ * \param [in] forest_new      The forest that is constructed from \a forest_old.
+ *                             It is not committed yet.
+ * \param [in] which_tree      The local tree containing the elements.
+ * \param [in] num_outgoing    The number of old elements.
+ * \param [in] first_outgoing  The tree local index of the first old element.
+ * \param [in] outgoing        The \a num_outgoing entries of the old elements.
+ * \param [in] num_incoming    The number of new elements.
+ * \param [in] first_incoming  The tree local index of the first new element.
+ * \param [out] incoming       The \a num_incoming entries of the new elements.
+ * \param [in] elem_size       The size of one entry in bytes.
+ * \param [in] user_data       The user data of the field.
+ * \see t8_forest_field_register
+ */
+typedef void        (*t8_forest_field_interpolate_t) (t8_forest_t forest_old,
+                                                      t8_forest_t forest_new,
+                                                      t8_locidx_t which_tree,
+                                                      int num_outgoing,
+                                                      t8_locidx_t
+                                                      first_outgoing,
+                                                      const void *outgoing,
+                                                      int num_incoming,
+                                                      t8_locidx_t
+                                                      first_incoming,
+                                                      void *incoming,
+                                                      size_t elem_size,
+                                                      void *user_data);
+
+T8_EXTERN_C_BEGIN ();
+
+/** Attach a new element data field to a committed forest.
+ * The field has one entry for each local element followed by one entry for
+ * each ghost element. All entries are initialized to zero. After writing the
+ * entries of the local elements, call \ref t8_forest_field_ghost_exchange
+ * to fill the ghost entries.
+ * Forests that are committed from \a forest inherit the field.
+ * \param [in,out] forest    A committed forest.
+ * \param [in]     name      The name of the field. It must be unique among the
+ *                           fields of \a forest. The string is copied.
+ * \param [in]     elem_size The size of one entry in bytes.
+ * \param [in]     policy    How the field is interpolated during adapt.
+ * \param [in]     interpolate If \a policy is \ref T8_FOREST_FIELD_USER, the
+ *                           interpolation callback. Must be NULL otherwise.
+ * \param [in]     user_data User data that is passed to \a interpolate.
+ * \return                   The index of the new field in \a forest.
+ */
+int                 t8_forest_field_register (t8_forest_t forest,
+                                              const char *name,
+                                              size_t elem_size,
+                                              t8_forest_field_policy_t policy,
+                                              t8_forest_field_interpolate_t
+                                              interpolate, void *user_data);
+
+/** Remove a field from a forest and free its data.
+ * The indices of the fields after \a ifield decrease by one.
+ * Forests that were already committed from \a forest keep their copy.
+ * \param [in,out] forest    A committed forest.
+ * \param [in]     ifield    The index of a field of \a forest.
+ */
+void                t8_forest_field_unregister (t8_forest_t forest,
+                                                int ifield);
+
+/** Return the number of fields of a forest.
+ * \param [in]     forest    A committed forest.
+ * \return                   The number of fields attached to \a forest.
+ */
+int                 t8_forest_field_num (t8_forest_t forest);
+
+/** Find a field of a forest by its name.
+ * \param [in]     forest    A committed forest.
+ * \param [in]     name      The name of a field.
+ * \return                   The index of the field with name \a name,
+ *                           or -1 if \a forest has no such field.
+ */
+int                 t8_forest_field_find (t8_forest_t forest,
+                                          const char *name);
+
+/** Return the name of a field.
+ * \param [in]     forest    A committed forest.
+ * \param [in]     ifield    The index of a field of \a forest.
+ * \return                   The name of the field.
+ */
+const char         *t8_forest_field_get_name (t8_forest_t forest,
+                                              int ifield);
+
+/** Return the data of a field.
+ * \param [in]     forest    A committed forest.
+ * \param [in]     ifield    The index of a field of \a forest.
+ * \return                   An array with one entry for each local element
+ *                           followed by one entry for each ghost element.
+ *                           The entries may be modified, but the array may
+ *                           not be resized.
+ */
+sc_array_t         *t8_forest_field_get_data (t8_forest_t forest,
+                                              int ifield);
+
+/** Fill the ghost entries of all fields of a forest with the values of
+ * their owners. All fields are sent in one message per pair of processes.
+ * This is done when a forest is committed; call it again after the
+ * entries of the local elements were changed.
+ * \param [in,out] forest    A committed forest.
+ * \note This function is collective.
+ */
+void                t8_forest_field_ghost_exchange (t8_forest_t forest);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_FIELDS_H */
@@ -29,6 +29,38 @@
 #include <t8_cmesh/t8_cmesh_trees.h>
 #include <t8_element_cxx.hxx>
 #include <t8_data/t8_containers.h>
+#include <t8_profile_regions.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* We store a direct map from global tree ids to ghost trees if the range of
+ * the ids is at most this factor times the number of ghost trees. */
+#define T8_GHOST_TREE_MAP_FACTOR 4
+
+#if defined (SC_ENABLE_MPI) && MPI_VERSION >= 3
+/* MPI provides distributed graph communicators and neighborhood collectives */
+#define T8_GHOST_NEIGHBOR_COLLECTIVES
+/* MPI provides shared memory windows */
+#define T8_GHOST_SHARED_WINDOWS
+#endif
+#ifdef SC_ENABLE_MPI
+/* MPI provides one-sided communication */
+#define T8_GHOST_RMA
+#endif
+
+/* The current time if profiling is enabled for forest, 0 otherwise */
+#define T8_GHOST_PROFILE_TIME(forest) \
+  ((forest)->profile != NULL ? sc_MPI_Wtime () : 0)
+
+/* If profiling is enabled, add the time since start to a runtime
+ * of the profile */
+#define T8_GHOST_PROFILE_ADD(forest, runtime, start) \
+  do { \
+    if ((forest)->profile != NULL) { \
+      (forest)->profile->runtime += sc_MPI_Wtime () - (start); \
+    } \
+  } while (0)
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -40,6 +72,7 @@ typedef struct
 {
   int                 recv_rank;        /* The rank to which we send. */
   size_t              num_bytes;        /* The number of bytes that we send. */
+  int                 message_size;     /* num_bytes, sent ahead of the message */
   sc_MPI_Request     *request;  /* Commuication request, not owned by this struct. */
   char               *buffer;   /* The send buffer. */
 } t8_ghost_mpi_send_info_t;
@@ -53,13 +86,6 @@ typedef struct
   t8_eclass_t         eclass;   /* The trees element class */
 } t8_ghost_tree_t;
 
-/* The data structure stored in the global_tree_to_ghost_tree hash table. */
-typedef struct
-{
-  t8_gloidx_t         global_id;        /* global tree id */
-  size_t              index;    /* the index of that global tree in the ghost_trees array. */
-} t8_ghost_gtree_hash_t;
-
 /* The data structure stored in the process_offsets array. */
 typedef struct
 {
@@ -68,7 +94,7 @@ typedef struct
   size_t              tree_index;       /* index of first ghost tree of this process in ghost_trees */
   size_t              first_element;    /* the index of the first element in the elements array
                                            of the ghost tree. */
-} t8_ghost_process_hash_t;
+} t8_ghost_process_info_t;
 
 /* The information stored for the remote trees.
  * Each remote process stores an array of these */
@@ -88,9 +114,8 @@ typedef struct
   sc_array_t          remote_trees;     /* Array of the remote trees of this process */
 } t8_ghost_remote_t;
 
-#if 0
-/* Compare two ghost_tree entries. We need this function to sort the
- * ghost_trees array by global_id. */
+/* Compare two ghost_tree entries by their global_id.
+ * The ghost_trees array is sorted with respect to this order. */
 static int
 t8_ghost_tree_compare (const void *tree_a, const void *tree_b)
 {
@@ -102,61 +127,6 @@ t8_ghost_tree_compare (const void *tree_a, const void *tree_b)
   }
   return A->global_id != B->global_id;
 }
-#endif
-
-/* The hash function for the global tree hash.
- * As hash value we just return the global tree id. */
-static unsigned
-t8_ghost_gtree_hash_function (const void *ghost_gtree_hash, const void *data)
-{
-  const t8_ghost_gtree_hash_t *object =
-    (const t8_ghost_gtree_hash_t *) ghost_gtree_hash;
-
-  return (unsigned) object->global_id;
-}
-
-/* The equal function for two global tree hash objects.
- * Two t8_ghost_gtree_hash_t are considered equal if theit global
- * tree ids are the same.
- */
-static int
-t8_ghost_gtree_equal_function (const void *ghost_gtreea,
-                               const void *ghost_gtreeb, const void *user)
-{
-  const t8_ghost_gtree_hash_t *objecta =
-    (const t8_ghost_gtree_hash_t *) ghost_gtreea;
-  const t8_ghost_gtree_hash_t *objectb =
-    (const t8_ghost_gtree_hash_t *) ghost_gtreeb;
-
-  /* return true if and only if the global_ids are the same */
-  return objecta->global_id == objectb->global_id;
-}
-
-/* The hash value for an entry of the process_offsets hash is the
- * processes mpirank. */
-static unsigned
-t8_ghost_process_hash_function (const void *process_data,
-                                const void *user_data)
-{
-  const t8_ghost_process_hash_t *process =
-    (const t8_ghost_process_hash_t *) process_data;
-
-  return process->mpirank;
-}
-
-/* The equal function for the process_offsets array.
- * Two entries are the same if their mpiranks are equal. */
-static int
-t8_ghost_process_equal_function (const void *process_dataa,
-                                 const void *process_datab, const void *user)
-{
-  const t8_ghost_process_hash_t *processa =
-    (const t8_ghost_process_hash_t *) process_dataa;
-  const t8_ghost_process_hash_t *processb =
-    (const t8_ghost_process_hash_t *) process_datab;
-
-  return processa->mpirank == processb->mpirank;
-}
 
 /* The hash funtion for the remote_ghosts hash table.
  * The hash value for an mpirank is just the rank */
@@ -184,17 +154,207 @@ t8_ghost_remote_equal_function (const void *remote_dataa,
  * Since we use asynchronuous communication, we store the
  * send buffers and mpi requests until we end the communication.
  */
-typedef struct
+struct t8_ghost_data_exchange
 {
   int                 num_remotes;
                     /** The number of processes, we send to */
-  char              **send_buffers;
-                      /** For each remote the send buffer */
+  char               *send_buffer;
+                      /** One send buffer for all remotes. The data for the i-th
+                          remote starts at send_offsets[i] times the data size. */
+  size_t              buffer_bytes;
+                      /** The number of allocated bytes of send_buffer */
+  char               *recv_buffer;
+                      /** If the data is not received directly, the receive buffer
+                          for all remotes. */
+  size_t              recv_buffer_bytes;
+                      /** The number of allocated bytes of recv_buffer */
+  int                 recv_direct;
+                      /** True if we receive directly into the only field */
+  int                 num_fields;
+                      /** The number of exchanged fields */
+  int                 fields_alloc;
+                      /** The number of allocated entries of fields */
+  t8_ghost_field_t   *fields;
+                      /** The exchanged fields */
+  size_t              data_size;
+                      /** The number of bytes of all fields of one element */
+  t8_locidx_t         ghost_start;
+                      /** The index of the first ghost in the fields */
   sc_MPI_Request     *send_requests;
                            /** For each process we send to, the MPI request used */
   sc_MPI_Request     *recv_requests;
                            /** For each process we receive from, the MPI request used */
-} t8_ghost_data_exchange_t;
+  sc_MPI_Request      neighbor_request;
+                           /** The request of a neighborhood collective exchange,
+                               sc_MPI_REQUEST_NULL if not used. */
+  int                *neighbor_counts;
+                           /** Send counts, send displacements, receive counts and
+                               receive displacements in bytes of a neighborhood
+                               collective exchange, each num_remotes entries. */
+  const t8_locidx_t  *recv_counts;
+                           /** If not NULL, the number of ghosts received from
+                               each remote in an exchange restricted to levels.
+                               Their indices are in
+                               plan->level_recv_indices. */
+  char               *recv_data;
+                           /** The buffer that the ghosts are received into */
+  const t8_locidx_t  *send_offsets;
+                           /** For each remote the index of its first record
+                               in the send buffer, records of data_size bytes.
+                               plan->send_offsets unless the exchange is a face
+                               exchange. num_remotes + 1 entries. */
+  const t8_locidx_t  *recv_offsets;
+                           /** As send_offsets for the receive buffer */
+  int                 max_num_faces;
+                           /** If not 0, the exchange is a face exchange and
+                               the field has this many entries per element */
+  int                 changed;
+                           /** True if the exchange sends only the changed
+                               elements. Its messages may be shorter than the
+                               receive buffer, which the neighborhood
+                               collective and the windows do not allow. */
+  t8_locidx_t        *changed_counts;
+                           /** In an exchange of changed elements, the number
+                               of records sent to each remote */
+  int                 shared;
+                           /** True if the send data was packed into our
+                               segment of the shared window */
+  t8_gloidx_t        *shared_offsets;
+                           /** For each remote on our node, the byte offset of
+                               its data in our segment that we notify it of,
+                               followed by the offsets that we are notified of.
+                               An offset of -1 means that the data is sent in
+                               a message. 2 * num_remotes entries. */
+  sc_MPI_Request     *shared_requests;
+                           /** The requests of the notifications, the sends
+                               followed by the receives. 2 * num_remotes entries */
+  int                 rma;
+                           /** The state of an exchange through the RMA window,
+                               0 if it does not use the window. If not 0, its
+                               epochs are open and the data is copied out of the
+                               window into recv_data when they are closed. */
+  t8_ghost_exchange_plan_t *plan;
+                           /** The plan that this exchange uses */
+};
+
+#ifdef T8_GHOST_SHARED_WINDOWS
+/** A shared memory window of the processes on one node.
+ * Each process packs the data of its remote elements into its segment of the
+ * window, from which the remotes on the same node copy it directly.
+ */
+struct t8_ghost_shared
+{
+  MPI_Comm            node_comm;
+                      /** The processes on our node */
+  MPI_Win             window;
+                      /** The window holding the segments of all processes of node_comm */
+  char               *segment;
+                      /** Our segment, with room for max_data_size bytes for each remote element */
+  size_t              max_data_size;
+                      /** The maximum number of bytes per element of exchanges through the window */
+};
+#endif
+
+#ifdef T8_GHOST_RMA
+/** A window for one-sided ghost data exchanges.
+ * Each process exposes a receive buffer for all its ghosts, into which the
+ * owners of the ghosts put their data with precomputed displacements.
+ */
+struct t8_ghost_rma
+{
+  MPI_Win             window;
+                      /** The window over the buffers of all processes */
+  char               *buffer;
+                      /** Our buffer, with room for max_data_size bytes for each ghost */
+  size_t              max_data_size;
+                      /** The maximum number of bytes per element of exchanges through the window */
+  t8_locidx_t        *displacements;
+                      /** For each remote the index of our first element among its ghosts,
+                          ordered as ghost->remote_processes */
+  MPI_Group           group;
+                      /** The remotes that we access and that access us */
+  int                 group_size;
+                      /** The number of processes in group */
+};
+#endif
+
+/** The communication pattern of ghost data exchanges.
+ * Since it only depends on the ghost layer, it is computed once on the first
+ * exchange and reused by all later exchanges with the same forest.
+ * The remotes are ordered as in ghost->remote_processes.
+ */
+struct t8_ghost_exchange_plan
+{
+  int                 num_remotes;
+                    /** The number of processes, we send to and receive from */
+  int                *remote_ranks;
+                      /** The ranks of the remote processes */
+  t8_locidx_t        *send_offsets;
+                      /** For each remote the first entry in send_indices.
+                          num_remotes + 1 entries. */
+  t8_locidx_t        *send_indices;
+                      /** The local indices of the remote elements ordered by remote */
+  t8_locidx_t        *recv_offsets;
+                      /** For each remote the index of its first element among all ghosts.
+                          num_remotes + 1 entries. */
+  int                 num_levels;
+                      /** The number of levels of the level arrays, 0 if they
+                          were not computed yet */
+  t8_locidx_t        *level_send_indices;
+                      /** The entries of send_indices, ordered by descending
+                          level for each remote */
+  t8_locidx_t        *level_send_counts;
+                      /** For each level l and remote i, entry
+                          l * num_remotes + i is the number of remote elements
+                          of i with level >= l */
+  t8_locidx_t        *level_recv_indices;
+                      /** The indices of the ghosts of each remote, ordered by
+                          descending level */
+  t8_locidx_t        *level_recv_counts;
+                      /** As level_send_counts for the ghosts */
+  t8_locidx_t        *face_send_offsets;
+                      /** For each remote the first entry in face_send_elements,
+                          NULL if the face lists were not computed yet.
+                          num_remotes + 1 entries. */
+  t8_locidx_t        *face_send_elements;
+                      /** The local elements of the faces whose data is sent,
+                          ordered by remote */
+  int8_t             *face_send_faces;
+                      /** The face of each entry of face_send_elements */
+  t8_locidx_t        *face_recv_offsets;
+                      /** For each remote the first entry in face_recv_ghosts.
+                          num_remotes + 1 entries. */
+  t8_locidx_t        *face_recv_ghosts;
+                      /** The ghosts of the faces whose data is received,
+                          ordered by remote */
+  int8_t             *face_recv_faces;
+                      /** The face of each entry of face_recv_ghosts */
+  sc_MPI_Comm         mpicomm;
+                      /** The communicator of the forest */
+  t8_ghost_shared_t  *shared;
+                      /** The shared window of the ghost layer, or NULL */
+  int                *shared_ranks;
+                      /** If not NULL, for each remote its rank in the node
+                          communicator of the shared window, or -1 if it is
+                          not on our node */
+  char              **shared_segments;
+                      /** For each remote on our node its segment of the
+                          shared window */
+  sc_MPI_Request     *shared_done_requests;
+                      /** For each remote on our node, the receive of its
+                          confirmation that it read our segment, followed by
+                          the send of our confirmation. 2 * num_remotes entries */
+  t8_ghost_rma_t     *rma;
+                      /** The RMA window of the ghost layer, or NULL */
+  t8_ghost_data_exchange_t *rma_exchange;
+                      /** The exchange whose epochs on the RMA window are open,
+                          or NULL */
+  t8_ghost_data_exchange_t exchange;
+                      /** An exchange context that is reused, so that
+                          exchanges do not need to allocate memory. */
+  int                 exchange_active;
+                      /** True while \a exchange is used by an exchange. */
+};
 
 void
 t8_forest_ghost_init (t8_forest_ghost_t * pghost, t8_ghost_type_t ghost_type)
@@ -214,18 +374,12 @@ t8_forest_ghost_init (t8_forest_ghost_t * pghost, t8_ghost_type_t ghost_type)
   /* Allocate the trees array */
   ghost->ghost_trees = sc_array_new (sizeof (t8_ghost_tree_t));
 
-  /* initialize the global_tree_to_ghost_tree hash table */
-  ghost->glo_tree_mempool = sc_mempool_new (sizeof (t8_ghost_gtree_hash_t));
-  ghost->global_tree_to_ghost_tree =
-    sc_hash_new (t8_ghost_gtree_hash_function, t8_ghost_gtree_equal_function,
-                 NULL, NULL);
-
-  /* initialize the process_offset hash table */
-  ghost->proc_offset_mempool =
-    sc_mempool_new (sizeof (t8_ghost_process_hash_t));
-  ghost->process_offsets =
-    sc_hash_new (t8_ghost_process_hash_function,
-                 t8_ghost_process_equal_function, NULL, NULL);
+  /* The map from global tree ids to ghost trees is built when the
+   * ghost trees are complete */
+  ghost->global_tree_to_ghost_tree = NULL;
+
+  /* initialize the process_offsets array */
+  ghost->process_offsets = sc_array_new (sizeof (t8_ghost_process_info_t));
   /* initialize the remote ghosts hash table */
   ghost->remote_ghosts =
     sc_hash_array_new (sizeof (t8_ghost_remote_t),
@@ -233,6 +387,11 @@ t8_forest_ghost_init (t8_forest_ghost_t * pghost, t8_ghost_type_t ghost_type)
                        t8_ghost_remote_equal_function, NULL);
   /* initialize the remote processes array */
   ghost->remote_processes = sc_array_new (sizeof (int));
+  /* The neighborhood communicator is only created if requested */
+  ghost->neighbor_comm = sc_MPI_COMM_NULL;
+  /* The shared and RMA windows are only created if requested */
+  ghost->shared = NULL;
+  ghost->rma = NULL;
 }
 
 /* Return the remote struct of a given remote rank */
@@ -261,29 +420,20 @@ t8_forest_ghost_get_remote (t8_forest_t forest, int remote)
 }
 
 /* Return a remote processes info about the stored ghost elements */
-static t8_ghost_process_hash_t *
+static t8_ghost_process_info_t *
 t8_forest_ghost_get_proc_info (t8_forest_t forest, int remote)
 {
-  t8_ghost_process_hash_t proc_hash_search, **pproc_hash_found,
-    *proc_hash_found;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
+  ssize_t             proc_pos;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
-  proc_hash_search.mpirank = remote;
-#ifdef T8_ENABLE_DEBUG
-  ret =
-#else
-  (void)
-#endif
-    sc_hash_lookup (forest->ghosts->process_offsets, &proc_hash_search,
-                    (void ***) &pproc_hash_found);
-  T8_ASSERT (ret);
-  proc_hash_found = *pproc_hash_found;
-  T8_ASSERT (proc_hash_found->mpirank == remote);
-  return proc_hash_found;
+  /* The entries of process_offsets are in the order of the sorted
+   * remote_processes array */
+  proc_pos = sc_array_bsearch (forest->ghosts->remote_processes, &remote,
+                               sc_int_compare);
+  T8_ASSERT (proc_pos >= 0);
+  return (t8_ghost_process_info_t *)
+    sc_array_index_ssize_t (forest->ghosts->process_offsets, proc_pos);
 }
 
 /* return the number of trees in a ghost */
@@ -356,21 +506,67 @@ t8_forest_ghost_get_tree_elements (t8_forest_t forest,
 t8_locidx_t
 t8_forest_ghost_get_ghost_treeid (t8_forest_t forest, t8_gloidx_t gtreeid)
 {
-  t8_ghost_gtree_hash_t query, *found, **pfound;
+  t8_forest_ghost_t   ghost;
+  t8_ghost_tree_t     query;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (forest->ghosts != NULL);
 
+  ghost = forest->ghosts;
+  if (ghost->global_tree_to_ghost_tree != NULL) {
+    /* The global ids of the ghost trees are compact, we look them up
+     * directly */
+    if (gtreeid < ghost->first_ghost_gtree
+        || gtreeid >= ghost->first_ghost_gtree + ghost->num_ghost_gtree_ids) {
+      return -1;
+    }
+    return ghost->global_tree_to_ghost_tree[gtreeid -
+                                            ghost->first_ghost_gtree];
+  }
+  /* Binary search in the ghost trees, which are sorted by global id.
+   * Returns -1 if the tree was not found. */
   query.global_id = gtreeid;
-  if (sc_hash_lookup (forest->ghosts->global_tree_to_ghost_tree, &query,
-                      (void ***) &pfound)) {
-    /* The tree was found */
-    found = *pfound;
-    return found->index;
+  return (t8_locidx_t) sc_array_bsearch (ghost->ghost_trees, &query,
+                                         t8_ghost_tree_compare);
+}
+
+/* When the ghost trees are complete, build a direct map from global tree
+ * ids to ghost trees if the range of their ids is compact. */
+static void
+t8_forest_ghost_build_tree_map (t8_forest_ghost_t ghost)
+{
+  t8_ghost_tree_t    *ghost_tree;
+  t8_gloidx_t         first_id, last_id, gtreeid;
+  size_t              num_trees, itree;
+
+  T8_ASSERT (sc_array_is_sorted (ghost->ghost_trees, t8_ghost_tree_compare));
+  T8_ASSERT (ghost->global_tree_to_ghost_tree == NULL);
+
+  num_trees = ghost->ghost_trees->elem_count;
+  if (num_trees == 0) {
+    return;
   }
-  else {
-    /* The tree was not found */
-    return -1;
+  first_id = ((t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees, 0))
+    ->global_id;
+  last_id = ((t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
+                                                 num_trees - 1))->global_id;
+  if (last_id - first_id + 1 > T8_GHOST_TREE_MAP_FACTOR * (t8_gloidx_t)
+      num_trees) {
+    /* The ids are spread out, we use binary search */
+    return;
+  }
+  ghost->first_ghost_gtree = first_id;
+  ghost->num_ghost_gtree_ids = last_id - first_id + 1;
+  ghost->global_tree_to_ghost_tree =
+    T8_ALLOC (t8_locidx_t, ghost->num_ghost_gtree_ids);
+  for (gtreeid = 0; gtreeid < ghost->num_ghost_gtree_ids; gtreeid++) {
+    ghost->global_tree_to_ghost_tree[gtreeid] = -1;
+  }
+  for (itree = 0; itree < num_trees; itree++) {
+    ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
+                                                     itree);
+    ghost->global_tree_to_ghost_tree[ghost_tree->global_id - first_id] =
+      (t8_locidx_t) itree;
   }
 }
 
@@ -414,6 +610,45 @@ t8_element_t
   return t8_element_array_index_locidx (&ghost_tree->elements, lelement);
 }
 
+int
+t8_forest_ghost_is_equal (t8_forest_t forest_a, t8_forest_t forest_b)
+{
+  t8_locidx_t         num_trees, itree, num_elems, ielem;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+
+  T8_ASSERT (t8_forest_is_committed (forest_a));
+  T8_ASSERT (t8_forest_is_committed (forest_b));
+
+  num_trees = t8_forest_ghost_num_trees (forest_a);
+  if (num_trees != t8_forest_ghost_num_trees (forest_b)) {
+    return 0;
+  }
+  for (itree = 0; itree < num_trees; itree++) {
+    /* Check the global ids and classes of the trees */
+    eclass = t8_forest_ghost_get_tree_class (forest_a, itree);
+    if (t8_forest_ghost_get_global_treeid (forest_a, itree) !=
+        t8_forest_ghost_get_global_treeid (forest_b, itree)
+        || eclass != t8_forest_ghost_get_tree_class (forest_b, itree)) {
+      return 0;
+    }
+    /* Check the elements for equality */
+    num_elems = t8_forest_ghost_tree_num_elements (forest_a, itree);
+    if (num_elems != t8_forest_ghost_tree_num_elements (forest_b, itree)) {
+      return 0;
+    }
+    ts = t8_forest_get_eclass_scheme (forest_a, eclass);
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      if (ts->t8_element_compare
+          (t8_forest_ghost_get_element (forest_a, itree, ielem),
+           t8_forest_ghost_get_element (forest_b, itree, ielem))) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
 /* Initialize a t8_ghost_remote_tree_t */
 static void
 t8_ghost_init_remote_tree (t8_forest_t forest, t8_gloidx_t gtreeid,
@@ -848,6 +1083,7 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
     parent_upper;
   int                 el_lower, el_upper;
   int                 element_is_owned, iproc, remote_rank;
+  double              owner_time;
 
   /* First part: the search enters a new tree, we need to reset the user_data */
   if (t8_forest_global_tree_id (forest, ltreeid) != data->gtreeid) {
@@ -897,8 +1133,10 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
   el_lower = parent_lower;
   el_upper = parent_upper;
   /* Compute bounds for the element's owners */
+  owner_time = T8_GHOST_PROFILE_TIME (forest);
   t8_forest_element_owners_bounds (forest, data->gtreeid, element,
                                    data->eclass, &el_lower, &el_upper);
+  T8_GHOST_PROFILE_ADD (forest, ghost_owner_runtime, owner_time);
   /* Set these as the new bounds */
   new_bounds[2 * data->max_num_faces] = el_lower;
   new_bounds[2 * data->max_num_faces + 1] = el_upper;
@@ -930,8 +1168,10 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
        * if all face neighbors are owned by this rank, and the element is completely
        * owned, then we do not continue the search. */
       /* Compute the owners of the neighbor at this face of the element */
+      owner_time = T8_GHOST_PROFILE_TIME (forest);
       t8_forest_element_owners_at_neigh_face_bounds (forest, ltreeid, element,
                                                      iface, &lower, &upper);
+      T8_GHOST_PROFILE_ADD (forest, ghost_owner_runtime, owner_time);
       /* Store the new bounds at the entry for this element */
       new_bounds[iface * 2] = lower;
       new_bounds[iface * 2 + 1] = upper;
@@ -951,8 +1191,10 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
        * and upper bound */
       *(int *) sc_array_index (&data->face_owners, 0) = lower;
       *(int *) sc_array_index (&data->face_owners, 1) = upper;
+      owner_time = T8_GHOST_PROFILE_TIME (forest);
       t8_forest_element_owners_at_neigh_face (forest, ltreeid, element,
                                               iface, &data->face_owners);
+      T8_GHOST_PROFILE_ADD (forest, ghost_owner_runtime, owner_time);
       /*TODO: add as remotes */
       for (iproc = 0; iproc < (int) data->face_owners.elem_count; iproc++) {
         remote_rank = *(int *) sc_array_index (&data->face_owners, iproc);
@@ -992,6 +1234,7 @@ t8_forest_ghost_search_boundary (t8_forest_t forest, t8_locidx_t ltreeid,
   return 1;
 }
 
+
 /* Fill the remote ghosts of a ghost structure.
  * We iterate through all elements and check if their neighbors
  * lie on remote processes. If so, we add the element to the
@@ -1025,244 +1268,787 @@ t8_forest_ghost_fill_remote_v3 (t8_forest_t forest)
 #ifdef T8_ENABLE_DEBUG
 #endif
 }
+/* A remote element found by a thread. The candidates of all threads are
+ * sorted and added to the ghost structure after the threads are done, since
+ * t8_ghost_add_remote must be called in linear order. */
+typedef struct
+{
+  t8_locidx_t         ltreeid;          /* The local tree of the element */
+  t8_locidx_t         element_index;    /* The index of the element in its tree */
+  int                 remote_rank;      /* The process the element is remote to */
+} t8_ghost_remote_candidate_t;
 
-/* Fill the remote ghosts of a ghost structure.
- * We iterate through all elements and check if their neighbors
- * lie on remote processes. If so, we add the element to the
- * remote_ghosts array of ghost.
- * We also fill the remote_processes here.
- * If ghost_method is 0, then we assume a balanced forest and
- * construct the remote processes by looking at the half neighbors of an element.
- * Otherwise, we use the owners_at_face method.
- */
+/* Compare two remote candidates by tree, element index and rank */
+static int
+t8_ghost_remote_candidate_compare (const void *a, const void *b)
+{
+  const t8_ghost_remote_candidate_t *ca =
+    (const t8_ghost_remote_candidate_t *) a;
+  const t8_ghost_remote_candidate_t *cb =
+    (const t8_ghost_remote_candidate_t *) b;
+
+  if (ca->ltreeid != cb->ltreeid) {
+    return ca->ltreeid < cb->ltreeid ? -1 : 1;
+  }
+  if (ca->element_index != cb->element_index) {
+    return ca->element_index < cb->element_index ? -1 : 1;
+  }
+  return (ca->remote_rank > cb->remote_rank) - (ca->remote_rank <
+                                                cb->remote_rank);
+}
+
+/* Add an element of a tree as remote of owner, or store it as a candidate
+ * if candidates is not NULL */
 static void
-t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
-                             int ghost_method)
+t8_forest_ghost_fill_remote_add (t8_forest_t forest, t8_forest_ghost_t ghost,
+                                 sc_array_t * candidates, int owner,
+                                 t8_locidx_t itree, const t8_element_t * elem,
+                                 t8_locidx_t ielem)
+{
+  t8_ghost_remote_candidate_t *candidate;
+
+  if (candidates == NULL) {
+    t8_ghost_add_remote (forest, ghost, owner, itree, elem, ielem);
+    return;
+  }
+  candidate = (t8_ghost_remote_candidate_t *) sc_array_push (candidates);
+  candidate->ltreeid = itree;
+  candidate->element_index = ielem;
+  candidate->remote_rank = owner;
+}
+
+/* Find the remote elements of one local tree.
+ * If candidates is NULL, they are added to ghost directly. Otherwise, they
+ * are pushed to candidates and ghost is not accessed, such that different
+ * trees can be handled concurrently.
+ * Return the runtime of the owner searches if profiling is enabled. */
+static double
+t8_forest_ghost_fill_remote_tree (t8_forest_t forest, t8_forest_ghost_t ghost,
+                                  t8_locidx_t itree, int ghost_method,
+                                  sc_array_t * candidates)
 {
   t8_element_t       *elem, **half_neighbors = NULL;
-  t8_locidx_t         num_local_trees, num_tree_elems;
-  t8_locidx_t         itree, ielem;
+  t8_locidx_t         num_tree_elems, ielem;
   t8_tree_t           tree;
   t8_eclass_t         tree_class, neigh_class, last_class;
   t8_gloidx_t         neighbor_tree;
   t8_eclass_scheme_c *ts, *neigh_scheme = NULL, *prev_neigh_scheme = NULL;
-
   int                 iface, num_faces;
   int                 num_face_children, max_num_face_children = 0;
   int                 ichild, owner;
-  sc_array_t          owners, tree_owners;
+  sc_array_t          owners;
   int                 is_atom;
+  double              owner_time, owner_runtime = 0;
 
   last_class = T8_ECLASS_COUNT;
-  num_local_trees = t8_forest_get_num_local_trees (forest);
-
   if (ghost_method != 0) {
     sc_array_init (&owners, sizeof (int));
-    sc_array_init (&tree_owners, sizeof (int));
   }
-
-  /* Loop over the trees of the forest */
-  for (itree = 0; itree < num_local_trees; itree++) {
-    /* Get a pointer to the tree, the class of the tree, the
-     * scheme associated to the class and the number of elements in
-     * this tree. */
-    tree = t8_forest_get_tree (forest, itree);
-    tree_class = t8_forest_get_tree_class (forest, itree);
-    ts = t8_forest_get_eclass_scheme (forest, tree_class);
-
-    /* Loop over the elements of this tree */
-    num_tree_elems = t8_forest_get_tree_element_count (tree);
-    for (ielem = 0; ielem < num_tree_elems; ielem++) {
-      /* Get the element of the tree */
-      elem = t8_forest_get_tree_element (tree, ielem);
-      num_faces = ts->t8_element_num_faces (elem);
-      if (ts->t8_element_level (elem) == ts->t8_element_maxlevel ()) {
-        /* flag to decide whether this element is at the maximum level */
-        is_atom = 1;
-      }
-      else {
-        is_atom = 0;
-      }
-      for (iface = 0; iface < num_faces; iface++) {
-        /* TODO: Check whether the neighbor element is inside the forest,
-         *       if not then do not compute the half_neighbors.
-         *       This will save computing time. Needs an "element is in forest" function
-         *       Currently we perform this check in the half_neighbors function. */
-
-        /* Get the element class of the neighbor tree */
-        neigh_class =
-          t8_forest_element_neighbor_eclass (forest, itree, elem, iface);
-        neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
-        if (ghost_method == 0) {
-          /* Use half neighbors */
-          /* Get the number of face children of the element at this face */
-          num_face_children = ts->t8_element_num_face_children (elem, iface);
-          /* regrow the half_neighbors array if neccessary.
-           * We also need to reallocate it, if the element class of the neighbor
-           * changes */
-          if (max_num_face_children < num_face_children ||
-              last_class != neigh_class) {
-            if (max_num_face_children > 0) {
-              /* Clean-up memory */
-              prev_neigh_scheme->t8_element_destroy (max_num_face_children,
-                                                     half_neighbors);
-              T8_FREE (half_neighbors);
-            }
-            half_neighbors = T8_ALLOC (t8_element_t *, num_face_children);
-            /* Allocate memory for the half size face neighbors */
-            neigh_scheme->t8_element_new (num_face_children, half_neighbors);
-            max_num_face_children = num_face_children;
-            last_class = neigh_class;
-            prev_neigh_scheme = neigh_scheme;
-          }
-          if (!is_atom) {
-            /* Construct each half size neighbor */
-            neighbor_tree =
-              t8_forest_element_half_face_neighbors (forest, itree, elem,
-                                                     half_neighbors,
-                                                     neigh_scheme, iface,
-                                                     num_face_children, NULL);
-          }
-          else {
-            int                 dummy_neigh_face;
-            /* This element has maximum level, we only construct its neighbor */
-            neighbor_tree =
-              t8_forest_element_face_neighbor (forest, itree, elem,
-                                               half_neighbors[0],
-                                               neigh_scheme, iface,
-                                               &dummy_neigh_face);
-          }
-          if (neighbor_tree >= 0) {
-            /* If there exist face neighbor elements (we are not at a domain boundary */
-            /* Find the owner process of each face_child */
-            for (ichild = 0; ichild < num_face_children; ichild++) {
-              /* find the owner */
-              owner =
-                t8_forest_element_find_owner (forest, neighbor_tree,
-                                              half_neighbors[ichild],
-                                              neigh_class);
-              T8_ASSERT (0 <= owner && owner < forest->mpisize);
-              if (owner != forest->mpirank) {
-                /* Add the element as a remote element */
-                t8_ghost_add_remote (forest, ghost, owner, itree, elem,
-                                     ielem);
-              }
-            }
+  /* Get a pointer to the tree, the class of the tree, the
+   * scheme associated to the class and the number of elements in
+   * this tree. */
+  tree = t8_forest_get_tree (forest, itree);
+  tree_class = t8_forest_get_tree_class (forest, itree);
+  ts = t8_forest_get_eclass_scheme (forest, tree_class);
+
+  /* Loop over the elements of this tree */
+  num_tree_elems = t8_forest_get_tree_element_count (tree);
+  for (ielem = 0; ielem < num_tree_elems; ielem++) {
+    /* Get the element of the tree */
+    elem = t8_forest_get_tree_element (tree, ielem);
+    num_faces = ts->t8_element_num_faces (elem);
+    if (ts->t8_element_level (elem) == ts->t8_element_maxlevel ()) {
+      /* flag to decide whether this element is at the maximum level */
+      is_atom = 1;
+    }
+    else {
+      is_atom = 0;
+    }
+    for (iface = 0; iface < num_faces; iface++) {
+      /* TODO: Check whether the neighbor element is inside the forest,
+       *       if not then do not compute the half_neighbors.
+       *       This will save computing time. Needs an "element is in forest" function
+       *       Currently we perform this check in the half_neighbors function. */
+
+      /* Get the element class of the neighbor tree */
+      neigh_class =
+        t8_forest_element_neighbor_eclass (forest, itree, elem, iface);
+      neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+      if (ghost_method == 0) {
+        /* Use half neighbors */
+        /* Get the number of face children of the element at this face */
+        num_face_children = ts->t8_element_num_face_children (elem, iface);
+        /* regrow the half_neighbors array if neccessary.
+         * We also need to reallocate it, if the element class of the neighbor
+         * changes */
+        if (max_num_face_children < num_face_children ||
+            last_class != neigh_class) {
+          if (max_num_face_children > 0) {
+            /* Clean-up memory */
+            prev_neigh_scheme->t8_element_destroy (max_num_face_children,
+                                                   half_neighbors);
+            T8_FREE (half_neighbors);
           }
-        }                       /* end ghost_method 0 */
+          half_neighbors = T8_ALLOC (t8_element_t *, num_face_children);
+          /* Allocate memory for the half size face neighbors */
+          neigh_scheme->t8_element_new (num_face_children, half_neighbors);
+          max_num_face_children = num_face_children;
+          last_class = neigh_class;
+          prev_neigh_scheme = neigh_scheme;
+        }
+        if (!is_atom) {
+          /* Construct each half size neighbor */
+          neighbor_tree =
+            t8_forest_element_half_face_neighbors (forest, itree, elem,
+                                                   half_neighbors,
+                                                   neigh_scheme, iface,
+                                                   num_face_children, NULL);
+        }
         else {
-          size_t              iowner;
-          /* Construc the owners at the face of the neighbor element */
-          t8_forest_element_owners_at_neigh_face (forest, itree, elem, iface,
-                                                  &owners);
-          T8_ASSERT (owners.elem_count >= 0);
-          /* Iterate over all owners and if any is not the current process,
-           * add this element as remote */
-          for (iowner = 0; iowner < owners.elem_count; iowner++) {
-            owner = *(int *) sc_array_index (&owners, iowner);
+          int                 dummy_neigh_face;
+          /* This element has maximum level, we only construct its neighbor */
+          neighbor_tree =
+            t8_forest_element_face_neighbor (forest, itree, elem,
+                                             half_neighbors[0],
+                                             neigh_scheme, iface,
+                                             &dummy_neigh_face);
+        }
+        if (neighbor_tree >= 0) {
+          /* If there exist face neighbor elements (we are not at a domain boundary */
+          /* Find the owner process of each face_child */
+          for (ichild = 0; ichild < num_face_children; ichild++) {
+            /* find the owner */
+            owner_time = T8_GHOST_PROFILE_TIME (forest);
+            owner =
+              t8_forest_element_find_owner (forest, neighbor_tree,
+                                            half_neighbors[ichild],
+                                            neigh_class);
+            owner_runtime += T8_GHOST_PROFILE_TIME (forest) - owner_time;
             T8_ASSERT (0 <= owner && owner < forest->mpisize);
             if (owner != forest->mpirank) {
               /* Add the element as a remote element */
-              t8_ghost_add_remote (forest, ghost, owner, itree, elem, ielem);
+              t8_forest_ghost_fill_remote_add (forest, ghost, candidates,
+                                               owner, itree, elem, ielem);
             }
           }
-          sc_array_truncate (&owners);
         }
-      }                         /* end face loop */
-    }                           /* end element loop */
-  }                             /* end tree loop */
+      }                         /* end ghost_method 0 */
+      else {
+        size_t              iowner;
+        /* Construc the owners at the face of the neighbor element */
+        owner_time = T8_GHOST_PROFILE_TIME (forest);
+        t8_forest_element_owners_at_neigh_face (forest, itree, elem, iface,
+                                                &owners);
+        owner_runtime += T8_GHOST_PROFILE_TIME (forest) - owner_time;
+        T8_ASSERT (owners.elem_count >= 0);
+        /* Iterate over all owners and if any is not the current process,
+         * add this element as remote */
+        for (iowner = 0; iowner < owners.elem_count; iowner++) {
+          owner = *(int *) sc_array_index (&owners, iowner);
+          T8_ASSERT (0 <= owner && owner < forest->mpisize);
+          if (owner != forest->mpirank) {
+            /* Add the element as a remote element */
+            t8_forest_ghost_fill_remote_add (forest, ghost, candidates,
+                                             owner, itree, elem, ielem);
+          }
+        }
+        sc_array_truncate (&owners);
+      }
+    }                           /* end face loop */
+  }                             /* end element loop */
 
-  if (forest->profile != NULL) {
-    /* If profiling is enabled, we count the number of remote processes. */
-    forest->profile->ghosts_remotes = ghost->remote_processes->elem_count;
-  }
   /* Clean-up memory */
   if (ghost_method == 0) {
     if (half_neighbors != NULL) {
-      neigh_scheme->t8_element_destroy (max_num_face_children,
-                                        half_neighbors);
+      prev_neigh_scheme->t8_element_destroy (max_num_face_children,
+                                             half_neighbors);
       T8_FREE (half_neighbors);
     }
   }
   else {
     sc_array_reset (&owners);
-    sc_array_reset (&tree_owners);
   }
+  return owner_runtime;
 }
 
-/* Begin sending the ghost elements from the remote ranks
- * using non-blocking communication.
- * Afterward
- *  t8_forest_ghost_send_end
- * must be called to end the communication.
- * Returns an array of mpi_send_info_t, one for each remote rank.
+#ifdef T8_ENABLE_OPENMP
+/* Find the remote elements of the local trees with num_threads threads.
+ * Each thread collects the remote elements of its trees in its own array.
+ * The arrays are merged, sorted and deduplicated, and the remote elements
+ * are added to ghost in linear order. This avoids any shared state during
+ * the searches, which dominate the runtime. */
+static void
+t8_forest_ghost_fill_remote_threads (t8_forest_t forest,
+                                     t8_forest_ghost_t ghost,
+                                     int ghost_method, int num_threads)
+{
+  sc_array_t         *candidates, merged;
+  t8_ghost_remote_candidate_t *candidate, *last = NULL;
+  t8_element_t       *elem;
+  t8_locidx_t         num_local_trees, itree;
+  double              owner_runtime = 0;
+  size_t              icand, num_candidates = 0;
+  int                 ithread;
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  candidates = T8_ALLOC (sc_array_t, num_threads);
+  for (ithread = 0; ithread < num_threads; ithread++) {
+    sc_array_init (&candidates[ithread],
+                   sizeof (t8_ghost_remote_candidate_t));
+  }
+#pragma omp parallel for num_threads (num_threads) schedule (dynamic) reduction (+:owner_runtime)
+  for (itree = 0; itree < num_local_trees; itree++) {
+    owner_runtime +=
+      t8_forest_ghost_fill_remote_tree (forest, ghost, itree, ghost_method,
+                                        &candidates[omp_get_thread_num ()]);
+  }
+  if (forest->profile != NULL) {
+    forest->profile->ghost_owner_runtime += owner_runtime;
+  }
+  /* Merge the candidates of all threads and bring them into linear order */
+  for (ithread = 0; ithread < num_threads; ithread++) {
+    num_candidates += candidates[ithread].elem_count;
+  }
+  sc_array_init_size (&merged, sizeof (t8_ghost_remote_candidate_t),
+                      num_candidates);
+  for (ithread = 0, num_candidates = 0; ithread < num_threads; ithread++) {
+    memcpy (sc_array_index (&merged, num_candidates),
+            candidates[ithread].array,
+            candidates[ithread].elem_count * merged.elem_size);
+    num_candidates += candidates[ithread].elem_count;
+    sc_array_reset (&candidates[ithread]);
+  }
+  T8_FREE (candidates);
+  sc_array_sort (&merged, t8_ghost_remote_candidate_compare);
+  /* Add each remote element once per remote process */
+  for (icand = 0; icand < merged.elem_count; icand++) {
+    candidate =
+      (t8_ghost_remote_candidate_t *) sc_array_index (&merged, icand);
+    if (last == NULL
+        || t8_ghost_remote_candidate_compare (last, candidate) != 0) {
+      elem = t8_forest_get_element_in_tree (forest, candidate->ltreeid,
+                                            candidate->element_index);
+      t8_ghost_add_remote (forest, ghost, candidate->remote_rank,
+                           candidate->ltreeid, elem,
+                           candidate->element_index);
+    }
+    last = candidate;
+  }
+  sc_array_reset (&merged);
+}
+#endif
+
+/* Fill the remote ghosts of a ghost structure.
+ * We iterate through all elements and check if their neighbors
+ * lie on remote processes. If so, we add the element to the
+ * remote_ghosts array of ghost.
+ * We also fill the remote_processes here.
+ * If ghost_method is 0, then we assume a balanced forest and
+ * construct the remote processes by looking at the half neighbors of an element.
+ * Otherwise, we use the owners_at_face method.
+ * With OpenMP, the trees are searched by t8_get_num_threads threads.
  */
-static t8_ghost_mpi_send_info_t *
-t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
-                            sc_MPI_Request ** requests)
+static void
+t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
+                             int ghost_method)
 {
-  int                 proc_index, remote_rank;
-  int                 num_remotes;
-  size_t              remote_index;
-  t8_ghost_remote_t  *remote_entry;
-  sc_array_t         *remote_trees;
-  t8_ghost_remote_tree_t *remote_tree = NULL;
-  t8_ghost_mpi_send_info_t *send_info, *current_send_info;
-  char               *current_buffer;
-  size_t              bytes_written, element_bytes, element_count,
-    element_size;
-#ifdef T8_ENABLE_DEBUG
-  size_t              acc_el_count = 0;
+  t8_locidx_t         num_local_trees, itree;
+  double              owner_runtime = 0;
+#ifdef T8_ENABLE_OPENMP
+  int                 num_threads;
 #endif
-  int                 mpiret;
 
-  /* Allocate a send_buffer for each remote rank */
-  num_remotes = ghost->remote_processes->elem_count;
-  send_info = T8_ALLOC (t8_ghost_mpi_send_info_t, num_remotes);
-  *requests = T8_ALLOC (sc_MPI_Request, num_remotes);
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+#ifdef T8_ENABLE_OPENMP
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (t8_get_num_threads (), num_local_trees);
+  if (num_threads > 1) {
+    t8_forest_ghost_fill_remote_threads (forest, ghost, ghost_method,
+                                         num_threads);
+  }
+  else
+#endif
+  {
+    /* Loop over the trees of the forest */
+    for (itree = 0; itree < num_local_trees; itree++) {
+      owner_runtime +=
+        t8_forest_ghost_fill_remote_tree (forest, ghost, itree, ghost_method,
+                                          NULL);
+    }
+    if (forest->profile != NULL) {
+      forest->profile->ghost_owner_runtime += owner_runtime;
+    }
+  }
 
-  /* Loop over all remote processes */
-  for (proc_index = 0; proc_index < (int) ghost->remote_processes->elem_count;
-       proc_index++) {
-    current_send_info = send_info + proc_index;
-    /* Get the rank of the current remote process. */
-    remote_rank = *(int *) sc_array_index_int (ghost->remote_processes,
-                                               proc_index);
-    t8_debugf ("Filling send buffer for process %i\n", remote_rank);
-    /* initialize the send_info for the current rank */
-    current_send_info->recv_rank = remote_rank;
-    current_send_info->num_bytes = 0;
-    current_send_info->request = *requests + proc_index;
-    /* Lookup the ghost elements for the first tree of this remote */
-    remote_entry = t8_forest_ghost_get_remote (forest, remote_rank);
-    T8_ASSERT (remote_entry->remote_rank == remote_rank);
-    /* Loop over all trees of the remote rank and count the bytes */
-    /* At first we store the number of remote trees in the buffer */
-    current_send_info->num_bytes += sizeof (size_t);
-    /* add padding before the eclass */
-    current_send_info->num_bytes +=
-      T8_ADD_PADDING (current_send_info->num_bytes);
-    /* TODO: put this in a funtion */
-    /* TODO: Use remote_entry to count the number of bytes while inserting
-     *        the remote ghosts. */
-    remote_trees = &remote_entry->remote_trees;
-    for (remote_index = 0; remote_index < remote_trees->elem_count;
-         remote_index++) {
-      /* Get the next remote tree. */
-      remote_tree = (t8_ghost_remote_tree_t *) sc_array_index (remote_trees,
-                                                               remote_index);
-      /* We will store the global tree id, the element class and the list
-       * of elements in the send_buffer. */
-      current_send_info->num_bytes += sizeof (t8_gloidx_t);
-      /* add padding before the eclass */
-      current_send_info->num_bytes +=
-        T8_ADD_PADDING (current_send_info->num_bytes);
-      current_send_info->num_bytes += sizeof (t8_eclass_t);
-      /* add padding before the elements */
-      current_send_info->num_bytes +=
-        T8_ADD_PADDING (current_send_info->num_bytes);
-      /* The byte count of the elements */
-      element_size = t8_element_array_get_size (&remote_tree->elements);
+  if (forest->profile != NULL) {
+    /* If profiling is enabled, we count the number of remote processes. */
+    forest->profile->ghosts_remotes = ghost->remote_processes->elem_count;
+  }
+}
+
+/* Free the remote elements of a ghost layer and their hash table */
+static void
+t8_forest_ghost_remote_destroy (t8_forest_ghost_t ghost)
+{
+  size_t              it, it_trees;
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+
+  for (it = 0; it < ghost->remote_ghosts->a.elem_count; it++) {
+    remote_entry = (t8_ghost_remote_t *)
+      sc_array_index (&ghost->remote_ghosts->a, it);
+    for (it_trees = 0; it_trees < remote_entry->remote_trees.elem_count;
+         it_trees++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, it_trees);
+      t8_element_array_reset (&remote_tree->elements);
+      sc_array_reset (&remote_tree->element_indices);
+    }
+    sc_array_reset (&remote_entry->remote_trees);
+  }
+  sc_hash_array_destroy (ghost->remote_ghosts);
+  ghost->remote_ghosts = NULL;
+}
+
+/* Push the local indices of all local leaves that overlap a same level
+ * face neighbor of a local element to indices.
+ * For uniform forests, these are exactly the local face neighbors. */
+static void
+t8_forest_ghost_local_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
+                                      const t8_element_t * element,
+                                      sc_array_t * indices)
+{
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  t8_eclass_t         neigh_class;
+  t8_element_array_t *elements;
+  t8_element_t       *neigh[3], *leaf;
+  t8_linearidx_t      first_id, last_id;
+  t8_gloidx_t         gneigh_tree;
+  t8_locidx_t         lneigh_tree, lower, upper, ileaf, offset;
+  int                 iface, num_faces, dual_face;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  num_faces = ts->t8_element_num_faces (element);
+  for (iface = 0; iface < num_faces; iface++) {
+    neigh_class =
+      t8_forest_element_neighbor_eclass (forest, ltreeid, element, iface);
+    neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+    /* neigh[0] is the neighbor, neigh[1] its last descendant and
+     * neigh[2] is used for nearest common ancestors */
+    neigh_scheme->t8_element_new (3, neigh);
+    gneigh_tree =
+      t8_forest_element_face_neighbor (forest, ltreeid, element, neigh[0],
+                                       neigh_scheme, iface, &dual_face);
+    lneigh_tree = gneigh_tree < 0 ? -1 :
+      t8_forest_get_local_id (forest, gneigh_tree);
+    if (lneigh_tree >= 0) {
+      /* The neighbor is in a local tree. We search the leaves between its
+       * first and its last descendant. */
+      elements = t8_forest_get_tree_element_array (forest, lneigh_tree);
+      offset = t8_forest_get_tree_element_offset (forest, lneigh_tree);
+      neigh_scheme->t8_element_last_descendant (neigh[0], neigh[1],
+                                                forest->maxlevel);
+      first_id = neigh_scheme->t8_element_get_linear_id (neigh[0],
+                                                         forest->maxlevel);
+      last_id = neigh_scheme->t8_element_get_linear_id (neigh[1],
+                                                        forest->maxlevel);
+      lower = t8_forest_bin_search_lower (elements, first_id,
+                                          forest->maxlevel);
+      upper = t8_forest_bin_search_lower (elements, last_id,
+                                          forest->maxlevel);
+      if (lower < 0) {
+        lower = 0;
+      }
+      else {
+        leaf = t8_element_array_index_locidx (elements, lower);
+        neigh_scheme->t8_element_nca (leaf, neigh[0], neigh[2]);
+        if (neigh_scheme->t8_element_get_linear_id (leaf, forest->maxlevel)
+            < first_id && neigh_scheme->t8_element_compare (neigh[2],
+                                                            leaf) != 0) {
+          /* The leaf ends before the neighbor */
+          lower++;
+        }
+      }
+      for (ileaf = lower; ileaf <= upper; ileaf++) {
+        *(t8_locidx_t *) sc_array_push (indices) = offset + ileaf;
+      }
+    }
+    neigh_scheme->t8_element_destroy (3, neigh);
+  }
+}
+
+/* Compare two local element indices for sorting */
+static int
+t8_forest_ghost_locidx_compare (const void *indexa, const void *indexb)
+{
+  return *(const t8_locidx_t *) indexa - *(const t8_locidx_t *) indexb;
+}
+
+/* Extend the remote elements of a ghost layer by depth - 1 rings of
+ * local face neighbors. On input, the remote elements of each remote
+ * process are the local elements at its boundary. On output, they are all
+ * local elements that are reachable from these with at most depth - 1
+ * steps between local face neighbors. */
+static void
+t8_forest_ghost_expand_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
+                               int depth)
+{
+  sc_array_t         *remote_indices, neighbors;
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_locidx_t         num_elements, lelement, ltreeid, tree_offset;
+  t8_element_t       *element;
+  int8_t             *is_remote;
+  int                *ranks;
+  size_t              iremote, num_remotes, itree, ielement, ring_begin;
+  size_t              ring_end, ientry, ineigh;
+  int                 iring;
+
+  T8_ASSERT (depth > 1);
+  num_remotes = ghost->remote_processes->elem_count;
+  num_elements = t8_forest_get_num_element (forest);
+  ranks = T8_ALLOC (int, num_remotes);
+  remote_indices = T8_ALLOC (sc_array_t, num_remotes);
+  is_remote = T8_ALLOC_ZERO (int8_t, num_elements);
+  sc_array_init (&neighbors, sizeof (t8_locidx_t));
+
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    ranks[iremote] = *(int *) sc_array_index (ghost->remote_processes,
+                                              iremote);
+    remote_entry = t8_forest_ghost_get_remote (forest, ranks[iremote]);
+    sc_array_init (remote_indices + iremote, sizeof (t8_locidx_t));
+    /* The first ring are the current remote elements */
+    for (itree = 0; itree < remote_entry->remote_trees.elem_count; itree++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, itree);
+      tree_offset = t8_forest_get_tree_element_offset (forest,
+                                                       t8_forest_get_local_id
+                                                       (forest,
+                                                        remote_tree->global_id));
+      for (ielement = 0; ielement < remote_tree->element_indices.elem_count;
+           ielement++) {
+        lelement = tree_offset + *(t8_locidx_t *)
+          sc_array_index (&remote_tree->element_indices, ielement);
+        is_remote[lelement] = 1;
+        *(t8_locidx_t *) sc_array_push (remote_indices + iremote) = lelement;
+      }
+    }
+    /* Add the local face neighbors of the last ring as the next ring */
+    ring_begin = 0;
+    for (iring = 1; iring < depth; iring++) {
+      ring_end = remote_indices[iremote].elem_count;
+      for (ientry = ring_begin; ientry < ring_end; ientry++) {
+        lelement = *(t8_locidx_t *) sc_array_index (remote_indices + iremote,
+                                                    ientry);
+        element = t8_forest_get_element (forest, lelement, &ltreeid);
+        t8_forest_ghost_local_face_neighbors (forest, ltreeid, element,
+                                              &neighbors);
+        for (ineigh = 0; ineigh < neighbors.elem_count; ineigh++) {
+          lelement = *(t8_locidx_t *) sc_array_index (&neighbors, ineigh);
+          if (!is_remote[lelement]) {
+            is_remote[lelement] = 1;
+            *(t8_locidx_t *) sc_array_push (remote_indices + iremote) =
+              lelement;
+          }
+        }
+        sc_array_truncate (&neighbors);
+      }
+      ring_begin = ring_end;
+    }
+    /* Reset the markers for the next remote and sort the elements */
+    for (ientry = 0; ientry < remote_indices[iremote].elem_count; ientry++) {
+      is_remote[*(t8_locidx_t *) sc_array_index (remote_indices + iremote,
+                                                 ientry)] = 0;
+    }
+    sc_array_sort (remote_indices + iremote, t8_forest_ghost_locidx_compare);
+  }
+
+  /* Rebuild the remote elements in linear order */
+  t8_forest_ghost_remote_destroy (ghost);
+  ghost->remote_ghosts =
+    sc_hash_array_new (sizeof (t8_ghost_remote_t),
+                       t8_ghost_remote_hash_function,
+                       t8_ghost_remote_equal_function, NULL);
+  sc_array_truncate (ghost->remote_processes);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    for (ientry = 0; ientry < remote_indices[iremote].elem_count; ientry++) {
+      lelement = *(t8_locidx_t *) sc_array_index (remote_indices + iremote,
+                                                  ientry);
+      element = t8_forest_get_element (forest, lelement, &ltreeid);
+      t8_ghost_add_remote (forest, ghost, ranks[iremote], ltreeid, element,
+                           lelement - t8_forest_get_tree_element_offset
+                           (forest, ltreeid));
+    }
+    sc_array_reset (remote_indices + iremote);
+  }
+  sc_array_reset (&neighbors);
+  T8_FREE (is_remote);
+  T8_FREE (remote_indices);
+  T8_FREE (ranks);
+}
+
+/* Compute the remote elements and processes of a ghost layer with the
+ * algorithm chosen by unbalanced_version, see t8_forest_ghost_create_ext,
+ * and add further layers if the forest's ghost depth is larger than 1. */
+static void
+t8_forest_ghost_search_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
+                               int unbalanced_version)
+{
+  double              search_time;
+
+  t8_profile_region_begin ("ghost_search");
+  search_time = T8_GHOST_PROFILE_TIME (forest);
+  if (unbalanced_version == -1) {
+    t8_forest_ghost_fill_remote_v3 (forest);
+  }
+  else {
+    t8_forest_ghost_fill_remote (forest, ghost, unbalanced_version != 0);
+  }
+  if (forest->ghost_depth > 1) {
+    /* Add the further layers of remote elements */
+    t8_forest_ghost_expand_remote (forest, ghost, forest->ghost_depth);
+  }
+  T8_GHOST_PROFILE_ADD (forest, ghost_search_runtime, search_time);
+  t8_profile_region_end ("ghost_search");
+}
+
+/* If profiling is enabled, count a ghost message of recv_bytes bytes that
+ * was received at time - start_time after posting the sends.
+ * If start_time is negative, no latency is recorded. */
+static void
+t8_forest_ghost_profile_message (t8_forest_t forest, int recv_bytes,
+                                 double start_time)
+{
+  if (forest->profile != NULL) {
+    forest->profile->ghost_bytes_received += recv_bytes;
+    sc_stats_accumulate (&forest->profile->ghost_message_size, recv_bytes);
+    if (start_time >= 0) {
+      sc_stats_accumulate (&forest->profile->ghost_message_latency,
+                           sc_MPI_Wtime () - start_time);
+    }
+  }
+  t8_profile_comm_received (forest->profile == NULL ? NULL :
+                            &forest->profile->comm[T8_PROFILE_COMM_GHOST], 1,
+                            recv_bytes);
+}
+
+/* If message compression is enabled, each ghost message starts with this
+ * header, the number of bytes of the uncompressed message or 0 if it is not
+ * compressed. In a compressed message the elements of each tree are
+ * replaced by their runs, see t8_forest_element_runs_encode. */
+#define T8_GHOST_MESSAGE_HEADER \
+  (sizeof (size_t) + T8_ADD_PADDING (sizeof (size_t)))
+
+/* Walk through the trees of an uncompressed ghost message and copy it to
+ * message with the runs of the elements instead of the elements.
+ * If message is NULL, only count the bytes.
+ * Returns the number of bytes of the compressed message without the header
+ * and stores the number of bytes of all elements in element_bytes. */
+static size_t
+t8_forest_ghost_message_encode (t8_forest_t forest, const char *raw,
+                                size_t raw_bytes, char *message,
+                                size_t *element_bytes)
+{
+  size_t              num_trees, itree, num_elements, tree_start;
+  size_t              raw_pos, pos;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+
+  memcpy (&num_trees, raw, sizeof (size_t));
+  raw_pos = pos = sizeof (size_t) + T8_ADD_PADDING (sizeof (size_t));
+  if (message != NULL) {
+    memcpy (message, raw, pos);
+  }
+  *element_bytes = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    /* The tree id, eclass and number of elements are copied */
+    tree_start = raw_pos;
+    raw_pos += sizeof (t8_gloidx_t);
+    raw_pos += T8_ADD_PADDING (raw_pos);
+    memcpy (&eclass, raw + raw_pos, sizeof (t8_eclass_t));
+    raw_pos += sizeof (t8_eclass_t);
+    raw_pos += T8_ADD_PADDING (raw_pos);
+    memcpy (&num_elements, raw + raw_pos, sizeof (size_t));
+    raw_pos += sizeof (size_t);
+    raw_pos += T8_ADD_PADDING (raw_pos);
+    if (message != NULL) {
+      memcpy (message + pos, raw + tree_start, raw_pos - tree_start);
+    }
+    pos += raw_pos - tree_start;
+    /* The elements are replaced by their runs */
+    ts = forest->scheme_cxx->eclass_schemes[eclass];
+    pos += t8_forest_element_runs_encode (ts, (const t8_element_t *)
+                                          (raw + raw_pos), num_elements,
+                                          message == NULL ? NULL :
+                                          message + pos);
+    pos += T8_ADD_PADDING (pos);
+    raw_pos += num_elements * ts->t8_element_size ();
+    raw_pos += T8_ADD_PADDING (raw_pos);
+    *element_bytes += num_elements * ts->t8_element_size ();
+  }
+  T8_ASSERT (raw_pos == raw_bytes);
+  return pos;
+}
+
+/* Add the compression header to a packed send buffer. The elements are
+ * compressed if there are enough of them and their runs are smaller. */
+static void
+t8_forest_ghost_message_compress (t8_forest_t forest,
+                                  t8_ghost_mpi_send_info_t * send_info)
+{
+  char               *message;
+  size_t              raw_bytes, bytes, element_bytes;
+
+  raw_bytes = send_info->num_bytes;
+  bytes = t8_forest_ghost_message_encode (forest, send_info->buffer,
+                                          raw_bytes, NULL, &element_bytes);
+  if (element_bytes >= forest->message_compression && bytes < raw_bytes) {
+    message = T8_ALLOC_ZERO (char, T8_GHOST_MESSAGE_HEADER + bytes);
+    memcpy (message, &raw_bytes, sizeof (size_t));
+    (void) t8_forest_ghost_message_encode (forest, send_info->buffer,
+                                           raw_bytes,
+                                           message + T8_GHOST_MESSAGE_HEADER,
+                                           &element_bytes);
+  }
+  else {
+    /* We send the elements as they are */
+    bytes = raw_bytes;
+    message = T8_ALLOC_ZERO (char, T8_GHOST_MESSAGE_HEADER + bytes);
+    memcpy (message + T8_GHOST_MESSAGE_HEADER, send_info->buffer, bytes);
+  }
+  T8_FREE (send_info->buffer);
+  send_info->buffer = message;
+  send_info->num_bytes = T8_GHOST_MESSAGE_HEADER + bytes;
+}
+
+/* Convert a received ghost message with the compression header into an
+ * uncompressed message, as packed by t8_forest_ghost_send_pack.
+ * message must have been allocated and is replaced. */
+static void
+t8_forest_ghost_message_expand (t8_forest_t forest, char **message,
+                                int *bytes)
+{
+  const char         *body;
+  char               *raw;
+  size_t              raw_bytes, num_trees, itree, num_elements;
+  size_t              tree_start, raw_pos, pos;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+
+  if (forest->message_compression == 0) {
+    /* The message has no header */
+    return;
+  }
+  T8_ASSERT ((size_t) * bytes >= T8_GHOST_MESSAGE_HEADER);
+  memcpy (&raw_bytes, *message, sizeof (size_t));
+  body = *message + T8_GHOST_MESSAGE_HEADER;
+  *bytes -= T8_GHOST_MESSAGE_HEADER;
+  if (raw_bytes == 0) {
+    /* The message is not compressed */
+    memmove (*message, body, *bytes);
+    return;
+  }
+  raw = T8_ALLOC_ZERO (char, raw_bytes);
+  memcpy (&num_trees, body, sizeof (size_t));
+  raw_pos = pos = sizeof (size_t) + T8_ADD_PADDING (sizeof (size_t));
+  memcpy (raw, body, pos);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree_start = pos;
+    pos += sizeof (t8_gloidx_t);
+    pos += T8_ADD_PADDING (pos);
+    memcpy (&eclass, body + pos, sizeof (t8_eclass_t));
+    pos += sizeof (t8_eclass_t);
+    pos += T8_ADD_PADDING (pos);
+    memcpy (&num_elements, body + pos, sizeof (size_t));
+    pos += sizeof (size_t);
+    pos += T8_ADD_PADDING (pos);
+    memcpy (raw + raw_pos, body + tree_start, pos - tree_start);
+    raw_pos += pos - tree_start;
+    ts = forest->scheme_cxx->eclass_schemes[eclass];
+    pos += t8_forest_element_runs_decode (ts, body + pos, num_elements,
+                                          (t8_element_t *) (raw + raw_pos));
+    pos += T8_ADD_PADDING (pos);
+    raw_pos += num_elements * ts->t8_element_size ();
+    raw_pos += T8_ADD_PADDING (raw_pos);
+  }
+  T8_ASSERT (pos == (size_t) * bytes && raw_pos == raw_bytes);
+  T8_FREE (*message);
+  *message = raw;
+  *bytes = raw_bytes;
+}
+
+/* Pack the ghost elements for each remote rank into its own send buffer.
+ * Returns an array of mpi_send_info_t, one for each remote rank in the
+ * order of ghost->remote_processes. The requests are not set.
+ */
+static t8_ghost_mpi_send_info_t *
+t8_forest_ghost_send_pack (t8_forest_t forest, t8_forest_ghost_t ghost)
+{
+  int                 proc_index, remote_rank;
+  int                 num_remotes;
+  size_t              remote_index;
+  t8_ghost_remote_t  *remote_entry;
+  sc_array_t         *remote_trees;
+  t8_ghost_remote_tree_t *remote_tree = NULL;
+  t8_ghost_mpi_send_info_t *send_info, *current_send_info;
+  char               *current_buffer;
+  size_t              bytes_written, element_bytes, element_count,
+    element_size;
+  double              pack_time;
+#ifdef T8_ENABLE_DEBUG
+  size_t              acc_el_count = 0;
+#endif
+
+  t8_profile_region_begin ("ghost_pack");
+  pack_time = T8_GHOST_PROFILE_TIME (forest);
+  /* Allocate a send_buffer for each remote rank */
+  num_remotes = ghost->remote_processes->elem_count;
+  send_info = T8_ALLOC (t8_ghost_mpi_send_info_t, num_remotes);
+
+  /* Loop over all remote processes */
+  for (proc_index = 0; proc_index < (int) ghost->remote_processes->elem_count;
+       proc_index++) {
+    current_send_info = send_info + proc_index;
+    /* Get the rank of the current remote process. */
+    remote_rank = *(int *) sc_array_index_int (ghost->remote_processes,
+                                               proc_index);
+    t8_debugf ("Filling send buffer for process %i\n", remote_rank);
+    /* initialize the send_info for the current rank */
+    current_send_info->recv_rank = remote_rank;
+    current_send_info->num_bytes = 0;
+    current_send_info->request = NULL;
+    /* Lookup the ghost elements for the first tree of this remote */
+    remote_entry = t8_forest_ghost_get_remote (forest, remote_rank);
+    T8_ASSERT (remote_entry->remote_rank == remote_rank);
+    /* Loop over all trees of the remote rank and count the bytes */
+    /* At first we store the number of remote trees in the buffer */
+    current_send_info->num_bytes += sizeof (size_t);
+    /* add padding before the eclass */
+    current_send_info->num_bytes +=
+      T8_ADD_PADDING (current_send_info->num_bytes);
+    /* TODO: put this in a funtion */
+    /* TODO: Use remote_entry to count the number of bytes while inserting
+     *        the remote ghosts. */
+    remote_trees = &remote_entry->remote_trees;
+    for (remote_index = 0; remote_index < remote_trees->elem_count;
+         remote_index++) {
+      /* Get the next remote tree. */
+      remote_tree = (t8_ghost_remote_tree_t *) sc_array_index (remote_trees,
+                                                               remote_index);
+      /* We will store the global tree id, the element class and the list
+       * of elements in the send_buffer. */
+      current_send_info->num_bytes += sizeof (t8_gloidx_t);
+      /* add padding before the eclass */
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      current_send_info->num_bytes += sizeof (t8_eclass_t);
+      /* add padding before the elements */
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      /* The byte count of the elements */
+      element_size = t8_element_array_get_size (&remote_tree->elements);
       element_count = t8_element_array_get_count (&remote_tree->elements);
       element_bytes = element_size * element_count;
       /* We will store the number of elements */
@@ -1336,13 +2122,64 @@ t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
     }                           /* End tree loop */
 
     T8_ASSERT (bytes_written == current_send_info->num_bytes);
+    if (forest->message_compression > 0) {
+      t8_forest_ghost_message_compress (forest, current_send_info);
+    }
+    if (forest->profile != NULL) {
+      forest->profile->ghost_bytes_sent += current_send_info->num_bytes;
+    }
+    t8_profile_comm_sent (forest->profile == NULL ? NULL :
+                          &forest->profile->comm[T8_PROFILE_COMM_GHOST], 1,
+                          current_send_info->num_bytes);
+  }                             /* end process loop */
+  T8_GHOST_PROFILE_ADD (forest, ghost_pack_runtime, pack_time);
+  t8_profile_region_end ("ghost_pack");
+  return send_info;
+}
+
+/* Begin sending the ghost elements from the remote ranks
+ * using non-blocking communication.
+ * Each remote rank first gets the size of its message, such that it can
+ * post the receive of the message in advance.
+ * Afterward
+ *  t8_forest_ghost_send_end
+ * must be called to end the communication.
+ * Returns an array of mpi_send_info_t, one for each remote rank.
+ */
+static t8_ghost_mpi_send_info_t *
+t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
+                            sc_MPI_Request ** requests)
+{
+  int                 proc_index, num_remotes;
+  t8_ghost_mpi_send_info_t *send_info, *current_send_info;
+  int                 mpiret;
+
+  /* Fill the send buffers */
+  send_info = t8_forest_ghost_send_pack (forest, ghost);
+  num_remotes = ghost->remote_processes->elem_count;
+  *requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+
+  for (proc_index = 0; proc_index < num_remotes; proc_index++) {
+    current_send_info = send_info + proc_index;
+    current_send_info->request = *requests + proc_index;
+    /* Send the size of the message */
+    current_send_info->message_size = current_send_info->num_bytes;
+    mpiret = sc_MPI_Isend (&current_send_info->message_size, 1, sc_MPI_INT,
+                           current_send_info->recv_rank,
+                           T8_MPI_GHOST_SIZE_FOREST, forest->mpicomm,
+                           *requests + num_remotes + proc_index);
+    SC_CHECK_MPI (mpiret);
+    t8_profile_comm_sent (forest->profile == NULL ? NULL :
+                          &forest->profile->comm[T8_PROFILE_COMM_GHOST], 1,
+                          sizeof (int));
     /* We can now post the MPI_Isend for the remote process */
     mpiret =
-      sc_MPI_Isend (current_buffer, bytes_written, sc_MPI_BYTE, remote_rank,
+      sc_MPI_Isend (current_send_info->buffer, current_send_info->num_bytes,
+                    sc_MPI_BYTE, current_send_info->recv_rank,
                     T8_MPI_GHOST_FOREST, forest->mpicomm,
-                    *requests + proc_index);
+                    current_send_info->request);
     SC_CHECK_MPI (mpiret);
-  }                             /* end process loop */
+  }
   return send_info;
 }
 
@@ -1360,8 +2197,9 @@ t8_forest_ghost_send_end (t8_forest_t forest, t8_forest_ghost_t ghost,
   /* Get the number of remote processes */
   num_remotes = ghost->remote_processes->elem_count;
 
-  /* We wait for all communication to end. */
-  mpiret = sc_MPI_Waitall (num_remotes, requests, sc_MPI_STATUSES_IGNORE);
+  /* We wait for all communication to end, the messages and their sizes. */
+  mpiret = sc_MPI_Waitall (2 * num_remotes, requests,
+                           sc_MPI_STATUSES_IGNORE);
   SC_CHECK_MPI (mpiret);
 
   /* Clean-up */
@@ -1372,21 +2210,20 @@ t8_forest_ghost_send_end (t8_forest_t forest, t8_forest_ghost_t ghost,
   T8_FREE (requests);
 }
 
-/* Receive a single message from a remote process, after the message was
- * successfully probed.
+/* Receive a single message from a remote process with blocking
+ * communication, after receiving its size.
  * Returns the allocated receive buffer and the number of bytes received */
 static char        *
 t8_forest_ghost_receive_message (int recv_rank, sc_MPI_Comm comm,
-                                 sc_MPI_Status status, int *recv_bytes)
+                                 int *recv_bytes)
 {
   char               *recv_buffer;
   int                 mpiret;
 
-  T8_ASSERT (recv_rank == status.MPI_SOURCE);
-  T8_ASSERT (status.MPI_TAG == T8_MPI_GHOST_FOREST);
-
   /* Get the number of bytes in the message */
-  mpiret = sc_MPI_Get_count (&status, sc_MPI_BYTE, recv_bytes);
+  mpiret = sc_MPI_Recv (recv_bytes, 1, sc_MPI_INT, recv_rank,
+                        T8_MPI_GHOST_SIZE_FOREST, comm, sc_MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
 
   /* Allocate receive buffer */
   recv_buffer = T8_ALLOC_ZERO (char, *recv_bytes);
@@ -1409,6 +2246,7 @@ t8_forest_ghost_receive_message (int recv_rank, sc_MPI_Comm comm,
  * current_element_offset is updated in each step to store the element offset
  * of the next ghost tree to be inserted.
  * When called with the first message, current_element_offset must be set to 0.
+ * The buffer is not freed.
  */
 /* Currently we expect that the messages arrive in order of the sender's rank. */
 static void
@@ -1424,15 +2262,15 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
   t8_gloidx_t         global_id;
   t8_eclass_t         eclass;
   size_t              num_elements, old_elem_count, ghosts_offset;
-  t8_ghost_gtree_hash_t *tree_hash, **pfound_tree, *found_tree;
+  size_t              num_ghost_trees;
   t8_ghost_tree_t    *ghost_tree;
   t8_eclass_scheme_c *ts;
   t8_element_t       *element_insert;
-  t8_ghost_process_hash_t *process_hash;
-#ifdef T8_ENABLE_DEBUG
-  int                 added_process;
-#endif
+  t8_ghost_process_info_t *process_info;
+  double              parse_time;
 
+  t8_profile_region_begin ("ghost_parse");
+  parse_time = T8_GHOST_PROFILE_TIME (forest);
   bytes_read = 0;
   /* read the number of trees */
   num_trees = *(size_t *) recv_buffer;
@@ -1466,20 +2304,17 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
 
     bytes_read += sizeof (size_t);
     bytes_read += T8_ADD_PADDING (bytes_read);
-    /* Search for the tree in the ghost_trees array */
-    tree_hash =
-      (t8_ghost_gtree_hash_t *) sc_mempool_alloc (ghost->glo_tree_mempool);
-    tree_hash->global_id = global_id;
-
     /* Get the element scheme for this tree */
     ts = t8_forest_get_eclass_scheme (forest, eclass);
-    if (sc_hash_insert_unique (ghost->global_tree_to_ghost_tree, tree_hash,
-                               (void ***) &pfound_tree)) {
-      /* The tree was not stored already, tree_hash is now an entry in the hash table. */
-      /* If the tree was not contained, it is the newest tree in the array and
-       * thus has as index the number of currently inserted trees. */
-      tree_hash->index = ghost->ghost_trees->elem_count;
-      found_tree = tree_hash;
+    /* Since we parse the messages in order of the ranks, the trees arrive
+     * in order of their global ids. Thus, if the tree was already inserted,
+     * it is the last tree in the ghost_trees array. */
+    num_ghost_trees = ghost->ghost_trees->elem_count;
+    ghost_tree = num_ghost_trees == 0 ? NULL : (t8_ghost_tree_t *)
+      sc_array_index (ghost->ghost_trees, num_ghost_trees - 1);
+    if (ghost_tree == NULL || ghost_tree->global_id != global_id) {
+      /* The tree was not stored already */
+      T8_ASSERT (ghost_tree == NULL || ghost_tree->global_id < global_id);
       /* We grow the array by one and initilize the entry */
       ghost_tree = (t8_ghost_tree_t *) sc_array_push (ghost->ghost_trees);
       ghost_tree->global_id = global_id;
@@ -1491,20 +2326,12 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
       /* Compute the element offset of this new tree by adding the offset
        * of the previous tree to the element count of the previous tree. */
       ghost_tree->element_offset = *current_element_offset;
-      /* Allocate a new tree_hash for the next search */
       old_elem_count = 0;
-      tree_hash =
-        (t8_ghost_gtree_hash_t *) sc_mempool_alloc (ghost->glo_tree_mempool);
     }
     else {
-      /* The entry was found in the trees array */
-      found_tree = *pfound_tree;
-      T8_ASSERT (found_tree->global_id == global_id);
-      /* Get a pointer to the tree */
-      ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
-                                                       found_tree->index);
+      /* The tree is the last entry in the trees array */
+      num_ghost_trees--;
       T8_ASSERT (ghost_tree->eclass == eclass);
-      T8_ASSERT (ghost_tree->global_id == global_id);
       T8_ASSERT (ghost_tree->elements.scheme == ts);
 
       old_elem_count = t8_element_array_get_count (&ghost_tree->elements);
@@ -1519,7 +2346,7 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
     if (itree == 0) {
       /* We store the index of the first tree and the first element of this
        * rank */
-      first_tree_index = found_tree->index;
+      first_tree_index = num_ghost_trees;
       first_element_index = old_elem_count;
     }
     /* Insert the new elements */
@@ -1531,67 +2358,197 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
     *current_element_offset += num_elements;
   }
   T8_ASSERT (bytes_read == (size_t) recv_bytes);
-  T8_FREE (recv_buffer);
 
-  /* At last we add the receiving rank to the ghosts process_offset hash table */
-  process_hash =
-    (t8_ghost_process_hash_t *) sc_mempool_alloc (ghost->proc_offset_mempool);
-  process_hash->mpirank = recv_rank;
-  process_hash->tree_index = first_tree_index;
-  process_hash->first_element = first_element_index;
-  process_hash->ghost_offset = ghosts_offset;
-  /* Insert this rank into the hash table. We assert if the rank was not already
-   * contained. */
-#ifdef T8_ENABLE_DEBUG
-  added_process =
-#else
-  (void)
-#endif
-    sc_hash_insert_unique (ghost->process_offsets, process_hash, NULL);
-  T8_ASSERT (added_process);
+  /* At last we add the receiving rank to the ghosts process_offsets array.
+   * Its entries are in the order of the sorted remote_processes array. */
+  T8_ASSERT (*(int *) sc_array_index (ghost->remote_processes,
+                                      ghost->process_offsets->elem_count)
+             == recv_rank);
+  process_info =
+    (t8_ghost_process_info_t *) sc_array_push (ghost->process_offsets);
+  process_info->mpirank = recv_rank;
+  process_info->tree_index = first_tree_index;
+  process_info->first_element = first_element_index;
+  process_info->ghost_offset = ghosts_offset;
+  T8_GHOST_PROFILE_ADD (forest, ghost_parse_runtime, parse_time);
+  t8_profile_region_end ("ghost_parse");
 }
 
-/* In forest_ghost_receive we need a lookup table to give us the position
- * of a process in the ghost->remote_processes array, given the rank of
- * a process. We implement this via a hash table with the following struct
- * as entry. */
-typedef struct t8_recv_list_entry_struct
+/* A tree of a received ghost message */
+typedef struct
 {
-  int                 rank;     /* The rank of this process */
-  int                 pos_in_remote_processes;  /* The position of this process in the remote_processes array */
-} t8_recv_list_entry_t;
-
-/* We hash these entries by their rank */
-unsigned
-t8_recv_list_entry_hash (const void *v1, const void *u)
+  t8_gloidx_t         global_id;        /* global id of the tree */
+  t8_eclass_t         eclass;   /* The trees element class */
+  size_t              num_elements;     /* The number of elements in the message */
+  const char         *elements; /* The elements, pointing into the message */
+} t8_ghost_message_tree_t;
+
+/* Read the trees of a message from a remote process, as described in
+ * t8_forest_ghost_parse_received_message, into an array of
+ * t8_ghost_message_tree_t. The elements are not copied.
+ * Returns the number of elements in the message. */
+static t8_locidx_t
+t8_forest_ghost_scan_message (t8_forest_t forest, int recv_rank,
+                              const char *recv_buffer, int recv_bytes,
+                              sc_array_t * trees)
 {
-  const t8_recv_list_entry_t *e1 = (const t8_recv_list_entry_t *) v1;
+  t8_ghost_message_tree_t *tree;
+  t8_eclass_scheme_c *ts;
+  size_t              bytes_read, num_trees, itree;
+  t8_locidx_t         num_elements = 0;
+  double              parse_time;
+
+  t8_profile_region_begin ("ghost_parse");
+  parse_time = T8_GHOST_PROFILE_TIME (forest);
+  bytes_read = 0;
+  /* read the number of trees */
+  num_trees = *(const size_t *) recv_buffer;
+  bytes_read += sizeof (size_t);
+  bytes_read += T8_ADD_PADDING (bytes_read);
 
-  return e1->rank;
+  t8_debugf ("Received %li trees from %i (%i bytes)\n",
+             (long) num_trees, recv_rank, recv_bytes);
+
+  tree = num_trees == 0 ? NULL : (t8_ghost_message_tree_t *)
+    sc_array_push_count (trees, num_trees);
+  for (itree = 0; itree < num_trees; itree++, tree++) {
+    tree->global_id = *(const t8_gloidx_t *) (recv_buffer + bytes_read);
+    bytes_read += sizeof (t8_gloidx_t);
+    bytes_read += T8_ADD_PADDING (bytes_read);
+    tree->eclass = *(const t8_eclass_t *) (recv_buffer + bytes_read);
+    bytes_read += sizeof (t8_eclass_t);
+    bytes_read += T8_ADD_PADDING (bytes_read);
+    tree->num_elements = *(const size_t *) (recv_buffer + bytes_read);
+    bytes_read += sizeof (size_t);
+    bytes_read += T8_ADD_PADDING (bytes_read);
+    tree->elements = recv_buffer + bytes_read;
+    T8_ASSERT (itree == 0 || tree[-1].global_id < tree->global_id);
+    ts = t8_forest_get_eclass_scheme (forest, tree->eclass);
+    bytes_read += tree->num_elements * ts->t8_element_size ();
+    bytes_read += T8_ADD_PADDING (bytes_read);
+    num_elements += tree->num_elements;
+  }
+  T8_ASSERT (bytes_read == (size_t) recv_bytes);
+  T8_GHOST_PROFILE_ADD (forest, ghost_parse_runtime, parse_time);
+  t8_profile_region_end ("ghost_parse");
+  return num_elements;
 }
 
-/* two entries are considered equal if they have the same rank. */
-int
-t8_recv_list_entry_equal (const void *v1, const void *v2, const void *u)
+/* Build the ghost trees and the process offsets from the scanned messages
+ * of all remote processes, which are in the order of the sorted
+ * remote_processes array. Since the trees arrive in order of their global
+ * ids, consecutive remote processes can only share their last and first
+ * tree. We first count the elements of each ghost tree, such that its
+ * element array is allocated only once, and then copy the elements. */
+static void
+t8_forest_ghost_assemble (t8_forest_t forest, t8_forest_ghost_t ghost,
+                          sc_array_t * message_trees)
 {
-  const t8_recv_list_entry_t *e1 = (const t8_recv_list_entry_t *) v1;
-  const t8_recv_list_entry_t *e2 = (const t8_recv_list_entry_t *) v2;
+  t8_ghost_message_tree_t *message_tree;
+  t8_ghost_tree_t    *ghost_tree = NULL;
+  t8_ghost_process_info_t *process_info;
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         num_elements = 0, filled = 0;
+  size_t              iremote, itree, num_remotes, ighost_tree;
+  double              parse_time;
+
+  t8_profile_region_begin ("ghost_parse");
+  parse_time = T8_GHOST_PROFILE_TIME (forest);
+  num_remotes = ghost->remote_processes->elem_count;
+  /* Create the ghost trees and store their element offsets */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    for (itree = 0; itree < message_trees[iremote].elem_count; itree++) {
+      message_tree = (t8_ghost_message_tree_t *)
+        sc_array_index (message_trees + iremote, itree);
+      if (ghost_tree == NULL
+          || ghost_tree->global_id != message_tree->global_id) {
+        T8_ASSERT (ghost_tree == NULL
+                   || ghost_tree->global_id < message_tree->global_id);
+        ghost_tree = (t8_ghost_tree_t *) sc_array_push (ghost->ghost_trees);
+        ghost_tree->global_id = message_tree->global_id;
+        ghost_tree->eclass = message_tree->eclass;
+        ghost_tree->element_offset = num_elements;
+      }
+      T8_ASSERT (ghost_tree->eclass == message_tree->eclass);
+      num_elements += message_tree->num_elements;
+    }
+  }
+  /* Allocate the element arrays */
+  for (ighost_tree = 0; ighost_tree < ghost->ghost_trees->elem_count;
+       ighost_tree++) {
+    ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
+                                                     ighost_tree);
+    ts = t8_forest_get_eclass_scheme (forest, ghost_tree->eclass);
+    t8_element_array_init_size (&ghost_tree->elements, ts,
+                                (ighost_tree + 1 <
+                                 ghost->ghost_trees->elem_count ?
+                                 ghost_tree[1].element_offset : num_elements)
+                                - ghost_tree->element_offset);
+  }
 
-  return e1->rank == e2->rank;
+  /* Copy the elements and store the offsets of each process */
+  ghost_tree = NULL;
+  ighost_tree = 0;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    process_info =
+      (t8_ghost_process_info_t *) sc_array_push (ghost->process_offsets);
+    process_info->mpirank =
+      *(int *) sc_array_index (ghost->remote_processes, iremote);
+    process_info->ghost_offset = ghost->num_ghosts_elements;
+    process_info->tree_index = 0;
+    process_info->first_element = 0;
+    for (itree = 0; itree < message_trees[iremote].elem_count; itree++) {
+      message_tree = (t8_ghost_message_tree_t *)
+        sc_array_index (message_trees + iremote, itree);
+      if (ghost_tree == NULL
+          || ghost_tree->global_id != message_tree->global_id) {
+        /* The next ghost tree starts */
+        ighost_tree = ghost_tree == NULL ? 0 : ighost_tree + 1;
+        ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees,
+                                                         ighost_tree);
+        filled = 0;
+      }
+      T8_ASSERT (ghost_tree->global_id == message_tree->global_id);
+      if (itree == 0) {
+        /* We store the index of the first tree and the first element of
+         * this rank */
+        process_info->tree_index = ighost_tree;
+        process_info->first_element = filled;
+      }
+      if (message_tree->num_elements > 0) {
+        ts = t8_forest_get_eclass_scheme (forest, ghost_tree->eclass);
+        memcpy (t8_element_array_index_locidx (&ghost_tree->elements,
+                                               filled),
+                message_tree->elements,
+                message_tree->num_elements * ts->t8_element_size ());
+      }
+      filled += message_tree->num_elements;
+      ghost->num_ghosts_elements += message_tree->num_elements;
+    }
+  }
+  T8_ASSERT (ghost->num_ghosts_elements == num_elements);
+  T8_GHOST_PROFILE_ADD (forest, ghost_parse_runtime, parse_time);
+  t8_profile_region_end ("ghost_parse");
 }
 
-/* Probe for all incoming messages from the remote ranks and receive them.
- * We receive the message in the order in which they arrive. To achieve this,
- * we have to use polling. */
+/* Receive the ghost elements from all remote processes.
+ * We post the receives of the message sizes up front and as soon as a size
+ * arrives, we post the receive of its message. The messages are scanned in
+ * the order in which they arrive, such that a slow remote process does not
+ * delay the processing of the others. When all messages arrived, the ghost
+ * trees are assembled in order of the ranks. */
 static void
 t8_forest_ghost_receive (t8_forest_t forest, t8_forest_ghost_t ghost)
 {
-  int                 num_remotes;
-  int                 proc_pos;
-  int                 recv_rank;
+  sc_MPI_Request     *requests;
+  sc_array_t         *message_trees;
+  char              **buffers;
+  int                *recv_bytes, *indices;
+  int                 num_remotes, num_pending, num_completed;
+  int                 iremote, icompleted, recv_rank;
   int                 mpiret;
   sc_MPI_Comm         comm;
-  sc_MPI_Status       status;
+  double              receive_time, parse_runtime = 0;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (ghost != NULL);
@@ -1604,234 +2561,366 @@ t8_forest_ghost_receive (t8_forest_t forest, t8_forest_ghost_t ghost)
     /* There is nothing to do */
     return;
   }
+  /* The sends were posted just before, we measure the message latencies
+   * from here */
+  t8_profile_region_begin ("ghost_receive");
+  receive_time = T8_GHOST_PROFILE_TIME (forest);
+  if (forest->profile != NULL) {
+    parse_runtime = forest->profile->ghost_parse_runtime;
+  }
 
-  {
-    /*       This code receives the message in order of their arrival.
-     *       This is effective in terms of runtime, but makes it more difficult
-     *       to store the received data, since the data has to be stored in order of
-     *       ascending ranks.
-     *       We include the received data into the ghost structure in order of the
-     *       ranks of the receivers and we do this as soon as the message from
-     *       the next rank that we can include was received. */
-    char              **buffer;
-    int                *recv_bytes;
-    int                 received_messages = 0;
-    int                *received_flag;
-    int                 last_rank_parsed = -1, parse_it;
-#undef T8_POLLING               /* activates polling for Mpi messages, currently used for testing */
-#ifdef T8_POLLING
-    sc_link_t          *proc_it, *prev;
-    int                 iprobe_flag;
-    sc_list_t          *receivers;
-#else
-    t8_recv_list_entry_t **pfound, *found;
-#ifdef T8_ENABLE_DEBUG
-    int                 ret;
-#endif
-    sc_hash_t          *recv_list_entries_hash;
-#endif
-    t8_recv_list_entry_t recv_list_entry, *recv_list_entries;
-    t8_locidx_t         current_element_offset = 0;
-
-    buffer = T8_ALLOC (char *, num_remotes);
-    recv_bytes = T8_ALLOC (int, num_remotes);
-    received_flag = T8_ALLOC_ZERO (int, num_remotes);
-    recv_list_entries = T8_ALLOC (t8_recv_list_entry_t, num_remotes);
-
-    /* Sort the array of remote processes, such that the ranks are in
-     * ascending order. */
-    sc_array_sort (ghost->remote_processes, sc_int_compare);
+  /* Sort the array of remote processes, such that the ranks are in
+   * ascending order. The ghost trees are assembled in this order. */
+  sc_array_sort (ghost->remote_processes, sc_int_compare);
 
-    /* We build a hash table of all ranks from which we receive and their position
-     * in the remote_processes array. */
-#ifdef T8_POLLING               /* polling */
-    receivers = sc_list_new (NULL);
-#else
-    recv_list_entries_hash = sc_hash_new (t8_recv_list_entry_hash,
-                                          t8_recv_list_entry_equal, NULL,
-                                          NULL);
-#endif
-    for (proc_pos = 0; proc_pos < num_remotes; proc_pos++) {
-      recv_list_entries[proc_pos].rank =
-        *(int *) sc_array_index_int (ghost->remote_processes, proc_pos);
-      recv_list_entries[proc_pos].pos_in_remote_processes = proc_pos;
-#ifndef T8_POLLING
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_insert_unique (recv_list_entries_hash,
-                               recv_list_entries + proc_pos, NULL);
-      T8_ASSERT (ret == 1);
-#else /* polling */
-      sc_list_append (receivers, recv_list_entries + proc_pos);
-#endif
-    }
+  /* The first num_remotes requests receive the message sizes, the others
+   * the messages */
+  requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  indices = T8_ALLOC (int, 2 * num_remotes);
+  recv_bytes = T8_ALLOC (int, num_remotes);
+  buffers = T8_ALLOC (char *, num_remotes);
+  message_trees = T8_ALLOC (sc_array_t, num_remotes);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    recv_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    mpiret = sc_MPI_Irecv (recv_bytes + iremote, 1, sc_MPI_INT, recv_rank,
+                           T8_MPI_GHOST_SIZE_FOREST, comm,
+                           requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    requests[num_remotes + iremote] = sc_MPI_REQUEST_NULL;
+    sc_array_init (message_trees + iremote,
+                   sizeof (t8_ghost_message_tree_t));
+  }
 
-  /****     Actual communication    ****/
-
-    /* Until there is only one sender left we iprobe for a message for each
-     * sender and if there is one we receive it and remove the sender from
-     * the list.
-     * The last message can be received via probe */
-#ifdef T8_POLLING
-    while (received_messages < num_remotes - 1) {
-      /* TODO: This part of the code using polling and IProbe to receive the
-       *       messages. We replaced with a non-polling version that uses the
-       *       blocking Probe. */
-      iprobe_flag = 0;
-      prev = NULL;              /* ensure that if the first receive entry is matched first,
-                                   it is removed properly. */
-      for (proc_it = receivers->first; proc_it != NULL && iprobe_flag == 0;) {
-        /* pointer to the rank of a receiver */
-        recv_rank = ((t8_recv_list_entry_t *) proc_it->data)->rank;
-        proc_pos =
-          ((t8_recv_list_entry_t *) proc_it->data)->pos_in_remote_processes;
-
-        mpiret = sc_MPI_Iprobe (recv_rank, T8_MPI_GHOST_FOREST, comm,
-                                &iprobe_flag, &status);
+  /* Each remote completes two requests */
+  num_pending = 2 * num_remotes;
+  while (num_pending > 0) {
+    mpiret = sc_MPI_Waitsome (2 * num_remotes, requests, &num_completed,
+                              indices, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    T8_ASSERT (0 < num_completed && num_completed <= num_pending);
+    num_pending -= num_completed;
+    for (icompleted = 0; icompleted < num_completed; icompleted++) {
+      iremote = indices[icompleted] % num_remotes;
+      recv_rank =
+        *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+      if (indices[icompleted] < num_remotes) {
+        /* The size arrived, we receive the message */
+        t8_profile_comm_received (forest->profile == NULL ? NULL :
+                                  &forest->profile->comm
+                                  [T8_PROFILE_COMM_GHOST], 1, sizeof (int));
+        buffers[iremote] = T8_ALLOC (char, recv_bytes[iremote]);
+        mpiret = sc_MPI_Irecv (buffers[iremote], recv_bytes[iremote],
+                               sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_FOREST,
+                               comm, requests + num_remotes + iremote);
         SC_CHECK_MPI (mpiret);
-#else
-    while (received_messages < num_remotes) {
-      /* blocking probe for a message. */
-      mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, T8_MPI_GHOST_FOREST, comm,
-                             &status);
-      SC_CHECK_MPI (mpiret);
-#endif
-#ifdef T8_POLLING
-      if (iprobe_flag == 0) {
-        /* There is no message to receive, we continue */
-        prev = proc_it;
-        proc_it = proc_it->next;
       }
       else {
+        /* The message arrived */
+        t8_forest_ghost_profile_message (forest, recv_bytes[iremote],
+                                         receive_time);
+        t8_forest_ghost_message_expand (forest, buffers + iremote,
+                                        recv_bytes + iremote);
+        t8_forest_ghost_scan_message (forest, recv_rank, buffers[iremote],
+                                      recv_bytes[iremote],
+                                      message_trees + iremote);
+      }
+    }
+  }
+  T8_FREE (requests);
+  T8_FREE (indices);
+
+  t8_forest_ghost_assemble (forest, ghost, message_trees);
+
+  /* clean-up */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    sc_array_reset (message_trees + iremote);
+    T8_FREE (buffers[iremote]);
+  }
+  T8_FREE (message_trees);
+  T8_FREE (buffers);
+  T8_FREE (recv_bytes);
+
+  if (forest->profile != NULL) {
+    /* The receive runtime does not include the parsing of the messages */
+    forest->profile->ghost_receive_runtime += sc_MPI_Wtime () - receive_time
+      - (forest->profile->ghost_parse_runtime - parse_runtime);
+  }
+  t8_profile_region_end ("ghost_receive");
+}
+
+/* Return true if the ghost layer of a forest is built and exchanged with
+ * neighborhood collectives. */
+static int
+t8_forest_ghost_use_neighborhood (t8_forest_t forest)
+{
+#ifdef T8_GHOST_NEIGHBOR_COLLECTIVES
+  return forest->ghost_neighborhood;
 #else
-      /* There is a message to receive, we receive it. */
-      recv_rank = status.MPI_SOURCE;
-      /* Get the position of this rank in the remote processes array */
-      recv_list_entry.rank = recv_rank;
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
+  return 0;
 #endif
-        sc_hash_lookup (recv_list_entries_hash, &recv_list_entry,
-                        (void ***) &pfound);
-      T8_ASSERT (ret != 0);
-      found = *pfound;
-      proc_pos = found->pos_in_remote_processes;
-#endif
-      T8_ASSERT (status.MPI_TAG == T8_MPI_GHOST_FOREST);
-      buffer[proc_pos] =
-        t8_forest_ghost_receive_message (recv_rank, comm, status,
-                                         recv_bytes + proc_pos);
-      /* mark this entry as received. */
-      T8_ASSERT (received_flag[proc_pos] == 0);
-      received_flag[proc_pos] = 1;
-      received_messages++;
-      /* Parse all messages that we can parse now.
-       * We have to parse the messages in order of their rank. */
-      T8_ASSERT (last_rank_parsed < proc_pos);
-      /* For all ranks that we haven't parsed yet, but can be parsed in order */
-      for (parse_it = last_rank_parsed + 1; parse_it < num_remotes &&
-           received_flag[parse_it] == 1; parse_it++) {
-        recv_rank =
-          *(int *) sc_array_index_int (ghost->remote_processes, parse_it);
-        t8_forest_ghost_parse_received_message (forest, ghost,
-                                                &current_element_offset,
-                                                recv_rank, buffer[parse_it],
-                                                recv_bytes[parse_it]);
-        last_rank_parsed++;
-      }
+}
+
+#ifdef T8_GHOST_NEIGHBOR_COLLECTIVES
+/* Create the distributed graph communicator of the ghost layer.
+ * Each process is connected to its remote processes in both directions.
+ * This is collective over the forest's communicator. */
+static void
+t8_forest_ghost_neighborhood_create (t8_forest_t forest,
+                                     t8_forest_ghost_t ghost)
+{
+  int                 num_remotes, mpiret;
+  int                *ranks;
+
+  T8_ASSERT (ghost->neighbor_comm == sc_MPI_COMM_NULL);
+
+  /* The neighbors of the graph are in ascending order of their ranks */
+  sc_array_sort (ghost->remote_processes, sc_int_compare);
+  num_remotes = ghost->remote_processes->elem_count;
+  ranks = (int *) ghost->remote_processes->array;
+  mpiret = MPI_Dist_graph_create_adjacent (forest->mpicomm, num_remotes,
+                                           ranks, MPI_UNWEIGHTED,
+                                           num_remotes, ranks,
+                                           MPI_UNWEIGHTED, MPI_INFO_NULL, 0,
+                                           &ghost->neighbor_comm);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Exchange the ghost elements with neighborhood collectives on the
+ * graph communicator of the ghost layer.
+ * This replaces t8_forest_ghost_send_start, t8_forest_ghost_receive
+ * and t8_forest_ghost_send_end. */
+static void
+t8_forest_ghost_neighborhood_exchange (t8_forest_t forest,
+                                       t8_forest_ghost_t ghost)
+{
+  t8_ghost_mpi_send_info_t *send_info;
+  int                 num_remotes, iremote, mpiret;
+  int                *send_counts, *send_displs, *recv_counts, *recv_displs;
+  char               *send_buffer, *recv_buffer;
+  t8_locidx_t         current_element_offset = 0;
+  double              receive_time;
+
+  T8_ASSERT (ghost->neighbor_comm != sc_MPI_COMM_NULL);
+
+  /* Fill the send buffers and concatenate them */
+  send_info = t8_forest_ghost_send_pack (forest, ghost);
+  num_remotes = ghost->remote_processes->elem_count;
+  send_counts = T8_ALLOC (int, 4 * num_remotes);
+  send_displs = send_counts + num_remotes;
+  recv_counts = send_displs + num_remotes;
+  recv_displs = recv_counts + num_remotes;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    send_counts[iremote] = send_info[iremote].num_bytes;
+    send_displs[iremote] = iremote == 0 ? 0 :
+      send_displs[iremote - 1] + send_counts[iremote - 1];
+  }
+  send_buffer = T8_ALLOC (char, num_remotes == 0 ? 0 :
+                          send_displs[num_remotes - 1] +
+                          send_counts[num_remotes - 1]);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    memcpy (send_buffer + send_displs[iremote], send_info[iremote].buffer,
+            send_counts[iremote]);
+    T8_FREE (send_info[iremote].buffer);
+  }
+  T8_FREE (send_info);
 
-#ifdef T8_POLLING               /* polling */
-      /* Remove the process from the list of receivers. */
-      proc_it = proc_it->next;
-      sc_list_remove (receivers, prev);
+  /* Exchange the message sizes */
+  t8_profile_region_begin ("ghost_receive");
+  receive_time = T8_GHOST_PROFILE_TIME (forest);
+  mpiret = MPI_Neighbor_alltoall (send_counts, 1, MPI_INT, recv_counts, 1,
+                                  MPI_INT, ghost->neighbor_comm);
+  SC_CHECK_MPI (mpiret);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    recv_displs[iremote] = iremote == 0 ? 0 :
+      recv_displs[iremote - 1] + recv_counts[iremote - 1];
+  }
+  recv_buffer = T8_ALLOC (char, num_remotes == 0 ? 0 :
+                          recv_displs[num_remotes - 1] +
+                          recv_counts[num_remotes - 1]);
+  /* Exchange the ghost elements */
+  mpiret = MPI_Neighbor_alltoallv (send_buffer, send_counts, send_displs,
+                                   MPI_BYTE, recv_buffer, recv_counts,
+                                   recv_displs, MPI_BYTE,
+                                   ghost->neighbor_comm);
+  SC_CHECK_MPI (mpiret);
+  T8_GHOST_PROFILE_ADD (forest, ghost_receive_runtime, receive_time);
+  t8_profile_region_end ("ghost_receive");
+  /* All messages arrive in the same collective, they have no individual
+   * latency */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    t8_forest_ghost_profile_message (forest, recv_counts[iremote], -1);
+  }
+
+  /* The messages are ordered by the rank of the sender */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    char               *message = recv_buffer + recv_displs[iremote];
+    int                 message_bytes = recv_counts[iremote];
+
+    if (forest->message_compression > 0) {
+      /* Expand a copy of the message */
+      message = T8_ALLOC (char, message_bytes);
+      memcpy (message, recv_buffer + recv_displs[iremote], message_bytes);
+      t8_forest_ghost_message_expand (forest, &message, &message_bytes);
     }
-  }                             /* end for */
-#endif
-#if 0
-  {                             /* this is for indent */
-    {
-#endif
-    }                           /* end while */
-#ifdef T8_POLLING
-    /* polling */
-    T8_ASSERT (receivers->elem_count == 1);
-    /* Get the last rank from which we didnt receive yet */
-    recv_list_entry = *(t8_recv_list_entry_t *) sc_list_pop (receivers);
-    recv_rank = recv_list_entry.rank;
-    proc_pos = recv_list_entry.pos_in_remote_processes;
-    /* destroy the list */
-    sc_list_destroy (receivers);
-    /* Blocking probe for the last message */
-    mpiret = sc_MPI_Probe (recv_rank, T8_MPI_GHOST_FOREST, comm, &status);
-    SC_CHECK_MPI (mpiret);
-    /* Receive the message */
-    T8_ASSERT (received_flag[proc_pos] == 0);
-    buffer[proc_pos] = t8_forest_ghost_receive_message (recv_rank, comm,
-                                                        status,
-                                                        recv_bytes +
-                                                        proc_pos);
-    received_flag[proc_pos] = 1;
-    received_messages++;
-    T8_ASSERT (received_messages == num_remotes);
-    /* parse all messages that are left */
-    /* For all ranks that we haven't parsed yet, but can be parsed in order */
-    for (parse_it = last_rank_parsed + 1; parse_it < num_remotes &&
-         received_flag[parse_it] == 1; parse_it++) {
-      recv_rank =
-        *(int *) sc_array_index_int (ghost->remote_processes, parse_it);
-      t8_forest_ghost_parse_received_message (forest, ghost,
-                                              &current_element_offset,
-                                              recv_rank, buffer[parse_it],
-                                              recv_bytes[parse_it]);
-      last_rank_parsed++;
+    t8_forest_ghost_parse_received_message (forest, ghost,
+                                            &current_element_offset,
+                                            *(int *)
+                                            sc_array_index_int
+                                            (ghost->remote_processes,
+                                             iremote),
+                                            message, message_bytes);
+    if (forest->message_compression > 0) {
+      T8_FREE (message);
     }
+  }
+  T8_FREE (send_buffer);
+  T8_FREE (recv_buffer);
+  T8_FREE (send_counts);
+}
 #endif
-#ifdef T8_ENABLE_DEBUG
-    for (parse_it = 0; parse_it < num_remotes; parse_it++) {
-      T8_ASSERT (received_flag[parse_it] == 1);
-    }
+
+/* Return true if the processes of a forest on the same node exchange ghost
+ * data through a shared memory window. */
+static int
+t8_forest_ghost_use_shared (t8_forest_t forest)
+{
+#ifdef T8_GHOST_SHARED_WINDOWS
+  return forest->ghost_shared_size > 0;
+#else
+  return 0;
 #endif
-    T8_ASSERT (last_rank_parsed == num_remotes - 1);
+}
+
+#ifdef T8_GHOST_SHARED_WINDOWS
+/* Allocate the shared memory window of the ghost layer. Each process gets a
+ * segment with room for ghost_shared_size bytes for each of its remote
+ * elements. This is collective over the forest's communicator. */
+static void
+t8_forest_ghost_shared_create (t8_forest_t forest, t8_forest_ghost_t ghost)
+{
+  t8_ghost_shared_t  *shared;
+  int                 mpiret;
+
+  T8_ASSERT (ghost->shared == NULL);
+  shared = ghost->shared = T8_ALLOC_ZERO (t8_ghost_shared_t, 1);
+  shared->max_data_size = forest->ghost_shared_size;
+  mpiret = MPI_Comm_split_type (forest->mpicomm, MPI_COMM_TYPE_SHARED,
+                                forest->mpirank, MPI_INFO_NULL,
+                                &shared->node_comm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_allocate_shared ((MPI_Aint) (ghost->num_remote_elements
+                                                * shared->max_data_size), 1,
+                                    MPI_INFO_NULL, shared->node_comm,
+                                    &shared->segment, &shared->window);
+  SC_CHECK_MPI (mpiret);
+  /* We synchronize with messages, the window stays in one passive epoch */
+  mpiret = MPI_Win_lock_all (MPI_MODE_NOCHECK, shared->window);
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Free the shared memory window of a ghost layer.
+ * This is collective over the processes on the node. */
+static void
+t8_forest_ghost_shared_destroy (t8_forest_ghost_t ghost)
+{
+  t8_ghost_shared_t  *shared = ghost->shared;
+  int                 mpiret;
 
-    /* clean-up */
-#ifndef T8_POLLING
-    sc_hash_destroy (recv_list_entries_hash);
+  mpiret = MPI_Win_unlock_all (shared->window);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_free (&shared->window);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Comm_free (&shared->node_comm);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (shared);
+  ghost->shared = NULL;
+}
 #endif
-    T8_FREE (buffer);
-    T8_FREE (received_flag);
-    T8_FREE (recv_list_entries);
-    T8_FREE (recv_bytes);
 
-  }
+/* Return true if the ghost data of a forest is exchanged through an RMA
+ * window. */
+static int
+t8_forest_ghost_use_rma (t8_forest_t forest)
+{
+#ifdef T8_GHOST_RMA
+  return forest->ghost_rma_size > 0;
+#else
+  return 0;
+#endif
+}
 
-#if 0
-  /* Receive the message in order of the sender's rank,
-   * this is a non-optimized version of the code below.
-   * slow but simple. */
+#ifdef T8_GHOST_RMA
+/* Create the RMA window of the ghost layer over a receive buffer with room
+ * for ghost_rma_size bytes for each ghost. Each remote tells us where our
+ * elements start among its ghosts, which is the displacement of our data in
+ * its buffer. This is collective over the forest's communicator. */
+static void
+t8_forest_ghost_rma_create (t8_forest_t forest, t8_forest_ghost_t ghost)
+{
+  t8_ghost_rma_t     *rma;
+  t8_locidx_t        *first_elems;
+  sc_MPI_Request     *requests;
+  int                 num_remotes, iremote, remote_rank, mpiret;
+
+  T8_ASSERT (ghost->rma == NULL);
+  rma = ghost->rma = T8_ALLOC_ZERO (t8_ghost_rma_t, 1);
+  rma->max_data_size = forest->ghost_rma_size;
+  rma->group = MPI_GROUP_NULL;
+  rma->buffer = T8_ALLOC (char, ghost->num_ghosts_elements
+                          * rma->max_data_size);
+  mpiret = MPI_Win_create (rma->buffer,
+                           (MPI_Aint) (ghost->num_ghosts_elements
+                                       * rma->max_data_size), 1,
+                           MPI_INFO_NULL, forest->mpicomm, &rma->window);
+  SC_CHECK_MPI (mpiret);
 
-  /* Sort the array of remote processes, such that the ranks are in
-   * ascending order. */
-  sc_array_sort (ghost->remote_processes, sc_int_compare);
+  /* The ghost layer is symmetric, we exchange one offset with each remote */
+  num_remotes = ghost->remote_processes->elem_count;
+  rma->displacements = T8_ALLOC (t8_locidx_t, num_remotes);
+  first_elems = T8_ALLOC (t8_locidx_t, num_remotes);
+  requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    first_elems[iremote] =
+      t8_forest_ghost_remote_first_elem (forest, remote_rank);
+    mpiret = sc_MPI_Isend (first_elems + iremote, 1, T8_MPI_LOCIDX,
+                           remote_rank, T8_MPI_GHOST_RMA, forest->mpicomm,
+                           requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Irecv (rma->displacements + iremote, 1, T8_MPI_LOCIDX,
+                           remote_rank, T8_MPI_GHOST_RMA, forest->mpicomm,
+                           requests + num_remotes + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Waitall (2 * num_remotes, requests,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests);
+  T8_FREE (first_elems);
+}
 
-  for (proc_pos = 0; proc_pos < num_remotes; proc_pos++) {
-    recv_rank =
-      (int *) sc_array_index_int (ghost->remote_processes, proc_pos);
-    /* blocking probe for a message. */
-    mpiret = sc_MPI_Probe (*recv_rank, T8_MPI_GHOST_FOREST, comm, &status);
+/* Free the RMA window of a ghost layer.
+ * This is collective over the forest's communicator. */
+static void
+t8_forest_ghost_rma_destroy (t8_forest_ghost_t ghost)
+{
+  t8_ghost_rma_t     *rma = ghost->rma;
+  int                 mpiret;
+
+  mpiret = MPI_Win_free (&rma->window);
+  SC_CHECK_MPI (mpiret);
+  if (rma->group != MPI_GROUP_NULL) {
+    mpiret = MPI_Group_free (&rma->group);
     SC_CHECK_MPI (mpiret);
-    /* receive message */
-    buffer =
-      t8_forest_ghost_receive_message (*recv_rank, comm, status, &recv_bytes);
-    t8_forest_ghost_parse_received_message (forest, ghost, *recv_rank, buffer,
-                                            recv_bytes);
   }
-#endif
+  T8_FREE (rma->buffer);
+  T8_FREE (rma->displacements);
+  T8_FREE (rma);
+  ghost->rma = NULL;
 }
+#endif
 
 /* Create one layer of ghost elements, following the algorithm
  * in: p4est: Scalable Algorithms For Parallel Adaptive
@@ -1851,16 +2940,18 @@ t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
   t8_forest_ghost_t   ghost = NULL;
   t8_ghost_mpi_send_info_t *send_info;
   sc_MPI_Request     *requests;
-  int                 create_tree_array = 0, create_gfirst_desc_array = 0;
-  int                 create_element_array = 0;
+  int                 create_tree_array, create_gfirst_desc_array;
+  int                 create_element_array;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   t8_global_productionf ("Into t8_forest_ghost with %i local elements.\n",
                          t8_forest_get_num_element (forest));
+  t8_profile_region_begin ("ghost");
 
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of ghost_create */
     forest->profile->ghost_runtime = -sc_MPI_Wtime ();
+    t8_forest_profile_ghost_reset (forest);
     /* DO NOT DELETE THE FOLLOWING line.
      * even if you do not want this output. It fixes a bug that occured on JUQUEEN, where the
      * runtimes were computed to 0.
@@ -1869,23 +2960,36 @@ t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
                            forest->profile->ghost_runtime);
   }
 
-  if (forest->element_offsets == NULL) {
-    /* create element offset array if not done already */
-    create_element_array = 1;
-    t8_forest_partition_create_offsets (forest);
+  /* Create the offset arrays that are not created already */
+  create_element_array = forest->element_offsets == NULL;
+  create_tree_array = forest->tree_offsets == NULL;
+  create_gfirst_desc_array = forest->global_first_desc == NULL;
+  t8_forest_partition_create_all_offsets (forest);
+
+#ifndef T8_GHOST_NEIGHBOR_COLLECTIVES
+  if (forest->ghost_neighborhood) {
+    t8_debugf ("MPI does not provide neighborhood collectives, using"
+               " point-to-point messages for the ghost layer.\n");
   }
-  if (forest->tree_offsets == NULL) {
-    /* Create tree offset array if not done already */
-    create_tree_array = 1;
-    t8_forest_partition_create_tree_offsets (forest);
+#endif
+#ifndef T8_GHOST_SHARED_WINDOWS
+  if (forest->ghost_shared_size > 0) {
+    t8_debugf ("MPI does not provide shared memory windows, using"
+               " point-to-point messages for ghost data exchanges.\n");
   }
-  if (forest->global_first_desc == NULL) {
-    /* Create global first desc array if not done already */
-    create_gfirst_desc_array = 1;
-    t8_forest_partition_create_first_desc (forest);
+#endif
+#ifndef T8_GHOST_RMA
+  if (forest->ghost_rma_size > 0) {
+    t8_debugf ("MPI does not provide one-sided communication, using"
+               " point-to-point messages for ghost data exchanges.\n");
   }
-
-  if (t8_forest_get_num_element (forest) > 0) {
+#endif
+  /* With neighborhood collectives or a shared or RMA window all processes
+   * take part, also empty ones */
+  if (t8_forest_get_num_element (forest) > 0
+      || t8_forest_ghost_use_neighborhood (forest)
+      || t8_forest_ghost_use_shared (forest)
+      || t8_forest_ghost_use_rma (forest)) {
     if (forest->ghost_type == T8_GHOST_NONE) {
       t8_debugf ("WARNING: Trying to construct ghosts with ghost_type NONE. "
                  "Ghost layer is not constructed.\n");
@@ -1898,23 +3002,40 @@ t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
     t8_forest_ghost_init (&forest->ghosts, forest->ghost_type);
     ghost = forest->ghosts;
 
-    if (unbalanced_version == -1) {
-      t8_forest_ghost_fill_remote_v3 (forest);
-    }
-    else {
+    if (t8_forest_get_num_element (forest) > 0) {
       /* Construct the remote elements and processes. */
-      t8_forest_ghost_fill_remote (forest, ghost, unbalanced_version != 0);
+      t8_forest_ghost_search_remote (forest, ghost, unbalanced_version);
     }
 
-    /* Start sending the remote elements */
-    send_info = t8_forest_ghost_send_start (forest, ghost, &requests);
-
-    /* Reveive the ghost elements from the remote processes */
-    t8_forest_ghost_receive (forest, ghost);
+#ifdef T8_GHOST_NEIGHBOR_COLLECTIVES
+    if (forest->ghost_neighborhood) {
+      /* Build the graph communicator and exchange the ghost elements over it */
+      t8_forest_ghost_neighborhood_create (forest, ghost);
+      t8_forest_ghost_neighborhood_exchange (forest, ghost);
+    }
+    else
+#endif
+    {
+      /* Start sending the remote elements */
+      send_info = t8_forest_ghost_send_start (forest, ghost, &requests);
 
-    /* End sending the remote elements */
-    t8_forest_ghost_send_end (forest, ghost, send_info, requests);
+      /* Reveive the ghost elements from the remote processes */
+      t8_forest_ghost_receive (forest, ghost);
 
+      /* End sending the remote elements */
+      t8_forest_ghost_send_end (forest, ghost, send_info, requests);
+    }
+    t8_forest_ghost_build_tree_map (ghost);
+#ifdef T8_GHOST_SHARED_WINDOWS
+    if (t8_forest_ghost_use_shared (forest)) {
+      t8_forest_ghost_shared_create (forest, ghost);
+    }
+#endif
+#ifdef T8_GHOST_RMA
+    if (t8_forest_ghost_use_rma (forest)) {
+      t8_forest_ghost_rma_create (forest, ghost);
+    }
+#endif
   }
 
   if (create_element_array) {
@@ -1950,6 +3071,13 @@ t8_forest_ghost_create_ext (t8_forest_t forest, int unbalanced_version)
                            forest->profile->ghost_runtime);
   }
 
+  t8_profile_region_end ("ghost");
+  if (forest->profile != NULL) {
+    t8_profile_regions_last_hw_counters (forest->profile->hw_counters
+                                         [T8_PROFILE_HW_GHOST]);
+    forest->profile->memory_peak[T8_PROFILE_HW_GHOST] =
+      t8_profile_regions_last_memory_peak ();
+  }
   t8_global_productionf ("Done t8_forest_ghost with %i local elements and %i"
                          " ghost elements.\n",
                          t8_forest_get_num_element (forest),
@@ -1966,309 +3094,2045 @@ t8_forest_ghost_create (t8_forest_t forest)
   }
 }
 
-void
-t8_forest_ghost_create_balanced_only (t8_forest_t forest)
+void
+t8_forest_ghost_create_balanced_only (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if (forest->mpisize > 1) {
+    /* TODO: assert that forest is balanced */
+    /* Call balanced version of ghost algorithm */
+    t8_forest_ghost_create_ext (forest, 0);
+  }
+}
+
+void
+t8_forest_ghost_create_topdown (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  t8_forest_ghost_create_ext (forest, -1);
+}
+
+/* Add the remote elements of a previous ghost layer to the ghost layer
+ * of forest. The local elements of forest must be the same as the ones
+ * of the forest that ghost_from was created for. */
+static void
+t8_forest_ghost_copy_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
+                             t8_forest_ghost_t ghost_from)
+{
+  t8_ghost_remote_t   remote_search, *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_locidx_t         ltreeid, element_pos;
+  size_t              iremote, itree, ielement, index;
+  int                 remote_rank;
+#ifdef T8_ENABLE_DEBUG
+  int                 ret;
+#endif
+
+  for (iremote = 0; iremote < ghost_from->remote_processes->elem_count;
+       iremote++) {
+    remote_rank = *(int *) sc_array_index (ghost_from->remote_processes,
+                                           iremote);
+    remote_search.remote_rank = remote_rank;
+#ifdef T8_ENABLE_DEBUG
+    ret =
+#else
+    (void)
+#endif
+      sc_hash_array_lookup (ghost_from->remote_ghosts, &remote_search,
+                            &index);
+    T8_ASSERT (ret);
+    remote_entry = (t8_ghost_remote_t *)
+      sc_array_index (&ghost_from->remote_ghosts->a, index);
+    for (itree = 0; itree < remote_entry->remote_trees.elem_count; itree++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, itree);
+      ltreeid = t8_forest_get_local_id (forest, remote_tree->global_id);
+      T8_ASSERT (ltreeid >= 0);
+      for (ielement = 0; ielement < remote_tree->element_indices.elem_count;
+           ielement++) {
+        /* Add the element of forest at the same position */
+        element_pos = *(t8_locidx_t *)
+          sc_array_index (&remote_tree->element_indices, ielement);
+        t8_ghost_add_remote (forest, ghost, remote_rank, ltreeid,
+                             t8_forest_get_element_in_tree (forest, ltreeid,
+                                                            element_pos),
+                             element_pos);
+      }
+    }
+  }
+  ghost->num_remote_elements = ghost_from->num_remote_elements;
+  if (forest->profile != NULL) {
+    forest->profile->ghosts_remotes = ghost->remote_processes->elem_count;
+  }
+}
+
+/* Build the message that the remote process at position proc_pos in
+ * ghost_from->remote_processes sent to create ghost_from.
+ * ghost_from->remote_processes must be sorted.
+ * Returns the allocated message and stores its number of bytes. */
+static char        *
+t8_forest_ghost_message_from_previous (t8_forest_ghost_t ghost_from,
+                                       int proc_pos, int *num_bytes)
+{
+  t8_ghost_process_info_t *proc_entry;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_locidx_t         ghost_end, remaining;
+  size_t              itree, first_element, element_count, element_size;
+  size_t              num_trees, bytes;
+  char               *buffer;
+  int                 iround;
+
+  proc_entry = (t8_ghost_process_info_t *)
+    sc_array_index_int (ghost_from->process_offsets, proc_pos);
+  /* The ghosts of this process end where those of the next process begin */
+  if (proc_pos + 1 < (int) ghost_from->process_offsets->elem_count) {
+    ghost_end = ((t8_ghost_process_info_t *)
+                 sc_array_index_int (ghost_from->process_offsets,
+                                     proc_pos + 1))->ghost_offset;
+  }
+  else {
+    ghost_end = ghost_from->num_ghosts_elements;
+  }
+
+  /* In the first round we count the bytes, in the second round we write
+   * the message in the format of t8_forest_ghost_send_start */
+  buffer = NULL;
+  num_trees = 0;
+  bytes = 0;
+  for (iround = 0; iround < 2; iround++) {
+    if (iround == 1) {
+      buffer = T8_ALLOC_ZERO (char, bytes);
+      *num_bytes = bytes;
+      bytes = 0;
+      memcpy (buffer, &num_trees, sizeof (size_t));
+    }
+    bytes += sizeof (size_t);
+    bytes += T8_ADD_PADDING (bytes);
+    itree = proc_entry->tree_index;
+    first_element = proc_entry->first_element;
+    remaining = ghost_end - proc_entry->ghost_offset;
+    while (remaining > 0) {
+      ghost_tree =
+        (t8_ghost_tree_t *) sc_array_index (ghost_from->ghost_trees, itree);
+      element_count = SC_MIN ((size_t) remaining,
+                              t8_element_array_get_count
+                              (&ghost_tree->elements) - first_element);
+      element_size = t8_element_array_get_size (&ghost_tree->elements);
+      if (iround == 1) {
+        memcpy (buffer + bytes, &ghost_tree->global_id, sizeof (t8_gloidx_t));
+      }
+      bytes += sizeof (t8_gloidx_t);
+      bytes += T8_ADD_PADDING (bytes);
+      if (iround == 1) {
+        memcpy (buffer + bytes, &ghost_tree->eclass, sizeof (t8_eclass_t));
+      }
+      bytes += sizeof (t8_eclass_t);
+      bytes += T8_ADD_PADDING (bytes);
+      if (iround == 1) {
+        memcpy (buffer + bytes, &element_count, sizeof (size_t));
+      }
+      bytes += sizeof (size_t);
+      bytes += T8_ADD_PADDING (bytes);
+      if (iround == 1) {
+        memcpy (buffer + bytes,
+                t8_element_array_index_locidx (&ghost_tree->elements,
+                                               first_element),
+                element_count * element_size);
+      }
+      else {
+        num_trees++;
+      }
+      bytes += element_count * element_size;
+      bytes += T8_ADD_PADDING (bytes);
+      remaining -= element_count;
+      first_element = 0;
+      itree++;
+    }
+  }
+  T8_ASSERT (bytes == (size_t) * num_bytes);
+  return buffer;
+}
+
+void
+t8_forest_ghost_create_incremental (t8_forest_t forest,
+                                    t8_forest_ghost_t ghost_from,
+                                    int unbalanced_version)
+{
+  t8_forest_ghost_t   ghost;
+  t8_ghost_mpi_send_info_t *send_info = NULL;
+  sc_MPI_Request     *requests = NULL, *flag_requests;
+  t8_locidx_t         current_element_offset = 0;
+  int                 changed, *remote_changed;
+  int                 num_remotes, iremote, remote_rank;
+  int                 recv_bytes, mpiret;
+  char               *buffer;
+  double              receive_time;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (ghost_from != NULL);
+  T8_ASSERT (forest->ghost_type == ghost_from->ghost_type);
+  T8_ASSERT (ghost_from->neighbor_comm == sc_MPI_COMM_NULL);
+  T8_ASSERT (sc_array_is_sorted (ghost_from->remote_processes,
+                                 sc_int_compare));
+
+  t8_profile_region_begin ("ghost_incremental");
+  if (forest->profile != NULL) {
+    /* If profiling is enabled, we measure the runtime of ghost_create */
+    forest->profile->ghost_runtime = -sc_MPI_Wtime ();
+    t8_forest_profile_ghost_reset (forest);
+  }
+
+  /* Since the forest was only adapted, a process has the same remote
+   * processes as before. We tell each of them whether our elements changed
+   * and learn whether theirs did. */
+  changed = !forest->adapt_unchanged;
+  num_remotes = ghost_from->remote_processes->elem_count;
+  remote_changed = T8_ALLOC (int, num_remotes);
+  flag_requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost_from->remote_processes, iremote);
+    mpiret = sc_MPI_Irecv (remote_changed + iremote, 1, sc_MPI_INT,
+                           remote_rank, T8_MPI_GHOST_UPDATE_FOREST,
+                           forest->mpicomm, flag_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Isend (&changed, 1, sc_MPI_INT, remote_rank,
+                           T8_MPI_GHOST_UPDATE_FOREST, forest->mpicomm,
+                           flag_requests + num_remotes + iremote);
+    SC_CHECK_MPI (mpiret);
+    t8_profile_comm_sent (forest->profile == NULL ? NULL :
+                          &forest->profile->comm[T8_PROFILE_COMM_GHOST], 1,
+                          sizeof (int));
+    t8_profile_comm_received (forest->profile == NULL ? NULL :
+                              &forest->profile->comm[T8_PROFILE_COMM_GHOST],
+                              1, sizeof (int));
+  }
+  mpiret = sc_MPI_Waitall (2 * num_remotes, flag_requests,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (flag_requests);
+
+  t8_forest_ghost_init (&forest->ghosts, forest->ghost_type);
+  ghost = forest->ghosts;
+  if (changed) {
+    /* Our elements changed, we recompute the remote elements and
+     * send them to all remote processes */
+    t8_forest_ghost_search_remote (forest, ghost, unbalanced_version);
+    sc_array_sort (ghost->remote_processes, sc_int_compare);
+    T8_ASSERT ((int) ghost->remote_processes->elem_count == num_remotes);
+    send_info = t8_forest_ghost_send_start (forest, ghost, &requests);
+  }
+  else {
+    /* Our remote elements are the same as before */
+    t8_forest_ghost_copy_remote (forest, ghost, ghost_from);
+  }
+
+  /* Receive the ghosts of the changed remote processes and take the
+   * others from the previous ghost layer, in order of the ranks */
+  receive_time = T8_GHOST_PROFILE_TIME (forest);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost_from->remote_processes, iremote);
+    if (remote_changed[iremote]) {
+      double              message_time = T8_GHOST_PROFILE_TIME (forest);
+
+      buffer = t8_forest_ghost_receive_message (remote_rank, forest->mpicomm,
+                                                &recv_bytes);
+      T8_GHOST_PROFILE_ADD (forest, ghost_receive_runtime, message_time);
+      t8_forest_ghost_profile_message (forest, recv_bytes, receive_time);
+      t8_forest_ghost_message_expand (forest, &buffer, &recv_bytes);
+    }
+    else {
+      buffer = t8_forest_ghost_message_from_previous (ghost_from, iremote,
+                                                      &recv_bytes);
+    }
+    t8_forest_ghost_parse_received_message (forest, ghost,
+                                            &current_element_offset,
+                                            remote_rank, buffer, recv_bytes);
+    T8_FREE (buffer);
+  }
+  T8_FREE (remote_changed);
+
+  if (changed) {
+    /* End sending the remote elements */
+    t8_forest_ghost_send_end (forest, ghost, send_info, requests);
+  }
+  t8_forest_ghost_build_tree_map (ghost);
+
+  if (forest->profile != NULL) {
+    forest->profile->ghost_runtime += sc_MPI_Wtime ();
+    forest->profile->ghosts_received = ghost->num_ghosts_elements;
+    forest->profile->ghosts_shipped = ghost->num_remote_elements;
+  }
+  t8_profile_region_end ("ghost_incremental");
+  if (forest->profile != NULL) {
+    t8_profile_regions_last_hw_counters (forest->profile->hw_counters
+                                         [T8_PROFILE_HW_GHOST]);
+    forest->profile->memory_peak[T8_PROFILE_HW_GHOST] =
+      t8_profile_regions_last_memory_peak ();
+  }
+  t8_debugf ("Updated the ghost layer incrementally with %i ghost"
+             " elements.\n", t8_forest_get_num_ghosts (forest));
+}
+
+/** Return the array of remote ranks.
+ * \param [in] forest   A forest with constructed ghost layer.
+ * \param [in,out] num_remotes On output the number of remote ranks is stored here.
+ * \return              The array of remote ranks in ascending order.
+ */
+int                *
+t8_forest_ghost_get_remotes (t8_forest_t forest, int *num_remotes)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if (forest->ghosts == NULL) {
+    *num_remotes = 0;
+    return NULL;
+  }
+  T8_ASSERT (forest->ghosts != NULL);
+
+  *num_remotes = forest->ghosts->remote_processes->elem_count;
+  return (int *) forest->ghosts->remote_processes->array;
+}
+
+/** Return the first local ghost tree of a remote rank.
+ * \param [in] forest   A forest with constructed ghost layer.
+ * \param [in] remote   A remote rank of the ghost layer in \a forest.
+ * \return              The ghost tree id of the first ghost tree that stores ghost
+ *                      elements of \a remote.
+ */
+t8_locidx_t
+t8_forest_ghost_remote_first_tree (t8_forest_t forest, int remote)
+{
+  t8_ghost_process_info_t *proc_entry;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts != NULL);
+
+  proc_entry = t8_forest_ghost_get_proc_info (forest, remote);
+  T8_ASSERT (proc_entry->mpirank == remote);
+  return proc_entry->tree_index;
+}
+
+/** Return the local index of the first ghost element that belongs to a given remote rank.
+ * \param [in] forest   A forest with constructed ghost layer.
+ * \param [in] remote   A remote rank of the ghost layer in \a forest.
+ * \return              The index i in the ghost elements of the first element of rank \a remote
+ */
+t8_locidx_t
+t8_forest_ghost_remote_first_elem (t8_forest_t forest, int remote)
+{
+  t8_ghost_process_info_t *proc_entry;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts != NULL);
+
+  proc_entry = t8_forest_ghost_get_proc_info (forest, remote);
+  T8_ASSERT (proc_entry->mpirank == remote);
+
+  return proc_entry->ghost_offset;
+}
+
+void
+t8_forest_ghost_mark_remote_elements (t8_forest_t forest, int8_t * marks)
+{
+  t8_forest_ghost_t   ghost;
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_locidx_t         ltreeid, element_pos, offset;
+  size_t              iremote, itree, ielement;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts != NULL);
+
+  ghost = forest->ghosts;
+  /* Iterate over all remote processes and their remote trees */
+  for (iremote = 0; iremote < ghost->remote_ghosts->a.elem_count; iremote++) {
+    remote_entry =
+      (t8_ghost_remote_t *) sc_array_index (&ghost->remote_ghosts->a,
+                                            iremote);
+    for (itree = 0; itree < remote_entry->remote_trees.elem_count; itree++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, itree);
+      ltreeid = t8_forest_get_local_id (forest, remote_tree->global_id);
+      T8_ASSERT (ltreeid >= 0);
+      offset = t8_forest_get_tree_element_offset (forest, ltreeid);
+      for (ielement = 0; ielement < remote_tree->element_indices.elem_count;
+           ielement++) {
+        /* Mark this remote element via its index in the local tree */
+        element_pos = *(t8_locidx_t *)
+          sc_array_index (&remote_tree->element_indices, ielement);
+        T8_ASSERT (0 <= element_pos);
+        marks[offset + element_pos] = 1;
+      }
+    }
+  }
+}
+
+void
+t8_forest_ghost_split_elements (t8_forest_t forest, sc_array_t * interior,
+                                sc_array_t * boundary)
+{
+  int8_t             *marks;
+  t8_locidx_t         ielement, num_elements;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (interior == NULL || interior->elem_size == sizeof (t8_locidx_t));
+  T8_ASSERT (boundary == NULL || boundary->elem_size == sizeof (t8_locidx_t));
+
+  num_elements = t8_forest_get_num_element (forest);
+  marks = T8_ALLOC_ZERO (int8_t, num_elements);
+  if (forest->ghosts != NULL) {
+    t8_forest_ghost_mark_remote_elements (forest, marks);
+  }
+  if (interior != NULL) {
+    sc_array_truncate (interior);
+  }
+  if (boundary != NULL) {
+    sc_array_truncate (boundary);
+  }
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    if (marks[ielement] && boundary != NULL) {
+      *(t8_locidx_t *) sc_array_push (boundary) = ielement;
+    }
+    else if (!marks[ielement] && interior != NULL) {
+      *(t8_locidx_t *) sc_array_push (interior) = ielement;
+    }
+  }
+  T8_FREE (marks);
+}
+
+#ifdef T8_GHOST_SHARED_WINDOWS
+/* Find the remotes of a plan that are on our node and their segments of the
+ * shared window */
+static void
+t8_forest_ghost_shared_plan (t8_forest_t forest,
+                             t8_ghost_exchange_plan_t * plan)
+{
+  MPI_Group           group, node_group;
+  MPI_Aint            segment_size;
+  int                 iremote, disp_unit, mpiret;
+
+  T8_ASSERT (plan->shared != NULL);
+  plan->shared_ranks = T8_ALLOC (int, plan->num_remotes);
+  plan->shared_segments = T8_ALLOC_ZERO (char *, plan->num_remotes);
+  plan->shared_done_requests =
+    T8_ALLOC (sc_MPI_Request, 2 * plan->num_remotes);
+  mpiret = MPI_Comm_group (forest->mpicomm, &group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Comm_group (plan->shared->node_comm, &node_group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_translate_ranks (group, plan->num_remotes,
+                                      plan->remote_ranks, node_group,
+                                      plan->shared_ranks);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_free (&node_group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_free (&group);
+  SC_CHECK_MPI (mpiret);
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    plan->shared_done_requests[iremote] = sc_MPI_REQUEST_NULL;
+    plan->shared_done_requests[plan->num_remotes + iremote] =
+      sc_MPI_REQUEST_NULL;
+    if (plan->shared_ranks[iremote] == MPI_UNDEFINED) {
+      plan->shared_ranks[iremote] = -1;
+      continue;
+    }
+    mpiret = MPI_Win_shared_query (plan->shared->window,
+                                   plan->shared_ranks[iremote],
+                                   &segment_size, &disp_unit,
+                                   &plan->shared_segments[iremote]);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+#endif
+
+#ifdef T8_GHOST_RMA
+/* Build the group of the remotes of a plan that exchange data with us
+ * through the RMA window. These are all remotes that are not served by the
+ * shared window. */
+static void
+t8_forest_ghost_rma_plan (t8_forest_t forest,
+                          t8_ghost_exchange_plan_t * plan)
+{
+  t8_ghost_rma_t     *rma = plan->rma;
+  MPI_Group           group;
+  int                *ranks;
+  int                 iremote, mpiret;
+
+  T8_ASSERT (rma != NULL && rma->group == MPI_GROUP_NULL);
+  ranks = T8_ALLOC (int, plan->num_remotes);
+  rma->group_size = 0;
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    if (plan->shared_ranks == NULL || plan->shared_ranks[iremote] < 0) {
+      ranks[rma->group_size++] = plan->remote_ranks[iremote];
+    }
+  }
+  mpiret = MPI_Comm_group (forest->mpicomm, &group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_incl (group, rma->group_size, ranks, &rma->group);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Group_free (&group);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (ranks);
+}
+#endif
+
+/* Compute the communication pattern of ghost data exchanges for a forest */
+static t8_ghost_exchange_plan_t *
+t8_forest_ghost_exchange_plan_new (t8_forest_t forest)
+{
+  t8_ghost_exchange_plan_t *plan;
+  t8_forest_ghost_t   ghost;
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_locidx_t         ltreeid, element_pos, elements_offset, num_send;
+  size_t              itree, ielement;
+  int                 iremote, remote_rank;
+
+  ghost = forest->ghosts;
+  plan = T8_ALLOC_ZERO (t8_ghost_exchange_plan_t, 1);
+  plan->num_remotes = ghost->remote_processes->elem_count;
+  plan->remote_ranks = T8_ALLOC (int, plan->num_remotes);
+  plan->send_offsets = T8_ALLOC (t8_locidx_t, plan->num_remotes + 1);
+  plan->recv_offsets = T8_ALLOC (t8_locidx_t, plan->num_remotes + 1);
+
+  /* Compute the offsets of the remotes in the send and receive data */
+  plan->send_offsets[0] = 0;
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    remote_rank =
+      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
+    plan->remote_ranks[iremote] = remote_rank;
+    remote_entry = t8_forest_ghost_get_remote (forest, remote_rank);
+    plan->send_offsets[iremote + 1] =
+      plan->send_offsets[iremote] + remote_entry->num_elements;
+    plan->recv_offsets[iremote] =
+      t8_forest_ghost_remote_first_elem (forest, remote_rank);
+  }
+  plan->recv_offsets[plan->num_remotes] = ghost->num_ghosts_elements;
+  plan->mpicomm = forest->mpicomm;
+  plan->shared = ghost->shared;
+#ifdef T8_GHOST_SHARED_WINDOWS
+  if (plan->shared != NULL) {
+    t8_forest_ghost_shared_plan (forest, plan);
+  }
+#endif
+  plan->rma = ghost->rma;
+#ifdef T8_GHOST_RMA
+  if (plan->rma != NULL) {
+    t8_forest_ghost_rma_plan (forest, plan);
+  }
+#endif
+
+  /* Store the local indices of the remote elements of each remote */
+  plan->send_indices =
+    T8_ALLOC (t8_locidx_t, plan->send_offsets[plan->num_remotes]);
+  num_send = 0;
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    remote_entry =
+      t8_forest_ghost_get_remote (forest, plan->remote_ranks[iremote]);
+    for (itree = 0; itree < remote_entry->remote_trees.elem_count; itree++) {
+      remote_tree = (t8_ghost_remote_tree_t *)
+        sc_array_index (&remote_entry->remote_trees, itree);
+      /* Get the local id of this tree */
+      ltreeid = t8_forest_get_local_id (forest, remote_tree->global_id);
+      elements_offset = t8_forest_get_tree_element_offset (forest, ltreeid);
+      for (ielement = 0; ielement < remote_tree->element_indices.elem_count;
+           ielement++) {
+        /* Get the index of this remote element in its local tree */
+        element_pos = *(t8_locidx_t *)
+          sc_array_index (&remote_tree->element_indices, ielement);
+        T8_ASSERT (0 <= element_pos);
+        plan->send_indices[num_send++] = elements_offset + element_pos;
+      }
+    }
+    T8_ASSERT (num_send == plan->send_offsets[iremote + 1]);
+  }
+
+  /* Initialize the reusable exchange context */
+  plan->exchange.num_remotes = plan->num_remotes;
+  plan->exchange.send_requests = T8_ALLOC (sc_MPI_Request, plan->num_remotes);
+  plan->exchange.recv_requests = T8_ALLOC (sc_MPI_Request, plan->num_remotes);
+  plan->exchange.plan = plan;
+  return plan;
+}
+
+/* Free the memory of a ghost exchange plan */
+static void
+t8_forest_ghost_exchange_plan_destroy (t8_ghost_exchange_plan_t ** pplan)
+{
+  t8_ghost_exchange_plan_t *plan = *pplan;
+
+  T8_ASSERT (!plan->exchange_active);
+  T8_ASSERT (plan->rma_exchange == NULL);
+  if (plan->shared_done_requests != NULL) {
+    int                 mpiret;
+    /* Wait until the remotes on our node read our segment */
+    mpiret = sc_MPI_Waitall (2 * plan->num_remotes,
+                             plan->shared_done_requests,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  T8_FREE (plan->shared_ranks);
+  T8_FREE (plan->shared_segments);
+  T8_FREE (plan->shared_done_requests);
+  T8_FREE (plan->remote_ranks);
+  T8_FREE (plan->send_offsets);
+  T8_FREE (plan->send_indices);
+  T8_FREE (plan->recv_offsets);
+  T8_FREE (plan->level_send_indices);
+  T8_FREE (plan->level_send_counts);
+  T8_FREE (plan->level_recv_indices);
+  T8_FREE (plan->level_recv_counts);
+  T8_FREE (plan->face_send_offsets);
+  T8_FREE (plan->face_send_elements);
+  T8_FREE (plan->face_send_faces);
+  T8_FREE (plan->face_recv_offsets);
+  T8_FREE (plan->face_recv_ghosts);
+  T8_FREE (plan->face_recv_faces);
+  T8_FREE (plan->exchange.send_buffer);
+  T8_FREE (plan->exchange.recv_buffer);
+  T8_FREE (plan->exchange.fields);
+  T8_FREE (plan->exchange.neighbor_counts);
+  T8_FREE (plan->exchange.changed_counts);
+  T8_FREE (plan->exchange.shared_offsets);
+  T8_FREE (plan->exchange.shared_requests);
+  T8_FREE (plan->exchange.send_requests);
+  T8_FREE (plan->exchange.recv_requests);
+  T8_FREE (plan);
+  *pplan = NULL;
+}
+
+/* Return a pointer to the entry of a field for a local or ghost element */
+static inline char *
+t8_forest_ghost_field_entry (const t8_ghost_field_t * field,
+                             t8_locidx_t index)
+{
+  return (char *) field->data + index * field->stride;
+}
+
+/* Return an exchange context for a new ghost data exchange of a forest
+ * with ghosts. The communication pattern is computed on the first call. */
+static t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_context (t8_forest_t forest)
+{
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_ghost_exchange_plan_t *plan;
+  t8_forest_ghost_t   ghost;
+
+  ghost = forest->ghosts;
+  T8_ASSERT (ghost != NULL);
+  if (ghost->exchange_plan == NULL) {
+    /* This is the first exchange, we compute the communication pattern */
+    ghost->exchange_plan = t8_forest_ghost_exchange_plan_new (forest);
+  }
+  plan = ghost->exchange_plan;
+
+  if (!plan->exchange_active) {
+    /* Reuse the exchange context and its buffers */
+    data_exchange = &plan->exchange;
+    plan->exchange_active = 1;
+  }
+  else {
+    /* Another exchange is running, we need a new exchange context */
+    data_exchange = T8_ALLOC_ZERO (t8_ghost_data_exchange_t, 1);
+    data_exchange->num_remotes = plan->num_remotes;
+    data_exchange->send_requests = T8_ALLOC (sc_MPI_Request,
+                                             plan->num_remotes);
+    data_exchange->recv_requests = T8_ALLOC (sc_MPI_Request,
+                                             plan->num_remotes);
+    data_exchange->plan = plan;
+  }
+  /* By default, an exchange sends the data of the remote elements */
+  data_exchange->send_offsets = plan->send_offsets;
+  data_exchange->recv_offsets = plan->recv_offsets;
+  data_exchange->max_num_faces = 0;
+  data_exchange->changed = 0;
+  return data_exchange;
+}
+
+/* Return the number of elements that are sent to a remote in an exchange.
+ * If counts is NULL, these are all its remote elements, otherwise
+ * counts[iremote]. */
+static inline t8_locidx_t
+t8_forest_ghost_exchange_count (const t8_locidx_t * offsets,
+                                const t8_locidx_t * counts, int iremote)
+{
+  return counts != NULL ? counts[iremote]
+    : offsets[iremote + 1] - offsets[iremote];
+}
+
+/* Return true if a remote of a plan is on our node and exchanges its data
+ * with us through the shared window */
+static inline int
+t8_forest_ghost_remote_is_shared (const t8_ghost_exchange_plan_t * plan,
+                                  int iremote)
+{
+  return plan->shared_ranks != NULL && plan->shared_ranks[iremote] >= 0;
+}
+
+/* Return our segment of the shared window as the send buffer of an exchange
+ * with data_size bytes per element, or NULL if the exchange does not use the
+ * window. Only the reusable exchange context of the plan uses it, and we
+ * wait until the remotes on our node read the data of the last exchange. */
+static char        *
+t8_forest_ghost_shared_send_buffer (t8_ghost_data_exchange_t * data_exchange,
+                                    size_t data_size)
+{
+  data_exchange->shared = 0;
+#ifdef T8_GHOST_SHARED_WINDOWS
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+
+  if (plan->shared_ranks != NULL && data_exchange == &plan->exchange
+      && data_size <= plan->shared->max_data_size) {
+    int                 mpiret;
+
+    mpiret = sc_MPI_Waitall (2 * plan->num_remotes,
+                             plan->shared_done_requests,
+                             sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Win_sync (plan->shared->window);
+    SC_CHECK_MPI (mpiret);
+    data_exchange->shared = 1;
+    return plan->shared->segment;
+  }
+#endif
+  return NULL;
+}
+
+/* Post the notifications of a ghost data exchange to the remotes on our
+ * node. Each of them is told the byte offset of its data in our segment of
+ * the shared window, or -1 if it gets the data in a message, which is then
+ * sent. The receives of their notifications are posted and the data is
+ * copied when the exchange ends. */
+static void
+t8_forest_ghost_shared_post (t8_ghost_data_exchange_t * data_exchange,
+                             const char *send_buffer, size_t data_size,
+                             const t8_locidx_t * send_counts)
+{
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+  const t8_locidx_t *send_offsets = data_exchange->send_offsets;
+  t8_gloidx_t        *offsets;
+  sc_MPI_Request     *requests;
+  t8_locidx_t         count;
+  int                 iremote, num_remotes, mpiret;
+
+  if (plan->shared_ranks == NULL) {
+    /* There is no shared window */
+    return;
+  }
+  num_remotes = plan->num_remotes;
+  if (data_exchange->shared_offsets == NULL) {
+    data_exchange->shared_offsets = T8_ALLOC (t8_gloidx_t, 2 * num_remotes);
+    data_exchange->shared_requests =
+      T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  }
+  offsets = data_exchange->shared_offsets;
+  requests = data_exchange->shared_requests;
+#ifdef T8_GHOST_SHARED_WINDOWS
+  if (data_exchange->shared) {
+    /* Make the packed data visible to the other processes */
+    mpiret = MPI_Win_sync (plan->shared->window);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    requests[iremote] = requests[num_remotes + iremote] = sc_MPI_REQUEST_NULL;
+    if (!t8_forest_ghost_remote_is_shared (plan, iremote)) {
+      continue;
+    }
+    data_exchange->send_requests[iremote] = sc_MPI_REQUEST_NULL;
+    data_exchange->recv_requests[iremote] = sc_MPI_REQUEST_NULL;
+    if (data_exchange->shared) {
+      offsets[iremote] = send_offsets[iremote] * data_size;
+      /* The remote confirms when it read its data */
+      mpiret = sc_MPI_Irecv (NULL, 0, sc_MPI_BYTE,
+                             plan->remote_ranks[iremote],
+                             T8_MPI_GHOST_SHARED_DONE, plan->mpicomm,
+                             plan->shared_done_requests + iremote);
+      SC_CHECK_MPI (mpiret);
+    }
+    else {
+      offsets[iremote] = -1;
+      count =
+        t8_forest_ghost_exchange_count (send_offsets, send_counts,
+                                        iremote);
+      mpiret =
+        sc_MPI_Isend ((void *) (send_buffer +
+                                send_offsets[iremote] * data_size),
+                      count * data_size, sc_MPI_BYTE,
+                      plan->remote_ranks[iremote], T8_MPI_GHOST_EXC_FOREST,
+                      plan->mpicomm, data_exchange->send_requests + iremote);
+      SC_CHECK_MPI (mpiret);
+    }
+    mpiret = sc_MPI_Isend (offsets + iremote, 1, T8_MPI_GLOIDX,
+                           plan->remote_ranks[iremote], T8_MPI_GHOST_SHARED,
+                           plan->mpicomm, requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Irecv (offsets + num_remotes + iremote, 1, T8_MPI_GLOIDX,
+                           plan->remote_ranks[iremote], T8_MPI_GHOST_SHARED,
+                           plan->mpicomm, requests + num_remotes + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+/* Wait for the notifications of the remotes on our node and copy the data
+ * of those that provide it in the shared window into the ghost entries,
+ * then confirm this to them. For the others, post the receives of their
+ * messages. */
+static void
+t8_forest_ghost_shared_end (t8_ghost_data_exchange_t * data_exchange)
+{
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+  const t8_locidx_t *recv_offsets = data_exchange->recv_offsets;
+  t8_gloidx_t         offset;
+  t8_locidx_t         count;
+  int                 iremote, num_remotes, mpiret;
+  char               *recv_pos;
+
+  if (plan->shared_ranks == NULL) {
+    /* There is no shared window */
+    return;
+  }
+  num_remotes = plan->num_remotes;
+  mpiret = sc_MPI_Waitall (2 * num_remotes, data_exchange->shared_requests,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+#ifdef T8_GHOST_SHARED_WINDOWS
+  /* See the data that the other processes packed */
+  mpiret = MPI_Win_sync (plan->shared->window);
+  SC_CHECK_MPI (mpiret);
+#endif
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    if (!t8_forest_ghost_remote_is_shared (plan, iremote)) {
+      continue;
+    }
+    count =
+      t8_forest_ghost_exchange_count (recv_offsets,
+                                      data_exchange->recv_counts, iremote);
+    recv_pos = data_exchange->recv_data
+      + recv_offsets[iremote] * data_exchange->data_size;
+    offset = data_exchange->shared_offsets[num_remotes + iremote];
+    if (offset < 0) {
+      /* The remote sends its data in a message */
+      mpiret = sc_MPI_Irecv (recv_pos, count * data_exchange->data_size,
+                             sc_MPI_BYTE, plan->remote_ranks[iremote],
+                             T8_MPI_GHOST_EXC_FOREST, plan->mpicomm,
+                             data_exchange->recv_requests + iremote);
+      SC_CHECK_MPI (mpiret);
+      continue;
+    }
+    memcpy (recv_pos, plan->shared_segments[iremote] + offset,
+            count * data_exchange->data_size);
+  }
+#ifdef T8_GHOST_SHARED_WINDOWS
+  /* Finish our reads before the other processes overwrite their segments */
+  mpiret = MPI_Win_sync (plan->shared->window);
+  SC_CHECK_MPI (mpiret);
+#endif
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    if (t8_forest_ghost_remote_is_shared (plan, iremote)
+        && data_exchange->shared_offsets[num_remotes + iremote] >= 0) {
+      /* Confirm that we read the data, after our last confirmation was sent */
+      mpiret = sc_MPI_Wait (plan->shared_done_requests + num_remotes
+                            + iremote, sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Isend (NULL, 0, sc_MPI_BYTE,
+                             plan->remote_ranks[iremote],
+                             T8_MPI_GHOST_SHARED_DONE, plan->mpicomm,
+                             plan->shared_done_requests + num_remotes
+                             + iremote);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+}
+
+/* The states of an exchange through the RMA window */
+#define T8_GHOST_RMA_EPOCHS 1   /* The access and exposure epochs are open */
+#define T8_GHOST_RMA_EXPOSURE 2 /* Only the exposure epoch is open */
+#define T8_GHOST_RMA_CLOSED 3   /* The data arrived in our buffer */
+
+/* End an exchange through the RMA window. We close its epochs and copy the
+ * data that the remotes put into our buffer into the ghost entries. */
+static void
+t8_forest_ghost_rma_finish (t8_ghost_data_exchange_t * data_exchange)
+{
+#ifdef T8_GHOST_RMA
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+  t8_ghost_rma_t     *rma = plan->rma;
+  t8_locidx_t         count;
+  size_t              offset;
+  int                 iremote, mpiret;
+
+  if (data_exchange->rma == 0) {
+    /* The exchange does not use the window */
+    return;
+  }
+  T8_ASSERT (plan->rma_exchange == data_exchange);
+  if (data_exchange->rma == T8_GHOST_RMA_EPOCHS) {
+    mpiret = MPI_Win_complete (rma->window);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (data_exchange->rma != T8_GHOST_RMA_CLOSED) {
+    mpiret = MPI_Win_wait (rma->window);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    if (t8_forest_ghost_remote_is_shared (plan, iremote)) {
+      continue;
+    }
+    count =
+      t8_forest_ghost_exchange_count (plan->recv_offsets,
+                                      data_exchange->recv_counts, iremote);
+    offset = plan->recv_offsets[iremote] * data_exchange->data_size;
+    memcpy (data_exchange->recv_data + offset, rma->buffer + offset,
+            count * data_exchange->data_size);
+  }
+  data_exchange->rma = 0;
+  plan->rma_exchange = NULL;
+#endif
+}
+
+/* Start an exchange through the RMA window of the plan if it has one that
+ * can hold data_size bytes per element. We open an exposure epoch for the
+ * remotes that put into our buffer and an access epoch in which we put the
+ * data of each remote that is not on our node at its precomputed
+ * displacement. Return true if the exchange uses the window. */
+static int
+t8_forest_ghost_rma_post (t8_ghost_data_exchange_t * data_exchange,
+                          const char *send_buffer, size_t data_size,
+                          const t8_locidx_t * send_counts)
+{
+  data_exchange->rma = 0;
+#ifdef T8_GHOST_RMA
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+  t8_ghost_rma_t     *rma = plan->rma;
+  t8_locidx_t         count;
+  int                 iremote, mpiret;
+
+  if (rma == NULL || data_size > rma->max_data_size
+      || data_exchange->send_offsets != plan->send_offsets
+      || data_exchange->changed) {
+    /* The window has room for the elements, not for face records, and
+     * the receivers cannot tell how much of it was put */
+    return 0;
+  }
+  if (plan->rma_exchange != NULL) {
+    /* Our buffer still holds the data of a running exchange. The remotes
+     * close its epochs before they put new data, so we finish it now. */
+    t8_forest_ghost_rma_finish (plan->rma_exchange);
+  }
+  plan->rma_exchange = data_exchange;
+  if (rma->group_size == 0) {
+    /* All remotes are on our node */
+    data_exchange->rma = T8_GHOST_RMA_CLOSED;
+    return 1;
+  }
+  data_exchange->rma = T8_GHOST_RMA_EPOCHS;
+  mpiret = MPI_Win_post (rma->group, 0, rma->window);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Win_start (rma->group, 0, rma->window);
+  SC_CHECK_MPI (mpiret);
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    if (t8_forest_ghost_remote_is_shared (plan, iremote)) {
+      /* Already handled by t8_forest_ghost_shared_post */
+      continue;
+    }
+    data_exchange->send_requests[iremote] = sc_MPI_REQUEST_NULL;
+    data_exchange->recv_requests[iremote] = sc_MPI_REQUEST_NULL;
+    count =
+      t8_forest_ghost_exchange_count (plan->send_offsets, send_counts,
+                                      iremote);
+    if (count == 0) {
+      continue;
+    }
+    mpiret =
+      MPI_Put ((void *) (send_buffer +
+                         plan->send_offsets[iremote] * data_size),
+               count * data_size, MPI_BYTE, plan->remote_ranks[iremote],
+               (MPI_Aint) (rma->displacements[iremote] * data_size),
+               count * data_size, MPI_BYTE, rma->window);
+    SC_CHECK_MPI (mpiret);
+  }
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* Test whether the data of an exchange arrived in our buffer of the RMA
+ * window, closing its epochs as far as possible. Return true if it did or
+ * if the exchange does not use the window. */
+static int
+t8_forest_ghost_rma_test (t8_ghost_data_exchange_t * data_exchange)
+{
+#ifdef T8_GHOST_RMA
+  t8_ghost_rma_t     *rma = data_exchange->plan->rma;
+  int                 flag, mpiret;
+
+  if (data_exchange->rma == T8_GHOST_RMA_EPOCHS) {
+    /* Our puts were issued, the remotes wait for us to close them */
+    mpiret = MPI_Win_complete (rma->window);
+    SC_CHECK_MPI (mpiret);
+    data_exchange->rma = T8_GHOST_RMA_EXPOSURE;
+  }
+  if (data_exchange->rma == T8_GHOST_RMA_EXPOSURE) {
+    mpiret = MPI_Win_test (rma->window, &flag);
+    SC_CHECK_MPI (mpiret);
+    if (flag) {
+      data_exchange->rma = T8_GHOST_RMA_CLOSED;
+    }
+  }
+#endif
+  return data_exchange->rma == 0
+    || data_exchange->rma == T8_GHOST_RMA_CLOSED;
+}
+
+/* Post the sends and receives of a ghost data exchange.
+ * send_buffer holds the data of the remote elements ordered as in
+ * plan->send_indices and recv_buffer receives the data of all ghosts,
+ * data_size bytes for each element. The buffers are only accessed by MPI.
+ * If send_counts and recv_counts are not NULL, only the first
+ * send_counts[i] elements of remote i are sent and recv_counts[i] are
+ * received.
+ * The remotes on our node are notified and read the data from the shared
+ * window if it holds the send buffer. If the ghost layer has an RMA window,
+ * the data of all other remotes is put into their buffers instead. */
+static void
+t8_forest_ghost_exchange_post (t8_forest_t forest,
+                               t8_ghost_data_exchange_t * data_exchange,
+                               const char *send_buffer, char *recv_buffer,
+                               size_t data_size,
+                               const t8_locidx_t * send_counts,
+                               const t8_locidx_t * recv_counts)
+{
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+  const t8_locidx_t *send_offsets = data_exchange->send_offsets;
+  const t8_locidx_t *recv_offsets = data_exchange->recv_offsets;
+  t8_profile_comm_t  *profile_comm;
+  t8_locidx_t         count;
+  int                 iremote, mpiret;
+
+  /* Each remote process gets one message and sends one */
+  profile_comm = forest->profile == NULL ? NULL :
+    &forest->profile->comm[T8_PROFILE_COMM_GHOST_EXCHANGE];
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    t8_profile_comm_sent (profile_comm, 1,
+                          t8_forest_ghost_exchange_count (send_offsets,
+                                                          send_counts,
+                                                          iremote)
+                          * data_size);
+    t8_profile_comm_received (profile_comm, 1,
+                              t8_forest_ghost_exchange_count
+                              (recv_offsets, recv_counts, iremote)
+                              * data_size);
+  }
+
+  data_exchange->recv_data = recv_buffer;
+  t8_forest_ghost_shared_post (data_exchange, send_buffer, data_size,
+                               send_counts);
+  data_exchange->neighbor_request = sc_MPI_REQUEST_NULL;
+  if (t8_forest_ghost_rma_post (data_exchange, send_buffer, data_size,
+                                send_counts)) {
+    /* The RMA window replaces the messages */
+    return;
+  }
+#ifdef T8_GHOST_NEIGHBOR_COLLECTIVES
+  if (forest->ghosts->neighbor_comm != sc_MPI_COMM_NULL
+      && !data_exchange->changed) {
+    int                *counts;
+    /* Exchange the data with one neighborhood collective on the
+     * graph communicator. Its neighbors are the remotes in plan order.
+     * The remotes on our node get no data in it. */
+    if (data_exchange->neighbor_counts == NULL) {
+      data_exchange->neighbor_counts = T8_ALLOC (int, 4 * plan->num_remotes);
+    }
+    counts = data_exchange->neighbor_counts;
+    for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+      counts[plan->num_remotes + iremote] =
+        send_offsets[iremote] * data_size;
+      counts[3 * plan->num_remotes + iremote] =
+        recv_offsets[iremote] * data_size;
+      if (t8_forest_ghost_remote_is_shared (plan, iremote)) {
+        counts[iremote] = counts[2 * plan->num_remotes + iremote] = 0;
+        continue;
+      }
+      counts[iremote] =
+        t8_forest_ghost_exchange_count (send_offsets, send_counts,
+                                        iremote) * data_size;
+      counts[2 * plan->num_remotes + iremote] =
+        t8_forest_ghost_exchange_count (recv_offsets, recv_counts,
+                                        iremote) * data_size;
+      data_exchange->send_requests[iremote] = sc_MPI_REQUEST_NULL;
+      data_exchange->recv_requests[iremote] = sc_MPI_REQUEST_NULL;
+    }
+    mpiret = MPI_Ineighbor_alltoallv ((void *) send_buffer, counts,
+                                      counts + plan->num_remotes, MPI_BYTE,
+                                      recv_buffer,
+                                      counts + 2 * plan->num_remotes,
+                                      counts + 3 * plan->num_remotes,
+                                      MPI_BYTE, forest->ghosts->neighbor_comm,
+                                      &data_exchange->neighbor_request);
+    SC_CHECK_MPI (mpiret);
+    return;
+  }
+#endif
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    if (t8_forest_ghost_remote_is_shared (plan, iremote)) {
+      /* Already handled by t8_forest_ghost_shared_post */
+      continue;
+    }
+    /* Post the asynchronuous send */
+    count =
+      t8_forest_ghost_exchange_count (send_offsets, send_counts,
+                                      iremote);
+    mpiret =
+      sc_MPI_Isend ((void *) (send_buffer +
+                              send_offsets[iremote] * data_size),
+                    count * data_size, sc_MPI_BYTE,
+                    plan->remote_ranks[iremote], T8_MPI_GHOST_EXC_FOREST,
+                    forest->mpicomm, data_exchange->send_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    if (t8_forest_ghost_remote_is_shared (plan, iremote)) {
+      continue;
+    }
+    /* In plan we stored the offset of this ranks ghosts under all ghosts */
+    count =
+      t8_forest_ghost_exchange_count (recv_offsets, recv_counts,
+                                      iremote);
+    /* receive the message */
+    mpiret =
+      sc_MPI_Irecv (recv_buffer + recv_offsets[iremote] * data_size,
+                    count * data_size, sc_MPI_BYTE,
+                    plan->remote_ranks[iremote], T8_MPI_GHOST_EXC_FOREST,
+                    forest->mpicomm, data_exchange->recv_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+/* For each remote we send and receive one message that holds the data of
+ * all fields, one field after the other. If there is one contiguous field,
+ * we receive directly into it, otherwise into a receive buffer that is
+ * unpacked when the exchange ends. */
+t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_fields_begin (t8_forest_t forest, int num_fields,
+                                       const t8_ghost_field_t * fields)
+{
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_ghost_exchange_plan_t *plan;
+  size_t              data_size, bytes;
+  t8_locidx_t         isend, num_send;
+  int                 iremote, ifield;
+  char               *send_buffer, *send_pos, *recv_buffer;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_fields > 0 && fields != NULL);
+
+  if (forest->ghosts == NULL) {
+    /* This process has no ghosts */
+    return NULL;
+  }
+  data_exchange = t8_forest_ghost_exchange_context (forest);
+  plan = data_exchange->plan;
+
+  /* Store the fields, we need them to unpack the received data */
+  if (num_fields > data_exchange->fields_alloc) {
+    data_exchange->fields =
+      T8_REALLOC (data_exchange->fields, t8_ghost_field_t, num_fields);
+    data_exchange->fields_alloc = num_fields;
+  }
+  memcpy (data_exchange->fields, fields,
+          num_fields * sizeof (t8_ghost_field_t));
+  data_exchange->num_fields = num_fields;
+  data_size = 0;
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    T8_ASSERT (fields[ifield].stride >= fields[ifield].size);
+    data_size += fields[ifield].size;
+  }
+  data_exchange->data_size = data_size;
+  data_exchange->recv_direct = num_fields == 1
+    && fields[0].stride == fields[0].size;
+  data_exchange->recv_counts = NULL;
+  /* The index in the field data at which the ghost elements start */
+  data_exchange->ghost_start = t8_forest_get_num_element (forest);
+
+  /* Pack the data of all remote elements into the send buffer */
+  send_buffer = t8_forest_ghost_shared_send_buffer (data_exchange, data_size);
+  if (send_buffer == NULL) {
+    num_send = plan->send_offsets[plan->num_remotes];
+    bytes = num_send * data_size;
+    if (bytes > data_exchange->buffer_bytes) {
+      data_exchange->send_buffer =
+        T8_REALLOC (data_exchange->send_buffer, char, bytes);
+      data_exchange->buffer_bytes = bytes;
+    }
+    send_buffer = data_exchange->send_buffer;
+  }
+  send_pos = send_buffer;
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    for (ifield = 0; ifield < num_fields; ifield++) {
+      for (isend = plan->send_offsets[iremote];
+           isend < plan->send_offsets[iremote + 1]; isend++) {
+        memcpy (send_pos,
+                t8_forest_ghost_field_entry (fields + ifield,
+                                             plan->send_indices[isend]),
+                fields[ifield].size);
+        send_pos += fields[ifield].size;
+      }
+    }
+  }
+
+  if (data_exchange->recv_direct) {
+    recv_buffer =
+      t8_forest_ghost_field_entry (fields, data_exchange->ghost_start);
+  }
+  else {
+    bytes = forest->ghosts->num_ghosts_elements * data_size;
+    if (bytes > data_exchange->recv_buffer_bytes) {
+      data_exchange->recv_buffer =
+        T8_REALLOC (data_exchange->recv_buffer, char, bytes);
+      data_exchange->recv_buffer_bytes = bytes;
+    }
+    recv_buffer = data_exchange->recv_buffer;
+  }
+  t8_forest_ghost_exchange_post (forest, data_exchange, send_buffer,
+                                 recv_buffer, data_size, NULL, NULL);
+  return data_exchange;
+}
+
+t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_packed_begin (t8_forest_t forest,
+                                       const void *send_buffer,
+                                       void *recv_buffer, size_t data_size)
+{
+  t8_ghost_data_exchange_t *data_exchange;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (forest->ghosts == NULL) {
+    /* This process has no ghosts */
+    return NULL;
+  }
+  data_exchange = t8_forest_ghost_exchange_context (forest);
+  /* The caller packs and unpacks the data */
+  data_exchange->shared = 0;
+  data_exchange->num_fields = 0;
+  data_exchange->data_size = data_size;
+  data_exchange->recv_direct = 1;
+  data_exchange->recv_counts = NULL;
+  t8_forest_ghost_exchange_post (forest, data_exchange,
+                                 (const char *) send_buffer,
+                                 (char *) recv_buffer, data_size, NULL, NULL);
+  return data_exchange;
+}
+
+void
+t8_forest_ghost_exchange_get_pattern (t8_forest_t forest, int *num_remotes,
+                                      const int **remote_ranks,
+                                      const t8_locidx_t ** send_offsets,
+                                      const t8_locidx_t ** send_indices,
+                                      const t8_locidx_t ** recv_offsets)
+{
+  t8_ghost_exchange_plan_t *plan;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (forest->ghosts == NULL) {
+    /* This process has no ghosts */
+    *num_remotes = 0;
+    *remote_ranks = NULL;
+    *send_offsets = *send_indices = *recv_offsets = NULL;
+    return;
+  }
+  if (forest->ghosts->exchange_plan == NULL) {
+    forest->ghosts->exchange_plan = t8_forest_ghost_exchange_plan_new (forest);
+  }
+  plan = forest->ghosts->exchange_plan;
+  *num_remotes = plan->num_remotes;
+  *remote_ranks = plan->remote_ranks;
+  *send_offsets = plan->send_offsets;
+  *send_indices = plan->send_indices;
+  *recv_offsets = plan->recv_offsets;
+}
+
+/* Copy the received data of all fields from the receive buffer to the
+ * ghost entries of the fields */
+static void
+t8_forest_ghost_exchange_unpack (t8_ghost_data_exchange_t * data_exchange)
+{
+  t8_ghost_exchange_plan_t *plan = data_exchange->plan;
+  const t8_ghost_field_t *field;
+  t8_locidx_t         ighost, position;
+  int                 iremote, ifield;
+  char               *recv_pos;
+
+  if (data_exchange->max_num_faces > 0) {
+    /* Copy each face record to the entry of its ghost and face */
+    T8_ASSERT (data_exchange->num_fields == 1);
+    field = data_exchange->fields;
+    recv_pos = data_exchange->recv_buffer;
+    for (ighost = 0; ighost < plan->face_recv_offsets[plan->num_remotes];
+         ighost++) {
+      memcpy (t8_forest_ghost_field_entry (field,
+                                           (data_exchange->ghost_start +
+                                            plan->face_recv_ghosts[ighost])
+                                           * data_exchange->max_num_faces
+                                           + plan->face_recv_faces[ighost]),
+              recv_pos, field->size);
+      recv_pos += field->size;
+    }
+    return;
+  }
+  if (data_exchange->changed) {
+    /* Copy the data of the received records up to the end marker */
+    field = data_exchange->fields;
+    for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+      recv_pos = data_exchange->recv_buffer
+        + plan->recv_offsets[iremote] * data_exchange->data_size;
+      for (ighost = plan->recv_offsets[iremote];
+           ighost < plan->recv_offsets[iremote + 1]; ighost++) {
+        memcpy (&position, recv_pos, sizeof (t8_locidx_t));
+        if (position < 0) {
+          break;
+        }
+        T8_ASSERT (position < plan->recv_offsets[iremote + 1]
+                   - plan->recv_offsets[iremote]);
+        memcpy (t8_forest_ghost_field_entry (field,
+                                             data_exchange->ghost_start +
+                                             plan->recv_offsets[iremote] +
+                                             position),
+                recv_pos + sizeof (t8_locidx_t), field->size);
+        recv_pos += data_exchange->data_size;
+      }
+    }
+    return;
+  }
+  if (data_exchange->recv_counts != NULL) {
+    /* Only the ghosts of the exchanged levels were received, at the
+     * position of the first ghost of their remote */
+    T8_ASSERT (data_exchange->num_fields == 1);
+    field = data_exchange->fields;
+    for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+      recv_pos = data_exchange->recv_buffer
+        + plan->recv_offsets[iremote] * field->size;
+      for (ighost = plan->recv_offsets[iremote];
+           ighost < plan->recv_offsets[iremote]
+           + data_exchange->recv_counts[iremote]; ighost++) {
+        memcpy (t8_forest_ghost_field_entry (field,
+                                             data_exchange->ghost_start +
+                                             plan->level_recv_indices
+                                             [ighost]), recv_pos,
+                field->size);
+        recv_pos += field->size;
+      }
+    }
+    return;
+  }
+  recv_pos = data_exchange->recv_buffer;
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    for (ifield = 0; ifield < data_exchange->num_fields; ifield++) {
+      field = data_exchange->fields + ifield;
+      for (ighost = plan->recv_offsets[iremote];
+           ighost < plan->recv_offsets[iremote + 1]; ighost++) {
+        memcpy (t8_forest_ghost_field_entry (field,
+                                             data_exchange->ghost_start +
+                                             ighost), recv_pos, field->size);
+        recv_pos += field->size;
+      }
+    }
+  }
+}
+
+t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_begin (t8_forest_t forest, sc_array_t * element_data)
+{
+  t8_ghost_field_t    field;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (element_data != NULL);
+  T8_ASSERT (forest->ghosts == NULL
+             || (t8_locidx_t) element_data->elem_count ==
+             t8_forest_get_num_element (forest)
+             + t8_forest_get_num_ghosts (forest));
+
+  field.data = element_data->array;
+  field.size = field.stride = element_data->elem_size;
+  return t8_forest_ghost_exchange_fields_begin (forest, 1, &field);
+}
+
+/* Order the elements of one remote by descending level.
+ * The elements are indices[first], ..., indices[last - 1], or first, ...,
+ * last - 1 if indices is NULL, and levels holds the level of each element.
+ * On output, sorted[first], ..., sorted[last - 1] holds the ordered elements
+ * and counts[l * stride] the number of them with level >= l. */
+static void
+t8_forest_ghost_level_sort (const int8_t * levels,
+                            const t8_locidx_t * indices, t8_locidx_t first,
+                            t8_locidx_t last, int num_levels,
+                            t8_locidx_t * sorted, t8_locidx_t * counts,
+                            int stride)
+{
+  t8_locidx_t        *next, ielement, index;
+  int                 ilevel;
+
+  for (ilevel = 0; ilevel < num_levels; ilevel++) {
+    counts[ilevel * stride] = 0;
+  }
+  for (ielement = first; ielement < last; ielement++) {
+    index = indices != NULL ? indices[ielement] : ielement;
+    T8_ASSERT (0 <= levels[index] && levels[index] < num_levels);
+    counts[levels[index] * stride]++;
+  }
+  /* The elements of level l start after all elements of a finer level */
+  next = T8_ALLOC (t8_locidx_t, num_levels);
+  next[num_levels - 1] = 0;
+  for (ilevel = num_levels - 2; ilevel >= 0; ilevel--) {
+    next[ilevel] = counts[(ilevel + 1) * stride];
+    counts[ilevel * stride] += counts[(ilevel + 1) * stride];
+  }
+  for (ielement = first; ielement < last; ielement++) {
+    index = indices != NULL ? indices[ielement] : ielement;
+    sorted[first + next[levels[index]]++] = index;
+  }
+  T8_FREE (next);
+}
+
+/* Compute the arrays of an exchange plan for exchanges restricted to levels */
+static void
+t8_forest_ghost_exchange_plan_levels (t8_forest_t forest,
+                                      t8_ghost_exchange_plan_t * plan)
+{
+  t8_locidx_t         num_ghosts, num_send;
+  int8_t             *levels;
+  int                 iremote, num_levels;
+
+  num_levels = plan->num_levels = t8_forest_get_maxlevel (forest) + 1;
+  num_send = plan->send_offsets[plan->num_remotes];
+  num_ghosts = plan->recv_offsets[plan->num_remotes];
+  plan->level_send_indices = T8_ALLOC (t8_locidx_t, num_send);
+  plan->level_recv_indices = T8_ALLOC (t8_locidx_t, num_ghosts);
+  plan->level_send_counts =
+    T8_ALLOC (t8_locidx_t, num_levels * plan->num_remotes);
+  plan->level_recv_counts =
+    T8_ALLOC (t8_locidx_t, num_levels * plan->num_remotes);
+
+  /* Order the remote elements of each remote by level */
+  levels = T8_ALLOC (int8_t, SC_MAX (t8_forest_get_num_element (forest),
+                                     num_ghosts));
+  t8_forest_element_levels_compute (forest, levels);
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    t8_forest_ghost_level_sort (levels, plan->send_indices,
+                                plan->send_offsets[iremote],
+                                plan->send_offsets[iremote + 1], num_levels,
+                                plan->level_send_indices,
+                                plan->level_send_counts + iremote,
+                                plan->num_remotes);
+  }
+  /* Order the ghosts of each remote by level */
+  t8_forest_ghost_levels_compute (forest, levels);
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    t8_forest_ghost_level_sort (levels, NULL, plan->recv_offsets[iremote],
+                                plan->recv_offsets[iremote + 1], num_levels,
+                                plan->level_recv_indices,
+                                plan->level_recv_counts + iremote,
+                                plan->num_remotes);
+  }
+  T8_FREE (levels);
+}
+
+/* The remote elements of each remote are packed by descending level, such
+ * that the elements of the exchanged levels are a prefix of its message.
+ * The ghosts are received into the receive buffer and unpacked by level. */
+t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_levels_begin (t8_forest_t forest,
+                                       sc_array_t * element_data,
+                                       int min_level)
+{
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_ghost_exchange_plan_t *plan;
+  t8_ghost_field_t   *field;
+  const t8_locidx_t  *send_counts;
+  size_t              data_size, bytes;
+  t8_locidx_t         isend;
+  int                 iremote;
+  char               *send_buffer;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (element_data != NULL);
+  T8_ASSERT (0 <= min_level && min_level <= t8_forest_get_maxlevel (forest));
+
+  if (forest->ghosts == NULL) {
+    /* This process has no ghosts */
+    return NULL;
+  }
+  T8_ASSERT ((t8_locidx_t) element_data->elem_count ==
+             t8_forest_get_num_element (forest)
+             + t8_forest_get_num_ghosts (forest));
+  data_exchange = t8_forest_ghost_exchange_context (forest);
+  plan = data_exchange->plan;
+  if (plan->num_levels == 0) {
+    t8_forest_ghost_exchange_plan_levels (forest, plan);
+  }
+
+  /* Store the field, we need it to unpack the received data */
+  if (data_exchange->fields_alloc < 1) {
+    data_exchange->fields = T8_ALLOC (t8_ghost_field_t, 1);
+    data_exchange->fields_alloc = 1;
+  }
+  field = data_exchange->fields;
+  field->data = element_data->array;
+  field->size = field->stride = data_size = element_data->elem_size;
+  data_exchange->num_fields = 1;
+  data_exchange->data_size = data_size;
+  data_exchange->recv_direct = 0;
+  data_exchange->ghost_start = t8_forest_get_num_element (forest);
+  send_counts = plan->level_send_counts + min_level * plan->num_remotes;
+  data_exchange->recv_counts =
+    plan->level_recv_counts + min_level * plan->num_remotes;
+
+  /* Pack the data of the remote elements of the exchanged levels */
+  send_buffer = t8_forest_ghost_shared_send_buffer (data_exchange, data_size);
+  if (send_buffer == NULL) {
+    bytes = plan->send_offsets[plan->num_remotes] * data_size;
+    if (bytes > data_exchange->buffer_bytes) {
+      data_exchange->send_buffer =
+        T8_REALLOC (data_exchange->send_buffer, char, bytes);
+      data_exchange->buffer_bytes = bytes;
+    }
+    send_buffer = data_exchange->send_buffer;
+  }
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    for (isend = plan->send_offsets[iremote];
+         isend < plan->send_offsets[iremote] + send_counts[iremote];
+         isend++) {
+      memcpy (send_buffer + isend * data_size,
+              t8_forest_ghost_field_entry (field,
+                                           plan->level_send_indices[isend]),
+              data_size);
+    }
+  }
+  bytes = forest->ghosts->num_ghosts_elements * data_size;
+  if (bytes > data_exchange->recv_buffer_bytes) {
+    data_exchange->recv_buffer =
+      T8_REALLOC (data_exchange->recv_buffer, char, bytes);
+    data_exchange->recv_buffer_bytes = bytes;
+  }
+  t8_forest_ghost_exchange_post (forest, data_exchange, send_buffer,
+                                 data_exchange->recv_buffer, data_size,
+                                 send_counts, data_exchange->recv_counts);
+  return data_exchange;
+}
+
+void
+t8_forest_ghost_exchange_levels (t8_forest_t forest,
+                                 sc_array_t * element_data, int min_level)
+{
+  t8_ghost_data_exchange_t *data_exchange;
+
+  t8_profile_region_begin ("ghost_exchange");
+  data_exchange =
+    t8_forest_ghost_exchange_levels_begin (forest, element_data, min_level);
+  if (forest->profile != NULL) {
+    /* Measure the time for ghost_exchange_end */
+    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
+  }
+  t8_profile_region_begin ("ghost_exchange_wait");
+  t8_forest_ghost_exchange_end (data_exchange);
+  t8_profile_region_end ("ghost_exchange_wait");
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime += sc_MPI_Wtime ();
+  }
+  t8_profile_region_end ("ghost_exchange");
+}
+
+/* Return the remote whose range offsets[iremote], ..., offsets[iremote + 1] - 1
+ * contains index. offsets has num_remotes + 1 ascending entries. */
+static int
+t8_forest_ghost_offsets_search (const t8_locidx_t * offsets, int num_remotes,
+                                t8_locidx_t index)
+{
+  int                 low = 0, high = num_remotes - 1, mid;
+
+  T8_ASSERT (offsets[0] <= index && index < offsets[num_remotes]);
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    if (offsets[mid] <= index) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+/* Build the list of the (element, face) records of an exchange from a face
+ * mask for each element. Bit f of masks[k] is set if face f of element k is
+ * exchanged. The elements of remote i are the entries offsets[i], ...,
+ * offsets[i + 1] - 1 of masks, their indices are stored from indices or,
+ * if indices is NULL, the entry itself. */
+static void
+t8_forest_ghost_face_list (const uint8_t * masks, const t8_locidx_t * offsets,
+                           const t8_locidx_t * indices, int num_remotes,
+                           t8_locidx_t ** precord_offsets,
+                           t8_locidx_t ** pelements, int8_t ** pfaces)
 {
-  T8_ASSERT (t8_forest_is_committed (forest));
-  if (forest->mpisize > 1) {
-    /* TODO: assert that forest is balanced */
-    /* Call balanced version of ghost algorithm */
-    t8_forest_ghost_create_ext (forest, 0);
+  t8_locidx_t         ielement, num_records;
+  int                 iremote, iface;
+
+  num_records = 0;
+  for (ielement = 0; ielement < offsets[num_remotes]; ielement++) {
+    for (iface = 0; iface < T8_ECLASS_MAX_FACES; iface++) {
+      num_records += (masks[ielement] >> iface) & 1;
+    }
+  }
+  *precord_offsets = T8_ALLOC (t8_locidx_t, num_remotes + 1);
+  *pelements = T8_ALLOC (t8_locidx_t, num_records);
+  *pfaces = T8_ALLOC (int8_t, num_records);
+  num_records = 0;
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    (*precord_offsets)[iremote] = num_records;
+    for (ielement = offsets[iremote]; ielement < offsets[iremote + 1];
+         ielement++) {
+      for (iface = 0; iface < T8_ECLASS_MAX_FACES; iface++) {
+        if (masks[ielement] & (1 << iface)) {
+          (*pelements)[num_records] =
+            indices != NULL ? indices[ielement] : ielement;
+          (*pfaces)[num_records++] = iface;
+        }
+      }
+    }
   }
+  (*precord_offsets)[num_remotes] = num_records;
 }
 
-void
-t8_forest_ghost_create_topdown (t8_forest_t forest)
+/* Compute the arrays of an exchange plan for face exchanges.
+ * A face of a remote element is sent to each remote that has a ghost
+ * neighbor across it. The receivers cannot compute the neighbors of their
+ * ghosts, so we send them the faces for each ghost once. */
+static void
+t8_forest_ghost_exchange_plan_faces (t8_forest_t forest,
+                                     t8_ghost_exchange_plan_t * plan)
 {
-  T8_ASSERT (t8_forest_is_committed (forest));
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_forest_element_cursor_t cursor;
+  t8_element_scratch_t scratch;
+  t8_element_t      **neighbor_leafs;
+  t8_eclass_scheme_c *neigh_scheme;
+  const t8_locidx_t  *neighbors;
+  t8_locidx_t        *element_indices, num_local, ghost, low, high, mid;
+  uint8_t            *send_masks, *recv_masks;
+  int8_t             *is_remote;
+  int                 iface, num_faces, ineigh, num_neighbors, iremote;
+  int                *dual_faces;
+
+  num_local = t8_forest_get_num_element (forest);
+  send_masks = T8_ALLOC_ZERO (uint8_t, plan->send_offsets[plan->num_remotes]);
+  recv_masks = T8_ALLOC (uint8_t, plan->recv_offsets[plan->num_remotes]);
+  is_remote = T8_ALLOC_ZERO (int8_t, num_local);
+  t8_forest_ghost_mark_remote_elements (forest, is_remote);
+
+  /* Mark the faces of the remote elements at which a ghost is a neighbor */
+  t8_element_scratch_init (&scratch, 0);
+  t8_forest_element_cursor_init (forest, &cursor);
+  while (t8_forest_element_cursor_next (&cursor)) {
+    if (!is_remote[cursor.lelement_id]) {
+      /* All neighbors of this element are local */
+      continue;
+    }
+    num_faces = cursor.ts->t8_element_num_faces (cursor.element);
+    T8_ASSERT (num_faces <= T8_ECLASS_MAX_FACES);
+    for (iface = 0; iface < num_faces; iface++) {
+      if (forest->face_neighbors != NULL) {
+        num_neighbors =
+          t8_forest_get_face_neighbors (forest, cursor.lelement_id, iface,
+                                        &neighbors, NULL, NULL);
+      }
+      else {
+        num_neighbors =
+          t8_forest_leaf_face_neighbors_scratch (forest, cursor.ltreeid,
+                                                 cursor.element, iface,
+                                                 &scratch, &neighbor_leafs,
+                                                 &dual_faces,
+                                                 &element_indices,
+                                                 &neigh_scheme, 1);
+        neighbors = element_indices;
+      }
+      for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+        if (neighbors[ineigh] < num_local) {
+          continue;
+        }
+        /* Find the remote of this ghost and our element in its list of
+         * remote elements, which is ascending */
+        ghost = neighbors[ineigh] - num_local;
+        iremote = t8_forest_ghost_offsets_search (plan->recv_offsets,
+                                                  plan->num_remotes, ghost);
+        low = plan->send_offsets[iremote];
+        high = plan->send_offsets[iremote + 1] - 1;
+        while (low < high) {
+          mid = (low + high) / 2;
+          if (plan->send_indices[mid] < cursor.lelement_id) {
+            low = mid + 1;
+          }
+          else {
+            high = mid;
+          }
+        }
+        T8_ASSERT (plan->send_indices[low] == cursor.lelement_id);
+        send_masks[low] |= 1 << iface;
+      }
+      t8_element_scratch_clear (&scratch);
+    }
+  }
+  t8_element_scratch_reset (&scratch);
+  T8_FREE (is_remote);
 
-  t8_forest_ghost_create_ext (forest, -1);
+  /* Tell each remote the faces of its ghosts that it receives */
+  data_exchange =
+    t8_forest_ghost_exchange_packed_begin (forest, send_masks, recv_masks,
+                                           sizeof (uint8_t));
+  t8_forest_ghost_exchange_end (data_exchange);
+  t8_forest_ghost_face_list (send_masks, plan->send_offsets,
+                             plan->send_indices, plan->num_remotes,
+                             &plan->face_send_offsets,
+                             &plan->face_send_elements,
+                             &plan->face_send_faces);
+  t8_forest_ghost_face_list (recv_masks, plan->recv_offsets, NULL,
+                             plan->num_remotes, &plan->face_recv_offsets,
+                             &plan->face_recv_ghosts,
+                             &plan->face_recv_faces);
+  T8_FREE (send_masks);
+  T8_FREE (recv_masks);
 }
 
-/** Return the array of remote ranks.
- * \param [in] forest   A forest with constructed ghost layer.
- * \param [in,out] num_remotes On output the number of remote ranks is stored here.
- * \return              The array of remote ranks in ascending order.
- */
-int                *
-t8_forest_ghost_get_remotes (t8_forest_t forest, int *num_remotes)
+/* One record is sent for each face of a remote element that has a ghost
+ * neighbor of the receiver. The records are received into the receive
+ * buffer and unpacked by their ghost and face. */
+t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_faces_begin (t8_forest_t forest,
+                                      sc_array_t * face_data,
+                                      int max_num_faces)
 {
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_ghost_exchange_plan_t *plan;
+  t8_ghost_field_t   *field;
+  size_t              data_size, bytes;
+  t8_locidx_t         irecord, num_records;
+  char               *send_buffer;
+
   T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (face_data != NULL);
+  T8_ASSERT (0 < max_num_faces && max_num_faces <= T8_ECLASS_MAX_FACES);
+
   if (forest->ghosts == NULL) {
-    *num_remotes = 0;
+    /* This process has no ghosts */
     return NULL;
   }
-  T8_ASSERT (forest->ghosts != NULL);
+  T8_ASSERT ((t8_locidx_t) face_data->elem_count ==
+             (t8_forest_get_num_element (forest)
+              + t8_forest_get_num_ghosts (forest)) * max_num_faces);
+  if (forest->ghosts->exchange_plan == NULL) {
+    forest->ghosts->exchange_plan = t8_forest_ghost_exchange_plan_new (forest);
+  }
+  plan = forest->ghosts->exchange_plan;
+  if (plan->face_send_offsets == NULL) {
+    /* This exchanges the face masks, so we do it before we take the
+     * exchange context */
+    t8_forest_ghost_exchange_plan_faces (forest, plan);
+  }
+  data_exchange = t8_forest_ghost_exchange_context (forest);
 
-  *num_remotes = forest->ghosts->remote_processes->elem_count;
-  return (int *) forest->ghosts->remote_processes->array;
+  /* Store the field, we need it to unpack the received data */
+  if (data_exchange->fields_alloc < 1) {
+    data_exchange->fields = T8_ALLOC (t8_ghost_field_t, 1);
+    data_exchange->fields_alloc = 1;
+  }
+  field = data_exchange->fields;
+  field->data = face_data->array;
+  field->size = field->stride = data_size = face_data->elem_size;
+  data_exchange->num_fields = 1;
+  data_exchange->data_size = data_size;
+  data_exchange->recv_direct = 0;
+  data_exchange->recv_counts = NULL;
+  data_exchange->ghost_start = t8_forest_get_num_element (forest);
+  data_exchange->send_offsets = plan->face_send_offsets;
+  data_exchange->recv_offsets = plan->face_recv_offsets;
+  data_exchange->max_num_faces = max_num_faces;
+  /* The shared window has room for the elements, not for face records */
+  data_exchange->shared = 0;
+
+  /* Pack the face records */
+  num_records = plan->face_send_offsets[plan->num_remotes];
+  bytes = num_records * data_size;
+  if (bytes > data_exchange->buffer_bytes) {
+    data_exchange->send_buffer =
+      T8_REALLOC (data_exchange->send_buffer, char, bytes);
+    data_exchange->buffer_bytes = bytes;
+  }
+  send_buffer = data_exchange->send_buffer;
+  for (irecord = 0; irecord < num_records; irecord++) {
+    T8_ASSERT (plan->face_send_faces[irecord] < max_num_faces);
+    memcpy (send_buffer + irecord * data_size,
+            t8_forest_ghost_field_entry (field,
+                                         plan->face_send_elements[irecord]
+                                         * max_num_faces
+                                         + plan->face_send_faces[irecord]),
+            data_size);
+  }
+  bytes = plan->face_recv_offsets[plan->num_remotes] * data_size;
+  if (bytes > data_exchange->recv_buffer_bytes) {
+    data_exchange->recv_buffer =
+      T8_REALLOC (data_exchange->recv_buffer, char, bytes);
+    data_exchange->recv_buffer_bytes = bytes;
+  }
+  t8_forest_ghost_exchange_post (forest, data_exchange, send_buffer,
+                                 data_exchange->recv_buffer, data_size,
+                                 NULL, NULL);
+  return data_exchange;
 }
 
-/** Return the first local ghost tree of a remote rank.
- * \param [in] forest   A forest with constructed ghost layer.
- * \param [in] remote   A remote rank of the ghost layer in \a forest.
- * \return              The ghost tree id of the first ghost tree that stores ghost
- *                      elements of \a remote.
- */
-t8_locidx_t
-t8_forest_ghost_remote_first_tree (t8_forest_t forest, int remote)
+void
+t8_forest_ghost_exchange_faces (t8_forest_t forest, sc_array_t * face_data,
+                                int max_num_faces)
 {
-  t8_ghost_process_hash_t *proc_entry;
-
-  T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (forest->ghosts != NULL);
+  t8_ghost_data_exchange_t *data_exchange;
 
-  proc_entry = t8_forest_ghost_get_proc_info (forest, remote);
-  T8_ASSERT (proc_entry->mpirank == remote);
-  return proc_entry->tree_index;
+  t8_profile_region_begin ("ghost_exchange");
+  data_exchange =
+    t8_forest_ghost_exchange_faces_begin (forest, face_data, max_num_faces);
+  if (forest->profile != NULL) {
+    /* Measure the time for ghost_exchange_end */
+    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
+  }
+  t8_profile_region_begin ("ghost_exchange_wait");
+  t8_forest_ghost_exchange_end (data_exchange);
+  t8_profile_region_end ("ghost_exchange_wait");
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime += sc_MPI_Wtime ();
+  }
+  t8_profile_region_end ("ghost_exchange");
 }
 
-/** Return the local index of the first ghost element that belongs to a given remote rank.
- * \param [in] forest   A forest with constructed ghost layer.
- * \param [in] remote   A remote rank of the ghost layer in \a forest.
- * \return              The index i in the ghost elements of the first element of rank \a remote
- */
-t8_locidx_t
-t8_forest_ghost_remote_first_elem (t8_forest_t forest, int remote)
+/* Each message holds one record for each changed remote element, its index
+ * among the elements that we send to the remote followed by its data.
+ * If not all elements changed, a record with index -1 ends the message.
+ * The receive buffer has room for a record of each ghost. */
+t8_ghost_data_exchange_t *
+t8_forest_ghost_exchange_changed_begin (t8_forest_t forest,
+                                        sc_array_t * element_data,
+                                        const int8_t * changed)
 {
-  t8_ghost_process_hash_t *proc_entry;
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_ghost_exchange_plan_t *plan;
+  t8_ghost_field_t   *field;
+  size_t              data_size, record_size, bytes;
+  t8_locidx_t         isend, position, count;
+  int                 iremote;
+  char               *send_pos;
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (forest->ghosts != NULL);
+  T8_ASSERT (element_data != NULL);
+  T8_ASSERT (changed != NULL || t8_forest_get_num_element (forest) == 0);
 
-  proc_entry = t8_forest_ghost_get_proc_info (forest, remote);
-  T8_ASSERT (proc_entry->mpirank == remote);
+  if (forest->ghosts == NULL) {
+    /* This process has no ghosts */
+    return NULL;
+  }
+  T8_ASSERT ((t8_locidx_t) element_data->elem_count ==
+             t8_forest_get_num_element (forest)
+             + t8_forest_get_num_ghosts (forest));
+  data_exchange = t8_forest_ghost_exchange_context (forest);
+  plan = data_exchange->plan;
 
-  return proc_entry->ghost_offset;
+  /* Store the field, we need it to unpack the received data */
+  if (data_exchange->fields_alloc < 1) {
+    data_exchange->fields = T8_ALLOC (t8_ghost_field_t, 1);
+    data_exchange->fields_alloc = 1;
+  }
+  field = data_exchange->fields;
+  field->data = element_data->array;
+  field->size = field->stride = data_size = element_data->elem_size;
+  record_size = sizeof (t8_locidx_t) + data_size;
+  data_exchange->num_fields = 1;
+  data_exchange->data_size = record_size;
+  data_exchange->recv_direct = 0;
+  data_exchange->recv_counts = NULL;
+  data_exchange->ghost_start = t8_forest_get_num_element (forest);
+  data_exchange->changed = 1;
+  data_exchange->shared = 0;
+  if (data_exchange->changed_counts == NULL) {
+    data_exchange->changed_counts = T8_ALLOC (t8_locidx_t, plan->num_remotes);
+  }
+
+  /* Pack the records of the changed remote elements */
+  bytes = plan->send_offsets[plan->num_remotes] * record_size;
+  if (bytes > data_exchange->buffer_bytes) {
+    data_exchange->send_buffer =
+      T8_REALLOC (data_exchange->send_buffer, char, bytes);
+    data_exchange->buffer_bytes = bytes;
+  }
+  for (iremote = 0; iremote < plan->num_remotes; iremote++) {
+    send_pos = data_exchange->send_buffer
+      + plan->send_offsets[iremote] * record_size;
+    count = 0;
+    for (isend = plan->send_offsets[iremote];
+         isend < plan->send_offsets[iremote + 1]; isend++) {
+      if (!changed[plan->send_indices[isend]]) {
+        continue;
+      }
+      position = isend - plan->send_offsets[iremote];
+      memcpy (send_pos, &position, sizeof (t8_locidx_t));
+      memcpy (send_pos + sizeof (t8_locidx_t),
+              t8_forest_ghost_field_entry (field, plan->send_indices[isend]),
+              data_size);
+      send_pos += record_size;
+      count++;
+    }
+    if (count < plan->send_offsets[iremote + 1] - plan->send_offsets[iremote]) {
+      /* Mark the end of the message */
+      position = -1;
+      memcpy (send_pos, &position, sizeof (t8_locidx_t));
+      count++;
+    }
+    data_exchange->changed_counts[iremote] = count;
+  }
+  bytes = forest->ghosts->num_ghosts_elements * record_size;
+  if (bytes > data_exchange->recv_buffer_bytes) {
+    data_exchange->recv_buffer =
+      T8_REALLOC (data_exchange->recv_buffer, char, bytes);
+    data_exchange->recv_buffer_bytes = bytes;
+  }
+  t8_forest_ghost_exchange_post (forest, data_exchange,
+                                 data_exchange->send_buffer,
+                                 data_exchange->recv_buffer, record_size,
+                                 data_exchange->changed_counts, NULL);
+  return data_exchange;
 }
 
-/* Fill the send buffer for a ghost data exchange for on remote rank.
- * returns the number of bytes in the buffer. */
-static              size_t
-t8_forest_ghost_exchange_fill_send_buffer (t8_forest_t forest, int remote,
-                                           char **pbuffer,
-                                           sc_array_t * element_data)
+void
+t8_forest_ghost_exchange_changed (t8_forest_t forest,
+                                  sc_array_t * element_data,
+                                  const int8_t * changed)
 {
-  char               *buffer;
-  t8_ghost_remote_t   lookup_rank, *remote_entry;
-  t8_ghost_remote_tree_t *remote_tree;
-  t8_forest_ghost_t   ghost;
-  size_t              index, element_index, data_size;
-  size_t              elements_inserted, byte_count;
-  t8_tree_t           local_tree;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
-  t8_locidx_t         itree, ielement, element_pos;
-  t8_locidx_t         ltreeid;
-  size_t              elem_count;
-
-  ghost = forest->ghosts;
-  data_size = element_data->elem_size;
-  elements_inserted = 0;
-  lookup_rank.remote_rank = remote;
+  t8_ghost_data_exchange_t *data_exchange;
 
-  /* Lookup the remote entry of this remote process */
-#ifdef T8_ENABLE_DEBUG
-  ret =
-#else
-  (void)
-#endif
-    sc_hash_array_lookup (ghost->remote_ghosts, &lookup_rank, &index);
-  T8_ASSERT (ret != 0);
-  remote_entry =
-    (t8_ghost_remote_t *) sc_array_index (&ghost->remote_ghosts->a, index);
-  T8_ASSERT (remote_entry->remote_rank == remote);
-
-  /* allocate memory for the send buffer */
-  byte_count = data_size * remote_entry->num_elements;
-  buffer = *pbuffer = T8_ALLOC (char, byte_count);
-
-  /* We now iterate over the remote trees and their elements to find the
-   * local element indices of the remote elements */
-  for (itree = 0; itree < (t8_locidx_t) remote_entry->remote_trees.elem_count;
-       itree++) {
-    /* tree loop */
-    remote_tree = (t8_ghost_remote_tree_t *)
-      t8_sc_array_index_locidx (&remote_entry->remote_trees, itree);
-    /* Get the local id of this tree */
-    /* TODO: Why does remote_tree store the global id? could be local instead */
-    ltreeid = t8_forest_get_local_id (forest, remote_tree->global_id);
-    /* Get a pointer to the forest tree */
-    local_tree = t8_forest_get_tree (forest, ltreeid);
-    elem_count = t8_element_array_get_count (&remote_tree->elements);
-    for (ielement = 0; ielement < (t8_locidx_t) elem_count; ielement++) {
-      /* element loop */
-      /* Get the index of this remote element in its local tree */
-      element_pos = *(t8_locidx_t *)
-        t8_sc_array_index_locidx (&remote_tree->element_indices, ielement);
-      T8_ASSERT (0 <= element_pos);
-      /* Compute the index of this element in the element_data array */
-      element_index = local_tree->elements_offset + element_pos;
-      /* Copy the data of this element from the element_data array to the send buffer */
-      memcpy (buffer + elements_inserted * data_size,
-              sc_array_index (element_data, element_index), data_size);
-      elements_inserted++;
-    }
-  }
-  return byte_count;
+  t8_profile_region_begin ("ghost_exchange");
+  data_exchange =
+    t8_forest_ghost_exchange_changed_begin (forest, element_data, changed);
+  if (forest->profile != NULL) {
+    /* Measure the time for ghost_exchange_end */
+    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
+  }
+  t8_profile_region_begin ("ghost_exchange_wait");
+  t8_forest_ghost_exchange_end (data_exchange);
+  t8_profile_region_end ("ghost_exchange_wait");
+  if (forest->profile != NULL) {
+    forest->profile->ghost_waittime += sc_MPI_Wtime ();
+  }
+  t8_profile_region_end ("ghost_exchange");
 }
 
-static t8_ghost_data_exchange_t *
-t8_forest_ghost_exchange_begin (t8_forest_t forest, sc_array_t * element_data)
+void
+t8_forest_ghost_exchange_fields (t8_forest_t forest, int num_fields,
+                                 const t8_ghost_field_t * fields)
 {
   t8_ghost_data_exchange_t *data_exchange;
-  t8_forest_ghost_t   ghost;
-  size_t              bytes_to_send, ghost_start;
-  int                 iremote, remote_rank;
-  int                 mpiret, recv_rank, bytes_recv;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
-  char              **send_buffers;
-  t8_ghost_process_hash_t lookup_proc, *process_entry, **pfound;
-  t8_locidx_t         remote_offset, next_offset;
 
-  T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (element_data != NULL);
-  T8_ASSERT (forest->ghosts != NULL);
+  t8_profile_region_begin ("ghost_exchange");
+  data_exchange =
+    t8_forest_ghost_exchange_fields_begin (forest, num_fields, fields);
+  if (forest->profile != NULL) {
+    /* Measure the time for ghost_exchange_end */
+    forest->profile->ghost_waittime = -sc_MPI_Wtime ();
+  }
+  t8_profile_region_begin ("ghost_exchange_wait");
+  t8_forest_ghost_exchange_end (data_exchange);
+  t8_profile_region_end ("ghost_exchange_wait");
+  if (forest->profile != NULL) {
+    /* Measure the time for ghost_exchange_end */
+    forest->profile->ghost_waittime += sc_MPI_Wtime ();
+  }
+  t8_profile_region_end ("ghost_exchange");
+}
 
-  ghost = forest->ghosts;
+int
+t8_forest_ghost_exchange_test (t8_ghost_data_exchange_t * data_exchange)
+{
+  int                 mpiret, recv_done, send_done;
 
-  /* Allocate the new exchange context */
-  data_exchange = T8_ALLOC (t8_ghost_data_exchange_t, 1);
-  /* The number of processes we need to send to */
-  data_exchange->num_remotes = ghost->remote_processes->elem_count;
-  /* Allocate MPI requests */
-  data_exchange->send_requests = T8_ALLOC (sc_MPI_Request,
-                                           data_exchange->num_remotes);
-  data_exchange->recv_requests = T8_ALLOC (sc_MPI_Request,
-                                           data_exchange->num_remotes);
-  /* Allocate pointers to send buffers */
-  send_buffers = data_exchange->send_buffers =
-    T8_ALLOC (char *, data_exchange->num_remotes);
-
-  for (iremote = 0; iremote < data_exchange->num_remotes; iremote++) {
-    /* Iterate over all remote processes and fill their send buffers */
-    remote_rank =
-      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
-    /* Fill the send buffers and compute the number of bytes to send */
-    bytes_to_send =
-      t8_forest_ghost_exchange_fill_send_buffer (forest, remote_rank,
-                                                 send_buffers + iremote,
-                                                 element_data);
-
-    /* Post the asynchronuos send */
-    mpiret = sc_MPI_Isend (send_buffers[iremote], bytes_to_send, sc_MPI_BYTE,
-                           remote_rank, T8_MPI_GHOST_EXC_FOREST,
-                           forest->mpicomm,
-                           data_exchange->send_requests + iremote);
-    SC_CHECK_MPI (mpiret);
+  if (data_exchange == NULL) {
+    /* There is no communication */
+    return 1;
   }
-
-  /* The index in element_data at which the ghost elements start */
-  ghost_start = t8_forest_get_num_element (forest);
-  /* Receive the incoming messages */
-#if 0
-  while (received_messages < data_exchange->num_remotes) {
-    /* Blocking test for incoming message */
-    mpiret = sc_MPI_Probe (sc_MPI_ANY_SOURCE, T8_MPI_GHOST_EXC_FOREST,
-                           forest->mpicomm, &recv_status);
-    SC_CHECK_MPI (mpiret);
-    recv_rank = recv_status.MPI_SOURCE;
-    /* Get the number of bytes to receive */
-    mpiret = sc_MPI_Get_count (&recv_status, sc_MPI_BYTE, &bytes_recv);
+  mpiret = sc_MPI_Testall (data_exchange->num_remotes,
+                           data_exchange->recv_requests, &recv_done,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Testall (data_exchange->num_remotes,
+                           data_exchange->send_requests, &send_done,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  if (recv_done && send_done) {
+    /* Test the neighborhood collective, if there is one */
+    mpiret = sc_MPI_Testall (1, &data_exchange->neighbor_request, &recv_done,
+                             sc_MPI_STATUSES_IGNORE);
     SC_CHECK_MPI (mpiret);
-
-    /* We need to compute the offset in element_data to which we can receive the message */
-    /* Search for this process' entry in the ghost struct */
-    lookup_proc.mpirank = recv_rank;
-    ret =
-      sc_hash_lookup (ghost->process_offsets, &lookup_proc,
-                      (void ***) &pfound);
-    T8_ASSERT (ret);
-    process_entry = *pfound;
-    /* In process_entry we stored the offset of this ranks ghosts under all
-     * ghosts. Thus in element_data we look at the position
-     *  ghost_start + offset
-     */
-    /* receive the message */
-    sc_MPI_Recv (sc_array_index
-                 (element_data, ghost_start + process_entry->ghost_offset),
-                 bytes_recv, sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_EXC_FOREST,
-                 forest->mpicomm, sc_MPI_STATUS_IGNORE);
-    received_messages++;
   }
-#endif
-  for (iremote = 0; iremote < data_exchange->num_remotes; iremote++) {
-    /* We need to compute the offset in element_data to which we can receive the message */
-    /* Search for this processes' entry in the ghost struct */
-    recv_rank =
-      *(int *) sc_array_index_int (ghost->remote_processes, iremote);
-    lookup_proc.mpirank = recv_rank;
-#ifdef T8_ENABLE_DEBUG
-    ret =
-#else
-    (void)
-#endif
-      sc_hash_lookup (ghost->process_offsets, &lookup_proc,
-                      (void ***) &pfound);
-    T8_ASSERT (ret);
-    process_entry = *pfound;
-    /* In process_entry we stored the offset of this ranks ghosts under all
-     * ghosts. Thus in element_data we look at the position
-     *  ghost_start + offset
-     */
-    remote_offset = process_entry->ghost_offset;
-    /* Compute the offset of the next remote rank */
-    if (iremote + 1 < data_exchange->num_remotes) {
-      lookup_proc.mpirank =
-        *(int *) sc_array_index_int (ghost->remote_processes, iremote + 1);
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_lookup (ghost->process_offsets, &lookup_proc,
-                        (void ***) &pfound);
-      T8_ASSERT (ret);
-      process_entry = *pfound;
-      next_offset = process_entry->ghost_offset;
-    }
-    else {
-      /* We are the last rank, the next offset is the total number of ghosts */
-      next_offset = ghost->num_ghosts_elements;
-    }
-    /* Calculate the number of bytes to receive */
-    bytes_recv = (next_offset - remote_offset) * element_data->elem_size;
-    /* receive the message */
-    mpiret =
-      sc_MPI_Irecv (sc_array_index
-                    (element_data, ghost_start + remote_offset), bytes_recv,
-                    sc_MPI_BYTE, recv_rank, T8_MPI_GHOST_EXC_FOREST,
-                    forest->mpicomm, data_exchange->recv_requests + iremote);
+  if (recv_done && send_done && data_exchange->shared_requests != NULL) {
+    /* Test the notifications of the remotes on our node */
+    mpiret = sc_MPI_Testall (2 * data_exchange->num_remotes,
+                             data_exchange->shared_requests, &recv_done,
+                             sc_MPI_STATUSES_IGNORE);
     SC_CHECK_MPI (mpiret);
   }
-  return data_exchange;
+  if (recv_done && send_done) {
+    /* Test the epochs of the RMA window, if we use it */
+    recv_done = t8_forest_ghost_rma_test (data_exchange);
+  }
+  return recv_done && send_done;
 }
 
-static void
+void
 t8_forest_ghost_exchange_end (t8_ghost_data_exchange_t * data_exchange)
 {
-  int                 iproc;
+  t8_ghost_exchange_plan_t *plan;
 
-  T8_ASSERT (data_exchange != NULL);
+  if (data_exchange == NULL) {
+    /* There is no communication */
+    return;
+  }
+  /* Copy the data of the remotes on our node from the shared window */
+  t8_forest_ghost_shared_end (data_exchange);
+  /* Copy the data that the remotes put into the RMA window */
+  t8_forest_ghost_rma_finish (data_exchange);
   /* Wait for all communications to end */
   sc_MPI_Waitall (data_exchange->num_remotes, data_exchange->recv_requests,
                   sc_MPI_STATUSES_IGNORE);
   sc_MPI_Waitall (data_exchange->num_remotes, data_exchange->send_requests,
                   sc_MPI_STATUSES_IGNORE);
+  sc_MPI_Waitall (1, &data_exchange->neighbor_request,
+                  sc_MPI_STATUSES_IGNORE);
+
+  if (!data_exchange->recv_direct) {
+    t8_forest_ghost_exchange_unpack (data_exchange);
+  }
 
-  /* Free the send buffers */
-  for (iproc = 0; iproc < data_exchange->num_remotes; iproc++) {
-    T8_FREE (data_exchange->send_buffers[iproc]);
+  plan = data_exchange->plan;
+  if (data_exchange == &plan->exchange) {
+    /* Keep the buffers for the next exchange */
+    plan->exchange_active = 0;
+    return;
   }
-  T8_FREE (data_exchange->send_buffers);
+  /* Free the buffers */
+  T8_FREE (data_exchange->send_buffer);
+  T8_FREE (data_exchange->recv_buffer);
+  T8_FREE (data_exchange->fields);
+  T8_FREE (data_exchange->neighbor_counts);
+  T8_FREE (data_exchange->changed_counts);
+  T8_FREE (data_exchange->shared_offsets);
+  T8_FREE (data_exchange->shared_requests);
   /* free requests */
   T8_FREE (data_exchange->send_requests);
   T8_FREE (data_exchange->recv_requests);
@@ -2290,20 +5154,21 @@ t8_forest_ghost_exchange_data (t8_forest_t forest, sc_array_t * element_data)
 
   T8_ASSERT (forest->ghosts != NULL);
   T8_ASSERT (element_data != NULL);
-  T8_ASSERT ((t8_locidx_t) element_data->elem_count ==
-             t8_forest_get_num_element (forest)
-             + t8_forest_get_num_ghosts (forest));
 
+  t8_profile_region_begin ("ghost_exchange");
   data_exchange = t8_forest_ghost_exchange_begin (forest, element_data);
   if (forest->profile != NULL) {
     /* Measure the time for ghost_exchange_end */
     forest->profile->ghost_waittime = -sc_MPI_Wtime ();
   }
+  t8_profile_region_begin ("ghost_exchange_wait");
   t8_forest_ghost_exchange_end (data_exchange);
+  t8_profile_region_end ("ghost_exchange_wait");
   if (forest->profile != NULL) {
     /* Measure the time for ghost_exchange_end */
     forest->profile->ghost_waittime += sc_MPI_Wtime ();
   }
+  t8_profile_region_end ("ghost_exchange");
   t8_debugf ("Finished ghost_exchange_data\n");
 }
 
@@ -2314,11 +5179,8 @@ t8_forest_ghost_print (t8_forest_t forest)
   t8_forest_ghost_t   ghost;
   t8_ghost_remote_t  *remote_found;
   t8_ghost_remote_tree_t *remote_tree;
-  t8_ghost_process_hash_t proc_hash, **pfound, *found;
+  t8_ghost_process_info_t *found;
   size_t              iremote, itree;
-#ifdef T8_ENABLE_DEBUG
-  int                 ret;
-#endif
   int                 remote_rank;
   char                remote_buffer[BUFSIZ] = "";
   char                buffer[BUFSIZ] = "";
@@ -2358,18 +5220,9 @@ t8_forest_ghost_print (t8_forest_t forest)
       }
 
       /* Investigate the elements that we received from this process */
-      proc_hash.mpirank = remote_rank;
-      /* look up this rank in the hash table */
-#ifdef T8_ENABLE_DEBUG
-      ret =
-#else
-      (void)
-#endif
-        sc_hash_lookup (ghost->process_offsets, &proc_hash,
-                        (void ***) &pfound);
-
-      T8_ASSERT (ret);
-      found = *pfound;
+      found = (t8_ghost_process_info_t *)
+        sc_array_index (ghost->process_offsets, iremote);
+      T8_ASSERT (found->mpirank == remote_rank);
       snprintf (buffer + strlen (buffer), BUFSIZ - strlen (buffer),
                 "\t[Rank %i] First tree: %li\n\t\t First element: %li\n",
                 remote_rank,
@@ -2384,10 +5237,8 @@ static void
 t8_forest_ghost_reset (t8_forest_ghost_t * pghost)
 {
   t8_forest_ghost_t   ghost;
-  size_t              it, it_trees;
+  size_t              it_trees;
   t8_ghost_tree_t    *ghost_tree;
-  t8_ghost_remote_t  *remote_entry;
-  t8_ghost_remote_tree_t *remote_tree;
 
   T8_ASSERT (pghost != NULL);
   ghost = *pghost;
@@ -2403,28 +5254,31 @@ t8_forest_ghost_reset (t8_forest_ghost_t * pghost)
 
   sc_array_destroy (ghost->ghost_trees);
   sc_array_destroy (ghost->remote_processes);
-  /* Clean-up the hashtables */
-  sc_hash_destroy (ghost->global_tree_to_ghost_tree);
-  sc_hash_destroy (ghost->process_offsets);
+  sc_array_destroy (ghost->process_offsets);
+  T8_FREE (ghost->global_tree_to_ghost_tree);
   /* Clean-up the remote ghost entries */
-  for (it = 0; it < ghost->remote_ghosts->a.elem_count; it++) {
-    remote_entry = (t8_ghost_remote_t *)
-      sc_array_index (&ghost->remote_ghosts->a, it);
-    for (it_trees = 0; it_trees < remote_entry->remote_trees.elem_count;
-         it_trees++) {
-      remote_tree = (t8_ghost_remote_tree_t *)
-        sc_array_index (&remote_entry->remote_trees, it_trees);
-      t8_element_array_reset (&remote_tree->elements);
-      sc_array_reset (&remote_tree->element_indices);
-    }
-    sc_array_reset (&remote_entry->remote_trees);
+  t8_forest_ghost_remote_destroy (ghost);
+  if (ghost->exchange_plan != NULL) {
+    t8_forest_ghost_exchange_plan_destroy (&ghost->exchange_plan);
   }
-  sc_hash_array_destroy (ghost->remote_ghosts);
-
-  /* Clean-up the memory pools for the data inside
-   * the hash tables */
-  sc_mempool_destroy (ghost->glo_tree_mempool);
-  sc_mempool_destroy (ghost->proc_offset_mempool);
+  if (ghost->neighbor_comm != sc_MPI_COMM_NULL) {
+    int                 mpiret;
+    /* Free the graph communicator */
+    mpiret = sc_MPI_Comm_free (&ghost->neighbor_comm);
+    SC_CHECK_MPI (mpiret);
+  }
+#ifdef T8_GHOST_SHARED_WINDOWS
+  if (ghost->shared != NULL) {
+    /* Free the shared window */
+    t8_forest_ghost_shared_destroy (ghost);
+  }
+#endif
+#ifdef T8_GHOST_RMA
+  if (ghost->rma != NULL) {
+    /* Free the RMA window */
+    t8_forest_ghost_rma_destroy (ghost);
+  }
+#endif
 
   /* Free the ghost */
   T8_FREE (ghost);
@@ -2462,4 +5316,76 @@ t8_forest_ghost_destroy (t8_forest_ghost_t * pghost)
   T8_ASSERT (*pghost == NULL);
 }
 
+size_t
+t8_forest_ghost_memory_used (t8_forest_ghost_t ghost)
+{
+  size_t              bytes, it, it_trees;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_ghost_remote_t  *remote_entry;
+  t8_ghost_remote_tree_t *remote_tree;
+  t8_ghost_exchange_plan_t *plan;
+
+  T8_ASSERT (ghost != NULL);
+  bytes = sizeof (t8_forest_ghost_struct_t);
+  if (ghost->ghost_trees != NULL) {
+    bytes += sc_array_memory_used (ghost->ghost_trees, 1);
+    for (it = 0; it < ghost->ghost_trees->elem_count; it++) {
+      ghost_tree = (t8_ghost_tree_t *) sc_array_index (ghost->ghost_trees, it);
+      bytes +=
+        sc_array_memory_used (t8_element_array_get_array
+                              (&ghost_tree->elements), 0);
+    }
+  }
+  if (ghost->global_tree_to_ghost_tree != NULL) {
+    bytes += ghost->num_ghost_gtree_ids * sizeof (t8_locidx_t);
+  }
+  if (ghost->process_offsets != NULL) {
+    bytes += sc_array_memory_used (ghost->process_offsets, 1);
+  }
+  if (ghost->remote_processes != NULL) {
+    bytes += sc_array_memory_used (ghost->remote_processes, 1);
+  }
+  if (ghost->remote_ghosts != NULL) {
+    bytes += sc_hash_array_memory_used (ghost->remote_ghosts);
+    for (it = 0; it < ghost->remote_ghosts->a.elem_count; it++) {
+      remote_entry = (t8_ghost_remote_t *)
+        sc_array_index (&ghost->remote_ghosts->a, it);
+      bytes += sc_array_memory_used (&remote_entry->remote_trees, 0);
+      for (it_trees = 0; it_trees < remote_entry->remote_trees.elem_count;
+           it_trees++) {
+        remote_tree = (t8_ghost_remote_tree_t *)
+          sc_array_index (&remote_entry->remote_trees, it_trees);
+        bytes +=
+          sc_array_memory_used (t8_element_array_get_array
+                                (&remote_tree->elements), 0);
+        bytes += sc_array_memory_used (&remote_tree->element_indices, 0);
+      }
+    }
+  }
+  if (ghost->exchange_plan != NULL) {
+    plan = ghost->exchange_plan;
+    bytes += sizeof (t8_ghost_exchange_plan_t)
+      + plan->num_remotes * sizeof (int)
+      + (2 * (plan->num_remotes + 1) + plan->send_offsets[plan->num_remotes])
+      * sizeof (t8_locidx_t)
+      + plan->exchange.buffer_bytes + plan->exchange.recv_buffer_bytes
+      + plan->exchange.fields_alloc * sizeof (t8_ghost_field_t)
+      + 2 * plan->num_remotes * sizeof (sc_MPI_Request);
+    if (plan->exchange.neighbor_counts != NULL) {
+      bytes += 4 * plan->num_remotes * sizeof (int);
+    }
+    if (plan->exchange.changed_counts != NULL) {
+      bytes += plan->num_remotes * sizeof (t8_locidx_t);
+    }
+  }
+#ifdef T8_GHOST_RMA
+  if (ghost->rma != NULL) {
+    bytes += sizeof (t8_ghost_rma_t)
+      + ghost->num_ghosts_elements * ghost->rma->max_data_size
+      + ghost->remote_processes->elem_count * sizeof (t8_locidx_t);
+  }
+#endif
+  return bytes;
+}
+
 T8_EXTERN_C_END ();
@@ -35,6 +35,20 @@
 
 T8_EXTERN_C_BEGIN ();
 
+/** The description of one field of element data for
+ * \ref t8_forest_ghost_exchange_fields.
+ * The field has one entry for each local element followed by one entry
+ * for each ghost element. The entries may be strided, for example
+ * if the field is one member of an array of structs.
+ */
+typedef struct
+{
+  void               *data;     /**< The entry of the first local element. */
+  size_t              size;     /**< The number of bytes of one entry. */
+  size_t              stride;   /**< The distance in bytes between the entries of two consecutive
+                                     elements. Must be at least \a size. */
+} t8_ghost_field_t;
+
 /* We enumerate the ghost trees by 0, 1, ..., num_ghost_trees - 1
  * In the context of a forest we add the number of local trees as offset,
  * so that we have a range of trees:
@@ -105,6 +119,19 @@ t8_element_t       *t8_forest_ghost_get_element (t8_forest_t forest,
                                                  t8_locidx_t lghost_tree,
                                                  t8_locidx_t lelement);
 
+/** Check whether two committed forests have the same ghost elements.
+ * \param [in] forest_a The first forest.
+ * \param [in] forest_b The second forest.
+ * \return              True if the ghost layers of \a forest_a and \a forest_b
+ *                      have the same ghost trees in the same order and each
+ *                      ghost tree has the same elements.
+ *                      Two forests without ghost layer are equal.
+ * \note This function is not collective. It only returns the state on the current
+ * rank.
+ */
+int                 t8_forest_ghost_is_equal (t8_forest_t forest_a,
+                                              t8_forest_t forest_b);
+
 /** Return the array of remote ranks.
  * \param [in] forest   A forest with constructed ghost layer.
  * \param [in,out] num_remotes On output the number of remote ranks is stored here.
@@ -130,13 +157,283 @@ t8_locidx_t         t8_forest_ghost_remote_first_tree (t8_forest_t forest,
 t8_locidx_t         t8_forest_ghost_remote_first_elem (t8_forest_t forest,
                                                        int remote);
 
-/* TODO: - document
- *       - make accesible to forest API
- *       - make a begin and end version
+/** Mark all local elements that are ghost elements of at least one other process.
+ * \param [in] forest   A forest with constructed ghost layer.
+ * \param [in,out] marks An array with one entry for each local element of \a forest.
+ *                      On output, the entry of each remote element is set to 1.
+ *                      All other entries are not changed.
+ */
+void                t8_forest_ghost_mark_remote_elements (t8_forest_t forest,
+                                                          int8_t * marks);
+
+/** Split the local elements of a forest into interior elements, that are not
+ * ghosts of any other process, and boundary elements, that are ghosts
+ * of at least one other process.
+ * Computations on interior elements can thus overlap with a ghost exchange
+ * that was started with \ref t8_forest_ghost_exchange_begin.
+ * \param [in] forest   A committed forest.
+ * \param [in,out] interior If not NULL, an array of t8_locidx_t. On output
+ *                      it holds the local indices of the interior elements in
+ *                      ascending order.
+ * \param [in,out] boundary If not NULL, an array of t8_locidx_t. On output
+ *                      it holds the local indices of the boundary elements in
+ *                      ascending order.
+ * \note If \a forest has no ghost layer, all elements are interior.
+ */
+void                t8_forest_ghost_split_elements (t8_forest_t forest,
+                                                    sc_array_t * interior,
+                                                    sc_array_t * boundary);
+
+/** Exchange the data of the ghost elements with the other processes.
+ * Each process sends the data of its remote elements and receives the
+ * data of its ghost elements.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in,out] element_data An array with one entry for each local element
+ *                      followed by one entry for each ghost element.
+ *                      On output the entries of the ghost elements are filled.
+ * \note This function is collective and blocking. It is equivalent to calling
+ * \ref t8_forest_ghost_exchange_begin and \ref t8_forest_ghost_exchange_end.
  */
 void                t8_forest_ghost_exchange_data (t8_forest_t forest,
                                                    sc_array_t * element_data);
 
+/** Start a ghost data exchange. The data of the remote elements is copied
+ * to a send buffer, thus it may be modified afterwards. The entries of the
+ * ghost elements in \a element_data must not be accessed until the exchange
+ * has ended.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in,out] element_data As in \ref t8_forest_ghost_exchange_data.
+ * \return              The exchange context, that must be passed to
+ *                      \ref t8_forest_ghost_exchange_end. NULL if \a forest
+ *                      has no ghosts.
+ */
+t8_ghost_data_exchange_t *t8_forest_ghost_exchange_begin (t8_forest_t forest,
+                                                          sc_array_t *
+                                                          element_data);
+
+/** Exchange the data of several fields of the ghost elements with the
+ * other processes. The data of all fields is sent in one message per
+ * remote process.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in] num_fields The number of fields. Must be positive.
+ * \param [in] fields   Array of \a num_fields field descriptions. The fields
+ *                      may have different entry sizes and strides.
+ *                      On output the ghost entries of all fields are filled.
+ * \note This function is collective and blocking. It is equivalent to calling
+ * \ref t8_forest_ghost_exchange_fields_begin and \ref t8_forest_ghost_exchange_end.
+ */
+void                t8_forest_ghost_exchange_fields (t8_forest_t forest,
+                                                     int num_fields,
+                                                     const t8_ghost_field_t *
+                                                     fields);
+
+/** Start a ghost data exchange of several fields.
+ * The ghost entries of the fields must not be accessed until the exchange
+ * has ended.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in] num_fields As in \ref t8_forest_ghost_exchange_fields.
+ * \param [in] fields   As in \ref t8_forest_ghost_exchange_fields.
+ *                      The array is copied and may be freed afterwards.
+ * \return              The exchange context, that must be passed to
+ *                      \ref t8_forest_ghost_exchange_end. NULL if \a forest
+ *                      has no ghosts.
+ */
+t8_ghost_data_exchange_t *t8_forest_ghost_exchange_fields_begin (t8_forest_t
+                                                                 forest,
+                                                                 int
+                                                                 num_fields,
+                                                                 const
+                                                                 t8_ghost_field_t
+                                                                 * fields);
+
+/** Return the communication pattern of the ghost data exchanges of a forest.
+ * With it, the data of the remote elements can be packed by the caller, for
+ * example with device kernels, and exchanged with
+ * \ref t8_forest_ghost_exchange_packed_begin.
+ * All returned arrays are owned by the ghost layer of \a forest and stay valid
+ * as long as it exists.
+ * \param [in] forest   A committed forest.
+ * \param [out] num_remotes The number of processes we exchange data with.
+ *                      0 if \a forest has no ghosts.
+ * \param [out] remote_ranks The ranks of these processes in ascending order.
+ * \param [out] send_offsets For each remote the first index in \a send_indices.
+ *                      \a num_remotes + 1 entries.
+ * \param [out] send_indices The local indices of the elements whose data is
+ *                      sent, ordered by remote.
+ * \param [out] recv_offsets For each remote the index of its first ghost among all
+ *                      ghosts. \a num_remotes + 1 entries.
+ */
+void                t8_forest_ghost_exchange_get_pattern (t8_forest_t forest,
+                                                          int *num_remotes,
+                                                          const int
+                                                          **remote_ranks,
+                                                          const t8_locidx_t
+                                                          ** send_offsets,
+                                                          const t8_locidx_t
+                                                          ** send_indices,
+                                                          const t8_locidx_t
+                                                          ** recv_offsets);
+
+/** Start a ghost data exchange of data that the caller has packed.
+ * The buffers are only accessed by MPI, thus with a device-aware MPI
+ * implementation they may reside in device memory.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in] send_buffer The data of the elements in the send_indices of
+ *                      \ref t8_forest_ghost_exchange_get_pattern in this order.
+ *                      It must not be modified until the exchange has ended.
+ * \param [in,out] recv_buffer Space for the data of all ghost elements.
+ *                      On output of \ref t8_forest_ghost_exchange_end it holds
+ *                      the data of the ghosts in ghost order.
+ * \param [in] data_size The number of bytes of the data of one element.
+ * \return              The exchange context, that must be passed to
+ *                      \ref t8_forest_ghost_exchange_end. NULL if \a forest
+ *                      has no ghosts.
+ */
+t8_ghost_data_exchange_t *t8_forest_ghost_exchange_packed_begin (t8_forest_t
+                                                                 forest,
+                                                                 const void
+                                                                 *send_buffer,
+                                                                 void
+                                                                 *recv_buffer,
+                                                                 size_t
+                                                                 data_size);
+
+/** Start a ghost data exchange restricted to the elements of the levels
+ * greater or equal \a min_level. Only the data of the remote elements of
+ * these levels is sent and only the entries of the ghosts of these levels
+ * in \a element_data are changed. This is the exchange after a substep of
+ * local time stepping, in which only the finer levels were updated,
+ * \see t8_forest_multirate_min_level.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in,out] element_data As in \ref t8_forest_ghost_exchange_data.
+ * \param [in] min_level The coarsest exchanged level,
+ *                      0 <= \a min_level <= \ref t8_forest_get_maxlevel.
+ * \return              The exchange context, that must be passed to
+ *                      \ref t8_forest_ghost_exchange_end. NULL if \a forest
+ *                      has no ghosts.
+ * \note The level order of the remote elements and ghosts is computed on the
+ * first call and reused afterwards.
+ */
+t8_ghost_data_exchange_t *t8_forest_ghost_exchange_levels_begin (t8_forest_t
+                                                                 forest,
+                                                                 sc_array_t *
+                                                                 element_data,
+                                                                 int
+                                                                 min_level);
+
+/** Exchange the data of the ghost elements of the levels greater or equal
+ * \a min_level with the other processes.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in,out] element_data As in \ref t8_forest_ghost_exchange_data.
+ * \param [in] min_level As in \ref t8_forest_ghost_exchange_levels_begin.
+ * \note This function is collective and blocking. It is equivalent to calling
+ * \ref t8_forest_ghost_exchange_levels_begin and
+ * \ref t8_forest_ghost_exchange_end.
+ */
+void                t8_forest_ghost_exchange_levels (t8_forest_t forest,
+                                                     sc_array_t *
+                                                     element_data,
+                                                     int min_level);
+
+/** Start a ghost data exchange of face data. Instead of the data of whole
+ * elements, one entry is sent for each face of a remote element at which a
+ * ghost of the receiver is a face neighbor. This is the data that flux
+ * computations need. If a face is hanging, the neighbors across it share
+ * its entry, which can hold the data of all subfaces.
+ * \param [in] forest   A committed and balanced forest with a face ghost
+ *                      layer.
+ * \param [in,out] face_data An array with one entry for each face of each
+ *                      local element and ghost. The entry of face f of
+ *                      element i is at index i * \a max_num_faces + f, where
+ *                      the ghosts come after the local elements.
+ *                      On output the received entries of the ghosts are
+ *                      set, all other entries are not changed.
+ * \param [in] max_num_faces The maximum number of faces of an element,
+ *                      at most \ref T8_ECLASS_MAX_FACES.
+ * \return              The exchange context, that must be passed to
+ *                      \ref t8_forest_ghost_exchange_end. NULL if \a forest
+ *                      has no ghosts.
+ * \note The exchanged faces are computed on the first call, which sends one
+ * message with the faces of the ghosts to each remote, and reused afterwards.
+ */
+t8_ghost_data_exchange_t *t8_forest_ghost_exchange_faces_begin (t8_forest_t
+                                                                forest,
+                                                                sc_array_t *
+                                                                face_data,
+                                                                int
+                                                                max_num_faces);
+
+/** Exchange the face data of the ghost elements with the other processes.
+ * \param [in] forest   A committed and balanced forest with a face ghost
+ *                      layer.
+ * \param [in,out] face_data As in \ref t8_forest_ghost_exchange_faces_begin.
+ * \param [in] max_num_faces As in \ref t8_forest_ghost_exchange_faces_begin.
+ * \note This function is collective and blocking. It is equivalent to calling
+ * \ref t8_forest_ghost_exchange_faces_begin and
+ * \ref t8_forest_ghost_exchange_end.
+ */
+void                t8_forest_ghost_exchange_faces (t8_forest_t forest,
+                                                    sc_array_t * face_data,
+                                                    int max_num_faces);
+
+/** Start a ghost data exchange of the changed elements only. The data of
+ * the remote elements that are marked as changed is sent, together with
+ * their indices, and only the entries of the corresponding ghosts in
+ * \a element_data are changed. If the entries of the other ghosts hold the
+ * data of the last exchange, the result equals that of
+ * \ref t8_forest_ghost_exchange_begin, with less communication if few
+ * elements changed.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in,out] element_data As in \ref t8_forest_ghost_exchange_data.
+ * \param [in] changed  For each local element a flag, nonzero if its data
+ *                      changed since the last exchange.
+ * \return              The exchange context, that must be passed to
+ *                      \ref t8_forest_ghost_exchange_end. NULL if \a forest
+ *                      has no ghosts.
+ * \note The exchange uses point-to-point messages, also if the forest has a
+ * neighborhood communicator or a shared or RMA window.
+ */
+t8_ghost_data_exchange_t *t8_forest_ghost_exchange_changed_begin (t8_forest_t
+                                                                  forest,
+                                                                  sc_array_t
+                                                                  *
+                                                                  element_data,
+                                                                  const int8_t
+                                                                  * changed);
+
+/** Exchange the data of the changed ghost elements with the other
+ * processes.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in,out] element_data As in \ref t8_forest_ghost_exchange_data.
+ * \param [in] changed  As in \ref t8_forest_ghost_exchange_changed_begin.
+ * \note This function is collective and blocking. It is equivalent to calling
+ * \ref t8_forest_ghost_exchange_changed_begin and
+ * \ref t8_forest_ghost_exchange_end.
+ */
+void                t8_forest_ghost_exchange_changed (t8_forest_t forest,
+                                                      sc_array_t *
+                                                      element_data,
+                                                      const int8_t * changed);
+
+/** Test whether a ghost data exchange has completed and progress its
+ * communication.
+ * \param [in,out] data_exchange An exchange context returned by
+ *                      \ref t8_forest_ghost_exchange_begin.
+ * \return              True if all messages are sent and received.
+ * \note \ref t8_forest_ghost_exchange_end must be called in any case.
+ */
+int                 t8_forest_ghost_exchange_test (t8_ghost_data_exchange_t *
+                                                   data_exchange);
+
+/** End a ghost data exchange. Wait until all messages are sent and
+ * received. Afterwards the ghost entries of the exchanged data are valid.
+ * \param [in] data_exchange An exchange context returned by
+ *                      \ref t8_forest_ghost_exchange_begin. It is freed
+ *                      or reused by later exchanges and must not be accessed afterwards.
+ */
+void                t8_forest_ghost_exchange_end (t8_ghost_data_exchange_t *
+                                                  data_exchange);
+
 /** Increase the reference count of a ghost structure.
  * \param [in,out]  ghost     On input, this ghost structure must exist with
  *                            positive reference count.
@@ -165,6 +462,13 @@ void                t8_forest_ghost_unref (t8_forest_ghost_t * pghost);
  */
 void                t8_forest_ghost_destroy (t8_forest_ghost_t * pghost);
 
+/** Return the number of bytes that a ghost structure allocates, including
+ * the ghost and remote elements and the exchange plan.
+ * \param [in]      ghost      The ghost structure.
+ * \return                     The allocated bytes of \a ghost.
+ */
+size_t              t8_forest_ghost_memory_used (t8_forest_ghost_t ghost);
+
 /** Create one layer of ghost elements for a forest.
  * \see t8_forest_set_ghost
  * \param [in,out]    forest     The forest.
@@ -185,6 +489,26 @@ void                t8_forest_ghost_create_balanced_only (t8_forest_t forest);
 /* experimental version using the ghost_v3 algorithm */
 void                t8_forest_ghost_create_topdown (t8_forest_t forest);
 
+/** Create the ghost layer of a forest that was adapted (and neither partitioned
+ * nor balanced) from a forest with ghost layer, reusing that ghost layer.
+ * A process only recomputes its remote elements if its elements changed during
+ * adaptation and only receives ghost elements from remote processes whose
+ * elements changed. All other entries are copied from \a ghost_from.
+ * This must be called on all processes that have a ghost layer \a ghost_from.
+ * \param [in,out] forest   The committed, adapted forest.
+ * \param [in]     ghost_from The ghost layer of the forest that \a forest was
+ *                          adapted from. It must have been created with point-to-point
+ *                          messages and with the same ghost type and algorithm.
+ * \param [in]     unbalanced_version The ghost algorithm used to recompute the
+ *                          remote elements. 0 for balanced forests only, 1 for
+ *                          unbalanced forests and -1 for the top-down search.
+ */
+void                t8_forest_ghost_create_incremental (t8_forest_t forest,
+                                                        t8_forest_ghost_t
+                                                        ghost_from,
+                                                        int
+                                                        unbalanced_version);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_GHOST_H! */
@@ -0,0 +1,214 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_hierarchy.h>
+#include <t8_element_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* Coarsen every family once */
+static int
+t8_forest_hierarchy_coarsen (t8_forest_t forest, t8_forest_t forest_from,
+                             t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                             t8_eclass_scheme_c * ts, int num_elements,
+                             t8_element_t * elements[])
+{
+  return num_elements > 1 ? -1 : 0;
+}
+
+/* Compute the child offsets and the parents between level and level + 1.
+ * Since the coarse forest is adapted from the fine one without
+ * repartitioning, both have the same local trees and the children of a
+ * coarse element are consecutive local fine elements. */
+static void
+t8_forest_hierarchy_build_maps (t8_forest_hierarchy_t * hierarchy, int level)
+{
+  t8_forest_t         fine, coarse;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *celem, *felem;
+  t8_locidx_t        *offsets, *parents;
+  t8_locidx_t         num_trees, itree, ielem, num_elems;
+  t8_locidx_t         icoarse, ifine, ifine_tree;
+  int                 num_children, ichild;
+
+  fine = hierarchy->forests[level];
+  coarse = hierarchy->forests[level + 1];
+  num_trees = t8_forest_get_num_local_trees (coarse);
+  T8_ASSERT (num_trees == t8_forest_get_num_local_trees (fine));
+  offsets = T8_ALLOC (t8_locidx_t, t8_forest_get_num_element (coarse) + 1);
+  parents = T8_ALLOC (t8_locidx_t, t8_forest_get_num_element (fine));
+  icoarse = ifine = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (coarse,
+                                      t8_forest_get_tree_class (coarse,
+                                                                itree));
+    num_elems = t8_forest_get_tree_num_elements (coarse, itree);
+    ifine_tree = 0;
+    for (ielem = 0; ielem < num_elems; ielem++, icoarse++) {
+      celem = t8_forest_get_element_in_tree (coarse, itree, ielem);
+      felem = t8_forest_get_element_in_tree (fine, itree, ifine_tree);
+      /* A coarse element is either unchanged or the parent of a family */
+      num_children = ts->t8_element_level (celem) == ts->t8_element_level
+        (felem) ? 1 : ts->t8_element_num_children (celem);
+      offsets[icoarse] = ifine;
+      for (ichild = 0; ichild < num_children; ichild++) {
+        parents[ifine++] = icoarse;
+      }
+      ifine_tree += num_children;
+    }
+    T8_ASSERT (ifine_tree == t8_forest_get_tree_num_elements (fine, itree));
+  }
+  T8_ASSERT (icoarse == t8_forest_get_num_element (coarse));
+  T8_ASSERT (ifine == t8_forest_get_num_element (fine));
+  offsets[icoarse] = ifine;
+  hierarchy->child_offsets[level] = offsets;
+  hierarchy->parents[level] = parents;
+}
+
+t8_forest_hierarchy_t *
+t8_forest_hierarchy_new (t8_forest_t forest, int max_levels, int do_ghost)
+{
+  t8_forest_hierarchy_t *hierarchy;
+  t8_forest_t         fine, coarse;
+  int                 level;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (max_levels >= 1);
+
+  hierarchy = T8_ALLOC_ZERO (t8_forest_hierarchy_t, 1);
+  hierarchy->forests = T8_ALLOC (t8_forest_t, max_levels);
+  hierarchy->child_offsets = T8_ALLOC_ZERO (t8_locidx_t *, max_levels);
+  hierarchy->parents = T8_ALLOC_ZERO (t8_locidx_t *, max_levels);
+
+  /* Level 0 is partitioned such that its families can be coarsened */
+  t8_forest_init (&fine);
+  t8_forest_set_partition (fine, forest, 1);
+  if (do_ghost) {
+    t8_forest_set_ghost (fine, 1, T8_GHOST_FACES);
+  }
+  t8_forest_commit (fine);
+  hierarchy->forests[0] = fine;
+  hierarchy->num_levels = 1;
+
+  for (level = 1; level < max_levels; level++) {
+    t8_forest_init (&coarse);
+    t8_forest_ref (fine);
+    t8_forest_set_adapt (coarse, fine, t8_forest_hierarchy_coarsen, 0);
+    if (do_ghost) {
+      t8_forest_set_ghost (coarse, 1, T8_GHOST_FACES);
+    }
+    t8_forest_commit (coarse);
+    if (t8_forest_get_global_num_elements (coarse) ==
+        t8_forest_get_global_num_elements (fine)) {
+      /* Nothing was coarsened anywhere, this level would be a copy */
+      t8_forest_unref (&coarse);
+      break;
+    }
+    hierarchy->forests[level] = coarse;
+    hierarchy->num_levels++;
+    t8_forest_hierarchy_build_maps (hierarchy, level - 1);
+    fine = coarse;
+  }
+  t8_global_productionf ("Constructed forest hierarchy with %i levels.\n",
+                         hierarchy->num_levels);
+  return hierarchy;
+}
+
+void
+t8_forest_hierarchy_destroy (t8_forest_hierarchy_t ** phierarchy)
+{
+  t8_forest_hierarchy_t *hierarchy;
+  int                 level;
+
+  T8_ASSERT (phierarchy != NULL && *phierarchy != NULL);
+  hierarchy = *phierarchy;
+  for (level = 0; level < hierarchy->num_levels; level++) {
+    t8_forest_unref (&hierarchy->forests[level]);
+  }
+  for (level = 0; level < hierarchy->num_levels - 1; level++) {
+    T8_FREE (hierarchy->child_offsets[level]);
+    T8_FREE (hierarchy->parents[level]);
+  }
+  T8_FREE (hierarchy->forests);
+  T8_FREE (hierarchy->child_offsets);
+  T8_FREE (hierarchy->parents);
+  T8_FREE (hierarchy);
+  *phierarchy = NULL;
+}
+
+void
+t8_forest_hierarchy_restrict (const t8_forest_hierarchy_t * hierarchy,
+                              int level, const double *fine, double *coarse,
+                              int num_values)
+{
+  const t8_locidx_t  *offsets;
+  t8_locidx_t         num_coarse, icoarse, ifine;
+  double             *c;
+  int                 ival;
+
+  T8_ASSERT (hierarchy != NULL);
+  T8_ASSERT (0 <= level && level < hierarchy->num_levels - 1);
+  T8_ASSERT (num_values > 0);
+
+  offsets = hierarchy->child_offsets[level];
+  num_coarse = t8_forest_get_num_element (hierarchy->forests[level + 1]);
+  for (icoarse = 0; icoarse < num_coarse; icoarse++) {
+    c = coarse + (size_t) icoarse * num_values;
+    for (ival = 0; ival < num_values; ival++) {
+      c[ival] = 0;
+    }
+    for (ifine = offsets[icoarse]; ifine < offsets[icoarse + 1]; ifine++) {
+      for (ival = 0; ival < num_values; ival++) {
+        c[ival] += fine[(size_t) ifine * num_values + ival];
+      }
+    }
+    for (ival = 0; ival < num_values; ival++) {
+      c[ival] /= offsets[icoarse + 1] - offsets[icoarse];
+    }
+  }
+}
+
+void
+t8_forest_hierarchy_prolongate (const t8_forest_hierarchy_t * hierarchy,
+                                int level, const double *coarse,
+                                double *fine, int num_values)
+{
+  const t8_locidx_t  *parents;
+  t8_locidx_t         num_fine, ifine;
+  int                 ival;
+
+  T8_ASSERT (hierarchy != NULL);
+  T8_ASSERT (0 <= level && level < hierarchy->num_levels - 1);
+  T8_ASSERT (num_values > 0);
+
+  parents = hierarchy->parents[level];
+  num_fine = t8_forest_get_num_element (hierarchy->forests[level]);
+  for (ifine = 0; ifine < num_fine; ifine++) {
+    for (ival = 0; ival < num_values; ival++) {
+      fine[(size_t) ifine * num_values + ival] =
+        coarse[(size_t) parents[ifine] * num_values + ival];
+    }
+  }
+}
+
+T8_EXTERN_C_END ();
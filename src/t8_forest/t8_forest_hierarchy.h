@@ -0,0 +1,119 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_hierarchy.h
+ * A hierarchy of successively coarser forests for geometric multigrid.
+ *
+ * Level 0 of the hierarchy is the finest forest. Each coarser level is
+ * built from the next finer one by coarsening every local family once,
+ * without repartitioning. Thus the parent of a coarsened family is on the
+ * same process as its children and transferring values between two levels
+ * needs no communication. The finest forest is partitioned such that no
+ * family is split between processes. On the coarser levels, families that
+ * are split between processes stay fine.
+ *
+ * For each pair of levels the hierarchy stores which fine elements are the
+ * children of a coarse element. An element that is not coarsened is its own
+ * only child.
+ */
+
+#ifndef T8_FOREST_HIERARCHY_H
+#define T8_FOREST_HIERARCHY_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** A hierarchy of forests. */
+typedef struct
+{
+  int                 num_levels;       /**< The number of forests. */
+  t8_forest_t        *forests;          /**< The forests, from the finest at index 0
+                                             to the coarsest. */
+  t8_locidx_t       **child_offsets;    /**< The children of local element i of level
+                                             k + 1 are the local elements
+                                             child_offsets[k][i], ...,
+                                             child_offsets[k][i + 1] - 1 of level k.
+                                             Has num_levels - 1 arrays. */
+  t8_locidx_t       **parents;          /**< parents[k][j] is the local element of level
+                                             k + 1 that local element j of level k
+                                             belongs to. Has num_levels - 1 arrays. */
+} t8_forest_hierarchy_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Build a hierarchy of coarser forests from a forest.
+ * Coarsening stops after \a max_levels levels or when a level does not
+ * reduce the global number of elements.
+ * \param [in] forest     A committed forest. We take ownership. This can be
+ *                        prevented by referencing \a forest.
+ *                        It is repartitioned to become level 0.
+ * \param [in] max_levels The maximum number of levels, at least 1.
+ * \param [in] do_ghost   If true, each level gets a face ghost layer.
+ * \return                The hierarchy. Destroy it with
+ *                        \ref t8_forest_hierarchy_destroy.
+ * \note This function is collective.
+ */
+t8_forest_hierarchy_t *t8_forest_hierarchy_new (t8_forest_t forest,
+                                                int max_levels, int do_ghost);
+
+/** Free the memory of a hierarchy and unref its forests.
+ * \param [in,out] phierarchy  A hierarchy, set to NULL on output.
+ */
+void                t8_forest_hierarchy_destroy (t8_forest_hierarchy_t **
+                                                 phierarchy);
+
+/** Restrict element values from a level to the next coarser level.
+ * The value of a coarse element is the mean of the values of its children.
+ * \param [in] hierarchy  A hierarchy.
+ * \param [in] level      The fine level, 0 <= \a level < num_levels - 1.
+ * \param [in] fine       \a num_values doubles for each local element of
+ *                        \a level.
+ * \param [out] coarse    \a num_values doubles for each local element of
+ *                        \a level + 1.
+ * \param [in] num_values The number of values per element.
+ */
+void                t8_forest_hierarchy_restrict (const t8_forest_hierarchy_t *
+                                                  hierarchy, int level,
+                                                  const double *fine,
+                                                  double *coarse,
+                                                  int num_values);
+
+/** Prolongate element values from a level to the next finer level.
+ * Each child gets the value of its parent.
+ * \param [in] hierarchy  A hierarchy.
+ * \param [in] level      The fine level, 0 <= \a level < num_levels - 1.
+ * \param [in] coarse     \a num_values doubles for each local element of
+ *                        \a level + 1.
+ * \param [out] fine      \a num_values doubles for each local element of
+ *                        \a level.
+ * \param [in] num_values The number of values per element.
+ */
+void                t8_forest_hierarchy_prolongate (const
+                                                    t8_forest_hierarchy_t *
+                                                    hierarchy, int level,
+                                                    const double *coarse,
+                                                    double *fine,
+                                                    int num_values);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_HIERARCHY_H */
@@ -0,0 +1,568 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_io.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_element_cxx.hxx>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_profile_regions.h>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* A forest file consists of
+ *  - the header,
+ *  - the global index of the first element of each tree,
+ *  - the eclass of each tree,
+ *  - the raw bytes of all elements in global order. Each element takes
+ *    slot_size bytes, such that the position of an element in the file is
+ *    given by its global index,
+ *  - the user data of all elements in global order.
+ */
+
+#define T8_FOREST_IO_MAGIC "t8forest"
+#define T8_FOREST_IO_VERSION 1
+
+/* The header of a forest file */
+typedef struct
+{
+  char                magic[8];
+  int64_t             version;
+  int64_t             byte_order;       /* 1 in the byte order of the writer. */
+  int64_t             dimension;
+  int64_t             num_trees;
+  int64_t             num_elements;
+  int64_t             element_size[T8_ECLASS_COUNT];    /* 0 for classes without scheme. */
+  int64_t             slot_size;        /* Number of bytes of each element in the file. */
+  int64_t             data_size;        /* Number of bytes of user data per element. */
+} t8_forest_io_header_t;
+
+/* The position of the eclasses of the trees in the file */
+static long long
+t8_forest_io_eclass_start (const t8_forest_io_header_t * header)
+{
+  return (long long) sizeof (t8_forest_io_header_t)
+    + (long long) sizeof (int64_t) * header->num_trees;
+}
+
+/* The position of the elements in the file */
+static long long
+t8_forest_io_elements_start (const t8_forest_io_header_t * header)
+{
+  long long           end_eclass;
+
+  end_eclass = t8_forest_io_eclass_start (header)
+    + (long long) sizeof (int32_t) * header->num_trees;
+  /* We align the elements to 8 bytes */
+  return (end_eclass + 7) / 8 * 8;
+}
+
+/* The position of the user data in the file */
+static long long
+t8_forest_io_data_start (const t8_forest_io_header_t * header)
+{
+  return t8_forest_io_elements_start (header)
+    + header->slot_size * header->num_elements;
+}
+
+/* A file that is read by all processes of a communicator */
+typedef struct
+{
+#ifdef T8_ENABLE_MPIIO
+  MPI_File            file;
+#else
+  FILE               *file;
+#endif
+} t8_forest_io_file_t;
+
+/* Open a file for reading. Returns true on success.
+ * This function is collective. */
+static int
+t8_forest_io_open (t8_forest_io_file_t * file, const char *filename,
+                   sc_MPI_Comm comm)
+{
+#ifdef T8_ENABLE_MPIIO
+  return MPI_File_open (comm, (char *) filename, MPI_MODE_RDONLY,
+                        MPI_INFO_NULL, &file->file) == MPI_SUCCESS;
+#else
+  file->file = fopen (filename, "rb");
+  return file->file != NULL;
+#endif
+}
+
+/* Read \a size bytes at position \a offset of a file.
+ * Returns true on success. */
+static int
+t8_forest_io_read (t8_forest_io_file_t * file, long long offset,
+                   void *data, size_t size)
+{
+#ifdef T8_ENABLE_MPIIO
+  MPI_Status          status;
+  /* MPI counts are ints, so we read in chunks of at most 1GB */
+  const size_t        max_chunk = (size_t) 1 << 30;
+  size_t              done, chunk;
+  int                 mpiret, count;
+
+  for (done = 0; done < size; done += chunk) {
+    chunk = SC_MIN (max_chunk, size - done);
+    mpiret = MPI_File_read_at (file->file, (MPI_Offset) (offset + done),
+                               (char *) data + done, (int) chunk, MPI_BYTE,
+                               &status);
+    if (mpiret != MPI_SUCCESS) {
+      return 0;
+    }
+    mpiret = MPI_Get_count (&status, MPI_BYTE, &count);
+    if (mpiret != MPI_SUCCESS || (size_t) count != chunk) {
+      return 0;
+    }
+  }
+  return 1;
+#else
+  return !fseek (file->file, (long) offset, SEEK_SET)
+    && fread (data, 1, size, file->file) == size;
+#endif
+}
+
+/* Close a file that was opened with t8_forest_io_open.
+ * This function is collective. */
+static void
+t8_forest_io_close (t8_forest_io_file_t * file)
+{
+#ifdef T8_ENABLE_MPIIO
+  MPI_File_close (&file->file);
+#else
+  fclose (file->file);
+#endif
+}
+
+int
+t8_forest_io_write_blocks (const char *filename, sc_MPI_Comm comm,
+                           int num_blocks, char *const *blocks,
+                           const size_t * sizes, const long long *offsets)
+{
+  int                 mpiret, iblock;
+  int                 success = 1;
+#ifdef T8_ENABLE_MPIIO
+  MPI_File            file;
+  MPI_Status          status;
+  /* MPI counts are ints, so we write blocks in chunks of at most 1GB */
+  const size_t        max_chunk = (size_t) 1 << 30;
+  int                 num_chunks, max_num_chunks, ichunk;
+  size_t              written, chunk;
+
+  mpiret = MPI_File_open (comm, (char *) filename,
+                          MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL,
+                          &file);
+  if (mpiret != MPI_SUCCESS) {
+    t8_errorf ("Error when opening file %s\n", filename);
+    return 0;
+  }
+  /* Discard the contents of an older file */
+  mpiret = MPI_File_set_size (file, 0);
+  success = success && mpiret == MPI_SUCCESS;
+
+  /* Collective writes must be called equally often on all processes */
+  num_chunks = 0;
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    num_chunks += (int) ((sizes[iblock] + max_chunk - 1) / max_chunk);
+  }
+  mpiret = sc_MPI_Allreduce (&num_chunks, &max_num_chunks, 1, sc_MPI_INT,
+                             sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  ichunk = 0;
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    for (written = 0; written < sizes[iblock]; written += chunk, ichunk++) {
+      chunk = SC_MIN (max_chunk, sizes[iblock] - written);
+      mpiret = MPI_File_write_at_all (file,
+                                      (MPI_Offset) (offsets[iblock] +
+                                                    written),
+                                      blocks[iblock] + written, (int) chunk,
+                                      MPI_BYTE, &status);
+      success = success && mpiret == MPI_SUCCESS;
+    }
+  }
+  for (; ichunk < max_num_chunks; ichunk++) {
+    mpiret = MPI_File_write_at_all (file, 0, NULL, 0, MPI_BYTE, &status);
+    success = success && mpiret == MPI_SUCCESS;
+  }
+  mpiret = MPI_File_close (&file);
+  success = success && mpiret == MPI_SUCCESS;
+#else
+  FILE               *file;
+  int                 mpirank, mpisize, rank;
+
+  /* Without MPI I/O the processes write one after the other */
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  for (rank = 0; rank < mpisize; rank++) {
+    if (rank == mpirank) {
+      /* The first process creates the file */
+      file = fopen (filename, rank == 0 ? "wb" : "r+b");
+      if (file == NULL) {
+        t8_errorf ("Error when opening file %s\n", filename);
+        success = 0;
+      }
+      for (iblock = 0; success && iblock < num_blocks; iblock++) {
+        success = !fseek (file, (long) offsets[iblock], SEEK_SET)
+          && fwrite (blocks[iblock], 1, sizes[iblock], file) == sizes[iblock];
+      }
+      if (file != NULL && fclose (file)) {
+        success = 0;
+      }
+    }
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+  if (!success) {
+    t8_errorf ("Error when writing file %s\n", filename);
+  }
+  return success;
+}
+
+int
+t8_forest_save (t8_forest_t forest, const char *filename,
+                const sc_array_t * element_data)
+{
+  t8_forest_io_header_t header;
+  t8_eclass_scheme_c *ts;
+  t8_tree_t           tree;
+  t8_gloidx_t         first_element;
+  t8_locidx_t         num_trees, first_owned, itree, ielem, num_elements;
+  int64_t            *tree_first;
+  int32_t            *tree_eclass;
+  char               *elements, *blocks[5];
+  size_t              sizes[5], element_size;
+  long long           offsets[5], data_size[2], all_data_size[2];
+  int                 ieclass, num_blocks, success, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (filename != NULL);
+  T8_ASSERT (element_data == NULL
+             || element_data->elem_count ==
+             (size_t) forest->local_num_elements);
+
+  /* All processes must agree on the size of the user data */
+  data_size[0] = element_data != NULL ? (long long) element_data->elem_size
+    : 0;
+  data_size[1] = -data_size[0];
+  mpiret = sc_MPI_Allreduce (data_size, all_data_size, 2,
+                             sc_MPI_LONG_LONG_INT, sc_MPI_MAX,
+                             forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (all_data_size[0] == -all_data_size[1],
+                  "The element data must have the same size on all"
+                  " processes");
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, T8_FOREST_IO_MAGIC, 8);
+  header.version = T8_FOREST_IO_VERSION;
+  header.byte_order = 1;
+  header.dimension = forest->dimension;
+  header.num_trees = forest->global_num_trees;
+  header.num_elements = forest->global_num_elements;
+  header.slot_size = 0;
+  for (ieclass = T8_ECLASS_ZERO; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    ts = forest->scheme_cxx->eclass_schemes[ieclass];
+    if (ts != NULL) {
+      header.element_size[ieclass] = ts->t8_element_size ();
+    }
+    if (forest->cmesh->num_trees_per_eclass[ieclass] > 0) {
+      /* The slots must fit the elements of all classes in the forest */
+      T8_ASSERT (ts != NULL);
+      header.slot_size = SC_MAX (header.slot_size,
+                                 header.element_size[ieclass]);
+    }
+  }
+  header.data_size = all_data_size[0];
+
+  /* We write the table entries of the trees whose first element is local */
+  num_trees = t8_forest_get_num_local_trees (forest);
+  num_elements = forest->local_num_elements;
+  first_element = t8_forest_get_first_local_element_id (forest);
+  first_owned = num_trees > 0 && t8_forest_first_tree_shared (forest);
+  tree_first = T8_ALLOC (int64_t, num_trees + 1);
+  tree_eclass = T8_ALLOC (int32_t, num_trees + 1);
+  elements = T8_ALLOC_ZERO (char, header.slot_size * num_elements + 1);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    if (itree >= first_owned) {
+      tree_first[itree - first_owned] = first_element + tree->elements_offset;
+      tree_eclass[itree - first_owned] = tree->eclass;
+    }
+    /* Copy the elements into their slots */
+    element_size = header.element_size[tree->eclass];
+    if ((long long) element_size == header.slot_size) {
+      memcpy (elements + header.slot_size * tree->elements_offset,
+              t8_element_array_get_data (&tree->elements),
+              element_size * t8_element_array_get_count (&tree->elements));
+    }
+    else {
+      for (ielem = 0;
+           ielem < (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+           ielem++) {
+        memcpy (elements +
+                header.slot_size * (tree->elements_offset + ielem),
+                t8_element_array_index_locidx (&tree->elements, ielem),
+                element_size);
+      }
+    }
+  }
+
+  num_blocks = 0;
+  if (forest->mpirank == 0) {
+    blocks[num_blocks] = (char *) &header;
+    sizes[num_blocks] = sizeof (header);
+    offsets[num_blocks++] = 0;
+  }
+  if (num_trees > first_owned) {
+    blocks[num_blocks] = (char *) tree_first;
+    sizes[num_blocks] = sizeof (int64_t) * (num_trees - first_owned);
+    offsets[num_blocks++] = (long long) sizeof (header)
+      + (long long) sizeof (int64_t) * (forest->first_local_tree +
+                                        first_owned);
+    blocks[num_blocks] = (char *) tree_eclass;
+    sizes[num_blocks] = sizeof (int32_t) * (num_trees - first_owned);
+    offsets[num_blocks++] = t8_forest_io_eclass_start (&header)
+      + (long long) sizeof (int32_t) * (forest->first_local_tree +
+                                        first_owned);
+  }
+  if (num_elements > 0) {
+    blocks[num_blocks] = elements;
+    sizes[num_blocks] = header.slot_size * num_elements;
+    offsets[num_blocks++] = t8_forest_io_elements_start (&header)
+      + header.slot_size * first_element;
+    if (header.data_size > 0) {
+      blocks[num_blocks] = element_data->array;
+      sizes[num_blocks] = header.data_size * num_elements;
+      offsets[num_blocks++] = t8_forest_io_data_start (&header)
+        + header.data_size * first_element;
+    }
+  }
+  success = t8_forest_io_write_blocks (filename, forest->mpicomm, num_blocks,
+                                       blocks, sizes, offsets);
+  T8_FREE (tree_first);
+  T8_FREE (tree_eclass);
+  T8_FREE (elements);
+  return success;
+}
+
+/* Read the header of a forest file and check that it matches the forest.
+ * Aborts if it does not. */
+static void
+t8_forest_io_read_header (t8_forest_t forest, t8_forest_io_file_t * file,
+                          t8_forest_io_header_t * header)
+{
+  SC_CHECK_ABORT (t8_forest_io_read (file, 0, header, sizeof (*header)),
+                  "Could not read the header of the forest file");
+  SC_CHECK_ABORT (!memcmp (header->magic, T8_FOREST_IO_MAGIC, 8),
+                  "Not a t8code forest file");
+  SC_CHECK_ABORT (header->byte_order == 1,
+                  "The forest file was written with a different byte order");
+  SC_CHECK_ABORTF (header->version == T8_FOREST_IO_VERSION,
+                   "Unsupported version %lld of the forest file",
+                   (long long) header->version);
+  SC_CHECK_ABORT (header->dimension == forest->dimension
+                  && header->num_trees ==
+                  t8_cmesh_get_num_trees (forest->cmesh),
+                  "The forest file does not match the cmesh");
+}
+
+/* Return the tree of a global element given the first elements of all
+ * trees. tree_first has num_trees + 1 entries, the last one being the
+ * global number of elements. For the global number of elements we return
+ * num_trees. */
+static t8_gloidx_t
+t8_forest_io_find_tree (const int64_t * tree_first, t8_gloidx_t num_trees,
+                        t8_gloidx_t element)
+{
+  t8_gloidx_t         low = 0, high = num_trees, mid;
+
+  /* We search the last tree whose first element is at most element */
+  while (low < high) {
+    mid = high - (high - low) / 2;
+    if (tree_first[mid] <= element) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  return low;
+}
+
+void
+t8_forest_load_trees (t8_forest_t forest, const char *filename)
+{
+  t8_forest_io_file_t file;
+  t8_forest_io_header_t header;
+  t8_eclass_scheme_c *ts;
+  t8_tree_t           tree;
+  t8_gloidx_t         first_element, end_element, itree;
+  t8_gloidx_t         tree_begin, tree_end;
+  t8_locidx_t         num_trees, ielem;
+  int64_t            *tree_first;
+  int32_t            *tree_eclass;
+  char               *elements;
+  size_t              element_size;
+
+  T8_ASSERT (forest != NULL && !forest->committed);
+  T8_ASSERT (forest->cmesh != NULL && forest->scheme_cxx != NULL);
+  t8_profile_region_begin ("forest_load");
+  SC_CHECK_ABORTF (t8_forest_io_open (&file, filename, forest->mpicomm),
+                   "Could not open the forest file %s", filename);
+  t8_forest_io_read_header (forest, &file, &header);
+
+  /* We distribute the elements evenly. We cast to long double and double
+   * first to prevent integer overflow. */
+  first_element = ((long double) header.num_elements * forest->mpirank)
+    / (double) forest->mpisize;
+  end_element = forest->mpirank == forest->mpisize - 1 ? header.num_elements
+    : (t8_gloidx_t) (((long double) header.num_elements *
+                      (forest->mpirank + 1)) / (double) forest->mpisize);
+
+  /* Read the first elements of all trees and find the local trees */
+  tree_first = T8_ALLOC (int64_t, header.num_trees + 1);
+  SC_CHECK_ABORT (t8_forest_io_read (&file, sizeof (header), tree_first,
+                                     sizeof (int64_t) * header.num_trees),
+                  "Could not read the trees of the forest file");
+  tree_first[header.num_trees] = header.num_elements;
+  forest->first_local_tree =
+    t8_forest_io_find_tree (tree_first, header.num_trees, first_element);
+  if (first_element < end_element) {
+    forest->last_local_tree =
+      t8_forest_io_find_tree (tree_first, header.num_trees, end_element - 1);
+  }
+  else {
+    /* This process is empty */
+    forest->last_local_tree = forest->first_local_tree - 1;
+  }
+  num_trees = forest->last_local_tree - forest->first_local_tree + 1;
+
+  /* Read the eclasses of the local trees and the local elements */
+  tree_eclass = T8_ALLOC (int32_t, num_trees + 1);
+  elements = T8_ALLOC (char,
+                       header.slot_size * (end_element - first_element) + 1);
+  SC_CHECK_ABORT (t8_forest_io_read (&file,
+                                     t8_forest_io_eclass_start (&header) +
+                                     (long long) sizeof (int32_t) *
+                                     forest->first_local_tree, tree_eclass,
+                                     sizeof (int32_t) * num_trees)
+                  && t8_forest_io_read (&file,
+                                        t8_forest_io_elements_start (&header)
+                                        + header.slot_size * first_element,
+                                        elements, header.slot_size *
+                                        (end_element - first_element)),
+                  "Could not read the elements of the forest file");
+  t8_forest_io_close (&file);
+
+  forest->trees = sc_array_new_count (sizeof (t8_tree_struct_t), num_trees);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    SC_CHECK_ABORT (0 <= tree_eclass[itree]
+                    && tree_eclass[itree] < T8_ECLASS_COUNT,
+                    "Invalid tree class in the forest file");
+    tree->eclass = (t8_eclass_t) tree_eclass[itree];
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    element_size = header.element_size[tree->eclass];
+    SC_CHECK_ABORT (ts != NULL && element_size == ts->t8_element_size (),
+                    "The element scheme does not match the forest file");
+    /* The local elements of this tree */
+    tree_begin = SC_MAX (first_element,
+                         tree_first[forest->first_local_tree + itree]);
+    tree_end = SC_MIN (end_element,
+                       tree_first[forest->first_local_tree + itree + 1]);
+    T8_ASSERT (tree_begin < tree_end);
+    tree->elements_offset = tree_begin - first_element;
+    t8_element_array_init_size (&tree->elements, ts, tree_end - tree_begin);
+    for (ielem = 0; ielem < tree_end - tree_begin; ielem++) {
+      memcpy (t8_element_array_index_locidx (&tree->elements, ielem),
+              elements +
+              header.slot_size * (tree->elements_offset + ielem),
+              element_size);
+    }
+  }
+  forest->local_num_elements = end_element - first_element;
+  forest->global_num_elements = header.num_elements;
+  T8_FREE (tree_first);
+  T8_FREE (tree_eclass);
+  T8_FREE (elements);
+  t8_profile_region_end ("forest_load");
+}
+
+/* Read the user data of the local elements of a forest that was loaded
+ * from a file. */
+static void
+t8_forest_load_element_data (t8_forest_t forest, const char *filename,
+                             sc_array_t * element_data)
+{
+  t8_forest_io_file_t file;
+  t8_forest_io_header_t header;
+  int                 success;
+
+  SC_CHECK_ABORTF (t8_forest_io_open (&file, filename, forest->mpicomm),
+                   "Could not open the forest file %s", filename);
+  t8_forest_io_read_header (forest, &file, &header);
+  SC_CHECK_ABORT (header.data_size == (int64_t) element_data->elem_size,
+                  "The element data size does not match the forest file");
+  sc_array_resize (element_data, forest->local_num_elements);
+  success = t8_forest_io_read (&file, t8_forest_io_data_start (&header)
+                               + header.data_size *
+                               t8_forest_get_first_local_element_id (forest),
+                               element_data->array,
+                               header.data_size * forest->local_num_elements);
+  t8_forest_io_close (&file);
+  SC_CHECK_ABORT (success, "Could not read the element data of the forest"
+                  " file");
+}
+
+t8_forest_t
+t8_forest_load (const char *filename, t8_cmesh_t cmesh,
+                t8_scheme_cxx_t * scheme, int do_face_ghost,
+                sc_MPI_Comm comm, sc_array_t * element_data)
+{
+  t8_forest_t         forest;
+
+  T8_ASSERT (filename != NULL);
+  T8_ASSERT (t8_cmesh_is_committed (cmesh));
+  T8_ASSERT (scheme != NULL);
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, comm);
+  t8_forest_set_scheme (forest, scheme);
+  t8_forest_set_load (forest, filename);
+  if (do_face_ghost) {
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  }
+  t8_forest_commit (forest);
+  if (element_data != NULL) {
+    t8_forest_load_element_data (forest, filename, element_data);
+  }
+  t8_global_productionf ("Loaded forest with %lli global elements from %s.\n",
+                         (long long) forest->global_num_elements, filename);
+  return forest;
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,72 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_io.h
+ * Write and read binary forest files in parallel.
+ * \see t8_forest_save
+ */
+
+#ifndef T8_FOREST_IO_H
+#define T8_FOREST_IO_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Write blocks of bytes of this process to given offsets in a file that
+ * is shared by all processes of a communicator. Existing contents of the
+ * file are discarded.
+ * The blocks of all processes must not overlap. If t8code is built with
+ * MPI I/O, the blocks are written collectively, otherwise the processes
+ * write one after the other.
+ * \param [in] filename   The file to write.
+ * \param [in] comm       The communicator of the processes sharing the file.
+ * \param [in] num_blocks The number of blocks of this process, may be 0.
+ * \param [in] blocks     The blocks of bytes.
+ * \param [in] sizes      The number of bytes of each block.
+ * \param [in] offsets    The position of each block in the file.
+ * \return  True if succesful, false if not (process local).
+ * This function is collective.
+ */
+int                 t8_forest_io_write_blocks (const char *filename,
+                                               sc_MPI_Comm comm,
+                                               int num_blocks,
+                                               char *const *blocks,
+                                               const size_t * sizes,
+                                               const long long *offsets);
+
+/** Create the trees and elements of a forest from a file that was written
+ * by \ref t8_forest_save. The elements are evenly distributed among the
+ * processes of the forest.
+ * \param [in,out] forest   The forest that is being committed. Its
+ *                          communicator, cmesh, scheme and maxlevel must be set.
+ * \param [in]     filename The file to load.
+ * This function is collective. It aborts if the file cannot be read or
+ * does not match the cmesh or scheme of \a forest.
+ */
+void                t8_forest_load_trees (t8_forest_t forest,
+                                          const char *filename);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_IO_H */
@@ -22,10 +22,14 @@
 
 #include <t8_forest/t8_forest_iterate.h>
 #include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
 #include <t8_forest.h>
 #include <t8_element_cxx.hxx>
 
 #include <t8_default/t8_dtri.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -177,6 +181,156 @@ t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* Return the face of a leaf that lies on a given face of one of its
+ * ancestors, or -1 if the leaf does not touch this face.
+ * We follow each face of the leaf up to the ancestor's level.
+ * ancestor must be an allocated element and is used as work space. */
+static int
+t8_forest_leaf_face_at_ancestor_face (t8_eclass_scheme_c * ts,
+                                      const t8_element_t * leaf,
+                                      int ancestor_level, int face,
+                                      t8_element_t * ancestor)
+{
+  int                 num_faces, leaf_face, iface;
+
+  num_faces = ts->t8_element_num_faces (leaf);
+  for (leaf_face = 0; leaf_face < num_faces; leaf_face++) {
+    ts->t8_element_copy (leaf, ancestor);
+    iface = leaf_face;
+    while (iface >= 0 && ts->t8_element_level (ancestor) > ancestor_level) {
+      /* The face number at the parent, or -1 if the face is inside
+       * the parent */
+      iface = ts->t8_element_face_parent_face (ancestor, iface);
+      ts->t8_element_parent (ancestor, ancestor);
+    }
+    if (iface == face) {
+      return leaf_face;
+    }
+  }
+  return -1;
+}
+
+void
+t8_forest_iterate_face_leafs (t8_forest_t forest, t8_locidx_t ltreeid,
+                              const t8_element_t * element, int face,
+                              t8_element_array_t * leaf_elements,
+                              void *user_data,
+                              t8_locidx_t tree_lindex_of_first_leaf,
+                              t8_forest_iterate_face_fn callback)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *desc, *leaf;
+  t8_linearidx_t      first_id, last_id;
+  t8_locidx_t         first, last, ileaf;
+  int                 maxlevel, level, leaf_face;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= ltreeid
+             && ltreeid < t8_forest_get_num_local_trees (forest));
+
+  if (t8_element_array_get_count (leaf_elements) == 0) {
+    /* There are no leafs, so we have nothing to do */
+    return;
+  }
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  maxlevel = t8_forest_get_maxlevel (forest);
+  level = ts->t8_element_level (element);
+  ts->t8_element_new (1, &desc);
+  /* All leafs at the face lie between the first and last descendant
+   * of element at the face */
+  ts->t8_element_first_descendant_face (element, face, desc, maxlevel);
+  first_id = ts->t8_element_get_linear_id (desc, maxlevel);
+  ts->t8_element_last_descendant_face (element, face, desc, maxlevel);
+  last_id = ts->t8_element_get_linear_id (desc, maxlevel);
+  /* Find the leafs that contain these descendants, or the leafs closest
+   * to them */
+  first = t8_forest_bin_search_lower (leaf_elements, first_id, maxlevel);
+  first = SC_MAX (first, 0);
+  last = t8_forest_bin_search_lower (leaf_elements, last_id, maxlevel);
+  for (ileaf = first; ileaf <= last; ileaf++) {
+    /* Check whether the leaf touches the face and call the callback */
+    leaf = t8_element_array_index_locidx (leaf_elements, ileaf);
+    leaf_face =
+      t8_forest_leaf_face_at_ancestor_face (ts, leaf, level, face, desc);
+    if (leaf_face >= 0) {
+      (void) callback (forest, ltreeid, leaf, leaf_face, user_data,
+                       tree_lindex_of_first_leaf + ileaf);
+    }
+  }
+  ts->t8_element_destroy (1, &desc);
+}
+
+/* Iterate over the leafs at all faces of one local tree */
+static void
+t8_forest_iterate_tree_faces_tree (t8_forest_t forest, t8_locidx_t ltreeid,
+                                   t8_forest_iterate_face_fn callback,
+                                   void *user_data, int use_leaf_ranges)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t *leafs;
+  t8_element_t       *root;
+  int                 iface, num_faces;
+
+  leafs = t8_forest_tree_get_leafs (forest, ltreeid);
+  if (t8_element_array_get_count (leafs) == 0) {
+    return;
+  }
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  /* The root element of the tree */
+  ts->t8_element_new (1, &root);
+  ts->t8_element_set_linear_id (root, 0, 0);
+  num_faces = ts->t8_element_num_faces (root);
+  for (iface = 0; iface < num_faces; iface++) {
+    if (use_leaf_ranges) {
+      t8_forest_iterate_face_leafs (forest, ltreeid, root, iface, leafs,
+                                    user_data, 0, callback);
+    }
+    else {
+      t8_forest_iterate_faces (forest, ltreeid, root, iface, leafs,
+                               user_data, 0, callback);
+    }
+  }
+  ts->t8_element_destroy (1, &root);
+}
+
+void
+t8_forest_iterate_tree_faces (t8_forest_t forest,
+                              t8_forest_iterate_face_fn callback,
+                              void **thread_user_data, int num_threads,
+                              int use_leaf_ranges)
+{
+  t8_locidx_t         num_local_trees, itree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_threads >= 1);
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+#ifdef T8_ENABLE_OPENMP
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (num_threads, num_local_trees);
+  if (num_threads > 1) {
+    /* Each tree is iterated by exactly one thread, which passes
+     * its own user data */
+#pragma omp parallel for num_threads (num_threads) schedule (dynamic)
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_forest_iterate_tree_faces_tree (forest, itree, callback,
+                                         thread_user_data
+                                         [omp_get_thread_num ()],
+                                         use_leaf_ranges);
+    }
+    return;
+  }
+#endif
+  for (itree = 0; itree < num_local_trees; itree++) {
+    t8_forest_iterate_tree_faces_tree (forest, itree, callback,
+                                       thread_user_data[0], use_leaf_ranges);
+  }
+}
+
 /* The recursion that is called from t8_forest_search_tree
  * Input is an element and an array of all leaf elements of this element.
  * The callback function is called on element and if it returns true,
@@ -295,46 +449,346 @@ t8_forest_search_tree (t8_forest_t forest, t8_locidx_t ltreeid,
   /* Start the top-down search */
   t8_forest_search_recursion (forest, ltreeid, eclass, nca, ts, leaf_elements,
                               0, search_fn, user_data);
+  ts->t8_element_destroy (1, &nca);
 }
 
 void
 t8_forest_search (t8_forest_t forest, t8_forest_search_query_fn search_fn,
                   void *user_data)
+{
+  t8_forest_search_threads (forest, search_fn, user_data, 1);
+}
+
+void
+t8_forest_search_threads (t8_forest_t forest,
+                          t8_forest_search_query_fn search_fn,
+                          void *user_data, int num_threads)
 {
   t8_locidx_t         num_local_trees, itree;
 
   num_local_trees = t8_forest_get_num_local_trees (forest);
+#ifdef T8_ENABLE_OPENMP
+  if (num_threads < 0) {
+    num_threads = t8_get_num_threads ();
+  }
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (num_threads, num_local_trees);
+  if (num_threads > 1) {
+    /* Each tree is searched by exactly one thread */
+#pragma omp parallel for num_threads (num_threads) schedule (dynamic)
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_forest_search_tree (forest, itree, search_fn, user_data);
+    }
+    return;
+  }
+#endif
   for (itree = 0; itree < num_local_trees; itree++) {
     t8_forest_search_tree (forest, itree, search_fn, user_data);
   }
 }
 
+/* The recursion that is called from t8_forest_search_queries_tree.
+ * active_queries stores the indices of the queries that are active at
+ * element. */
+static void
+t8_forest_search_queries_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    t8_element_t * element,
+                                    t8_eclass_scheme_c * ts,
+                                    t8_element_array_t * leaf_elements,
+                                    t8_locidx_t tree_lindex_of_first_leaf,
+                                    t8_forest_search_query_fn search_fn,
+                                    t8_forest_query_fn query_fn,
+                                    sc_array_t * queries,
+                                    sc_array_t * active_queries,
+                                    void *user_data)
+{
+  t8_element_t       *leaf, **children;
+  int                 num_children, ichild, is_leaf;
+  size_t             *split_offsets, indexa, indexb;
+  size_t              elem_count, iquery, query_index;
+  t8_locidx_t         tree_leaf_index;
+  t8_element_array_t  child_leafs;
+  sc_array_t          child_queries;
+
+  elem_count = t8_element_array_get_count (leaf_elements);
+  if (elem_count == 0) {
+    /* There are no leafs left, so we have nothing to do */
+    return;
+  }
+  is_leaf = 0;
+  if (elem_count == 1) {
+    /* There is only one leaf left, we check whether it is element */
+    leaf = t8_element_array_index_locidx (leaf_elements, 0);
+    SC_CHECK_ABORT (ts->t8_element_level (element) <=
+                    ts->t8_element_level (leaf),
+                    "Search: element level greater than leaf level\n");
+    if (ts->t8_element_level (element) == ts->t8_element_level (leaf)) {
+      T8_ASSERT (!ts->t8_element_compare (element, leaf));
+      is_leaf = 1;
+      element = leaf;
+    }
+  }
+  tree_leaf_index =
+    is_leaf ? tree_lindex_of_first_leaf : -tree_lindex_of_first_leaf - 1;
+  if (search_fn != NULL
+      && !search_fn (forest, ltreeid, element, leaf_elements, user_data,
+                     tree_leaf_index)) {
+    /* The element and its descendants are pruned */
+    return;
+  }
+  /* Call the query callback for each active query and keep those that
+   * return true for the children */
+  sc_array_init (&child_queries, sizeof (size_t));
+  for (iquery = 0; iquery < active_queries->elem_count; iquery++) {
+    query_index = *(size_t *) sc_array_index (active_queries, iquery);
+    if (query_fn (forest, ltreeid, element, leaf_elements, user_data,
+                  tree_leaf_index, sc_array_index (queries, query_index),
+                  query_index) && !is_leaf) {
+      *(size_t *) sc_array_push (&child_queries) = query_index;
+    }
+  }
+
+  if (child_queries.elem_count > 0) {
+    T8_ASSERT (!is_leaf);
+    /* Enter the recursion with the remaining queries */
+    num_children = ts->t8_element_num_children (element);
+    children = T8_ALLOC (t8_element_t *, num_children);
+    ts->t8_element_new (num_children, children);
+    split_offsets = T8_ALLOC (size_t, num_children + 1);
+    ts->t8_element_children (element, num_children, children);
+    t8_forest_split_array (element, leaf_elements, split_offsets);
+    for (ichild = 0; ichild < num_children; ichild++) {
+      indexa = split_offsets[ichild];   /* first leaf of this child */
+      indexb = split_offsets[ichild + 1];       /* first leaf of next child */
+      if (indexa < indexb) {
+        t8_element_array_init_view (&child_leafs, leaf_elements, indexa,
+                                    indexb - indexa);
+        t8_forest_search_queries_recursion (forest, ltreeid,
+                                            children[ichild], ts,
+                                            &child_leafs,
+                                            indexa +
+                                            tree_lindex_of_first_leaf,
+                                            search_fn, query_fn, queries,
+                                            &child_queries, user_data);
+      }
+    }
+    ts->t8_element_destroy (num_children, children);
+    T8_FREE (children);
+    T8_FREE (split_offsets);
+  }
+  sc_array_reset (&child_queries);
+}
+
+/* Perform a top-down search for all queries in one tree of the forest */
+static void
+t8_forest_search_queries_tree (t8_forest_t forest, t8_locidx_t ltreeid,
+                               t8_forest_search_query_fn search_fn,
+                               t8_forest_query_fn query_fn,
+                               sc_array_t * queries, void *user_data)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *nca, *first_el, *last_el;
+  t8_element_array_t *leaf_elements;
+  sc_array_t          active_queries;
+  size_t              iquery;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_eclass (forest, ltreeid));
+  leaf_elements = t8_forest_tree_get_leafs (forest, ltreeid);
+  if (t8_element_array_get_count (leaf_elements) == 0) {
+    return;
+  }
+  /* All queries are active at the start */
+  sc_array_init_size (&active_queries, sizeof (size_t),
+                      queries->elem_count);
+  for (iquery = 0; iquery < queries->elem_count; iquery++) {
+    *(size_t *) sc_array_index (&active_queries, iquery) = iquery;
+  }
+  /* Start the search at the nearest common ancestor of the leafs */
+  first_el = t8_element_array_index_locidx (leaf_elements, 0);
+  last_el =
+    t8_element_array_index_locidx (leaf_elements,
+                                   t8_element_array_get_count (leaf_elements)
+                                   - 1);
+  ts->t8_element_new (1, &nca);
+  ts->t8_element_nca (first_el, last_el, nca);
+  t8_forest_search_queries_recursion (forest, ltreeid, nca, ts,
+                                      leaf_elements, 0, search_fn, query_fn,
+                                      queries, &active_queries, user_data);
+  ts->t8_element_destroy (1, &nca);
+  sc_array_reset (&active_queries);
+}
+
 void
-t8_forest_iterate_replace (t8_forest_t forest_new,
-                           t8_forest_t forest_old,
-                           t8_forest_replace_t replace_fn)
+t8_forest_search_queries (t8_forest_t forest,
+                          t8_forest_search_query_fn search_fn,
+                          t8_forest_query_fn query_fn, sc_array_t * queries,
+                          void *user_data, int num_threads)
+{
+  t8_locidx_t         num_local_trees, itree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (query_fn != NULL);
+  T8_ASSERT (queries != NULL);
+
+  if (queries->elem_count == 0) {
+    return;
+  }
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+#ifdef T8_ENABLE_OPENMP
+  if (num_threads < 0) {
+    num_threads = t8_get_num_threads ();
+  }
+  /* We never use more threads than there are trees */
+  num_threads = SC_MIN (num_threads, num_local_trees);
+  if (num_threads > 1) {
+    /* Each tree is searched by exactly one thread */
+#pragma omp parallel for num_threads (num_threads) schedule (dynamic)
+    for (itree = 0; itree < num_local_trees; itree++) {
+      t8_forest_search_queries_tree (forest, itree, search_fn, query_fn,
+                                     queries, user_data);
+    }
+    return;
+  }
+#endif
+  for (itree = 0; itree < num_local_trees; itree++) {
+    t8_forest_search_queries_tree (forest, itree, search_fn, query_fn,
+                                   queries, user_data);
+  }
+}
+
+/* Decide whether t8_forest_iterate visits a face from one of its sides.
+ * See the rules in the documentation of t8_forest_iterate. */
+static int
+t8_forest_iterate_visits_face (t8_forest_t forest, t8_locidx_t lelement_id,
+                               int num_neighbors,
+                               const t8_locidx_t * neighbors, int level_diff)
+{
+  if (num_neighbors == 0 || level_diff > 0) {
+    /* A boundary face or the coarse side of a hanging face */
+    return 1;
+  }
+  if (level_diff == 0) {
+    return lelement_id < neighbors[0];
+  }
+  /* The fine side of a hanging face, we visit it if the coarse side
+   * is a ghost */
+  return neighbors[0] >= t8_forest_get_num_element (forest);
+}
+
+void
+t8_forest_iterate (t8_forest_t forest, t8_forest_iterate_volume_fn volume_fn,
+                   t8_forest_iterate_face_pair_fn face_fn, void *user_data)
+{
+  t8_forest_element_cursor_t cursor;
+  t8_element_scratch_t scratch;
+  t8_eclass_scheme_c *neigh_scheme;
+  t8_element_t      **neighbor_leafs;
+  const t8_locidx_t  *neighbors;
+  t8_locidx_t        *element_indices;
+  const int8_t       *table_dual_faces;
+  int                *dual_faces;
+  sc_array_t          dual_buffer;
+  int                 iface, num_faces, num_neighbors, level_diff, ineigh;
+  int                 use_table;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  use_table = forest->face_neighbors != NULL;
+  if (face_fn != NULL && !use_table) {
+    t8_element_scratch_init (&scratch, 0);
+  }
+  sc_array_init (&dual_buffer, sizeof (int));
+  t8_forest_element_cursor_init (forest, &cursor);
+  while (t8_forest_element_cursor_next (&cursor)) {
+    if (volume_fn != NULL) {
+      volume_fn (forest, cursor.ltreeid, cursor.element, cursor.lelement_id,
+                 user_data);
+    }
+    if (face_fn == NULL) {
+      continue;
+    }
+    num_faces = cursor.ts->t8_element_num_faces (cursor.element);
+    for (iface = 0; iface < num_faces; iface++) {
+      if (use_table) {
+        num_neighbors =
+          t8_forest_get_face_neighbors (forest, cursor.lelement_id, iface,
+                                        &neighbors, &table_dual_faces,
+                                        &level_diff);
+        /* The table stores the dual faces as int8_t */
+        sc_array_resize (&dual_buffer, num_neighbors);
+        dual_faces = (int *) dual_buffer.array;
+        for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+          dual_faces[ineigh] = table_dual_faces[ineigh];
+        }
+      }
+      else {
+        num_neighbors =
+          t8_forest_leaf_face_neighbors_scratch (forest, cursor.ltreeid,
+                                                 cursor.element, iface,
+                                                 &scratch, &neighbor_leafs,
+                                                 &dual_faces,
+                                                 &element_indices,
+                                                 &neigh_scheme, 1);
+        neighbors = element_indices;
+        level_diff = num_neighbors == 0 ? 0 :
+          neigh_scheme->t8_element_level (neighbor_leafs[0])
+          - cursor.ts->t8_element_level (cursor.element);
+      }
+      if (t8_forest_iterate_visits_face (forest, cursor.lelement_id,
+                                         num_neighbors, neighbors,
+                                         level_diff)) {
+        face_fn (forest, cursor.ltreeid, cursor.element, cursor.lelement_id,
+                 iface, num_neighbors, neighbors, dual_faces, level_diff,
+                 user_data);
+      }
+      if (!use_table) {
+        t8_element_scratch_clear (&scratch);
+      }
+    }
+  }
+  if (face_fn != NULL && !use_table) {
+    t8_element_scratch_reset (&scratch);
+  }
+  sc_array_reset (&dual_buffer);
+}
+
+/* Compare forest_old and forest_new tree by tree and call replace_fn for
+ * each refined element and coarsened family. If copy_fn is NULL, replace_fn
+ * is also called for each unchanged element. Otherwise the unchanged
+ * elements are collected into runs of consecutive local indices that may
+ * span several trees and copy_fn is called once per run. */
+static void
+t8_forest_iterate_replace_runs (t8_forest_t forest_new,
+                                t8_forest_t forest_old,
+                                t8_forest_replace_t replace_fn,
+                                t8_forest_replace_copy_t copy_fn)
 {
   t8_locidx_t         ielem_new, ielem_old, elems_per_tree_old,
     elems_per_tree_new;
   t8_locidx_t         itree, num_local_trees;
   t8_locidx_t         family_size;
+  t8_locidx_t         offset_new, offset_old;
+  t8_locidx_t         run_old, run_new, run_count;
   t8_element_t       *elem_new, *elem_old;
   t8_eclass_scheme_c *ts;
   t8_eclass_t         eclass;
   int                 level_new, level_old;
 
-  t8_global_productionf ("Into t8_forest_iterate_replace\n");
   T8_ASSERT (t8_forest_is_committed (forest_old));
   T8_ASSERT (t8_forest_is_committed (forest_new));
 
   num_local_trees = t8_forest_get_num_local_trees (forest_new);
   T8_ASSERT (num_local_trees == t8_forest_get_num_local_trees (forest_old));
 
+  run_old = run_new = run_count = 0;
   for (itree = 0; itree < num_local_trees; itree++) {
     /* Loop over the trees */
     /* Get the number of elements of this tree in old and new forest */
     elems_per_tree_new = t8_forest_get_tree_num_elements (forest_new, itree);
     elems_per_tree_old = t8_forest_get_tree_num_elements (forest_old, itree);
+    offset_new = t8_forest_get_tree_element_offset (forest_new, itree);
+    offset_old = t8_forest_get_tree_element_offset (forest_old, itree);
     /* Get the eclass and scheme of the tree */
     eclass = t8_forest_get_tree_class (forest_new, itree);
     T8_ASSERT (eclass == t8_forest_get_tree_class (forest_old, itree));
@@ -349,7 +803,37 @@ t8_forest_iterate_replace (t8_forest_t forest_new,
       /* Get the levels of these elements */
       level_new = ts->t8_element_level (elem_new);
       level_old = ts->t8_element_level (elem_old);
-      /* If the levels differ, elem_new was refined or its family coarsened */
+      if (level_old == level_new) {
+        /* elem_new = elem_old */
+        T8_ASSERT (!ts->t8_element_compare (elem_new, elem_old));
+        if (copy_fn == NULL) {
+          replace_fn (forest_old, forest_new, itree, ts, 1, ielem_old, 1,
+                      ielem_new);
+        }
+        else if (run_count == 0) {
+          /* Start a new run */
+          run_old = offset_old + ielem_old;
+          run_new = offset_new + ielem_new;
+          run_count = 1;
+        }
+        else {
+          /* Unchanged elements have consecutive local indices, also
+           * across trees, extend the current run */
+          T8_ASSERT (run_old + run_count == offset_old + ielem_old);
+          T8_ASSERT (run_new + run_count == offset_new + ielem_new);
+          run_count++;
+        }
+        /* Advance to the next element */
+        ielem_new++;
+        ielem_old++;
+        continue;
+      }
+      /* The levels differ, elem_new was refined or its family coarsened.
+       * Report the unchanged elements before it first. */
+      if (run_count > 0) {
+        copy_fn (forest_old, forest_new, run_old, run_new, run_count);
+        run_count = 0;
+      }
       if (level_old < level_new) {
         T8_ASSERT (level_new == level_old + 1);
         /* elem_old was refined */
@@ -360,7 +844,7 @@ t8_forest_iterate_replace (t8_forest_t forest_new,
         ielem_new += family_size;
         ielem_old++;
       }
-      else if (level_old > level_new) {
+      else {
         T8_ASSERT (level_new == level_old - 1);
         /* elem_old was coarsened */
         family_size = ts->t8_element_num_children (elem_new);
@@ -370,22 +854,38 @@ t8_forest_iterate_replace (t8_forest_t forest_new,
         ielem_new++;
         ielem_old += family_size;
       }
-      else {
-        /* elem_new = elem_old */
-        T8_ASSERT (!ts->t8_element_compare (elem_new, elem_old));
-        replace_fn (forest_old, forest_new, itree, ts, 1, ielem_old, 1,
-                    ielem_new);
-        /* Advance to the next element */
-        ielem_new++;
-        ielem_old++;
-      }
     }                           /* element loop */
     T8_ASSERT (ielem_new ==
                t8_forest_get_tree_num_elements (forest_new, itree));
     T8_ASSERT (ielem_old ==
                t8_forest_get_tree_num_elements (forest_old, itree));
   }                             /* tree loop */
+  if (run_count > 0) {
+    copy_fn (forest_old, forest_new, run_old, run_new, run_count);
+  }
+}
+
+void
+t8_forest_iterate_replace (t8_forest_t forest_new,
+                           t8_forest_t forest_old,
+                           t8_forest_replace_t replace_fn)
+{
+  t8_global_productionf ("Into t8_forest_iterate_replace\n");
+  t8_forest_iterate_replace_runs (forest_new, forest_old, replace_fn, NULL);
   t8_global_productionf ("Done t8_forest_iterate_replace\n");
 }
 
+void
+t8_forest_iterate_replace_bulk (t8_forest_t forest_new,
+                                t8_forest_t forest_old,
+                                t8_forest_replace_t replace_fn,
+                                t8_forest_replace_copy_t copy_fn)
+{
+  T8_ASSERT (copy_fn != NULL);
+  t8_global_productionf ("Into t8_forest_iterate_replace_bulk\n");
+  t8_forest_iterate_replace_runs (forest_new, forest_old, replace_fn,
+                                  copy_fn);
+  t8_global_productionf ("Done t8_forest_iterate_replace_bulk\n");
+}
+
 T8_EXTERN_C_END ();
@@ -51,6 +51,79 @@ typedef int         (*t8_forest_search_query_fn) (t8_forest_t forest,
                                                   t8_locidx_t
                                                   tree_leaf_index);
 
+/** A callback for \ref t8_forest_search_queries that is called for an element
+ * and one of the queries that are active at this element.
+ * \param [in] forest      The forest.
+ * \param [in] ltreeid     The local tree of \a element.
+ * \param [in] element     The current element of the search.
+ * \param [in] leaf_elements The leafs of the tree that are descendants of
+ *                         \a element.
+ * \param [in] user_data   The user data passed to the search.
+ * \param [in] tree_leaf_index If \a element is a leaf, its index in the
+ *                         tree, otherwise -(index of the first leaf) - 1.
+ * \param [in] query       A pointer to the query.
+ * \param [in] query_index The index of \a query in the query array.
+ * \return                 If \a element is no leaf, true if the query may
+ *                         match a descendant of \a element and should stay
+ *                         active for its descendants.
+ *                         If \a element is a leaf, true if the query matches
+ *                         the leaf. The return value is then ignored.
+ * \note A box that contains \a element is computed cheaply with
+ * \ref t8_forest_element_bounding_box.
+ */
+typedef int         (*t8_forest_query_fn) (t8_forest_t forest,
+                                           t8_locidx_t ltreeid,
+                                           const t8_element_t * element,
+                                           t8_element_array_t *
+                                           leaf_elements, void *user_data,
+                                           t8_locidx_t tree_leaf_index,
+                                           void *query, size_t query_index);
+
+/** A callback for \ref t8_forest_iterate that is called once for each
+ * local leaf.
+ * \param [in] forest      The forest.
+ * \param [in] ltreeid     The local tree of \a element.
+ * \param [in] element     A local leaf.
+ * \param [in] lelement_id The local index of \a element.
+ * \param [in] user_data   The user data passed to \ref t8_forest_iterate.
+ */
+typedef void        (*t8_forest_iterate_volume_fn) (t8_forest_t forest,
+                                                    t8_locidx_t ltreeid,
+                                                    const t8_element_t *
+                                                    element,
+                                                    t8_locidx_t lelement_id,
+                                                    void *user_data);
+
+/** A callback for \ref t8_forest_iterate that is called once for each face
+ * between leafs and for each boundary face.
+ * \param [in] forest      The forest.
+ * \param [in] ltreeid     The local tree of \a element.
+ * \param [in] element     A local leaf, one side of the face.
+ * \param [in] lelement_id The local index of \a element.
+ * \param [in] face        The face of \a element.
+ * \param [in] num_neighbors The number of leafs on the other side, 0 at the
+ *                         domain boundary.
+ * \param [in] neighbors   The indices of the leafs on the other side.
+ *                         0, ..., num_local_el - 1 for local leafs and
+ *                         num_local_el, ... for ghosts.
+ * \param [in] dual_faces  The faces of the neighbors at \a face.
+ * \param [in] level_diff  The level of the neighbors minus the level of
+ *                         \a element. Nonzero if the face is hanging.
+ * \param [in] user_data   The user data passed to \ref t8_forest_iterate.
+ */
+typedef void        (*t8_forest_iterate_face_pair_fn) (t8_forest_t forest,
+                                                       t8_locidx_t ltreeid,
+                                                       const t8_element_t *
+                                                       element,
+                                                       t8_locidx_t
+                                                       lelement_id, int face,
+                                                       int num_neighbors,
+                                                       const t8_locidx_t *
+                                                       neighbors,
+                                                       const int *dual_faces,
+                                                       int level_diff,
+                                                       void *user_data);
+
 T8_EXTERN_C_BEGIN ();
 
 /* TODO: Document */
@@ -66,6 +139,8 @@ void                t8_forest_split_array (const t8_element_t * element,
  * - (index + 1) */
 /* Top-down iteration and callback is called on each intermediate level.
  * If it returns false, the current element is not traversed further */
+/* This function may be called concurrently from several threads for
+ * different trees or elements. */
 void                t8_forest_iterate_faces (t8_forest_t forest,
                                              t8_locidx_t ltreeid,
                                              const t8_element_t * element,
@@ -77,6 +152,67 @@ void                t8_forest_iterate_faces (t8_forest_t forest,
                                              t8_forest_iterate_face_fn
                                              callback);
 
+/** Call a callback on each leaf of an element that touches a given face of
+ * the element. The result is the same as the calls of
+ * \ref t8_forest_iterate_faces on leafs, but instead of recursing
+ * and splitting the leaf array, we find the range of leafs between the first
+ * and last descendant of \a element at \a face by binary search and check
+ * each leaf in this range.
+ * \param [in] forest      A committed forest.
+ * \param [in] ltreeid     A local tree of \a forest.
+ * \param [in] element     An element of this tree.
+ * \param [in] face        A face of \a element.
+ * \param [in] leaf_elements The leafs of the tree that are descendants
+ *                         of \a element, sorted.
+ * \param [in] user_data   Passed to \a callback.
+ * \param [in] tree_lindex_of_first_leaf The index in the tree of the first
+ *                         entry of \a leaf_elements.
+ * \param [in] callback    Called for each leaf at the face, with the
+ *                         leaf's face that lies on \a face and the index
+ *                         of the leaf in the tree. Its return value is
+ *                         ignored.
+ * This function may be called concurrently from several threads for
+ * different trees or elements.
+ */
+void                t8_forest_iterate_face_leafs (t8_forest_t forest,
+                                                  t8_locidx_t ltreeid,
+                                                  const t8_element_t *
+                                                  element, int face,
+                                                  t8_element_array_t *
+                                                  leaf_elements,
+                                                  void *user_data,
+                                                  t8_locidx_t
+                                                  tree_lindex_of_first_leaf,
+                                                  t8_forest_iterate_face_fn
+                                                  callback);
+
+/** Iterate over the leafs at each face of each local tree of a forest.
+ * The local trees are iterated concurrently.
+ * This is only effective if t8code was configured with --enable-openmp.
+ * Otherwise, the trees are iterated serially.
+ * \param [in] forest      A committed forest.
+ * \param [in] callback    The face callback,
+ *                         \see t8_forest_iterate_faces.
+ * \param [in] thread_user_data An array of \a num_threads user data pointers.
+ *                         The thread with number i passes thread_user_data[i]
+ *                         to \a callback. Without OpenMP only the first entry
+ *                         is used.
+ * \param [in] num_threads The number of threads, at least 1.
+ * \param [in] use_leaf_ranges If true, use \ref t8_forest_iterate_face_leafs
+ *                         and call \a callback only for leafs.
+ *                         Otherwise use the top-down recursion
+ *                         \ref t8_forest_iterate_faces.
+ * \note If \a num_threads > 1, \a callback is called concurrently for
+ * elements of different trees. The calls for one tree are always made from the
+ * same thread and in order.
+ */
+void                t8_forest_iterate_tree_faces (t8_forest_t forest,
+                                                  t8_forest_iterate_face_fn
+                                                  callback,
+                                                  void **thread_user_data,
+                                                  int num_threads,
+                                                  int use_leaf_ranges);
+
 /* Perform a top-down search of the forest, executing a callback on each
  * intermediate element. The search will enter each tree at least once.
  * If the callback returns false for an element, its descendants
@@ -86,6 +222,102 @@ void                t8_forest_search (t8_forest_t forest,
                                       t8_forest_search_query_fn search_fn,
                                       void *user_data);
 
+/** Perform the same search as \ref t8_forest_search, but search the local
+ * trees concurrently.
+ * This is only effective if t8code was configured with --enable-openmp.
+ * Otherwise, the trees are searched serially.
+ * \param [in]     forest      A committed forest.
+ * \param [in]     search_fn   The search callback.
+ * \param [in]     user_data   User data that is passed to \a search_fn.
+ * \param [in]     num_threads The number of threads. 0 or 1 for a serial search,
+ *                             a negative number to use
+ *                             \ref t8_get_num_threads threads.
+ * \note If \a num_threads > 1, \a search_fn is called concurrently for
+ * elements of different trees. The calls for one tree are always made from the
+ * same thread and in order. It must not modify \a user_data or other data
+ * shared between trees without synchronizing and it must not call MPI.
+ */
+void                t8_forest_search_threads (t8_forest_t forest,
+                                              t8_forest_search_query_fn
+                                              search_fn, void *user_data,
+                                              int num_threads);
+
+/** Perform a top-down search of the forest for many queries at once, similar
+ * to p4est_search_local.
+ * Each element of the search keeps the set of queries that are active at
+ * its parent. \a query_fn is called for each of these queries and only the
+ * queries for which it returns true are passed on to the children.
+ * The descendants of an element are not searched if no query is active at
+ * the element, or if \a search_fn returns false for it.
+ * At the leafs \a query_fn reports the matches of the queries.
+ * \param [in] forest      A committed forest.
+ * \param [in] search_fn   If not NULL, called once for each element before
+ *                         the queries. If it returns false, neither the
+ *                         queries nor the descendants are considered.
+ * \param [in] query_fn    Called for each element and each query that is
+ *                         active at it.
+ * \param [in] queries     An array of queries. Each query is active at the
+ *                         root of each tree.
+ * \param [in] user_data   Passed to \a search_fn and \a query_fn.
+ * \param [in] num_threads The number of threads to search the local trees
+ *                         with. 0 or 1 for a serial search, a negative
+ *                         number for \ref t8_get_num_threads threads.
+ *                         Only effective with --enable-openmp.
+ * \note If \a num_threads > 1, the callbacks are called concurrently for
+ * elements of different trees and may be called concurrently for the same
+ * query. They must not modify shared data without synchronizing and must not
+ * call MPI.
+ */
+void                t8_forest_search_queries (t8_forest_t forest,
+                                              t8_forest_search_query_fn
+                                              search_fn,
+                                              t8_forest_query_fn query_fn,
+                                              sc_array_t * queries,
+                                              void *user_data,
+                                              int num_threads);
+
+/** Iterate over all local leafs and all faces of a forest, similar to
+ * p4est_iterate. Each face is visited once, with both of its sides:
+ * - A face between two leafs of the same level is visited from the leaf
+ *   with the smaller index, that is from the local leaf if the other
+ *   side is a ghost.
+ * - A hanging face is visited once from its coarse side, with all fine
+ *   leafs as neighbors. If the coarse side is a ghost, the face is visited
+ *   from each local fine leaf instead, with the ghost as the only neighbor.
+ * - A boundary face is visited with 0 neighbors.
+ * If the forest has a face neighbor table, \see t8_forest_set_face_neighbors,
+ * the neighbors are read from it, otherwise they are computed.
+ * \param [in] forest     A committed, balanced forest. On more than one
+ *                        process it needs a face ghost layer.
+ * \param [in] volume_fn  If not NULL, called once for each local leaf,
+ *                        before its faces.
+ * \param [in] face_fn    If not NULL, called once for each face.
+ * \param [in] user_data  Passed to the callbacks.
+ */
+void                t8_forest_iterate (t8_forest_t forest,
+                                       t8_forest_iterate_volume_fn volume_fn,
+                                       t8_forest_iterate_face_pair_fn face_fn,
+                                       void *user_data);
+
+/** A callback for \ref t8_forest_iterate_replace_bulk that is called for
+ * each run of consecutive elements that are unchanged between the old and
+ * the new forest.
+ * \param [in] forest_old  The forest that is adapted.
+ * \param [in] forest_new  The forest that is newly constructed from \a forest_old.
+ * \param [in] first_old   The local index of the first element of the run
+ *                         in \a forest_old.
+ * \param [in] first_new   The local index of the first element of the run
+ *                         in \a forest_new.
+ * \param [in] count       The number of elements in the run.
+ * The run may span several trees, so that data stored per local element
+ * can be copied with one memcpy.
+ */
+typedef void        (*t8_forest_replace_copy_t) (t8_forest_t forest_old,
+                                                 t8_forest_t forest_new,
+                                                 t8_locidx_t first_old,
+                                                 t8_locidx_t first_new,
+                                                 t8_locidx_t count);
+
 /** Given two forest where the elemnts in one forest are either direct children or
  * parents of the elements in the other forest.
  * Compare the two forests and for each refined element or coarsened
@@ -102,6 +334,25 @@ void                t8_forest_iterate_replace (t8_forest_t forest_new,
                                                t8_forest_replace_t
                                                replace_fn);
 
+/** Like \ref t8_forest_iterate_replace, but the unchanged elements are
+ * reported in runs instead of one by one.
+ * \a replace_fn is only called for refined elements and coarsened families,
+ * and \a copy_fn is called for each maximal run of unchanged elements
+ * between them. Both callbacks are called in the order of the elements.
+ * \param [in]  forest_new  A forest, each element is a parent or child of an element in \a forest_old.
+ * \param [in]  forest_old  The initial forest.
+ * \param [in]  replace_fn  A replace callback function.
+ * \param [in]  copy_fn     A callback for runs of unchanged elements.
+ * \note To pass a user pointer to the callbacks use \ref t8_forest_set_user_data
+ * and \ref t8_forest_get_user_data.
+ */
+void                t8_forest_iterate_replace_bulk (t8_forest_t forest_new,
+                                                    t8_forest_t forest_old,
+                                                    t8_forest_replace_t
+                                                    replace_fn,
+                                                    t8_forest_replace_copy_t
+                                                    copy_fn);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_ITERATE_H! */
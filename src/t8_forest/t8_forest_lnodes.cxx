@@ -0,0 +1,929 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_lnodes.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_element_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The reference coordinates of a node on the boundary of a tree are scaled
+ * to this length, such that trees of different classes agree on them. */
+#define T8_LNODES_ROOT_LEN ((t8_gloidx_t) 1 << 62)
+
+/* The key of a node, which is the same in all trees containing the node.
+ * A node inside a tree is given by the global id of the tree and its
+ * reference coordinates.
+ * A node on the boundary of a tree lies on a tree vertex, edge or face.
+ * It is given by the coordinates of the first corners of this vertex,
+ * edge or face, sorted by their coordinates, and its scaled reference
+ * coordinates relative to these corners.
+ * All members are 8 bytes wide, thus keys can be compared bytewise. */
+typedef struct
+{
+  t8_gloidx_t         tree;     /* The tree of inner nodes, -1 otherwise */
+  double              corners[3][3];
+  t8_gloidx_t         coords[3];
+} t8_lnodes_key_t;
+
+/* A key together with the position it was computed for */
+typedef struct
+{
+  t8_lnodes_key_t     key;
+  size_t              index;
+} t8_lnodes_entry_t;
+
+/* The midpoint of an edge or a quad face of an element, which is a hanging
+ * node if it is a node at all, and the corners that constrain it. */
+typedef struct
+{
+  t8_lnodes_key_t     key;
+  t8_gloidx_t         num_nodes;
+  t8_gloidx_t         nodes[4];
+} t8_lnodes_constraint_t;
+
+/* A non-owned local node ordered by its global number */
+typedef struct
+{
+  t8_gloidx_t         gid;
+  t8_locidx_t         lnode;
+} t8_lnodes_nonlocal_t;
+
+/* The reference geometry of a tree class */
+typedef struct
+{
+  int                 initialized;
+  int                 root_len;
+  int                 num_corners;
+  int                 num_faces;
+  int                 num_edges;
+  int                 num_quad_faces;
+  int                 corners[T8_ECLASS_MAX_CORNERS][3];
+  int                 face_corner[T8_ECLASS_MAX_FACES];
+  int                 normals[T8_ECLASS_MAX_FACES][3];
+  unsigned            face_masks[T8_ECLASS_MAX_FACES];
+  int                 edges[12][2];
+  int                 quad_faces[T8_ECLASS_MAX_FACES][4];
+} t8_lnodes_eclass_t;
+
+/* Compute the reference corners, face normals, edges and quad faces of
+ * a tree class from its root element */
+static void
+t8_forest_lnodes_eclass_init (t8_eclass_scheme_c * ts, t8_eclass_t eclass,
+                              t8_lnodes_eclass_t * info)
+{
+  t8_element_t       *root;
+  int                 dim, icorner, jcorner, iface, i, count;
+  int                 num_face_corners, u[3], w[3];
+  const int          *face_vertices;
+
+  SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                  "Node numbering is not supported for pyramids");
+  memset (info, 0, sizeof (*info));
+  info->initialized = 1;
+  dim = t8_eclass_to_dimension[eclass];
+  ts->t8_element_new (1, &root);
+  ts->t8_element_set_linear_id (root, 0, 0);
+  info->root_len = ts->t8_element_root_len (root);
+  T8_ASSERT (T8_LNODES_ROOT_LEN % info->root_len == 0);
+  info->num_corners = t8_eclass_num_vertices[eclass];
+  for (icorner = 0; icorner < info->num_corners; icorner++) {
+    ts->t8_element_vertex_coords (root, icorner, info->corners[icorner]);
+  }
+  ts->t8_element_destroy (1, &root);
+
+  /* A point lies on a face if its offset to the first face corner is
+   * orthogonal to the face normal */
+  info->num_faces = t8_eclass_num_faces[eclass];
+  for (iface = 0; iface < info->num_faces; iface++) {
+    face_vertices = t8_face_vertex_to_tree_vertex[eclass][iface];
+    num_face_corners =
+      t8_eclass_num_vertices[t8_eclass_face_types[eclass][iface]];
+    for (i = 0; i < num_face_corners; i++) {
+      info->face_masks[iface] |= 1u << face_vertices[i];
+    }
+    info->face_corner[iface] = face_vertices[0];
+    for (i = 0; i < 3; i++) {
+      u[i] = w[i] = 0;
+      if (num_face_corners > 1) {
+        u[i] = (info->corners[face_vertices[1]][i] -
+                info->corners[face_vertices[0]][i]) / info->root_len;
+      }
+      if (num_face_corners > 2) {
+        w[i] = (info->corners[face_vertices[2]][i] -
+                info->corners[face_vertices[0]][i]) / info->root_len;
+      }
+    }
+    if (dim == 1) {
+      info->normals[iface][0] = 1;
+    }
+    else if (dim == 2) {
+      info->normals[iface][0] = -u[1];
+      info->normals[iface][1] = u[0];
+      info->edges[info->num_edges][0] = face_vertices[0];
+      info->edges[info->num_edges++][1] = face_vertices[1];
+    }
+    else {
+      info->normals[iface][0] = u[1] * w[2] - u[2] * w[1];
+      info->normals[iface][1] = u[2] * w[0] - u[0] * w[2];
+      info->normals[iface][2] = u[0] * w[1] - u[1] * w[0];
+      if (num_face_corners == 4) {
+        memcpy (info->quad_faces[info->num_quad_faces++], face_vertices,
+                4 * sizeof (int));
+      }
+    }
+  }
+  if (dim == 3) {
+    /* Two corners span an edge if they share two faces */
+    for (icorner = 0; icorner < info->num_corners; icorner++) {
+      for (jcorner = icorner + 1; jcorner < info->num_corners; jcorner++) {
+        count = 0;
+        for (iface = 0; iface < info->num_faces; iface++) {
+          if ((info->face_masks[iface] >> icorner & 1)
+              && (info->face_masks[iface] >> jcorner & 1)) {
+            count++;
+          }
+        }
+        if (count >= 2) {
+          T8_ASSERT (info->num_edges < 12);
+          info->edges[info->num_edges][0] = icorner;
+          info->edges[info->num_edges++][1] = jcorner;
+        }
+      }
+    }
+  }
+}
+
+/* Compare two points lexicographically */
+static int
+t8_forest_lnodes_point_compare (const double *a, const double *b)
+{
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/* Compute the key of a point given by its reference coordinates in a tree */
+static void
+t8_forest_lnodes_key (const t8_lnodes_eclass_t * info,
+                      const double *tree_vertices, t8_gloidx_t gtree,
+                      const int coords[3], t8_lnodes_key_t * key)
+{
+  unsigned            mask;
+  int                 iface, icorner, num, i, j, k, l, opposite;
+  int                 list[T8_ECLASS_MAX_CORNERS];
+  t8_gloidx_t         d[3], u[3], w[3], dot, det, scale;
+  const int          *origin;
+
+  memset (key, 0, sizeof (*key));
+  mask = (1u << info->num_corners) - 1;
+  for (iface = 0; iface < info->num_faces; iface++) {
+    origin = info->corners[info->face_corner[iface]];
+    dot = 0;
+    for (i = 0; i < 3; i++) {
+      dot += (t8_gloidx_t) (coords[i] - origin[i]) * info->normals[iface][i];
+    }
+    if (dot == 0) {
+      mask &= info->face_masks[iface];
+    }
+  }
+  if (mask == (1u << info->num_corners) - 1) {
+    /* The point lies inside the tree */
+    key->tree = gtree;
+    for (i = 0; i < 3; i++) {
+      key->coords[i] = coords[i];
+    }
+    return;
+  }
+  key->tree = -1;
+
+  /* The corners of the smallest tree face, edge or vertex containing the
+   * point, sorted by their coordinates */
+  num = 0;
+  for (icorner = 0; icorner < info->num_corners; icorner++) {
+    if (mask >> icorner & 1) {
+      for (i = num; i > 0 && t8_forest_lnodes_point_compare
+           (tree_vertices + 3 * icorner,
+            tree_vertices + 3 * list[i - 1]) < 0; i--) {
+        list[i] = list[i - 1];
+      }
+      list[i] = icorner;
+      num++;
+    }
+  }
+  T8_ASSERT (1 <= num && num <= 4);
+  if (num == 4) {
+    /* Drop the corner of a quad face that is opposite to the first one */
+    opposite = 3;
+    for (k = 1; k < 4; k++) {
+      j = k % 3 + 1;
+      l = (k + 1) % 3 + 1;
+      for (i = 0; i < 3; i++) {
+        if (info->corners[list[k]][i] + info->corners[list[0]][i] !=
+            info->corners[list[j]][i] + info->corners[list[l]][i]) {
+          break;
+        }
+      }
+      if (i == 3) {
+        opposite = k;
+        break;
+      }
+    }
+    for (k = opposite; k < 3; k++) {
+      list[k] = list[k + 1];
+    }
+    num = 3;
+  }
+  for (icorner = 0; icorner < num; icorner++) {
+    for (i = 0; i < 3; i++) {
+      /* Adding 0 turns -0 into 0, such that equal keys have equal bytes */
+      key->corners[icorner][i] = tree_vertices[3 * list[icorner] + i] + 0.;
+    }
+  }
+
+  /* Write the point as the first corner plus a combination of the edges
+   * to the other corners */
+  scale = T8_LNODES_ROOT_LEN / info->root_len;
+  for (i = 0; i < 3; i++) {
+    d[i] = coords[i] - info->corners[list[0]][i];
+    u[i] = w[i] = 0;
+    if (num > 1) {
+      u[i] = (info->corners[list[1]][i] - info->corners[list[0]][i])
+        / info->root_len;
+    }
+    if (num > 2) {
+      w[i] = (info->corners[list[2]][i] - info->corners[list[0]][i])
+        / info->root_len;
+    }
+  }
+  if (num == 2) {
+    for (i = 0; u[i] == 0; i++) {
+    }
+    key->coords[0] = d[i] / u[i] * scale;
+  }
+  else if (num == 3) {
+    for (i = 0; i < 3; i++) {
+      for (j = i + 1; j < 3; j++) {
+        det = u[i] * w[j] - u[j] * w[i];
+        if (det != 0) {
+          key->coords[0] = (d[i] * w[j] - d[j] * w[i]) / det * scale;
+          key->coords[1] = (u[i] * d[j] - u[j] * d[i]) / det * scale;
+          return;
+        }
+      }
+    }
+    SC_ABORT_NOT_REACHED ();
+  }
+}
+
+static int
+t8_forest_lnodes_key_compare (const t8_lnodes_key_t * a,
+                              const t8_lnodes_key_t * b)
+{
+  return memcmp (a, b, sizeof (t8_lnodes_key_t));
+}
+
+/* Compare two entries by their keys and then by their index */
+static int
+t8_forest_lnodes_entry_compare (const void *a, const void *b)
+{
+  const t8_lnodes_entry_t *ea = (const t8_lnodes_entry_t *) a;
+  const t8_lnodes_entry_t *eb = (const t8_lnodes_entry_t *) b;
+  int                 ret;
+
+  ret = t8_forest_lnodes_key_compare (&ea->key, &eb->key);
+  if (ret != 0) {
+    return ret;
+  }
+  return ea->index < eb->index ? -1 : ea->index > eb->index;
+}
+
+static int
+t8_forest_lnodes_constraint_compare (const void *a, const void *b)
+{
+  return t8_forest_lnodes_key_compare (&((const t8_lnodes_constraint_t *)
+                                         a)->key,
+                                       &((const t8_lnodes_constraint_t *)
+                                         b)->key);
+}
+
+static int
+t8_forest_lnodes_nonlocal_compare (const void *a, const void *b)
+{
+  t8_gloidx_t         ga = ((const t8_lnodes_nonlocal_t *) a)->gid;
+  t8_gloidx_t         gb = ((const t8_lnodes_nonlocal_t *) b)->gid;
+
+  return ga < gb ? -1 : ga > gb;
+}
+
+/* The process that decides about the owner and the number of a node.
+ * Each process sends the keys of its nodes there, thus nodes are matched
+ * between processes that only share an edge or a vertex and are not face
+ * ghosts of each other. */
+static int
+t8_forest_lnodes_key_rank (const t8_lnodes_key_t * key, int mpisize)
+{
+  const unsigned char *bytes = (const unsigned char *) key;
+  uint32_t            hash = 2166136261u;
+  size_t              i;
+
+  /* FNV-1a */
+  for (i = 0; i < sizeof (t8_lnodes_key_t); i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return (int) (hash % (uint32_t) mpisize);
+}
+
+/* Given the number of items that we send to each process, compute the
+ * numbers that we receive and the offsets of both. */
+static void
+t8_forest_lnodes_counts (sc_MPI_Comm comm, int mpisize,
+                         const int *send_counts, int *recv_counts,
+                         size_t *send_offsets, size_t *recv_offsets)
+{
+  int                 iproc, mpiret;
+
+  mpiret = sc_MPI_Alltoall ((void *) send_counts, 1, sc_MPI_INT,
+                            recv_counts, 1, sc_MPI_INT, comm);
+  SC_CHECK_MPI (mpiret);
+  send_offsets[0] = recv_offsets[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    send_offsets[iproc + 1] = send_offsets[iproc] + send_counts[iproc];
+    recv_offsets[iproc + 1] = recv_offsets[iproc] + recv_counts[iproc];
+  }
+}
+
+/* Send send_counts[p] items of item_size bytes starting at item
+ * send_offsets[p] to each process p and receive recv_counts[p] items
+ * from p starting at item recv_offsets[p]. */
+static void
+t8_forest_lnodes_exchange (sc_MPI_Comm comm, int mpirank, int mpisize,
+                           size_t item_size, const void *send_buffer,
+                           const int *send_counts, const size_t *send_offsets,
+                           void *recv_buffer, const int *recv_counts,
+                           const size_t *recv_offsets)
+{
+  int                 iproc, num_requests, mpiret;
+  char               *send = (char *) send_buffer;
+  char               *recv = (char *) recv_buffer;
+  sc_MPI_Request     *requests;
+
+  requests = T8_ALLOC (sc_MPI_Request, 2 * mpisize);
+  num_requests = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc != mpirank && recv_counts[iproc] > 0) {
+      mpiret = sc_MPI_Irecv (recv + recv_offsets[iproc] * item_size,
+                             recv_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, T8_MPI_LNODES, comm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc != mpirank && send_counts[iproc] > 0) {
+      mpiret = sc_MPI_Isend (send + send_offsets[iproc] * item_size,
+                             send_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, T8_MPI_LNODES, comm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  T8_ASSERT (send_counts[mpirank] == recv_counts[mpirank]);
+  memcpy (recv + recv_offsets[mpirank] * item_size,
+          send + send_offsets[mpirank] * item_size,
+          send_counts[mpirank] * item_size);
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests);
+}
+
+t8_forest_lnodes_t *
+t8_forest_lnodes_new (t8_forest_t forest)
+{
+  t8_forest_lnodes_t *lnodes;
+  t8_lnodes_eclass_t  infos[T8_ECLASS_COUNT], *info;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  const double       *tree_vertices;
+  t8_lnodes_entry_t  *entries;
+  t8_lnodes_key_t    *node_keys, *send_keys, *recv_keys, *group_keys;
+  t8_lnodes_constraint_t *cands, *recv_cands, *cand;
+  t8_lnodes_nonlocal_t *nonlocal;
+  t8_gloidx_t        *node_gids, *send_gids, *recv_gids, *group_gids;
+  t8_gloidx_t        *owned_counts, *node_cons, *send_cons, *recv_cons;
+  t8_gloidx_t        *group_cons, gtree, owned;
+  t8_locidx_t        *element_nodes, *new_lnode, num_elements, ielem;
+  t8_locidx_t         itree, num_trees, tree_elem, num_tree_elems;
+  t8_locidx_t         num_nodes, inode, num_nonlocal, offset;
+  int                 mpisize, mpirank, mpiret, iproc, icorner, iedge;
+  int                 iface, i, level, coords[3], corner_coords[4][3];
+  int                *send_counts, *recv_counts, *cand_counts;
+  int                *cand_recv_counts, *node_ranks, *send_ints;
+  int                *recv_ints, *group_owners, *recv_ranks;
+  size_t             *send_offsets, *recv_offsets, *cand_offsets;
+  size_t             *cand_recv_offsets, *send_nodes, *recv_groups;
+  size_t             *positions;
+  size_t              num_corners, num_send, num_recv, num_groups;
+  size_t              num_cands, num_cand_recv, ientry, ipos, low, high;
+  sc_MPI_Comm         comm;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  comm = forest->mpicomm;
+  mpisize = forest->mpisize;
+  mpirank = forest->mpirank;
+  for (i = 0; i < T8_ECLASS_COUNT; i++) {
+    infos[i].initialized = 0;
+  }
+  lnodes = T8_ALLOC_ZERO (t8_forest_lnodes_t, 1);
+  lnodes->mpicomm = comm;
+  num_elements = t8_forest_get_num_element (forest);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  lnodes->num_local_elements = num_elements;
+
+  /* Each corner of each element gets an entry */
+  lnodes->element_offsets = T8_ALLOC (t8_locidx_t, num_elements + 1);
+  lnodes->element_offsets[0] = 0;
+  ielem = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    if (!infos[eclass].initialized) {
+      t8_forest_lnodes_eclass_init (t8_forest_get_eclass_scheme (forest,
+                                                                 eclass),
+                                    eclass, infos + eclass);
+    }
+    num_tree_elems = t8_forest_get_tree_num_elements (forest, itree);
+    for (tree_elem = 0; tree_elem < num_tree_elems; tree_elem++, ielem++) {
+      lnodes->element_offsets[ielem + 1] =
+        lnodes->element_offsets[ielem] + infos[eclass].num_corners;
+    }
+  }
+  num_corners = lnodes->element_offsets[num_elements];
+
+  /* Compute the keys of all corners and sort them */
+  entries = T8_ALLOC (t8_lnodes_entry_t, num_corners);
+  ientry = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    info = infos + eclass;
+    gtree = t8_forest_global_tree_id (forest, itree);
+    tree_vertices = t8_forest_get_tree_vertices (forest, itree);
+    SC_CHECK_ABORT (tree_vertices != NULL,
+                    "Node numbering needs the vertices of the trees");
+    num_tree_elems = t8_forest_get_tree_num_elements (forest, itree);
+    for (tree_elem = 0; tree_elem < num_tree_elems; tree_elem++) {
+      element = t8_forest_get_element_in_tree (forest, itree, tree_elem);
+      for (icorner = 0; icorner < info->num_corners; icorner++, ientry++) {
+        coords[0] = coords[1] = coords[2] = 0;
+        ts->t8_element_vertex_coords (element, icorner, coords);
+        t8_forest_lnodes_key (info, tree_vertices, gtree, coords,
+                              &entries[ientry].key);
+        entries[ientry].index = ientry;
+      }
+    }
+  }
+  T8_ASSERT (ientry == num_corners);
+  qsort (entries, num_corners, sizeof (t8_lnodes_entry_t),
+         t8_forest_lnodes_entry_compare);
+
+  /* The distinct keys are the local nodes */
+  element_nodes = T8_ALLOC (t8_locidx_t, num_corners);
+  node_keys = T8_ALLOC (t8_lnodes_key_t, num_corners);
+  num_nodes = 0;
+  for (ientry = 0; ientry < num_corners; ientry++) {
+    if (ientry == 0 ||
+        t8_forest_lnodes_key_compare (&entries[ientry].key,
+                                      &entries[ientry - 1].key) != 0) {
+      node_keys[num_nodes++] = entries[ientry].key;
+    }
+    element_nodes[entries[ientry].index] = num_nodes - 1;
+  }
+  T8_FREE (entries);
+
+  /* Send the key of each node to the process deciding about it */
+  send_counts = T8_ALLOC_ZERO (int, mpisize);
+  recv_counts = T8_ALLOC (int, mpisize);
+  send_offsets = T8_ALLOC (size_t, mpisize + 1);
+  recv_offsets = T8_ALLOC (size_t, mpisize + 1);
+  node_ranks = T8_ALLOC (int, num_nodes);
+  for (inode = 0; inode < num_nodes; inode++) {
+    node_ranks[inode] =
+      t8_forest_lnodes_key_rank (node_keys + inode, mpisize);
+    send_counts[node_ranks[inode]]++;
+  }
+  t8_forest_lnodes_counts (comm, mpisize, send_counts, recv_counts,
+                           send_offsets, recv_offsets);
+  num_send = send_offsets[mpisize];
+  num_recv = recv_offsets[mpisize];
+  T8_ASSERT (num_send == (size_t) num_nodes);
+  send_keys = T8_ALLOC (t8_lnodes_key_t, num_send);
+  send_nodes = T8_ALLOC (size_t, num_send);
+  positions = T8_ALLOC (size_t, mpisize);
+  memcpy (positions, send_offsets, mpisize * sizeof (size_t));
+  for (inode = 0; inode < num_nodes; inode++) {
+    ipos = positions[node_ranks[inode]]++;
+    send_keys[ipos] = node_keys[inode];
+    send_nodes[ipos] = inode;
+  }
+  T8_FREE (positions);
+  T8_FREE (node_keys);
+  recv_keys = T8_ALLOC (t8_lnodes_key_t, num_recv);
+  t8_forest_lnodes_exchange (comm, mpirank, mpisize,
+                             sizeof (t8_lnodes_key_t), send_keys,
+                             send_counts, send_offsets, recv_keys,
+                             recv_counts, recv_offsets);
+  T8_FREE (send_keys);
+
+  /* Group the received keys. Since the keys are sorted stably and we
+   * receive in the order of the processes, the first process of a group
+   * is the smallest one and owns the node. */
+  recv_ranks = T8_ALLOC (int, num_recv);
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    for (ientry = recv_offsets[iproc]; ientry < recv_offsets[iproc + 1];
+         ientry++) {
+      recv_ranks[ientry] = iproc;
+    }
+  }
+  entries = T8_ALLOC (t8_lnodes_entry_t, num_recv);
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    entries[ientry].key = recv_keys[ientry];
+    entries[ientry].index = ientry;
+  }
+  T8_FREE (recv_keys);
+  qsort (entries, num_recv, sizeof (t8_lnodes_entry_t),
+         t8_forest_lnodes_entry_compare);
+  recv_groups = T8_ALLOC (size_t, num_recv);
+  group_keys = T8_ALLOC (t8_lnodes_key_t, num_recv);
+  group_owners = T8_ALLOC (int, num_recv);
+  num_groups = 0;
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    if (ientry == 0 ||
+        t8_forest_lnodes_key_compare (&entries[ientry].key,
+                                      &entries[ientry - 1].key) != 0) {
+      group_keys[num_groups] = entries[ientry].key;
+      group_owners[num_groups++] = recv_ranks[entries[ientry].index];
+    }
+    recv_groups[entries[ientry].index] = num_groups - 1;
+  }
+  T8_FREE (entries);
+  T8_FREE (recv_ranks);
+
+  /* Tell each process the owners of its nodes */
+  recv_ints = T8_ALLOC (int, num_recv);
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    recv_ints[ientry] = group_owners[recv_groups[ientry]];
+  }
+  T8_FREE (group_owners);
+  send_ints = T8_ALLOC (int, num_send);
+  t8_forest_lnodes_exchange (comm, mpirank, mpisize, sizeof (int),
+                             recv_ints, recv_counts, recv_offsets,
+                             send_ints, send_counts, send_offsets);
+  T8_FREE (recv_ints);
+  for (ientry = 0; ientry < num_send; ientry++) {
+    node_ranks[send_nodes[ientry]] = send_ints[ientry];
+  }
+  T8_FREE (send_ints);
+
+  /* Number the owned nodes in the order of their keys */
+  owned = 0;
+  for (inode = 0; inode < num_nodes; inode++) {
+    if (node_ranks[inode] == mpirank) {
+      owned++;
+    }
+  }
+  owned_counts = T8_ALLOC (t8_gloidx_t, mpisize);
+  mpiret = sc_MPI_Allgather (&owned, 1, T8_MPI_GLOIDX, owned_counts, 1,
+                             T8_MPI_GLOIDX, comm);
+  SC_CHECK_MPI (mpiret);
+  lnodes->owned_count = (t8_locidx_t) owned;
+  lnodes->global_offset = 0;
+  lnodes->num_global_nodes = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc < mpirank) {
+      lnodes->global_offset += owned_counts[iproc];
+    }
+    lnodes->num_global_nodes += owned_counts[iproc];
+  }
+  T8_FREE (owned_counts);
+  node_gids = T8_ALLOC (t8_gloidx_t, num_nodes);
+  owned = 0;
+  for (inode = 0; inode < num_nodes; inode++) {
+    node_gids[inode] = node_ranks[inode] == mpirank ?
+      lnodes->global_offset + owned++ : -1;
+  }
+
+  /* Send the numbers of the owned nodes and get back all numbers */
+  send_gids = T8_ALLOC (t8_gloidx_t, num_send);
+  for (ientry = 0; ientry < num_send; ientry++) {
+    send_gids[ientry] = node_gids[send_nodes[ientry]];
+  }
+  recv_gids = T8_ALLOC (t8_gloidx_t, num_recv);
+  t8_forest_lnodes_exchange (comm, mpirank, mpisize, sizeof (t8_gloidx_t),
+                             send_gids, send_counts, send_offsets,
+                             recv_gids, recv_counts, recv_offsets);
+  group_gids = T8_ALLOC (t8_gloidx_t, num_groups);
+  for (ientry = 0; ientry < num_groups; ientry++) {
+    group_gids[ientry] = -1;
+  }
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    group_gids[recv_groups[ientry]] =
+      SC_MAX (group_gids[recv_groups[ientry]], recv_gids[ientry]);
+  }
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    recv_gids[ientry] = group_gids[recv_groups[ientry]];
+    T8_ASSERT (recv_gids[ientry] >= 0);
+  }
+  T8_FREE (group_gids);
+  t8_forest_lnodes_exchange (comm, mpirank, mpisize, sizeof (t8_gloidx_t),
+                             recv_gids, recv_counts, recv_offsets,
+                             send_gids, send_counts, send_offsets);
+  T8_FREE (recv_gids);
+  for (ientry = 0; ientry < num_send; ientry++) {
+    node_gids[send_nodes[ientry]] = send_gids[ientry];
+  }
+  T8_FREE (send_gids);
+
+  /* Collect the midpoints of the edges and quad faces of all elements that
+   * may have finer neighbors, together with the corners constraining them */
+  num_cands = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    info = infos + t8_forest_get_tree_class (forest, itree);
+    num_cands += (size_t) t8_forest_get_tree_num_elements (forest, itree)
+      * (info->num_edges + info->num_quad_faces);
+  }
+  cands = T8_ALLOC (t8_lnodes_constraint_t, num_cands);
+  num_cands = 0;
+  ielem = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    info = infos + eclass;
+    gtree = t8_forest_global_tree_id (forest, itree);
+    tree_vertices = t8_forest_get_tree_vertices (forest, itree);
+    num_tree_elems = t8_forest_get_tree_num_elements (forest, itree);
+    for (tree_elem = 0; tree_elem < num_tree_elems; tree_elem++, ielem++) {
+      element = t8_forest_get_element_in_tree (forest, itree, tree_elem);
+      level = ts->t8_element_level (element);
+      if (level >= ts->t8_element_maxlevel ()) {
+        continue;
+      }
+      offset = lnodes->element_offsets[ielem];
+      for (iedge = 0; iedge < info->num_edges; iedge++) {
+        cand = cands + num_cands++;
+        for (icorner = 0; icorner < 2; icorner++) {
+          corner_coords[icorner][0] = corner_coords[icorner][1] =
+            corner_coords[icorner][2] = 0;
+          ts->t8_element_vertex_coords (element,
+                                        info->edges[iedge][icorner],
+                                        corner_coords[icorner]);
+          cand->nodes[icorner] =
+            node_gids[element_nodes[offset + info->edges[iedge][icorner]]];
+        }
+        for (i = 0; i < 3; i++) {
+          coords[i] = (corner_coords[0][i] + corner_coords[1][i]) / 2;
+        }
+        cand->num_nodes = 2;
+        cand->nodes[2] = cand->nodes[3] = -1;
+        t8_forest_lnodes_key (info, tree_vertices, gtree, coords,
+                              &cand->key);
+      }
+      for (iface = 0; iface < info->num_quad_faces; iface++) {
+        cand = cands + num_cands++;
+        coords[0] = coords[1] = coords[2] = 0;
+        for (icorner = 0; icorner < 4; icorner++) {
+          corner_coords[icorner][0] = corner_coords[icorner][1] =
+            corner_coords[icorner][2] = 0;
+          ts->t8_element_vertex_coords (element,
+                                        info->quad_faces[iface][icorner],
+                                        corner_coords[icorner]);
+          cand->nodes[icorner] =
+            node_gids[element_nodes
+                      [offset + info->quad_faces[iface][icorner]]];
+          for (i = 0; i < 3; i++) {
+            coords[i] += corner_coords[icorner][i];
+          }
+        }
+        for (i = 0; i < 3; i++) {
+          T8_ASSERT (coords[i] % 4 == 0);
+          coords[i] /= 4;
+        }
+        cand->num_nodes = 4;
+        t8_forest_lnodes_key (info, tree_vertices, gtree, coords,
+                              &cand->key);
+      }
+    }
+  }
+
+  /* Remove duplicate midpoints and send them to the deciding processes */
+  qsort (cands, num_cands, sizeof (t8_lnodes_constraint_t),
+         t8_forest_lnodes_constraint_compare);
+  ipos = 0;
+  for (ientry = 0; ientry < num_cands; ientry++) {
+    if (ipos == 0 ||
+        t8_forest_lnodes_key_compare (&cands[ientry].key,
+                                      &cands[ipos - 1].key) != 0) {
+      cands[ipos++] = cands[ientry];
+    }
+  }
+  num_cands = ipos;
+  cand_counts = T8_ALLOC_ZERO (int, mpisize);
+  cand_recv_counts = T8_ALLOC (int, mpisize);
+  cand_offsets = T8_ALLOC (size_t, mpisize + 1);
+  cand_recv_offsets = T8_ALLOC (size_t, mpisize + 1);
+  for (ientry = 0; ientry < num_cands; ientry++) {
+    cand_counts[t8_forest_lnodes_key_rank (&cands[ientry].key, mpisize)]++;
+  }
+  t8_forest_lnodes_counts (comm, mpisize, cand_counts, cand_recv_counts,
+                           cand_offsets, cand_recv_offsets);
+  num_cand_recv = cand_recv_offsets[mpisize];
+  recv_cands = T8_ALLOC (t8_lnodes_constraint_t, num_cands);
+  positions = T8_ALLOC (size_t, mpisize);
+  memcpy (positions, cand_offsets, mpisize * sizeof (size_t));
+  for (ientry = 0; ientry < num_cands; ientry++) {
+    iproc = t8_forest_lnodes_key_rank (&cands[ientry].key, mpisize);
+    recv_cands[positions[iproc]++] = cands[ientry];
+  }
+  T8_FREE (positions);
+  T8_FREE (cands);
+  cands = recv_cands;
+  recv_cands = T8_ALLOC (t8_lnodes_constraint_t, num_cand_recv);
+  t8_forest_lnodes_exchange (comm, mpirank, mpisize,
+                             sizeof (t8_lnodes_constraint_t), cands,
+                             cand_counts, cand_offsets, recv_cands,
+                             cand_recv_counts, cand_recv_offsets);
+  T8_FREE (cands);
+  T8_FREE (cand_counts);
+  T8_FREE (cand_recv_counts);
+  T8_FREE (cand_offsets);
+  T8_FREE (cand_recv_offsets);
+
+  /* A midpoint that is a node is a hanging node */
+  group_cons = T8_ALLOC_ZERO (t8_gloidx_t, 5 * num_groups);
+  for (ientry = 0; ientry < num_cand_recv; ientry++) {
+    low = 0;
+    high = num_groups;
+    while (low < high) {
+      ipos = low + (high - low) / 2;
+      if (t8_forest_lnodes_key_compare (group_keys + ipos,
+                                        &recv_cands[ientry].key) < 0) {
+        low = ipos + 1;
+      }
+      else {
+        high = ipos;
+      }
+    }
+    if (low < num_groups &&
+        t8_forest_lnodes_key_compare (group_keys + low,
+                                      &recv_cands[ientry].key) == 0) {
+      memcpy (group_cons + 5 * low, &recv_cands[ientry].num_nodes,
+              5 * sizeof (t8_gloidx_t));
+    }
+  }
+  T8_FREE (recv_cands);
+  T8_FREE (group_keys);
+  recv_cons = T8_ALLOC (t8_gloidx_t, 5 * num_recv);
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    memcpy (recv_cons + 5 * ientry, group_cons + 5 * recv_groups[ientry],
+            5 * sizeof (t8_gloidx_t));
+  }
+  T8_FREE (group_cons);
+  T8_FREE (recv_groups);
+  send_cons = T8_ALLOC (t8_gloidx_t, 5 * num_send);
+  t8_forest_lnodes_exchange (comm, mpirank, mpisize, 5 * sizeof (t8_gloidx_t),
+                             recv_cons, recv_counts, recv_offsets,
+                             send_cons, send_counts, send_offsets);
+  T8_FREE (recv_cons);
+  node_cons = T8_ALLOC (t8_gloidx_t, 5 * num_nodes);
+  for (ientry = 0; ientry < num_send; ientry++) {
+    memcpy (node_cons + 5 * send_nodes[ientry], send_cons + 5 * ientry,
+            5 * sizeof (t8_gloidx_t));
+  }
+  T8_FREE (send_cons);
+  T8_FREE (send_nodes);
+  T8_FREE (send_counts);
+  T8_FREE (recv_counts);
+  T8_FREE (send_offsets);
+  T8_FREE (recv_offsets);
+
+  /* Order the local nodes: The owned nodes first, then the others by
+   * their global number */
+  new_lnode = T8_ALLOC (t8_locidx_t, num_nodes);
+  num_nonlocal = num_nodes - lnodes->owned_count;
+  nonlocal = T8_ALLOC (t8_lnodes_nonlocal_t, num_nonlocal);
+  num_nonlocal = 0;
+  for (inode = 0; inode < num_nodes; inode++) {
+    if (node_ranks[inode] == mpirank) {
+      new_lnode[inode] =
+        (t8_locidx_t) (node_gids[inode] - lnodes->global_offset);
+    }
+    else {
+      nonlocal[num_nonlocal].gid = node_gids[inode];
+      nonlocal[num_nonlocal++].lnode = inode;
+    }
+  }
+  qsort (nonlocal, num_nonlocal, sizeof (t8_lnodes_nonlocal_t),
+         t8_forest_lnodes_nonlocal_compare);
+  lnodes->num_local_nodes = num_nodes;
+  lnodes->nonlocal_nodes = T8_ALLOC (t8_gloidx_t, num_nonlocal);
+  lnodes->nonlocal_ranks = T8_ALLOC (int, num_nonlocal);
+  for (inode = 0; inode < num_nonlocal; inode++) {
+    new_lnode[nonlocal[inode].lnode] = lnodes->owned_count + inode;
+    lnodes->nonlocal_nodes[inode] = nonlocal[inode].gid;
+    lnodes->nonlocal_ranks[inode] = node_ranks[nonlocal[inode].lnode];
+  }
+  T8_FREE (nonlocal);
+  T8_FREE (node_ranks);
+  T8_FREE (node_gids);
+  for (ientry = 0; ientry < num_corners; ientry++) {
+    element_nodes[ientry] = new_lnode[element_nodes[ientry]];
+  }
+  lnodes->element_nodes = element_nodes;
+
+  /* Store the constraints of the hanging nodes */
+  lnodes->constraint_offsets = T8_ALLOC_ZERO (t8_locidx_t, num_nodes + 1);
+  for (inode = 0; inode < num_nodes; inode++) {
+    lnodes->constraint_offsets[new_lnode[inode] + 1] =
+      (t8_locidx_t) node_cons[5 * inode];
+  }
+  for (inode = 0; inode < num_nodes; inode++) {
+    lnodes->constraint_offsets[inode + 1] +=
+      lnodes->constraint_offsets[inode];
+  }
+  lnodes->constraint_nodes =
+    T8_ALLOC (t8_gloidx_t, lnodes->constraint_offsets[num_nodes]);
+  for (inode = 0; inode < num_nodes; inode++) {
+    memcpy (lnodes->constraint_nodes +
+            lnodes->constraint_offsets[new_lnode[inode]],
+            node_cons + 5 * inode + 1,
+            node_cons[5 * inode] * sizeof (t8_gloidx_t));
+  }
+  T8_FREE (node_cons);
+  T8_FREE (new_lnode);
+  return lnodes;
+}
+
+void
+t8_forest_lnodes_destroy (t8_forest_lnodes_t ** plnodes)
+{
+  t8_forest_lnodes_t *lnodes;
+
+  T8_ASSERT (plnodes != NULL && *plnodes != NULL);
+  lnodes = *plnodes;
+  T8_FREE (lnodes->element_offsets);
+  T8_FREE (lnodes->element_nodes);
+  T8_FREE (lnodes->nonlocal_nodes);
+  T8_FREE (lnodes->nonlocal_ranks);
+  T8_FREE (lnodes->constraint_offsets);
+  T8_FREE (lnodes->constraint_nodes);
+  T8_FREE (lnodes);
+  *plnodes = NULL;
+}
+
+t8_gloidx_t
+t8_forest_lnodes_global_index (const t8_forest_lnodes_t * lnodes,
+                               t8_locidx_t lnode)
+{
+  T8_ASSERT (0 <= lnode && lnode < lnodes->num_local_nodes);
+  if (lnode < lnodes->owned_count) {
+    return lnodes->global_offset + lnode;
+  }
+  return lnodes->nonlocal_nodes[lnode - lnodes->owned_count];
+}
+
+int
+t8_forest_lnodes_is_hanging (const t8_forest_lnodes_t * lnodes,
+                             t8_locidx_t lnode)
+{
+  T8_ASSERT (0 <= lnode && lnode < lnodes->num_local_nodes);
+  return lnodes->constraint_offsets[lnode + 1] -
+    lnodes->constraint_offsets[lnode];
+}
+
+T8_EXTERN_C_END ();
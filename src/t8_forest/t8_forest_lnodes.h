@@ -0,0 +1,117 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_lnodes.h
+ * A globally unique and parallel consistent numbering of the vertices of
+ * the elements of a forest, as needed for continuous linear finite elements.
+ *
+ * Each corner of a local element is a node. Nodes that are shared between
+ * elements, trees and processes get the same number everywhere. Each node is
+ * owned by the smallest process that has an element touching it, and the
+ * owned nodes of a process are numbered consecutively.
+ * A node that lies inside an edge or a face of a coarser element is a
+ * hanging node. Its value is the mean of the values at the corners of this
+ * edge or face, which are stored as its constraint.
+ *
+ * On the tree boundaries nodes are identified by the coordinates of the tree
+ * vertices, which must coincide exactly for trees that share a vertex.
+ * Trees that are periodically connected to themselves are not identified.
+ * Pyramids are not supported.
+ */
+
+#ifndef T8_FOREST_LNODES_H
+#define T8_FOREST_LNODES_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** The node numbering of a forest. */
+typedef struct
+{
+  sc_MPI_Comm         mpicomm;            /**< The communicator of the forest. */
+  t8_locidx_t         num_local_elements; /**< The number of local elements. */
+  t8_locidx_t         num_local_nodes;    /**< The number of nodes of the local elements. */
+  t8_locidx_t         owned_count;        /**< The number of nodes owned by this process.
+                                               These are the first local nodes. */
+  t8_gloidx_t         global_offset;      /**< The global number of the first owned node. */
+  t8_gloidx_t         num_global_nodes;   /**< The number of nodes of all processes. */
+  t8_locidx_t        *element_offsets;    /**< The corners of local element i are the entries
+                                               element_offsets[i], ...,
+                                               element_offsets[i + 1] - 1
+                                               of \a element_nodes.
+                                               Has num_local_elements + 1 entries. */
+  t8_locidx_t        *element_nodes;      /**< The local node of each corner of each
+                                               local element, ordered as the corners
+                                               of the element. */
+  t8_gloidx_t        *nonlocal_nodes;     /**< The global numbers of the local nodes that
+                                               are not owned, in ascending order.
+                                               Local node owned_count + i has the global number
+                                               nonlocal_nodes[i]. */
+  int                *nonlocal_ranks;     /**< The owner process of each non-owned node. */
+  t8_locidx_t        *constraint_offsets; /**< The nodes constraining local node i are the entries
+                                               constraint_offsets[i], ...,
+                                               constraint_offsets[i + 1] - 1
+                                               of \a constraint_nodes. The constraint of a
+                                               node that is not hanging is empty.
+                                               Has num_local_nodes + 1 entries. */
+  t8_gloidx_t        *constraint_nodes;   /**< The global numbers of the 2 or 4 nodes
+                                               whose mean is the value of a hanging node. */
+} t8_forest_lnodes_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Number the nodes of a forest.
+ * \param [in] forest   A committed forest. It does not need a ghost layer
+ *                      and does not need to be balanced. If it is not
+ *                      balanced, the nodes in a constraint may be hanging
+ *                      nodes themselves.
+ * \return              The node numbering of \a forest. Destroy it with
+ *                      \ref t8_forest_lnodes_destroy.
+ * \note This function is collective.
+ */
+t8_forest_lnodes_t *t8_forest_lnodes_new (t8_forest_t forest);
+
+/** Free the memory of a node numbering.
+ * \param [in,out] plnodes  A node numbering, set to NULL on output.
+ */
+void                t8_forest_lnodes_destroy (t8_forest_lnodes_t ** plnodes);
+
+/** Return the global number of a local node.
+ * \param [in] lnodes   A node numbering.
+ * \param [in] lnode    A local node, 0 <= \a lnode < num_local_nodes.
+ * \return              The global number of \a lnode.
+ */
+t8_gloidx_t         t8_forest_lnodes_global_index (const t8_forest_lnodes_t *
+                                                   lnodes, t8_locidx_t lnode);
+
+/** Query whether a local node is hanging.
+ * \param [in] lnodes   A node numbering.
+ * \param [in] lnode    A local node, 0 <= \a lnode < num_local_nodes.
+ * \return              The number of nodes that \a lnode is constrained by,
+ *                      0 if it is not hanging.
+ */
+int                 t8_forest_lnodes_is_hanging (const t8_forest_lnodes_t *
+                                                 lnodes, t8_locidx_t lnode);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_LNODES_H */
@@ -0,0 +1,912 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_locate.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_element_cxx.hxx>
+#include <t8_vec.h>
+
+/* The maximum number of corners of an element */
+#define T8_LOCATE_MAX_CORNERS 8
+
+/* The maximum number of Newton iterations to compute reference coordinates */
+#define T8_LOCATE_NEWTON_MAX_ITER 20
+
+/* The user data of the local search in t8_forest_locate_points */
+typedef struct
+{
+  t8_forest_point_owner_t *results;     /* For each query its location */
+  double              tolerance;        /* The tolerance of the inside test */
+  t8_locidx_t         ltreeid;  /* The tree of the current element */
+  const double       *tree_vertices;    /* The vertices of this tree */
+  int                 num_corners;      /* The number of corners of the current element */
+  double              corners[T8_LOCATE_MAX_CORNERS][3];        /* Its corner coordinates */
+  double              box[6];   /* Its bounding box */
+} t8_forest_locate_data_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/* Compute the coordinates of the corners of an element and return their
+ * number. Returns 0 for pyramids, which are not supported. */
+static int
+t8_forest_locate_element_corners (t8_forest_t forest, t8_locidx_t ltreeid,
+                                  const t8_element_t * element,
+                                  const double *tree_vertices,
+                                  double corners[][3])
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  int                 num_corners, icorner;
+
+  T8_ASSERT (tree_vertices != NULL);
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  if (eclass == T8_ECLASS_PYRAMID) {
+    return 0;
+  }
+  if (eclass == T8_ECLASS_VERTEX) {
+    /* The only corner of a vertex is the tree vertex */
+    for (icorner = 0; icorner < 3; icorner++) {
+      corners[0][icorner] = tree_vertices[icorner];
+    }
+    return 1;
+  }
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  num_corners = ts->t8_element_num_corners (element);
+  T8_ASSERT (num_corners <= T8_LOCATE_MAX_CORNERS);
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    t8_forest_element_coordinate (forest, ltreeid, element, tree_vertices,
+                                  icorner, corners[icorner]);
+  }
+  return num_corners;
+}
+
+/* Compute the axis aligned bounding box of the corners of an element.
+ * box stores the minimum coordinates followed by the maximum coordinates. */
+static void
+t8_forest_locate_corners_box (double corners[][3], int num_corners,
+                              double box[6])
+{
+  int                 icorner, idim;
+
+  T8_ASSERT (num_corners > 0);
+  for (idim = 0; idim < 3; idim++) {
+    box[idim] = box[3 + idim] = corners[0][idim];
+  }
+  for (icorner = 1; icorner < num_corners; icorner++) {
+    for (idim = 0; idim < 3; idim++) {
+      box[idim] = SC_MIN (box[idim], corners[icorner][idim]);
+      box[3 + idim] = SC_MAX (box[3 + idim], corners[icorner][idim]);
+    }
+  }
+}
+
+/* Return true if a point lies in a bounding box enlarged by tolerance.
+ * An empty box, with a minimum larger than the maximum, contains no points. */
+static int
+t8_forest_locate_box_contains (const double box[6], const double point[3],
+                               double tolerance)
+{
+  int                 idim;
+
+  for (idim = 0; idim < 3; idim++) {
+    if (point[idim] < box[idim] - tolerance
+        || point[idim] > box[3 + idim] + tolerance) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Solve the normal equations gram x = rhs of dim vectors with the lengths
+ * length by Gaussian elimination with partial pivoting. On output rhs
+ * stores the solution. Returns false if the vectors are linearly dependent. */
+static int
+t8_forest_locate_solve (double gram[3][3], double rhs[3],
+                        const double length[3], int dim)
+{
+  double              factor;
+  int                 i, j, k, pivot;
+
+  for (k = 0; k < dim; k++) {
+    pivot = k;
+    for (i = k + 1; i < dim; i++) {
+      if (fabs (gram[i][k]) > fabs (gram[pivot][k])) {
+        pivot = i;
+      }
+    }
+    if (fabs (gram[pivot][k]) <= 1e-14 * length[k] * length[k]) {
+      return 0;
+    }
+    if (pivot != k) {
+      for (j = 0; j < dim; j++) {
+        factor = gram[k][j];
+        gram[k][j] = gram[pivot][j];
+        gram[pivot][j] = factor;
+      }
+      factor = rhs[k];
+      rhs[k] = rhs[pivot];
+      rhs[pivot] = factor;
+    }
+    for (i = k + 1; i < dim; i++) {
+      factor = gram[i][k] / gram[k][k];
+      for (j = k; j < dim; j++) {
+        gram[i][j] -= factor * gram[k][j];
+      }
+      rhs[i] -= factor * rhs[k];
+    }
+  }
+  for (k = dim - 1; k >= 0; k--) {
+    for (j = k + 1; j < dim; j++) {
+      rhs[k] -= gram[k][j] * rhs[j];
+    }
+    rhs[k] /= gram[k][k];
+  }
+  return 1;
+}
+
+/* Return true if a point lies inside the simplex of dimension dim whose
+ * vertices are the corners with the indices vertex_ids.
+ * We compute the barycentric coordinates of the orthogonal projection of
+ * the point onto the affine hull of the simplex and its distance to it. */
+static int
+t8_forest_locate_simplex_inside (double corners[][3], const int *vertex_ids,
+                                 int dim, const double point[3],
+                                 double tolerance)
+{
+  double              edges[3][3], gram[3][3], lambda[3];
+  double              diff[3], length[3], sum, max;
+  int                 i, j;
+
+  T8_ASSERT (1 <= dim && dim <= 3);
+  for (j = 0; j < 3; j++) {
+    diff[j] = point[j] - corners[vertex_ids[0]][j];
+  }
+  for (i = 0; i < dim; i++) {
+    for (j = 0; j < 3; j++) {
+      edges[i][j] = corners[vertex_ids[i + 1]][j] - corners[vertex_ids[0]][j];
+    }
+    length[i] = t8_vec_norm (edges[i]);
+    if (length[i] == 0) {
+      /* The simplex is degenerated */
+      return 0;
+    }
+  }
+  /* Set up the normal equations of the projection */
+  for (i = 0; i < dim; i++) {
+    for (j = 0; j < dim; j++) {
+      gram[i][j] = t8_vec_dot (edges[i], edges[j]);
+    }
+    lambda[i] = t8_vec_dot (edges[i], diff);
+  }
+  if (!t8_forest_locate_solve (gram, lambda, length, dim)) {
+    /* The simplex is degenerated */
+    return 0;
+  }
+  /* Check the barycentric coordinates. A coordinate of -t moves the point
+   * by t times the length of the corresponding edge outside of the simplex. */
+  sum = 0;
+  max = 0;
+  for (i = 0; i < dim; i++) {
+    if (lambda[i] * length[i] < -tolerance) {
+      return 0;
+    }
+    sum += lambda[i];
+    max = SC_MAX (max, length[i]);
+  }
+  if ((sum - 1) * max > tolerance) {
+    return 0;
+  }
+  /* Check the distance of the point to the affine hull of the simplex */
+  for (i = 0; i < dim; i++) {
+    t8_vec_axpy (edges[i], diff, -lambda[i]);
+  }
+  return t8_vec_norm (diff) <= tolerance;
+}
+
+/* The reference coordinates of the center of each element class, a
+ * starting point for the Newton iteration */
+static const double t8_forest_locate_center[T8_ECLASS_COUNT][3] = {
+  {0, 0, 0},                    /* vertex */
+  {0.5, 0, 0},                  /* line */
+  {0.5, 0.5, 0},                /* quad */
+  {2. / 3, 1. / 3, 0},          /* triangle */
+  {0.5, 0.5, 0.5},              /* hex */
+  {0.75, 0.25, 0.5},            /* tet */
+  {2. / 3, 1. / 3, 0.5},        /* prism */
+  {0, 0, 0}                     /* pyramid */
+};
+
+/* Evaluate the map from the reference element to an element given by its
+ * corners at ref, in the parametrization of t8_forest_element_coordinate.
+ * On output x is the image of ref and jacobian[j] is the derivative with
+ * respect to ref[j]. */
+static void
+t8_forest_locate_element_map (t8_eclass_t eclass, double corners[][3],
+                              const double ref[3], double x[3],
+                              double jacobian[3][3])
+{
+  const double        u = ref[0], v = ref[1], w = ref[2];
+  double              tri[3], edge[3];
+  int                 i, k;
+
+  for (i = 0; i < 3; i++) {
+    jacobian[0][i] = jacobian[1][i] = jacobian[2][i] = 0;
+    switch (eclass) {
+    case T8_ECLASS_VERTEX:
+      x[i] = corners[0][i];
+      break;
+    case T8_ECLASS_LINE:
+      jacobian[0][i] = corners[1][i] - corners[0][i];
+      x[i] = corners[0][i] + u * jacobian[0][i];
+      break;
+    case T8_ECLASS_TRIANGLE:
+      jacobian[0][i] = corners[1][i] - corners[0][i];
+      jacobian[1][i] = corners[2][i] - corners[1][i];
+      x[i] = corners[0][i] + u * jacobian[0][i] + v * jacobian[1][i];
+      break;
+    case T8_ECLASS_TET:
+      jacobian[0][i] = corners[1][i] - corners[0][i];
+      jacobian[1][i] = corners[3][i] - corners[2][i];
+      jacobian[2][i] = corners[2][i] - corners[1][i];
+      x[i] = corners[0][i] + u * jacobian[0][i] + v * jacobian[1][i]
+        + w * jacobian[2][i];
+      break;
+    case T8_ECLASS_QUAD:
+      jacobian[0][i] = (1 - v) * (corners[1][i] - corners[0][i])
+        + v * (corners[3][i] - corners[2][i]);
+      jacobian[1][i] = (1 - u) * (corners[2][i] - corners[0][i])
+        + u * (corners[3][i] - corners[1][i]);
+      x[i] = (1 - v) * ((1 - u) * corners[0][i] + u * corners[1][i])
+        + v * ((1 - u) * corners[2][i] + u * corners[3][i]);
+      break;
+    case T8_ECLASS_HEX:
+      jacobian[0][i] =
+        (1 - v) * (1 - w) * (corners[1][i] - corners[0][i])
+        + v * (1 - w) * (corners[3][i] - corners[2][i])
+        + (1 - v) * w * (corners[5][i] - corners[4][i])
+        + v * w * (corners[7][i] - corners[6][i]);
+      jacobian[1][i] =
+        (1 - u) * (1 - w) * (corners[2][i] - corners[0][i])
+        + u * (1 - w) * (corners[3][i] - corners[1][i])
+        + (1 - u) * w * (corners[6][i] - corners[4][i])
+        + u * w * (corners[7][i] - corners[5][i]);
+      jacobian[2][i] =
+        (1 - u) * (1 - v) * (corners[4][i] - corners[0][i])
+        + u * (1 - v) * (corners[5][i] - corners[1][i])
+        + (1 - u) * v * (corners[6][i] - corners[2][i])
+        + u * v * (corners[7][i] - corners[3][i]);
+      x[i] = (1 - w) * ((1 - v) * ((1 - u) * corners[0][i]
+                                   + u * corners[1][i])
+                        + v * ((1 - u) * corners[2][i] + u * corners[3][i]))
+        + w * ((1 - v) * ((1 - u) * corners[4][i] + u * corners[5][i])
+               + v * ((1 - u) * corners[6][i] + u * corners[7][i]));
+      break;
+    case T8_ECLASS_PRISM:
+      /* Interpolate the triangle at height w, then within it */
+      for (k = 0; k < 3; k++) {
+        edge[k] = corners[k + 3][i] - corners[k][i];
+        tri[k] = corners[k][i] + w * edge[k];
+      }
+      jacobian[0][i] = tri[1] - tri[0];
+      jacobian[1][i] = tri[2] - tri[1];
+      jacobian[2][i] = edge[0] + u * (edge[1] - edge[0])
+        + v * (edge[2] - edge[1]);
+      x[i] = tri[0] + u * jacobian[0][i] + v * jacobian[1][i];
+      break;
+    default:
+      SC_ABORT_NOT_REACHED ();
+    }
+  }
+}
+
+/* Compute the reference coordinates of a point with respect to an element
+ * given by its corners with Gauss-Newton iterations starting at ref.
+ * If the element has a lower dimension than 3, these are the reference
+ * coordinates of the orthogonal projection of the point onto the element.
+ * For lines, triangles and tets the map is affine and the first iteration
+ * is exact. Returns true if the iteration converged. */
+static int
+t8_forest_locate_newton (t8_eclass_t eclass, double corners[][3],
+                         const double point[3], double ref[3])
+{
+  double              x[3], jacobian[3][3], gram[3][3], step[3], diff[3];
+  double              length[3], max_step;
+  int                 dim, iter, i, j;
+
+  dim = t8_eclass_to_dimension[eclass];
+  for (iter = 0; iter < T8_LOCATE_NEWTON_MAX_ITER; iter++) {
+    t8_forest_locate_element_map (eclass, corners, ref, x, jacobian);
+    for (i = 0; i < 3; i++) {
+      diff[i] = point[i] - x[i];
+    }
+    for (i = 0; i < dim; i++) {
+      length[i] = t8_vec_norm (jacobian[i]);
+      for (j = 0; j < dim; j++) {
+        gram[i][j] = t8_vec_dot (jacobian[i], jacobian[j]);
+      }
+      step[i] = t8_vec_dot (jacobian[i], diff);
+    }
+    if (!t8_forest_locate_solve (gram, step, length, dim)) {
+      /* The Jacobian is singular */
+      return 0;
+    }
+    max_step = 0;
+    for (i = 0; i < dim; i++) {
+      ref[i] += step[i];
+      max_step = SC_MAX (max_step, fabs (step[i]));
+    }
+    if (eclass == T8_ECLASS_LINE || eclass == T8_ECLASS_TRIANGLE
+        || eclass == T8_ECLASS_TET || max_step < 1e-12) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Return true if a point lies inside a quad, hex or prism given by its
+ * corners, -1 if its reference coordinates could not be computed.
+ * We move the reference coordinates of the point into the reference
+ * element and compare the distance of their image to the point with
+ * the tolerance. ref is the starting point of the Newton iteration and
+ * on output the reference coordinates of the point. */
+static int
+t8_forest_locate_newton_inside (t8_eclass_t eclass, double corners[][3],
+                                const double point[3], double tolerance,
+                                double ref[3])
+{
+  double              clamped[3], x[3], jacobian[3][3];
+  int                 i;
+
+  T8_ASSERT (eclass == T8_ECLASS_QUAD || eclass == T8_ECLASS_HEX
+             || eclass == T8_ECLASS_PRISM);
+  if (!t8_forest_locate_newton (eclass, corners, point, ref)) {
+    return -1;
+  }
+  for (i = 0; i < 3; i++) {
+    clamped[i] = SC_MAX (0, SC_MIN (1, ref[i]));
+  }
+  if (eclass == T8_ECLASS_PRISM) {
+    /* The reference triangle is 0 <= ref[1] <= ref[0] <= 1 */
+    clamped[1] = SC_MIN (clamped[1], clamped[0]);
+  }
+  t8_forest_locate_element_map (eclass, corners, clamped, x, jacobian);
+  return t8_vec_dist (x, point) <= tolerance;
+}
+
+/* Return true if a point lies inside an element given by its corners.
+ * Simplices are tested with their barycentric coordinates, quads, hexes and
+ * prisms with the reference coordinates of the point. If these cannot be
+ * computed, the element is split into simplices.
+ * If ref is not NULL, it is the starting point for the reference coordinates
+ * and stores them on output for quads, hexes and prisms. */
+static int
+t8_forest_locate_corners_inside (t8_eclass_t eclass, double corners[][3],
+                                 const double point[3], double tolerance,
+                                 double *ref)
+{
+  /* The simplices of the elements that are not simplices, in z-order
+   * corner numbers */
+  static const int    quad_tris[2][3] = { {0, 1, 3}, {0, 3, 2} };
+  static const int    hex_tets[6][4] = {
+    {0, 1, 3, 7}, {0, 1, 5, 7}, {0, 2, 3, 7},
+    {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}
+  };
+  static const int    prism_tets[3][4] = {
+    {0, 1, 2, 5}, {0, 1, 4, 5}, {0, 3, 4, 5}
+  };
+  static const int    simplex_ids[4] = { 0, 1, 2, 3 };
+  double              center[3];
+  int                 isimplex, is_inside;
+
+  if (eclass == T8_ECLASS_QUAD || eclass == T8_ECLASS_HEX
+      || eclass == T8_ECLASS_PRISM) {
+    if (ref == NULL) {
+      for (isimplex = 0; isimplex < 3; isimplex++) {
+        center[isimplex] = t8_forest_locate_center[eclass][isimplex];
+      }
+      ref = center;
+    }
+    is_inside = t8_forest_locate_newton_inside (eclass, corners, point,
+                                                tolerance, ref);
+    if (is_inside >= 0) {
+      return is_inside;
+    }
+  }
+  switch (eclass) {
+  case T8_ECLASS_VERTEX:
+    return t8_vec_dist (corners[0], point) <= tolerance;
+  case T8_ECLASS_LINE:
+  case T8_ECLASS_TRIANGLE:
+  case T8_ECLASS_TET:
+    return t8_forest_locate_simplex_inside (corners, simplex_ids,
+                                            t8_eclass_to_dimension[eclass],
+                                            point, tolerance);
+  case T8_ECLASS_QUAD:
+    for (isimplex = 0; isimplex < 2; isimplex++) {
+      if (t8_forest_locate_simplex_inside (corners, quad_tris[isimplex], 2,
+                                           point, tolerance)) {
+        return 1;
+      }
+    }
+    return 0;
+  case T8_ECLASS_HEX:
+    for (isimplex = 0; isimplex < 6; isimplex++) {
+      if (t8_forest_locate_simplex_inside (corners, hex_tets[isimplex], 3,
+                                           point, tolerance)) {
+        return 1;
+      }
+    }
+    return 0;
+  case T8_ECLASS_PRISM:
+    for (isimplex = 0; isimplex < 3; isimplex++) {
+      if (t8_forest_locate_simplex_inside (corners, prism_tets[isimplex], 3,
+                                           point, tolerance)) {
+        return 1;
+      }
+    }
+    return 0;
+  default:
+    /* Pyramids are not supported */
+    return 0;
+  }
+}
+
+int
+t8_forest_element_point_inside (t8_forest_t forest, t8_locidx_t ltreeid,
+                                const t8_element_t * element,
+                                const double point[3], double tolerance)
+{
+  double              corners[T8_LOCATE_MAX_CORNERS][3];
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  if (t8_forest_locate_element_corners (forest, ltreeid, element,
+                                        t8_forest_get_tree_vertices (forest,
+                                                                     ltreeid),
+                                        corners) == 0) {
+    return 0;
+  }
+  return t8_forest_locate_corners_inside (t8_forest_get_tree_class
+                                          (forest, ltreeid), corners, point,
+                                          tolerance, NULL);
+}
+
+void
+t8_forest_element_point_inside_batch (t8_forest_t forest,
+                                      t8_locidx_t ltreeid,
+                                      const t8_element_t * element,
+                                      const double *points,
+                                      size_t num_points, double tolerance,
+                                      int *is_inside)
+{
+  double              corners[T8_LOCATE_MAX_CORNERS][3], box[6], ref[3];
+  t8_eclass_t         eclass;
+  int                 num_corners, i;
+  size_t              ipoint;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  num_corners =
+    t8_forest_locate_element_corners (forest, ltreeid, element,
+                                      t8_forest_get_tree_vertices (forest,
+                                                                   ltreeid),
+                                      corners);
+  if (num_corners == 0) {
+    for (ipoint = 0; ipoint < num_points; ipoint++) {
+      is_inside[ipoint] = 0;
+    }
+    return;
+  }
+  t8_forest_locate_corners_box (corners, num_corners, box);
+  for (i = 0; i < 3; i++) {
+    ref[i] = t8_forest_locate_center[eclass][i];
+  }
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    if (!t8_forest_locate_box_contains (box, points + 3 * ipoint,
+                                        tolerance)) {
+      is_inside[ipoint] = 0;
+      continue;
+    }
+    /* Nearby points have nearby reference coordinates, thus we start the
+     * Newton iteration at the result of the previous point */
+    is_inside[ipoint] =
+      t8_forest_locate_corners_inside (eclass, corners, points + 3 * ipoint,
+                                       tolerance, ref);
+    for (i = 0; i < 3; i++) {
+      if (!(fabs (ref[i]) < 2)) {
+        /* Restart far away or diverged iterations at the center */
+        ref[0] = t8_forest_locate_center[eclass][0];
+        ref[1] = t8_forest_locate_center[eclass][1];
+        ref[2] = t8_forest_locate_center[eclass][2];
+        break;
+      }
+    }
+  }
+}
+
+int
+t8_forest_element_reference_coords (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    const t8_element_t * element,
+                                    const double point[3], double ref[3])
+{
+  int                 converged;
+
+  t8_forest_element_reference_coords_batch (forest, ltreeid, element, point,
+                                            1, ref, &converged);
+  return converged;
+}
+
+void
+t8_forest_element_reference_coords_batch (t8_forest_t forest,
+                                          t8_locidx_t ltreeid,
+                                          const t8_element_t * element,
+                                          const double *points,
+                                          size_t num_points, double *ref,
+                                          int *converged)
+{
+  double              corners[T8_LOCATE_MAX_CORNERS][3];
+  const double       *start;
+  t8_eclass_t         eclass;
+  int                 i;
+  size_t              ipoint;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  if (t8_forest_locate_element_corners (forest, ltreeid, element,
+                                        t8_forest_get_tree_vertices (forest,
+                                                                     ltreeid),
+                                        corners) == 0) {
+    for (ipoint = 0; ipoint < num_points; ipoint++) {
+      ref[3 * ipoint] = ref[3 * ipoint + 1] = ref[3 * ipoint + 2] = 0;
+      converged[ipoint] = 0;
+    }
+    return;
+  }
+  start = t8_forest_locate_center[eclass];
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    for (i = 0; i < 3; i++) {
+      ref[3 * ipoint + i] = start[i];
+    }
+    if (eclass == T8_ECLASS_VERTEX) {
+      converged[ipoint] = 1;
+      continue;
+    }
+    converged[ipoint] =
+      t8_forest_locate_newton (eclass, corners, points + 3 * ipoint,
+                               ref + 3 * ipoint);
+    /* Start the next point at the result of this one, unless the
+     * iteration failed */
+    start = converged[ipoint] ? ref + 3 * ipoint
+      : t8_forest_locate_center[eclass];
+  }
+}
+
+/* The element callback of the local search. We compute the bounding box
+ * of the element once for all queries and, if it is a leaf, its corners. */
+static int
+t8_forest_locate_element_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                             const t8_element_t * element,
+                             t8_element_array_t * leaf_elements,
+                             void *user_data, t8_locidx_t tree_leaf_index)
+{
+  t8_forest_locate_data_t *data = (t8_forest_locate_data_t *) user_data;
+
+  if (data->ltreeid != ltreeid) {
+    data->ltreeid = ltreeid;
+    data->tree_vertices = t8_forest_get_tree_vertices (forest, ltreeid);
+  }
+  if (t8_forest_get_tree_class (forest, ltreeid) == T8_ECLASS_PYRAMID) {
+    /* We cannot locate points in this tree */
+    return 0;
+  }
+  if (tree_leaf_index < 0) {
+    /* The queries are only pruned with the box, which we compute
+     * without the corners */
+    t8_forest_element_bounding_box (forest, ltreeid, element,
+                                    data->tree_vertices, data->box);
+    return 1;
+  }
+  data->num_corners =
+    t8_forest_locate_element_corners (forest, ltreeid, element,
+                                      data->tree_vertices, data->corners);
+  if (data->num_corners == 0) {
+    /* We cannot locate points in this tree */
+    return 0;
+  }
+  t8_forest_locate_corners_box (data->corners, data->num_corners, data->box);
+  return 1;
+}
+
+/* The query callback of the local search. Each query is a point. */
+static int
+t8_forest_locate_query_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                           const t8_element_t * element,
+                           t8_element_array_t * leaf_elements,
+                           void *user_data, t8_locidx_t tree_leaf_index,
+                           void *query, size_t query_index)
+{
+  t8_forest_locate_data_t *data = (t8_forest_locate_data_t *) user_data;
+  t8_forest_point_owner_t *result = data->results + query_index;
+  const double       *point = (const double *) query;
+
+  if (result->rank >= 0) {
+    /* The point was already found in a previous element */
+    return 0;
+  }
+  if (!t8_forest_locate_box_contains (data->box, point, data->tolerance)) {
+    return 0;
+  }
+  if (tree_leaf_index < 0) {
+    /* The point may be inside a descendant */
+    return 1;
+  }
+  if (t8_forest_locate_corners_inside (t8_forest_get_tree_class
+                                       (forest, ltreeid), data->corners,
+                                       point, data->tolerance, NULL)) {
+    result->rank = forest->mpirank;
+    result->gtreeid = t8_forest_global_tree_id (forest, ltreeid);
+    result->lelement_id =
+      t8_forest_get_tree_element_offset (forest, ltreeid) + tree_leaf_index;
+    return 1;
+  }
+  return 0;
+}
+
+/* Enlarge box such that it contains other. If is_empty, box is
+ * overwritten with other. */
+static void
+t8_forest_locate_box_union (double box[6], const double other[6],
+                            int is_empty)
+{
+  int                 idim;
+
+  for (idim = 0; idim < 3; idim++) {
+    box[idim] = is_empty ? other[idim] : SC_MIN (box[idim], other[idim]);
+    box[3 + idim] = is_empty ? other[3 + idim]
+      : SC_MAX (box[3 + idim], other[3 + idim]);
+  }
+}
+
+/* Compute the bounding box of all local elements. If the forest has no
+ * local elements, the box is empty.
+ * Only the first and the last local tree can be shared with other
+ * processes. For all other trees we use the cached tree boxes of the cmesh. */
+static void
+t8_forest_locate_partition_box (t8_forest_t forest, double box[6])
+{
+  t8_locidx_t         itree, ielem, num_elems, num_trees;
+  const double       *tree_vertices;
+  double              corners[T8_LOCATE_MAX_CORNERS][3], elem_box[6];
+  int                 num_corners, idim, is_empty;
+
+  is_empty = 1;
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    if (num_elems == 0
+        || t8_forest_get_tree_class (forest, itree) == T8_ECLASS_PYRAMID) {
+      continue;
+    }
+    if (0 < itree && itree < num_trees - 1) {
+      /* This tree is not shared, its elements cover it */
+      t8_cmesh_get_tree_bounding_box (forest->cmesh,
+                                      t8_forest_ltreeid_to_cmesh_ltreeid
+                                      (forest, itree), elem_box);
+      t8_forest_locate_box_union (box, elem_box, is_empty);
+      is_empty = 0;
+      continue;
+    }
+    tree_vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      num_corners =
+        t8_forest_locate_element_corners (forest, itree,
+                                          t8_forest_get_element_in_tree
+                                          (forest, itree, ielem),
+                                          tree_vertices, corners);
+      t8_forest_locate_corners_box (corners, num_corners, elem_box);
+      t8_forest_locate_box_union (box, elem_box, is_empty);
+      is_empty = 0;
+    }
+  }
+  if (is_empty) {
+    /* The minimum is larger than the maximum */
+    for (idim = 0; idim < 3; idim++) {
+      box[idim] = 1;
+      box[3 + idim] = 0;
+    }
+  }
+}
+
+/* Post the receives and sends of a sparse exchange in which process p
+ * sends send_counts[p] items of item_size bytes starting at item
+ * send_offsets[p] and receives recv_counts[p] items.
+ * The items to the process itself are copied.
+ * Returns the number of requests posted. */
+static int
+t8_forest_locate_exchange_begin (t8_forest_t forest, size_t item_size,
+                                 char *send_buffer, const int *send_counts,
+                                 const size_t *send_offsets,
+                                 char *recv_buffer, const int *recv_counts,
+                                 const size_t *recv_offsets,
+                                 sc_MPI_Request * requests)
+{
+  int                 iproc, num_requests, mpiret;
+
+  num_requests = 0;
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (iproc != forest->mpirank && recv_counts[iproc] > 0) {
+      mpiret = sc_MPI_Irecv (recv_buffer + recv_offsets[iproc] * item_size,
+                             recv_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, T8_MPI_LOCATE_POINTS, forest->mpicomm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (iproc != forest->mpirank && send_counts[iproc] > 0) {
+      mpiret = sc_MPI_Isend (send_buffer + send_offsets[iproc] * item_size,
+                             send_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, T8_MPI_LOCATE_POINTS, forest->mpicomm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  T8_ASSERT (send_counts[forest->mpirank] == recv_counts[forest->mpirank]);
+  memcpy (recv_buffer + recv_offsets[forest->mpirank] * item_size,
+          send_buffer + send_offsets[forest->mpirank] * item_size,
+          send_counts[forest->mpirank] * item_size);
+  return num_requests;
+}
+
+void
+t8_forest_locate_points (t8_forest_t forest, const double *points,
+                         size_t num_points, double tolerance,
+                         t8_forest_point_owner_t * owners)
+{
+  int                 mpisize, iproc, mpiret, num_requests;
+  int                *send_counts, *recv_counts;
+  size_t             *send_offsets, *recv_offsets, *send_ids, *positions;
+  size_t              ipoint, ientry, num_send, num_recv;
+  double              local_box[6], *boxes, *send_points, *recv_points;
+  t8_forest_point_owner_t *send_results;
+  sc_MPI_Request     *requests;
+  sc_array_t          queries;
+  t8_forest_locate_data_t data;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_points == 0 || (points != NULL && owners != NULL));
+  T8_ASSERT (tolerance >= 0);
+  mpisize = forest->mpisize;
+
+  /* Gather the bounding boxes of all partitions */
+  t8_forest_locate_partition_box (forest, local_box);
+  boxes = T8_ALLOC (double, 6 * mpisize);
+  mpiret = sc_MPI_Allgather (local_box, 6, sc_MPI_DOUBLE, boxes, 6,
+                             sc_MPI_DOUBLE, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Count the points that we send to each process */
+  send_counts = T8_ALLOC_ZERO (int, mpisize);
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      if (t8_forest_locate_box_contains (boxes + 6 * iproc,
+                                         points + 3 * ipoint, tolerance)) {
+        send_counts[iproc]++;
+      }
+    }
+  }
+  recv_counts = T8_ALLOC (int, mpisize);
+  mpiret = sc_MPI_Alltoall (send_counts, 1, sc_MPI_INT, recv_counts, 1,
+                            sc_MPI_INT, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  send_offsets = T8_ALLOC (size_t, mpisize + 1);
+  recv_offsets = T8_ALLOC (size_t, mpisize + 1);
+  send_offsets[0] = recv_offsets[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    send_offsets[iproc + 1] = send_offsets[iproc] + send_counts[iproc];
+    recv_offsets[iproc + 1] = recv_offsets[iproc] + recv_counts[iproc];
+  }
+  num_send = send_offsets[mpisize];
+  num_recv = recv_offsets[mpisize];
+
+  /* Fill the send buffer, ordered by process */
+  send_ids = T8_ALLOC (size_t, num_send);
+  send_points = T8_ALLOC (double, 3 * num_send);
+  positions = T8_ALLOC (size_t, mpisize);
+  memcpy (positions, send_offsets, mpisize * sizeof (size_t));
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      if (t8_forest_locate_box_contains (boxes + 6 * iproc,
+                                         points + 3 * ipoint, tolerance)) {
+        ientry = positions[iproc]++;
+        send_ids[ientry] = ipoint;
+        memcpy (send_points + 3 * ientry, points + 3 * ipoint,
+                3 * sizeof (double));
+      }
+    }
+  }
+  T8_FREE (positions);
+  T8_FREE (boxes);
+
+  /* Send the points to the candidate processes */
+  recv_points = T8_ALLOC (double, 3 * num_recv);
+  requests = T8_ALLOC (sc_MPI_Request, 2 * mpisize);
+  num_requests =
+    t8_forest_locate_exchange_begin (forest, 3 * sizeof (double),
+                                     (char *) send_points, send_counts,
+                                     send_offsets, (char *) recv_points,
+                                     recv_counts, recv_offsets, requests);
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (send_points);
+
+  /* Search the received points in the local elements */
+  data.results = T8_ALLOC (t8_forest_point_owner_t, num_recv);
+  for (ientry = 0; ientry < num_recv; ientry++) {
+    data.results[ientry].rank = -1;
+    data.results[ientry].gtreeid = -1;
+    data.results[ientry].lelement_id = -1;
+  }
+  data.tolerance = tolerance;
+  data.ltreeid = -1;
+  data.tree_vertices = NULL;
+  sc_array_init_data (&queries, recv_points, 3 * sizeof (double), num_recv);
+  /* The element callback stores the current element in data, thus we
+   * cannot search with multiple threads. */
+  t8_forest_search_queries (forest, t8_forest_locate_element_fn,
+                            t8_forest_locate_query_fn, &queries, &data, 1);
+  T8_FREE (recv_points);
+
+  /* Send the results back. We now send what we received before. */
+  send_results = T8_ALLOC (t8_forest_point_owner_t, num_send);
+  num_requests =
+    t8_forest_locate_exchange_begin (forest,
+                                     sizeof (t8_forest_point_owner_t),
+                                     (char *) data.results, recv_counts,
+                                     recv_offsets, (char *) send_results,
+                                     send_counts, send_offsets, requests);
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (data.results);
+  T8_FREE (requests);
+
+  /* Each point gets the result of the lowest process that found it */
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    owners[ipoint].rank = -1;
+    owners[ipoint].gtreeid = -1;
+    owners[ipoint].lelement_id = -1;
+  }
+  for (ientry = 0; ientry < num_send; ientry++) {
+    ipoint = send_ids[ientry];
+    if (owners[ipoint].rank < 0 && send_results[ientry].rank >= 0) {
+      owners[ipoint] = send_results[ientry];
+    }
+  }
+  T8_FREE (send_results);
+  T8_FREE (send_ids);
+  T8_FREE (send_counts);
+  T8_FREE (recv_counts);
+  T8_FREE (send_offsets);
+  T8_FREE (recv_offsets);
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,184 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_locate.h
+ * Find the processes and elements of a forest that contain given points
+ * in physical space.
+ */
+
+#ifndef T8_FOREST_LOCATE_H
+#define T8_FOREST_LOCATE_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** The location of a point in a forest. */
+typedef struct
+{
+  int                 rank;        /**< The process that owns the element containing the point,
+                                        -1 if the point is not inside the forest. */
+  t8_gloidx_t         gtreeid;     /**< The global id of the tree of the element. */
+  t8_locidx_t         lelement_id; /**< The local index of the element on process \a rank. */
+} t8_forest_point_owner_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Test whether a point lies inside an element.
+ * Lines, triangles and tets are tested with the barycentric coordinates of
+ * the point. For quads, hexes and prisms the reference coordinates of the point
+ * are computed as in \ref t8_forest_element_reference_coords, thus the test
+ * is exact for the multilinear interpolation of the element's corners.
+ * Only if the Newton iteration fails for them, the element is split into
+ * simplices.
+ * \param [in] forest     A committed forest.
+ * \param [in] ltreeid    The local tree of \a element.
+ * \param [in] element    An element of the tree \a ltreeid.
+ * \param [in] point      The x, y and z coordinates of the point.
+ * \param [in] tolerance  Points whose distance to the element is smaller
+ *                        than this are considered inside.
+ * \return                True if the point is inside the element.
+ * \note Pyramids are not supported and never contain a point.
+ */
+int                 t8_forest_element_point_inside (t8_forest_t forest,
+                                                    t8_locidx_t ltreeid,
+                                                    const t8_element_t *
+                                                    element,
+                                                    const double point[3],
+                                                    double tolerance);
+
+/** Test for multiple points whether they lie inside an element.
+ * The corners of the element are computed once and points outside of their
+ * bounding box are rejected right away. The Newton iteration for quads, hexes
+ * and prisms starts at the reference coordinates of the previous point, thus
+ * it is fastest if consecutive points are close to each other.
+ * \param [in] forest     A committed forest.
+ * \param [in] ltreeid    The local tree of \a element.
+ * \param [in] element    An element of the tree \a ltreeid.
+ * \param [in] points     An array of 3 * \a num_points doubles, the
+ *                        coordinates of the points.
+ * \param [in] num_points The number of points.
+ * \param [in] tolerance  Points whose distance to the element is smaller
+ *                        than this are considered inside.
+ * \param [out] is_inside An allocated array of \a num_points entries.
+ *                        On output true for each point inside \a element.
+ * \see t8_forest_element_point_inside
+ */
+void                t8_forest_element_point_inside_batch (t8_forest_t
+                                                          forest,
+                                                          t8_locidx_t
+                                                          ltreeid,
+                                                          const t8_element_t
+                                                          * element,
+                                                          const double
+                                                          *points,
+                                                          size_t num_points,
+                                                          double tolerance,
+                                                          int *is_inside);
+
+/** Compute the reference coordinates of a point with respect to an element.
+ * These are the coordinates that the interpolation of the element's corners
+ * maps to the point, in the same parametrization that
+ * \ref t8_forest_element_coordinate uses for the trees: The reference
+ * element is [0,1]^d for lines, quads and hexes,
+ * 0 <= ref[1] <= ref[0] <= 1 for triangles, 0 <= ref[1] <= ref[2] <= ref[0] <= 1
+ * for tets and the triangle times [0,1] for prisms. Corner i of the element
+ * has the coordinates of corner i of the reference element.
+ * For lines, triangles and tets the map is affine and inverted directly.
+ * For quads, hexes and prisms we use a Newton iteration starting at the
+ * center of the element.
+ * If the dimension of the element is smaller than 3, we compute the
+ * reference coordinates of the closest point of the element's plane or line.
+ * \param [in] forest     A committed forest.
+ * \param [in] ltreeid    The local tree of \a element.
+ * \param [in] element    An element of the tree \a ltreeid.
+ * \param [in] point      The x, y and z coordinates of the point.
+ * \param [out] ref       On output the reference coordinates of \a point.
+ *                        Entries beyond the dimension of the element are 0.
+ * \return                True if the coordinates could be computed, false if
+ *                        the iteration did not converge, if the element is
+ *                        degenerated or if it is a pyramid.
+ */
+int                 t8_forest_element_reference_coords (t8_forest_t forest,
+                                                        t8_locidx_t ltreeid,
+                                                        const t8_element_t *
+                                                        element,
+                                                        const double
+                                                        point[3],
+                                                        double ref[3]);
+
+/** Compute the reference coordinates of multiple points with respect to an
+ * element. The corners of the element are computed once and the Newton
+ * iteration for each point starts at the result of the previous point.
+ * \param [in] forest     A committed forest.
+ * \param [in] ltreeid    The local tree of \a element.
+ * \param [in] element    An element of the tree \a ltreeid.
+ * \param [in] points     An array of 3 * \a num_points doubles, the
+ *                        coordinates of the points.
+ * \param [in] num_points The number of points.
+ * \param [out] ref       An allocated array of 3 * \a num_points doubles.
+ *                        On output the reference coordinates of the points.
+ * \param [out] converged An allocated array of \a num_points entries.
+ *                        On output the return value of
+ *                        \ref t8_forest_element_reference_coords for each point.
+ */
+void                t8_forest_element_reference_coords_batch (t8_forest_t
+                                                              forest,
+                                                              t8_locidx_t
+                                                              ltreeid,
+                                                              const
+                                                              t8_element_t *
+                                                              element,
+                                                              const double
+                                                              *points,
+                                                              size_t
+                                                              num_points,
+                                                              double *ref,
+                                                              int
+                                                              *converged);
+
+/** Find the owning processes and elements of points in physical space.
+ * Each process passes its own points. They are sent to the processes whose
+ * bounding boxes contain them, searched there with \ref
+ * t8_forest_search_queries and the results are sent back.
+ * If a point is contained in multiple elements, for example on a common
+ * face, the element on the lowest process and with the lowest tree and
+ * element index is chosen.
+ * This function is collective over the communicator of the forest.
+ * \param [in] forest     A committed forest.
+ * \param [in] points     An array of 3 * \a num_points doubles, the
+ *                        coordinates of the points.
+ * \param [in] num_points The number of points of this process.
+ * \param [in] tolerance  Points whose distance to an element is smaller
+ *                        than this are considered inside.
+ * \param [out] owners    An allocated array of \a num_points entries.
+ *                        On output the location of each point.
+ */
+void                t8_forest_locate_points (t8_forest_t forest,
+                                             const double *points,
+                                             size_t num_points,
+                                             double tolerance,
+                                             t8_forest_point_owner_t *
+                                             owners);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_LOCATE_H! */
@@ -0,0 +1,382 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <typeinfo>
+#include <p4est_bits.h>
+#include <p8est_bits.h>
+#include <p4est_communication.h>
+#include <p8est_communication.h>
+#include <t8_forest/t8_forest_p4est.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_default/t8_default_quad_cxx.hxx>
+#include <t8_default/t8_default_hex_cxx.hxx>
+
+/* The types and functions of p4est that the conversion uses */
+struct t8_forest_p4est_2d
+{
+  typedef p4est_t     p4est_type;
+  typedef p4est_tree_t tree_type;
+  typedef p4est_quadrant_t quadrant_type;
+  typedef p4est_connectivity_t connectivity_type;
+  typedef t8_default_scheme_quad_c scheme_type;
+  static const t8_eclass_t eclass = T8_ECLASS_QUAD;
+  static const int    dim = P4EST_DIM;
+  static const int    qmaxlevel = P4EST_QMAXLEVEL;
+
+  static t8_cmesh_t   new_cmesh (p4est_connectivity_t * conn,
+                                 sc_MPI_Comm comm)
+  {
+    return t8_cmesh_new_from_p4est (conn, comm, 0);
+  }
+  static void         destroy (p4est_t * p4est)
+  {
+    p4est_destroy (p4est);
+  }
+  static void         first_descendant (const p4est_quadrant_t * q,
+                                        p4est_quadrant_t * desc)
+  {
+    p4est_quadrant_first_descendant (q, desc, P4EST_QMAXLEVEL);
+  }
+  static void         last_descendant (const p4est_quadrant_t * q,
+                                       p4est_quadrant_t * desc)
+  {
+    p4est_quadrant_last_descendant (q, desc, P4EST_QMAXLEVEL);
+  }
+  static void         count_quadrants (p4est_t * p4est)
+  {
+    p4est_comm_count_quadrants (p4est);
+  }
+  static void         global_partition (p4est_t * p4est,
+                                        p4est_quadrant_t * first_quad)
+  {
+    p4est_comm_global_partition (p4est, first_quad);
+  }
+  static int          is_valid (p4est_t * p4est)
+  {
+    return p4est_is_valid (p4est);
+  }
+};
+
+/* The types and functions of p8est that the conversion uses */
+struct t8_forest_p4est_3d
+{
+  typedef p8est_t     p4est_type;
+  typedef p8est_tree_t tree_type;
+  typedef p8est_quadrant_t quadrant_type;
+  typedef p8est_connectivity_t connectivity_type;
+  typedef t8_default_scheme_hex_c scheme_type;
+  static const t8_eclass_t eclass = T8_ECLASS_HEX;
+  static const int    dim = P8EST_DIM;
+  static const int    qmaxlevel = P8EST_QMAXLEVEL;
+
+  static t8_cmesh_t   new_cmesh (p8est_connectivity_t * conn,
+                                 sc_MPI_Comm comm)
+  {
+    return t8_cmesh_new_from_p8est (conn, comm, 0);
+  }
+  static void         destroy (p8est_t * p8est)
+  {
+    p8est_destroy (p8est);
+  }
+  static void         first_descendant (const p8est_quadrant_t * q,
+                                        p8est_quadrant_t * desc)
+  {
+    p8est_quadrant_first_descendant (q, desc, P8EST_QMAXLEVEL);
+  }
+  static void         last_descendant (const p8est_quadrant_t * q,
+                                       p8est_quadrant_t * desc)
+  {
+    p8est_quadrant_last_descendant (q, desc, P8EST_QMAXLEVEL);
+  }
+  static void         count_quadrants (p8est_t * p8est)
+  {
+    p8est_comm_count_quadrants (p8est);
+  }
+  static void         global_partition (p8est_t * p8est,
+                                        p8est_quadrant_t * first_quad)
+  {
+    p8est_comm_global_partition (p8est, first_quad);
+  }
+  static int          is_valid (p8est_t * p8est)
+  {
+    return p8est_is_valid (p8est);
+  }
+};
+
+/* Return true if ts is the default scheme of the p4est elements.
+ * Schemes derived from it may use a different order or storage. */
+template < class TP4est > static int
+t8_forest_p4est_scheme_matches (t8_eclass_scheme_c * ts)
+{
+  return ts != NULL
+    && typeid (*ts) == typeid (typename TP4est::scheme_type)
+    && ts->t8_element_size () == sizeof (typename TP4est::quadrant_type);
+}
+
+/* Move the quadrant arrays of the local trees of p4est into the trees of
+ * forest and destroy p4est. */
+template < class TP4est > static void
+t8_forest_p4est_adopt_trees (t8_forest_t forest,
+                             typename TP4est::p4est_type * p4est)
+{
+  typename TP4est::tree_type * ptree;
+  t8_eclass_scheme_c *ts;
+  t8_tree_t           tree;
+  t8_locidx_t         num_trees, itree;
+  size_t              iquad;
+
+  SC_CHECK_ABORT ((t8_gloidx_t) p4est->connectivity->num_trees ==
+                  forest->global_num_trees,
+                  "The cmesh does not match the connectivity of the p4est");
+  ts = forest->scheme_cxx->eclass_schemes[TP4est::eclass];
+  SC_CHECK_ABORT (t8_forest_p4est_scheme_matches < TP4est > (ts),
+                  "The scheme does not store the elements as p4est");
+
+  forest->local_num_elements = p4est->local_num_quadrants;
+  forest->global_num_elements = p4est->global_num_quadrants;
+  if (p4est->local_num_quadrants == 0) {
+    /* This process is empty */
+    forest->first_local_tree = 0;
+    forest->last_local_tree = -1;
+  }
+  else {
+    forest->first_local_tree = p4est->first_local_tree;
+    forest->last_local_tree = p4est->last_local_tree;
+  }
+  num_trees = forest->last_local_tree - forest->first_local_tree + 1;
+  forest->trees = sc_array_new_count (sizeof (t8_tree_struct_t), num_trees);
+  for (itree = 0; itree < num_trees; itree++) {
+    ptree = (typename TP4est::tree_type *)
+      sc_array_index (p4est->trees, forest->first_local_tree + itree);
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    tree->eclass = TP4est::eclass;
+    tree->elements_offset = ptree->quadrants_offset;
+    /* Take over the quadrant array and leave an empty one in its place */
+    tree->elements.scheme = ts;
+    tree->elements.array = ptree->quadrants;
+    sc_array_init (&ptree->quadrants,
+                   sizeof (typename TP4est::quadrant_type));
+    if (TP4est::eclass == T8_ECLASS_QUAD) {
+      /* A default quad stores its surrounding dimension in pad8 */
+      for (iquad = 0; iquad < tree->elements.array.elem_count; iquad++) {
+        T8_QUAD_SET_TDIM ((p4est_quadrant_t *)
+                          sc_array_index (&tree->elements.array, iquad), 2);
+      }
+    }
+  }
+  TP4est::destroy (p4est);
+}
+
+void
+t8_forest_p4est_build_trees (t8_forest_t forest)
+{
+  T8_ASSERT (forest != NULL && !forest->committed);
+  T8_ASSERT (forest->set_p4est != NULL);
+  T8_ASSERT (forest->cmesh != NULL && forest->scheme_cxx != NULL);
+
+  if (forest->set_p4est_dim == 2) {
+    t8_forest_p4est_adopt_trees < t8_forest_p4est_2d > (forest,
+                                                        (p4est_t *)
+                                                        forest->set_p4est);
+  }
+  else {
+    T8_ASSERT (forest->set_p4est_dim == 3);
+    t8_forest_p4est_adopt_trees < t8_forest_p4est_3d > (forest,
+                                                        (p8est_t *)
+                                                        forest->set_p4est);
+  }
+  forest->set_p4est = NULL;
+}
+
+template < class TP4est > static t8_forest_t
+t8_forest_new_from_p4est_dim (typename TP4est::p4est_type ** pp4est,
+                              t8_scheme_cxx_t * scheme, int do_face_ghost)
+{
+  typename TP4est::p4est_type * p4est;
+  t8_forest_t         forest;
+
+  T8_ASSERT (pp4est != NULL && *pp4est != NULL);
+  T8_ASSERT (TP4est::is_valid (*pp4est));
+  T8_ASSERT (scheme != NULL);
+
+  p4est = *pp4est;
+  *pp4est = NULL;
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, TP4est::new_cmesh (p4est->connectivity,
+                                                  p4est->mpicomm),
+                       p4est->mpicomm);
+  t8_forest_set_scheme (forest, scheme);
+  /* The p4est is adopted in commit */
+  forest->set_p4est = p4est;
+  forest->set_p4est_dim = TP4est::dim;
+  if (do_face_ghost) {
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+  }
+  t8_forest_commit (forest);
+  t8_global_productionf
+    ("Constructed forest from p%iest with %lli global elements.\n",
+     TP4est::dim == 2 ? 4 : 8, (long long) forest->global_num_elements);
+  return forest;
+}
+
+template < class TP4est > static typename TP4est::p4est_type *
+t8_forest_to_p4est_dim (t8_forest_t * pforest,
+                        typename TP4est::connectivity_type * conn)
+{
+  typename TP4est::p4est_type * p4est;
+  typename TP4est::tree_type * ptree;
+  typename TP4est::quadrant_type * quad, *first_quad;
+  t8_forest_t         forest;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         itree, offset;
+  size_t              iquad;
+  int                 adopt;
+
+  T8_ASSERT (pforest != NULL);
+  forest = *pforest;
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (conn != NULL);
+  SC_CHECK_ABORT ((t8_gloidx_t) conn->num_trees == forest->global_num_trees,
+                  "The connectivity does not match the cmesh of the forest");
+  SC_CHECK_ABORT (!forest->do_dup, "The forest must not duplicate its"
+                  " communicator");
+  ts = forest->scheme_cxx->eclass_schemes[TP4est::eclass];
+  SC_CHECK_ABORT (t8_forest_p4est_scheme_matches < TP4est > (ts),
+                  "The scheme does not store the elements as p4est");
+  /* We take over the element arrays only if nobody else can see them */
+  adopt = forest->rc.refcount == 1 && forest->shared_elements == NULL;
+
+  p4est = P4EST_ALLOC_ZERO (typename TP4est::p4est_type, 1);
+  p4est->mpicomm = forest->mpicomm;
+  p4est->mpisize = forest->mpisize;
+  p4est->mpirank = forest->mpirank;
+  p4est->data_size = 0;
+  p4est->connectivity = conn;
+  p4est->quadrant_pool =
+    sc_mempool_new (sizeof (typename TP4est::quadrant_type));
+  p4est->local_num_quadrants = forest->local_num_elements;
+  if (forest->local_num_elements == 0) {
+    /* p4est marks an empty process with these values */
+    p4est->first_local_tree = -1;
+    p4est->last_local_tree = -2;
+  }
+  else {
+    p4est->first_local_tree = forest->first_local_tree;
+    p4est->last_local_tree = forest->last_local_tree;
+  }
+  p4est->trees = sc_array_new_count (sizeof (typename TP4est::tree_type),
+                                     conn->num_trees);
+  first_quad = NULL;
+  offset = 0;
+  for (itree = 0; itree < (t8_locidx_t) conn->num_trees; itree++) {
+    ptree = (typename TP4est::tree_type *) sc_array_index (p4est->trees,
+                                                           itree);
+    memset (ptree, 0, sizeof (*ptree));
+    sc_array_init (&ptree->quadrants,
+                   sizeof (typename TP4est::quadrant_type));
+    ptree->quadrants_offset = offset;
+    if (itree < p4est->first_local_tree || itree > p4est->last_local_tree) {
+      continue;
+    }
+    tree = t8_forest_get_tree (forest, itree - forest->first_local_tree);
+    SC_CHECK_ABORT (tree->eclass == TP4est::eclass,
+                    "The forest has trees of another class");
+    if (adopt && tree->elements.array.byte_alloc >= 0) {
+      /* Take over the element array and leave an empty one in its place */
+      ptree->quadrants = tree->elements.array;
+      sc_array_init (&tree->elements.array, tree->elements.array.elem_size);
+    }
+    else {
+      sc_array_copy (&ptree->quadrants, &tree->elements.array);
+    }
+    for (iquad = 0; iquad < ptree->quadrants.elem_count; iquad++) {
+      quad = (typename TP4est::quadrant_type *)
+        sc_array_index (&ptree->quadrants, iquad);
+      /* Clear the fields that t8code uses and p4est does not */
+      quad->pad8 = 0;
+      quad->pad16 = 0;
+      quad->p.user_data = NULL;
+      ptree->quadrants_per_level[quad->level]++;
+      ptree->maxlevel = SC_MAX (ptree->maxlevel, quad->level);
+    }
+    T8_ASSERT (ptree->quadrants.elem_count > 0);
+    TP4est::first_descendant ((typename TP4est::quadrant_type *)
+                              sc_array_index (&ptree->quadrants, 0),
+                              &ptree->first_desc);
+    TP4est::last_descendant ((typename TP4est::quadrant_type *)
+                             sc_array_index (&ptree->quadrants,
+                                             ptree->quadrants.elem_count -
+                                             1), &ptree->last_desc);
+    if (first_quad == NULL) {
+      first_quad = (typename TP4est::quadrant_type *)
+        sc_array_index (&ptree->quadrants, 0);
+    }
+    offset += (t8_locidx_t) ptree->quadrants.elem_count;
+  }
+  T8_ASSERT (offset == forest->local_num_elements);
+  t8_forest_unref (pforest);
+
+  /* Compute the partition of the p4est */
+  p4est->global_first_quadrant = P4EST_ALLOC (p4est_gloidx_t,
+                                              p4est->mpisize + 1);
+  TP4est::count_quadrants (p4est);
+  p4est->global_first_position =
+    P4EST_ALLOC_ZERO (typename TP4est::quadrant_type, p4est->mpisize + 1);
+  TP4est::global_partition (p4est, first_quad);
+  T8_ASSERT (TP4est::is_valid (p4est));
+  return p4est;
+}
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+t8_forest_t
+t8_forest_new_from_p4est (p4est_t ** pp4est, t8_scheme_cxx_t * scheme,
+                          int do_face_ghost)
+{
+  return t8_forest_new_from_p4est_dim < t8_forest_p4est_2d > (pp4est, scheme,
+                                                              do_face_ghost);
+}
+
+t8_forest_t
+t8_forest_new_from_p8est (p8est_t ** pp8est, t8_scheme_cxx_t * scheme,
+                          int do_face_ghost)
+{
+  return t8_forest_new_from_p4est_dim < t8_forest_p4est_3d > (pp8est, scheme,
+                                                              do_face_ghost);
+}
+
+p4est_t            *
+t8_forest_to_p4est (t8_forest_t * pforest, p4est_connectivity_t * conn)
+{
+  return t8_forest_to_p4est_dim < t8_forest_p4est_2d > (pforest, conn);
+}
+
+p8est_t            *
+t8_forest_to_p8est (t8_forest_t * pforest, p8est_connectivity_t * conn)
+{
+  return t8_forest_to_p4est_dim < t8_forest_p4est_3d > (pforest, conn);
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,97 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_p4est.h
+ * Convert p4est and p8est forests to t8code forests and back.
+ *
+ * The default quad and hex schemes store their elements as
+ * p4est_quadrant_t and p8est_quadrant_t in the same Morton order as p4est.
+ * Thus the quadrant array of a p4est tree is adopted as the element array
+ * of a t8code tree and vice versa, without copying the quadrants.
+ * The trees of the forests are the trees of the connectivity, and each
+ * process keeps the quadrants that it owns.
+ */
+
+#ifndef T8_FOREST_P4EST_H
+#define T8_FOREST_P4EST_H
+
+#include <p4est.h>
+#include <p8est.h>
+#include <t8.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Create a forest of quads from a p4est. The quadrant arrays of the
+ * p4est are taken over by the trees of the forest and the p4est is
+ * destroyed. Its user data is discarded.
+ * \param [in,out] pp4est   A p4est. It is destroyed and set to NULL
+ *                          on output. Its connectivity is not destroyed.
+ * \param [in] scheme       The scheme of the forest. Its quad scheme
+ *                          must be the default one. We take ownership
+ *                          of \a scheme.
+ * \param [in] do_face_ghost If true, a face ghost layer is created.
+ * \return                  A committed forest with the quadrants of
+ *                          \a pp4est, partitioned as \a pp4est. Its cmesh
+ *                          is built from the connectivity of \a pp4est
+ *                          and is replicated.
+ * \note This function is collective over the communicator of \a pp4est.
+ */
+t8_forest_t         t8_forest_new_from_p4est (p4est_t ** pp4est,
+                                              t8_scheme_cxx_t * scheme,
+                                              int do_face_ghost);
+
+/** Create a forest of hexes from a p8est.
+ * \see t8_forest_new_from_p4est
+ */
+t8_forest_t         t8_forest_new_from_p8est (p8est_t ** pp8est,
+                                              t8_scheme_cxx_t * scheme,
+                                              int do_face_ghost);
+
+/** Create a p4est from a forest of quads. If the forest is not referenced
+ * elsewhere, its element arrays are taken over by the p4est, otherwise
+ * they are copied as a whole. The p4est has no user data, which can be
+ * added with p4est_reset_data.
+ * \param [in,out] pforest  A committed forest of quads in the default quad
+ *                          scheme. The only tree class must be quads. We
+ *                          take one reference of it and set it to NULL on
+ *                          output.
+ * \param [in] conn         The connectivity that the cmesh of \a pforest
+ *                          was built from. It must outlive the p4est.
+ * \return                  A p4est with the elements of \a pforest,
+ *                          partitioned as \a pforest. It uses the
+ *                          communicator of \a pforest, which must not be
+ *                          duplicated by the forest.
+ * \note This function is collective.
+ */
+p4est_t            *t8_forest_to_p4est (t8_forest_t * pforest,
+                                        p4est_connectivity_t * conn);
+
+/** Create a p8est from a forest of hexes.
+ * \see t8_forest_to_p4est
+ */
+p8est_t            *t8_forest_to_p8est (t8_forest_t * pforest,
+                                        p8est_connectivity_t * conn);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_P4EST_H */
@@ -0,0 +1,462 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_particles.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_forest/t8_forest_locate.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_element_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The new particle arrays that are filled while iterating over the old and
+ * the adapted forest */
+typedef struct
+{
+  const t8_forest_particles_t *particles;
+  t8_locidx_t        *offsets;
+  double            **components;
+  t8_locidx_t         cursor;   /* The next particle that is written */
+  sc_array_t          points;   /* Coordinates of the particles of an element */
+  sc_array_t          is_inside;
+} t8_forest_particles_adapt_t;
+
+/* Allocate an array for each of the num_components components of
+ * num_particles particles */
+static double     **
+t8_forest_particles_alloc (int num_components, t8_locidx_t num_particles)
+{
+  double            **components;
+  int                 icomp;
+
+  components = T8_ALLOC (double *, num_components);
+  for (icomp = 0; icomp < num_components; icomp++) {
+    components[icomp] = T8_ALLOC (double, num_particles);
+  }
+  return components;
+}
+
+static void
+t8_forest_particles_free (int num_components, double **components)
+{
+  int                 icomp;
+
+  for (icomp = 0; icomp < num_components; icomp++) {
+    T8_FREE (components[icomp]);
+  }
+  T8_FREE (components);
+}
+
+/* Copy count particles starting at first_from to first_to */
+static void
+t8_forest_particles_copy (int num_components, double **to,
+                          t8_locidx_t first_to, double *const *from,
+                          t8_locidx_t first_from, t8_locidx_t count)
+{
+  int                 icomp;
+
+  for (icomp = 0; icomp < num_components; icomp++) {
+    memcpy (to[icomp] + first_to, from[icomp] + first_from,
+            count * sizeof (double));
+  }
+}
+
+t8_forest_particles_t *
+t8_forest_particles_new (t8_forest_t forest, int num_components)
+{
+  t8_forest_particles_t *particles;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_components >= 3);
+
+  particles = T8_ALLOC_ZERO (t8_forest_particles_t, 1);
+  t8_forest_ref (forest);
+  particles->forest = forest;
+  particles->num_components = num_components;
+  particles->num_particles = 0;
+  particles->element_offsets =
+    T8_ALLOC_ZERO (t8_locidx_t, t8_forest_get_num_element (forest) + 1);
+  particles->components = t8_forest_particles_alloc (num_components, 0);
+  return particles;
+}
+
+void
+t8_forest_particles_destroy (t8_forest_particles_t ** pparticles)
+{
+  t8_forest_particles_t *particles;
+
+  T8_ASSERT (pparticles != NULL && *pparticles != NULL);
+  particles = *pparticles;
+  t8_forest_unref (&particles->forest);
+  T8_FREE (particles->element_offsets);
+  t8_forest_particles_free (particles->num_components,
+                            particles->components);
+  T8_FREE (particles);
+  *pparticles = NULL;
+}
+
+void
+t8_forest_particles_add (t8_forest_particles_t * particles,
+                         t8_locidx_t num_new, const t8_locidx_t * elements,
+                         const double *values)
+{
+  const int           num_components = particles->num_components;
+  t8_locidx_t        *offsets, *positions, *old_offsets;
+  t8_locidx_t         num_elems, ielem, inew, ipos;
+  double            **components;
+  int                 icomp;
+
+  T8_ASSERT (num_new >= 0);
+  T8_ASSERT (num_new == 0 || (elements != NULL && values != NULL));
+
+  /* Count the particles of each element */
+  num_elems = t8_forest_get_num_element (particles->forest);
+  old_offsets = particles->element_offsets;
+  offsets = T8_ALLOC_ZERO (t8_locidx_t, num_elems + 1);
+  for (ielem = 0; ielem < num_elems; ielem++) {
+    offsets[ielem + 1] = old_offsets[ielem + 1] - old_offsets[ielem];
+  }
+  for (inew = 0; inew < num_new; inew++) {
+    T8_ASSERT (0 <= elements[inew] && elements[inew] < num_elems);
+    offsets[elements[inew] + 1]++;
+  }
+  for (ielem = 0; ielem < num_elems; ielem++) {
+    offsets[ielem + 1] += offsets[ielem];
+  }
+
+  /* Copy the existing particles and put the new ones behind them */
+  components = t8_forest_particles_alloc (num_components, offsets[num_elems]);
+  positions = T8_ALLOC (t8_locidx_t, num_elems);
+  for (ielem = 0; ielem < num_elems; ielem++) {
+    t8_forest_particles_copy (num_components, components, offsets[ielem],
+                              particles->components, old_offsets[ielem],
+                              old_offsets[ielem + 1] - old_offsets[ielem]);
+    positions[ielem] =
+      offsets[ielem] + old_offsets[ielem + 1] - old_offsets[ielem];
+  }
+  for (inew = 0; inew < num_new; inew++) {
+    ipos = positions[elements[inew]]++;
+    for (icomp = 0; icomp < num_components; icomp++) {
+      components[icomp][ipos] = values[(size_t) inew * num_components + icomp];
+    }
+  }
+  T8_FREE (positions);
+
+  t8_forest_particles_free (num_components, particles->components);
+  T8_FREE (old_offsets);
+  particles->components = components;
+  particles->element_offsets = offsets;
+  particles->num_particles = offsets[num_elems];
+}
+
+/* Copy the particles of a run of unchanged elements */
+static void
+t8_forest_particles_copy_fn (t8_forest_t forest_old, t8_forest_t forest_new,
+                             t8_locidx_t first_old, t8_locidx_t first_new,
+                             t8_locidx_t count)
+{
+  t8_forest_particles_adapt_t *adapt;
+  const t8_locidx_t  *old_offsets;
+  t8_locidx_t         ielem;
+
+  adapt = (t8_forest_particles_adapt_t *) t8_forest_get_user_data
+    (forest_new);
+  old_offsets = adapt->particles->element_offsets;
+  for (ielem = 0; ielem < count; ielem++) {
+    adapt->offsets[first_new + ielem] =
+      adapt->cursor + old_offsets[first_old + ielem] - old_offsets[first_old];
+  }
+  t8_forest_particles_copy (adapt->particles->num_components,
+                            adapt->components, adapt->cursor,
+                            adapt->particles->components,
+                            old_offsets[first_old],
+                            old_offsets[first_old + count] -
+                            old_offsets[first_old]);
+  adapt->cursor += old_offsets[first_old + count] - old_offsets[first_old];
+}
+
+/* Merge the particles of a coarsened family or bucket the particles of a
+ * refined element into its children */
+static void
+t8_forest_particles_replace_fn (t8_forest_t forest_old,
+                                t8_forest_t forest_new,
+                                t8_locidx_t which_tree,
+                                t8_eclass_scheme_c * ts,
+                                int num_outgoing, t8_locidx_t first_outgoing,
+                                int num_incoming, t8_locidx_t first_incoming)
+{
+  t8_forest_particles_adapt_t *adapt;
+  const t8_forest_particles_t *particles;
+  const t8_element_t *child;
+  t8_locidx_t         iold, inew, first, num, iparticle;
+  int                *is_inside, *assigned;
+  double             *points;
+  int                 ichild, icomp;
+
+  adapt = (t8_forest_particles_adapt_t *) t8_forest_get_user_data
+    (forest_new);
+  particles = adapt->particles;
+  iold = t8_forest_get_tree_element_offset (forest_old, which_tree) +
+    first_outgoing;
+  inew = t8_forest_get_tree_element_offset (forest_new, which_tree) +
+    first_incoming;
+  if (num_outgoing > 1 || num_incoming == 1) {
+    /* The family was coarsened, its particles are consecutive */
+    first = particles->element_offsets[iold];
+    num = particles->element_offsets[iold + num_outgoing] - first;
+    adapt->offsets[inew] = adapt->cursor;
+    t8_forest_particles_copy (particles->num_components, adapt->components,
+                              adapt->cursor, particles->components, first,
+                              num);
+    adapt->cursor += num;
+    return;
+  }
+
+  /* The element was refined. Each child takes the remaining particles
+   * inside of it, the last child all that remain. */
+  first = particles->element_offsets[iold];
+  num = particles->element_offsets[iold + 1] - first;
+  sc_array_resize (&adapt->points, 3 * num);
+  sc_array_resize (&adapt->is_inside, 2 * num);
+  points = (double *) adapt->points.array;
+  is_inside = (int *) adapt->is_inside.array;
+  assigned = is_inside + num;
+  for (iparticle = 0; iparticle < num; iparticle++) {
+    for (icomp = 0; icomp < 3; icomp++) {
+      points[3 * iparticle + icomp] =
+        particles->components[icomp][first + iparticle];
+    }
+    assigned[iparticle] = 0;
+  }
+  for (ichild = 0; ichild < num_incoming; ichild++) {
+    adapt->offsets[inew + ichild] = adapt->cursor;
+    if (num > 0 && ichild < num_incoming - 1) {
+      child = t8_forest_get_element_in_tree (forest_new, which_tree,
+                                             first_incoming + ichild);
+      t8_forest_element_point_inside_batch (forest_new, which_tree, child,
+                                            points, num, 0, is_inside);
+    }
+    for (iparticle = 0; iparticle < num; iparticle++) {
+      if (!assigned[iparticle]
+          && (ichild == num_incoming - 1 || is_inside[iparticle])) {
+        t8_forest_particles_copy (particles->num_components,
+                                  adapt->components, adapt->cursor++,
+                                  particles->components, first + iparticle,
+                                  1);
+        assigned[iparticle] = 1;
+      }
+    }
+  }
+}
+
+/* Replace the forest of particles and its particles */
+static void
+t8_forest_particles_replace (t8_forest_particles_t * particles,
+                             t8_forest_t forest_new, t8_locidx_t * offsets,
+                             double **components)
+{
+  t8_forest_ref (forest_new);
+  t8_forest_unref (&particles->forest);
+  particles->forest = forest_new;
+  T8_FREE (particles->element_offsets);
+  particles->element_offsets = offsets;
+  t8_forest_particles_free (particles->num_components,
+                            particles->components);
+  particles->components = components;
+}
+
+void
+t8_forest_particles_adapt (t8_forest_particles_t * particles,
+                           t8_forest_t forest_new)
+{
+  t8_forest_particles_adapt_t adapt;
+  t8_locidx_t         num_elems;
+  void               *user_data;
+
+  T8_ASSERT (particles != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest_new));
+
+  num_elems = t8_forest_get_num_element (forest_new);
+  adapt.particles = particles;
+  adapt.offsets = T8_ALLOC (t8_locidx_t, num_elems + 1);
+  adapt.components = t8_forest_particles_alloc (particles->num_components,
+                                                particles->num_particles);
+  adapt.cursor = 0;
+  sc_array_init (&adapt.points, sizeof (double));
+  sc_array_init (&adapt.is_inside, sizeof (int));
+
+  /* We pass the new arrays as user data of the new forest */
+  user_data = t8_forest_get_user_data (forest_new);
+  t8_forest_set_user_data (forest_new, &adapt);
+  t8_forest_iterate_replace_bulk (forest_new, particles->forest,
+                                  t8_forest_particles_replace_fn,
+                                  t8_forest_particles_copy_fn);
+  t8_forest_set_user_data (forest_new, user_data);
+  T8_ASSERT (adapt.cursor == particles->num_particles);
+  adapt.offsets[num_elems] = adapt.cursor;
+
+  sc_array_reset (&adapt.points);
+  sc_array_reset (&adapt.is_inside);
+  t8_forest_particles_replace (particles, forest_new, adapt.offsets,
+                               adapt.components);
+}
+
+void
+t8_forest_particles_partition (t8_forest_particles_t * particles,
+                               t8_forest_t forest_new)
+{
+  const int           num_components = particles->num_components;
+  t8_forest_t         forest_old = particles->forest;
+  sc_array_t          counts_old, counts_new;
+  sc_MPI_Request     *requests;
+  t8_locidx_t        *offsets_old, *offsets_new;
+  t8_locidx_t         num_old, num_new, ielem, first, num, num_particles;
+  t8_gloidx_t         old_begin, old_end, new_begin, new_end, low, high;
+  double            **components, **buffers;
+  int                 mpisize, mpirank, iproc, icomp, mpiret;
+  int                 num_requests;
+
+  T8_ASSERT (particles != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest_new));
+  mpisize = forest_old->mpisize;
+  mpirank = forest_old->mpirank;
+
+  /* The particle counts of the elements travel with the elements */
+  num_old = t8_forest_get_num_element (forest_old);
+  num_new = t8_forest_get_num_element (forest_new);
+  offsets_old = particles->element_offsets;
+  sc_array_init_size (&counts_old, sizeof (t8_locidx_t), num_old);
+  sc_array_init_size (&counts_new, sizeof (t8_locidx_t), num_new);
+  for (ielem = 0; ielem < num_old; ielem++) {
+    *(t8_locidx_t *) sc_array_index (&counts_old, ielem) =
+      offsets_old[ielem + 1] - offsets_old[ielem];
+  }
+  t8_forest_partition_data (forest_old, forest_new, &counts_old, &counts_new);
+  offsets_new = T8_ALLOC (t8_locidx_t, num_new + 1);
+  offsets_new[0] = 0;
+  for (ielem = 0; ielem < num_new; ielem++) {
+    offsets_new[ielem + 1] = offsets_new[ielem] +
+      *(t8_locidx_t *) sc_array_index (&counts_new, ielem);
+  }
+  sc_array_reset (&counts_old);
+  sc_array_reset (&counts_new);
+  num_particles = offsets_new[num_new];
+  components = t8_forest_particles_alloc (num_components, num_particles);
+
+  /* The particles of the elements that go from process p to q are a
+   * contiguous range on both. We send each component of the range. */
+  old_begin = t8_shmem_array_get_gloidx (forest_old->element_offsets,
+                                         mpirank);
+  old_end = t8_shmem_array_get_gloidx (forest_old->element_offsets,
+                                       mpirank + 1);
+  new_begin = t8_shmem_array_get_gloidx (forest_new->element_offsets,
+                                         mpirank);
+  new_end = t8_shmem_array_get_gloidx (forest_new->element_offsets,
+                                       mpirank + 1);
+  buffers = T8_ALLOC_ZERO (double *, 2 * mpisize);
+  requests = T8_ALLOC (sc_MPI_Request, 2 * mpisize);
+  num_requests = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    /* Receive the particles of the elements that we get from iproc */
+    low = SC_MAX (new_begin,
+                  t8_shmem_array_get_gloidx (forest_old->element_offsets,
+                                             iproc));
+    high = SC_MIN (new_end,
+                   t8_shmem_array_get_gloidx (forest_old->element_offsets,
+                                              iproc + 1));
+    if (iproc == mpirank || low >= high) {
+      continue;
+    }
+    first = offsets_new[low - new_begin];
+    num = offsets_new[high - new_begin] - first;
+    if (num > 0) {
+      buffers[iproc] = T8_ALLOC (double, (size_t) num_components * num);
+      mpiret = sc_MPI_Irecv (buffers[iproc], num_components * num,
+                             sc_MPI_DOUBLE, iproc, T8_MPI_PARTICLES,
+                             forest_old->mpicomm, requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    /* Send the particles of the elements that go to iproc */
+    low = SC_MAX (old_begin,
+                  t8_shmem_array_get_gloidx (forest_new->element_offsets,
+                                             iproc));
+    high = SC_MIN (old_end,
+                   t8_shmem_array_get_gloidx (forest_new->element_offsets,
+                                              iproc + 1));
+    if (low >= high) {
+      continue;
+    }
+    first = offsets_old[low - old_begin];
+    num = offsets_old[high - old_begin] - first;
+    if (iproc == mpirank) {
+      t8_forest_particles_copy (num_components, components,
+                                offsets_new[low - new_begin],
+                                particles->components, first, num);
+    }
+    else if (num > 0) {
+      buffers[mpisize + iproc] =
+        T8_ALLOC (double, (size_t) num_components * num);
+      for (icomp = 0; icomp < num_components; icomp++) {
+        memcpy (buffers[mpisize + iproc] + (size_t) icomp * num,
+                particles->components[icomp] + first, num * sizeof (double));
+      }
+      mpiret = sc_MPI_Isend (buffers[mpisize + iproc], num_components * num,
+                             sc_MPI_DOUBLE, iproc, T8_MPI_PARTICLES,
+                             forest_old->mpicomm, requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests);
+
+  /* Unpack the received components */
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (buffers[iproc] != NULL) {
+      low = SC_MAX (new_begin,
+                    t8_shmem_array_get_gloidx (forest_old->element_offsets,
+                                               iproc));
+      high = SC_MIN (new_end,
+                     t8_shmem_array_get_gloidx (forest_old->element_offsets,
+                                                iproc + 1));
+      first = offsets_new[low - new_begin];
+      num = offsets_new[high - new_begin] - first;
+      for (icomp = 0; icomp < num_components; icomp++) {
+        memcpy (components[icomp] + first,
+                buffers[iproc] + (size_t) icomp * num, num * sizeof (double));
+      }
+    }
+    T8_FREE (buffers[iproc]);
+    T8_FREE (buffers[mpisize + iproc]);
+  }
+  T8_FREE (buffers);
+
+  particles->num_particles = num_particles;
+  t8_forest_particles_replace (particles, forest_new, offsets_new,
+                               components);
+}
+
+T8_EXTERN_C_END ();
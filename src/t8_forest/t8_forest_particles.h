@@ -0,0 +1,119 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_particles.h
+ * A container of particles that are bound to the local elements of a forest
+ * and follow them through adapt and partition.
+ *
+ * Each particle has a fixed number of double components, of which the first
+ * three are its x, y and z coordinates. The components are stored as a
+ * structure of arrays, one array per component, and the particles are sorted
+ * by their element. Thus the particles of an element are a contiguous range
+ * of each component array.
+ *
+ * After adapting the forest, \ref t8_forest_particles_adapt moves the
+ * particles of refined elements into the children containing them and
+ * merges the particles of coarsened families. After partitioning,
+ * \ref t8_forest_particles_partition sends the particles along with their
+ * elements. Neither needs a search for the elements of the particles.
+ */
+
+#ifndef T8_FOREST_PARTICLES_H
+#define T8_FOREST_PARTICLES_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** The particles of a forest. */
+typedef struct
+{
+  t8_forest_t         forest;           /**< The forest whose elements hold the particles.
+                                             We keep a reference to it. */
+  int                 num_components;   /**< The number of doubles per particle, at least 3. */
+  t8_locidx_t         num_particles;    /**< The number of particles. */
+  t8_locidx_t        *element_offsets;  /**< The particles of local element i are
+                                             element_offsets[i], ...,
+                                             element_offsets[i + 1] - 1.
+                                             Has one entry per local element plus one. */
+  double            **components;       /**< For each component an array with one entry per
+                                             particle. Components 0, 1 and 2 are the
+                                             coordinates. */
+} t8_forest_particles_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Create an empty particle container on a forest.
+ * \param [in] forest         A committed forest. We keep a reference.
+ * \param [in] num_components The number of doubles per particle, at least 3.
+ * \return                    The container. Destroy it with
+ *                            \ref t8_forest_particles_destroy.
+ */
+t8_forest_particles_t *t8_forest_particles_new (t8_forest_t forest,
+                                                int num_components);
+
+/** Free the memory of a particle container and unref its forest.
+ * \param [in,out] pparticles A particle container, set to NULL on output.
+ */
+void                t8_forest_particles_destroy (t8_forest_particles_t **
+                                                 pparticles);
+
+/** Add particles to a container.
+ * The new particles of an element are put behind its existing ones.
+ * \param [in,out] particles  A particle container.
+ * \param [in] num_new        The number of new particles.
+ * \param [in] elements       The local element of each new particle, for example
+ *                            found by \ref t8_forest_locate_points.
+ * \param [in] values         The \a num_components doubles of each new particle,
+ *                            stored particle by particle.
+ */
+void                t8_forest_particles_add (t8_forest_particles_t *
+                                             particles, t8_locidx_t num_new,
+                                             const t8_locidx_t * elements,
+                                             const double *values);
+
+/** Move the particles to the elements of an adapted forest.
+ * A particle of a refined element goes to the first child that contains
+ * its coordinates, or to the last child if no other child does.
+ * \param [in,out] particles  A particle container.
+ * \param [in] forest_new     A committed forest that was adapted from the
+ *                            forest of \a particles. It replaces this forest
+ *                            in \a particles, and we keep a reference to it.
+ */
+void                t8_forest_particles_adapt (t8_forest_particles_t *
+                                               particles,
+                                               t8_forest_t forest_new);
+
+/** Move the particles to the elements of a repartitioned forest.
+ * \param [in,out] particles  A particle container.
+ * \param [in] forest_new     A committed forest that was partitioned from
+ *                            the forest of \a particles. It replaces this
+ *                            forest in \a particles, and we keep a reference
+ *                            to it.
+ * \note This function is collective.
+ */
+void                t8_forest_particles_partition (t8_forest_particles_t *
+                                                   particles,
+                                                   t8_forest_t forest_new);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_PARTICLES_H */
@@ -23,9 +23,11 @@
 #include <t8_forest/t8_forest_partition.h>
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
 #include <t8_element_cxx.hxx>
+#include <t8_profile_regions.h>
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
@@ -38,8 +40,15 @@ typedef struct
   t8_gloidx_t         gtree_id; /* The global id of that tree *//* TODO: we could optimize this out */
   t8_eclass_t         eclass;   /* The element class of that tree */
   t8_locidx_t         num_elements;     /* The number of elements from this tree that were sent */
+  t8_locidx_t         first_element;    /* The tree local index of the first element that was sent */
 } t8_forest_partition_tree_info_t;
 
+#ifdef SC_ENABLE_MPI
+/* An element message is sent directly from and received directly into the
+ * tree element arrays with this MPI datatype */
+#define T8_FOREST_PARTITION_ELEMENT_TYPE
+#endif
+
 /* Given the element offset array and a rank, return the first
  * local element id of this rank */
 static              t8_gloidx_t
@@ -159,13 +168,41 @@ t8_forest_partition_test_desc (t8_forest_t forest)
 }
 #endif
 
+/* Compute the linear id of the first descendant of the first local
+ * element at the forest's maxlevel. An empty process returns 0. */
+static              t8_linearidx_t
+t8_forest_partition_local_first_desc (t8_forest_t forest)
+{
+  t8_linearidx_t      local_first_desc;
+  t8_element_t       *first_element, *first_desc;
+  t8_eclass_scheme_c *ts;
+
+  if (forest->local_num_elements <= 0) {
+    /* This process is empty, we store 0 in the array */
+    return 0;
+  }
+  /* Get a pointer to the first local element. */
+  first_element = t8_forest_get_element_in_tree (forest, 0, 0);
+  /* This process is not empty, the element was found, so we compute
+   * its first descendant. */
+  /* Get the eclass_scheme of the element. */
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest, 0));
+  ts->t8_element_new (1, &first_desc);
+  ts->t8_element_first_descendant (first_element, first_desc,
+                                   forest->maxlevel);
+  /* Compute the linear id of the descendant. */
+  local_first_desc =
+    ts->t8_element_get_linear_id (first_desc, forest->maxlevel);
+  ts->t8_element_destroy (1, &first_desc);
+  return local_first_desc;
+}
+
 void
 t8_forest_partition_create_first_desc (t8_forest_t forest)
 {
   sc_MPI_Comm         comm;
   t8_linearidx_t      local_first_desc;
-  t8_element_t       *first_element, *first_desc;
-  t8_eclass_scheme_c *ts;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
@@ -187,26 +224,7 @@ t8_forest_partition_create_first_desc (t8_forest_t forest)
   T8_ASSERT (t8_shmem_array_get_elem_size (forest->global_first_desc) ==
              sizeof (t8_linearidx_t));
   T8_ASSERT (t8_shmem_array_get_comm (forest->global_first_desc) == comm);
-  if (forest->local_num_elements <= 0) {
-    /* This process is empty, we store 0 in the array */
-    local_first_desc = 0;
-  }
-  else {
-    /* Get a pointer to the first local element. */
-    first_element = t8_forest_get_element_in_tree (forest, 0, 0);
-    /* This process is not empty, the element was found, so we compute
-     * its first descendant. */
-    /* Get the eclass_scheme of the element. */
-    ts = t8_forest_get_eclass_scheme (forest,
-                                      t8_forest_get_tree_class (forest, 0));
-    ts->t8_element_new (1, &first_desc);
-    ts->t8_element_first_descendant (first_element, first_desc,
-                                     forest->maxlevel);
-    /* Compute the linear id of the descendant. */
-    local_first_desc =
-      ts->t8_element_get_linear_id (first_desc, forest->maxlevel);
-    ts->t8_element_destroy (1, &first_desc);
-  }
+  local_first_desc = t8_forest_partition_local_first_desc (forest);
   /* Collect all first global indices in the array */
 #ifdef T8_ENABLE_DEBUG
 #ifdef SC_ENABLE_MPI
@@ -317,16 +335,478 @@ t8_forest_partition_create_tree_offsets (t8_forest_t forest)
   }
 }
 
+/* The partition data of one process that
+ * t8_forest_partition_create_all_offsets gathers from all processes. */
+typedef struct
+{
+  t8_gloidx_t         num_elements;     /* The number of local elements */
+  t8_gloidx_t         first_tree;       /* The global id of the first local tree */
+  t8_linearidx_t      first_desc;       /* The id of the first local descendant */
+  int                 first_tree_shared;        /* True if the first tree is shared */
+} t8_forest_partition_info_t;
+
+void
+t8_forest_partition_create_all_offsets (t8_forest_t forest)
+{
+  t8_forest_partition_info_t local_info;
+  const t8_forest_partition_info_t *info;
+  t8_shmem_array_t    info_array;
+  t8_gloidx_t        *offsets;
+  t8_linearidx_t     *first_desc;
+  sc_MPI_Comm         comm;
+  int                 iproc, next_nonempty, mpisize;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (forest->element_offsets != NULL && forest->tree_offsets != NULL
+      && forest->global_first_desc != NULL) {
+    /* All arrays exist and stay valid as long as the forest does */
+    return;
+  }
+  t8_debugf ("Building partition offsets for forest %p\n", forest);
+  comm = forest->mpicomm;
+  mpisize = forest->mpisize;
+  /* Set the shmem array type of comm */
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+
+  /* Pack the partition data of this process. We clear the struct first,
+   * since its padding is communicated as well. */
+  memset (&local_info, 0, sizeof (local_info));
+  local_info.num_elements = forest->local_num_elements;
+  local_info.first_tree = forest->first_local_tree;
+  local_info.first_desc = t8_forest_partition_local_first_desc (forest);
+  local_info.first_tree_shared = forest->local_num_elements > 0
+    && t8_forest_first_tree_shared (forest);
+  /* Gather the data of all processes with one collective */
+  t8_shmem_array_init (&info_array, sizeof (t8_forest_partition_info_t),
+                       mpisize, comm);
+  t8_shmem_array_allgather (&local_info, (int) sizeof (local_info),
+                            sc_MPI_BYTE, info_array,
+                            (int) sizeof (local_info), sc_MPI_BYTE);
+  info = (const t8_forest_partition_info_t *)
+    t8_shmem_array_get_array (info_array);
+
+  offsets = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  if (forest->element_offsets == NULL) {
+    /* The element offsets are the prefix sums of the element counts */
+    offsets[0] = 0;
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      offsets[iproc + 1] = offsets[iproc] + info[iproc].num_elements;
+    }
+    T8_ASSERT (offsets[mpisize] == forest->global_num_elements);
+    t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                         mpisize + 1, comm);
+    t8_shmem_array_copy_from (forest->element_offsets, offsets);
+  }
+  if (forest->tree_offsets == NULL) {
+    /* An empty process stores the first nonshared tree of the next
+     * nonempty process, as in t8_forest_partition_create_tree_offsets */
+    offsets[mpisize] = forest->global_num_trees;
+    next_nonempty = mpisize;
+    for (iproc = mpisize - 1; iproc >= 0; iproc--) {
+      if (info[iproc].num_elements > 0) {
+        offsets[iproc] = info[iproc].first_tree_shared ?
+          -info[iproc].first_tree - 1 : info[iproc].first_tree;
+        next_nonempty = iproc;
+      }
+      else if (next_nonempty == mpisize) {
+        offsets[iproc] = forest->global_num_trees;
+      }
+      else {
+        offsets[iproc] = info[next_nonempty].first_tree
+          + (info[next_nonempty].first_tree_shared ? 1 : 0);
+      }
+    }
+    t8_shmem_array_init (&forest->tree_offsets, sizeof (t8_gloidx_t),
+                         mpisize + 1, comm);
+    t8_shmem_array_copy_from (forest->tree_offsets, offsets);
+  }
+  T8_FREE (offsets);
+  if (forest->global_first_desc == NULL) {
+    first_desc = T8_ALLOC (t8_linearidx_t, mpisize);
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      first_desc[iproc] = info[iproc].first_desc;
+    }
+    t8_shmem_array_init (&forest->global_first_desc,
+                         sizeof (t8_linearidx_t), mpisize, comm);
+    t8_shmem_array_copy_from (forest->global_first_desc, first_desc);
+    T8_FREE (first_desc);
+#ifdef T8_ENABLE_DEBUG
+    t8_forest_partition_test_desc (forest);
+#endif
+  }
+  t8_shmem_array_destroy (&info_array);
+}
+
+/* The global index of the first element of a rank in a uniform forest.
+ * This must match the computation in t8_cmesh_uniform_bounds.
+ * For rank = mpisize, we return the global number of elements. */
+static              t8_gloidx_t
+t8_forest_partition_uniform_first_element (t8_gloidx_t global_num_elements,
+                                           int rank, int mpisize)
+{
+  if (rank == 0) {
+    return 0;
+  }
+  if (rank >= mpisize) {
+    return global_num_elements;
+  }
+  /* We cast to long double and double first to prevent integer overflow. */
+  return ((long double) global_num_elements * rank) / (double) mpisize;
+}
+
+void
+t8_forest_partition_create_uniform_offsets (t8_forest_t forest, int level)
+{
+  t8_gloidx_t        *element_offsets, *tree_offsets;
+  t8_linearidx_t     *first_desc;
+  t8_gloidx_t         children_per_tree, global_num_trees;
+  t8_gloidx_t         first_element, first_tree, child_in_tree;
+  sc_MPI_Comm         comm;
+  int                 iproc, next_nonempty;
+
+  T8_ASSERT (forest->element_offsets == NULL);
+  T8_ASSERT (forest->global_first_desc == NULL);
+  T8_ASSERT (forest->tree_offsets == NULL);
+  T8_ASSERT (0 <= level && level <= forest->maxlevel);
+
+  t8_debugf ("Building uniform offsets for forest %p\n", forest);
+  comm = forest->mpicomm;
+  global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
+  children_per_tree = ((t8_gloidx_t) 1) << forest->dimension * level;
+  T8_ASSERT (forest->global_num_elements ==
+             global_num_trees * children_per_tree);
+
+  element_offsets = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
+  tree_offsets = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
+  first_desc = T8_ALLOC (t8_linearidx_t, forest->mpisize);
+  for (iproc = 0; iproc <= forest->mpisize; iproc++) {
+    element_offsets[iproc] =
+      t8_forest_partition_uniform_first_element (forest->global_num_elements,
+                                                 iproc, forest->mpisize);
+  }
+  T8_ASSERT (element_offsets[forest->mpirank + 1] -
+             element_offsets[forest->mpirank] == forest->local_num_elements);
+
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (t8_forest_partition_empty (element_offsets, iproc)) {
+      /* Empty processes store 0 as first descendant and
+       * (temporarily) the global number of trees as tree offset */
+      first_desc[iproc] = 0;
+      tree_offsets[iproc] = global_num_trees;
+      continue;
+    }
+    first_element = element_offsets[iproc];
+    first_tree = first_element / children_per_tree;
+    child_in_tree = first_element - first_tree * children_per_tree;
+    /* The first tree is shared if and only if the first element is not
+     * the first element of its tree */
+    tree_offsets[iproc] =
+      t8_offset_first_tree_to_entry (first_tree, child_in_tree != 0);
+    /* The first descendant of the element with linear id child_in_tree
+     * has the linear id child_in_tree * 2^(dim * (maxlevel - level)) */
+    first_desc[iproc] = ((t8_linearidx_t) child_in_tree)
+      << forest->dimension * (forest->maxlevel - level);
+  }
+  tree_offsets[forest->mpisize] = global_num_trees;
+  /* Each empty process stores the first nonshared tree of the next
+   * nonempty process. See t8_forest_partition_create_tree_offsets */
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (t8_forest_partition_empty (element_offsets, iproc)) {
+      next_nonempty = iproc + 1;
+      while (next_nonempty < forest->mpisize
+             && tree_offsets[next_nonempty] >= global_num_trees) {
+        next_nonempty++;
+      }
+      tree_offsets[iproc] = t8_offset_first (next_nonempty, tree_offsets);
+      if (tree_offsets[next_nonempty] < 0) {
+        tree_offsets[iproc]++;
+      }
+    }
+  }
+#ifdef T8_ENABLE_DEBUG
+  if (forest->local_num_elements > 0) {
+    T8_ASSERT (t8_offset_first (forest->mpirank, tree_offsets) ==
+               forest->first_local_tree);
+  }
+#endif
+
+  /* Copy the arrays to shared memory */
+  t8_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                       forest->mpisize + 1, comm);
+  t8_shmem_array_copy_from (forest->element_offsets, element_offsets);
+  t8_shmem_array_init (&forest->global_first_desc, sizeof (t8_linearidx_t),
+                       forest->mpisize, comm);
+  t8_shmem_array_copy_from (forest->global_first_desc, first_desc);
+  t8_shmem_array_init (&forest->tree_offsets, sizeof (t8_gloidx_t),
+                       forest->mpisize + 1, comm);
+  t8_shmem_array_copy_from (forest->tree_offsets, tree_offsets);
+
+  T8_FREE (element_offsets);
+  T8_FREE (tree_offsets);
+  T8_FREE (first_desc);
+}
+
+/* Given a global element index of forest_from that is local on this
+ * process, return by how many elements a process boundary at this element
+ * has to be moved to the front, such that no family of elements is split.
+ * Only families that are completely local on this process are considered. */
+static              t8_gloidx_t
+t8_forest_partition_family_shift (t8_forest_t forest_from,
+                                  t8_gloidx_t gelement)
+{
+  t8_gloidx_t         first_local;
+  t8_locidx_t         lelement, ltree, el_in_tree, tree_count, family_start;
+  t8_element_t       *element, **family;
+  t8_eclass_scheme_c *ts;
+  int                 child_id, num_children, ichild, is_family;
+
+  first_local =
+    t8_forest_partition_first_element (t8_shmem_array_get_gloidx_array
+                                       (forest_from->element_offsets),
+                                       forest_from->mpirank);
+  lelement = (t8_locidx_t) (gelement - first_local);
+  T8_ASSERT (0 <= lelement && lelement < forest_from->local_num_elements);
+  element = t8_forest_get_element (forest_from, lelement, &ltree);
+  ts = t8_forest_get_eclass_scheme (forest_from,
+                                    t8_forest_get_tree_class (forest_from,
+                                                              ltree));
+  if (ts->t8_element_level (element) == 0) {
+    /* A root element is no member of a family */
+    return 0;
+  }
+  child_id = ts->t8_element_child_id (element);
+  if (child_id == 0) {
+    /* The boundary is in front of a family */
+    return 0;
+  }
+  num_children = ts->t8_element_num_children (element);
+  /* The family candidate must lie in the same tree */
+  el_in_tree = lelement - t8_forest_get_tree_element_offset (forest_from,
+                                                             ltree);
+  tree_count = t8_forest_get_tree_num_elements (forest_from, ltree);
+  family_start = el_in_tree - child_id;
+  if (family_start < 0 || family_start + num_children > tree_count) {
+    /* The family is not local, we cannot decide */
+    return 0;
+  }
+  family = T8_ALLOC (t8_element_t *, num_children);
+  is_family = 1;
+  for (ichild = 0; ichild < num_children; ichild++) {
+    family[ichild] =
+      t8_forest_get_element_in_tree (forest_from, ltree,
+                                     family_start + ichild);
+    if (ts->t8_element_child_id (family[ichild]) != ichild) {
+      is_family = 0;
+      break;
+    }
+  }
+  is_family = is_family && ts->t8_element_is_family (family);
+  T8_FREE (family);
+  return is_family ? child_id : 0;
+}
+
+/* Move the process boundaries in offsets to the front such that no
+ * family of elements of forest->set_from is split between two processes.
+ * Thus, each family can be coarsened process locally after partitioning.
+ * Each process checks the boundaries that lie in its local elements, then
+ * all shifts are combined with one allreduce. */
+static void
+t8_forest_partition_for_coarsening (t8_forest_t forest, t8_gloidx_t * offsets)
+{
+  t8_forest_t         forest_from;
+  t8_gloidx_t        *shifts, *shifts_global;
+  t8_gloidx_t         first_local, last_local;
+  int                 i, mpiret;
+
+  forest_from = forest->set_from;
+  shifts = T8_ALLOC_ZERO (t8_gloidx_t, forest->mpisize);
+  shifts_global = T8_ALLOC (t8_gloidx_t, forest->mpisize);
+  first_local =
+    t8_shmem_array_get_gloidx (forest_from->element_offsets,
+                               forest_from->mpirank);
+  last_local =
+    t8_shmem_array_get_gloidx (forest_from->element_offsets,
+                               forest_from->mpirank + 1) - 1;
+  /* The first boundary is always at element 0 */
+  for (i = 1; i < forest->mpisize; i++) {
+    if (first_local <= offsets[i] && offsets[i] <= last_local) {
+      shifts[i] = t8_forest_partition_family_shift (forest_from, offsets[i]);
+    }
+  }
+  /* Each boundary is local on at most one process */
+  mpiret = sc_MPI_Allreduce (shifts, shifts_global, forest->mpisize,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (i = 1; i < forest->mpisize; i++) {
+    offsets[i] -= shifts_global[i];
+  }
+  /* If a boundary moved in front of the previous one, the previous
+   * process gets no elements. */
+  for (i = forest->mpisize - 1; i > 0; i--) {
+    offsets[i] = SC_MIN (offsets[i], offsets[i + 1]);
+  }
+  T8_FREE (shifts);
+  T8_FREE (shifts_global);
+}
+
+/* The number of processes that get elements in the partition of forest.
+ * These are the processes with rank smaller than the returned value. */
+static int
+t8_forest_partition_num_active_ranks (t8_forest_t forest)
+{
+  if (forest->set_partition_num_ranks <= 0
+      || forest->set_partition_num_ranks > forest->mpisize) {
+    return forest->mpisize;
+  }
+  return forest->set_partition_num_ranks;
+}
+
+/* Compute the first element of each process for a partition in which the
+ * element weights are balanced and store them in offsets.
+ * An element whose predecessors in the SFC order have weight W_e is assigned to
+ * process floor (W_e * P / W), where W is the total weight and P the
+ * number of processes that get elements. Each process
+ * counts its elements that go to processes smaller than p, and the sum of
+ * these counts over all processes is the first element of p.
+ * Returns false if the total weight is zero and offsets was not changed. */
+static int
+t8_forest_partition_compute_weighted_offset (t8_forest_t forest,
+                                             t8_gloidx_t * offsets)
+{
+  t8_forest_t         forest_from;
+  t8_locidx_t         num_elements, num_trees, num_tree_elements;
+  t8_locidx_t         itree, ielement, lelement;
+  t8_eclass_scheme_c *ts;
+  t8_gloidx_t        *local_counts;
+  double             *weights, *proc_weights = NULL, *global_proc_weights;
+  double              local_weight = 0, weight_before, total_weight;
+  double              max_weight;
+  int                 mpisize, iproc, owner, mpiret;
+
+  forest_from = forest->set_from;
+  mpisize = t8_forest_partition_num_active_ranks (forest);
+  num_elements = t8_forest_get_num_element (forest_from);
+  num_trees = t8_forest_get_num_local_trees (forest_from);
+
+  /* Compute the weights of the local elements */
+  weights = T8_ALLOC (double, num_elements);
+  for (itree = 0, lelement = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest_from,
+                                      t8_forest_get_tree_class (forest_from,
+                                                                itree));
+    num_tree_elements = t8_forest_get_tree_num_elements (forest_from, itree);
+    for (ielement = 0; ielement < num_tree_elements; ielement++, lelement++) {
+      if (forest->set_partition_weight_fn != NULL) {
+        weights[lelement] =
+          forest->set_partition_weight_fn (forest_from, itree, ielement, ts,
+                                           t8_forest_get_element_in_tree
+                                           (forest_from, itree, ielement));
+      }
+      else {
+        weights[lelement] = forest->set_partition_weights[lelement];
+      }
+      T8_ASSERT (weights[lelement] >= 0);
+      local_weight += weights[lelement];
+    }
+  }
+  T8_ASSERT (lelement == num_elements);
+
+  /* Compute the weight of all elements on smaller ranks and
+   * the total weight */
+  mpiret = sc_MPI_Scan (&local_weight, &weight_before, 1, sc_MPI_DOUBLE,
+                        sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  weight_before -= local_weight;
+  mpiret = sc_MPI_Allreduce (&local_weight, &total_weight, 1, sc_MPI_DOUBLE,
+                             sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (total_weight <= 0) {
+    /* There is nothing to balance */
+    T8_FREE (weights);
+    return 0;
+  }
+
+  /* local_counts[p + 1] is the number of local elements assigned to p,
+   * only the first mpisize processes get elements */
+  local_counts = T8_ALLOC_ZERO (t8_gloidx_t, forest->mpisize + 1);
+  if (forest->profile != NULL) {
+    proc_weights = T8_ALLOC_ZERO (double, mpisize);
+  }
+  for (lelement = 0; lelement < num_elements; lelement++) {
+    owner = (int) (weight_before * mpisize / total_weight);
+    owner = SC_MAX (0, SC_MIN (owner, mpisize - 1));
+    local_counts[owner + 1]++;
+    if (proc_weights != NULL) {
+      proc_weights[owner] += weights[lelement];
+    }
+    weight_before += weights[lelement];
+  }
+  /* Since the owners are ascending, local_counts[p] is the number of local
+   * elements that go to processes smaller than p */
+  for (iproc = 1; iproc <= forest->mpisize; iproc++) {
+    local_counts[iproc] += local_counts[iproc - 1];
+  }
+  mpiret = sc_MPI_Allreduce (local_counts, offsets, forest->mpisize + 1,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  T8_ASSERT (offsets[0] == 0);
+  T8_ASSERT (offsets[mpisize] == forest_from->global_num_elements);
+  T8_ASSERT (offsets[forest->mpisize] == forest_from->global_num_elements);
+
+  if (proc_weights != NULL) {
+    /* Compute the ratio of the maximum and the average process weight */
+    global_proc_weights = T8_ALLOC (double, mpisize);
+    mpiret = sc_MPI_Allreduce (proc_weights, global_proc_weights, mpisize,
+                               sc_MPI_DOUBLE, sc_MPI_SUM, forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    max_weight = 0;
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      max_weight = SC_MAX (max_weight, global_proc_weights[iproc]);
+    }
+    forest->profile->partition_weight_imbalance =
+      max_weight * mpisize / total_weight;
+    T8_FREE (global_proc_weights);
+    T8_FREE (proc_weights);
+  }
+  T8_FREE (local_counts);
+  T8_FREE (weights);
+  return 1;
+}
+
+/* Change a new element offset array such that elements only move to
+ * neighboring processes. The first element of each process p is clamped
+ * to the range between the old first elements of p - 1 and p + 1.
+ * Since the new and the old offsets are non-decreasing, so are the clamped
+ * offsets. */
+static void
+t8_forest_partition_diffuse_offset (t8_forest_t forest, t8_gloidx_t * offsets)
+{
+  t8_gloidx_t        *offsets_old;
+  int                 iproc;
+
+  T8_ASSERT (forest->set_from->element_offsets != NULL);
+  offsets_old =
+    t8_shmem_array_get_gloidx_array (forest->set_from->element_offsets);
+  for (iproc = 1; iproc < forest->mpisize; iproc++) {
+    offsets[iproc] = SC_MAX (offsets[iproc], offsets_old[iproc - 1]);
+    offsets[iproc] = SC_MIN (offsets[iproc], offsets_old[iproc + 1]);
+  }
+}
+
 /* Calculate the new element_offset for forest from
  * the element in forest->set_from assuming a partition without
- * element weights */
+ * element weights.
+ * If forest->set_for_coarsening is true, no family of elements
+ * of forest->set_from is split in the new partition. */
 static void
 t8_forest_partition_compute_new_offset (t8_forest_t forest)
 {
   t8_forest_t         forest_from;
   sc_MPI_Comm         comm;
-  t8_gloidx_t         new_first_element_id;
-  int                 i, mpiret, mpisize;
+  t8_gloidx_t        *offsets;
+  int                 i, mpiret, mpisize, num_active;
 
   T8_ASSERT (t8_forest_is_initialized (forest));
   T8_ASSERT (forest->set_from != NULL);
@@ -343,19 +823,37 @@ t8_forest_partition_compute_new_offset (t8_forest_t forest)
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
   SC_CHECK_MPI (mpiret);
 
-  for (i = 0; i < mpisize; i++) {
-    /* Calculate the first element index for each process. We convert to doubles to
-     * prevent overflow */
-    new_first_element_id =
-      (((double) i *
-        (long double) forest_from->global_num_elements) / (double) mpisize);
-    T8_ASSERT (0 <= new_first_element_id &&
-               new_first_element_id < forest_from->global_num_elements);
-    t8_shmem_array_set_gloidx (forest->element_offsets, i,
-                               new_first_element_id);
+  offsets = T8_ALLOC (t8_gloidx_t, mpisize + 1);
+  if ((forest->set_partition_weight_fn == NULL
+       && forest->set_partition_weights == NULL)
+      || !t8_forest_partition_compute_weighted_offset (forest, offsets)) {
+    num_active = t8_forest_partition_num_active_ranks (forest);
+    for (i = 0; i < num_active; i++) {
+      /* Calculate the first element index for each process. We convert to doubles to
+       * prevent overflow */
+      offsets[i] =
+        (((double) i *
+          (long double) forest_from->global_num_elements) /
+         (double) num_active);
+      T8_ASSERT (0 <= offsets[i] &&
+                 offsets[i] < forest_from->global_num_elements);
+    }
+    /* The remaining processes are empty */
+    for (i = num_active; i <= mpisize; i++) {
+      offsets[i] = forest_from->global_num_elements;
+    }
   }
-  t8_shmem_array_set_gloidx (forest->element_offsets, forest->mpisize,
-                             forest->global_num_elements);
+  if (forest->set_partition_diffusive) {
+    SC_CHECK_ABORT (t8_forest_partition_num_active_ranks (forest) == mpisize,
+                    "A diffusive partition cannot be restricted to a subset"
+                    " of the processes.");
+    t8_forest_partition_diffuse_offset (forest, offsets);
+  }
+  if (forest->set_for_coarsening > 0) {
+    t8_forest_partition_for_coarsening (forest, offsets);
+  }
+  t8_shmem_array_copy_from (forest->element_offsets, offsets);
+  T8_FREE (offsets);
 }
 
 /* Find the owner of a given element.
@@ -485,7 +983,9 @@ t8_forest_partition_tree_first_last_el (t8_tree_t tree,
   return 0;
 }
 
-/* Fill the send buffers for one send operation.
+/* Fill the send buffer with the tree information for one send operation.
+ * The elements themselves are not copied, they are sent directly out of
+ * the tree element arrays, see t8_forest_partition_element_type.
  * \param [in]  forest_from     The original forest
  * \param [in]  send_buffer     Unallocated send_buffer
  * \param [out] buffer_alloc    The number of bytes in the send buffer
@@ -494,36 +994,43 @@ t8_forest_partition_tree_first_last_el (t8_tree_t tree,
  *                              we would send elements from to the next process.
  * \param [in]  first_element_send The local id of the first element that we need to send.
  * \param [in]  last_element_send The local id of the last element that we need to send.
+ * \param [out] element_bytes   The number of bytes of all elements that we send.
+ *                              0 if they are compressed into the send buffer.
+ * \param [in]  min_compress_bytes If nonzero and we send at least this many
+ *                              bytes of elements, we store their runs in the
+ *                              send buffer instead, if they are smaller.
  */
 /* The send buffer will look like this:
  *
- * | number of trees | padding | tree_1 info | ... | tree_n info | tree_1 elements | ... | tree_n elements |
+ * | num trees | run bytes | padding | tree_1 info | ... | tree_n info | runs |
+ *
+ * The runs of the elements of all trees, see t8_forest_element_runs_encode,
+ * are only present if the number of their bytes is not 0.
  */
-/* If send_data is true, data must be an array of length forest_from->num_local elements
- * and instead of shipping the elements of forest_from, we ship the data entries. */
 static void
 t8_forest_partition_fill_buffer (t8_forest_t forest_from,
                                  char **send_buffer, int *buffer_alloc,
                                  t8_locidx_t * current_tree,
                                  t8_locidx_t first_element_send,
-                                 t8_locidx_t last_element_send)
+                                 t8_locidx_t last_element_send,
+                                 size_t *element_bytes,
+                                 size_t min_compress_bytes)
 {
   t8_locidx_t         num_elements_send;
   t8_tree_t           tree;
   t8_locidx_t         current_element, tree_id, num_trees_send;
   t8_locidx_t         first_tree_element, last_tree_element;
-  int                 element_alloc, byte_alloc, tree_info_pos, element_pos;
+  int                 byte_alloc, tree_info_pos;
   int                 last_element_is_last_tree_element = 0;
   t8_forest_partition_tree_info_t *tree_info;
   t8_locidx_t        *pnum_trees_send;
-  void               *pfirst_element;
-  size_t              elem_size;
+  size_t              run_bytes;
 
   current_element = first_element_send;
   tree_id = *current_tree;
-  element_alloc = 0;
+  *element_bytes = 0;
   num_trees_send = 0;
-  /* At first we calculate the number of bytes that fit in the buffer */
+  /* At first we calculate the number of trees that we send */
   while (current_element <= last_element_send) {
     /* Get the first tree that we send elements from */
     tree = t8_forest_get_tree (forest_from, tree_id);
@@ -534,40 +1041,29 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
                                               *current_tree,
                                               &first_tree_element,
                                               &last_tree_element);
-    SC_CHECK_ABORT (tree->eclass != T8_ECLASS_PYRAMID,
-                    "Forest partition"
-                    " is not implement for pyramidal elements.");
     /* We now know how many elements this tree will send */
     num_elements_send = last_tree_element - first_tree_element + 1;
     T8_ASSERT (num_elements_send > 0);
-    elem_size = t8_element_array_get_size (&tree->elements);
-    element_alloc += num_elements_send * elem_size;
     current_element += num_elements_send;
     num_trees_send++;
     tree_id++;
   }
   /* We calculate the total number of bytes that we need to allocate
    * and allocate the buffer */
-  /* The buffer consists of the number of trees, ... */
-  byte_alloc = sizeof (t8_locidx_t);
+  /* The buffer consists of the number of trees, the bytes of the runs, ... */
+  byte_alloc = 2 * sizeof (t8_locidx_t);
   /* padding, ... */
   byte_alloc += T8_ADD_PADDING (byte_alloc);
   /* Store the position of the first tree info struct in the buffer */
   tree_info_pos = byte_alloc;
-  /* an info struct for each tree, ... */
+  /* and an info struct for each tree. */
   byte_alloc += num_trees_send * sizeof (t8_forest_partition_tree_info_t);
-  /* Store the position of the first element in the buffer */
-  element_pos = byte_alloc;
-  /* and the bytes for each tree's elements */
-  byte_alloc += element_alloc;
-  /* Note, that we do not add padding after the info structs and
-   * each tree's elements, since these are multiples of structs and
-   * structs are padded correctly */
   /* We allocate the buffer */
   *send_buffer = T8_ALLOC (char, byte_alloc);
   /* We store the number of trees at first in the send buffer */
   pnum_trees_send = (t8_locidx_t *) * send_buffer;
-  *pnum_trees_send = num_trees_send;
+  pnum_trees_send[0] = num_trees_send;
+  pnum_trees_send[1] = 0;
   for (tree_id = 0; tree_id < num_trees_send; tree_id++) {
     /* Get the first tree that we send elements from */
     tree = t8_forest_get_tree (forest_from, tree_id + *current_tree);
@@ -590,20 +1086,174 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
     tree_info->gtree_id = tree_id + *current_tree +
       forest_from->first_local_tree;
     tree_info->num_elements = num_elements_send;
+    tree_info->first_element = first_tree_element;
     tree_info_pos += sizeof (t8_forest_partition_tree_info_t);
-    /* We can now fill the send buffer with all elements of that tree */
-    pfirst_element =
-      t8_element_array_index_locidx (&tree->elements, first_tree_element);
-    elem_size = t8_element_array_get_size (&tree->elements);
-    memcpy (*send_buffer + element_pos, pfirst_element,
-            num_elements_send * elem_size);
-    element_pos += num_elements_send * elem_size;
+    *element_bytes +=
+      num_elements_send * t8_element_array_get_size (&tree->elements);
+  }
+  if (min_compress_bytes > 0 && *element_bytes >= min_compress_bytes) {
+    /* Count the bytes of the runs of the elements */
+    tree_info = (t8_forest_partition_tree_info_t *)
+      (*send_buffer + byte_alloc -
+       num_trees_send * sizeof (t8_forest_partition_tree_info_t));
+    run_bytes = 0;
+    for (tree_id = 0; tree_id < num_trees_send; tree_id++) {
+      tree = t8_forest_get_tree (forest_from, tree_id + *current_tree);
+      run_bytes +=
+        t8_forest_element_runs_encode (t8_element_array_get_scheme
+                                       (&tree->elements),
+                                       t8_element_array_index_locidx
+                                       (&tree->elements,
+                                        tree_info[tree_id].first_element),
+                                       tree_info[tree_id].num_elements,
+                                       NULL);
+    }
+    if (run_bytes < *element_bytes) {
+      /* Append the runs to the buffer, the elements are not sent */
+      *send_buffer = T8_REALLOC (*send_buffer, char, byte_alloc + run_bytes);
+      tree_info = (t8_forest_partition_tree_info_t *)
+        (*send_buffer + byte_alloc -
+         num_trees_send * sizeof (t8_forest_partition_tree_info_t));
+      ((t8_locidx_t *) * send_buffer)[1] = run_bytes;
+      for (tree_id = 0; tree_id < num_trees_send; tree_id++) {
+        tree = t8_forest_get_tree (forest_from, tree_id + *current_tree);
+        byte_alloc +=
+          t8_forest_element_runs_encode (t8_element_array_get_scheme
+                                         (&tree->elements),
+                                         t8_element_array_index_locidx
+                                         (&tree->elements,
+                                          tree_info[tree_id].first_element),
+                                         tree_info[tree_id].num_elements,
+                                         *send_buffer + byte_alloc);
+      }
+      *element_bytes = 0;
+    }
   }
   *current_tree += num_trees_send - 1 + last_element_is_last_tree_element;
   *buffer_alloc = byte_alloc;
   t8_debugf ("Post send of %i trees\n", num_trees_send);
 }
 
+/* Compute the memory ranges of the elements and the registered data that
+ * are sent with a message whose tree information was filled with
+ * t8_forest_partition_fill_buffer. There is one range for each tree followed
+ * by one range for each data array registered with
+ * t8_forest_set_partition_data. The ranges point into forest->set_from and
+ * the data arrays, ranges and range_bytes must be freed after use. */
+static void
+t8_forest_partition_source_ranges (t8_forest_t forest,
+                                   const char *send_buffer,
+                                   t8_locidx_t * num_ranges, void ***ranges,
+                                   int **range_bytes)
+{
+  const t8_forest_partition_tree_info_t *tree_info;
+  const t8_forest_partition_data_t *field;
+  t8_forest_t         forest_from = forest->set_from;
+  t8_locidx_t         num_trees, itree, first_element, num_elements = 0;
+  size_t              num_fields, ifield;
+  t8_tree_t           tree;
+  int                 compressed;
+
+  num_trees = ((const t8_locidx_t *) send_buffer)[0];
+  /* If the elements were compressed, they are not sent in ranges */
+  compressed = ((const t8_locidx_t *) send_buffer)[1] > 0;
+  tree_info = (const t8_forest_partition_tree_info_t *)
+    (send_buffer + 2 * sizeof (t8_locidx_t) +
+     T8_ADD_PADDING (2 * sizeof (t8_locidx_t)));
+  num_fields = forest->set_partition_data == NULL ? 0 :
+    forest->set_partition_data->elem_count;
+  *num_ranges = num_trees + num_fields;
+  *ranges = T8_ALLOC (void *, *num_ranges);
+  *range_bytes = T8_ALLOC (int, *num_ranges);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest_from, tree_info[itree].gtree_id
+                               - forest_from->first_local_tree);
+    (*ranges)[itree] =
+      t8_element_array_index_locidx (&tree->elements,
+                                     tree_info[itree].first_element);
+    (*range_bytes)[itree] = compressed ? 0 : tree_info[itree].num_elements *
+      t8_element_array_get_size (&tree->elements);
+    num_elements += tree_info[itree].num_elements;
+  }
+  if (num_fields > 0) {
+    /* The sent elements are contiguous in the local elements */
+    tree = t8_forest_get_tree (forest_from, tree_info[0].gtree_id
+                               - forest_from->first_local_tree);
+    first_element = tree->elements_offset + tree_info[0].first_element;
+    for (ifield = 0; ifield < num_fields; ifield++) {
+      field = (const t8_forest_partition_data_t *)
+        sc_array_index (forest->set_partition_data, ifield);
+      (*ranges)[num_trees + ifield] =
+        t8_sc_array_index_locidx ((sc_array_t *) field->data_in,
+                                  first_element);
+      (*range_bytes)[num_trees + ifield] =
+        num_elements * field->data_in->elem_size;
+    }
+  }
+}
+
+#ifdef T8_FOREST_PARTITION_ELEMENT_TYPE
+/* Create and commit an MPI datatype that covers the element ranges of a
+ * message in place, relative to MPI_BOTTOM.
+ * \param [in]  num_ranges  The number of element ranges.
+ * \param [in]  ranges      The first element of each range.
+ * \param [in]  range_bytes The number of bytes of each range.
+ * \return                  The committed datatype. It must be freed with
+ *                          MPI_Type_free.
+ */
+static              MPI_Datatype
+t8_forest_partition_element_type (t8_locidx_t num_ranges, void **ranges,
+                                  int *range_bytes)
+{
+  MPI_Datatype        element_type;
+  MPI_Aint           *displacements;
+  t8_locidx_t         irange;
+  int                 mpiret;
+
+  displacements = T8_ALLOC (MPI_Aint, num_ranges);
+  for (irange = 0; irange < num_ranges; irange++) {
+    mpiret = MPI_Get_address (ranges[irange], displacements + irange);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_Type_create_hindexed (num_ranges, range_bytes, displacements,
+                                     MPI_BYTE, &element_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&element_type);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (displacements);
+  return element_type;
+}
+
+/* Post the send of the elements of a message whose tree information
+ * was filled with t8_forest_partition_fill_buffer.
+ * The elements and the registered data are sent directly from the trees
+ * and the data arrays of forest->set_from. */
+static void
+t8_forest_partition_send_elements (t8_forest_t forest,
+                                   const char *send_buffer, int iproc,
+                                   sc_MPI_Request * request)
+{
+  void              **ranges;
+  int                *range_bytes;
+  t8_locidx_t         num_ranges;
+  MPI_Datatype        element_type;
+  int                 mpiret;
+
+  t8_forest_partition_source_ranges (forest, send_buffer, &num_ranges,
+                                     &ranges, &range_bytes);
+  element_type =
+    t8_forest_partition_element_type (num_ranges, ranges, range_bytes);
+  mpiret = MPI_Isend (MPI_BOTTOM, 1, element_type, iproc,
+                      T8_MPI_PARTITION_ELEMENTS, forest->mpicomm, request);
+  SC_CHECK_MPI (mpiret);
+  /* The type is only released after the send completed */
+  mpiret = MPI_Type_free (&element_type);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (ranges);
+  T8_FREE (range_bytes);
+}
+#endif
+
 /* Fill the send buffers for one send operation in send_data mode.
  * \param [in]  forest_from     The original forest
  * \param [in]  send_buffer     Unallocated send_buffer
@@ -642,6 +1292,9 @@ t8_forest_partition_fill_buffer_data (t8_forest_t forest_from,
 /* Carry out all sending of elements */
 /* If send_data is true, the elements are not send but element data
  * stored in an sc_array of length forest->set_from->num_local_elements.
+ * For each process that we send to there are two requests, one for the
+ * tree information and one for the elements, which are stored after all
+ * tree information requests.
  * Returns true if we sent to ourselves. */
 static int
 t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
@@ -661,7 +1314,8 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
   char              **buffer;
   int                 buffer_alloc;
   sc_MPI_Comm         comm;
-  int                 to_self = 0;
+  int                 to_self = 0, num_send;
+  size_t              element_bytes = 0;
 
   t8_debugf ("Start send loop\n");
   /* If send_data is false, the forest must not be committed but initialized.
@@ -678,13 +1332,14 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
 
   comm = forest->mpicomm;
   /* Determine the number of requests for MPI communication. */
-  *num_request_alloc = send_last - send_first + 1;
-  if (*num_request_alloc < 0) {
+  num_send = send_last - send_first + 1;
+  if (num_send < 0) {
     /* If there are no processes to send to, this value could get
      * negative */
-    *num_request_alloc = 0;
+    num_send = 0;
     T8_ASSERT (send_last - send_first + 1 == 0);
   }
+  *num_request_alloc = 2 * num_send;
   *requests = T8_ALLOC (sc_MPI_Request, *num_request_alloc);
 
   /* Allocate memory for pointers to the send buffers */
@@ -741,11 +1396,14 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
       }
       if (!send_data) {
         /* Fill the buffer with the elements and calculate the next tree
-         * from which to send elements */
+         * from which to send elements. The elements that we keep are
+         * copied and not compressed. */
         t8_forest_partition_fill_buffer (forest_from,
                                          buffer, &buffer_alloc,
                                          &current_tree, first_element_send,
-                                         last_element_send);
+                                         last_element_send, &element_bytes,
+                                         iproc != forest->mpirank ?
+                                         forest->message_compression : 0);
       }
       else {
         T8_ASSERT (send_data);
@@ -764,10 +1422,30 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
                                T8_MPI_PARTITION_FOREST, comm,
                                *requests + iproc - send_first);
         SC_CHECK_MPI (mpiret);
+        /* The tree information and, if not in data mode, the elements */
+        t8_profile_comm_sent (forest->profile == NULL ? NULL :
+                              &forest->profile->comm
+                              [T8_PROFILE_COMM_PARTITION],
+                              send_data ? 1 : 2,
+                              buffer_alloc + (send_data ? 0 : element_bytes));
+        if (!send_data) {
+#ifdef T8_FOREST_PARTITION_ELEMENT_TYPE
+          /* Send the elements directly out of the trees */
+          t8_forest_partition_send_elements (forest, *buffer, iproc,
+                                             *requests + num_send +
+                                             iproc - send_first);
+#else
+          SC_ABORT_NOT_REACHED ();
+#endif
+        }
+        else {
+          *(*requests + num_send + iproc - send_first) = sc_MPI_REQUEST_NULL;
+        }
       }
       else {
         *byte_to_self = buffer_alloc;
         *(*requests + iproc - send_first) = sc_MPI_REQUEST_NULL;
+        *(*requests + num_send + iproc - send_first) = sc_MPI_REQUEST_NULL;
       }
       if (!send_data && forest->profile != NULL) {
         if (iproc != forest->mpirank) {
@@ -777,15 +1455,17 @@ t8_forest_partition_sendloop (t8_forest_t forest, const int send_first,
           /* The number of procs we send to */
           forest->profile->partition_procs_sent += 1;
           /* The number of bytes that we send */
-          forest->profile->partition_bytes_sent += buffer_alloc;
+          forest->profile->partition_bytes_sent +=
+            buffer_alloc + element_bytes;
         }
       }
     }
     else {
       /* We do not send any elements to iproc (iproc is empty in new partition) */
-      /* Set the request to NULL, such that it is ignored when we wait for
+      /* Set the requests to NULL, such that they are ignored when we wait for
        * the requests to complete */
       *(*requests + iproc - send_first) = sc_MPI_REQUEST_NULL;
+      *(*requests + num_send + iproc - send_first) = sc_MPI_REQUEST_NULL;
     }
   }
   t8_debugf ("End send loop\n");
@@ -843,6 +1523,9 @@ t8_forest_partition_recv_message_data (t8_forest_t forest, sc_MPI_Comm comm,
                           T8_MPI_PARTITION_FOREST, comm,
                           sc_MPI_STATUS_IGNORE);
     SC_CHECK_MPI (mpiret);
+    t8_profile_comm_received (forest->profile == NULL ? NULL :
+                              &forest->profile->comm
+                              [T8_PROFILE_COMM_PARTITION], 1, recv_bytes);
   }
   else {
     recv_buffer = sent_to_self;
@@ -874,6 +1557,10 @@ t8_forest_partition_recv_message_data (t8_forest_t forest, sc_MPI_Comm comm,
  *                          should be passed as this parameter.
  * \param [in]  byte_to_self If proc equals the rank of this process, the number of
  *                          bytes in the message.
+ * The message only contains the tree information. We grow the element arrays
+ * of the trees and receive the elements and the registered data directly into
+ * them. The elements that we send to ourselves are copied from
+ * forest->set_from.
  * It is important, that we receive the messages in order to properly fill the
  * forest->trees array.
  */
@@ -888,13 +1575,18 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
   char               *recv_buffer;
   t8_locidx_t         num_trees, itree;
   t8_locidx_t         num_elements_recv;
-  t8_locidx_t         old_num_elements, new_num_elements;
-  size_t              tree_cursor, element_cursor;
+  t8_locidx_t         old_num_elements;
+  size_t              tree_cursor;
   t8_forest_partition_tree_info_t *tree_info;
+  t8_locidx_t         first_element_recv;
   t8_tree_t           tree, last_tree;
-  size_t              element_size;
-  void               *first_new_element;
   t8_eclass_scheme_c *eclass_scheme;
+  t8_forest_partition_data_t *field;
+  size_t              num_fields, ifield;
+  void              **ranges;
+  int                *range_bytes;
+  t8_locidx_t         run_bytes;
+  const char         *run_pos;
 
   if (proc != forest->mpirank) {
     T8_ASSERT (proc == status->MPI_SOURCE);
@@ -902,11 +1594,6 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
     /* Get the number of bytes to receive */
     mpiret = sc_MPI_Get_count (status, sc_MPI_BYTE, &recv_bytes);
     SC_CHECK_MPI (mpiret);
-  }
-  t8_debugf ("Receiving message of %i bytes from process %i\n", recv_bytes,
-             proc);
-
-  if (proc != forest->mpirank) {
     /* allocate the receive buffer */
     recv_buffer = T8_ALLOC (char, recv_bytes);
     /* receive the message */
@@ -919,13 +1606,28 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
     recv_buffer = sent_to_self;
     recv_bytes = byte_to_self;
   }
-  /* Read the number of trees, it is the first locidx_t in recv_buffer */
-  num_trees = *(t8_locidx_t *) recv_buffer;
+  t8_debugf ("Receiving message of %i bytes from process %i\n", recv_bytes,
+             proc);
+  /* Read the number of trees, it is the first locidx_t in recv_buffer,
+   * followed by the number of bytes of the runs of compressed elements */
+  num_trees = ((t8_locidx_t *) recv_buffer)[0];
+  run_bytes = ((t8_locidx_t *) recv_buffer)[1];
   /* Set the tree cursor to the first tree info entry in recv_buffer */
-  tree_cursor = sizeof (t8_locidx_t) + T8_ADD_PADDING (sizeof (t8_locidx_t));
-  /* Set the element cursor to the first element entry in recv_buffer */
-  element_cursor = tree_cursor +
-    num_trees * sizeof (t8_forest_partition_tree_info_t);
+  tree_cursor =
+    2 * sizeof (t8_locidx_t) + T8_ADD_PADDING (2 * sizeof (t8_locidx_t));
+  T8_ASSERT (tree_cursor +
+             num_trees * sizeof (t8_forest_partition_tree_info_t) +
+             run_bytes == (size_t) recv_bytes);
+  /* The runs follow the tree info entries */
+  run_pos = recv_buffer + tree_cursor
+    + num_trees * sizeof (t8_forest_partition_tree_info_t);
+  /* The position and byte count of the received elements of each tree,
+   * followed by those of the registered data arrays */
+  num_fields = forest->set_partition_data == NULL ? 0 :
+    forest->set_partition_data->elem_count;
+  ranges = T8_ALLOC (void *, num_trees + num_fields);
+  range_bytes = T8_ALLOC (int, num_trees + num_fields);
+  first_element_recv = forest->local_num_elements;
   /* Get the information for the first tree */
   tree_info = (t8_forest_partition_tree_info_t *) (recv_buffer + tree_cursor);
   if (prev_recvd == 0) {
@@ -939,6 +1641,9 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
   for (itree = 0; itree < num_trees; itree++) {
     num_elements_recv += tree_info->num_elements;
     T8_ASSERT (tree_info->gtree_id >= forest->last_local_tree);
+    /* Get the scheme of the tree */
+    eclass_scheme =
+      t8_forest_get_eclass_scheme (forest->set_from, tree_info->eclass);
     if (tree_info->gtree_id > forest->last_local_tree) {
       /* We will insert a new tree in the forest */
       tree = (t8_tree_t) sc_array_push (forest->trees);
@@ -961,24 +1666,10 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
         tree->elements_offset = 0;
       }
       /* Done calculating the element offset */
-      /* Get the size of an element of the tree */
-      eclass_scheme =
-        t8_forest_get_eclass_scheme (forest->set_from, tree->eclass);
-      element_size = eclass_scheme->t8_element_size ();
-      /* initialize the elements array and copy the elements from the receive buffer */
-      T8_ASSERT (element_cursor + tree_info->num_elements * element_size <=
-                 (size_t) recv_bytes);
-      t8_debugf ("[H} init array for tree %i\n", itree);
-      t8_element_array_init_copy (&tree->elements, eclass_scheme,
-                                  (t8_element_t *) (recv_buffer +
-                                                    element_cursor),
-                                  tree_info->num_elements);
-#if 0
-      /* Debugging output */
-      t8_debugf ("receive %li elements for tree %lli\n",
-                 (long) tree_info->num_elements,
-                 (long long) tree_info->gtree_id);
-#endif
+      /* initialize the elements array with space for the received elements */
+      t8_forest_init_tree_elements (forest, &tree->elements, eclass_scheme,
+                                    tree_info->num_elements);
+      old_num_elements = 0;
     }
     else {
       T8_ASSERT (itree == 0);   /* This situation only happens for the first tree */
@@ -990,43 +1681,96 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
                                  - forest->first_local_tree);
       /* assert for correctness */
       T8_ASSERT (tree->eclass == tree_info->eclass);
-      /* Get the old number of elements in the tree and calculate the new number */
+      /* Get the old number of elements in the tree and enlarge the
+       * elements array */
       old_num_elements = t8_forest_get_tree_element_count (tree);
-      new_num_elements = old_num_elements + tree_info->num_elements;
-      /* Enlarge the elements array */
-      t8_element_array_resize (&tree->elements, new_num_elements);
-      first_new_element = t8_element_array_index_locidx (&tree->elements,
-                                                         old_num_elements);
-#if 0
-      /* Debugging output */
-      t8_debugf ("receive %li elements for tree %lli\n",
-                 (long) tree_info->num_elements,
-                 (long long) tree_info->gtree_id);
-#endif
-      /* Get the size of an element of the tree */
-      eclass_scheme =
-        t8_forest_get_eclass_scheme (forest->set_from, tree->eclass);
-      element_size = eclass_scheme->t8_element_size ();
-      T8_ASSERT (element_size == t8_element_array_get_size (&tree->elements));
-      /* Copy the elements from the receive buffer to the elements array */
-      memcpy (first_new_element, recv_buffer + element_cursor,
-              tree_info->num_elements * element_size);
+      t8_element_array_resize (&tree->elements,
+                               old_num_elements + tree_info->num_elements);
+    }
+    T8_ASSERT (eclass_scheme->t8_element_size () ==
+               t8_element_array_get_size (&tree->elements));
+    /* The received elements of this tree are stored here */
+    ranges[itree] =
+      t8_element_array_index_locidx (&tree->elements, old_num_elements);
+    range_bytes[itree] =
+      tree_info->num_elements * eclass_scheme->t8_element_size ();
+    if (run_bytes > 0) {
+      /* The elements are not sent separately, we decode them from the runs */
+      run_pos += t8_forest_element_runs_decode (eclass_scheme, run_pos,
+                                                tree_info->num_elements,
+                                                (t8_element_t *)
+                                                ranges[itree]);
+      range_bytes[itree] = 0;
     }
 
     /* compute the new number of local elements */
     forest->local_num_elements += tree_info->num_elements;
     /* Set the new last local tree */
     forest->last_local_tree = tree_info->gtree_id;
-    /* advance the element cursor */
-    element_cursor += element_size * tree_info->num_elements;
     /* Advance to the next tree_info entry in the recv buffer */
     tree_cursor += sizeof (t8_forest_partition_tree_info_t);
     tree_info += 1;
   }
+  /* The received data is stored after the data of the previous messages */
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    field = (t8_forest_partition_data_t *)
+      sc_array_index (forest->set_partition_data, ifield);
+    ranges[num_trees + ifield] =
+      t8_sc_array_index_locidx (field->data_out, first_element_recv);
+    range_bytes[num_trees + ifield] =
+      num_elements_recv * field->data_out->elem_size;
+  }
 
   if (proc != forest->mpirank) {
+#ifdef T8_FOREST_PARTITION_ELEMENT_TYPE
+    MPI_Datatype        element_type;
+
+    /* Receive the elements and data directly into the trees and arrays */
+    element_type =
+      t8_forest_partition_element_type (num_trees + num_fields, ranges,
+                                        range_bytes);
+    mpiret = MPI_Recv (MPI_BOTTOM, 1, element_type, proc,
+                       T8_MPI_PARTITION_ELEMENTS, comm, MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Type_free (&element_type);
+    SC_CHECK_MPI (mpiret);
+#else
+    SC_ABORT_NOT_REACHED ();
+#endif
+    {
+      size_t              element_bytes = 0;
+      t8_locidx_t         irange;
+
+      /* The tree information and the elements */
+      for (irange = 0; irange < (t8_locidx_t) (num_trees + num_fields);
+           irange++) {
+        element_bytes += range_bytes[irange];
+      }
+      t8_profile_comm_received (forest->profile == NULL ? NULL :
+                                &forest->profile->comm
+                                [T8_PROFILE_COMM_PARTITION], 2,
+                                recv_bytes + element_bytes);
+    }
     T8_FREE (recv_buffer);
   }
+  else {
+    void              **source_ranges;
+    int                *source_bytes;
+    t8_locidx_t         num_ranges, irange;
+
+    /* Copy our own elements and data from forest_from */
+    t8_forest_partition_source_ranges (forest, recv_buffer, &num_ranges,
+                                       &source_ranges, &source_bytes);
+    T8_ASSERT (num_ranges == (t8_locidx_t) (num_trees + num_fields));
+    for (irange = 0; irange < num_ranges; irange++) {
+      T8_ASSERT (source_bytes[irange] == range_bytes[irange]);
+      memcpy (ranges[irange], source_ranges[irange], range_bytes[irange]);
+    }
+    T8_FREE (source_ranges);
+    T8_FREE (source_bytes);
+  }
+  T8_FREE (ranges);
+  T8_FREE (range_bytes);
   if (forest->profile != NULL) {
     if (proc != forest->mpirank) {
       /* If profiling is enabled we count the number of elements received from
@@ -1133,10 +1877,12 @@ t8_forest_partition_given (t8_forest_t forest, const int send_data,
   t8_debugf ("send_last = %i\n", send_last);
 
   /* Send all elements to other ranks */
+  t8_profile_region_begin ("partition_send");
   to_self =
     t8_forest_partition_sendloop (forest, send_first, send_last, &requests,
                                   &num_request_alloc, &send_buffer, send_data,
                                   data_in, &byte_to_self);
+  t8_profile_region_end ("partition_send");
   if (to_self) {
     /* We have sent data to ourselves. */
     sent_to_self = *(send_buffer + forest->mpirank - send_first);
@@ -1154,12 +1900,28 @@ t8_forest_partition_given (t8_forest_t forest, const int send_data,
   else {
     num_new_elements = t8_forest_get_num_element (forest);
   }
+  if (!send_data && forest->set_partition_data != NULL) {
+    size_t              ifield;
+    t8_forest_partition_data_t *field;
+
+    /* Make room for the registered data of the new elements */
+    for (ifield = 0; ifield < forest->set_partition_data->elem_count;
+         ifield++) {
+      field = (t8_forest_partition_data_t *)
+        sc_array_index (forest->set_partition_data, ifield);
+      T8_ASSERT (field->data_in->elem_count ==
+                 (size_t) forest->set_from->local_num_elements);
+      sc_array_resize (field->data_out, num_new_elements);
+    }
+  }
 
   if (num_new_elements > 0) {
     /* Receive all element from other ranks */
     t8_forest_partition_recvrange (forest, &recv_first, &recv_last);
+    t8_profile_region_begin ("partition_recv");
     t8_forest_partition_recvloop (forest, recv_first, recv_last, send_data,
                                   data_out, sent_to_self, byte_to_self);
+    t8_profile_region_end ("partition_recv");
   }
   else if (!send_data) {
     /* This forest is empty, set first and last local tree such
@@ -1171,12 +1933,15 @@ t8_forest_partition_given (t8_forest_t forest, const int send_data,
   /* Wait for all sends to complete */
   t8_debugf ("[HH] waiting...\n");
   if (num_request_alloc > 0) {
+    t8_profile_region_begin ("partition_wait");
     mpiret =
       sc_MPI_Waitall (num_request_alloc, requests, sc_MPI_STATUSES_IGNORE);
     SC_CHECK_MPI (mpiret);
+    t8_profile_region_end ("partition_wait");
   }
   T8_FREE (requests);
-  for (i = 0; i < num_request_alloc; i++) {
+  /* There are two requests for each send buffer */
+  for (i = 0; i < num_request_alloc / 2; i++) {
     T8_FREE (send_buffer[i]);
   }
   T8_FREE (send_buffer);
@@ -1201,6 +1966,7 @@ t8_forest_partition (t8_forest_t forest)
   forest_from = forest->set_from;
   T8_ASSERT (t8_forest_is_committed (forest_from));
 
+  t8_profile_region_begin ("partition");
   if (forest->profile != NULL) {
     /* If profiling is enabled, we measure the runtime of partition */
     forest->profile->partition_runtime = sc_MPI_Wtime ();
@@ -1246,6 +2012,13 @@ t8_forest_partition (t8_forest_t forest)
     t8_global_productionf ("End partition %f %f\n", sc_MPI_Wtime (),
                            forest->profile->partition_runtime);
   }
+  t8_profile_region_end ("partition");
+  if (forest->profile != NULL) {
+    t8_profile_regions_last_hw_counters (forest->profile->hw_counters
+                                         [T8_PROFILE_HW_PARTITION]);
+    forest->profile->memory_peak[T8_PROFILE_HW_PARTITION] =
+      t8_profile_regions_last_memory_peak ();
+  }
 
   t8_log_indent_pop ();
   t8_global_productionf ("Done forest partition.\n");
@@ -1292,4 +2065,116 @@ t8_forest_partition_data (t8_forest_t forest_from, t8_forest_t forest_to,
   t8_global_productionf ("Done forest partition data.\n");
 }
 
+int
+t8_forest_partition_skip (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  t8_locidx_t         max_num_elements;
+  double              imbalance;
+  int                 mpiret;
+
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  forest_from = forest->set_from;
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+
+  if (forest->set_partition_threshold < 1
+      || t8_forest_partition_num_active_ranks (forest) < forest->mpisize) {
+    /* Every imbalance is at least 1, we always partition.
+     * If only a subset of the processes gets elements, we always
+     * partition as well. */
+    return 0;
+  }
+  if (forest_from->global_num_elements == 0) {
+    /* There is nothing to partition */
+    return 1;
+  }
+  mpiret = sc_MPI_Allreduce (&forest_from->local_num_elements,
+                             &max_num_elements, 1, T8_MPI_LOCIDX, sc_MPI_MAX,
+                             forest_from->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  imbalance = max_num_elements * (double) forest_from->mpisize /
+    forest_from->global_num_elements;
+  t8_global_productionf ("Forest element imbalance is %f, threshold %f.\n",
+                         imbalance, forest->set_partition_threshold);
+  return imbalance <= forest->set_partition_threshold;
+}
+
+void
+t8_forest_partition_stats (t8_forest_t forest,
+                           t8_forest_partition_stats_t * stats)
+{
+  t8_locidx_t         itree, ielement, num_elements, num_trees;
+  t8_element_t       *element;
+  t8_eclass_scheme_c *ts;
+  t8_gloidx_t         num_remote_faces;
+  sc_array_t          owners;
+  size_t              iowner;
+  double              local_values[4], max_values[4], average;
+  int                 iface, num_faces, is_remote, mpiret;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (stats != NULL);
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "Partition statistics need a ghost layer.\n");
+
+  stats->num_elements = t8_forest_get_num_element (forest);
+  stats->num_ghosts = t8_forest_get_num_ghosts (forest);
+  stats->num_remote_faces = 0;
+  stats->num_neighbor_ranks = 0;
+  if (forest->mpisize > 1) {
+    (void) t8_forest_ghost_get_remotes (forest, &stats->num_neighbor_ranks);
+    /* Count the faces of local elements at which at least one
+     * face neighbor leaf is owned by another process */
+    sc_array_init (&owners, sizeof (int));
+    num_trees = t8_forest_get_num_local_trees (forest);
+    for (itree = 0; itree < num_trees; itree++) {
+      ts = t8_forest_get_eclass_scheme (forest,
+                                        t8_forest_get_tree_class (forest,
+                                                                  itree));
+      num_elements = t8_forest_get_tree_num_elements (forest, itree);
+      for (ielement = 0; ielement < num_elements; ielement++) {
+        element = t8_forest_get_element_in_tree (forest, itree, ielement);
+        num_faces = ts->t8_element_num_faces (element);
+        for (iface = 0; iface < num_faces; iface++) {
+          /* An empty owners array means that no bounds are known */
+          sc_array_truncate (&owners);
+          t8_forest_element_owners_at_neigh_face (forest, itree, element,
+                                                  iface, &owners);
+          for (iowner = 0, is_remote = 0;
+               iowner < owners.elem_count && !is_remote; iowner++) {
+            is_remote =
+              *(int *) sc_array_index (&owners, iowner) != forest->mpirank;
+          }
+          stats->num_remote_faces += is_remote;
+        }
+      }
+    }
+    sc_array_reset (&owners);
+  }
+  stats->surface_to_volume = stats->num_elements > 0 ?
+    stats->num_remote_faces / (double) stats->num_elements : 0;
+  stats->ghost_ratio = stats->num_elements > 0 ?
+    stats->num_ghosts / (double) stats->num_elements : 0;
+
+  /* Compute the global values with one maximum and one sum reduction */
+  local_values[0] = stats->num_elements;
+  local_values[1] = stats->num_neighbor_ranks;
+  local_values[2] = stats->surface_to_volume;
+  local_values[3] = stats->ghost_ratio;
+  mpiret = sc_MPI_Allreduce (local_values, max_values, 4, sc_MPI_DOUBLE,
+                             sc_MPI_MAX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  num_remote_faces = stats->num_remote_faces;
+  mpiret = sc_MPI_Allreduce (&num_remote_faces,
+                             &stats->global_num_remote_faces, 1,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  average = forest->global_num_elements / (double) forest->mpisize;
+  stats->element_imbalance = average > 0 ? max_values[0] / average : 1;
+  stats->max_neighbor_ranks = (int) max_values[1];
+  stats->max_surface_to_volume = max_values[2];
+  stats->max_ghost_ratio = max_values[3];
+}
+
 T8_EXTERN_C_END ();
@@ -36,6 +36,15 @@ T8_EXTERN_C_BEGIN ();
 /* TODO: document */
 void                t8_forest_partition (t8_forest_t forest);
 
+/** Decide whether the partition of a forest can be skipped, since the
+ * element imbalance of its source forest is at most the threshold set
+ * with \ref t8_forest_set_partition_threshold.
+ * \param [in]      forest The forest. Its \a set_from must be committed.
+ * \return                 True if the partition should be skipped.
+ * This function is MPI collective if a nonzero threshold is set.
+ */
+int                 t8_forest_partition_skip (t8_forest_t forest);
+
 /** Create the element_offset array of a partitioned forest.
  * \param [in,out]  forest The forest.
  * \a forest must be committed before calling this function.
@@ -69,6 +78,33 @@ void                t8_forest_partition_create_first_desc (t8_forest_t
 void                t8_forest_partition_create_tree_offsets (t8_forest_t
                                                              forest);
 
+/** Create the element offsets, the tree offsets and the global first
+ * descendants of a partitioned forest, as far as they do not exist yet.
+ * All three arrays are filled from one allgather of the element count,
+ * first tree and first descendant of each process, instead of one
+ * collective per array as in \ref t8_forest_partition_create_offsets,
+ * \ref t8_forest_partition_create_tree_offsets and
+ * \ref t8_forest_partition_create_first_desc.
+ * If all arrays exist, this function does not communicate.
+ * \param [in,out]  forest The forest.
+ * \a forest must be committed before calling this function.
+ */
+void                t8_forest_partition_create_all_offsets (t8_forest_t
+                                                            forest);
+
+/** Create the element offsets, global first descendants and tree offsets
+ * of a uniform forest without communication.
+ * These arrays are computed from the formula in \ref t8_cmesh_uniform_bounds.
+ * \param [in,out]  forest The forest. It must have been populated with
+ *                         \ref t8_forest_populate, but does not need to be
+ *                         committed. Pyramidal trees with \a level > 0 are
+ *                         not supported.
+ * \param [in]      level  The uniform refinement level of \a forest.
+ */
+void                t8_forest_partition_create_uniform_offsets (t8_forest_t
+                                                                forest,
+                                                                int level);
+
 /* TODO: document */
 /* data_in has length forest_from->num_local_elements
  * data_out   --  --  forest_to->num_local_elements
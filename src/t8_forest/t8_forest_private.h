@@ -32,6 +32,7 @@
 
 #include <t8.h>
 #include <t8_forest.h>
+#include <t8_data/t8_element_scratch.h>
 
 T8_EXTERN_C_BEGIN ();
 
@@ -40,6 +41,13 @@ T8_EXTERN_C_BEGIN ();
 /* For each tree in a forest compute its first and last descendant */
 void                t8_forest_compute_desc (t8_forest_t forest);
 
+/** Reset the statistics of the ghost creation phases in the profile
+ * of a forest. This is called on enabling profiling and before each ghost
+ * creation.
+ * \param [in,out] forest  A forest with profiling enabled.
+ */
+void                t8_forest_profile_ghost_reset (t8_forest_t forest);
+
 /* Create the elements on this process given a uniform partition
  * of the coarse mesh. */
 void                t8_forest_populate (t8_forest_t forest);
@@ -107,6 +115,47 @@ void                t8_forest_copy_trees (t8_forest_t forest,
                                           t8_forest_t from,
                                           int copy_elements);
 
+/* Create the trees and elements of a forest from the leaves that were set
+ * with t8_forest_set_leaves, in one pass over the leaves.
+ * The forest must not be committed and its cmesh, scheme and maxlevel
+ * must be set.
+ */
+void                t8_forest_leaves_build_trees (t8_forest_t forest);
+
+/* Create the trees of a forest from the p4est or p8est that was set by
+ * t8_forest_new_from_p4est, taking over its quadrant arrays, and destroy it.
+ * The forest must not be committed and its cmesh and scheme must be set.
+ */
+void                t8_forest_p4est_build_trees (t8_forest_t forest);
+
+/* Set the trees of forest as in from, with element arrays that are views
+ * on the element arrays of from. The arrays of from are moved into a
+ * reference counted t8_forest_shared_elements_t, unless they are shared
+ * already, and forest takes one reference. The per element work of
+ * t8_forest_copy_trees is avoided. Since the elements of a committed forest
+ * do not change, the arrays are only duplicated if a forest builds new
+ * ones, as t8_forest_decompress does.
+ */
+void                t8_forest_share_trees (t8_forest_t forest,
+                                           t8_forest_t from);
+
+/* Release the reference of forest on its shared element arrays.
+ * The element arrays of its trees must not be used afterwards.
+ * With the last reference the arrays are freed, or handed to the pool of
+ * forest. */
+void                t8_forest_shared_elements_unref (t8_forest_t forest);
+
+/* Initialize the element array of a tree of forest with num_elements elements,
+ * as \ref t8_element_array_init_size. If forest has a pool, the memory is
+ * taken from the pool if it holds a large enough buffer.
+ */
+void                t8_forest_init_tree_elements (t8_forest_t forest,
+                                                  t8_element_array_t *
+                                                  elements,
+                                                  t8_eclass_scheme_c *
+                                                  scheme,
+                                                  size_t num_elements);
+
 /** Given the local id of a tree in a forest, return the coarse tree of the
  * cmesh that corresponds to this tree, also return the neighbor information of
  * the tree.
@@ -444,6 +493,59 @@ void                t8_forest_leaf_face_neighbors (t8_forest_t forest,
                                                    pneigh_scheme,
                                                    int forest_is_balanced);
 
+/** Construct all face neighbors of half size of a given element, like
+ * \ref t8_forest_element_half_face_neighbors, but the temporary elements
+ * are taken from a scratch arena instead of being allocated.
+ * \param [in,out] scratch An initialized scratch arena. Its allocations
+ *                        are released before the function returns.
+ * For the other parameters, see \ref t8_forest_element_half_face_neighbors.
+ */
+t8_gloidx_t         t8_forest_element_half_face_neighbors_scratch
+  (t8_forest_t forest, t8_locidx_t ltreeid, const t8_element_t * elem,
+   t8_element_t * neighs[], t8_eclass_scheme_c * neigh_scheme, int face,
+   int num_neighs, int dual_faces[], t8_element_scratch_t * scratch);
+
+/** Compute the leaf face neighbors of a forest without allocating memory
+ * on the heap. Computes the same neighbors as
+ * \ref t8_forest_leaf_face_neighbors, but the neighbor elements, dual faces
+ * and indices are stored in a scratch arena. They are valid until the
+ * arena is released or cleared. Once the arena has grown large enough,
+ * repeated calls followed by \ref t8_element_scratch_clear do not allocate.
+ * \param [in]    forest  The forest. Must have a valid ghost layer.
+ * \param [in]    ltreeid A local tree id.
+ * \param [in]    leaf    A leaf in tree \a ltreeid of \a forest.
+ * \param [in]    face    The index of the face across which the face neighbors
+ *                        are searched.
+ * \param [in,out] scratch An initialized scratch arena.
+ * \param [out]   pneighbor_leafs On output the neighbor leafs, NULL if there
+ *                        are none. They must not be destroyed.
+ * \param [out]   pdual_faces On output the face id's of the neighboring
+ *                        elements' faces.
+ * \param [out]   pelement_indices On output the element indices of the
+ *                        neighbor leafs, as in \ref t8_forest_leaf_face_neighbors.
+ * \param [out]   pneigh_scheme On output the eclass scheme of the neighbor elements.
+ * \param [in]    forest_is_balanced True if we know that \a forest is balanced, false
+ *                        otherwise.
+ * \return                The number of neighbor leafs.
+ * \note Currently \a forest must be balanced.
+ */
+int                 t8_forest_leaf_face_neighbors_scratch (t8_forest_t forest,
+                                                           t8_locidx_t
+                                                           ltreeid,
+                                                           const t8_element_t
+                                                           * leaf, int face,
+                                                           t8_element_scratch_t
+                                                           * scratch,
+                                                           t8_element_t ***
+                                                           pneighbor_leafs,
+                                                           int **pdual_faces,
+                                                           t8_locidx_t **
+                                                           pelement_indices,
+                                                           t8_eclass_scheme_c
+                                                           ** pneigh_scheme,
+                                                           int
+                                                           forest_is_balanced);
+
 /** Iterate over all leafs of a forest and for each face compute the face neighbor
  * leafs with \ref t8_forest_leaf_face_neighbors and print their local element ids.
  * This function is meant for debugging only.
@@ -453,6 +555,244 @@ void                t8_forest_leaf_face_neighbors (t8_forest_t forest,
  */
 void                t8_forest_print_all_leaf_neighbors (t8_forest_t forest);
 
+/** Build the face neighbor table of a forest with
+ * \ref t8_forest_leaf_face_neighbors for each face of each local leaf.
+ * \param [in,out] forest The forest. On output forest->face_neighbors is set.
+ * \note \a forest must be committed and balanced. This function is
+ *       collective.
+ * \see t8_forest_set_face_neighbors
+ */
+void                t8_forest_face_neighbors_build (t8_forest_t forest);
+
+/** Free the face neighbor table of a forest, if it exists.
+ * \param [in,out] forest The forest.
+ */
+void                t8_forest_face_neighbors_destroy (t8_forest_t forest);
+
+/** Compute for each local tree of a forest whether the map from its
+ * reference element is affine and store the map.
+ * \param [in,out] forest The forest. On output forest->tree_affine is set.
+ * \note \a forest must be committed.
+ */
+void                t8_forest_tree_affine_compute (t8_forest_t forest);
+
+/** Compute for each face of each local tree of a forest the neighbor tree,
+ * its face and the orientation of the connection.
+ * \param [in,out] forest The forest. On output forest->tree_faces is set.
+ * \note \a forest must be committed.
+ */
+void                t8_forest_tree_faces_compute (t8_forest_t forest);
+
+/** Set up the corner caches of all local and ghost trees of a forest whose
+ * vertices are computed from the geometry of the cmesh.
+ * Does nothing if the cmesh has no tree geometry.
+ * \param [in,out] forest The forest. On output forest->tree_curved is set.
+ * \note \a forest must be committed and its ghost layer must be created.
+ */
+void                t8_forest_tree_curved_build (t8_forest_t forest);
+
+/** Free the corner caches of a forest, if they exist.
+ * \param [in,out] forest The forest.
+ */
+void                t8_forest_tree_curved_destroy (t8_forest_t forest);
+
+/** Return the memory used by the corner caches of a forest.
+ * \param [in]     forest The forest.
+ * \return        The number of bytes.
+ */
+size_t              t8_forest_tree_curved_memory_used (t8_forest_t forest);
+
+/** Compute the centroids, volumes, face areas and face normals of all
+ * local leafs and ghosts of a forest and store them in the forest.
+ * \param [in,out] forest The forest. On output forest->geometry_cache is set.
+ * \note \a forest must be committed.
+ * \see t8_forest_set_geometry_cache
+ */
+void                t8_forest_geometry_cache_build (t8_forest_t forest);
+
+/** Free the geometry cache of a forest, if it exists.
+ * \param [in,out] forest The forest.
+ */
+void                t8_forest_geometry_cache_destroy (t8_forest_t forest);
+
+/** Give a forest the same element data fields as the forest it is
+ * committed from. The fields have no entries yet.
+ * \param [in,out] forest      A forest that is being committed.
+ * \param [in]     forest_from A committed forest.
+ * \see t8_forest_field_register
+ */
+void                t8_forest_fields_inherit (t8_forest_t forest,
+                                              t8_forest_t forest_from);
+
+/** Copy the local entries of the fields of a forest with the same local
+ * elements as \a forest.
+ * \param [in,out] forest      A forest that is being committed, whose fields
+ *                             were inherited from \a forest_from.
+ * \param [in]     forest_from A committed forest with the same local elements.
+ */
+void                t8_forest_fields_copy (t8_forest_t forest,
+                                           t8_forest_t forest_from);
+
+/** Transfer the local entries of the fields of a forest to the forest that
+ * is adapted from it, according to the policy of each field.
+ * \param [in,out] forest      A forest that was just adapted from \a forest_from.
+ *                             Its trees and elements must be set.
+ * \param [in]     forest_from The committed forest that \a forest was adapted from.
+ */
+void                t8_forest_fields_adapt (t8_forest_t forest,
+                                            t8_forest_t forest_from);
+
+/** Register the fields of a forest as partition data of the forest that
+ * is partitioned from it, such that they are sent together with the elements.
+ * \param [in,out] forest      A forest that is about to be partitioned.
+ * \param [in]     forest_from The committed forest that \a forest is partitioned from.
+ * \see t8_forest_set_partition_data
+ */
+void                t8_forest_fields_set_partition (t8_forest_t forest,
+                                                    t8_forest_t forest_from);
+
+/** Add the ghost entries to the fields of a committed forest and fill them.
+ * \param [in,out] forest      A committed forest with its final ghost layer.
+ */
+void                t8_forest_fields_commit_ghosts (t8_forest_t forest);
+
+/** Free the fields of a forest.
+ * \param [in,out] forest      A forest.
+ */
+void                t8_forest_fields_destroy (t8_forest_t forest);
+
+/** Build the owner search table of a forest from its partition tables.
+ * \param [in,out] forest The forest. Its tree_offsets, element_offsets and
+ *                        global_first_desc arrays must exist.
+ * \see t8_forest_set_owner_table
+ */
+void                t8_forest_owner_table_build (t8_forest_t forest);
+
+/** Free the owner search table of a forest.
+ * \param [in,out] forest The forest. Its owner table must exist.
+ */
+void                t8_forest_owner_table_destroy (t8_forest_t forest);
+
+/** Compute the levels of the local elements of a forest.
+ * \param [in]  forest   A committed forest.
+ * \param [out] levels   On output the level of each local element.
+ *                       Must have one entry per local element.
+ * If the forest has an array of the element levels, it is copied.
+ */
+void                t8_forest_element_levels_compute (t8_forest_t forest,
+                                                      int8_t * levels);
+
+/** Build the array of the levels of the local elements of a forest.
+ * \param [in,out] forest The forest.
+ * \see t8_forest_set_element_levels
+ */
+void                t8_forest_element_levels_build (t8_forest_t forest);
+
+/** Compute the levels of the ghosts of a forest.
+ * \param [in]  forest   A committed forest.
+ * \param [out] levels   On output the level of each ghost.
+ *                       Must have one entry per ghost.
+ * If the forest has level lists, the levels are read from them.
+ */
+void                t8_forest_ghost_levels_compute (t8_forest_t forest,
+                                                    int8_t * levels);
+
+/** Build the lists of the local elements of each level of a forest.
+ * The lists have one entry per possible level of the forest, until the
+ * maximum existing level is known.
+ * \param [in,out] forest The forest, its elements must be final.
+ * \see t8_forest_set_level_lists
+ */
+void                t8_forest_level_lists_build_elements (t8_forest_t
+                                                          forest);
+
+/** Add the lists of the ghosts of each level to the level lists of a forest.
+ * \param [in,out] forest The committed forest. Its level lists must have
+ *                        one entry per existing level.
+ * \see t8_forest_set_level_lists
+ */
+void                t8_forest_level_lists_build_ghosts (t8_forest_t forest);
+
+/** Free the level lists of a forest, if it has them.
+ * \param [in,out] forest The forest.
+ */
+void                t8_forest_level_lists_destroy (t8_forest_t forest);
+
+/* Free the element array of a tree of forest. If forest has a pool, the
+ * memory is handed to the pool if it fits.
+ */
+void                t8_forest_release_tree_elements (t8_forest_t forest,
+                                                     t8_element_array_t *
+                                                     elements);
+
+/** Free the compact form of the elements of a compressed forest.
+ * \param [in,out] forest The forest. It must be compressed.
+ */
+void                t8_forest_compressed_destroy (t8_forest_t forest);
+
+/** Encode the elements of one tree as runs of elements of the same level that
+ * are consecutive in the uniform refinement of this level. This is the
+ * compressed form of the elements in partition and ghost messages.
+ * \param [in] ts      The eclass scheme of the elements.
+ * \param [in] elements An array of \a num_elements elements, as stored in a
+ *                     \ref t8_element_array_t.
+ * \param [in] num_elements The number of elements.
+ * \param [out] buffer If not NULL, the runs are written to it. It must have
+ *                     room for the returned number of bytes.
+ * \return             The number of bytes of the runs.
+ */
+size_t              t8_forest_element_runs_encode (t8_eclass_scheme_c * ts,
+                                                   const t8_element_t *
+                                                   elements,
+                                                   t8_locidx_t num_elements,
+                                                   char *buffer);
+
+/** Set elements from their runs written by \ref t8_forest_element_runs_encode.
+ * \param [in] ts      The eclass scheme of the elements.
+ * \param [in] buffer  The runs. They need not be aligned.
+ * \param [in] num_elements The number of encoded elements.
+ * \param [out] elements An array of \a num_elements elements that is set.
+ * \return             The number of bytes read from \a buffer.
+ */
+size_t              t8_forest_element_runs_decode (t8_eclass_scheme_c * ts,
+                                                   const char *buffer,
+                                                   t8_locidx_t num_elements,
+                                                   t8_element_t * elements);
+
+/** Build the compact partition table of a forest from its partition tables.
+ * \param [in,out] forest The forest. Its tree_offsets, element_offsets and
+ *                        global_first_desc arrays must exist.
+ * \see t8_forest_set_partition_compact
+ */
+void                t8_forest_partition_compact_build (t8_forest_t forest);
+
+/** Free the compact partition table of a forest.
+ * \param [in,out] forest The forest. Its compact partition table must exist.
+ */
+void                t8_forest_partition_compact_destroy (t8_forest_t forest);
+
+/** Return the number of bytes used by the compact partition table of a forest.
+ * \param [in] forest     The forest. Its compact partition table must exist.
+ * \return                The size of the table in bytes.
+ */
+size_t              t8_forest_partition_compact_memory_used (t8_forest_t
+                                                             forest);
+
+/** Search for a linear element id (at forest->maxlevel) in a sorted array of
+ * elements.
+ * \param [in] elements  A sorted array of elements of one tree.
+ * \param [in] element_id The linear id to search for.
+ * \param [in] maxlevel  The level at which linear ids are compared.
+ * \return               The index of the element with the given id. If it does not
+ *                       exist, the largest index i such that the element at position i
+ *                       has a smaller id than the given one.
+ *                       If no such i exists, -1.
+ */
+t8_locidx_t         t8_forest_bin_search_lower (t8_element_array_t *
+                                                elements,
+                                                t8_linearidx_t element_id,
+                                                int maxlevel);
+
 /** Compute whether for a given element there exist leaf or ghost leaf elements in
  * the local forest that are a descendant of the element but not the element itself
  * \param [in]  forest    The forest.
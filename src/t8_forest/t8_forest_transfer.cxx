@@ -0,0 +1,415 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_transfer.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_element_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* The descendants of a source element at the maximum level */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  t8_linearidx_t      first;
+  t8_linearidx_t      last;
+} t8_forest_transfer_range_t;
+
+/* An overlap of a local target element with a received source element */
+typedef struct
+{
+  t8_locidx_t         target;
+  size_t              source;
+  double              weight;
+} t8_forest_transfer_overlap_t;
+
+/* Post the receives and sends of a sparse exchange in which process p
+ * sends send_counts[p] items of item_size bytes starting at item
+ * send_offsets[p] and receives recv_counts[p] items.
+ * The items to the process itself are copied.
+ * Returns the number of requests posted. */
+static int
+t8_forest_transfer_exchange_begin (t8_forest_t forest, size_t item_size,
+                                   char *send_buffer, const int *send_counts,
+                                   const size_t *send_offsets,
+                                   char *recv_buffer, const int *recv_counts,
+                                   const size_t *recv_offsets,
+                                   sc_MPI_Request * requests)
+{
+  int                 iproc, num_requests, mpiret;
+
+  num_requests = 0;
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (iproc != forest->mpirank && recv_counts[iproc] > 0) {
+      mpiret = sc_MPI_Irecv (recv_buffer + recv_offsets[iproc] * item_size,
+                             recv_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, T8_MPI_TRANSFER_DATA, forest->mpicomm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    if (iproc != forest->mpirank && send_counts[iproc] > 0) {
+      mpiret = sc_MPI_Isend (send_buffer + send_offsets[iproc] * item_size,
+                             send_counts[iproc] * item_size, sc_MPI_BYTE,
+                             iproc, T8_MPI_TRANSFER_DATA, forest->mpicomm,
+                             requests + num_requests++);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  T8_ASSERT (send_counts[forest->mpirank] == recv_counts[forest->mpirank]);
+  memcpy (recv_buffer + recv_offsets[forest->mpirank] * item_size,
+          send_buffer + send_offsets[forest->mpirank] * item_size,
+          send_counts[forest->mpirank] * item_size);
+  return num_requests;
+}
+
+/* Compute the descendant range of each local source element and the first
+ * and last process of the target forest that owns a part of it. */
+static void
+t8_forest_transfer_source_ranges (t8_forest_t source, t8_forest_t target,
+                                  t8_forest_transfer_range_t * ranges,
+                                  int *lower, int *upper)
+{
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  t8_element_t       *elem, *desc;
+  t8_locidx_t         num_trees, itree, ielem, num_elems, ilocal;
+  t8_gloidx_t         gtreeid;
+  int                 first_owner;
+
+  num_trees = t8_forest_get_num_local_trees (source);
+  first_owner = 0;
+  for (itree = 0, ilocal = 0; itree < num_trees; itree++) {
+    eclass = t8_forest_get_tree_class (source, itree);
+    SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                    "Data transfer is not supported for pyramids");
+    ts = t8_forest_get_eclass_scheme (source, eclass);
+    gtreeid = t8_forest_global_tree_id (source, itree);
+    num_elems = t8_forest_get_tree_num_elements (source, itree);
+    ts->t8_element_new (1, &desc);
+    for (ielem = 0; ielem < num_elems; ielem++, ilocal++) {
+      elem = t8_forest_get_element_in_tree (source, itree, ielem);
+      ranges[ilocal].gtreeid = gtreeid;
+      ts->t8_element_first_descendant (elem, desc, source->maxlevel);
+      ranges[ilocal].first = ts->t8_element_get_linear_id (desc,
+                                                           source->maxlevel);
+      /* The owners of consecutive elements are ascending */
+      lower[ilocal] = first_owner =
+        t8_forest_element_find_owner_ext (target, gtreeid, desc, eclass,
+                                          first_owner, target->mpisize - 1,
+                                          first_owner, 1);
+      ts->t8_element_last_descendant (elem, desc, source->maxlevel);
+      ranges[ilocal].last = ts->t8_element_get_linear_id (desc,
+                                                          source->maxlevel);
+      upper[ilocal] =
+        t8_forest_element_find_owner_ext (target, gtreeid, desc, eclass,
+                                          first_owner, target->mpisize - 1,
+                                          first_owner, 1);
+    }
+    ts->t8_element_destroy (1, &desc);
+  }
+  T8_ASSERT (ilocal == t8_forest_get_num_element (source));
+}
+
+/* Find the local target elements that overlap the received source ranges
+ * and append them to overlaps. */
+static void
+t8_forest_transfer_find_overlaps (t8_forest_t target,
+                                  const t8_forest_transfer_range_t * ranges,
+                                  size_t num_ranges, sc_array_t * overlaps)
+{
+  t8_forest_transfer_overlap_t *overlap;
+  t8_eclass_scheme_c *ts;
+  t8_element_array_t *elements;
+  t8_element_t       *elem, *desc;
+  t8_locidx_t         ltreeid, ielem, num_elems, offset;
+  t8_linearidx_t      first, last;
+  size_t              irange;
+
+  for (irange = 0; irange < num_ranges; irange++) {
+    ltreeid = t8_forest_get_local_id (target, ranges[irange].gtreeid);
+    T8_ASSERT (ltreeid >= 0);
+    elements = &t8_forest_get_tree (target, ltreeid)->elements;
+    num_elems = (t8_locidx_t) t8_element_array_get_count (elements);
+    T8_ASSERT (num_elems > 0);
+    offset = t8_forest_get_tree_element_offset (target, ltreeid);
+    ts = t8_element_array_get_scheme (elements);
+    ts->t8_element_new (1, &desc);
+    /* Start at the element that contains or precedes the first descendant */
+    ielem = t8_forest_bin_search_lower (elements, ranges[irange].first,
+                                        target->maxlevel);
+    for (ielem = SC_MAX (ielem, 0); ielem < num_elems; ielem++) {
+      elem = t8_element_array_index_locidx (elements, ielem);
+      first = ts->t8_element_get_linear_id (elem, target->maxlevel);
+      if (first > ranges[irange].last) {
+        break;
+      }
+      ts->t8_element_last_descendant (elem, desc, target->maxlevel);
+      last = ts->t8_element_get_linear_id (desc, target->maxlevel);
+      if (last < ranges[irange].first) {
+        continue;
+      }
+      overlap = (t8_forest_transfer_overlap_t *) sc_array_push (overlaps);
+      overlap->target = offset + ielem;
+      overlap->source = irange;
+      overlap->weight =
+        ((double) (SC_MIN (last, ranges[irange].last) -
+                   SC_MAX (first, ranges[irange].first)) + 1) /
+        ((double) (last - first) + 1);
+    }
+    ts->t8_element_destroy (1, &desc);
+  }
+}
+
+t8_forest_transfer_t *
+t8_forest_transfer_new (t8_forest_t source, t8_forest_t target)
+{
+  t8_forest_transfer_t *transfer;
+  t8_forest_transfer_range_t *ranges, *send_ranges, *recv_ranges;
+  t8_forest_transfer_overlap_t *overlap;
+  sc_array_t          overlaps;
+  sc_MPI_Request     *requests;
+  t8_locidx_t         num_source, num_target, ielem;
+  size_t             *positions, ientry, num_send, num_recv, ioverlap;
+  int                *lower, *upper;
+  int                 mpisize, iproc, mpiret, num_requests;
+
+  T8_ASSERT (t8_forest_is_committed (source));
+  T8_ASSERT (t8_forest_is_committed (target));
+  SC_CHECK_ABORT (source->mpisize == target->mpisize
+                  && source->mpirank == target->mpirank,
+                  "The forests must have the same communicator");
+  SC_CHECK_ABORT (source->global_num_trees == target->global_num_trees
+                  && source->maxlevel == target->maxlevel,
+                  "The forests must have the same coarse mesh and scheme");
+  mpisize = source->mpisize;
+
+  transfer = T8_ALLOC_ZERO (t8_forest_transfer_t, 1);
+  t8_forest_ref (source);
+  t8_forest_ref (target);
+  transfer->source = source;
+  transfer->target = target;
+
+  /* We keep the partition tables of the target for later owner searches */
+  t8_forest_partition_create_all_offsets (target);
+
+  /* Each source element is sent to the nonempty processes between the
+   * owners of its first and last descendant */
+  num_source = t8_forest_get_num_element (source);
+  ranges = T8_ALLOC (t8_forest_transfer_range_t, num_source);
+  lower = T8_ALLOC (int, num_source);
+  upper = T8_ALLOC (int, num_source);
+  t8_forest_transfer_source_ranges (source, target, ranges, lower, upper);
+  transfer->send_counts = T8_ALLOC_ZERO (int, mpisize);
+  for (ielem = 0; ielem < num_source; ielem++) {
+    for (iproc = lower[ielem]; iproc <= upper[ielem];
+         iproc = t8_forest_partition_next_nonempty_rank (target, iproc)) {
+      transfer->send_counts[iproc]++;
+    }
+  }
+  transfer->recv_counts = T8_ALLOC (int, mpisize);
+  mpiret = sc_MPI_Alltoall (transfer->send_counts, 1, sc_MPI_INT,
+                            transfer->recv_counts, 1, sc_MPI_INT,
+                            source->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  transfer->send_offsets = T8_ALLOC (size_t, mpisize + 1);
+  transfer->recv_offsets = T8_ALLOC (size_t, mpisize + 1);
+  transfer->send_offsets[0] = transfer->recv_offsets[0] = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    transfer->send_offsets[iproc + 1] =
+      transfer->send_offsets[iproc] + transfer->send_counts[iproc];
+    transfer->recv_offsets[iproc + 1] =
+      transfer->recv_offsets[iproc] + transfer->recv_counts[iproc];
+  }
+  num_send = transfer->send_offsets[mpisize];
+  num_recv = transfer->recv_offsets[mpisize];
+
+  /* Fill the send buffer, ordered by process */
+  transfer->send_elements = T8_ALLOC (t8_locidx_t, num_send);
+  send_ranges = T8_ALLOC (t8_forest_transfer_range_t, num_send);
+  positions = T8_ALLOC (size_t, mpisize);
+  memcpy (positions, transfer->send_offsets, mpisize * sizeof (size_t));
+  for (ielem = 0; ielem < num_source; ielem++) {
+    for (iproc = lower[ielem]; iproc <= upper[ielem];
+         iproc = t8_forest_partition_next_nonempty_rank (target, iproc)) {
+      ientry = positions[iproc]++;
+      transfer->send_elements[ientry] = ielem;
+      send_ranges[ientry] = ranges[ielem];
+    }
+  }
+  T8_FREE (positions);
+  T8_FREE (ranges);
+  T8_FREE (lower);
+  T8_FREE (upper);
+
+  /* Send the ranges to the target processes */
+  recv_ranges = T8_ALLOC (t8_forest_transfer_range_t, num_recv);
+  requests = T8_ALLOC (sc_MPI_Request, 2 * mpisize);
+  num_requests =
+    t8_forest_transfer_exchange_begin (source,
+                                       sizeof (t8_forest_transfer_range_t),
+                                       (char *) send_ranges,
+                                       transfer->send_counts,
+                                       transfer->send_offsets,
+                                       (char *) recv_ranges,
+                                       transfer->recv_counts,
+                                       transfer->recv_offsets, requests);
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests);
+  T8_FREE (send_ranges);
+
+  /* Intersect the received ranges with the local target elements.
+   * The ranges arrive in SFC order, since the source processes are. */
+  sc_array_init (&overlaps, sizeof (t8_forest_transfer_overlap_t));
+  t8_forest_transfer_find_overlaps (target, recv_ranges, num_recv,
+                                    &overlaps);
+  T8_FREE (recv_ranges);
+
+  /* Sort the overlaps by target element, keeping the SFC order of the
+   * sources of each target element */
+  num_target = t8_forest_get_num_element (target);
+  transfer->overlap_offsets = T8_ALLOC_ZERO (t8_locidx_t, num_target + 1);
+  for (ioverlap = 0; ioverlap < overlaps.elem_count; ioverlap++) {
+    overlap = (t8_forest_transfer_overlap_t *)
+      sc_array_index (&overlaps, ioverlap);
+    transfer->overlap_offsets[overlap->target + 1]++;
+  }
+  for (ielem = 0; ielem < num_target; ielem++) {
+    SC_CHECK_ABORT (transfer->overlap_offsets[ielem + 1] > 0,
+                    "A target element does not overlap any source element");
+    transfer->overlap_offsets[ielem + 1] += transfer->overlap_offsets[ielem];
+  }
+  transfer->overlap_sources = T8_ALLOC (size_t, overlaps.elem_count);
+  transfer->overlap_weights = T8_ALLOC (double, overlaps.elem_count);
+  positions = T8_ALLOC (size_t, num_target);
+  for (ielem = 0; ielem < num_target; ielem++) {
+    positions[ielem] = transfer->overlap_offsets[ielem];
+  }
+  for (ioverlap = 0; ioverlap < overlaps.elem_count; ioverlap++) {
+    overlap = (t8_forest_transfer_overlap_t *)
+      sc_array_index (&overlaps, ioverlap);
+    ientry = positions[overlap->target]++;
+    transfer->overlap_sources[ientry] = overlap->source;
+    transfer->overlap_weights[ientry] = overlap->weight;
+  }
+  T8_FREE (positions);
+  sc_array_reset (&overlaps);
+
+  t8_debugf ("Transfer plan sends %lli and receives %lli elements\n",
+             (long long) num_send, (long long) num_recv);
+  return transfer;
+}
+
+void
+t8_forest_transfer_destroy (t8_forest_transfer_t ** ptransfer)
+{
+  t8_forest_transfer_t *transfer;
+
+  T8_ASSERT (ptransfer != NULL && *ptransfer != NULL);
+  transfer = *ptransfer;
+  t8_forest_unref (&transfer->source);
+  t8_forest_unref (&transfer->target);
+  T8_FREE (transfer->send_counts);
+  T8_FREE (transfer->send_offsets);
+  T8_FREE (transfer->send_elements);
+  T8_FREE (transfer->recv_counts);
+  T8_FREE (transfer->recv_offsets);
+  T8_FREE (transfer->overlap_offsets);
+  T8_FREE (transfer->overlap_sources);
+  T8_FREE (transfer->overlap_weights);
+  T8_FREE (transfer);
+  *ptransfer = NULL;
+}
+
+void
+t8_forest_transfer_data (const t8_forest_transfer_t * transfer,
+                         const double *source_data, double *target_data,
+                         int num_values, t8_forest_transfer_mode_t mode)
+{
+  t8_forest_t         source;
+  sc_MPI_Request     *requests;
+  double             *send_values, *recv_values, *t;
+  const double       *s;
+  size_t              num_send, num_recv, ientry;
+  t8_locidx_t         num_target, ielem, ioverlap;
+  int                 ival, mpiret, num_requests;
+
+  T8_ASSERT (transfer != NULL);
+  T8_ASSERT (num_values > 0);
+  T8_ASSERT (mode == T8_FOREST_TRANSFER_AVERAGE
+             || mode == T8_FOREST_TRANSFER_INJECT);
+  source = transfer->source;
+
+  /* Pack the values of the sent source elements */
+  num_send = transfer->send_offsets[source->mpisize];
+  num_recv = transfer->recv_offsets[source->mpisize];
+  send_values = T8_ALLOC (double, num_send * num_values);
+  for (ientry = 0; ientry < num_send; ientry++) {
+    memcpy (send_values + ientry * num_values,
+            source_data + (size_t) transfer->send_elements[ientry] *
+            num_values, num_values * sizeof (double));
+  }
+  recv_values = T8_ALLOC (double, num_recv * num_values);
+  requests = T8_ALLOC (sc_MPI_Request, 2 * source->mpisize);
+  num_requests =
+    t8_forest_transfer_exchange_begin (source, num_values * sizeof (double),
+                                       (char *) send_values,
+                                       transfer->send_counts,
+                                       transfer->send_offsets,
+                                       (char *) recv_values,
+                                       transfer->recv_counts,
+                                       transfer->recv_offsets, requests);
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests);
+  T8_FREE (send_values);
+
+  /* Combine the received values for each target element */
+  num_target = t8_forest_get_num_element (transfer->target);
+  for (ielem = 0; ielem < num_target; ielem++) {
+    t = target_data + (size_t) ielem * num_values;
+    ioverlap = transfer->overlap_offsets[ielem];
+    if (mode == T8_FOREST_TRANSFER_INJECT) {
+      /* The first overlap contains the first descendant */
+      s = recv_values + transfer->overlap_sources[ioverlap] * num_values;
+      memcpy (t, s, num_values * sizeof (double));
+      continue;
+    }
+    for (ival = 0; ival < num_values; ival++) {
+      t[ival] = 0;
+    }
+    for (; ioverlap < transfer->overlap_offsets[ielem + 1]; ioverlap++) {
+      s = recv_values + transfer->overlap_sources[ioverlap] * num_values;
+      for (ival = 0; ival < num_values; ival++) {
+        t[ival] += transfer->overlap_weights[ioverlap] * s[ival];
+      }
+    }
+  }
+  T8_FREE (recv_values);
+}
+
+T8_EXTERN_C_END ();
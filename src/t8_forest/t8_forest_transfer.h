@@ -0,0 +1,122 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_transfer.h
+ * Transfer element data between two forests on the same coarse mesh.
+ *
+ * The forests may be refined and partitioned differently, as in coupled
+ * codes that each adapt their own forest. Two elements overlap if the
+ * ranges of their descendants at the maximum level intersect. Each process
+ * sends its source elements to the processes whose target elements they
+ * overlap, which are found from the partition table of the target forest.
+ * The resulting communication pattern is stored in a plan and reused by
+ * each transfer, which then needs a single exchange of the values.
+ *
+ * Since the overlap is measured in descendants, the weights are volume
+ * fractions if all children of an element have the same volume. Thus
+ * pyramids are not supported.
+ */
+
+#ifndef T8_FOREST_TRANSFER_H
+#define T8_FOREST_TRANSFER_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** How the values of target elements are computed from the source. */
+typedef enum t8_forest_transfer_mode
+{
+  T8_FOREST_TRANSFER_AVERAGE = 0,       /**< The mean of the overlapping source elements,
+                                             weighted by the size of the overlap.
+                                             This conserves the integral of the values. */
+  T8_FOREST_TRANSFER_INJECT             /**< The value of the source element that
+                                             contains the first descendant of the
+                                             target element. */
+} t8_forest_transfer_mode_t;
+
+/** The communication pattern and overlaps of a transfer between two forests. */
+typedef struct
+{
+  t8_forest_t         source;           /**< The forest that data is sent from. */
+  t8_forest_t         target;           /**< The forest that data is sent to. */
+  int                *send_counts;      /**< For each process the number of source
+                                             elements that we send to it. */
+  size_t             *send_offsets;     /**< The prefix sums of \a send_counts,
+                                             with mpisize + 1 entries. */
+  t8_locidx_t        *send_elements;    /**< The local index of each sent source
+                                             element, ordered by process. */
+  int                *recv_counts;      /**< For each process the number of source
+                                             elements that we receive from it. */
+  size_t             *recv_offsets;     /**< The prefix sums of \a recv_counts,
+                                             with mpisize + 1 entries. */
+  t8_locidx_t        *overlap_offsets;  /**< The received source elements that overlap
+                                             local target element i are the entries
+                                             overlap_offsets[i], ...,
+                                             overlap_offsets[i + 1] - 1 of
+                                             \a overlap_sources. Has one entry per
+                                             local target element plus one. */
+  size_t             *overlap_sources;  /**< The positions of the overlapping source
+                                             elements among the received ones, in
+                                             SFC order for each target element. */
+  double             *overlap_weights;  /**< The fraction of a target element that
+                                             each overlap covers. */
+} t8_forest_transfer_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Compute the plan to transfer data between two forests.
+ * \param [in] source   A committed forest.
+ * \param [in] target   A committed forest on the same coarse mesh and with
+ *                      the same scheme and communicator as \a source.
+ * \return              The plan, which keeps a reference to both forests.
+ *                      Destroy it with \ref t8_forest_transfer_destroy.
+ * \note This function is collective.
+ */
+t8_forest_transfer_t *t8_forest_transfer_new (t8_forest_t source,
+                                              t8_forest_t target);
+
+/** Free the memory of a transfer plan and unref its forests.
+ * \param [in,out] ptransfer  A transfer plan, set to NULL on output.
+ */
+void                t8_forest_transfer_destroy (t8_forest_transfer_t **
+                                                ptransfer);
+
+/** Transfer element values from the source to the target forest of a plan.
+ * \param [in] transfer     A transfer plan.
+ * \param [in] source_data  \a num_values doubles for each local element of
+ *                          the source forest.
+ * \param [out] target_data \a num_values doubles for each local element of
+ *                          the target forest.
+ * \param [in] num_values   The number of values per element.
+ * \param [in] mode         How the target values are computed.
+ * \note This function is collective.
+ */
+void                t8_forest_transfer_data (const t8_forest_transfer_t *
+                                             transfer,
+                                             const double *source_data,
+                                             double *target_data,
+                                             int num_values,
+                                             t8_forest_transfer_mode_t mode);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_TRANSFER_H */
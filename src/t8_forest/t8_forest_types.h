@@ -34,16 +34,23 @@
 #include <t8_data/t8_containers.h>
 #include <t8_forest/t8_forest_adapt.h>
 #include <t8_forest.h>
+#include <t8_forest/t8_forest_fields.h>
+#include <t8_profile_regions.h>
+#include <sc_statistics.h>
 
 typedef struct t8_profile t8_profile_t; /* Defined below */
 typedef struct t8_forest_ghost *t8_forest_ghost_t;      /* Defined below */
+typedef struct t8_ghost_exchange_plan t8_ghost_exchange_plan_t; /* Defined in t8_forest_ghost.cxx */
+typedef struct t8_ghost_data_exchange t8_ghost_data_exchange_t; /* Defined in t8_forest_ghost.cxx */
+typedef struct t8_ghost_shared t8_ghost_shared_t; /* Defined in t8_forest_ghost.cxx */
+typedef struct t8_ghost_rma t8_ghost_rma_t; /* Defined in t8_forest_ghost.cxx */
 
 /** If a forest is to be derived from another forest, there are different
  * possibilities how the original forest is modified.
  * Currently we support: Copying, adapting, partitioning, and balancing
  * a forest.
  * The latter 3 can be combined, in which case the order is
- * 1. Adapt, 2. Partition, 3. Balance.
+ * 1. Adapt, 2. Balance, 3. Partition.
  * We store the methods in an int8_t and use these defines to
  * distinguish between them.
  */
@@ -60,14 +67,307 @@ typedef int8_t      t8_forest_from_t;
 #define T8_FOREST_BALANCE_REPART 1 /**< Value of forest->set_balance if balancing with repartitioning */
 #define T8_FOREST_BALANCE_NO_REPART 2 /**< Value of forest->set_balance if balancing without repartitioning */
 
+/** An element data array that is partitioned together with the elements.
+ * \see t8_forest_set_partition_data */
+typedef struct t8_forest_partition_data
+{
+  const sc_array_t   *data_in;  /**< The data of the elements of the partitioned forest. */
+  sc_array_t         *data_out; /**< The data of the elements of the new forest. */
+}
+t8_forest_partition_data_t;
+
+/** An element data field that is attached to a forest.
+ * \see t8_forest_field_register */
+typedef struct t8_forest_field
+{
+  char               *name;     /**< The name of the field. */
+  t8_forest_field_policy_t policy; /**< How the field is interpolated during adapt. */
+  t8_forest_field_interpolate_t interpolate; /**< The callback of \ref T8_FOREST_FIELD_USER. */
+  void               *user_data; /**< The user data of \a interpolate. */
+  sc_array_t          data;     /**< One entry per local element, followed by the ghosts. */
+  sc_array_t          source;   /**< While the forest is partitioned, a view on the local
+                                     entries of the field of the partitioned forest. */
+}
+t8_forest_field_t;
+
+/** The face neighbors of all local leafs of a forest in compressed row storage.
+ * The faces of all local elements are numbered consecutively, the faces of
+ * element i are face_offsets[i], ..., face_offsets[i + 1] - 1.
+ * The neighbors of face f are stored at positions
+ * neighbor_offsets[f], ..., neighbor_offsets[f + 1] - 1 of
+ * \a neighbors and \a dual_faces.
+ * \see t8_forest_set_face_neighbors */
+typedef struct t8_forest_face_neighbors
+{
+  t8_locidx_t         num_elements;     /**< The number of local elements. */
+  t8_locidx_t        *face_offsets;     /**< For each local element the index of its first face.
+                                             Has num_elements + 1 entries. */
+  t8_locidx_t        *neighbor_offsets; /**< For each face the index of its first neighbor.
+                                             Has face_offsets[num_elements] + 1 entries. */
+  int8_t             *level_diff;       /**< For each face the level of its neighbors minus
+                                             the level of the element, 0 at the boundary.
+                                             Positive values mark hanging faces with smaller
+                                             neighbors, negative values hanging faces of a
+                                             larger neighbor. */
+  t8_locidx_t        *neighbors;        /**< The neighbor indices. 0, ..., num_elements - 1
+                                             for local leafs and num_elements, ... for ghosts. */
+  int8_t             *dual_faces;       /**< For each neighbor the face id of its face at
+                                             the element. */
+}
+t8_forest_face_neighbors_t;
+
+/** The map from the reference element to a local tree, if it is affine.
+ * Then a point with reference coordinates r lies at offset + jacobian r.
+ */
+typedef struct t8_forest_tree_affine
+{
+  const double       *vertices;         /**< The tree vertices the map was computed from.
+                                             NULL if the tree has no stored vertices. */
+  int                 is_affine;        /**< True if the map is affine. */
+  double              offset[3];        /**< The image of the reference origin. */
+  double              jacobian[3][3];   /**< jacobian[j] is the derivative with respect to
+                                             the j-th reference coordinate. */
+  double              volume;           /**< The volume of the tree. */
+}
+t8_forest_tree_affine_t;
+
+/** The connection of a local tree to its neighbor tree across one face,
+ * as needed to transform elements from one tree to the other. */
+typedef struct t8_forest_tree_face
+{
+  t8_gloidx_t         neigh_tree;       /**< The global id of the neighbor tree,
+                                             -1 if the face is a domain boundary. */
+  int8_t              neigh_face;       /**< The face of the neighbor tree. */
+  int8_t              orientation;      /**< The orientation of the connection. */
+  int8_t              sign;             /**< True if both faces have the same
+                                             topological orientation. */
+  int8_t              is_smaller;       /**< True if the face of the local tree is
+                                             the smaller one. */
+  int8_t              neigh_eclass;     /**< The eclass of the neighbor tree,
+                                             the eclass of the local tree if
+                                             the face is a domain boundary. */
+  int8_t              boundary_eclass;  /**< The eclass of the face. */
+}
+t8_forest_tree_face_t;
+
+/** A corner of an element mapped by the geometry of its tree. */
+typedef struct t8_forest_curved_corner
+{
+  int                 coords[3];        /**< The integer reference coordinates of the corner. */
+  double              xyz[3];           /**< The image of the corner under the geometry. */
+}
+t8_forest_curved_corner_t;
+
+/** The geometry of a local or ghost tree whose vertices are not stored but
+ * computed from the geometry of the cmesh, see \ref t8_cmesh_set_tree_geometry.
+ * The element corners of such a tree are the images of the geometry map and
+ * each corner is mapped only once.
+ */
+typedef struct t8_forest_tree_curved
+{
+  t8_gloidx_t         gtreeid;          /**< The global id of the tree, passed to the geometry. */
+  sc_hash_t          *corners;          /**< The mapped corners that were computed so far,
+                                             keyed by their reference coordinates.
+                                             NULL if the tree has stored vertices. */
+  sc_mempool_t       *corner_pool;      /**< The memory of the entries of \a corners. */
+}
+t8_forest_tree_curved_t;
+
+/** The geometry of the local and ghost leafs of a forest, computed once
+ * when the forest is committed. The quantities are stored as one array per
+ * component. Elements are indexed by their local index, the ghosts follow
+ * with the indices num_local_elements, ..., num_elements - 1.
+ * The values are stored either in double or in single precision,
+ * such that exactly one of each pair of arrays is allocated.
+ * \see t8_forest_set_geometry_cache, t8_forest_set_geometry_float
+ */
+typedef struct t8_forest_geometry_cache
+{
+  t8_locidx_t         num_local_elements; /**< The number of local elements. */
+  t8_locidx_t         num_elements;     /**< The number of local and cached ghost elements. */
+  int                 is_float;         /**< If true, the float arrays are used. */
+  int                 has_normals;      /**< False for one dimensional forests. */
+  double             *centroid[3];      /**< The coordinates of the element centroids,
+                                             num_elements entries each. */
+  double             *volume;           /**< The element volumes. */
+  t8_locidx_t        *face_offsets;     /**< For each element the index of its first face.
+                                             Has num_elements + 1 entries. */
+  double             *face_area;        /**< For each face its area. */
+  double             *face_normal[3];   /**< The components of the outward face normals.
+                                             NULL for one dimensional forests. */
+  float              *centroid_float[3]; /**< As \a centroid in single precision. */
+  float              *volume_float;     /**< As \a volume in single precision. */
+  float              *face_area_float;  /**< As \a face_area in single precision. */
+  float              *face_normal_float[3]; /**< As \a face_normal in single precision. */
+}
+t8_forest_geometry_cache_t;
+
+/** A copy of the partition tables \a tree_offsets and \a global_first_desc
+ * of a forest that is laid out for fast owner searches.
+ * It stores for each nonempty process the pair of its first tree and the
+ * first descendant in that tree. The pairs are sorted and we store them in
+ * Eytzinger layout, that is the breadth first order of a complete binary
+ * search tree. Entry k has the children 2k and 2k + 1. Thus a search
+ * accesses the memory in a predictable pattern and the top entries
+ * stay in cache.
+ * \see t8_forest_set_owner_table
+ */
+typedef struct t8_forest_owner_table
+{
+  int                 num_entries;      /**< The number of nonempty processes. */
+  t8_gloidx_t        *first_trees;      /**< The first trees in Eytzinger layout, indexed from 1. */
+  t8_linearidx_t     *first_descs;      /**< The first descendants in Eytzinger layout, indexed from 1. */
+  int                *sorted_index;     /**< For each Eytzinger entry its position in sorted order. */
+  int                *ranks;    /**< The nonempty processes in sorted order. */
+}
+t8_forest_owner_table_t;
+
+/** The number of entries in a block of a compact partition table. */
+#define T8_FOREST_PARTITION_COMPACT_BLOCK 32
+
+/** A compressed copy of the partition tables of a forest.
+ * For each nonempty process it stores its rank, its first tree, the first
+ * descendant in that tree and its first element. The entries are grouped
+ * in blocks of \ref T8_FOREST_PARTITION_COMPACT_BLOCK. The first entry of
+ * each block is stored in full and serves as a checkpoint for a binary
+ * search. The other entries are stored as variable length encoded
+ * differences to their predecessor, which mostly fit in a few bytes.
+ * If the first tree changes, the first descendant is stored in full.
+ * \see t8_forest_set_partition_compact
+ */
+typedef struct t8_forest_partition_compact
+{
+  int                 num_entries;      /**< The number of nonempty processes. */
+  int                 num_blocks;       /**< The number of blocks. */
+  int                *block_ranks;      /**< The rank of the first entry of each block. */
+  t8_gloidx_t        *block_trees;      /**< The first tree of the first entry of each block. */
+  t8_linearidx_t     *block_descs;      /**< The first descendant of the first entry of each block. */
+  t8_gloidx_t        *block_elements;   /**< The first element of the first entry of each block. */
+  size_t             *block_offsets;    /**< For each block and one more the offset of its
+                                             encoded entries in \a stream. */
+  unsigned char      *stream;           /**< The encoded differences of all entries that are
+                                             not the first of a block. */
+  t8_gloidx_t         first_local_element; /**< The global index of the first local element. */
+}
+t8_forest_partition_compact_t;
+
+/** The local leaves of a forest that is built from them.
+ * The arrays belong to the user. \see t8_forest_set_leaves */
+typedef struct t8_forest_set_leaves
+{
+  t8_locidx_t         num_leaves;       /**< The number of local leaves. */
+  const t8_gloidx_t  *trees;            /**< The global tree of each leaf. */
+  const t8_linearidx_t *ids;            /**< The linear id of each leaf at its level. */
+  const int          *levels;           /**< The level of each leaf. */
+}
+t8_forest_set_leaves_t;
+
+/** The compact form of the local elements of a forest.
+ * \see t8_forest_compress */
+typedef struct t8_forest_compressed
+{
+  t8_linearidx_t     *first_ids;        /**< For each local tree the linear id (at the maximum level
+                                             of its scheme) of the first descendant of its first
+                                             element. */
+  int8_t             *levels;           /**< The level of each local element. */
+}
+t8_forest_compressed_t;
+
+/** The element arrays of the local trees of forests that were copied from
+ * each other. The element arrays of the trees of these forests are views on
+ * these arrays, which are freed with the last reference.
+ * \see t8_forest_share_trees */
+typedef struct t8_forest_shared_elements
+{
+  t8_refcount_t       rc;               /**< Reference counter, one per forest. */
+  t8_locidx_t         num_trees;        /**< The number of local trees. */
+  t8_element_array_t *elements;         /**< The element array of each local tree. */
+}
+t8_forest_shared_elements_t;
+
+/** The local elements and ghosts of a forest grouped by their level.
+ * \see t8_forest_set_level_lists */
+typedef struct t8_forest_level_lists
+{
+  int                 num_levels;       /**< The number of levels, the maximum existing level
+                                             of the forest plus one. */
+  t8_locidx_t        *element_offsets;  /**< The elements of level l are element_offsets[l], ...,
+                                             element_offsets[l + 1] - 1 in \a elements. */
+  t8_locidx_t        *elements;         /**< The local element indices sorted by level. */
+  t8_locidx_t        *ghost_offsets;    /**< As \a element_offsets for \a ghosts. */
+  t8_locidx_t        *ghosts;           /**< The ghost indices sorted by level. */
+}
+t8_forest_level_lists_t;
+
+/** The positions of the values in a \ref t8_forest_global_reduce_t. */
+typedef enum
+{
+  T8_FOREST_REDUCE_NUM_ELEMENTS = 0,    /**< The number of local elements. */
+  T8_FOREST_REDUCE_NOT_DONE,            /**< 1 if the done flag of the process is false. */
+  T8_FOREST_REDUCE_LEVELS               /**< The number of local elements of level 0, followed
+                                             by those of all other levels of the level lists. */
+}
+t8_forest_reduce_value_t;
+
+/** The values of a forest that are summed over all processes with one
+ * nonblocking collective when the forest is committed. */
+typedef struct t8_forest_global_reduce
+{
+  int                 num_values;       /**< The number of reduced values. */
+  t8_gloidx_t        *values;           /**< The local values followed by the global ones. */
+  sc_MPI_Request      request;          /**< The request of the collective. */
+}
+t8_forest_global_reduce_t;
+
+/** A buffer of element memory kept in a \ref t8_forest_pool. */
+typedef struct t8_forest_pool_buffer
+{
+  char               *data;             /**< The memory, allocated by sc. */
+  size_t              num_bytes;        /**< The size of \a data in bytes. */
+}
+t8_forest_pool_buffer_t;
+
+/** Element memory of destroyed forests that is kept for reuse.
+ * \see t8_forest_pool_init */
+typedef struct t8_forest_pool
+{
+  t8_refcount_t       rc;               /**< Reference counter. */
+  size_t              max_bytes;        /**< The maximum number of bytes in \a buffers. */
+  size_t              num_bytes;        /**< The number of bytes in \a buffers. */
+  sc_array_t          buffers;          /**< The kept buffers, of type \ref t8_forest_pool_buffer_t. */
+}
+t8_forest_pool_struct_t;
+
 /** This structure is private to the implementation. */
 typedef struct t8_forest
 {
   t8_refcount_t       rc;               /**< Reference counter. */
 
   int                 set_level;        /**< Level to use in new construction. */
+  char               *set_load_filename;        /**< If not NULL, the forest is loaded from this file.
+                                                     \see t8_forest_set_load */
+  t8_forest_set_leaves_t *set_leaves;   /**< If not NULL, the forest is built from these leaves.
+                                             \see t8_forest_set_leaves */
+  void               *set_p4est;        /**< If not NULL, the p4est or p8est whose quadrants
+                                             become the elements in commit.
+                                             \see t8_forest_new_from_p4est */
+  int                 set_p4est_dim;    /**< The dimension of \a set_p4est. */
   int                 set_for_coarsening;       /**< Change partition to allow
                                                      for one round of coarsening */
+  t8_forest_partition_weight_t set_partition_weight_fn; /**< If not NULL, the element weights for
+                                                             partition are computed with this callback.
+                                                             \see t8_forest_set_partition_weight */
+  const double       *set_partition_weights; /**< If not NULL, the element weights for partition.
+                                                  \see t8_forest_set_partition_weight */
+  sc_array_t         *set_partition_data; /**< If not NULL, the element data arrays that are partitioned
+                                               with the elements, of type \ref t8_forest_partition_data_t.
+                                               \see t8_forest_set_partition_data */
+  int                 set_partition_diffusive; /**< If true, elements are only moved between neighboring
+                                                    processes. \see t8_forest_set_partition_diffusive */
+  double              set_partition_threshold; /**< The partition is skipped if the element imbalance
+                                                    is at most this value. \see t8_forest_set_partition_threshold */
+  int                 set_partition_num_ranks; /**< If positive, the elements are only partitioned to the processes
+                                                    with rank smaller than this. \see t8_forest_set_partition_ranks */
 
   sc_MPI_Comm         mpicomm;          /**< MPI communicator to use. */
   t8_cmesh_t          cmesh;            /**< Coarse mesh to use. */
@@ -87,8 +387,16 @@ typedef struct t8_forest
 #endif
   t8_forest_adapt_t   set_adapt_fn;     /**< refinement and coarsen function. Called when \b from_method
                                              is set to T8_FOREST_FROM_ADAPT. */
+  t8_forest_adapt_batch_t set_adapt_batch_fn; /**< Batched refinement and coarsen function.
+                                                   If not NULL, it is used instead of
+                                                   \b set_adapt_fn. \see t8_forest_set_adapt_batch */
   int                 set_adapt_recursive; /**< Flag to decide whether coarsen and refine
                                                 are carried out recursive */
+  int                 set_adapt_threads; /**< Number of threads to adapt the local trees with.
+                                              0 or 1 for serial adaptation, negative for
+                                              t8_get_num_threads. \see t8_forest_set_adapt_threads */
+  int                 adapt_unchanged;  /**< Set by \ref t8_forest_adapt. True if no local
+                                             element changed during adaptation. */
   int                 set_balance;      /**< Flag to decide whether to forest will be balance in \ref t8_forest_commit.
                                              See \ref t8_forest_set_balance.
                                              If 0, no balance. If 1 balance with repartitioning, if 2 balance without
@@ -97,6 +405,21 @@ typedef struct t8_forest
   t8_ghost_type_t     ghost_type;       /**< If a ghost layer will be created, the type of neighbors that count as ghost. */
   int                 ghost_algorithm;  /**< Controls the algorithm used for ghost. 1 = balanced only. 2 = also unbalanced
                                              3 = top-down search and unbalanced. */
+  int                 ghost_depth;      /**< The number of ghost layers. Values smaller than 2 mean a single layer.
+                                             \see t8_forest_set_ghost_ext */
+  int                 ghost_neighborhood; /**< If true, the ghost layer is built and exchanged with
+                                               neighborhood collectives. \see t8_forest_set_ghost_neighborhood */
+  size_t              ghost_shared_size; /**< If nonzero, processes on the same node exchange ghost data of
+                                              up to this many bytes per element through shared memory.
+                                              \see t8_forest_set_ghost_shared */
+  size_t              ghost_rma_size; /**< If nonzero, ghost data of up to this many bytes per element is
+                                           exchanged with one-sided communication.
+                                           \see t8_forest_set_ghost_rma */
+  size_t              message_compression; /**< If nonzero, the elements in partition and ghost messages
+                                                of at least this many bytes are compressed.
+                                                \see t8_forest_set_message_compression */
+  int                 do_face_neighbors; /**< If true, the face neighbor table is built when the forest is
+                                              committed. \see t8_forest_set_face_neighbors */
   void               *user_data;        /**< Pointer for arbitrary user data. \see t8_forest_set_user_data. */
   void               *t8code_data;      /**< Pointer for arbitrary data that is used internally. */
   int                 committed;        /**< \ref t8_forest_commit called? */
@@ -108,6 +431,64 @@ typedef struct t8_forest
   t8_gloidx_t         global_num_trees; /**< The total number of global trees */
   sc_array_t         *trees;
   t8_forest_ghost_t   ghosts;           /**< If not NULL, the ghost elements. \see t8_forest_ghost.h */
+  t8_forest_face_neighbors_t *face_neighbors; /**< If not NULL, the face neighbors of the local leafs.
+                                                   \see t8_forest_set_face_neighbors */
+  t8_forest_tree_affine_t *tree_affine; /**< For each local tree its affine map, if it has one. */
+  t8_forest_tree_face_t *tree_faces;    /**< For each local tree and each of its faces
+                                             the connection to the neighbor tree, at
+                                             position tree * T8_ECLASS_MAX_FACES + face. */
+  t8_forest_tree_curved_t *tree_curved; /**< For each local and ghost tree its curved geometry.
+                                             NULL if the cmesh has no tree geometry. */
+  int                 do_geometry_cache; /**< If true, \a geometry_cache is built when the forest
+                                              is committed. \see t8_forest_set_geometry_cache */
+  t8_forest_geometry_cache_t *geometry_cache; /**< If not NULL, the cached geometry of the local
+                                                   and ghost leafs. */
+  sc_array_t         *fields;          /**< If not NULL, the element data fields of type
+                                             \ref t8_forest_field_t. \see t8_forest_field_register */
+  int                 geometry_float;   /**< If true, the geometry cache and the vtk output
+                                             use single precision. \see t8_forest_set_geometry_float */
+  int                 do_element_tree_index; /**< If true, \a element_to_tree is built when the forest
+                                                  is committed. \see t8_forest_set_element_tree_index */
+  t8_locidx_t        *element_to_tree;  /**< If not NULL, the local tree of each local element. */
+  int                 do_element_levels; /**< If true, \a element_levels is built when the forest
+                                              is committed. \see t8_forest_set_element_levels */
+  int8_t             *element_levels;   /**< If not NULL, the level of each local element. */
+  int                 do_level_lists;   /**< If true, \a level_lists is built when the forest
+                                             is committed. \see t8_forest_set_level_lists */
+  t8_forest_level_lists_t *level_lists; /**< If not NULL, the elements and ghosts grouped by level. */
+  int                *reduce_done;      /**< If not NULL, a flag of the caller that is replaced by its
+                                             logical and over all processes when the forest is
+                                             committed. Used by balance. */
+  t8_forest_global_reduce_t *global_reduce; /**< If not NULL, the running reduction of commit. */
+  int                 do_owner_table;   /**< If true, \a owner_table is built when the forest
+                                             is committed. \see t8_forest_set_owner_table */
+  t8_forest_owner_table_t *owner_table; /**< If not NULL, a search table of the partition.
+                                             \see t8_forest_set_owner_table */
+  int                 do_partition_compact; /**< If true, \a partition_compact is built and the
+                                                 shared partition tables are freed when the forest
+                                                 is committed. \see t8_forest_set_partition_compact */
+  t8_forest_partition_compact_t *partition_compact; /**< If not NULL, a compressed copy of
+                                                         the partition tables. */
+  int                 do_traversal_order; /**< If true, \a tree_order and \a element_order are built
+                                               when the forest is committed.
+                                               \see t8_forest_set_traversal_order */
+  t8_locidx_t        *tree_order;       /**< If not NULL, the local trees sorted along a Hilbert curve
+                                             through their centroids. */
+  t8_locidx_t        *element_order;    /**< If not NULL, the local elements in the order of
+                                             \a tree_order, in SFC order within each tree. */
+  int                 memory_hugepages; /**< If true, the element arrays are advised to use
+                                             transparent huge pages. \see t8_forest_set_memory_advice */
+  t8_forest_memory_advise_t memory_advise_fn; /**< If not NULL, called for the memory of each element
+                                                   array when the forest is committed. */
+  void               *memory_advise_data; /**< User data passed to \a memory_advise_fn. */
+  t8_forest_compressed_t *compressed;   /**< If not NULL, the forest is compressed and the
+                                             element arrays of the local trees are empty.
+                                             \see t8_forest_compress */
+  t8_forest_pool_t    pool;             /**< If not NULL, the pool that element memory is taken from
+                                             and returned to. \see t8_forest_set_pool */
+  t8_forest_shared_elements_t *shared_elements; /**< If not NULL, the element arrays of the local
+                                                     trees are views on these shared arrays.
+                                                     \see t8_forest_share_trees */
   t8_shmem_array_t    element_offsets; /**< If partitioned, for each process the global index
                                             of its first element. Since it is memory consuming,
                                             it is usually only constructed when needed and otherwise unallocated. */
@@ -134,9 +515,12 @@ typedef struct t8_tree
 {
   t8_element_array_t  elements;              /**< locally stored elements */
   t8_eclass_t         eclass;                /**< The element class of this tree */
-  /* TODO: We will need the *_desc variables later for shure. */
   t8_element_t       *first_desc,            /**< first local descendant */
                      *last_desc;             /**< last local descendant */
+  t8_linearidx_t      first_desc_id;         /**< The linear id of \a first_desc
+                                                  at the forest's maxlevel */
+  t8_linearidx_t      last_desc_id;          /**< The linear id of \a last_desc
+                                                  at the forest's maxlevel */
   t8_locidx_t         elements_offset;      /**< cumulative sum over earlier
                                                   trees on this processor
                                                   (locals only) */
@@ -150,7 +534,30 @@ t8_tree_struct_t;
  */
 
 /** The number of statistics collected by a profile struct. */
-#define T8_PROFILE_NUM_STATS 13
+#define T8_PROFILE_NUM_STATS 24
+
+/** The phases of the forest algorithms for which hardware counters and
+ * memory peaks are stored in a profile struct. */
+typedef enum t8_profile_hw_phase
+{
+  T8_PROFILE_HW_ADAPT = 0,      /**< \ref t8_forest_adapt */
+  T8_PROFILE_HW_BALANCE,        /**< \ref t8_forest_balance */
+  T8_PROFILE_HW_PARTITION,      /**< \ref t8_forest_partition */
+  T8_PROFILE_HW_GHOST,          /**< The ghost layer creation */
+  T8_PROFILE_HW_COMMIT,         /**< \ref t8_forest_commit */
+  T8_PROFILE_HW_NUM_PHASES      /**< The number of phases */
+} t8_profile_hw_phase_t;
+
+/** The communicating phases of the forest algorithms, for which the
+ * messages are counted in a profile struct. */
+typedef enum t8_profile_comm_phase
+{
+  T8_PROFILE_COMM_PARTITION = 0, /**< \ref t8_forest_partition and \ref t8_forest_partition_data */
+  T8_PROFILE_COMM_GHOST,        /**< The last ghost layer creation */
+  T8_PROFILE_COMM_GHOST_EXCHANGE, /**< All ghost data exchanges of the forest */
+  T8_PROFILE_COMM_BALANCE,      /**< The ghost layers and partitions of the balance rounds */
+  T8_PROFILE_COMM_NUM_PHASES    /**< The number of phases */
+} t8_profile_comm_phase_t;
 typedef struct t8_profile
 {
   t8_locidx_t         partition_elements_shipped; /**< The number of elements this process has
@@ -161,6 +568,8 @@ typedef struct t8_profile
                                                  last partition call. */
   int                 partition_procs_sent; /**< The number of different processes this process has send
                                             local elements to in the last partition call. */
+  double              partition_weight_imbalance; /**< The maximum weight of a process divided by the average
+                                                       weight after the last weighted partition call. */
   t8_locidx_t         ghosts_shipped;     /**< The number of ghost elements this process has sent to other processes. */
   t8_locidx_t         ghosts_received;    /**< The number of ghost elements this process has received from other processes. */
   int                 ghosts_remotes;     /**< The number of processes this process have sent ghost elements to (and received from). */
@@ -169,8 +578,29 @@ typedef struct t8_profile
   double              partition_runtime;  /**< The runtime of  the last call to \a t8_cmesh_partition (not countint partition in t8_forest_balance). */
   double              ghost_runtime;      /**< The runtime of the last call to \a t8_forest_ghost_create. */
   double              ghost_waittime;     /**< Amount of synchronisation time in ghost. */
+  double              ghost_search_runtime; /**< The runtime of the search for remote elements in the last ghost creation. */
+  double              ghost_owner_runtime; /**< The part of \a ghost_search_runtime spent computing the owners of face neighbors. */
+  double              ghost_pack_runtime; /**< The runtime of packing the remote elements into the send buffers. */
+  double              ghost_receive_runtime; /**< The time spent probing for and receiving ghost messages, without parsing. */
+  double              ghost_parse_runtime; /**< The runtime of parsing the received ghost messages. */
+  size_t              ghost_bytes_sent;   /**< The number of bytes sent in the last ghost creation. */
+  size_t              ghost_bytes_received; /**< The number of bytes received in the last ghost creation. */
+  sc_statinfo_t       ghost_message_size; /**< The sizes in bytes of the received ghost messages. */
+  sc_statinfo_t       ghost_message_latency; /**< For each received ghost message the time from posting the sends
+                                                  until it was received. Only measured for point-to-point messages. */
   double              balance_runtime;    /**< The runtime of the last call to \a t8_forest_balance. */
   double              commit_runtime;     /**< The runtime of the last call to \a t8_cmesh_commit. */
+  size_t              partition_table_bytes; /**< The memory per process of the element offsets, tree offsets
+                                                  and first descendants. Smaller than their size if they are
+                                                  stored once per node. */
+  double              hw_counters[T8_PROFILE_HW_NUM_PHASES][T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+                                          /**< For each phase the hardware counters of its last call.
+                                               Only recorded if t8code is configured with a counter
+                                               library, \see t8_profile_regions_num_hw_counters. */
+  double              memory_peak[T8_PROFILE_HW_NUM_PHASES];
+                                          /**< For each phase the peak heap memory in bytes during its
+                                               last call, \see t8_profile_regions_set_memory. */
+  t8_profile_comm_t   comm[T8_PROFILE_COMM_NUM_PHASES]; /**< The messages of each communicating phase. */
 
 }
 t8_profile_struct_t;
@@ -187,13 +617,19 @@ typedef struct t8_forest_ghost
   sc_array_t         *ghost_trees;      /* ghost tree data:
                                            global_id.
                                            eclass.
-                                           elements. In linear id order */
-  sc_hash_t          *global_tree_to_ghost_tree;        /* Indexes into ghost_trees.
-                                                           Given a global tree id I give the index
-                                                           i such that the tree is in ghost_trees[i]
-                                                         */
-  sc_hash_t          *process_offsets;  /* Given a process, return the first ghost tree and
-                                           whithin it the first element of that process. */
+                                           elements. In linear id order.
+                                           Sorted by global_id. */
+  t8_locidx_t        *global_tree_to_ghost_tree;        /* If not NULL, indexes into ghost_trees.
+                                                           Given a global tree id I, entry I - first_ghost_gtree
+                                                           is the index i such that the tree is in ghost_trees[i],
+                                                           or -1 if I is not a ghost tree.
+                                                           Only built if the ids are compact, otherwise
+                                                           we binary search in ghost_trees. */
+  t8_gloidx_t         first_ghost_gtree;        /* The smallest global id of a ghost tree */
+  t8_gloidx_t         num_ghost_gtree_ids;      /* The number of entries of global_tree_to_ghost_tree */
+  sc_array_t         *process_offsets;  /* For each process in remote_processes (same order),
+                                           the first ghost tree and whithin it the first element
+                                           of that process and its first ghost element. */
 #if 0
   /* TODO: obsolete by remote_processes below. */
   sc_array_t         *processes;        /* ranks of the processes */
@@ -206,9 +642,15 @@ typedef struct t8_forest_ghost
                                          */
   sc_array_t         *remote_processes; /* The ranks of the processes for which local elements are ghost.
                                            Array of int's. */
-
-  sc_mempool_t       *glo_tree_mempool;
-  sc_mempool_t       *proc_offset_mempool;
+  t8_ghost_exchange_plan_t *exchange_plan; /* If not NULL, the precomputed communication pattern of
+                                              ghost data exchanges. Built on the first exchange. */
+  sc_MPI_Comm         neighbor_comm;    /* If not sc_MPI_COMM_NULL, the distributed graph communicator
+                                           connecting this process with its remote processes,
+                                           used for neighborhood collective exchanges. */
+  t8_ghost_shared_t  *shared;           /* If not NULL, the shared memory window through which processes
+                                           on the same node exchange ghost data. */
+  t8_ghost_rma_t     *rma;              /* If not NULL, the window into which the owners of our ghosts
+                                           put their data. */
 } t8_forest_ghost_struct_t;
 
 #endif /* ! T8_FOREST_TYPES_H! */
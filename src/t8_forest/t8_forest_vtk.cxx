@@ -25,15 +25,82 @@
 #include <t8_cmesh.h>
 #include <t8_element_cxx.hxx>
 #include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_io.h>
+#include <t8_forest/t8_forest_fields.h>
 #include <t8_vec.h>
+#include <sc_io.h>
 #include "t8_cmesh/t8_cmesh_trees.h"
 #include "t8_forest_types.h"
+#include <t8_profile_regions.h>
+#ifdef SC_ENABLE_PTHREAD
+#include <pthread.h>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
-/* TODO: Currently we only use ASCII mode and no data compression.
- *       We also do not use sc_io to buffer our output stream. */
+/* In ASCII mode the kernels print each value to a buffer that is written to
+ * the file in chunks.
+ * In the binary modes they append the raw values of the current data array
+ * to a buffer and the whole array is written at once when it is complete.
+ * Base64 encoding and compression are done by sc_io. */
+
+/* A numbering of the distinct points of the cells of a process.
+ * The corners of the cells are ordered as in the connectivity array, that
+ * is by cell and within a cell in vtk corner order. The points are numbered
+ * in the order in which they first occur as a corner. */
+typedef struct
+{
+  t8_locidx_t         num_corners;      /* The number of cell corners, counted with multiplicity. */
+  t8_locidx_t         num_points;       /* The number of distinct points. */
+  t8_locidx_t        *corner_to_point;  /* For each cell corner its point. */
+  t8_locidx_t        *corner_element;   /* For each cell corner the local index of its cell,
+                                           -1 for ghosts. */
+  double             *coords;   /* 3 coordinates per point. */
+} t8_forest_vtk_points_t;
+
+/* The state of the kernels that write one value per point */
+typedef struct
+{
+  const t8_forest_vtk_points_t *points;
+  const double       *values;   /* num_components values per point, may be NULL
+                                   for the connectivity. */
+  int                 num_components;
+  const char         *ascii_format;     /* The format of a value in ASCII mode. */
+  t8_locidx_t         corner;   /* The current corner. */
+  t8_locidx_t         next_point;       /* The first point that was not written yet. */
+} t8_forest_vtk_point_values_t;
+
+/* The output stream of a vtu file together with the state needed for
+ * binary output. */
+typedef struct
+{
+  FILE               *file;     /* The vtu file. */
+  t8_vtk_format_t     format;   /* The output format. */
+  int                 value_type;       /* The type of the values of the current data array. */
+  sc_array_t          buffer;   /* Raw bytes of the current data array, and in appended
+                                   mode of all previous data arrays. */
+  size_t              array_start;      /* Position in buffer where the current array starts. */
+  sc_array_t         *xml;      /* If not NULL, the xml text is written to this array
+                                   instead of the file. */
+  sc_array_t         *offset_positions;     /* If \a xml is not NULL, the positions of the appended
+                                               data offsets in \a xml. */
+  t8_forest_vtk_points_t *points;       /* If not NULL, the points are written once each
+                                           and not once per cell corner. */
+  const char         *float_name;       /* The vtk type of floating point data arrays. */
+  const char         *float_format;     /* The ASCII format of coordinates. */
+  const char         *selected; /* If not NULL, only the local elements with a
+                                   nonzero entry are written, and no ghosts. */
+} t8_forest_vtk_output_t;
+
+/* The vtk types that we use for data arrays */
+enum
+{
+  T8_VTK_VALUE_INT32,
+  T8_VTK_VALUE_INT64,
+  T8_VTK_VALUE_FLOAT32,
+  T8_VTK_VALUE_FLOAT64
+};
 
 /* There are different cell data to write, e.g. connectivity, type, vertices, ...
  * The structure is always the same:
@@ -71,7 +138,9 @@ typedef enum
  * \param [in] is_ghost Non-zero if the current element is a ghost element.
  *                      In this cas \a tree is NULL.
  *                      All ghost element will be traversed after all elements are
- * \param [in,out] vtufile The open file stream to which we write the forest.
+ * \param [in,out] out     The output stream to which we write the forest.
+ *                         Values are written with \ref t8_forest_vtk_output_int
+ *                         and \ref t8_forest_vtk_output_float.
  * \param [in,out] columns An integer counting the number of written columns.
  *                         The callback should increase this value by the number
  *                         of values written to the file.
@@ -89,14 +158,225 @@ typedef int         (*t8_forest_vtk_cell_data_kernel) (t8_forest_t forest,
                                                        t8_element_t * element,
                                                        t8_eclass_scheme_c *
                                                        ts, int is_ghost,
-                                                       FILE * vtufile,
-                                                       int *columns,
+                                                       t8_forest_vtk_output_t
+                                                       * out, int *columns,
                                                        void **data,
                                                        T8_VTK_KERNEL_MODUS
                                                        modus);
 
+/* In ASCII mode the values of a data array are formatted into the buffer
+ * of the output stream and written in chunks of this many bytes. */
+#define T8_FOREST_VTK_ASCII_CHUNK 65536
+
+/* Write the ASCII values that are pending in the buffer of \a out.
+ * Return true on success. */
+static int
+t8_forest_vtk_output_flush (t8_forest_vtk_output_t * out)
+{
+  size_t              num_bytes;
+  int                 success = 1;
+
+  num_bytes = out->buffer.elem_count;
+  if (out->format != T8_VTK_FORMAT_ASCII || num_bytes == 0) {
+    return 1;
+  }
+  if (out->xml != NULL) {
+    memcpy (sc_array_push_count (out->xml, num_bytes), out->buffer.array,
+            num_bytes);
+  }
+  else {
+    success =
+      fwrite (out->buffer.array, 1, num_bytes, out->file) == num_bytes;
+  }
+  /* Keep the memory of the buffer for the next chunk */
+  sc_array_truncate (&out->buffer);
+  return success;
+}
+
+/* Format an ASCII value into the buffer of \a out and write the buffer
+ * when it is full. Return true on success. */
+static int
+t8_forest_vtk_output_ascii (t8_forest_vtk_output_t * out,
+                            const char *format, ...)
+{
+  va_list             ap;
+  char                text[BUFSIZ];
+  int                 num_chars;
+
+  va_start (ap, format);
+  num_chars = vsnprintf (text, BUFSIZ, format, ap);
+  va_end (ap);
+  if (num_chars <= 0 || num_chars >= BUFSIZ) {
+    return 0;
+  }
+  memcpy (sc_array_push_count (&out->buffer, num_chars), text, num_chars);
+  if (out->buffer.elem_count >= T8_FOREST_VTK_ASCII_CHUNK) {
+    return t8_forest_vtk_output_flush (out);
+  }
+  return 1;
+}
+
+/* Print xml text to the file of \a out, or append it to \a out->xml.
+ * Return the number of characters written, a negative value or 0 on error. */
+static int
+t8_forest_vtk_printf (t8_forest_vtk_output_t * out, const char *format, ...)
+{
+  va_list             ap;
+  char                text[3 * BUFSIZ];
+  int                 num_chars;
+
+  if (!t8_forest_vtk_output_flush (out)) {
+    return 0;
+  }
+  va_start (ap, format);
+  if (out->xml == NULL) {
+    num_chars = vfprintf (out->file, format, ap);
+    va_end (ap);
+    return num_chars;
+  }
+  num_chars = vsnprintf (text, 3 * BUFSIZ, format, ap);
+  va_end (ap);
+  if (num_chars < 0 || num_chars >= 3 * BUFSIZ) {
+    return 0;
+  }
+  memcpy (sc_array_push_count (out->xml, num_chars), text, num_chars);
+  return num_chars;
+}
+
+/* Return the value type of a vtk data type string */
+static int
+t8_forest_vtk_value_type (const char *datatype)
+{
+  if (!strcmp (datatype, "Int32")) {
+    return T8_VTK_VALUE_INT32;
+  }
+  else if (!strcmp (datatype, "Int64")) {
+    return T8_VTK_VALUE_INT64;
+  }
+  else if (!strcmp (datatype, "Float32")) {
+    return T8_VTK_VALUE_FLOAT32;
+  }
+  T8_ASSERT (!strcmp (datatype, "Float64"));
+  return T8_VTK_VALUE_FLOAT64;
+}
+
+/* Choose the precision of the floating point data arrays of a forest.
+ * \see t8_forest_set_geometry_float */
+static void
+t8_forest_vtk_output_set_precision (t8_forest_vtk_output_t * out,
+                                    t8_forest_t forest)
+{
+  if (forest->geometry_float) {
+    out->float_name = "Float32";
+    out->float_format = " %16.8e";
+    return;
+  }
+  out->float_name = T8_VTK_FLOAT_NAME;
+#ifdef T8_VTK_DOUBLES
+  out->float_format = " %24.16e";
+#else
+  out->float_format = " %16.8e";
+#endif
+}
+
+/* Append the raw bytes of a value to the buffer of the current array */
+static void
+t8_forest_vtk_output_push (t8_forest_vtk_output_t * out, const void *value,
+                           size_t size)
+{
+  memcpy (sc_array_push_count (&out->buffer, size), value, size);
+}
+
+/* Write an integer value of the current data array.
+ * Return true on success. */
+static int
+t8_forest_vtk_output_int (t8_forest_vtk_output_t * out, long long value)
+{
+  int32_t             value32;
+  int64_t             value64;
+
+  if (out->format == T8_VTK_FORMAT_ASCII) {
+    return t8_forest_vtk_output_ascii (out, " %lld", value);
+  }
+  if (out->value_type == T8_VTK_VALUE_INT64) {
+    value64 = (int64_t) value;
+    t8_forest_vtk_output_push (out, &value64, sizeof (value64));
+  }
+  else {
+    T8_ASSERT (out->value_type == T8_VTK_VALUE_INT32);
+    value32 = (int32_t) value;
+    t8_forest_vtk_output_push (out, &value32, sizeof (value32));
+  }
+  return 1;
+}
+
+/* Write a floating point value of the current data array.
+ * In ASCII mode, \a ascii_format is used to print the value.
+ * Return true on success. */
+static int
+t8_forest_vtk_output_float (t8_forest_vtk_output_t * out, double value,
+                            const char *ascii_format)
+{
+  float               valuef;
+
+  if (out->format == T8_VTK_FORMAT_ASCII) {
+    return t8_forest_vtk_output_ascii (out, ascii_format, value);
+  }
+  if (out->value_type == T8_VTK_VALUE_FLOAT64) {
+    t8_forest_vtk_output_push (out, &value, sizeof (value));
+  }
+  else {
+    T8_ASSERT (out->value_type == T8_VTK_VALUE_FLOAT32);
+    valuef = (float) value;
+    t8_forest_vtk_output_push (out, &valuef, sizeof (valuef));
+  }
+  return 1;
+}
+
+/* Count the local elements that are written.
+ * If \a selected is not NULL, only the elements with a nonzero entry. */
+static              t8_locidx_t
+t8_forest_vtk_num_selected (t8_tree_t tree, const char *selected)
+{
+  t8_locidx_t         num_elements, ielem, num_selected;
+
+  num_elements = t8_element_array_get_count (&tree->elements);
+  if (selected == NULL) {
+    return num_elements;
+  }
+  for (ielem = 0, num_selected = 0; ielem < num_elements; ielem++) {
+    num_selected += selected[tree->elements_offset + ielem] != 0;
+  }
+  return num_selected;
+}
+
+/* The number of cells that are written by a process */
+static              t8_locidx_t
+t8_forest_vtk_num_cells (t8_forest_t forest, int count_ghosts,
+                         const char *selected)
+{
+  t8_locidx_t         itree, num_cells;
+
+  if (selected == NULL) {
+    num_cells = t8_forest_get_num_element (forest);
+    if (count_ghosts) {
+      num_cells += t8_forest_get_num_ghosts (forest);
+    }
+    return num_cells;
+  }
+  T8_ASSERT (!count_ghosts);
+  num_cells = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    num_cells +=
+      t8_forest_vtk_num_selected (t8_forest_get_tree (forest, itree),
+                                  selected);
+  }
+  return num_cells;
+}
+
 static              t8_locidx_t
-t8_forest_num_points (t8_forest_t forest, int count_ghosts)
+t8_forest_num_points (t8_forest_t forest, int count_ghosts,
+                      const char *selected)
 {
   t8_locidx_t         itree, num_points, num_ghosts;
   t8_tree_t           tree;
@@ -108,7 +388,7 @@ t8_forest_num_points (t8_forest_t forest, int count_ghosts)
     tree = (t8_tree_t) t8_sc_array_index_topidx (forest->trees, itree);
     /* TODO: This will cause problems when pyramids are introduced. */
     num_points += t8_eclass_num_vertices[tree->eclass] *
-      t8_element_array_get_count (&tree->elements);
+      t8_forest_vtk_num_selected (tree, selected);
   }
   if (count_ghosts) {
     T8_ASSERT (forest->ghosts != NULL);
@@ -127,6 +407,9 @@ t8_forest_num_points (t8_forest_t forest, int count_ghosts)
   return num_points;
 }
 
+/* The number of local elements whose corners the vertices kernel computes at once */
+#define T8_FOREST_VTK_VERTEX_BATCH 256
+
 static int
 t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                      t8_tree_t tree,
@@ -134,7 +417,8 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                      t8_element_t * element,
                                      t8_eclass_scheme_c * ts,
                                      int is_ghost,
-                                     FILE * vtufile, int *columns,
+                                     t8_forest_vtk_output_t * out,
+                                     int *columns,
                                      void **data, T8_VTK_KERNEL_MODUS modus)
 {
   struct t8_forest_vtk_vertices_t
@@ -142,6 +426,10 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
     t8_locidx_t         ltreeid;        /* Store the last treeid with which the lernel was called.
                                            This is either a local tree id or a local ghost tree id */
     double              tree_vertices[T8_ECLASS_MAX_CORNERS * 3];       /* Stores the vertex coordinates of the tree */
+    double              batch[T8_FOREST_VTK_VERTEX_BATCH * T8_ECLASS_MAX_CORNERS * 3];  /* The corner coordinates
+                                                                                           of a batch of local elements */
+    t8_locidx_t         batch_first;    /* The index in the tree of the first element in batch */
+    t8_locidx_t         batch_count;    /* The number of elements in batch */
   }                  *vertex_data;
 
 #if 0
@@ -149,7 +437,8 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   double              midpoint[3];
 #endif
   double              element_coordinates[3];
-  int                 num_tree_vertices, ivertex;
+  const double       *coordinates;
+  int                 num_tree_vertices, ivertex, idim;
   int                 freturn;
 
   if (modus == T8_VTK_KERNEL_INIT) {
@@ -186,8 +475,26 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
 
     /* Copy the tree's vertex coordinates into the struct of the data pointer */
     num_tree_vertices = t8_eclass_num_vertices[ts->eclass];
-    memcpy (vertex_data->tree_vertices, temp_vertices, sizeof (*temp_vertices)
-            * num_tree_vertices * 3);
+    if (temp_vertices != NULL) {
+      memcpy (vertex_data->tree_vertices, temp_vertices,
+              sizeof (*temp_vertices) * num_tree_vertices * 3);
+    }
+    /* Otherwise the corners are computed from the cmesh's geometry */
+    vertex_data->batch_count = 0;
+  }
+  num_tree_vertices = t8_eclass_num_vertices[ts->eclass];
+  if (!is_ghost && (element_index < vertex_data->batch_first
+                    || element_index >= vertex_data->batch_first
+                    + vertex_data->batch_count)) {
+    /* Compute the corners of the next local elements at once */
+    vertex_data->batch_first = element_index;
+    vertex_data->batch_count =
+      SC_MIN (T8_FOREST_VTK_VERTEX_BATCH,
+              t8_forest_get_tree_element_count (tree) - element_index);
+    t8_forest_element_coordinates_batch (forest, ltree_id, element_index,
+                                         vertex_data->batch_count,
+                                         vertex_data->tree_vertices,
+                                         vertex_data->batch);
   }
 
   /* TODO: be careful with pyramid class here.
@@ -199,11 +506,19 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   t8_forest_element_centroid (forest, ltree_id, element,
                               vertex_data->tree_vertices, midpoint);
 #endif
-  for (ivertex = 0; ivertex < t8_eclass_num_vertices[ts->eclass]; ivertex++) {
-    t8_forest_element_coordinate (forest, ltree_id, element,
-                                  vertex_data->tree_vertices,
-                                  t8_eclass_vtk_corner_number[ts->eclass]
-                                  [ivertex], element_coordinates);
+  for (ivertex = 0; ivertex < num_tree_vertices; ivertex++) {
+    if (!is_ghost) {
+      coordinates = vertex_data->batch + 3 *
+        ((element_index - vertex_data->batch_first) * num_tree_vertices
+         + t8_eclass_vtk_corner_number[ts->eclass][ivertex]);
+    }
+    else {
+      t8_forest_element_coordinate (forest, ltree_id, element,
+                                    vertex_data->tree_vertices,
+                                    t8_eclass_vtk_corner_number[ts->eclass]
+                                    [ivertex], element_coordinates);
+      coordinates = element_coordinates;
+    }
 #if 0
     /* if we eventually implement scaling the elements, activate this line */
     /* replace 0.9 with the scale factor
@@ -211,26 +526,16 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
     t8_vec_ax (element_coordinates, 0.9);
     t8_vec_axpy (midpoint, element_coordinates, 0.1);
 #endif
-    freturn = fprintf (vtufile, "         ");
-    if (freturn <= 0) {
-      return 0;
-    }
-#ifdef T8_VTK_DOUBLES
-    freturn = fprintf (vtufile, " %24.16e %24.16e %24.16e\n",
-                       element_coordinates[0], element_coordinates[1],
-                       element_coordinates[2]);
-#else
-    freturn = fprintf (vtufile, " %16.8e %16.8e %16.8e\n",
-                       element_coordinates[0], element_coordinates[1],
-                       element_coordinates[2]);
-#endif
-    if (freturn <= 0) {
-      return 0;
+    for (idim = 0; idim < 3; idim++) {
+      freturn = t8_forest_vtk_output_float (out, coordinates[idim],
+                                            out->float_format);
+      if (!freturn) {
+        return 0;
+      }
     }
-    /* We switch of the colum control of the surrounding function
-     * by keeping the columns value constant. */
-    *columns = 1;
   }
+  /* Each element's vertices are written in one row */
+  *columns += 3 * num_tree_vertices;
   return 1;
 }
 
@@ -350,7 +655,8 @@ t8_forest_vtk_cells_connectivity_kernel (t8_forest_t forest,
                                          t8_element_t * elements,
                                          t8_eclass_scheme_c * ts,
                                          int is_ghost,
-                                         FILE * vtufile, int *columns,
+                                         t8_forest_vtk_output_t * out,
+                                         int *columns,
                                          void **data,
                                          T8_VTK_KERNEL_MODUS modus)
 {
@@ -376,8 +682,8 @@ t8_forest_vtk_cells_connectivity_kernel (t8_forest_t forest,
                   "No vtk support for pyramids.");
   for (ivertex = 0; ivertex < t8_eclass_num_vertices[ts->eclass];
        ++ivertex, (*count_vertices)++) {
-    freturn = fprintf (vtufile, " %ld", (long) *count_vertices);
-    if (freturn <= 0) {
+    freturn = t8_forest_vtk_output_int (out, *count_vertices);
+    if (!freturn) {
       return 0;
     }
   }
@@ -392,7 +698,8 @@ t8_forest_vtk_cells_offset_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_forest_vtk_output_t * out,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   long long          *offset;
@@ -414,8 +721,8 @@ t8_forest_vtk_cells_offset_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   SC_CHECK_ABORT (ts->eclass != T8_ECLASS_PYRAMID,
                   "Pyramids not supported in vtk");
   *offset += t8_eclass_num_vertices[ts->eclass];
-  freturn = fprintf (vtufile, " %lld", *offset);
-  if (freturn <= 0) {
+  freturn = t8_forest_vtk_output_int (out, *offset);
+  if (!freturn) {
     return 0;
   }
   *columns += 1;
@@ -430,14 +737,15 @@ t8_forest_vtk_cells_type_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                  t8_element_t * element,
                                  t8_eclass_scheme_c * ts,
                                  int is_ghost,
-                                 FILE * vtufile, int *columns,
+                                 t8_forest_vtk_output_t * out,
+                                 int *columns,
                                  void **data, T8_VTK_KERNEL_MODUS modus)
 {
   int                 freturn;
   if (modus == T8_VTK_KERNEL_EXECUTE) {
     /* print the vtk type of the element */
-    freturn = fprintf (vtufile, " %d", t8_eclass_vtk_type[ts->eclass]);
-    if (freturn <= 0) {
+    freturn = t8_forest_vtk_output_int (out, t8_eclass_vtk_type[ts->eclass]);
+    if (!freturn) {
       return 0;
     }
     *columns += 1;
@@ -452,11 +760,19 @@ t8_forest_vtk_cells_level_kernel (t8_forest_t forest,
                                   t8_element_t * element,
                                   t8_eclass_scheme_c * ts,
                                   int is_ghost,
-                                  FILE * vtufile, int *columns,
+                                  t8_forest_vtk_output_t * out,
+                                  int *columns,
                                   void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    fprintf (vtufile, "%i ", ts->t8_element_level (element));
+    if (!t8_forest_vtk_output_int (out, !is_ghost
+                                   && forest->element_levels != NULL ?
+                                   forest->element_levels[tree->
+                                                          elements_offset +
+                                                          element_index] :
+                                   ts->t8_element_level (element))) {
+      return 0;
+    }
     *columns += 1;
   }
   return 1;
@@ -469,11 +785,14 @@ t8_forest_vtk_cells_rank_kernel (t8_forest_t forest,
                                  t8_element_t * element,
                                  t8_eclass_scheme_c * ts,
                                  int is_ghost,
-                                 FILE * vtufile, int *columns,
+                                 t8_forest_vtk_output_t * out,
+                                 int *columns,
                                  void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    fprintf (vtufile, "%i ", forest->mpirank);
+    if (!t8_forest_vtk_output_int (out, forest->mpirank)) {
+      return 0;
+    }
     *columns += 1;
   }
   return 1;
@@ -486,7 +805,8 @@ t8_forest_vtk_cells_treeid_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_forest_vtk_output_t * out,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
@@ -499,7 +819,9 @@ t8_forest_vtk_cells_treeid_kernel (t8_forest_t forest,
       /* Otherwise the global tree id */
       tree_id = (long long) ltree_id + forest->first_local_tree;
     }
-    fprintf (vtufile, "%lli ", tree_id);
+    if (!t8_forest_vtk_output_int (out, tree_id)) {
+      return 0;
+    }
     *columns += 1;
   }
   return 1;
@@ -512,16 +834,22 @@ t8_forest_vtk_cells_elementid_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      t8_forest_vtk_output_t * out,
+                                      int *columns,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
+    long long           element_id;
+
     if (!is_ghost) {
-      fprintf (vtufile, "%lli ", element_index + tree->elements_offset +
-               (long long) t8_forest_get_first_local_element_id (forest));
+      element_id = element_index + tree->elements_offset +
+        (long long) t8_forest_get_first_local_element_id (forest);
     }
     else {
-      fprintf (vtufile, "%lli ", (long long) -1);
+      element_id = -1;
+    }
+    if (!t8_forest_vtk_output_int (out, element_id)) {
+      return 0;
     }
     *columns += 1;
   }
@@ -535,7 +863,8 @@ t8_forest_vtk_cells_scalar_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_forest_vtk_output_t * out,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double              element_value = 0;
@@ -551,7 +880,9 @@ t8_forest_vtk_cells_scalar_kernel (t8_forest_t forest,
     else {
       element_value = 0;
     }
-    fprintf (vtufile, "%g ", element_value);
+    if (!t8_forest_vtk_output_float (out, element_value, " %g")) {
+      return 0;
+    }
     *columns += 1;
   }
   return 1;
@@ -564,7 +895,8 @@ t8_forest_vtk_cells_vector_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   t8_forest_vtk_output_t * out,
+                                   int *columns,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double             *element_values, null_vec[3] = { 0, 0, 0 };
@@ -585,7 +917,9 @@ t8_forest_vtk_cells_vector_kernel (t8_forest_t forest,
       element_values = null_vec;
     }
     for (idim = 0; idim < dim; idim++) {
-      fprintf (vtufile, "%g ", element_values[idim]);
+      if (!t8_forest_vtk_output_float (out, element_values[idim], " %g")) {
+        return 0;
+      }
     }
     *columns += dim;
   }
@@ -600,7 +934,8 @@ t8_forest_vtk_vertices_scalar_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      t8_forest_vtk_output_t * out,
+                                      int *columns,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double              element_value = 0;
@@ -620,7 +955,9 @@ t8_forest_vtk_vertices_scalar_kernel (t8_forest_t forest,
       else {
         element_value = 0;
       }
-      fprintf (vtufile, "%g ", element_value);
+      if (!t8_forest_vtk_output_float (out, element_value, " %g")) {
+        return 0;
+      }
       *columns += 1;
     }
   }
@@ -635,7 +972,8 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      t8_forest_vtk_output_t * out,
+                                      int *columns,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double             *element_values, null_vec[3] = { 0, 0, 0 };
@@ -659,7 +997,9 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
         element_values = null_vec;
       }
       for (idim = 0; idim < dim; idim++) {
-        fprintf (vtufile, "%g ", element_values[idim]);
+        if (!t8_forest_vtk_output_float (out, element_values[idim], " %g")) {
+          return 0;
+        }
       }
       *columns += dim;
     }
@@ -667,18 +1007,178 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
   return 1;
 }
 
-/* Iterate over all cells and write cell data to the file using
- * the cell_data_kernel as callback */
+/* Start a data array in a binary format. Its values are collected in the
+ * buffer of \a out. */
+static void
+t8_forest_vtk_begin_binary_array (t8_forest_vtk_output_t * out,
+                                  const char *datatype)
+{
+  uint64_t            num_bytes = 0;
+
+  T8_ASSERT (out->format != T8_VTK_FORMAT_ASCII);
+  out->value_type = t8_forest_vtk_value_type (datatype);
+  out->array_start = out->buffer.elem_count;
+  if (out->format == T8_VTK_FORMAT_APPENDED) {
+    /* Reserve the space for the size header of the array */
+    t8_forest_vtk_output_push (out, &num_bytes, sizeof (num_bytes));
+  }
+}
+
+/* Finish a data array in a binary format.
+ * In appended mode we write the header of the array with its offset into
+ * the appended data and keep the values in the buffer.
+ * Otherwise we write the header and the encoded values of the array.
+ * Return true on success. */
 static int
-t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
-                               const char *dataname,
-                               const char *datatype,
-                               const char *component_string,
-                               int max_columns,
-                               t8_forest_vtk_cell_data_kernel kernel,
-                               int write_ghosts, void *udata)
+t8_forest_vtk_end_binary_array (t8_forest_vtk_output_t * out,
+                                const char *dataname, const char *datatype,
+                                const char *component_string)
 {
+  uint64_t            num_bytes;
+  char               *values;
   int                 freturn;
+
+  T8_ASSERT (out->format != T8_VTK_FORMAT_ASCII);
+  values = out->buffer.array + out->array_start;
+  num_bytes = out->buffer.elem_count - out->array_start;
+  if (out->format == T8_VTK_FORMAT_APPENDED) {
+    /* Store the number of bytes of the array in front of it */
+    num_bytes -= sizeof (num_bytes);
+    memcpy (values, &num_bytes, sizeof (num_bytes));
+    freturn = t8_forest_vtk_printf (out, "        <DataArray type=\"%s\" "
+                                    "Name=\"%s\" %s format=\"appended\" "
+                                    "offset=\"", datatype, dataname,
+                                    component_string);
+    if (freturn <= 0) {
+      return 0;
+    }
+    if (out->xml != NULL) {
+      /* The offset is shifted later by the data of the other processes.
+       * We remember where it is and give it a fixed width. */
+      *(size_t *) sc_array_push (out->offset_positions) =
+        out->xml->elem_count;
+      freturn = t8_forest_vtk_printf (out, "%020llu\"/>\n",
+                                      (unsigned long long) out->array_start);
+    }
+    else {
+      freturn = t8_forest_vtk_printf (out, "%llu\"/>\n",
+                                      (unsigned long long) out->array_start);
+    }
+    return freturn > 0;
+  }
+  T8_ASSERT (out->xml == NULL);
+  freturn = t8_forest_vtk_printf (out, "        <DataArray type=\"%s\" "
+                                  "Name=\"%s\" %s format=\"binary\">\n"
+                                  "          ", datatype, dataname,
+                                  component_string);
+  if (freturn <= 0) {
+    return 0;
+  }
+#ifdef SC_HAVE_ZLIB
+  if (out->format == T8_VTK_FORMAT_COMPRESSED) {
+    freturn = sc_vtk_write_compressed (out->file, values, num_bytes);
+  }
+  else
+#endif
+  {
+    freturn = sc_vtk_write_binary (out->file, values, num_bytes);
+  }
+  /* The values are written, we can reuse the buffer */
+  sc_array_resize (&out->buffer, 0);
+  if (freturn) {
+    return 0;
+  }
+  freturn = t8_forest_vtk_printf (out, "\n        </DataArray>\n");
+  return freturn > 0;
+}
+
+/* Write the point of each corner of a cell, for the connectivity of
+ * distinct points. */
+static int
+t8_forest_vtk_cells_point_connectivity_kernel (t8_forest_t forest,
+                                               t8_locidx_t ltree_id,
+                                               t8_tree_t tree,
+                                               t8_locidx_t element_index,
+                                               t8_element_t * element,
+                                               t8_eclass_scheme_c * ts,
+                                               int is_ghost,
+                                               t8_forest_vtk_output_t * out,
+                                               int *columns, void **data,
+                                               T8_VTK_KERNEL_MODUS modus)
+{
+  t8_forest_vtk_point_values_t *state;
+  int                 ivertex, num_vertices;
+
+  if (modus == T8_VTK_KERNEL_EXECUTE) {
+    state = (t8_forest_vtk_point_values_t *) * data;
+    num_vertices = t8_eclass_num_vertices[ts->eclass];
+    for (ivertex = 0; ivertex < num_vertices; ivertex++, state->corner++) {
+      T8_ASSERT (state->corner < state->points->num_corners);
+      if (!t8_forest_vtk_output_int (out,
+                                     state->points->corner_to_point
+                                     [state->corner])) {
+        return 0;
+      }
+    }
+    *columns += num_vertices;
+  }
+  return 1;
+}
+
+/* Write the values of the points that occur first at a corner of this
+ * cell. Thus each point is written once, in the order of its number. */
+static int
+t8_forest_vtk_cells_point_values_kernel (t8_forest_t forest,
+                                         t8_locidx_t ltree_id,
+                                         t8_tree_t tree,
+                                         t8_locidx_t element_index,
+                                         t8_element_t * element,
+                                         t8_eclass_scheme_c * ts,
+                                         int is_ghost,
+                                         t8_forest_vtk_output_t * out,
+                                         int *columns, void **data,
+                                         T8_VTK_KERNEL_MODUS modus)
+{
+  t8_forest_vtk_point_values_t *state;
+  t8_locidx_t         point;
+  int                 ivertex, icomp;
+
+  if (modus == T8_VTK_KERNEL_EXECUTE) {
+    state = (t8_forest_vtk_point_values_t *) * data;
+    for (ivertex = 0; ivertex < t8_eclass_num_vertices[ts->eclass];
+         ivertex++, state->corner++) {
+      T8_ASSERT (state->corner < state->points->num_corners);
+      point = state->points->corner_to_point[state->corner];
+      T8_ASSERT (point <= state->next_point);
+      if (point == state->next_point) {
+        for (icomp = 0; icomp < state->num_components; icomp++) {
+          if (!t8_forest_vtk_output_float (out,
+                                           state->values[state->num_components
+                                                         * point + icomp],
+                                           state->ascii_format)) {
+            return 0;
+          }
+        }
+        state->next_point++;
+        *columns += state->num_components;
+      }
+    }
+  }
+  return 1;
+}
+
+/* Iterate over all cells and write the values of one data array to the
+ * output stream, using the cell_data_kernel as callback.
+ * In ASCII mode, the line is broken after each \a max_columns values.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_write_cell_values (t8_forest_t forest,
+                                 t8_forest_vtk_output_t * out,
+                                 int max_columns,
+                                 t8_forest_vtk_cell_data_kernel kernel,
+                                 int write_ghosts, void *udata)
+{
+  int                 freturn = 1;
   int                 countcols;
   t8_tree_t           tree;
   t8_locidx_t         itree, ighost;
@@ -688,15 +1188,6 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
   t8_eclass_scheme_c *ts;
   void               *data = NULL;
 
-  /* Write the connectivity information.
-   * Thus for each tree we write the indices of its corner vertices. */
-  freturn = fprintf (vtufile, "        <DataArray type=\"%s\" "
-                     "Name=\"%s\" %s format=\"ascii\">\n         ",
-                     datatype, dataname, component_string);
-  if (freturn <= 0) {
-    return 0;
-  }
-
   /* if udata != NULL, use it as the data pointer, in this case, the kernel
    * should not modify it */
   if (udata != NULL) {
@@ -721,6 +1212,11 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
     elems_in_tree =
       (t8_locidx_t) t8_element_array_get_count (&tree->elements);
     for (element_index = 0; element_index < elems_in_tree; element_index++) {
+      if (out->selected != NULL
+          && !out->selected[tree->elements_offset + element_index]) {
+        /* This element is not written */
+        continue;
+      }
       /* Get a pointer to the element */
       element =
         t8_forest_get_element (forest, tree->elements_offset + element_index,
@@ -728,7 +1224,7 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
       T8_ASSERT (element != NULL);
       /* Execute the given callback on each element */
       if (!kernel
-          (forest, itree, tree, element_index, element, ts, 0, vtufile,
+          (forest, itree, tree, element_index, element, ts, 0, out,
            &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
         /* call the kernel in clean-up modus */
         kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
@@ -736,8 +1232,8 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
         return 0;
       }
       /* After max_columns we break the line */
-      if (!(countcols % max_columns)) {
-        freturn = fprintf (vtufile, "\n         ");
+      if (out->format == T8_VTK_FORMAT_ASCII && !(countcols % max_columns)) {
+        freturn = t8_forest_vtk_printf (out, "\n         ");
         if (freturn <= 0) {
           /* call the kernel in clean-up modus */
           kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
@@ -756,6 +1252,8 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
 
   if (write_ghosts) {
     t8_locidx_t         num_ghosts_in_tree;
+
+    T8_ASSERT (out->selected == NULL);
     /* Iterate over the ghost elements */
     /* TODO: replace with an element iterator */
     num_ghost_trees = t8_forest_ghost_num_trees (forest);
@@ -774,15 +1272,16 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
         /* Execute the given callback on each element */
         if (!kernel
             (forest, ighost + num_local_trees, NULL, element_index, element,
-             ts, 1, vtufile, &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
+             ts, 1, out, &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
           /* call the kernel in clean-up modus */
           kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
                   T8_VTK_KERNEL_CLEANUP);
           return 0;
         }
         /* After max_columns we break the line */
-        if (!(countcols % max_columns)) {
-          freturn = fprintf (vtufile, "\n         ");
+        if (out->format == T8_VTK_FORMAT_ASCII
+            && !(countcols % max_columns)) {
+          freturn = t8_forest_vtk_printf (out, "\n         ");
           if (freturn <= 0) {
             /* call the kernel in clean-up modus */
             kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
@@ -802,7 +1301,47 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
   /* call the kernel in clean-up modus */
   kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
           T8_VTK_KERNEL_CLEANUP);
-  freturn = fprintf (vtufile, "\n        </DataArray>\n");
+  return 1;
+}
+
+/* Write one data array with the values of all cells to the output stream,
+ * using the cell_data_kernel as callback */
+static int
+t8_forest_vtk_write_cell_data (t8_forest_t forest,
+                               t8_forest_vtk_output_t * out,
+                               const char *dataname,
+                               const char *datatype,
+                               const char *component_string,
+                               int max_columns,
+                               t8_forest_vtk_cell_data_kernel kernel,
+                               int write_ghosts, void *udata)
+{
+  int                 freturn = 1;
+
+  if (out->format == T8_VTK_FORMAT_ASCII) {
+    /* Write the header of the data array, the values follow inline */
+    freturn = t8_forest_vtk_printf (out, "        <DataArray type=\"%s\" "
+                                    "Name=\"%s\" %s format=\"ascii\">\n"
+                                    "         ", datatype, dataname,
+                                    component_string);
+    if (freturn <= 0) {
+      return 0;
+    }
+  }
+  else {
+    /* The header is written when the size of the data is known */
+    t8_forest_vtk_begin_binary_array (out, datatype);
+  }
+
+  if (!t8_forest_vtk_write_cell_values (forest, out, max_columns, kernel,
+                                        write_ghosts, udata)) {
+    return 0;
+  }
+  if (out->format != T8_VTK_FORMAT_ASCII) {
+    return t8_forest_vtk_end_binary_array (out, dataname, datatype,
+                                           component_string);
+  }
+  freturn = t8_forest_vtk_printf (out, "\n        </DataArray>\n");
   if (freturn <= 0) {
     return 0;
   }
@@ -810,59 +1349,368 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
   return 1;
 }
 
-/* Write the cell data to an open file stream.
- * Returns true on success and zero otherwise.
- * After completion the file will remain open, whether writing
- * cells was successful or not. */
-static int
-t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
-                           int write_treeid,
-                           int write_mpirank,
-                           int write_level, int write_element_id,
-                           int write_ghosts, int num_data,
-                           t8_vtk_data_field_t * data)
+/* The key of a point in the hash table of distinct points.
+ * We hash the points by the cell of a uniform grid with width
+ * 4 * tolerance that contains them. */
+typedef struct
 {
-  int                 freturn;
-  int                 idata;
+  double              x[3];     /* The coordinates of the point. */
+  long long           cell[3];  /* The grid cell of the point. */
+  t8_locidx_t         point;    /* The number of the point. */
+} t8_forest_vtk_point_key_t;
 
-  T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (vtufile != NULL);
+static unsigned
+t8_forest_vtk_point_key_hash (const void *v, const void *u)
+{
+  const t8_forest_vtk_point_key_t *key = (const t8_forest_vtk_point_key_t *) v;
 
-  freturn = fprintf (vtufile, "      <Cells>\n");
-  if (freturn <= 0) {
-    goto t8_forest_vtk_cell_failure;
-  }
+  return (unsigned) (key->cell[0] * 73856093LL ^ key->cell[1] * 19349663LL
+                     ^ key->cell[2] * 83492791LL);
+}
 
-  /* Write the connectivity information.
-   * Thus for each tree we write the indices of its corner vertices. */
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "connectivity",
-                                           T8_VTK_LOCIDX, "", 8,
-                                           t8_forest_vtk_cells_connectivity_kernel,
-                                           write_ghosts, NULL);
-  if (!freturn) {
-    goto t8_forest_vtk_cell_failure;
+/* Two keys are equal if they have the same grid cell and their points
+ * differ by at most the tolerance \a u in each coordinate. */
+static int
+t8_forest_vtk_point_key_equal (const void *v1, const void *v2, const void *u)
+{
+  const t8_forest_vtk_point_key_t *key1 =
+    (const t8_forest_vtk_point_key_t *) v1;
+  const t8_forest_vtk_point_key_t *key2 =
+    (const t8_forest_vtk_point_key_t *) v2;
+  const double        tolerance = *(const double *) u;
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    if (key1->cell[i] != key2->cell[i]
+        || fabs (key1->x[i] - key2->x[i]) > tolerance) {
+      return 0;
+    }
   }
-  /* Done with writing the connectivity */
+  return 1;
+}
 
-  /* Write the offsets, that is for each tree the index of the first entry
-   * in the connectivity output that
-   * does not refer to a vertex of the tree anymore.
-   * For example if the trees are a square and a triangle, the offsets would
-   * be 4 and 7, since indices 0,1,2,3 refer to the vertices of the square
-   * and indices 4,5,6 to the indices of the triangle. */
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "offsets",
-                                           T8_VTK_LOCIDX, "", 8,
-                                           t8_forest_vtk_cells_offset_kernel,
-                                           write_ghosts, NULL);
-  if (!freturn) {
-    goto t8_forest_vtk_cell_failure;
+/* Number the distinct points among the corner coordinates of all cells.
+ * Two corners are the same point if their coordinates differ by at most
+ * 1e-10 times the diameter of all corners in each coordinate.
+ * This also identifies corners of different trees, regardless of how the
+ * trees are connected. */
+static void
+t8_forest_vtk_number_points (t8_forest_vtk_points_t * points,
+                             const double *corner_coords)
+{
+  t8_forest_vtk_point_key_t *keys, query, *found;
+  sc_hash_t          *hash;
+  double              box_min[3], box_max[3], diameter, tolerance, width;
+  double              relative;
+  t8_locidx_t         icorner;
+  int                 i, icell, num_cells, num_near, which;
+  int                 near[3];
+
+  /* Compute the bounding box of all corners */
+  for (i = 0; i < 3; i++) {
+    box_min[i] = 1e300;
+    box_max[i] = -1e300;
   }
-  /* Done with writing the offsets */
+  for (icorner = 0; icorner < points->num_corners; icorner++) {
+    for (i = 0; i < 3; i++) {
+      box_min[i] = SC_MIN (box_min[i], corner_coords[3 * icorner + i]);
+      box_max[i] = SC_MAX (box_max[i], corner_coords[3 * icorner + i]);
+    }
+  }
+  diameter = 0;
+  for (i = 0; i < 3; i++) {
+    diameter = SC_MAX (diameter, box_max[i] - box_min[i]);
+  }
+  tolerance = diameter > 0 ? 1e-10 * diameter : 1;
+  width = 4 * tolerance;
+
+  keys = T8_ALLOC (t8_forest_vtk_point_key_t, points->num_corners + 1);
+  points->coords = T8_ALLOC (double, 3 * points->num_corners + 1);
+  hash = sc_hash_new (t8_forest_vtk_point_key_hash,
+                      t8_forest_vtk_point_key_equal, &tolerance, NULL);
+  points->num_points = 0;
+  for (icorner = 0; icorner < points->num_corners; icorner++) {
+    /* Compute the grid cell of the corner and whether it is closer than
+     * the tolerance to a neighbor cell */
+    num_near = 0;
+    for (i = 0; i < 3; i++) {
+      query.x[i] = corner_coords[3 * icorner + i];
+      relative = (query.x[i] - box_min[i]) / width;
+      query.cell[i] = (long long) floor (relative);
+      near[i] = 0;
+      if (relative - query.cell[i] < 0.25) {
+        near[i] = -1;
+      }
+      else if (relative - query.cell[i] > 0.75) {
+        near[i] = 1;
+      }
+      num_near += near[i] != 0;
+    }
+    /* Look for the point in the cell and in the near neighbor cells */
+    found = NULL;
+    num_cells = 1 << num_near;
+    for (icell = 0; icell < num_cells && found == NULL; icell++) {
+      t8_forest_vtk_point_key_t candidate = query;
+      void              **pfound;
+
+      for (i = 0, which = 0; i < 3; i++) {
+        if (near[i] != 0) {
+          if (icell & (1 << which)) {
+            candidate.cell[i] += near[i];
+          }
+          which++;
+        }
+      }
+      if (sc_hash_lookup (hash, &candidate, &pfound)) {
+        found = (t8_forest_vtk_point_key_t *) * pfound;
+      }
+    }
+    if (found == NULL) {
+      /* This is a new point */
+      found = keys + points->num_points;
+      *found = query;
+      found->point = points->num_points;
+      memcpy (points->coords + 3 * points->num_points, query.x,
+              3 * sizeof (double));
+      sc_hash_insert_unique (hash, found, NULL);
+      points->num_points++;
+    }
+    points->corner_to_point[icorner] = found->point;
+  }
+  sc_hash_destroy (hash);
+  T8_FREE (keys);
+}
+
+/* Compute the distinct points of the cells of a process.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_build_points (t8_forest_t forest, int write_ghosts,
+                            const char *selected,
+                            t8_forest_vtk_points_t * points)
+{
+  t8_forest_vtk_output_t collect;
+  t8_locidx_t         num_cells, icell, icorner, first_corner, *cell_id;
+  int64_t            *values;
+  t8_gloidx_t         first_element;
+  int                 success;
+
+  points->num_corners =
+    t8_forest_num_points (forest, write_ghosts, selected);
+  points->corner_to_point = T8_ALLOC (t8_locidx_t, points->num_corners + 1);
+  points->corner_element = T8_ALLOC (t8_locidx_t, points->num_corners + 1);
+  points->coords = NULL;
+  num_cells = t8_forest_vtk_num_cells (forest, write_ghosts, selected);
+
+  /* We let the kernels write into a buffer to collect the corner
+   * coordinates, the cell offsets and the cell ids */
+  collect.file = NULL;
+  collect.format = T8_VTK_FORMAT_BINARY;
+  collect.array_start = 0;
+  collect.xml = NULL;
+  collect.offset_positions = NULL;
+  collect.points = NULL;
+  collect.selected = selected;
+  t8_forest_vtk_output_set_precision (&collect, forest);
+  sc_array_init (&collect.buffer, 1);
+
+  /* For each corner the local index of its cell */
+  collect.value_type = T8_VTK_VALUE_INT64;
+  success = t8_forest_vtk_write_cell_values (forest, &collect, 1,
+                                             t8_forest_vtk_cells_offset_kernel,
+                                             write_ghosts, NULL);
+  success = success
+    && t8_forest_vtk_write_cell_values (forest, &collect, 1,
+                                        t8_forest_vtk_cells_elementid_kernel,
+                                        write_ghosts, NULL);
+  if (success) {
+    T8_ASSERT (collect.buffer.elem_count ==
+               2 * sizeof (int64_t) * (size_t) num_cells);
+    values = (int64_t *) collect.buffer.array;
+    cell_id = points->corner_element;
+    first_element = t8_forest_get_first_local_element_id (forest);
+    first_corner = 0;
+    for (icell = 0; icell < num_cells; icell++) {
+      for (icorner = first_corner; icorner < values[icell]; icorner++) {
+        /* Ghosts have the element id -1 */
+        cell_id[icorner] = values[num_cells + icell] < 0 ? -1 :
+          (t8_locidx_t) (values[num_cells + icell] - first_element);
+      }
+      first_corner = values[icell];
+    }
+    T8_ASSERT (first_corner == points->num_corners);
+  }
+
+  /* The corner coordinates */
+  sc_array_resize (&collect.buffer, 0);
+  collect.value_type = T8_VTK_VALUE_FLOAT64;
+  success = success
+    && t8_forest_vtk_write_cell_values (forest, &collect, 1,
+                                        t8_forest_vtk_cells_vertices_kernel,
+                                        write_ghosts, NULL);
+  if (success) {
+    T8_ASSERT (collect.buffer.elem_count ==
+               3 * sizeof (double) * (size_t) points->num_corners);
+    t8_forest_vtk_number_points (points, (double *) collect.buffer.array);
+  }
+  sc_array_reset (&collect.buffer);
+  return success;
+}
+
+static void
+t8_forest_vtk_destroy_points (t8_forest_vtk_points_t * points)
+{
+  T8_FREE (points->corner_to_point);
+  T8_FREE (points->corner_element);
+  if (points->coords != NULL) {
+    T8_FREE (points->coords);
+  }
+}
+
+/* Write one data array with one value per distinct point.
+ * \a values has num_components entries per point. */
+static int
+t8_forest_vtk_write_point_values (t8_forest_t forest,
+                                  t8_forest_vtk_output_t * out,
+                                  const char *dataname,
+                                  const char *datatype,
+                                  const char *component_string,
+                                  const double *values, int num_components,
+                                  const char *ascii_format, int write_ghosts)
+{
+  t8_forest_vtk_point_values_t state;
+
+  T8_ASSERT (out->points != NULL);
+  state.points = out->points;
+  state.values = values;
+  state.num_components = num_components;
+  state.ascii_format = ascii_format;
+  state.corner = 0;
+  state.next_point = 0;
+  if (!t8_forest_vtk_write_cell_data (forest, out, dataname, datatype,
+                                      component_string, 3 * num_components,
+                                      t8_forest_vtk_cells_point_values_kernel,
+                                      write_ghosts, &state)) {
+    return 0;
+  }
+  T8_ASSERT (state.next_point == out->points->num_points);
+  return 1;
+}
+
+/* Write a user defined data field per element as point data of the
+ * distinct points. The value of a point is the average of the values of
+ * the local cells that it is a corner of. */
+static int
+t8_forest_vtk_write_point_average (t8_forest_t forest,
+                                   t8_forest_vtk_output_t * out,
+                                   const char *dataname,
+                                   const char *component_string,
+                                   const double *data, int num_components,
+                                   int write_ghosts)
+{
+  const t8_forest_vtk_points_t *points = out->points;
+  double             *values;
+  int                *counts;
+  t8_locidx_t         icorner, point, element;
+  int                 icomp, success;
+
+  values = T8_ALLOC_ZERO (double, num_components * points->num_points + 1);
+  counts = T8_ALLOC_ZERO (int, points->num_points + 1);
+  for (icorner = 0; icorner < points->num_corners; icorner++) {
+    element = points->corner_element[icorner];
+    if (element >= 0) {
+      point = points->corner_to_point[icorner];
+      for (icomp = 0; icomp < num_components; icomp++) {
+        values[num_components * point + icomp] +=
+          data[num_components * element + icomp];
+      }
+      counts[point]++;
+    }
+  }
+  for (point = 0; point < points->num_points; point++) {
+    for (icomp = 0; icomp < num_components && counts[point] > 0; icomp++) {
+      values[num_components * point + icomp] /= counts[point];
+    }
+  }
+  success = t8_forest_vtk_write_point_values (forest, out, dataname,
+                                              out->float_name,
+                                              component_string, values,
+                                              num_components, " %g",
+                                              write_ghosts);
+  T8_FREE (values);
+  T8_FREE (counts);
+  return success;
+}
+
+/* Write the cell data to an open file stream.
+ * Returns true on success and zero otherwise.
+ * After completion the file will remain open, whether writing
+ * cells was successful or not. */
+static int
+t8_forest_vtk_write_cells (t8_forest_t forest, t8_forest_vtk_output_t * out,
+                           int write_treeid,
+                           int write_mpirank,
+                           int write_level, int write_element_id,
+                           int write_ghosts, int num_data,
+                           t8_vtk_data_field_t * data)
+{
+  int                 freturn;
+  int                 idata;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (out != NULL && (out->file != NULL || out->xml != NULL));
+
+  freturn = t8_forest_vtk_printf (out, "      <Cells>\n");
+  if (freturn <= 0) {
+    goto t8_forest_vtk_cell_failure;
+  }
+
+  /* Write the connectivity information.
+   * Thus for each tree we write the indices of its corner vertices. */
+  if (out->points != NULL) {
+    /* Each distinct point is written only once */
+    t8_forest_vtk_point_values_t state;
+
+    state.points = out->points;
+    state.values = NULL;
+    state.num_components = 0;
+    state.ascii_format = NULL;
+    state.corner = 0;
+    state.next_point = 0;
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "connectivity",
+                                             T8_VTK_LOCIDX, "", 8,
+                                             t8_forest_vtk_cells_point_connectivity_kernel,
+                                             write_ghosts, &state);
+  }
+  else {
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "connectivity",
+                                             T8_VTK_LOCIDX, "", 8,
+                                             t8_forest_vtk_cells_connectivity_kernel,
+                                             write_ghosts, NULL);
+  }
+  if (!freturn) {
+    goto t8_forest_vtk_cell_failure;
+  }
+  /* Done with writing the connectivity */
+
+  /* Write the offsets, that is for each tree the index of the first entry
+   * in the connectivity output that
+   * does not refer to a vertex of the tree anymore.
+   * For example if the trees are a square and a triangle, the offsets would
+   * be 4 and 7, since indices 0,1,2,3 refer to the vertices of the square
+   * and indices 4,5,6 to the indices of the triangle. */
+  freturn = t8_forest_vtk_write_cell_data (forest, out, "offsets",
+                                           T8_VTK_LOCIDX, "", 8,
+                                           t8_forest_vtk_cells_offset_kernel,
+                                           write_ghosts, NULL);
+  if (!freturn) {
+    goto t8_forest_vtk_cell_failure;
+  }
+  /* Done with writing the offsets */
 
   /* Write the element types. The type specifies the element class, thus
    * square/triangle/tet etc. */
 
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "types",
+  freturn = t8_forest_vtk_write_cell_data (forest, out, "types",
                                            "Int32", "", 8,
                                            t8_forest_vtk_cells_type_kernel,
                                            write_ghosts, NULL);
@@ -871,13 +1719,15 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     goto t8_forest_vtk_cell_failure;
   }
   /* Done with writing the types */
-  freturn = fprintf (vtufile, "      </Cells>\n");
+  freturn = t8_forest_vtk_printf (out, "      </Cells>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
 
-  freturn = fprintf (vtufile, "      <CellData Scalars =\"%s%s\">\n",
-                     "treeid,mpirank,level", (write_element_id ? "id" : ""));
+  freturn =
+    t8_forest_vtk_printf (out, "      <CellData Scalars =\"%s%s\">\n",
+                          "treeid,mpirank,level",
+                          (write_element_id ? "id" : ""));
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -885,7 +1735,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   if (write_treeid) {
     /* Write the tree ids. */
 
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "treeid",
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "treeid",
                                              T8_VTK_GLOIDX, "", 8,
                                              t8_forest_vtk_cells_treeid_kernel,
                                              write_ghosts, NULL);
@@ -897,7 +1747,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   if (write_mpirank) {
     /* Write the mpiranks. */
 
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "mpirank",
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "mpirank",
                                              "Int32", "", 8,
                                              t8_forest_vtk_cells_rank_kernel,
                                              write_ghosts, NULL);
@@ -909,7 +1759,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   if (write_level) {
     /* Write the element refinement levels. */
 
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "level",
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "level",
                                              "Int32", "", 8,
                                              t8_forest_vtk_cells_level_kernel,
                                              write_ghosts, NULL);
@@ -926,7 +1776,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     /* Use 32 bit ints if the global element count fits, 64 bit otherwise. */
     datatype = forest->global_num_elements > T8_LOCIDX_MAX ? T8_VTK_GLOIDX :
       T8_VTK_LOCIDX;
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "element_id",
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "element_id",
                                              datatype, "", 8,
                                              t8_forest_vtk_cells_elementid_kernel,
                                              write_ghosts, NULL);
@@ -940,9 +1790,9 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   for (idata = 0; idata < num_data; idata++) {
     if (data[idata].type == T8_VTK_SCALAR) {
       freturn =
-        t8_forest_vtk_write_cell_data (forest, vtufile,
+        t8_forest_vtk_write_cell_data (forest, out,
                                        data[idata].description,
-                                       T8_VTK_FLOAT_NAME, "", 8,
+                                       out->float_name, "", 8,
                                        t8_forest_vtk_cells_scalar_kernel,
                                        write_ghosts, data[idata].data);
     }
@@ -951,9 +1801,9 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
       T8_ASSERT (data[idata].type == T8_VTK_VECTOR);
       snprintf (component_string, BUFSIZ, "NumberOfComponents=\"3\"");
       freturn =
-        t8_forest_vtk_write_cell_data (forest, vtufile,
+        t8_forest_vtk_write_cell_data (forest, out,
                                        data[idata].description,
-                                       T8_VTK_FLOAT_NAME,
+                                       out->float_name,
                                        component_string,
                                        8 * forest->dimension,
                                        t8_forest_vtk_cells_vector_kernel,
@@ -964,7 +1814,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     }
   }
 
-  freturn = fprintf (vtufile, "      </CellData>\n");
+  freturn = t8_forest_vtk_printf (out, "      </CellData>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -982,7 +1832,7 @@ t8_forest_vtk_cell_failure:
  * After completion the file will remain open, whether writing
  * cells was successful or not. */
 static int
-t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
+t8_forest_vtk_write_points (t8_forest_t forest, t8_forest_vtk_output_t * out,
                             int write_ghosts,
                             int num_data, t8_vtk_data_field_t * data)
 {
@@ -991,24 +1841,34 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
   char                description[BUFSIZ];
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (vtufile != NULL);
+  T8_ASSERT (out != NULL && (out->file != NULL || out->xml != NULL));
 
   /* Write the vertex coordinates */
 
-  freturn = fprintf (vtufile, "      <Points>\n");
+  freturn = t8_forest_vtk_printf (out, "      <Points>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "Position",
-                                           T8_VTK_FLOAT_NAME,
-                                           "NumberOfComponents=\"3\"",
-                                           8,
-                                           t8_forest_vtk_cells_vertices_kernel,
-                                           write_ghosts, NULL);
+  if (out->points != NULL) {
+    freturn = t8_forest_vtk_write_point_values (forest, out, "Position",
+                                                out->float_name,
+                                                "NumberOfComponents=\"3\"",
+                                                out->points->coords, 3,
+                                                out->float_format,
+                                                write_ghosts);
+  }
+  else {
+    freturn = t8_forest_vtk_write_cell_data (forest, out, "Position",
+                                             out->float_name,
+                                             "NumberOfComponents=\"3\"",
+                                             3,
+                                             t8_forest_vtk_cells_vertices_kernel,
+                                             write_ghosts, NULL);
+  }
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
   }
-  freturn = fprintf (vtufile, "      </Points>\n");
+  freturn = t8_forest_vtk_printf (out, "      </Points>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -1016,14 +1876,28 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
 
   /* Write the user defined data fields per element */
   if (num_data > 0) {
-    freturn = fprintf (vtufile, "      <PointData>\n");
+    freturn = t8_forest_vtk_printf (out, "      <PointData>\n");
     for (idata = 0; idata < num_data; idata++) {
-      if (data[idata].type == T8_VTK_SCALAR) {
+      if (out->points != NULL) {
+        /* Average the element values at each distinct point */
         snprintf (description, BUFSIZ, "%s_%s", data[idata].description,
                   "points");
         freturn =
-          t8_forest_vtk_write_cell_data (forest, vtufile, description,
-                                         T8_VTK_FLOAT_NAME, "", 8,
+          t8_forest_vtk_write_point_average (forest, out, description,
+                                             data[idata].type ==
+                                             T8_VTK_SCALAR ? "" :
+                                             "NumberOfComponents=\"3\"",
+                                             data[idata].data,
+                                             data[idata].type ==
+                                             T8_VTK_SCALAR ? 1 : 3,
+                                             write_ghosts);
+      }
+      else if (data[idata].type == T8_VTK_SCALAR) {
+        snprintf (description, BUFSIZ, "%s_%s", data[idata].description,
+                  "points");
+        freturn =
+          t8_forest_vtk_write_cell_data (forest, out, description,
+                                         out->float_name, "", 8,
                                          t8_forest_vtk_vertices_scalar_kernel,
                                          write_ghosts, data[idata].data);
       }
@@ -1034,8 +1908,8 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
         snprintf (description, BUFSIZ, "%s_%s", data[idata].description,
                   "points");
         freturn =
-          t8_forest_vtk_write_cell_data (forest, vtufile, description,
-                                         T8_VTK_FLOAT_NAME, component_string,
+          t8_forest_vtk_write_cell_data (forest, out, description,
+                                         out->float_name, component_string,
                                          8 * forest->dimension,
                                          t8_forest_vtk_vertices_vector_kernel,
                                          write_ghosts, data[idata].data);
@@ -1044,7 +1918,7 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
         goto t8_forest_vtk_cell_failure;
       }
     }
-    freturn = fprintf (vtufile, "      </PointData>\n");
+    freturn = t8_forest_vtk_printf (out, "      </PointData>\n");
   }
   /* Function completed successfully */
   return 1;
@@ -1054,6 +1928,58 @@ t8_forest_vtk_cell_failure:
   return 0;
 }
 
+/* Write the piece of this process, that is its points and cells,
+ * to an output stream.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_write_piece (t8_forest_t forest, t8_forest_vtk_output_t * out,
+                           int write_treeid, int write_mpirank,
+                           int write_level, int write_element_id,
+                           int write_ghosts, int num_data,
+                           t8_vtk_data_field_t * data, int unique_points)
+{
+  t8_forest_vtk_points_t points;
+  t8_locidx_t         num_elements, num_points;
+  int                 freturn;
+
+  /* The local number of elements */
+  num_elements = t8_forest_vtk_num_cells (forest, write_ghosts,
+                                          out->selected);
+  if (unique_points) {
+    /* Number the distinct points */
+    if (!t8_forest_vtk_build_points (forest, write_ghosts, out->selected,
+                                     &points)) {
+      t8_forest_vtk_destroy_points (&points);
+      return 0;
+    }
+    out->points = &points;
+    num_points = points.num_points;
+  }
+  else {
+    /* The local number of points, counted with multiplicity */
+    out->points = NULL;
+    num_points = t8_forest_num_points (forest, write_ghosts, out->selected);
+  }
+
+  freturn = t8_forest_vtk_printf (out, "    <Piece NumberOfPoints=\"%lld\" "
+                                  "NumberOfCells=\"%lld\">\n",
+                                  (long long) num_points,
+                                  (long long) num_elements);
+  freturn = freturn > 0
+    /* write the point data */
+    && t8_forest_vtk_write_points (forest, out, write_ghosts, num_data, data)
+    /* write the cell data */
+    && t8_forest_vtk_write_cells (forest, out, write_treeid, write_mpirank,
+                                  write_level, write_element_id,
+                                  write_ghosts, num_data, data)
+    && t8_forest_vtk_printf (out, "    </Piece>\n") > 0;
+  if (unique_points) {
+    t8_forest_vtk_destroy_points (&points);
+    out->points = NULL;
+  }
+  return freturn;
+}
+
 int
 t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
                           int write_treeid,
@@ -1062,41 +1988,71 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
                           int write_ghosts,
                           int num_data, t8_vtk_data_field_t * data)
 {
-  FILE               *vtufile = NULL;
-  t8_locidx_t         num_elements, num_points;
+  return t8_forest_vtk_write_file_format (forest, fileprefix, write_treeid,
+                                          write_mpirank, write_level,
+                                          write_element_id, write_ghosts,
+                                          num_data, data,
+                                          T8_VTK_FORMAT_ASCII, 0);
+}
+
+/* Write the forest in .pvtu file format. If selected is not NULL, only the
+ * local elements with a nonzero entry in selected are written.
+ * \see t8_forest_vtk_write_file_format */
+static int
+t8_forest_vtk_write_file_selected (t8_forest_t forest,
+                                   const char *fileprefix, int write_treeid,
+                                   int write_mpirank, int write_level,
+                                   int write_element_id, int write_ghosts,
+                                   int num_data, t8_vtk_data_field_t * data,
+                                   t8_vtk_format_t format, int unique_points,
+                                   const char *selected)
+{
+  t8_forest_vtk_output_t out;
   char                vtufilename[BUFSIZ];
   int                 freturn;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (T8_VTK_FORMAT_ASCII <= format
+             && format <= T8_VTK_FORMAT_APPENDED);
   if (forest->ghosts == NULL || forest->ghosts->num_ghosts_elements == 0) {
     /* Never write ghost elements if there aren't any */
     write_ghosts = 0;
   }
   T8_ASSERT (forest->ghosts != NULL || !write_ghosts);
-
-  /* Currently we only support output in ascii format, not binary */
-  T8_ASSERT (T8_VTK_ASCII == 1);
+  T8_ASSERT (selected == NULL || !write_ghosts);
+#ifndef SC_HAVE_ZLIB
+  if (format == T8_VTK_FORMAT_COMPRESSED) {
+    t8_global_productionf ("zlib is not available, writing uncompressed "
+                           "binary vtk files.\n");
+    format = T8_VTK_FORMAT_BINARY;
+  }
+#endif
+  t8_profile_region_begin ("forest_vtk");
+  out.file = NULL;
+  out.format = format;
+  out.value_type = T8_VTK_VALUE_INT32;
+  out.array_start = 0;
+  out.xml = NULL;
+  out.offset_positions = NULL;
+  out.points = NULL;
+  out.selected = selected;
+  t8_forest_vtk_output_set_precision (&out, forest);
+  /* The buffer stores raw bytes */
+  sc_array_init (&out.buffer, 1);
 
   /* process 0 creates the .pvtu file */
   if (forest->mpirank == 0) {
-    if (t8_write_pvtu
+    if (t8_write_pvtu_float_type
         (fileprefix, forest->mpisize, write_treeid, write_mpirank,
-         write_level, write_element_id, num_data, data)) {
+         write_level, write_element_id, num_data, data,
+         forest->geometry_float ? "Float32" : T8_VTK_FLOAT_NAME)) {
       t8_errorf ("Error when writing file %s.pvtu\n", fileprefix);
       goto t8_forest_vtk_failure;
     }
   }
 
-  /* The local number of elements */
-  num_elements = t8_forest_get_num_element (forest);
-  if (write_ghosts) {
-    num_elements += t8_forest_get_num_ghosts (forest);
-  }
-  /* The local number of points, counted with multiplicity */
-  num_points = t8_forest_num_points (forest, write_ghosts);
-
   /* The filename for this processes file */
   freturn =
     snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix,
@@ -1107,79 +2063,856 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
   }
 
   /* Open the vtufile to write to */
-  vtufile = fopen (vtufilename, "w");
-  if (vtufile == NULL) {
+  out.file = fopen (vtufilename, "wb");
+  if (out.file == NULL) {
     t8_errorf ("Error when opening file %s\n", vtufilename);
     goto t8_forest_vtk_failure;
   }
   /* Write the header information in the .vtu file.
    * xml type, Unstructured grid and number of points and elements. */
-  freturn = fprintf (vtufile, "<?xml version=\"1.0\"?>\n");
+  freturn = fprintf (out.file, "<?xml version=\"1.0\"?>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
-  freturn =
-    fprintf (vtufile, "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
+  if (format == T8_VTK_FORMAT_APPENDED) {
+    /* We prefix the appended arrays with 64 bit sizes, such that arrays
+     * larger than 4GB are possible */
+    freturn = fprintf (out.file, "<VTKFile type=\"UnstructuredGrid\" "
+                       "version=\"1.0\" header_type=\"UInt64\"");
+  }
+  else {
+    freturn = fprintf (out.file,
+                       "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
+  }
   if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
+  if (format == T8_VTK_FORMAT_COMPRESSED) {
+    freturn = fprintf (out.file, " compressor=\"vtkZLibDataCompressor\"");
+    if (freturn <= 0) {
+      goto t8_forest_vtk_failure;
+    }
+  }
 #ifdef SC_IS_BIGENDIAN
-  freturn = fprintf (vtufile, " byte_order=\"BigEndian\">\n");
+  freturn = fprintf (out.file, " byte_order=\"BigEndian\">\n");
 #else
-  freturn = fprintf (vtufile, " byte_order=\"LittleEndian\">\n");
+  freturn = fprintf (out.file, " byte_order=\"LittleEndian\">\n");
 #endif
   if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
-  freturn = fprintf (vtufile, "  <UnstructuredGrid>\n");
+  freturn = fprintf (out.file, "  <UnstructuredGrid>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
-  freturn = fprintf (vtufile,
-                     "    <Piece NumberOfPoints=\"%lld\" NumberOfCells=\"%lld\">\n",
-                     (long long) num_points, (long long) num_elements);
-  if (freturn <= 0) {
+  if (!t8_forest_vtk_write_piece (forest, &out, write_treeid, write_mpirank,
+                                  write_level, write_element_id,
+                                  write_ghosts, num_data, data,
+                                  unique_points)) {
     goto t8_forest_vtk_failure;
   }
 
-  /* write the point data */
-  if (!t8_forest_vtk_write_points
-      (forest, vtufile, write_ghosts, num_data, data)) {
-    /* writings points was not succesful */
+  freturn = fprintf (out.file, "  </UnstructuredGrid>\n");
+  if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
-  /* write the cell data */
-  if (!t8_forest_vtk_write_cells
-      (forest, vtufile, write_treeid, write_mpirank, write_level,
-       write_element_id, write_ghosts, num_data, data)) {
-    /* Writing cells was not successful */
-    goto t8_forest_vtk_failure;
+  if (format == T8_VTK_FORMAT_APPENDED) {
+    /* Write all data arrays in one block. The offsets of the arrays
+     * count from the byte after the underscore. */
+    freturn = fprintf (out.file, "  <AppendedData encoding=\"raw\">\n   _");
+    if (freturn <= 0) {
+      goto t8_forest_vtk_failure;
+    }
+    if (fwrite (out.buffer.array, 1, out.buffer.elem_count, out.file) !=
+        out.buffer.elem_count) {
+      goto t8_forest_vtk_failure;
+    }
+    freturn = fprintf (out.file, "\n  </AppendedData>\n");
+    if (freturn <= 0) {
+      goto t8_forest_vtk_failure;
+    }
   }
-
-  freturn = fprintf (vtufile, "    </Piece>\n"
-                     "  </UnstructuredGrid>\n" "</VTKFile>\n");
+  freturn = fprintf (out.file, "</VTKFile>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_failure;
   }
 
-  freturn = fclose (vtufile);
+  freturn = fclose (out.file);
   /* We set it not NULL, even if fclose was not successful, since then any
    * following call to fclose would result in undefined behaviour. */
-  vtufile = NULL;
+  out.file = NULL;
   if (freturn != 0) {
     /* Closing failed, this usually means that the final write operation could
      * not be completed. */
     t8_global_errorf ("Error when closing file %s\n", vtufilename);
     goto t8_forest_vtk_failure;
   }
+  sc_array_reset (&out.buffer);
+  t8_profile_region_end ("forest_vtk");
   /* Writing was successful */
   return 1;
 t8_forest_vtk_failure:
-  if (vtufile != NULL) {
-    fclose (vtufile);
+  if (out.file != NULL) {
+    fclose (out.file);
   }
+  sc_array_reset (&out.buffer);
+  t8_profile_region_end ("forest_vtk");
   t8_errorf ("Error when writing vtk file.\n");
   return 0;
 }
 
+int
+t8_forest_vtk_write_file_format (t8_forest_t forest, const char *fileprefix,
+                                 int write_treeid,
+                                 int write_mpirank,
+                                 int write_level, int write_element_id,
+                                 int write_ghosts,
+                                 int num_data, t8_vtk_data_field_t * data,
+                                 t8_vtk_format_t format, int unique_points)
+{
+  return t8_forest_vtk_write_file_selected (forest, fileprefix, write_treeid,
+                                            write_mpirank, write_level,
+                                            write_element_id, write_ghosts,
+                                            num_data, data, format,
+                                            unique_points, NULL);
+}
+
+/* The state of the search that selects the elements of a filtered output */
+typedef struct
+{
+  const t8_forest_vtk_filter_t *filter;
+  char               *selected;
+} t8_forest_vtk_select_t;
+
+/* The search callback that marks the leaves that pass a filter.
+ * Elements above the maximum level or outside of the box of the filter
+ * are pruned together with their descendants. */
+static int
+t8_forest_vtk_select_query (t8_forest_t forest, t8_locidx_t ltreeid,
+                            const t8_element_t * element,
+                            t8_element_array_t * leaf_elements,
+                            void *user_data, t8_locidx_t tree_leaf_index)
+{
+  t8_forest_vtk_select_t *select = (t8_forest_vtk_select_t *) user_data;
+  const t8_forest_vtk_filter_t *filter = select->filter;
+  t8_eclass_scheme_c *ts;
+  double              box[6];
+  int                 level, i;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  level = ts->t8_element_level (element);
+  if (filter->max_level >= 0 && level > filter->max_level) {
+    /* The descendants of this element have even larger levels */
+    return 0;
+  }
+  if (filter->use_box) {
+    t8_forest_element_bounding_box (forest, ltreeid, element,
+                                    t8_forest_get_tree_vertices (forest,
+                                                                 ltreeid),
+                                    box);
+    for (i = 0; i < 3; i++) {
+      if (box[i] > filter->box[3 + i] || box[3 + i] < filter->box[i]) {
+        return 0;
+      }
+    }
+  }
+  if (tree_leaf_index < 0) {
+    /* The element is no leaf, continue the search if the user does */
+    return filter->select_fn == NULL
+      || filter->select_fn (forest, ltreeid, element, leaf_elements,
+                            filter->user_data, tree_leaf_index);
+  }
+  if (level < filter->min_level || (filter->select_fn != NULL
+                                    && !filter->select_fn (forest, ltreeid,
+                                                           element,
+                                                           leaf_elements,
+                                                           filter->user_data,
+                                                           tree_leaf_index)))
+  {
+    return 0;
+  }
+  select->selected[t8_forest_get_tree_element_offset (forest, ltreeid)
+                   + tree_leaf_index] = 1;
+  return 1;
+}
+
+void
+t8_forest_vtk_filter_init (t8_forest_vtk_filter_t * filter)
+{
+  int                 i;
+
+  T8_ASSERT (filter != NULL);
+  filter->min_level = 0;
+  filter->max_level = -1;
+  filter->use_box = 0;
+  for (i = 0; i < 3; i++) {
+    filter->box[i] = 0;
+    filter->box[3 + i] = 0;
+  }
+  filter->select_fn = NULL;
+  filter->user_data = NULL;
+}
+
+int
+t8_forest_vtk_write_file_filtered (t8_forest_t forest,
+                                   const char *fileprefix, int write_treeid,
+                                   int write_mpirank, int write_level,
+                                   int write_element_id, int num_data,
+                                   t8_vtk_data_field_t * data,
+                                   t8_vtk_format_t format, int unique_points,
+                                   const t8_forest_vtk_filter_t * filter)
+{
+  t8_forest_vtk_select_t select;
+  int                 success;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (filter != NULL);
+
+  /* Mark the local elements that pass the filter */
+  select.filter = filter;
+  select.selected = T8_ALLOC_ZERO (char,
+                                   t8_forest_get_num_element (forest) + 1);
+  t8_forest_search (forest, t8_forest_vtk_select_query, &select);
+  success = t8_forest_vtk_write_file_selected (forest, fileprefix,
+                                               write_treeid, write_mpirank,
+                                               write_level, write_element_id,
+                                               0, num_data, data, format,
+                                               unique_points,
+                                               select.selected);
+  T8_FREE (select.selected);
+  return success;
+}
+
+/* Write the pieces of all processes of comm into the file vtufilename,
+ * one after the other, with appended data.
+ * \see t8_forest_vtk_write_single_file */
+static int
+t8_forest_vtk_write_merged (t8_forest_t forest, const char *vtufilename,
+                            sc_MPI_Comm comm, int write_treeid,
+                            int write_mpirank, int write_level,
+                            int write_element_id, int write_ghosts,
+                            int num_data, t8_vtk_data_field_t * data,
+                            int unique_points)
+{
+  t8_forest_vtk_output_t out;
+  sc_array_t          xml, offset_positions;
+  char                header[BUFSIZ], offset[21];
+  const char         *middle =
+    "  </UnstructuredGrid>\n  <AppendedData encoding=\"raw\">\n   _";
+  const char         *footer = "\n  </AppendedData>\n</VTKFile>\n";
+  char               *blocks[5];
+  size_t              sizes[5], ipos, idigit;
+  long long           offsets[5], local_sizes[2], *all_sizes;
+  long long           xml_offset, xml_total, data_offset, data_total;
+  long long           header_size, middle_size;
+  unsigned long long  value;
+  char               *digits;
+  int                 success = 1, num_blocks, iproc, mpiret;
+  int                 mpirank, mpisize;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (vtufilename != NULL);
+  if (forest->ghosts == NULL || forest->ghosts->num_ghosts_elements == 0) {
+    /* Never write ghost elements if there aren't any */
+    write_ghosts = 0;
+  }
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  /* The header is the same on all processes, and so is its size */
+  snprintf (header, BUFSIZ, "<?xml version=\"1.0\"?>\n"
+            "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" "
+            "header_type=\"UInt64\" byte_order=\"%s\">\n"
+            "  <UnstructuredGrid>\n",
+#ifdef SC_IS_BIGENDIAN
+            "BigEndian"
+#else
+            "LittleEndian"
+#endif
+    );
+
+  /* Write the xml text of the local piece and its appended data to
+   * memory */
+  out.file = NULL;
+  out.format = T8_VTK_FORMAT_APPENDED;
+  out.value_type = T8_VTK_VALUE_INT32;
+  out.array_start = 0;
+  out.points = NULL;
+  out.selected = NULL;
+  t8_forest_vtk_output_set_precision (&out, forest);
+  sc_array_init (&out.buffer, 1);
+  sc_array_init (&xml, 1);
+  sc_array_init (&offset_positions, sizeof (size_t));
+  out.xml = &xml;
+  out.offset_positions = &offset_positions;
+  success = success
+    && t8_forest_vtk_write_piece (forest, &out, write_treeid, write_mpirank,
+                                  write_level, write_element_id,
+                                  write_ghosts, num_data, data,
+                                  unique_points);
+
+  /* Each process needs the sizes of the pieces of all processes
+   * before it to know where its piece goes */
+  local_sizes[0] = (long long) xml.elem_count;
+  local_sizes[1] = (long long) out.buffer.elem_count;
+  all_sizes = T8_ALLOC (long long, 2 * mpisize);
+  mpiret = sc_MPI_Allgather (local_sizes, 2, sc_MPI_LONG_LONG_INT, all_sizes,
+                             2, sc_MPI_LONG_LONG_INT, comm);
+  SC_CHECK_MPI (mpiret);
+  header_size = (long long) strlen (header);
+  middle_size = (long long) strlen (middle);
+  xml_offset = header_size;
+  xml_total = 0;
+  data_offset = 0;
+  data_total = 0;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    if (iproc < mpirank) {
+      xml_offset += all_sizes[2 * iproc];
+      data_offset += all_sizes[2 * iproc + 1];
+    }
+    xml_total += all_sizes[2 * iproc];
+    data_total += all_sizes[2 * iproc + 1];
+  }
+  T8_FREE (all_sizes);
+
+  /* Shift the offsets of the local data arrays by the data of the
+   * processes before us. They were written with a fixed width of 20 digits. */
+  for (ipos = 0; ipos < offset_positions.elem_count; ipos++) {
+    digits = xml.array + *(size_t *) sc_array_index (&offset_positions, ipos);
+    value = 0;
+    for (idigit = 0; idigit < 20; idigit++) {
+      value = 10 * value + (digits[idigit] - '0');
+    }
+    snprintf (offset, 21, "%020llu", value + (unsigned long long) data_offset);
+    memcpy (digits, offset, 20);
+  }
+
+  /* The file is laid out as: header, all pieces, middle,
+   * all appended data, footer. */
+  num_blocks = 0;
+  if (mpirank == 0) {
+    blocks[num_blocks] = header;
+    sizes[num_blocks] = header_size;
+    offsets[num_blocks++] = 0;
+  }
+  blocks[num_blocks] = xml.array;
+  sizes[num_blocks] = xml.elem_count;
+  offsets[num_blocks++] = xml_offset;
+  if (mpirank == 0) {
+    blocks[num_blocks] = (char *) middle;
+    sizes[num_blocks] = middle_size;
+    offsets[num_blocks++] = header_size + xml_total;
+  }
+  blocks[num_blocks] = out.buffer.array;
+  sizes[num_blocks] = out.buffer.elem_count;
+  offsets[num_blocks++] = header_size + xml_total + middle_size + data_offset;
+  if (mpirank == 0) {
+    blocks[num_blocks] = (char *) footer;
+    sizes[num_blocks] = strlen (footer);
+    offsets[num_blocks++] =
+      header_size + xml_total + middle_size + data_total;
+  }
+  success = t8_forest_io_write_blocks (vtufilename, comm,
+                                       num_blocks, blocks, sizes, offsets)
+    && success;
+
+  sc_array_reset (&out.buffer);
+  sc_array_reset (&xml);
+  sc_array_reset (&offset_positions);
+  if (!success) {
+    t8_errorf ("Error when writing vtk file.\n");
+  }
+  return success;
+}
+
+int
+t8_forest_vtk_write_single_file (t8_forest_t forest, const char *fileprefix,
+                                 int write_treeid,
+                                 int write_mpirank,
+                                 int write_level, int write_element_id,
+                                 int write_ghosts,
+                                 int num_data, t8_vtk_data_field_t * data,
+                                 int unique_points)
+{
+  char                vtufilename[BUFSIZ];
+  int                 success;
+
+  T8_ASSERT (fileprefix != NULL);
+  success = snprintf (vtufilename, BUFSIZ, "%s.vtu", fileprefix) < BUFSIZ;
+  if (!success) {
+    t8_errorf ("Error when writing vtu file. Filename too long.\n");
+  }
+  return t8_forest_vtk_write_merged (forest, vtufilename, forest->mpicomm,
+                                     write_treeid, write_mpirank,
+                                     write_level, write_element_id,
+                                     write_ghosts, num_data, data,
+                                     unique_points) && success;
+}
+
+int
+t8_forest_vtk_write_file_nodes (t8_forest_t forest, const char *fileprefix,
+                                int write_treeid,
+                                int write_mpirank,
+                                int write_level, int write_element_id,
+                                int write_ghosts,
+                                int num_data, t8_vtk_data_field_t * data,
+                                int unique_points)
+{
+  char                vtufilename[BUFSIZ];
+  sc_MPI_Comm         node_comm;
+  int                 node, num_nodes, success = 1;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+
+  node_comm = t8_vtk_node_comm (forest->mpicomm, &node, &num_nodes);
+  /* process 0 creates the .pvtu file with one piece per node */
+  if (forest->mpirank == 0) {
+    if (t8_write_pvtu_float_type
+        (fileprefix, num_nodes, write_treeid, write_mpirank,
+         write_level, write_element_id, num_data, data,
+         forest->geometry_float ? "Float32" : T8_VTK_FLOAT_NAME)) {
+      t8_errorf ("Error when writing file %s.pvtu\n", fileprefix);
+      success = 0;
+    }
+  }
+  /* The processes of a node write the file of the node together */
+  if (snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix, node)
+      >= BUFSIZ) {
+    t8_errorf ("Error when writing vtu file. Filename too long.\n");
+    success = 0;
+  }
+  return t8_forest_vtk_write_merged (forest, vtufilename, node_comm,
+                                     write_treeid, write_mpirank,
+                                     write_level, write_element_id,
+                                     write_ghosts, num_data, data,
+                                     unique_points) && success;
+}
+
+/* The number of files that an asynchronous output can hold in memory */
+#define T8_FOREST_VTK_ASYNC_NUM_BUFFERS 2
+
+/* A file that is written by the I/O thread */
+typedef struct
+{
+  char                filename[BUFSIZ];
+  sc_array_t          contents; /* The bytes of the file. */
+} t8_forest_vtk_async_file_t;
+
+struct t8_forest_vtk_async
+{
+  t8_forest_vtk_async_file_t files[T8_FOREST_VTK_ASYNC_NUM_BUFFERS];
+  /* The files are used in a ring. File i is stored in
+   * files[i % T8_FOREST_VTK_ASYNC_NUM_BUFFERS]. */
+  long                num_packed;       /* The number of files handed to the thread. */
+  long                num_written;      /* The number of files the thread finished. */
+  int                 failed;   /* True if writing a file failed since the last wait. */
+#ifdef SC_ENABLE_PTHREAD
+  int                 shutdown; /* True if the thread should stop. */
+  pthread_t           thread;
+  pthread_mutex_t     mutex;    /* Protects the counters and flags. */
+  pthread_cond_t      cond;     /* Signals a change of the counters. */
+#endif
+};
+
+/* Write the contents of a file. Returns true on success. */
+static int
+t8_forest_vtk_async_write (const t8_forest_vtk_async_file_t * file)
+{
+  FILE               *vtufile;
+  int                 success;
+
+  vtufile = fopen (file->filename, "wb");
+  if (vtufile == NULL) {
+    t8_errorf ("Error when opening file %s\n", file->filename);
+    return 0;
+  }
+  success = fwrite (file->contents.array, 1, file->contents.elem_count,
+                    vtufile) == file->contents.elem_count;
+  /* fclose must be called in any case */
+  success = !fclose (vtufile) && success;
+  if (!success) {
+    t8_errorf ("Error when writing file %s\n", file->filename);
+  }
+  return success;
+}
+
+#ifdef SC_ENABLE_PTHREAD
+/* The I/O thread writes the packed files in order until it is shut down
+ * and all files are written. */
+static void        *
+t8_forest_vtk_async_thread (void *arg)
+{
+  t8_forest_vtk_async_t async = (t8_forest_vtk_async_t) arg;
+  t8_forest_vtk_async_file_t *file;
+  int                 success;
+
+  pthread_mutex_lock (&async->mutex);
+  for (;;) {
+    while (async->num_written == async->num_packed && !async->shutdown) {
+      pthread_cond_wait (&async->cond, &async->mutex);
+    }
+    if (async->num_written == async->num_packed) {
+      /* We are shut down and there is nothing left to write */
+      break;
+    }
+    file = async->files +
+      async->num_written % T8_FOREST_VTK_ASYNC_NUM_BUFFERS;
+    /* The calling thread does not touch a file until it is written */
+    pthread_mutex_unlock (&async->mutex);
+    success = t8_forest_vtk_async_write (file);
+    pthread_mutex_lock (&async->mutex);
+    async->failed = async->failed || !success;
+    async->num_written++;
+    pthread_cond_broadcast (&async->cond);
+  }
+  pthread_mutex_unlock (&async->mutex);
+  return NULL;
+}
+#endif
+
+void
+t8_forest_vtk_async_init (t8_forest_vtk_async_t * pasync)
+{
+  t8_forest_vtk_async_t async;
+  int                 ifile;
+
+  T8_ASSERT (pasync != NULL);
+  async = *pasync = T8_ALLOC_ZERO (struct t8_forest_vtk_async, 1);
+  for (ifile = 0; ifile < T8_FOREST_VTK_ASYNC_NUM_BUFFERS; ifile++) {
+    sc_array_init (&async->files[ifile].contents, 1);
+  }
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_init (&async->mutex, NULL);
+  pthread_cond_init (&async->cond, NULL);
+  SC_CHECK_ABORT (!pthread_create (&async->thread, NULL,
+                                   t8_forest_vtk_async_thread, async),
+                  "Could not create the vtk output thread");
+#endif
+}
+
+/* Pack the vtu file of this process in appended format into \a contents.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_pack_file (t8_forest_t forest, int write_treeid,
+                         int write_mpirank, int write_level,
+                         int write_element_id, int write_ghosts,
+                         int num_data, t8_vtk_data_field_t * data,
+                         int unique_points, sc_array_t * contents)
+{
+  t8_forest_vtk_output_t out;
+  sc_array_t          offset_positions;
+  int                 success;
+
+  out.file = NULL;
+  out.format = T8_VTK_FORMAT_APPENDED;
+  out.value_type = T8_VTK_VALUE_INT32;
+  out.array_start = 0;
+  out.points = NULL;
+  out.selected = NULL;
+  t8_forest_vtk_output_set_precision (&out, forest);
+  sc_array_init (&out.buffer, 1);
+  /* The offsets of the arrays are final, we do not need their positions */
+  sc_array_init (&offset_positions, sizeof (size_t));
+  out.xml = contents;
+  out.offset_positions = &offset_positions;
+
+  sc_array_resize (contents, 0);
+  success = t8_forest_vtk_printf (&out, "<?xml version=\"1.0\"?>\n"
+                                  "<VTKFile type=\"UnstructuredGrid\" "
+                                  "version=\"1.0\" header_type=\"UInt64\" "
+                                  "byte_order=\"%s\">\n"
+                                  "  <UnstructuredGrid>\n",
+#ifdef SC_IS_BIGENDIAN
+                                  "BigEndian"
+#else
+                                  "LittleEndian"
+#endif
+    ) > 0
+    && t8_forest_vtk_write_piece (forest, &out, write_treeid, write_mpirank,
+                                  write_level, write_element_id,
+                                  write_ghosts, num_data, data,
+                                  unique_points)
+    && t8_forest_vtk_printf (&out, "  </UnstructuredGrid>\n"
+                             "  <AppendedData encoding=\"raw\">\n   _") > 0;
+  if (success) {
+    /* Append the data arrays and the end of the file */
+    memcpy (sc_array_push_count (contents, out.buffer.elem_count),
+            out.buffer.array, out.buffer.elem_count);
+    success = t8_forest_vtk_printf (&out, "\n  </AppendedData>\n"
+                                    "</VTKFile>\n") > 0;
+  }
+  sc_array_reset (&out.buffer);
+  sc_array_reset (&offset_positions);
+  return success;
+}
+
+int
+t8_forest_vtk_write_file_async (t8_forest_vtk_async_t async,
+                                t8_forest_t forest, const char *fileprefix,
+                                int write_treeid, int write_mpirank,
+                                int write_level, int write_element_id,
+                                int write_ghosts, int num_data,
+                                t8_vtk_data_field_t * data,
+                                int unique_points)
+{
+  t8_forest_vtk_async_file_t *file;
+  int                 success;
+
+  T8_ASSERT (async != NULL);
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+  if (forest->ghosts == NULL || forest->ghosts->num_ghosts_elements == 0) {
+    /* Never write ghost elements if there aren't any */
+    write_ghosts = 0;
+  }
+
+  /* process 0 creates the .pvtu file */
+  if (forest->mpirank == 0) {
+    if (t8_write_pvtu_float_type
+        (fileprefix, forest->mpisize, write_treeid, write_mpirank,
+         write_level, write_element_id, num_data, data,
+         forest->geometry_float ? "Float32" : T8_VTK_FLOAT_NAME)) {
+      t8_errorf ("Error when writing file %s.pvtu\n", fileprefix);
+      return 0;
+    }
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  /* Wait for a free buffer */
+  pthread_mutex_lock (&async->mutex);
+  while (async->num_packed - async->num_written >=
+         T8_FOREST_VTK_ASYNC_NUM_BUFFERS) {
+    pthread_cond_wait (&async->cond, &async->mutex);
+  }
+  pthread_mutex_unlock (&async->mutex);
+#endif
+  /* The I/O thread does not touch this buffer until we hand it over */
+  file = async->files + async->num_packed % T8_FOREST_VTK_ASYNC_NUM_BUFFERS;
+  if (snprintf (file->filename, BUFSIZ, "%s_%04d.vtu", fileprefix,
+                forest->mpirank) >= BUFSIZ) {
+    t8_errorf ("Error when writing vtu file. Filename too long.\n");
+    return 0;
+  }
+  success = t8_forest_vtk_pack_file (forest, write_treeid, write_mpirank,
+                                     write_level, write_element_id,
+                                     write_ghosts, num_data, data,
+                                     unique_points, &file->contents);
+  if (!success) {
+    t8_errorf ("Error when writing vtk file.\n");
+    return 0;
+  }
+
+#ifdef SC_ENABLE_PTHREAD
+  /* Hand the file over to the I/O thread */
+  pthread_mutex_lock (&async->mutex);
+  async->num_packed++;
+  pthread_cond_broadcast (&async->cond);
+  pthread_mutex_unlock (&async->mutex);
+#else
+  /* Without threads we write the file right away */
+  async->failed = async->failed || !t8_forest_vtk_async_write (file);
+  async->num_packed++;
+  async->num_written++;
+#endif
+  return 1;
+}
+
+int
+t8_forest_vtk_async_wait (t8_forest_vtk_async_t async)
+{
+  int                 success;
+
+  T8_ASSERT (async != NULL);
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_lock (&async->mutex);
+  while (async->num_written < async->num_packed) {
+    pthread_cond_wait (&async->cond, &async->mutex);
+  }
+#endif
+  success = !async->failed;
+  async->failed = 0;
+#ifdef SC_ENABLE_PTHREAD
+  pthread_mutex_unlock (&async->mutex);
+#endif
+  return success;
+}
+
+void
+t8_forest_vtk_async_destroy (t8_forest_vtk_async_t * pasync)
+{
+  t8_forest_vtk_async_t async;
+  int                 ifile;
+
+  T8_ASSERT (pasync != NULL && *pasync != NULL);
+  async = *pasync;
+#ifdef SC_ENABLE_PTHREAD
+  /* The thread writes all remaining files before it stops */
+  pthread_mutex_lock (&async->mutex);
+  async->shutdown = 1;
+  pthread_cond_broadcast (&async->cond);
+  pthread_mutex_unlock (&async->mutex);
+  pthread_join (async->thread, NULL);
+  pthread_cond_destroy (&async->cond);
+  pthread_mutex_destroy (&async->mutex);
+#endif
+  T8_ASSERT (async->num_written == async->num_packed);
+  for (ifile = 0; ifile < T8_FOREST_VTK_ASYNC_NUM_BUFFERS; ifile++) {
+    sc_array_reset (&async->files[ifile].contents);
+  }
+  T8_FREE (async);
+  *pasync = NULL;
+}
+
+/* Collect the values of one cell data kernel for all local elements in
+ * an array of \a value_type. The size of the array is returned in
+ * \a num_bytes. Return NULL on failure. */
+static void        *
+t8_forest_vtk_mesh_collect (t8_forest_t forest, t8_forest_vtk_output_t * out,
+                            int value_type,
+                            t8_forest_vtk_cell_data_kernel kernel,
+                            void *udata, size_t *num_bytes)
+{
+  void               *values;
+
+  out->value_type = value_type;
+  sc_array_resize (&out->buffer, 0);
+  if (!t8_forest_vtk_write_cell_values (forest, out, 1, kernel, 0, udata)) {
+    return NULL;
+  }
+  *num_bytes = out->buffer.elem_count;
+  values = T8_ALLOC (char, *num_bytes + 1);
+  memcpy (values, out->buffer.array, *num_bytes);
+  return values;
+}
+
+int
+t8_forest_vtk_mesh_build (t8_forest_t forest, int unique_points,
+                          t8_forest_vtk_mesh_t * mesh)
+{
+  t8_forest_vtk_output_t collect;
+  t8_forest_vtk_points_t points;
+  t8_forest_vtk_point_values_t state;
+  sc_array_t         *field_data;
+  size_t              num_bytes;
+  int                 ifield, num_fields, success;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (mesh != NULL);
+
+  memset (mesh, 0, sizeof (*mesh));
+  mesh->num_cells = t8_forest_get_num_element (forest);
+
+  /* The kernels of the vtk output write the raw values into a buffer */
+  collect.file = NULL;
+  collect.format = T8_VTK_FORMAT_BINARY;
+  collect.array_start = 0;
+  collect.xml = NULL;
+  collect.offset_positions = NULL;
+  collect.points = NULL;
+  collect.selected = NULL;
+  t8_forest_vtk_output_set_precision (&collect, forest);
+  sc_array_init (&collect.buffer, 1);
+
+  if (unique_points) {
+    /* Each distinct point once */
+    success = t8_forest_vtk_build_points (forest, 0, NULL, &points);
+    if (success) {
+      mesh->num_points = points.num_points;
+      mesh->points = T8_ALLOC (double, 3 * points.num_points + 1);
+      memcpy (mesh->points, points.coords,
+              3 * sizeof (double) * points.num_points);
+      state.points = &points;
+      state.values = NULL;
+      state.num_components = 0;
+      state.ascii_format = NULL;
+      state.corner = 0;
+      state.next_point = 0;
+      mesh->connectivity = (int64_t *)
+        t8_forest_vtk_mesh_collect (forest, &collect, T8_VTK_VALUE_INT64,
+                                    t8_forest_vtk_cells_point_connectivity_kernel,
+                                    &state, &num_bytes);
+    }
+    t8_forest_vtk_destroy_points (&points);
+  }
+  else {
+    /* The corners of each cell */
+    mesh->num_points = t8_forest_num_points (forest, 0, NULL);
+    mesh->points = (double *)
+      t8_forest_vtk_mesh_collect (forest, &collect, T8_VTK_VALUE_FLOAT64,
+                                  t8_forest_vtk_cells_vertices_kernel, NULL,
+                                  &num_bytes);
+    mesh->connectivity = mesh->points == NULL ? NULL : (int64_t *)
+      t8_forest_vtk_mesh_collect (forest, &collect, T8_VTK_VALUE_INT64,
+                                  t8_forest_vtk_cells_connectivity_kernel,
+                                  NULL, &num_bytes);
+  }
+  mesh->offsets = mesh->connectivity == NULL ? NULL : (int64_t *)
+    t8_forest_vtk_mesh_collect (forest, &collect, T8_VTK_VALUE_INT64,
+                                t8_forest_vtk_cells_offset_kernel, NULL,
+                                &num_bytes);
+  mesh->types = mesh->offsets == NULL ? NULL : (int32_t *)
+    t8_forest_vtk_mesh_collect (forest, &collect, T8_VTK_VALUE_INT32,
+                                t8_forest_vtk_cells_type_kernel, NULL,
+                                &num_bytes);
+  sc_array_reset (&collect.buffer);
+  if (mesh->types == NULL) {
+    t8_forest_vtk_mesh_destroy (mesh);
+    return 0;
+  }
+
+  /* The fields of doubles are passed without copying */
+  num_fields = t8_forest_field_num (forest);
+  mesh->field_names = T8_ALLOC (const char *, num_fields + 1);
+  mesh->field_values = T8_ALLOC (const double *, num_fields + 1);
+  mesh->field_components = T8_ALLOC (int, num_fields + 1);
+  for (ifield = 0; ifield < num_fields; ifield++) {
+    field_data = t8_forest_field_get_data (forest, ifield);
+    if (field_data->elem_size % sizeof (double) != 0) {
+      /* This is not a field of doubles */
+      continue;
+    }
+    mesh->field_names[mesh->num_fields] =
+      t8_forest_field_get_name (forest, ifield);
+    mesh->field_values[mesh->num_fields] = (const double *) field_data->array;
+    mesh->field_components[mesh->num_fields] =
+      (int) (field_data->elem_size / sizeof (double));
+    mesh->num_fields++;
+  }
+  return 1;
+}
+
+void
+t8_forest_vtk_mesh_destroy (t8_forest_vtk_mesh_t * mesh)
+{
+  T8_ASSERT (mesh != NULL);
+  if (mesh->points != NULL) {
+    T8_FREE (mesh->points);
+  }
+  if (mesh->connectivity != NULL) {
+    T8_FREE (mesh->connectivity);
+  }
+  if (mesh->offsets != NULL) {
+    T8_FREE (mesh->offsets);
+  }
+  if (mesh->types != NULL) {
+    T8_FREE (mesh->types);
+  }
+  if (mesh->field_names != NULL) {
+    T8_FREE (mesh->field_names);
+    T8_FREE (mesh->field_values);
+    T8_FREE (mesh->field_components);
+  }
+  memset (mesh, 0, sizeof (*mesh));
+}
+
 T8_EXTERN_C_END ();
@@ -30,6 +30,7 @@
 
 #include <t8_vtk.h>
 #include <t8_forest.h>
+#include <t8_forest/t8_forest_iterate.h>
 
 T8_EXTERN_C_BEGIN ();
 /* function declarations */
@@ -61,6 +62,248 @@ int                 t8_forest_vtk_write_file (t8_forest_t forest,
                                               int num_data,
                                               t8_vtk_data_field_t * data);
 
+/** Write the forest in .pvtu file format, choosing the format of the data.
+ * Writes one .vtu file per process and a meta .pvtu file.
+ * The parameters are the same as for \ref t8_forest_vtk_write_file, which
+ * writes in ASCII format.
+ * \param [in]  format    The format of the data arrays in the .vtu files.
+ *                        The binary formats write the raw values of each
+ *                        array in one block. They are much faster to write
+ *                        and to read and result in smaller files.
+ *                        For \ref T8_VTK_FORMAT_APPENDED, each process keeps
+ *                        all its data arrays in memory until the file is
+ *                        complete.
+ *                        Floating point arrays are written in single
+ *                        precision if \ref t8_forest_set_geometry_float
+ *                        was set for \a forest.
+ * \param [in]  unique_points If true, each point that is shared by several
+ *                        elements (also across trees) is written only once,
+ *                        and the cells reference these shared points.
+ *                        Point data is then the average of the values of
+ *                        the adjacent elements. This makes the files
+ *                        smaller and allows filters such as contours and
+ *                        streamlines to see the mesh as connected.
+ *                        Otherwise each element writes its own corners.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_file_format (t8_forest_t forest,
+                                                     const char *fileprefix,
+                                                     int write_treeid,
+                                                     int write_mpirank,
+                                                     int write_level,
+                                                     int write_element_id,
+                                                     int write_ghosts,
+                                                     int num_data,
+                                                     t8_vtk_data_field_t *
+                                                     data,
+                                                     t8_vtk_format_t format,
+                                                     int unique_points);
+
+/** Write the forest into one .vtu file that is shared by all processes.
+ * Each process writes its elements as one piece of the file. The data is
+ * written in raw binary appended format, \see T8_VTK_FORMAT_APPENDED.
+ * The processes compute the positions of their pieces in the file from
+ * the sizes of the pieces of all processes and write them with collective
+ * MPI I/O. If t8code is built without MPI I/O, the processes write one
+ * after the other. Unlike \ref t8_forest_vtk_write_file, no .pvtu file is
+ * written, which avoids one file per process and output step.
+ * This function is collective.
+ * The parameters are the same as for \ref t8_forest_vtk_write_file_format.
+ * The output file is fileprefix.vtu.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_single_file (t8_forest_t forest,
+                                                     const char *fileprefix,
+                                                     int write_treeid,
+                                                     int write_mpirank,
+                                                     int write_level,
+                                                     int write_element_id,
+                                                     int write_ghosts,
+                                                     int num_data,
+                                                     t8_vtk_data_field_t *
+                                                     data,
+                                                     int unique_points);
+
+/** Write the forest in .pvtu file format with one piece file per shared
+ * memory node instead of one per process.
+ * The processes of a node write their elements into the file of the node
+ * as in \ref t8_forest_vtk_write_single_file, and process 0 writes the
+ * .pvtu file that lists the files of all nodes. This reduces the number
+ * of files of a large run by the number of processes per node.
+ * If the node communicators are not available, each process is its own
+ * node and the output matches \ref t8_forest_vtk_write_file_format.
+ * This function is collective.
+ * The parameters are the same as for \ref t8_forest_vtk_write_file_format.
+ * The output files are fileprefix.pvtu and fileprefix_NODE.vtu.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_file_nodes (t8_forest_t forest,
+                                                    const char *fileprefix,
+                                                    int write_treeid,
+                                                    int write_mpirank,
+                                                    int write_level,
+                                                    int write_element_id,
+                                                    int write_ghosts,
+                                                    int num_data,
+                                                    t8_vtk_data_field_t *
+                                                    data, int unique_points);
+
+/** A filter that selects the local elements that are written by
+ * \ref t8_forest_vtk_write_file_filtered.
+ * An element is written if it passes all criteria of the filter.
+ * The criteria are evaluated in a \ref t8_forest_search, such that whole
+ * subtrees outside of the level range or the box are skipped.
+ * Initialize a filter with \ref t8_forest_vtk_filter_init.
+ */
+typedef struct
+{
+  int                 min_level;        /**< Only write elements of at least this level. */
+  int                 max_level;        /**< If >= 0, only write elements of at most this level. */
+  int                 use_box;          /**< If true, only write elements whose bounding box,
+                                             see \ref t8_forest_element_bounding_box,
+                                             intersects \a box. */
+  double              box[6];           /**< The minimum x, y and z coordinates followed by
+                                             the maximum x, y and z coordinates of the box. */
+  t8_forest_search_query_fn select_fn;  /**< If not NULL, called as in \ref t8_forest_search
+                                             for the elements that pass the other criteria.
+                                             For a non-leaf, false skips its descendants.
+                                             For a leaf, true writes the leaf. */
+  void               *user_data;        /**< Passed to \a select_fn. */
+} t8_forest_vtk_filter_t;
+
+/** Initialize a filter such that all elements pass.
+ * \param [out] filter   The filter.
+ */
+void                t8_forest_vtk_filter_init (t8_forest_vtk_filter_t *
+                                               filter);
+
+/** Write only the local elements that pass a filter in .pvtu file format.
+ * Each process writes a .vtu file with its selected elements, which may be
+ * empty, and process 0 writes the .pvtu file that refers to all of them.
+ * Ghost elements are not written.
+ * The other parameters are the same as for
+ * \ref t8_forest_vtk_write_file_format.
+ * \param [in]  filter    The filter that selects the elements.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_file_filtered (t8_forest_t forest,
+                                                       const char
+                                                       *fileprefix,
+                                                       int write_treeid,
+                                                       int write_mpirank,
+                                                       int write_level,
+                                                       int write_element_id,
+                                                       int num_data,
+                                                       t8_vtk_data_field_t *
+                                                       data,
+                                                       t8_vtk_format_t
+                                                       format,
+                                                       int unique_points,
+                                                       const
+                                                       t8_forest_vtk_filter_t
+                                                       * filter);
+
+/** Opaque handle of an asynchronous vtk output.
+ * Files are written by a background thread while the calling code goes on.
+ * \see t8_forest_vtk_write_file_async */
+typedef struct t8_forest_vtk_async *t8_forest_vtk_async_t;
+
+/** Create a handle for asynchronous vtk output and start its I/O thread.
+ * If libsc is configured without --enable-pthread, there is no thread and
+ * the files are written before \ref t8_forest_vtk_write_file_async returns.
+ * \param [out] pasync   On output the new handle.
+ */
+void                t8_forest_vtk_async_init (t8_forest_vtk_async_t *
+                                              pasync);
+
+/** Write the forest in .pvtu file format in the background.
+ * The vtu file of this process is first packed into memory in
+ * \ref T8_VTK_FORMAT_APPENDED format, which is the expensive part that
+ * touches the forest. Then the I/O thread of \a async writes the memory
+ * to the file. When this function returns, the forest and the data fields
+ * are no longer needed and may be changed or destroyed.
+ * The handle has two output buffers. If two files are still being written,
+ * this function waits until the older one is complete, such that at most
+ * two files per process are held in memory.
+ * The .pvtu meta file is small and written directly by process 0.
+ * The parameters are the same as for \ref t8_forest_vtk_write_file_format.
+ * \param [in,out] async The handle of the asynchronous output.
+ * \return  True if the file was packed succesfully, false if not
+ *          (process local). Errors while writing the file are reported by
+ *          \ref t8_forest_vtk_async_wait.
+ */
+int                 t8_forest_vtk_write_file_async (t8_forest_vtk_async_t
+                                                    async,
+                                                    t8_forest_t forest,
+                                                    const char *fileprefix,
+                                                    int write_treeid,
+                                                    int write_mpirank,
+                                                    int write_level,
+                                                    int write_element_id,
+                                                    int write_ghosts,
+                                                    int num_data,
+                                                    t8_vtk_data_field_t *
+                                                    data, int unique_points);
+
+/** Wait until all files of an asynchronous output are written.
+ * \param [in,out] async The handle of the asynchronous output.
+ * \return  True if all files that were written since the last call to
+ *          this function were written succesfully, false if not
+ *          (process local).
+ */
+int                 t8_forest_vtk_async_wait (t8_forest_vtk_async_t async);
+
+/** Wait until all files are written, stop the I/O thread and free the
+ * handle of an asynchronous output.
+ * \param [in,out] pasync The handle. Set to NULL on output.
+ */
+void                t8_forest_vtk_async_destroy (t8_forest_vtk_async_t *
+                                                 pasync);
+
+/** The mesh of the local elements of a forest in the memory layout of a
+ * vtk unstructured grid. It can be handed to in situ visualization
+ * libraries, such as ParaView Catalyst or ADIOS2, without writing files.
+ * \see t8_forest_vtk_mesh_build */
+typedef struct
+{
+  t8_locidx_t         num_points;       /**< The number of points. */
+  t8_locidx_t         num_cells;        /**< The number of cells, one per local element. */
+  double             *points;           /**< 3 coordinates per point. */
+  int64_t            *connectivity;     /**< The points of the corners of all cells, in vtk
+                                             corner order. */
+  int64_t            *offsets;          /**< For each cell the end of its corners in
+                                             \a connectivity. */
+  int32_t            *types;            /**< For each cell its vtk cell type. */
+  int                 num_fields;       /**< The number of element fields of doubles. */
+  const char        **field_names;      /**< The names of the fields. */
+  const double      **field_values;     /**< For each field its values of the local elements,
+                                             followed by the ghosts. */
+  int                *field_components; /**< The number of doubles per element of each field. */
+} t8_forest_vtk_mesh_t;
+
+/** Build the vtk mesh of the local elements of a forest in memory.
+ * The points, connectivity, offsets and types are computed by the same
+ * kernels as the vtk file output. The values of the element fields of the
+ * forest, \see t8_forest_field_register, whose entries consist of doubles
+ * are not copied; \a mesh points to the data of the fields.
+ * \param [in]  forest    A committed forest.
+ * \param [in]  unique_points If true, shared points are stored once,
+ *                        \see t8_forest_vtk_write_file_format.
+ *                        Otherwise each cell has its own corners.
+ * \param [out] mesh      On output the mesh. The field values stay valid
+ *                        as long as the fields of \a forest are not changed.
+ *                        Free with \ref t8_forest_vtk_mesh_destroy.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_mesh_build (t8_forest_t forest,
+                                              int unique_points,
+                                              t8_forest_vtk_mesh_t * mesh);
+
+/** Free the memory of a vtk mesh.
+ * \param [in,out] mesh   A mesh built with \ref t8_forest_vtk_mesh_build.
+ */
+void                t8_forest_vtk_mesh_destroy (t8_forest_vtk_mesh_t * mesh);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_VTK_H */
@@ -119,6 +119,16 @@ t8_geometry_reset (t8_geometry_t * pgeom)
   }
 }
 
+void
+t8_geometry_evaluate (t8_geometry_t geom, t8_topidx_t which_tree,
+                      const double abc[3], double xyz[3])
+{
+  T8_ASSERT (geom != NULL);
+  T8_ASSERT (geom->X != NULL);
+
+  geom->X (geom, which_tree, abc, xyz);
+}
+
 static void
 t8_geometry_identity_X (t8_geometry_t geom, t8_topidx_t which_tree,
                         const double abc[3], double xyz[3])
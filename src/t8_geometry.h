@@ -75,6 +75,17 @@ void                t8_geometry_unref (t8_geometry_t * pgeom);
 
 void                t8_geometry_reset (t8_geometry_t * pgeom);
 
+/** Evaluate the transformation of a geometry.
+ * \param [in] geom The geometry, its transformation must be set.
+ * \param [in] which_tree The tree_id of the coarse tree to be considered.
+ * \param [in] abc  The reference coordinates in [0,1]^d to be transformed.
+ * \param [out] xyz The physical coordinates that abc get mapped to.
+ */
+void                t8_geometry_evaluate (t8_geometry_t geom,
+                                          t8_topidx_t which_tree,
+                                          const double abc[3],
+                                          double xyz[3]);
+
 /** Create a geometry that maps the unit square to itself via the identity mapping.
  * This function exists to provide the minimal example of a t8_geometry_t.
  * It should not be used for coarse meshes with more than one tree.
@@ -0,0 +1,986 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_profile_regions.h>
+#if defined __x86_64__ || defined __i386__
+#include <x86intrin.h>
+#define T8_PROFILE_REGIONS_TSC 1
+#endif
+#if defined T8_WITH_PAPI
+#include <papi.h>
+#define T8_PROFILE_REGIONS_HW 1
+#elif defined T8_ENABLE_PERF_EVENT
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define T8_PROFILE_REGIONS_HW 1
+#endif
+#if defined T8_HAVE_MALLINFO2 && defined T8_HAVE_MALLOC_H
+#include <malloc.h>
+#define T8_PROFILE_REGIONS_MEMORY 1
+#endif
+
+/** The maximum nesting depth of regions, including the root. */
+#define T8_PROFILE_REGIONS_MAX_DEPTH 64
+
+/* A region or a counter in the tree of regions */
+typedef struct t8_profile_region_node
+{
+  const char         *name;
+  int                 parent;
+  int                 first_child;
+  int                 next_sibling;
+  int                 is_counter;
+  long long           num_calls;
+  uint64_t            ticks;    /* The total ticks of a region */
+  uint64_t            min_ticks;
+  uint64_t            max_ticks;
+  double              value;    /* The sum of a counter */
+  uint64_t            hw[T8_PROFILE_REGIONS_MAX_HW_COUNTERS];   /* The total hardware counts */
+  double              memory_peak;      /* The maximum heap memory over all calls */
+} t8_profile_region_node_t;
+
+/* A call of a region, for the trace output */
+typedef struct t8_profile_region_event
+{
+  int                 node;
+  uint64_t            begin;
+  uint64_t            end;
+} t8_profile_region_event_t;
+
+/* The regions of this process. We allocate with malloc instead of
+ * T8_ALLOC, since the regions may be recorded before t8_init and after
+ * sc_finalize, which would report them as leaked. */
+static struct
+{
+  int                 initialized;
+  t8_profile_region_node_t *nodes;
+  int                 num_nodes;
+  int                 alloc_nodes;
+  int                 stack[T8_PROFILE_REGIONS_MAX_DEPTH];
+  uint64_t            stack_begin[T8_PROFILE_REGIONS_MAX_DEPTH];
+  int                 depth;
+  int                 do_trace;
+  t8_profile_region_event_t *events;
+  size_t              num_events;
+  size_t              alloc_events;
+  t8_profile_region_hook_t begin_fn;
+  t8_profile_region_hook_t end_fn;
+  void               *hook_data;
+  uint64_t            first_ticks;
+  double              first_wtime;
+  int                 hw_initialized;
+  int                 num_hw;   /* The number of available hardware counters */
+  const char         *hw_names[T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+  uint64_t            stack_hw[T8_PROFILE_REGIONS_MAX_DEPTH]
+    [T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+  uint64_t            last_hw[T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+  int                 do_memory;
+  double              stack_memory_peak[T8_PROFILE_REGIONS_MAX_DEPTH];
+  double              last_memory_peak;
+#if defined T8_WITH_PAPI
+  int                 papi_eventset;
+#elif defined T8_ENABLE_PERF_EVENT
+  int                 perf_fd[T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+#endif
+} t8_profile_regions;
+
+static uint64_t
+t8_profile_regions_ticks (void)
+{
+#ifdef T8_PROFILE_REGIONS_TSC
+  return __rdtsc ();
+#else
+  return (uint64_t) (sc_MPI_Wtime () * 1e9);
+#endif
+}
+
+/* Return the number of ticks per second. The time stamp counter is
+ * calibrated against the wall time since the first region. */
+static double
+t8_profile_regions_ticks_per_second (void)
+{
+#ifdef T8_PROFILE_REGIONS_TSC
+  double              elapsed;
+
+  /* Wait for a sufficiently long interval */
+  do {
+    elapsed = sc_MPI_Wtime () - t8_profile_regions.first_wtime;
+  } while (elapsed < 1e-2);
+  return (t8_profile_regions_ticks () - t8_profile_regions.first_ticks)
+    / elapsed;
+#else
+  return 1e9;
+#endif
+}
+
+#ifdef T8_PROFILE_REGIONS_HW
+/* Open the hardware counters. Counters that the hardware or the operating
+ * system do not provide are skipped. */
+static void
+t8_profile_regions_hw_init (void)
+{
+#if defined T8_WITH_PAPI
+  int                 events[T8_PROFILE_REGIONS_MAX_HW_COUNTERS] =
+    { PAPI_TOT_INS, PAPI_TOT_CYC, PAPI_L1_DCM, PAPI_L3_TCM };
+  const char         *names[T8_PROFILE_REGIONS_MAX_HW_COUNTERS] =
+    { "instructions", "cycles", "L1 data cache misses",
+    "L3 cache misses"
+  };
+  int                 ievent;
+
+  t8_profile_regions.papi_eventset = PAPI_NULL;
+  if ((PAPI_is_initialized () == PAPI_NOT_INITED
+       && PAPI_library_init (PAPI_VER_CURRENT) != PAPI_VER_CURRENT)
+      || PAPI_create_eventset (&t8_profile_regions.papi_eventset) != PAPI_OK) {
+    t8_global_errorf ("Could not initialize PAPI, the profile regions do not"
+                      " count hardware events.\n");
+    return;
+  }
+  for (ievent = 0; ievent < T8_PROFILE_REGIONS_MAX_HW_COUNTERS; ievent++) {
+    if (PAPI_add_event (t8_profile_regions.papi_eventset, events[ievent])
+        == PAPI_OK) {
+      t8_profile_regions.hw_names[t8_profile_regions.num_hw++] =
+        names[ievent];
+    }
+  }
+  if (t8_profile_regions.num_hw > 0
+      && PAPI_start (t8_profile_regions.papi_eventset) != PAPI_OK) {
+    t8_profile_regions.num_hw = 0;
+  }
+#elif defined T8_ENABLE_PERF_EVENT
+  struct perf_event_attr attr;
+  uint64_t            configs[T8_PROFILE_REGIONS_MAX_HW_COUNTERS] = {
+    PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_CACHE_MISSES
+  };
+  uint32_t            types[T8_PROFILE_REGIONS_MAX_HW_COUNTERS] = {
+    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+    PERF_TYPE_HARDWARE
+  };
+  const char         *names[T8_PROFILE_REGIONS_MAX_HW_COUNTERS] =
+    { "instructions", "cycles", "L1 data cache misses",
+    "last level cache misses"
+  };
+  int                 ievent, fd, leader = -1;
+
+  for (ievent = 0; ievent < T8_PROFILE_REGIONS_MAX_HW_COUNTERS; ievent++) {
+    memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = types[ievent];
+    attr.config = configs[ievent];
+    attr.disabled = leader < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    /* All counters form one group and are read with one system call */
+    attr.read_format = PERF_FORMAT_GROUP;
+    fd = (int) syscall (__NR_perf_event_open, &attr, 0, -1, leader, 0);
+    if (fd < 0) {
+      continue;
+    }
+    if (leader < 0) {
+      leader = fd;
+    }
+    t8_profile_regions.perf_fd[t8_profile_regions.num_hw] = fd;
+    t8_profile_regions.hw_names[t8_profile_regions.num_hw++] = names[ievent];
+  }
+  if (leader < 0) {
+    t8_global_errorf ("Could not open the perf events, the profile regions"
+                      " do not count hardware events.\n");
+    return;
+  }
+  ioctl (leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl (leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+/* Read the current values of the hardware counters */
+static void
+t8_profile_regions_hw_read (uint64_t *values)
+{
+#if defined T8_WITH_PAPI
+  long long           papi_values[T8_PROFILE_REGIONS_MAX_HW_COUNTERS];
+  int                 ihw;
+
+  PAPI_read (t8_profile_regions.papi_eventset, papi_values);
+  for (ihw = 0; ihw < t8_profile_regions.num_hw; ihw++) {
+    values[ihw] = (uint64_t) papi_values[ihw];
+  }
+#elif defined T8_ENABLE_PERF_EVENT
+  /* The group format starts with the number of counters */
+  uint64_t            group[T8_PROFILE_REGIONS_MAX_HW_COUNTERS + 1];
+  ssize_t             num_bytes;
+
+  num_bytes = read (t8_profile_regions.perf_fd[0], group, sizeof (group));
+  if (num_bytes < (ssize_t) ((t8_profile_regions.num_hw + 1)
+                             * sizeof (uint64_t))) {
+    memset (values, 0, t8_profile_regions.num_hw * sizeof (uint64_t));
+    return;
+  }
+  memcpy (values, group + 1, t8_profile_regions.num_hw * sizeof (uint64_t));
+#endif
+}
+#endif
+
+/* Return the number of heap bytes that are currently allocated,
+ * or a negative number if they are not known. */
+static double
+t8_profile_regions_memory_used (void)
+{
+#ifdef T8_PROFILE_REGIONS_MEMORY
+  struct mallinfo2    info = mallinfo2 ();
+
+  /* Large blocks are allocated with mmap and not counted in the arenas */
+  return (double) info.uordblks + (double) info.hblkhd;
+#else
+  return -1;
+#endif
+}
+
+/* Update the memory peak of all active regions */
+static void
+t8_profile_regions_memory_update (double used)
+{
+  int                 depth;
+
+  for (depth = 1; depth < t8_profile_regions.depth; depth++) {
+    t8_profile_regions.stack_memory_peak[depth] =
+      SC_MAX (t8_profile_regions.stack_memory_peak[depth], used);
+  }
+}
+
+static void
+t8_profile_regions_init (void)
+{
+  t8_profile_region_node_t *root;
+
+  t8_profile_regions.alloc_nodes = 64;
+  t8_profile_regions.nodes = (t8_profile_region_node_t *)
+    malloc (t8_profile_regions.alloc_nodes *
+            sizeof (t8_profile_region_node_t));
+  SC_CHECK_ABORT (t8_profile_regions.nodes != NULL, "Allocation failed");
+  root = t8_profile_regions.nodes;
+  memset (root, 0, sizeof (*root));
+  root->name = "root";
+  root->parent = root->first_child = root->next_sibling = -1;
+  t8_profile_regions.num_nodes = 1;
+  t8_profile_regions.stack[0] = 0;
+  t8_profile_regions.depth = 1;
+  t8_profile_regions.first_wtime = sc_MPI_Wtime ();
+  t8_profile_regions.first_ticks = t8_profile_regions_ticks ();
+  t8_profile_regions.initialized = 1;
+#ifdef T8_PROFILE_REGIONS_HW
+  /* The counters stay open when the regions are reset */
+  if (!t8_profile_regions.hw_initialized) {
+    t8_profile_regions_hw_init ();
+    t8_profile_regions.hw_initialized = 1;
+  }
+#endif
+}
+
+/* Find the child of a node with a given name. If it does not exist and
+ * create is true, add it, otherwise return -1. */
+static int
+t8_profile_regions_child (int parent, const char *name, int is_counter,
+                          int create)
+{
+  t8_profile_region_node_t *node;
+  int                 inode;
+
+  for (inode = t8_profile_regions.nodes[parent].first_child; inode >= 0;
+       inode = node->next_sibling) {
+    node = t8_profile_regions.nodes + inode;
+    /* The names are usually the same string literal */
+    if (node->is_counter == is_counter
+        && (node->name == name || !strcmp (node->name, name))) {
+      return inode;
+    }
+  }
+  if (!create) {
+    return -1;
+  }
+  if (t8_profile_regions.num_nodes == t8_profile_regions.alloc_nodes) {
+    t8_profile_regions.alloc_nodes *= 2;
+    t8_profile_regions.nodes = (t8_profile_region_node_t *)
+      realloc (t8_profile_regions.nodes, t8_profile_regions.alloc_nodes *
+               sizeof (t8_profile_region_node_t));
+    SC_CHECK_ABORT (t8_profile_regions.nodes != NULL, "Allocation failed");
+  }
+  inode = t8_profile_regions.num_nodes++;
+  node = t8_profile_regions.nodes + inode;
+  memset (node, 0, sizeof (*node));
+  node->name = name;
+  node->parent = parent;
+  node->first_child = -1;
+  node->is_counter = is_counter;
+  node->min_ticks = UINT64_MAX;
+  /* Append the node to the children of parent, to keep the order of the
+   * first calls */
+  node->next_sibling = -1;
+  if (t8_profile_regions.nodes[parent].first_child < 0) {
+    t8_profile_regions.nodes[parent].first_child = inode;
+  }
+  else {
+    int                 isibling =
+      t8_profile_regions.nodes[parent].first_child;
+
+    while (t8_profile_regions.nodes[isibling].next_sibling >= 0) {
+      isibling = t8_profile_regions.nodes[isibling].next_sibling;
+    }
+    t8_profile_regions.nodes[isibling].next_sibling = inode;
+  }
+  return inode;
+}
+
+void
+t8_profile_region_begin (const char *name)
+{
+  int                 depth;
+
+  if (!t8_profile_regions.initialized) {
+    t8_profile_regions_init ();
+  }
+  if (t8_profile_regions.begin_fn != NULL) {
+    t8_profile_regions.begin_fn (name, t8_profile_regions.hook_data);
+  }
+  depth = t8_profile_regions.depth;
+  SC_CHECK_ABORT (depth < T8_PROFILE_REGIONS_MAX_DEPTH,
+                  "Too many nested profile regions");
+  t8_profile_regions.stack[depth] =
+    t8_profile_regions_child (t8_profile_regions.stack[depth - 1], name, 0,
+                              1);
+  t8_profile_regions.depth++;
+  if (t8_profile_regions.do_memory) {
+    t8_profile_regions.stack_memory_peak[depth] = 0;
+    t8_profile_regions_memory_update (t8_profile_regions_memory_used ());
+  }
+#ifdef T8_PROFILE_REGIONS_HW
+  if (t8_profile_regions.num_hw > 0) {
+    t8_profile_regions_hw_read (t8_profile_regions.stack_hw[depth]);
+  }
+#endif
+  t8_profile_regions.stack_begin[depth] = t8_profile_regions_ticks ();
+}
+
+void
+t8_profile_region_end (const char *name)
+{
+  uint64_t            end = t8_profile_regions_ticks (), ticks;
+  t8_profile_region_node_t *node;
+  t8_profile_region_event_t *event;
+  int                 depth;
+
+  T8_ASSERT (t8_profile_regions.initialized);
+  T8_ASSERT (t8_profile_regions.depth > 1);
+  if (t8_profile_regions.do_memory) {
+    t8_profile_regions_memory_update (t8_profile_regions_memory_used ());
+  }
+  depth = --t8_profile_regions.depth;
+  node = t8_profile_regions.nodes + t8_profile_regions.stack[depth];
+  T8_ASSERT (!strcmp (node->name, name));
+  ticks = end - t8_profile_regions.stack_begin[depth];
+  node->num_calls++;
+  node->ticks += ticks;
+  node->min_ticks = SC_MIN (node->min_ticks, ticks);
+  node->max_ticks = SC_MAX (node->max_ticks, ticks);
+  t8_profile_regions.last_memory_peak =
+    t8_profile_regions.do_memory ?
+    t8_profile_regions.stack_memory_peak[depth] : 0;
+  node->memory_peak =
+    SC_MAX (node->memory_peak, t8_profile_regions.last_memory_peak);
+#ifdef T8_PROFILE_REGIONS_HW
+  if (t8_profile_regions.num_hw > 0) {
+    int                 ihw;
+
+    t8_profile_regions_hw_read (t8_profile_regions.last_hw);
+    for (ihw = 0; ihw < t8_profile_regions.num_hw; ihw++) {
+      t8_profile_regions.last_hw[ihw] -=
+        t8_profile_regions.stack_hw[depth][ihw];
+      node->hw[ihw] += t8_profile_regions.last_hw[ihw];
+    }
+  }
+#endif
+  if (t8_profile_regions.do_trace) {
+    if (t8_profile_regions.num_events == t8_profile_regions.alloc_events) {
+      t8_profile_regions.alloc_events =
+        SC_MAX (1024, 2 * t8_profile_regions.alloc_events);
+      t8_profile_regions.events = (t8_profile_region_event_t *)
+        realloc (t8_profile_regions.events, t8_profile_regions.alloc_events
+                 * sizeof (t8_profile_region_event_t));
+      SC_CHECK_ABORT (t8_profile_regions.events != NULL,
+                      "Allocation failed");
+    }
+    event = t8_profile_regions.events + t8_profile_regions.num_events++;
+    event->node = t8_profile_regions.stack[depth];
+    event->begin = t8_profile_regions.stack_begin[depth];
+    event->end = end;
+  }
+  if (t8_profile_regions.end_fn != NULL) {
+    t8_profile_regions.end_fn (name, t8_profile_regions.hook_data);
+  }
+}
+
+void
+t8_profile_region_count (const char *name, double value)
+{
+  t8_profile_region_node_t *node;
+
+  if (!t8_profile_regions.initialized) {
+    t8_profile_regions_init ();
+  }
+  node = t8_profile_regions.nodes +
+    t8_profile_regions_child (t8_profile_regions.stack
+                              [t8_profile_regions.depth - 1], name, 1, 1);
+  node->num_calls++;
+  node->value += value;
+}
+
+void
+t8_profile_regions_set_trace (int do_trace)
+{
+  t8_profile_regions.do_trace = do_trace;
+}
+
+void
+t8_profile_regions_set_hooks (t8_profile_region_hook_t begin_fn,
+                              t8_profile_region_hook_t end_fn,
+                              void *user_data)
+{
+  t8_profile_regions.begin_fn = begin_fn;
+  t8_profile_regions.end_fn = end_fn;
+  t8_profile_regions.hook_data = user_data;
+}
+
+void
+t8_profile_regions_set_memory (int do_memory)
+{
+  t8_profile_regions.do_memory = do_memory
+    && t8_profile_regions_memory_used () >= 0;
+}
+
+void
+t8_profile_regions_sample_memory (void)
+{
+  if (t8_profile_regions.do_memory) {
+    t8_profile_regions_memory_update (t8_profile_regions_memory_used ());
+  }
+}
+
+double
+t8_profile_regions_last_memory_peak (void)
+{
+  return t8_profile_regions.last_memory_peak;
+}
+
+/* Return true if all processes record the memory peaks */
+static int
+t8_profile_regions_do_memory_global (sc_MPI_Comm comm)
+{
+  int                 do_memory, mpiret;
+
+  do_memory = t8_profile_regions.do_memory;
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &do_memory, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return do_memory;
+}
+
+void
+t8_profile_regions_print_memory (sc_MPI_Comm comm, const char *prefix,
+                                 int num_phases,
+                                 const char *const *phase_names,
+                                 const double *peaks)
+{
+  sc_statinfo_t      *stats;
+  char               *names;
+  int                 iphase;
+
+  if (!t8_profile_regions_do_memory_global (comm)) {
+    return;
+  }
+  stats = T8_ALLOC (sc_statinfo_t, num_phases);
+  names = T8_ALLOC (char, num_phases * BUFSIZ);
+  for (iphase = 0; iphase < num_phases; iphase++) {
+    snprintf (names + iphase * BUFSIZ, BUFSIZ, "%s: %s peak heap bytes.",
+              prefix, phase_names[iphase]);
+    sc_stats_set1 (&stats[iphase], peaks[iphase], names + iphase * BUFSIZ);
+  }
+  sc_stats_compute (comm, num_phases, stats);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Printing memory peaks for %s.\n", prefix);
+  sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS, num_phases,
+                  stats, 1, 1);
+  T8_FREE (names);
+  T8_FREE (stats);
+}
+
+int
+t8_profile_regions_num_hw_counters (void)
+{
+  if (!t8_profile_regions.initialized) {
+    t8_profile_regions_init ();
+  }
+  return t8_profile_regions.num_hw;
+}
+
+const char         *
+t8_profile_regions_hw_counter_name (int icounter)
+{
+  T8_ASSERT (0 <= icounter && icounter < t8_profile_regions.num_hw);
+  return t8_profile_regions.hw_names[icounter];
+}
+
+void
+t8_profile_regions_last_hw_counters (double *values)
+{
+  int                 ihw;
+
+  for (ihw = 0; ihw < t8_profile_regions.num_hw; ihw++) {
+    values[ihw] = (double) t8_profile_regions.last_hw[ihw];
+  }
+}
+
+/* Return the number of hardware counters that all processes provide */
+static int
+t8_profile_regions_num_hw_counters_global (sc_MPI_Comm comm)
+{
+  int                 num_hw, mpiret;
+
+  num_hw = t8_profile_regions_num_hw_counters ();
+  mpiret = sc_MPI_Allreduce (sc_MPI_IN_PLACE, &num_hw, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return num_hw;
+}
+
+void
+t8_profile_regions_print_hw_counters (sc_MPI_Comm comm, const char *prefix,
+                                      int num_phases,
+                                      const char *const *phase_names,
+                                      const double *values)
+{
+  sc_statinfo_t      *stats;
+  char               *names;
+  int                 num_hw, iphase, ihw, istat;
+
+  num_hw = t8_profile_regions_num_hw_counters_global (comm);
+  if (num_hw == 0) {
+    return;
+  }
+  stats = T8_ALLOC (sc_statinfo_t, num_phases * num_hw);
+  names = T8_ALLOC (char, num_phases * num_hw * BUFSIZ);
+  for (iphase = 0, istat = 0; iphase < num_phases; iphase++) {
+    for (ihw = 0; ihw < num_hw; ihw++, istat++) {
+      snprintf (names + istat * BUFSIZ, BUFSIZ, "%s: %s %s.", prefix,
+                phase_names[iphase], t8_profile_regions.hw_names[ihw]);
+      sc_stats_set1 (&stats[istat],
+                     values[iphase * T8_PROFILE_REGIONS_MAX_HW_COUNTERS +
+                            ihw], names + istat * BUFSIZ);
+    }
+  }
+  sc_stats_compute (comm, num_phases * num_hw, stats);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Printing hardware counters for %s.\n", prefix);
+  sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS,
+                  num_phases * num_hw, stats, 1, 1);
+  T8_FREE (names);
+  T8_FREE (stats);
+}
+
+/* Find the node of a path of names separated by '/'.
+ * A counter is found if the last name is not a region.
+ * Return -1 if the path does not exist. */
+static int
+t8_profile_regions_find (const char *path)
+{
+  char                name[BUFSIZ];
+  const char         *next;
+  size_t              length;
+  int                 inode = 0, ichild;
+
+  if (!t8_profile_regions.initialized) {
+    return -1;
+  }
+  while (inode >= 0 && *path != '\0') {
+    next = strchr (path, '/');
+    length = next != NULL ? (size_t) (next - path) : strlen (path);
+    SC_CHECK_ABORT (length < BUFSIZ, "Region name too long");
+    memcpy (name, path, length);
+    name[length] = '\0';
+    ichild = t8_profile_regions_child (inode, name, 0, 0);
+    if (ichild < 0 && next == NULL) {
+      ichild = t8_profile_regions_child (inode, name, 1, 0);
+    }
+    inode = ichild;
+    path = next != NULL ? next + 1 : path + length;
+  }
+  return inode;
+}
+
+double
+t8_profile_regions_get_time (const char *path)
+{
+  int                 inode = t8_profile_regions_find (path);
+
+  if (inode < 0 || t8_profile_regions.nodes[inode].is_counter) {
+    return 0;
+  }
+  return t8_profile_regions.nodes[inode].ticks /
+    t8_profile_regions_ticks_per_second ();
+}
+
+/* Append the paths of the subtree of a node to a buffer, in depth first
+ * order, each terminated by '\0'. */
+static void
+t8_profile_regions_paths (int inode, char *prefix, sc_array_t * buffer)
+{
+  size_t              length = strlen (prefix), name_length;
+  int                 ichild;
+  char               *dest;
+
+  for (ichild = t8_profile_regions.nodes[inode].first_child; ichild >= 0;
+       ichild = t8_profile_regions.nodes[ichild].next_sibling) {
+    name_length = strlen (t8_profile_regions.nodes[ichild].name);
+    if (length + name_length + 2 >= BUFSIZ) {
+      continue;
+    }
+    if (length > 0) {
+      prefix[length] = '/';
+    }
+    strcpy (prefix + length + (length > 0),
+            t8_profile_regions.nodes[ichild].name);
+    dest = (char *) sc_array_push_count (buffer, strlen (prefix) + 1);
+    strcpy (dest, prefix);
+    t8_profile_regions_paths (ichild, prefix, buffer);
+    prefix[length] = '\0';
+  }
+}
+
+void
+t8_profile_regions_print (sc_MPI_Comm comm)
+{
+  sc_array_t          buffer;
+  sc_statinfo_t      *stats;
+  char                prefix[BUFSIZ];
+  const char         *path, *p;
+  int                 mpirank, mpiret, length, num_paths, ipath, inode;
+  int                 depth, num_hw, ihw, num_values, do_memory;
+  double              rate;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  num_hw = t8_profile_regions_num_hw_counters_global (comm);
+  do_memory = t8_profile_regions_do_memory_global (comm);
+  num_values = 1 + num_hw + do_memory;
+  rate = t8_profile_regions_ticks_per_second ();
+
+  /* The first process sends the paths of its regions to all others */
+  sc_array_init (&buffer, sizeof (char));
+  if (mpirank == 0 && t8_profile_regions.initialized) {
+    prefix[0] = '\0';
+    t8_profile_regions_paths (0, prefix, &buffer);
+  }
+  length = (int) buffer.elem_count;
+  mpiret = sc_MPI_Bcast (&length, 1, sc_MPI_INT, 0, comm);
+  SC_CHECK_MPI (mpiret);
+  sc_array_resize (&buffer, length);
+  mpiret = sc_MPI_Bcast (buffer.array, length, sc_MPI_CHAR, 0, comm);
+  SC_CHECK_MPI (mpiret);
+
+  for (num_paths = 0, ipath = 0; ipath < length; ipath++) {
+    num_paths += buffer.array[ipath] == '\0';
+  }
+  /* For each path the time or counter value, followed by the hardware
+   * counters */
+  stats = T8_ALLOC (sc_statinfo_t, SC_MAX (num_paths * num_values, 1));
+  for (path = buffer.array, ipath = 0; ipath < num_paths;
+       path += strlen (path) + 1, ipath++) {
+    inode = t8_profile_regions_find (path);
+    sc_stats_set1 (&stats[ipath * num_values], inode < 0 ? 0 :
+                   t8_profile_regions.nodes[inode].is_counter ?
+                   t8_profile_regions.nodes[inode].value :
+                   t8_profile_regions.nodes[inode].ticks / rate, path);
+    for (ihw = 0; ihw < num_hw; ihw++) {
+      sc_stats_set1 (&stats[ipath * num_values + 1 + ihw], inode < 0 ? 0 :
+                     (double) t8_profile_regions.nodes[inode].hw[ihw],
+                     t8_profile_regions.hw_names[ihw]);
+    }
+    if (do_memory) {
+      sc_stats_set1 (&stats[ipath * num_values + 1 + num_hw], inode < 0 ? 0 :
+                     t8_profile_regions.nodes[inode].memory_peak,
+                     "peak heap bytes");
+    }
+  }
+  sc_stats_compute (comm, num_paths * num_values, stats);
+
+  t8_global_productionf ("Profile regions: avg, min and max over processes"
+                         " of time in seconds or counter values\n");
+  /* The paths are those of the first process, which prints them */
+  if (mpirank == 0) {
+    for (path = buffer.array, ipath = 0; ipath < num_paths;
+         path += strlen (path) + 1, ipath++) {
+      for (depth = 0, p = path; *p != '\0'; p++) {
+        depth += *p == '/';
+      }
+      inode = t8_profile_regions_find (path);
+      t8_global_productionf ("%*s%-*s %10lld calls %.3e %.3e %.3e\n",
+                             2 * depth, "", 40 - 2 * depth,
+                             t8_profile_regions.nodes[inode].name,
+                             t8_profile_regions.nodes[inode].num_calls,
+                             stats[ipath * num_values].average,
+                             stats[ipath * num_values].min,
+                             stats[ipath * num_values].max);
+      if (t8_profile_regions.nodes[inode].is_counter) {
+        continue;
+      }
+      for (ihw = 0; ihw < num_hw; ihw++) {
+        t8_global_productionf ("%*s%-*s %16s %.3e %.3e %.3e\n",
+                               2 * depth + 2, "", 38 - 2 * depth,
+                               t8_profile_regions.hw_names[ihw], "",
+                               stats[ipath * num_values + 1 + ihw].average,
+                               stats[ipath * num_values + 1 + ihw].min,
+                               stats[ipath * num_values + 1 + ihw].max);
+      }
+      if (do_memory) {
+        t8_global_productionf ("%*s%-*s %16s %.3e %.3e %.3e\n",
+                               2 * depth + 2, "", 38 - 2 * depth,
+                               "peak heap bytes", "",
+                               stats[ipath * num_values + 1 + num_hw].average,
+                               stats[ipath * num_values + 1 + num_hw].min,
+                               stats[ipath * num_values + 1 + num_hw].max);
+      }
+    }
+  }
+  T8_FREE (stats);
+  sc_array_reset (&buffer);
+}
+
+int
+t8_profile_regions_write_chrome_trace (const char *prefix, sc_MPI_Comm comm)
+{
+  t8_profile_region_event_t *event;
+  char                filename[BUFSIZ];
+  FILE               *file;
+  size_t              ievent;
+  int                 mpirank, mpiret;
+  double              us_per_tick;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  snprintf (filename, BUFSIZ, "%s_%04d.json", prefix, mpirank);
+  file = fopen (filename, "w");
+  if (file == NULL) {
+    t8_errorf ("Could not open file %s for writing.\n", filename);
+    return 0;
+  }
+  us_per_tick = t8_profile_regions.initialized ?
+    1e6 / t8_profile_regions_ticks_per_second () : 0;
+  fprintf (file, "{\"traceEvents\": [\n");
+  for (ievent = 0; ievent < t8_profile_regions.num_events; ievent++) {
+    event = t8_profile_regions.events + ievent;
+    fprintf (file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, "
+             "\"tid\": 0, \"ts\": %.3f, \"dur\": %.3f}\n",
+             ievent > 0 ? "," : "",
+             t8_profile_regions.nodes[event->node].name, mpirank,
+             (event->begin - t8_profile_regions.first_ticks) * us_per_tick,
+             (event->end - event->begin) * us_per_tick);
+  }
+  fprintf (file, "], \"displayTimeUnit\": \"ms\"}\n");
+  fclose (file);
+  return 1;
+}
+
+void
+t8_profile_comm_sent (t8_profile_comm_t *phase, int num_messages,
+                      size_t num_bytes)
+{
+  if (phase != NULL) {
+    phase->bytes_sent += num_bytes;
+    phase->messages_sent += num_messages;
+    phase->peers_sent++;
+  }
+  t8_profile_region_count ("bytes_sent", num_bytes);
+  t8_profile_region_count ("messages_sent", num_messages);
+}
+
+void
+t8_profile_comm_received (t8_profile_comm_t *phase, int num_messages,
+                          size_t num_bytes)
+{
+  if (phase != NULL) {
+    phase->bytes_received += num_bytes;
+    phase->messages_received += num_messages;
+    phase->peers_received++;
+  }
+  t8_profile_region_count ("bytes_received", num_bytes);
+  t8_profile_region_count ("messages_received", num_messages);
+}
+
+void
+t8_profile_comm_add (t8_profile_comm_t *dest, const t8_profile_comm_t *src)
+{
+  dest->bytes_sent += src->bytes_sent;
+  dest->bytes_received += src->bytes_received;
+  dest->messages_sent += src->messages_sent;
+  dest->messages_received += src->messages_received;
+  dest->peers_sent += src->peers_sent;
+  dest->peers_received += src->peers_received;
+}
+
+/* Print a histogram of the values of all processes, one line per bin */
+static void
+t8_profile_comm_print_histogram (const char *prefix, const char *phase_name,
+                                 const double *values, int mpisize)
+{
+  int                 bins[T8_PROFILE_COMM_HISTOGRAM_BINS] = { 0 };
+  char                bar[41];
+  double              min, max, width;
+  int                 iproc, ibin, length;
+
+  min = max = values[0];
+  for (iproc = 1; iproc < mpisize; iproc++) {
+    min = SC_MIN (min, values[iproc]);
+    max = SC_MAX (max, values[iproc]);
+  }
+  width = (max - min) / T8_PROFILE_COMM_HISTOGRAM_BINS;
+  for (iproc = 0; iproc < mpisize; iproc++) {
+    ibin = width > 0 ? (int) ((values[iproc] - min) / width) : 0;
+    bins[SC_MIN (ibin, T8_PROFILE_COMM_HISTOGRAM_BINS - 1)]++;
+  }
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "%s: %s bytes sent and received per process:\n", prefix,
+           phase_name);
+  for (ibin = 0; ibin < T8_PROFILE_COMM_HISTOGRAM_BINS; ibin++) {
+    /* The bar of the largest possible bin has 40 characters */
+    length = (int) (40. * bins[ibin] / mpisize + .5);
+    memset (bar, '#', length);
+    bar[length] = '\0';
+    t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS, "   [%.3e, %.3e%c %8i %s\n",
+             min + ibin * width, min + (ibin + 1) * width,
+             ibin == T8_PROFILE_COMM_HISTOGRAM_BINS - 1 ? ']' : ')',
+             bins[ibin], bar);
+    if (width == 0) {
+      /* All processes are in the first bin */
+      break;
+    }
+  }
+}
+
+void
+t8_profile_comm_print (sc_MPI_Comm comm, const char *prefix, int num_phases,
+                       const char *const *phase_names,
+                       const t8_profile_comm_t *phases)
+{
+  /* The quantities that are printed for each phase */
+  const char         *quantity_names[6] = {
+    "bytes sent", "bytes received", "messages sent", "messages received",
+    "processes sent to", "processes received from"
+  };
+  sc_statinfo_t      *stats;
+  char               *names;
+  double             *volume, *all_volumes = NULL, value;
+  int                 iphase, iquantity, istat, mpirank, mpisize, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  stats = T8_ALLOC (sc_statinfo_t, 6 * num_phases);
+  names = T8_ALLOC (char, 6 * num_phases * BUFSIZ);
+  volume = T8_ALLOC (double, num_phases);
+  for (iphase = 0, istat = 0; iphase < num_phases; iphase++) {
+    for (iquantity = 0; iquantity < 6; iquantity++, istat++) {
+      switch (iquantity) {
+      case 0:
+        value = phases[iphase].bytes_sent;
+        break;
+      case 1:
+        value = phases[iphase].bytes_received;
+        break;
+      case 2:
+        value = phases[iphase].messages_sent;
+        break;
+      case 3:
+        value = phases[iphase].messages_received;
+        break;
+      case 4:
+        value = phases[iphase].peers_sent;
+        break;
+      default:
+        value = phases[iphase].peers_received;
+      }
+      snprintf (names + istat * BUFSIZ, BUFSIZ, "%s: %s %s.", prefix,
+                phase_names[iphase], quantity_names[iquantity]);
+      sc_stats_set1 (&stats[istat], value, names + istat * BUFSIZ);
+    }
+    volume[iphase] = phases[iphase].bytes_sent
+      + phases[iphase].bytes_received;
+  }
+  sc_stats_compute (comm, 6 * num_phases, stats);
+  t8_logf (SC_LC_GLOBAL, SC_LP_STATISTICS,
+           "Printing communication for %s.\n", prefix);
+  sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS, 6 * num_phases,
+                  stats, 1, 1);
+
+  /* The first process collects the volume of each process per phase */
+  if (mpirank == 0) {
+    all_volumes = T8_ALLOC (double, num_phases * mpisize);
+  }
+  mpiret = sc_MPI_Gather (volume, num_phases, sc_MPI_DOUBLE, all_volumes,
+                          num_phases, sc_MPI_DOUBLE, 0, comm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    double             *phase_volumes = T8_ALLOC (double, mpisize);
+    int                 iproc;
+
+    for (iphase = 0; iphase < num_phases; iphase++) {
+      for (iproc = 0; iproc < mpisize; iproc++) {
+        phase_volumes[iproc] = all_volumes[iproc * num_phases + iphase];
+      }
+      t8_profile_comm_print_histogram (prefix, phase_names[iphase],
+                                       phase_volumes, mpisize);
+    }
+    T8_FREE (phase_volumes);
+    T8_FREE (all_volumes);
+  }
+  T8_FREE (volume);
+  T8_FREE (names);
+  T8_FREE (stats);
+}
+
+void
+t8_profile_regions_reset (void)
+{
+  T8_ASSERT (!t8_profile_regions.initialized
+             || t8_profile_regions.depth == 1);
+  free (t8_profile_regions.nodes);
+  free (t8_profile_regions.events);
+  t8_profile_regions.nodes = NULL;
+  t8_profile_regions.events = NULL;
+  t8_profile_regions.num_nodes = t8_profile_regions.alloc_nodes = 0;
+  t8_profile_regions.num_events = t8_profile_regions.alloc_events = 0;
+  t8_profile_regions.initialized = 0;
+}
@@ -0,0 +1,286 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_profile_regions.h
+ * Nested timer regions that are recorded for the major algorithms of
+ * t8code, such as forest commit, adapt, balance, partition, ghost, cmesh
+ * commit, load and vtk output.
+ *
+ * Each process records a tree of regions. A region is identified by its
+ * name and its parent region and stores the number of calls, the total time
+ * and the minimum and maximum time per call. Counters, for example a number
+ * of sent bytes, are stored in the region in which they are added.
+ * Times are read from the time stamp counter where available, so entering
+ * and leaving a region costs a few tens of nanoseconds; the regions are
+ * thus always recorded.
+ * Optionally, each call is also stored as an event, so that a timeline can
+ * be written in the Chrome trace format, and begin and end hooks forward the
+ * regions to tools such as Score-P or Caliper.
+ * If t8code is configured with --with-papi or --enable-perf-event, each
+ * region also accumulates hardware counters: instructions, cycles, and
+ * L1 data and last level cache misses, as far as the hardware provides them.
+ * Reading the counters costs about a microsecond with perf_event, so the
+ * regions should enclose whole phases of an algorithm.
+ * After \ref t8_profile_regions_set_memory, each region also records the
+ * peak of the allocated heap memory while it was active, as reported by the
+ * C library. The heap is sampled when a region is entered or left and on
+ * \ref t8_profile_regions_sample_memory, so the peak is a lower bound.
+ * The regions are not thread safe.
+ */
+
+#ifndef T8_PROFILE_REGIONS_H
+#define T8_PROFILE_REGIONS_H
+
+#include <t8.h>
+
+/** The maximum number of hardware counters of a region. */
+#define T8_PROFILE_REGIONS_MAX_HW_COUNTERS 4
+
+/** Callback function prototype that is called when a region is entered
+ * or left. \see t8_profile_regions_set_hooks
+ * \param [in] name       The name of the region.
+ * \param [in] user_data  The user data passed to \ref t8_profile_regions_set_hooks.
+ */
+typedef void        (*t8_profile_region_hook_t) (const char *name,
+                                                 void *user_data);
+
+/** The communication of one phase of an algorithm on one process.
+ * A message to or from the process itself is not counted.
+ * For a broadcast, the root counts the payload once as sent to all other
+ * processes and each other process counts it as received from the root.
+ * \see t8_profile_comm_sent, t8_profile_comm_received, t8_profile_comm_print
+ */
+typedef struct t8_profile_comm
+{
+  double              bytes_sent;       /**< The number of bytes sent. */
+  double              bytes_received;   /**< The number of bytes received. */
+  int                 messages_sent;    /**< The number of messages sent. */
+  int                 messages_received; /**< The number of messages received. */
+  int                 peers_sent;       /**< The number of processes sent to. */
+  int                 peers_received;   /**< The number of processes received from. */
+}
+t8_profile_comm_t;
+
+/** The number of bins of the histograms of \ref t8_profile_comm_print. */
+#define T8_PROFILE_COMM_HISTOGRAM_BINS 8
+
+T8_EXTERN_C_BEGIN ();
+
+/** Enter a region. Regions that are entered while another region is active
+ * are its children.
+ * \param [in] name       The name of the region. The string is not copied and
+ *                        must stay valid, string literals are recommended.
+ */
+void                t8_profile_region_begin (const char *name);
+
+/** Leave the region that was entered last.
+ * \param [in] name       The name of the region. It must equal the name
+ *                        passed to the matching \ref t8_profile_region_begin.
+ */
+void                t8_profile_region_end (const char *name);
+
+/** Add a value to a counter of the active region.
+ * \param [in] name       The name of the counter. The string is not copied.
+ * \param [in] value      The value that is added.
+ */
+void                t8_profile_region_count (const char *name, double value);
+
+/** Set whether each call of a region is stored as an event, as needed by
+ * \ref t8_profile_regions_write_chrome_trace. Each event uses 24 bytes.
+ * By default, only the accumulated times of the regions are stored.
+ * \param [in] do_trace   If true, store the events.
+ */
+void                t8_profile_regions_set_trace (int do_trace);
+
+/** Set callbacks that are called when a region is entered or left, for
+ * example to forward the regions to SCOREP_USER_REGION_BY_NAME_BEGIN or
+ * cali_begin_region.
+ * \param [in] begin_fn   Called on \ref t8_profile_region_begin. May be NULL.
+ * \param [in] end_fn     Called on \ref t8_profile_region_end. May be NULL.
+ * \param [in] user_data  Passed to \a begin_fn and \a end_fn.
+ */
+void                t8_profile_regions_set_hooks (t8_profile_region_hook_t
+                                                  begin_fn,
+                                                  t8_profile_region_hook_t
+                                                  end_fn, void *user_data);
+
+/** Set whether the regions record the peak of the allocated heap memory.
+ * Sampling the heap walks the lists of the allocator and may take some
+ * microseconds, so it is disabled by default.
+ * It is enabled by \ref t8_forest_set_profiling and \ref t8_cmesh_set_profiling.
+ * \param [in] do_memory  If true, record the memory peaks. Has no effect if
+ *                        the C library does not provide mallinfo2.
+ */
+void                t8_profile_regions_set_memory (int do_memory);
+
+/** Sample the allocated heap memory and update the peaks of all active
+ * regions. Call this where an algorithm holds the most memory, for example
+ * before freeing a temporary forest.
+ */
+void                t8_profile_regions_sample_memory (void);
+
+/** Return the peak heap memory of the last call of the region that was
+ * left last, to attribute it to a profile struct.
+ * \return               The peak in bytes, 0 if the peaks are not recorded.
+ */
+double              t8_profile_regions_last_memory_peak (void);
+
+/** Print the minimum, average and maximum over all processes of the memory
+ * peaks that were stored for the phases of an algorithm.
+ * Nothing is printed if some process does not record the memory peaks.
+ * \param [in] comm       The communicator of all processes.
+ * \param [in] prefix     The name of the algorithm, for example "forest".
+ * \param [in] num_phases The number of phases.
+ * \param [in] phase_names The names of the phases.
+ * \param [in] peaks      For each phase the peak in bytes, as returned by
+ *                        \ref t8_profile_regions_last_memory_peak.
+ * \note This function is collective.
+ */
+void                t8_profile_regions_print_memory (sc_MPI_Comm comm,
+                                                     const char *prefix,
+                                                     int num_phases,
+                                                     const char *const
+                                                     *phase_names,
+                                                     const double *peaks);
+
+/** Return the number of hardware counters that are recorded for each region.
+ * \return               0 if t8code was configured without a counter library
+ *                        or the counters could not be opened, otherwise at
+ *                        most \ref T8_PROFILE_REGIONS_MAX_HW_COUNTERS.
+ */
+int                 t8_profile_regions_num_hw_counters (void);
+
+/** Return the name of a hardware counter.
+ * \param [in] icounter   The index of a counter,
+ *                        smaller than \ref t8_profile_regions_num_hw_counters.
+ * \return                The name, for example "instructions".
+ */
+const char         *t8_profile_regions_hw_counter_name (int icounter);
+
+/** Return the hardware counters of the last call of the region that was left
+ * last, to attribute them to a profile struct.
+ * \param [out] values    The first \ref t8_profile_regions_num_hw_counters
+ *                        entries are set to the counts.
+ */
+void                t8_profile_regions_last_hw_counters (double *values);
+
+/** Print the minimum, average and maximum over all processes of hardware
+ * counters that were stored for the phases of an algorithm.
+ * Nothing is printed if some process records no hardware counters.
+ * \param [in] comm       The communicator of all processes.
+ * \param [in] prefix     The name of the algorithm, for example "forest".
+ * \param [in] num_phases The number of phases.
+ * \param [in] phase_names The names of the phases.
+ * \param [in] values     For each phase \ref T8_PROFILE_REGIONS_MAX_HW_COUNTERS
+ *                        entries, as filled by \ref t8_profile_regions_last_hw_counters.
+ * \note This function is collective.
+ */
+void                t8_profile_regions_print_hw_counters (sc_MPI_Comm comm,
+                                                          const char *prefix,
+                                                          int num_phases,
+                                                          const char *const
+                                                          *phase_names,
+                                                          const double
+                                                          *values);
+
+/** Return the total time spent in a region.
+ * \param [in] path       The names of the region and its ancestors, separated
+ *                        by '/', for example "forest_commit/adapt".
+ * \return                The total time in seconds, 0 if the region
+ *                        was not entered.
+ */
+double              t8_profile_regions_get_time (const char *path);
+
+/** Print the regions of the first process and the minimum, average and
+ * maximum of their times, hardware counters and memory peaks over all
+ * processes. Regions that do not exist on all processes are counted with
+ * zero time.
+ * \param [in] comm       The communicator of all processes that record regions.
+ * \note This function is collective.
+ */
+void                t8_profile_regions_print (sc_MPI_Comm comm);
+
+/** Write the events of each process as a file in the Chrome trace format,
+ * that can be viewed with chrome://tracing or Perfetto.
+ * Process p writes the file \a prefix_p.json. The events are only recorded
+ * after \ref t8_profile_regions_set_trace was called with true.
+ * \param [in] prefix     The prefix of the file names.
+ * \param [in] comm       The communicator, used for the process numbers.
+ * \return                True if the file was written, false otherwise.
+ */
+int                 t8_profile_regions_write_chrome_trace (const char *prefix,
+                                                           sc_MPI_Comm comm);
+
+/** Count the messages that were sent to one other process.
+ * The bytes and messages are also added to the counters "bytes_sent" and
+ * "messages_sent" of the active region.
+ * \param [in,out] phase       The communication of the current phase.
+ *                             If NULL, only the region counters are updated.
+ * \param [in]     num_messages The number of messages sent to the process.
+ * \param [in]     num_bytes   The number of bytes in these messages.
+ */
+void                t8_profile_comm_sent (t8_profile_comm_t *phase,
+                                          int num_messages,
+                                          size_t num_bytes);
+
+/** Count the messages that were received from one other process.
+ * The bytes and messages are also added to the counters "bytes_received"
+ * and "messages_received" of the active region.
+ * \param [in,out] phase       The communication of the current phase.
+ *                             If NULL, only the region counters are updated.
+ * \param [in]     num_messages The number of messages received from the process.
+ * \param [in]     num_bytes   The number of bytes in these messages.
+ */
+void                t8_profile_comm_received (t8_profile_comm_t *phase,
+                                              int num_messages,
+                                              size_t num_bytes);
+
+/** Add the communication of one phase to another.
+ * \param [in,out] dest        Is increased by \a src.
+ * \param [in]     src         The communication that is added.
+ */
+void                t8_profile_comm_add (t8_profile_comm_t *dest,
+                                         const t8_profile_comm_t *src);
+
+/** Print the minimum, average and maximum over all processes of the
+ * communication of the phases of an algorithm, followed by a histogram of
+ * the bytes sent and received per process for each phase.
+ * \param [in] comm       The communicator of all processes.
+ * \param [in] prefix     The name of the algorithm, for example "forest".
+ * \param [in] num_phases The number of phases.
+ * \param [in] phase_names The names of the phases.
+ * \param [in] phases     The communication of each phase on this process.
+ * \note This function is collective.
+ */
+void                t8_profile_comm_print (sc_MPI_Comm comm,
+                                           const char *prefix,
+                                           int num_phases,
+                                           const char *const *phase_names,
+                                           const t8_profile_comm_t *phases);
+
+/** Clear all regions, counters and events. No region may be active.
+ */
+void                t8_profile_regions_reset (void);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_PROFILE_REGIONS_H */
@@ -22,95 +22,63 @@
 
 #include <t8_vec.h>
 
-double
-t8_vec_norm (const double vec[3])
-{
-  int                 i;
-  double              norm = 0;
-
-  for (i = 0; i < 3; i++) {
-    norm += vec[i] * vec[i];
-  }
-  return sqrt (norm);
-}
-
-double
-t8_vec_dist (const double vec_x[3], const double vec_y[3])
-{
-  int                 i;
-  double              dist = 0;
-
-  for (i = 0; i < 3; i++) {
-    dist += SC_SQR (vec_x[i] - vec_y[i]);
-  }
-  return sqrt (dist);
-}
+/* The batched routines loop over the vectors with the component as the
+ * outer loop, such that each inner loop runs over contiguous memory. */
 
 void
-t8_vec_ax (double vec_x[3], double alpha)
+t8_vec_norm_n (size_t n, const double *vec, double *norm)
 {
-  int                 i;
+  size_t              i;
 
-  for (i = 0; i < 3; i++) {
-    vec_x[i] *= alpha;
+  for (i = 0; i < n; i++) {
+    norm[i] = vec[i] * vec[i];
   }
-}
-
-/* y = ax + b */
-void
-t8_vec_axb (const double vec_x[3], double vec_y[3], double alpha, double b)
-{
-  int                 i;
-
-  for (i = 0; i < 3; i++) {
-    vec_y[i] = alpha * vec_x[i] + b;
+  for (i = 0; i < n; i++) {
+    norm[i] += vec[n + i] * vec[n + i];
+  }
+  for (i = 0; i < n; i++) {
+    norm[i] = sqrt (norm[i] + vec[2 * n + i] * vec[2 * n + i]);
   }
 }
 
-/* y = y + alpha * x */
 void
-t8_vec_axpy (const double vec_x[3], double vec_y[3], double alpha)
+t8_vec_axpy_n (size_t n, const double *vec_x, double *vec_y, double alpha)
 {
-  int                 i;
+  size_t              i;
 
-  for (i = 0; i < 3; i++) {
+  for (i = 0; i < 3 * n; i++) {
     vec_y[i] += alpha * vec_x[i];
   }
 }
 
-/* z = y + alpha * x */
 void
-t8_vec_axpyz (const double vec_x[3], const double vec_y[3], double vec_z[3],
-              double alpha)
+t8_vec_dot_n (size_t n, const double *vec_x, const double *vec_y,
+              double *dot)
 {
+  size_t              i;
 
-  int                 i;
-
-  for (i = 0; i < 3; i++) {
-    vec_z[i] = vec_y[i] + alpha * vec_x[i];
+  for (i = 0; i < n; i++) {
+    dot[i] = vec_x[i] * vec_y[i];
   }
-}
-
-double
-t8_vec_dot (const double vec_x[3], const double vec_y[3])
-{
-  int                 i;
-  double              dot = 0;
-
-  for (i = 0; i < 3; i++) {
-    dot += vec_x[i] * vec_y[i];
+  for (i = n; i < 2 * n; i++) {
+    dot[i - n] += vec_x[i] * vec_y[i];
+  }
+  for (i = 2 * n; i < 3 * n; i++) {
+    dot[i - 2 * n] += vec_x[i] * vec_y[i];
   }
-  return dot;
 }
 
 void
-t8_vec_cross (const double vec_x[3], const double vec_y[3], double cross[3])
+t8_vec_cross_n (size_t n, const double *vec_x, const double *vec_y,
+                double *cross)
 {
-  int                 i;
-
-  for (i = 0; i < 3; i++) {
-    cross[i] =
-      vec_x[(i + 1) % 3] * vec_y[(i + 2) % 3] -
-      vec_x[(i + 2) % 3] * vec_y[(i + 1) % 3];
+  const double       *x0 = vec_x, *x1 = vec_x + n, *x2 = vec_x + 2 * n;
+  const double       *y0 = vec_y, *y1 = vec_y + n, *y2 = vec_y + 2 * n;
+  size_t              i;
+
+  for (i = 0; i < n; i++) {
+    cross[i] = x1[i] * y2[i] - x2[i] * y1[i];
+    cross[n + i] = x2[i] * y0[i] - x0[i] * y2[i];
+    cross[2 * n + i] = x0[i] * y1[i] - x1[i] * y0[i];
   }
 }
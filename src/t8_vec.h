@@ -22,6 +22,11 @@
 
 /** \file t8_vec.h
  * We define routines to handle 3-dimensional vectors.
+ * The routines on single vectors are inline, such that they can be
+ * optimized within the loops that call them.
+ * The routines with the suffix _n operate on n vectors at once. These vectors
+ * are stored by component: an array of n vectors starts with the n x
+ * components, followed by the n y and the n z components.
  */
 
 #ifndef T8_VEC_H
@@ -35,7 +40,11 @@ T8_EXTERN_C_BEGIN ();
  * \param [in] vec  A 3D vector.
  * \return          The norm of \a vec.
  */
-double              t8_vec_norm (const double vec[3]);
+static inline double
+t8_vec_norm (const double vec[3])
+{
+  return sqrt (vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]);
+}
 
 /** Euclidean distance of X and Y.
  * \param [in]  vec_x  A 3D vector.
@@ -43,14 +52,24 @@ double              t8_vec_norm (const double vec[3]);
  * \return             The euclidean distance.
  *                     Equivalent to norm (X-Y).
  */
-double              t8_vec_dist (const double vec_x[3],
-                                 const double vec_y[3]);
+static inline double
+t8_vec_dist (const double vec_x[3], const double vec_y[3])
+{
+  return sqrt (SC_SQR (vec_x[0] - vec_y[0]) + SC_SQR (vec_x[1] - vec_y[1])
+               + SC_SQR (vec_x[2] - vec_y[2]));
+}
 
 /** Compute X = alpha * X
  * \param [in,out] vec_x  A 3D vector. On output set to \a alpha * \a vec_x.
  * \param [in]     alpha  A factor.
  */
-void                t8_vec_ax (double vec_x[3], double alpha);
+static inline void
+t8_vec_ax (double vec_x[3], double alpha)
+{
+  vec_x[0] *= alpha;
+  vec_x[1] *= alpha;
+  vec_x[2] *= alpha;
+}
 
 /** Y = alpha * X + b
  * \param [in]  vec_x  A 3D vector.
@@ -60,8 +79,13 @@ void                t8_vec_ax (double vec_x[3], double alpha);
  * \param [in]  b      An offset.
  * \note It is possible that vec_x = vec_y on input to overwrite x
  */
-void                t8_vec_axb (const double vec_x[3], double vec_y[3],
-                                double alpha, double b);
+static inline void
+t8_vec_axb (const double vec_x[3], double vec_y[3], double alpha, double b)
+{
+  vec_y[0] = alpha * vec_x[0] + b;
+  vec_y[1] = alpha * vec_x[1] + b;
+  vec_y[2] = alpha * vec_x[2] + b;
+}
 
 /** Y = Y + alpha * X
  * \param [in]  vec_x  A 3D vector.
@@ -69,32 +93,89 @@ void                t8_vec_axb (const double vec_x[3], double vec_y[3],
  *                      On output set \a to vec_y + \a alpha * \a vec_x
  * \param [in]  alpha  A factor.
  */
-void                t8_vec_axpy (const double vec_x[3], double vec_y[3],
-                                 double alpha);
+static inline void
+t8_vec_axpy (const double vec_x[3], double vec_y[3], double alpha)
+{
+  vec_y[0] += alpha * vec_x[0];
+  vec_y[1] += alpha * vec_x[1];
+  vec_y[2] += alpha * vec_x[2];
+}
 
 /** Z = Y + alpha * X
  * \param [in]  vec_x  A 3D vector.
  * \param [in]  vec_y  A 3D vector.
  * \param [out] vec_z  On output set \a to vec_y + \a alpha * \a vec_x
  */
-void                t8_vec_axpyz (const double vec_x[3],
-                                  const double vec_y[3], double vec_z[3],
-                                  double alpha);
+static inline void
+t8_vec_axpyz (const double vec_x[3], const double vec_y[3], double vec_z[3],
+              double alpha)
+{
+  vec_z[0] = vec_y[0] + alpha * vec_x[0];
+  vec_z[1] = vec_y[1] + alpha * vec_x[1];
+  vec_z[2] = vec_y[2] + alpha * vec_x[2];
+}
 
 /** Dot product of X and Y.
  * \param [in]  vec_x  A 3D vector.
  * \param [in]  vec_y  A 3D vector.
  * \return             The dot product \a vec_x * \a vec_y
  */
-double              t8_vec_dot (const double vec_x[3], const double vec_y[3]);
+static inline double
+t8_vec_dot (const double vec_x[3], const double vec_y[3])
+{
+  return vec_x[0] * vec_y[0] + vec_x[1] * vec_y[1] + vec_x[2] * vec_y[2];
+}
 
 /** Cross product of X and Y
  * \param [in]  vec_x  A 3D vector.
  * \param [in]  vec_y  A 3D vector.
  * \param [out] cross  On output, the cross product of \a vec_x and \a vec_y.
+ *                     Must not coincide with \a vec_x or \a vec_y.
  */
-void                t8_vec_cross (const double vec_x[3],
-                                  const double vec_y[3], double cross[3]);
+static inline void
+t8_vec_cross (const double vec_x[3], const double vec_y[3], double cross[3])
+{
+  cross[0] = vec_x[1] * vec_y[2] - vec_x[2] * vec_y[1];
+  cross[1] = vec_x[2] * vec_y[0] - vec_x[0] * vec_y[2];
+  cross[2] = vec_x[0] * vec_y[1] - vec_x[1] * vec_y[0];
+}
+
+/** Compute the norms of n vectors.
+ * \param [in]  n      The number of vectors.
+ * \param [in]  vec    The n vectors, stored by component.
+ * \param [out] norm   On output the n norms.
+ */
+void                t8_vec_norm_n (size_t n, const double *vec,
+                                   double *norm);
+
+/** Y = Y + alpha * X for n vectors.
+ * \param [in]  n      The number of vectors.
+ * \param [in]  vec_x  The n vectors X, stored by component.
+ * \param [in,out] vec_y The n vectors Y, stored by component.
+ *                     On output set to \a vec_y + \a alpha * \a vec_x.
+ * \param [in]  alpha  A factor.
+ */
+void                t8_vec_axpy_n (size_t n, const double *vec_x,
+                                   double *vec_y, double alpha);
+
+/** Dot products of n pairs of vectors.
+ * \param [in]  n      The number of vectors.
+ * \param [in]  vec_x  The n vectors X, stored by component.
+ * \param [in]  vec_y  The n vectors Y, stored by component.
+ * \param [out] dot    On output dot[i] is the dot product of X_i and Y_i.
+ */
+void                t8_vec_dot_n (size_t n, const double *vec_x,
+                                  const double *vec_y, double *dot);
+
+/** Cross products of n pairs of vectors.
+ * \param [in]  n      The number of vectors.
+ * \param [in]  vec_x  The n vectors X, stored by component.
+ * \param [in]  vec_y  The n vectors Y, stored by component.
+ * \param [out] cross  On output the n cross products X_i x Y_i, stored by
+ *                     component. Must not overlap \a vec_x or \a vec_y.
+ */
+void                t8_vec_cross_n (size_t n, const double *vec_x,
+                                    const double *vec_y, double *cross);
 
 T8_EXTERN_C_END ();
 
@@ -22,6 +22,42 @@
 
 #include <t8_vtk.h>
 
+sc_MPI_Comm
+t8_vtk_node_comm (sc_MPI_Comm comm, int *node, int *num_nodes)
+{
+  sc_MPI_Comm         intranode = sc_MPI_COMM_NULL;
+  sc_MPI_Comm         internode = sc_MPI_COMM_NULL;
+  int                 node_info[2], mpiret;
+
+#ifdef SC_ENABLE_MPICOMMSHARED
+  sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    sc_mpi_comm_attach_node_comms (comm, 0);
+    sc_mpi_comm_get_node_comms (comm, &intranode, &internode);
+  }
+#endif
+  if (intranode == sc_MPI_COMM_NULL || internode == sc_MPI_COMM_NULL) {
+    /* Each process is its own node */
+    mpiret = sc_MPI_Comm_rank (comm, node);
+    SC_CHECK_MPI (mpiret);
+    mpiret = sc_MPI_Comm_size (comm, num_nodes);
+    SC_CHECK_MPI (mpiret);
+    return sc_MPI_COMM_SELF;
+  }
+  /* The internode communicator of the first process of each node
+   * connects all nodes. The other processes get the node index
+   * and count from it, since nodes may have different sizes. */
+  mpiret = sc_MPI_Comm_rank (internode, &node_info[0]);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (internode, &node_info[1]);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Bcast (node_info, 2, sc_MPI_INT, 0, intranode);
+  SC_CHECK_MPI (mpiret);
+  *node = node_info[0];
+  *num_nodes = node_info[1];
+  return intranode;
+}
+
 /* Writes the pvtu header file that links to the processor local files.
  * This function should only be called by one process.
  * Return 0 on success. */
@@ -29,6 +65,17 @@ int
 t8_write_pvtu (const char *filename, int num_procs, int write_tree,
                int write_rank, int write_level, int write_id, int num_data,
                t8_vtk_data_field_t * data)
+{
+  return t8_write_pvtu_float_type (filename, num_procs, write_tree,
+                                   write_rank, write_level, write_id,
+                                   num_data, data, T8_VTK_FLOAT_NAME);
+}
+
+int
+t8_write_pvtu_float_type (const char *filename, int num_procs,
+                          int write_tree, int write_rank, int write_level,
+                          int write_id, int num_data,
+                          t8_vtk_data_field_t * data, const char *float_name)
 {
   char                pvtufilename[BUFSIZ], filename_cpy[BUFSIZ];
   FILE               *pvtufile;
@@ -59,7 +106,7 @@ t8_write_pvtu (const char *filename, int num_procs, int write_tree,
   fprintf (pvtufile, "    <PPoints>\n");
   fprintf (pvtufile, "      <PDataArray type=\"%s\" Name=\"Position\""
            " NumberOfComponents=\"3\" format=\"%s\"/>\n",
-           T8_VTK_FLOAT_NAME, T8_VTK_FORMAT_STRING);
+           float_name, T8_VTK_FORMAT_STRING);
   fprintf (pvtufile, "    </PPoints>\n");
 
   if (num_data > 0) {
@@ -109,7 +156,7 @@ t8_write_pvtu (const char *filename, int num_procs, int write_tree,
         fprintf (pvtufile,
                  "      "
                  "<PDataArray type=\"%s\" Name=\"%s\" format=\"%s\"/>\n",
-                 T8_VTK_FLOAT_NAME, description, T8_VTK_FORMAT_STRING);
+                 float_name, description, T8_VTK_FORMAT_STRING);
       }
 
       /* Write vector data fields */
@@ -120,7 +167,7 @@ t8_write_pvtu (const char *filename, int num_procs, int write_tree,
         fprintf (pvtufile,
                  "      "
                  "<PDataArray type=\"%s\" Name=\"%s\" NumberOfComponents=\"3\" "
-                 "format=\"%s\"/>\n", T8_VTK_FLOAT_NAME, description,
+                 "format=\"%s\"/>\n", float_name, description,
                  T8_VTK_FORMAT_STRING);
       }
       fprintf (pvtufile, "    </PPointData>\n");
@@ -206,7 +253,7 @@ t8_write_pvtu (const char *filename, int num_procs, int write_tree,
   for (idata = 0; idata < num_scalars; idata++) {
     fprintf (pvtufile, "      "
              "<PDataArray type=\"%s\" Name=\"%s\" format=\"%s\"/>\n",
-             T8_VTK_FLOAT_NAME, data[idata].description,
+             float_name, data[idata].description,
              T8_VTK_FORMAT_STRING);
   }
 
@@ -216,7 +263,7 @@ t8_write_pvtu (const char *filename, int num_procs, int write_tree,
     fprintf (pvtufile, "      "
              "<PDataArray type=\"%s\" Name=\"%s\" NumberOfComponents=\"3\" "
              "format=\"%s\"/>\n",
-             T8_VTK_FLOAT_NAME, data[idata].description,
+             float_name, data[idata].description,
              T8_VTK_FORMAT_STRING);
   }
   if (wrote_cell_data) {
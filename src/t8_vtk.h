@@ -56,6 +56,18 @@
 #define T8_VTK_FORMAT_STRING "binary"
 #endif
 
+/** The formats in which the forest vtk output writes its data arrays.
+ * \see t8_forest_vtk_write_file_format */
+typedef enum
+{
+  T8_VTK_FORMAT_ASCII,          /**< Each value is printed as text. */
+  T8_VTK_FORMAT_BINARY,         /**< Each array is base64 encoded inside its DataArray. */
+  T8_VTK_FORMAT_COMPRESSED,     /**< As binary, but each array is compressed with zlib.
+                                     Falls back to binary if t8code is built without zlib. */
+  T8_VTK_FORMAT_APPENDED        /**< All arrays are written raw into one block
+                                     at the end of the file. */
+} t8_vtk_format_t;
+
 typedef enum
 {
   T8_VTK_SCALAR,                /* One double value per element */
@@ -84,6 +96,27 @@ int                 t8_write_pvtu (const char *filename, int num_procs,
                                    int write_level, int write_id,
                                    int num_data, t8_vtk_data_field_t * data);
 
+/* As t8_write_pvtu, but the floating point data arrays have the vtk
+ * type float_name, "Float32" or "Float64".
+ * Return 0 on success. */
+int                 t8_write_pvtu_float_type (const char *filename,
+                                              int num_procs, int write_tree,
+                                              int write_rank,
+                                              int write_level, int write_id,
+                                              int num_data,
+                                              t8_vtk_data_field_t * data,
+                                              const char *float_name);
+
+/* Return the communicator of the processes on the same shared memory node
+ * as this process, for the output of one file per node.
+ * The node communicators of comm are attached if necessary.
+ * On output node is the index of our node and num_nodes the number of
+ * nodes. The node of process 0 of comm has index 0. If sc cannot
+ * compute node communicators, each process is its own node.
+ * This function is collective. */
+sc_MPI_Comm         t8_vtk_node_comm (sc_MPI_Comm comm, int *node,
+                                      int *num_nodes);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_VTK_H */
@@ -0,0 +1,326 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This program checks the performance of a fixed set of forest kernels.
+ * Each kernel runs on a fixed hexahedral mesh of a fixed size and is
+ * repeated several times; the fastest repetition is taken as its runtime,
+ * where the runtime of a repetition is the maximum over all processes.
+ * With -w the runtimes are written to a baseline file. With -b the runtimes
+ * are compared to a baseline file and the program fails if a kernel is
+ * slower than its baseline time by more than the tolerance -t.
+ * It is not part of the regular tests since runtimes depend on the machine,
+ * but it is called by 'make perfcheck'.
+ */
+
+#include <sc_options.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_cmesh.h>
+
+/* The checked kernels */
+typedef enum
+{
+  T8_PERFCHECK_NEW_UNIFORM = 0,
+  T8_PERFCHECK_ADAPT,
+  T8_PERFCHECK_BALANCE,
+  T8_PERFCHECK_GHOST,
+  T8_PERFCHECK_GHOST_EXCHANGE,
+  T8_PERFCHECK_FACE_NEIGHBORS,
+  T8_PERFCHECK_VTK,
+  T8_PERFCHECK_NUM_KERNELS
+} t8_perfcheck_kernel_t;
+
+static const char  *t8_perfcheck_kernel_names[T8_PERFCHECK_NUM_KERNELS] = {
+  "new_uniform",
+  "adapt",
+  "balance",
+  "ghost",
+  "ghost_exchange",
+  "leaf_face_neighbors",
+  "vtk"
+};
+
+/* Refine every second element once */
+static int
+t8_perfcheck_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                    t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                    t8_eclass_scheme_c * ts, int num_elements,
+                    t8_element_t * elements[])
+{
+  int                 level, maxlevel;
+
+  level = ts->t8_element_level (elements[0]);
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  if (level < maxlevel
+      && ts->t8_element_get_linear_id (elements[0], level) % 2) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Compute the face neighbors of all leaves of a forest */
+static void
+t8_perfcheck_face_neighbors (t8_forest_t forest)
+{
+  t8_locidx_t         ielem, ltree, *element_indices;
+  t8_element_t       *leaf, **neighbor_leafs;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  int                 iface, num_neighbors;
+  int                *dual_faces;
+
+  for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
+    leaf = t8_forest_get_element (forest, ielem, &ltree);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    for (iface = 0; iface < ts->t8_element_num_faces (leaf); iface++) {
+      t8_forest_leaf_face_neighbors (forest, ltree, leaf, &neighbor_leafs,
+                                     iface, &dual_faces, &num_neighbors,
+                                     &element_indices, &neigh_scheme, 1);
+      if (num_neighbors > 0) {
+        neigh_scheme->t8_element_destroy (num_neighbors, neighbor_leafs);
+        T8_FREE (element_indices);
+        T8_FREE (neighbor_leafs);
+        T8_FREE (dual_faces);
+      }
+    }
+  }
+}
+
+/* Run all kernels once and add the runtime of each kernel on this
+ * process to times. */
+static void
+t8_perfcheck_run (sc_MPI_Comm comm, int level, int num_exchanges,
+                  double *times)
+{
+  t8_cmesh_t          cmesh;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_t         forest, forest_adapt, forest_balance, forest_ghost;
+  sc_array_t          element_data;
+  double              start;
+  int                 maxlevel = level + 1, iexchange;
+
+  cmesh = t8_cmesh_new_hypercube (T8_ECLASS_HEX, comm, 0, 0, 0);
+  scheme = t8_scheme_new_default_cxx ();
+
+  start = sc_MPI_Wtime ();
+  forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+  times[T8_PERFCHECK_NEW_UNIFORM] = sc_MPI_Wtime () - start;
+
+  start = sc_MPI_Wtime ();
+  forest_adapt = t8_forest_new_adapt (forest, t8_perfcheck_adapt, 0, 0,
+                                      &maxlevel);
+  times[T8_PERFCHECK_ADAPT] = sc_MPI_Wtime () - start;
+
+  start = sc_MPI_Wtime ();
+  t8_forest_init (&forest_balance);
+  t8_forest_set_balance (forest_balance, forest_adapt, 0);
+  t8_forest_commit (forest_balance);
+  times[T8_PERFCHECK_BALANCE] = sc_MPI_Wtime () - start;
+
+  start = sc_MPI_Wtime ();
+  t8_forest_init (&forest_ghost);
+  t8_forest_set_copy (forest_ghost, forest_balance);
+  t8_forest_set_ghost (forest_ghost, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_ghost);
+  times[T8_PERFCHECK_GHOST] = sc_MPI_Wtime () - start;
+
+  sc_array_init_size (&element_data, sizeof (double),
+                      t8_forest_get_num_element (forest_ghost) +
+                      t8_forest_get_num_ghosts (forest_ghost));
+  memset (element_data.array, 0,
+          element_data.elem_count * element_data.elem_size);
+  start = sc_MPI_Wtime ();
+  for (iexchange = 0; iexchange < num_exchanges; iexchange++) {
+    t8_forest_ghost_exchange_data (forest_ghost, &element_data);
+  }
+  times[T8_PERFCHECK_GHOST_EXCHANGE] = sc_MPI_Wtime () - start;
+  sc_array_reset (&element_data);
+
+  start = sc_MPI_Wtime ();
+  t8_perfcheck_face_neighbors (forest_ghost);
+  times[T8_PERFCHECK_FACE_NEIGHBORS] = sc_MPI_Wtime () - start;
+
+  start = sc_MPI_Wtime ();
+  t8_forest_write_vtk (forest_ghost, "t8_perfcheck");
+  times[T8_PERFCHECK_VTK] = sc_MPI_Wtime () - start;
+
+  t8_forest_unref (&forest_ghost);
+}
+
+/* Read a baseline file. Kernels that are not listed get a negative time.
+ * Return 0 if the file could not be opened. */
+static int
+t8_perfcheck_read_baseline (const char *filename, double *baseline)
+{
+  FILE               *file;
+  char                name[BUFSIZ];
+  double              seconds;
+  int                 ikernel;
+
+  for (ikernel = 0; ikernel < T8_PERFCHECK_NUM_KERNELS; ikernel++) {
+    baseline[ikernel] = -1;
+  }
+  file = fopen (filename, "r");
+  if (file == NULL) {
+    return 0;
+  }
+  while (fscanf (file, "%255s %lf", name, &seconds) == 2) {
+    for (ikernel = 0; ikernel < T8_PERFCHECK_NUM_KERNELS; ikernel++) {
+      if (!strcmp (name, t8_perfcheck_kernel_names[ikernel])) {
+        baseline[ikernel] = seconds;
+      }
+    }
+  }
+  fclose (file);
+  return 1;
+}
+
+/* Time all kernels and write or compare them to the baseline.
+ * Return the number of kernels that are slower than the baseline. */
+static int
+t8_perfcheck (sc_MPI_Comm comm, int level, int num_repetitions,
+              int num_exchanges, const char *write_file,
+              const char *baseline_file, double tolerance)
+{
+  double              times[T8_PERFCHECK_NUM_KERNELS];
+  double              max_times[T8_PERFCHECK_NUM_KERNELS];
+  double              best[T8_PERFCHECK_NUM_KERNELS];
+  double              baseline[T8_PERFCHECK_NUM_KERNELS];
+  int                 mpirank, mpiret, irep, ikernel, num_failed = 0;
+  FILE               *file;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  for (irep = 0; irep < num_repetitions; irep++) {
+    mpiret = sc_MPI_Barrier (comm);
+    SC_CHECK_MPI (mpiret);
+    t8_perfcheck_run (comm, level, num_exchanges, times);
+    mpiret = sc_MPI_Allreduce (times, max_times, T8_PERFCHECK_NUM_KERNELS,
+                               sc_MPI_DOUBLE, sc_MPI_MAX, comm);
+    SC_CHECK_MPI (mpiret);
+    for (ikernel = 0; ikernel < T8_PERFCHECK_NUM_KERNELS; ikernel++) {
+      if (irep == 0 || max_times[ikernel] < best[ikernel]) {
+        best[ikernel] = max_times[ikernel];
+      }
+    }
+  }
+
+  if (write_file != NULL && mpirank == 0) {
+    file = fopen (write_file, "w");
+    SC_CHECK_ABORTF (file != NULL, "Could not open file %s", write_file);
+    for (ikernel = 0; ikernel < T8_PERFCHECK_NUM_KERNELS; ikernel++) {
+      fprintf (file, "%s %.6e\n", t8_perfcheck_kernel_names[ikernel],
+               best[ikernel]);
+    }
+    fclose (file);
+    t8_global_productionf ("Wrote baseline %s\n", write_file);
+  }
+
+  if (baseline_file != NULL) {
+    /* All processes read the baseline, such that all return the same
+     * result */
+    SC_CHECK_ABORTF (t8_perfcheck_read_baseline (baseline_file, baseline),
+                     "Could not open baseline %s", baseline_file);
+  }
+  for (ikernel = 0; ikernel < T8_PERFCHECK_NUM_KERNELS; ikernel++) {
+    if (baseline_file == NULL || baseline[ikernel] < 0) {
+      t8_global_productionf ("%-20s %.3e s\n",
+                             t8_perfcheck_kernel_names[ikernel],
+                             best[ikernel]);
+    }
+    else if (best[ikernel] > (1 + tolerance) * baseline[ikernel]) {
+      t8_global_errorf ("%-20s %.3e s, baseline %.3e s: SLOWER\n",
+                        t8_perfcheck_kernel_names[ikernel], best[ikernel],
+                        baseline[ikernel]);
+      num_failed++;
+    }
+    else {
+      t8_global_productionf ("%-20s %.3e s, baseline %.3e s: ok\n",
+                             t8_perfcheck_kernel_names[ikernel],
+                             best[ikernel], baseline[ikernel]);
+    }
+  }
+  return num_failed;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_options_t       *opt;
+  const char         *write_file, *baseline_file;
+  double              tolerance;
+  int                 level, num_repetitions, num_exchanges;
+  int                 parsed, helpme, num_failed = 0;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &helpme,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'l', "level", &level, 4,
+                      "The level of the uniform forest.");
+  sc_options_add_int (opt, 'r', "repetitions", &num_repetitions, 3,
+                      "The number of repetitions of each kernel.");
+  sc_options_add_int (opt, 'x', "exchanges", &num_exchanges, 10,
+                      "The number of ghost exchanges per repetition.");
+  sc_options_add_string (opt, 'w', "write", &write_file, NULL,
+                         "Write the runtimes to this baseline file.");
+  sc_options_add_string (opt, 'b', "baseline", &baseline_file, NULL,
+                         "Compare the runtimes to this baseline file.");
+  sc_options_add_double (opt, 't', "tolerance", &tolerance, 0.2,
+                         "The relative slowdown that is tolerated.");
+
+  parsed =
+    sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
+  if (helpme) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else if (parsed >= 0 && level >= 0 && num_repetitions > 0
+           && num_exchanges > 0 && tolerance >= 0) {
+    num_failed = t8_perfcheck (sc_MPI_COMM_WORLD, level, num_repetitions,
+                               num_exchanges, write_file, baseline_file,
+                               tolerance);
+  }
+  else {
+    t8_global_productionf ("\n\t ERROR: Wrong usage.\n\n");
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+    num_failed = 1;
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return num_failed > 0;
+}
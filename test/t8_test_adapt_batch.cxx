@@ -0,0 +1,194 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_private.h>
+
+/* In this test, we adapt a uniform forest in four ways:
+ * 1st  With an element-wise adapt callback (t8_forest_set_adapt)
+ * 2nd  With a batched adapt callback (t8_forest_set_adapt_batch) that
+ *      implements the same refinement criterion.
+ * 3rd  With the batched adapt callback and a single thread
+ *      (t8_forest_set_adapt_threads), as it runs without OpenMP.
+ * 4th  With the batched adapt callback and multiple threads.
+ *
+ * We do this for uniform forests of each element class except pyramids
+ * and of a hybrid mesh with several trees.
+ * Afterwards we check the resulting forests for equality.
+ */
+
+/* A family whose parent is the first child of its parent is coarsened,
+ * every element with child id 1 is refined. */
+static int
+t8_test_adapt_batch_criterion (t8_eclass_scheme_c * ts,
+                               const t8_element_t * element, int is_family)
+{
+  int                 level;
+
+  level = ts->t8_element_level (element);
+  if (is_family && level > 1 && ts->t8_element_ancestor_id (element,
+                                                             level - 1) ==
+      0) {
+    return -1;
+  }
+  if (ts->t8_element_child_id (element) == 1) {
+    return 1;
+  }
+  return 0;
+}
+
+static int
+t8_test_adapt_single (t8_forest_t forest, t8_forest_t forest_from,
+                      t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                      t8_eclass_scheme_c * ts, int num_elements,
+                      t8_element_t * elements[])
+{
+  return t8_test_adapt_batch_criterion (ts, elements[0], num_elements > 1);
+}
+
+static void
+t8_test_adapt_batch (t8_forest_t forest, t8_forest_t forest_from,
+                     t8_locidx_t which_tree, t8_eclass_scheme_c * ts,
+                     t8_element_array_t * elements,
+                     const int8_t * family_first, int *markers)
+{
+  size_t              ielem, num_elements;
+
+  num_elements = t8_element_array_get_count (elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    markers[ielem] =
+      t8_test_adapt_batch_criterion (ts,
+                                     t8_element_array_index_locidx (elements,
+                                                                    ielem),
+                                     family_first[ielem]);
+  }
+}
+
+/* Adapt a uniform forest of the given level with the element-wise callback,
+ * the batched callback, the batched callback with a single thread and the
+ * batched callback with all threads, and check that the resulting forests
+ * are equal element by element. */
+static void
+t8_test_adapt_batch_compare (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
+                             int level)
+{
+  t8_forest_t         forest, forest_single, forest_batch;
+  t8_forest_t         forest_one_thread, forest_threaded;
+
+  /* ref the cmesh and scheme since we reuse them */
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  forest = t8_forest_new_uniform (cmesh, scheme, level, 0, sc_MPI_COMM_WORLD);
+  /* We need to use forest four times, so we ref it */
+  t8_forest_ref (forest);
+  t8_forest_ref (forest);
+  t8_forest_ref (forest);
+
+  t8_forest_init (&forest_single);
+  t8_forest_set_adapt (forest_single, forest, t8_test_adapt_single, 0);
+  t8_forest_commit (forest_single);
+
+  t8_forest_init (&forest_batch);
+  t8_forest_set_adapt_batch (forest_batch, forest, t8_test_adapt_batch);
+  t8_forest_commit (forest_batch);
+
+  /* The batched path with a single thread, as it runs without OpenMP */
+  t8_forest_init (&forest_one_thread);
+  t8_forest_set_adapt_batch (forest_one_thread, forest, t8_test_adapt_batch);
+  t8_forest_set_adapt_threads (forest_one_thread, 1);
+  t8_forest_commit (forest_one_thread);
+
+  t8_forest_init (&forest_threaded);
+  t8_forest_set_adapt_batch (forest_threaded, forest, t8_test_adapt_batch);
+  t8_forest_set_adapt_threads (forest_threaded, -1);
+  t8_forest_commit (forest_threaded);
+
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_single, forest_batch),
+                  "The forests are not equal");
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_single, forest_one_thread),
+                  "The single threaded forest is not equal");
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_single, forest_threaded),
+                  "The threaded forest is not equal");
+  t8_forest_unref (&forest_single);
+  t8_forest_unref (&forest_batch);
+  t8_forest_unref (&forest_one_thread);
+  t8_forest_unref (&forest_threaded);
+}
+
+static void
+t8_test_adapt_batch_equal ()
+{
+  int                 level;
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 4; level++) {
+      t8_global_productionf
+        ("Testing batched adapt with eclass %s, level %i\n",
+         t8_eclass_to_string[eclass], level);
+      t8_test_adapt_batch_compare (cmesh, scheme, level);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+
+  /* A mesh of several trees of different element classes */
+  cmesh = t8_cmesh_new_hypercube_hybrid (3, sc_MPI_COMM_WORLD, 0, 0);
+  for (level = 0; level < 3; level++) {
+    t8_global_productionf
+      ("Testing batched adapt with a hybrid mesh, level %i\n", level);
+    t8_test_adapt_batch_compare (cmesh, scheme, level);
+  }
+  t8_cmesh_destroy (&cmesh);
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_adapt_batch_equal ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -110,6 +110,48 @@ test_cmesh_partition_concentrate (t8_cmesh_t cmesh_partition_uniform,
   t8_cmesh_destroy (&cmesh_partition_new2);
 }
 
+/* Check that the bounds of all processes computed at once match the bounds
+ * that each process computes for itself and that the processes cover all
+ * elements of a uniform level in order. */
+static void
+test_cmesh_uniform_bounds_all (t8_cmesh_t cmesh, int level)
+{
+  t8_gloidx_t        *first_trees, *last_trees, *begins, *ends;
+  t8_gloidx_t         first_tree, last_tree, begin, end;
+  int8_t             *shared, first_shared;
+  int                 rank;
+
+  first_trees = T8_ALLOC (t8_gloidx_t, cmesh->mpisize);
+  last_trees = T8_ALLOC (t8_gloidx_t, cmesh->mpisize);
+  begins = T8_ALLOC (t8_gloidx_t, cmesh->mpisize);
+  ends = T8_ALLOC (t8_gloidx_t, cmesh->mpisize);
+  shared = T8_ALLOC (int8_t, cmesh->mpisize);
+  t8_cmesh_uniform_bounds_all (cmesh, level, first_trees, begins, last_trees,
+                               ends, shared);
+  t8_cmesh_uniform_bounds (cmesh, level, &first_tree, &begin, &last_tree,
+                           &end, &first_shared);
+  rank = cmesh->mpirank;
+  SC_CHECK_ABORT (first_trees[rank] == first_tree
+                  && last_trees[rank] == last_tree && begins[rank] == begin
+                  && ends[rank] == end && shared[rank] == first_shared,
+                  "Bounds of all processes do not match the local bounds");
+  for (rank = 1; rank < cmesh->mpisize; rank++) {
+    if (last_trees[rank] >= first_trees[rank]) {
+      /* A nonempty process starts at or after the last tree of the
+       * previous processes and shares its first tree with them if flagged */
+      SC_CHECK_ABORT (first_trees[rank] >= last_trees[rank - 1]
+                      && (!shared[rank]
+                          || first_trees[rank] <= last_trees[rank - 1]),
+                      "Uniform bounds are not ordered");
+    }
+  }
+  T8_FREE (first_trees);
+  T8_FREE (last_trees);
+  T8_FREE (begins);
+  T8_FREE (ends);
+  T8_FREE (shared);
+}
+
 static void
 test_cmesh_partition (sc_MPI_Comm comm)
 {
@@ -158,6 +200,7 @@ test_cmesh_partition (sc_MPI_Comm comm)
             t8_cmesh_new_bigmesh ((t8_eclass_t) eci, num_trees, comm);
         }
         test_cmesh_committed (cmesh_original);
+        test_cmesh_uniform_bounds_all (cmesh_original, level);
         for (i = 0; i < 2; i++) {
           /* Set up the partitioned cmesh */
           t8_cmesh_init (&cmesh_partition);
@@ -182,6 +225,37 @@ test_cmesh_partition (sc_MPI_Comm comm)
   }
 }
 
+/* Build the partitioned bigmesh and check that the local trees of all
+ * processes add up to the global trees and that at most the two neighbors
+ * of the local range are ghosts. */
+static void
+test_cmesh_bigmesh_partitioned (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_gloidx_t         num_trees, num_local_trees, sum_local_trees;
+  int                 eci, mpiret;
+
+  for (eci = T8_ECLASS_VERTEX; eci < T8_ECLASS_COUNT; eci++) {
+    for (num_trees = 1; num_trees < 30; num_trees += 7) {
+      cmesh =
+        t8_cmesh_new_bigmesh_partitioned ((t8_eclass_t) eci, num_trees,
+                                          comm);
+      test_cmesh_committed (cmesh);
+      SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) == num_trees,
+                      "Wrong number of global trees");
+      SC_CHECK_ABORT (t8_cmesh_get_num_ghosts (cmesh) <= 2,
+                      "Too many ghosts in partitioned bigmesh");
+      num_local_trees = t8_cmesh_get_num_local_trees (cmesh);
+      mpiret = sc_MPI_Allreduce (&num_local_trees, &sum_local_trees, 1,
+                                 T8_MPI_GLOIDX, sc_MPI_SUM, comm);
+      SC_CHECK_MPI (mpiret);
+      SC_CHECK_ABORT (sum_local_trees == num_trees,
+                      "Local trees do not add up to the global trees");
+      t8_cmesh_destroy (&cmesh);
+    }
+  }
+}
+
 int
 main (int argc, char **argv)
 {
@@ -198,6 +272,7 @@ main (int argc, char **argv)
 
   t8_global_productionf ("Testing cmesh partition.\n");
   test_cmesh_partition (comm);
+  test_cmesh_bigmesh_partitioned (comm);
   t8_global_productionf ("Done testing cmesh partition.\n");
 
   sc_finalize ();
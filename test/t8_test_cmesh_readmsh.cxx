@@ -0,0 +1,221 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_readmshfile.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+
+/* In this test, we read a small hybrid 2D mesh of 4 quads and 5 triangles
+ * with the different .msh readers.
+ * The file test/testfiles/t8_test_msh_hybrid_v2.msh is in the ASCII format
+ * of version 2.2 and t8_test_msh_hybrid_v4.msh holds the same mesh in the
+ * ASCII format of version 4.1. Both also contain boundary lines that are
+ * skipped when reading the 2D elements.
+ * 1st  We read the v2 file on all processes with the serial reader and
+ *      check that it has 9 trees and 20 joined faces and that joined faces
+ *      share their vertices.
+ * 2nd  We read the v2 file with the serial reader on one process and
+ *      partitioned, with the parallel reader and with the scatter reader.
+ *      We read the v4 file with the serial reader. For each of these cmeshes
+ *      we check that each local tree has the same class, face neighbors and
+ *      tree to face entries as in the first cmesh.
+ */
+
+#ifndef T8_TEST_MSH_DIR
+#define T8_TEST_MSH_DIR "test/testfiles"
+#endif
+
+#define T8_TEST_MSH_NUM_TREES 9
+#define T8_TEST_MSH_NUM_JOINS 20
+
+/* Return true if the vertex ivertex of the first tree has the same
+ * coordinates as the vertex jvertex of the second tree */
+static int
+t8_test_readmsh_vertex_equal (const double *vertices_a, int ivertex,
+                              const double *vertices_b, int jvertex)
+{
+  int                 icoord;
+
+  for (icoord = 0; icoord < 3; icoord++) {
+    if (vertices_a[3 * ivertex + icoord] != vertices_b[3 * jvertex + icoord]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Check the number of trees and joins of the serial cmesh and that the
+ * faces of each join have the same vertices */
+static void
+t8_test_readmsh_serial (t8_cmesh_t cmesh)
+{
+  t8_locidx_t         ltree, neighbor;
+  t8_eclass_t         eclass, neigh_class;
+  int                 iface, neigh_face, F;
+  int                 a0, a1, b0, b1;
+  int                 num_joins = 0;
+  int8_t              ttf;
+  double             *vertices, *neigh_vertices;
+
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh) == T8_TEST_MSH_NUM_TREES,
+                  "Wrong number of trees");
+  SC_CHECK_ABORT (t8_cmesh_get_num_local_trees (cmesh) ==
+                  T8_TEST_MSH_NUM_TREES, "Wrong number of local trees");
+  F = t8_eclass_max_num_faces[cmesh->dimension];
+  for (ltree = 0; ltree < T8_TEST_MSH_NUM_TREES; ltree++) {
+    eclass = t8_cmesh_get_tree_class (cmesh, ltree);
+    SC_CHECK_ABORT (eclass == T8_ECLASS_QUAD
+                    || eclass == T8_ECLASS_TRIANGLE, "Wrong tree class");
+    vertices = t8_cmesh_get_tree_vertices (cmesh, ltree);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      if (t8_cmesh_tree_face_is_boundary (cmesh, ltree, iface)) {
+        continue;
+      }
+      num_joins++;
+      neighbor = t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees, ltree,
+                                                       iface, &ttf);
+      neigh_face = ttf % F;
+      neigh_class = t8_cmesh_get_tree_class (cmesh, neighbor);
+      neigh_vertices = t8_cmesh_get_tree_vertices (cmesh, neighbor);
+      /* A face in 2D has two vertices that may appear in either order */
+      a0 = t8_face_vertex_to_tree_vertex[eclass][iface][0];
+      a1 = t8_face_vertex_to_tree_vertex[eclass][iface][1];
+      b0 = t8_face_vertex_to_tree_vertex[neigh_class][neigh_face][0];
+      b1 = t8_face_vertex_to_tree_vertex[neigh_class][neigh_face][1];
+      SC_CHECK_ABORTF ((t8_test_readmsh_vertex_equal
+                        (vertices, a0, neigh_vertices, b0)
+                        && t8_test_readmsh_vertex_equal (vertices, a1,
+                                                         neigh_vertices, b1))
+                       || (t8_test_readmsh_vertex_equal
+                           (vertices, a0, neigh_vertices, b1)
+                           && t8_test_readmsh_vertex_equal (vertices, a1,
+                                                            neigh_vertices,
+                                                            b0)),
+                       "Face %i of tree %i and face %i of tree %i do not "
+                       "share their vertices", iface, ltree, neigh_face,
+                       neighbor);
+    }
+  }
+  SC_CHECK_ABORTF (num_joins == T8_TEST_MSH_NUM_JOINS,
+                   "Wrong number of joined faces %i", num_joins);
+}
+
+/* Check that each local tree of cmesh has the same class, face neighbors
+ * and tree to face entries as the corresponding tree of the serial cmesh */
+static void
+t8_test_readmsh_compare (t8_cmesh_t cmesh, t8_cmesh_t cmesh_serial,
+                         const char *reader)
+{
+  t8_locidx_t         ltree, serial_ltree, neighbor, serial_neighbor;
+  t8_locidx_t         num_local_trees;
+  t8_gloidx_t         gtree;
+  t8_eclass_t         eclass;
+  int                 iface;
+  int8_t              ttf, serial_ttf;
+
+  SC_CHECK_ABORTF (t8_cmesh_get_num_trees (cmesh) == T8_TEST_MSH_NUM_TREES,
+                   "Wrong number of trees with the %s reader", reader);
+  num_local_trees = t8_cmesh_get_num_local_trees (cmesh);
+  for (ltree = 0; ltree < num_local_trees; ltree++) {
+    gtree = t8_cmesh_get_global_id (cmesh, ltree);
+    serial_ltree = t8_cmesh_get_local_id (cmesh_serial, gtree);
+    eclass = t8_cmesh_get_tree_class (cmesh, ltree);
+    SC_CHECK_ABORTF (eclass == t8_cmesh_get_tree_class (cmesh_serial,
+                                                        serial_ltree),
+                     "Wrong class of tree %lli with the %s reader",
+                     (long long) gtree, reader);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      neighbor = t8_cmesh_trees_get_face_neighbor_ext (cmesh->trees, ltree,
+                                                       iface, &ttf);
+      serial_neighbor =
+        t8_cmesh_trees_get_face_neighbor_ext (cmesh_serial->trees,
+                                              serial_ltree, iface,
+                                              &serial_ttf);
+      SC_CHECK_ABORTF (t8_cmesh_get_global_id (cmesh, neighbor) ==
+                       t8_cmesh_get_global_id (cmesh_serial, serial_neighbor)
+                       && ttf == serial_ttf,
+                       "Wrong face neighbor at face %i of tree %lli with the "
+                       "%s reader", iface, (long long) gtree, reader);
+    }
+  }
+}
+
+static void
+t8_test_readmsh (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_serial, cmesh;
+  const char         *prefix_v2 = T8_TEST_MSH_DIR "/t8_test_msh_hybrid_v2";
+  const char         *prefix_v4 = T8_TEST_MSH_DIR "/t8_test_msh_hybrid_v4";
+
+  cmesh_serial = t8_cmesh_from_msh_file (prefix_v2, 0, comm, 2, 0);
+  t8_test_readmsh_serial (cmesh_serial);
+  t8_global_productionf ("Checked the serial reader.\n");
+
+  cmesh = t8_cmesh_from_msh_file (prefix_v2, 1, comm, 2, 0);
+  t8_test_readmsh_compare (cmesh, cmesh_serial, "partitioned");
+  t8_cmesh_destroy (&cmesh);
+  t8_global_productionf ("Checked the partitioned reader.\n");
+
+  cmesh = t8_cmesh_from_msh_file (prefix_v2, 1, comm, 2, -1);
+  t8_test_readmsh_compare (cmesh, cmesh_serial, "parallel");
+  t8_cmesh_destroy (&cmesh);
+  t8_global_productionf ("Checked the parallel reader.\n");
+
+  cmesh = t8_cmesh_from_msh_file_scatter (prefix_v2, comm, 2, 0);
+  SC_CHECK_ABORT (cmesh != NULL, "The scatter reader failed");
+  t8_test_readmsh_compare (cmesh, cmesh_serial, "scatter");
+  t8_cmesh_destroy (&cmesh);
+  t8_global_productionf ("Checked the scatter reader.\n");
+
+  cmesh = t8_cmesh_from_msh_file (prefix_v4, 0, comm, 2, 0);
+  t8_test_readmsh_compare (cmesh, cmesh_serial, "v4.1");
+  t8_cmesh_destroy (&cmesh);
+  t8_global_productionf ("Checked the v4.1 reader.\n");
+
+  t8_cmesh_destroy (&cmesh_serial);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_readmsh (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh.h>
+#include "t8_cmesh/t8_cmesh_types.h"
+#include "t8_cmesh/t8_cmesh_trees.h"
+
+/* Check whether a loaded cmesh is equal to the cmesh that was saved */
+static void
+test_cmesh_loaded_equal (t8_cmesh_t cmesh, t8_cmesh_t cmesh_loaded)
+{
+  int                 retval;
+
+  SC_CHECK_ABORT (cmesh_loaded != NULL, "Loading the cmesh failed.");
+  SC_CHECK_ABORT (t8_cmesh_is_committed (cmesh_loaded),
+                  "Loaded cmesh is not committed.");
+  retval = cmesh->num_trees == cmesh_loaded->num_trees
+    && cmesh->num_local_trees == cmesh_loaded->num_local_trees
+    && cmesh->num_ghosts == cmesh_loaded->num_ghosts
+    && cmesh->first_tree == cmesh_loaded->first_tree
+    && cmesh->dimension == cmesh_loaded->dimension
+    && cmesh->set_partition == cmesh_loaded->set_partition;
+  SC_CHECK_ABORT (retval, "Loaded cmesh has wrong metadata.");
+  retval = t8_cmesh_trees_is_equal (cmesh, cmesh->trees,
+                                    cmesh_loaded->trees);
+  SC_CHECK_ABORT (retval, "Loaded cmesh has different trees.");
+}
+
+/* In this test we save replicated and partitioned hypercube cmeshes
+ * in the binary format, load them again, once by reading and once
+ * by memory mapping the files, and check that the loaded
+ * cmeshes are equal to the original ones. */
+static void
+test_cmesh_save_binary (sc_MPI_Comm comm)
+{
+  int                 eci, do_partition, retval;
+  int                 mpirank, mpiret;
+  char                filename[BUFSIZ];
+  t8_cmesh_t          cmesh, cmesh_loaded, cmesh_mapped;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  for (eci = T8_ECLASS_ZERO; eci < T8_ECLASS_COUNT; ++eci) {
+    for (do_partition = 0; do_partition <= 1; do_partition++) {
+      t8_global_productionf ("Testing eclass %s, partitioned %i.\n",
+                             t8_eclass_to_string[eci], do_partition);
+      cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eci, comm, 0,
+                                      do_partition, 0);
+      retval = t8_cmesh_save_binary (cmesh, "test_cmesh_save");
+      SC_CHECK_ABORT (retval == 1, "Saving the cmesh failed.");
+      /* Make sure that all files are written */
+      mpiret = sc_MPI_Barrier (comm);
+      SC_CHECK_MPI (mpiret);
+      /* A replicated cmesh is only written by rank 0 */
+      snprintf (filename, BUFSIZ, "test_cmesh_save_%04d.cmesh",
+                do_partition ? mpirank : 0);
+      cmesh_loaded = t8_cmesh_load (filename, comm);
+      test_cmesh_loaded_equal (cmesh, cmesh_loaded);
+      cmesh_mapped = t8_cmesh_load_mapped (filename, comm);
+      test_cmesh_loaded_equal (cmesh, cmesh_mapped);
+      t8_cmesh_destroy (&cmesh_mapped);
+      t8_cmesh_destroy (&cmesh_loaded);
+      t8_cmesh_destroy (&cmesh);
+      /* Make sure that all files are unmapped before we overwrite them */
+      mpiret = sc_MPI_Barrier (comm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         comm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  comm = sc_MPI_COMM_WORLD;
+  sc_init (comm, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing cmesh binary save.\n");
+  test_cmesh_save_binary (comm);
+  t8_global_productionf ("Done testing cmesh binary save.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
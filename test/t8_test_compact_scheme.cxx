@@ -0,0 +1,169 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we build the same adapted forest of triangles and of
+ * tetrahedra once with the default scheme and once with the compact scheme.
+ * Afterwards we check that both forests have the same elements and the
+ * same number of ghosts.
+ */
+
+/* Refine every element whose child id equals its level modulo the
+ * number of children. Only uses the scheme interface, thus it gives the
+ * same forest for both schemes. */
+static int
+t8_test_compact_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  int                 level, num_children;
+
+  level = ts->t8_element_level (elements[0]);
+  num_children = ts->t8_element_num_children (elements[0]);
+  if (level < 4
+      && ts->t8_element_child_id (elements[0]) == level % num_children) {
+    return 1;
+  }
+  return 0;
+}
+
+static          t8_forest_t
+t8_test_compact_new_forest (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
+                            int level)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                  sc_MPI_COMM_WORLD);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_compact_adapt, 1);
+  t8_forest_set_partition (forest_adapt, NULL, 0);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  return forest_adapt;
+}
+
+/* Check that two forests have the same elements in the same order */
+static void
+t8_test_compact_compare (t8_forest_t forest, t8_forest_t forest_compact)
+{
+  t8_locidx_t         itree, ielem, num_elems;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts, *ts_compact;
+  t8_element_t       *elem, *elem_compact;
+  int                 maxlevel;
+
+  SC_CHECK_ABORT (t8_forest_get_num_local_trees (forest) ==
+                  t8_forest_get_num_local_trees (forest_compact),
+                  "The forests have different numbers of trees");
+  SC_CHECK_ABORT (t8_forest_get_num_ghosts (forest) ==
+                  t8_forest_get_num_ghosts (forest_compact),
+                  "The forests have different numbers of ghosts");
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    ts_compact = t8_forest_get_eclass_scheme (forest_compact, eclass);
+    maxlevel = ts_compact->t8_element_maxlevel ();
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    SC_CHECK_ABORT (num_elems ==
+                    t8_forest_get_tree_num_elements (forest_compact, itree),
+                    "The trees have different numbers of elements");
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+      elem_compact =
+        t8_forest_get_element_in_tree (forest_compact, itree, ielem);
+      SC_CHECK_ABORT (ts->t8_element_level (elem) ==
+                      ts_compact->t8_element_level (elem_compact),
+                      "The elements have different levels");
+      SC_CHECK_ABORT (ts->t8_element_get_linear_id (elem, maxlevel) ==
+                      ts_compact->t8_element_get_linear_id (elem_compact,
+                                                            maxlevel),
+                      "The elements have different linear ids");
+    }
+  }
+}
+
+static void
+t8_test_compact_scheme ()
+{
+  int                 level;
+  int                 ieclass;
+  t8_eclass_t         eclasses[2] = { T8_ECLASS_TRIANGLE, T8_ECLASS_TET };
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_compact;
+  t8_scheme_cxx_t    *scheme, *scheme_compact;
+
+  scheme = t8_scheme_new_default_cxx ();
+  scheme_compact = t8_scheme_new_compact_cxx ();
+  for (ieclass = 0; ieclass < 2; ieclass++) {
+    cmesh = t8_cmesh_new_hypercube (eclasses[ieclass], sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf
+        ("Testing compact scheme with eclass %s, level %i\n",
+         t8_eclass_to_string[eclasses[ieclass]], level);
+      /* ref the cmesh and schemes since we reuse them */
+      t8_cmesh_ref (cmesh);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      t8_scheme_cxx_ref (scheme_compact);
+      forest = t8_test_compact_new_forest (cmesh, scheme, level);
+      forest_compact =
+        t8_test_compact_new_forest (cmesh, scheme_compact, level);
+      t8_test_compact_compare (forest, forest_compact);
+      t8_forest_unref (&forest);
+      t8_forest_unref (&forest_compact);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+  t8_scheme_cxx_unref (&scheme_compact);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_compact_scheme ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,193 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_private.h>
+
+/* In this test, we build a forest with a face neighbor table
+ * (t8_forest_set_face_neighbors) and compare the table to the results of
+ * t8_forest_leaf_face_neighbors for each face of each local leaf.
+ * We test a uniform forest and an adapted, balanced forest that has
+ * hanging faces.
+ * The coarse meshes are a periodic square, a periodic square of two
+ * triangles, a periodic cube and a cube of six tetrahedra. We refine the
+ * trees with odd global id and the elements at face 0 of each tree, such
+ * that there are hanging faces across tree boundaries and across the
+ * periodic boundaries.
+ */
+
+/* Refine the elements of trees with odd global id and the elements at
+ * face 0 of each tree up to level 3 */
+static int
+t8_test_face_neighbors_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                              t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                              t8_eclass_scheme_c * ts, int num_elements,
+                              t8_element_t * elements[])
+{
+  int                 iface;
+
+  if (ts->t8_element_level (elements[0]) >= 3) {
+    return 0;
+  }
+  if (t8_forest_global_tree_id (forest_from, which_tree) % 2) {
+    return 1;
+  }
+  for (iface = 0; iface < ts->t8_element_num_faces (elements[0]); iface++) {
+    if (ts->t8_element_is_root_boundary (elements[0], iface)
+        && ts->t8_element_tree_face (elements[0], iface) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Build the coarse mesh of the test case icase */
+static t8_cmesh_t
+t8_test_face_neighbors_cmesh (int icase, sc_MPI_Comm comm)
+{
+  switch (icase) {
+  case 0:
+    return t8_cmesh_new_periodic (comm, 2);
+  case 1:
+    return t8_cmesh_new_periodic_tri (comm);
+  case 2:
+    return t8_cmesh_new_periodic (comm, 3);
+  default:
+    return t8_cmesh_new_hypercube (T8_ECLASS_TET, comm, 0, 0, 0);
+  }
+}
+
+static void
+t8_test_face_neighbors_check (t8_forest_t forest)
+{
+  t8_locidx_t         ielem, ltree, *element_indices;
+  const t8_locidx_t  *neighbors;
+  const int8_t       *dual_faces;
+  t8_element_t       *leaf, **neighbor_leafs;
+  t8_eclass_scheme_c *ts, *neigh_scheme;
+  int                 iface, num_neighbors, ineigh, level_diff;
+  int                *neigh_dual_faces;
+
+  for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
+    leaf = t8_forest_get_element (forest, ielem, &ltree);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    for (iface = 0; iface < ts->t8_element_num_faces (leaf); iface++) {
+      t8_forest_leaf_face_neighbors (forest, ltree, leaf, &neighbor_leafs,
+                                     iface, &neigh_dual_faces,
+                                     &num_neighbors, &element_indices,
+                                     &neigh_scheme, 1);
+      SC_CHECK_ABORT (t8_forest_get_face_neighbors (forest, ielem, iface,
+                                                    &neighbors, &dual_faces,
+                                                    &level_diff) ==
+                      num_neighbors, "Wrong number of face neighbors");
+      for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+        SC_CHECK_ABORT (neighbors[ineigh] == element_indices[ineigh],
+                        "Wrong face neighbor index");
+        SC_CHECK_ABORT (dual_faces[ineigh] == neigh_dual_faces[ineigh],
+                        "Wrong dual face");
+        SC_CHECK_ABORT (level_diff ==
+                        neigh_scheme->t8_element_level (neighbor_leafs
+                                                        [ineigh]) -
+                        ts->t8_element_level (leaf), "Wrong level difference");
+      }
+      if (num_neighbors > 0) {
+        neigh_scheme->t8_element_destroy (num_neighbors, neighbor_leafs);
+        T8_FREE (element_indices);
+        T8_FREE (neighbor_leafs);
+        T8_FREE (neigh_dual_faces);
+      }
+      else {
+        SC_CHECK_ABORT (level_diff == 0, "Boundary face with level difference");
+      }
+    }
+  }
+}
+
+static void
+t8_test_face_neighbors (sc_MPI_Comm comm)
+{
+  const char         *names[4] = { "periodic quad", "periodic triangle",
+    "periodic hex", "tet"
+  };
+  int                 icase;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (icase = 0; icase < 4; icase++) {
+    t8_global_productionf ("Testing face neighbor table with %s mesh\n",
+                           names[icase]);
+    cmesh = t8_test_face_neighbors_cmesh (icase, comm);
+    t8_scheme_cxx_ref (scheme);
+    /* A uniform forest */
+    t8_forest_init (&forest);
+    t8_forest_set_cmesh (forest, cmesh, comm);
+    t8_forest_set_scheme (forest, scheme);
+    t8_forest_set_level (forest, 2);
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+    t8_forest_set_face_neighbors (forest, 1);
+    t8_forest_commit (forest);
+    t8_test_face_neighbors_check (forest);
+
+    /* An adapted and balanced forest */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_face_neighbors_adapt,
+                         1);
+    t8_forest_set_balance (forest_adapt, NULL, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_set_face_neighbors (forest_adapt, 1);
+    t8_forest_commit (forest_adapt);
+    t8_test_face_neighbors_check (forest_adapt);
+    t8_forest_unref (&forest_adapt);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_face_neighbors (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
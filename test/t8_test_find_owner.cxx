@@ -168,6 +168,76 @@ t8_test_find_multiple_owners (sc_MPI_Comm comm, t8_eclass_t eclass)
   sc_array_reset (&owners);
 }
 
+/* Partition a uniform forest to half of the processes, such that the
+ * other processes are empty, once with the dense partition tables and once
+ * with the compact tables. Check that both forests find the same owner for
+ * each element. */
+static void
+t8_test_find_owner_compact (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_dense, forest_compact;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  t8_gloidx_t         itree, ielement, elements_per_tree;
+  int                 level = 2;
+  int                 mpisize, mpiret, num_ranks;
+  int                 owner, owner_compact;
+
+  t8_global_productionf ("Testing compact find_owner with eclass %s\n",
+                         t8_eclass_to_string[eclass]);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  num_ranks = (mpisize + 1) / 2;
+
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), level,
+                                  0, comm);
+  /* We need to use forest twice, so we ref it */
+  t8_forest_ref (forest);
+
+  t8_forest_init (&forest_dense);
+  t8_forest_set_partition (forest_dense, forest, 0);
+  t8_forest_set_partition_ranks (forest_dense, num_ranks);
+  t8_forest_commit (forest_dense);
+
+  t8_forest_init (&forest_compact);
+  t8_forest_set_partition (forest_compact, forest, 0);
+  t8_forest_set_partition_ranks (forest_compact, num_ranks);
+  t8_forest_set_partition_compact (forest_compact, 1);
+  t8_forest_commit (forest_compact);
+  SC_CHECK_ABORT (forest_compact->element_offsets == NULL,
+                  "The compact forest kept its partition tables");
+  SC_CHECK_ABORT (t8_forest_get_first_local_element_id (forest_dense) ==
+                  t8_forest_get_first_local_element_id (forest_compact),
+                  "The first local elements are not equal");
+
+  ts = t8_forest_get_eclass_scheme (forest_dense, eclass);
+  ts->t8_element_new (1, &element);
+  elements_per_tree = t8_eclass_count_leaf (eclass, level);
+  for (itree = 0; itree < t8_forest_get_num_global_trees (forest_dense);
+       itree++) {
+    for (ielement = 0; ielement < elements_per_tree; ielement++) {
+      ts->t8_element_set_linear_id (element, level, ielement);
+      owner = t8_forest_element_find_owner (forest_dense, itree, element,
+                                            eclass);
+      owner_compact = t8_forest_element_find_owner (forest_compact, itree,
+                                                    element, eclass);
+      SC_CHECK_ABORTF (owner == owner_compact,
+                       "Compact owner of element %lli in tree %lli is %i"
+                       " instead of %i.\n", (long long) ielement,
+                       (long long) itree, owner_compact, owner);
+      SC_CHECK_ABORTF (owner < num_ranks,
+                       "Element %lli in tree %lli is owned by the empty"
+                       " process %i.\n", (long long) ielement,
+                       (long long) itree, owner);
+    }
+  }
+  ts->t8_element_destroy (1, &element);
+  t8_forest_unref (&forest_dense);
+  t8_forest_unref (&forest_compact);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -187,6 +257,9 @@ main (int argc, char **argv)
     if (ieclass != T8_ECLASS_PYRAMID) {
       /* TODO: does not work with pyramids yet */
       t8_test_find_multiple_owners (mpic, (t8_eclass_t) ieclass);
+      if (ieclass != T8_ECLASS_VERTEX) {
+        t8_test_find_owner_compact (mpic, (t8_eclass_t) ieclass);
+      }
     }
   }
 
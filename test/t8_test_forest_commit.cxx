@@ -25,8 +25,10 @@
 #include <t8_cmesh.h>
 #include <t8_forest.h>
 #include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest/t8_forest_partition.h>
 #include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_types.h>
 
 /* In this test, we adapt, balance and partition a uniform forest.
  * We do this in two ways:
@@ -34,6 +36,9 @@
  * 2nd  Each intermediate step is performed in a seperate commit
  *
  * After these two forests are created, we check for equality.
+ * Finally we adapt and balance the forest again and partition it once
+ * with uncompressed and once with compressed messages and compare the
+ * elements and ghosts.
  */
 
 /* Adapt a forest such that always the first child of a
@@ -132,6 +137,131 @@ t8_test_forest_commit_abp_3step (t8_forest_t forest, int maxlevel)
   return forest_partition;
 }
 
+/* Adapt and balance a forest and partition it with ghosts once with
+ * uncompressed and once with compressed messages of all sizes. Check that
+ * both forests have the same elements and ghost elements. */
+static void
+t8_test_forest_commit_compression (t8_forest_t forest, int maxlevel)
+{
+  t8_forest_t         forest_adapt, forest_balance;
+  t8_forest_t         forest_plain, forest_compressed;
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_user_data (forest_adapt, &maxlevel);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_adapt_balance, 1);
+  t8_forest_commit (forest_adapt);
+
+  t8_forest_init (&forest_balance);
+  t8_forest_set_balance (forest_balance, forest_adapt, 0);
+  t8_forest_commit (forest_balance);
+  /* We need to use forest_balance twice, so we ref it */
+  t8_forest_ref (forest_balance);
+
+  t8_forest_init (&forest_plain);
+  t8_forest_set_partition (forest_plain, forest_balance, 0);
+  t8_forest_set_ghost (forest_plain, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_plain);
+
+  t8_forest_init (&forest_compressed);
+  t8_forest_set_partition (forest_compressed, forest_balance, 0);
+  t8_forest_set_message_compression (forest_compressed, 1);
+  t8_forest_set_ghost (forest_compressed, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_compressed);
+
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_plain, forest_compressed),
+                  "The compressed partition changed the elements");
+  SC_CHECK_ABORT (t8_forest_ghost_is_equal (forest_plain, forest_compressed),
+                  "The compressed ghost layer is not equal");
+  t8_forest_unref (&forest_plain);
+  t8_forest_unref (&forest_compressed);
+}
+
+/* Check that the offsets that are built with one collective equal the
+ * offsets of the functions that build one array each. */
+static void
+t8_test_forest_commit_offsets (t8_forest_t forest)
+{
+  t8_shmem_array_t    element_offsets, tree_offsets, global_first_desc;
+
+  /* The committed forest built its arrays with
+   * t8_forest_partition_create_all_offsets */
+  t8_forest_partition_create_all_offsets (forest);
+  element_offsets = forest->element_offsets;
+  tree_offsets = forest->tree_offsets;
+  global_first_desc = forest->global_first_desc;
+  forest->element_offsets = NULL;
+  forest->tree_offsets = NULL;
+  forest->global_first_desc = NULL;
+  t8_forest_partition_create_offsets (forest);
+  t8_forest_partition_create_tree_offsets (forest);
+  t8_forest_partition_create_first_desc (forest);
+  SC_CHECK_ABORT (t8_shmem_array_is_equal
+                  (element_offsets, forest->element_offsets),
+                  "The element offsets are not equal");
+  SC_CHECK_ABORT (t8_shmem_array_is_equal
+                  (tree_offsets, forest->tree_offsets),
+                  "The tree offsets are not equal");
+  SC_CHECK_ABORT (t8_shmem_array_is_equal
+                  (global_first_desc, forest->global_first_desc),
+                  "The global first descendants are not equal");
+  t8_shmem_array_destroy (&forest->element_offsets);
+  t8_shmem_array_destroy (&forest->tree_offsets);
+  t8_shmem_array_destroy (&forest->global_first_desc);
+  forest->element_offsets = element_offsets;
+  forest->tree_offsets = tree_offsets;
+  forest->global_first_desc = global_first_desc;
+}
+
+/* Refine all elements of the first local tree */
+static int
+t8_test_adapt_first_tree (t8_forest_t forest, t8_forest_t forest_from,
+                          t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                          t8_eclass_scheme_c * ts, int num_elements,
+                          t8_element_t * elements[])
+{
+  return which_tree == 0;
+}
+
+/* Adapt a copy of a uniform forest that holds the only reference to the
+ * shared element arrays. The copy is destroyed when the adapted forest is
+ * committed, thus the adapted forest must not use the arrays of the copy.
+ * We compare it to the same adaptation of a uniform forest. */
+static void
+t8_test_forest_commit_copy_adapt (t8_cmesh_t cmesh, t8_scheme_cxx_t * scheme,
+                                  int level)
+{
+  t8_forest_t         forest, forest_copy, forest_adapt, forest_compare;
+
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                  sc_MPI_COMM_WORLD);
+  /* The copy takes over our reference of forest */
+  t8_forest_init (&forest_copy);
+  t8_forest_set_copy (forest_copy, forest);
+  t8_forest_commit (forest_copy);
+  /* The adapted forest takes over our reference of the copy */
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest_copy, t8_test_adapt_first_tree,
+                       0);
+  t8_forest_commit (forest_adapt);
+
+  t8_cmesh_ref (cmesh);
+  t8_scheme_cxx_ref (scheme);
+  forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                  sc_MPI_COMM_WORLD);
+  t8_forest_init (&forest_compare);
+  t8_forest_set_adapt (forest_compare, forest, t8_test_adapt_first_tree, 0);
+  t8_forest_commit (forest_compare);
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_adapt, forest_compare),
+                  "The adapted copy is not equal to the adapted forest");
+  SC_CHECK_ABORT (t8_forest_checksum (forest_adapt) ==
+                  t8_forest_checksum (forest_compare),
+                  "The checksums of the adapted forests are not equal");
+  t8_forest_unref (&forest_adapt);
+  t8_forest_unref (&forest_compare);
+}
+
 static void
 t8_test_forest_commit ()
 {
@@ -162,7 +292,8 @@ t8_test_forest_commit ()
         /* Create a uniformly refined forest */
         forest = t8_forest_new_uniform (cmesh, scheme, level, 1,
                                         sc_MPI_COMM_WORLD);
-        /* We need to use forest twice, so we ref it */
+        /* We need to use forest three times, so we ref it */
+        t8_forest_ref (forest);
         t8_forest_ref (forest);
         /* Adapt, balance and partition the forest */
         forest_ada_bal_part = t8_test_forest_commit_abp (forest, maxlevel);
@@ -175,6 +306,14 @@ t8_test_forest_commit ()
         SC_CHECK_ABORT (t8_forest_is_equal
                         (forest_abp_3part, forest_ada_bal_part),
                         "The forests are not equal");
+        SC_CHECK_ABORT (t8_forest_checksum (forest_abp_3part) ==
+                        t8_forest_checksum (forest_ada_bal_part),
+                        "The checksums of the forests are not equal");
+        t8_test_forest_commit_offsets (forest_abp_3part);
+        /* Partition with compressed messages and compare to the
+         * uncompressed partition */
+        t8_test_forest_commit_compression (forest, maxlevel);
+        t8_test_forest_commit_copy_adapt (cmesh, scheme, level);
         t8_scheme_cxx_ref (scheme);
         t8_forest_unref (&forest_ada_bal_part);
         t8_forest_unref (&forest_abp_3part);
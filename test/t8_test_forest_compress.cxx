@@ -0,0 +1,151 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we build adapted forests, compress and decompress them and
+ * check that the elements are the same as in a copy of the forest.
+ * We also check that the compressed forest uses less element memory.
+ */
+
+static int
+t8_test_forest_compress_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                               t8_locidx_t which_tree,
+                               t8_locidx_t lelement_id,
+                               t8_eclass_scheme_c * ts, int num_elements,
+                               t8_element_t * elements[])
+{
+  int                 level = ts->t8_element_level (elements[0]);
+
+  if (num_elements > 1 && which_tree == 0 && level == 2
+      && ts->t8_element_child_id (elements[0]) == 0) {
+    return -1;
+  }
+  if ((lelement_id % 3 == 1 || ts->t8_element_child_id (elements[0]) == 1)
+      && level < 4) {
+    return 1;
+  }
+  return 0;
+}
+
+static void
+t8_test_forest_compress_check (t8_forest_t forest, t8_forest_t copy)
+{
+  t8_locidx_t         itree, num_trees, ielem, num_elements;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *elem, *elem_copy;
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest) ==
+                  t8_forest_get_num_element (copy),
+                  "Wrong number of elements");
+  for (itree = 0; itree < num_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    SC_CHECK_ABORT (num_elements ==
+                    t8_forest_get_tree_num_elements (copy, itree),
+                    "Wrong number of tree elements");
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+      elem_copy = t8_forest_get_element_in_tree (copy, itree, ielem);
+      SC_CHECK_ABORT (ts->t8_element_level (elem) ==
+                      ts->t8_element_level (elem_copy)
+                      && !ts->t8_element_compare (elem, elem_copy),
+                      "Decompressed element differs");
+    }
+  }
+}
+
+static void
+t8_test_forest_compress (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_copy;
+  t8_scheme_cxx_t    *scheme;
+  size_t              usage[T8_FOREST_MEMORY_NUM_CATEGORIES];
+  size_t              element_bytes;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing forest compression with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 2, 0, comm);
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest,
+                         t8_test_forest_compress_adapt, 1);
+    t8_forest_commit (forest_adapt);
+
+    t8_forest_ref (forest_adapt);
+    t8_forest_init (&forest_copy);
+    t8_forest_set_copy (forest_copy, forest_adapt);
+    t8_forest_commit (forest_copy);
+
+    t8_forest_memory_usage (forest_adapt, usage, NULL, NULL);
+    element_bytes = usage[T8_FOREST_MEMORY_ELEMENTS];
+    t8_forest_compress (forest_adapt);
+    SC_CHECK_ABORT (t8_forest_is_compressed (forest_adapt),
+                    "Forest is not compressed");
+    t8_forest_memory_usage (forest_adapt, usage, NULL, NULL);
+    SC_CHECK_ABORT (usage[T8_FOREST_MEMORY_ELEMENTS] <= element_bytes,
+                    "Compressed forest uses more element memory");
+    t8_forest_decompress (forest_adapt);
+    SC_CHECK_ABORT (!t8_forest_is_compressed (forest_adapt),
+                    "Forest is still compressed");
+    t8_test_forest_compress_check (forest_adapt, forest_copy);
+
+    t8_forest_unref (&forest_adapt);
+    t8_forest_unref (&forest_copy);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_compress (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,146 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_extrude.h>
+
+/* In this test, we extrude uniform and adapted triangle and quad forests.
+ * The extrusion of a uniform forest must have the same elements as the
+ * uniform forest on the extruded cmesh, and each leaf of level l must
+ * give num_layers times 2^l elements. */
+
+static int
+t8_test_extrude_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  /* Refine the elements of the first tree */
+  return t8_forest_global_tree_id (forest_from, which_tree) == 0;
+}
+
+/* Return the number of elements of the extrusion of a forest */
+static              t8_gloidx_t
+t8_test_extrude_num_elements (t8_forest_t forest, int num_layers)
+{
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         itree, ielem;
+  t8_gloidx_t         local_num = 0, global_num;
+  int                 mpiret;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest, itree);
+         ielem++) {
+      local_num += (t8_gloidx_t) num_layers <<
+        ts->t8_element_level (t8_forest_get_element_in_tree (forest, itree,
+                                                             ielem));
+    }
+  }
+  mpiret = sc_MPI_Allreduce (&local_num, &global_num, 1, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, t8_forest_get_mpicomm (forest));
+  SC_CHECK_MPI (mpiret);
+  return global_num;
+}
+
+static void
+t8_test_extrude (sc_MPI_Comm comm)
+{
+  t8_eclass_t         eclasses[2] = { T8_ECLASS_TRIANGLE, T8_ECLASS_QUAD };
+  t8_scheme_cxx_t    *scheme;
+  t8_cmesh_t          cmesh, cmesh_extruded;
+  t8_forest_t         forest, forest_adapt, forest_extruded, forest_uniform;
+  const int           num_layers = 3;
+  int                 iclass, level;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (iclass = 0; iclass < 2; iclass++) {
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing extrusion of %s forest of level %i\n",
+                             t8_eclass_to_string[eclasses[iclass]], level);
+      cmesh = t8_cmesh_new_hypercube (eclasses[iclass], comm, 0, 0, 0);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+
+      /* Extrude the uniform forest and compare with the uniform forest
+       * on the extruded cmesh */
+      forest_extruded = t8_forest_extrude (forest, num_layers, 2, 1);
+      cmesh_extruded = t8_forest_get_cmesh (forest_extruded);
+      SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh_extruded) ==
+                      num_layers * t8_cmesh_get_num_trees (cmesh),
+                      "Wrong number of extruded trees");
+      t8_cmesh_ref (cmesh_extruded);
+      t8_scheme_cxx_ref (scheme);
+      forest_uniform =
+        t8_forest_new_uniform (cmesh_extruded, scheme, level, 0, comm);
+      SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_extruded) ==
+                      t8_forest_get_global_num_elements (forest_uniform),
+                      "Wrong number of extruded elements");
+      SC_CHECK_ABORT (t8_forest_checksum (forest_extruded) ==
+                      t8_forest_checksum (forest_uniform),
+                      "The extruded forest is not uniform");
+      t8_forest_unref (&forest_uniform);
+      t8_forest_unref (&forest_extruded);
+
+      /* Extrude an adapted forest */
+      forest_adapt =
+        t8_forest_new_adapt (forest, t8_test_extrude_adapt, 0, 0, NULL);
+      forest_extruded = t8_forest_extrude (forest_adapt, num_layers, 2, 1);
+      SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_extruded) ==
+                      t8_test_extrude_num_elements (forest_adapt,
+                                                    num_layers),
+                      "Wrong number of extruded elements");
+      t8_forest_unref (&forest_extruded);
+      t8_forest_unref (&forest_adapt);
+    }
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_extrude (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
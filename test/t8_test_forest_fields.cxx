@@ -0,0 +1,220 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_fields.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we attach two fields to a uniform forest with ghosts.
+ * The first field stores the global tree id of each element as a double
+ * and is averaged on coarsening, the second stores it as t8_gloidx_t and
+ * is copied. We then refine and coarsen the forest and partition it, and
+ * check that each local and ghost element still has its global tree id
+ * in both fields. Finally we adapt only the first tree of a forest that
+ * is consumed by the adaptation. */
+
+/* Refine every element with child id 1 and coarsen every family
+ * of level 2 in the first tree */
+static int
+t8_test_forest_fields_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                             t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                             t8_eclass_scheme_c * ts, int num_elements,
+                             t8_element_t * elements[])
+{
+  int                 level = ts->t8_element_level (elements[0]);
+
+  if (num_elements > 1 && which_tree == 0 && level == 2) {
+    return -1;
+  }
+  if (ts->t8_element_child_id (elements[0]) == 1 && level < 4) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Refine the elements of the first local tree only, such that the other
+ * trees are unchanged */
+static int
+t8_test_forest_fields_adapt_first (t8_forest_t forest,
+                                   t8_forest_t forest_from,
+                                   t8_locidx_t which_tree,
+                                   t8_locidx_t lelement_id,
+                                   t8_eclass_scheme_c * ts,
+                                   int num_elements,
+                                   t8_element_t * elements[])
+{
+  return which_tree == 0;
+}
+
+/* Fill the fields of forest with the global tree ids of its local elements */
+static void
+t8_test_forest_fields_fill (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielement, num_elements, lelement;
+  t8_gloidx_t         gtree;
+  sc_array_t         *average, *copy;
+
+  average = t8_forest_field_get_data (forest, 0);
+  copy = t8_forest_field_get_data (forest, 1);
+  for (itree = 0, lelement = 0;
+       itree < t8_forest_get_num_local_trees (forest); itree++) {
+    gtree = t8_forest_global_tree_id (forest, itree);
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, lelement++) {
+      *(double *) sc_array_index_int (average, lelement) = (double) gtree;
+      *(t8_gloidx_t *) sc_array_index_int (copy, lelement) = gtree;
+    }
+  }
+}
+
+/* Check that both fields of forest hold the global tree id of each
+ * local and ghost element */
+static void
+t8_test_forest_fields_check (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielement, num_elements, lelement;
+  t8_locidx_t         num_local, num_ghosts;
+  t8_gloidx_t         gtree;
+  sc_array_t         *average, *copy;
+
+  SC_CHECK_ABORT (t8_forest_field_num (forest) == 2,
+                  "Wrong number of fields");
+  SC_CHECK_ABORT (t8_forest_field_find (forest, "tree_copy") == 1,
+                  "Field not found");
+  average = t8_forest_field_get_data (forest, 0);
+  copy = t8_forest_field_get_data (forest, 1);
+  num_local = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  SC_CHECK_ABORT (average->elem_count == (size_t) (num_local + num_ghosts)
+                  && copy->elem_count == (size_t) (num_local + num_ghosts),
+                  "Field has wrong length");
+
+  for (itree = 0, lelement = 0;
+       itree < t8_forest_get_num_local_trees (forest); itree++) {
+    gtree = t8_forest_global_tree_id (forest, itree);
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, lelement++) {
+      SC_CHECK_ABORT (*(double *) sc_array_index_int (average, lelement)
+                      == (double) gtree, "Wrong averaged entry");
+      SC_CHECK_ABORT (*(t8_gloidx_t *) sc_array_index_int (copy, lelement)
+                      == gtree, "Wrong copied entry");
+    }
+  }
+  for (itree = 0; itree < t8_forest_ghost_num_trees (forest); itree++) {
+    gtree = t8_forest_ghost_get_global_treeid (forest, itree);
+    num_elements = t8_forest_ghost_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, lelement++) {
+      SC_CHECK_ABORT (*(double *) sc_array_index_int (average, lelement)
+                      == (double) gtree, "Wrong averaged ghost entry");
+      SC_CHECK_ABORT (*(t8_gloidx_t *) sc_array_index_int (copy, lelement)
+                      == gtree, "Wrong copied ghost entry");
+    }
+  }
+}
+
+static void
+t8_test_forest_fields (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_partition;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing forest fields with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 2, 1, comm);
+
+    t8_forest_field_register (forest, "tree_average", sizeof (double),
+                              T8_FOREST_FIELD_AVERAGE, NULL, NULL);
+    t8_forest_field_register (forest, "tree_copy", sizeof (t8_gloidx_t),
+                              T8_FOREST_FIELD_COPY, NULL, NULL);
+    t8_test_forest_fields_fill (forest);
+    t8_forest_field_ghost_exchange (forest);
+    t8_test_forest_fields_check (forest);
+
+    /* Adapt the forest without partitioning it */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest,
+                         t8_test_forest_fields_adapt, 1);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_adapt);
+    t8_test_forest_fields_check (forest_adapt);
+
+    /* Partition the forest together with its fields */
+    t8_forest_init (&forest_partition);
+    t8_forest_set_partition (forest_partition, forest_adapt, 0);
+    t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_partition);
+    t8_test_forest_fields_check (forest_partition);
+
+    /* Adapt the partitioned forest, which we only reference once. Thus
+     * the adapted forest takes over the elements of the unchanged trees. */
+    forest_adapt = forest_partition;
+    t8_forest_init (&forest_partition);
+    t8_forest_set_adapt (forest_partition, forest_adapt,
+                         t8_test_forest_fields_adapt_first, 0);
+    t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_partition);
+    t8_test_forest_fields_check (forest_partition);
+
+    t8_forest_field_unregister (forest_partition, 0);
+    SC_CHECK_ABORT (t8_forest_field_num (forest_partition) == 1
+                    && t8_forest_field_find (forest_partition,
+                                             "tree_average") == -1
+                    && t8_forest_field_find (forest_partition,
+                                             "tree_copy") == 0,
+                    "Unregistering a field failed");
+    t8_forest_unref (&forest_partition);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_fields (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_hierarchy.h>
+
+/* In this test, we build the hierarchy of uniform forests on the
+ * hypercube. We check that the transfer maps are consistent and that
+ * restricting prolongated values gives back the original values.
+ */
+
+static void
+t8_test_hierarchy_check (const t8_forest_hierarchy_t * hierarchy, int level)
+{
+  t8_locidx_t         num_fine, num_coarse, icoarse, ifine;
+  const t8_locidx_t  *offsets, *parents;
+  double             *fine, *coarse, *restricted;
+
+  num_fine = t8_forest_get_num_element (hierarchy->forests[level]);
+  num_coarse = t8_forest_get_num_element (hierarchy->forests[level + 1]);
+  offsets = hierarchy->child_offsets[level];
+  parents = hierarchy->parents[level];
+  SC_CHECK_ABORT (offsets[0] == 0 && offsets[num_coarse] == num_fine,
+                  "Wrong child offsets");
+  for (icoarse = 0; icoarse < num_coarse; icoarse++) {
+    SC_CHECK_ABORT (offsets[icoarse] < offsets[icoarse + 1],
+                    "Element without children");
+    for (ifine = offsets[icoarse]; ifine < offsets[icoarse + 1]; ifine++) {
+      SC_CHECK_ABORT (parents[ifine] == icoarse, "Wrong parent");
+    }
+  }
+
+  fine = T8_ALLOC (double, 2 * num_fine);
+  coarse = T8_ALLOC (double, 2 * num_coarse);
+  restricted = T8_ALLOC (double, 2 * num_coarse);
+  for (icoarse = 0; icoarse < num_coarse; icoarse++) {
+    coarse[2 * icoarse] = icoarse;
+    coarse[2 * icoarse + 1] = -1;
+  }
+  t8_forest_hierarchy_prolongate (hierarchy, level, coarse, fine, 2);
+  t8_forest_hierarchy_restrict (hierarchy, level, fine, restricted, 2);
+  for (icoarse = 0; icoarse < 2 * num_coarse; icoarse++) {
+    SC_CHECK_ABORT (restricted[icoarse] == coarse[icoarse],
+                    "Restriction does not invert prolongation");
+  }
+  T8_FREE (fine);
+  T8_FREE (coarse);
+  T8_FREE (restricted);
+}
+
+static void
+t8_test_hierarchy (sc_MPI_Comm comm)
+{
+  int                 eclass, level;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_hierarchy_t *hierarchy;
+  t8_gloidx_t         num_fine, num_coarse;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing hierarchy with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 3, 0, comm);
+    hierarchy = t8_forest_hierarchy_new (forest, 10, 1);
+    SC_CHECK_ABORT (2 <= hierarchy->num_levels
+                    && hierarchy->num_levels <= 4, "Wrong number of levels");
+    num_fine = t8_forest_get_global_num_elements (hierarchy->forests[0]);
+    num_coarse = t8_forest_get_global_num_elements (hierarchy->forests[1]);
+    SC_CHECK_ABORT (num_coarse < num_fine, "Level 0 was not coarsened");
+    for (level = 0; level < hierarchy->num_levels - 1; level++) {
+      t8_test_hierarchy_check (hierarchy, level);
+    }
+    t8_forest_hierarchy_destroy (&hierarchy);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_hierarchy (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <p4est_extended.h>
+#include <p8est_extended.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_p4est.h>
+
+/* In this test, we build adapted and partitioned p4est and p8est forests,
+ * convert them to t8 forests and back and check that we get the same
+ * quadrants again. Once the t8 forest is referenced elsewhere, which
+ * copies the elements, and once it is not, which moves them.
+ */
+
+/* Refine the quadrants in the lower left corner of each tree */
+static int
+t8_test_p4est_refine (p4est_t * p4est, p4est_topidx_t which_tree,
+                      p4est_quadrant_t * q)
+{
+  return q->level < 4 && q->x == 0 && q->y == 0;
+}
+
+static int
+t8_test_p8est_refine (p8est_t * p8est, p4est_topidx_t which_tree,
+                      p8est_quadrant_t * q)
+{
+  return q->level < 3 && q->x == 0 && q->y == 0 && q->z == 0;
+}
+
+static void
+t8_test_forest_p4est (sc_MPI_Comm comm)
+{
+  p4est_connectivity_t *conn;
+  p4est_t            *p4est;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  p4est_gloidx_t      num_quads;
+  p4est_locidx_t      num_local_quads;
+  unsigned            checksum;
+  int                 do_copy;
+
+  conn = p4est_connectivity_new_brick (3, 2, 0, 0);
+  for (do_copy = 0; do_copy < 2; do_copy++) {
+    t8_global_productionf ("Testing p4est conversion with copy %i\n",
+                           do_copy);
+    p4est = p4est_new_ext (comm, conn, 0, 2, 1, 0, NULL, NULL);
+    p4est_refine (p4est, 1, t8_test_p4est_refine, NULL);
+    p4est_partition (p4est, 0, NULL);
+    num_quads = p4est->global_num_quadrants;
+    num_local_quads = p4est->local_num_quadrants;
+    checksum = p4est_checksum (p4est);
+
+    scheme = t8_scheme_new_default_cxx ();
+    forest = t8_forest_new_from_p4est (&p4est, scheme, 1);
+    SC_CHECK_ABORT (p4est == NULL, "The p4est was not taken over");
+    SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest) == num_quads,
+                    "Wrong number of elements");
+    SC_CHECK_ABORT (t8_forest_get_num_element (forest) == num_local_quads,
+                    "Wrong number of local elements");
+
+    if (do_copy) {
+      t8_forest_ref (forest);
+    }
+    p4est = t8_forest_to_p4est (&forest, conn);
+    SC_CHECK_ABORT (p4est_is_valid (p4est), "Invalid p4est");
+    SC_CHECK_ABORT (p4est->global_num_quadrants == num_quads,
+                    "Wrong number of quadrants");
+    SC_CHECK_ABORT (p4est_checksum (p4est) == checksum,
+                    "The quadrants changed");
+    if (do_copy) {
+      SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest) ==
+                      num_quads, "The forest changed");
+      t8_forest_unref (&forest);
+    }
+    p4est_destroy (p4est);
+  }
+  p4est_connectivity_destroy (conn);
+}
+
+static void
+t8_test_forest_p8est (sc_MPI_Comm comm)
+{
+  p8est_connectivity_t *conn;
+  p8est_t            *p8est;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  p4est_gloidx_t      num_quads;
+  unsigned            checksum;
+
+  t8_global_productionf ("Testing p8est conversion\n");
+  conn = p8est_connectivity_new_brick (2, 2, 1, 0, 0, 0);
+  p8est = p8est_new_ext (comm, conn, 0, 1, 1, 0, NULL, NULL);
+  p8est_refine (p8est, 1, t8_test_p8est_refine, NULL);
+  p8est_partition (p8est, 0, NULL);
+  num_quads = p8est->global_num_quadrants;
+  checksum = p8est_checksum (p8est);
+
+  scheme = t8_scheme_new_default_cxx ();
+  forest = t8_forest_new_from_p8est (&p8est, scheme, 0);
+  SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest) == num_quads,
+                  "Wrong number of elements");
+  p8est = t8_forest_to_p8est (&forest, conn);
+  SC_CHECK_ABORT (p8est_is_valid (p8est), "Invalid p8est");
+  SC_CHECK_ABORT (p8est_checksum (p8est) == checksum,
+                  "The quadrants changed");
+  p8est_destroy (p8est);
+  p8est_connectivity_destroy (conn);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_p4est (mpic);
+  t8_test_forest_p8est (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
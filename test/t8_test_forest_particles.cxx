@@ -0,0 +1,183 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_particles.h>
+#include <t8_forest/t8_forest_locate.h>
+
+/* In this test, we put two particles at the centroid of each element of a
+ * uniform forest, refine the first tree, coarsen the families of the last
+ * tree and repartition. After each step, each particle must lie inside its
+ * element and no particle may be lost. */
+
+static int
+t8_test_particles_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                         t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                         t8_eclass_scheme_c * ts, int num_elements,
+                         t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree;
+
+  gtree = t8_forest_global_tree_id (forest_from, which_tree);
+  if (gtree == 0) {
+    return 1;
+  }
+  if (num_elements > 1
+      && gtree == t8_forest_get_num_global_trees (forest_from) - 1) {
+    return -1;
+  }
+  return 0;
+}
+
+/* Check that each particle is inside its element and return the global sum
+ * of the ids, which are stored in component 3 */
+static double
+t8_test_particles_check (const t8_forest_particles_t * particles)
+{
+  t8_forest_t         forest = particles->forest;
+  t8_locidx_t         itree, tree_elem, ielem, iparticle;
+  double              point[3], local_sum, global_sum;
+  int                 icomp, mpiret;
+
+  local_sum = 0;
+  ielem = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    for (tree_elem = 0;
+         tree_elem < t8_forest_get_tree_num_elements (forest, itree);
+         tree_elem++, ielem++) {
+      for (iparticle = particles->element_offsets[ielem];
+           iparticle < particles->element_offsets[ielem + 1]; iparticle++) {
+        for (icomp = 0; icomp < 3; icomp++) {
+          point[icomp] = particles->components[icomp][iparticle];
+        }
+        SC_CHECK_ABORT (t8_forest_element_point_inside
+                        (forest, itree,
+                         t8_forest_get_element_in_tree (forest, itree,
+                                                        tree_elem), point,
+                         1e-10), "Particle outside of its element");
+        local_sum += particles->components[3][iparticle];
+      }
+    }
+  }
+  SC_CHECK_ABORT (particles->element_offsets[ielem] ==
+                  particles->num_particles, "Wrong number of particles");
+  mpiret = sc_MPI_Allreduce (&local_sum, &global_sum, 1, sc_MPI_DOUBLE,
+                             sc_MPI_SUM, t8_forest_get_mpicomm (forest));
+  SC_CHECK_MPI (mpiret);
+  return global_sum;
+}
+
+static void
+t8_test_particles (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_partition;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_particles_t *particles;
+  t8_locidx_t         itree, tree_elem, ielem, num_elements, *elements;
+  t8_gloidx_t         first_id;
+  double             *values, id_sum;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing particles with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 2, 0, comm);
+
+    /* Two particles at the centroid of each element, with their ids */
+    num_elements = t8_forest_get_num_element (forest);
+    first_id = t8_forest_get_first_local_element_id (forest);
+    elements = T8_ALLOC (t8_locidx_t, 2 * num_elements);
+    values = T8_ALLOC (double, 8 * num_elements);
+    ielem = 0;
+    for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+      for (tree_elem = 0;
+           tree_elem < t8_forest_get_tree_num_elements (forest, itree);
+           tree_elem++, ielem++) {
+        t8_forest_element_centroid (forest, itree,
+                                    t8_forest_get_element_in_tree (forest,
+                                                                   itree,
+                                                                   tree_elem),
+                                    t8_forest_get_tree_vertices (forest,
+                                                                 itree),
+                                    values + 8 * ielem);
+        values[8 * ielem + 3] = 2 * (first_id + ielem);
+        memcpy (values + 8 * ielem + 4, values + 8 * ielem,
+                3 * sizeof (double));
+        values[8 * ielem + 7] = 2 * (first_id + ielem) + 1;
+        elements[2 * ielem] = elements[2 * ielem + 1] = ielem;
+      }
+    }
+    particles = t8_forest_particles_new (forest, 4);
+    t8_forest_particles_add (particles, 2 * num_elements, elements, values);
+    T8_FREE (elements);
+    T8_FREE (values);
+    id_sum = t8_test_particles_check (particles);
+
+    /* The container keeps its own references to the forests */
+    forest_adapt = t8_forest_new_adapt (forest, t8_test_particles_adapt, 0,
+                                        0, NULL);
+    t8_forest_particles_adapt (particles, forest_adapt);
+    SC_CHECK_ABORT (t8_test_particles_check (particles) == id_sum,
+                    "Particles lost in adapt");
+
+    t8_forest_init (&forest_partition);
+    t8_forest_set_partition (forest_partition, forest_adapt, 0);
+    t8_forest_commit (forest_partition);
+    t8_forest_particles_partition (particles, forest_partition);
+    SC_CHECK_ABORT (t8_test_particles_check (particles) == id_sum,
+                    "Particles lost in partition");
+    t8_forest_unref (&forest_partition);
+    t8_forest_particles_destroy (&particles);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_particles (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we save an adapted forest together with the global id of
+ * each element as element data. We load it on the same communicator and
+ * on each process alone and check that the elements and data are the same.
+ */
+
+/* Refine the elements with child id 1 up to level 3 */
+static int
+t8_test_save_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                    t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                    t8_eclass_scheme_c * ts, int num_elements,
+                    t8_element_t * elements[])
+{
+  return ts->t8_element_level (elements[0]) < 3
+    && ts->t8_element_child_id (elements[0]) == 1;
+}
+
+/* Check that the data of each element of a loaded forest is its global id */
+static void
+t8_test_save_check_data (t8_forest_t forest, sc_array_t * data)
+{
+  t8_gloidx_t         first_element;
+  t8_locidx_t         ielem;
+
+  SC_CHECK_ABORT (data->elem_count ==
+                  (size_t) t8_forest_get_num_element (forest),
+                  "Wrong number of loaded data entries");
+  first_element = t8_forest_get_first_local_element_id (forest);
+  for (ielem = 0; ielem < t8_forest_get_num_element (forest); ielem++) {
+    SC_CHECK_ABORT (*(t8_gloidx_t *) sc_array_index_int (data, ielem) ==
+                    first_element + ielem, "Wrong loaded element data");
+  }
+}
+
+static void
+t8_test_save_load (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_load, forest_self;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_element_cursor_t cursor, cursor_self;
+  t8_gloidx_t         first_element, ielem;
+  sc_array_t          data;
+  const char         *filename = "test_forest_save.t8f";
+  int                 eclass;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing forest save and load with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 1, 0, comm);
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_save_adapt, 1);
+    t8_forest_commit (forest_adapt);
+
+    /* Save the forest with the global element ids as data */
+    first_element = t8_forest_get_first_local_element_id (forest_adapt);
+    sc_array_init_size (&data, sizeof (t8_gloidx_t),
+                        t8_forest_get_num_element (forest_adapt));
+    for (ielem = 0; ielem < t8_forest_get_num_element (forest_adapt);
+         ielem++) {
+      *(t8_gloidx_t *) sc_array_index_int (&data, ielem) =
+        first_element + ielem;
+    }
+    SC_CHECK_ABORT (t8_forest_save (forest_adapt, filename, &data),
+                    "Could not save the forest");
+    sc_array_reset (&data);
+
+    /* Load the forest on the same processes */
+    sc_array_init (&data, sizeof (t8_gloidx_t));
+    t8_cmesh_ref (cmesh);
+    t8_scheme_cxx_ref (scheme);
+    forest_load = t8_forest_load (filename, cmesh, scheme, 0, comm, &data);
+    SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_load) ==
+                    t8_forest_get_global_num_elements (forest_adapt),
+                    "Wrong number of loaded elements");
+    t8_test_save_check_data (forest_load, &data);
+    sc_array_reset (&data);
+    t8_forest_unref (&forest_load);
+
+    /* Load the whole forest on each process and compare the elements
+     * of the saved forest to it */
+    sc_array_init (&data, sizeof (t8_gloidx_t));
+    t8_scheme_cxx_ref (scheme);
+    forest_self =
+      t8_forest_load (filename,
+                      t8_cmesh_new_hypercube ((t8_eclass_t) eclass,
+                                              sc_MPI_COMM_SELF, 0, 0, 0),
+                      scheme, 0, sc_MPI_COMM_SELF, &data);
+    t8_test_save_check_data (forest_self, &data);
+    sc_array_reset (&data);
+    t8_forest_element_cursor_init (forest_self, &cursor_self);
+    for (ielem = 0; ielem < first_element; ielem++) {
+      t8_forest_element_cursor_next (&cursor_self);
+    }
+    t8_forest_element_cursor_init (forest_adapt, &cursor);
+    while (t8_forest_element_cursor_next (&cursor)) {
+      SC_CHECK_ABORT (t8_forest_element_cursor_next (&cursor_self),
+                      "Too few loaded elements");
+      SC_CHECK_ABORT (t8_forest_global_tree_id (forest_adapt, cursor.ltreeid)
+                      == t8_forest_global_tree_id (forest_self,
+                                                   cursor_self.ltreeid),
+                      "Loaded element has the wrong tree");
+      SC_CHECK_ABORT (!cursor.ts->t8_element_compare (cursor.element,
+                                                      cursor_self.element)
+                      && cursor.ts->t8_element_level (cursor.element) ==
+                      cursor.ts->t8_element_level (cursor_self.element),
+                      "Loaded element is not equal to the saved one");
+    }
+    t8_forest_unref (&forest_self);
+    t8_forest_unref (&forest_adapt);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_save_load (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_transfer.h>
+
+/* In this test, we transfer element data from a uniform forest to an
+ * adapted and repartitioned forest on the same cmesh and back.
+ * Constant values must stay constant, averaging must conserve the integral
+ * of the values and transferring a forest to itself must not change them.
+ */
+
+/* Coarsen the families in odd trees and refine every third element */
+static int
+t8_test_transfer_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                        t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                        t8_eclass_scheme_c * ts, int num_elements,
+                        t8_element_t * elements[])
+{
+  if (num_elements > 1
+      && t8_forest_global_tree_id (forest_from, which_tree) % 2 == 1) {
+    return -1;
+  }
+  return lelement_id % 3 == 0;
+}
+
+/* Compute the integral of element values, with the volume of an element
+ * of level l being 2^(-dim l). */
+static double
+t8_test_transfer_integral (t8_forest_t forest, const double *values)
+{
+  t8_locidx_t         num_elems, ielem, ltreeid;
+  t8_element_t       *elem;
+  t8_eclass_scheme_c *ts;
+  t8_eclass_t         eclass;
+  double              local_sum, global_sum;
+  int                 mpiret;
+
+  num_elems = t8_forest_get_num_element (forest);
+  local_sum = 0;
+  for (ielem = 0; ielem < num_elems; ielem++) {
+    elem = t8_forest_get_element (forest, ielem, &ltreeid);
+    eclass = t8_forest_get_tree_class (forest, ltreeid);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    local_sum += values[ielem] /
+      (1 << (t8_eclass_to_dimension[eclass] * ts->t8_element_level (elem)));
+  }
+  mpiret = sc_MPI_Allreduce (&local_sum, &global_sum, 1, sc_MPI_DOUBLE,
+                             sc_MPI_SUM, t8_forest_get_mpicomm (forest));
+  SC_CHECK_MPI (mpiret);
+  return global_sum;
+}
+
+static void
+t8_test_transfer (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         source, target;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_transfer_t *to_target, *to_source, *identity;
+  t8_locidx_t         num_source, num_target, ielem;
+  double             *source_data, *target_data, *back_data;
+  double              integral;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing data transfer with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    source = t8_forest_new_uniform (cmesh, scheme, 2, 0, comm);
+    t8_forest_init (&target);
+    t8_forest_ref (source);
+    t8_forest_set_adapt (target, source, t8_test_transfer_adapt, 0);
+    t8_forest_set_partition (target, NULL, 0);
+    t8_forest_commit (target);
+
+    to_target = t8_forest_transfer_new (source, target);
+    to_source = t8_forest_transfer_new (target, source);
+    identity = t8_forest_transfer_new (source, source);
+    num_source = t8_forest_get_num_element (source);
+    num_target = t8_forest_get_num_element (target);
+    source_data = T8_ALLOC (double, num_source);
+    target_data = T8_ALLOC (double, num_target);
+    back_data = T8_ALLOC (double, num_source);
+
+    /* Constant values */
+    for (ielem = 0; ielem < num_source; ielem++) {
+      source_data[ielem] = 2;
+    }
+    t8_forest_transfer_data (to_target, source_data, target_data, 1,
+                             T8_FOREST_TRANSFER_INJECT);
+    for (ielem = 0; ielem < num_target; ielem++) {
+      SC_CHECK_ABORT (target_data[ielem] == 2, "Injection changed a constant");
+    }
+
+    /* Conservation and identity */
+    for (ielem = 0; ielem < num_source; ielem++) {
+      source_data[ielem] =
+        (t8_forest_get_first_local_element_id (source) + ielem) % 7;
+    }
+    integral = t8_test_transfer_integral (source, source_data);
+    t8_forest_transfer_data (to_target, source_data, target_data, 1,
+                             T8_FOREST_TRANSFER_AVERAGE);
+    SC_CHECK_ABORT (fabs (t8_test_transfer_integral (target, target_data) -
+                          integral) < 1e-10 * integral,
+                    "Averaging does not conserve the integral");
+    t8_forest_transfer_data (to_source, target_data, back_data, 1,
+                             T8_FOREST_TRANSFER_AVERAGE);
+    SC_CHECK_ABORT (fabs (t8_test_transfer_integral (source, back_data) -
+                          integral) < 1e-10 * integral,
+                    "Averaging back does not conserve the integral");
+    t8_forest_transfer_data (identity, source_data, back_data, 1,
+                             T8_FOREST_TRANSFER_INJECT);
+    for (ielem = 0; ielem < num_source; ielem++) {
+      SC_CHECK_ABORT (back_data[ielem] == source_data[ielem],
+                      "Transfer to the same forest changed a value");
+    }
+
+    T8_FREE (source_data);
+    T8_FREE (target_data);
+    T8_FREE (back_data);
+    t8_forest_transfer_destroy (&to_target);
+    t8_forest_transfer_destroy (&to_source);
+    t8_forest_transfer_destroy (&identity);
+    t8_forest_unref (&source);
+    t8_forest_unref (&target);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_transfer (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -37,6 +37,8 @@
  * coarse meshes.
  * One test is an integer entry '42' for each element,
  * in a second test, we store the element's linear id in the data array.
+ * A third test performs the exchange in two phases and fills the entries of
+ * the interior elements while communicating.
  */
 
 static int
@@ -190,13 +192,360 @@ t8_test_ghost_exchange_data_int (t8_forest_t forest)
   sc_array_reset (&element_data);
 }
 
+/* Split the elements into interior and boundary elements. Construct a data
+ * array of ints for all elements and all ghosts, fill the boundary
+ * element's entries with '42' and the interior element's entries with
+ * '-1' and start the ghost exchange. While communicating, fill the
+ * interior element's entries with '42' and end the exchange.
+ * Since no interior element is a ghost of another process, we then check
+ * whether the ghost's entries are '42'.
+ */
+static void
+t8_test_ghost_exchange_data_split (t8_forest_t forest)
+{
+  sc_array_t          element_data;
+  sc_array_t          interior, boundary;
+  t8_ghost_data_exchange_t *data_exchange;
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  size_t              iindex;
+  int                 ghost_int;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  /* Allocate an integer as data for each element and each ghost */
+  sc_array_init_size (&element_data, sizeof (int), num_elements + num_ghosts);
+
+  /* Split the elements into interior and boundary elements */
+  sc_array_init (&interior, sizeof (t8_locidx_t));
+  sc_array_init (&boundary, sizeof (t8_locidx_t));
+  t8_forest_ghost_split_elements (forest, &interior, &boundary);
+  SC_CHECK_ABORT ((t8_locidx_t) (interior.elem_count + boundary.elem_count)
+                  == num_elements, "Wrong number of interior and boundary "
+                  "elements.\n");
+
+  /* Fill the boundary element entries with the integer 42 and the
+   * interior element entries with -1 */
+  for (iindex = 0; iindex < boundary.elem_count; iindex++) {
+    ielem = *(t8_locidx_t *) sc_array_index (&boundary, iindex);
+    *(int *) t8_sc_array_index_locidx (&element_data, ielem) = 42;
+  }
+  for (iindex = 0; iindex < interior.elem_count; iindex++) {
+    ielem = *(t8_locidx_t *) sc_array_index (&interior, iindex);
+    *(int *) t8_sc_array_index_locidx (&element_data, ielem) = -1;
+  }
+  /* Start the ghost data exchange */
+  data_exchange = t8_forest_ghost_exchange_begin (forest, &element_data);
+  /* Fill the interior element entries while communicating */
+  for (iindex = 0; iindex < interior.elem_count; iindex++) {
+    ielem = *(t8_locidx_t *) sc_array_index (&interior, iindex);
+    *(int *) t8_sc_array_index_locidx (&element_data, ielem) = 42;
+  }
+  (void) t8_forest_ghost_exchange_test (data_exchange);
+  t8_forest_ghost_exchange_end (data_exchange);
+
+  /* Check for the ghosts that we received the correct data */
+  for (ielem = 0; ielem < num_ghosts; ielem++) {
+    /* Get the integer for this ghost */
+    ghost_int =
+      *(int *) t8_sc_array_index_locidx (&element_data, num_elements + ielem);
+    SC_CHECK_ABORT (ghost_int == 42,
+                    "Error when exchanging ghost data in two phases. "
+                    "Received wrong data.\n");
+  }
+  /* clean-up */
+  sc_array_reset (&element_data);
+  sc_array_reset (&interior);
+  sc_array_reset (&boundary);
+}
+
+/* The data of one element for the multi-field exchange test */
+typedef struct
+{
+  int                 value;
+  double              weight;
+} t8_test_ghost_struct_t;
+
+/* Construct an array of structs for all elements and all ghosts and a
+ * separate array of ints. Exchange the members of the structs and the
+ * int array as three fields in one exchange and check the ghost entries.
+ */
+static void
+t8_test_ghost_exchange_data_fields (t8_forest_t forest)
+{
+  t8_test_ghost_struct_t *structs;
+  int                *ints;
+  t8_ghost_field_t    fields[3];
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  structs = T8_ALLOC_ZERO (t8_test_ghost_struct_t, num_elements + num_ghosts);
+  ints = T8_ALLOC_ZERO (int, num_elements + num_ghosts);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    structs[ielem].value = 42;
+    structs[ielem].weight = 0.5;
+    ints[ielem] = 7;
+  }
+  fields[0].data = &structs[0].value;
+  fields[0].size = sizeof (int);
+  fields[0].stride = sizeof (t8_test_ghost_struct_t);
+  fields[1].data = &structs[0].weight;
+  fields[1].size = sizeof (double);
+  fields[1].stride = sizeof (t8_test_ghost_struct_t);
+  fields[2].data = ints;
+  fields[2].size = fields[2].stride = sizeof (int);
+  t8_forest_ghost_exchange_fields (forest, 3, fields);
+
+  for (ielem = num_elements; ielem < num_elements + num_ghosts; ielem++) {
+    SC_CHECK_ABORT (structs[ielem].value == 42
+                    && structs[ielem].weight == 0.5 && ints[ielem] == 7,
+                    "Error when exchanging ghost fields. Received wrong data.\n");
+  }
+  T8_FREE (structs);
+  T8_FREE (ints);
+}
+
+/* Sort the elements by level and fill their entries with their level.
+ * Exchange the levels greater or equal min_level and check that exactly
+ * the ghosts of these levels received their level. */
+static void
+t8_test_ghost_exchange_data_levels (t8_forest_t forest, int min_level)
+{
+  t8_eclass_scheme_c *ts;
+  sc_array_t          element_data, level_offsets, elements;
+  t8_locidx_t         num_elements, num_ghosts, itree, ielem, ghost_pos;
+  t8_locidx_t        *offsets;
+  int                 level, ghost_int;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&element_data, sizeof (int), num_elements + num_ghosts);
+  sc_array_init (&level_offsets, sizeof (t8_locidx_t));
+  sc_array_init (&elements, sizeof (t8_locidx_t));
+  t8_forest_split_levels (forest, &level_offsets, &elements);
+  offsets = (t8_locidx_t *) level_offsets.array;
+  SC_CHECK_ABORT ((t8_locidx_t) elements.elem_count == num_elements
+                  && offsets[level_offsets.elem_count - 1] == num_elements,
+                  "Wrong number of elements in the level lists.\n");
+  /* Fill the local entries with their level and the ghost entries with -1 */
+  for (level = 0; level + 1 < (int) level_offsets.elem_count; level++) {
+    for (ielem = offsets[level]; ielem < offsets[level + 1]; ielem++) {
+      *(int *) t8_sc_array_index_locidx (&element_data,
+                                         *(t8_locidx_t *)
+                                         t8_sc_array_index_locidx (&elements,
+                                                                   ielem)) =
+        level;
+    }
+  }
+  for (ielem = 0; ielem < num_ghosts; ielem++) {
+    *(int *) t8_sc_array_index_locidx (&element_data, num_elements + ielem) =
+      -1;
+  }
+  t8_forest_ghost_exchange_levels (forest, &element_data, min_level);
+
+  for (itree = 0, ghost_pos = num_elements;
+       itree < t8_forest_get_num_ghost_trees (forest); itree++) {
+    ts =
+      t8_forest_get_eclass_scheme (forest,
+                                   t8_forest_ghost_get_tree_class (forest,
+                                                                   itree));
+    for (ielem = 0; ielem < t8_forest_ghost_tree_num_elements (forest, itree);
+         ielem++, ghost_pos++) {
+      level =
+        ts->t8_element_level (t8_forest_ghost_get_element
+                              (forest, itree, ielem));
+      ghost_int =
+        *(int *) t8_sc_array_index_locidx (&element_data, ghost_pos);
+      SC_CHECK_ABORT (ghost_int == (level >= min_level ? level : -1),
+                      "Error when exchanging ghost levels. Received wrong data.\n");
+    }
+  }
+  sc_array_reset (&element_data);
+  sc_array_reset (&level_offsets);
+  sc_array_reset (&elements);
+}
+
+/* Construct a data array with an entry for each face of each element and
+ * ghost, fill the entries of the local elements from their linear id and
+ * face and exchange the face data. We then check that each received entry
+ * belongs to its ghost and face and that each ghost received a face.
+ * The forest must be balanced. */
+static void
+t8_test_ghost_exchange_data_faces (t8_forest_t forest)
+{
+  t8_eclass_scheme_c *ts;
+  t8_locidx_t         num_elements, ielem, num_ghosts, itree;
+  t8_linearidx_t      elem_id, entry, unset;
+  t8_element_t       *elem;
+  size_t              array_pos = 0;
+  sc_array_t          face_data;
+  int                 iface, num_received;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&face_data, sizeof (t8_linearidx_t),
+                      (num_elements + num_ghosts) * T8_ECLASS_MAX_FACES);
+  unset = (t8_linearidx_t) - 1;
+
+  /* Fill the face entries of the local elements */
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielem = 0; ielem < t8_forest_get_tree_num_elements (forest, itree);
+         ielem++, array_pos++) {
+      elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+      elem_id = ts->t8_element_get_linear_id (elem,
+                                              ts->t8_element_level (elem));
+      for (iface = 0; iface < T8_ECLASS_MAX_FACES; iface++) {
+        *(t8_linearidx_t *) sc_array_index (&face_data,
+                                            array_pos * T8_ECLASS_MAX_FACES +
+                                            iface) =
+          elem_id * T8_ECLASS_MAX_FACES + iface;
+      }
+    }
+  }
+  for (ielem = 0; ielem < num_ghosts * T8_ECLASS_MAX_FACES; ielem++) {
+    *(t8_linearidx_t *) sc_array_index (&face_data,
+                                        num_elements * T8_ECLASS_MAX_FACES +
+                                        ielem) = unset;
+  }
+
+  t8_forest_ghost_exchange_faces (forest, &face_data, T8_ECLASS_MAX_FACES);
+
+  for (itree = 0; itree < t8_forest_get_num_ghost_trees (forest); itree++) {
+    ts =
+      t8_forest_get_eclass_scheme (forest,
+                                   t8_forest_ghost_get_tree_class (forest,
+                                                                   itree));
+    for (ielem = 0; ielem < t8_forest_ghost_tree_num_elements (forest, itree);
+         ielem++, array_pos++) {
+      elem = t8_forest_ghost_get_element (forest, itree, ielem);
+      elem_id = ts->t8_element_get_linear_id (elem,
+                                              ts->t8_element_level (elem));
+      num_received = 0;
+      for (iface = 0; iface < T8_ECLASS_MAX_FACES; iface++) {
+        entry =
+          *(t8_linearidx_t *) sc_array_index (&face_data,
+                                              array_pos *
+                                              T8_ECLASS_MAX_FACES + iface);
+        if (entry != unset) {
+          SC_CHECK_ABORT (entry == elem_id * T8_ECLASS_MAX_FACES + iface,
+                          "Error when exchanging ghost faces. Received wrong data.\n");
+          num_received++;
+        }
+      }
+      SC_CHECK_ABORT (num_received > 0,
+                      "Error when exchanging ghost faces. A ghost received no face.\n");
+    }
+  }
+  sc_array_reset (&face_data);
+}
+
+/* Construct a data array of uint64_t for all elements and all ghosts and
+ * exchange it. Change the entries of every second local element, exchange
+ * only those and check that the result equals a full exchange. */
+static void
+t8_test_ghost_exchange_data_changed (t8_forest_t forest)
+{
+  t8_locidx_t         num_elements, ielem, num_ghosts;
+  sc_array_t          element_data, full_data;
+  int8_t             *changed;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  sc_array_init_size (&element_data, sizeof (t8_linearidx_t),
+                      num_elements + num_ghosts);
+  sc_array_init_size (&full_data, sizeof (t8_linearidx_t),
+                      num_elements + num_ghosts);
+  changed = T8_ALLOC_ZERO (int8_t, num_elements);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    *(t8_linearidx_t *) sc_array_index (&element_data, ielem) =
+      t8_forest_get_first_local_element_id (forest) + ielem;
+  }
+  t8_forest_ghost_exchange_data (forest, &element_data);
+
+  /* Change every second element */
+  for (ielem = 0; ielem < num_elements; ielem += 2) {
+    *(t8_linearidx_t *) sc_array_index (&element_data, ielem) += 1;
+    changed[ielem] = 1;
+  }
+  sc_array_copy (&full_data, &element_data);
+  t8_forest_ghost_exchange_changed (forest, &element_data, changed);
+  t8_forest_ghost_exchange_data (forest, &full_data);
+  SC_CHECK_ABORT (num_elements + num_ghosts == 0
+                  || !memcmp (element_data.array, full_data.array,
+                              (num_elements + num_ghosts)
+                              * sizeof (t8_linearidx_t)),
+                  "Error when exchanging changed ghosts. Received wrong data.\n");
+  T8_FREE (changed);
+  sc_array_reset (&element_data);
+  sc_array_reset (&full_data);
+}
+
+/* Check the level lists of a forest against the levels of its elements
+ * and ghosts */
+static void
+t8_test_ghost_level_lists (t8_forest_t forest)
+{
+  t8_eclass_scheme_c *ts;
+  const t8_locidx_t  *entries;
+  t8_locidx_t         itree, ielem, ientry, num_entries, lelement;
+  t8_locidx_t         num_found = 0, num_ghosts_found = 0;
+  int                 level, maxlevel;
+
+  maxlevel = t8_forest_get_maxlevel_existing (forest);
+  SC_CHECK_ABORT (maxlevel >= 0, "Maximum level not computed.\n");
+  for (level = 0; level <= maxlevel + 1; level++) {
+    num_entries = t8_forest_get_level_elements (forest, level, &entries);
+    for (ientry = 0; ientry < num_entries; ientry++) {
+      lelement = entries[ientry];
+      SC_CHECK_ABORT (ientry == 0 || entries[ientry - 1] < lelement,
+                      "Level list is not sorted.\n");
+      for (itree = 0;
+           lelement >= t8_forest_get_tree_num_elements (forest, itree);
+           itree++) {
+        lelement -= t8_forest_get_tree_num_elements (forest, itree);
+      }
+      ts = t8_forest_get_eclass_scheme (forest,
+                                        t8_forest_get_tree_class (forest,
+                                                                  itree));
+      SC_CHECK_ABORT (ts->t8_element_level
+                      (t8_forest_get_element_in_tree (forest, itree,
+                                                      lelement)) == level,
+                      "Element in wrong level list.\n");
+    }
+    num_found += num_entries;
+    num_entries = t8_forest_get_level_ghosts (forest, level, &entries);
+    for (ientry = 0; ientry < num_entries; ientry++) {
+      ielem = entries[ientry];
+      for (itree = 0;
+           ielem >= t8_forest_ghost_tree_num_elements (forest, itree);
+           itree++) {
+        ielem -= t8_forest_ghost_tree_num_elements (forest, itree);
+      }
+      ts = t8_forest_get_eclass_scheme (forest,
+                                        t8_forest_ghost_get_tree_class
+                                        (forest, itree));
+      SC_CHECK_ABORT (ts->t8_element_level
+                      (t8_forest_ghost_get_element (forest, itree,
+                                                    ielem)) == level,
+                      "Ghost in wrong level list.\n");
+    }
+    num_ghosts_found += num_entries;
+  }
+  SC_CHECK_ABORT (num_found == t8_forest_get_num_element (forest)
+                  && num_ghosts_found == t8_forest_get_num_ghosts (forest),
+                  "Wrong number of entries in the level lists.\n");
+}
+
 static void
 t8_test_ghost_exchange ()
 {
   int                 ctype, level, min_level, maxlevel;
   int                 eclass;
   t8_cmesh_t          cmesh;
-  t8_forest_t         forest, forest_adapt;
+  t8_forest_t         forest, forest_adapt, forest_neighbor, forest_lists;
   t8_scheme_cxx_t    *scheme;
 
   scheme = t8_scheme_new_default_cxx ();
@@ -223,15 +572,42 @@ t8_test_ghost_exchange ()
                                         sc_MPI_COMM_WORLD);
         /* exchange ghost data */
         t8_test_ghost_exchange_data_int (forest);
+        t8_test_ghost_exchange_data_split (forest);
         t8_test_ghost_exchange_data_id (forest);
+        t8_test_ghost_exchange_data_fields (forest);
+        t8_test_ghost_exchange_data_faces (forest);
+        /* Copy the forest with a neighborhood collective ghost layer
+         * and exchange data again */
+        t8_forest_ref (forest);
+        t8_forest_init (&forest_neighbor);
+        t8_forest_set_copy (forest_neighbor, forest);
+        t8_forest_set_ghost (forest_neighbor, 1, T8_GHOST_FACES);
+        t8_forest_set_ghost_neighborhood (forest_neighbor, 1);
+        t8_forest_commit (forest_neighbor);
+        t8_test_ghost_exchange_data_int (forest_neighbor);
+        t8_test_ghost_exchange_data_split (forest_neighbor);
+        t8_test_ghost_exchange_data_id (forest_neighbor);
+        t8_forest_unref (&forest_neighbor);
         /* Adapt the forest and exchange data again */
         maxlevel = level + 2;
         forest_adapt =
           t8_forest_new_adapt (forest, t8_test_exchange_adapt, 1, 1,
                                &maxlevel);
         t8_test_ghost_exchange_data_int (forest_adapt);
+        t8_test_ghost_exchange_data_split (forest_adapt);
         t8_test_ghost_exchange_data_id (forest_adapt);
-        t8_forest_unref (&forest_adapt);
+        t8_test_ghost_exchange_data_levels (forest_adapt, level + 1);
+        t8_test_ghost_exchange_data_levels (forest_adapt, 0);
+        t8_test_ghost_exchange_data_changed (forest_adapt);
+        /* Copy the adapted forest with level lists and exchange again */
+        t8_forest_init (&forest_lists);
+        t8_forest_set_copy (forest_lists, forest_adapt);
+        t8_forest_set_ghost (forest_lists, 1, T8_GHOST_FACES);
+        t8_forest_set_level_lists (forest_lists, 1);
+        t8_forest_commit (forest_lists);
+        t8_test_ghost_level_lists (forest_lists);
+        t8_test_ghost_exchange_data_levels (forest_lists, level + 1);
+        t8_forest_unref (&forest_lists);
       }
       t8_cmesh_destroy (&cmesh);
     }
@@ -0,0 +1,215 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we build uniform and adapted forests of quads and hexes
+ * with the Hilbert scheme. We check that consecutive elements of a uniform
+ * forest share a face, which holds for the Hilbert order but not for the
+ * Morton order, and that the linear ids, children and descendants of the
+ * elements are consistent with the order.
+ */
+
+/* Refine every element whose child id equals its level modulo the
+ * number of children. */
+static int
+t8_test_hilbert_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  int                 level, num_children;
+
+  level = ts->t8_element_level (elements[0]);
+  num_children = ts->t8_element_num_children (elements[0]);
+  if (level < 4
+      && ts->t8_element_child_id (elements[0]) == level % num_children) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Check that two elements of the same level share a face */
+static void
+t8_test_hilbert_neighbors (t8_eclass_scheme_c * ts, int dim,
+                           const t8_element_t * elem1,
+                           const t8_element_t * elem2)
+{
+  int                 anchor1[3], anchor2[3], idim, len, dist;
+
+  len = ts->t8_element_root_len (elem1) >> ts->t8_element_level (elem1);
+  ts->t8_element_anchor (elem1, anchor1);
+  ts->t8_element_anchor (elem2, anchor2);
+  dist = 0;
+  for (idim = 0; idim < dim; idim++) {
+    dist += SC_MAX (anchor1[idim], anchor2[idim])
+      - SC_MIN (anchor1[idim], anchor2[idim]);
+  }
+  SC_CHECK_ABORT (dist == len, "Consecutive elements do not share a face");
+}
+
+/* Check the element functions of a scheme for one element */
+static void
+t8_test_hilbert_element (t8_eclass_scheme_c * ts, const t8_element_t * elem)
+{
+  t8_element_t       *test, *children[8], *desc;
+  t8_linearidx_t      id;
+  int                 level, num_children, ichild;
+
+  level = ts->t8_element_level (elem);
+  num_children = ts->t8_element_num_children (elem);
+  ts->t8_element_new (1, &test);
+  ts->t8_element_new (1, &desc);
+  ts->t8_element_new (num_children, children);
+
+  /* The linear id determines the element */
+  id = ts->t8_element_get_linear_id (elem, level);
+  ts->t8_element_set_linear_id (test, level, id);
+  SC_CHECK_ABORT (!ts->t8_element_compare (elem, test),
+                  "Linear id does not match the element");
+
+  /* The children are consecutive and start with the first descendant */
+  ts->t8_element_children (elem, num_children, children);
+  SC_CHECK_ABORT (ts->t8_element_is_family (children),
+                  "The children are not a family");
+  for (ichild = 0; ichild < num_children; ichild++) {
+    SC_CHECK_ABORT (ts->t8_element_child_id (children[ichild]) == ichild,
+                    "Wrong child id");
+    SC_CHECK_ABORT (ts->t8_element_get_linear_id (children[ichild],
+                                                  level + 1) ==
+                    ts->t8_element_get_linear_id (elem, level + 1) + ichild,
+                    "The children are not consecutive");
+    SC_CHECK_ABORT (ts->t8_element_compare (elem, children[ichild]) < 0,
+                    "A child is not larger than its parent");
+    ts->t8_element_parent (children[ichild], test);
+    SC_CHECK_ABORT (!ts->t8_element_compare (elem, test), "Wrong parent");
+  }
+  ts->t8_element_first_descendant (elem, desc, level + 1);
+  SC_CHECK_ABORT (!ts->t8_element_compare (desc, children[0]),
+                  "Wrong first descendant");
+  ts->t8_element_last_descendant (elem, desc, level + 1);
+  SC_CHECK_ABORT (!ts->t8_element_compare (desc,
+                                           children[num_children - 1]),
+                  "Wrong last descendant");
+  for (ichild = 0; ichild + 1 < num_children; ichild++) {
+    ts->t8_element_successor (children[ichild], test, level + 1);
+    SC_CHECK_ABORT (!ts->t8_element_compare (test, children[ichild + 1]),
+                    "Wrong successor");
+  }
+
+  ts->t8_element_destroy (1, &test);
+  ts->t8_element_destroy (1, &desc);
+  ts->t8_element_destroy (num_children, children);
+}
+
+/* Check the elements of all local trees of a forest */
+static void
+t8_test_hilbert_check (t8_forest_t forest, int uniform)
+{
+  t8_locidx_t         itree, ielem, num_elems;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *elem, *prev;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielem = 0; ielem < num_elems; ielem++) {
+      elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+      t8_test_hilbert_element (ts, elem);
+      if (ielem > 0) {
+        prev = t8_forest_get_element_in_tree (forest, itree, ielem - 1);
+        SC_CHECK_ABORT (ts->t8_element_compare (prev, elem) < 0,
+                        "The elements are not sorted");
+        if (uniform) {
+          t8_test_hilbert_neighbors (ts, t8_eclass_to_dimension[eclass],
+                                     prev, elem);
+        }
+      }
+    }
+  }
+}
+
+static void
+t8_test_hilbert_scheme ()
+{
+  int                 level;
+  int                 ieclass;
+  t8_eclass_t         eclasses[2] = { T8_ECLASS_QUAD, T8_ECLASS_HEX };
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_hilbert_cxx ();
+  for (ieclass = 0; ieclass < 2; ieclass++) {
+    cmesh = t8_cmesh_new_hypercube (eclasses[ieclass], sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 4; level++) {
+      t8_global_productionf
+        ("Testing Hilbert scheme with eclass %s, level %i\n",
+         t8_eclass_to_string[eclasses[ieclass]], level);
+      /* ref the cmesh and scheme since we reuse them */
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                      sc_MPI_COMM_WORLD);
+      t8_test_hilbert_check (forest, 1);
+      t8_forest_init (&forest_adapt);
+      t8_forest_set_adapt (forest_adapt, forest, t8_test_hilbert_adapt, 1);
+      t8_forest_set_partition (forest_adapt, NULL, 0);
+      t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+      t8_forest_commit (forest_adapt);
+      t8_test_hilbert_check (forest_adapt, 0);
+      t8_forest_unref (&forest_adapt);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_hilbert_scheme ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
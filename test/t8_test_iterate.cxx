@@ -0,0 +1,231 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_types.h>
+
+/* In this test, we call t8_forest_iterate on a uniform forest and on an
+ * adapted, balanced forest with hanging faces. We count how often each
+ * local leaf and each face of a local leaf is reported and check that
+ * every count is exactly one.
+ * We iterate once using the face neighbor table of the forest and once
+ * computing the neighbors on the fly.
+ * The coarse meshes are a periodic square of quads and triangles, a
+ * periodic square of two triangles, a periodic cube and a cube of six
+ * tetrahedra. We refine the trees with odd global id on even processes and
+ * the trees with even global id on odd processes, such that there are
+ * hanging faces between different element classes and between local leafs
+ * and ghosts, whose faces must only be reported once.
+ */
+
+typedef struct
+{
+  t8_locidx_t         num_elements;
+  int                *volume_count;
+  int                *face_count;       /* T8_ECLASS_MAX_FACES entries per leaf */
+} t8_test_iterate_counts_t;
+
+/* Refine the elements of trees whose global id plus the rank of the
+ * process is odd up to level 3 */
+static int
+t8_test_iterate_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree;
+
+  gtree = t8_forest_global_tree_id (forest_from, which_tree);
+  if (ts->t8_element_level (elements[0]) < 3
+      && (gtree + forest_from->mpirank) % 2) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Build the coarse mesh of the test case icase */
+static t8_cmesh_t
+t8_test_iterate_cmesh (int icase, sc_MPI_Comm comm)
+{
+  switch (icase) {
+  case 0:
+    return t8_cmesh_new_periodic_hybrid (comm);
+  case 1:
+    return t8_cmesh_new_hypercube (T8_ECLASS_TRIANGLE, comm, 0, 0, 1);
+  case 2:
+    return t8_cmesh_new_hypercube (T8_ECLASS_HEX, comm, 0, 0, 1);
+  default:
+    return t8_cmesh_new_hypercube (T8_ECLASS_TET, comm, 0, 0, 0);
+  }
+}
+
+static void
+t8_test_iterate_volume (t8_forest_t forest, t8_locidx_t ltreeid,
+                        const t8_element_t * element,
+                        t8_locidx_t lelement_id, void *user_data)
+{
+  t8_test_iterate_counts_t *counts = (t8_test_iterate_counts_t *) user_data;
+
+  SC_CHECK_ABORT (0 <= lelement_id && lelement_id < counts->num_elements,
+                  "Invalid element index");
+  counts->volume_count[lelement_id]++;
+}
+
+static void
+t8_test_iterate_face (t8_forest_t forest, t8_locidx_t ltreeid,
+                      const t8_element_t * element, t8_locidx_t lelement_id,
+                      int face, int num_neighbors,
+                      const t8_locidx_t * neighbors, const int *dual_faces,
+                      int level_diff, void *user_data)
+{
+  t8_test_iterate_counts_t *counts = (t8_test_iterate_counts_t *) user_data;
+  int                 ineigh;
+
+  SC_CHECK_ABORT (0 <= lelement_id && lelement_id < counts->num_elements,
+                  "Invalid element index");
+  SC_CHECK_ABORT (0 <= face && face < T8_ECLASS_MAX_FACES, "Invalid face");
+  counts->face_count[lelement_id * T8_ECLASS_MAX_FACES + face]++;
+  for (ineigh = 0; ineigh < num_neighbors; ineigh++) {
+    if (neighbors[ineigh] < counts->num_elements) {
+      /* A local neighbor, its side of the face is visited as well */
+      counts->face_count[neighbors[ineigh] * T8_ECLASS_MAX_FACES +
+                         dual_faces[ineigh]]++;
+    }
+  }
+}
+
+static void
+t8_test_iterate_run (t8_forest_t forest)
+{
+  t8_test_iterate_counts_t counts;
+  t8_locidx_t         ielem, ltree;
+  t8_element_t       *leaf;
+  t8_eclass_scheme_c *ts;
+  int                 iface, num_faces;
+
+  counts.num_elements = t8_forest_get_num_element (forest);
+  counts.volume_count = T8_ALLOC_ZERO (int, counts.num_elements);
+  counts.face_count =
+    T8_ALLOC_ZERO (int, counts.num_elements * T8_ECLASS_MAX_FACES);
+  t8_forest_iterate (forest, t8_test_iterate_volume, t8_test_iterate_face,
+                     &counts);
+  for (ielem = 0; ielem < counts.num_elements; ielem++) {
+    SC_CHECK_ABORT (counts.volume_count[ielem] == 1,
+                    "Leaf not visited exactly once");
+    leaf = t8_forest_get_element (forest, ielem, &ltree);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                ltree));
+    num_faces = ts->t8_element_num_faces (leaf);
+    for (iface = 0; iface < T8_ECLASS_MAX_FACES; iface++) {
+      SC_CHECK_ABORT (counts.face_count[ielem * T8_ECLASS_MAX_FACES + iface]
+                      == (iface < num_faces ? 1 : 0),
+                      "Face not visited exactly once");
+    }
+  }
+  T8_FREE (counts.volume_count);
+  T8_FREE (counts.face_count);
+}
+
+static void
+t8_test_iterate_check (t8_forest_t forest)
+{
+  t8_forest_face_neighbors_t *table;
+
+  SC_CHECK_ABORT (forest->face_neighbors != NULL,
+                  "Face neighbor table was not built");
+  t8_test_iterate_run (forest);
+  /* Hide the table, such that the neighbors are computed */
+  table = forest->face_neighbors;
+  forest->face_neighbors = NULL;
+  t8_test_iterate_run (forest);
+  forest->face_neighbors = table;
+}
+
+static void
+t8_test_iterate (sc_MPI_Comm comm)
+{
+  const char         *names[4] = { "periodic hybrid", "periodic triangle",
+    "periodic hex", "tet"
+  };
+  int                 icase;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (icase = 0; icase < 4; icase++) {
+    t8_global_productionf ("Testing forest iterate with %s mesh\n",
+                           names[icase]);
+    cmesh = t8_test_iterate_cmesh (icase, comm);
+    t8_scheme_cxx_ref (scheme);
+    /* A uniform forest */
+    t8_forest_init (&forest);
+    t8_forest_set_cmesh (forest, cmesh, comm);
+    t8_forest_set_scheme (forest, scheme);
+    t8_forest_set_level (forest, 2);
+    t8_forest_set_ghost (forest, 1, T8_GHOST_FACES);
+    t8_forest_set_face_neighbors (forest, 1);
+    t8_forest_commit (forest);
+    t8_test_iterate_check (forest);
+
+    /* An adapted and balanced forest */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_iterate_adapt, 1);
+    t8_forest_set_balance (forest_adapt, NULL, 0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_set_face_neighbors (forest_adapt, 1);
+    t8_forest_commit (forest_adapt);
+    t8_test_iterate_check (forest_adapt);
+    t8_forest_unref (&forest_adapt);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_iterate (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_iterate.h>
+
+/* In this test, we iterate over the leafs at the faces of all trees of
+ * an adapted forest with t8_forest_iterate_tree_faces, once with the
+ * top-down recursion and once with the leaf ranges.
+ * We record which faces of which leafs are visited and check that both
+ * variants visit the same leaf faces and that these are exactly the leaf
+ * faces at the tree boundaries.
+ * We repeat both variants with several threads, each thread recording the
+ * visits of its trees, and check that the visits of all threads together
+ * equal those of the serial run.
+ * The forests are refined deeply at face 0 of each tree and less deeply at
+ * the other tree faces, such that the leafs at a tree face have different
+ * levels and the leafs in the interior of the trees are skipped.
+ */
+
+/* Refine the elements at face 0 of a tree up to level 4 and the elements at
+ * the other tree faces up to level 2 */
+static int
+t8_test_iterate_faces_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                             t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                             t8_eclass_scheme_c * ts, int num_elements,
+                             t8_element_t * elements[])
+{
+  int                 level, iface;
+
+  level = ts->t8_element_level (elements[0]);
+  for (iface = 0; iface < ts->t8_element_num_faces (elements[0]); iface++) {
+    if (ts->t8_element_is_root_boundary (elements[0], iface)) {
+      if (level < 2 || (level < 4
+                        && ts->t8_element_tree_face (elements[0],
+                                                     iface) == 0)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* The user data of the face callback */
+typedef struct
+{
+  int                *visited; /* For each local element a bit field of visited faces */
+  int                *num_visits;       /* For each local element the number of visits */
+} t8_test_iterate_faces_data_t;
+
+#define T8_TEST_ITERATE_FACES_THREADS 4
+
+static int
+t8_test_iterate_faces_callback (t8_forest_t forest, t8_locidx_t ltreeid,
+                                const t8_element_t * element, int face,
+                                void *user_data,
+                                t8_locidx_t tree_leaf_index)
+{
+  t8_test_iterate_faces_data_t *data =
+    (t8_test_iterate_faces_data_t *) user_data;
+
+  t8_locidx_t         ielem;
+
+  if (tree_leaf_index >= 0) {
+    /* The element is a leaf, we record the face */
+    ielem = t8_forest_get_tree_element_offset (forest, ltreeid) +
+      tree_leaf_index;
+    data->visited[ielem] |= 1 << face;
+    data->num_visits[ielem]++;
+  }
+  return 1;
+}
+
+/* Iterate with several threads and check that the visits of all threads
+ * together equal the visits of the serial iteration */
+static void
+t8_test_iterate_faces_threads (t8_forest_t forest, int use_leaf_ranges,
+                               const t8_test_iterate_faces_data_t * serial)
+{
+  t8_test_iterate_faces_data_t data[T8_TEST_ITERATE_FACES_THREADS];
+  void               *user_data[T8_TEST_ITERATE_FACES_THREADS];
+  t8_locidx_t         num_elements, ielem;
+  int                 ithread, visited, num_visits;
+
+  num_elements = t8_forest_get_num_element (forest);
+  for (ithread = 0; ithread < T8_TEST_ITERATE_FACES_THREADS; ithread++) {
+    data[ithread].visited = T8_ALLOC_ZERO (int, num_elements);
+    data[ithread].num_visits = T8_ALLOC_ZERO (int, num_elements);
+    user_data[ithread] = &data[ithread];
+  }
+  t8_forest_iterate_tree_faces (forest, t8_test_iterate_faces_callback,
+                                user_data, T8_TEST_ITERATE_FACES_THREADS,
+                                use_leaf_ranges);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    visited = num_visits = 0;
+    for (ithread = 0; ithread < T8_TEST_ITERATE_FACES_THREADS; ithread++) {
+      visited |= data[ithread].visited[ielem];
+      num_visits += data[ithread].num_visits[ielem];
+    }
+    SC_CHECK_ABORT (visited == serial->visited[ielem]
+                    && num_visits == serial->num_visits[ielem],
+                    "Threaded face iteration does not match");
+  }
+  for (ithread = 0; ithread < T8_TEST_ITERATE_FACES_THREADS; ithread++) {
+    T8_FREE (data[ithread].visited);
+    T8_FREE (data[ithread].num_visits);
+  }
+}
+
+static void
+t8_test_iterate_faces (sc_MPI_Comm comm)
+{
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_scheme_cxx_t    *scheme;
+  t8_test_iterate_faces_data_t data_recursive, data_ranges;
+  void               *user_data;
+  t8_locidx_t         num_elements, ielem, ltree;
+  t8_element_t       *leaf;
+  t8_eclass_scheme_c *ts;
+  int                 iface, boundary_faces;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_QUAD; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing face iteration with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 1, 0, comm);
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_iterate_faces_adapt,
+                         1);
+    t8_forest_commit (forest_adapt);
+
+    num_elements = t8_forest_get_num_element (forest_adapt);
+    data_recursive.visited = T8_ALLOC_ZERO (int, num_elements);
+    data_ranges.visited = T8_ALLOC_ZERO (int, num_elements);
+    data_recursive.num_visits = T8_ALLOC_ZERO (int, num_elements);
+    data_ranges.num_visits = T8_ALLOC_ZERO (int, num_elements);
+    user_data = &data_recursive;
+    t8_forest_iterate_tree_faces (forest_adapt,
+                                  t8_test_iterate_faces_callback, &user_data,
+                                  1, 0);
+    user_data = &data_ranges;
+    t8_forest_iterate_tree_faces (forest_adapt,
+                                  t8_test_iterate_faces_callback, &user_data,
+                                  1, 1);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      SC_CHECK_ABORT (data_recursive.visited[ielem] ==
+                      data_ranges.visited[ielem]
+                      && data_recursive.num_visits[ielem] ==
+                      data_ranges.num_visits[ielem],
+                      "Face iterations do not match");
+      leaf = t8_forest_get_element (forest_adapt, ielem, &ltree);
+      ts = t8_forest_get_eclass_scheme (forest_adapt,
+                                        t8_forest_get_tree_class
+                                        (forest_adapt, ltree));
+      boundary_faces = 0;
+      for (iface = 0; iface < ts->t8_element_num_faces (leaf); iface++) {
+        if (ts->t8_element_is_root_boundary (leaf, iface)) {
+          boundary_faces |= 1 << iface;
+        }
+      }
+      SC_CHECK_ABORT (data_recursive.visited[ielem] == boundary_faces,
+                      "Visited faces are not the tree boundary faces");
+    }
+    t8_test_iterate_faces_threads (forest_adapt, 0, &data_recursive);
+    t8_test_iterate_faces_threads (forest_adapt, 1, &data_ranges);
+    T8_FREE (data_recursive.visited);
+    T8_FREE (data_ranges.visited);
+    T8_FREE (data_recursive.num_visits);
+    T8_FREE (data_ranges.num_visits);
+    t8_forest_unref (&forest_adapt);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_iterate_faces (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
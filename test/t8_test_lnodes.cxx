@@ -0,0 +1,158 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_lnodes.h>
+
+/* In this test, we number the nodes of partitioned uniform forests on the
+ * unit hypercube. The hypercube consists of several trees for triangles,
+ * tets and prisms. A uniform forest of level l has (2^l + 1)^dim nodes,
+ * none of them hanging.
+ * We then refine one element of a uniform level 1 quad forest, which
+ * results in 14 nodes, of which 2 are hanging.
+ */
+
+/* Check the global number of nodes and the number of hanging nodes */
+static void
+t8_test_lnodes_check (t8_forest_t forest, t8_gloidx_t num_nodes,
+                      t8_gloidx_t num_hanging)
+{
+  t8_forest_lnodes_t *lnodes;
+  t8_locidx_t         ielem, inode, i, j;
+  t8_gloidx_t         gid, local_hanging, global_hanging;
+  int                 mpiret;
+
+  lnodes = t8_forest_lnodes_new (forest);
+  SC_CHECK_ABORT (lnodes->num_global_nodes == num_nodes,
+                  "Wrong number of nodes");
+  SC_CHECK_ABORT (lnodes->num_local_elements ==
+                  t8_forest_get_num_element (forest),
+                  "Wrong number of elements");
+  /* The corners of an element are distinct nodes */
+  for (ielem = 0; ielem < lnodes->num_local_elements; ielem++) {
+    for (i = lnodes->element_offsets[ielem];
+         i < lnodes->element_offsets[ielem + 1]; i++) {
+      for (j = i + 1; j < lnodes->element_offsets[ielem + 1]; j++) {
+        SC_CHECK_ABORT (lnodes->element_nodes[i] != lnodes->element_nodes[j],
+                        "Corners of an element share a node");
+      }
+    }
+  }
+  /* Count the hanging nodes that we own */
+  local_hanging = 0;
+  for (inode = 0; inode < lnodes->num_local_nodes; inode++) {
+    gid = t8_forest_lnodes_global_index (lnodes, inode);
+    SC_CHECK_ABORT (0 <= gid && gid < num_nodes, "Invalid node number");
+    SC_CHECK_ABORT ((inode < lnodes->owned_count) ==
+                    (lnodes->global_offset <= gid
+                     && gid < lnodes->global_offset + lnodes->owned_count),
+                    "Owned node outside of the owned range");
+    if (inode < lnodes->owned_count
+        && t8_forest_lnodes_is_hanging (lnodes, inode)) {
+      SC_CHECK_ABORT (t8_forest_lnodes_is_hanging (lnodes, inode) == 2,
+                      "Wrong number of constraining nodes");
+      local_hanging++;
+    }
+  }
+  mpiret = sc_MPI_Allreduce (&local_hanging, &global_hanging, 1,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, lnodes->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORT (global_hanging == num_hanging,
+                  "Wrong number of hanging nodes");
+  t8_forest_lnodes_destroy (&lnodes);
+}
+
+/* Refine the first element of the first tree */
+static int
+t8_test_lnodes_refine_first (t8_forest_t forest, t8_forest_t forest_from,
+                             t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                             t8_eclass_scheme_c * ts, int num_elements,
+                             t8_element_t * elements[])
+{
+  return t8_forest_global_tree_id (forest_from, which_tree) == 0
+    && ts->t8_element_get_linear_id (elements[0], 1) == 0;
+}
+
+static void
+t8_test_lnodes (sc_MPI_Comm comm)
+{
+  int                 eclass, level, idim;
+  t8_gloidx_t         num_nodes;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing node numbering with eclass %s and"
+                             " level %i\n", t8_eclass_to_string[eclass],
+                             level);
+      cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+      num_nodes = 1;
+      for (idim = 0; idim < t8_eclass_to_dimension[eclass]; idim++) {
+        num_nodes *= (1 << level) + 1;
+      }
+      t8_test_lnodes_check (forest, num_nodes, 0);
+      t8_forest_unref (&forest);
+    }
+  }
+
+  t8_global_productionf ("Testing hanging nodes\n");
+  cmesh = t8_cmesh_new_hypercube (T8_ECLASS_QUAD, comm, 0, 0, 0);
+  t8_scheme_cxx_ref (scheme);
+  forest = t8_forest_new_uniform (cmesh, scheme, 1, 0, comm);
+  forest = t8_forest_new_adapt (forest, t8_test_lnodes_refine_first, 0, 0,
+                                NULL);
+  t8_test_lnodes_check (forest, 14, 2);
+  t8_forest_unref (&forest);
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_lnodes (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
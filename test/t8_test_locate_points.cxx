@@ -0,0 +1,182 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_locate.h>
+
+/* In this test, we locate the centroids of all local elements of a
+ * partitioned uniform forest with t8_forest_locate_points.
+ * Each centroid must be found in its own element. We also locate a point
+ * outside of the domain, which must not be found.
+ * For each element we compute the reference coordinates of its corners,
+ * which must be the corners of the reference element, and check that
+ * its bounding box contains the corners.
+ */
+
+/* The corners of the reference element of each eclass */
+static const double
+  t8_test_reference_corners[T8_ECLASS_COUNT][3 * T8_ECLASS_MAX_CORNERS] = {
+  {0, 0, 0},                    /* VERTEX */
+  {0, 0, 0, 1, 0, 0},           /* LINE */
+  {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0},         /* QUAD */
+  {0, 0, 0, 1, 0, 0, 1, 1, 0},  /* TRIANGLE */
+  {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0,
+   0, 0, 1, 1, 0, 1, 0, 1, 1, 1, 1, 1},         /* HEX */
+  {0, 0, 0, 1, 0, 0, 1, 0, 1, 1, 1, 1},         /* TET */
+  {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 0, 1, 1, 0, 1, 1, 1, 1},       /* PRISM */
+  {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0, 1, 1, 1} /* PYRAMID */
+};
+
+/* Check the reference coordinates of the corners of all local elements */
+static void
+t8_test_reference_coords (t8_forest_t forest, t8_eclass_t eclass)
+{
+  const t8_element_t *element;
+  const double       *tree_vertices;
+  double              corners[3 * T8_ECLASS_MAX_CORNERS];
+  double              ref[3 * T8_ECLASS_MAX_CORNERS], box[6];
+  int                 converged[T8_ECLASS_MAX_CORNERS];
+  int                 is_inside[T8_ECLASS_MAX_CORNERS];
+  int                 num_corners, icorner, i;
+  t8_locidx_t         itree, tree_elem;
+
+  num_corners = t8_eclass_num_vertices[eclass];
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree_vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (tree_elem = 0;
+         tree_elem < t8_forest_get_tree_num_elements (forest, itree);
+         tree_elem++) {
+      element = t8_forest_get_element_in_tree (forest, itree, tree_elem);
+      for (icorner = 0; icorner < num_corners; icorner++) {
+        t8_forest_element_coordinate (forest, itree, element, tree_vertices,
+                                      icorner, corners + 3 * icorner);
+      }
+      t8_forest_element_reference_coords_batch (forest, itree, element,
+                                                corners, num_corners, ref,
+                                                converged);
+      t8_forest_element_point_inside_batch (forest, itree, element, corners,
+                                            num_corners, 1e-10, is_inside);
+      t8_forest_element_bounding_box (forest, itree, element, tree_vertices,
+                                      box);
+      for (icorner = 0; icorner < num_corners; icorner++) {
+        SC_CHECK_ABORT (converged[icorner] && is_inside[icorner],
+                        "Corner not inside its element");
+        for (i = 0; i < 3; i++) {
+          SC_CHECK_ABORT (fabs (ref[3 * icorner + i] -
+                                t8_test_reference_corners[eclass][3 * icorner
+                                                                  + i]) <
+                          1e-10, "Wrong reference coordinates of a corner");
+          SC_CHECK_ABORT (box[i] - 1e-10 <= corners[3 * icorner + i]
+                          && corners[3 * icorner + i] <= box[3 + i] + 1e-10,
+                          "Corner outside of the element's bounding box");
+        }
+      }
+    }
+  }
+}
+
+static void
+t8_test_locate_points (sc_MPI_Comm comm)
+{
+  int                 eclass, mpirank, mpiret;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  t8_forest_point_owner_t *owners;
+  double             *points;
+  t8_locidx_t         num_elements, ielem, itree, tree_elem;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing point location with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 2, 0, comm);
+
+    /* The centroids of all local elements and one point outside */
+    num_elements = t8_forest_get_num_element (forest);
+    points = T8_ALLOC (double, 3 * (num_elements + 1));
+    owners = T8_ALLOC (t8_forest_point_owner_t, num_elements + 1);
+    ielem = 0;
+    for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+      for (tree_elem = 0;
+           tree_elem < t8_forest_get_tree_num_elements (forest, itree);
+           tree_elem++, ielem++) {
+        t8_forest_element_centroid (forest, itree,
+                                    t8_forest_get_element_in_tree (forest,
+                                                                   itree,
+                                                                   tree_elem),
+                                    t8_forest_get_tree_vertices (forest,
+                                                                 itree),
+                                    points + 3 * ielem);
+      }
+    }
+    points[3 * num_elements] = 2;
+    points[3 * num_elements + 1] = 2;
+    points[3 * num_elements + 2] = 2;
+
+    t8_forest_locate_points (forest, points, num_elements + 1, 1e-10,
+                             owners);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      SC_CHECK_ABORT (owners[ielem].rank == mpirank
+                      && owners[ielem].lelement_id == ielem,
+                      "Centroid not located in its element");
+    }
+    SC_CHECK_ABORT (owners[num_elements].rank == -1,
+                    "Point outside of the domain was located");
+    t8_test_reference_coords (forest, (t8_eclass_t) eclass);
+    T8_FREE (points);
+    T8_FREE (owners);
+    t8_forest_unref (&forest);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_locate_points (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we adapt a uniform forest without repartitioning it and
+ * then partition it together with two data arrays registered with
+ * t8_forest_set_partition_data. The first array stores the global id of
+ * each element and the second array its level.
+ * After partitioning, we check that each element has its global id and
+ * level as data. */
+
+/* Refine every element with child id 1 */
+static int
+t8_test_partition_data_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                              t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                              t8_eclass_scheme_c * ts, int num_elements,
+                              t8_element_t * elements[])
+{
+  if (ts->t8_element_child_id (elements[0]) == 1
+      && ts->t8_element_level (elements[0]) < 4) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Fill the global id and the level of each local element of forest */
+static void
+t8_test_partition_data_fill (t8_forest_t forest, sc_array_t * ids,
+                             sc_array_t * levels)
+{
+  t8_locidx_t         itree, ielement, num_elements, lelement;
+  t8_gloidx_t         first_id;
+  t8_eclass_scheme_c *ts;
+
+  first_id = t8_forest_get_first_local_element_id (forest);
+  for (itree = 0, lelement = 0;
+       itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, lelement++) {
+      *(t8_gloidx_t *) sc_array_index_int (ids, lelement) =
+        first_id + lelement;
+      *(int *) sc_array_index_int (levels, lelement) =
+        ts->t8_element_level (t8_forest_get_element_in_tree (forest, itree,
+                                                             ielement));
+    }
+  }
+}
+
+static void
+t8_test_partition_data (sc_MPI_Comm comm)
+{
+  int                 level, eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_partition;
+  t8_scheme_cxx_t    *scheme;
+  t8_locidx_t         num_elements;
+  sc_array_t         *ids, *levels, *ids_new, *levels_new;
+  sc_array_t         *ids_check, *levels_check;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    for (level = 1; level < 3; level++) {
+      t8_global_productionf
+        ("Testing partition data with eclass %s, level %i\n",
+         t8_eclass_to_string[eclass], level);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+      /* Adapt the forest without partitioning it */
+      t8_forest_init (&forest_adapt);
+      t8_forest_set_adapt (forest_adapt, forest,
+                           t8_test_partition_data_adapt, 1);
+      t8_forest_commit (forest_adapt);
+
+      num_elements = t8_forest_get_num_element (forest_adapt);
+      ids = sc_array_new_count (sizeof (t8_gloidx_t), num_elements);
+      levels = sc_array_new_count (sizeof (int), num_elements);
+      t8_test_partition_data_fill (forest_adapt, ids, levels);
+      ids_new = sc_array_new (sizeof (t8_gloidx_t));
+      levels_new = sc_array_new (sizeof (int));
+
+      /* Partition the forest and the data in one step */
+      t8_forest_init (&forest_partition);
+      t8_forest_set_partition (forest_partition, forest_adapt, 0);
+      t8_forest_set_partition_data (forest_partition, ids, ids_new);
+      t8_forest_set_partition_data (forest_partition, levels, levels_new);
+      t8_forest_commit (forest_partition);
+
+      /* Compute the expected data on the partitioned forest */
+      num_elements = t8_forest_get_num_element (forest_partition);
+      SC_CHECK_ABORT (ids_new->elem_count == (size_t) num_elements
+                      && levels_new->elem_count == (size_t) num_elements,
+                      "Partitioned data has wrong length");
+      ids_check = sc_array_new_count (sizeof (t8_gloidx_t), num_elements);
+      levels_check = sc_array_new_count (sizeof (int), num_elements);
+      t8_test_partition_data_fill (forest_partition, ids_check, levels_check);
+      SC_CHECK_ABORT (sc_array_is_equal (ids_new, ids_check),
+                      "Partitioned element ids are wrong");
+      SC_CHECK_ABORT (sc_array_is_equal (levels_new, levels_check),
+                      "Partitioned element levels are wrong");
+
+      sc_array_destroy (ids);
+      sc_array_destroy (levels);
+      sc_array_destroy (ids_new);
+      sc_array_destroy (levels_new);
+      sc_array_destroy (ids_check);
+      sc_array_destroy (levels_check);
+      t8_forest_unref (&forest_partition);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_partition_data (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,298 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_data/t8_shmem.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_forest/t8_forest_types.h>
+
+/* In this test, we check the partition modes of a forest.
+ * 1st  With a partition threshold above the imbalance of a forest the
+ *      partition is skipped, below it the forest is partitioned. In both
+ *      cases the elements and ghosts must equal those of a forest that was
+ *      fully partitioned.
+ * 2nd  With the diffusive partition each process only sends elements to
+ *      its neighboring processes, that is its new elements were owned by
+ *      the process itself or its neighbors before.
+ * 3rd  With a partition to a subset of the processes, all other processes
+ *      have no elements and no trees, the cmesh holds the trees of the
+ *      forest and the active communicator contains the nonempty processes.
+ */
+
+/* Refine each element of the process with rank 0 */
+static int
+t8_test_partition_refine_rank0 (t8_forest_t forest, t8_forest_t forest_from,
+                                t8_locidx_t which_tree,
+                                t8_locidx_t lelement_id,
+                                t8_eclass_scheme_c * ts, int num_elements,
+                                t8_element_t * elements[])
+{
+  return forest_from->mpirank == 0;
+}
+
+/* Compute the maximum number of local elements over all processes divided
+ * by the average number */
+static double
+t8_test_partition_imbalance (t8_forest_t forest)
+{
+  t8_locidx_t         num_local, max_local;
+  int                 mpiret;
+
+  num_local = t8_forest_get_num_element (forest);
+  mpiret = sc_MPI_Allreduce (&num_local, &max_local, 1, T8_MPI_LOCIDX,
+                             sc_MPI_MAX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return max_local * (double) forest->mpisize
+    / t8_forest_get_global_num_elements (forest);
+}
+
+/* Partition forest with ghosts once with the given threshold and once
+ * fully and check that both have the same elements and ghosts.
+ * If do_skip is true, the partition must be skipped and the ghost layer of
+ * forest reused. */
+static void
+t8_test_partition_threshold_compare (t8_forest_t forest, double threshold,
+                                     int do_skip)
+{
+  t8_forest_t         forest_threshold, forest_full;
+
+  /* We need to use forest twice, so we ref it */
+  t8_forest_ref (forest);
+
+  t8_forest_init (&forest_threshold);
+  t8_forest_set_partition (forest_threshold, forest, 0);
+  t8_forest_set_partition_threshold (forest_threshold, threshold);
+  t8_forest_set_ghost (forest_threshold, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_threshold);
+  SC_CHECK_ABORT ((forest_threshold->ghosts == forest->ghosts) == do_skip,
+                  "The ghost layer was not reused as expected");
+
+  t8_forest_init (&forest_full);
+  t8_forest_set_partition (forest_full, forest, 0);
+  t8_forest_set_ghost (forest_full, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_full);
+
+  SC_CHECK_ABORT (t8_forest_is_equal (forest_threshold, forest_full),
+                  "The elements do not match the full partition");
+  SC_CHECK_ABORT (t8_forest_ghost_is_equal (forest_threshold, forest_full),
+                  "The ghosts do not match the full partition");
+  t8_forest_unref (&forest_threshold);
+  t8_forest_unref (&forest_full);
+}
+
+static void
+t8_test_partition_threshold (sc_MPI_Comm comm)
+{
+  int                 eclass, level = 3;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+  t8_scheme_cxx_t    *scheme;
+  double              imbalance;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf
+      ("Testing partition threshold with eclass %s\n",
+       t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 1, comm);
+
+    /* The uniform forest is partitioned already, so its partition is
+     * skipped with a threshold above its imbalance */
+    imbalance = t8_test_partition_imbalance (forest);
+    t8_forest_ref (forest);
+    t8_test_partition_threshold_compare (forest, imbalance + 1, 1);
+
+    /* Refining the elements of rank 0 makes the forest imbalanced, so
+     * it is partitioned with a threshold below its imbalance */
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_partition_refine_rank0,
+                         0);
+    t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_adapt);
+    imbalance = t8_test_partition_imbalance (forest_adapt);
+    t8_test_partition_threshold_compare (forest_adapt,
+                                         imbalance > 1 ?
+                                         (1 + imbalance) / 2 : 0, 0);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+/* Partition an imbalanced forest diffusively and check that the first
+ * element of each process p was owned by p - 1, p or p + 1 before, which
+ * means that all elements only move to neighboring processes. */
+static void
+t8_test_partition_diffusive (sc_MPI_Comm comm)
+{
+  int                 eclass, iproc, level = 3;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_diffusive;
+  t8_scheme_cxx_t    *scheme;
+  t8_gloidx_t        *offsets_old, *offsets_new;
+  uint64_t            checksum;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf
+      ("Testing diffusive partition with eclass %s\n",
+       t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_adapt (forest_adapt, forest, t8_test_partition_refine_rank0,
+                         0);
+    t8_forest_commit (forest_adapt);
+    if (forest_adapt->element_offsets == NULL) {
+      t8_forest_partition_create_offsets (forest_adapt);
+    }
+    checksum = t8_forest_checksum (forest_adapt);
+    /* We keep forest_adapt to compare the offsets */
+    t8_forest_ref (forest_adapt);
+
+    t8_forest_init (&forest_diffusive);
+    t8_forest_set_partition (forest_diffusive, forest_adapt, 0);
+    t8_forest_set_partition_diffusive (forest_diffusive, 1);
+    t8_forest_commit (forest_diffusive);
+
+    offsets_old =
+      t8_shmem_array_get_gloidx_array (forest_adapt->element_offsets);
+    offsets_new =
+      t8_shmem_array_get_gloidx_array (forest_diffusive->element_offsets);
+    for (iproc = 1; iproc < forest_diffusive->mpisize; iproc++) {
+      SC_CHECK_ABORTF (offsets_old[iproc - 1] <= offsets_new[iproc]
+                       && offsets_new[iproc] <= offsets_old[iproc + 1],
+                       "Process %i receives elements from a process that"
+                       " is not its neighbor.\n", iproc);
+    }
+    SC_CHECK_ABORT (t8_forest_checksum (forest_diffusive) == checksum,
+                    "The diffusive partition changed the elements");
+    t8_forest_unref (&forest_adapt);
+    t8_forest_unref (&forest_diffusive);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+/* Partition a forest on a partitioned cmesh to the first half of the
+ * processes and check the trees and elements of each process. */
+static void
+t8_test_partition_ranks (sc_MPI_Comm comm)
+{
+  int                 eclass, level = 3;
+  int                 mpirank, mpisize, mpiret, num_ranks, active_size;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_partition;
+  t8_scheme_cxx_t    *scheme;
+  t8_locidx_t         ltree, lctree;
+  sc_MPI_Comm         active_comm;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  num_ranks = (mpisize + 1) / 2;
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf
+      ("Testing partition to %i processes with eclass %s\n", num_ranks,
+       t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 1, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+
+    t8_forest_init (&forest_partition);
+    t8_forest_set_partition (forest_partition, forest, 0);
+    t8_forest_set_partition_ranks (forest_partition, num_ranks);
+    t8_forest_commit (forest_partition);
+
+    cmesh = t8_forest_get_cmesh (forest_partition);
+    if (mpirank >= num_ranks) {
+      SC_CHECK_ABORT (t8_forest_get_num_element (forest_partition) == 0
+                      && t8_forest_get_num_local_trees (forest_partition) ==
+                      0, "An inactive process owns elements or trees");
+      SC_CHECK_ABORT (t8_cmesh_get_num_local_trees (cmesh) == 0,
+                      "An inactive process owns cmesh trees");
+    }
+    else {
+      SC_CHECK_ABORT (t8_forest_get_num_element (forest_partition) > 0,
+                      "An active process owns no elements");
+    }
+    /* Each local tree of the forest is a local tree of the cmesh */
+    for (ltree = 0; ltree < t8_forest_get_num_local_trees (forest_partition);
+         ltree++) {
+      lctree = t8_cmesh_get_local_id (cmesh,
+                                      t8_forest_global_tree_id
+                                      (forest_partition, ltree));
+      SC_CHECK_ABORT (0 <= lctree
+                      && lctree < t8_cmesh_get_num_local_trees (cmesh),
+                      "The cmesh does not match the forest");
+    }
+
+    t8_forest_get_active_comm (forest_partition, &active_comm);
+    if (mpirank < num_ranks) {
+      mpiret = sc_MPI_Comm_size (active_comm, &active_size);
+      SC_CHECK_MPI (mpiret);
+      SC_CHECK_ABORT (active_size == num_ranks,
+                      "Wrong size of the active communicator");
+      mpiret = sc_MPI_Comm_free (&active_comm);
+      SC_CHECK_MPI (mpiret);
+    }
+    else {
+      SC_CHECK_ABORT (active_comm == sc_MPI_COMM_NULL,
+                      "An inactive process got a communicator");
+    }
+    t8_forest_unref (&forest_partition);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_partition_threshold (mpic);
+  t8_test_partition_diffusive (mpic);
+  t8_test_partition_ranks (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
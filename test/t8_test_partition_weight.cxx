@@ -0,0 +1,135 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we partition a uniform forest with element weights and
+ * check that the weight of each process is at most the average weight
+ * plus the maximum weight of an element. */
+
+#define T8_TEST_PARTITION_WEIGHT_MAX 5
+
+/* Elements with child id 0 are expensive */
+static double
+t8_test_partition_weight_fn (t8_forest_t forest_from, t8_locidx_t which_tree,
+                             t8_locidx_t lelement_id, t8_eclass_scheme_c * ts,
+                             const t8_element_t * element)
+{
+  return ts->t8_element_child_id (element) == 0 ?
+    T8_TEST_PARTITION_WEIGHT_MAX : 1;
+}
+
+/* Compute the sum of the weights of the local elements of a forest */
+static double
+t8_test_partition_weight_local (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielement, num_elements;
+  t8_eclass_scheme_c *ts;
+  double              weight = 0;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      weight +=
+        t8_test_partition_weight_fn (forest, itree, ielement, ts,
+                                     t8_forest_get_element_in_tree (forest,
+                                                                    itree,
+                                                                    ielement));
+    }
+  }
+  return weight;
+}
+
+static void
+t8_test_partition_weight (sc_MPI_Comm comm)
+{
+  int                 level, eclass, mpisize, mpiret;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_partition;
+  t8_scheme_cxx_t    *scheme;
+  double              local_weight, max_weight, total_weight;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    for (level = 1; level < 4; level++) {
+      t8_global_productionf
+        ("Testing weighted partition with eclass %s, level %i\n",
+         t8_eclass_to_string[eclass], level);
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0, comm);
+
+      t8_forest_init (&forest_partition);
+      t8_forest_set_partition (forest_partition, forest, 0);
+      t8_forest_set_partition_weight (forest_partition,
+                                      t8_test_partition_weight_fn, NULL);
+      t8_forest_commit (forest_partition);
+
+      local_weight = t8_test_partition_weight_local (forest_partition);
+      mpiret = sc_MPI_Allreduce (&local_weight, &max_weight, 1,
+                                 sc_MPI_DOUBLE, sc_MPI_MAX, comm);
+      SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Allreduce (&local_weight, &total_weight, 1,
+                                 sc_MPI_DOUBLE, sc_MPI_SUM, comm);
+      SC_CHECK_MPI (mpiret);
+      SC_CHECK_ABORT (max_weight <= total_weight / mpisize
+                      + T8_TEST_PARTITION_WEIGHT_MAX,
+                      "The weighted partition is not balanced");
+      t8_forest_unref (&forest_partition);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_partition_weight (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
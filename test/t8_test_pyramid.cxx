@@ -0,0 +1,294 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we check the default pyramid scheme.
+ * 1st  For all elements of a uniform refinement we check that the linear
+ *      id, the successor, the parent and the face neighbors are consistent.
+ * 2nd  We refine a pyramid forest uniformly with adapt and coarsen it back,
+ *      such that the forest handles the families of ten pyramid children and
+ *      eight tetrahedral children.
+ * 3rd  We refine a hybrid mesh of a hexahedron, a pyramid and a tetrahedron
+ *      and partition it, such that pyramid elements are sent between
+ *      processes.
+ */
+
+/* Check the element functions on all elements of a uniform level */
+static void
+t8_test_pyramid_elements (t8_eclass_scheme_c * ts, int level)
+{
+  t8_element_t       *elem, *succ, *parent, *child, *neigh, *neigh_back;
+  t8_linearidx_t      id, num_elements;
+  int                 face, neigh_face, back_face, num_children;
+
+  ts->t8_element_new (1, &elem);
+  ts->t8_element_new (1, &succ);
+  ts->t8_element_new (1, &parent);
+  ts->t8_element_new (1, &child);
+  ts->t8_element_new (1, &neigh);
+  ts->t8_element_new (1, &neigh_back);
+
+  num_elements = t8_eclass_count_leaf (T8_ECLASS_PYRAMID, level);
+  ts->t8_element_set_linear_id (elem, level, 0);
+  for (id = 0; id < num_elements; id++) {
+    SC_CHECK_ABORT (ts->t8_element_get_linear_id (elem, level) == id,
+                    "Wrong linear id");
+    if (level > 0) {
+      /* The element is the child of its parent */
+      ts->t8_element_parent (elem, parent);
+      num_children = ts->t8_element_num_children (parent);
+      SC_CHECK_ABORT (ts->t8_element_child_id (elem) < num_children,
+                      "Wrong child id");
+      ts->t8_element_child (parent, ts->t8_element_child_id (elem), child);
+      SC_CHECK_ABORT (!ts->t8_element_compare (elem, child),
+                      "Wrong parent or child");
+    }
+    for (face = 0; face < ts->t8_element_num_faces (elem); face++) {
+      if (ts->t8_element_face_neighbor_inside (elem, neigh, face,
+                                               &neigh_face)) {
+        /* The neighbor of the neighbor is the element */
+        SC_CHECK_ABORT (ts->t8_element_level (neigh) == level,
+                        "Wrong neighbor level");
+        SC_CHECK_ABORT (ts->t8_element_face_neighbor_inside
+                        (neigh, neigh_back, neigh_face, &back_face),
+                        "Neighbor is not inside the root");
+        SC_CHECK_ABORT (back_face == face
+                        && !ts->t8_element_compare (elem, neigh_back),
+                        "Face neighbors do not match");
+      }
+      else {
+        SC_CHECK_ABORT (ts->t8_element_is_root_boundary (elem, face),
+                        "Face neighbor outside of the root");
+      }
+    }
+    if (id + 1 < num_elements) {
+      /* The successor has the next linear id */
+      ts->t8_element_successor (elem, succ, level);
+      SC_CHECK_ABORT (ts->t8_element_compare (elem, succ) < 0,
+                      "Successor is not larger");
+      ts->t8_element_copy (succ, elem);
+    }
+  }
+
+  ts->t8_element_destroy (1, &elem);
+  ts->t8_element_destroy (1, &succ);
+  ts->t8_element_destroy (1, &parent);
+  ts->t8_element_destroy (1, &child);
+  ts->t8_element_destroy (1, &neigh);
+  ts->t8_element_destroy (1, &neigh_back);
+}
+
+/* Refine each element up to the level given as user data */
+static int
+t8_test_pyramid_refine (t8_forest_t forest, t8_forest_t forest_from,
+                        t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                        t8_eclass_scheme_c * ts, int num_elements,
+                        t8_element_t * elements[])
+{
+  int                 level = *(int *) t8_forest_get_user_data (forest);
+
+  return ts->t8_element_level (elements[0]) < level;
+}
+
+/* Coarsen each family */
+static int
+t8_test_pyramid_coarsen (t8_forest_t forest, t8_forest_t forest_from,
+                         t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                         t8_eclass_scheme_c * ts, int num_elements,
+                         t8_element_t * elements[])
+{
+  if (num_elements > 1) {
+    SC_CHECK_ABORT (num_elements ==
+                    ts->t8_element_num_children (elements[0]),
+                    "Wrong family size");
+    return -1;
+  }
+  return 0;
+}
+
+static void
+t8_test_pyramid_forest (int level)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_refine, forest_coarsen;
+  t8_gloidx_t         num_trees;
+
+  cmesh = t8_cmesh_new_from_class (T8_ECLASS_PYRAMID, sc_MPI_COMM_WORLD);
+  num_trees = t8_cmesh_get_num_trees (cmesh);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), 0, 0,
+                                  sc_MPI_COMM_WORLD);
+  t8_forest_ref (forest);
+
+  /* Refine the forest recursively to a uniform level */
+  t8_forest_init (&forest_refine);
+  t8_forest_set_user_data (forest_refine, &level);
+  t8_forest_set_adapt (forest_refine, forest, t8_test_pyramid_refine, 1);
+  t8_forest_commit (forest_refine);
+  SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_refine) ==
+                  num_trees * t8_eclass_count_leaf (T8_ECLASS_PYRAMID,
+                                                    level),
+                  "Wrong number of elements after refinement");
+
+  /* Coarsen the forest recursively back to level 0 */
+  t8_forest_init (&forest_coarsen);
+  t8_forest_set_adapt (forest_coarsen, forest_refine,
+                       t8_test_pyramid_coarsen, 1);
+  t8_forest_commit (forest_coarsen);
+  SC_CHECK_ABORT (t8_forest_is_equal (forest, forest_coarsen),
+                  "Coarsened forest is not the original forest");
+
+  t8_forest_unref (&forest);
+  t8_forest_unref (&forest_coarsen);
+}
+
+/* A cmesh of a hexahedron, a pyramid on top of it and a tetrahedron next
+ * to it. The trees are not connected, since the partition does not use the
+ * face connectivity. */
+static              t8_cmesh_t
+t8_test_pyramid_hybrid_cmesh (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  double              vertices_hex[24] = {
+    0, 0, 0,
+    1, 0, 0,
+    0, 1, 0,
+    1, 1, 0,
+    0, 0, 1,
+    1, 0, 1,
+    0, 1, 1,
+    1, 1, 1
+  };
+  double              vertices_pyramid[15] = {
+    0, 0, 1,
+    1, 0, 1,
+    0, 1, 1,
+    1, 1, 1,
+    0.5, 0.5, 2
+  };
+  double              vertices_tet[12] = {
+    1, 0, 0,
+    2, 0, 0,
+    2, 1, 0,
+    2, 1, 1
+  };
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_tree_class (cmesh, 0, T8_ECLASS_HEX);
+  t8_cmesh_set_tree_class (cmesh, 1, T8_ECLASS_PYRAMID);
+  t8_cmesh_set_tree_class (cmesh, 2, T8_ECLASS_TET);
+  t8_cmesh_set_tree_vertices (cmesh, 0, t8_get_package_id (), 0,
+                              vertices_hex, 8);
+  t8_cmesh_set_tree_vertices (cmesh, 1, t8_get_package_id (), 0,
+                              vertices_pyramid, 5);
+  t8_cmesh_set_tree_vertices (cmesh, 2, t8_get_package_id (), 0,
+                              vertices_tet, 4);
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
+/* Refine the hybrid mesh to a uniform level and partition it. The
+ * partitioned forest must have the same elements and each process must
+ * get its share of the elements. */
+static void
+t8_test_pyramid_partition (int level)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_refine, forest_partition;
+  t8_gloidx_t         num_elements;
+  uint64_t            checksum;
+  double              share;
+  int                 mpisize, mpiret;
+
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+
+  cmesh = t8_test_pyramid_hybrid_cmesh (sc_MPI_COMM_WORLD);
+  forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), 0, 0,
+                                  sc_MPI_COMM_WORLD);
+
+  /* Refine the forest recursively to a uniform level. Since the uniform
+   * level 0 partition assigns whole trees to processes, the forest is not
+   * balanced afterwards. */
+  t8_forest_init (&forest_refine);
+  t8_forest_set_user_data (forest_refine, &level);
+  t8_forest_set_adapt (forest_refine, forest, t8_test_pyramid_refine, 1);
+  t8_forest_commit (forest_refine);
+  num_elements = t8_forest_get_global_num_elements (forest_refine);
+  SC_CHECK_ABORT (num_elements ==
+                  t8_eclass_count_leaf (T8_ECLASS_HEX, level)
+                  + t8_eclass_count_leaf (T8_ECLASS_PYRAMID, level)
+                  + t8_eclass_count_leaf (T8_ECLASS_TET, level),
+                  "Wrong number of elements after refinement");
+  checksum = t8_forest_checksum (forest_refine);
+
+  t8_forest_init (&forest_partition);
+  t8_forest_set_partition (forest_partition, forest_refine, 0);
+  t8_forest_commit (forest_partition);
+  SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_partition) ==
+                  num_elements,
+                  "Wrong number of elements after partition");
+  SC_CHECK_ABORT (t8_forest_checksum (forest_partition) == checksum,
+                  "Partition changed the elements");
+  share = (double) num_elements / mpisize;
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest_partition) >=
+                  share - 1
+                  && t8_forest_get_num_element (forest_partition) <=
+                  share + 1, "Forest is not partitioned evenly");
+
+  t8_forest_unref (&forest_partition);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 level;
+  t8_scheme_cxx_t    *scheme;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (level = 0; level < 4; level++) {
+    t8_global_productionf ("Testing pyramid elements at level %i\n", level);
+    t8_test_pyramid_elements (scheme->eclass_schemes[T8_ECLASS_PYRAMID],
+                              level);
+    t8_test_pyramid_forest (level);
+    t8_test_pyramid_partition (level);
+  }
+  t8_scheme_cxx_unref (&scheme);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we refine each element of a uniform forest in two ways:
+ * 1st  With t8_element_children and t8_forest_element_coordinate for the
+ *      corners of each child.
+ * 2nd  With t8_element_children_batch and
+ *      t8_forest_element_children_coordinates_batch, which use the
+ *      refinement tables.
+ *
+ * Afterwards we check that the children and their coordinates are equal.
+ */
+
+static void
+t8_test_refine_tables_tree (t8_forest_t forest, t8_locidx_t itree)
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  const t8_element_t *element;
+  t8_element_t       *children[T8_ECLASS_MAX_CHILDREN];
+  t8_element_array_t  batch_children;
+  double             *vertices, *coordinates, coords[3];
+  t8_locidx_t         ielem, num_elements;
+  int                 num_children, num_corners, ichild, icorner, i;
+  size_t              offset;
+
+  eclass = t8_forest_get_tree_class (forest, itree);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  vertices = t8_forest_get_tree_vertices (forest, itree);
+  num_elements = t8_forest_get_tree_num_elements (forest, itree);
+  num_children = 1 << t8_eclass_to_dimension[eclass];
+  num_corners = t8_eclass_num_vertices[eclass];
+
+  coordinates = T8_ALLOC (double, 3 * (size_t) num_elements * num_children
+                          * num_corners);
+  t8_forest_element_children_coordinates_batch (forest, itree, 0,
+                                                num_elements, vertices,
+                                                coordinates);
+  ts->t8_element_new (num_children, children);
+  t8_element_array_init_size (&batch_children, ts, num_children);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    element = t8_forest_get_element_in_tree (forest, itree, ielem);
+    ts->t8_element_children (element, num_children, children);
+    ts->t8_element_children_batch (element, 1,
+                                   t8_element_array_index_int
+                                   (&batch_children, 0));
+    for (ichild = 0; ichild < num_children; ichild++) {
+      SC_CHECK_ABORT (!ts->t8_element_compare (children[ichild],
+                                               t8_element_array_index_int
+                                               (&batch_children, ichild))
+                      && ts->t8_element_level (children[ichild])
+                      == ts->t8_element_level (t8_element_array_index_int
+                                               (&batch_children, ichild)),
+                      "The batched children are not equal");
+      for (icorner = 0; icorner < num_corners; icorner++) {
+        t8_forest_element_coordinate (forest, itree, children[ichild],
+                                      vertices, icorner, coords);
+        offset = 3 * ((ielem * num_children + ichild) * num_corners
+                      + icorner);
+        for (i = 0; i < 3; i++) {
+          SC_CHECK_ABORT (fabs (coords[i] - coordinates[offset + i]) < 1e-12,
+                          "The child coordinates are not equal");
+        }
+      }
+    }
+  }
+  t8_element_array_reset (&batch_children);
+  ts->t8_element_destroy (num_children, children);
+  T8_FREE (coordinates);
+}
+
+static void
+t8_test_refine_tables ()
+{
+  int                 level;
+  int                 eclass;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  t8_locidx_t         itree;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, sc_MPI_COMM_WORLD,
+                                    0, 0, 0);
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf
+        ("Testing refinement tables with eclass %s, level %i\n",
+         t8_eclass_to_string[eclass], level);
+      /* ref the cmesh and scheme since we reuse them */
+      t8_cmesh_ref (cmesh);
+      t8_scheme_cxx_ref (scheme);
+      forest = t8_forest_new_uniform (cmesh, scheme, level, 0,
+                                      sc_MPI_COMM_WORLD);
+      for (itree = 0; itree < t8_forest_get_num_local_trees (forest);
+           itree++) {
+        t8_test_refine_tables_tree (forest, itree);
+      }
+      t8_forest_unref (&forest);
+    }
+    t8_cmesh_destroy (&cmesh);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_refine_tables ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
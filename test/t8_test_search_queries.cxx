@@ -0,0 +1,152 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_iterate.h>
+
+/* In this test, we search a uniform forest with t8_forest_search_queries.
+ * Each query is a child id q and matches all elements whose ancestor at
+ * level 1 has child id q.
+ * We check that each leaf is matched by exactly the query of its ancestor,
+ * once with a serial and once with a threaded search.
+ */
+
+/* The user data of the search */
+typedef struct
+{
+  int                *matches; /* For each local element a bit field of matching queries */
+} t8_test_search_queries_data_t;
+
+static int
+t8_test_search_queries_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                           const t8_element_t * element,
+                           t8_element_array_t * leaf_elements,
+                           void *user_data, t8_locidx_t tree_leaf_index,
+                           void *query, size_t query_index)
+{
+  t8_test_search_queries_data_t *data =
+    (t8_test_search_queries_data_t *) user_data;
+  t8_eclass_scheme_c *ts;
+  int                 child_id;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  child_id = *(int *) query;
+  if (ts->t8_element_level (element) > 0
+      && ts->t8_element_ancestor_id (element, 1) != child_id) {
+    /* The query does not match the element or any descendant */
+    return 0;
+  }
+  if (tree_leaf_index >= 0) {
+    /* The element is a leaf, we record the match */
+    data->matches[t8_forest_get_tree_element_offset (forest, ltreeid) +
+                  tree_leaf_index] |= 1 << query_index;
+  }
+  return 1;
+}
+
+static void
+t8_test_search_queries (sc_MPI_Comm comm)
+{
+  int                 eclass, num_children, ichild;
+  int                 num_threads, match;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  t8_eclass_scheme_c *ts;
+  t8_test_search_queries_data_t data;
+  t8_element_t       *element;
+  sc_array_t          queries;
+  t8_locidx_t         num_elements, ielem, itree, tree_elem;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_LINE; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing query search with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme, 3, 0, comm);
+
+    /* One query for each child id */
+    ts = t8_forest_get_eclass_scheme (forest, (t8_eclass_t) eclass);
+    ts->t8_element_new (1, &element);
+    ts->t8_element_set_linear_id (element, 0, 0);
+    num_children = ts->t8_element_num_children (element);
+    ts->t8_element_destroy (1, &element);
+    sc_array_init_size (&queries, sizeof (int), num_children);
+    for (ichild = 0; ichild < num_children; ichild++) {
+      *(int *) sc_array_index_int (&queries, ichild) = ichild;
+    }
+
+    num_elements = t8_forest_get_num_element (forest);
+    data.matches = T8_ALLOC (int, num_elements);
+    for (num_threads = 1; num_threads <= 2; num_threads++) {
+      memset (data.matches, 0, num_elements * sizeof (int));
+      t8_forest_search_queries (forest, NULL, t8_test_search_queries_fn,
+                                &queries, &data, num_threads);
+      ielem = 0;
+      for (itree = 0; itree < t8_forest_get_num_local_trees (forest);
+           itree++) {
+        for (tree_elem = 0;
+             tree_elem < t8_forest_get_tree_num_elements (forest, itree);
+             tree_elem++, ielem++) {
+          element = t8_forest_get_element_in_tree (forest, itree, tree_elem);
+          match = 1 << ts->t8_element_ancestor_id (element, 1);
+          SC_CHECK_ABORT (data.matches[ielem] == match,
+                          "Wrong matches in query search");
+        }
+      }
+    }
+    T8_FREE (data.matches);
+    sc_array_reset (&queries);
+    t8_forest_unref (&forest);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_search_queries (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+#include <t8_forest/t8_forest_iterate.h>
+
+/* In this test, we search a uniform forest of several trees with
+ * t8_forest_search and with t8_forest_search_threads.
+ * The search callback allocates and frees the parent and the children of
+ * each element, such that the threads concurrently use the mempool of the
+ * default scheme. A leaf matches if it is not the last child of its parent.
+ * We check that the threaded search matches the same leafs as the serial
+ * search and that these are the expected leafs.
+ */
+
+#define T8_TEST_SEARCH_THREADS_NUM_TREES 8
+#define T8_TEST_SEARCH_THREADS_LEVEL 3
+
+/* The user data of the search */
+typedef struct
+{
+  int                *matches; /* For each local element the number of matches */
+} t8_test_search_threads_data_t;
+
+static int
+t8_test_search_threads_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                           const t8_element_t * element,
+                           t8_element_array_t * leaf_elements,
+                           void *user_data, t8_locidx_t tree_leaf_index)
+{
+  t8_test_search_threads_data_t *data =
+    (t8_test_search_threads_data_t *) user_data;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *parent, **children;
+  int                 num_children, is_last_child = 0;
+
+  ts = t8_forest_get_eclass_scheme (forest,
+                                    t8_forest_get_tree_class (forest,
+                                                              ltreeid));
+  /* Allocate the children and check that element is their parent */
+  num_children = ts->t8_element_num_children (element);
+  children = T8_ALLOC (t8_element_t *, num_children);
+  ts->t8_element_new (num_children, children);
+  ts->t8_element_children (element, num_children, children);
+  ts->t8_element_new (1, &parent);
+  ts->t8_element_parent (children[0], parent);
+  SC_CHECK_ABORT (!ts->t8_element_compare (parent, element),
+                  "Wrong parent of the first child");
+  if (ts->t8_element_level (element) > 0) {
+    /* Check whether element is the last child of its parent */
+    ts->t8_element_parent (element, parent);
+    is_last_child = ts->t8_element_child_id (element) ==
+      ts->t8_element_num_children (parent) - 1;
+  }
+  ts->t8_element_destroy (1, &parent);
+  ts->t8_element_destroy (num_children, children);
+  T8_FREE (children);
+
+  if (tree_leaf_index >= 0 && !is_last_child) {
+    /* The element is a matching leaf, we record the match */
+    data->matches[t8_forest_get_tree_element_offset (forest, ltreeid) +
+                  tree_leaf_index]++;
+  }
+  return 1;
+}
+
+/* Return true if the leaf element is not the last child of its parent */
+static int
+t8_test_search_threads_expected (t8_eclass_scheme_c * ts,
+                                 const t8_element_t * element)
+{
+  t8_element_t       *parent;
+  int                 match;
+
+  ts->t8_element_new (1, &parent);
+  ts->t8_element_parent (element, parent);
+  match = ts->t8_element_child_id (element) !=
+    ts->t8_element_num_children (parent) - 1;
+  ts->t8_element_destroy (1, &parent);
+  return match;
+}
+
+static void
+t8_test_search_threads (sc_MPI_Comm comm)
+{
+  int                 eclass, ithreads;
+  /* A negative number uses t8_get_num_threads threads */
+  int                 num_threads[2] = { 4, -1 };
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  t8_eclass_scheme_c *ts;
+  t8_test_search_threads_data_t data_serial, data_threads;
+  t8_element_t       *element;
+  t8_locidx_t         num_elements, ielem, itree;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclass = T8_ECLASS_QUAD; eclass < T8_ECLASS_PYRAMID; eclass++) {
+    t8_global_productionf ("Testing threaded search with eclass %s\n",
+                           t8_eclass_to_string[eclass]);
+    cmesh = t8_cmesh_new_bigmesh ((t8_eclass_t) eclass,
+                                  T8_TEST_SEARCH_THREADS_NUM_TREES, comm);
+    t8_scheme_cxx_ref (scheme);
+    forest = t8_forest_new_uniform (cmesh, scheme,
+                                    T8_TEST_SEARCH_THREADS_LEVEL, 0, comm);
+    ts = t8_forest_get_eclass_scheme (forest, (t8_eclass_t) eclass);
+
+    num_elements = t8_forest_get_num_element (forest);
+    data_serial.matches = T8_ALLOC_ZERO (int, num_elements);
+    data_threads.matches = T8_ALLOC (int, num_elements);
+    t8_forest_search (forest, t8_test_search_threads_fn, &data_serial);
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      element = t8_forest_get_element (forest, ielem, &itree);
+      SC_CHECK_ABORT (data_serial.matches[ielem] ==
+                      t8_test_search_threads_expected (ts, element),
+                      "Wrong matches in serial search");
+    }
+    for (ithreads = 0; ithreads < 2; ithreads++) {
+      memset (data_threads.matches, 0, num_elements * sizeof (int));
+      t8_forest_search_threads (forest, t8_test_search_threads_fn,
+                                &data_threads, num_threads[ithreads]);
+      for (ielem = 0; ielem < num_elements; ielem++) {
+        SC_CHECK_ABORTF (data_threads.matches[ielem] ==
+                         data_serial.matches[ielem],
+                         "Wrong matches in search with %i threads",
+                         num_threads[ithreads]);
+      }
+    }
+    T8_FREE (data_serial.matches);
+    T8_FREE (data_threads.matches);
+    t8_forest_unref (&forest);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_search_threads (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
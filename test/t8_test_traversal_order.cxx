@@ -0,0 +1,148 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we commit forests with t8_forest_set_traversal_order and
+ * check that the traversal order is a permutation of the local elements
+ * that keeps the elements of each tree together and in their SFC order.
+ * We also permute element data to the traversal order and back.
+ */
+
+static void
+t8_test_traversal_order_check (t8_forest_t forest)
+{
+  const t8_locidx_t  *order, *tree_order;
+  t8_locidx_t         num_elements, num_trees, ielem, itree, ltree;
+  t8_locidx_t         offset, tree_num_elements, pos;
+  int                *visited;
+  sc_array_t          data, permuted, restored;
+
+  num_elements = t8_forest_get_num_element (forest);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  order = t8_forest_get_traversal_order (forest);
+  tree_order = t8_forest_get_tree_traversal_order (forest);
+  SC_CHECK_ABORT (order != NULL && tree_order != NULL,
+                  "Traversal order was not built");
+
+  /* Each tree appears once, and its elements follow in order */
+  visited = T8_ALLOC_ZERO (int, num_trees + 1);
+  pos = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    ltree = tree_order[itree];
+    SC_CHECK_ABORT (0 <= ltree && ltree < num_trees, "Invalid tree id");
+    SC_CHECK_ABORT (!visited[ltree], "Tree visited twice");
+    visited[ltree] = 1;
+    offset = t8_forest_get_tree_element_offset (forest, ltree);
+    tree_num_elements = t8_forest_get_tree_num_elements (forest, ltree);
+    for (ielem = 0; ielem < tree_num_elements; ielem++, pos++) {
+      SC_CHECK_ABORT (order[pos] == offset + ielem,
+                      "Elements of a tree are not in SFC order");
+    }
+  }
+  SC_CHECK_ABORT (pos == num_elements, "Wrong number of elements");
+  T8_FREE (visited);
+
+  /* Permute the element indices and back */
+  sc_array_init_size (&data, sizeof (t8_locidx_t), num_elements);
+  sc_array_init (&permuted, sizeof (t8_locidx_t));
+  sc_array_init (&restored, sizeof (t8_locidx_t));
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    *(t8_locidx_t *) sc_array_index (&data, ielem) = ielem;
+  }
+  t8_forest_permute_element_data (forest, &data, &permuted, 0);
+  t8_forest_permute_element_data (forest, &permuted, &restored, 1);
+  for (ielem = 0; ielem < num_elements; ielem++) {
+    SC_CHECK_ABORT (*(t8_locidx_t *) sc_array_index (&permuted, ielem) ==
+                    order[ielem], "Wrong permuted data");
+    SC_CHECK_ABORT (*(t8_locidx_t *) sc_array_index (&restored, ielem) ==
+                    ielem, "Wrong restored data");
+  }
+  sc_array_reset (&data);
+  sc_array_reset (&permuted);
+  sc_array_reset (&restored);
+}
+
+static void
+t8_test_traversal_order (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_scheme_cxx_t    *scheme;
+  int                 itest;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (itest = 0; itest < 4; itest++) {
+    switch (itest) {
+    case 0:
+      cmesh = t8_cmesh_new_hypercube (T8_ECLASS_QUAD, comm, 0, 0, 0);
+      break;
+    case 1:
+      cmesh = t8_cmesh_new_hypercube (T8_ECLASS_TRIANGLE, comm, 0, 0, 0);
+      break;
+    case 2:
+      cmesh = t8_cmesh_new_hypercube (T8_ECLASS_TET, comm, 0, 0, 0);
+      break;
+    default:
+      cmesh = t8_cmesh_new_hypercube_hybrid (3, comm, 0, 0);
+      break;
+    }
+    t8_global_productionf ("Testing traversal order, test %i\n", itest);
+    t8_scheme_cxx_ref (scheme);
+    t8_forest_init (&forest);
+    t8_forest_set_cmesh (forest, cmesh, comm);
+    t8_forest_set_scheme (forest, scheme);
+    t8_forest_set_level (forest, 2);
+    t8_forest_set_traversal_order (forest, 1);
+    t8_forest_commit (forest);
+    t8_test_traversal_order_check (forest);
+    t8_forest_unref (&forest);
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_traversal_order (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}